@@ -14,6 +14,7 @@
 
 #include <pybind11/eigen.h>
 #include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
@@ -23,6 +24,7 @@
 
 #include "Circuit/Boxes.hpp"
 #include "Circuit/Circuit.hpp"
+#include "Circuit/CircuitBinary.hpp"
 #include "Circuit/Command.hpp"
 #include "Gate/OpPtrFunctions.hpp"
 #include "Gate/SymTable.hpp"
@@ -108,15 +110,23 @@ void init_circuit(py::module &m) {
               0, 1>() /* Essential: keep object alive while iterator exists */)
       .def(
           "get_commands",
-          [](const Circuit &circ) {
-            std::vector<Command> out;
-            for (Command c : circ) out.push_back(c);
-            return out;
-          },
+          [](const Circuit &circ) { return circ.get_commands(); },
           ":return: a list of all the Commands in the circuit")
       .def(
           "get_unitary",
-          [](const Circuit &circ) { return tket_sim::get_unitary(circ); },
+          [](const Circuit &circ) {
+            // Simulate straight into the array handed back to Python
+            const auto size = get_matrix_size(circ.n_qubits());
+            py::array_t<std::complex<double>, py::array::f_style> result(
+                {size, size});
+            Eigen::Map<Eigen::MatrixXcd> matr(
+                result.mutable_data(), size, size);
+            {
+              py::gil_scoped_release release;
+              tket_sim::write_unitary(circ, matr);
+            }
+            return result;
+          },
           ":return: The numerical unitary matrix of the circuit, using ILO-BE "
           "convention.")
       .def(
@@ -132,9 +142,31 @@ void init_circuit(py::module &m) {
           "\n\n:param matr: The matrix to be multiplied."
           "\n:return: The product of the circuit unitary and the given matrix.",
           py::arg("matr"))
+      .def(
+          "apply_unitary_in_place",
+          [](const Circuit &circ, Eigen::Ref<Eigen::MatrixXcd> matr) {
+            py::gil_scoped_release release;
+            tket_sim::apply_unitary(circ, matr);
+          },
+          "Replace M with UM in place, where U is the numerical unitary "
+          "matrix of the circuit, with ILO-BE convention, and M is a "
+          "writeable, Fortran-ordered numpy array of complex128. Unlike "
+          ":py:meth:`get_unitary_times_other`, M is not copied, so this "
+          "halves the memory needed for large circuits."
+          "\n\n:param matr: The matrix to be premultiplied.",
+          py::arg("matr").noconvert())
       .def(
           "get_statevector",
-          [](const Circuit &circ) { return tket_sim::get_statevector(circ); },
+          [](const Circuit &circ) {
+            const auto size = get_matrix_size(circ.n_qubits());
+            py::array_t<std::complex<double>> result(size);
+            Eigen::Map<Eigen::VectorXcd> vec(result.mutable_data(), size);
+            {
+              py::gil_scoped_release release;
+              tket_sim::write_statevector(circ, vec);
+            }
+            return result;
+          },
           "Calculate the unitary matrix of the circuit, using ILO-BE "
           "convention, applied to the column vector (1,0,0...), "
           "which is thus another column vector. Due to "
@@ -431,6 +463,25 @@ void init_circuit(py::module &m) {
           "from_dict", [](const json &j) { return j.get<Circuit>(); },
           "Construct Circuit instance from JSON serializable "
           "dictionary representation of the Circuit.")
+      .def(
+          "to_bytes",
+          [](const Circuit &c) {
+            std::ostringstream ss;
+            write_circuit_binary(ss, c);
+            return py::bytes(ss.str());
+          },
+          ":return: a compact binary representation of the Circuit")
+      .def_static(
+          "from_bytes",
+          [](const py::bytes &b) {
+            char *data;
+            Py_ssize_t size;
+            PyBytes_AsStringAndSize(b.ptr(), &data, &size);
+            return read_circuit_binary(data, size);
+          },
+          "Construct Circuit instance from its binary representation, as "
+          "returned by :py:meth:`to_bytes`.",
+          py::arg("data"))
       .def(py::pickle(
           [](py::object self) {  // __getstate__
             return py::make_tuple(self.attr("to_dict")());
@@ -440,11 +491,23 @@ void init_circuit(py::module &m) {
             return j.get<Circuit>();
           }))
       .def(
-          "to_latex_file", &Circuit::to_latex_file,
+          "to_latex_file",
+          [](const Circuit &circ, const std::string &filename,
+             bool expand_boxes, bool collapse_repeated_layers) {
+            LatexOptions options;
+            options.expand_boxes = expand_boxes;
+            options.collapse_repeated_layers = collapse_repeated_layers;
+            circ.to_latex_file(filename, options);
+          },
           "Produces a latex file with a visualisation of the circuit "
           "using the Quantikz package.\n\n:param filename: Name of file "
-          "to write output to (must end in \".tex\")",
-          py::arg("filename"))
+          "to write output to (must end in \".tex\")"
+          "\n:param expand_boxes: Draw each box as its circuit rather than "
+          "as a single gate"
+          "\n:param collapse_repeated_layers: Draw runs of identical "
+          "consecutive layers once, marked with the number of repetitions",
+          py::arg("filename"), py::arg("expand_boxes") = false,
+          py::arg("collapse_repeated_layers") = false)
       .def(
           py::self >> py::self,
           "Creates a new Circuit, corresponding to the sequential "
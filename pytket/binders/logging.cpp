@@ -15,6 +15,7 @@
 #include <pybind11/pybind11.h>
 
 #include "Utils/TketLog.hpp"
+#include "Utils/Trace.hpp"
 
 namespace py = pybind11;
 
@@ -36,6 +37,26 @@ PYBIND11_MODULE(logging, m) {
       [](spdlog::level::level_enum level) { tket_log()->set_level(level); },
       "Set the global logging level."
       "\n\n:param level: Desired logging level");
+  m.def(
+      "set_tracing", &trace::set_enabled,
+      "Start or stop recording timed spans of compilation internals "
+      "(passes, routing, rewrites), with counters such as the number of "
+      "routing iterations or rewrites applied. Spans are only available if "
+      "tket was built with tracing, which is the default."
+      "\n\n:param enable: Whether to record spans",
+      py::arg("enable"));
+  m.def(
+      "clear_trace", &trace::clear, "Discard all recorded tracing spans.");
+  m.def(
+      "get_trace", &trace::chrome_json,
+      ":return: the recorded tracing spans as Chrome trace event JSON, "
+      "which chrome://tracing and Perfetto can display");
+  m.def(
+      "write_trace", &trace::write_chrome_json,
+      "Write the recorded tracing spans to a file as Chrome trace event "
+      "JSON."
+      "\n\n:param filename: Path of the file to write",
+      py::arg("filename"));
 }
 
 }  // namespace tket
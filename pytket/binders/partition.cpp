@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <pybind11/eigen.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -118,7 +119,17 @@ PYBIND11_MODULE(partition, m) {
           "Checks that the strings to be measured correspond to the "
           "correct strings generated by the measurement circs. Checks "
           "for parity by comparing to the `invert` flag.\n\n"
-          ":return: True or False");
+          ":return: True or False")
+      .def(
+          "expectation_values", &MeasurementSetup::expectation_values,
+          "Computes the expectation value of every term from the shots of "
+          "each measurement circuit. Shots from all the circuits "
+          "measuring a term are pooled.\n\n"
+          ":param shots: for each measurement circuit in order, a 2D "
+          "numpy array of dtype uint64 with one row per shot, holding bit "
+          "i of the circuit in bit i % 64 of column i // 64\n"
+          ":return: map from each term to its expectation value",
+          py::arg("shots"));
 
   m.def(
       "measurement_reduction", measurement_reduction,
@@ -135,6 +146,35 @@ PYBIND11_MODULE(partition, m) {
       py::arg("method") = GraphColourMethod::Lazy,
       py::arg("cx_config") = CXConfigType::Snake);
 
+  py::class_<IncrementalMeasurementReduction>(
+      m, "IncrementalMeasurementReduction",
+      "Builds a :py:class:`MeasurementSetup` for a growing set of Pauli "
+      "strings. New strings join the first compatible group, and only "
+      "groups that gained strings are diagonalised again.")
+      .def(
+          py::init<PauliPartitionStrat, CXConfigType>(),
+          "Constructs an empty IncrementalMeasurementReduction."
+          "\n\n:param strat: The `PauliPartitionStrat` to use."
+          "\n:param cx_config: Whenever diagonalisation is required, use "
+          "this configuration of CX gates",
+          py::arg("strat"), py::arg("cx_config") = CXConfigType::Snake)
+      .def(
+          "add_terms", &IncrementalMeasurementReduction::add_terms,
+          "Adds Pauli strings, ignoring any that were already added."
+          "\n\n:param strings: A list of `QubitPauliString` objects",
+          py::arg("strings"))
+      .def_property_readonly(
+          "n_terms", &IncrementalMeasurementReduction::n_terms,
+          "Number of distinct strings added")
+      .def_property_readonly(
+          "n_groups", &IncrementalMeasurementReduction::n_groups,
+          "Number of groups, and of measurement circuits")
+      .def(
+          "get_setup", &IncrementalMeasurementReduction::get_setup,
+          "Builds the circuits of groups that changed since the last call."
+          "\n\n:return: a :py:class:`MeasurementSetup` object measuring "
+          "every string added so far");
+
   m.def(
       "term_sequence", term_sequence,
       "Takes in a list of QubitPauliString objects and partitions them "
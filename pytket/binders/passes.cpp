@@ -18,6 +18,7 @@
 #include "Predicates/CompilerPass.hpp"
 #include "Predicates/PassGenerators.hpp"
 #include "Predicates/PassLibrary.hpp"
+#include "Predicates/PassProfiler.hpp"
 #include "Transformations/Transform.hpp"
 #include "Utils/Json.hpp"
 #include "binder_json.hpp"
@@ -38,6 +39,25 @@ void update_routing_config(RoutingConfig &config, py::kwargs kwargs) {
         py::cast<unsigned>(kwargs["bridge_interactions"]);
   if (kwargs.contains("bridge_exponent"))
     config.distrib_exponent = py::cast<unsigned>(kwargs["bridge_exponent"]);
+  if (kwargs.contains("engine"))
+    config.engine = py::cast<RoutingEngine>(kwargs["engine"]);
+  if (kwargs.contains("sabre_extended_set_size"))
+    config.sabre_extended_set_size =
+        py::cast<unsigned>(kwargs["sabre_extended_set_size"]);
+  if (kwargs.contains("sabre_extended_set_weight"))
+    config.sabre_extended_set_weight =
+        py::cast<double>(kwargs["sabre_extended_set_weight"]);
+  if (kwargs.contains("sabre_decay_delta"))
+    config.sabre_decay_delta = py::cast<double>(kwargs["sabre_decay_delta"]);
+  if (kwargs.contains("sabre_decay_reset"))
+    config.sabre_decay_reset = py::cast<unsigned>(kwargs["sabre_decay_reset"]);
+  if (kwargs.contains("sabre_refinement_passes"))
+    config.sabre_refinement_passes =
+        py::cast<unsigned>(kwargs["sabre_refinement_passes"]);
+  if (kwargs.contains("link_errors"))
+    config.link_errors = py::cast<avg_link_errors_t>(kwargs["link_errors"]);
+  if (kwargs.contains("commute_front_layer"))
+    config.commute_front_layer = py::cast<bool>(kwargs["commute_front_layer"]);
 }
 static PassPtr gen_cx_mapping_pass_kwargs(
     const Architecture &arc, const PlacementPtr &placer, py::kwargs kwargs) {
@@ -56,7 +76,13 @@ static PassPtr gen_default_routing_pass(
     const Architecture &arc, py::kwargs kwargs) {
   RoutingConfig config = {};
   update_routing_config(config, kwargs);
-  return gen_routing_pass(arc, config);
+  std::function<void(const Routing::Stats &)> stats_callback;
+  if (kwargs.contains("stats_callback")) {
+    stats_callback =
+        py::cast<std::function<void(const Routing::Stats &)>>(
+            kwargs["stats_callback"]);
+  }
+  return gen_routing_pass(arc, config, stats_callback);
 }
 
 static PassPtr gen_default_aas_routing_pass(
@@ -96,6 +122,8 @@ const PassPtr &DecomposeClassicalExp() {
   // ClassicalExpBox<py::object>
   static const PassPtr pp([]() {
     Transform t = Transform([](Circuit &circ) {
+      // passes are applied without the GIL
+      py::gil_scoped_acquire acquire;
       const py::tuple result =
           decompose_module().attr("_decompose_expressions")(circ);
       const bool success = result[1].cast<bool>();
@@ -188,7 +216,13 @@ PYBIND11_MODULE(passes, m) {
   };
 
   py::class_<BasePass, PassPtr, PyBasePass>(
-      m, "BasePass", "Base class for passes.")
+      m, "BasePass",
+      "Base class for passes.\n\n"
+      "The GIL is released while a pass is applied, so passes may be "
+      "applied to different circuits in parallel from several Python "
+      "threads. Passes may be shared between threads, but the "
+      ":py:class:`Circuit` or :py:class:`CompilationUnit` being compiled "
+      "must not be used by any other thread until the call returns.")
       .def(
           "apply",
           [](const BasePass &pass, CompilationUnit &cu,
@@ -196,7 +230,8 @@ PYBIND11_MODULE(passes, m) {
           "Apply to a :py:class:`CompilationUnit`.\n\n"
           ":return: True if pass modified the circuit, else False",
           py::arg("compilation_unit"),
-          py::arg("safety_mode") = SafetyMode::Default)
+          py::arg("safety_mode") = SafetyMode::Default,
+          py::call_guard<py::gil_scoped_release>())
       .def(
           "apply",
           [](const BasePass &pass, Circuit &circ) {
@@ -207,7 +242,7 @@ PYBIND11_MODULE(passes, m) {
           },
           "Apply to a :py:class:`Circuit` in-place.\n\n"
           ":return: True if pass modified the circuit, else False",
-          py::arg("circuit"))
+          py::arg("circuit"), py::call_guard<py::gil_scoped_release>())
       .def(
           "apply",
           [](const BasePass &pass, Circuit &circ,
@@ -229,7 +264,48 @@ PYBIND11_MODULE(passes, m) {
           "The CompilationUnit and a summary of the pass "
           "configuration are passed into the callback."
           "\n:return: True if pass modified the circuit, else False",
-          py::arg("circuit"), py::arg("before_apply"), py::arg("after_apply"))
+          py::arg("circuit"), py::arg("before_apply"), py::arg("after_apply"),
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "apply",
+          [](const BasePass &pass, CompilationUnit &cu,
+             const PassCallback &before_apply, const PassCallback &after_apply,
+             SafetyMode safety_mode) {
+            return pass.apply(cu, safety_mode, before_apply, after_apply);
+          },
+          "Apply to a :py:class:`CompilationUnit` and invoke callbacks for "
+          "all nested passes. Callbacks can inspect the changes made by each "
+          "pass with :py:meth:`CompilationUnit.get_changes` if the unit "
+          "records changes."
+          "\n\n:param before_apply: Invoked before a pass is applied. "
+          "The CompilationUnit and a summary of the pass "
+          "configuration are passed into the callback."
+          "\n:param after_apply: Invoked after a pass is applied. "
+          "The CompilationUnit and a summary of the pass "
+          "configuration are passed into the callback."
+          "\n:return: True if pass modified the circuit, else False",
+          py::arg("compilation_unit"), py::arg("before_apply"),
+          py::arg("after_apply"), py::arg("safety_mode") = SafetyMode::Default,
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "profile",
+          [](const BasePass &pass, Circuit &circ, bool record_depth) {
+            PassProfiler profiler(record_depth);
+            CompilationUnit cu(circ);
+            pass.apply(
+                cu, SafetyMode::Default, profiler.before_apply_callback(),
+                profiler.after_apply_callback());
+            circ = cu.get_circ_ref();
+            return profiler.get_profile().at(0);
+          },
+          "Apply to a :py:class:`Circuit` in-place and profile the pass and "
+          "all nested passes.\n\n"
+          ":param record_depth: whether to record changes in circuit depth\n"
+          ":return: A dictionary with the wall and CPU time in milliseconds "
+          "and the changes in gate count and depth of the pass, and the "
+          "same for each nested pass under the \"children\" key",
+          py::arg("circuit"), py::arg("record_depth") = true,
+          py::call_guard<py::gil_scoped_release>())
       .def("__str__", [](const BasePass &) { return "<tket::BasePass>"; })
       .def("__repr__", &BasePass::to_string)
       .def(
@@ -456,6 +532,12 @@ PYBIND11_MODULE(passes, m) {
   m.def(
       "RemoveBarriers", &RemoveBarriers,
       "A pass to remove all barrier instructions from the circuit.");
+  m.def(
+      "ZXGraphlikeOptimisation", &ZXGraphlikeOptimisation,
+      "Optimise the circuit through the ZX-calculus: convert it to a "
+      "graph-like ZX diagram, remove interior Clifford spiders, and extract "
+      "a circuit of Rz, H, CX, CZ and SWAP gates. The result is equal to the "
+      "original up to global phase. Connectivity is not preserved.");
 
   /* Pass generators */
 
@@ -506,7 +588,20 @@ PYBIND11_MODULE(passes, m) {
       "\n\n:param arc: The architecture to use for connectivity information."
       "\n:param \\**kwargs: Parameters for routing: "
       "(int)swap_lookahead=50, (int)bridge_lookahead=4, "
-      "(int)bridge_interactions=2, (float)bridge_exponent=0."
+      "(int)bridge_interactions=2, (float)bridge_exponent=0, "
+      "(RoutingEngine)engine=RoutingEngine.CowtanEtAl, "
+      "(int)sabre_extended_set_size=20, "
+      "(float)sabre_extended_set_weight=0.5, "
+      "(float)sabre_decay_delta=0.001, (int)sabre_decay_reset=5, "
+      "(int)sabre_refinement_passes=1, "
+      "(dict)link_errors={} (average error of each pair of nodes; if "
+      "given, SWAPs are scored by distances weighted by -log(1 - error) "
+      "of each link rather than by hop count), "
+      "(bool)commute_front_layer=False (if true, when no gate of the front "
+      "layer can run, a later two-qubit gate on adjacent nodes may run first "
+      "if it commutes with the gates before it), "
+      "(Callable[[RoutingStats], None])stats_callback=None (called with "
+      "the :py:class:`RoutingStats` of each application of the pass)"
       "\n:return: a pass that routes to the given device architecture",
       py::arg("arc"));
 
@@ -702,6 +797,16 @@ PYBIND11_MODULE(passes, m) {
       "transformed circuit (if omitted, an X gate is used)"
       "\n:return: a pass to perform the simplification",
       py::arg("allow_classical") = true, py::arg("xcirc") = nullptr);
+  m.def(
+      "ParallelRegions", &gen_parallel_regions_pass,
+      "Applies a pass to the independent regions of a circuit in parallel. "
+      "The circuit is cut at each barrier, and the commands between two "
+      "barriers are split into groups acting on disjoint sets of units, "
+      "which are compiled separately and put back together in order."
+      "\n\n:param region_pass: a pass which keeps the units of the circuit "
+      "(so not a placement or routing pass)"
+      "\n:return: a pass applying `region_pass` to each region",
+      py::arg("region_pass"));
 }
 
 }  // namespace tket
@@ -30,6 +30,28 @@ static std::map<UnitID, UnitID> unit_bimap_to_map(const unit_bimap_t &bimap) {
   return res;
 }
 
+static py::object changes_to_dict(const CompilationUnit &cu) {
+  std::optional<Circuit::ChangeLog> changes = cu.get_changes();
+  if (!changes) return py::none();
+  const Circuit &circ = cu.get_circ_ref();
+  std::vector<Op_ptr> added;
+  for (const Vertex &v : changes->added) {
+    added.push_back(circ.get_Op_ptr_from_Vertex(v));
+  }
+  std::vector<std::pair<Op_ptr, Op_ptr>> replaced;
+  for (const std::pair<const Vertex, Op_ptr> &pair : changes->replaced) {
+    replaced.push_back(
+        {pair.second, circ.get_Op_ptr_from_Vertex(pair.first)});
+  }
+  py::dict d;
+  d["added"] = added;
+  d["removed"] = changes->removed;
+  d["replaced"] = replaced;
+  d["n_rewired"] = changes->rewired.size();
+  d["rebuilt"] = changes->rebuilt;
+  return std::move(d);
+}
+
 PYBIND11_MODULE(predicates, m) {
   /* Predicates */
 
@@ -224,6 +246,24 @@ PYBIND11_MODULE(predicates, m) {
           },
           "Returns the map from the original qubits to their "
           "corresponding qubits at the end of the current circuit.")
+      .def(
+          "record_changes", &CompilationUnit::record_changes,
+          "Start or stop recording the changes made to the circuit, so "
+          "that pass callbacks can inspect them with :py:meth:`get_changes`. "
+          "Starting discards the changes recorded so far."
+          "\n\n:param enable: whether to record changes",
+          py::arg("enable"))
+      .def(
+          "get_changes", &changes_to_dict,
+          "The changes made to the circuit by the pass being applied (in "
+          "an ``after_apply`` callback, by the pass just applied), or since "
+          "recording started if no pass is being applied."
+          "\n\n:return: None if changes are not being recorded, otherwise "
+          "a dict with the operations ``added`` and ``removed``, the pairs "
+          "(old, new) of operations ``replaced`` in place, the number "
+          "``n_rewired`` of other operations whose connections changed, and "
+          "whether the circuit was ``rebuilt`` as a whole (in which case "
+          "the other entries are incomplete)")
       .def(
           "__str__",
           [](const CompilationUnit &) { return "<tket::CompilationUnit>"; })
@@ -14,6 +14,7 @@
 
 #include "Routing/Routing.hpp"
 
+#include <chrono>
 #include <pybind11/eigen.h>
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
@@ -75,8 +76,10 @@ void place_with_map(Circuit &circ, qubit_mapping_t &qmap) {
   plobj.place_with_map(circ, qmap);
 }
 
+// Route for an Architecture, or for the shared data of a RoutingContext
+template <typename ArcT>
 std::pair<Circuit, qubit_mapping_t> route(
-    const Circuit &circuit, const Architecture &arc, py::kwargs kwargs) {
+    const Circuit &circuit, const ArcT &arc, py::kwargs kwargs) {
   RoutingConfig config = {};
   if (kwargs.contains("swap_lookahead"))
     config.depth_limit = py::cast<unsigned>(kwargs["swap_lookahead"]);
@@ -87,7 +90,27 @@ std::pair<Circuit, qubit_mapping_t> route(
         py::cast<unsigned>(kwargs["bridge_interactions"]);
   if (kwargs.contains("bridge_exponent"))
     config.distrib_exponent = py::cast<float>(kwargs["bridge_exponent"]);
+  if (kwargs.contains("engine"))
+    config.engine = py::cast<RoutingEngine>(kwargs["engine"]);
+  if (kwargs.contains("sabre_extended_set_size"))
+    config.sabre_extended_set_size =
+        py::cast<unsigned>(kwargs["sabre_extended_set_size"]);
+  if (kwargs.contains("sabre_extended_set_weight"))
+    config.sabre_extended_set_weight =
+        py::cast<double>(kwargs["sabre_extended_set_weight"]);
+  if (kwargs.contains("sabre_decay_delta"))
+    config.sabre_decay_delta = py::cast<double>(kwargs["sabre_decay_delta"]);
+  if (kwargs.contains("sabre_decay_reset"))
+    config.sabre_decay_reset = py::cast<unsigned>(kwargs["sabre_decay_reset"]);
+  if (kwargs.contains("sabre_refinement_passes"))
+    config.sabre_refinement_passes =
+        py::cast<unsigned>(kwargs["sabre_refinement_passes"]);
+  if (kwargs.contains("link_errors"))
+    config.link_errors = py::cast<avg_link_errors_t>(kwargs["link_errors"]);
+  if (kwargs.contains("commute_front_layer"))
+    config.commute_front_layer = py::cast<bool>(kwargs["commute_front_layer"]);
 
+  py::gil_scoped_release release;
   Routing router(circuit, arc);
   Circuit out = router.solve(config).first;
   return {out, router.return_final_map()};
@@ -202,6 +225,58 @@ PYBIND11_MODULE(routing, m) {
       .def("__repr__", [](const RingArch &arc) {
         return "<tket::RingArch, nodes=" + std::to_string(arc.n_nodes()) + ">";
       });
+  py::class_<HeavyHexLattice, Architecture, graphs::AbstractGraph<Node>>(
+      m, "HeavyHexLattice",
+      "Architecture class for a heavy-hex lattice, as on IBM devices. Qubits "
+      "lie on rows coupled as lines, and neighbouring rows are joined "
+      "through bridge qubits every four columns. Row qubits are "
+      "``heavyHexNode[2r, c]`` and the bridge below row r at column c is "
+      "``heavyHexNode[2r + 1, c]``. Distances, articulation points and a "
+      "long path for placement are precomputed on construction.")
+      .def(
+          py::init<unsigned, unsigned>(),
+          "Construct a heavy-hex lattice.\n\n:param n_rows: The number of "
+          "rows\n:param n_columns: The number of qubits in each row",
+          py::arg("n_rows"), py::arg("n_columns"))
+      .def("__repr__", [](const HeavyHexLattice &arc) {
+        return "<tket::HeavyHexLattice, rows=" +
+               std::to_string(arc.get_rows()) +
+               ", columns=" + std::to_string(arc.get_columns()) + ">";
+      });
+  py::class_<HeavySquareLattice, Architecture, graphs::AbstractGraph<Node>>(
+      m, "HeavySquareLattice",
+      "Architecture class for a heavy-square lattice: a square grid with an "
+      "extra qubit on each coupling. On doubled coordinates, grid qubits are "
+      "``heavySquareNode[2r, 2c]``. Distances, articulation points and a "
+      "long path for placement are precomputed on construction.")
+      .def(
+          py::init<unsigned, unsigned>(),
+          "Construct a heavy-square lattice.\n\n:param n_rows: The number "
+          "of rows of the grid\n:param n_columns: The number of columns of "
+          "the grid",
+          py::arg("n_rows"), py::arg("n_columns"))
+      .def("__repr__", [](const HeavySquareLattice &arc) {
+        return "<tket::HeavySquareLattice, rows=" +
+               std::to_string(arc.get_rows()) +
+               ", columns=" + std::to_string(arc.get_columns()) + ">";
+      });
+  py::class_<SycamoreLattice, Architecture, graphs::AbstractGraph<Node>>(
+      m, "SycamoreLattice",
+      "Architecture class for a Sycamore-style lattice, as on Google "
+      "devices: a square grid rotated by 45 degrees, with qubits "
+      "``sycamoreNode[r, c]``. Distances, articulation points and a long "
+      "path for placement are precomputed on construction.")
+      .def(
+          py::init<unsigned, unsigned>(),
+          "Construct a Sycamore-style lattice.\n\n:param n_rows: The "
+          "number of rows\n:param n_columns: The number of qubits in each "
+          "row",
+          py::arg("n_rows"), py::arg("n_columns"))
+      .def("__repr__", [](const SycamoreLattice &arc) {
+        return "<tket::SycamoreLattice, rows=" +
+               std::to_string(arc.get_rows()) +
+               ", columns=" + std::to_string(arc.get_columns()) + ">";
+      });
   py::class_<FullyConnected, graphs::AbstractGraph<Node>>(
       m, "FullyConnected",
       "An architecture with full connectivity between qubits.")
@@ -232,7 +307,11 @@ PYBIND11_MODULE(routing, m) {
             m, "Placement",
             "The base Placement class, contains methods for getting maps "
             "between Circuit Qubits and Architecture Nodes and for relabelling "
-            "Circuit Qubits.")
+            "Circuit Qubits.\n\n"
+            "The GIL is released while placing, so placements may be used "
+            "from several Python threads at once, but a placement must not "
+            "be reconfigured, nor the circuit being placed used, by another "
+            "thread meanwhile.")
 
             .def(py::init<Architecture &>(),
                  "The constructor for a Placement object. The Architecture object "
@@ -245,20 +324,23 @@ PYBIND11_MODULE(routing, m) {
                  "Relabels Circuit Qubits to Architecture Nodes and 'unplaced'. For "
                  "base Placement, all Qubits and labelled 'unplaced'. "
                  "\n\n:param circuit: The Circuit being relabelled.",
-                 py::arg("circuit"))
+                 py::arg("circuit"),
+                 py::call_guard<py::gil_scoped_release>())
             .def_static(
                     "place_with_map", &Placement::place_with_map,
                     "Relabels Circuit Qubits to Architecture Nodes using given map. "
                     "\n\n:param circuit: The circuit being relabelled\n:param "
                     "qmap: The map from logical to physical qubits to apply.",
-                    py::arg("circuit"), py::arg("qmap"))
+                    py::arg("circuit"), py::arg("qmap"),
+                    py::call_guard<py::gil_scoped_release>())
             .def("get_placement_map", &Placement::get_placement_map,
                  "Returns a map from logical to physical qubits that is Architecture "
                  "appropriate for the given Circuit. "
                  "\n\n:param circuit: The circuit a map is designed for."
                  "\n:return: dictionary mapping " CLSOBJS(Qubit) " to "
                  CLSOBJS(Node),
-                 py::arg("circuit"))
+                 py::arg("circuit"),
+                 py::call_guard<py::gil_scoped_release>())
             .def("get_placement_maps", &Placement::get_all_placement_maps,
                  "Returns a list of maps from logical to physical qubits that "
                  "are Architecture appropriate for the given Circuit. Each map is "
@@ -266,7 +348,8 @@ PYBIND11_MODULE(routing, m) {
                  "\n\n:param circuit: The circuit the maps are designed for."
                  "\n:return: list of dictionaries mapping " CLSOBJS(Qubit) " "
                  "to " CLSOBJS(Node),
-                 py::arg("circuit"))
+                 py::arg("circuit"),
+                 py::call_guard<py::gil_scoped_release>())
             .def(
                 "to_dict", [](const PlacementPtr &placement) { return json(placement); },
                 "Return a JSON serializable dict representation of "
@@ -369,7 +452,80 @@ PYBIND11_MODULE(routing, m) {
       "is partial, remaining Circuit Qubits are left 'unplaced'. "
       "\n\n:param circuit: The Circuit being relabelled. \n:param qmap: "
       "The map from logical to physical qubits to apply.",
-      py::arg("circuit"), py::arg("qmap"));
+      py::arg("circuit"), py::arg("qmap"),
+      py::call_guard<py::gil_scoped_release>());
+
+  py::class_<RoutingContext, std::shared_ptr<RoutingContext>>(
+      m, "RoutingContext",
+      "Distances and connectivity of an architecture, computed once and "
+      "shared by every circuit routed with the context. Use one context "
+      "to route many circuits for the same device.")
+      .def(
+          py::init<const Architecture &, const avg_link_errors_t &>(),
+          "Precompute the routing data of an architecture."
+          "\n\n:param architecture: The architecture to route for"
+          "\n:param link_errors: Average error of each pair of nodes, for "
+          "routing with the same `link_errors`; the error-weighted "
+          "distances are then precomputed as well",
+          py::arg("architecture"), py::arg("link_errors") = py::dict(),
+          py::call_guard<py::gil_scoped_release>())
+      .def_property_readonly(
+          "architecture", &RoutingContext::get_architecture,
+          "The architecture the context was built for.");
+
+  auto seconds = [](std::chrono::nanoseconds Routing::Stats::*field) {
+    return [field](const Routing::Stats &stats) {
+      return std::chrono::duration<double>(stats.*field).count();
+    };
+  };
+  py::class_<Routing::Stats>(
+      m, "RoutingStats",
+      "Statistics of a routing run: the numbers of steps and gates added, "
+      "and the cumulative time in seconds spent in each phase.")
+      .def_readonly(
+          "n_try_all_swaps", &Routing::Stats::n_try_all_swaps,
+          "Number of steps choosing a SWAP by lookahead.")
+      .def_readonly(
+          "n_solve_furthest", &Routing::Stats::n_solve_furthest,
+          "Number of steps swapping the furthest interacting pair together.")
+      .def_readonly(
+          "swap_count", &Routing::Stats::swap_count,
+          "Number of SWAPs added.")
+      .def_readonly(
+          "bridge_count", &Routing::Stats::bridge_count,
+          "Number of BRIDGEs added.")
+      .def_property_readonly(
+          "advance_frontier_time",
+          seconds(&Routing::Stats::advance_frontier_time),
+          "Time spent advancing the frontier past routed gates.")
+      .def_property_readonly(
+          "swap_generation_time",
+          seconds(&Routing::Stats::swap_generation_time),
+          "Time spent generating candidate SWAPs.")
+      .def_property_readonly(
+          "swap_scoring_time", seconds(&Routing::Stats::swap_scoring_time),
+          "Time spent scoring candidate SWAPs.")
+      .def_property_readonly(
+          "distributed_cx_time",
+          seconds(&Routing::Stats::distributed_cx_time),
+          "Time spent checking whether to add BRIDGEs instead of SWAPs.")
+      .def_property_readonly(
+          "solve_furthest_time",
+          seconds(&Routing::Stats::solve_furthest_time),
+          "Time spent swapping the furthest interacting pair together.");
+
+  py::enum_<RoutingEngine>(
+      m, "RoutingEngine", "Algorithm used by routing to choose SWAPs.")
+      .value(
+          "CowtanEtAl", RoutingEngine::CowtanEtAl,
+          "Lookahead over circuit slices, inserting SWAPs and BRIDGEs")
+      .value(
+          "Sabre", RoutingEngine::Sabre,
+          "SABRE-style search over the front layer with a decaying "
+          "lookahead cost, inserting SWAPs only; the initial placement is "
+          "refined by routing forwards and backwards "
+          "(sabre_refinement_passes times)")
+      .export_values();
 
   m.def(
       "route",
@@ -377,15 +533,42 @@ PYBIND11_MODULE(routing, m) {
         return route(circuit, arc, kwargs).first;
       },
       "Routes the circuit subject to the connectivity of the input "
-      "architecture, given configuration settings."
+      "architecture, given configuration settings. The GIL is released "
+      "while routing."
       "\n\n:param circuit: The circuit to be routed."
       "\n:param architecture: A representation of the qubit connectivity "
       "constraints of the device."
       "\n:param \\**kwargs: Parameters for routing: "
       "(int)swap_lookahead=50, (int)bridge_lookahead=4, "
       "(int)bridge_interactions=2, (float)bridge_exponent=0, "
+      "(RoutingEngine)engine=RoutingEngine.CowtanEtAl, "
+      "(int)sabre_extended_set_size=20, "
+      "(float)sabre_extended_set_weight=0.5, "
+      "(float)sabre_decay_delta=0.001, (int)sabre_decay_reset=5, "
+      "(int)sabre_refinement_passes=1, "
+      "(dict)link_errors={} (average error of each pair of nodes; if "
+      "given, SWAPs are scored by distances weighted by -log(1 - error) "
+      "of each link rather than by hop count), "
+      "(bool)commute_front_layer=False (if true, when no gate of the front "
+      "layer can run, a later two-qubit gate on adjacent nodes may run first "
+      "if it commutes with the gates before it)"
       "\n:return: the routed :py:class:`Circuit`",
       py::arg("circuit"), py::arg("architecture"));
+  m.def(
+      "route",
+      [](const Circuit &circuit,
+         const std::shared_ptr<RoutingContext> &context, py::kwargs kwargs) {
+        return route(circuit, context, kwargs).first;
+      },
+      "Routes the circuit subject to the connectivity of the architecture "
+      "of a :py:class:`RoutingContext`, reusing its precomputed data. "
+      "The GIL is released while routing."
+      "\n\n:param circuit: The circuit to be routed."
+      "\n:param context: Routing data of the device, shared between calls."
+      "\n:param \\**kwargs: Parameters for routing, as for routing with "
+      "an :py:class:`Architecture`."
+      "\n:return: the routed :py:class:`Circuit`",
+      py::arg("circuit"), py::arg("context"));
   m.def(
       "_route_return_map",
       [](const Circuit &circuit, const Architecture &arc, py::kwargs kwargs) {
@@ -104,9 +104,10 @@ PYBIND11_MODULE(tailoring, m) {
           "frame gates uniformly.\n\n:param "
           "circuit: The circuit to perform frame randomisation with "
           "Pauli gates on\n:param samples: the number of frame "
-          "randomised circuits to return.\n"
+          "randomised circuits to return.\n:param seed: seed for "
+          "reproducible sampling, or None for a random seed.\n"
           ":return: list of " CLSOBJS(Circuit),
-          py::arg("circuit"), py::arg("samples"))
+          py::arg("circuit"), py::arg("samples"), py::arg("seed") = py::none())
       .def("__repr__", &FrameRandomisation::to_string);
 
   py::class_<PauliFrameRandomisation>(
@@ -137,9 +138,10 @@ PYBIND11_MODULE(tailoring, m) {
           "frame gates uniformly from the Pauli gates.\n\n:param "
           "circuit: The circuit to perform frame randomisation with "
           "Pauli gates on\n:param samples: the number of frame "
-          "randomised circuits to return.\n"
+          "randomised circuits to return.\n:param seed: seed for "
+          "reproducible sampling, or None for a random seed.\n"
           ":return: list of " CLSOBJS(Circuit),
-          py::arg("circuit"), py::arg("samples"))
+          py::arg("circuit"), py::arg("samples"), py::arg("seed") = py::none())
       .def("__repr__", &PauliFrameRandomisation::to_string);
 
   py::class_<UniversalFrameRandomisation>(
@@ -173,9 +175,10 @@ PYBIND11_MODULE(tailoring, m) {
           "frame gates uniformly from the Pauli gates.\n\n:param "
           "circuit: The circuit to perform frame randomisation with "
           "Pauli gates on\n:param samples: the number of frame "
-          "randomised circuits to return.\n"
+          "randomised circuits to return.\n:param seed: seed for "
+          "reproducible sampling, or None for a random seed.\n"
           ":return: list of " CLSOBJS(Circuit),
-          py::arg("circuit"), py::arg("samples"))
+          py::arg("circuit"), py::arg("samples"), py::arg("seed") = py::none())
       .def("__repr__", &UniversalFrameRandomisation::to_string);
   m.def(
       "apply_clifford_basis_change", &apply_clifford_basis_change,
@@ -64,7 +64,12 @@ PYBIND11_MODULE(transform, m) {
           "XXPhase3 gates instead of CXs where possible.");
 
   py::class_<Transform>(
-      m, "Transform", "An in-place transformation of a :py:class:`Circuit`.")
+      m, "Transform",
+      "An in-place transformation of a :py:class:`Circuit`.\n\n"
+      "The GIL is released while a transform is applied. Transforms may be "
+      "shared between threads, but the :py:class:`Circuit` being "
+      "transformed must not be used by any other thread until the call "
+      "returns.")
       .def(
           "apply",
           [](const Transform &tr, Circuit &circ) { return tr.apply(circ); },
@@ -72,7 +77,7 @@ PYBIND11_MODULE(transform, m) {
           "place.\n\n:param circuit: The circuit to be "
           "transformed\n"
           ":return: True if any changes were made, else False",
-          py::arg("circuit"))
+          py::arg("circuit"), py::call_guard<py::gil_scoped_release>())
 
       /* COMBINATORS */
       .def(
@@ -226,6 +231,13 @@ PYBIND11_MODULE(transform, m) {
           "gates, and removing identity gates. "
           "Preserves the gate set and any placement/orientation of "
           "multi-qubit gates.")
+      .def_static(
+          "CliffordPeephole", &Transform::clifford_peephole,
+          "Applies the simple optimisations of `RemoveRedundancies`, "
+          "and also commutes Z gates back through CX controls and X "
+          "gates back through CX targets so that they can cancel. "
+          "Preserves the gate set and any placement/orientation of "
+          "multi-qubit gates.")
       .def_static(
           "ReduceSingles", &Transform::squash_1qb_to_tk1,
           "Reduces each sequence of single-qubit rotations into a single TK1.")
@@ -254,7 +266,10 @@ PYBIND11_MODULE(transform, m) {
       .def_static(
           "ThreeQubitSquash", &Transform::three_qubit_squash,
           "Squash three-qubit subcircuits into subcircuits having fewer CX "
-          "gates, when possible.")
+          "gates, when possible."
+          "\n\n:param parallel: whether to synthesise the candidate "
+          "subcircuits in parallel (the result is the same either way)",
+          py::arg("parallel") = false)
       .def_static(
           "CommuteSQThroughSWAP",
           [](const avg_node_errors_t &avg_node_errors) {
@@ -12,6 +12,6 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
-"""Module to control visibility of internal logging from tket."""
+"""Module to control visibility of internal logging and tracing from tket."""
 
 from pytket._tket.logging import *  # type: ignore
@@ -55,6 +55,7 @@ from pytket.passes import (  # type: ignore
     SynthesiseUMD,
     SquashHQS,
     ThreeQubitSquash,
+    ZXGraphlikeOptimisation,
 )
 from pytket.transform import CXConfigType, PauliSynthStrat  # type: ignore
 
@@ -108,6 +109,7 @@ basic_pass:
     | synthesise_oqc
     | synthesise_umd
     | three_qubit_squash
+    | zx_graphlike_optimisation
 seq_pass: "[" pass_list "]"
 pass_list: comp_pass ("," comp_pass)*
 repeat_pass: "repeat" "(" comp_pass ")"
@@ -158,6 +160,7 @@ synthesise_tket: "SynthesiseTket"
 synthesise_oqc: "SynthesiseOQC"
 synthesise_umd: "SynthesiseUMD"
 three_qubit_squash: "ThreeQubitSquash"
+zx_graphlike_optimisation: "ZXGraphlikeOptimisation"
 
 cx_config_type:
     | cx_config_type_snake
@@ -346,6 +349,9 @@ class PassTransformer(Transformer):
     def three_qubit_squash(self, t: List) -> BasePass:
         return ThreeQubitSquash()
 
+    def zx_graphlike_optimisation(self, t: List) -> BasePass:
+        return ZXGraphlikeOptimisation()
+
     def cx_config_type(self, t: List) -> CXConfigType:
         return t[0]
 
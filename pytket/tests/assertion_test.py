@@ -72,6 +72,10 @@ def test_assertion_init() -> None:
     circ.add_assertion(stabilisers, [0, 1], 2, name="|stab1>")
     circ.add_assertion(stabilisers_2, [0, 1], 2, name="|stab2>")
     circ.add_assertion(stabilisers_2, [Qubit(0), Qubit(1)], Qubit(2), name="|stab3>")
+    # Without an ancilla, assertions share one
+    circ.add_assertion(stabilisers, [0, 1], name="|stab4>")
+    circ.add_assertion(stabilisers, [Qubit(2), Qubit(3)], name="|stab5>")
+    assert circ.n_qubits == 6
 
     # Test the circuit can be decomposed
 
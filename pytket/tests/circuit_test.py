@@ -513,6 +513,11 @@ def test_circuit_pickle_roundtrip(circuit: Circuit) -> None:
     assert pickle.loads(pickle.dumps(circuit)) == circuit
 
 
+@given(st.circuits())
+def test_circuit_bytes_roundtrip(circuit: Circuit) -> None:
+    assert Circuit.from_bytes(circuit.to_bytes()) == circuit
+
+
 @given(st.circuits())
 def test_circuit_from_to_serializable(circuit: Circuit) -> None:
     serializable_form = circuit.to_dict()
@@ -688,6 +693,24 @@ def test_op_dagger_transpose() -> None:
     assert sx.transpose == sx
 
 
+def test_gate_arrays() -> None:
+    types = np.array([OpType.H.value, OpType.CX.value, OpType.Rz.value])
+    qubits = np.array([[0, -1], [0, 1], [1, -1]])
+    params = np.array([[np.nan], [np.nan], [0.25]])
+    c = Circuit(2).add_gates_from_arrays(types, qubits, params)
+    assert c == Circuit(2).H(0).CX(0, 1).Rz(0.25, 1)
+    types1, qubits1, params1 = c.get_gate_arrays()
+    assert np.array_equal(types1, types)
+    assert np.array_equal(qubits1, qubits)
+    assert np.array_equal(params1, params, equal_nan=True)
+    c1 = Circuit(2).add_gates_from_arrays(types1[:2], qubits1[:2])
+    assert c1 == Circuit(2).H(0).CX(0, 1)
+    with pytest.raises(RuntimeError):
+        Circuit(2).add_gates_from_arrays(types, qubits)
+    with pytest.raises(RuntimeError):
+        Circuit(2, 1).Measure(0, 0).get_gate_arrays()
+
+
 if __name__ == "__main__":
     test_circuit_gen()
     test_symbolic_ops()
@@ -22,6 +22,7 @@ from pytket.partition import (  # type: ignore
     measurement_reduction,
 )
 
+import numpy as np
 import pytest  # type: ignore
 import platform
 from typing import Any
@@ -63,6 +64,19 @@ def test_reduction() -> None:
         assert measurements.verify()
 
 
+def test_expectation_values() -> None:
+    ms = MeasurementSetup()
+    ms.add_measurement_circuit(Circuit(2, 2))
+    zi = QubitPauliString(Qubit(0), Pauli.Z)
+    zz = QubitPauliString([Qubit(0), Qubit(1)], [Pauli.Z, Pauli.Z])
+    ms.add_result_for_term(zi, MeasurementBitMap(0, [0], True))
+    ms.add_result_for_term(zz, MeasurementBitMap(0, [0, 1], False))
+    shots = np.array([[0b00], [0b01], [0b01], [0b11]], dtype=np.uint64)
+    values = ms.expectation_values([shots])
+    assert values[zi] == pytest.approx(0.5)
+    assert values[zz] == pytest.approx(0.0)
+
+
 # readouterr() doesn't seem to work correctly on Windows, so skip. TODO investigate.
 @pytest.mark.skipif(platform.system() == "Windows", reason="issues with readouterr()")
 def test_error_logging(capfd: Any) -> None:
@@ -66,6 +66,7 @@ from pytket.passes import (  # type: ignore
     SimplifyInitial,
     RemoveBarriers,
     PauliSquash,
+    ParallelRegions,
 )
 from pytket.predicates import (  # type: ignore
     GateSetPredicate,
@@ -74,14 +75,22 @@ from pytket.predicates import (  # type: ignore
     CompilationUnit,
     UserDefinedPredicate,
 )
-from pytket.routing import Architecture, Placement, GraphPlacement  # type: ignore
+from pytket.routing import (  # type: ignore
+    Architecture,
+    Placement,
+    GraphPlacement,
+    LinePlacement,
+)
+from pytket import logging  # type: ignore
 from pytket.transform import Transform, PauliSynthStrat, CXConfigType  # type: ignore
 from pytket._tket.passes import SynthesiseOQC  # type: ignore
 import numpy as np
+import json
 
 import pytest  # type: ignore
 
 from typing import Dict, Any, List
+from concurrent.futures import ThreadPoolExecutor
 
 circ2 = Circuit(1)
 circ2.Rx(0.25, 0)
@@ -219,6 +228,24 @@ def test_routing_and_placement_pass() -> None:
     assert cu.circuit == cu3.circuit
 
 
+def test_routing_stats() -> None:
+    circ = Circuit(4)
+    for i in range(4):
+        circ.CX(i, (i + 2) % 4)
+    arc = Architecture([[0, 1], [1, 2], [2, 3]])
+    stats = []
+    routing = RoutingPass(arc, stats_callback=stats.append)
+    placement = PlacementPass(LinePlacement(arc))
+    cu = CompilationUnit(circ)
+    assert placement.apply(cu)
+    assert routing.apply(cu)
+    assert len(stats) == 1
+    assert stats[0].swap_count + stats[0].bridge_count > 0
+    assert stats[0].advance_frontier_time > 0
+    assert stats[0].swap_scoring_time >= 0
+    assert stats[0].solve_furthest_time >= 0
+
+
 def test_default_mapping_pass() -> None:
     circ = Circuit()
     q = circ.add_q_register("q", 5)
@@ -951,6 +978,101 @@ def test_three_qubit_squash() -> None:
     assert c.n_gates_of_type(OpType.CX) <= 18
 
 
+def test_profile_pass() -> None:
+    c = Circuit(2).H(0).H(0).CX(0, 1).CX(0, 1).Rz(0.3, 1)
+    seq = SequencePass([RepeatPass(RemoveRedundancies()), RemoveRedundancies()])
+    profile = seq.profile(c)
+    assert c.n_gates == 1
+    assert profile["pass_class"] == "SequencePass"
+    assert profile["gate_count_delta"] == -4
+    assert profile["wall_time_ms"] >= 0
+    repeat = profile["children"][0]
+    assert repeat["iterations"] == 2
+    assert repeat["children"][0]["name"] == "RemoveRedundancies"
+    assert repeat["children"][0]["gate_count_delta"] == -4
+
+
+def test_change_log() -> None:
+    c = Circuit(3).H(0).H(0).CX(1, 2).Rz(0.5, 2)
+    cu = CompilationUnit(c)
+    assert cu.get_changes() is None
+    cu.record_changes(True)
+    logs: List[Dict[str, Any]] = []
+
+    def after_apply(cu: CompilationUnit, config: Dict[str, Any]) -> None:
+        logs.append(cu.get_changes())
+
+    p = SequencePass([RemoveRedundancies(), RebaseTket()])
+    assert p.apply(cu, lambda cu, config: None, after_apply)
+    assert len(logs) == 3
+    assert [op.type for op in logs[0]["removed"]] == [OpType.H, OpType.H]
+    assert logs[0]["added"] == []
+    assert len(logs[1]["replaced"]) + len(logs[1]["added"]) > 0
+    assert [op.type for op in logs[2]["removed"]].count(OpType.H) == 2
+    cu.record_changes(False)
+    assert cu.get_changes() is None
+
+
+def test_parallel_regions() -> None:
+    c = Circuit(4).CX(0, 1).CX(0, 1).CX(2, 3).add_barrier([0, 1, 2, 3])
+    c.H(3).H(3).CX(1, 2)
+    p = ParallelRegions(RemoveRedundancies())
+    assert p.apply(c)
+    cmds = c.get_commands()
+    assert [cmd.op.type for cmd in cmds] == [
+        OpType.CX,
+        OpType.Barrier,
+        OpType.CX,
+    ]
+    assert p.to_dict()["StandardPass"]["name"] == "ParallelRegions"
+    p1 = BasePass.from_dict(p.to_dict())
+    assert p1.to_dict() == p.to_dict()
+
+
+def test_apply_in_threads() -> None:
+    # passes are applied without the GIL, each thread on its own circuit
+    def make_circ(i: int) -> Circuit:
+        c = Circuit(3)
+        for j in range(20):
+            c.Rz(0.1 * (i + j), j % 3).CX(j % 3, (j + 1) % 3).H(j % 3)
+        return c
+
+    p = FullPeepholeOptimise()
+    expected = []
+    for i in range(8):
+        c = make_circ(i)
+        p.apply(c)
+        expected.append(c)
+
+    def compile_circ(i: int) -> Circuit:
+        c = make_circ(i)
+        p.apply(c)
+        return c
+
+    with ThreadPoolExecutor(max_workers=4) as executor:
+        results = list(executor.map(compile_circ, range(8)))
+    assert results == expected
+
+
+def test_tracing() -> None:
+    c = Circuit(3).CX(0, 1).CX(0, 1).Rz(0.3, 2).CX(1, 2).H(0).H(0)
+    logging.clear_trace()
+    logging.set_tracing(True)
+    arc = Architecture([[0, 1], [1, 2]])
+    SequencePass([RemoveRedundancies(), CXMappingPass(arc, Placement(arc))]).apply(c)
+    logging.set_tracing(False)
+    events = json.loads(logging.get_trace())["traceEvents"]
+    names = {e["name"] for e in events}
+    assert "StandardPass::apply" in names
+    passes = {
+        e["args"]["name"] for e in events if e["name"] == "StandardPass::apply"
+    }
+    assert "RemoveRedundancies" in passes
+    assert all(e["ph"] == "X" and e["dur"] >= 0 for e in events)
+    logging.clear_trace()
+    assert json.loads(logging.get_trace())["traceEvents"] == []
+
+
 if __name__ == "__main__":
     test_predicate_generation()
     test_compilation_unit_generation()
@@ -969,3 +1091,8 @@ if __name__ == "__main__":
     test_apply_pass_with_callbacks()
     test_remove_barriers()
     test_RebaseOQC_and_SynthesiseOQC()
+    test_profile_pass()
+    test_change_log()
+    test_parallel_regions()
+    test_apply_in_threads()
+    test_tracing()
@@ -23,6 +23,11 @@ from pytket.routing import (  # type: ignore
     Placement,
     SquareGrid,
     FullyConnected,
+    HeavyHexLattice,
+    HeavySquareLattice,
+    SycamoreLattice,
+    RoutingContext,
+    RoutingEngine,
     place_with_map,
     route,
 )
@@ -110,6 +115,25 @@ def test_arch_types() -> None:
     assert isinstance(sg, NodeGraph)
 
 
+def test_lattice_architectures() -> None:
+    hh = HeavyHexLattice(3, 9)
+    assert isinstance(hh, Architecture)
+    # Three rows of 9, with bridges at columns 0, 4, 8 then 2, 6
+    assert len(hh.nodes) == 27 + 5
+    assert len(hh.coupling) == 24 + 10
+    assert Node("heavyHexNode", 3, 6) in hh.nodes
+    hs = HeavySquareLattice(2, 2)
+    assert len(hs.nodes) == 8
+    assert len(hs.coupling) == 8
+    syc = SycamoreLattice(4, 3)
+    assert len(syc.nodes) == 12
+    assert len(syc.coupling) == 15
+    assert repr(syc) == "<tket::SycamoreLattice, rows=4, columns=3>"
+    c = Circuit(20).CX(0, 19).CX(3, 11).CX(7, 15)
+    routed = route(c, hh)
+    assert routed.n_gates >= 3
+
+
 def test_placements() -> None:
     test_coupling = [(0, 1), (1, 2), (1, 3), (4, 1), (4, 5)]
     test_architecture = Architecture(test_coupling)
@@ -479,6 +503,40 @@ def test_RoutingPass() -> None:
     assert out_circ_1.valid_connectivity(arc, False, True)
 
 
+def test_sabre_RoutingPass() -> None:
+    arc = SquareGrid(3, 3)
+    circ = Circuit(9)
+    for i in range(9):
+        circ.CX(i, (i + 4) % 9)
+        circ.CX(i, (i + 7) % 9)
+    r_pass = RoutingPass(arc, engine=RoutingEngine.Sabre, sabre_extended_set_size=10)
+    config = r_pass.to_dict()["StandardPass"]["routing_config"]
+    assert config["engine"] == "Sabre"
+    assert config["sabre_extended_set_size"] == 10
+    cu = CompilationUnit(circ)
+    placer = GraphPlacement(arc)
+    PlacementPass(placer).apply(cu)
+    r_pass.apply(cu)
+    out_circ = cu.circuit
+    assert out_circ.n_gates_of_type(OpType.BRIDGE) == 0
+    assert out_circ.valid_connectivity(arc, False, True)
+    routed = route(circ, arc, engine=RoutingEngine.Sabre)
+    assert routed.valid_connectivity(arc, False, True)
+
+
+def test_route_with_context() -> None:
+    arc = SquareGrid(3, 3)
+    context = RoutingContext(arc)
+    assert context.architecture == arc
+    for k in range(5):
+        circ = Circuit(9)
+        for i in range(9):
+            circ.CX(i, (i + k + 2) % 9)
+        routed = route(circ, context)
+        assert routed == route(circ, arc)
+        assert routed.valid_connectivity(arc, False, True)
+
+
 def test_FullMappingPass() -> None:
     arc = Architecture([[0, 2], [1, 3], [2, 3], [2, 4]])
     circ = Circuit(5)
@@ -258,8 +258,29 @@ def test_statevector() -> None:
                 check_matmul_failure_exception_string(str(e))
 
 
+def test_apply_unitary_in_place() -> None:
+    """Check that "apply_unitary_in_place" writes into the given array
+    without copying it, and agrees with "get_unitary_times_other"."""
+    for circ in get_circuit_triple():
+        unitary = circ.get_unitary()
+        assert unitary.flags["F_CONTIGUOUS"]
+        matr = np.asfortranarray(np.arange(8, dtype=complex).reshape(4, 2))
+        expected = circ.get_unitary_times_other(matr)
+        buffer = matr
+        circ.apply_unitary_in_place(matr)
+        assert matr is buffer
+        assert np.allclose(matr, expected)
+        assert np.allclose(matr, unitary @ np.arange(8).reshape(4, 2))
+        # Arrays which would need converting are rejected, not copied
+        with pytest.raises(TypeError):
+            circ.apply_unitary_in_place(np.ones((4, 2), dtype=complex))
+        with pytest.raises(TypeError):
+            circ.apply_unitary_in_place(np.ones((4, 2), dtype=float, order="F"))
+
+
 if __name__ == "__main__":
     test_premultiplication()
     test_circuit_unitaries_homomorphism_property()
     test_ry_matrix()
     test_statevector()
+    test_apply_unitary_in_place()
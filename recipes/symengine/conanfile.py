@@ -20,7 +20,7 @@ required_conan_version = ">=1.33.0"
 
 class SymengineConan(ConanFile):
     name = "symengine"
-    version = "0.8.1.1"
+    version = "0.8.1.2"
     description = "A fast symbolic manipulation library, written in C++"
     license = "MIT"
     topics = ("symbolic", "algebra")
@@ -63,6 +63,8 @@ class SymengineConan(ConanFile):
             self._cmake.definitions["BUILD_BENCHMARKS"] = False
             self._cmake.definitions["INTEGER_CLASS"] = self.options.integer_class
             self._cmake.definitions["MSVC_USE_MT"] = False
+            # tket shares expressions between threads
+            self._cmake.definitions["WITH_SYMENGINE_THREAD_SAFE"] = True
             self._cmake.configure()
         return self._cmake
 
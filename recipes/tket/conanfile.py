@@ -31,8 +31,16 @@ class TketConan(ConanFile):
         "shared": [True],
         "profile_coverage": [True, False],
         "spdlog_ho": [True, False],
+        "tracing": [True, False],
+        "sim_cuda": [True, False],
+    }
+    default_options = {
+        "shared": True,
+        "profile_coverage": False,
+        "spdlog_ho": True,
+        "tracing": True,
+        "sim_cuda": False,
     }
-    default_options = {"shared": True, "profile_coverage": False, "spdlog_ho": True}
     generators = "cmake"
     # Putting "patches" in both "exports_sources" and "exports" means that this works
     # in either the CI workflow (`conan create`) or the development workflow
@@ -41,7 +49,7 @@ class TketConan(ConanFile):
     exports = ["patches/*"]
     requires = (
         "boost/1.77.0",
-        "symengine/0.8.1.1",
+        "symengine/0.8.1.2",
         "eigen/3.4.0",
         "spdlog/1.9.2",
         "nlohmann_json/3.10.4",
@@ -53,6 +61,8 @@ class TketConan(ConanFile):
         if self._cmake is None:
             self._cmake = CMake(self)
             self._cmake.definitions["PROFILE_COVERAGE"] = self.options.profile_coverage
+            self._cmake.definitions["TKET_TRACING"] = self.options.tracing
+            self._cmake.definitions["TKET_SIM_CUDA"] = self.options.sim_cuda
             self._cmake.configure()
         return self._cmake
 
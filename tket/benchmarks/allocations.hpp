@@ -0,0 +1,152 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Allocation and peak memory counters for the benchmarks
+ *
+ * Allocations are only counted when TKET_BENCHMARK_ALLOCATIONS is defined
+ * (the CMake option of the same name), in which case this header replaces
+ * the global operator new and operator delete. It must then be included by
+ * exactly one translation unit of each benchmark executable. Peak resident
+ * set size is always reported where the platform provides it.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace tket_benchmarks {
+
+/** Number of calls to operator new */
+inline std::atomic<unsigned long long> n_allocations{0};
+
+/** Total bytes requested from operator new */
+inline std::atomic<unsigned long long> n_allocated_bytes{0};
+
+/** Peak resident set size of the process in bytes, or 0 if unknown */
+inline double peak_rss_bytes() {
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.;
+#if defined(__APPLE__)
+  return double(usage.ru_maxrss);
+#else
+  return 1024. * double(usage.ru_maxrss);
+#endif
+#else
+  return 0.;
+#endif
+}
+
+/**
+ * Allocations made between calls to start and stop, accumulated over the
+ * iterations of a benchmark
+ *
+ * Only allocations inside the measured regions are counted, so untimed set
+ * up (such as copying an input between PauseTiming and ResumeTiming) can be
+ * left outside them.
+ */
+class AllocationCounter {
+ public:
+  void start() {
+    allocations_ -= n_allocations.load(std::memory_order_relaxed);
+    bytes_ -= n_allocated_bytes.load(std::memory_order_relaxed);
+  }
+
+  void stop() {
+    allocations_ += n_allocations.load(std::memory_order_relaxed);
+    bytes_ += n_allocated_bytes.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Add the counters to a finished benchmark: allocations and bytes per
+   * iteration, allocations per unit of work (such as per gate) if
+   * \p n_units is non-zero, and peak resident set size
+   */
+  void report(
+      benchmark::State &state, double n_units = 0,
+      const std::string &unit = "gate") const {
+#ifdef TKET_BENCHMARK_ALLOCATIONS
+    const double iterations = double(state.iterations());
+    if (iterations > 0) {
+      state.counters["allocs"] = double(allocations_) / iterations;
+      state.counters["alloc_bytes"] = benchmark::Counter(
+          double(bytes_) / iterations, benchmark::Counter::kDefaults,
+          benchmark::Counter::kIs1024);
+      if (n_units > 0) {
+        state.counters["allocs_per_" + unit] =
+            double(allocations_) / iterations / n_units;
+      }
+    }
+#else
+    (void)n_units;
+    (void)unit;
+#endif
+    state.counters["peak_rss"] = benchmark::Counter(
+        peak_rss_bytes(), benchmark::Counter::kDefaults,
+        benchmark::Counter::kIs1024);
+  }
+
+ private:
+  // Deltas wrap around while a region is open, and are exact once closed
+  unsigned long long allocations_ = 0;
+  unsigned long long bytes_ = 0;
+};
+
+}  // namespace tket_benchmarks
+
+#ifdef TKET_BENCHMARK_ALLOCATIONS
+
+void *operator new(std::size_t size) {
+  tket_benchmarks::n_allocations.fetch_add(1, std::memory_order_relaxed);
+  tket_benchmarks::n_allocated_bytes.fetch_add(
+      size, std::memory_order_relaxed);
+  if (size == 0) size = 1;
+  if (void *p = std::malloc(size)) return p;
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return operator new(size);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return operator new(size, std::nothrow);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete[](void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+#endif
@@ -16,6 +16,8 @@
 
 // tket includes
 #include "Circuit/Circuit.hpp"
+#include "allocations.hpp"
+#include "inputs.hpp"
 
 class FX_Circuit : public ::benchmark::Fixture {
  public:
@@ -43,4 +45,43 @@ BENCHMARK_REGISTER_F(FX_Circuit, BM_Circuit)
     ->Repetitions(4)
     ->Unit(benchmark::kMicrosecond);
 
+// Arguments are the number of qubits and the depth
+static void BM_Circuit_Construction(benchmark::State& state) {
+  tket_benchmarks::AllocationCounter allocations;
+  unsigned n_gates = 0;
+  for (auto _ : state) {
+    allocations.start();
+    tket::Circuit c =
+        tket_benchmarks::random_circuit(state.range(0), state.range(1));
+    allocations.stop();
+    n_gates = c.n_gates();
+    benchmark::DoNotOptimize(c);
+  }
+  allocations.report(state, n_gates);
+}
+
+// Arguments are the number of qubits and the depth
+static void BM_Circuit_Copy(benchmark::State& state) {
+  const tket::Circuit circ =
+      tket_benchmarks::random_circuit(state.range(0), state.range(1));
+  tket_benchmarks::AllocationCounter allocations;
+  for (auto _ : state) {
+    allocations.start();
+    tket::Circuit c = circ;
+    allocations.stop();
+    benchmark::DoNotOptimize(c);
+  }
+  allocations.report(state, circ.n_gates());
+}
+
+BENCHMARK(BM_Circuit_Construction)
+    ->RangeMultiplier(4)
+    ->Ranges({{4, 64}, {16, 256}})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_Circuit_Copy)
+    ->RangeMultiplier(4)
+    ->Ranges({{4, 64}, {16, 256}})
+    ->Unit(benchmark::kMicrosecond);
+
 BENCHMARK_MAIN();
@@ -0,0 +1,201 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+// tket includes
+#include "Circuit/Circuit.hpp"
+#include "inputs.hpp"
+
+// Throughput of the graph rewrites that passes are built from, reported as
+// items (edits, or gates copied) per second. Arguments are the number of
+// gates in the circuit and the window of single-qubit gates the edits are
+// drawn from: the first gates in insertion order, or all of them if zero.
+// Small windows keep edits close together in the DAG and in memory.
+
+// Circuits of 16 qubits with about the given number of gates
+static const tket::Circuit& circuit_with_gates(unsigned n_gates) {
+  static std::map<unsigned, tket::Circuit> cache;
+  auto found = cache.find(n_gates);
+  if (found == cache.end()) {
+    // Each layer of random_circuit has 16 single-qubit gates and 8 CXs
+    unsigned depth = std::max(1u, n_gates / 24);
+    found =
+        cache.emplace(n_gates, tket_benchmarks::random_circuit(16, depth))
+            .first;
+  }
+  return found->second;
+}
+
+class FX_Mutation : public ::benchmark::Fixture {
+ public:
+  FX_Mutation() {}
+  void SetUp(const ::benchmark::State& state) {
+    circuit = circuit_with_gates(state.range(0));
+    // With an even number of qubits every single-qubit gate of
+    // random_circuit lies between CXs (or boundaries), so no two of them
+    // are adjacent
+    sites.clear();
+    BGL_FORALL_VERTICES(v, circuit.dag, tket::DAG) {
+      if (circuit.get_Op_ptr_from_Vertex(v)->get_desc().is_gate() &&
+          circuit.n_in_edges(v) == 1) {
+        sites.push_back(v);
+      }
+    }
+    window = sites.size();
+    if (state.range(1) > 0) {
+      window = std::min<std::size_t>(window, state.range(1));
+    }
+    gen.seed(1);
+  }
+  void TearDown(const ::benchmark::State&) {}
+  ~FX_Mutation() {}
+
+  std::size_t random_site() {
+    return std::uniform_int_distribution<std::size_t>(0, window - 1)(gen);
+  }
+
+  // Remove the gate at a site with rewiring and insert it again on the
+  // wire it was removed from, as a new vertex; two edits
+  void remove_and_insert(std::size_t i) {
+    const tket::Vertex v = sites[i];
+    const tket::Edge in = circuit.get_nth_in_edge(v, 0);
+    const tket::Vertex pred = circuit.source(in);
+    const tket::port_t port = circuit.get_source_port(in);
+    const tket::Op_ptr op = circuit.get_Op_ptr_from_Vertex(v);
+    circuit.remove_vertex(
+        v, tket::Circuit::GraphRewiring::Yes,
+        tket::Circuit::VertexDeletion::Yes);
+    reinsert(i, op, pred, port);
+  }
+
+  void reinsert(
+      std::size_t i, const tket::Op_ptr& op, const tket::Vertex& pred,
+      tket::port_t port) {
+    const tket::Edge e = circuit.get_nth_out_edge(pred, port);
+    const tket::Vertex w = circuit.add_vertex(op);
+    circuit.rewire(w, {e}, {tket::EdgeType::Quantum});
+    sites[i] = w;
+  }
+
+  tket::Circuit circuit;
+  std::vector<tket::Vertex> sites;
+  std::size_t window;
+  std::mt19937 gen;
+};
+
+static const unsigned edits_per_iteration = 1000;
+
+static void mutation_arguments(benchmark::internal::Benchmark* b) {
+  for (int n_gates = 1000; n_gates <= 1000000; n_gates *= 10) {
+    b->Args({n_gates, 64});
+    b->Args({n_gates, 0});
+  }
+}
+
+BENCHMARK_DEFINE_F(FX_Mutation, BM_RemoveVertex)
+(benchmark::State& state) {
+  for (auto _ : state) {
+    for (unsigned k = 0; k < edits_per_iteration; k += 2) {
+      remove_and_insert(random_site());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * edits_per_iteration);
+}
+
+BENCHMARK_DEFINE_F(FX_Mutation, BM_RemoveVertices)
+(benchmark::State& state) {
+  // Batches of distinct sites, removed together and inserted again
+  const std::size_t batch = std::min<std::size_t>(64, window);
+  long long edits = 0;
+  for (auto _ : state) {
+    for (unsigned k = 0; k < edits_per_iteration; k += 2 * batch) {
+      std::set<std::size_t> indices;
+      while (indices.size() < batch) indices.insert(random_site());
+      tket::VertexSet surplus;
+      std::vector<
+          std::tuple<std::size_t, tket::Op_ptr, tket::Vertex, tket::port_t>>
+          wires;
+      for (std::size_t i : indices) {
+        const tket::Vertex v = sites[i];
+        const tket::Edge in = circuit.get_nth_in_edge(v, 0);
+        surplus.insert(v);
+        wires.push_back(
+            {i, circuit.get_Op_ptr_from_Vertex(v), circuit.source(in),
+             circuit.get_source_port(in)});
+      }
+      circuit.remove_vertices(
+          surplus, tket::Circuit::GraphRewiring::Yes,
+          tket::Circuit::VertexDeletion::Yes);
+      for (const auto& [i, op, pred, port] : wires) {
+        reinsert(i, op, pred, port);
+      }
+      edits += 2 * batch;
+    }
+  }
+  state.SetItemsProcessed(edits);
+}
+
+BENCHMARK_DEFINE_F(FX_Mutation, BM_Substitute)
+(benchmark::State& state) {
+  tket::Circuit replacement(1);
+  replacement.add_op<unsigned>(tket::OpType::H, {0});
+  for (auto _ : state) {
+    for (unsigned k = 0; k < edits_per_iteration; ++k) {
+      const std::size_t i = random_site();
+      const tket::Edge in = circuit.get_nth_in_edge(sites[i], 0);
+      const tket::Vertex pred = circuit.source(in);
+      const tket::port_t port = circuit.get_source_port(in);
+      circuit.substitute(replacement, sites[i]);
+      sites[i] = circuit.target(circuit.get_nth_out_edge(pred, port));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * edits_per_iteration);
+}
+
+BENCHMARK_DEFINE_F(FX_Mutation, BM_CopyGraph)
+(benchmark::State& state) {
+  for (auto _ : state) {
+    tket::Circuit c;
+    benchmark::DoNotOptimize(c.copy_graph(circuit));
+  }
+  state.SetItemsProcessed(state.iterations() * circuit.n_vertices());
+}
+
+BENCHMARK_REGISTER_F(FX_Mutation, BM_RemoveVertex)
+    ->Apply(mutation_arguments)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(FX_Mutation, BM_RemoveVertices)
+    ->Apply(mutation_arguments)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(FX_Mutation, BM_Substitute)
+    ->Apply(mutation_arguments)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(FX_Mutation, BM_CopyGraph)
+    ->RangeMultiplier(10)
+    ->Ranges({{1000, 1000000}, {0, 0}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -14,37 +14,40 @@
 
 #include <benchmark/benchmark.h>
 
-#include <cstdlib>
-#include <fstream>
-#include <iostream>
+#include <string>
+#include <vector>
 
 // tket includes
 #include "Circuit/Circuit.hpp"
+#include "inputs.hpp"
 
-class FX_Circuit_Random : public ::benchmark::Fixture {
- public:
-  FX_Circuit_Random() {}
-  void SetUp(const ::benchmark::State&) {}
-  void TearDown(const ::benchmark::State&) {}
-  ~FX_Circuit_Random() {}
-  // TODO: Find a way to pass file path from benchmark arguments rather than
-  // hardcoded.
-  tket::Circuit circuit_random = tket::Circuit(
-      "./input_files/circuit_random_nb_qubits=20_nb_layers=200_example.tkc");
-};
-
-BENCHMARK_DEFINE_F(FX_Circuit_Random, BM_Circuit_Random)
-(benchmark::State& state) {
-  // Benchmark timing the Circuit::get_OpType_slices method
+// Benchmark timing the Circuit::get_OpType_slices method
+static void BM_Circuit_Random(
+    benchmark::State& state, const std::string& path) {
+  const tket::Circuit circuit_random(path);
   for (auto _ : state) {
     circuit_random.get_OpType_slices(tket::OpType::CX);
   }
 }
 
-BENCHMARK_REGISTER_F(FX_Circuit_Random, BM_Circuit_Random)
-    // ->DenseRange(0, 100, 100)
-    ->Iterations(1000)
-    ->Repetitions(4)
-    ->Unit(benchmark::kMicrosecond);
-
-BENCHMARK_MAIN();
+// Circuit files are given as --input=<path>, by default the example input
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  std::vector<std::string> files =
+      tket_benchmarks::take_input_files(argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  if (files.empty()) {
+    files.push_back(
+        "./input_files/"
+        "circuit_random_nb_qubits=20_nb_layers=200_example.tkc");
+  }
+  for (const std::string& path : files) {
+    benchmark::RegisterBenchmark(
+        ("BM_Circuit_Random/" + path).c_str(), BM_Circuit_Random, path)
+        ->Iterations(1000)
+        ->Repetitions(4)
+        ->Unit(benchmark::kMicrosecond);
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
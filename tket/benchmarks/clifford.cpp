@@ -0,0 +1,117 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <utility>
+#include <vector>
+
+// tket includes
+#include "Circuit/Circuit.hpp"
+#include "Clifford/CliffTableau.hpp"
+#include "Converters/Converters.hpp"
+#include "PauliGraph/PauliGraph.hpp"
+#include "inputs.hpp"
+
+// Arguments are the number of qubits and the depth of a random Clifford
+// circuit
+class FX_CliffTableau : public ::benchmark::Fixture {
+ public:
+  FX_CliffTableau() {}
+  void SetUp(const ::benchmark::State& state) {
+    circuit = tket_benchmarks::random_clifford_circuit(
+        state.range(0), state.range(1));
+    gates.clear();
+    for (const tket::Command& com : circuit) {
+      std::vector<unsigned> qbs;
+      for (const tket::Qubit& qb : com.get_qubits()) {
+        qbs.push_back(qb.index()[0]);
+      }
+      gates.push_back({com.get_op_ptr()->get_type(), std::move(qbs)});
+    }
+  }
+  void TearDown(const ::benchmark::State&) {}
+  ~FX_CliffTableau() {}
+  tket::Circuit circuit;
+  std::vector<std::pair<tket::OpType, std::vector<unsigned>>> gates;
+};
+
+BENCHMARK_DEFINE_F(FX_CliffTableau, BM_CliffTableau_ApplyGateAtEnd)
+(benchmark::State& state) {
+  for (auto _ : state) {
+    tket::CliffTableau tab(state.range(0));
+    for (const auto& [type, qbs] : gates) tab.apply_gate_at_end(type, qbs);
+    benchmark::DoNotOptimize(tab);
+  }
+  state.SetItemsProcessed(state.iterations() * gates.size());
+}
+
+BENCHMARK_DEFINE_F(FX_CliffTableau, BM_CircuitToTableau)
+(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tket::circuit_to_tableau(circuit));
+  }
+  state.SetItemsProcessed(state.iterations() * gates.size());
+}
+
+BENCHMARK_REGISTER_F(FX_CliffTableau, BM_CliffTableau_ApplyGateAtEnd)
+    ->RangeMultiplier(4)
+    ->Ranges({{4, 64}, {16, 256}})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_REGISTER_F(FX_CliffTableau, BM_CircuitToTableau)
+    ->RangeMultiplier(4)
+    ->Ranges({{4, 64}, {16, 256}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Arguments are the number of qubits and the number of Pauli gadgets, or
+// the depth of a random circuit of Clifford gates and rotations
+class FX_PauliGraph : public ::benchmark::Fixture {
+ public:
+  FX_PauliGraph() {}
+  void SetUp(const ::benchmark::State&) {}
+  void TearDown(const ::benchmark::State&) {}
+  ~FX_PauliGraph() {}
+
+  static void run(benchmark::State& state, const tket::Circuit& circ) {
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(tket::circuit_to_pauli_graph(circ));
+    }
+    state.counters["gates"] = circ.n_gates();
+  }
+};
+
+BENCHMARK_DEFINE_F(FX_PauliGraph, BM_PauliGraph_FromGadgets)
+(benchmark::State& state) {
+  run(state, tket_benchmarks::random_pauli_gadget_circuit(
+                 state.range(0), state.range(1)));
+}
+
+BENCHMARK_DEFINE_F(FX_PauliGraph, BM_PauliGraph_FromGates)
+(benchmark::State& state) {
+  run(state,
+      tket_benchmarks::random_circuit(state.range(0), state.range(1)));
+}
+
+BENCHMARK_REGISTER_F(FX_PauliGraph, BM_PauliGraph_FromGadgets)
+    ->RangeMultiplier(4)
+    ->Ranges({{4, 64}, {16, 256}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(FX_PauliGraph, BM_PauliGraph_FromGates)
+    ->RangeMultiplier(4)
+    ->Ranges({{4, 64}, {4, 64}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,127 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// tket includes
+#include "Circuit/Circuit.hpp"
+#include "Predicates/CompilationUnit.hpp"
+#include "Predicates/CompilerPass.hpp"
+#include "Predicates/PassGenerators.hpp"
+#include "Predicates/PassLibrary.hpp"
+#include "allocations.hpp"
+#include "corpus.hpp"
+#include "inputs.hpp"
+
+// End-to-end compilation of a corpus of application circuits with the
+// standard target pipelines. Each benchmark compiles one circuit with one
+// pipeline, and reports the sizes of the input and output circuits as
+// counters, besides the time and (with TKET_BENCHMARK_ALLOCATIONS) the
+// allocations. For results to track across releases, write them as JSON
+// with --benchmark_out=<file> --benchmark_out_format=json.
+//
+// The peak_rss counter is the peak of the whole process so far; to measure
+// it for one circuit, select its benchmarks alone with --benchmark_filter.
+
+namespace {
+
+// A pipeline, made for the architecture to map to
+struct Pipeline {
+  std::string name;
+  std::function<tket::PassPtr(const tket::Architecture&)> make;
+};
+
+const std::vector<Pipeline>& pipelines() {
+  static const std::vector<Pipeline> pipelines_ = {
+      {"FullPeepholeOptimise_DefaultMapping",
+       [](const tket::Architecture& arc) {
+         return tket::DecomposeBoxes() >> tket::FullPeepholeOptimise() >>
+                tket::gen_default_mapping_pass(arc);
+       }},
+      {"SynthesiseTket",
+       [](const tket::Architecture&) {
+         return tket::DecomposeBoxes() >> tket::SynthesiseTket();
+       }},
+      {"CliffordSimp", [](const tket::Architecture&) {
+         return tket::DecomposeBoxes() >> tket::gen_clifford_simp_pass();
+       }}};
+  return pipelines_;
+}
+
+unsigned n_multi_qubit_gates(const tket::Circuit& circ) {
+  unsigned n = 0;
+  for (const tket::Command& com : circ) {
+    if (com.get_qubits().size() > 1) n++;
+  }
+  return n;
+}
+
+void BM_CompileCorpus(
+    benchmark::State& state, const tket::Circuit& circ,
+    const Pipeline& pipeline) {
+  // Map onto the kind of device the circuit would run on
+  const tket::Architecture arc = tket_benchmarks::make_architecture(
+      tket_benchmarks::ArchitectureKind::HeavyHex, circ.n_qubits());
+  const tket::PassPtr pass = pipeline.make(arc);
+  tket_benchmarks::AllocationCounter allocations;
+  tket::Circuit out;
+  for (auto _ : state) {
+    state.PauseTiming();
+    tket::CompilationUnit cu(circ);
+    state.ResumeTiming();
+    allocations.start();
+    pass->apply(cu);
+    allocations.stop();
+    state.PauseTiming();
+    out = cu.get_circ_ref();
+    state.ResumeTiming();
+  }
+  state.counters["qubits"] = circ.n_qubits();
+  state.counters["gates_in"] = circ.n_gates();
+  state.counters["multi_qubit_gates_in"] = n_multi_qubit_gates(circ);
+  state.counters["gates_out"] = out.n_gates();
+  state.counters["multi_qubit_gates_out"] = n_multi_qubit_gates(out);
+  state.counters["depth_out"] = out.depth();
+  allocations.report(state, circ.n_gates());
+}
+
+}  // namespace
+
+// Further circuits are given as --input=<path>, of JSON (.json) or binary
+// (.tkcb) circuit files, and named by their path.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  const std::vector<std::string> files =
+      tket_benchmarks::take_input_files(argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  std::vector<tket_benchmarks::CorpusCircuit> corpus =
+      tket_benchmarks::generated_corpus();
+  for (const std::string& path : files) {
+    corpus.push_back({path, tket_benchmarks::load_circuit(path)});
+  }
+  for (const tket_benchmarks::CorpusCircuit& entry : corpus) {
+    for (const Pipeline& pipeline : pipelines()) {
+      benchmark::RegisterBenchmark(
+          ("BM_CompileCorpus/" + pipeline.name + "/" + entry.name).c_str(),
+          BM_CompileCorpus, entry.circ, pipeline)
+          ->Unit(benchmark::kMillisecond);
+    }
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
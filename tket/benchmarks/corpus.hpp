@@ -0,0 +1,285 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Corpus of application circuits for end-to-end compilation benchmarks
+ *
+ * The circuits are generated from their family, width and a seed, so the
+ * corpus is the same in every build and needs no input files. Further
+ * circuits can be loaded from JSON or binary circuit files (circuits in
+ * QASM can be converted to JSON with pytket).
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// tket includes
+#include "Circuit/Boxes.hpp"
+#include "Circuit/Circuit.hpp"
+#include "Circuit/CircuitBinary.hpp"
+#include "Utils/Json.hpp"
+#include "Utils/PauliStrings.hpp"
+
+namespace tket_benchmarks {
+
+/** Quantum Fourier transform, with the final qubit reversal as SWAPs */
+inline tket::Circuit qft_circuit(unsigned n_qubits) {
+  tket::Circuit circ(n_qubits);
+  for (unsigned i = 0; i < n_qubits; ++i) {
+    circ.add_op<unsigned>(tket::OpType::H, {i});
+    for (unsigned j = i + 1; j < n_qubits; ++j) {
+      circ.add_op<unsigned>(tket::OpType::CU1, std::pow(0.5, j - i), {j, i});
+    }
+  }
+  for (unsigned i = 0; i < n_qubits / 2; ++i) {
+    circ.add_op<unsigned>(tket::OpType::SWAP, {i, n_qubits - 1 - i});
+  }
+  return circ;
+}
+
+/**
+ * Cuccaro ripple-carry adder of two registers of n_bits bits, on
+ * 2 * n_bits + 2 qubits: a carry in, the interleaved bits of the two
+ * registers, and a carry out
+ */
+inline tket::Circuit adder_circuit(unsigned n_bits) {
+  tket::Circuit circ(2 * n_bits + 2);
+  const unsigned cin = 0, cout = 2 * n_bits + 1;
+  auto a = [](unsigned i) { return 1 + 2 * i; };
+  auto b = [](unsigned i) { return 2 + 2 * i; };
+  auto maj = [&circ](unsigned c, unsigned y, unsigned x) {
+    circ.add_op<unsigned>(tket::OpType::CX, {x, y});
+    circ.add_op<unsigned>(tket::OpType::CX, {x, c});
+    circ.add_op<unsigned>(tket::OpType::CCX, {c, y, x});
+  };
+  auto uma = [&circ](unsigned c, unsigned y, unsigned x) {
+    circ.add_op<unsigned>(tket::OpType::CCX, {c, y, x});
+    circ.add_op<unsigned>(tket::OpType::CX, {x, c});
+    circ.add_op<unsigned>(tket::OpType::CX, {c, y});
+  };
+  maj(cin, b(0), a(0));
+  for (unsigned i = 1; i < n_bits; ++i) maj(a(i - 1), b(i), a(i));
+  circ.add_op<unsigned>(tket::OpType::CX, {a(n_bits - 1), cout});
+  for (unsigned i = n_bits - 1; i > 0; --i) uma(a(i - 1), b(i), a(i));
+  uma(cin, b(0), a(0));
+  return circ;
+}
+
+/**
+ * QAOA for MaxCut on a ring with random chords, with the given number of
+ * rounds of cost and mixer layers at random angles
+ */
+inline tket::Circuit qaoa_circuit(
+    unsigned n_qubits, unsigned n_rounds = 2, unsigned seed = 1) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> angle(0., 2.);
+  std::uniform_int_distribution<unsigned> node(0, n_qubits - 1);
+  std::vector<std::pair<unsigned, unsigned>> edges;
+  for (unsigned i = 0; i < n_qubits; ++i) {
+    edges.push_back({i, (i + 1) % n_qubits});
+  }
+  for (unsigned k = 0; k < n_qubits / 2; ++k) {
+    const unsigned i = node(gen), j = node(gen);
+    if (i != j) edges.push_back({i, j});
+  }
+  tket::Circuit circ(n_qubits);
+  for (unsigned q = 0; q < n_qubits; ++q) {
+    circ.add_op<unsigned>(tket::OpType::H, {q});
+  }
+  for (unsigned r = 0; r < n_rounds; ++r) {
+    const double gamma = angle(gen), beta = angle(gen);
+    for (const std::pair<unsigned, unsigned> &e : edges) {
+      circ.add_op<unsigned>(tket::OpType::CX, {e.first, e.second});
+      circ.add_op<unsigned>(tket::OpType::Rz, gamma, {e.second});
+      circ.add_op<unsigned>(tket::OpType::CX, {e.first, e.second});
+    }
+    for (unsigned q = 0; q < n_qubits; ++q) {
+      circ.add_op<unsigned>(tket::OpType::Rx, beta, {q});
+    }
+  }
+  return circ;
+}
+
+/**
+ * UCCSD ansatz on n_qubits spin orbitals, the lower half occupied, as Pauli
+ * gadgets of the Jordan-Wigner encoded excitations at random angles
+ */
+inline tket::Circuit uccsd_circuit(unsigned n_qubits, unsigned seed = 1) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> angle(0., 2.);
+  tket::Circuit circ(n_qubits);
+  std::vector<unsigned> qubits(n_qubits);
+  std::iota(qubits.begin(), qubits.end(), 0);
+  for (unsigned q = 0; q < n_qubits / 2; ++q) {
+    circ.add_op<unsigned>(tket::OpType::X, {q});
+  }
+  // Add a gadget for each assignment of X and Y to the ends of the
+  // excitation with an odd number of Ys, with Zs between the pairs of ends
+  auto excitation = [&](const std::vector<unsigned> &ends) {
+    const double t = angle(gen);
+    for (unsigned mask = 0; mask < (1u << ends.size()); ++mask) {
+      if (std::popcount(mask) % 2 == 0) continue;
+      std::vector<tket::Pauli> paulis(n_qubits, tket::Pauli::I);
+      for (unsigned k = 0; k < ends.size(); k += 2) {
+        for (unsigned q = ends[k] + 1; q < ends[k + 1]; ++q) {
+          paulis[q] = tket::Pauli::Z;
+        }
+      }
+      for (unsigned k = 0; k < ends.size(); ++k) {
+        paulis[ends[k]] = (mask >> k) & 1 ? tket::Pauli::Y : tket::Pauli::X;
+      }
+      circ.add_box(tket::PauliExpBox(paulis, t), qubits);
+    }
+  };
+  const unsigned n_occ = n_qubits / 2;
+  for (unsigned i = 0; i < n_occ; ++i) {
+    for (unsigned a = n_occ; a < n_qubits; ++a) excitation({i, a});
+  }
+  for (unsigned i = 0; i < n_occ; ++i) {
+    for (unsigned j = i + 1; j < n_occ; ++j) {
+      for (unsigned a = n_occ; a < n_qubits; ++a) {
+        for (unsigned b = a + 1; b < n_qubits; ++b) {
+          excitation({i, j, a, b});
+        }
+      }
+    }
+  }
+  return circ;
+}
+
+/**
+ * Random Clifford+T circuit: layers of H, S, T or Tdg gates on every qubit
+ * followed by CXs between random pairs of qubits
+ */
+inline tket::Circuit random_clifford_t_circuit(
+    unsigned n_qubits, unsigned depth, unsigned seed = 1) {
+  std::mt19937 gen(seed);
+  const tket::OpType types[] = {
+      tket::OpType::H, tket::OpType::S, tket::OpType::T, tket::OpType::Tdg};
+  std::uniform_int_distribution<unsigned> gate(0, 3);
+  tket::Circuit circ(n_qubits);
+  std::vector<unsigned> qubits(n_qubits);
+  std::iota(qubits.begin(), qubits.end(), 0);
+  for (unsigned layer = 0; layer < depth; ++layer) {
+    for (unsigned q = 0; q < n_qubits; ++q) {
+      circ.add_op<unsigned>(types[gate(gen)], {q});
+    }
+    std::shuffle(qubits.begin(), qubits.end(), gen);
+    for (unsigned i = 0; i + 1 < n_qubits; i += 2) {
+      circ.add_op<unsigned>(tket::OpType::CX, {qubits[i], qubits[i + 1]});
+    }
+  }
+  return circ;
+}
+
+/**
+ * Quantum volume circuit: as many layers as qubits, each a random pairing
+ * of the qubits with a random two-qubit unitary on each pair, in the
+ * three-CX form of a general two-qubit unitary
+ */
+inline tket::Circuit quantum_volume_circuit(
+    unsigned n_qubits, unsigned seed = 1) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> angle(0., 2.);
+  tket::Circuit circ(n_qubits);
+  auto u3 = [&](unsigned q) {
+    circ.add_op<unsigned>(
+        tket::OpType::U3,
+        std::vector<tket::Expr>{angle(gen), angle(gen), angle(gen)}, {q});
+  };
+  std::vector<unsigned> qubits(n_qubits);
+  std::iota(qubits.begin(), qubits.end(), 0);
+  for (unsigned layer = 0; layer < n_qubits; ++layer) {
+    std::shuffle(qubits.begin(), qubits.end(), gen);
+    for (unsigned i = 0; i + 1 < n_qubits; i += 2) {
+      const unsigned a = qubits[i], b = qubits[i + 1];
+      u3(a);
+      u3(b);
+      circ.add_op<unsigned>(tket::OpType::CX, {a, b});
+      circ.add_op<unsigned>(tket::OpType::Rz, angle(gen), {a});
+      circ.add_op<unsigned>(tket::OpType::Ry, angle(gen), {b});
+      circ.add_op<unsigned>(tket::OpType::CX, {b, a});
+      circ.add_op<unsigned>(tket::OpType::Ry, angle(gen), {b});
+      circ.add_op<unsigned>(tket::OpType::CX, {a, b});
+      u3(a);
+      u3(b);
+    }
+  }
+  return circ;
+}
+
+/** A named circuit of the corpus */
+struct CorpusCircuit {
+  std::string name;
+  tket::Circuit circ;
+};
+
+/**
+ * The generated corpus: each family at several widths, named as
+ * "<family>/<number of qubits>"
+ */
+inline std::vector<CorpusCircuit> generated_corpus() {
+  std::vector<CorpusCircuit> corpus;
+  auto add = [&corpus](const std::string &family, tket::Circuit circ) {
+    std::string name = family + "/" + std::to_string(circ.n_qubits());
+    corpus.push_back({std::move(name), std::move(circ)});
+  };
+  for (unsigned n : {4, 8, 16}) add("qft", qft_circuit(n));
+  for (unsigned n : {2, 4, 8}) add("adder", adder_circuit(n));
+  for (unsigned n : {4, 8, 16}) add("qaoa", qaoa_circuit(n));
+  for (unsigned n : {4, 8}) add("uccsd", uccsd_circuit(n));
+  for (unsigned n : {4, 8, 16}) {
+    add("clifford_t", random_clifford_t_circuit(n, 4 * n));
+  }
+  for (unsigned n : {4, 8, 16}) {
+    add("quantum_volume", quantum_volume_circuit(n));
+  }
+  return corpus;
+}
+
+/**
+ * Load a circuit from a file of its JSON serialization (".json") or its
+ * binary serialization (".tkcb")
+ *
+ * @throw std::invalid_argument if the file has neither extension or cannot
+ *  be opened
+ */
+inline tket::Circuit load_circuit(const std::string &path) {
+  auto has_suffix = [&path](const std::string &suffix) {
+    return path.size() >= suffix.size() &&
+           path.compare(path.size() - suffix.size(), suffix.size(), suffix) ==
+               0;
+  };
+  if (has_suffix(".tkcb")) return tket::read_circuit_binary_file(path);
+  if (!has_suffix(".json")) {
+    throw std::invalid_argument(
+        "Circuit file " + path + " is neither .json nor .tkcb");
+  }
+  std::ifstream in(path);
+  if (!in) throw std::invalid_argument("Cannot open circuit file " + path);
+  return nlohmann::json::parse(in).get<tket::Circuit>();
+}
+
+}  // namespace tket_benchmarks
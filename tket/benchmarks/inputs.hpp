@@ -0,0 +1,219 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Generated inputs and input file arguments shared by the benchmarks
+ *
+ * Generated inputs depend only on their size arguments and a seed, so runs
+ * are comparable between builds.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <list>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// tket includes
+#include "Architecture/Architecture.hpp"
+#include "Circuit/Boxes.hpp"
+#include "Circuit/Circuit.hpp"
+#include "Utils/PauliStrings.hpp"
+
+namespace tket_benchmarks {
+
+/**
+ * Random circuit with layers of single-qubit gates on every qubit followed
+ * by CXs between random pairs of qubits
+ */
+inline tket::Circuit random_circuit(
+    unsigned n_qubits, unsigned depth, unsigned seed = 1) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<unsigned> gate(0, 3);
+  std::uniform_real_distribution<double> angle(0., 2.);
+  tket::Circuit circ(n_qubits);
+  std::vector<unsigned> qubits(n_qubits);
+  std::iota(qubits.begin(), qubits.end(), 0);
+  for (unsigned layer = 0; layer < depth; ++layer) {
+    for (unsigned q = 0; q < n_qubits; ++q) {
+      switch (gate(gen)) {
+        case 0:
+          circ.add_op<unsigned>(tket::OpType::H, {q});
+          break;
+        case 1:
+          circ.add_op<unsigned>(tket::OpType::T, {q});
+          break;
+        case 2:
+          circ.add_op<unsigned>(tket::OpType::Rz, angle(gen), {q});
+          break;
+        default:
+          circ.add_op<unsigned>(tket::OpType::Rx, angle(gen), {q});
+      }
+    }
+    std::shuffle(qubits.begin(), qubits.end(), gen);
+    for (unsigned i = 0; i + 1 < n_qubits; i += 2) {
+      circ.add_op<unsigned>(tket::OpType::CX, {qubits[i], qubits[i + 1]});
+    }
+  }
+  return circ;
+}
+
+/** Random Clifford circuit, built like \ref random_circuit */
+inline tket::Circuit random_clifford_circuit(
+    unsigned n_qubits, unsigned depth, unsigned seed = 1) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<unsigned> gate(0, 2);
+  tket::Circuit circ(n_qubits);
+  std::vector<unsigned> qubits(n_qubits);
+  std::iota(qubits.begin(), qubits.end(), 0);
+  const tket::OpType types[] = {
+      tket::OpType::H, tket::OpType::S, tket::OpType::V};
+  for (unsigned layer = 0; layer < depth; ++layer) {
+    for (unsigned q = 0; q < n_qubits; ++q) {
+      circ.add_op<unsigned>(types[gate(gen)], {q});
+    }
+    std::shuffle(qubits.begin(), qubits.end(), gen);
+    for (unsigned i = 0; i + 1 < n_qubits; i += 2) {
+      circ.add_op<unsigned>(tket::OpType::CX, {qubits[i], qubits[i + 1]});
+    }
+  }
+  return circ;
+}
+
+/** Random Pauli string on the default register */
+inline tket::QubitPauliString random_pauli_string(
+    unsigned n_qubits, std::mt19937 &gen) {
+  std::uniform_int_distribution<unsigned> pauli(0, 3);
+  tket::QubitPauliString qps;
+  for (unsigned q = 0; q < n_qubits; ++q) {
+    qps.set(tket::Qubit(q), static_cast<tket::Pauli>(pauli(gen)));
+  }
+  return qps;
+}
+
+/** Distinct random Pauli strings */
+inline std::list<tket::QubitPauliString> random_pauli_strings(
+    unsigned n_qubits, unsigned n_strings, unsigned seed = 1) {
+  std::mt19937 gen(seed);
+  std::list<tket::QubitPauliString> strings;
+  std::set<tket::QubitPauliString> seen;
+  // There are fewer than n_strings distinct strings on very few qubits
+  const double max_distinct = std::pow(4., n_qubits);
+  while (strings.size() < n_strings && seen.size() < max_distinct) {
+    tket::QubitPauliString qps = random_pauli_string(n_qubits, gen);
+    if (seen.insert(qps).second) strings.push_back(qps);
+  }
+  return strings;
+}
+
+/** Circuit of random Pauli gadgets over all the qubits */
+inline tket::Circuit random_pauli_gadget_circuit(
+    unsigned n_qubits, unsigned n_gadgets, unsigned seed = 1) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<unsigned> pauli(0, 3);
+  std::uniform_real_distribution<double> angle(0., 2.);
+  tket::Circuit circ(n_qubits);
+  std::vector<unsigned> qubits(n_qubits);
+  std::iota(qubits.begin(), qubits.end(), 0);
+  for (unsigned g = 0; g < n_gadgets; ++g) {
+    std::vector<tket::Pauli> paulis(n_qubits);
+    for (tket::Pauli &p : paulis) p = static_cast<tket::Pauli>(pauli(gen));
+    circ.add_box(tket::PauliExpBox(paulis, angle(gen)), qubits);
+  }
+  return circ;
+}
+
+/** Kinds of architecture to route onto */
+enum class ArchitectureKind { Ring, Grid, HeavyHex };
+
+/** Square grid with at least the given number of nodes */
+inline tket::Architecture grid_architecture(unsigned n_nodes) {
+  unsigned rows = std::max(1u, unsigned(std::sqrt(double(n_nodes))));
+  unsigned columns = (n_nodes + rows - 1) / rows;
+  return tket::SquareGrid(rows, columns);
+}
+
+/**
+ * Heavy-hexagon lattice with at least the given number of nodes: rows of
+ * seven nodes, joined by a bridging node every fourth column, with the
+ * bridges offset on alternate rows
+ */
+inline tket::Architecture heavy_hex_architecture(unsigned n_nodes) {
+  const unsigned width = 7;
+  std::vector<std::pair<unsigned, unsigned>> edges;
+  std::vector<unsigned> prev_row;
+  unsigned next = 0;
+  for (unsigned r = 0; r == 0 || next < n_nodes; ++r) {
+    std::vector<unsigned> row(width);
+    for (unsigned c = 0; c < width; ++c) {
+      row[c] = next++;
+      if (c > 0) edges.push_back({row[c - 1], row[c]});
+    }
+    if (r > 0) {
+      for (unsigned c = (r % 2 == 1) ? 0 : 2; c < width; c += 4) {
+        unsigned bridge = next++;
+        edges.push_back({prev_row[c], bridge});
+        edges.push_back({bridge, row[c]});
+      }
+    }
+    prev_row = std::move(row);
+  }
+  return tket::Architecture(edges);
+}
+
+/** Architecture of the given kind with at least the given number of nodes */
+inline tket::Architecture make_architecture(
+    ArchitectureKind kind, unsigned n_nodes) {
+  switch (kind) {
+    case ArchitectureKind::Ring:
+      return tket::RingArch(n_nodes);
+    case ArchitectureKind::Grid:
+      return grid_architecture(n_nodes);
+    default:
+      return heavy_hex_architecture(n_nodes);
+  }
+}
+
+/**
+ * Remove the arguments of the form --input=<path> from the command line and
+ * return their paths
+ *
+ * Call after benchmark::Initialize, which removes the arguments it
+ * recognises, and before benchmark::ReportUnrecognizedArguments.
+ */
+inline std::vector<std::string> take_input_files(int &argc, char **argv) {
+  static const char prefix[] = "--input=";
+  const std::size_t prefix_len = std::strlen(prefix);
+  std::vector<std::string> files;
+  int kept = 1;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], prefix, prefix_len) == 0) {
+      files.push_back(argv[i] + prefix_len);
+    } else {
+      argv[kept++] = argv[i];
+    }
+  }
+  argc = kept;
+  return files;
+}
+
+}  // namespace tket_benchmarks
@@ -0,0 +1,86 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <benchmark/benchmark.h>
+
+// tket includes
+#include "Circuit/Circuit.hpp"
+#include "Transformations/Transform.hpp"
+#include "allocations.hpp"
+#include "inputs.hpp"
+
+// Arguments are the number of qubits and the depth or number of gadgets
+class FX_Passes : public ::benchmark::Fixture {
+ public:
+  FX_Passes() {}
+  void SetUp(const ::benchmark::State&) {}
+  void TearDown(const ::benchmark::State&) {}
+  ~FX_Passes() {}
+
+  // Time a transform on copies of a circuit
+  static void run(
+      benchmark::State& state, const tket::Transform& transform,
+      const tket::Circuit& circ) {
+    tket_benchmarks::AllocationCounter allocations;
+    for (auto _ : state) {
+      state.PauseTiming();
+      tket::Circuit c = circ;
+      state.ResumeTiming();
+      allocations.start();
+      transform.apply(c);
+      allocations.stop();
+      benchmark::DoNotOptimize(c);
+    }
+    state.counters["gates"] = circ.n_gates();
+    allocations.report(state, circ.n_gates());
+  }
+};
+
+BENCHMARK_DEFINE_F(FX_Passes, BM_FullPeepholeOptimise)
+(benchmark::State& state) {
+  run(state, tket::Transform::full_peephole_optimise(),
+      tket_benchmarks::random_circuit(state.range(0), state.range(1)));
+}
+
+BENCHMARK_DEFINE_F(FX_Passes, BM_CliffordSimp)
+(benchmark::State& state) {
+  run(state, tket::Transform::clifford_simp(),
+      tket_benchmarks::random_clifford_circuit(
+          state.range(0), state.range(1)));
+}
+
+BENCHMARK_DEFINE_F(FX_Passes, BM_SynthesisePauliGraph)
+(benchmark::State& state) {
+  run(state, tket::Transform::synthesise_pauli_graph(),
+      tket_benchmarks::random_pauli_gadget_circuit(
+          state.range(0), state.range(1)));
+}
+
+BENCHMARK_REGISTER_F(FX_Passes, BM_FullPeepholeOptimise)
+    ->RangeMultiplier(2)
+    ->Ranges({{4, 16}, {8, 64}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(FX_Passes, BM_CliffordSimp)
+    ->RangeMultiplier(2)
+    ->Ranges({{4, 32}, {8, 128}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(FX_Passes, BM_SynthesisePauliGraph)
+    ->RangeMultiplier(2)
+    ->Ranges({{4, 16}, {8, 64}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,100 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+// tket includes
+#include "Diagonalisation/PauliPartition.hpp"
+#include "Graphs/AdjacencyData.hpp"
+#include "Graphs/GraphColouring.hpp"
+#include "inputs.hpp"
+
+// Arguments are the number of qubits, the number of strings and the
+// PauliPartitionStrat
+class FX_PauliPartition : public ::benchmark::Fixture {
+ public:
+  FX_PauliPartition() {}
+  void SetUp(const ::benchmark::State& state) {
+    strings =
+        tket_benchmarks::random_pauli_strings(state.range(0), state.range(1));
+  }
+  void TearDown(const ::benchmark::State&) {}
+  ~FX_PauliPartition() {}
+  std::list<tket::QubitPauliString> strings;
+};
+
+BENCHMARK_DEFINE_F(FX_PauliPartition, BM_TermSequence)
+(benchmark::State& state) {
+  const tket::PauliPartitionStrat strat =
+      static_cast<tket::PauliPartitionStrat>(state.range(2));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tket::term_sequence(strings, strat));
+  }
+}
+
+// Commutation of every pair of strings
+BENCHMARK_DEFINE_F(FX_PauliPartition, BM_CommutesWith)
+(benchmark::State& state) {
+  const std::vector<tket::QubitPauliString> v(strings.begin(), strings.end());
+  for (auto _ : state) {
+    unsigned n_commuting = 0;
+    for (unsigned i = 0; i < v.size(); ++i) {
+      for (unsigned j = i + 1; j < v.size(); ++j) {
+        if (v[i].commutes_with(v[j])) ++n_commuting;
+      }
+    }
+    benchmark::DoNotOptimize(n_commuting);
+  }
+  state.SetItemsProcessed(
+      state.iterations() * v.size() * (v.size() - 1) / 2);
+}
+
+// Colouring of the graph of anticommuting pairs of strings, as partitioned
+// into commuting sets
+BENCHMARK_DEFINE_F(FX_PauliPartition, BM_GraphColouring)
+(benchmark::State& state) {
+  const std::vector<tket::QubitPauliString> v(strings.begin(), strings.end());
+  tket::graphs::AdjacencyData graph(v.size());
+  for (unsigned i = 0; i < v.size(); ++i) {
+    for (unsigned j = i + 1; j < v.size(); ++j) {
+      if (!v[i].commutes_with(v[j])) graph.add_edge(i, j);
+    }
+  }
+  tket::graphs::GraphColouringResult result;
+  for (auto _ : state) {
+    result = tket::graphs::GraphColouringRoutines::get_colouring(graph, 1000);
+  }
+  state.counters["colours"] = result.number_of_colours;
+  state.counters["exact"] = result.is_exact;
+}
+
+BENCHMARK_REGISTER_F(FX_PauliPartition, BM_TermSequence)
+    ->RangeMultiplier(4)
+    ->Ranges({{4, 16}, {16, 1024}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(FX_PauliPartition, BM_CommutesWith)
+    ->RangeMultiplier(4)
+    ->Ranges({{4, 64}, {16, 1024}})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_REGISTER_F(FX_PauliPartition, BM_GraphColouring)
+    ->RangeMultiplier(4)
+    ->Ranges({{4, 16}, {16, 256}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,75 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <benchmark/benchmark.h>
+
+// tket includes
+#include "Architecture/Architecture.hpp"
+#include "Circuit/Circuit.hpp"
+#include "Routing/Placement.hpp"
+#include "Routing/Routing.hpp"
+#include "inputs.hpp"
+
+// Arguments are the number of qubits, the depth and the ArchitectureKind
+class FX_Routing : public ::benchmark::Fixture {
+ public:
+  FX_Routing() {}
+  void SetUp(const ::benchmark::State& state) {
+    circuit = tket_benchmarks::random_circuit(state.range(0), state.range(1));
+    architecture = tket_benchmarks::make_architecture(
+        static_cast<tket_benchmarks::ArchitectureKind>(state.range(2)),
+        state.range(0));
+  }
+  void TearDown(const ::benchmark::State&) {}
+  ~FX_Routing() {}
+  tket::Circuit circuit;
+  tket::Architecture architecture;
+};
+
+static void routing_arguments(benchmark::internal::Benchmark* b) {
+  for (int kind = 0; kind < 3; ++kind) {
+    for (int n_qubits = 8; n_qubits <= 64; n_qubits *= 2) {
+      for (int depth = 8; depth <= 64; depth *= 8) {
+        b->Args({n_qubits, depth, kind});
+      }
+    }
+  }
+}
+
+BENCHMARK_DEFINE_F(FX_Routing, BM_Routing_Solve)
+(benchmark::State& state) {
+  for (auto _ : state) {
+    tket::Routing router(circuit, architecture);
+    benchmark::DoNotOptimize(router.solve());
+  }
+}
+
+BENCHMARK_DEFINE_F(FX_Routing, BM_GraphPlacement)
+(benchmark::State& state) {
+  for (auto _ : state) {
+    tket::GraphPlacement placement(architecture);
+    benchmark::DoNotOptimize(placement.get_placement_map(circuit));
+  }
+}
+
+BENCHMARK_REGISTER_F(FX_Routing, BM_Routing_Solve)
+    ->Apply(routing_arguments)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(FX_Routing, BM_GraphPlacement)
+    ->Apply(routing_arguments)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,65 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+// tket includes
+#include "Circuit/Circuit.hpp"
+#include "Utils/Json.hpp"
+#include "inputs.hpp"
+
+// Serialise a circuit to a JSON string and read it back
+static void json_round_trip(
+    benchmark::State& state, const tket::Circuit& circ) {
+  for (auto _ : state) {
+    nlohmann::json j = circ;
+    nlohmann::json parsed = nlohmann::json::parse(j.dump());
+    benchmark::DoNotOptimize(parsed.get<tket::Circuit>());
+  }
+  state.counters["gates"] = circ.n_gates();
+}
+
+// Arguments are the number of qubits and the depth
+static void BM_JsonRoundTrip(benchmark::State& state) {
+  json_round_trip(
+      state, tket_benchmarks::random_circuit(state.range(0), state.range(1)));
+}
+
+BENCHMARK(BM_JsonRoundTrip)
+    ->RangeMultiplier(4)
+    ->Ranges({{4, 64}, {16, 256}})
+    ->Unit(benchmark::kMillisecond);
+
+// Circuit files given as --input=<path> are benchmarked as well
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  std::vector<std::string> files =
+      tket_benchmarks::take_input_files(argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  for (const std::string& path : files) {
+    benchmark::RegisterBenchmark(
+        ("BM_JsonRoundTrip/" + path).c_str(),
+        [](benchmark::State& state, const std::string& file) {
+          json_round_trip(state, tket::Circuit(file));
+        },
+        path)
+        ->Unit(benchmark::kMillisecond);
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,49 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <benchmark/benchmark.h>
+
+// tket includes
+#include "Circuit/Circuit.hpp"
+#include "Simulation/CircuitSimulator.hpp"
+#include "inputs.hpp"
+
+// Arguments are the number of qubits and the depth
+class FX_Simulation : public ::benchmark::Fixture {
+ public:
+  FX_Simulation() {}
+  void SetUp(const ::benchmark::State& state) {
+    circuit = tket_benchmarks::random_circuit(state.range(0), state.range(1));
+  }
+  void TearDown(const ::benchmark::State&) {}
+  ~FX_Simulation() {}
+  tket::Circuit circuit;
+};
+
+BENCHMARK_DEFINE_F(FX_Simulation, BM_GetStatevector)
+(benchmark::State& state) {
+  const unsigned n_qubits = state.range(0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        tket::tket_sim::get_statevector(circuit, tket::EPS, n_qubits));
+  }
+}
+
+BENCHMARK_REGISTER_F(FX_Simulation, BM_GetStatevector)
+    ->RangeMultiplier(2)
+    ->Ranges({{4, 16}, {8, 64}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
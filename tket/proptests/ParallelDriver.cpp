@@ -0,0 +1,196 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ParallelDriver.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "Utils/Parallel.hpp"
+#include "rapidcheck.h"
+
+namespace tket {
+
+namespace {
+
+struct LabelStats {
+  std::uint64_t cases = 0;
+  double seconds = 0;
+};
+
+struct Failure {
+  std::uint64_t case_number;
+  std::string property;
+  std::string message;
+  std::string log;
+};
+
+}  // namespace
+
+// Message for the exception being handled, or nullopt if the case was
+// discarded (e.g. by RC_PRE) rather than failed
+static std::optional<std::string> describe_current_exception() {
+  try {
+    throw;
+  } catch (const rc::detail::CaseResult &result) {
+    if (result.type != rc::detail::CaseResult::Type::Failure) {
+      return std::nullopt;
+    }
+    return result.description;
+  } catch (const std::exception &e) {
+    return std::string("Exception thrown: ") + e.what();
+  } catch (...) {
+    return std::string("Unknown exception thrown");
+  }
+}
+
+static std::uint64_t parse_number(
+    const std::string &arg, const std::string &value) {
+  try {
+    std::size_t end;
+    const unsigned long long n = std::stoull(value, &end);
+    if (end == value.size()) return n;
+  } catch (const std::exception &) {
+  }
+  throw std::invalid_argument("Invalid number in argument " + arg);
+}
+
+DriverOptions parse_driver_options(const std::vector<std::string> &args) {
+  DriverOptions options;
+  for (const std::string &arg : args) {
+    const std::size_t eq = arg.find('=');
+    const std::string key = arg.substr(0, eq);
+    const std::string value =
+        (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+    if (key == "--threads") {
+      options.threads = unsigned(parse_number(arg, value));
+    } else if (key == "--seconds") {
+      try {
+        options.seconds = std::stod(value);
+      } catch (const std::exception &) {
+        throw std::invalid_argument("Invalid number in argument " + arg);
+      }
+    } else if (key == "--cases") {
+      options.max_cases = parse_number(arg, value);
+    } else if (key == "--seed") {
+      options.seed = parse_number(arg, value);
+    } else if (key == "--replay") {
+      options.replay = parse_number(arg, value);
+    } else if (key == "--max-failures") {
+      options.max_failures = unsigned(parse_number(arg, value));
+    } else {
+      throw std::invalid_argument("Unrecognised argument " + arg);
+    }
+  }
+  return options;
+}
+
+bool run_parallel(
+    const std::vector<Property> &properties, const DriverOptions &options) {
+  if (properties.empty()) return true;
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point start = Clock::now();
+  const Clock::time_point deadline =
+      start + std::chrono::duration_cast<Clock::duration>(
+                  std::chrono::duration<double>(options.seconds));
+  std::uint64_t end_case = std::numeric_limits<std::uint64_t>::max();
+  if (options.max_cases) end_case = *options.max_cases;
+  if (options.replay) end_case = *options.replay + 1;
+  std::atomic<std::uint64_t> next_case{options.replay.value_or(0)};
+  std::atomic<bool> stop{false};
+
+  std::mutex mutex;
+  std::map<std::string, LabelStats> stats;
+  std::vector<Failure> failures;
+
+  auto worker = [&]() {
+    // Merged into stats at the end, to keep the workers independent
+    std::map<std::string, LabelStats> local_stats;
+    while (!stop.load(std::memory_order_relaxed)) {
+      if (!options.replay && Clock::now() >= deadline) break;
+      const std::uint64_t n = next_case.fetch_add(1);
+      if (n >= end_case) break;
+      const Property &property = properties[n % properties.size()];
+      RngSource source(options.seed, n);
+      const Clock::time_point case_start = Clock::now();
+      std::string label;
+      std::optional<std::string> error;
+      try {
+        label = property.run(source);
+      } catch (...) {
+        error = describe_current_exception();
+      }
+      LabelStats &label_stats =
+          local_stats[label.empty() ? property.name
+                                    : property.name + ": " + label];
+      ++label_stats.cases;
+      label_stats.seconds +=
+          std::chrono::duration<double>(Clock::now() - case_start).count();
+      if (error) {
+        std::lock_guard<std::mutex> lock(mutex);
+        failures.push_back({n, property.name, *error, source.logged()});
+        if (failures.size() >= options.max_failures) stop = true;
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &[label, label_stats] : local_stats) {
+      stats[label].cases += label_stats.cases;
+      stats[label].seconds += label_stats.seconds;
+    }
+  };
+
+  unsigned n_threads = options.threads ? options.threads : get_max_threads();
+  if (options.replay) n_threads = 1;
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < n_threads; ++i) threads.emplace_back(worker);
+  for (std::thread &thread : threads) thread.join();
+  const double elapsed =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  for (const Failure &failure : failures) {
+    std::cout << "FAILED: " << failure.property << " (case "
+              << failure.case_number << ", seed " << options.seed
+              << "; rerun with --seed=" << options.seed
+              << " --replay=" << failure.case_number << ")\n"
+              << failure.message << "\n"
+              << failure.log << "\n\n";
+  }
+  std::uint64_t total = 0;
+  for (const auto &entry : stats) total += entry.second.cases;
+  std::cout << "Ran " << total << " cases in " << std::fixed
+            << std::setprecision(1) << elapsed << " s on " << n_threads
+            << " threads, seed " << options.seed << ": " << failures.size()
+            << " failed\n";
+  std::cout << std::setw(10) << "cases" << std::setw(12) << "cases/s"
+            << std::setw(12) << "ms/case"
+            << "  label\n";
+  for (const auto &[label, label_stats] : stats) {
+    std::cout << std::setw(10) << label_stats.cases << std::setw(12)
+              << std::setprecision(1) << label_stats.cases / elapsed
+              << std::setw(12) << std::setprecision(3)
+              << 1000 * label_stats.seconds / label_stats.cases << "  "
+              << label << "\n";
+  }
+  std::cout << std::flush;
+  return failures.empty();
+}
+
+}  // namespace tket
@@ -0,0 +1,80 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "RandomSource.hpp"
+
+namespace tket {
+
+/**
+ * A property to check on random cases.
+ *
+ * run generates a case from the source and checks it, throwing (e.g. with
+ * RC_ASSERT) if the check fails. It returns a label to report throughput
+ * under, such as the name of the pass it checked, or an empty string to
+ * report under the name of the property.
+ */
+struct Property {
+  std::string name;
+  std::function<std::string(RandomSource &)> run;
+};
+
+struct DriverOptions {
+  /** Number of worker threads; 0 for the default number of threads */
+  unsigned threads = 0;
+  /** Stop starting new cases after this many seconds */
+  double seconds = 60;
+  /** Stop after this many cases, if given */
+  std::optional<std::uint64_t> max_cases;
+  /** Base seed; case n of a run is generated from (seed, n) */
+  std::uint64_t seed = 0;
+  /** Run only this case, to reproduce a failure */
+  std::optional<std::uint64_t> replay;
+  /** Stop the run after this many failing cases */
+  unsigned max_failures = 10;
+};
+
+/**
+ * Parse the driver options from the command line
+ *
+ * Recognises --threads=N, --seconds=S, --cases=N, --seed=N, --replay=N and
+ * --max-failures=N.
+ *
+ * @throw std::invalid_argument for any other argument
+ */
+DriverOptions parse_driver_options(const std::vector<std::string> &args);
+
+/**
+ * Check properties on random cases in parallel, until the time or case
+ * budget is used up.
+ *
+ * Cases are numbered, and case n checks property n modulo the number of
+ * properties, generated from a std::mt19937 seeded with (seed, n), so any
+ * failure can be reproduced on its own with the replay option. Prints the
+ * failing cases, and the number of cases and cases per second for each
+ * label, to stdout.
+ *
+ * @return whether every case passed
+ */
+bool run_parallel(
+    const std::vector<Property> &properties, const DriverOptions &options);
+
+}  // namespace tket
@@ -0,0 +1,85 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace tket {
+
+/**
+ * Source of the random choices made when generating test cases.
+ *
+ * Properties draw all their inputs from a RandomSource, so the same
+ * property can be run under rapidcheck (which shrinks failing cases) or by
+ * the parallel driver, with a seeded generator per test case.
+ */
+class RandomSource {
+ public:
+  virtual ~RandomSource() = default;
+
+  /** Uniform integer in [lo, hi) */
+  virtual int in_range(int lo, int hi) = 0;
+
+  /** Uniform real number in [0, 1) */
+  virtual double unit() = 0;
+
+  /** Stream for a description of the case, shown if it fails */
+  virtual std::ostream &log() = 0;
+
+  /** Uniformly chosen element of a non-empty container */
+  template <typename Container>
+  const typename Container::value_type &element_of(const Container &c) {
+    if (c.empty()) throw std::logic_error("choosing from empty container");
+    auto it = c.begin();
+    std::advance(it, in_range(0, int(c.size())));
+    return *it;
+  }
+};
+
+/** RandomSource driven by a std::mt19937, for the parallel driver */
+class RngSource : public RandomSource {
+ public:
+  /** The choices depend only on the seed and the case number */
+  RngSource(std::uint64_t seed, std::uint64_t case_number) {
+    std::seed_seq seq{
+        std::uint32_t(seed), std::uint32_t(seed >> 32),
+        std::uint32_t(case_number), std::uint32_t(case_number >> 32)};
+    gen_.seed(seq);
+  }
+
+  int in_range(int lo, int hi) override {
+    return std::uniform_int_distribution<int>(lo, hi - 1)(gen_);
+  }
+
+  double unit() override {
+    return std::uniform_real_distribution<double>(0., 1.)(gen_);
+  }
+
+  std::ostream &log() override { return log_; }
+
+  /** Everything logged for the case so far */
+  std::string logged() const { return log_.str(); }
+
+ private:
+  std::mt19937 gen_;
+  std::ostringstream log_;
+};
+
+}  // namespace tket
@@ -12,12 +12,18 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <iostream>
+#include <string>
+#include <vector>
+
 #include "Architecture/Architecture.hpp"
 #include "Circuit/Circuit.hpp"
 #include "ComparisonFunctions.hpp"
+#include "ParallelDriver.hpp"
 #include "Predicates/PassGenerators.hpp"
 #include "Predicates/PassLibrary.hpp"
 #include "Predicates/Predicates.hpp"
+#include "RandomSource.hpp"
 #include "Simulation/CircuitSimulator.hpp"
 #include "Transformations/Transform.hpp"
 #include "Utils/Exceptions.hpp"
@@ -59,14 +65,27 @@ static const std::map<PassPtr, std::string> passes = {
 #undef NAMEPASS
 };
 
+// RandomSource drawing from rapidcheck's generators, inside rc::check
+class RcSource : public RandomSource {
+ public:
+  int in_range(int lo, int hi) override { return *rc::gen::inRange(lo, hi); }
+
+  double unit() override {
+    double x = *rc::gen::arbitrary<double>();
+    return x - floor(x);
+  }
+
+  std::ostream &log() override { return RC_LOG(); }
+};
+
 static std::vector<unsigned> random_subset(
-    const std::vector<unsigned> &v, unsigned k) {
+    RandomSource &src, const std::vector<unsigned> &v, unsigned k) {
   if (k > v.size()) throw std::logic_error("invalid subset size");
   std::vector<unsigned> rvec(k);
   std::set<unsigned> rset;
   unsigned i = 0;
   while (i < k) {
-    unsigned x = *rc::gen::elementOf(v);
+    unsigned x = src.element_of(v);
     bool added = rset.insert(x).second;
     if (added) {
       rvec[i] = x;
@@ -76,28 +95,26 @@ static std::vector<unsigned> random_subset(
   return rvec;
 }
 
-static std::vector<Expr> random_params(unsigned k) {
+static std::vector<Expr> random_params(RandomSource &src, unsigned k) {
   std::vector<Expr> rvec(k);
   for (unsigned i = 0; i < k; i++) {
-    double x = *rc::gen::arbitrary<double>();
     // Constrain to [0,2} to avoid rounding errors arising from enormous
     // values.
-    x -= floor(x);
-    rvec[i] = 2 * x;
+    rvec[i] = 2 * src.unit();
   }
   return rvec;
 }
 
 // Generate a random circuit with no classical wires.
-static Circuit random_circuit() {
-  int n_qb = *rc::gen::inRange(1, 5);
-  int n_g = *rc::gen::inRange(0, 16);
+static Circuit random_circuit(RandomSource &src) {
+  int n_qb = src.in_range(1, 5);
+  int n_g = src.in_range(0, 16);
   Circuit c(n_qb);
   std::vector<unsigned> qbs(n_qb);
   std::iota(qbs.begin(), qbs.end(), 0);
   int i = 0;
   while (i < n_g) {
-    OpType g = *rc::gen::elementOf(all_gate_types());
+    OpType g = src.element_of(all_gate_types());
     if (g == OpType::Measure)  // invalid without classical output
     {
       continue;
@@ -109,12 +126,12 @@ static Circuit random_circuit() {
       g_nq =
           std::count(sig.value().begin(), sig.value().end(), EdgeType::Quantum);
     } else {
-      g_nq = *rc::gen::inRange(1, n_qb + 1);
+      g_nq = src.in_range(1, n_qb + 1);
     }
     if (g_nq > n_qb) continue;
     unsigned g_np = opinfo.n_params();
-    std::vector<unsigned> qb = random_subset(qbs, g_nq);
-    std::vector<Expr> params = random_params(g_np);
+    std::vector<unsigned> qb = random_subset(src, qbs, g_nq);
+    std::vector<Expr> params = random_params(src, g_np);
     c.add_op<unsigned>(g, params, qb);
     i++;
   }
@@ -129,31 +146,31 @@ static bool sanity_check(const Circuit &c) {
   return i == n_gates;
 }
 
-static bool verify_n_qubits_for_ops(const Circuit &circ) {
+static bool verify_n_qubits_for_ops(RandomSource &src, const Circuit &circ) {
   // Check that n_qubits() gives the right answer for all operations.
   for (const Command &com : circ) {
     Op_ptr op = com.get_op_ptr();
     if (op->n_qubits() != com.get_args().size()) {
-      RC_LOG() << "Failure at command " << com << std::endl;
-      RC_LOG() << "Op::n_qubits() = " << op->n_qubits() << std::endl;
+      src.log() << "Failure at command " << com << std::endl;
+      src.log() << "Op::n_qubits() = " << op->n_qubits() << std::endl;
       return false;
     }
   }
   return true;
 }
 
-static std::set<Node> random_node_set() {
-  int n = *rc::gen::inRange(1, 10);
+static std::set<Node> random_node_set(RandomSource &src) {
+  int n = src.in_range(1, 10);
   std::set<Node> nodes;
   for (int i = 0; i < n; i++) {
-    int idx = *rc::gen::inRange(0, 20);
+    int idx = src.in_range(0, 20);
     nodes.insert(Node("x", idx));
   }
   return nodes;
 }
 
 static std::set<std::pair<Node, Node>> random_connected_graph(
-    std::set<Node> nodes) {
+    RandomSource &src, std::set<Node> nodes) {
   int n_nodes = nodes.size();
   std::set<std::pair<Node, Node>> links;
   // First connect all the nodes, one by one. Connect each new nodes to a
@@ -163,16 +180,16 @@ static std::set<std::pair<Node, Node>> random_connected_graph(
     if (connected.empty()) {
       connected.insert(node);
     } else {
-      Node node0 = *rc::gen::elementOf(connected);
+      Node node0 = src.element_of(connected);
       links.insert({node, node0});
       connected.insert(node);
     }
   }
   // Now add a random selection of new links.
-  int n_new = *rc::gen::inRange(0, 2 * n_nodes);
+  int n_new = src.in_range(0, 2 * n_nodes);
   for (int i = 0; i < n_new; i++) {
-    Node node0 = *rc::gen::elementOf(nodes);
-    Node node1 = *rc::gen::elementOf(nodes);
+    Node node0 = src.element_of(nodes);
+    Node node1 = src.element_of(nodes);
     if (node0 != node1) {
       links.insert({node0, node1});
     }
@@ -180,9 +197,9 @@ static std::set<std::pair<Node, Node>> random_connected_graph(
   return links;
 }
 
-static Architecture random_architecture() {
-  std::set<Node> nodes = random_node_set();
-  std::set<std::pair<Node, Node>> links = random_connected_graph(nodes);
+static Architecture random_architecture(RandomSource &src) {
+  std::set<Node> nodes = random_node_set(src);
+  std::set<std::pair<Node, Node>> links = random_connected_graph(src, nodes);
   Architecture arc(
       std::vector<std::pair<Node, Node>>(links.begin(), links.end()));
   return arc;
@@ -191,11 +208,13 @@ static Architecture random_architecture() {
 /**
  * Check correctness of a completed compilation pass.
  *
+ * @param[in] src source of the random states to compare on
  * @param[in] c0 original circuit
  * @param[in] cu compliation pass having been applied to \p c0
  */
-static void check_correctness(const Circuit &c0, const CompilationUnit &cu) {
-  RC_LOG() << "In Check Correctness" << std::endl;
+static void check_correctness(
+    RandomSource &src, const Circuit &c0, const CompilationUnit &cu) {
+  src.log() << "In Check Correctness" << std::endl;
 
   const Circuit &c1 = cu.get_circ_ref();
   const unit_bimap_t &initial_map = cu.get_initial_map_ref();
@@ -238,10 +257,19 @@ static void check_correctness(const Circuit &c0, const CompilationUnit &cu) {
                                            m_inv_fin = lift_perm(inv_fin);
 
   try {
-    const auto u1 = tket_sim::get_unitary(c1);
-    const auto u0 = tket_sim::get_unitary(c0_copy);
-    RC_ASSERT(tket_sim::compare_statevectors_or_unitaries(
-        u0, m_inv_fin * u1 * m_ini));
+    // Compare the circuits on random states rather than building their
+    // unitaries, so that large circuits can be checked too.
+    const Eigen::MatrixXcd states = tket_sim::random_states(
+        c0_copy.n_qubits(), 2, unsigned(src.in_range(0, 1 << 30)));
+    Eigen::MatrixXcd s0 = states;
+    Eigen::MatrixXcd s1 = m_ini * states;
+    tket_sim::apply_unitary(c0_copy, s0, EPS, 20);
+    tket_sim::apply_unitary(c1, s1, EPS, 20);
+    s1 = m_inv_fin * s1;
+    for (Eigen::Index col = 0; col < states.cols(); ++col) {
+      RC_ASSERT(tket_sim::compare_statevectors_or_unitaries(
+          s0.col(col), s1.col(col)));
+    }
   } catch (const Unsupported &) {
   } catch (const NotImplemented &) {
   }
@@ -251,153 +279,154 @@ static void check_correctness(const Circuit &c0, const CompilationUnit &cu) {
   RC_ASSERT(sanity_check(c1));
 }
 
-namespace rc {
+static std::string check_n_qubits(RandomSource &src) {
+  unsigned m = unsigned(src.in_range(0, 20));
+  Circuit c(m);
+  RC_ASSERT(c.n_qubits() == m);
+  return "";
+}
 
-template <>
-struct Arbitrary<Circuit> {
-  static Gen<Circuit> arbitrary() {
-    return gen::exec([] { return random_circuit(); });
+// Returns the name of the pass checked
+static std::string check_passes(RandomSource &src) {
+  // Also perform some sanity checks on the circuits before and after
+  // the transforms.
+  const Circuit c = random_circuit(src);
+  const PassPtr &p = src.element_of(passes).first;
+  verify_n_qubits_for_ops(src, c);
+  PassConditions pcons = p->get_conditions();
+  PredicatePtrMap precons = pcons.first;
+  PredicatePtrMap postcons = pcons.second.specific_postcons_;
+  if (std::all_of(precons.begin(), precons.end(), [&c](auto precon) {
+        return precon.second->verify(c);
+      })) {
+    src.log() << "\nCircuit (" << c.n_qubits() << " qubits, " << c.n_gates()
+              << " gates): " << c << std::endl;
+    src.log() << "Pass: " << passes.at(p) << std::endl;
+    CompilationUnit cu(c);
+    bool applied = (p->apply(cu));
+    const Circuit &c1 = cu.get_circ_ref();
+    verify_n_qubits_for_ops(src, c1);
+    src.log() << "\nNew circuit(" << c1.n_qubits() << " qubits, "
+              << c1.n_gates() << " gates): " << c1 << std::endl;
+    if (applied) {
+      for (auto postcon : postcons) {
+        RC_ASSERT(postcon.second->verify(c1));
+      }
+      check_correctness(src, c, cu);
+    } else {
+      RC_ASSERT(c == c1);
+    }
   }
-};
+  return passes.at(p);
+}
 
-template <>
-struct Arbitrary<PassPtr> {
-  static Gen<PassPtr> arbitrary() {
-    return gen::exec([] {
-      auto p = *rc::gen::elementOf(passes);
-      return p.first;
-    });
+static std::string check_mapping(RandomSource &src) {
+  const Circuit c = random_circuit(src);
+  const Architecture a = random_architecture(src);
+  // Exclude circuits with classical controls. TKET-235
+  PredicatePtr pp1 = std::make_shared<NoClassicalControlPredicate>();
+  if (!pp1->verify(c)) return "";
+  // Architecture must be big enough.
+  PredicatePtr pp2 = std::make_shared<MaxNQubitsPredicate>(a.n_nodes());
+  if (!pp2->verify(c)) return "";
+  // All gates must act on 1 or 2 qubits.
+  PredicatePtr pp3 = std::make_shared<MaxTwoQubitGatesPredicate>();
+  if (!pp3->verify(c)) return "";
+  PassPtr pass = gen_default_mapping_pass(a);
+  CompilationUnit cu(c);
+  bool applied = pass->apply(cu);
+  const Circuit &c1 = cu.get_circ_ref();
+  src.log() << "Circuit (" << c.n_qubits() << " qubits, " << c.n_gates()
+            << " gates): " << c;
+  src.log() << "Architecture (" << a.n_nodes() << " nodes): ";
+  const node_vector_t nodes = a.get_all_nodes_vec();
+  for (Node node0 : nodes) {
+    for (Node node1 : nodes) {
+      if (a.edge_exists(node0, node1)) {
+        src.log() << node0.repr() << "-->" << node1.repr() << "; ";
+      }
+    }
   }
-};
+  src.log() << std::endl;
+  src.log() << "Circuit (" << c1.n_qubits() << " qubits, " << c1.n_gates()
+            << " gates): " << c1;
 
-template <>
-struct Arbitrary<Architecture> {
-  static Gen<Architecture> arbitrary() {
-    return gen::exec([] { return random_architecture(); });
+  const unit_bimap_t &initial_map = cu.get_initial_map_ref();
+  const unit_bimap_t &final_map = cu.get_final_map_ref();
+  src.log() << "Initial Map:" << std::endl;
+  for (const auto &x : initial_map.left) {
+    src.log() << x.first.repr() << " " << x.second.repr() << std::endl;
   }
-};
-
-}  // namespace rc
-
-bool check_n_qubits() {
-  return rc::check("n_qubits is correct", [](const unsigned &n) {
-    unsigned m = n % 20;
-    Circuit c(m);
-    RC_ASSERT(c.n_qubits() == m);
-  });
+  src.log() << "Final Map:" << std::endl;
+  for (const auto &x : final_map.left) {
+    src.log() << x.first.repr() << " " << x.second.repr() << std::endl;
+  }
+  if (applied) {
+    check_correctness(src, c, cu);
+  } else {
+    RC_ASSERT(c == c1);
+  }
+  return "";
 }
 
-bool check_passes() {
-  return rc::check(
-      "preconditions and postconditions of passes are correct",
-      // Also perform some sanity checks on the circuits before and after
-      // the transforms.
-      [](const Circuit &c, const PassPtr &p) {
-        verify_n_qubits_for_ops(c);
-        PassConditions pcons = p->get_conditions();
-        PredicatePtrMap precons = pcons.first;
-        PredicatePtrMap postcons = pcons.second.specific_postcons_;
-        if (std::all_of(precons.begin(), precons.end(), [&c](auto precon) {
-              return precon.second->verify(c);
-            })) {
-          RC_LOG() << "\nCircuit (" << c.n_qubits() << " qubits, "
-                   << c.n_gates() << " gates): " << c << std::endl;
-          RC_LOG() << "Pass: " << passes.at(p) << std::endl;
-          CompilationUnit cu(c);
-          bool applied = (p->apply(cu));
-          const Circuit &c1 = cu.get_circ_ref();
-          verify_n_qubits_for_ops(c1);
-          RC_LOG() << "\nNew circuit(" << c1.n_qubits() << " qubits, "
-                   << c1.n_gates() << " gates): " << c1 << std::endl;
-          if (applied) {
-            for (auto postcon : postcons) {
-              RC_ASSERT(postcon.second->verify(c1));
-            }
-            check_correctness(c, cu);
-          } else {
-            RC_ASSERT(c == c1);
-          }
-        }
-      });
+static std::string check_initial_simplification(RandomSource &src) {
+  const Circuit c = random_circuit(src);
+  src.log() << "Circuit (" << c.n_qubits() << " qubits, " << c.n_gates()
+            << " gates): " << c << std::endl;
+  Circuit c1 = c;
+  Transform::simplify_initial(
+      Transform::AllowClassical::No, Transform::CreateAllQubits::Yes)
+      .apply(c1);
+  try {
+    const auto s = tket_sim::get_statevector(c);
+    const auto s1 = tket_sim::get_statevector(c1);
+    RC_ASSERT(tket_sim::compare_statevectors_or_unitaries(
+        s, s1, tket_sim::MatrixEquivalence::EQUAL_UP_TO_GLOBAL_PHASE));
+  } catch (const Unsupported &) {
+  } catch (const NotImplemented &) {
+  }
+  // If tket-sim doesn't recognise a gate, just ignore it.
+  // But if a gate is unknown, which exception SHOULD it be:
+  // "Unsupported" or "NotImplemented" ?
+  return "";
 }
 
-bool check_mapping() {
-  return rc::check(
-      "routing to different architectures",
-      [](const Circuit &c, const Architecture &a) {
-        // Exclude circuits with classical controls. TKET-235
-        PredicatePtr pp1 = std::make_shared<NoClassicalControlPredicate>();
-        if (!pp1->verify(c)) return;
-        // Architecture must be big enough.
-        PredicatePtr pp2 = std::make_shared<MaxNQubitsPredicate>(a.n_nodes());
-        if (!pp2->verify(c)) return;
-        // All gates must act on 1 or 2 qubits.
-        PredicatePtr pp3 = std::make_shared<MaxTwoQubitGatesPredicate>();
-        if (!pp3->verify(c)) return;
-        PassPtr pass = gen_default_mapping_pass(a);
-        CompilationUnit cu(c);
-        bool applied = pass->apply(cu);
-        const Circuit &c1 = cu.get_circ_ref();
-        RC_LOG() << "Circuit (" << c.n_qubits() << " qubits, " << c.n_gates()
-                 << " gates): " << c;
-        RC_LOG() << "Architecture (" << a.n_nodes() << " nodes): ";
-        const node_vector_t nodes = a.get_all_nodes_vec();
-        for (Node node0 : nodes) {
-          for (Node node1 : nodes) {
-            if (a.edge_exists(node0, node1)) {
-              RC_LOG() << node0.repr() << "-->" << node1.repr() << "; ";
-            }
-          }
-        }
-        RC_LOG() << std::endl;
-        RC_LOG() << "Circuit (" << c1.n_qubits() << " qubits, " << c1.n_gates()
-                 << " gates): " << c1;
-
-        const unit_bimap_t &initial_map = cu.get_initial_map_ref();
-        const unit_bimap_t &final_map = cu.get_final_map_ref();
-        RC_LOG() << "Initial Map:" << std::endl;
-        for (const auto &x : initial_map.left) {
-          RC_LOG() << x.first.repr() << " " << x.second.repr() << std::endl;
-        }
-        RC_LOG() << "Final Map:" << std::endl;
-        for (const auto &x : final_map.left) {
-          RC_LOG() << x.first.repr() << " " << x.second.repr() << std::endl;
-        }
-        if (applied) {
-          check_correctness(c, cu);
-        } else {
-          RC_ASSERT(c == c1);
-        }
-      });
-}
+static const std::vector<Property> properties = {
+    {"n_qubits is correct", check_n_qubits},
+    {"preconditions and postconditions of passes are correct", check_passes},
+    {"routing to different architectures", check_mapping},
+    {"initial simplification produces equivalent final state",
+     check_initial_simplification},
+};
 
-bool check_initial_simplification() {
-  return rc::check(
-      "initial simplification produces equivalent final state",
-      [](const Circuit &c) {
-        Circuit c1 = c;
-        Transform::simplify_initial(
-            Transform::AllowClassical::No, Transform::CreateAllQubits::Yes)
-            .apply(c1);
-        try {
-          const auto s = tket_sim::get_statevector(c);
-          const auto s1 = tket_sim::get_statevector(c1);
-          RC_ASSERT(tket_sim::compare_statevectors_or_unitaries(
-              s, s1, tket_sim::MatrixEquivalence::EQUAL_UP_TO_GLOBAL_PHASE));
-        } catch (const Unsupported &) {
-        } catch (const NotImplemented &) {
-        }
-        // If tket-sim doesn't recognise a gate, just ignore it.
-        // But if a gate is unknown, which exception SHOULD it be:
-        // "Unsupported" or "NotImplemented" ?
-      });
+static bool rc_check(const Property &property) {
+  return rc::check(property.name, [&property] {
+    RcSource src;
+    property.run(src);
+  });
 }
 
-int main() {
+// With no arguments, checks each property in turn with rapidcheck, which is
+// configured by the RC_PARAMS environment variable and shrinks failing
+// cases. With --parallel, checks them in parallel until a time or case
+// budget is used up, e.g. as a soak test:
+//   proptest --parallel --seconds=3600 --threads=16 --seed=42
+// See parse_driver_options for the other options.
+int main(int argc, char **argv) {
+  const std::vector<std::string> args(argv + 1, argv + argc);
+  if (!args.empty() && args[0] == "--parallel") {
+    DriverOptions options;
+    try {
+      options = parse_driver_options({args.begin() + 1, args.end()});
+    } catch (const std::invalid_argument &e) {
+      std::cerr << e.what() << std::endl;
+      return 2;
+    }
+    return run_parallel(properties, options) ? 0 : 1;
+  }
   bool ok = true;
-  ok = ok && check_n_qubits();
-  ok = ok && check_passes();
-  ok = ok && check_mapping();
-  ok = ok && check_initial_simplification();
+  for (const Property &property : properties) {
+    ok = ok && rc_check(property);
+  }
   return ok ? 0 : 1;
-}
\ No newline at end of file
+}
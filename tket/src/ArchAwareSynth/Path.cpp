@@ -14,7 +14,18 @@
 
 #include "Path.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <optional>
 #include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "Utils/Parallel.hpp"
 
 namespace tket {
 
@@ -41,17 +52,79 @@ namespace aas {
 PathHandler::PathHandler(const Architecture &arch)
     : PathHandler(arch.get_connectivity()) {}
 
+namespace {
+
+// Distances and paths already computed, by connectivity matrix. The same
+// matrices recur for each circuit synthesised for a device, and for each
+// column reduced in CNOT synthesis.
+class PathCache {
+ public:
+  struct Entry {
+    MatrixXu distances;
+    MatrixXu paths;
+  };
+
+  static std::string key(const MatrixXb &connectivity) {
+    std::string k = std::to_string(connectivity.rows()) + ":";
+    k.reserve(k.size() + connectivity.size());
+    for (unsigned i = 0; i != connectivity.rows(); ++i) {
+      for (unsigned j = 0; j != connectivity.cols(); ++j) {
+        k.push_back(connectivity(i, j) ? '1' : '0');
+      }
+    }
+    return k;
+  }
+
+  std::optional<Entry> find(const std::string &k) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(k);
+    if (it == entries_.end()) return std::nullopt;
+    return it->second;
+  }
+
+  void insert(const std::string &k, const Entry &entry) {
+    const std::size_t bytes = 2 * entry.distances.size() * sizeof(unsigned);
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Start afresh rather than grow without bound
+    if (bytes_ + bytes > max_bytes) {
+      entries_.clear();
+      bytes_ = 0;
+    }
+    if (entries_.insert({k, entry}).second) bytes_ += bytes;
+  }
+
+ private:
+  static constexpr std::size_t max_bytes = std::size_t{64} << 20;
+  std::mutex mutex_;
+  std::unordered_map<std::string, Entry> entries_;
+  std::size_t bytes_ = 0;
+};
+
+PathCache &path_cache() {
+  static PathCache cache;
+  return cache;
+}
+
+}  // namespace
+
 // breaks for devices with n_qubits >= UINT_MAX/2
 // For internal use.
 PathHandler::PathHandler(const MatrixXb &connectivity) {
   unsigned n = connectivity.rows();
   size = n;
+  connectivity_matrix_ = connectivity;
+
+  const std::string key = PathCache::key(connectivity);
+  if (std::optional<PathCache::Entry> cached = path_cache().find(key)) {
+    distance_matrix_ = std::move(cached->distances);
+    path_matrix_ = std::move(cached->paths);
+    return;
+  }
 
   unsigned approx_infinity = UINT_MAX >> 1;
   if (n >= approx_infinity) throw std::out_of_range("Qubit number too large");
   distance_matrix_ = MatrixXu::Constant(n, n, approx_infinity);
   path_matrix_ = MatrixXu::Constant(n, n, n);  // set all unreachable nodes to n
-  connectivity_matrix_ = connectivity;
 
   // Floyd-Warshall with path reconstruction, see:
   // https://en.wikipedia.org/wiki/Floyd–Warshall_algorithm#Pseudocode_[11]
@@ -77,6 +150,7 @@ PathHandler::PathHandler(const MatrixXb &connectivity) {
       }
     }
   }
+  path_cache().insert(key, {distance_matrix_, path_matrix_});
 }
 
 PathHandler PathHandler::construct_acyclic_handler() const {
@@ -164,7 +238,8 @@ std::list<unsigned> PathHandler::find_path(unsigned i, unsigned j) {
   return path;
 }
 
-std::vector<Node> find_hampath(const Architecture &arch, long timeout) {
+// Hamiltonian path by VF2 subgraph monomorphism of a line, within timeout
+static std::vector<Node> vf2_hampath(const Architecture &arch, long timeout) {
   using ArchitectureConn = Architecture::UndirectedConnGraph;
   ArchitectureConn undirected_target = arch.get_undirected_connectivity();
   unsigned n_nodes = arch.n_nodes();
@@ -193,6 +268,182 @@ std::vector<Node> find_hampath(const Architecture &arch, long timeout) {
   return hampath;
 }
 
+// Hamiltonian path of an undirected graph starting at a vertex, by
+// depth-first search visiting the neighbours with fewest unvisited neighbours
+// first (Warnsdorff's rule). Gives up at the deadline, or once stop is true.
+template <typename Graph>
+static std::optional<std::vector<unsigned>> hampath_from(
+    const Graph &graph, unsigned start,
+    const std::chrono::steady_clock::time_point &deadline,
+    const std::function<bool()> &stop) {
+  const unsigned n = boost::num_vertices(graph);
+  std::vector<std::vector<unsigned>> neighbours(n);
+  for (unsigned v = 0; v != n; ++v) {
+    for (auto [it, end] = boost::adjacent_vertices(v, graph); it != end;
+         ++it) {
+      if (*it != v) neighbours[v].push_back(*it);
+    }
+  }
+  std::vector<bool> visited(n, false);
+  std::vector<unsigned> unvisited_degree(n);
+  for (unsigned v = 0; v != n; ++v) unvisited_degree[v] = neighbours[v].size();
+  auto visit = [&](unsigned v, bool on) {
+    visited[v] = on;
+    for (unsigned w : neighbours[v]) {
+      if (on) {
+        --unvisited_degree[w];
+      } else {
+        ++unvisited_degree[w];
+      }
+    }
+  };
+  // Candidates still to try at each step of the path, best last
+  auto candidates = [&](unsigned v) {
+    std::vector<unsigned> next;
+    for (unsigned w : neighbours[v]) {
+      if (!visited[w]) next.push_back(w);
+    }
+    std::stable_sort(next.begin(), next.end(), [&](unsigned a, unsigned b) {
+      return unvisited_degree[a] > unvisited_degree[b];
+    });
+    return next;
+  };
+  std::vector<unsigned> path{start};
+  std::vector<std::vector<unsigned>> stack{candidates(start)};
+  visit(start, true);
+  unsigned long steps = 0;
+  while (path.size() < n) {
+    if (++steps % 1024 == 0 &&
+        (stop() || std::chrono::steady_clock::now() >= deadline)) {
+      return std::nullopt;
+    }
+    if (stack.back().empty()) {
+      // Backtrack
+      visit(path.back(), false);
+      path.pop_back();
+      stack.pop_back();
+      if (path.empty()) return std::nullopt;
+      continue;
+    }
+    const unsigned w = stack.back().back();
+    stack.back().pop_back();
+    visit(w, true);
+    path.push_back(w);
+    stack.push_back(candidates(w));
+  }
+  return path;
+}
+
+std::vector<Node> find_hampath_multistart(
+    const Architecture &arch, long timeout) {
+  using ArchitectureConn = Architecture::UndirectedConnGraph;
+  const ArchitectureConn graph = arch.get_undirected_connectivity();
+  const unsigned n = boost::num_vertices(graph);
+  if (n == 0) return {};
+  // A path ends at every vertex of degree one, so if there are any the
+  // search need only start from them.
+  std::vector<unsigned> starts;
+  for (unsigned v = 0; v != n; ++v) {
+    if (boost::degree(v, graph) <= 1) starts.push_back(v);
+  }
+  if (starts.size() > 2) return {};
+  std::vector<bool> reached(n, false);
+  std::vector<unsigned> queue{0};
+  reached[0] = true;
+  for (unsigned k = 0; k < queue.size(); ++k) {
+    for (auto [it, end] = boost::adjacent_vertices(queue[k], graph); it != end;
+         ++it) {
+      if (!reached[*it]) {
+        reached[*it] = true;
+        queue.push_back(*it);
+      }
+    }
+  }
+  if (queue.size() < n) return {};
+  if (starts.empty()) {
+    starts.resize(n);
+    std::iota(starts.begin(), starts.end(), 0);
+  }
+  const std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+  // Searches stop once one from an earlier start has succeeded, so the
+  // result is that of the first start which succeeds in time.
+  std::vector<std::optional<std::vector<unsigned>>> found(starts.size());
+  std::atomic<std::size_t> first_found = starts.size();
+  parallel_for(0, starts.size(), 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      if (first_found < i) return;
+      found[i] = hampath_from(graph, starts[i], deadline, [&first_found, i]() {
+        return first_found < i;
+      });
+      if (!found[i]) continue;
+      std::size_t current = first_found;
+      while (i < current && !first_found.compare_exchange_weak(current, i)) {
+      }
+      return;
+    }
+  });
+  for (const std::optional<std::vector<unsigned>> &path : found) {
+    if (!path) continue;
+    std::vector<Node> hampath;
+    for (unsigned v : *path) hampath.push_back(graph[v]);
+    return hampath;
+  }
+  return {};
+}
+
+namespace {
+
+// Hamiltonian paths already found, by architecture
+class HampathCache {
+ public:
+  struct Entry {
+    std::vector<Node> path;
+    // Timeout of the search, if it failed
+    long timeout;
+  };
+
+  std::optional<Entry> find(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return std::nullopt;
+    return it->second;
+  }
+
+  void insert(const std::string &key, const Entry &entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[key] = entry;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+HampathCache &hampath_cache() {
+  static HampathCache cache;
+  return cache;
+}
+
+}  // namespace
+
+std::vector<Node> find_hampath(const Architecture &arch, long timeout) {
+  nlohmann::json j = arch;
+  const std::string key = j.dump();
+  if (std::optional<HampathCache::Entry> cached = hampath_cache().find(key)) {
+    // A failed search is only repeated if given longer
+    if (!cached->path.empty() || cached->timeout >= timeout) {
+      return cached->path;
+    }
+  }
+  // VF2 comes first so that the path is the same as before the cache; the
+  // multi-start search catches the devices on which it runs out of time.
+  std::vector<Node> hampath = vf2_hampath(arch, timeout);
+  if (hampath.empty()) hampath = find_hampath_multistart(arch, timeout);
+  hampath_cache().insert(key, {hampath, timeout});
+  return hampath;
+}
+
 IterationOrder::IterationOrder(const Architecture &arch) {
   std::set<Node> visited_nodes;
 
@@ -263,13 +514,17 @@ std::ostream &operator<<(std::ostream &out, const PathHandler &path) {
   return out;
 }
 
-MatrixXb PathHandler::get_connectivity_matrix() const {
+const MatrixXb &PathHandler::get_connectivity_matrix() const {
   return connectivity_matrix_;
 }
 
-MatrixXu PathHandler::get_distance_matrix() const { return distance_matrix_; }
+const MatrixXu &PathHandler::get_distance_matrix() const {
+  return distance_matrix_;
+}
 
-MatrixXu PathHandler::get_path_matrix() const { return path_matrix_; }
+const MatrixXu &PathHandler::get_path_matrix() const {
+  return path_matrix_;
+}
 
 unsigned PathHandler::get_size() const { return size; }
 
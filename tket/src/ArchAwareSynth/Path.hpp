@@ -44,7 +44,8 @@ class PathHandler {
    * should only be used in the aas code. This function interprets the matrix as
    * a directed graph.
    * @param connectivity matrix with the different connections of the directed
-   * graph
+   * graph. Distances and paths are cached by connectivity matrix, so
+   * handlers for a matrix seen before are built without recomputing them.
    */
   explicit PathHandler(const MatrixXb &connectivity);
 
@@ -64,19 +65,19 @@ class PathHandler {
    * get connectivity_matrix_ of the pathhandler
    * @return connectivity_matrix_
    */
-  MatrixXb get_connectivity_matrix() const;
+  const MatrixXb &get_connectivity_matrix() const;
 
   /**
    * get distance_matrix_ of the pathhandler
    * @return distance_matrix_
    */
-  MatrixXu get_distance_matrix() const;
+  const MatrixXu &get_distance_matrix() const;
 
   /**
    * get path_matrix_ of the pathhandler
    * @return path_matrix_
    */
-  MatrixXu get_path_matrix() const;
+  const MatrixXu &get_path_matrix() const;
 
   /**
    * get size of the pathhandler
@@ -127,6 +128,11 @@ class IterationOrder {
  * Find a Hamiltonian path in the architecture. Returns {} if no
  * Hamiltonian path is found within timeout. Timeout is in ms.
  *
+ * Results are cached by architecture, so each device is searched once: a
+ * path found is returned again at once, and a failed search is repeated
+ * only if given a longer timeout. If the subgraph search fails, the
+ * multi-start search of \ref find_hampath_multistart is tried too.
+ *
  * @param arch architecture where the path is searched
  * @param timeout give the timeout for the search of the hamiltonpath,
  *                  default value is 10000
@@ -134,6 +140,21 @@ class IterationOrder {
  */
 std::vector<Node> find_hampath(const Architecture &arch, long timeout = 10000);
 
+/**
+ * Find a Hamiltonian path in the architecture by depth-first searches from
+ * several start nodes in parallel, each trying the neighbours with fewest
+ * unvisited neighbours first. Searches start from the nodes of degree one,
+ * if any, else from every node. Returns {} at once if the architecture is
+ * disconnected or has more than two nodes of degree one, and {} if no
+ * search succeeds within timeout, in ms.
+ *
+ * @param arch architecture where the path is searched
+ * @param timeout timeout for the searches
+ * @return ordered vector of nodes in the path found from the earliest start
+ */
+std::vector<Node> find_hampath_multistart(
+    const Architecture &arch, long timeout = 10000);
+
 /**
  * print out a given Pathhandler
  */
@@ -14,6 +14,8 @@
 
 #include "SteinerForest.hpp"
 
+#include "Utils/Parallel.hpp"
+
 namespace tket {
 namespace aas {
 
@@ -95,39 +97,59 @@ SteinerForest::SteinerForest(
   current_trees = new_trees;
 }
 
-void SteinerForest::add_row_globally(unsigned i, unsigned j) {
-  /* CNOT with control j and target i. Which way round the indices are is a wee
-   * bit fiddly. */
-  std::vector<unsigned> qbs = {j, i};
-  synth_circuit.add_op(OpType::CX, qbs);
-  linear_function.col_add(
-      i, j);  // prepend a CNOT to the linear reversible function
-
+// Apply a CNOT with control j and target i to all trees. Trees keep their
+// relative order, and are moved between cost buckets rather than copied.
+// Returns the phases of the trees fully reduced by the operation, in order.
+static std::list<Expr> add_row_to_trees(
+    CostedTrees &trees, unsigned &global_cost, unsigned &tree_count,
+    unsigned i, unsigned j) {
+  std::list<Expr> reduced;
   CostedTrees new_trees;
-
-  for (const auto &cost_trees : current_trees) {
-    for (auto tree_expr : cost_trees.second) {
-      tree_expr.first.add_row(i, j);
+  for (auto &cost_trees : trees) {
+    std::list<std::pair<SteinerTree, Expr>> &bucket = cost_trees.second;
+    while (!bucket.empty()) {
+      SteinerTree &tree = bucket.front().first;
+      /* The operation only changes trees in which i is a one */
+      if (tree.node_types[i] == SteinerNodeType::OneInTree ||
+          tree.node_types[i] == SteinerNodeType::Leaf) {
+        tree.add_row(i, j);
+      } else {
+        tree.last_operation_cost = 0;
+      }
       /* If the tree has been fully reduced, remove it from the
       forest */
-      if (tree_expr.first.fully_reduced()) {
-        std::vector<unsigned> qubit{i};
-        synth_circuit.add_op(OpType::Rz, tree_expr.second, qubit);
+      if (tree.fully_reduced()) {
+        reduced.push_back(bucket.front().second);
+        bucket.pop_front();
         --tree_count;
       }
       /* Otherwise, update the forest */
       else {
-        CostedTrees::iterator iter = new_trees.find(tree_expr.first.tree_cost);
-        if (iter == new_trees.end())
-          new_trees.insert({tree_expr.first.tree_cost, {tree_expr}});
-        else
-          iter->second.push_back(tree_expr);
-        unsigned cost_change = tree_expr.first.last_operation_cost;
-        global_cost += cost_change;
+        global_cost += tree.last_operation_cost;
+        std::list<std::pair<SteinerTree, Expr>> &target =
+            new_trees[tree.tree_cost];
+        target.splice(target.end(), bucket, bucket.begin());
       }
     }
   }
-  current_trees = new_trees;
+  trees = std::move(new_trees);
+  return reduced;
+}
+
+void SteinerForest::add_row_globally(unsigned i, unsigned j) {
+  /* CNOT with control j and target i. Which way round the indices are is a wee
+   * bit fiddly. */
+  std::vector<unsigned> qbs = {j, i};
+  synth_circuit.add_op(OpType::CX, qbs);
+  linear_function.col_add(
+      i, j);  // prepend a CNOT to the linear reversible function
+
+  std::list<Expr> reduced =
+      add_row_to_trees(current_trees, global_cost, tree_count, i, j);
+  for (const Expr &phase : reduced) {
+    std::vector<unsigned> qubit{i};
+    synth_circuit.add_op(OpType::Rz, phase, qubit);
+  }
 }
 
 void SteinerForest::add_operation_list(const OperationList &oper_list) {
@@ -136,12 +158,12 @@ void SteinerForest::add_operation_list(const OperationList &oper_list) {
   }
 }
 
-OperationList SteinerForest::operations_available_under_the_index(
-    const PathHandler &path, unsigned index) const {
+static OperationList operations_under_index(
+    const CostedTrees &trees, const PathHandler &path, unsigned index) {
   OperationList operations;
   for (unsigned i = 0; i != index; ++i) {
-    CostedTrees::const_iterator iter = current_trees.find(i);
-    if (iter == current_trees.end()) continue;
+    CostedTrees::const_iterator iter = trees.find(i);
+    if (iter == trees.end()) continue;
     for (const auto &tree_pair : iter->second) {
       operations.splice(
           operations.begin(), tree_pair.first.operations_available(path));
@@ -150,6 +172,11 @@ OperationList SteinerForest::operations_available_under_the_index(
   return operations;
 }
 
+OperationList SteinerForest::operations_available_under_the_index(
+    const PathHandler &path, unsigned index) const {
+  return operations_under_index(current_trees, path, index);
+}
+
 OperationList SteinerForest::operations_available_at_index(
     const PathHandler &path, unsigned index) const {
   OperationList operations;
@@ -177,6 +204,46 @@ OperationList SteinerForest::operations_available_at_min_costs(
   return operations;
 }
 
+// As recursive_operation_search, on the trees of a forest only: the
+// synthesised circuit and linear function play no part in the search, so
+// they are not copied into each branch.
+static CostedOperations search_trees(
+    const PathHandler &path, CostedTrees trees, unsigned global_cost,
+    unsigned lookahead, OperationList &row_operations) {
+  unsigned tree_count = 0;
+  add_row_to_trees(
+      trees, global_cost, tree_count, row_operations.back().first,
+      row_operations.back().second);
+
+  if ((lookahead == 0) || (trees.empty())) {
+    return {global_cost, row_operations};
+  }
+  CostedTrees::const_reverse_iterator r_iter = trees.rbegin();
+  unsigned index = r_iter->first;
+  OperationList operations_available =
+      operations_under_index(trees, path, index);
+  if (operations_available.empty()) {
+    return {global_cost, row_operations};
+  }
+  CostedOperations costed_operations;
+  bool first = true;
+  for (const Operation &op : operations_available) {
+    row_operations.push_back(op);
+    CostedOperations candidate_operations = search_trees(
+        path, trees, global_cost, lookahead - 1, row_operations);
+    row_operations.pop_back();
+
+    if (first || (candidate_operations.first < costed_operations.first) ||
+        ((candidate_operations.first == costed_operations.first) &&
+         (candidate_operations.second.size() <
+          costed_operations.second.size()))) {
+      costed_operations = std::move(candidate_operations);
+      first = false;
+    }
+  }
+  return costed_operations;
+}
+
 CostedOperations best_operations_lookahead(
     const PathHandler &path, const SteinerForest &forest, unsigned lookahead) {
   if (lookahead == 0) {
@@ -194,18 +261,26 @@ CostedOperations best_operations_lookahead(
     throw std::logic_error("Cannot find any operations");
   }
 
-  // set up base case
-  OperationList ops{operations_available.front()};
-  CostedOperations costed_operations =
-      recursive_operation_search(path, forest, lookahead - 1, ops);
-  operations_available.pop_front();
-
-  for (OperationList::iterator op_iter = operations_available.begin();
-       op_iter != operations_available.end(); ++op_iter) {
-    ops = {*op_iter};
-    CostedOperations candidate_operations =
-        recursive_operation_search(path, forest, lookahead - 1, ops);
+  // The candidates are searched independently, and in parallel when each
+  // search looks further ahead. The best is then chosen in the original
+  // order, so that ties are broken as in a serial search.
+  std::vector<Operation> candidates(
+      operations_available.begin(), operations_available.end());
+  std::vector<CostedOperations> results(candidates.size());
+  parallel_for(
+      0, candidates.size(), (lookahead > 1) ? 1 : 16,
+      [&](std::size_t begin, std::size_t end) {
+        for (std::size_t k = begin; k != end; ++k) {
+          OperationList ops{candidates[k]};
+          results[k] = search_trees(
+              path, forest.current_trees, forest.global_cost, lookahead - 1,
+              ops);
+        }
+      });
 
+  CostedOperations costed_operations = std::move(results.front());
+  for (unsigned k = 1; k != results.size(); ++k) {
+    CostedOperations &candidate_operations = results[k];
     if ((candidate_operations.first < costed_operations.first) ||
         ((candidate_operations.first == costed_operations.first) &&
          (candidate_operations.second.size() <
@@ -218,47 +293,11 @@ CostedOperations best_operations_lookahead(
 }
 
 CostedOperations recursive_operation_search(
-    const PathHandler &path, SteinerForest forest, unsigned lookahead,
+    const PathHandler &path, const SteinerForest &forest, unsigned lookahead,
     OperationList row_operations) {
-  CostedOperations costed_operations;
-  CostedOperations candidate_operations;
-
-  forest.add_row_globally(
-      row_operations.back().first, row_operations.back().second);
-
-  if ((lookahead == 0) || (forest.current_trees.empty())) {
-    return {forest.global_cost, row_operations};
-  }
-  CostedTrees::const_reverse_iterator r_iter = forest.current_trees.rbegin();
-  unsigned index = r_iter->first;
-  OperationList operations_available =
-      forest.operations_available_under_the_index(path, index);
-  if (operations_available.empty()) {
-    return {forest.global_cost, row_operations};
-  } else {
-    row_operations.push_back(operations_available.front());
-    costed_operations =
-        recursive_operation_search(path, forest, lookahead - 1, row_operations);
-    row_operations.pop_back();
-    operations_available.pop_front();
-
-    for (OperationList::iterator op_iter = operations_available.begin();
-         op_iter != operations_available.end(); ++op_iter) {
-      row_operations.push_back(*op_iter);
-      candidate_operations = recursive_operation_search(
-          path, forest, lookahead - 1, row_operations);
-
-      row_operations.pop_back();
-
-      if ((candidate_operations.first < costed_operations.first) ||
-          ((candidate_operations.first == costed_operations.first) &&
-           (candidate_operations.second.size() <
-            costed_operations.second.size()))) {
-        costed_operations = std::move(candidate_operations);
-      }
-    }
-    return costed_operations;
-  }
+  return search_trees(
+      path, forest.current_trees, forest.global_cost, lookahead,
+      row_operations);
 }
 
 Circuit phase_poly_synthesis_int(
@@ -353,7 +392,10 @@ Circuit phase_poly_synthesis(
 
   PhasePolyBox placed_ppb(circuit_ppb_place);
 
-  std::vector<Node> hampath = find_hampath(arch);  // using default timeout
+  std::vector<Node> hampath;
+  if (cnottype == CNotSynthType::HamPath) {
+    hampath = find_hampath(arch);  // using default timeout
+  }
 
   // create maps from qubits/node to int
   std::map<UnitID, UnitID> forward_contiguous_uids_q;
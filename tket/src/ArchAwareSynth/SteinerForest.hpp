@@ -110,7 +110,8 @@ class SteinerForest {
 };
 
 /**
- * searches for the best operation in the given forest
+ * searches for the best operation in the given forest. The first operation of
+ * each candidate sequence is searched in parallel.
  * @param path pathhandler used for the calculation
  * @param forest steinerforest used for the calculation
  * @param lookahead maximum steps of recursion used for the iteration
@@ -127,7 +128,7 @@ CostedOperations best_operations_lookahead(
  * @param row_operations operations which are executed before the search starts
  */
 CostedOperations recursive_operation_search(
-    const PathHandler &path, SteinerForest forest, unsigned lookahead,
+    const PathHandler &path, const SteinerForest &forest, unsigned lookahead,
     OperationList row_operations);
 
 /**
@@ -321,17 +321,19 @@ int SteinerTree::cost_of_operation(unsigned i, unsigned j) const {
 OperationList SteinerTree::operations_available(
     const PathHandler& pathhandler) const {
   OperationList operations;
+  const MatrixXb& connectivity = pathhandler.get_connectivity_matrix();
   for (unsigned i = 0; i != node_types.size(); ++i) {
+    if (node_types[i] != SteinerNodeType::OneInTree &&
+        node_types[i] != SteinerNodeType::Leaf) {
+      continue;
+    }
     for (unsigned j = 0; j != node_types.size(); ++j) {
       if (i == j) continue;
-      if (!pathhandler.get_connectivity_matrix()(i, j)) continue;
+      if (!connectivity(i, j)) continue;
 
-      if (node_types[i] == SteinerNodeType::OneInTree ||
-          node_types[i] == SteinerNodeType::Leaf) {
-        if (node_types[j] == SteinerNodeType::ZeroInTree ||
-            node_types[j] == SteinerNodeType::Leaf) {
-          operations.push_back({i, j});
-        }
+      if (node_types[j] == SteinerNodeType::ZeroInTree ||
+          node_types[j] == SteinerNodeType::Leaf) {
+        operations.push_back({i, j});
       }
     }
   }
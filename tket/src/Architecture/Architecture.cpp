@@ -15,6 +15,8 @@
 #include "Architecture/Architecture.hpp"
 
 #include <boost/graph/biconnected_components.hpp>
+#include <map>
+#include <memory>
 #include <unordered_set>
 #include <vector>
 
@@ -25,13 +27,9 @@
 namespace tket {
 
 Architecture Architecture::create_subarch(
-    const std::vector<Node>& subarc_nodes) {
-  Architecture subarc(subarc_nodes);
-  for (auto [u1, u2] : get_all_edges_vec()) {
-    if (subarc.node_exists(u1) && subarc.node_exists(u2)) {
-      subarc.add_connection(u1, u2);
-    }
-  }
+    const std::vector<Node>& subarc_nodes) const {
+  Architecture subarc;
+  subarc.build_induced_subgraph(*this, subarc_nodes);
   return subarc;
 }
 
@@ -49,8 +47,22 @@ std::vector<node_vector_t> Architecture::get_lines(
       required_lengths.begin(), required_lengths.end(),
       std::greater<unsigned>());
 
-  UndirectedConnGraph curr_graph(get_undirected_connectivity());
   std::vector<node_vector_t> found_lines;
+  if (const RoutingData* data = routing_data()) {
+    // Cut the lines from the precomputed path, if they fit
+    if (std::accumulate(
+            required_lengths.begin(), required_lengths.end(), std::size_t{0}) <=
+        data->long_path.size()) {
+      node_vector_t::const_iterator start = data->long_path.begin();
+      for (unsigned length : required_lengths) {
+        found_lines.push_back(node_vector_t(start, start + length));
+        start += length;
+      }
+      return found_lines;
+    }
+  }
+
+  UndirectedConnGraph curr_graph(get_undirected_connectivity());
   for (unsigned length : required_lengths) {
     std::vector<Vertex> longest(
         graphs::longest_simple_path(curr_graph, length));
@@ -77,6 +89,9 @@ std::set<Node> Architecture::get_articulation_points(
 }
 
 std::set<Node> Architecture::get_articulation_points() const {
+  if (const RoutingData* data = routing_data()) {
+    return data->articulation_points;
+  }
   std::set<Vertex> aps;
   UndirectedConnGraph undir_g = get_undirected_connectivity();
   boost::articulation_points(undir_g, std::inserter(aps, aps.begin()));
@@ -96,7 +111,13 @@ static bool lexicographical_comparison(
 
 std::optional<Node> Architecture::find_worst_node(
     const Architecture& original_arch) {
-  node_set_t ap = get_articulation_points();
+  std::map<Node, std::vector<std::size_t>> distances;
+  return find_worst_node(original_arch, get_articulation_points(), distances);
+}
+
+std::optional<Node> Architecture::find_worst_node(
+    const Architecture& original_arch, const node_set_t& ap,
+    std::map<Node, std::vector<std::size_t>>& distances) {
   node_set_t min_nodes = min_degree_nodes();
 
   std::set<Node> bad_nodes;
@@ -108,17 +129,24 @@ std::optional<Node> Architecture::find_worst_node(
     return std::nullopt;
   }
 
-  std::vector<std::size_t> worst_distances, temp_distances;
+  auto distances_from = [&](const Node& node) -> const std::vector<size_t>& {
+    auto it = distances.find(node);
+    if (it == distances.end()) {
+      it = distances.insert({node, get_distances(node)}).first;
+    }
+    return it->second;
+  };
+
   Node worst_node = *bad_nodes.begin();
-  worst_distances = get_distances(worst_node);
+  const std::vector<std::size_t>* worst_distances = &distances_from(worst_node);
   for (Node temp_node : bad_nodes) {
-    temp_distances = get_distances(temp_node);
+    const std::vector<std::size_t>& temp_distances = distances_from(temp_node);
 
     int distance_comp =
-        tri_lexicographical_comparison(temp_distances, worst_distances);
+        tri_lexicographical_comparison(temp_distances, *worst_distances);
     if (distance_comp == 1) {
       worst_node = temp_node;
-      worst_distances = temp_distances;
+      worst_distances = &temp_distances;
     } else if (distance_comp == -1) {
       std::vector<std::size_t> temp_distances_full =
           original_arch.get_distances(temp_node);
@@ -127,22 +155,68 @@ std::optional<Node> Architecture::find_worst_node(
       if (lexicographical_comparison(
               temp_distances_full, worst_distances_full)) {
         worst_node = temp_node;
-        worst_distances = temp_distances;
+        worst_distances = &temp_distances;
       }
     }
   }
   return worst_node;
 }
 
+// Update distance vectors, indexed by vertex, for the removal of a node that
+// is about to happen. A vector is kept, minus the entry of the removed node,
+// if no distance from its root changes: that is, if every neighbour one step
+// further from the root than the removed node has another neighbour at the
+// same distance as it. Otherwise it is dropped, to be recomputed when needed.
+static void update_distances_for_removal(
+    const Architecture& arc, const Node& removed,
+    std::map<Node, std::vector<std::size_t>>& distances) {
+  const std::shared_ptr<const graphs::ConnectivityView<Node>> view =
+      arc.get_connectivity_view();
+  const unsigned x = view->index(removed);
+  for (auto it = distances.begin(); it != distances.end();) {
+    std::vector<std::size_t>& dists = it->second;
+    bool unchanged = it->first != removed;
+    const std::size_t dx = dists[x];
+    if (unchanged && dx != 0) {
+      for (unsigned y : view->neighbours(x)) {
+        if (dists[y] != dx + 1) continue;
+        bool other_parent = false;
+        for (unsigned z : view->neighbours(y)) {
+          if (z != x && dists[z] == dx) {
+            other_parent = true;
+            break;
+          }
+        }
+        if (!other_parent) {
+          unchanged = false;
+          break;
+        }
+      }
+    }
+    if (unchanged) {
+      dists.erase(dists.begin() + x);
+      ++it;
+    } else {
+      it = distances.erase(it);
+    }
+  }
+}
+
 node_set_t Architecture::remove_worst_nodes(unsigned num) {
   node_set_t out;
   Architecture original_arch(*this);
+  // Both the articulation points and the distances from candidate nodes are
+  // kept up to date across removals rather than recomputed for each.
+  graphs::ArticulationPointTracker<Node> aps(get_undirected_connectivity());
+  std::map<Node, std::vector<std::size_t>> distances;
   for (unsigned k = 0; k < num; k++) {
-    std::optional<Node> v = find_worst_node(original_arch);
-    if (v.has_value()) {
-      remove_node(v.value());
-      out.insert(v.value());
-    }
+    std::optional<Node> v =
+        find_worst_node(original_arch, aps.get_aps(), distances);
+    if (!v.has_value()) break;
+    update_distances_for_removal(*this, v.value(), distances);
+    remove_node(v.value());
+    aps.remove_vertex(v.value());
+    out.insert(v.value());
   }
   return out;
 }
@@ -168,6 +242,7 @@ int tri_lexicographical_comparison(
 
 MatrixXb Architecture::get_connectivity() const {
   unsigned n = n_nodes();
+  compile_connectivity();
   MatrixXb connectivity = MatrixXb(n, n);
   for (unsigned i = 0; i != n; ++i) {
     for (unsigned j = 0; j != n; ++j) {
@@ -178,6 +253,28 @@ MatrixXb Architecture::get_connectivity() const {
   return connectivity;
 }
 
+void Architecture::precompute_routing_data() {
+  if (routing_data()) return;
+  precompute_distances();
+  std::shared_ptr<RoutingData> data = std::make_shared<RoutingData>();
+  data->view = get_connectivity_view();
+  data->articulation_points = get_articulation_points();
+  if (n_nodes() > 0) {
+    const UndirectedConnGraph& undir_g = get_undirected_connectivity();
+    for (Vertex v : graphs::longest_simple_path(undir_g, n_nodes())) {
+      data->long_path.push_back(undir_g[v]);
+    }
+  }
+  routing_data_ = std::move(data);
+}
+
+const Architecture::RoutingData* Architecture::routing_data() const {
+  if (!routing_data_ || routing_data_->view != get_connectivity_view()) {
+    return nullptr;
+  }
+  return routing_data_.get();
+}
+
 void to_json(nlohmann::json& j, const Architecture::Connection& link) {
   j.push_back(link.first);
   j.push_back(link.second);
@@ -278,4 +375,81 @@ std::vector<Architecture::Connection> SquareGrid::get_edges(
   return edges;
 }
 
+HeavyHexLattice::HeavyHexLattice(unsigned n_rows, unsigned n_columns)
+    : Architecture(get_edges(n_rows, n_columns)),
+      n_rows_(n_rows),
+      n_columns_(n_columns) {
+  precompute_routing_data();
+}
+
+std::vector<Architecture::Connection> HeavyHexLattice::get_edges(
+    unsigned n_rows, unsigned n_columns) {
+  std::vector<Connection> edges;
+  for (unsigned r = 0; r < n_rows; r++) {
+    for (unsigned c = 0; c + 1 < n_columns; c++) {
+      edges.push_back(
+          {Node("heavyHexNode", 2 * r, c), Node("heavyHexNode", 2 * r, c + 1)});
+    }
+    if (r + 1 == n_rows) continue;
+    for (unsigned c = (r % 2 == 0) ? 0 : 2; c < n_columns; c += 4) {
+      Node bridge("heavyHexNode", 2 * r + 1, c);
+      edges.push_back({Node("heavyHexNode", 2 * r, c), bridge});
+      edges.push_back({bridge, Node("heavyHexNode", 2 * r + 2, c)});
+    }
+  }
+  return edges;
+}
+
+HeavySquareLattice::HeavySquareLattice(unsigned n_rows, unsigned n_columns)
+    : Architecture(get_edges(n_rows, n_columns)),
+      n_rows_(n_rows),
+      n_columns_(n_columns) {
+  precompute_routing_data();
+}
+
+std::vector<Architecture::Connection> HeavySquareLattice::get_edges(
+    unsigned n_rows, unsigned n_columns) {
+  std::vector<Connection> edges;
+  for (unsigned r = 0; r < n_rows; r++) {
+    for (unsigned c = 0; c < n_columns; c++) {
+      Node n("heavySquareNode", 2 * r, 2 * c);
+      if (c + 1 < n_columns) {
+        Node mid("heavySquareNode", 2 * r, 2 * c + 1);
+        edges.push_back({n, mid});
+        edges.push_back({mid, Node("heavySquareNode", 2 * r, 2 * c + 2)});
+      }
+      if (r + 1 < n_rows) {
+        Node mid("heavySquareNode", 2 * r + 1, 2 * c);
+        edges.push_back({n, mid});
+        edges.push_back({mid, Node("heavySquareNode", 2 * r + 2, 2 * c)});
+      }
+    }
+  }
+  return edges;
+}
+
+SycamoreLattice::SycamoreLattice(unsigned n_rows, unsigned n_columns)
+    : Architecture(get_edges(n_rows, n_columns)),
+      n_rows_(n_rows),
+      n_columns_(n_columns) {
+  precompute_routing_data();
+}
+
+std::vector<Architecture::Connection> SycamoreLattice::get_edges(
+    unsigned n_rows, unsigned n_columns) {
+  std::vector<Connection> edges;
+  for (unsigned r = 0; r + 1 < n_rows; r++) {
+    for (unsigned c = 0; c < n_columns; c++) {
+      Node n("sycamoreNode", r, c);
+      edges.push_back({n, Node("sycamoreNode", r + 1, c)});
+      if (r % 2 == 0 && c > 0) {
+        edges.push_back({n, Node("sycamoreNode", r + 1, c - 1)});
+      } else if (r % 2 == 1 && c + 1 < n_columns) {
+        edges.push_back({n, Node("sycamoreNode", r + 1, c + 1)});
+      }
+    }
+  }
+  return edges;
+}
+
 }  // namespace tket
@@ -15,7 +15,10 @@
 #pragma once
 
 #include <iostream>
+#include <map>
+#include <memory>
 #include <numeric>
+#include <optional>
 #include <set>
 #include <string>
 #include <utility>
@@ -103,8 +106,13 @@ class Architecture : public ArchitectureBase<graphs::DirectedGraph<Node>> {
 
   /**
    * Sub-architecture generated by a subset of nodes.
+   *
+   * Built from the adjacency of this architecture in linear time. If its
+   * distances have been precomputed, those of the sub-architecture are
+   * derived from them, searching again only from the nodes whose shortest
+   * paths leave the subset.
    */
-  Architecture create_subarch(const std::vector<Node> &nodes);
+  Architecture create_subarch(const std::vector<Node> &nodes) const;
 
   /**
    * Vectors of nodes corresponding to lines of given lengths
@@ -122,9 +130,42 @@ class Architecture : public ArchitectureBase<graphs::DirectedGraph<Node>> {
    */
   MatrixXb get_connectivity() const;
 
+  /**
+   * Precompute the data used to set up routing on the architecture.
+   *
+   * This builds the all-pairs distance matrix and the connectivity view, and
+   * stores the articulation points and a long simple path through the
+   * architecture. Until the architecture is next modified,
+   * \ref get_articulation_points returns the stored points and
+   * \ref get_lines cuts the lines from the stored path when they fit on it,
+   * instead of searching the graph again.
+   */
+  void precompute_routing_data();
+
  protected:
   // Returns node with least connectivity given some distance matrix.
   std::optional<Node> find_worst_node(const Architecture &orig_g);
+
+  // As above, given the articulation points and a cache of distance vectors,
+  // which is filled in as needed.
+  std::optional<Node> find_worst_node(
+      const Architecture &orig_g, const node_set_t &ap,
+      std::map<Node, std::vector<std::size_t>> &distances);
+
+ private:
+  struct RoutingData {
+    // Connectivity view the data was computed with; the graph has been
+    // modified since iff the current view is a different one
+    std::shared_ptr<const graphs::ConnectivityView<Node>> view;
+    node_set_t articulation_points;
+    node_vector_t long_path;
+  };
+
+  // The precomputed routing data, if there is any and it is still valid
+  const RoutingData *routing_data() const;
+
+  // Immutable once built, so copies share it
+  std::shared_ptr<const RoutingData> routing_data_;
 };
 
 JSON_DECL(Architecture::Connection)
@@ -199,6 +240,82 @@ class SquareGrid : public Architecture {
   unsigned layers;
 };
 
+/**
+ * Heavy-hex lattice, as on IBM devices.
+ *
+ * Qubits lie on `n_rows` rows of `n_columns` qubits, each row coupled as a
+ * line. Neighbouring rows are joined through bridge qubits, one every four
+ * columns, at columns 0, 4, 8, ... below even rows and 2, 6, 10, ... below
+ * odd rows. Row qubits are "heavyHexNode"[2r, c]; the bridge below row r at
+ * column c is "heavyHexNode"[2r + 1, c].
+ *
+ * The routing data is precomputed on construction.
+ */
+class HeavyHexLattice : public Architecture {
+ public:
+  HeavyHexLattice(unsigned n_rows, unsigned n_columns);
+
+  unsigned get_rows() const { return n_rows_; }
+  unsigned get_columns() const { return n_columns_; }
+
+ private:
+  static std::vector<Connection> get_edges(
+      unsigned n_rows, unsigned n_columns);
+
+  unsigned n_rows_;
+  unsigned n_columns_;
+};
+
+/**
+ * Heavy-square lattice: a square grid of `n_rows` by `n_columns` qubits with
+ * an extra qubit on each coupling.
+ *
+ * On doubled coordinates, grid qubits are "heavySquareNode"[2r, 2c], and the
+ * qubit between two grid qubits is at the average of their coordinates.
+ *
+ * The routing data is precomputed on construction.
+ */
+class HeavySquareLattice : public Architecture {
+ public:
+  HeavySquareLattice(unsigned n_rows, unsigned n_columns);
+
+  unsigned get_rows() const { return n_rows_; }
+  unsigned get_columns() const { return n_columns_; }
+
+ private:
+  static std::vector<Connection> get_edges(
+      unsigned n_rows, unsigned n_columns);
+
+  unsigned n_rows_;
+  unsigned n_columns_;
+};
+
+/**
+ * Sycamore-style lattice, as on Google devices: a square grid rotated by 45
+ * degrees.
+ *
+ * Qubits "sycamoreNode"[r, c] lie on `n_rows` rows of `n_columns`. Each
+ * qubit is coupled to the qubit in the same column of the next row, and to
+ * the one in the previous column (from even rows) or the next column (from
+ * odd rows), so that interior qubits have four couplings.
+ *
+ * The routing data is precomputed on construction.
+ */
+class SycamoreLattice : public Architecture {
+ public:
+  SycamoreLattice(unsigned n_rows, unsigned n_columns);
+
+  unsigned get_rows() const { return n_rows_; }
+  unsigned get_columns() const { return n_columns_; }
+
+ private:
+  static std::vector<Connection> get_edges(
+      unsigned n_rows, unsigned n_columns);
+
+  unsigned n_rows_;
+  unsigned n_columns_;
+};
+
 int tri_lexicographical_comparison(
     const dist_vec &dist1, const dist_vec &dist2);
 
@@ -14,7 +14,8 @@
 
 #include "Cycles.hpp"
 
-#include <numeric>
+#include <algorithm>
+#include <iterator>
 
 namespace tket {
 
@@ -33,29 +34,6 @@ std::vector<std::pair<Vertex, Vertex>> Cycle::get_frame() const {
   return frame_vertices;
 }
 
-UnitID CycleFinder::unitid_from_unit_frontier(
-    const std::shared_ptr<unit_frontier_t>& u_frontier, const Edge& e) const {
-  for (const std::pair<UnitID, Edge>& pair : u_frontier->get<TagKey>()) {
-    if (pair.second == e) {
-      return pair.first;
-    }
-  }
-  throw CycleError(std::string("Edge not in unit_frontier_t object."));
-}
-
-void CycleFinder::update_cycle_out_edges(const UnitID& uid, const Edge& e) {
-  for (std::pair<const Edge, UnitID>& pair : cycle_out_edges) {
-    if (pair.second == uid) {
-      cycle_out_edges.erase(pair.first);
-      cycle_out_edges[e] = uid;
-      return;
-    }
-  }
-  throw CycleError(std::string(
-      "UnitID " + uid.repr() + " not in std::map<Edge, UnitID> object."));
-  return;
-}
-
 void Cycle::update_boundary(
     const Edge& source_edge, const Edge& replacement_edge) {
   for (unsigned i = 0; i < boundary_edges_.size(); i++) {
@@ -79,50 +57,67 @@ void CycleFinder::erase_keys(
   for (const unsigned& key : all_erased) erase_from.erase(key);
 }
 
-// Adds a new cycle to bt.key_to_cycle
+unsigned CycleFinder::add_cycle(const std::vector<unsigned>& qubits) {
+  cycles_.push_back(PartialCycle());
+  cycles_.back().history.insert(qubits.begin(), qubits.end());
+  return cycles_.size() - 1;
+}
+
+unsigned CycleFinder::add_slot(const edge_pair_t& edges) {
+  slot_edges_.push_back(edges);
+  slot_parent_.push_back(slot_parent_.size());
+  return slot_parent_.size() - 1;
+}
+
+unsigned CycleFinder::find_slot(unsigned slot) {
+  while (slot_parent_[slot] != slot) {
+    slot_parent_[slot] = slot_parent_[slot_parent_[slot]];
+    slot = slot_parent_[slot];
+  }
+  return slot;
+}
+
+// Adds a new cycle to cycles_
 std::pair<unsigned, std::set<unsigned>> CycleFinder::make_cycle(
-    const Vertex& v, const EdgeVec& out_edges, const CutFrontier& cut) {
-  // Make a new boundary, add it to "all_boundaries", update "boundary_key" map
-  std::vector<edge_pair_t> new_cycle_boundary;
-  std::vector<UnitID> new_boundary_uids;
+    const Vertex& v, const EdgeVec& out_edges) {
+  // Make a new boundary, keep note of all old boundary keys for merging, add
+  // new edges to new boundary and update cycle out edges
+  const std::vector<unsigned>& qubits = port_qubits_.at(v);
+  std::vector<unsigned> new_boundary_qubits;
+  std::vector<unsigned> new_slots;
   std::set<unsigned> old_boundary_keys;
   std::set<unsigned> banned_keys;
-
-  // Get UnitID, add to uids for new boundary, keep note of all old boundary
-  // keys for merging set new boundary key, add new edges to new boundary update
-  // cycle out edges if the edge can't be found
+  const unsigned new_key = cycles_.size();
   for (const Edge& e : out_edges) {
-    UnitID uid = unitid_from_unit_frontier(cut.u_frontier, e);
-    new_boundary_uids.push_back(uid);
-    old_boundary_keys.insert(bt.uid_to_key[uid]);
+    unsigned q = qubits.at(circ.get_source_port(e));
+    new_boundary_qubits.push_back(q);
+    old_boundary_keys.insert(qubit_key_[q]);
 
     // boundary key associated with given edge e not included
     // i.e. e's associated in edge isn't a cycle out edge
     // i.e. some other non-cycle gate has been passed
-    if (cycle_out_edges.find(circ.get_last_edge(v, e)) ==
-        cycle_out_edges.end()) {
-      banned_keys.insert(bt.uid_to_key[uid]);
+    Edge in_edge = circ.get_last_edge(v, e);
+    if (cycle_out_edges_[q] != in_edge) {
+      banned_keys.insert(qubit_key_[q]);
     }
-    bt.uid_to_key[uid] = bt.key;
-    new_cycle_boundary.push_back({circ.get_last_edge(v, e), e});
-    update_cycle_out_edges(uid, e);
+    qubit_key_[q] = new_key;
+    new_slots.push_back(add_slot({in_edge, e}));
+    cycle_out_edges_[q] = e;
   }
 
-  std::vector<unsigned> op_indices(out_edges.size());
-  std::iota(op_indices.begin(), op_indices.end(), 0);
+  add_cycle(new_boundary_qubits);
+  PartialCycle& new_cycle = cycles_.back();
+  for (unsigned slot : new_slots) {
+    new_cycle.slots.push_back(slot);
+    new_cycle.out_slots.insert({slot_edges_[slot].second, slot});
+  }
   // Edges in port ordering
-  Cycle new_cycle(
-      new_cycle_boundary, {{circ.get_OpType_from_Vertex(v), op_indices, v}});
-  bt.key_to_cycle[bt.key] = {new_cycle};
+  new_cycle.coms.push_back({circ.get_OpType_from_Vertex(v), new_slots, v});
 
-  bt.history.push_back(new_boundary_uids);
   for (const unsigned& key : banned_keys) {
     erase_keys(key, old_boundary_keys);
   }
-  std::pair<unsigned, std::set<unsigned>> return_keys = {
-      bt.key, old_boundary_keys};
-  bt.key++;
-  return return_keys;
+  return {new_key, old_boundary_keys};
 }
 
 // "old_keys" returned gives keys for boundaries to be merged together
@@ -135,20 +130,24 @@ void CycleFinder::order_keys(
   std::set<unsigned> bad_keys;
   for (std::set<unsigned>::iterator it = old_keys.begin(); it != old_keys.end();
        ++it) {
-    std::set<unsigned>::iterator jt = it;
-    std::advance(jt, 1);
-    // if either std::vector<UnitID> has common UnitIDs then one is causally
-    // blocked. remove smaller key from keys from set as not a candidate for
-    // merging into
-    for (; jt != old_keys.end(); ++jt)
-      for (const UnitID& u0 : bt.history[*it])
-        for (const UnitID& u1 : bt.history[*jt])
-          if (u0 == u1) {
-            bad_keys.insert(*it);
-            goto new_loop;
-          }
-
-  new_loop : {}
+    // if either history has common qubits then one is causally blocked.
+    // remove smaller key from keys from set as not a candidate for merging
+    // into
+    for (std::set<unsigned>::iterator jt = std::next(it); jt != old_keys.end();
+         ++jt) {
+      const std::unordered_set<unsigned>& h0 = cycles_[*it].history;
+      const std::unordered_set<unsigned>& h1 = cycles_[*jt].history;
+      const std::unordered_set<unsigned>& smaller =
+          h0.size() <= h1.size() ? h0 : h1;
+      const std::unordered_set<unsigned>& larger =
+          h0.size() <= h1.size() ? h1 : h0;
+      if (std::any_of(smaller.begin(), smaller.end(), [&](unsigned q) {
+            return larger.count(q) != 0;
+          })) {
+        bad_keys.insert(*it);
+        break;
+      }
+    }
   }
 
   for (const unsigned& key : bad_keys) old_keys.erase(key);
@@ -199,6 +198,38 @@ void Cycle::merge(Cycle& new_cycle) {
   coms_.insert(coms_.end(), new_cycle.coms_.begin(), new_cycle.coms_.end());
 }
 
+// Equivalent to Cycle::merge, using the out edge map of the base cycle in
+// place of a search of its boundary
+void CycleFinder::merge_into(unsigned base_key, unsigned merge_key) {
+  PartialCycle& base = cycles_[base_key];
+  PartialCycle& merged = cycles_[merge_key];
+  for (unsigned slot : merged.slots) {
+    // if in edge of boundary of merged matches out edge of base, update base
+    // out edge; CycleCom of merged on this slot then refer to the base slot
+    std::map<Edge, unsigned>::iterator match =
+        base.out_slots.find(slot_edges_[slot].first);
+    if (match != base.out_slots.end()) {
+      unsigned base_slot = match->second;
+      base.out_slots.erase(match);
+      slot_edges_[base_slot].second = slot_edges_[slot].second;
+      base.out_slots.insert({slot_edges_[base_slot].second, base_slot});
+      slot_parent_[slot] = base_slot;
+    } else {
+      base.slots.push_back(slot);
+      base.out_slots.insert({slot_edges_[slot].second, slot});
+    }
+  }
+  base.coms.splice(base.coms.end(), merged.coms);
+  // Qubits in the history of the merged cycle move to the base cycle
+  for (unsigned q : merged.history) qubit_key_[q] = base_key;
+  if (merged.history.size() > base.history.size()) {
+    base.history.swap(merged.history);
+  }
+  base.history.insert(merged.history.begin(), merged.history.end());
+  merged = PartialCycle();
+  merged.merged = true;
+}
+
 void CycleFinder::merge_cycles(unsigned new_key, std::set<unsigned>& old_keys) {
   // boundary_keys is a std::set<unsigned> so is ordered
   order_keys(new_key, old_keys);
@@ -206,18 +237,8 @@ void CycleFinder::merge_cycles(unsigned new_key, std::set<unsigned>& old_keys) {
   // boundary with smallest value
   std::set<unsigned>::iterator it = old_keys.begin();
   unsigned base_key = *it;
-  std::advance(it, 1);
-  for (; it != old_keys.end(); ++it) {
-    unsigned merge_key = *it;
-    bt.key_to_cycle[base_key].merge(bt.key_to_cycle[merge_key]);
-    bt.key_to_cycle.erase(merge_key);
-    // update bt.history for "base_key"
-    for (const UnitID& u0 : bt.history[merge_key]) {
-      bt.uid_to_key[u0] = base_key;
-      for (const UnitID& u1 : bt.history[base_key])
-        if (u0 == u1) break;
-      bt.history[base_key].push_back(u0);
-    }
+  for (++it; it != old_keys.end(); ++it) {
+    merge_into(base_key, *it);
   }
 }
 
@@ -227,14 +248,13 @@ void CycleFinder::extend_cycles(const CutFrontier& cut) {
   // If any in edge to new cycle matches an out edge to a previous cycle,
   // attempt to merge cycles together
   for (const Vertex& v : *cut.slice) {
-    EdgeVec in_edges = circ.get_in_edges_of_type(v, EdgeType::Quantum);
     EdgeVec out_edges = circ.get_out_edges_of_type(v, EdgeType::Quantum);
-    // Compare EdgeType::Quantum "in_edges" of vertex in slice to collection of
-    // out edges from "active" boundaries If an "in_edge" is not equivalent to
+    // Compare EdgeType::Quantum in edges of vertex in slice to collection of
+    // out edges from "active" boundaries If an in edge is not equivalent to
     // an out edge from "active" boundary, implies vertex needs to start a new
     // boundary
     std::pair<unsigned, std::set<unsigned>> all_keys =
-        make_cycle(v, out_edges, cut);
+        make_cycle(v, out_edges);
     if (all_keys.second.size() > 0) {
       merge_cycles(all_keys.first, all_keys.second);
     }
@@ -246,8 +266,27 @@ std::vector<Cycle> CycleFinder::get_cycles() {
     return (cycle_types_.find(op->get_type()) == cycle_types_.end());
   };
 
+  // Index qubits, and record the qubit on each quantum in port
+  const qubit_vector_t qubits = circ.all_qubits();
+  std::map<UnitID, unsigned> qubit_index;
+  for (unsigned q = 0; q < qubits.size(); q++) {
+    qubit_index.insert({qubits[q], q});
+    Vertex v = circ.get_in(qubits[q]);
+    Edge e = circ.get_nth_out_edge(v, 0);
+    while (true) {
+      v = circ.target(e);
+      if (is_final_q_type(circ.get_OpType_from_Vertex(v))) break;
+      std::vector<unsigned>& ports = port_qubits_[v];
+      port_t port = circ.get_target_port(e);
+      if (ports.size() <= port) ports.resize(port + 1);
+      ports[port] = q;
+      e = circ.get_next_edge(v, e);
+    }
+  }
+  cycle_out_edges_.assign(qubits.size(), Edge());
+  qubit_key_.assign(qubits.size(), 0);
+
   Circuit::SliceIterator slice_iter(circ, skip_func);
-  bt.key = 0;
 
   // initialization
   if (!(*slice_iter).empty()) {
@@ -264,21 +303,26 @@ std::vector<Cycle> CycleFinder::get_cycles() {
           in_edge = circ.get_last_edge(in_vert, pair.second);
         }
 
-        cycle_out_edges.insert({in_edge, pair.first});
-        bt.uid_to_key.insert({pair.first, bt.key});
-        Cycle new_cycle({{in_edge, in_edge}}, {{}});
-        bt.key_to_cycle[bt.key] = new_cycle;
-        bt.history.push_back({pair.first});
-        bt.key++;
+        unsigned q = qubit_index.at(pair.first);
+        cycle_out_edges_[q] = in_edge;
+        qubit_key_[q] = add_cycle({q});
+        unsigned slot = add_slot({in_edge, in_edge});
+        PartialCycle& new_cycle = cycles_.back();
+        new_cycle.slots.push_back(slot);
+        new_cycle.out_slots.insert({in_edge, slot});
+        new_cycle.coms.push_back(CycleCom{});
       }
     }
     // extend cycles automatically merges cycles that can be merge due to
     // overlapping multi-qubit gates
     extend_cycles(slice_iter.cut_);
-    cycle_out_edges = {};
     for (const std::pair<UnitID, Edge>& pair :
          slice_iter.cut_.u_frontier->get<TagKey>()) {
-      cycle_out_edges.insert({pair.second, pair.first});
+      std::map<UnitID, unsigned>::const_iterator found =
+          qubit_index.find(pair.first);
+      if (found != qubit_index.end()) {
+        cycle_out_edges_[found->second] = pair.second;
+      }
     }
   }
   while (!slice_iter.finished()) {
@@ -289,22 +333,36 @@ std::vector<Cycle> CycleFinder::get_cycles() {
     }
   }
 
-  // Skim Cycle type from CycleHistory.key_to_cycle
+  // Build Cycle objects from the cycles that were not merged, resolving
+  // slots to positions in their boundary
   // Discard any Cycles with only Input Gates
   std::vector<Cycle> output_cycles;
-  for (std::pair<unsigned, Cycle> entry : bt.key_to_cycle) {
-    if (entry.second.coms_.size() == 0) {
+  std::vector<unsigned> slot_position(slot_edges_.size());
+  for (PartialCycle& partial : cycles_) {
+    if (partial.merged) continue;
+    if (partial.coms.size() == 0) {
       throw CycleError(std::string("Cycle with no internal gates."));
     }
-    if (entry.second.boundary_edges_[0].first ==
-        entry.second.boundary_edges_[0].second) {
+    const edge_pair_t& first = slot_edges_[partial.slots[0]];
+    if (first.first == first.second) {
       continue;
     }
-    if (entry.second.size() > circ.n_qubits()) {
+    if (partial.slots.size() > circ.n_qubits()) {
       throw CycleError(
           std::string("Cycle has a larger frame than Circuit has qubits."));
     }
-    output_cycles.push_back(entry.second);
+    Cycle cycle;
+    for (unsigned i = 0; i < partial.slots.size(); i++) {
+      slot_position[partial.slots[i]] = i;
+      cycle.boundary_edges_.push_back(slot_edges_[partial.slots[i]]);
+    }
+    for (CycleCom& com : partial.coms) {
+      for (unsigned& index : com.indices) {
+        index = slot_position[find_slot(index)];
+      }
+      cycle.coms_.push_back(std::move(com));
+    }
+    output_cycles.push_back(std::move(cycle));
   }
   return output_cycles;
 }
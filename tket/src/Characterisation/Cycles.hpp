@@ -14,6 +14,10 @@
 
 #pragma once
 
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "Circuit/Circuit.hpp"
 
 namespace tket {
@@ -73,20 +77,6 @@ class Cycle {
   std::vector<std::pair<Vertex, Vertex>> frame_vertices;
 };
 
-// CycleHistory stores information used to find minimal number of boundaries
-struct CycleHistory {
-  // Every time a new cycle is made it's assigned a key of type unsigned
-  // The size of key is used to track the causal ordering of cycles
-  unsigned key;
-  // history.size() == key always
-  // Tracks which UnitID were in which Cycle
-  std::vector<std::vector<UnitID>> history;
-  // Map from UnitID to key, where key maps in key_to_cycle to "active" Cycle
-  std::map<UnitID, unsigned> uid_to_key;
-  // Map from key to cycle, where a key n refers to the nth cycle made
-  std::map<unsigned, Cycle> key_to_cycle;
-};
-
 class CycleFinder {
  public:
   CycleFinder(const Circuit& _circ, const OpTypeSet& _cycle_types)
@@ -98,40 +88,66 @@ class CycleFinder {
   std::vector<Cycle> get_cycles();
 
  private:
+  // Cycle under construction
+  // Boundary edges are held in "slots", shared between cycles so that
+  // merging a cycle only touches its own boundary: when a boundary edge of a
+  // merged cycle continues a boundary edge of the cycle it merges into, its
+  // slot is joined to the existing one (union-find). CycleCom indices hold
+  // slot ids until the cycles are output.
+  struct PartialCycle {
+    // Root slots of the boundary, in order
+    std::vector<unsigned> slots;
+    // Map from out edge of the boundary to its slot
+    std::map<Edge, unsigned> out_slots;
+    std::list<CycleCom> coms;
+    // Every qubit index that has been in the cycle
+    std::unordered_set<unsigned> history;
+    bool merged = false;
+  };
+
   // Circuit cycles are found in
   const Circuit& circ;
   // OpType cycle gates have
   const OpTypeSet cycle_types_;
 
-  // CycleFinder uses SliceIterator to find get circ gates in cycle_types_
-  // In Edges to a new slice are checked for equality with the last boundary out
-  // edge stored for their UnitID If equal a cycle may be extended, if not equal
-  std::map<Edge, UnitID> cycle_out_edges;
-
-  // Stores data structures for tracking created Cycles and associated UnitID's
-  CycleHistory bt;
+  // Qubit indices of the quantum in ports of each vertex
+  std::unordered_map<Vertex, std::vector<unsigned>> port_qubits_;
+  // For each qubit, last boundary out edge of a cycle on it
+  // In Edges to a new slice are checked for equality with it; if equal a
+  // cycle may be extended
+  std::vector<Edge> cycle_out_edges_;
+  // For each qubit, the key of its "active" cycle
+  std::vector<unsigned> qubit_key_;
+  // Cycles by key, where the key n refers to the nth cycle made
+  std::vector<PartialCycle> cycles_;
+  // In and out edge of each slot, and the union-find parent of each slot
+  std::vector<edge_pair_t> slot_edges_;
+  std::vector<unsigned> slot_parent_;
 
   // Given a new CutFrontier object, creates new cycles from interior vertices
   // and merges them with previous cycles where possible
   void extend_cycles(const CutFrontier& cut);
 
-  // Makes a new Cycle object from given dag information
-  // Return type used to identify whether cycle should be merged with previous
-  // cycles
+  // Makes a new Cycle from vertex v of a slice
+  // Returns its key and the keys of the cycles it may be merged with
   std::pair<unsigned, std::set<unsigned>> make_cycle(
-      const Vertex& v, const EdgeVec& out_edges, const CutFrontier& cut);
+      const Vertex& v, const EdgeVec& out_edges);
 
-  // Uses CycleHistory to merge Cycle attributed to new_key with Cycles
-  // attributed to old_keys Cycles are merged in to Cycle with smallest key
-  void merge_cycles(unsigned new_key, std::set<unsigned>& old_keys);
+  // Adds a cycle with the given qubits in its history; returns its key
+  unsigned add_cycle(const std::vector<unsigned>& qubits);
+
+  // Adds a slot for a boundary edge pair; returns its id
+  unsigned add_slot(const edge_pair_t& edges);
 
-  // Updates cycle_out_edges with new Edge
-  // UnitID should not be new, so error thrown if not found
-  void update_cycle_out_edges(const UnitID& uid, const Edge& e);
+  // Root of the slot
+  unsigned find_slot(unsigned slot);
+
+  // Merges Cycle attributed to new_key with Cycles attributed to old_keys
+  // Cycles are merged in to Cycle with smallest key
+  void merge_cycles(unsigned new_key, std::set<unsigned>& old_keys);
 
-  // Getter for UnitID from unit_frontier_t in Cut
-  UnitID unitid_from_unit_frontier(
-      const std::shared_ptr<unit_frontier_t>& u_frontier, const Edge& e) const;
+  // Merges the cycle with key merge_key into the cycle with key base_key
+  void merge_into(unsigned base_key, unsigned merge_key);
 
   // if unsigned in erase_from is <= to_erase, removes from erase_from
   void erase_keys(
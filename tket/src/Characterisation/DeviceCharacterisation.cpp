@@ -15,6 +15,7 @@
 #include "Characterisation/DeviceCharacterisation.hpp"
 
 #include <optional>
+#include <set>
 
 namespace tket {
 
@@ -67,6 +68,30 @@ readout_error_t DeviceCharacterisation::get_readout_error(const Node& n) const {
   return maybe_err ? *maybe_err : 0.;
 }
 
+gate_error_t DeviceCharacterisation::get_average_error(
+    const OpType& op, unsigned n_qubits) const {
+  gate_error_t total = 0.;
+  unsigned count = 0;
+  if (n_qubits <= 1) {
+    std::set<Node> nodes;
+    for (const auto& [node, err] : default_node_errors_) nodes.insert(node);
+    for (const auto& [node, errs] : op_node_errors_) nodes.insert(node);
+    for (const Node& node : nodes) {
+      total += get_error(node, op);
+      count++;
+    }
+  } else {
+    std::set<Architecture::Connection> links;
+    for (const auto& [link, err] : default_link_errors_) links.insert(link);
+    for (const auto& [link, errs] : op_link_errors_) links.insert(link);
+    for (const Architecture::Connection& link : links) {
+      total += get_error(link, op);
+      count++;
+    }
+  }
+  return count == 0 ? 0. : total / count;
+}
+
 bool DeviceCharacterisation::operator==(
     const DeviceCharacterisation& other) const {
   return (this->default_node_errors_ == other.default_node_errors_) &&
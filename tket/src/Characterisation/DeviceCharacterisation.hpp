@@ -81,11 +81,26 @@ class DeviceCharacterisation {
   // readout errors
   readout_error_t get_readout_error(const Node& n) const;
 
+  /**
+   * Error of an OpType averaged over the device.
+   *
+   * For a single-qubit OpType this is the mean of get_error(n, op) over all
+   * nodes with any gate error given; for a multi-qubit one, the mean of
+   * get_error(link, op) over all links with any gate error given. It is 0.
+   * if there are none.
+   *
+   * @param op operation type
+   * @param n_qubits number of qubits the operation acts on
+   */
+  gate_error_t get_average_error(const OpType& op, unsigned n_qubits) const;
+
   bool operator==(const DeviceCharacterisation& other) const;
 
   friend void to_json(nlohmann::json& j, const DeviceCharacterisation& dc);
   friend void from_json(const nlohmann::json& j, DeviceCharacterisation& dc);
 
+  friend class DeviceErrorTables;
+
  private:
   // default errors per Node
   avg_node_errors_t default_node_errors_;
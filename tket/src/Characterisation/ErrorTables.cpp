@@ -0,0 +1,128 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ErrorTables.hpp"
+
+#include <set>
+
+#include "OpType/OpTypeFunctions.hpp"
+#include "Ops/Conditional.hpp"
+
+namespace tket {
+
+static std::uint64_t link_key(unsigned node0, unsigned node1) {
+  return (std::uint64_t(node0) << 32) | node1;
+}
+
+DeviceErrorTables::DeviceErrorTables(const DeviceCharacterisation &dc) {
+  // Number the nodes, links and OpTypes mentioned anywhere.
+  std::set<Node> nodes;
+  std::set<std::pair<Node, Node>> links;
+  std::set<OpType> ops;
+  for (const auto &[node, err] : dc.default_node_errors_) nodes.insert(node);
+  for (const auto &[node, err] : dc.default_readout_errors_) {
+    nodes.insert(node);
+  }
+  for (const auto &[node, errs] : dc.op_node_errors_) {
+    nodes.insert(node);
+    for (const auto &[op, err] : errs) ops.insert(op);
+  }
+  for (const auto &[link, err] : dc.default_link_errors_) links.insert(link);
+  for (const auto &[link, errs] : dc.op_link_errors_) {
+    links.insert(link);
+    for (const auto &[op, err] : errs) ops.insert(op);
+  }
+  for (const std::pair<Node, Node> &link : links) {
+    nodes.insert(link.first);
+    nodes.insert(link.second);
+  }
+  nodes_.assign(nodes.begin(), nodes.end());
+  for (unsigned i = 0; i < nodes_.size(); i++) node_indices_[nodes_[i]] = i;
+  for (const std::pair<Node, Node> &link : links) {
+    const unsigned n0 = node_indices_.at(link.first);
+    const unsigned n1 = node_indices_.at(link.second);
+    link_indices_[link_key(n0, n1)] = links_.size();
+    links_.push_back({n0, n1});
+  }
+  n_columns_ = ops.size() + 1;
+  unsigned col = 1;
+  for (OpType op : ops) {
+    const unsigned t = static_cast<unsigned>(op);
+    if (t >= op_columns_.size()) op_columns_.resize(t + 1, 0);
+    op_columns_[t] = col++;
+  }
+
+  // Fill the tables through the characterisation, so that the fallbacks are
+  // exactly its own.
+  node_errors_.resize(nodes_.size() * n_columns_);
+  readout_errors_.resize(nodes_.size());
+  for (unsigned i = 0; i < nodes_.size(); i++) {
+    node_errors_[i * n_columns_] = dc.get_error(nodes_[i]);
+    for (OpType op : ops) {
+      node_errors_[i * n_columns_ + column(op)] = dc.get_error(nodes_[i], op);
+    }
+    readout_errors_[i] = dc.get_readout_error(nodes_[i]);
+  }
+  link_errors_.resize(links_.size() * n_columns_);
+  for (unsigned i = 0; i < links_.size(); i++) {
+    const Architecture::Connection link{
+        nodes_[links_[i].first], nodes_[links_[i].second]};
+    link_errors_[i * n_columns_] = dc.get_error(link);
+    for (OpType op : ops) {
+      link_errors_[i * n_columns_ + column(op)] = dc.get_error(link, op);
+    }
+  }
+}
+
+unsigned DeviceErrorTables::node_index(const Node &node) const {
+  auto it = node_indices_.find(node);
+  return it == node_indices_.end() ? none : it->second;
+}
+
+unsigned DeviceErrorTables::link_index(unsigned node0, unsigned node1) const {
+  auto it = link_indices_.find(link_key(node0, node1));
+  return it == link_indices_.end() ? none : it->second;
+}
+
+double DeviceErrorTables::estimate_fidelity(const Circuit &circ) const {
+  std::map<Qubit, unsigned> node_of;
+  for (const Qubit &qb : circ.all_qubits()) {
+    node_of.insert({qb, node_index(Node(qb))});
+  }
+  double fidelity = 1.;
+  for (const Command &com : circ) {
+    Op_ptr op = com.get_op_ptr();
+    while (op->get_type() == OpType::Conditional) {
+      op = static_cast<const Conditional &>(*op).get_op();
+    }
+    const OpType type = op->get_type();
+    if (is_metaop_type(type)) continue;
+    const qubit_vector_t qubits = com.get_qubits();
+    if (qubits.size() == 1) {
+      const unsigned n = node_of.at(qubits[0]);
+      if (n == none) continue;
+      fidelity *= 1. - (type == OpType::Measure ? readout_error(n)
+                                                : node_error(n, type));
+    } else if (qubits.size() == 2) {
+      const unsigned n0 = node_of.at(qubits[0]);
+      const unsigned n1 = node_of.at(qubits[1]);
+      if (n0 == none || n1 == none) continue;
+      const unsigned l = link_index(n0, n1);
+      if (l != none) fidelity *= 1. - link_error(l, type);
+    }
+  }
+  return fidelity;
+}
+
+}  // namespace tket
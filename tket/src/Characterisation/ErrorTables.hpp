@@ -0,0 +1,113 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "Characterisation/DeviceCharacterisation.hpp"
+#include "Circuit/Circuit.hpp"
+
+namespace tket {
+
+/**
+ * The errors of a \ref DeviceCharacterisation, compiled into flat arrays.
+ *
+ * Every node and link mentioned by the characterisation is given a dense
+ * index, and every OpType with a specific error somewhere a column. Errors
+ * are then read by index and OpType with a single array load, falling back
+ * exactly as \ref DeviceCharacterisation::get_error does. Nodes and links are
+ * numbered in increasing order.
+ *
+ * The tables are a snapshot: they do not follow later changes to the
+ * characterisation.
+ */
+class DeviceErrorTables {
+ public:
+  /** Index of an unknown node or link */
+  static constexpr unsigned none = std::numeric_limits<unsigned>::max();
+
+  explicit DeviceErrorTables(const DeviceCharacterisation &characterisation);
+
+  unsigned n_nodes() const { return nodes_.size(); }
+  unsigned n_links() const { return links_.size(); }
+
+  /** Index of a node, or \ref none if it has no errors given */
+  unsigned node_index(const Node &node) const;
+
+  /** Index of a directed link, or \ref none if it has no errors given */
+  unsigned link_index(unsigned node0, unsigned node1) const;
+
+  const Node &node(unsigned index) const { return nodes_[index]; }
+  const std::pair<unsigned, unsigned> &link(unsigned index) const {
+    return links_[index];
+  }
+
+  /** Average error of a node, as \ref DeviceCharacterisation::get_error */
+  gate_error_t node_error(unsigned node) const {
+    return node_errors_[node * n_columns_];
+  }
+  /** Error of an OpType on a node */
+  gate_error_t node_error(unsigned node, OpType op) const {
+    return node_errors_[node * n_columns_ + column(op)];
+  }
+  /** Average error of a link */
+  gate_error_t link_error(unsigned link) const {
+    return link_errors_[link * n_columns_];
+  }
+  /** Error of an OpType on a link */
+  gate_error_t link_error(unsigned link, OpType op) const {
+    return link_errors_[link * n_columns_ + column(op)];
+  }
+  /** Readout error of a node */
+  readout_error_t readout_error(unsigned node) const {
+    return readout_errors_[node];
+  }
+
+  /**
+   * Estimated probability that a circuit on the device runs without error.
+   *
+   * This is the product of 1 - e over the operations of the circuit, in one
+   * pass, where e is the readout error of the measured node for a
+   * measurement, the error of the OpType on its node or link for one- and
+   * two-qubit operations, and 0 otherwise. Conditional operations count as
+   * the operation they condition, and meta operations are ignored. Qubits of
+   * the circuit are read as nodes; those not in the tables have no errors.
+   */
+  double estimate_fidelity(const Circuit &circ) const;
+
+ private:
+  unsigned column(OpType op) const {
+    const unsigned t = static_cast<unsigned>(op);
+    return t < op_columns_.size() ? op_columns_[t] : 0;
+  }
+
+  node_vector_t nodes_;
+  std::map<Node, unsigned> node_indices_;
+  std::vector<std::pair<unsigned, unsigned>> links_;
+  std::unordered_map<std::uint64_t, unsigned> link_indices_;
+  // Column of each OpType, indexed by its value; 0 for the average error
+  std::vector<unsigned> op_columns_;
+  unsigned n_columns_;
+  // Errors of node or link i are entries i * n_columns_ onwards.
+  std::vector<gate_error_t> node_errors_;
+  std::vector<gate_error_t> link_errors_;
+  std::vector<readout_error_t> readout_errors_;
+};
+
+}  // namespace tket
@@ -18,6 +18,7 @@
 
 #include "Ops/MetaOp.hpp"
 #include "PauliGraph/ConjugatePauliFunctions.hpp"
+#include "Utils/Parallel.hpp"
 #include "Utils/PauliStrings.hpp"
 
 namespace tket {
@@ -331,48 +332,6 @@ UniversalFrameRandomisation::get_out_frame(
   return {out_frame, to_dagger};
 }
 
-std::vector<Circuit> FrameRandomisation::label_frames(
-    const std::vector<std::vector<OpTypeVector>>& all_frame_ops,
-    const std::vector<Cycle>& cycles) {
-  std::vector<Circuit> output_circuit_list;
-  // make instances of all circuits using
-  for (const std::vector<OpTypeVector>& cycle_frames : all_frame_ops) {
-    std::vector<Vertex> dagger_vertices;
-    if (cycle_frames.size() != cycles.size()) {
-      throw FrameRandomisationError(
-          std::string("Length of combination of Frame Permutations does not "
-                      "equal number of Cycles."));
-    }
-    for (unsigned i = 0; i < cycle_frames.size(); i++) {
-      if (cycle_frames[i].size() != cycles[i].size()) {
-        throw FrameRandomisationError(
-            std::string("Size of frame does not match the number "
-                        "of qubits in Cycles."));
-      }
-      OpTypeVector in_frame = cycle_frames[i];
-      std::pair<OpTypeVector, std::vector<Vertex>> frame_and_vertices =
-          get_out_frame(in_frame, cycles[i]);
-      dagger_vertices.insert(
-          dagger_vertices.end(), frame_and_vertices.second.begin(),
-          frame_and_vertices.second.end());
-      assign_vertices(
-          in_frame, frame_and_vertices.first, cycles[i].get_frame());
-    }
-
-    for (const Vertex& v : dagger_vertices) {
-      circuit_.set_vertex_Op_ptr(
-          v, circuit_.get_Op_ptr_from_Vertex(v)->dagger());
-    }
-    output_circuit_list.push_back(Circuit(circuit_));
-
-    for (const Vertex& v : dagger_vertices) {
-      circuit_.set_vertex_Op_ptr(
-          v, circuit_.get_Op_ptr_from_Vertex(v)->dagger());
-    }
-  }
-  return output_circuit_list;
-}
-
 std::pair<std::vector<unsigned>, unsigned> get_frame_sizes(
     const std::vector<Cycle>& cycles) {
   unsigned max_frame_size = 0;
@@ -395,15 +354,9 @@ std::vector<Circuit> FrameRandomisation::get_all_circuits(const Circuit& circ) {
   // Return as vector
   // get all cycles in circuit, wire noop vertices for relabelling into
   // boundaries
-  this->circuit_ = circ;
-  std::vector<Cycle> all_cycles = get_cycles(circuit_);
-  if (all_cycles.size() == 0) {
-    throw FrameRandomisationError(
-        std::string("Circuit has no gates with OpType in Cycle OpTypes."));
-  }
-  add_noop_frames(all_cycles, circuit_);
+  std::shared_ptr<const FrameTemplate> frame_template = make_template(circ);
   std::pair<std::vector<unsigned>, unsigned> frame_sizes =
-      get_frame_sizes(all_cycles);
+      get_frame_sizes(frame_template->cycles);
 
   // work out all possible permutations of given ops for all frame sizes
   std::vector<std::vector<OpTypeVector>> all_frame_perms =
@@ -411,65 +364,100 @@ std::vector<Circuit> FrameRandomisation::get_all_circuits(const Circuit& circ) {
   // combine all these permutations
   std::vector<std::vector<OpTypeVector>> all_permutation_combinations =
       get_all_permutation_combinations(frame_sizes.first, all_frame_perms);
-  std::vector<Circuit> output_circuit_list =
-      label_frames(all_permutation_combinations, all_cycles);
-  return output_circuit_list;
+  return materialise(
+      *frame_template,
+      conjugate_frames(*frame_template, all_permutation_combinations));
+}
+
+// Independent random stream for each sample of a seeded sampling, so that
+// samples do not depend on how they are shared between threads
+static std::mt19937 sample_generator(unsigned seed, std::size_t index) {
+  std::seed_seq seq{seed, static_cast<unsigned>(index)};
+  return std::mt19937(seq);
 }
-OpTypeVector FrameRandomisation::sample_frame(const unsigned& size) const {
-  OpTypeVector frame;
-  for (unsigned i = 0; i < size; i++)
-    std::sample(
-        frame_types_.begin(), frame_types_.end(), std::back_inserter(frame), 1,
-        std::mt19937{std::random_device{}()});
+
+OpTypeVector FrameRandomisation::sample_frame(
+    const unsigned& size, std::mt19937& gen) const {
+  if (frame_types_.empty()) {
+    throw FrameRandomisationError(
+        std::string("No frame OpTypes to sample from."));
+  }
+  const OpTypeVector frame_types(frame_types_.begin(), frame_types_.end());
+  std::uniform_int_distribution<std::size_t> choice(
+      0, frame_types.size() - 1);
+  OpTypeVector frame(size);
+  for (OpType& ot : frame) ot = frame_types[choice(gen)];
   return frame;
 }
 
 std::vector<std::vector<OpTypeVector>> FrameRandomisation::get_all_samples(
-    const unsigned& samples, const std::vector<unsigned>& frame_sizes) const {
-  std::vector<std::vector<OpTypeVector>> output_frames;
-  for (unsigned i = 0; i < samples; i++) {
-    std::vector<OpTypeVector> single_sample;
-    for (const unsigned& size : frame_sizes)
-      single_sample.push_back(sample_frame(size));
-    output_frames.push_back(single_sample);
-  }
+    const unsigned& samples, const std::vector<unsigned>& frame_sizes,
+    unsigned seed) const {
+  std::vector<std::vector<OpTypeVector>> output_frames(samples);
+  parallel_for(0, samples, 64, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; i++) {
+      std::mt19937 gen = sample_generator(seed, i);
+      for (const unsigned& size : frame_sizes)
+        output_frames[i].push_back(sample_frame(size, gen));
+    }
+  });
   return output_frames;
 }
 
-void FrameRandomisation::assign_vertices(
-    const OpTypeVector& in_frame, const OpTypeVector& out_frame,
-    const std::vector<std::pair<Vertex, Vertex>>& frame_vertices) {
-  if (in_frame.size() != out_frame.size() ||
-      in_frame.size() != frame_vertices.size()) {
-    throw FrameRandomisationError(
-        std::string("Number of gates in sampled frame doesn't match "
-                    "number of qubits in frame"));
-  }
-  for (unsigned i = 0; i < frame_vertices.size(); i++) {
-    circuit_.set_vertex_Op_ptr(
-        frame_vertices[i].first, get_op_ptr(in_frame[i]));
-    circuit_.set_vertex_Op_ptr(
-        frame_vertices[i].second, get_op_ptr(out_frame[i]));
+// Interleaves in and out frames as in FrameSample::frame_ops
+static void add_frames(
+    FrameRandomisation::FrameSample& sample, const OpTypeVector& in_frame,
+    const OpTypeVector& out_frame) {
+  for (unsigned i = 0; i < in_frame.size(); i++) {
+    sample.frame_ops.push_back(in_frame[i]);
+    sample.frame_ops.push_back(out_frame[i]);
   }
 }
 
+std::vector<FrameRandomisation::FrameSample>
+FrameRandomisation::conjugate_frames(
+    const FrameTemplate& frame_template,
+    const std::vector<std::vector<OpTypeVector>>& all_frame_ops) {
+  const std::vector<Cycle>& cycles = frame_template.cycles;
+  std::vector<FrameSample> output_samples(all_frame_ops.size());
+  parallel_for(
+      0, all_frame_ops.size(), 16, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t s = begin; s < end; s++) {
+          const std::vector<OpTypeVector>& cycle_frames = all_frame_ops[s];
+          if (cycle_frames.size() != cycles.size()) {
+            throw FrameRandomisationError(std::string(
+                "Length of combination of Frame Permutations does not "
+                "equal number of Cycles."));
+          }
+          FrameSample& sample = output_samples[s];
+          for (unsigned i = 0; i < cycle_frames.size(); i++) {
+            if (cycle_frames[i].size() != cycles[i].size()) {
+              throw FrameRandomisationError(
+                  std::string("Size of frame does not match the number "
+                              "of qubits in Cycles."));
+            }
+            std::pair<OpTypeVector, std::vector<Vertex>> frame_and_vertices =
+                get_out_frame(cycle_frames[i], cycles[i]);
+            add_frames(sample, cycle_frames[i], frame_and_vertices.first);
+            sample.to_dagger.insert(
+                sample.to_dagger.end(), frame_and_vertices.second.begin(),
+                frame_and_vertices.second.end());
+          }
+        }
+      });
+  return output_samples;
+}
+
 std::vector<Circuit> FrameRandomisation::sample_randomisation_circuits(
-    const Circuit& circ, unsigned samples) {
+    const Circuit& circ, unsigned samples, std::optional<unsigned> seed) {
   // get all cycles in circuit, wire noop vertices for relabelling into
   // boundaries
-  this->circuit_ = circ;
-  std::vector<Cycle> all_cycles = get_cycles(circuit_);
-  if (all_cycles.size() == 0) {
-    throw FrameRandomisationError(
-        std::string("Circuit has no gates with OpType in Cycle OpTypes."));
-  }
-  add_noop_frames(all_cycles, circuit_);
-  std::vector<unsigned> frame_sizes = get_frame_sizes(all_cycles).first;
-  std::vector<std::vector<OpTypeVector>> all_samples =
-      get_all_samples(samples, frame_sizes);
-  std::vector<Circuit> output_circuit_list =
-      label_frames(all_samples, all_cycles);
-  return output_circuit_list;
+  std::shared_ptr<const FrameTemplate> frame_template = make_template(circ);
+  return materialise(
+      *frame_template,
+      sample_frames(
+          *frame_template, samples,
+          seed ? *seed : std::random_device{}()));
 }
 
 std::vector<Cycle> FrameRandomisation::get_cycles(const Circuit& circ) const {
@@ -477,48 +465,113 @@ std::vector<Cycle> FrameRandomisation::get_cycles(const Circuit& circ) const {
   return cf.get_cycles();
 }
 
-std::vector<Circuit> PowerCycle::sample_cycles(
-    const Circuit& circ, unsigned total_cycles, unsigned samples) {
-  this->circuit_ = circ;
-  std::vector<Circuit> out;
-  std::vector<Cycle> all_cycles = get_cycles(circuit_);
-  if (all_cycles.size() == 0) {
+std::shared_ptr<const FrameRandomisation::FrameTemplate>
+FrameRandomisation::make_template(const Circuit& circ) const {
+  std::shared_ptr<FrameTemplate> frame_template =
+      std::make_shared<FrameTemplate>();
+  // Cycles refer to vertices of the template circuit, so are found there
+  frame_template->circuit = circ;
+  frame_template->cycles = get_cycles(frame_template->circuit);
+  if (frame_template->cycles.size() == 0) {
     throw FrameRandomisationError(
-        std::string("Circuit has no gates with OpType in Clifford gates."));
+        std::string("Circuit has no gates with OpType in Cycle OpTypes."));
+  }
+  add_noop_frames(frame_template->cycles, frame_template->circuit);
+  return frame_template;
+}
+
+std::vector<FrameRandomisation::FrameSample> FrameRandomisation::sample_frames(
+    const FrameTemplate& frame_template, unsigned samples, unsigned seed) {
+  return conjugate_frames(
+      frame_template,
+      get_all_samples(
+          samples, get_frame_sizes(frame_template.cycles).first, seed));
+}
+
+void FrameRandomisation::materialise_into(
+    Circuit& circ, const FrameTemplate& frame_template,
+    const FrameSample& sample) const {
+  vertex_map_t isomap = circ.copy_graph(frame_template.circuit);
+  circ.add_phase(frame_template.circuit.get_phase());
+  std::optional<std::string> name = frame_template.circuit.get_name();
+  if (name) circ.set_name(*name);
+  unsigned k = 0;
+  for (const Cycle& cycle : frame_template.cycles) {
+    for (const std::pair<Vertex, Vertex>& frame : cycle.get_frame()) {
+      if (k + 2 > sample.frame_ops.size()) {
+        throw FrameRandomisationError(
+            std::string("Number of gates in sampled frame doesn't match "
+                        "number of qubits in frame"));
+      }
+      circ.set_vertex_Op_ptr(
+          isomap.at(frame.first), get_op_ptr(sample.frame_ops[k++]));
+      circ.set_vertex_Op_ptr(
+          isomap.at(frame.second), get_op_ptr(sample.frame_ops[k++]));
+    }
   }
-  if (all_cycles.size() > 1) {
+  if (k != sample.frame_ops.size()) {
     throw FrameRandomisationError(
-        std::string("Circuit has non-Clifford gates."));
+        std::string("Number of gates in sampled frame doesn't match "
+                    "number of qubits in frame"));
+  }
+  for (const Vertex& v : sample.to_dagger) {
+    Vertex w = isomap.at(v);
+    circ.set_vertex_Op_ptr(w, circ.get_Op_ptr_from_Vertex(w)->dagger());
   }
+}
 
-  add_noop_frames(all_cycles, circuit_);
-  std::vector<unsigned> frame_sizes = get_frame_sizes(all_cycles).first;
-  std::vector<std::vector<OpTypeVector>> all_samples =
-      get_all_samples(samples, frame_sizes);
-  for (const std::vector<OpTypeVector>& sample : all_samples) {
-    if (sample.size() > 1) {
-      throw FrameRandomisationError(
-          std::string("Frames have been sampled for more than one cycle."));
-    }
-    OpTypeVector in_frame = sample[0];
-    OpTypeVector noop_frame;
-    for (unsigned i = 0; i < in_frame.size(); i++) {
-      noop_frame.push_back(OpType::noop);
-    }
-    std::pair<OpTypeVector, std::vector<Vertex>> frame_and_vertices =
-        get_out_frame(in_frame, all_cycles[0]);
-    assign_vertices(
-        in_frame, frame_and_vertices.first, all_cycles[0].get_frame());
-    Circuit full_circ = circuit_;
-    for (unsigned i = 0; i < total_cycles - 1; i++) {
-      frame_and_vertices =
-          get_out_frame(frame_and_vertices.first, all_cycles[0]);
-      assign_vertices(
-          noop_frame, frame_and_vertices.first, all_cycles[0].get_frame());
-      full_circ.append(circuit_);
+Circuit FrameRandomisation::materialise(
+    const FrameTemplate& frame_template, const FrameSample& sample) const {
+  Circuit circ;
+  materialise_into(circ, frame_template, sample);
+  return circ;
+}
+
+std::vector<Circuit> FrameRandomisation::materialise(
+    const FrameTemplate& frame_template,
+    const std::vector<FrameSample>& samples) const {
+  // Built in place, as copying a circuit copies its whole graph
+  std::vector<Circuit> output_circuit_list(samples.size());
+  parallel_for(0, samples.size(), 4, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; i++) {
+      materialise_into(output_circuit_list[i], frame_template, samples[i]);
     }
-    out.push_back(full_circ);
+  });
+  return output_circuit_list;
+}
+
+std::vector<Circuit> PowerCycle::sample_cycles(
+    const Circuit& circ, unsigned total_cycles, unsigned samples,
+    std::optional<unsigned> seed) {
+  std::shared_ptr<const FrameTemplate> frame_template = make_template(circ);
+  if (frame_template->cycles.size() > 1) {
+    throw FrameRandomisationError(
+        std::string("Circuit has non-Clifford gates."));
   }
+  const Cycle& cycle = frame_template->cycles[0];
+  std::vector<std::vector<OpTypeVector>> all_samples = get_all_samples(
+      samples, get_frame_sizes(frame_template->cycles).first,
+      seed ? *seed : std::random_device{}());
+  std::vector<Circuit> out(samples);
+  parallel_for(0, samples, 4, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t s = begin; s < end; s++) {
+      const OpTypeVector& in_frame = all_samples[s][0];
+      const OpTypeVector noop_frame(in_frame.size(), OpType::noop);
+      std::pair<OpTypeVector, std::vector<Vertex>> frame_and_vertices =
+          get_out_frame(in_frame, cycle);
+      FrameSample first;
+      add_frames(first, in_frame, frame_and_vertices.first);
+      materialise_into(out[s], *frame_template, first);
+      for (unsigned i = 1; i < total_cycles; i++) {
+        frame_and_vertices = get_out_frame(frame_and_vertices.first, cycle);
+        FrameSample repeat;
+        add_frames(repeat, noop_frame, frame_and_vertices.first);
+        Circuit repeat_circ;
+        materialise_into(repeat_circ, *frame_template, repeat);
+        out[s].append(repeat_circ);
+      }
+    }
+  });
   return out;
 }
 
@@ -14,6 +14,10 @@
 
 #pragma once
 
+#include <memory>
+#include <optional>
+#include <random>
+
 #include "Characterisation/Cycles.hpp"
 #include "Circuit/Circuit.hpp"
 
@@ -47,12 +51,54 @@ class FrameRandomisation {
       : cycle_types_(_cycle_types),
         frame_types_(_frame_types),
         frame_cycle_conjugates_(_frame_cycle_conjugates) {}
-  // Returns samples instances of frame randomisation for circ
+  // Returns samples instances of frame randomisation for circ, sampled and
+  // built in parallel; the samples are reproducible if a seed is given
   virtual std::vector<Circuit> sample_randomisation_circuits(
-      const Circuit& circ, unsigned samples);
-  // Returns every combination of frame for every cycle in circ
+      const Circuit& circ, unsigned samples,
+      std::optional<unsigned> seed = std::nullopt);
+  // Returns every combination of frame for every cycle in circ, built in
+  // parallel
   std::vector<Circuit> get_all_circuits(const Circuit& circ);
 
+  // Circuit with frame vertices wired into the boundary of each cycle, shared
+  // by every sample drawn from it. Not copyable, as copying the circuit
+  // would invalidate the vertices held by the cycles.
+  struct FrameTemplate {
+    FrameTemplate() {}
+    FrameTemplate(const FrameTemplate&) = delete;
+    FrameTemplate& operator=(const FrameTemplate&) = delete;
+    Circuit circuit;
+    std::vector<Cycle> cycles;
+  };
+
+  // Frame gates of one sample from a FrameTemplate
+  // frame_ops holds the "in" then "out" frame OpType for each frame vertex
+  // pair, cycle by cycle; to_dagger holds cycle vertices of the template
+  // whose Op is replaced by its dagger
+  struct FrameSample {
+    OpTypeVector frame_ops;
+    std::vector<Vertex> to_dagger;
+  };
+
+  // Finds the cycles of circ and wires frame vertices into their boundaries
+  std::shared_ptr<const FrameTemplate> make_template(
+      const Circuit& circ) const;
+
+  // Returns samples sets of frame gates for frame_template, sampled in
+  // parallel; each sample depends only on seed and its index
+  std::vector<FrameSample> sample_frames(
+      const FrameTemplate& frame_template, unsigned samples, unsigned seed);
+
+  // Returns the circuit of frame_template labelled with the frame gates of
+  // sample, without modifying frame_template
+  Circuit materialise(
+      const FrameTemplate& frame_template, const FrameSample& sample) const;
+
+  // Returns the circuits of samples, built in parallel
+  std::vector<Circuit> materialise(
+      const FrameTemplate& frame_template,
+      const std::vector<FrameSample>& samples) const;
+
   std::string to_string() const;
 
  protected:
@@ -60,29 +106,30 @@ class FrameRandomisation {
   OpTypeSet frame_types_;
   std::map<OpType, std::map<OpTypeVector, OpTypeVector>>
       frame_cycle_conjugates_;
-  Circuit circuit_;
 
-  // Each Cycle in cycles has corresponding addresses of frame vertices in circ
-  // The OpType of each frame vertex is reassigned given all_frame_ops
-  std::vector<Circuit> label_frames(
-      const std::vector<std::vector<OpTypeVector>>& all_frame_ops,
-      const std::vector<Cycle>& cycles);
-
-  // Labels frame_vertices with in_frame & out_frame OpType
-  void assign_vertices(
-      const OpTypeVector& in_frame, const OpTypeVector& out_frame,
-      const std::vector<std::pair<Vertex, Vertex>>& frame_vertices);
+  // Each Cycle of frame_template has a frame in each element of
+  // all_frame_ops; finds the "out" frame for each, in parallel
+  std::vector<FrameSample> conjugate_frames(
+      const FrameTemplate& frame_template,
+      const std::vector<std::vector<OpTypeVector>>& all_frame_ops);
 
   // Finds cycles of cycle_types_ Op in circ using CycleFinder class
   std::vector<Cycle> get_cycles(const Circuit& circ) const;
 
+  // Copies frame_template into the empty circuit circ and labels it with
+  // the frame gates of sample
+  void materialise_into(
+      Circuit& circ, const FrameTemplate& frame_template,
+      const FrameSample& sample) const;
+
   // Uniformly samples size OpType from frame_types_
-  OpTypeVector sample_frame(const unsigned& size) const;
+  OpTypeVector sample_frame(const unsigned& size, std::mt19937& gen) const;
 
-  // Returns every permutation of OpType in frame_types_ up to largest
-  // frame_sizes value
+  // Returns samples sets of frames of sizes frame_sizes, sampled in
+  // parallel; each sample depends only on seed and its index
   std::vector<std::vector<OpTypeVector>> get_all_samples(
-      const unsigned& samples, const std::vector<unsigned>& frame_sizes) const;
+      const unsigned& samples, const std::vector<unsigned>& frame_sizes,
+      unsigned seed) const;
 
  private:
   // Returns new OpTypeVector "out_frame"
@@ -140,7 +187,8 @@ class PowerCycle : public PauliFrameRandomisation {
     frame_types_ = {OpType::X, OpType::Y, OpType::Z, OpType::noop};
   }
   std::vector<Circuit> sample_cycles(
-      const Circuit& circ, unsigned cycle_repeats, unsigned samples);
+      const Circuit& circ, unsigned cycle_repeats, unsigned samples,
+      std::optional<unsigned> seed = std::nullopt);
 };
 
 // Friend class of FrameRandomisation for testing some private methods
@@ -157,7 +205,8 @@ class FrameRandomisationTester {
       const OpTypeVector& in_frame, const Cycle& cycle_ops);
 
   std::vector<std::vector<OpTypeVector>> get_all_samples(
-      const unsigned& samples, const std::vector<unsigned>& frame_sizes);
+      const unsigned& samples, const std::vector<unsigned>& frame_sizes,
+      unsigned seed);
 };
 
 }  // namespace tket
@@ -14,8 +14,12 @@
 
 #include "Boxes.hpp"
 
+#include <boost/functional/hash.hpp>
 #include <memory>
+#include <mutex>
 #include <numeric>
+#include <shared_mutex>
+#include <unordered_map>
 
 #include "CircUtils.hpp"
 #include "Circuit/AssertionSynthesis.hpp"
@@ -43,6 +47,19 @@ unsigned Box::n_classical() const {
   return std::count(sig.begin(), sig.end(), EdgeType::Classical);
 }
 
+std::shared_ptr<Circuit> Box::to_circuit() const {
+  // Generating a circuit may generate those of inner boxes, which have their
+  // own mutexes.
+  std::lock_guard<std::mutex> lock(*generate_mutex_);
+  if (circ_ == nullptr) generate_circuit();
+  return circ_;
+}
+
+std::shared_ptr<const Circuit> Box::generated_circuit() const {
+  std::lock_guard<std::mutex> lock(*generate_mutex_);
+  return circ_;
+}
+
 op_signature_t Box::get_signature() const {
   std::optional<op_signature_t> sig = desc_.signature();
   if (sig)
@@ -75,6 +92,38 @@ CircBox::CircBox() : Box(OpType::CircBox) {
   circ_ = std::make_shared<Circuit>();
 }
 
+std::shared_ptr<const CircBox> CircBox::intern(const Circuit &circ) {
+  typedef std::unordered_multimap<std::size_t, std::weak_ptr<const CircBox>>
+      registry_t;
+  static std::mutex mutex;
+  static registry_t registry;
+  // Size of the registry after expired entries were last removed
+  static std::size_t swept_size = 0;
+  const std::size_t hash = circ.structural_hash();
+  std::lock_guard<std::mutex> lock(mutex);
+  auto range = registry.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    std::shared_ptr<const CircBox> box = it->second.lock();
+    if (box && box->circ_->get_name() == circ.get_name() &&
+        *box->circ_ == circ) {
+      return box;
+    }
+  }
+  if (registry.size() >= 2 * swept_size + 64) {
+    for (auto it = registry.begin(); it != registry.end();) {
+      if (it->second.expired()) {
+        it = registry.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    swept_size = registry.size();
+  }
+  std::shared_ptr<const CircBox> box = std::make_shared<CircBox>(circ);
+  registry.insert({hash, box});
+  return box;
+}
+
 Op_ptr CircBox::symbol_substitution(
     const SymEngine::map_basic_basic &sub_map) const {
   Circuit new_circ(*to_circuit());
@@ -92,11 +141,62 @@ Op_ptr CircBox::transpose() const {
   return std::make_shared<CircBox>(circ_->transpose());
 }
 
+namespace {
+
+template <typename MatrixT>
+const MatrixT &interned_key(const MatrixT &m) {
+  return m;
+}
+
+const Eigen::Matrix4cd &interned_key(const ExpBox::Eigensystem &eigensystem) {
+  return eigensystem.matrix;
+}
+
+// Unitary matrices of boxes, or values computed from the matrices, each
+// stored once per matrix. The registry does not keep them alive; expired
+// entries are removed as it grows.
+template <typename MatrixT, typename StoredT = MatrixT>
+std::shared_ptr<const StoredT> intern_matrix(const MatrixT &m) {
+  typedef std::unordered_multimap<std::size_t, std::weak_ptr<const StoredT>>
+      registry_t;
+  static std::mutex *mutex = new std::mutex();
+  static registry_t *registry = new registry_t();
+  // Size of the registry after expired entries were last removed
+  static std::size_t swept_size = 0;
+  std::size_t hash = 0;
+  for (Eigen::Index i = 0; i < m.size(); ++i) {
+    boost::hash_combine(hash, m.data()[i].real());
+    boost::hash_combine(hash, m.data()[i].imag());
+  }
+  std::lock_guard<std::mutex> lock(*mutex);
+  auto range = registry->equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    std::shared_ptr<const StoredT> stored = it->second.lock();
+    if (stored && interned_key(*stored) == m) return stored;
+  }
+  if (registry->size() >= 2 * swept_size + 64) {
+    for (auto it = registry->begin(); it != registry->end();) {
+      if (it->second.expired()) {
+        it = registry->erase(it);
+      } else {
+        ++it;
+      }
+    }
+    swept_size = registry->size();
+  }
+  std::shared_ptr<const StoredT> stored = std::make_shared<const StoredT>(m);
+  registry->insert({hash, stored});
+  return stored;
+}
+
+}  // namespace
+
 Unitary1qBox::Unitary1qBox(const Eigen::Matrix2cd &m)
-    : Box(OpType::Unitary1qBox), m_(m) {
+    : Box(OpType::Unitary1qBox) {
   if (!is_unitary(m)) {
     throw CircuitInvalidity("Matrix for Unitary1qBox must be unitary");
   }
+  m_ = intern_matrix(m);
 }
 
 Unitary1qBox::Unitary1qBox(const Unitary1qBox &other)
@@ -105,15 +205,15 @@ Unitary1qBox::Unitary1qBox(const Unitary1qBox &other)
 Unitary1qBox::Unitary1qBox() : Unitary1qBox(Eigen::Matrix2cd::Identity()) {}
 
 Op_ptr Unitary1qBox::dagger() const {
-  return std::make_shared<Unitary1qBox>(m_.conjugate().transpose());
+  return std::make_shared<Unitary1qBox>(m_->conjugate().transpose());
 }
 
 Op_ptr Unitary1qBox::transpose() const {
-  return std::make_shared<Unitary1qBox>(m_.transpose());
+  return std::make_shared<Unitary1qBox>(m_->transpose());
 }
 
 void Unitary1qBox::generate_circuit() const {
-  std::vector<double> tk1_params = tk1_angles_from_unitary(m_);
+  std::vector<double> tk1_params = tk1_angles_from_unitary(*m_);
   Circuit temp_circ(1);
   temp_circ.add_op<unsigned>(
       OpType::tk1, {tk1_params[0], tk1_params[1], tk1_params[2]}, {0});
@@ -122,11 +222,12 @@ void Unitary1qBox::generate_circuit() const {
 }
 
 Unitary2qBox::Unitary2qBox(const Eigen::Matrix4cd &m, BasisOrder basis)
-    : Box(OpType::Unitary2qBox),
-      m_(basis == BasisOrder::ilo ? m : reverse_indexing(m)) {
+    : Box(OpType::Unitary2qBox) {
   if (!is_unitary(m)) {
     throw CircuitInvalidity("Matrix for Unitary2qBox must be unitary");
   }
+  m_ = intern_matrix<Eigen::Matrix4cd>(
+      basis == BasisOrder::ilo ? m : reverse_indexing(m));
 }
 
 Unitary2qBox::Unitary2qBox(const Unitary2qBox &other)
@@ -135,20 +236,21 @@ Unitary2qBox::Unitary2qBox(const Unitary2qBox &other)
 Unitary2qBox::Unitary2qBox() : Unitary2qBox(Eigen::Matrix4cd::Identity()) {}
 
 Op_ptr Unitary2qBox::dagger() const {
-  return std::make_shared<Unitary2qBox>(m_.conjugate().transpose());
+  return std::make_shared<Unitary2qBox>(m_->conjugate().transpose());
 }
 
 Op_ptr Unitary2qBox::transpose() const {
-  return std::make_shared<Unitary2qBox>(m_.transpose());
+  return std::make_shared<Unitary2qBox>(m_->transpose());
 }
 
 void Unitary2qBox::generate_circuit() const {
-  circ_ = std::make_shared<Circuit>(two_qubit_canonical(m_));
+  circ_ = std::make_shared<Circuit>(two_qubit_canonical(*m_));
 }
 
 Unitary3qBox::Unitary3qBox(const Matrix8cd &m, BasisOrder basis)
     : Box(OpType::Unitary3qBox),
-      m_(basis == BasisOrder::ilo ? m : reverse_indexing(m)) {}
+      m_(intern_matrix<Matrix8cd>(
+          basis == BasisOrder::ilo ? m : reverse_indexing(m))) {}
 
 Unitary3qBox::Unitary3qBox(const Unitary3qBox &other)
     : Box(other), m_(other.m_) {}
@@ -156,38 +258,65 @@ Unitary3qBox::Unitary3qBox(const Unitary3qBox &other)
 Unitary3qBox::Unitary3qBox() : Unitary3qBox(Matrix8cd::Identity()) {}
 
 Op_ptr Unitary3qBox::dagger() const {
-  return std::make_shared<Unitary3qBox>(m_.adjoint());
+  return std::make_shared<Unitary3qBox>(m_->adjoint());
 }
 
 Op_ptr Unitary3qBox::transpose() const {
-  return std::make_shared<Unitary3qBox>(m_.transpose());
+  return std::make_shared<Unitary3qBox>(m_->transpose());
 }
 
 void Unitary3qBox::generate_circuit() const {
-  circ_ = std::make_shared<Circuit>(three_qubit_synthesis(m_));
+  circ_ = std::make_shared<Circuit>(three_qubit_synthesis(*m_));
+}
+
+ExpBox::Eigensystem::Eigensystem(const Eigen::Matrix4cd &A) : matrix(A) {
+  // The solver reads one triangle only, so decompose the hermitian part
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix4cd> solver(
+      0.5 * (A + A.adjoint()));
+  values = solver.eigenvalues();
+  vectors = solver.eigenvectors();
+}
+
+Eigen::Matrix4cd ExpBox::Eigensystem::exp(double t) const {
+  const Eigen::Vector4cd phases = (i_ * t * values).array().exp();
+  return vectors * phases.asDiagonal() * vectors.adjoint();
 }
 
 ExpBox::ExpBox(const Eigen::Matrix4cd &A, double t, BasisOrder basis)
-    : Box(OpType::ExpBox),
-      A_(basis == BasisOrder::ilo ? A : reverse_indexing(A)),
-      t_(t) {
+    : Box(OpType::ExpBox), t_(t) {
   if (!A.isApprox(A.adjoint())) {
     throw CircuitInvalidity("Matrix for ExpBox must be Hermitian");
   }
+  eigensystem_ = intern_matrix<Eigen::Matrix4cd, Eigensystem>(
+      basis == BasisOrder::ilo ? A : reverse_indexing(A));
 }
 
-ExpBox::ExpBox(const ExpBox &other) : Box(other), A_(other.A_), t_(other.t_) {}
+ExpBox::ExpBox(std::shared_ptr<const Eigensystem> eigensystem, double t)
+    : Box(OpType::ExpBox), eigensystem_(std::move(eigensystem)), t_(t) {}
+
+ExpBox::ExpBox(const ExpBox &other)
+    : Box(other), eigensystem_(other.eigensystem_), t_(other.t_) {}
 
 ExpBox::ExpBox() : ExpBox(Eigen::Matrix4cd::Zero(), 1.) {}
 
-Op_ptr ExpBox::dagger() const { return std::make_shared<ExpBox>(A_, -t_); }
+Op_ptr ExpBox::with_phase(double t) const {
+  return Op_ptr(new ExpBox(eigensystem_, t));
+}
+
+Op_ptr ExpBox::dagger() const { return with_phase(-t_); }
 
 Op_ptr ExpBox::transpose() const {
-  return std::make_shared<ExpBox>(A_.transpose(), t_);
+  // A is hermitian, so its transpose is its conjugate, with the conjugate
+  // eigenvectors
+  return Op_ptr(new ExpBox(
+      std::make_shared<const Eigensystem>(
+          eigensystem_->matrix.transpose(), eigensystem_->values,
+          eigensystem_->vectors.conjugate()),
+      t_));
 }
 
 void ExpBox::generate_circuit() const {
-  circ_ = std::make_shared<Circuit>(two_qubit_canonical((i_ * t_ * A_).exp()));
+  circ_ = std::make_shared<Circuit>(two_qubit_canonical(get_exp_matrix()));
 }
 
 PauliExpBox::PauliExpBox(const std::vector<Pauli> &paulis, const Expr &t)
@@ -343,7 +472,58 @@ std::string QControlBox::get_command_str(const unit_vector_t &args) const {
   return out.str();
 }
 
+namespace {
+
+struct QControlKey {
+  Op_ptr op;
+  unsigned n_controls;
+
+  bool operator==(const QControlKey &other) const {
+    return n_controls == other.n_controls && *op == *other.op;
+  }
+};
+
+struct QControlKeyHash {
+  std::size_t operator()(const QControlKey &key) const {
+    std::size_t seed = op_hash(key.op);
+    boost::hash_combine(seed, key.n_controls);
+    return seed;
+  }
+};
+
+/** Maximum number of cached decompositions */
+constexpr unsigned max_cached_qcontrol = 1024;
+
+typedef std::unordered_map<
+    QControlKey, std::shared_ptr<Circuit>, QControlKeyHash>
+    qcontrol_cache_t;
+
+// The cache is never destroyed, so that it can be used during static
+// deinitialization.
+qcontrol_cache_t &qcontrol_cache() {
+  static qcontrol_cache_t *cache = new qcontrol_cache_t();
+  return *cache;
+}
+
+std::shared_mutex &qcontrol_cache_mutex() {
+  static std::shared_mutex *mutex = new std::shared_mutex();
+  return *mutex;
+}
+
+}  // namespace
+
 void QControlBox::generate_circuit() const {
+  // Multi-controlled arithmetic repeats the same controlled ops many times,
+  // so decompositions are memoised and shared between boxes.
+  QControlKey key{op_, n_controls_};
+  {
+    std::shared_lock<std::shared_mutex> lock(qcontrol_cache_mutex());
+    qcontrol_cache_t::const_iterator found = qcontrol_cache().find(key);
+    if (found != qcontrol_cache().end()) {
+      circ_ = found->second;
+      return;
+    }
+  }
   Circuit c(n_inner_qubits_);
   std::vector<unsigned> qbs(n_inner_qubits_);
   std::iota(qbs.begin(), qbs.end(), 0);
@@ -351,6 +531,21 @@ void QControlBox::generate_circuit() const {
   c.decompose_boxes_recursively();
   c = with_controls(c, n_controls_);
   circ_ = std::make_shared<Circuit>(c);
+  std::unique_lock<std::shared_mutex> lock(qcontrol_cache_mutex());
+  if (qcontrol_cache().size() >= max_cached_qcontrol) {
+    qcontrol_cache().clear();
+  }
+  qcontrol_cache().insert({std::move(key), circ_});
+}
+
+unsigned qcontrol_box_cache_size() {
+  std::shared_lock<std::shared_mutex> lock(qcontrol_cache_mutex());
+  return qcontrol_cache().size();
+}
+
+void clear_qcontrol_box_cache() {
+  std::unique_lock<std::shared_mutex> lock(qcontrol_cache_mutex());
+  qcontrol_cache().clear();
 }
 
 Op_ptr QControlBox::dagger() const {
@@ -18,6 +18,7 @@
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <memory>
+#include <mutex>
 
 #include "Ops/Op.hpp"
 #include "Utils/BiMapHeaders.hpp"
@@ -36,7 +37,11 @@ class Circuit;
 class Box : public Op {
  public:
   explicit Box(const OpType &type, const op_signature_t &signature = {})
-      : Op(type), signature_(signature), circ_(), id_(idgen()) {
+      : Op(type),
+        signature_(signature),
+        circ_(),
+        id_(idgen()),
+        generate_mutex_(std::make_shared<std::mutex>()) {
     if (!is_box_type(type)) throw NotValid();
   }
 
@@ -44,7 +49,8 @@ class Box : public Op {
       : Op(other.get_type()),
         signature_(other.signature_),
         circ_(other.circ_),
-        id_(other.id_) {}
+        id_(other.id_),
+        generate_mutex_(std::make_shared<std::mutex>()) {}
 
   /** Number of Quantum inputs */
   unsigned n_qubits() const override;
@@ -61,11 +67,17 @@ class Box : public Op {
 
   static Op_ptr deserialize(const nlohmann::json &j);
 
-  /** Circuit represented by box */
-  std::shared_ptr<Circuit> to_circuit() const {
-    if (circ_ == nullptr) generate_circuit();
-    return circ_;
-  };
+  /**
+   * Circuit represented by box
+   *
+   * The circuit is generated on first use. Boxes are shared between
+   * circuits, so this may be called from several threads at once; distinct
+   * boxes are generated concurrently.
+   */
+  std::shared_ptr<Circuit> to_circuit() const;
+
+  /** Circuit represented by box if it has been generated, otherwise null */
+  std::shared_ptr<const Circuit> generated_circuit() const;
 
   /** Unique identifier (preserved on copy) */
   boost::uuids::uuid get_id() const { return id_; }
@@ -75,7 +87,8 @@ class Box : public Op {
 
  protected:
   static boost::uuids::uuid idgen() {
-    static boost::uuids::random_generator gen = {};
+    // One generator per thread, since boxes may be built concurrently
+    thread_local boost::uuids::random_generator gen = {};
 
     return gen();
   }
@@ -83,6 +96,9 @@ class Box : public Op {
   mutable std::shared_ptr<Circuit> circ_;
   boost::uuids::uuid id_;
 
+  /** Guards generation of \ref circ_ */
+  std::shared_ptr<std::mutex> generate_mutex_;
+
   virtual void generate_circuit() const = 0;
 };
 
@@ -129,6 +145,16 @@ class CircBox : public Box {
 
   ~CircBox() override {}
 
+  /**
+   * Box for a circuit, shared with all other interned boxes of equal circuits
+   *
+   * Interned boxes are looked up by \ref Circuit::structural_hash and
+   * compared by equality and name, so building the same subcircuit many
+   * times yields a single box, with a single id and a single stored circuit.
+   * The registry does not keep boxes alive.
+   */
+  static std::shared_ptr<const CircBox> intern(const Circuit &circ);
+
   Op_ptr symbol_substitution(
       const SymEngine::map_basic_basic &sub_map) const override;
 
@@ -156,6 +182,9 @@ class CircBox : public Box {
 
 /**
  * One-qubit operation defined as a unitary matrix
+ *
+ * The matrices of unitary boxes are immutable and interned: boxes with equal
+ * matrices, and all copies of a box, share a single stored matrix.
  */
 class Unitary1qBox : public Box {
  public:
@@ -194,9 +223,9 @@ class Unitary1qBox : public Box {
   }
 
   /** Get the unitary matrix correspnding to this operation */
-  Eigen::Matrix2cd get_matrix() const { return m_; }
+  const Eigen::Matrix2cd &get_matrix() const { return *m_; }
 
-  Eigen::MatrixXcd get_unitary() const override { return m_; }
+  Eigen::MatrixXcd get_unitary() const override { return *m_; }
 
   Op_ptr dagger() const override;
 
@@ -210,7 +239,8 @@ class Unitary1qBox : public Box {
   void generate_circuit() const override;
 
  private:
-  const Eigen::Matrix2cd m_;
+  // Shared with all other boxes of equal matrices
+  std::shared_ptr<const Eigen::Matrix2cd> m_;
 };
 
 /**
@@ -255,9 +285,9 @@ class Unitary2qBox : public Box {
   }
 
   /** Get the unitary matrix correspnding to this operation */
-  Eigen::Matrix4cd get_matrix() const { return m_; }
+  const Eigen::Matrix4cd &get_matrix() const { return *m_; }
 
-  Eigen::MatrixXcd get_unitary() const override { return m_; }
+  Eigen::MatrixXcd get_unitary() const override { return *m_; }
 
   Op_ptr dagger() const override;
 
@@ -271,7 +301,8 @@ class Unitary2qBox : public Box {
   void generate_circuit() const override;
 
  private:
-  const Eigen::Matrix4cd m_;
+  // Shared with all other boxes of equal matrices
+  std::shared_ptr<const Eigen::Matrix4cd> m_;
 };
 
 /**
@@ -315,9 +346,9 @@ class Unitary3qBox : public Box {
   }
 
   /** Get the unitary matrix correspnding to this operation */
-  Matrix8cd get_matrix() const { return m_; }
+  const Matrix8cd &get_matrix() const { return *m_; }
 
-  Eigen::MatrixXcd get_unitary() const override { return m_; }
+  Eigen::MatrixXcd get_unitary() const override { return *m_; }
 
   Op_ptr dagger() const override;
 
@@ -331,7 +362,8 @@ class Unitary3qBox : public Box {
   void generate_circuit() const override;
 
  private:
-  const Matrix8cd m_;
+  // Shared with all other boxes of equal matrices
+  std::shared_ptr<const Matrix8cd> m_;
 };
 
 /**
@@ -342,6 +374,36 @@ class Unitary3qBox : public Box {
  */
 class ExpBox : public Box {
  public:
+  /**
+   * Eigendecomposition \f$ A = V D V^\dagger \f$ of the matrix of an ExpBox.
+   *
+   * It is computed once for each distinct matrix and shared between the
+   * boxes built from it, their copies, and boxes derived from them by
+   * \ref with_phase, \ref dagger and \ref transpose, so that
+   * \f$ e^{itA} = V e^{itD} V^\dagger \f$ costs a diagonal scaling and two
+   * 4x4 products for each new phase.
+   */
+  struct Eigensystem {
+    /** Decompose a hermitian matrix */
+    explicit Eigensystem(const Eigen::Matrix4cd &A);
+
+    /** From a known decomposition */
+    Eigensystem(
+        const Eigen::Matrix4cd &A, const Eigen::Vector4d &D,
+        const Eigen::Matrix4cd &V)
+        : matrix(A), values(D), vectors(V) {}
+
+    /** \f$ e^{itA} \f$ */
+    Eigen::Matrix4cd exp(double t) const;
+
+    /** The hermitian matrix A */
+    Eigen::Matrix4cd matrix;
+    /** Eigenvalues, the diagonal of D */
+    Eigen::Vector4d values;
+    /** Orthonormal eigenvectors, the columns of V */
+    Eigen::Matrix4cd vectors;
+  };
+
   /**
    * Construct from a given 4x4 hermitian matrix and optional phase.
    *
@@ -382,9 +444,17 @@ class ExpBox : public Box {
 
   /** Get the hermitian matrix and phase parameter */
   std::pair<Eigen::Matrix4cd, double> get_matrix_and_phase() const {
-    return std::make_pair(A_, t_);
+    return std::make_pair(eigensystem_->matrix, t_);
   }
 
+  /** The unitary \f$ e^{itA} \f$ (ILO-BE) */
+  Eigen::Matrix4cd get_exp_matrix() const { return eigensystem_->exp(t_); }
+
+  Eigen::MatrixXcd get_unitary() const override { return get_exp_matrix(); }
+
+  /** The box with the same matrix and another phase */
+  Op_ptr with_phase(double t) const;
+
   Op_ptr dagger() const override;
 
   Op_ptr transpose() const override;
@@ -397,7 +467,9 @@ class ExpBox : public Box {
   void generate_circuit() const override;
 
  private:
-  const Eigen::Matrix4cd A_;
+  ExpBox(std::shared_ptr<const Eigensystem> eigensystem, double t);
+
+  std::shared_ptr<const Eigensystem> eigensystem_;
   double t_;
 };
 
@@ -587,6 +659,18 @@ class QControlBox : public Box {
   unsigned n_inner_qubits_;
 };
 
+/**
+ * Number of decompositions memoised by \ref QControlBox
+ *
+ * Decompositions are cached by the controlled op and the number of controls,
+ * and boxes with equal keys share one circuit, so repeated controlled
+ * operations are only decomposed once.
+ */
+unsigned qcontrol_box_cache_size();
+
+/** Forget all decompositions memoised by \ref QControlBox */
+void clear_qcontrol_box_cache();
+
 class ProjectorAssertionBox : public Box {
  public:
   /**
@@ -42,6 +42,16 @@ const Circuit &BRIDGE_using_CX_1() {
   return *C;
 }
 
+const ReplacementTemplate &BRIDGE_using_CX_0_template() {
+  static const ReplacementTemplate T(BRIDGE_using_CX_0());
+  return T;
+}
+
+const ReplacementTemplate &BRIDGE_using_CX_1_template() {
+  static const ReplacementTemplate T(BRIDGE_using_CX_1());
+  return T;
+}
+
 const Circuit &CX_using_flipped_CX() {
   static std::unique_ptr<const Circuit> C = std::make_unique<Circuit>([]() {
     Circuit c(2);
@@ -227,6 +237,16 @@ const Circuit &SWAP_using_CX_1() {
   return *C;
 }
 
+const ReplacementTemplate &SWAP_using_CX_0_template() {
+  static const ReplacementTemplate T(SWAP_using_CX_0());
+  return T;
+}
+
+const ReplacementTemplate &SWAP_using_CX_1_template() {
+  static const ReplacementTemplate T(SWAP_using_CX_1());
+  return T;
+}
+
 const Circuit &two_Rz1() {
   static std::unique_ptr<const Circuit> C = std::make_unique<Circuit>([]() {
     Circuit c(2);
@@ -15,6 +15,7 @@
 #pragma once
 
 #include "Circuit.hpp"
+#include "ReplacementTemplate.hpp"
 #include "Utils/Expression.hpp"
 
 namespace tket {
@@ -27,6 +28,12 @@ const Circuit &BRIDGE_using_CX_0();
 /** Equivalent to BRIDGE, using four CX, first CX has control on qubit 1 */
 const Circuit &BRIDGE_using_CX_1();
 
+/** \ref BRIDGE_using_CX_0 as a replacement template */
+const ReplacementTemplate &BRIDGE_using_CX_0_template();
+
+/** \ref BRIDGE_using_CX_1 as a replacement template */
+const ReplacementTemplate &BRIDGE_using_CX_1_template();
+
 /** Equivalent to CX[0,1], using a CX[1,0] and four H gates */
 const Circuit &CX_using_flipped_CX();
 
@@ -102,6 +109,12 @@ const Circuit &SWAP_using_CX_0();
 /** Equivalent to SWAP, using three CX, outer CX have control on qubit 1 */
 const Circuit &SWAP_using_CX_1();
 
+/** \ref SWAP_using_CX_0 as a replacement template */
+const ReplacementTemplate &SWAP_using_CX_0_template();
+
+/** \ref SWAP_using_CX_1 as a replacement template */
+const ReplacementTemplate &SWAP_using_CX_1_template();
+
 /** A two-qubit circuit with an Rz(1) on each qubit */
 const Circuit &two_Rz1();
 
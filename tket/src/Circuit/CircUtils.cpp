@@ -14,13 +14,20 @@
 
 #include "CircUtils.hpp"
 
+#include <array>
+#include <boost/functional/hash.hpp>
 #include <cmath>
 #include <complex>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "CircPool.hpp"
 #include "Circuit/Circuit.hpp"
 #include "Gate/GatePtr.hpp"
+#include "Gate/GateUnitaryMatrix.hpp"
+#include "Gate/GateUnitaryMatrixError.hpp"
 #include "Gate/Rotation.hpp"
 #include "Utils/EigenConfig.hpp"
 #include "Utils/Expression.hpp"
@@ -105,9 +112,13 @@ Eigen::Matrix4cd get_matrix_from_2qb_circ(const Circuit &circ) {
         default: {
           if (o->get_desc().is_gate() && circ.n_in_edges(it->first) == 1 &&
               circ.n_out_edges(it->first) == 1) {
-            const Op_ptr g = o;
-            std::vector<Expr> ps = as_gate_ptr(g)->get_tk1_angles();
-            Eigen::Matrix2cd mat = get_matrix_from_tk1_angles(ps);
+            Eigen::Matrix2cd mat;
+            try {
+              mat = GateUnitaryMatrix::get_unitary_1q(*as_gate_ptr(o));
+            } catch (const GateUnitaryMatrixError &) {
+              throw NotImplemented(
+                  "Cannot obtain matrix from op " + o->get_name());
+            }
             if (uqb == 0) {
               v_to_op[it->first] =
                   Eigen::kroneckerProduct(mat, Eigen::Matrix2cd::Identity());
@@ -132,13 +143,63 @@ Eigen::Matrix4cd get_matrix_from_2qb_circ(const Circuit &circ) {
   return std::exp(i_ * PI * eval_expr(circ.get_phase()).value()) * m;
 }
 
-// TODO all cnots are in one direction: freedom to choose the optimal one
-Circuit two_qubit_canonical(const Eigen::Matrix4cd &U, double cx_fidelity) {
-  if (!is_unitary(U)) {
-    throw std::invalid_argument(
-        "Non-unitary matrix passed to two_qubit_canonical");
+namespace {
+
+/**
+ * Identifies a call to two_qubit_canonical: the real and imaginary parts of
+ * the matrix entries, rounded to multiples of EPS, and the CX fidelity.
+ */
+struct CanonicalKey {
+  std::array<long long, 32> entries;
+  double cx_fidelity;
+
+  CanonicalKey(const Eigen::Matrix4cd &U, double cx_fidelity)
+      : cx_fidelity(cx_fidelity) {
+    for (unsigned r = 0; r < 4; ++r) {
+      for (unsigned c = 0; c < 4; ++c) {
+        entries[8 * r + 2 * c] = std::llround(U(r, c).real() / EPS);
+        entries[8 * r + 2 * c + 1] = std::llround(U(r, c).imag() / EPS);
+      }
+    }
+  }
+
+  bool operator==(const CanonicalKey &other) const {
+    return entries == other.entries && cx_fidelity == other.cx_fidelity;
+  }
+};
+
+struct CanonicalKeyHash {
+  std::size_t operator()(const CanonicalKey &key) const {
+    std::size_t seed =
+        boost::hash_range(key.entries.begin(), key.entries.end());
+    boost::hash_combine(seed, key.cx_fidelity);
+    return seed;
   }
+};
+
+/** Maximum number of cached decompositions */
+constexpr unsigned max_cached_canonical = 1024;
+
+typedef std::unordered_map<CanonicalKey, Circuit, CanonicalKeyHash>
+    canonical_cache_t;
+
+// The cache is never destroyed, so that it can be used during static
+// deinitialization.
+canonical_cache_t &canonical_cache() {
+  static canonical_cache_t *cache = new canonical_cache_t();
+  return *cache;
+}
 
+std::shared_mutex &canonical_cache_mutex() {
+  static std::shared_mutex *mutex = new std::shared_mutex();
+  return *mutex;
+}
+
+}  // namespace
+
+// TODO all cnots are in one direction: freedom to choose the optimal one
+static Circuit two_qubit_canonical_uncached(
+    const Eigen::Matrix4cd &U, double cx_fidelity) {
   auto [K1, A, K2] = get_information_content(U);
 
   K1 /= pow(K1.determinant(), 0.25);
@@ -191,6 +252,38 @@ Circuit two_qubit_canonical(const Eigen::Matrix4cd &U, double cx_fidelity) {
   return result;
 }
 
+Circuit two_qubit_canonical(const Eigen::Matrix4cd &U, double cx_fidelity) {
+  if (!is_unitary(U)) {
+    throw std::invalid_argument(
+        "Non-unitary matrix passed to two_qubit_canonical");
+  }
+  // Circuits made of repeated layers decompose the same unitaries many times,
+  // so decompositions are memoised.
+  CanonicalKey key(U, cx_fidelity);
+  {
+    std::shared_lock<std::shared_mutex> lock(canonical_cache_mutex());
+    canonical_cache_t::const_iterator found = canonical_cache().find(key);
+    if (found != canonical_cache().end()) return found->second;
+  }
+  Circuit result = two_qubit_canonical_uncached(U, cx_fidelity);
+  std::unique_lock<std::shared_mutex> lock(canonical_cache_mutex());
+  if (canonical_cache().size() >= max_cached_canonical) {
+    canonical_cache().clear();
+  }
+  canonical_cache().insert({std::move(key), result});
+  return result;
+}
+
+unsigned two_qubit_canonical_cache_size() {
+  std::shared_lock<std::shared_mutex> lock(canonical_cache_mutex());
+  return canonical_cache().size();
+}
+
+void clear_two_qubit_canonical_cache() {
+  std::unique_lock<std::shared_mutex> lock(canonical_cache_mutex());
+  canonical_cache().clear();
+}
+
 // Factorize U as VD where V corresponds to a 2-CX circuit and
 // D = diag(z, z*, z*, z). Return V and z.
 static std::pair<Eigen::Matrix4cd, Complex> decompose_VD(
@@ -79,6 +79,17 @@ Eigen::Matrix4cd get_matrix_from_2qb_circ(const Circuit& circ);
  */
 Circuit two_qubit_canonical(const Eigen::Matrix4cd& U, double cx_fidelity = 1.);
 
+/**
+ * Number of decompositions memoised by \ref two_qubit_canonical
+ *
+ * Decompositions are cached by the matrix (with entries rounded to multiples
+ * of EPS) and the CX fidelity, so repeated blocks are only decomposed once.
+ */
+unsigned two_qubit_canonical_cache_size();
+
+/** Forget all decompositions memoised by \ref two_qubit_canonical */
+void clear_two_qubit_canonical_cache();
+
 /**
  * Decompose a unitary matrix into a 2-CX circuit following a diagonal operator.
  *
@@ -14,6 +14,9 @@
 
 #include "Circuit.hpp"
 
+#include <boost/uuid/uuid_hash.hpp>
+#include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <numeric>
 #include <optional>
@@ -21,6 +24,8 @@
 #include <string>
 #include <utility>
 
+#include "CommandView.hpp"
+#include "Gate/Gate.hpp"
 #include "Utils/GraphHeaders.hpp"
 #include "Utils/HelperFunctions.hpp"
 #include "Utils/TketLog.hpp"
@@ -95,13 +100,45 @@ void Circuit::extract_slice_segment(unsigned slice_one, unsigned slice_two) {
 }
 
 std::vector<Command> Circuit::get_commands() const {
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    refresh_traversal_cache();
+    if (traversal_cache_.commands) {
+      // Operations may have been replaced in place since the commands were
+      // computed; their arguments are unaffected by such changes.
+      for (Command &com : *traversal_cache_.commands) {
+        const Vertex v = com.get_vertex();
+        const VertexProperties &props = dag[v];
+        if (com.get_op_ptr() != props.op ||
+            com.get_opgroup() != props.opgroup) {
+          com = Command(props.op, com.get_args(), props.opgroup, v);
+        }
+      }
+      return *traversal_cache_.commands;
+    }
+  }
+  // The views take the lock themselves, to read the slices and unit paths
   std::vector<Command> coms;
-  for (CommandIterator it = begin(); it != end(); ++it) {
-    coms.push_back(*it);
+  for (const CommandView &view : CommandViews(*this)) {
+    coms.push_back(view.to_command());
   }
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  refresh_traversal_cache();
+  traversal_cache_.commands = coms;
   return coms;
 }
 
+void Circuit::refresh_traversal_cache() const {
+  if (traversal_cache_.version != dag_version_ ||
+      !(traversal_cache_.boundary == boundary)) {
+    traversal_cache_.version = dag_version_;
+    traversal_cache_.boundary = boundary;
+    traversal_cache_.slices = std::nullopt;
+    traversal_cache_.commands = std::nullopt;
+    traversal_cache_.unit_paths = nullptr;
+  }
+}
+
 void Circuit::index_vertices() /*const*/ {
   VIndex index = boost::get(boost::vertex_index, dag);
   int i = 0;
@@ -156,7 +193,9 @@ void Circuit::symbol_substitution(const SymEngine::map_basic_basic sub_map) {
   BGL_FORALL_VERTICES(v, dag, DAG) {
     Op_ptr new_op = get_Op_ptr_from_Vertex(v)->symbol_substitution(sub_map);
     if (new_op) {
+      log_change(Change::Kind::Replaced, v, dag[v].op);
       dag[v] = {new_op};
+      ++op_version_;
     }
   }
   phase = phase.subs(sub_map);
@@ -234,16 +273,125 @@ bool Circuit::circuit_equality(
   return check;
 }
 
+// Finaliser of splitmix64, spreading the bits of a hash before summing
+static std::uint64_t mix_hash(std::uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// Hash of a parameter, stable between runs. Numbers are reduced modulo n and
+// rounded to a multiple of 1e-9, so that values equal to within the
+// tolerance of equiv_expr almost always hash the same.
+static std::size_t param_hash(const Expr &e, unsigned n) {
+  std::optional<double> x = eval_expr(e);
+  if (!x) return boost::hash_value(ExprPtr(e)->__str__());
+  constexpr double grid = 1e9;
+  long long r = std::llround(fmodn(*x, n) * grid);
+  long long period = std::llround(n * grid);
+  return boost::hash_value(r % period);
+}
+
+// Hash of a unit, stable between runs
+static std::size_t unit_hash(const UnitID &unit) {
+  std::size_t seed = boost::hash_value(unit.reg_name());
+  boost::hash_combine(seed, unit.index());
+  boost::hash_combine(seed, static_cast<unsigned>(unit.type()));
+  return seed;
+}
+
+std::size_t op_hash(const Op_ptr &op) {
+  std::size_t seed = 0;
+  boost::hash_combine(seed, static_cast<unsigned>(op->get_type()));
+  for (EdgeType e : op->get_signature()) {
+    boost::hash_combine(seed, static_cast<unsigned>(e));
+  }
+  if (const Gate *gate = dynamic_cast<const Gate *>(op.get())) {
+    OpDesc desc = gate->get_desc();
+    std::vector<Expr> params = gate->get_params();
+    for (unsigned i = 0; i < params.size(); ++i) {
+      boost::hash_combine(seed, param_hash(params[i], desc.param_mod(i)));
+    }
+  } else if (
+      const Conditional *cond = dynamic_cast<const Conditional *>(op.get())) {
+    boost::hash_combine(seed, op_hash(cond->get_op()));
+    boost::hash_combine(seed, cond->get_width());
+    boost::hash_combine(seed, cond->get_value());
+  } else if (const Box *box = dynamic_cast<const Box *>(op.get())) {
+    // Boxes compare by id, except phase polynomial boxes which compare by
+    // content
+    if (op->get_type() != OpType::PhasePolyBox) {
+      boost::hash_combine(seed, boost::uuids::hash_value(box->get_id()));
+    }
+  }
+  return seed;
+}
+
+std::size_t Circuit::structural_hash() const {
+  // Identify each in-port of each vertex by the unit on its wire and the
+  // number of vertices before it on that wire; inputs are at position 0.
+  typedef std::pair<std::size_t, unsigned> WirePos;
+  std::map<Vertex, std::vector<WirePos>> positions;
+  for (const BoundaryElement &el : boundary.get<TagID>()) {
+    std::size_t u = unit_hash(el.id_);
+    Vertex v = el.in_;
+    positions[v] = {{u, 0}};
+    unsigned step = 0;
+    Edge e = get_nth_out_edge(v, 0);
+    while (true) {
+      v = target(e);
+      port_t port = get_target_port(e);
+      std::vector<WirePos> &pos = positions[v];
+      if (pos.size() <= port) pos.resize(port + 1);
+      pos[port] = {u, ++step};
+      if (detect_final_Op(v)) break;
+      e = get_next_edge(v, e);
+    }
+  }
+  std::uint64_t total = 0;
+  BGL_FORALL_VERTICES(v, dag, DAG) {
+    std::vector<WirePos> pos = positions[v];
+    // Boolean in-edges read the wire of a classical out-port
+    BGL_FORALL_INEDGES(v, e, dag, DAG) {
+      if (get_edgetype(e) != EdgeType::Boolean) continue;
+      port_t port = get_target_port(e);
+      const std::vector<WirePos> &source_pos = positions.at(source(e));
+      if (pos.size() <= port) pos.resize(port + 1);
+      pos[port] = source_pos.at(get_source_port(e));
+    }
+    std::size_t seed = op_hash(get_Op_ptr_from_Vertex(v));
+    for (const WirePos &p : pos) {
+      boost::hash_combine(seed, p.first);
+      boost::hash_combine(seed, p.second);
+    }
+    total += mix_hash(seed);
+  }
+  std::size_t seed = 0;
+  boost::hash_combine(seed, param_hash(get_phase(), 2));
+  for (const std::pair<const Qubit, Qubit> &pair :
+       implicit_qubit_permutation()) {
+    boost::hash_combine(seed, unit_hash(pair.first));
+    boost::hash_combine(seed, unit_hash(pair.second));
+  }
+  std::optional<std::string> name = get_name();
+  if (name) boost::hash_combine(seed, *name);
+  total += mix_hash(seed);
+  return static_cast<std::size_t>(total);
+}
+
 // Performs a traversal from the given vertex forwards through the dag, looking
 // for something on the target qubit We can prune a path if it reaches the depth
 // of the target forward = true returns true if target is in causal future of
 // from forward = false checks for causal past (v_to_depth should give reverse
 // depth)
 // TODO:: rewrite to work with classical boxes
-bool Circuit::in_causal_order(
-    const Vertex &target, const Vertex &from, bool forward,
-    const std::map<Vertex, unsigned> &v_to_depth,
-    const std::map<Vertex, unit_set_t> &v_to_units, bool strict) const {
+// DepthMap and UnitsMap are std::maps or VertexArrays
+template <typename DepthMap, typename UnitsMap>
+static bool causal_search(
+    const Circuit &circ, const Vertex &target, const Vertex &from,
+    bool forward, const DepthMap &v_to_depth, const UnitsMap &v_to_units,
+    bool strict) {
   unsigned target_depth = v_to_depth.at(target);
   if (!strict && from == target) return true;
   if (v_to_depth.at(from) >= target_depth) return false;
@@ -252,48 +400,63 @@ bool Circuit::in_causal_order(
     unsigned deptha = v_to_depth.at(a);
     unsigned depthb = v_to_depth.at(b);
     if (deptha == depthb) {
-      unit_set_t unitsa = v_to_units.at(a);
-      unit_set_t unitsb = v_to_units.at(b);
-      return unitsa < unitsb;
+      return v_to_units.at(a) < v_to_units.at(b);
     }
     return deptha < depthb;
   };
   std::set<Vertex, Comp> to_search(c);
+  SmallVertexVec succs, preds;
   if (forward) {
-    VertexVec succs = get_successors(from);
+    circ.get_successors(from, succs);
     for (const Vertex &s : succs) {
-      if (v_to_depth.find(s) != v_to_depth.end()) {
+      if (v_to_depth.count(s)) {
         to_search.insert(s);
       }
     }
   } else {
-    VertexVec preds = get_predecessors(from);
+    circ.get_predecessors(from, preds);
     to_search.insert(preds.begin(), preds.end());
   }
-  unit_set_t lookup_units = v_to_units.at(target);
+  const unit_set_t &lookup_units = v_to_units.at(target);
   while (!to_search.empty()) {
     Vertex v = *to_search.begin();
     to_search.erase(to_search.begin());
     if (v_to_depth.at(v) > target_depth) continue;
-    unit_set_t v_units = v_to_units.at(v);
+    const unit_set_t &v_units = v_to_units.at(v);
     for (const UnitID &u : lookup_units) {
       if (v_units.find(u) != v_units.end()) {
         return true;
       }
     }
     if (forward) {
-      VertexVec succs = get_successors(v);
+      circ.get_successors(v, succs);
       for (const Vertex &s : succs) {
-        if (v_to_depth.find(s) != v_to_depth.end()) {
+        if (v_to_depth.count(s)) {
           to_search.insert(s);
         }
       }
     } else {
-      VertexVec preds = get_predecessors(v);
+      circ.get_predecessors(v, preds);
       to_search.insert(preds.begin(), preds.end());
     }
   }
   return false;
 }
 
+bool Circuit::in_causal_order(
+    const Vertex &target, const Vertex &from, bool forward,
+    const std::map<Vertex, unsigned> &v_to_depth,
+    const std::map<Vertex, unit_set_t> &v_to_units, bool strict) const {
+  return causal_search(
+      *this, target, from, forward, v_to_depth, v_to_units, strict);
+}
+
+bool Circuit::in_causal_order(
+    const Vertex &target, const Vertex &from, bool forward,
+    const VertexArray<unsigned> &v_to_depth,
+    const VertexArray<unit_set_t> &v_to_units, bool strict) const {
+  return causal_search(
+      *this, target, from, forward, v_to_depth, v_to_units, strict);
+}
+
 }  // namespace tket
@@ -25,13 +25,17 @@
 // is ignored, and the amortized constant time used for scaling instead
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <ostream>
+#include <set>
 #include <sstream>
 #include <string>
 #include <type_traits>
@@ -51,9 +55,12 @@
 #include "Utils/SequencedContainers.hpp"
 #include "Utils/TketLog.hpp"
 #include "Utils/UnitID.hpp"
+#include "VertexArray.hpp"
 
 namespace tket {
 
+class UnitPathIndex;
+
 typedef std::vector<EdgeVec> BundleVec;
 
 typedef VertexVec Slice;
@@ -238,6 +245,19 @@ enum ReverseType {
   transpose = 2,
 };
 
+/** Options for \ref Circuit::to_latex */
+struct LatexOptions {
+  /**
+   * Draw each box as its circuit, recursively, rather than as a single gate
+   */
+  bool expand_boxes = false;
+  /**
+   * Draw a run of identical consecutive slices once, followed by a marker
+   * giving the number of repetitions
+   */
+  bool collapse_repeated_layers = false;
+};
+
 /**
  * A circuit.
  *
@@ -252,6 +272,7 @@ class Circuit {
   void _handle_edges(
       Circuit &circ, vertex_map_t &vmap, E_iterator &ei,
       E_iterator &eend) const;
+  void _reverse_in_place(ReverseType reverse_op);
 
  public:
   /*SliceIterator class is used for lazy evaluation of slices */
@@ -413,6 +434,24 @@ class Circuit {
    */
   void assert_valid() const;
 
+  /**
+   * Run the checks of \ref assert_valid on the parts of the circuit changed
+   * since a checkpoint, as taken by \ref get_change_checkpoint.
+   *
+   * Only the vertices added, given a new operation or rewired since the
+   * checkpoint are checked, together with the boundary. For a circuit that
+   * was valid at the checkpoint and has since been changed through its
+   * methods, this is equivalent to the full check. The full check is run if
+   * changes are not being recorded (see \ref record_changes) or the DAG has
+   * been rebuilt since the checkpoint.
+   *
+   * @return whether the checks pass
+   */
+  bool is_valid_since(std::size_t checkpoint) const;
+
+  /** Abort if \ref is_valid_since fails. */
+  void assert_valid_since(std::size_t checkpoint) const;
+
   /* getters */
   // returns the vector of input/output vertices to dag, ordered by register
   VertexVec all_inputs() const;
@@ -491,11 +530,15 @@ class Circuit {
   // duplicates) O(log(n!)), where `n` is number of outedges from `vert`
   // (ignoring hashtable collisions)
   VertexVec get_successors(const Vertex &vert) const;
+  // as above, but filling `succs`, which does not allocate for up to 8
+  void get_successors(const Vertex &vert, SmallVertexVec &succs) const;
   VertexVec get_successors_of_type(const Vertex &vert, EdgeType type) const;
   // O(log(n!)), where `n` is number of inedges of `vert` (ignoring hashtable
   // collisions) given a vertex, returns a vector of all its predecessor
   // vertices (no duplicates)
   VertexVec get_predecessors(const Vertex &vert) const;
+  // as above, but filling `preds`, which does not allocate for up to 8
+  void get_predecessors(const Vertex &vert, SmallVertexVec &preds) const;
   VertexVec get_predecessors_of_type(const Vertex &vert, EdgeType type) const;
 
   // O(1)
@@ -519,6 +562,16 @@ class Circuit {
    */
   EdgeVec get_in_edges(const Vertex &vert) const;
 
+  /**
+   * As \ref get_in_edges, but filling a small vector, which is cleared
+   * first and does not allocate for vertices of up to 8 ports. Prefer this
+   * in hot loops over the vertices of a circuit.
+   *
+   * @param vert vertex
+   * @param ins replaced by the in-edges of vert, ordered by port number
+   */
+  void get_in_edges(const Vertex &vert, SmallEdgeVec &ins) const;
+
   /**
    * All inward edges of given type, ordered by port number
    *
@@ -537,6 +590,14 @@ class Circuit {
   std::vector<std::optional<Edge>> get_linear_out_edges(
       const Vertex &vert) const;
 
+  /**
+   * As \ref get_linear_out_edges, but filling a small vector
+   *
+   * @param vert vertex
+   * @param outs replaced by one entry per port of vert
+   */
+  void get_linear_out_edges(const Vertex &vert, SmallOptEdgeVec &outs) const;
+
   /**
    * Outward edges for all types, ordered by port number
    * For classical ports, the Classical output is given, followed by any
@@ -546,6 +607,14 @@ class Circuit {
    */
   EdgeVec get_all_out_edges(const Vertex &vert) const;
 
+  /**
+   * As \ref get_all_out_edges, but filling a small vector
+   *
+   * @param vert vertex
+   * @param outs replaced by the out-edges of vert, ordered by port number
+   */
+  void get_all_out_edges(const Vertex &vert, SmallEdgeVec &outs) const;
+
   /**
    * All outward edges of given type, ordered by port number
    *
@@ -766,6 +835,24 @@ class Circuit {
     return add_op(get_op_ptr(type, params, args.size()), args, opgroup);
   }
 
+  /**
+   * Append a batch of operations to the circuit
+   *
+   * Equivalent to calling \ref add_op on each operation in turn, with the
+   * arguments given as indices into \p units, but the units are looked up
+   * only once for the whole batch.
+   *
+   * @param ops operations to append, each with its argument indices
+   * @param units the units referred to by the argument indices
+   *
+   * @return the newly-added vertices, in order
+   * @throw CircuitInvalidity if an operation has invalid arguments, in
+   *   which case the operations before it have been appended
+   */
+  std::vector<Vertex> add_ops(
+      const std::vector<std::pair<Op_ptr, std::vector<unsigned>>> &ops,
+      const unit_vector_t &units);
+
   /**
    * Add a measure operation from a qubit to a bit
    *
@@ -855,9 +942,25 @@ class Circuit {
       const std::optional<Qubit> &ancilla = std::nullopt,
       const std::optional<std::string> &name = std::nullopt);
 
+  /**
+   * Append a stabiliser assertion.
+   *
+   * The assertion resets its ancilla before measuring each stabiliser, so
+   * one ancilla can be shared by any number of assertions. If none is given,
+   * the qubit 0 of the \ref q_debug_ancilla_reg register is used, and added
+   * to the circuit by the first assertion that needs it.
+   *
+   * @param assertion_box assertion to append
+   * @param qubits target qubits, one for each Pauli in the stabilisers
+   * @param ancilla ancilla qubit
+   * @param name name used to identify this assertion
+   *
+   * @return the new vertex
+   */
   Vertex add_assertion(
       const StabiliserAssertionBox &assertion_box,
-      const std::vector<Qubit> &qubits, const Qubit &ancilla,
+      const std::vector<Qubit> &qubits,
+      const std::optional<Qubit> &ancilla = std::nullopt,
       const std::optional<std::string> &name = std::nullopt);
 
   /**
@@ -1030,6 +1133,82 @@ class Circuit {
    */
   std::map<OpType, unsigned> op_counts() const;
 
+  /** Numbers of vertices of each operation type, as from \ref optype_counts */
+  struct OpTypeCounts {
+    /** Number of vertices of each type, indexed by the type */
+    std::array<unsigned, n_optypes> counts{};
+    /**
+     * Number of Conditional vertices conditioning an operation of each type,
+     * indexed by that type
+     */
+    std::array<unsigned, n_optypes> conditioned{};
+
+    /** Types of the vertices */
+    OpTypeMask types() const;
+    /** Types of the operations conditioned by Conditional vertices */
+    OpTypeMask conditioned_types() const;
+  };
+
+  /**
+   * Count vertices by operation type, including initial and final nodes.
+   *
+   * The counts are computed in one pass over the DAG and then kept up to
+   * date by the methods adding, removing and replacing single vertices, so
+   * that asking again costs O(number of OpTypes) until the circuit is
+   * changed in another way.
+   */
+  OpTypeCounts optype_counts() const;
+
+  /**
+   * Estimated memory used by a circuit, in bytes, by category, as from
+   * \ref memory_usage
+   */
+  struct MemoryUsage {
+    /** Vertex nodes of the DAG, with their properties */
+    std::size_t vertices = 0;
+    /** Edge nodes of the DAG, with their in- and out-edge list entries */
+    std::size_t edges = 0;
+    /** Operations referenced only by this circuit */
+    std::size_t unique_ops = 0;
+    /**
+     * Operations also referenced from elsewhere, such as other circuits or
+     * the copies of a box
+     */
+    std::size_t shared_ops = 0;
+    /** Circuits generated for boxes, including everything they hold */
+    std::size_t boxes = 0;
+    /** SymEngine expression nodes of parameters and the global phase */
+    std::size_t expressions = 0;
+    /** Boundary entries and the (interned) names and indices of units */
+    std::size_t units = 0;
+    /** Operation group names and signatures */
+    std::size_t opgroups = 0;
+    /** Cached traversals, depths, operation counts and change logs */
+    std::size_t caches = 0;
+    /** The circuit object itself and its name */
+    std::size_t other = 0;
+
+    /** Sum over all categories */
+    std::size_t total() const;
+  };
+
+  /**
+   * Estimate the memory used by the circuit.
+   *
+   * Sizes are those of the objects stored plus the link pointers of the
+   * lists and trees holding them, ignoring allocator overhead. Objects of
+   * dynamic type (operations and expression nodes) are counted at the size
+   * of their common type, so those categories are lower bounds. Objects
+   * referenced more than once, such as an operation shared by several
+   * vertices, an expression node shared by several parameters or the
+   * circuit of a box used several times, are counted once. Circuits of boxes
+   * are only counted if they have already been generated.
+   *
+   * O(V + E + size of the parameters), plus the same for the circuits of
+   * boxes
+   */
+  MemoryUsage memory_usage() const;
+
   unsigned count_gates(const OpType &op_type) const;
   VertexSet get_gates_of_type(const OpType &op_type) const;
 
@@ -1051,6 +1230,17 @@ class Circuit {
   // returns slices of parallel actions from the end to the front
   SliceVec get_reverse_slices() const;
 
+  /**
+   * The slices of \ref get_slices, computed from the layer of each vertex
+   *
+   * The layers are computed on a \ref CompactDAG snapshot, in parallel for
+   * large circuits. The vertices within each slice are in a topological
+   * order of the DAG rather than ordered by unit.
+   *
+   * O(V + E)
+   */
+  SliceVec get_slices_by_layer() const;
+
   // starts at input edge and follows qubit path, returns first edge on path
   // with non single qubit target (or Output) O(D + alpha)
   Edge skip_irrelevant_edges(Edge current) const;
@@ -1103,6 +1293,25 @@ class Circuit {
   std::map<Vertex, unsigned> vertex_rev_depth_map() const;
   std::map<Edge, UnitID> edge_unit_map() const;
 
+  /**
+   * As \ref vertex_unit_map, but stored densely.
+   *
+   * This method is "morally" const, but it sets the vertex indices in the DAG.
+   */
+  VertexArray<unit_set_t> vertex_unit_array() /*const*/;
+  /**
+   * As \ref vertex_depth_map, but stored densely.
+   *
+   * This method is "morally" const, but it sets the vertex indices in the DAG.
+   */
+  VertexArray<unsigned> vertex_depth_array() /*const*/;
+  /**
+   * As \ref vertex_rev_depth_map, but stored densely.
+   *
+   * This method is "morally" const, but it sets the vertex indices in the DAG.
+   */
+  VertexArray<unsigned> vertex_rev_depth_array() /*const*/;
+
   Circuit subcircuit(const Subcircuit &sc) const;
 
   // returns qubit path via vertices & inhabited port in vertices
@@ -1113,6 +1322,19 @@ class Circuit {
   // returns a basic qubit path consisting of just vertices
   VertexVec qubit_path_vertices(const Qubit &qubit) const;
 
+  /**
+   * Index of the path of every unit through the DAG
+   *
+   * Built on first use and kept until the DAG or boundary changes, so
+   * repeated queries of the paths of an unchanged circuit do not walk its
+   * wires again. \ref unit_path, \ref all_qubit_paths,
+   * \ref all_unit_paths and \ref qubit_path_vertices read from the index
+   * whenever it is current.
+   *
+   * O(V + E) if the index needs building, O(1) otherwise
+   */
+  std::shared_ptr<const UnitPathIndex> get_unit_path_index() const;
+
   // returns a map from input qubit to output qubit on the same path
   qubit_map_t implicit_qubit_permutation() const;
 
@@ -1147,6 +1369,26 @@ class Circuit {
     return this->circuit_equality(other, {}, false);
   }
 
+  /**
+   * Hash of the structure of the circuit
+   *
+   * Covers the operations, their wiring, the units, the implicit
+   * permutation, the phase and the name, and does not depend on vertex
+   * identities or the order in which the DAG was built, so it is the same in
+   * every run of the same build. Circuits comparing equal with == have equal
+   * hashes, except where numerical parameters (or phases) are within the
+   * equality tolerance of each other but either side of a multiple of 1e-9.
+   * Symbolic parameters are hashed by their string form.
+   *
+   * The hash is the sum of a term for each vertex and a term for the other
+   * attributes. O(V log V).
+   */
+  std::size_t structural_hash() const;
+
+  friend std::size_t hash_value(const Circuit &circ) {
+    return circ.structural_hash();
+  }
+
   /** @brief Checks causal ordering of vertices
    *
    * @param target the target vertex
@@ -1161,6 +1403,10 @@ class Circuit {
       const Vertex &target, const Vertex &from, bool forward,
       const std::map<Vertex, unsigned> &v_to_depth,
       const std::map<Vertex, unit_set_t> &v_to_units, bool strict = true) const;
+  bool in_causal_order(
+      const Vertex &target, const Vertex &from, bool forward,
+      const VertexArray<unsigned> &v_to_depth,
+      const VertexArray<unit_set_t> &v_to_units, bool strict = true) const;
 
   //___________________________________________________
 
@@ -1187,6 +1433,21 @@ class Circuit {
 
   // O(E+V+q) -- E,V,q of c2
   void append(const Circuit &c2);
+  /**
+   * Append a circuit, taking over its vertices and edges
+   *
+   * The DAG of \p c2 is moved into this circuit without copying any
+   * vertex, which makes this O(q) rather than O(E+V+q). \p c2 is left
+   * empty, unless an exception is thrown, in which case neither circuit is
+   * changed.
+   *
+   * @param c2 circuit to append
+   *
+   * @throw Unsupported if a register has different types in the circuits
+   * @throw CircuitInvalidity if an input qubit of \p c2 would follow a
+   *   discarded qubit, or the op groups of the circuits are incompatible
+   */
+  void append(Circuit &&c2);
   // TODO:: Register-specific appending, probably be defining a register
   // renaming method
   void append_with_map(const Circuit &c2, const unit_map_t &qm);
@@ -1226,6 +1487,30 @@ class Circuit {
       VertexDeletion vertex_deletion = VertexDeletion::Yes,
       OpGroupTransfer opgroup_transfer = OpGroupTransfer::Disallow);
 
+  /**
+   * Replace many disjoint subcircuits, each with a new circuit.
+   *
+   * Equivalent to substituting each replacement in turn, but the new
+   * vertices are spliced directly onto the surrounding edges, in one pass
+   * over the DAG. Subcircuits may be adjacent: an edge may be in an out-hole
+   * of one subcircuit and an in-hole of another, as happens when each of a
+   * sequence of vertices is replaced separately. Boolean edges in
+   * \p b_future that lead into another subcircuit are dropped, as they would
+   * be by sequential substitution.
+   *
+   * @param replacements subcircuits with the circuits to replace them by
+   * @param vertex_deletion whether to delete replaced vertices from the DAG
+   * @param opgroup_transfer how to treat op groups in the inserted circuits
+   *
+   * @throw CircuitInvalidity if the subcircuits share vertices or hole
+   *        edges, or a hole does not match its circuit
+   * @throw SimpleOnly if an inserted circuit is not simple
+   */
+  void substitute_disjoint(
+      const std::vector<std::pair<Subcircuit, const Circuit *>> &replacements,
+      VertexDeletion vertex_deletion = VertexDeletion::Yes,
+      OpGroupTransfer opgroup_transfer = OpGroupTransfer::Disallow);
+
   /**
    * Replace a vertex with a new circuit
    *
@@ -1285,6 +1570,29 @@ class Circuit {
 
   Circuit transpose() const;
 
+  /**
+   * Replace the circuit by its Hermitian conjugate (its inverse), without
+   * copying it.
+   *
+   * The edges of the DAG are reversed, the inputs and outputs of each unit
+   * exchanged and each operation replaced by its dagger. The name and op
+   * groups of the circuit are kept.
+   *
+   * @throw CircuitInvalidity if an operation cannot be daggered, in which
+   *  case the circuit is unchanged
+   */
+  void dagger_in_place();
+
+  /**
+   * Replace the circuit by its transpose, without copying it.
+   *
+   * As \ref dagger_in_place but replacing each operation by its transpose.
+   *
+   * @throw CircuitInvalidity if an operation cannot be transposed, in which
+   *  case the circuit is unchanged
+   */
+  void transpose_in_place();
+
   /**
    * Subsitute all vertices matching the given op with the given circuit
    *
@@ -1392,6 +1700,11 @@ class Circuit {
   /**
    * Recursively apply \ref decompose_boxes
    *
+   * Each distinct box is expanded and flattened once, and all the boxes of
+   * the circuit are then spliced in together. The distinct boxes at each
+   * level of nesting are expanded in parallel, as are the flattenings of
+   * those whose contents are already flattened (see \ref set_max_threads).
+   *
    * @post no \ref Box operations remain
    */
   void decompose_boxes_recursively();
@@ -1418,8 +1731,19 @@ class Circuit {
   // output stream overload
   friend std::ostream &operator<<(std::ostream &out, const Circuit &circ);
 
-  std::string to_latex_str() const;
-  void to_latex_file(const std::string &filename) const;
+  /**
+   * Write a quantikz LaTeX drawing of the circuit to a stream.
+   *
+   * The document is written as it is produced, a wire at a time, rather than
+   * built up as a string.
+   *
+   * @param out stream to write to
+   * @param options drawing options
+   */
+  void to_latex(std::ostream &out, const LatexOptions &options = {}) const;
+  std::string to_latex_str(const LatexOptions &options = {}) const;
+  void to_latex_file(
+      const std::string &filename, const LatexOptions &options = {}) const;
 
   void extract_slice_segment(unsigned slice_one, unsigned slice_two);
 
@@ -1436,6 +1760,115 @@ class Circuit {
    */
   std::vector<Command> get_commands() const;
 
+  /**
+   * Counter incremented by every structural change to the DAG.
+   *
+   * All changes made through the methods of this class (adding or removing
+   * vertices and edges, copying, substitution) are counted. Changes made by
+   * calling Boost functions on \ref dag directly are not: call
+   * \ref notify_dag_changed after making them.
+   *
+   * It is used to decide when cached traversals of the circuit (the results
+   * of \ref get_slices and \ref get_commands) need to be recomputed.
+   */
+  unsigned long get_dag_version() const { return dag_version_; }
+
+  /**
+   * Counter incremented whenever an operation is replaced in place, using
+   * \ref set_vertex_Op_ptr.
+   *
+   * Together with \ref get_dag_version this decides when cached depth metrics
+   * need to be recomputed.
+   */
+  unsigned long get_op_version() const { return op_version_; }
+
+  /**
+   * Record a change to the DAG made outside the Circuit methods.
+   *
+   * This should be called after modifying the structure of \ref dag or the
+   * vertex properties directly.
+   */
+  void notify_dag_changed() {
+    ++dag_version_;
+    ++op_version_;
+    log_change(Change::Kind::Rebuilt, Vertex());
+  }
+
+  /**
+   * Snapshot identifying a state of the circuit, for caching results computed
+   * from it.
+   *
+   * It combines \ref get_dag_version, \ref get_op_version and the boundary.
+   * A version is only meaningful for the Circuit it was taken from; the global
+   * phase and name are not covered.
+   */
+  struct Version {
+    unsigned long dag_version;
+    unsigned long op_version;
+    boundary_t boundary;
+  };
+
+  Version get_version() const { return {dag_version_, op_version_, boundary}; }
+
+  /**
+   * Whether the circuit is unchanged since \p version was taken from it.
+   */
+  bool has_version(const Version &version) const {
+    return version.dag_version == dag_version_ &&
+           version.op_version == op_version_ && version.boundary == boundary;
+  }
+
+  /**
+   * Changes made to a circuit since a checkpoint, as recorded by
+   * \ref record_changes.
+   */
+  struct ChangeLog {
+    /** Vertices added since the checkpoint and still in the DAG */
+    VertexSet added;
+    /** Operations, as at the checkpoint, of the vertices since removed */
+    std::vector<Op_ptr> removed;
+    /** Vertices whose operation has been replaced, with the old operation */
+    std::map<Vertex, Op_ptr> replaced;
+    /** Vertices present at the checkpoint whose edges have changed */
+    VertexSet rewired;
+    /**
+     * Whether the whole DAG was replaced or changed outside the Circuit
+     * methods, in which case the other fields are incomplete
+     */
+    bool rebuilt = false;
+
+    bool empty() const {
+      return added.empty() && removed.empty() && replaced.empty() &&
+             rewired.empty() && !rebuilt;
+    }
+  };
+
+  /**
+   * Start or stop recording changes to the DAG.
+   *
+   * While recording, every vertex added or removed, operation replaced and
+   * edge added or removed through the methods of this class is appended to
+   * a log, from which \ref get_changes_since summarises the changes since a
+   * checkpoint. Starting clears the log. Copies of the circuit do not record.
+   */
+  void record_changes(bool enable);
+
+  bool is_recording_changes() const { return changes_.has_value(); }
+
+  /** Checkpoint to pass to \ref get_changes_since (0 if not recording) */
+  std::size_t get_change_checkpoint() const {
+    return changes_ ? changes_->size() : 0;
+  }
+
+  /**
+   * Summary of the changes recorded since a checkpoint.
+   *
+   * Takes time linear in the number of changes recorded since then.
+   *
+   * @throw CircuitInvalidity if changes are not being recorded
+   */
+  ChangeLog get_changes_since(std::size_t checkpoint) const;
+
   /**
    * Set the vertex indices in the DAG.
    *
@@ -1504,6 +1937,26 @@ class Circuit {
    */
   std::map<Bit, bool> classical_eval(const std::map<Bit, bool> &values) const;
 
+  /**
+   * Evaluate a classical circuit on many assignments of its inputs at once.
+   *
+   * Each bit is given a vector of words, all of the same length; bit k of
+   * word w holds the value of the bit in assignment 64 * w + k. Every
+   * operation is applied to 64 assignments at a time, through
+   * \ref ClassicalOp::eval_packed, and runs of words are evaluated in
+   * parallel.
+   *
+   * The circuit may have any classical operations. Bits of the circuit not
+   * in the input map start at 0 in every assignment.
+   *
+   * @param values input values, as a vector of words for each bit
+   * @return output values of every bit of the input map or the circuit
+   * @throw std::invalid_argument if the vectors differ in length
+   * @throw CircuitInvalidity if the circuit has a non-classical operation
+   */
+  std::map<Bit, std::vector<std::uint64_t>> classical_eval_packed(
+      const std::map<Bit, std::vector<std::uint64_t>> &values) const;
+
   /* class members */
   // currently public (no bueno)
   DAG dag; /** Representation as directed graph */
@@ -1526,10 +1979,147 @@ class Circuit {
 
   /** Signature associated with each named operation group */
   std::map<std::string, op_signature_t> opgroupsigs;
+
+  /** Incremented on every structural change to the DAG */
+  unsigned long dag_version_ = 0;
+
+  /** Incremented on every in-place change of a vertex's operation */
+  unsigned long op_version_ = 0;
+
+  /**
+   * Traversals of the circuit computed for a given DAG version and boundary.
+   *
+   * Operations may be changed in place without a change of version, so the
+   * cached commands are refreshed from the DAG before being returned.
+   */
+  struct TraversalCache {
+    unsigned long version = 0;
+    boundary_t boundary;
+    std::optional<SliceVec> slices;
+    std::optional<std::vector<Command>> commands;
+    std::shared_ptr<const UnitPathIndex> unit_paths;
+  };
+  mutable TraversalCache traversal_cache_;
+
+  /**
+   * Depth metrics computed for a given DAG and operation version.
+   *
+   * The layers used by \ref depth are kept for every vertex, so that
+   * appending an operation at the end of the circuit updates them in
+   * O(arity) instead of invalidating them.
+   */
+  struct DepthCache {
+    unsigned long version = 0;
+    unsigned long op_version = 0;
+    std::optional<std::unordered_map<Vertex, unsigned>> layers;
+    unsigned depth = 0;
+    std::map<OpType, unsigned> by_type;
+    std::map<std::set<OpType>, unsigned> by_types;
+  };
+  mutable DepthCache depth_cache_;
+
+  /** A change to the DAG, as recorded by \ref record_changes */
+  struct Change {
+    enum class Kind { Added, Removed, Replaced, Rewired, Rebuilt };
+    Kind kind;
+    Vertex vertex;
+    /** Operation removed or replaced */
+    Op_ptr op;
+  };
+
+  /** Changes recorded since recording started, if recording */
+  std::optional<std::vector<Change>> changes_;
+
+  /**
+   * Check and merge the op groups of a circuit about to be inserted
+   *
+   * @throw CircuitInvalidity if \p opgroup_transfer forbids the op groups
+   */
+  void transfer_opgroups(const Circuit &c2, OpGroupTransfer opgroup_transfer);
+
+  /**
+   * Whether every unit's input vertex is an initial vertex of the DAG and its
+   * output vertex a final one
+   */
+  bool boundary_is_valid() const;
+
+  void log_change(Change::Kind kind, const Vertex &v, Op_ptr op = nullptr) {
+    if (changes_) changes_->push_back({kind, v, std::move(op)});
+  }
+
+  /**
+   * Counts of operation types for a given DAG and operation version.
+   *
+   * Adding, removing or replacing a single vertex updates the counts and
+   * moves them to the new version, if they were current.
+   */
+  struct OpCountCache {
+    unsigned long version = 0;
+    unsigned long op_version = 0;
+    std::optional<OpTypeCounts> counts;
+  };
+  mutable OpCountCache op_count_cache_;
+
+  bool op_counts_current() const {
+    return op_count_cache_.counts && op_count_cache_.version == dag_version_ &&
+           op_count_cache_.op_version == op_version_;
+  }
+
+  /**
+   * Count an operation added (\p delta = 1) or removed (\p delta = -1) in
+   * the cached counts, which must be present, and move them to the current
+   * version.
+   */
+  void update_op_counts(const Op_ptr &op, int delta) const;
+
+  /** Guards the traversal, depth and operation count caches */
+  mutable std::mutex cache_mutex_;
+
+  /**
+   * Discard cached traversals if the DAG or boundary has changed.
+   *
+   * Must be called with \ref cache_mutex_ held.
+   */
+  void refresh_traversal_cache() const;
+
+  /** The cached \ref UnitPathIndex if it is current, or null */
+  std::shared_ptr<const UnitPathIndex> current_unit_path_index() const;
+
+  /**
+   * Discard cached depth metrics if the DAG or operations have changed.
+   *
+   * Must be called with \ref cache_mutex_ held.
+   */
+  void refresh_depth_cache() const;
+
+  /**
+   * Update the cached depth layers after a vertex has been wired in.
+   *
+   * @param new_vert vertex that has been added
+   * @param preds source vertices of all its in-edges
+   * @param append whether \p new_vert was isolated and has been placed
+   *   immediately before final vertices only
+   * @param was_current whether the cache was current before the change
+   */
+  void update_depth_cache(
+      const Vertex &new_vert, const VertexVec &preds, bool append,
+      bool was_current);
+
+  /** Objects already counted by \ref memory_usage */
+  struct MemoryUsageState;
+
+  /** As \ref memory_usage, skipping and recording counted objects */
+  MemoryUsage memory_usage(MemoryUsageState &state) const;
 };
 
 JSON_DECL(Circuit)
 
+/**
+ * Hash of an operation, consistent with Op::operator== and the same in every
+ * run of the same build, as used by \ref Circuit::structural_hash
+ */
+std::size_t op_hash(const Op_ptr &op);
+
 /** Templated method definitions */
 
 template <typename UnitA, typename UnitB>
@@ -0,0 +1,498 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CircuitBinary.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+
+#include "OpType/OpTypeFunctions.hpp"
+#include "Utils/Json.hpp"
+
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tket {
+
+static const char magic[4] = {'T', 'K', 'C', 'B'};
+
+// Tags of parameter encodings
+static const char param_double = 0;
+static const char param_string = 1;
+
+// Kinds of operation definitions
+static const unsigned op_gate = 0;
+static const unsigned op_json = 1;
+
+static void append_varint(std::string &s, std::size_t value) {
+  while (value >= 0x80) {
+    s.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  s.push_back(static_cast<char>(value));
+}
+
+// Whether the operation is stored by type, size and parameters alone
+static bool is_plain_gate(OpType type) {
+  return is_gate_type(type) && !is_metaop_type(type) && !is_box_type(type) &&
+         !is_classical_type(type) && type != OpType::Conditional;
+}
+
+// The bytes defining a parameter in the pool
+static std::string encode_param(const Expr &param) {
+  std::string encoded;
+  ExprPtr e = param;
+  if (SymEngine::is_a<SymEngine::RealDouble>(*e)) {
+    double x = SymEngine::down_cast<const SymEngine::RealDouble &>(*e).i;
+    std::uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    encoded.push_back(param_double);
+    for (unsigned k = 0; k < 8; ++k) {
+      encoded.push_back(static_cast<char>((bits >> (8 * k)) & 0xff));
+    }
+  } else {
+    std::string str = e->__str__();
+    encoded.push_back(param_string);
+    append_varint(encoded, str.size());
+    encoded += str;
+  }
+  return encoded;
+}
+
+CircuitBinaryWriter::CircuitBinaryWriter(
+    std::ostream &out, const qubit_vector_t &qubits, const bit_vector_t &bits,
+    const Expr &phase, const std::optional<std::string> &name,
+    const qubit_map_t &implicit_permutation)
+    : out_(out) {
+  out_.write(magic, sizeof(magic));
+  write_varint(circuit_binary_version);
+  if (name) {
+    write_varint(1);
+    write_string(*name);
+  } else {
+    write_varint(0);
+  }
+  write_param_ref(encode_param(phase));
+  write_varint(qubits.size());
+  for (const Qubit &qb : qubits) {
+    qubit_index_.insert({qb, qubit_index_.size()});
+    write_unit(qb);
+  }
+  write_varint(bits.size());
+  for (const Bit &b : bits) {
+    bit_index_.insert({b, bit_index_.size()});
+    write_unit(b);
+  }
+  write_varint(implicit_permutation.size());
+  for (const std::pair<const Qubit, Qubit> &pair : implicit_permutation) {
+    write_varint(qubit_index_.at(pair.first));
+    write_varint(qubit_index_.at(pair.second));
+  }
+}
+
+void CircuitBinaryWriter::write_varint(std::size_t value) {
+  while (value >= 0x80) {
+    out_.put(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out_.put(static_cast<char>(value));
+}
+
+void CircuitBinaryWriter::write_string(const std::string &s) {
+  write_varint(s.size());
+  out_.write(s.data(), s.size());
+}
+
+void CircuitBinaryWriter::write_string_ref(const std::string &s) {
+  std::map<std::string, unsigned>::iterator found = strings_.find(s);
+  if (found != strings_.end()) {
+    write_varint(found->second);
+    return;
+  }
+  unsigned index = strings_.size();
+  strings_.insert({s, index});
+  write_varint(index);
+  write_string(s);
+}
+
+void CircuitBinaryWriter::write_unit(const UnitID &unit) {
+  write_string_ref(unit.reg_name());
+  std::vector<unsigned> index = unit.index();
+  write_varint(index.size());
+  for (unsigned i : index) write_varint(i);
+}
+
+void CircuitBinaryWriter::write_optype_ref(OpType type) {
+  std::map<OpType, unsigned>::iterator found = optypes_.find(type);
+  if (found != optypes_.end()) {
+    write_varint(found->second);
+    return;
+  }
+  unsigned index = optypes_.size();
+  optypes_.insert({type, index});
+  write_varint(index);
+  write_string(optypeinfo(type).name);
+}
+
+void CircuitBinaryWriter::write_param_ref(const std::string &encoded) {
+  std::map<std::string, unsigned>::iterator found = params_.find(encoded);
+  if (found != params_.end()) {
+    write_varint(found->second);
+    return;
+  }
+  unsigned index = params_.size();
+  params_.insert({encoded, index});
+  write_varint(index);
+  out_.write(encoded.data(), encoded.size());
+}
+
+void CircuitBinaryWriter::write_command(
+    const Op_ptr &op, const unit_vector_t &args,
+    const std::optional<std::string> &opgroup) {
+  if (finished_) {
+    throw CircuitBinaryError("Cannot write a command after the end marker");
+  }
+  OpType type = op->get_type();
+  op_signature_t sig = op->get_signature();
+  if (sig.size() != args.size()) {
+    throw CircuitBinaryError(
+        "Wrong number of arguments for " + op->get_name());
+  }
+  std::vector<unsigned> arg_indices;
+  for (unsigned i = 0; i < args.size(); ++i) {
+    const std::map<UnitID, unsigned> &units =
+        (sig[i] == EdgeType::Quantum) ? qubit_index_ : bit_index_;
+    std::map<UnitID, unsigned>::const_iterator found = units.find(args[i]);
+    if (found == units.end()) {
+      throw CircuitBinaryError(
+          "Unit " + args[i].repr() + " is not in the circuit header");
+    }
+    arg_indices.push_back(found->second);
+  }
+  // The record is 0 for the end marker, and otherwise one more than twice
+  // the operation index, plus one if an opgroup follows.
+  unsigned has_opgroup = opgroup ? 1 : 0;
+  if (is_plain_gate(type)) {
+    unsigned n_qubits = 0;
+    for (EdgeType e : sig) {
+      if (e == EdgeType::Quantum) ++n_qubits;
+    }
+    std::vector<std::string> params;
+    for (const Expr &param : op->get_params()) {
+      params.push_back(encode_param(param));
+    }
+    std::tuple<OpType, unsigned, std::vector<std::string>> key{
+        type, n_qubits, params};
+    std::map<std::tuple<OpType, unsigned, std::vector<std::string>>,
+             unsigned>::iterator found = gates_.find(key);
+    if (found != gates_.end()) {
+      write_varint(2 * found->second + has_opgroup + 1);
+    } else {
+      gates_.insert({key, n_ops_});
+      write_varint(2 * n_ops_++ + has_opgroup + 1);
+      write_varint(op_gate);
+      write_optype_ref(type);
+      write_varint(n_qubits);
+      write_varint(params.size());
+      for (const std::string &param : params) write_param_ref(param);
+    }
+  } else {
+    nlohmann::json j = op;
+    std::string dump = j.dump();
+    std::map<std::string, unsigned>::iterator found = other_ops_.find(dump);
+    if (found != other_ops_.end()) {
+      write_varint(2 * found->second + has_opgroup + 1);
+    } else {
+      other_ops_.insert({dump, n_ops_});
+      write_varint(2 * n_ops_++ + has_opgroup + 1);
+      write_varint(op_json);
+      write_string(dump);
+    }
+  }
+  if (opgroup) write_string_ref(*opgroup);
+  for (unsigned index : arg_indices) write_varint(index);
+}
+
+void CircuitBinaryWriter::finish() {
+  if (!finished_) write_varint(0);
+  finished_ = true;
+}
+
+void write_circuit_binary(std::ostream &out, const Circuit &circ) {
+  CircuitBinaryWriter writer(
+      out, circ.all_qubits(), circ.all_bits(), circ.get_phase(),
+      circ.get_name(), circ.implicit_qubit_permutation());
+  for (const Command &com : circ) {
+    writer.write_command(
+        com.get_op_ptr(), com.get_args(), com.get_opgroup());
+  }
+  writer.finish();
+}
+
+void write_circuit_binary_file(
+    const std::string &filename, const Circuit &circ) {
+  std::ofstream file(filename, std::ios::binary);
+  if (!file) {
+    throw CircuitBinaryError("Cannot open " + filename + " for writing");
+  }
+  write_circuit_binary(file, circ);
+}
+
+namespace {
+
+// Decodes a binary circuit in place
+class CircuitBinaryReader {
+ public:
+  CircuitBinaryReader(const char *data, std::size_t size)
+      : pos_(data), end_(data + size) {}
+
+  Circuit read() {
+    if (static_cast<std::size_t>(end_ - pos_) < sizeof(magic) ||
+        std::memcmp(pos_, magic, sizeof(magic)) != 0) {
+      throw CircuitBinaryError("Not a binary circuit");
+    }
+    pos_ += sizeof(magic);
+    std::size_t version = read_varint();
+    if (version == 0 || version > circuit_binary_version) {
+      throw CircuitBinaryError(
+          "Unsupported binary circuit version " + std::to_string(version));
+    }
+    Circuit circ;
+    if (read_varint() != 0) circ.set_name(std::string(read_string()));
+    circ.add_phase(read_param_ref());
+    std::size_t n_qubits = read_varint();
+    for (std::size_t i = 0; i < n_qubits; ++i) {
+      std::pair<std::string, std::vector<unsigned>> unit = read_unit();
+      qubits_.push_back(Qubit(unit.first, unit.second));
+      circ.add_qubit(qubits_.back());
+    }
+    std::size_t n_bits = read_varint();
+    for (std::size_t i = 0; i < n_bits; ++i) {
+      std::pair<std::string, std::vector<unsigned>> unit = read_unit();
+      bits_.push_back(Bit(unit.first, unit.second));
+      circ.add_bit(bits_.back());
+    }
+    qubit_map_t implicit_permutation;
+    std::size_t n_perm = read_varint();
+    for (std::size_t i = 0; i < n_perm; ++i) {
+      const Qubit &in = qubits_.at(read_index(n_qubits));
+      const Qubit &out = qubits_.at(read_index(n_qubits));
+      implicit_permutation.insert({in, out});
+    }
+    unit_vector_t args;
+    for (std::size_t record = read_varint(); record != 0;
+         record = read_varint()) {
+      const Op_ptr &op = read_op((record - 1) / 2);
+      std::optional<std::string> opgroup;
+      if ((record - 1) % 2 != 0) opgroup = read_string_ref();
+      op_signature_t sig = op->get_signature();
+      args.clear();
+      for (EdgeType e : sig) {
+        if (e == EdgeType::Quantum) {
+          args.push_back(qubits_[read_index(qubits_.size())]);
+        } else {
+          args.push_back(bits_[read_index(bits_.size())]);
+        }
+      }
+      circ.add_op(op, args, opgroup);
+    }
+    circ.permute_boundary_output(implicit_permutation);
+    return circ;
+  }
+
+ private:
+  const char *pos_;
+  const char *end_;
+  qubit_vector_t qubits_;
+  bit_vector_t bits_;
+  std::vector<std::string_view> strings_;
+  std::vector<OpType> optypes_;
+  std::vector<Expr> params_;
+  std::vector<Op_ptr> ops_;
+
+  void require(std::size_t n) const {
+    if (static_cast<std::size_t>(end_ - pos_) < n) {
+      throw CircuitBinaryError("Binary circuit is truncated");
+    }
+  }
+
+  std::size_t read_varint() {
+    std::size_t value = 0;
+    for (unsigned shift = 0;; shift += 7) {
+      require(1);
+      if (shift >= 8 * sizeof(std::size_t)) {
+        throw CircuitBinaryError("Varint too long in binary circuit");
+      }
+      unsigned char byte = static_cast<unsigned char>(*pos_++);
+      value |= static_cast<std::size_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) return value;
+    }
+  }
+
+  std::size_t read_index(std::size_t size) {
+    std::size_t index = read_varint();
+    if (index >= size) {
+      throw CircuitBinaryError("Index out of range in binary circuit");
+    }
+    return index;
+  }
+
+  // Index of a table entry, or the table size if a new entry follows
+  std::size_t read_ref(std::size_t table_size) {
+    return read_index(table_size + 1);
+  }
+
+  std::string_view read_string() {
+    std::size_t size = read_varint();
+    require(size);
+    std::string_view s(pos_, size);
+    pos_ += size;
+    return s;
+  }
+
+  std::string_view read_string_ref() {
+    std::size_t index = read_ref(strings_.size());
+    if (index == strings_.size()) strings_.push_back(read_string());
+    return strings_[index];
+  }
+
+  std::pair<std::string, std::vector<unsigned>> read_unit() {
+    std::string name(read_string_ref());
+    std::vector<unsigned> index(read_varint());
+    for (unsigned &i : index) i = read_varint();
+    return {name, index};
+  }
+
+  OpType read_optype_ref() {
+    std::size_t index = read_ref(optypes_.size());
+    if (index == optypes_.size()) {
+      nlohmann::json name = std::string(read_string());
+      try {
+        optypes_.push_back(name.get<OpType>());
+      } catch (const JsonError &e) {
+        throw CircuitBinaryError(e.what());
+      }
+    }
+    return optypes_[index];
+  }
+
+  const Expr &read_param_ref() {
+    std::size_t index = read_ref(params_.size());
+    if (index == params_.size()) {
+      require(1);
+      char tag = *pos_++;
+      if (tag == param_double) {
+        require(8);
+        std::uint64_t bits = 0;
+        for (unsigned k = 0; k < 8; ++k) {
+          bits |= static_cast<std::uint64_t>(
+                      static_cast<unsigned char>(pos_[k]))
+                  << (8 * k);
+        }
+        pos_ += 8;
+        double x;
+        std::memcpy(&x, &bits, sizeof(x));
+        params_.push_back(Expr(x));
+      } else if (tag == param_string) {
+        params_.push_back(Expr(std::string(read_string())));
+      } else {
+        throw CircuitBinaryError("Unknown parameter encoding");
+      }
+    }
+    return params_[index];
+  }
+
+  const Op_ptr &read_op(std::size_t index) {
+    if (index > ops_.size()) {
+      throw CircuitBinaryError("Index out of range in binary circuit");
+    }
+    if (index < ops_.size()) return ops_[index];
+    std::size_t kind = read_varint();
+    if (kind == op_gate) {
+      OpType type = read_optype_ref();
+      if (!is_plain_gate(type)) {
+        throw CircuitBinaryError(
+            "Operation " + optypeinfo(type).name +
+            " is not stored as a gate");
+      }
+      unsigned n_qubits = read_varint();
+      std::vector<Expr> params(read_varint());
+      for (Expr &param : params) param = read_param_ref();
+      ops_.push_back(get_op_ptr(type, params, n_qubits));
+    } else if (kind == op_json) {
+      std::string_view dump = read_string();
+      nlohmann::json j = nlohmann::json::parse(dump.begin(), dump.end());
+      ops_.push_back(j.get<Op_ptr>());
+    } else {
+      throw CircuitBinaryError("Unknown operation encoding");
+    }
+    return ops_.back();
+  }
+};
+
+}  // namespace
+
+Circuit read_circuit_binary(const char *data, std::size_t size) {
+  CircuitBinaryReader reader(data, size);
+  return reader.read();
+}
+
+Circuit read_circuit_binary(std::istream &in) {
+  std::string data(
+      (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  return read_circuit_binary(data.data(), data.size());
+}
+
+Circuit read_circuit_binary_file(const std::string &filename) {
+#if !defined(_MSC_VER)
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw CircuitBinaryError("Cannot open " + filename + " for reading");
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    throw CircuitBinaryError("Cannot read " + filename);
+  }
+  std::size_t size = st.st_size;
+  void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    throw CircuitBinaryError("Cannot map " + filename);
+  }
+  try {
+    Circuit circ = read_circuit_binary(static_cast<const char *>(data), size);
+    munmap(data, size);
+    return circ;
+  } catch (...) {
+    munmap(data, size);
+    throw;
+  }
+#else
+  std::ifstream file(filename, std::ios::binary);
+  if (!file) {
+    throw CircuitBinaryError("Cannot open " + filename + " for reading");
+  }
+  return read_circuit_binary(file);
+#endif
+}
+
+}  // namespace tket
@@ -0,0 +1,151 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Compact binary serialisation of circuits
+ *
+ * A binary circuit is the magic string "TKCB" and a format version, followed
+ * by a header and a sequence of commands. All integers are unsigned LEB128
+ * varints.
+ *
+ * The header holds the optional name, the global phase, the qubits and bits,
+ * and the implicit qubit permutation (as pairs of qubit indices).
+ *
+ * Each command refers to its operation by an index into an operation table,
+ * with a flag for whether an opgroup follows, and then has one varint per
+ * argument, indexing the qubits or bits according to the edge type of the
+ * operation's signature. A zero marks the end of the commands.
+ * Gates are stored as an index into an OpType table, a number of qubits and
+ * indices into a parameter pool; other operations are stored as JSON.
+ * Register names and opgroups are indices into a string table. The string
+ * table, OpType table, parameter pool and operation table are all written
+ * inline: an index one past the end of a table is followed by the definition
+ * of a new entry. So a circuit can be written command by command, and a
+ * reader sees every table entry before its first use.
+ *
+ * Parameters that are floating-point numbers are stored as 8 bytes; other
+ * expressions are stored as strings.
+ */
+
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "Circuit.hpp"
+
+namespace tket {
+
+class CircuitBinaryError : public std::logic_error {
+ public:
+  explicit CircuitBinaryError(const std::string &message)
+      : std::logic_error(message) {}
+};
+
+/** Version of the binary circuit format written */
+constexpr unsigned circuit_binary_version = 1;
+
+/**
+ * Writes a binary circuit to a stream, one command at a time
+ */
+class CircuitBinaryWriter {
+ public:
+  /**
+   * Write the header of a circuit
+   *
+   * @param out stream to write to
+   * @param qubits all qubits of the circuit
+   * @param bits all bits of the circuit
+   * @param phase global phase
+   * @param name name of the circuit, if any
+   * @param implicit_permutation implicit qubit permutation; qubits not in the
+   *   map are not permuted
+   */
+  CircuitBinaryWriter(
+      std::ostream &out, const qubit_vector_t &qubits,
+      const bit_vector_t &bits, const Expr &phase = 0,
+      const std::optional<std::string> &name = std::nullopt,
+      const qubit_map_t &implicit_permutation = {});
+
+  /**
+   * Write a command
+   *
+   * @param op operation
+   * @param args qubits and bits, all of them in the header
+   * @param opgroup name of associated operation group, if any
+   */
+  void write_command(
+      const Op_ptr &op, const unit_vector_t &args,
+      const std::optional<std::string> &opgroup = std::nullopt);
+
+  /** Write the end marker. No more commands may be written. */
+  void finish();
+
+ private:
+  std::ostream &out_;
+  std::map<UnitID, unsigned> qubit_index_;
+  std::map<UnitID, unsigned> bit_index_;
+  std::map<std::string, unsigned> strings_;
+  std::map<OpType, unsigned> optypes_;
+  /** Parameters, by their encoding */
+  std::map<std::string, unsigned> params_;
+  /** Gates, by OpType, number of qubits and parameter encodings */
+  std::map<std::tuple<OpType, unsigned, std::vector<std::string>>, unsigned>
+      gates_;
+  /** Other operations, by their JSON */
+  std::map<std::string, unsigned> other_ops_;
+  unsigned n_ops_ = 0;
+  bool finished_ = false;
+
+  void write_varint(std::size_t value);
+  void write_string(const std::string &s);
+  void write_string_ref(const std::string &s);
+  void write_unit(const UnitID &unit);
+  void write_optype_ref(OpType type);
+  void write_param_ref(const std::string &encoded);
+};
+
+/** Write a circuit in binary form */
+void write_circuit_binary(std::ostream &out, const Circuit &circ);
+
+/** Write a circuit in binary form to a file */
+void write_circuit_binary_file(
+    const std::string &filename, const Circuit &circ);
+
+/**
+ * Read a binary circuit from memory
+ *
+ * Operation types, arguments and table entries are decoded in place, without
+ * copying the buffer, so \p data may be a memory-mapped file.
+ *
+ * @param data start of the binary circuit
+ * @param size number of bytes available
+ *
+ * @throws CircuitBinaryError if the data is truncated or invalid
+ */
+Circuit read_circuit_binary(const char *data, std::size_t size);
+
+/** Read a binary circuit from a stream */
+Circuit read_circuit_binary(std::istream &in);
+
+/** Read a binary circuit from a file, memory-mapped where supported */
+Circuit read_circuit_binary_file(const std::string &filename);
+
+}  // namespace tket
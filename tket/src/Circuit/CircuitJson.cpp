@@ -12,8 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <vector>
+
 #include "Circuit.hpp"
+#include "CommandView.hpp"
 #include "Utils/Json.hpp"
+#include "Utils/Parallel.hpp"
 
 namespace tket {
 
@@ -33,11 +37,14 @@ void to_json(nlohmann::json& j, const Circuit& circ) {
     j["implicit_permutation"] = impl;
   }
   j["commands"] = nlohmann::json::array();
-  for (const Command& com : circ) {
+  for (const CommandView& com : CommandViews(circ)) {
     j["commands"].push_back(com);
   }
 }
 
+// Fewest commands worth decoding in another thread
+static const std::size_t min_commands_range = 512;
+
 void from_json(const nlohmann::json& j, Circuit& circ) {
   circ = Circuit();
 
@@ -54,8 +61,17 @@ void from_json(const nlohmann::json& j, Circuit& circ) {
     circ.add_bit(b);
   }
 
-  for (const auto& j_com : j.at("commands")) {
-    const auto& com = j_com.get<Command>();
+  // Decode the commands in parallel, then add them to the DAG in order.
+  const nlohmann::json& j_coms = j.at("commands");
+  std::vector<Command> coms(j_coms.size());
+  parallel_for(
+      0, coms.size(), min_commands_range,
+      [&j_coms, &coms](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+          coms[i] = j_coms[i].get<Command>();
+        }
+      });
+  for (const Command& com : coms) {
     circ.add_op(com.get_op_ptr(), com.get_args(), com.get_opgroup());
   }
   const auto& imp_perm = j.at("implicit_permutation").get<qubit_map_t>();
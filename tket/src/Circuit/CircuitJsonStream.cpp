@@ -0,0 +1,205 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CircuitJsonStream.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Command.hpp"
+#include "Utils/Json.hpp"
+
+namespace tket {
+
+namespace {
+
+// SAX handler building a circuit. Each top-level field except "commands" is
+// built as a JSON value and then applied; each element of "commands" is
+// built as a JSON value, converted to a command and added to the circuit.
+class CircuitSaxHandler {
+ public:
+  using json = nlohmann::json;
+
+  explicit CircuitSaxHandler(Circuit &circ) : circ_(circ) {}
+
+  bool null() { return put(nullptr); }
+  bool boolean(bool val) { return put(val); }
+  bool number_integer(json::number_integer_t val) { return put(val); }
+  bool number_unsigned(json::number_unsigned_t val) { return put(val); }
+  bool number_float(json::number_float_t val, const json::string_t &) {
+    return put(val);
+  }
+  bool string(json::string_t &val) { return put(std::move(val)); }
+  bool binary(json::binary_t &val) { return put(json::binary(val)); }
+
+  bool start_object(std::size_t) {
+    ++depth_;
+    if (depth_ > 1) {
+      values_.push_back(json::object());
+      keys_.emplace_back();
+    }
+    return true;
+  }
+
+  bool key(json::string_t &val) {
+    if (depth_ == 1) {
+      top_key_ = val;
+    } else {
+      keys_.back() = val;
+    }
+    return true;
+  }
+
+  bool end_object() {
+    --depth_;
+    if (depth_ == 0) return true;
+    json value = pop();
+    if (in_commands_ && values_.empty()) {
+      add_command(value);
+      return true;
+    }
+    return put(std::move(value));
+  }
+
+  bool start_array(std::size_t) {
+    ++depth_;
+    if (depth_ == 1) {
+      throw JsonError("A circuit must be a JSON object");
+    }
+    if (depth_ == 2 && top_key_ == "commands") {
+      in_commands_ = true;
+      return true;
+    }
+    values_.push_back(json::array());
+    keys_.emplace_back();
+    return true;
+  }
+
+  bool end_array() {
+    --depth_;
+    if (in_commands_ && depth_ == 1) {
+      in_commands_ = false;
+      return true;
+    }
+    return put(pop());
+  }
+
+  bool parse_error(
+      std::size_t, const std::string &, const nlohmann::detail::exception &e) {
+    throw JsonError(e.what());
+  }
+
+  const qubit_map_t &implicit_permutation() const { return perm_; }
+
+ private:
+  Circuit &circ_;
+  // Depth of nesting in objects and arrays; the circuit object is at 1
+  unsigned depth_ = 0;
+  std::string top_key_;
+  bool in_commands_ = false;
+  // Values under construction, and the current key of each
+  std::vector<json> values_;
+  std::vector<std::string> keys_;
+  std::set<UnitID> units_;
+  qubit_map_t perm_;
+
+  json pop() {
+    json value = std::move(values_.back());
+    values_.pop_back();
+    keys_.pop_back();
+    return value;
+  }
+
+  // Add a complete value to its parent, or apply it if it is a field
+  bool put(json value) {
+    if (depth_ == 0) {
+      throw JsonError("A circuit must be a JSON object");
+    }
+    if (values_.empty()) {
+      set_field(value);
+    } else if (values_.back().is_array()) {
+      values_.back().push_back(std::move(value));
+    } else {
+      values_.back()[keys_.back()] = std::move(value);
+    }
+    return true;
+  }
+
+  void add_unit(const UnitID &unit) {
+    if (!units_.insert(unit).second) return;
+    if (unit.type() == UnitType::Qubit) {
+      circ_.add_qubit(Qubit(unit));
+    } else {
+      circ_.add_bit(Bit(unit));
+    }
+  }
+
+  void add_command(const json &j) {
+    const Command com = j.get<Command>();
+    const unit_vector_t args = com.get_args();
+    for (const UnitID &arg : args) add_unit(arg);
+    circ_.add_op(com.get_op_ptr(), args, com.get_opgroup());
+  }
+
+  void set_field(const json &value) {
+    if (top_key_ == "name") {
+      circ_.set_name(value.get<std::string>());
+    } else if (top_key_ == "phase") {
+      circ_.add_phase(value.get<Expr>());
+    } else if (top_key_ == "qubits") {
+      for (const Qubit &qb : value.get<qubit_vector_t>()) add_unit(qb);
+    } else if (top_key_ == "bits") {
+      for (const Bit &b : value.get<bit_vector_t>()) add_unit(b);
+    } else if (top_key_ == "implicit_permutation") {
+      perm_ = value.get<qubit_map_t>();
+    } else if (top_key_ == "commands") {
+      throw JsonError("Circuit commands must be an array");
+    }
+  }
+};
+
+}  // namespace
+
+Circuit read_circuit_json(std::istream &in) {
+  Circuit circ;
+  CircuitSaxHandler handler(circ);
+  nlohmann::json::sax_parse(in, &handler);
+  circ.permute_boundary_output(handler.implicit_permutation());
+  return circ;
+}
+
+void write_circuit_json(std::ostream &out, const Circuit &circ) {
+  // Fields in the order nlohmann::json stores them
+  out << "{\"bits\":" << nlohmann::json(circ.all_bits()).dump();
+  out << ",\"commands\":[";
+  bool first = true;
+  for (const Command &com : circ) {
+    if (!first) out << ',';
+    out << nlohmann::json(com).dump();
+    first = false;
+  }
+  out << ']';
+  const qubit_map_t impl = circ.implicit_qubit_permutation();
+  // empty maps are mapped to null instead of empty array
+  out << ",\"implicit_permutation\":"
+      << (impl.empty() ? nlohmann::json::array() : nlohmann::json(impl))
+             .dump();
+  const std::optional<std::string> name = circ.get_name();
+  if (name) out << ",\"name\":" << nlohmann::json(*name).dump();
+  out << ",\"phase\":" << nlohmann::json(circ.get_phase()).dump();
+  out << ",\"qubits\":" << nlohmann::json(circ.all_qubits()).dump() << '}';
+}
+
+}  // namespace tket
@@ -0,0 +1,50 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Reading and writing circuit JSON without a whole-document DOM
+ *
+ * The format is that of to_json and from_json for \ref Circuit. Only one
+ * command is held as a JSON value at a time.
+ */
+
+#include <iostream>
+
+#include "Circuit.hpp"
+
+namespace tket {
+
+/**
+ * Read a circuit from JSON text, adding each command to the circuit as soon
+ * as it has been parsed.
+ *
+ * The top-level fields may come in any order. Qubits and bits used by
+ * commands that come before the "qubits" and "bits" fields are added to the
+ * circuit on first use.
+ *
+ * @throws JsonError if the text is not a valid circuit
+ */
+Circuit read_circuit_json(std::istream &in);
+
+/**
+ * Write a circuit as JSON text, serialising one command at a time.
+ *
+ * The output is the same as dumping the result of to_json.
+ */
+void write_circuit_json(std::ostream &out, const Circuit &circ);
+
+}  // namespace tket
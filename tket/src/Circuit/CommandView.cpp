@@ -0,0 +1,68 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CommandView.hpp"
+
+namespace tket {
+
+const UnitID &CommandView::get_arg(port_t port) const {
+  Edge e = circ_->get_nth_in_edge(vert_, port);
+  if (circ_->get_edgetype(e) == EdgeType::Boolean) {
+    // The bit is the one on the Classical wire the edge branches from
+    e = circ_->get_nth_out_edge(circ_->source(e), circ_->get_source_port(e));
+  }
+  std::optional<UnitPathIndex::Position> pos = index_->position(e);
+  if (!pos) {
+    throw CircuitInvalidity(
+        "Vertex edge not found on any wire. Edge: " +
+        circ_->get_Op_ptr_from_Vertex(circ_->source(e))->get_name() + " -> " +
+        circ_->get_Op_ptr_from_Vertex(circ_->target(e))->get_name());
+  }
+  return index_->units()[pos->unit];
+}
+
+unit_vector_t CommandView::get_args() const {
+  const unsigned n = n_args();
+  unit_vector_t args;
+  args.reserve(n);
+  for (port_t p = 0; p < n; ++p) args.push_back(get_arg(p));
+  return args;
+}
+
+CommandViews::CommandViews(const Circuit &circ)
+    : index_(circ.get_unit_path_index()) {
+  for (const Slice &slice : circ.get_slices()) {
+    for (const Vertex &v : slice) views_.push_back({circ, *index_, v});
+  }
+}
+
+void to_json(nlohmann::json &j, const CommandView &com) {
+  const Op_ptr &op = com.get_op_ptr();
+  j["op"] = op;
+  if (com.get_opgroup()) {
+    j["opgroup"] = com.get_opgroup().value();
+  }
+  const op_signature_t &sig = op->get_signature();
+  nlohmann::json j_args;
+  for (port_t p = 0; p < sig.size(); ++p) {
+    if (sig[p] == EdgeType::Quantum) {
+      j_args.push_back(static_cast<const Qubit &>(com.get_arg(p)));
+    } else {
+      j_args.push_back(static_cast<const Bit &>(com.get_arg(p)));
+    }
+  }
+  j["args"] = j_args;
+}
+
+}  // namespace tket
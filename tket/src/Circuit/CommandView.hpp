@@ -0,0 +1,102 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Circuit.hpp"
+#include "Command.hpp"
+#include "UnitPaths.hpp"
+#include "Utils/Json.hpp"
+
+namespace tket {
+
+/**
+ * Non-owning view of an operation of a circuit as a command.
+ *
+ * A \ref Command copies the operation pointer, arguments and op group out of
+ * the circuit. A view only refers to the vertex, and looks its arguments up
+ * when asked, through the \ref UnitPathIndex of the circuit, so that a loop
+ * over the views of a circuit does not allocate for each operation.
+ *
+ * A view is invalidated by any change to the DAG or boundary of its circuit.
+ */
+class CommandView {
+ public:
+  CommandView(
+      const Circuit &circ, const UnitPathIndex &index, const Vertex &vert)
+      : circ_(&circ), index_(&index), vert_(vert) {}
+
+  Vertex get_vertex() const { return vert_; }
+  const Op_ptr &get_op_ptr() const { return circ_->dag[vert_].op; }
+  const std::optional<std::string> &get_opgroup() const {
+    return circ_->dag[vert_].opgroup;
+  }
+
+  /** Number of arguments, that is, of in-ports of the operation */
+  unsigned n_args() const { return circ_->n_in_edges(vert_); }
+
+  /**
+   * Unit at an in-port of the operation
+   *
+   * A Boolean in-port gives the bit read from.
+   *
+   * @throw CircuitInvalidity if the port is not on any wire
+   */
+  const UnitID &get_arg(port_t port) const;
+
+  /** All arguments, indexed by port, as in \ref Command::get_args */
+  unit_vector_t get_args() const;
+
+  /** Copy of the command */
+  Command to_command() const {
+    return Command(get_op_ptr(), get_args(), get_opgroup(), vert_);
+  }
+
+ private:
+  const Circuit *circ_;
+  const UnitPathIndex *index_;
+  Vertex vert_;
+};
+
+/**
+ * Views of all the commands of a circuit, in the order of
+ * \ref Circuit::get_commands
+ *
+ * Keeps the \ref UnitPathIndex that the views refer to alive.
+ */
+class CommandViews {
+ public:
+  typedef std::vector<CommandView>::const_iterator const_iterator;
+
+  explicit CommandViews(const Circuit &circ);
+
+  const_iterator begin() const { return views_.begin(); }
+  const_iterator end() const { return views_.end(); }
+  std::size_t size() const { return views_.size(); }
+  const CommandView &operator[](std::size_t i) const { return views_[i]; }
+
+ private:
+  std::shared_ptr<const UnitPathIndex> index_;
+  std::vector<CommandView> views_;
+};
+
+/** Same JSON as for the \ref Command the view refers to */
+void to_json(nlohmann::json &j, const CommandView &com);
+
+}  // namespace tket
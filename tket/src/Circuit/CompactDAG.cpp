@@ -0,0 +1,293 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CompactDAG.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <queue>
+
+#include "Utils/GraphHeaders.hpp"
+#include "Utils/Parallel.hpp"
+
+namespace tket {
+
+CompactDAG::CompactDAG(const Circuit &circ) {
+  const DAG &dag = circ.dag;
+  const unsigned n = boost::num_vertices(dag);
+
+  // Provisional numbering, in the order in which the DAG stores vertices
+  VertexVec verts;
+  verts.reserve(n);
+  std::unordered_map<Vertex, unsigned> prov_index;
+  prov_index.reserve(n);
+  BGL_FORALL_VERTICES(v, dag, DAG) {
+    prov_index.insert({v, verts.size()});
+    verts.push_back(v);
+  }
+
+  // Write-after-read dependencies: a vertex overwriting a classical value must
+  // follow every other vertex reading the old value through a Boolean edge
+  std::vector<std::vector<unsigned>> war_succs(n);
+  std::vector<std::vector<unsigned>> war_preds(n);
+  std::vector<unsigned> in_degree(n, 0);
+  for (unsigned i = 0; i < n; ++i) {
+    const Vertex &s = verts[i];
+    in_degree[i] = boost::in_degree(s, dag);
+    for (auto [ei, eend] = boost::out_edges(s, dag); ei != eend; ++ei) {
+      const Edge &e = *ei;
+      if (dag[e].type != EdgeType::Classical) continue;
+      unsigned writer = prov_index.at(boost::target(e, dag));
+      port_t p = dag[e].ports.first;
+      for (auto [bi, bend] = boost::out_edges(s, dag); bi != bend; ++bi) {
+        const Edge &b = *bi;
+        if (dag[b].type != EdgeType::Boolean || dag[b].ports.first != p)
+          continue;
+        unsigned reader = prov_index.at(boost::target(b, dag));
+        if (reader == writer) continue;
+        war_succs[reader].push_back(writer);
+        war_preds[writer].push_back(reader);
+      }
+    }
+  }
+  for (unsigned i = 0; i < n; ++i) in_degree[i] += war_preds[i].size();
+
+  // Topological order (Kahn), breaking ties by provisional index
+  std::vector<unsigned> order;
+  order.reserve(n);
+  std::queue<unsigned> ready;
+  for (unsigned i = 0; i < n; ++i) {
+    if (in_degree[i] == 0) ready.push(i);
+  }
+  while (!ready.empty()) {
+    unsigned i = ready.front();
+    ready.pop();
+    order.push_back(i);
+    for (auto [ei, eend] = boost::out_edges(verts[i], dag); ei != eend;
+         ++ei) {
+      const Edge &e = *ei;
+      unsigned t = prov_index.at(boost::target(e, dag));
+      if (--in_degree[t] == 0) ready.push(t);
+    }
+    for (unsigned t : war_succs[i]) {
+      if (--in_degree[t] == 0) ready.push(t);
+    }
+  }
+  if (order.size() != n) {
+    throw CircuitInvalidity("Circuit DAG contains a cyclic dependency");
+  }
+
+  // Final numbering
+  std::vector<unsigned> new_index(n);
+  for (unsigned k = 0; k < n; ++k) new_index[order[k]] = k;
+  vertices_.reserve(n);
+  ops_.reserve(n);
+  initial_.reserve(n);
+  final_.reserve(n);
+  index_.reserve(n);
+  for (unsigned k = 0; k < n; ++k) {
+    const Vertex &v = verts[order[k]];
+    vertices_.push_back(v);
+    ops_.push_back(dag[v].op);
+    initial_.push_back(circ.detect_initial_Op(v));
+    final_.push_back(circ.detect_final_Op(v));
+    index_.insert({v, k});
+  }
+
+  // Edge arrays
+  const unsigned n_e = boost::num_edges(dag);
+  in_offsets_.reserve(n + 1);
+  out_offsets_.reserve(n + 1);
+  in_edges_.reserve(n_e);
+  out_edges_.reserve(n_e);
+  war_offsets_.reserve(n + 1);
+  for (unsigned k = 0; k < n; ++k) {
+    const Vertex &v = vertices_[k];
+    in_offsets_.push_back(in_edges_.size());
+    for (auto [ei, eend] = boost::in_edges(v, dag); ei != eend; ++ei) {
+      const Edge &e = *ei;
+      in_edges_.push_back(
+          {index_.at(boost::source(e, dag)), k, dag[e].ports.first,
+           dag[e].ports.second, dag[e].type, e});
+    }
+    std::sort(
+        in_edges_.begin() + in_offsets_.back(), in_edges_.end(),
+        [](const EdgeEntry &a, const EdgeEntry &b) {
+          return a.target_port < b.target_port;
+        });
+    out_offsets_.push_back(out_edges_.size());
+    for (auto [ei, eend] = boost::out_edges(v, dag); ei != eend; ++ei) {
+      const Edge &e = *ei;
+      out_edges_.push_back(
+          {k, index_.at(boost::target(e, dag)), dag[e].ports.first,
+           dag[e].ports.second, dag[e].type, e});
+    }
+    std::sort(
+        out_edges_.begin() + out_offsets_.back(), out_edges_.end(),
+        [](const EdgeEntry &a, const EdgeEntry &b) {
+          if (a.source_port != b.source_port) {
+            return a.source_port < b.source_port;
+          }
+          return a.type != EdgeType::Boolean && b.type == EdgeType::Boolean;
+        });
+    war_offsets_.push_back(war_preds_.size());
+    for (unsigned r : war_preds[order[k]]) war_preds_.push_back(new_index[r]);
+  }
+  in_offsets_.push_back(in_edges_.size());
+  out_offsets_.push_back(out_edges_.size());
+  war_offsets_.push_back(war_preds_.size());
+}
+
+unsigned CompactDAG::get_index(const Vertex &v) const {
+  std::unordered_map<Vertex, unsigned>::const_iterator found = index_.find(v);
+  if (found == index_.end()) {
+    throw MissingVertex("Vertex not found in compact DAG");
+  }
+  return found->second;
+}
+
+std::vector<std::optional<unsigned>> CompactDAG::layers() const {
+  return compute_layers(nullptr);
+}
+
+std::vector<std::optional<unsigned>> CompactDAG::layers(
+    const std::function<bool(Op_ptr)> &skip_func) const {
+  return compute_layers(&skip_func);
+}
+
+unsigned CompactDAG::max_layer(
+    const std::function<bool(Op_ptr)> &skip_func) const {
+  unsigned max = 0;
+  for (const std::optional<unsigned> &l : compute_layers(&skip_func)) {
+    if (l && *l > max) max = *l;
+  }
+  return max;
+}
+
+SliceVec CompactDAG::slices() const {
+  SliceVec result;
+  const std::vector<std::optional<unsigned>> ls = layers();
+  for (unsigned i = 0; i < ls.size(); ++i) {
+    if (!ls[i] || *ls[i] == 0) continue;
+    if (*ls[i] > result.size()) result.resize(*ls[i]);
+    result[*ls[i] - 1].push_back(vertices_[i]);
+  }
+  return result;
+}
+
+void CompactDAG::assign_layer(
+    unsigned i, const std::function<bool(Op_ptr)> *skip_func,
+    std::vector<std::optional<unsigned>> &result,
+    std::vector<char> &reached) const {
+  if (initial_[i]) {
+    result[i] = 0;
+    reached[i] = true;
+    return;
+  }
+  const unsigned begin = in_offsets_[i];
+  const unsigned end = in_offsets_[i + 1];
+  if (begin == end) return;
+  unsigned m = 0;
+  for (unsigned k = begin; k < end; ++k) {
+    const unsigned s = in_edges_[k].source;
+    if (!reached[s]) return;
+    if (result[s] && *result[s] > m) m = *result[s];
+  }
+  reached[i] = true;
+  if (final_[i]) return;
+  if (skip_func) {
+    // Slicing with a skip function does not order writes after reads
+    result[i] = (*skip_func)(ops_[i]) ? m : m + 1;
+  } else {
+    for (unsigned k = war_offsets_[i]; k < war_offsets_[i + 1]; ++k) {
+      const std::optional<unsigned> &l = result[war_preds_[k]];
+      if (l && *l > m) m = *l;
+    }
+    result[i] = m + 1;
+  }
+}
+
+std::vector<std::optional<unsigned>> CompactDAG::compute_layers(
+    const std::function<bool(Op_ptr)> *skip_func) const {
+  const unsigned n = n_vertices();
+  std::vector<std::optional<unsigned>> result(n);
+  // Final vertices get no layer but must still propagate reachability
+  std::vector<char> reached(n, false);
+  if (n < parallel_layers_threshold || get_max_threads() == 1) {
+    for (unsigned i = 0; i < n; ++i) {
+      assign_layer(i, skip_func, result, reached);
+    }
+    return result;
+  }
+
+  // Kahn-style wavefront: every vertex of a front has all of its
+  // predecessors (including those it must follow as a write after a read)
+  // in earlier fronts, so the vertices of a front are independent
+  std::vector<unsigned> war_succ_offsets(n + 1, 0);
+  for (unsigned r : war_preds_) ++war_succ_offsets[r + 1];
+  for (unsigned i = 0; i < n; ++i) {
+    war_succ_offsets[i + 1] += war_succ_offsets[i];
+  }
+  std::vector<unsigned> war_succs(war_preds_.size());
+  {
+    std::vector<unsigned> pos(war_succ_offsets.begin(), war_succ_offsets.end());
+    for (unsigned w = 0; w < n; ++w) {
+      for (unsigned k = war_offsets_[w]; k < war_offsets_[w + 1]; ++k) {
+        war_succs[pos[war_preds_[k]]++] = w;
+      }
+    }
+  }
+  std::vector<std::atomic<unsigned>> n_waiting(n);
+  std::vector<unsigned> front;
+  for (unsigned i = 0; i < n; ++i) {
+    const unsigned deps = (in_offsets_[i + 1] - in_offsets_[i]) +
+                          (war_offsets_[i + 1] - war_offsets_[i]);
+    n_waiting[i].store(deps, std::memory_order_relaxed);
+    if (deps == 0) front.push_back(i);
+  }
+  std::vector<unsigned> next;
+  std::mutex next_mutex;
+  while (!front.empty()) {
+    next.clear();
+    // Narrow fronts are handled in the calling thread
+    parallel_for(
+        0, front.size(), parallel_front_min_range,
+        [&](std::size_t begin, std::size_t end) {
+          std::vector<unsigned> ready;
+          for (std::size_t f = begin; f < end; ++f) {
+            const unsigned i = front[f];
+            assign_layer(i, skip_func, result, reached);
+            auto release = [&](unsigned t) {
+              if (n_waiting[t].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                ready.push_back(t);
+              }
+            };
+            for (unsigned k = out_offsets_[i]; k < out_offsets_[i + 1]; ++k) {
+              release(out_edges_[k].target);
+            }
+            for (unsigned k = war_succ_offsets[i]; k < war_succ_offsets[i + 1];
+                 ++k) {
+              release(war_succs[k]);
+            }
+          }
+          std::lock_guard<std::mutex> lock(next_mutex);
+          next.insert(next.end(), ready.begin(), ready.end());
+        });
+    front.swap(next);
+  }
+  return result;
+}
+
+}  // namespace tket
@@ -0,0 +1,176 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Circuit.hpp"
+#include "DAGDefs.hpp"
+
+namespace tket {
+
+/**
+ * Contiguous, index-based snapshot of the DAG of a circuit.
+ *
+ * The \ref DAG of a \ref Circuit stores every vertex and edge in its own
+ * list node, so that descriptors remain valid while the graph is rewritten.
+ * Read-only analyses that visit the whole graph (such as depth computations)
+ * pay for this with a pointer chase per step. This class copies the structure
+ * into flat arrays once: vertices are numbered 0, ..., V-1 in a topological
+ * order, and the in- and out-edges of each vertex are stored contiguously in
+ * compressed sparse row form, ordered by port.
+ *
+ * The snapshot refers to the vertices and edges of the circuit it was built
+ * from, and is invalidated by any change to the DAG structure.
+ *
+ * O(V + E) to construct.
+ */
+class CompactDAG {
+ public:
+  /** An edge of the snapshot, given in terms of vertex indices */
+  struct EdgeEntry {
+    unsigned source;
+    unsigned target;
+    port_t source_port;
+    port_t target_port;
+    EdgeType type;
+    Edge edge; /**< corresponding edge in the original DAG */
+  };
+
+  /** Contiguous range of edges */
+  typedef std::pair<const EdgeEntry *, const EdgeEntry *> EdgeRange;
+
+  explicit CompactDAG(const Circuit &circ);
+
+  unsigned n_vertices() const { return vertices_.size(); }
+  unsigned n_edges() const { return out_edges_.size(); }
+
+  /** Vertex of the original DAG at the given index */
+  Vertex get_vertex(unsigned i) const { return vertices_[i]; }
+
+  /**
+   * Index of a vertex of the original DAG
+   *
+   * @throws MissingVertex if the vertex is not in the snapshot
+   */
+  unsigned get_index(const Vertex &v) const;
+
+  const Op_ptr &get_op(unsigned i) const { return ops_[i]; }
+
+  /** In-edges of a vertex, ordered by target port */
+  EdgeRange in_edges(unsigned i) const {
+    return {
+        in_edges_.data() + in_offsets_[i],
+        in_edges_.data() + in_offsets_[i + 1]};
+  }
+
+  /**
+   * Out-edges of a vertex, ordered by source port
+   *
+   * Edges sharing a source port (a Classical edge and any Boolean edges
+   * reading from it) are ordered with the Classical edge first.
+   */
+  EdgeRange out_edges(unsigned i) const {
+    return {
+        out_edges_.data() + out_offsets_[i],
+        out_edges_.data() + out_offsets_[i + 1]};
+  }
+
+  /**
+   * Layer of every vertex as given by \ref Circuit::SliceIterator.
+   *
+   * Initial vertices are assigned layer 0, and every other vertex reachable
+   * from them is assigned one more than the greatest layer among its
+   * predecessors. As in \ref Circuit::SliceIterator, a vertex writing to a
+   * classical wire is placed after every vertex reading the previous value of
+   * that wire. Final vertices, and vertices not reachable from an initial
+   * vertex, are assigned no layer.
+   *
+   * O(V + E)
+   *
+   * @return layer of each vertex, indexed as in the snapshot
+   */
+  std::vector<std::optional<unsigned>> layers() const;
+
+  /**
+   * Layer of every vertex as given by slicing with a skip function.
+   *
+   * Vertices for which \p skip_func holds do not start a new layer: they are
+   * assigned the greatest layer among their predecessors. Initial vertices are
+   * assigned layer 0 and the first non-skipped vertices layer 1. This matches
+   * the counting performed by \ref Circuit::depth and related methods.
+   *
+   * O(V + E)
+   *
+   * @param skip_func whether an operation is skipped
+   *
+   * @return layer of each vertex, indexed as in the snapshot
+   */
+  std::vector<std::optional<unsigned>> layers(
+      const std::function<bool(Op_ptr)> &skip_func) const;
+
+  /**
+   * Greatest layer assigned by \ref layers with the given skip function.
+   *
+   * O(V + E)
+   */
+  unsigned max_layer(const std::function<bool(Op_ptr)> &skip_func) const;
+
+  /**
+   * Vertices grouped by \ref layers into slices.
+   *
+   * Slice k holds the vertices of layer k + 1, which are those of the k-th
+   * slice given by \ref Circuit::SliceIterator, ordered by index rather
+   * than by unit.
+   *
+   * O(V + E)
+   */
+  SliceVec slices() const;
+
+ private:
+  /** Number of vertices from which layers are computed in wavefronts */
+  static constexpr unsigned parallel_layers_threshold = 1u << 14;
+  /** Smallest part of a wavefront worth handing to another thread */
+  static constexpr std::size_t parallel_front_min_range = 1024;
+
+  VertexVec vertices_;
+  std::vector<Op_ptr> ops_;
+  std::vector<bool> initial_;
+  std::vector<bool> final_;
+  std::unordered_map<Vertex, unsigned> index_;
+  std::vector<unsigned> in_offsets_;
+  std::vector<EdgeEntry> in_edges_;
+  std::vector<unsigned> out_offsets_;
+  std::vector<EdgeEntry> out_edges_;
+  /** Readers of a classical value that must precede its next write */
+  std::vector<unsigned> war_offsets_;
+  std::vector<unsigned> war_preds_;
+
+  std::vector<std::optional<unsigned>> compute_layers(
+      const std::function<bool(Op_ptr)> *skip_func) const;
+
+  /** Set the layer of a vertex, given those of its predecessors */
+  void assign_layer(
+      unsigned i, const std::function<bool(Op_ptr)> *skip_func,
+      std::vector<std::optional<unsigned>> &result,
+      std::vector<char> &reached) const;
+};
+
+}  // namespace tket
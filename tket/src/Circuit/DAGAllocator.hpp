@@ -0,0 +1,240 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <new>
+
+#include "Utils/GraphHeaders.hpp"
+
+namespace tket {
+
+namespace dag_pool {
+
+/** Unused block, linked into a free list */
+struct FreeBlock {
+  FreeBlock *next;
+};
+
+/** Alignment of every block */
+constexpr std::size_t block_align = alignof(std::max_align_t);
+
+/** Size of the blocks used to hold objects of a given size */
+constexpr std::size_t block_size_for(std::size_t size) {
+  return ((size > sizeof(FreeBlock) ? size : sizeof(FreeBlock)) +
+          block_align - 1) /
+         block_align * block_align;
+}
+
+/**
+ * Pool of fixed-size blocks shared by all threads.
+ *
+ * Each thread keeps its own free list, so that allocation and deallocation
+ * take no lock in the common case. When a thread's list is empty it takes a
+ * batch of blocks from a shared depot, or carves a new chunk of
+ * \ref chunk_blocks blocks from the system allocator; when it grows too long
+ * a batch is returned to the depot. A block may be released by a different
+ * thread from the one that allocated it.
+ *
+ * Chunks are never returned to the system: memory released by one circuit is
+ * reused by the next one built, so the footprint is bounded by the peak
+ * number of live vertices and edges.
+ *
+ * @tparam BlockSize size in bytes of each block, a multiple of
+ *   \ref block_align
+ */
+template <std::size_t BlockSize>
+class BlockPool {
+ public:
+  static constexpr std::size_t block_size = BlockSize;
+  static constexpr unsigned chunk_blocks = 256;
+
+  static void *allocate() {
+    ThreadCache &c = cache();
+    if (c.head == nullptr) refill(c);
+    FreeBlock *b = c.head;
+    c.head = b->next;
+    --c.count;
+    return b;
+  }
+
+  static void deallocate(void *p) {
+    ThreadCache &c = cache();
+    FreeBlock *b = static_cast<FreeBlock *>(p);
+    b->next = c.head;
+    c.head = b;
+    if (++c.count > 2 * chunk_blocks) spill(c, chunk_blocks);
+  }
+
+ private:
+  struct ThreadCache {
+    FreeBlock *head = nullptr;
+    unsigned count = 0;
+  };
+
+  /** Returns a thread's free list to the depot when the thread exits */
+  struct ThreadCacheReleaser {
+    ~ThreadCacheReleaser() { spill(cache(), cache().count); }
+  };
+
+  struct Depot {
+    std::mutex mutex;
+    FreeBlock *head = nullptr;
+    unsigned count = 0;
+  };
+
+  static ThreadCache &cache() {
+    // Trivially destructible, so still usable by graphs destroyed during
+    // thread or program exit.
+    static thread_local ThreadCache c;
+    static thread_local ThreadCacheReleaser releaser;
+    (void)releaser;
+    return c;
+  }
+
+  static Depot &depot() {
+    // Never destroyed: blocks may be released during static destruction.
+    static Depot *d = new Depot;
+    return *d;
+  }
+
+  static void refill(ThreadCache &c) {
+    Depot &d = depot();
+    {
+      std::lock_guard<std::mutex> lock(d.mutex);
+      if (d.head != nullptr) {
+        FreeBlock *last = d.head;
+        unsigned taken = 1;
+        while (taken < chunk_blocks && last->next != nullptr) {
+          last = last->next;
+          ++taken;
+        }
+        c.head = d.head;
+        c.count = taken;
+        d.head = last->next;
+        d.count -= taken;
+        last->next = nullptr;
+        return;
+      }
+    }
+    char *chunk =
+        static_cast<char *>(::operator new(block_size * chunk_blocks));
+    FreeBlock *head = nullptr;
+    for (unsigned i = chunk_blocks; i-- > 0;) {
+      FreeBlock *b = reinterpret_cast<FreeBlock *>(chunk + i * block_size);
+      b->next = head;
+      head = b;
+    }
+    c.head = head;
+    c.count = chunk_blocks;
+  }
+
+  static void spill(ThreadCache &c, unsigned n) {
+    if (n == 0 || c.head == nullptr) return;
+    FreeBlock *first = c.head;
+    FreeBlock *last = first;
+    unsigned moved = 1;
+    while (moved < n && last->next != nullptr) {
+      last = last->next;
+      ++moved;
+    }
+    c.head = last->next;
+    c.count -= moved;
+    Depot &d = depot();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    last->next = d.head;
+    d.head = first;
+    d.count += moved;
+  }
+};
+
+}  // namespace dag_pool
+
+/**
+ * Allocator for the nodes of the lists making up a \ref DAG.
+ *
+ * Single objects (list nodes) come from the \ref dag_pool::BlockPool for
+ * their rounded-up size, shared by all types of that size, so building or
+ * copying a circuit takes blocks from a thread-local free list rather than
+ * calling the system allocator once per vertex and edge. Arrays, and
+ * over-aligned types, use the global operator new.
+ *
+ * Stateless: all instances compare equal and memory may be released through
+ * any of them.
+ */
+template <typename T>
+class DAGAllocator {
+ public:
+  typedef T value_type;
+
+  DAGAllocator() noexcept {}
+  template <typename U>
+  DAGAllocator(const DAGAllocator<U> &) noexcept {}
+
+  T *allocate(std::size_t n) {
+    if (n == 1 && alignof(T) <= dag_pool::block_align) {
+      return static_cast<T *>(pool::allocate());
+    }
+    return static_cast<T *>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T *p, std::size_t n) noexcept {
+    if (n == 1 && alignof(T) <= dag_pool::block_align) {
+      pool::deallocate(p);
+    } else {
+      ::operator delete(p);
+    }
+  }
+
+  template <typename U>
+  bool operator==(const DAGAllocator<U> &) const noexcept {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const DAGAllocator<U> &) const noexcept {
+    return false;
+  }
+
+ private:
+  typedef dag_pool::BlockPool<dag_pool::block_size_for(sizeof(T))> pool;
+};
+
+/**
+ * Graph container selector for a `std::list` with a given allocator.
+ *
+ * Behaves like `boost::listS` (stable descriptors and iterators, parallel
+ * edges allowed), but lets the storage of a `boost::adjacency_list` be
+ * allocated with \p Alloc.
+ */
+template <template <typename> class Alloc>
+struct list_with_allocatorS {};
+
+}  // namespace tket
+
+namespace boost {
+
+template <template <typename> class Alloc, class ValueType>
+struct container_gen<tket::list_with_allocatorS<Alloc>, ValueType> {
+  typedef std::list<ValueType, Alloc<ValueType>> type;
+};
+
+template <template <typename> class Alloc>
+struct parallel_edge_traits<tket::list_with_allocatorS<Alloc>> {
+  typedef allow_parallel_edge_tag type;
+};
+
+}  // namespace boost
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <boost/container/small_vector.hpp>
 #include <list>
 #include <optional>
 #include <set>
@@ -23,6 +24,7 @@
 #include <utility>
 #include <vector>
 
+#include "DAGAllocator.hpp"
 #include "OpType/EdgeType.hpp"
 #include "Ops/Op.hpp"
 #include "Utils/GraphHeaders.hpp"
@@ -45,14 +47,24 @@ struct EdgeProperties {
   std::pair<port_t, port_t> ports;
 };
 
+/**
+ * Container selector for the storage of a \ref DAG.
+ *
+ * A list, so that vertices and edges can be removed without invalidating
+ * descriptors and iterators, whose nodes come from per-thread pools rather
+ * than one system allocation each. Substitute `boost::listS` here to use the
+ * standard allocator.
+ */
+typedef list_with_allocatorS<DAGAllocator> DAGListS;
+
 /** Graph representing a circuit, with operations as nodes. */
 typedef boost::adjacency_list<
     // OutEdgeList
-    boost::listS,
+    DAGListS,
 
-    // VertexList (use listS because we want to be able to remove vertices
+    // VertexList (use a list because we want to be able to remove vertices
     // without invalidating iterators)
-    boost::listS,
+    DAGListS,
 
     // we want access to incoming and outgoing edges
     boost::bidirectionalS,
@@ -60,13 +72,20 @@ typedef boost::adjacency_list<
     // indexing needed for algorithms such as topological sort
     boost::property<boost::vertex_index_t, int, VertexProperties>,
 
-    EdgeProperties>
+    EdgeProperties,
+
+    boost::no_property,
+
+    // EdgeList
+    DAGListS>
     DAG;
 
 typedef boost::graph_traits<DAG>::vertex_descriptor Vertex;
 typedef boost::graph_traits<DAG>::vertex_iterator V_iterator;
 typedef std::unordered_set<Vertex> VertexSet;
 typedef std::vector<Vertex> VertexVec;
+/** Vertex vector holding up to 8 vertices without allocating */
+typedef boost::container::small_vector<Vertex, 8> SmallVertexVec;
 typedef std::list<Vertex> VertexList;
 typedef std::unordered_map<Vertex, unsigned> IndexMap;
 typedef boost::adj_list_vertex_property_map<
@@ -87,6 +106,13 @@ typedef DAG::in_edge_iterator E_in_iterator;
 typedef DAG::out_edge_iterator E_out_iterator;
 typedef std::set<Edge> EdgeSet;
 typedef std::vector<Edge> EdgeVec;
+/**
+ * Edge vectors holding up to 8 entries without allocating, for the hot
+ * neighbourhood queries of \ref Circuit
+ */
+typedef boost::container::small_vector<Edge, 8> SmallEdgeVec;
+typedef boost::container::small_vector<std::optional<Edge>, 8>
+    SmallOptEdgeVec;
 typedef std::list<Edge> EdgeList;
 
 typedef std::pair<Vertex, port_t> VertPort;
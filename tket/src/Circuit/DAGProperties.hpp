@@ -59,4 +59,18 @@ namespace tket {
  */
 bool is_valid(const DAG &G);
 
+/**
+ * Check the properties of \ref is_valid(const DAG &) at some vertices only.
+ *
+ * Each property concerns a single vertex and its incident edges, so after
+ * changes to a valid DAG it is enough to check the vertices added and both
+ * ends of every edge added or removed.
+ *
+ * @param      G DAG to check
+ * @param      vertices vertices of G to check
+ *
+ * @return whether the vertices have the required properties
+ */
+bool is_valid(const DAG &G, const VertexSet &vertices);
+
 }  // namespace tket
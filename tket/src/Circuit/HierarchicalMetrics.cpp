@@ -0,0 +1,261 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "HierarchicalMetrics.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "CompactDAG.hpp"
+
+namespace tket {
+
+namespace {
+
+// Lengths of the longest chains of (non-barrier) operations reaching a point
+// from each of a number of sources
+typedef std::vector<long long> chain_t;
+
+constexpr long long unreachable = -1;
+
+// Elementwise maximum of a and b + offset, over reachable entries
+void max_into(chain_t &a, const chain_t &b, long long offset) {
+  if (offset == unreachable) return;
+  for (unsigned k = 0; k < a.size(); ++k) {
+    if (b[k] != unreachable) a[k] = std::max(a[k], b[k] + offset);
+  }
+}
+
+long long max_entry(const chain_t &a) {
+  if (a.empty()) return unreachable;
+  return *std::max_element(a.begin(), a.end());
+}
+
+bool is_boundary_type(OpType type) {
+  return is_boundary_q_type(type) || is_boundary_c_type(type);
+}
+
+}  // namespace
+
+struct HierarchicalMetrics::Summary {
+  std::map<OpType, unsigned long long> counts;
+  unsigned long long n_ops = 0;
+  /** Types of unconditional operations */
+  OpTypeSet plain_types;
+  /** Types of operations inside conditionals */
+  OpTypeSet conditional_types;
+  /**
+   * Entry [j][i] is the longest chain from input port i to output port j.
+   * Only computed for box circuits, whose ports are their qubits followed by
+   * their bits.
+   */
+  std::vector<chain_t> wires;
+  /**
+   * Longest chain from any input ending in an operation on output port j,
+   * which is where conditions of the box are read when it is conditional
+   */
+  chain_t conditioned;
+  /**
+   * Longest chain from each input port (or from the circuit inputs, if not
+   * computed per port) to any operation
+   */
+  chain_t peak;
+};
+
+HierarchicalMetrics::HierarchicalMetrics() {}
+
+HierarchicalMetrics::~HierarchicalMetrics() {}
+
+std::map<OpType, unsigned long long> HierarchicalMetrics::gate_counts(
+    const Circuit &circ) {
+  return summarise(circ, false).counts;
+}
+
+unsigned long long HierarchicalMetrics::count_gates(
+    const Circuit &circ, OpType type) {
+  std::map<OpType, unsigned long long> counts = gate_counts(circ);
+  std::map<OpType, unsigned long long>::const_iterator found =
+      counts.find(type);
+  return found == counts.end() ? 0 : found->second;
+}
+
+unsigned HierarchicalMetrics::depth(const Circuit &circ) {
+  return std::max<long long>(0, summarise(circ, false).peak[0]);
+}
+
+OpTypeSet HierarchicalMetrics::gate_types(const Circuit &circ) {
+  Summary s = summarise(circ, false);
+  OpTypeSet types = s.conditional_types;
+  for (OpType type : s.plain_types) {
+    if (!is_metaop_type(type)) types.insert(type);
+  }
+  return types;
+}
+
+void HierarchicalMetrics::clear() { cache_.clear(); }
+
+const HierarchicalMetrics::Summary &HierarchicalMetrics::box_summary(
+    const Box &box) {
+  auto found = cache_.find(box.get_id());
+  if (found != cache_.end()) return *found->second;
+  std::unique_ptr<Summary> s =
+      std::make_unique<Summary>(summarise(*box.to_circuit(), true));
+  return *cache_.emplace(box.get_id(), std::move(s)).first->second;
+}
+
+HierarchicalMetrics::Summary HierarchicalMetrics::summarise(
+    const Circuit &circ, bool per_port) {
+  // Ports of a box circuit, as matched by Circuit::substitute
+  std::unordered_map<Vertex, unsigned> in_ports, out_ports;
+  unsigned n_ports = 0;
+  if (per_port) {
+    for (const Qubit &q : circ.all_qubits()) {
+      in_ports.insert({circ.get_in(q), n_ports});
+      out_ports.insert({circ.get_out(q), n_ports++});
+    }
+    for (const Bit &b : circ.all_bits()) {
+      in_ports.insert({circ.get_in(b), n_ports});
+      out_ports.insert({circ.get_out(b), n_ports++});
+    }
+  }
+  const unsigned n_sources = per_port ? n_ports : 1;
+
+  Summary s;
+  s.peak.assign(n_sources, unreachable);
+  s.wires.assign(n_ports, chain_t(n_sources, unreachable));
+  CompactDAG compact(circ);
+  const unsigned n = compact.n_vertices();
+  // Chains at the out-ports of each vertex; a single entry if shared by all
+  // ports. Released once every out-edge has been visited.
+  std::vector<std::vector<chain_t>> values(n);
+  std::vector<unsigned> unvisited(n);
+  for (unsigned i = 0; i < n; ++i) {
+    const CompactDAG::EdgeRange ins = compact.in_edges(i);
+    const CompactDAG::EdgeRange outs = compact.out_edges(i);
+    unvisited[i] = outs.second - outs.first;
+    const Op_ptr &op = compact.get_op(i);
+    const OpType type = op->get_type();
+    const Vertex v = compact.get_vertex(i);
+    if (!per_port) {
+      // Boundaries are kept when decomposing the boxes of this circuit
+      if (ins.first == ins.second || is_boundary_type(type)) {
+        ++s.counts[type];
+        s.plain_types.insert(type);
+      }
+    }
+    if (ins.first == ins.second) {
+      chain_t c(n_sources, unreachable);
+      if (!per_port) {
+        c[0] = 0;
+      } else {
+        std::unordered_map<Vertex, unsigned>::const_iterator port =
+            in_ports.find(v);
+        if (port != in_ports.end()) c[port->second] = 0;
+      }
+      values[i] = {std::move(c)};
+      continue;
+    }
+    std::vector<chain_t> in;
+    for (const CompactDAG::EdgeEntry *e = ins.first; e != ins.second; ++e) {
+      const std::vector<chain_t> &src = values[e->source];
+      if (in.size() <= e->target_port) in.resize(e->target_port + 1);
+      in[e->target_port] = src.size() == 1 ? src[0] : src[e->source_port];
+      if (--unvisited[e->source] == 0) values[e->source].clear();
+    }
+    if (is_boundary_type(type)) {
+      std::unordered_map<Vertex, unsigned>::const_iterator port =
+          out_ports.find(v);
+      if (port != out_ports.end()) s.wires[port->second] = in[0];
+      values[i] = {std::move(in[0])};
+      continue;
+    }
+
+    Op_ptr inner = op;
+    unsigned width = 0;
+    if (type == OpType::Conditional) {
+      const Conditional &cond = static_cast<const Conditional &>(*op);
+      inner = cond.get_op();
+      width = cond.get_width();
+    }
+    if (!inner->get_desc().is_box()) {
+      chain_t c(n_sources, unreachable);
+      for (const chain_t &x : in) max_into(c, x, 0);
+      if (type != OpType::Barrier) {
+        for (long long &l : c) {
+          if (l != unreachable) ++l;
+        }
+      }
+      max_into(s.peak, c, 0);
+      values[i] = {std::move(c)};
+      ++s.counts[type];
+      ++s.n_ops;
+      if (type == OpType::Conditional) {
+        s.conditional_types.insert(inner->get_type());
+      } else {
+        s.plain_types.insert(type);
+      }
+      continue;
+    }
+
+    // A box, possibly conditional on its first width ports
+    const Summary &b = box_summary(static_cast<const Box &>(*inner));
+    const unsigned n_box_ports = b.peak.size();
+    const long long b_peak = max_entry(b.peak);
+    std::vector<chain_t> out(width + n_box_ports);
+    for (unsigned j = 0; j < n_box_ports; ++j) {
+      chain_t c(n_sources, unreachable);
+      for (unsigned k = 0; k < n_box_ports; ++k) {
+        max_into(c, in[width + k], b.wires[j][k]);
+      }
+      for (unsigned k = 0; k < width; ++k) {
+        max_into(c, in[k], b.conditioned[j]);
+      }
+      out[width + j] = std::move(c);
+    }
+    for (unsigned k = 0; k < n_box_ports; ++k) {
+      max_into(s.peak, in[width + k], b.peak[k]);
+    }
+    for (unsigned k = 0; k < width; ++k) {
+      max_into(s.peak, in[k], b_peak);
+    }
+    values[i] = std::move(out);
+    s.n_ops += b.n_ops;
+    if (width == 0) {
+      for (const std::pair<const OpType, unsigned long long> &tc : b.counts) {
+        s.counts[tc.first] += tc.second;
+      }
+      s.plain_types.insert(b.plain_types.begin(), b.plain_types.end());
+      s.conditional_types.insert(
+          b.conditional_types.begin(), b.conditional_types.end());
+    } else {
+      // Every operation of the box is made conditional
+      if (b.n_ops > 0) s.counts[OpType::Conditional] += b.n_ops;
+      s.conditional_types.insert(b.plain_types.begin(), b.plain_types.end());
+      if (!b.conditional_types.empty()) {
+        s.conditional_types.insert(OpType::Conditional);
+      }
+    }
+  }
+
+  s.conditioned.assign(n_ports, unreachable);
+  for (unsigned j = 0; j < n_ports; ++j) {
+    // Chains of length 0 pass through the circuit without any operation
+    const long long l = max_entry(s.wires[j]);
+    if (l > 0) s.conditioned[j] = l;
+  }
+  return s;
+}
+
+}  // namespace tket
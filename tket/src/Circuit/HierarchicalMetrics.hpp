@@ -0,0 +1,81 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Metrics of circuits with boxes, without decomposing the boxes
+ */
+
+#include <map>
+#include <memory>
+
+#include "Circuit.hpp"
+#include "OpType/OpTypeFunctions.hpp"
+
+namespace tket {
+
+/**
+ * Gate counts, depth and gate types of a circuit as they would be after
+ * \ref Circuit::decompose_boxes_recursively, computed without decomposing.
+ *
+ * Each distinct box (by id) is summarised once from its own circuit, which
+ * is itself summarised in terms of the boxes it contains, and the summary is
+ * cached for all its instances at any depth. A summary holds the expanded
+ * gate counts and, for each pair of ports, the length of the longest chain of
+ * operations between them, which is enough to compose depths exactly.
+ *
+ * Summaries stay valid as long as the circuits of the boxes are not changed.
+ * Not thread-safe.
+ */
+class HierarchicalMetrics {
+ public:
+  HierarchicalMetrics();
+  ~HierarchicalMetrics();
+
+  /**
+   * Number of vertices of each type in the expanded circuit
+   *
+   * As for \ref Circuit::count_gates, boundary vertices are included and
+   * conditional operations count as OpType::Conditional.
+   */
+  std::map<OpType, unsigned long long> gate_counts(const Circuit &circ);
+
+  /** Number of vertices of the given type in the expanded circuit */
+  unsigned long long count_gates(const Circuit &circ, OpType type);
+
+  /** Depth of the expanded circuit, as given by \ref Circuit::depth */
+  unsigned depth(const Circuit &circ);
+
+  /**
+   * Types of the non-meta operations of the expanded circuit, looking
+   * through conditionals, as checked by \ref GateSetPredicate
+   */
+  OpTypeSet gate_types(const Circuit &circ);
+
+  /** Discard all cached box summaries */
+  void clear();
+
+ private:
+  struct Summary;
+
+  std::map<boost::uuids::uuid, std::unique_ptr<Summary>> cache_;
+
+  const Summary &box_summary(const Box &box);
+
+  Summary summarise(const Circuit &circ, bool per_port);
+};
+
+}  // namespace tket
@@ -39,7 +39,7 @@ void from_json(const nlohmann::json& j, Op_ptr& op) {
   } else {
     throw JsonError(
         "Deserialization not yet implemented for " +
-        optypeinfo().at(optype).name);
+        optypeinfo(optype).name);
   }
 }
 
@@ -0,0 +1,289 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ParameterSweep.hpp"
+
+#include <symengine/add.h>
+#include <symengine/mul.h>
+#include <symengine/pow.h>
+
+#include <cmath>
+
+#include "Gate/OpPtrFunctions.hpp"
+
+namespace tket {
+
+ParameterSweep::ParameterSweep(
+    const Circuit &circ, const std::vector<Sym> &symbols)
+    : symbols_(symbols),
+      qubits_(circ.all_qubits()),
+      bits_(circ.all_bits()),
+      name_(circ.get_name()),
+      implicit_permutation_(circ.implicit_qubit_permutation()),
+      phase_(circ.get_phase()) {
+  for (unsigned i = 0; i < symbols_.size(); ++i) {
+    symbol_index_.insert({symbols_[i], i});
+  }
+  for (const Sym &s : circ.free_symbols()) {
+    if (symbol_index_.count(s) == 0) {
+      throw CircuitInvalidity(
+          "Symbol " + s->get_name() + " is not among the swept symbols");
+    }
+  }
+  unsigned command = 0;
+  for (const Command &com : circ) {
+    Entry entry{com.get_op_ptr(), com.get_args(), com.get_opgroup(), {}, false};
+    const Op_ptr &op = entry.op;
+    if (!op->free_symbols().empty()) {
+      if (op->get_desc().is_gate()) {
+        const std::vector<Expr> params = op->get_params();
+        for (unsigned p = 0; p < params.size(); ++p) {
+          if (expr_free_symbols(params[p]).empty()) continue;
+          entry.sites.push_back({p, add_site(command, p, params[p])});
+        }
+      } else {
+        entry.substitute = true;
+      }
+    }
+    entries_.push_back(std::move(entry));
+    ++command;
+  }
+  if (!expr_free_symbols(phase_).empty()) {
+    phase_site_ = add_site(no_command, 0, phase_);
+  }
+}
+
+std::optional<std::pair<unsigned, unsigned>> ParameterSweep::site_position(
+    unsigned site) const {
+  const Site &s = sites_.at(site);
+  if (s.command == no_command) return std::nullopt;
+  return std::make_pair(s.command, s.param);
+}
+
+unsigned ParameterSweep::add_site(
+    unsigned command, unsigned param, const Expr &expr) {
+  Site site{command, param, expr, {}};
+  if (!compile(expr, site.program)) site.program.clear();
+  sites_.push_back(std::move(site));
+  return sites_.size() - 1;
+}
+
+bool ParameterSweep::compile(
+    const ExprPtr &e, std::vector<Instruction> &program) const {
+  typedef Instruction::Code Code;
+  const SymEngine::Basic &b = *e;
+  if (SymEngine::free_symbols(b).empty()) {
+    try {
+      program.push_back({Code::Constant, SymEngine::eval_double(b), 0});
+      return true;
+    } catch (const std::exception &) {
+      // e.g. a complex constant
+      return false;
+    }
+  }
+  if (SymEngine::is_a<SymEngine::Symbol>(b)) {
+    Sym s = SymEngine::rcp_static_cast<const SymEngine::Symbol>(e);
+    std::map<Sym, unsigned, SymCompareLess>::const_iterator found =
+        symbol_index_.find(s);
+    if (found == symbol_index_.end()) return false;
+    program.push_back({Code::Symbol, 0., found->second});
+    return true;
+  }
+  const SymEngine::vec_basic args = b.get_args();
+  for (const ExprPtr &arg : args) {
+    if (!compile(arg, program)) return false;
+  }
+  if (SymEngine::is_a<SymEngine::Add>(b)) {
+    program.push_back({Code::Add, 0., static_cast<unsigned>(args.size())});
+    return true;
+  }
+  if (SymEngine::is_a<SymEngine::Mul>(b)) {
+    program.push_back({Code::Mul, 0., static_cast<unsigned>(args.size())});
+    return true;
+  }
+  Code code;
+  if (SymEngine::is_a<SymEngine::Pow>(b)) {
+    code = Code::Pow;
+  } else if (SymEngine::is_a<SymEngine::Sin>(b)) {
+    code = Code::Sin;
+  } else if (SymEngine::is_a<SymEngine::Cos>(b)) {
+    code = Code::Cos;
+  } else if (SymEngine::is_a<SymEngine::Tan>(b)) {
+    code = Code::Tan;
+  } else if (SymEngine::is_a<SymEngine::ASin>(b)) {
+    code = Code::Asin;
+  } else if (SymEngine::is_a<SymEngine::ACos>(b)) {
+    code = Code::Acos;
+  } else if (SymEngine::is_a<SymEngine::ATan>(b)) {
+    code = Code::Atan;
+  } else if (SymEngine::is_a<SymEngine::ATan2>(b)) {
+    code = Code::Atan2;
+  } else if (SymEngine::is_a<SymEngine::Log>(b)) {
+    code = Code::Log;
+  } else if (SymEngine::is_a<SymEngine::Abs>(b)) {
+    code = Code::Abs;
+  } else {
+    return false;
+  }
+  program.push_back({code, 0., 0});
+  return true;
+}
+
+SymEngine::map_basic_basic ParameterSweep::substitution_map(
+    const Eigen::MatrixXd &bindings, unsigned row) const {
+  SymEngine::map_basic_basic sub_map;
+  for (unsigned i = 0; i < symbols_.size(); ++i) {
+    sub_map[symbols_[i]] = SymEngine::real_double(bindings(row, i));
+  }
+  return sub_map;
+}
+
+Eigen::VectorXd ParameterSweep::evaluate(
+    const Site &site, const Eigen::MatrixXd &bindings) const {
+  typedef Instruction::Code Code;
+  const Eigen::Index n = bindings.rows();
+  if (site.program.empty()) {
+    Eigen::VectorXd values(n);
+    for (Eigen::Index row = 0; row < n; ++row) {
+      std::optional<double> x =
+          eval_expr(site.expr.subs(substitution_map(bindings, row)));
+      if (!x) {
+        throw CircuitInvalidity("Parameter could not be evaluated");
+      }
+      values[row] = *x;
+    }
+    return values;
+  }
+  std::vector<Eigen::ArrayXd> stack;
+  for (const Instruction &ins : site.program) {
+    switch (ins.code) {
+      case Code::Constant:
+        stack.push_back(Eigen::ArrayXd::Constant(n, ins.value));
+        break;
+      case Code::Symbol:
+        stack.push_back(bindings.col(ins.index).array());
+        break;
+      case Code::Add:
+      case Code::Mul: {
+        Eigen::ArrayXd acc = std::move(stack.back());
+        stack.pop_back();
+        for (unsigned k = 1; k < ins.index; ++k) {
+          if (ins.code == Code::Add) {
+            acc += stack.back();
+          } else {
+            acc *= stack.back();
+          }
+          stack.pop_back();
+        }
+        stack.push_back(std::move(acc));
+        break;
+      }
+      case Code::Pow: {
+        Eigen::ArrayXd exponent = std::move(stack.back());
+        stack.pop_back();
+        stack.back() = stack.back().pow(exponent);
+        break;
+      }
+      case Code::Atan2: {
+        Eigen::ArrayXd x = std::move(stack.back());
+        stack.pop_back();
+        Eigen::ArrayXd &y = stack.back();
+        for (Eigen::Index i = 0; i < n; ++i) y[i] = std::atan2(y[i], x[i]);
+        break;
+      }
+      case Code::Sin:
+        stack.back() = stack.back().sin();
+        break;
+      case Code::Cos:
+        stack.back() = stack.back().cos();
+        break;
+      case Code::Tan:
+        stack.back() = stack.back().tan();
+        break;
+      case Code::Asin:
+        stack.back() = stack.back().asin();
+        break;
+      case Code::Acos:
+        stack.back() = stack.back().acos();
+        break;
+      case Code::Atan:
+        stack.back() = stack.back().atan();
+        break;
+      case Code::Log:
+        stack.back() = stack.back().log();
+        break;
+      case Code::Abs:
+        stack.back() = stack.back().abs();
+        break;
+    }
+  }
+  return stack.back().matrix();
+}
+
+Eigen::MatrixXd ParameterSweep::parameter_values(
+    const Eigen::MatrixXd &bindings) const {
+  if (bindings.cols() != static_cast<Eigen::Index>(symbols_.size())) {
+    throw CircuitInvalidity("Bindings must have one column per symbol");
+  }
+  Eigen::MatrixXd values(bindings.rows(), sites_.size());
+  for (unsigned s = 0; s < sites_.size(); ++s) {
+    values.col(s) = evaluate(sites_[s], bindings);
+  }
+  return values;
+}
+
+Circuit ParameterSweep::build(
+    const Eigen::MatrixXd &values, const Eigen::MatrixXd &bindings,
+    unsigned row) const {
+  Circuit circ(qubits_, bits_);
+  if (name_) circ.set_name(*name_);
+  circ.add_phase(phase_site_ ? Expr(values(row, *phase_site_)) : phase_);
+  std::optional<SymEngine::map_basic_basic> sub_map;
+  for (const Entry &entry : entries_) {
+    Op_ptr op = entry.op;
+    if (!entry.sites.empty()) {
+      std::vector<Expr> params = op->get_params();
+      for (const std::pair<unsigned, unsigned> &site : entry.sites) {
+        params[site.first] = values(row, site.second);
+      }
+      op = get_op_ptr(op->get_type(), params, op->n_qubits());
+    } else if (entry.substitute) {
+      if (!sub_map) sub_map = substitution_map(bindings, row);
+      Op_ptr new_op = op->symbol_substitution(*sub_map);
+      if (new_op) op = new_op;
+    }
+    circ.add_op(op, entry.args, entry.opgroup);
+  }
+  circ.permute_boundary_output(implicit_permutation_);
+  return circ;
+}
+
+Circuit ParameterSweep::circuit(const std::vector<double> &binding) const {
+  Eigen::MatrixXd bindings(1, binding.size());
+  for (unsigned i = 0; i < binding.size(); ++i) bindings(0, i) = binding[i];
+  return build(parameter_values(bindings), bindings, 0);
+}
+
+std::vector<Circuit> ParameterSweep::circuits(
+    const Eigen::MatrixXd &bindings) const {
+  const Eigen::MatrixXd values = parameter_values(bindings);
+  std::vector<Circuit> result;
+  result.reserve(bindings.rows());
+  for (Eigen::Index row = 0; row < bindings.rows(); ++row) {
+    result.push_back(build(values, bindings, row));
+  }
+  return result;
+}
+
+}  // namespace tket
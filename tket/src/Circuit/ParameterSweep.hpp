@@ -0,0 +1,158 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Substituting many sets of values for the symbols of a circuit
+ */
+
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Circuit.hpp"
+#include "Utils/EigenConfig.hpp"
+
+namespace tket {
+
+/**
+ * Compiled substitution of values for the symbols of a circuit
+ *
+ * Every symbolic gate parameter (and a symbolic global phase) is a site.
+ * The expression at each site is compiled once into a small stack program
+ * over the symbols, which is then evaluated for a whole batch of bindings at
+ * a time with array operations. Expressions using functions that are not
+ * supported, and symbolic operations other than gates (such as boxes and
+ * conditional gates), fall back to SymEngine substitution for each binding.
+ *
+ * A binding gives a value for each symbol, in the order the symbols were
+ * given to the constructor. A batch of bindings is a matrix with one row per
+ * binding and one column per symbol.
+ */
+class ParameterSweep {
+ public:
+  /**
+   * Compile the substitution of values for the given symbols
+   *
+   * @param circ symbolic circuit
+   * @param symbols symbols to substitute, in the order of binding values
+   *
+   * @throws CircuitInvalidity if the circuit has free symbols not in
+   *   \p symbols
+   */
+  ParameterSweep(const Circuit &circ, const std::vector<Sym> &symbols);
+
+  /** Number of symbolic parameter sites */
+  unsigned n_sites() const { return sites_.size(); }
+
+  /**
+   * Position of a site: the index of its command in the circuit and the
+   * index of the parameter, or nullopt for the global phase
+   */
+  std::optional<std::pair<unsigned, unsigned>> site_position(
+      unsigned site) const;
+
+  /**
+   * Values at every site for a batch of bindings
+   *
+   * @param bindings one row per binding, one column per symbol
+   *
+   * @return one row per binding, one column per site
+   */
+  Eigen::MatrixXd parameter_values(const Eigen::MatrixXd &bindings) const;
+
+  /** Numerical circuit for a single binding */
+  Circuit circuit(const std::vector<double> &binding) const;
+
+  /** Numerical circuits for a batch of bindings */
+  std::vector<Circuit> circuits(const Eigen::MatrixXd &bindings) const;
+
+ private:
+  /** Instruction of a stack program */
+  struct Instruction {
+    enum class Code {
+      Constant,
+      Symbol,
+      Add,
+      Mul,
+      Pow,
+      Sin,
+      Cos,
+      Tan,
+      Asin,
+      Acos,
+      Atan,
+      Atan2,
+      Log,
+      Abs
+    };
+    Code code;
+    /** Value of a constant */
+    double value;
+    /** Index of a symbol, or number of operands of Add and Mul */
+    unsigned index;
+  };
+
+  struct Site {
+    /** Index of the command, or no_command for the global phase */
+    unsigned command;
+    unsigned param;
+    Expr expr;
+    /** Compiled expression; empty if it could not be compiled */
+    std::vector<Instruction> program;
+  };
+
+  static constexpr unsigned no_command = std::numeric_limits<unsigned>::max();
+
+  struct Entry {
+    Op_ptr op;
+    unit_vector_t args;
+    std::optional<std::string> opgroup;
+    /** Parameter indices and sites of the symbolic parameters of a gate */
+    std::vector<std::pair<unsigned, unsigned>> sites;
+    /** Whether the operation is symbolic but not a gate */
+    bool substitute;
+  };
+
+  std::vector<Sym> symbols_;
+  std::map<Sym, unsigned, SymCompareLess> symbol_index_;
+  qubit_vector_t qubits_;
+  bit_vector_t bits_;
+  std::optional<std::string> name_;
+  qubit_map_t implicit_permutation_;
+  Expr phase_;
+  std::optional<unsigned> phase_site_;
+  std::vector<Entry> entries_;
+  std::vector<Site> sites_;
+
+  unsigned add_site(unsigned command, unsigned param, const Expr &expr);
+
+  bool compile(const ExprPtr &e, std::vector<Instruction> &program) const;
+
+  Eigen::VectorXd evaluate(
+      const Site &site, const Eigen::MatrixXd &bindings) const;
+
+  SymEngine::map_basic_basic substitution_map(
+      const Eigen::MatrixXd &bindings, unsigned row) const;
+
+  Circuit build(
+      const Eigen::MatrixXd &values, const Eigen::MatrixXd &bindings,
+      unsigned row) const;
+};
+
+}  // namespace tket
@@ -0,0 +1,88 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ReplacementTemplate.hpp"
+
+#include <map>
+#include <utility>
+
+namespace tket {
+
+ReplacementTemplate::ReplacementTemplate(const Circuit &circ)
+    : n_qubits_(circ.n_qubits()), phase_(circ.get_phase()) {
+  if (!circ.is_simple()) throw SimpleOnly();
+  if (circ.n_bits() != 0) {
+    throw CircuitInvalidity("Replacement templates must have no bits");
+  }
+  std::map<Qubit, unsigned> index;
+  for (const Qubit &qb : circ.all_qubits()) {
+    index.insert({qb, unsigned(index.size())});
+  }
+  for (const Command &com : circ) {
+    if (com.get_opgroup()) {
+      throw CircuitInvalidity(
+          "Replacement templates must have no named op groups");
+    }
+    Gate gate{com.get_op_ptr(), {}};
+    for (const UnitID &arg : com.get_args()) {
+      gate.qubits.push_back(index.at(Qubit(arg)));
+    }
+    gates_.push_back(std::move(gate));
+  }
+  outputs_.resize(n_qubits_);
+  for (const std::pair<const Qubit, Qubit> &pair :
+       circ.implicit_qubit_permutation()) {
+    outputs_[index.at(pair.first)] = index.at(pair.second);
+  }
+}
+
+void ReplacementTemplate::substitute(
+    Circuit &circ, const Vertex &to_replace,
+    Circuit::VertexDeletion vertex_deletion) const {
+  const EdgeVec ins = circ.get_in_edges(to_replace);
+  const EdgeVec outs = circ.get_all_out_edges(to_replace);
+  if (ins.size() != n_qubits_ || outs.size() != n_qubits_) {
+    throw CircuitInvalidity("Vertex does not match replacement template");
+  }
+  // End of each wire built so far, starting at the predecessors
+  std::vector<VertPort> ends(n_qubits_);
+  std::vector<VertPort> succs(n_qubits_);
+  for (unsigned i = 0; i < n_qubits_; ++i) {
+    if (circ.get_edgetype(ins[i]) != EdgeType::Quantum ||
+        circ.get_edgetype(outs[i]) != EdgeType::Quantum) {
+      throw CircuitInvalidity("Vertex does not match replacement template");
+    }
+    ends[i] = {circ.source(ins[i]), circ.get_source_port(ins[i])};
+    succs[i] = {circ.target(outs[i]), circ.get_target_port(outs[i])};
+  }
+  for (unsigned i = 0; i < n_qubits_; ++i) {
+    circ.remove_edge(ins[i]);
+    circ.remove_edge(outs[i]);
+  }
+  for (const Gate &gate : gates_) {
+    Vertex v = circ.add_vertex(gate.op);
+    for (port_t p = 0; p < gate.qubits.size(); ++p) {
+      VertPort &end = ends[gate.qubits[p]];
+      circ.add_edge(end, {v, p}, EdgeType::Quantum);
+      end = {v, p};
+    }
+  }
+  for (unsigned i = 0; i < n_qubits_; ++i) {
+    circ.add_edge(ends[i], succs[outputs_[i]], EdgeType::Quantum);
+  }
+  circ.remove_vertex(to_replace, Circuit::GraphRewiring::No, vertex_deletion);
+  circ.add_phase(phase_);
+}
+
+}  // namespace tket
@@ -0,0 +1,83 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <vector>
+
+#include "Circuit.hpp"
+
+namespace tket {
+
+/**
+ * A purely quantum circuit flattened into a list of operations, for
+ * replacing vertices of other circuits.
+ *
+ * \ref Circuit::substitute copies the whole DAG of the inserted circuit,
+ * boundaries included, for every vertex it replaces. A template is built
+ * once from a circuit and then stamped in place of a vertex by adding only
+ * the vertices of its operations and the edges between them. The template
+ * keeps the implicit qubit permutation and phase of its circuit, so that
+ * stamping it is equivalent to substituting the circuit.
+ *
+ * Templates are immutable, so one may be shared between threads.
+ */
+class ReplacementTemplate {
+ public:
+  /**
+   * Flatten a circuit.
+   *
+   * @param circ simple circuit with no bits and no named op groups
+   *
+   * @throw SimpleOnly if \p circ is not simple
+   * @throw CircuitInvalidity if \p circ has bits or named op groups
+   */
+  explicit ReplacementTemplate(const Circuit &circ);
+
+  unsigned n_qubits() const { return n_qubits_; }
+  unsigned n_gates() const { return gates_.size(); }
+
+  /**
+   * Replace a vertex by the operations of the template.
+   *
+   * The i-th quantum input and output of the vertex are wired to qubit i of
+   * the template, and the phase of the template is added to the circuit.
+   *
+   * @param circ circuit to modify
+   * @param to_replace vertex with only quantum edges, one in and one out
+   *   for each qubit of the template
+   * @param vertex_deletion whether to remove \p to_replace from the DAG
+   *
+   * @throw CircuitInvalidity if the edges of \p to_replace do not match
+   */
+  void substitute(
+      Circuit &circ, const Vertex &to_replace,
+      Circuit::VertexDeletion vertex_deletion =
+          Circuit::VertexDeletion::Yes) const;
+
+ private:
+  struct Gate {
+    Op_ptr op;
+    /** Input qubit of the template on each port */
+    std::vector<unsigned> qubits;
+  };
+
+  unsigned n_qubits_;
+  std::vector<Gate> gates_;
+  /** Output qubit at the end of the wire from each input qubit */
+  std::vector<unsigned> outputs_;
+  Expr phase_;
+};
+
+}  // namespace tket
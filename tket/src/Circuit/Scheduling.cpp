@@ -0,0 +1,190 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Scheduling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "Ops/Conditional.hpp"
+#include "Utils/Constants.hpp"
+#include "Utils/Parallel.hpp"
+
+namespace tket {
+
+GateDurations::GateDurations(duration_t default_duration)
+    : default_duration_(default_duration) {}
+
+void GateDurations::set_duration(OpType type, duration_t duration) {
+  op_durations_[type] = duration;
+}
+
+void GateDurations::set_duration(
+    OpType type, const qubit_vector_t &qubits, duration_t duration) {
+  arg_durations_[{type, qubits}] = duration;
+}
+
+duration_t GateDurations::get_duration(
+    OpType type, const qubit_vector_t &qubits) const {
+  if (!arg_durations_.empty()) {
+    auto it = arg_durations_.find({type, qubits});
+    if (it != arg_durations_.end()) return it->second;
+  }
+  auto it = op_durations_.find(type);
+  if (it != op_durations_.end()) return it->second;
+  return is_metaop_type(type) ? 0. : default_duration_;
+}
+
+duration_t GateDurations::get_duration(const Command &com) const {
+  Op_ptr op = com.get_op_ptr();
+  while (op->get_type() == OpType::Conditional) {
+    op = static_cast<const Conditional &>(*op).get_op();
+  }
+  return get_duration(op->get_type(), com.get_qubits());
+}
+
+// Smallest layer worth splitting between threads
+static const std::size_t min_layer_range = 256;
+
+// For each operation, the longest total duration of a chain of its
+// dependencies. Dependencies of an operation come before it in the order
+// given by `reverse`. Operations are grouped into layers such that each only
+// depends on earlier layers, and each layer is handled in parallel.
+static std::vector<duration_t> longest_chains(
+    const std::vector<std::vector<unsigned>> &deps,
+    const std::vector<duration_t> &durs, bool reverse) {
+  const unsigned n = deps.size();
+  std::vector<unsigned> level(n, 0);
+  std::vector<std::vector<unsigned>> layers;
+  for (unsigned k = 0; k < n; k++) {
+    const unsigned i = reverse ? n - 1 - k : k;
+    for (unsigned j : deps[i]) level[i] = std::max(level[i], level[j] + 1);
+    if (level[i] == layers.size()) layers.emplace_back();
+    layers[level[i]].push_back(i);
+  }
+  std::vector<duration_t> chain(n, 0.);
+  for (const std::vector<unsigned> &layer : layers) {
+    parallel_for(
+        0, layer.size(), min_layer_range,
+        [&](std::size_t begin, std::size_t end) {
+          for (std::size_t k = begin; k < end; k++) {
+            const unsigned i = layer[k];
+            duration_t t = 0.;
+            for (unsigned j : deps[i]) t = std::max(t, chain[j] + durs[j]);
+            chain[i] = t;
+          }
+        });
+  }
+  return chain;
+}
+
+namespace {
+
+// The operations of a circuit in topological order, with their durations
+// and the indices of their neighbours
+struct TimingGraph {
+  std::vector<Vertex> verts;
+  std::vector<duration_t> durs;
+  std::vector<std::vector<unsigned>> preds;
+  std::vector<std::vector<unsigned>> succs;
+};
+
+}  // namespace
+
+static TimingGraph timing_graph(
+    const Circuit &circ, const GateDurations &durations, bool with_succs) {
+  TimingGraph g;
+  const std::vector<Command> coms = circ.get_commands();
+  const unsigned n = coms.size();
+  g.verts.reserve(n);
+  g.durs.reserve(n);
+  std::unordered_map<Vertex, unsigned> index;
+  for (const Command &com : coms) {
+    index.insert({com.get_vertex(), unsigned(g.verts.size())});
+    g.verts.push_back(com.get_vertex());
+    g.durs.push_back(durations.get_duration(com));
+  }
+  // Neighbours that are not operations are boundaries, which take no time.
+  auto indices = [&index](const VertexVec &vs) {
+    std::vector<unsigned> is;
+    for (const Vertex &v : vs) {
+      auto it = index.find(v);
+      if (it != index.end()) is.push_back(it->second);
+    }
+    return is;
+  };
+  g.preds.resize(n);
+  if (with_succs) g.succs.resize(n);
+  for (unsigned i = 0; i < n; i++) {
+    g.preds[i] = indices(circ.get_predecessors(g.verts[i]));
+    if (with_succs) g.succs[i] = indices(circ.get_successors(g.verts[i]));
+  }
+  return g;
+}
+
+static duration_t end_time(
+    const std::vector<duration_t> &starts,
+    const std::vector<duration_t> &durs) {
+  duration_t total = 0.;
+  for (unsigned i = 0; i < starts.size(); i++) {
+    total = std::max(total, starts[i] + durs[i]);
+  }
+  return total;
+}
+
+Schedule schedule_circuit(
+    const Circuit &circ, const GateDurations &durations, ScheduleMode mode) {
+  const bool alap = mode == ScheduleMode::ALAP;
+  const TimingGraph g = timing_graph(circ, durations, alap);
+  Schedule schedule;
+  std::vector<duration_t> starts;
+  if (alap) {
+    // Time from the end of each operation to the end of the circuit
+    const std::vector<duration_t> tails = longest_chains(g.succs, g.durs, true);
+    schedule.total_duration = end_time(tails, g.durs);
+    starts.resize(tails.size());
+    for (unsigned i = 0; i < tails.size(); i++) {
+      starts[i] = schedule.total_duration - tails[i] - g.durs[i];
+    }
+  } else {
+    starts = longest_chains(g.preds, g.durs, false);
+    schedule.total_duration = end_time(starts, g.durs);
+  }
+  for (unsigned i = 0; i < g.verts.size(); i++) {
+    schedule.start_times.insert({g.verts[i], starts[i]});
+    schedule.durations.insert({g.verts[i], g.durs[i]});
+  }
+  return schedule;
+}
+
+duration_t total_duration(const Circuit &circ, const GateDurations &durations) {
+  const TimingGraph g = timing_graph(circ, durations, false);
+  return end_time(longest_chains(g.preds, g.durs, false), g.durs);
+}
+
+std::function<unsigned(const Circuit &)> duration_metric(
+    const GateDurations &durations, duration_t resolution) {
+  if (!(resolution > 0.)) {
+    throw std::invalid_argument("Duration resolution must be positive");
+  }
+  return [durations, resolution](const Circuit &circ) {
+    const duration_t units = total_duration(circ, durations) / resolution;
+    return unsigned(std::max(0., std::ceil(units - EPS)));
+  };
+}
+
+}  // namespace tket
@@ -0,0 +1,122 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Scheduling of circuits in time, given gate durations
+ */
+
+#include <functional>
+#include <map>
+#include <utility>
+
+#include "Circuit.hpp"
+
+namespace tket {
+
+/** Duration of an operation, in whatever unit the device uses */
+typedef double duration_t;
+
+/**
+ * Durations of operations on a device.
+ *
+ * A duration may be given for an OpType on particular qubits (in order),
+ * for an OpType on any qubits, or as a default for all other operations.
+ * The most specific one given is used. Meta operations such as barriers take
+ * no time unless a duration is given for them.
+ */
+class GateDurations {
+ public:
+  explicit GateDurations(duration_t default_duration = 0.);
+
+  /** Set the duration of an OpType on any qubits */
+  void set_duration(OpType type, duration_t duration);
+
+  /** Set the duration of an OpType on the given qubits */
+  void set_duration(
+      OpType type, const qubit_vector_t &qubits, duration_t duration);
+
+  /** Duration of an operation of the given type on the given qubits */
+  duration_t get_duration(OpType type, const qubit_vector_t &qubits) const;
+
+  /**
+   * Duration of a command.
+   *
+   * Conditional operations take as long as the operation they condition.
+   */
+  duration_t get_duration(const Command &com) const;
+
+ private:
+  duration_t default_duration_;
+  std::map<OpType, duration_t> op_durations_;
+  std::map<std::pair<OpType, qubit_vector_t>, duration_t> arg_durations_;
+};
+
+/** Whether operations start as early or as late as possible */
+enum class ScheduleMode { ASAP, ALAP };
+
+/**
+ * Start times of the operations of a circuit.
+ *
+ * The circuit starts at time 0 and ends at \ref total_duration. Every
+ * operation starts no earlier than all its predecessors end, along quantum,
+ * classical and boolean wires alike.
+ */
+struct Schedule {
+  /** Start time of each operation vertex (boundaries excluded) */
+  std::map<Vertex, duration_t> start_times;
+  /** Duration of each operation vertex */
+  std::map<Vertex, duration_t> durations;
+  /** Length of the critical path */
+  duration_t total_duration = 0.;
+};
+
+/**
+ * Schedule the operations of a circuit in time.
+ *
+ * With ScheduleMode::ASAP each operation starts as soon as its predecessors
+ * have finished; with ScheduleMode::ALAP each finishes as late as possible
+ * without lengthening the circuit. The total duration is the same either
+ * way. The operations in each layer of the DAG are timed in parallel.
+ *
+ * @param circ circuit
+ * @param durations durations of the operations
+ * @param mode whether to start operations early or late
+ */
+Schedule schedule_circuit(
+    const Circuit &circ, const GateDurations &durations,
+    ScheduleMode mode = ScheduleMode::ASAP);
+
+/**
+ * Wall-clock duration of a circuit: the length of its critical path.
+ *
+ * @param circ circuit
+ * @param durations durations of the operations
+ */
+duration_t total_duration(const Circuit &circ, const GateDurations &durations);
+
+/**
+ * Total duration as a metric for \ref RepeatWithMetricPass and
+ * \ref Transform::repeat_with_metric.
+ *
+ * @param durations durations of the operations
+ * @param resolution time unit of the metric; durations are rounded up to a
+ *   whole number of these
+ */
+std::function<unsigned(const Circuit &)> duration_metric(
+    const GateDurations &durations, duration_t resolution = 1.);
+
+}  // namespace tket
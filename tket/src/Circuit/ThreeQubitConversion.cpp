@@ -31,6 +31,7 @@
 #include "Utils/CosSinDecomposition.hpp"
 #include "Utils/EigenConfig.hpp"
 #include "Utils/MatrixAnalysis.hpp"
+#include "Utils/Parallel.hpp"
 #include "Utils/UnitID.hpp"
 
 namespace tket {
@@ -177,17 +178,17 @@ static std::optional<Complex> id_coeff(
 // 0 and a circuit on qubits 1 and 2. (The qubits on the second circuit are
 // indexed with 0 and 1.)
 static std::optional<std::pair<Circuit, Circuit>> separate_0_12(
-    const Eigen::MatrixXcd &U) {
+    const Matrix8cd &U) {
   // We want to check whether the unitary is of the form
   // [ w_00 V  w_01 V ]
   // [ w_10 V  w_11 V ]
   // where W is a 2x2 unitary and V is a 4x4 unitary.
   // W.l.o.g. we will assume w_00 (or w_10) is real and positive, compute the
   // w_ij assuming the above form, and then check that the form is correct.
-  Eigen::Matrix4cd U00 = U.topLeftCorner(4, 4);
-  Eigen::Matrix4cd U01 = U.topRightCorner(4, 4);
-  Eigen::Matrix4cd U10 = U.bottomLeftCorner(4, 4);
-  Eigen::Matrix4cd U11 = U.bottomRightCorner(4, 4);
+  Eigen::Matrix4cd U00 = U.topLeftCorner<4, 4>();
+  Eigen::Matrix4cd U01 = U.topRightCorner<4, 4>();
+  Eigen::Matrix4cd U10 = U.bottomLeftCorner<4, 4>();
+  Eigen::Matrix4cd U11 = U.bottomRightCorner<4, 4>();
   // If U is of the desired form, then U_ij U_kl* = w_ij W_kl* I for all
   // i, j, k, l.
   std::optional<Complex> w0000 = id_coeff(U00, U00);  // |w_00|^2
@@ -249,7 +250,7 @@ static std::optional<std::pair<Circuit, Circuit>> separate_0_12(
 
 // Special cases worth handling. This is not necessary for correctness, but
 // allows us to obtain circuits that are more amenable to later optimization.
-static std::optional<Circuit> special_3q_synth(const Eigen::MatrixXcd &U) {
+static std::optional<Circuit> special_3q_synth(const Matrix8cd &U) {
   static const Eigen::PermutationMatrix<8> P1 = []() {
     Eigen::VectorXi V1(8);
     V1 << 0, 1, 4, 5, 2, 3, 6, 7;
@@ -301,7 +302,10 @@ Circuit three_qubit_synthesis(const Eigen::MatrixXcd &U) {
   if (U.rows() != 8 || U.cols() != 8) {
     throw std::invalid_argument("Wrong-size matrix for three-qubit synthesis");
   }
+  return three_qubit_synthesis(Matrix8cd(U));
+}
 
+Circuit three_qubit_synthesis(const Matrix8cd &U) {
   std::optional<Circuit> c_special = special_3q_synth(U);
   if (c_special) return *c_special;
 
@@ -331,6 +335,16 @@ Circuit three_qubit_synthesis(const Eigen::MatrixXcd &U) {
   return circ;
 }
 
+std::vector<Circuit> three_qubit_synthesis(const std::vector<Matrix8cd> &Us) {
+  std::vector<Circuit> circs(Us.size());
+  parallel_for(0, Us.size(), 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; i++) {
+      circs[i] = three_qubit_synthesis(Us[i]);
+    }
+  });
+  return circs;
+}
+
 Eigen::MatrixXcd get_3q_unitary(const Circuit &c) {
   if (c.n_qubits() != 3) {
     throw CircuitInvalidity("Circuit in get_3q_unitary must have 3 qubits");
@@ -344,11 +358,11 @@ Eigen::MatrixXcd get_3q_unitary(const Circuit &c) {
   }
 
   // Step through commands, building unitary as we go.
-  Eigen::MatrixXcd U = Eigen::MatrixXcd::Identity(8, 8);
+  Matrix8cd U = Matrix8cd::Identity();
   for (const Command &cmd : c) {
     qubit_vector_t qbs = cmd.get_qubits();
     Op_ptr op = cmd.get_op_ptr();
-    Eigen::MatrixXcd M = Eigen::MatrixXcd::Zero(8, 8);
+    Matrix8cd M = Matrix8cd::Zero();
     switch (qbs.size()) {
       case 1: {
         std::vector<Expr> angles = as_gate_ptr(op)->get_tk1_angles();
@@ -14,8 +14,11 @@
 
 #pragma once
 
+#include <vector>
+
 #include "Circuit.hpp"
 #include "Utils/EigenConfig.hpp"
+#include "Utils/MatrixAnalysis.hpp"
 
 namespace tket {
 
@@ -31,6 +34,28 @@ namespace tket {
  */
 Circuit three_qubit_synthesis(const Eigen::MatrixXcd &U);
 
+/**
+ * Synthesise a 3-qubit circuit from an 8x8 unitary.
+ *
+ * As above, but all the linear algebra is done on fixed-size matrices.
+ *
+ * @param U unitary matrix in \ref BasisOrder::ilo
+ *
+ * @return circuit implementing the unitary
+ */
+Circuit three_qubit_synthesis(const Matrix8cd &U);
+
+/**
+ * Synthesise 3-qubit circuits from many 8x8 unitaries.
+ *
+ * The unitaries are synthesised in parallel (see \ref parallel_for).
+ *
+ * @param Us unitary matrices in \ref BasisOrder::ilo
+ *
+ * @return circuits implementing the unitaries, in the same order
+ */
+std::vector<Circuit> three_qubit_synthesis(const std::vector<Matrix8cd> &Us);
+
 /**
  * Convert a 3-qubit circuit to its corresponding unitary matrix.
  *
@@ -0,0 +1,75 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "UnitPaths.hpp"
+
+namespace tket {
+
+UnitPathIndex::UnitPathIndex(const Circuit &circ) {
+  const unsigned n_units = circ.boundary.size();
+  units_.reserve(n_units);
+  paths_.reserve(n_units);
+  positions_.reserve(boost::num_edges(circ.dag));
+  for (const BoundaryElement &el : circ.boundary.get<TagID>()) {
+    const unsigned u = units_.size();
+    units_.push_back(el.id_);
+    unit_index_.insert({el.id_, u});
+    // As in Circuit::unit_path
+    Vertex current_v = el.in_;
+    QPathDetailed path = {{current_v, 0}};
+    Edge between = circ.get_nth_out_edge(current_v, 0);
+    current_v = circ.target(between);
+    while (!circ.detect_final_Op(current_v)) {
+      if (circ.n_out_edges(current_v) == 0) {
+        throw CircuitInvalidity(
+            "A path ends before reaching an output vertex.");
+      }
+      port_t n = circ.get_target_port(between);
+      positions_.insert({between, {u, unsigned(path.size())}});
+      path.push_back({current_v, n});
+      between = circ.get_nth_out_edge(current_v, n);
+      current_v = circ.target(between);
+    }
+    positions_.insert({between, {u, unsigned(path.size())}});
+    path.push_back({current_v, 0});
+    paths_.push_back(std::move(path));
+  }
+}
+
+const QPathDetailed &UnitPathIndex::path(const UnitID &unit) const {
+  std::map<UnitID, unsigned>::const_iterator found = unit_index_.find(unit);
+  if (found == unit_index_.end()) {
+    throw CircuitInvalidity(
+        "Circuit does not contain unit with id: " + unit.repr());
+  }
+  return paths_[found->second];
+}
+
+std::optional<UnitPathIndex::Position> UnitPathIndex::position(
+    const Edge &e) const {
+  std::unordered_map<Edge, Position, boost::hash<Edge>>::const_iterator
+      found = positions_.find(e);
+  if (found == positions_.end()) return std::nullopt;
+  return found->second;
+}
+
+std::optional<VertPort> UnitPathIndex::next(const Edge &e) const {
+  std::optional<Position> pos = position(e);
+  if (!pos) return std::nullopt;
+  const QPathDetailed &p = paths_[pos->unit];
+  if (pos->index + 1 >= p.size()) return std::nullopt;
+  return p[pos->index + 1];
+}
+
+}  // namespace tket
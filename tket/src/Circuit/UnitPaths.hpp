@@ -0,0 +1,108 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <boost/functional/hash.hpp>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "Circuit.hpp"
+#include "DAGDefs.hpp"
+#include "Utils/UnitID.hpp"
+
+namespace tket {
+
+/**
+ * Index of the path of every unit of a circuit through its DAG.
+ *
+ * \ref Circuit::unit_path walks a wire from its input every time it is
+ * called. This class walks every wire once and records, for each edge on a
+ * wire, which unit it carries and how far along the wire it is, so that
+ * analyses repeatedly asking where a vertex lies on a wire, or what follows
+ * it, need not walk again.
+ *
+ * The index refers to the vertices and edges of the circuit it was built
+ * from, and is invalidated by any change to the DAG structure or boundary.
+ * \ref Circuit::get_unit_path_index keeps one up to date.
+ *
+ * O(V + E) to construct.
+ */
+class UnitPathIndex {
+ public:
+  /** Position of an edge on the path of a unit */
+  struct Position {
+    /** Index of the unit in \ref units */
+    unsigned unit;
+    /** Index in the unit's path of the target of the edge (at least 1) */
+    unsigned index;
+  };
+
+  /**
+   * @throw CircuitInvalidity if a path ends before reaching an output
+   */
+  explicit UnitPathIndex(const Circuit &circ);
+
+  /** All units of the circuit, in boundary order */
+  const std::vector<UnitID> &units() const { return units_; }
+
+  /**
+   * Path of a unit, as given by \ref Circuit::unit_path
+   *
+   * @throw CircuitInvalidity if the unit is not in the circuit
+   */
+  const QPathDetailed &path(const UnitID &unit) const;
+
+  /** Path of the unit at an index of \ref units */
+  const QPathDetailed &path(unsigned unit) const { return paths_[unit]; }
+
+  /**
+   * Position of an edge on its wire, or nullopt if it is not on a wire (that
+   * is, a Boolean edge or an edge not in the indexed circuit)
+   *
+   * O(1)
+   */
+  std::optional<Position> position(const Edge &e) const;
+
+  /**
+   * The vertex and in-port following the target of an edge on its wire, or
+   * nullopt if the edge is not on a wire or leads into an output
+   *
+   * O(1)
+   */
+  std::optional<VertPort> next(const Edge &e) const;
+
+  /**
+   * The k-th vertex and in-port on the path of a unit, counting the input
+   * as 0
+   *
+   * O(log U) for U units
+   *
+   * @throw CircuitInvalidity if the unit is not in the circuit
+   * @throw std::out_of_range if the path is not that long
+   */
+  const VertPort &at(const UnitID &unit, unsigned k) const {
+    return path(unit).at(k);
+  }
+
+ private:
+  std::vector<UnitID> units_;
+  std::map<UnitID, unsigned> unit_index_;
+  std::vector<QPathDetailed> paths_;
+  std::unordered_map<Edge, Position, boost::hash<Edge>> positions_;
+};
+
+}  // namespace tket
@@ -0,0 +1,131 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "DAGDefs.hpp"
+#include "Utils/Assert.hpp"
+
+namespace tket {
+
+/**
+ * Per-vertex data of a DAG, stored contiguously.
+ *
+ * A replacement for std::map<Vertex, T> in analyses over a whole circuit.
+ * Entries are looked up through the vertex indices of the DAG, which must
+ * have been set by \ref Circuit::index_vertices since the last change to
+ * the DAG structure, so a lookup is a single array access rather than a
+ * tree search. The indices are not touched afterwards: entries for
+ * vertices added to the DAG later are kept in a hash map instead, so the
+ * array stays valid while a pass rewrites the circuit, provided the
+ * vertices are not reindexed.
+ *
+ * Like a map, the array only contains the vertices given entries.
+ *
+ * @tparam T type of the data
+ */
+template <typename T>
+class VertexArray {
+ public:
+  /**
+   * Empty array for the vertices of a DAG, whose indices must be 0, ..., V-1
+   */
+  explicit VertexArray(const DAG &dag)
+      : dag_(&dag),
+        vertices_(boost::num_vertices(dag)),
+        values_(boost::num_vertices(dag)),
+        present_(boost::num_vertices(dag), false) {
+    BGL_FORALL_VERTICES_T(v, dag, DAG) {
+      std::size_t i = dense_index(v);
+      TKET_ASSERT(i < vertices_.size());
+      vertices_[i] = v;
+    }
+  }
+
+  /** Number of vertices with an entry */
+  std::size_t size() const { return n_present_ + overflow_.size(); }
+
+  /** Whether the vertex has an entry (0 or 1, as for std::map) */
+  std::size_t count(const Vertex &v) const {
+    std::size_t i = dense_index(v);
+    if (is_dense(v, i)) return present_[i] ? 1 : 0;
+    return overflow_.count(v);
+  }
+
+  /**
+   * Entry of a vertex
+   *
+   * @throw std::out_of_range if the vertex has no entry
+   */
+  const T &at(const Vertex &v) const {
+    std::size_t i = dense_index(v);
+    if (is_dense(v, i)) {
+      if (!present_[i]) throw std::out_of_range("Vertex not in VertexArray");
+      return values_[i];
+    }
+    return overflow_.at(v);
+  }
+  T &at(const Vertex &v) {
+    return const_cast<T &>(std::as_const(*this).at(v));
+  }
+
+  /** Entry of a vertex, default-constructed if it has none */
+  T &operator[](const Vertex &v) {
+    std::size_t i = dense_index(v);
+    if (is_dense(v, i)) {
+      if (!present_[i]) {
+        present_[i] = true;
+        ++n_present_;
+      }
+      return values_[i];
+    }
+    return overflow_[v];
+  }
+
+  /**
+   * Give a vertex an entry, unless it has one already
+   *
+   * @return whether the entry was added
+   */
+  bool insert(const Vertex &v, T value) {
+    if (count(v)) return false;
+    (*this)[v] = std::move(value);
+    return true;
+  }
+
+ private:
+  std::size_t dense_index(const Vertex &v) const {
+    return std::size_t(boost::get(boost::vertex_index, *dag_, v));
+  }
+
+  // Vertices added after construction have stale (or no) indices, which
+  // this tells apart from those of the snapshot
+  bool is_dense(const Vertex &v, std::size_t i) const {
+    return i < vertices_.size() && vertices_[i] == v;
+  }
+
+  const DAG *dag_;
+  VertexVec vertices_;
+  std::vector<T> values_;
+  std::vector<bool> present_;
+  std::size_t n_present_ = 0;
+  std::unordered_map<Vertex, T> overflow_;
+};
+
+}  // namespace tket
@@ -20,6 +20,7 @@
 #include <optional>
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Boxes.hpp"
@@ -47,6 +48,7 @@ void Circuit::remove_blank_wires() {
       unused_units.push_back(el.id_);
     }
   }
+  if (!bin.empty()) ++op_version_;
   for (const UnitID& u : unused_units) {
     boundary.get<TagID>().erase(u);
   }
@@ -92,6 +94,53 @@ Vertex Circuit::add_op<unsigned>(
   return add_op(gate, arg_ids, opgroup);
 }
 
+std::vector<Vertex> Circuit::add_ops(
+    const std::vector<std::pair<Op_ptr, std::vector<unsigned>>>& ops,
+    const unit_vector_t& units) {
+  // Look up the output of each unit once for the whole batch
+  VertexVec outs;
+  outs.reserve(units.size());
+  for (const UnitID& unit : units) outs.push_back(get_out(unit));
+  // Index (plus one) of the last op writing to each unit
+  std::vector<std::size_t> last_write(units.size(), 0);
+  std::vector<Vertex> added;
+  added.reserve(ops.size());
+  EdgeVec preds;
+  for (std::size_t n = 0; n < ops.size(); ++n) {
+    const auto& [op, args] = ops[n];
+    if (args.empty()) {
+      throw CircuitInvalidity("An operation must act on at least one wire");
+    }
+    const op_signature_t& sig = op->get_signature();
+    if (sig.size() != args.size()) {
+      throw CircuitInvalidity(
+          std::to_string(args.size()) + " args provided, but " +
+          op->get_name() + " requires " + std::to_string(sig.size()));
+    }
+    preds.clear();
+    for (unsigned i = 0; i < args.size(); ++i) {
+      const unsigned a = args[i];
+      if (a >= units.size()) {
+        throw CircuitInvalidity(
+            "Argument " + std::to_string(a) + " out of range of " +
+            std::to_string(units.size()) + " units");
+      }
+      if (sig[i] != EdgeType::Boolean) {
+        if (last_write[a] == n + 1) {
+          throw CircuitInvalidity(
+              "Multiple operation arguments reference " + units[a].repr());
+        }
+        last_write[a] = n + 1;
+      }
+      preds.push_back(get_nth_in_edge(outs[a], 0));
+    }
+    Vertex v = add_vertex(op);
+    rewire(v, preds, sig);
+    added.push_back(v);
+  }
+  return added;
+}
+
 Vertex Circuit::add_barrier(
     const std::vector<unsigned>& qubits, const std::vector<unsigned>& bits) {
   op_signature_t sig(qubits.size(), EdgeType::Quantum);
@@ -197,7 +246,7 @@ Vertex Circuit::add_assertion(
 
 Vertex Circuit::add_assertion(
     const StabiliserAssertionBox& assertion_box,
-    const std::vector<Qubit>& qubits, const Qubit& ancilla,
+    const std::vector<Qubit>& qubits, const std::optional<Qubit>& ancilla,
     const std::optional<std::string>& name) {
   auto circ_ptr = assertion_box.to_circuit();
   unsigned pauli_len = assertion_box.get_stabilisers()[0].string.size();
@@ -210,7 +259,13 @@ Vertex Circuit::add_assertion(
 
   unit_vector_t args;
   args.insert(args.end(), qubits.begin(), qubits.end());
-  args.push_back(ancilla);
+  if (ancilla) {
+    args.push_back(*ancilla);
+  } else {
+    Qubit shared_ancilla(q_debug_ancilla_reg(), 0);
+    if (!contains_unit(shared_ancilla)) add_qubit(shared_ancilla);
+    args.push_back(shared_ancilla);
+  }
   append_debug_bits(*this, args, assertion_box.get_expected_readouts(), name);
   return add_op<UnitID>(
       std::make_shared<StabiliserAssertionBox>(assertion_box), args);
@@ -222,6 +277,14 @@ Vertex Circuit::add_vertex(
     const Op_ptr op_ptr, std::optional<std::string> opgroup) {
   Vertex new_V = boost::add_vertex(this->dag);
   this->dag[new_V] = {op_ptr, opgroup};
+  log_change(Change::Kind::Added, new_V);
+  // An isolated vertex is unreachable from the inputs, so has no effect on
+  // any depth metric.
+  bool depth_cache_current = depth_cache_.version == dag_version_;
+  const bool op_counts_were_current = op_counts_current();
+  ++dag_version_;
+  if (depth_cache_current) depth_cache_.version = dag_version_;
+  if (op_counts_were_current) update_op_counts(op_ptr, 1);
   return new_V;
 }
 
@@ -242,6 +305,11 @@ Edge Circuit::add_edge(
   if (edge_pairy.second == false) {
     throw MissingVertex("Cannot create edge between vertices");
   }
+  const bool op_counts_were_current = op_counts_current();
+  ++dag_version_;
+  if (op_counts_were_current) update_op_counts(nullptr, 0);
+  log_change(Change::Kind::Rewired, source.first);
+  log_change(Change::Kind::Rewired, target.first);
   Edge new_E = edge_pairy.first;
   dag[new_E].ports.first = source.second;
   dag[new_E].ports.second = target.second;
@@ -262,7 +330,8 @@ void Circuit::remove_vertex(
     const Vertex& deadvert, GraphRewiring graph_rewiring,
     VertexDeletion vertex_deletion) {
   if (graph_rewiring == GraphRewiring::Yes) {
-    EdgeVec ins = get_in_edges(deadvert);
+    SmallEdgeVec ins;
+    get_in_edges(deadvert, ins);
     std::vector<EdgeVec> bundles = get_b_out_bundles(deadvert);
     port_t p = 0;
     for (const Edge& e : ins) {
@@ -286,10 +355,27 @@ void Circuit::remove_vertex(
     }
   }
 
+  if (changes_) {
+    log_change(Change::Kind::Rewired, deadvert);
+    SmallVertexVec neighbours;
+    get_predecessors(deadvert, neighbours);
+    for (const Vertex& pred : neighbours) {
+      log_change(Change::Kind::Rewired, pred);
+    }
+    get_successors(deadvert, neighbours);
+    for (const Vertex& succ : neighbours) {
+      log_change(Change::Kind::Rewired, succ);
+    }
+  }
   boost::clear_vertex(deadvert, this->dag);
+  const bool op_counts_were_current = op_counts_current();
+  ++dag_version_;
+  if (op_counts_were_current) update_op_counts(nullptr, 0);
   if (vertex_deletion == VertexDeletion::Yes) {
     if (detect_boundary_Op(deadvert))
       throw CircuitInvalidity("Cannot remove a boundary vertex");
+    log_change(Change::Kind::Removed, deadvert, dag[deadvert].op);
+    if (op_counts_were_current) update_op_counts(dag[deadvert].op, -1);
     boost::remove_vertex(deadvert, this->dag);
   }
 }
@@ -312,7 +398,12 @@ void Circuit::remove_vertices(
 }
 
 void Circuit::remove_edge(const Edge& edge) {
+  log_change(Change::Kind::Rewired, source(edge));
+  log_change(Change::Kind::Rewired, target(edge));
   boost::remove_edge(edge, this->dag);
+  const bool op_counts_were_current = op_counts_current();
+  ++dag_version_;
+  if (op_counts_were_current) update_op_counts(nullptr, 0);
 }
 
 void Circuit::flatten_registers() {
@@ -461,7 +552,9 @@ register_t Circuit::add_c_register(std::string reg_name, unsigned size) {
 
 void Circuit::qubit_create(const Qubit& id) {
   Vertex v = get_in(id);
+  log_change(Change::Kind::Replaced, v, dag[v].op);
   dag[v].op = std::make_shared<const MetaOp>(OpType::Create);
+  ++op_version_;
 }
 
 void Circuit::qubit_create_all() {
@@ -472,7 +565,9 @@ void Circuit::qubit_create_all() {
 
 void Circuit::qubit_discard(const Qubit& id) {
   Vertex v = get_out(id);
+  log_change(Change::Kind::Replaced, v, dag[v].op);
   dag[v].op = std::make_shared<const MetaOp>(OpType::Discard);
+  ++op_version_;
 }
 
 void Circuit::qubit_discard_all() {
@@ -486,6 +581,10 @@ void Circuit::qubit_discard_all() {
 void Circuit::rewire(
     const Vertex& new_vert, const EdgeVec& preds, const op_signature_t& types) {
   // multi qubit gate
+  const bool depth_cache_current = depth_cache_.version == dag_version_ &&
+                                   depth_cache_.op_version == op_version_;
+  bool append = boost::degree(new_vert, dag) == 0;
+  VertexVec pred_verts;
   EdgeList bin;
   for (unsigned i = 0; i < preds.size(); ++i) {
     EdgeType insert_type = types[i];
@@ -494,6 +593,9 @@ void Circuit::rewire(
     port_t port2 = get_target_port(preds[i]);
     Vertex old_v1 = source(preds[i]);
     Vertex old_v2 = target(preds[i]);
+    pred_verts.push_back(old_v1);
+    // A write to a classical wire must also follow its readers
+    if (insert_type == EdgeType::Classical) append = false;
     if (insert_type == EdgeType::Boolean) {
       if (replace_type != EdgeType::Classical) {
         throw CircuitInvalidity(
@@ -508,9 +610,11 @@ void Circuit::rewire(
       add_edge({old_v1, port1}, {new_vert, i}, insert_type);
       add_edge({new_vert, i}, {old_v2, port2}, insert_type);
       bin.push_back(preds[i]);
+      if (!detect_final_Op(old_v2)) append = false;
     }
   }
   for (const Edge& e : bin) remove_edge(e);
+  update_depth_cache(new_vert, pred_verts, append, depth_cache_current);
 }
 
 }  // namespace tket
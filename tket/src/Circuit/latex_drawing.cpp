@@ -12,10 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <fstream>
 #include <limits>
+#include <unordered_map>
 
 #include "Boxes.hpp"
 #include "Circuit.hpp"
+#include "CommandView.hpp"
 namespace tket {
 
 struct LineBufferInfo {
@@ -27,13 +30,23 @@ struct LineBufferInfo {
 struct LatexContext {
   std::map<UnitID, unsigned> line_ids;
   std::vector<LineBufferInfo> lines;
+  // Gate labels, which for symbolic parameters are costly to print, are
+  // produced once for each operation
+  std::unordered_map<Op_ptr, std::string> labels;
 };
 
-void add_latex_for_command(LatexContext& context, const Command& command) {
+static void add_wire(LineBufferInfo& line) {
+  if (line.is_quantum) {
+    line.buffer << "\\qw & ";
+  } else {
+    line.buffer << "\\cw & ";
+  }
+}
+
+void add_latex_for_command(
+    LatexContext& context, const Op_ptr& op, unit_vector_t args) {
   std::map<UnitID, unsigned>& line_ids = context.line_ids;
   std::vector<LineBufferInfo>& lines = context.lines;
-  unit_vector_t args = command.get_args();
-  const Op_ptr op = command.get_op_ptr();
   switch (op->get_type()) {
     case OpType::CnRy:
     case OpType::CnX: {
@@ -206,7 +219,7 @@ void add_latex_for_command(LatexContext& context, const Command& command) {
         int index = line_ids.at(args[i]);
         if (index > max_index) max_index = index;
       }
-      add_latex_for_command(context, Command(box.get_op(), target_args));
+      add_latex_for_command(context, box.get_op(), target_args);
       for (unsigned i = 0; i < n_controls; ++i) {
         int index = line_ids.at(args[i]);
         lines.at(index).buffer << "\\ctrl{" << max_index - index << "} & ";
@@ -224,7 +237,7 @@ void add_latex_for_command(LatexContext& context, const Command& command) {
         int index = line_ids.at(args[i]);
         if (index > max_index) max_index = index;
       }
-      add_latex_for_command(context, Command(box.get_op(), target_args));
+      add_latex_for_command(context, box.get_op(), target_args);
       for (unsigned i = 0; i < n_controls; ++i) {
         int index = line_ids.at(args[i]);
         lines.at(index).buffer << "\\cwbend{" << max_index - index << "} & ";
@@ -240,8 +253,10 @@ void add_latex_for_command(LatexContext& context, const Command& command) {
         if (index < min_index) min_index = index;
         if (index > max_index) max_index = index;
       }
+      auto [label, added] = context.labels.insert({op, std::string()});
+      if (added) label->second = op->get_name(true);
       lines.at(min_index).buffer << "\\gate[" << (max_index + 1 - min_index)
-                                 << "]{\\text{" + op->get_name(true) + "}} & ";
+                                 << "]{\\text{" << label->second << "}} & ";
       lines.at(min_index).depth++;
       for (const UnitID& arg : args) {
         unsigned index = line_ids.at(arg);
@@ -254,13 +269,118 @@ void add_latex_for_command(LatexContext& context, const Command& command) {
   }
 }
 
-std::string Circuit::to_latex_str() const {
+// Draws an operation in the columns following the last used on its span of
+// wires, drawing the contents of boxes instead if asked to
+static void place_command(
+    LatexContext& context, const LatexOptions& options, const Op_ptr& op,
+    const unit_vector_t& args) {
+  std::map<UnitID, unsigned>& line_ids = context.line_ids;
+  std::vector<LineBufferInfo>& lines = context.lines;
+  if (options.expand_boxes && is_box_type(op->get_type())) {
+    const Box& box = static_cast<const Box&>(*op);
+    std::shared_ptr<Circuit> body = box.to_circuit();
+    // As for a CircBox, the quantum and classical ports of the box are the
+    // qubits and bits of its circuit, in order
+    qubit_vector_t qbs = body->all_qubits();
+    bit_vector_t cbs = body->all_bits();
+    const op_signature_t& sig = op->get_signature();
+    std::map<UnitID, UnitID> unit_map;
+    unsigned n_q = 0, n_c = 0;
+    for (unsigned p = 0; p < sig.size(); p++) {
+      if (sig[p] == EdgeType::Quantum) {
+        unit_map.insert({qbs.at(n_q++), args.at(p)});
+      } else {
+        unit_map.insert({cbs.at(n_c++), args.at(p)});
+      }
+    }
+    for (const Command& com : body->get_commands()) {
+      unit_vector_t body_args;
+      for (const UnitID& arg : com.get_args()) {
+        body_args.push_back(unit_map.at(arg));
+      }
+      place_command(context, options, com.get_op_ptr(), body_args);
+    }
+    return;
+  }
+
+  std::set<unsigned> used_lines;
+  unsigned min_index = std::numeric_limits<unsigned>::max();
+  unsigned max_index = 0;
+  for (const UnitID& arg : args) {
+    used_lines.insert(line_ids.at(arg));
+  }
+  for (unsigned index : used_lines) {
+    if (index < min_index) min_index = index;
+    if (index > max_index) max_index = index;
+  }
+
+  unsigned max_depth = 0;
+  for (unsigned index = min_index; index <= max_index; index++) {
+    if (lines.at(index).depth > max_depth) max_depth = lines.at(index).depth;
+  }
+  for (unsigned index : used_lines) {
+    for (unsigned d = lines.at(index).depth; d < max_depth; d++) {
+      add_wire(lines.at(index));
+    }
+    lines.at(index).depth = max_depth;
+  }
+
+  add_latex_for_command(context, op, args);
+
+  for (unsigned index = min_index; index <= max_index; index++) {
+    for (unsigned d = lines.at(index).depth; d <= max_depth; d++) {
+      add_wire(lines.at(index));
+    }
+    lines.at(index).depth = max_depth + 1;
+  }
+}
+
+// Brings all wires to the same column
+static void align_lines(LatexContext& context) {
+  unsigned max_depth = 0;
+  for (const LineBufferInfo& l : context.lines) {
+    if (l.depth > max_depth) max_depth = l.depth;
+  }
+  for (LineBufferInfo& l : context.lines) {
+    for (unsigned d = l.depth; d < max_depth; d++) add_wire(l);
+    l.depth = max_depth;
+  }
+}
+
+// Adds a column across all wires marking the layers before it as repeated
+static void mark_repeats(LatexContext& context, unsigned repeats) {
+  align_lines(context);
+  for (unsigned index = 0; index < context.lines.size(); index++) {
+    LineBufferInfo& l = context.lines[index];
+    if (index == 0) {
+      l.buffer << (l.is_quantum ? "\\qw" : "\\cw") << " \\slice{$\\times "
+               << repeats << "$} & ";
+    } else {
+      add_wire(l);
+    }
+    l.depth++;
+  }
+}
+
+typedef std::vector<std::pair<Op_ptr, unit_vector_t>> latex_layer_t;
+
+static bool same_layer(const latex_layer_t& a, const latex_layer_t& b) {
+  if (a.size() != b.size()) return false;
+  for (unsigned i = 0; i < a.size(); i++) {
+    if (a[i].second != b[i].second) return false;
+    if (a[i].first != b[i].first && !(*a[i].first == *b[i].first)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Circuit::to_latex(std::ostream& out, const LatexOptions& options) const {
   // Initial header
-  std::stringstream buffer;
-  buffer << "\\documentclass[tikz]{standalone}\n";
-  buffer << "\\usetikzlibrary{quantikz}\n";
-  buffer << "\\begin{document}\n";
-  buffer << "\\begin{quantikz}\n";
+  out << "\\documentclass[tikz]{standalone}\n";
+  out << "\\usetikzlibrary{quantikz}\n";
+  out << "\\begin{document}\n";
+  out << "\\begin{quantikz}\n";
 
   // Wire labels
   LatexContext context;
@@ -282,61 +402,39 @@ std::string Circuit::to_latex_str() const {
   }
 
   // Commands
-  for (const Command& com : this->get_commands()) {
-    std::set<unsigned> used_lines;
-    unsigned min_index = std::numeric_limits<unsigned>::max();
-    unsigned max_index = 0;
-    for (const UnitID& arg : com.get_args()) {
-      used_lines.insert(line_ids.at(arg));
-    }
-    for (unsigned index : used_lines) {
-      if (index < min_index) min_index = index;
-      if (index > max_index) max_index = index;
-    }
-
-    unsigned max_depth = 0;
-    for (unsigned index = min_index; index <= max_index; index++) {
-      if (lines.at(index).depth > max_depth) max_depth = lines.at(index).depth;
-    }
-    for (unsigned index : used_lines) {
-      for (unsigned d = lines.at(index).depth; d < max_depth; d++) {
-        if (lines.at(index).is_quantum) {
-          lines.at(index).buffer << "\\qw & ";
-        } else {
-          lines.at(index).buffer << "\\cw & ";
-        }
+  if (options.collapse_repeated_layers) {
+    // The views follow the slices in order
+    SliceVec slices = get_slices();
+    CommandViews views(*this);
+    std::size_t next_view = 0;
+    latex_layer_t last_layer;
+    unsigned repeats = 0;
+    for (const Slice& slice : slices) {
+      latex_layer_t layer;
+      for (std::size_t i = 0; i < slice.size(); i++) {
+        const CommandView& com = views[next_view++];
+        layer.push_back({com.get_op_ptr(), com.get_args()});
       }
-      lines.at(index).depth = max_depth;
-    }
-
-    add_latex_for_command(context, com);
-
-    for (unsigned index = min_index; index <= max_index; index++) {
-      for (unsigned d = lines.at(index).depth; d <= max_depth; d++) {
-        if (lines.at(index).is_quantum) {
-          lines.at(index).buffer << "\\qw & ";
-        } else {
-          lines.at(index).buffer << "\\cw & ";
-        }
+      if (repeats > 0 && same_layer(layer, last_layer)) {
+        repeats++;
+        continue;
+      }
+      if (repeats > 1) mark_repeats(context, repeats);
+      for (const std::pair<Op_ptr, unit_vector_t>& com : layer) {
+        place_command(context, options, com.first, com.second);
       }
-      lines.at(index).depth = max_depth + 1;
+      last_layer = std::move(layer);
+      repeats = 1;
+    }
+    if (repeats > 1) mark_repeats(context, repeats);
+  } else {
+    for (const Command& com : this->get_commands()) {
+      place_command(context, options, com.get_op_ptr(), com.get_args());
     }
   }
 
   // Fill out ends
-  unsigned max_depth = 0;
-  for (const LineBufferInfo& l : lines) {
-    if (l.depth > max_depth) max_depth = l.depth;
-  }
-  for (LineBufferInfo& l : lines) {
-    for (unsigned d = l.depth; d < max_depth; d++) {
-      if (l.is_quantum) {
-        l.buffer << "\\qw & ";
-      } else {
-        l.buffer << "\\cw & ";
-      }
-    }
-  }
+  align_lines(context);
   for (LineBufferInfo& l : lines) {
     if (l.is_quantum) {
       l.buffer << "\\qw \\\\";
@@ -345,19 +443,24 @@ std::string Circuit::to_latex_str() const {
     }
   }
 
-  // Build up overall buffer
+  // Write out each wire
   for (LineBufferInfo& l : lines) {
-    buffer << l.buffer.str() << "\n";
+    out << l.buffer.str() << "\n";
   }
-  buffer << "\\end{quantikz}\n";
-  buffer << "\\end{document}";
+  out << "\\end{quantikz}\n";
+  out << "\\end{document}";
+}
 
+std::string Circuit::to_latex_str(const LatexOptions& options) const {
+  std::stringstream buffer;
+  to_latex(buffer, options);
   return buffer.str();
 }
 
-void Circuit::to_latex_file(const std::string& filename) const {
+void Circuit::to_latex_file(
+    const std::string& filename, const LatexOptions& options) const {
   std::ofstream file(filename);
-  file << to_latex_str();
+  to_latex(file, options);
 }
 
 }  // namespace tket
@@ -17,8 +17,10 @@
 ////////////////////////////////////////////////////
 
 #include "Circuit.hpp"
+#include "CompactDAG.hpp"
 #include "OpType/OpType.hpp"
 #include "Ops/OpPtr.hpp"
+#include "UnitPaths.hpp"
 #include "Utils/GraphHeaders.hpp"
 #include "Utils/TketLog.hpp"
 
@@ -44,19 +46,58 @@ bool Circuit::default_regs_ok() const {
 }
 
 std::map<OpType, unsigned> Circuit::op_counts() const {
+  const OpTypeCounts optypes = optype_counts();
   std::map<OpType, unsigned> counts;
-  BGL_FORALL_VERTICES(v, dag, DAG) { counts[get_OpType_from_Vertex(v)]++; }
+  for (std::size_t i = 0; i < n_optypes; ++i) {
+    if (optypes.counts[i] != 0) {
+      counts.insert({static_cast<OpType>(i), optypes.counts[i]});
+    }
+  }
   return counts;
 }
 
-unsigned Circuit::count_gates(const OpType& op_type) const {
-  unsigned counter = 0;
-  BGL_FORALL_VERTICES(v, dag, DAG) {
-    if (get_OpType_from_Vertex(v) == op_type) {
-      ++counter;
+OpTypeMask Circuit::OpTypeCounts::types() const {
+  OpTypeMask mask;
+  for (std::size_t i = 0; i < n_optypes; ++i) {
+    if (counts[i] != 0) mask.set(i);
+  }
+  return mask;
+}
+
+OpTypeMask Circuit::OpTypeCounts::conditioned_types() const {
+  OpTypeMask mask;
+  for (std::size_t i = 0; i < n_optypes; ++i) {
+    if (conditioned[i] != 0) mask.set(i);
+  }
+  return mask;
+}
+
+Circuit::OpTypeCounts Circuit::optype_counts() const {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  if (!op_counts_current()) {
+    op_count_cache_.counts = OpTypeCounts();
+    BGL_FORALL_VERTICES(v, dag, DAG) { update_op_counts(dag[v].op, 1); }
+  }
+  return *op_count_cache_.counts;
+}
+
+void Circuit::update_op_counts(const Op_ptr& op, int delta) const {
+  OpTypeCounts& counts = *op_count_cache_.counts;
+  if (delta != 0) {
+    const OpType type = op->get_type();
+    counts.counts[static_cast<std::size_t>(type)] += delta;
+    if (type == OpType::Conditional) {
+      const OpType inner =
+          static_cast<const Conditional&>(*op).get_op()->get_type();
+      counts.conditioned[static_cast<std::size_t>(inner)] += delta;
     }
   }
-  return counter;
+  op_count_cache_.version = dag_version_;
+  op_count_cache_.op_version = op_version_;
+}
+
+unsigned Circuit::count_gates(const OpType& op_type) const {
+  return optype_counts().counts[static_cast<std::size_t>(op_type)];
 }
 
 VertexSet Circuit::get_gates_of_type(const OpType& op_type) const {
@@ -181,9 +222,29 @@ Circuit Circuit::subcircuit(const Subcircuit& sc) const {
   return sub;
 }
 
+std::shared_ptr<const UnitPathIndex> Circuit::get_unit_path_index() const {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  refresh_traversal_cache();
+  if (!traversal_cache_.unit_paths) {
+    traversal_cache_.unit_paths = std::make_shared<const UnitPathIndex>(*this);
+  }
+  return traversal_cache_.unit_paths;
+}
+
+std::shared_ptr<const UnitPathIndex> Circuit::current_unit_path_index() const {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  refresh_traversal_cache();
+  return traversal_cache_.unit_paths;
+}
+
 // returns qubit path via vertices & inhabited port in vertices
 // used to construct a routing grid
 QPathDetailed Circuit::unit_path(const UnitID& unit) const {
+  // Building the index for every unit costs more than walking one wire, so
+  // it is only used here if it is already current
+  if (std::shared_ptr<const UnitPathIndex> index = current_unit_path_index()) {
+    return index->path(unit);
+  }
   Vertex current_v = get_in(unit);
   QPathDetailed path = {{current_v, 0}};
   Edge betweenEdge = get_nth_out_edge(current_v, 0);
@@ -205,20 +266,22 @@ QPathDetailed Circuit::unit_path(const UnitID& unit) const {
 // returns a vector of each qubits path via qubit_path
 // this is all the information required to make a circuit
 std::vector<QPathDetailed> Circuit::all_qubit_paths() const {
+  std::shared_ptr<const UnitPathIndex> index = get_unit_path_index();
   std::vector<QPathDetailed> new_list_of_paths;
   for (const Qubit& q : all_qubits()) {
-    new_list_of_paths.push_back(unit_path(q));
+    new_list_of_paths.push_back(index->path(q));
   }
   return new_list_of_paths;
 }
 
 std::map<UnitID, QPathDetailed> Circuit::all_unit_paths() const {
+  std::shared_ptr<const UnitPathIndex> index = get_unit_path_index();
   std::map<UnitID, QPathDetailed> new_list_of_paths;
   for (const Qubit& q : all_qubits()) {
-    new_list_of_paths.insert({q, unit_path(q)});
+    new_list_of_paths.insert({q, index->path(q)});
   }
   for (const Bit& b : all_bits()) {
-    new_list_of_paths.insert({b, unit_path(b)});
+    new_list_of_paths.insert({b, index->path(b)});
   }
   return new_list_of_paths;
 }
@@ -290,11 +353,20 @@ VertexVec Circuit::qubit_path_vertices(const Qubit& qubit) const {
 // vertices
 // requires the boundaries to be correct and the circuit to be fully connected
 SliceVec Circuit::get_slices() const {
-  SliceVec slices;
-  for (SliceIterator sit = this->slice_begin(); sit != slice_end(); ++sit) {
-    slices.push_back(*sit);
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  refresh_traversal_cache();
+  if (!traversal_cache_.slices) {
+    SliceVec slices;
+    for (SliceIterator sit = this->slice_begin(); sit != slice_end(); ++sit) {
+      slices.push_back(*sit);
+    }
+    traversal_cache_.slices = std::move(slices);
   }
-  return slices;
+  return *traversal_cache_.slices;
+}
+
+SliceVec Circuit::get_slices_by_layer() const {
+  return CompactDAG(*this).slices();
 }
 
 Edge Circuit::skip_irrelevant_edges(Edge current) const {
@@ -581,49 +653,89 @@ SliceVec Circuit::get_reverse_slices() const {
   return rev_slices;
 }
 
+static bool is_barrier(Op_ptr op) { return op->get_type() == OpType::Barrier; }
+
 unsigned Circuit::depth() const {
-  unsigned count = 0;
-  std::function<bool(Op_ptr)> skip_func = [&](Op_ptr op) {
-    return (op->get_type() == OpType::Barrier);
-  };
-  Circuit::SliceIterator slice_iter(*this, skip_func);
-  if (!(*slice_iter).empty()) count++;
-  while (!slice_iter.finished()) {
-    slice_iter.cut_ = this->next_cut(
-        slice_iter.cut_.u_frontier, slice_iter.cut_.b_frontier, skip_func);
-    if (!(*slice_iter).empty()) count++;
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  refresh_depth_cache();
+  if (!depth_cache_.layers) {
+    CompactDAG compact(*this);
+    std::vector<std::optional<unsigned>> layers = compact.layers(is_barrier);
+    std::unordered_map<Vertex, unsigned> layer_map;
+    unsigned d = 0;
+    for (unsigned i = 0; i < layers.size(); ++i) {
+      if (!layers[i]) continue;
+      layer_map.insert({compact.get_vertex(i), *layers[i]});
+      if (*layers[i] > d) d = *layers[i];
+    }
+    depth_cache_.layers = std::move(layer_map);
+    depth_cache_.depth = d;
   }
-  return count;
+  return depth_cache_.depth;
 }
 
 unsigned Circuit::depth_by_type(OpType _type) const {
-  unsigned count = 0;
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  refresh_depth_cache();
+  std::map<OpType, unsigned>::const_iterator found =
+      depth_cache_.by_type.find(_type);
+  if (found != depth_cache_.by_type.end()) return found->second;
   std::function<bool(Op_ptr)> skip_func = [&](Op_ptr op) {
     return (op->get_type() != _type);
   };
-  Circuit::SliceIterator slice_iter(*this, skip_func);
-  if (!(*slice_iter).empty()) count++;
-  while (!slice_iter.finished()) {
-    slice_iter.cut_ = this->next_cut(
-        slice_iter.cut_.u_frontier, slice_iter.cut_.b_frontier, skip_func);
-    if (!(*slice_iter).empty()) count++;
-  }
-  return count;
+  unsigned d = CompactDAG(*this).max_layer(skip_func);
+  depth_cache_.by_type.insert({_type, d});
+  return d;
 }
 
 unsigned Circuit::depth_by_types(const OpTypeSet& _types) const {
-  unsigned count = 0;
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  refresh_depth_cache();
+  std::set<OpType> key(_types.begin(), _types.end());
+  std::map<std::set<OpType>, unsigned>::const_iterator found =
+      depth_cache_.by_types.find(key);
+  if (found != depth_cache_.by_types.end()) return found->second;
   std::function<bool(Op_ptr)> skip_func = [&](Op_ptr op) {
     return (_types.find(op->get_type()) == _types.end());
   };
-  Circuit::SliceIterator slice_iter(*this, skip_func);
-  if (!(*slice_iter).empty()) count++;
-  while (!slice_iter.finished()) {
-    slice_iter.cut_ = this->next_cut(
-        slice_iter.cut_.u_frontier, slice_iter.cut_.b_frontier, skip_func);
-    if (!(*slice_iter).empty()) count++;
+  unsigned d = CompactDAG(*this).max_layer(skip_func);
+  depth_cache_.by_types.insert({key, d});
+  return d;
+}
+
+void Circuit::refresh_depth_cache() const {
+  if (depth_cache_.version != dag_version_ ||
+      depth_cache_.op_version != op_version_) {
+    depth_cache_ = DepthCache();
+    depth_cache_.version = dag_version_;
+    depth_cache_.op_version = op_version_;
+  }
+}
+
+void Circuit::update_depth_cache(
+    const Vertex& new_vert, const VertexVec& preds, bool append,
+    bool was_current) {
+  if (!was_current || !append || !depth_cache_.layers) {
+    return;
+  }
+  std::unordered_map<Vertex, unsigned>& layers = *depth_cache_.layers;
+  unsigned m = 0;
+  for (const Vertex& pred : preds) {
+    std::unordered_map<Vertex, unsigned>::const_iterator found =
+        layers.find(pred);
+    if (found == layers.end()) {
+      // Predecessor not reachable from the inputs: recompute from scratch
+      return;
+    }
+    if (found->second > m) m = found->second;
   }
-  return count;
+  unsigned layer = is_barrier(get_Op_ptr_from_Vertex(new_vert)) ? m : m + 1;
+  layers.insert({new_vert, layer});
+  if (layer > depth_cache_.depth) depth_cache_.depth = layer;
+  // Metrics restricted to operation types are not maintained incrementally
+  depth_cache_.by_type.clear();
+  depth_cache_.by_types.clear();
+  depth_cache_.version = dag_version_;
 }
 
 std::map<Vertex, unit_set_t> Circuit::vertex_unit_map() const {
@@ -639,16 +751,18 @@ std::map<Vertex, unit_set_t> Circuit::vertex_unit_map() const {
 
 std::map<Vertex, unsigned> Circuit::vertex_depth_map() const {
   std::map<Vertex, unsigned> map;
-  unsigned i = 0;
-  for (SliceIterator it = slice_begin(); it != slice_end(); ++it) {
-    for (const Vertex& v : *it) {
-      map[v] = i;
-    }
-    i++;
+  CompactDAG compact(*this);
+  std::vector<std::optional<unsigned>> layers = compact.layers();
+  unsigned n_slices = 0;
+  for (unsigned i = 0; i < layers.size(); ++i) {
+    const std::optional<unsigned>& l = layers[i];
+    if (!l || *l == 0) continue;
+    map[compact.get_vertex(i)] = *l - 1;
+    if (*l > n_slices) n_slices = *l;
   }
   for (const BoundaryElement& el : boundary) {
     map[el.in_] = 0;
-    map[el.out_] = i;
+    map[el.out_] = n_slices;
   }
   return map;
 }
@@ -679,6 +793,53 @@ std::map<Edge, UnitID> Circuit::edge_unit_map() const {
   return map;
 }
 
+VertexArray<unit_set_t> Circuit::vertex_unit_array() /*const*/ {
+  index_vertices();
+  VertexArray<unit_set_t> array(dag);
+  BGL_FORALL_VERTICES(v, dag, DAG) { array[v]; }
+  for (const std::pair<const UnitID, QPathDetailed>& path : all_unit_paths()) {
+    for (const VertPort& vp : path.second) {
+      array[vp.first].insert(path.first);
+    }
+  }
+  return array;
+}
+
+VertexArray<unsigned> Circuit::vertex_depth_array() /*const*/ {
+  index_vertices();
+  VertexArray<unsigned> array(dag);
+  CompactDAG compact(*this);
+  std::vector<std::optional<unsigned>> layers = compact.layers();
+  unsigned n_slices = 0;
+  for (unsigned i = 0; i < layers.size(); ++i) {
+    const std::optional<unsigned>& l = layers[i];
+    if (!l || *l == 0) continue;
+    array[compact.get_vertex(i)] = *l - 1;
+    if (*l > n_slices) n_slices = *l;
+  }
+  for (const BoundaryElement& el : boundary) {
+    array[el.in_] = 0;
+    array[el.out_] = n_slices;
+  }
+  return array;
+}
+
+VertexArray<unsigned> Circuit::vertex_rev_depth_array() /*const*/ {
+  index_vertices();
+  VertexArray<unsigned> array(dag);
+  SliceVec slices = get_reverse_slices();
+  for (unsigned i = 0; i < slices.size(); i++) {
+    for (const Vertex& v : slices[i]) {
+      array[v] = i;
+    }
+  }
+  for (const BoundaryElement& el : boundary) {
+    array[el.in_] = slices.size();
+    array[el.out_] = 0;
+  }
+  return array;
+}
+
 /*SliceIterator related methods*/
 Circuit::SliceIterator::SliceIterator(const Circuit& circ)
     : cut_(), circ_(&circ) {
@@ -16,18 +16,26 @@
 // ALL METHODS TO PERFORM COMPLEX CIRCUIT MANIPULATION//
 /////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
 #include <memory>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
 
 #include "Circuit.hpp"
 #include "Gate/Gate.hpp"
 #include "Ops/ClassicalOps.hpp"
+#include "Utils/Parallel.hpp"
 #include "Utils/TketLog.hpp"
 #include "Utils/UnitID.hpp"
 namespace tket {
 
-vertex_map_t Circuit::copy_graph(
-    const Circuit& c2, BoundaryMerge boundary_merge,
-    OpGroupTransfer opgroup_transfer) {
+void Circuit::transfer_opgroups(
+    const Circuit& c2, OpGroupTransfer opgroup_transfer) {
   switch (opgroup_transfer) {
     case OpGroupTransfer::Preserve:
       // Fail if any collisions.
@@ -63,6 +71,12 @@ vertex_map_t Circuit::copy_graph(
       // Ignore inserted opgroups
       break;
   }
+}
+
+vertex_map_t Circuit::copy_graph(
+    const Circuit& c2, BoundaryMerge boundary_merge,
+    OpGroupTransfer opgroup_transfer) {
+  transfer_opgroups(c2, opgroup_transfer);
 
   vertex_map_t isomap;
   if (&c2 == this) {
@@ -72,6 +86,8 @@ vertex_map_t Circuit::copy_graph(
   }
   BGL_FORALL_VERTICES(v, c2.dag, DAG) {
     Vertex v0 = boost::add_vertex(this->dag);
+    ++dag_version_;
+    log_change(Change::Kind::Added, v0);
     this->dag[v0].op = c2.get_Op_ptr_from_Vertex(v);
     if (opgroup_transfer == OpGroupTransfer::Preserve ||
         opgroup_transfer == OpGroupTransfer::Merge) {
@@ -134,75 +150,87 @@ void Circuit::append(const Circuit& c2) { append_with_map(c2, {}); }
 void Circuit::append_with_map(const Circuit& c2, const unit_map_t& qm) {
   Circuit copy = c2;
   copy.rename_units(qm);
+  append(std::move(copy));
+}
 
+void Circuit::append(Circuit&& c2) {
+  if (&c2 == this) {
+    append(static_cast<const Circuit&>(c2));
+    return;
+  }
   // Check what we need to do at the joins:
   //   Output  --- Input    ==>   -------------
   //   Output  --- Create   ==>   --- Reset ---
   //   Discard --- Input    ==>   [not allowed]
   //   Discard --- Create   ==>   --- Reset ---
-  qubit_vector_t qbs = copy.all_qubits();
-  std::set<Qubit> qbs_set(qbs.begin(), qbs.end());
   std::set<Qubit> reset_qbs;
-  for (auto qb : all_qubits()) {
-    if (qbs_set.find(qb) != qbs_set.end()) {
-      if (copy.is_created(qb)) {
-        reset_qbs.insert(qb);
-      } else if (is_discarded(qb)) {
-        throw CircuitInvalidity("Cannot append input qubit to discarded qubit");
-      }
+  for (const BoundaryElement& el : c2.boundary.get<TagID>()) {
+    std::string reg_name = el.reg_name();
+    opt_reg_info_t reg_found = get_reg_info(reg_name);
+    if (reg_found && reg_found.value() != el.reg_info()) {
+      throw Unsupported(
+          "Cannot append circuits with different types for "
+          "register with name: " +
+          reg_name);
+    }
+    if (el.type() != UnitType::Qubit) continue;
+    Qubit qb(el.id_);
+    if (boundary.get<TagID>().find(el.id_) == boundary.get<TagID>().end()) {
+      continue;
+    }
+    if (c2.is_created(qb)) {
+      reset_qbs.insert(qb);
+    } else if (is_discarded(qb)) {
+      throw CircuitInvalidity("Cannot append input qubit to discarded qubit");
     }
   }
+  // Checked up front, so that a failure leaves both circuits unchanged
+  transfer_opgroups(c2, OpGroupTransfer::Merge);
 
-  // Copy c2 into c1 but do not merge boundaries
-  vertex_map_t vm = copy_graph(copy, BoundaryMerge::No);
+  // Move c2's vertices and edges into this circuit. Their storage is
+  // node-based and the allocator stateless, so the nodes are relinked rather
+  // than copied and every descriptor of c2 stays valid here.
+  const Expr phase = c2.get_phase();
+  const boundary_t c2_boundary = std::move(c2.boundary);
+  if (changes_) {
+    BGL_FORALL_VERTICES(v, c2.dag, DAG) { log_change(Change::Kind::Added, v); }
+  }
+  dag.m_vertices.splice(dag.m_vertices.end(), c2.dag.m_vertices);
+  dag.m_edges.splice(dag.m_edges.end(), c2.dag.m_edges);
+  ++dag_version_;
+  c2 = Circuit();
+  c2.opgroupsigs.clear();
   const Op_ptr noop = get_op_ptr(OpType::noop);
 
   // Connect each matching qubit and bit, merging remainder
-  for (const BoundaryElement& el : copy.boundary.get<TagID>()) {
-    std::string reg_name = el.reg_name();
-    register_info_t reg_type = el.reg_info();
-    opt_reg_info_t reg_found = get_reg_info(reg_name);
-    if (reg_found) {
-      if (reg_found.value() != reg_type) {
-        throw Unsupported(
-            "Cannot append circuits with different types for "
-            "register with name: " +
-            reg_name);
-      }
-      boundary_t::iterator unit_found = boundary.get<TagID>().find(el.id_);
-      if (unit_found != boundary.get<TagID>().end()) {
-        Vertex out = unit_found->out_;
-        Vertex in = vm[el.in_];
-        // Update map
-        BoundaryElement new_elem = *unit_found;
-        new_elem.out_ = vm[el.out_];
-        boundary.replace(unit_found, new_elem);
-        // Tie together
-        if (reg_type.first == UnitType::Qubit)
-          add_edge({out, 0}, {in, 0}, EdgeType::Quantum);
-        else
-          add_edge({out, 0}, {in, 0}, EdgeType::Classical);
-        dag[out].op = noop;
-        dag[in].op = noop;
-        remove_vertex(out, GraphRewiring::Yes, VertexDeletion::Yes);
-        if (el.type() != UnitType::Qubit ||
-            reset_qbs.find(Qubit(el.id_)) == reset_qbs.end()) {
-          remove_vertex(in, GraphRewiring::Yes, VertexDeletion::Yes);
-        } else {
-          dag[in].op = std::make_shared<const Gate>(OpType::Reset);
-        }
-      } else {
-        Vertex new_in = vm[el.in_];
-        Vertex new_out = vm[el.out_];
-        boundary.insert({el.id_, new_in, new_out});
-      }
+  for (const BoundaryElement& el : c2_boundary.get<TagID>()) {
+    boundary_t::iterator unit_found = boundary.get<TagID>().find(el.id_);
+    if (unit_found == boundary.get<TagID>().end()) {
+      boundary.insert(el);
+      continue;
+    }
+    Vertex out = unit_found->out_;
+    Vertex in = el.in_;
+    // Update map
+    BoundaryElement new_elem = *unit_found;
+    new_elem.out_ = el.out_;
+    boundary.replace(unit_found, new_elem);
+    // Tie together
+    if (el.type() == UnitType::Qubit)
+      add_edge({out, 0}, {in, 0}, EdgeType::Quantum);
+    else
+      add_edge({out, 0}, {in, 0}, EdgeType::Classical);
+    dag[out].op = noop;
+    dag[in].op = noop;
+    remove_vertex(out, GraphRewiring::Yes, VertexDeletion::Yes);
+    if (el.type() != UnitType::Qubit ||
+        reset_qbs.find(Qubit(el.id_)) == reset_qbs.end()) {
+      remove_vertex(in, GraphRewiring::Yes, VertexDeletion::Yes);
     } else {
-      Vertex new_in = vm[el.in_];
-      Vertex new_out = vm[el.out_];
-      boundary.insert({el.id_, new_in, new_out});
+      dag[in].op = std::make_shared<const Gate>(OpType::Reset);
     }
   }
-  add_phase(c2.get_phase());
+  add_phase(phase);
 }
 
 void Circuit::append_qubits(
@@ -302,17 +330,200 @@ void Circuit::substitute(
   add_phase(to_insert.get_phase());
 }
 
+// The boundary vertices of the inserted circuits are never copied. An edge
+// leaving an input is attached directly to the source of the matching
+// in-hole edge or, if that source is being replaced as well, to wherever the
+// neighbouring replacement's output resolves to. All new edges are computed
+// before any hole edge is removed, since resolving them reads the holes.
+void Circuit::substitute_disjoint(
+    const std::vector<std::pair<Subcircuit, const Circuit*>>& replacements,
+    VertexDeletion vertex_deletion, OpGroupTransfer opgroup_transfer) {
+  const unsigned n_subs = replacements.size();
+  // Replacement to which each replaced vertex belongs
+  std::unordered_map<Vertex, unsigned> owner;
+  // Input vertices of each inserted circuit, with the in-hole edges of the
+  // same units
+  std::vector<std::map<Vertex, Edge>> in_holes(n_subs);
+  EdgeSet in_hole_edges;
+  // Out-hole edges, with the replacement and output vertex of the same unit
+  std::map<Edge, std::pair<unsigned, Vertex>> out_holes;
+  auto add_hole = [&](unsigned k, const Edge& in, const Edge& out,
+                      const UnitID& unit) {
+    const Circuit& to_insert = *replacements[k].second;
+    if (!in_hole_edges.insert(in).second ||
+        !out_holes.insert({out, {k, to_insert.get_out(unit)}}).second) {
+      throw CircuitInvalidity("Subcircuits to replace overlap");
+    }
+    in_holes[k].insert({to_insert.get_in(unit), in});
+  };
+  for (unsigned k = 0; k < n_subs; ++k) {
+    const Subcircuit& sub = replacements[k].first;
+    const Circuit& to_insert = *replacements[k].second;
+    if (!to_insert.is_simple()) throw SimpleOnly();
+    if (to_insert.n_qubits() != sub.q_in_hole.size() ||
+        to_insert.n_qubits() != sub.q_out_hole.size() ||
+        to_insert.n_bits() != sub.c_in_hole.size() ||
+        to_insert.n_bits() != sub.c_out_hole.size())
+      throw CircuitInvalidity("Subcircuit boundary mismatch to hole");
+    for (const Vertex& v : sub.verts) {
+      if (!owner.insert({v, k}).second) {
+        throw CircuitInvalidity("Subcircuits to replace overlap");
+      }
+    }
+    for (unsigned i = 0; i < sub.q_in_hole.size(); ++i) {
+      add_hole(k, sub.q_in_hole[i], sub.q_out_hole[i], Qubit(i));
+    }
+    for (unsigned i = 0; i < sub.c_in_hole.size(); ++i) {
+      add_hole(k, sub.c_in_hole[i], sub.c_out_hole[i], Bit(i));
+    }
+  }
+
+  // Copy the operations of each inserted circuit
+  std::vector<std::unordered_map<Vertex, Vertex>> vms(n_subs);
+  const bool keep_opgroups = opgroup_transfer == OpGroupTransfer::Preserve ||
+                             opgroup_transfer == OpGroupTransfer::Merge;
+  for (unsigned k = 0; k < n_subs; ++k) {
+    const Circuit& to_insert = *replacements[k].second;
+    transfer_opgroups(to_insert, opgroup_transfer);
+    BGL_FORALL_VERTICES(v, to_insert.dag, DAG) {
+      if (to_insert.detect_boundary_Op(v)) continue;
+      std::optional<std::string> opgroup;
+      if (keep_opgroups) opgroup = to_insert.get_opgroup_from_Vertex(v);
+      vms[k].insert(
+          {v, add_vertex(to_insert.get_Op_ptr_from_Vertex(v), opgroup)});
+    }
+  }
+
+  // Source, in the spliced DAG, of an edge leaving port p of vertex v of the
+  // k-th inserted circuit
+  std::function<VertPort(unsigned, const Vertex&, port_t)> resolve_source =
+      [&](unsigned k, const Vertex& v, port_t p) -> VertPort {
+    std::unordered_map<Vertex, Vertex>::const_iterator copy = vms[k].find(v);
+    if (copy != vms[k].end()) return {copy->second, p};
+    // v is an input, so continue from the in-hole edge of its unit
+    const Edge& hole = in_holes[k].at(v);
+    Vertex pred = source(hole);
+    if (owner.find(pred) == owner.end()) return {pred, get_source_port(hole)};
+    // The edge leaves another replacement: continue from its output
+    std::map<Edge, std::pair<unsigned, Vertex>>::const_iterator shared =
+        out_holes.find(hole);
+    if (shared == out_holes.end()) {
+      throw CircuitInvalidity("Subcircuits to replace overlap");
+    }
+    const auto& [m, out_v] = shared->second;
+    const Circuit& pred_insert = *replacements[m].second;
+    Edge last = pred_insert.get_nth_in_edge(out_v, 0);
+    return resolve_source(
+        m, pred_insert.source(last), pred_insert.get_source_port(last));
+  };
+  // Source, in the spliced DAG, of the output of the k-th inserted circuit
+  auto resolve_output = [&](unsigned k, const Vertex& out_v) {
+    const Circuit& to_insert = *replacements[k].second;
+    Edge last = to_insert.get_nth_in_edge(out_v, 0);
+    return resolve_source(
+        k, to_insert.source(last), to_insert.get_source_port(last));
+  };
+
+  struct NewEdge {
+    VertPort source;
+    VertPort target;
+    EdgeType type;
+  };
+  std::vector<NewEdge> new_edges;
+  EdgeSet ebin = in_hole_edges;
+  Expr phase = 0;
+  for (unsigned k = 0; k < n_subs; ++k) {
+    const Subcircuit& sub = replacements[k].first;
+    const Circuit& to_insert = *replacements[k].second;
+    phase += to_insert.get_phase();
+    // Edges into copied operations
+    BGL_FORALL_EDGES(e, to_insert.dag, DAG) {
+      std::unordered_map<Vertex, Vertex>::const_iterator target_copy =
+          vms[k].find(to_insert.target(e));
+      if (target_copy == vms[k].end()) continue;
+      new_edges.push_back(
+          {resolve_source(
+               k, to_insert.source(e), to_insert.get_source_port(e)),
+           {target_copy->second, to_insert.get_target_port(e)},
+           to_insert.get_edgetype(e)});
+    }
+    // Edges out of the subcircuit, unless they lead into another one (in
+    // which case that one's copied operations take them)
+    for (const EdgeVec* holes : {&sub.q_out_hole, &sub.c_out_hole}) {
+      for (const Edge& hole : *holes) {
+        ebin.insert(hole);
+        Vertex succ = target(hole);
+        if (owner.find(succ) != owner.end()) {
+          if (in_hole_edges.find(hole) == in_hole_edges.end()) {
+            throw CircuitInvalidity("Subcircuits to replace overlap");
+          }
+          continue;
+        }
+        new_edges.push_back(
+            {resolve_output(k, out_holes.at(hole).second),
+             {succ, get_target_port(hole)},
+             get_edgetype(hole)});
+      }
+    }
+    for (const Edge& e : sub.b_future) {
+      ebin.insert(e);
+      Vertex succ = target(e);
+      // Dropped with the vertex it leads into
+      if (owner.find(succ) != owner.end()) continue;
+      Edge c_out = get_nth_out_edge(source(e), get_source_port(e));
+      std::map<Edge, std::pair<unsigned, Vertex>>::const_iterator hole =
+          out_holes.find(c_out);
+      if (hole == out_holes.end() || hole->second.first != k) {
+        throw CircuitInvalidity("Subcircuit boundary mismatch to hole");
+      }
+      new_edges.push_back(
+          {resolve_output(k, hole->second.second),
+           {succ, get_target_port(e)},
+           EdgeType::Boolean});
+    }
+  }
+
+  for (const Edge& e : ebin) {
+    remove_edge(e);
+  }
+  for (const NewEdge& e : new_edges) {
+    add_edge(e.source, e.target, e.type);
+  }
+  VertexList replaced;
+  for (const std::pair<Subcircuit, const Circuit*>& r : replacements) {
+    replaced.insert(replaced.end(), r.first.verts.begin(), r.first.verts.end());
+  }
+  remove_vertices(replaced, GraphRewiring::No, vertex_deletion);
+  add_phase(phase);
+}
+
+static Subcircuit vertex_subcircuit(const Circuit& circ, const Vertex& v) {
+  return {
+      circ.get_in_edges_of_type(v, EdgeType::Quantum),
+      circ.get_out_edges_of_type(v, EdgeType::Quantum),
+      circ.get_in_edges_of_type(v, EdgeType::Classical),
+      circ.get_out_edges_of_type(v, EdgeType::Classical),
+      circ.get_out_edges_of_type(v, EdgeType::Boolean),
+      {v}};
+}
+
+// Replacements of each of the vertices by the same circuit
+static std::vector<std::pair<Subcircuit, const Circuit*>> vertex_replacements(
+    const Circuit& circ, const VertexVec& verts, const Circuit& to_insert) {
+  std::vector<std::pair<Subcircuit, const Circuit*>> replacements;
+  replacements.reserve(verts.size());
+  for (const Vertex& v : verts) {
+    replacements.push_back({vertex_subcircuit(circ, v), &to_insert});
+  }
+  return replacements;
+}
+
 void Circuit::substitute(
     const Circuit& to_insert, const Vertex& to_replace,
     VertexDeletion vertex_deletion, OpGroupTransfer opgroup_transfer) {
-  Subcircuit sub = {
-      get_in_edges_of_type(to_replace, EdgeType::Quantum),
-      get_out_edges_of_type(to_replace, EdgeType::Quantum),
-      get_in_edges_of_type(to_replace, EdgeType::Classical),
-      get_out_edges_of_type(to_replace, EdgeType::Classical),
-      get_out_edges_of_type(to_replace, EdgeType::Boolean),
-      {to_replace}};
-  substitute(to_insert, sub, vertex_deletion, opgroup_transfer);
+  substitute(
+      to_insert, vertex_subcircuit(*this, to_replace), vertex_deletion,
+      opgroup_transfer);
 }
 
 void Circuit::substitute_conditional(
@@ -496,6 +707,79 @@ Circuit Circuit::transpose() const {
   return c;
 }
 
+void Circuit::_reverse_in_place(ReverseType reverse_op) {
+  // Find all the new operations before changing anything
+  std::vector<std::pair<Vertex, Op_ptr>> new_ops;
+  bool has_bits = false;
+  BGL_FORALL_VERTICES(v, dag, DAG) {
+    const Op_ptr op = get_Op_ptr_from_Vertex(v);
+    OpDesc desc = op->get_desc();
+    switch (desc.type()) {
+      case OpType::Input:
+        new_ops.push_back({v, get_op_ptr(OpType::Output)});
+        break;
+      case OpType::Output:
+        new_ops.push_back({v, get_op_ptr(OpType::Input)});
+        break;
+      case OpType::ClInput:
+        has_bits = true;
+        new_ops.push_back({v, get_op_ptr(OpType::ClOutput)});
+        break;
+      case OpType::ClOutput:
+        new_ops.push_back({v, get_op_ptr(OpType::ClInput)});
+        break;
+      default:
+        if ((desc.is_gate() || desc.is_box()) && !desc.is_oneway()) {
+          new_ops.push_back(
+              {v, reverse_op == ReverseType::dagger ? op->dagger()
+                                                    : op->transpose()});
+        } else {
+          throw CircuitInvalidity(
+              "Cannot dagger or transpose op: " + op->get_name());
+        }
+    }
+  }
+  if (has_bits) {
+    tket_log()->warn(
+        "The circuit contains classical data for which the dagger/transpose "
+        "might not be defined.");
+  }
+  for (const std::pair<Vertex, Op_ptr>& vop : new_ops) {
+    set_vertex_Op_ptr(vop.first, vop.second);
+  }
+
+  // Reverse every edge, keeping its ports at each end
+  std::vector<std::pair<Edge, EdgeProperties>> edges;
+  edges.reserve(boost::num_edges(dag));
+  E_iterator ei, eend;
+  for (std::tie(ei, eend) = boost::edges(dag); ei != eend; ei++) {
+    edges.push_back({*ei, dag[*ei]});
+  }
+  for (const std::pair<Edge, EdgeProperties>& ep : edges) {
+    Vertex s = source(ep.first);
+    Vertex t = target(ep.first);
+    remove_edge(ep.first);
+    add_edge(
+        {t, ep.second.ports.second}, {s, ep.second.ports.first},
+        ep.second.type);
+  }
+
+  // The outputs of each unit become its inputs
+  boundary_t::index<TagID>::type& by_id = boundary.get<TagID>();
+  for (auto it = by_id.begin(); it != by_id.end(); ++it) {
+    by_id.modify(it, [](BoundaryElement& el) { std::swap(el.in_, el.out_); });
+  }
+}
+
+void Circuit::dagger_in_place() {
+  _reverse_in_place(ReverseType::dagger);
+  phase = -phase;
+}
+
+void Circuit::transpose_in_place() {
+  _reverse_in_place(ReverseType::transpose);
+}
+
 bool Circuit::substitute_all(const Circuit& to_insert, const Op_ptr op) {
   if (!to_insert.is_simple()) throw SimpleOnly();
   if (op->n_qubits() != to_insert.n_qubits())
@@ -513,9 +797,7 @@ bool Circuit::substitute_all(const Circuit& to_insert, const Op_ptr op) {
       if (*cond.get_op() == *op) conditional_to_replace.push_back(v);
     }
   }
-  for (const Vertex& v : to_replace) {
-    substitute(to_insert, v, VertexDeletion::Yes);
-  }
+  substitute_disjoint(vertex_replacements(*this, to_replace, to_insert));
   for (const Vertex& v : conditional_to_replace) {
     substitute_conditional(to_insert, v, VertexDeletion::Yes);
   }
@@ -556,9 +838,9 @@ bool Circuit::substitute_named(
     }
   }
 
-  for (const Vertex& v : to_replace) {
-    substitute(to_insert, v, VertexDeletion::Yes, OpGroupTransfer::Merge);
-  }
+  substitute_disjoint(
+      vertex_replacements(*this, to_replace, to_insert), VertexDeletion::Yes,
+      OpGroupTransfer::Merge);
 
   return !to_replace.empty();
 }
@@ -590,9 +872,9 @@ bool Circuit::substitute_named(Op_ptr to_insert, const std::string opname) {
   for (unsigned i = 0; i < sig_n_q; i++) args[i] = Qubit(i);
   for (unsigned i = 0; i < sig_n_c; i++) args[sig_n_q + i] = Bit(i);
   c.add_op(to_insert, args, opname);
-  for (const Vertex& v : to_replace) {
-    substitute(c, v, VertexDeletion::Yes, OpGroupTransfer::Merge);
-  }
+  substitute_disjoint(
+      vertex_replacements(*this, to_replace, c), VertexDeletion::Yes,
+      OpGroupTransfer::Merge);
 
   return !to_replace.empty();
 }
@@ -629,35 +911,176 @@ Circuit Circuit::conditional_circuit(
   return cond_circ;
 }
 
+// The box of an operation, or of the operation of a conditional
+static const Box* get_box(Op_ptr op) {
+  if (op->get_type() == OpType::Conditional) {
+    op = static_cast<const Conditional&>(*op).get_op();
+  }
+  if (!op->get_desc().is_box()) return nullptr;
+  return static_cast<const Box*>(op.get());
+}
+
+// Generate the circuits of boxes, in parallel
+static void generate_box_circuits(const std::vector<const Box*>& boxes) {
+  parallel_for(0, boxes.size(), 4, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      boxes[i]->to_circuit();
+    }
+  });
+}
+
+// Replace a box vertex by a circuit
+static void substitute_box(
+    Circuit& circ, const Circuit& replacement, const Vertex& v) {
+  if (circ.get_OpType_from_Vertex(v) == OpType::Conditional) {
+    circ.substitute_conditional(
+        replacement, v, Circuit::VertexDeletion::No,
+        Circuit::OpGroupTransfer::Merge);
+  } else {
+    circ.substitute(
+        replacement, v, Circuit::VertexDeletion::No,
+        Circuit::OpGroupTransfer::Merge);
+  }
+}
+
 bool Circuit::decompose_boxes() {
+  // Box circuits are generated on first use, and generating them (e.g.
+  // synthesising a PhasePolyBox) can dominate; do it once for each distinct
+  // box in parallel before substituting them in turn. Copies of a box share
+  // its id and its circuit. Boxes nested in others are decomposed in later
+  // rounds.
   bool success = false;
-  VertexList bin;
-  BGL_FORALL_VERTICES(v, dag, DAG) {
-    Op_ptr op = get_Op_ptr_from_Vertex(v);
-    bool conditional = op->get_type() == OpType::Conditional;
-    if (conditional) {
-      const Conditional& cond = static_cast<const Conditional&>(*op);
-      op = cond.get_op();
-    }
-    if (!op->get_desc().is_box()) continue;
-    const Box& b = static_cast<const Box&>(*op);
-    Circuit replacement = *b.to_circuit();
-    if (conditional) {
-      substitute_conditional(
-          replacement, v, VertexDeletion::No, OpGroupTransfer::Merge);
-    } else {
-      substitute(replacement, v, VertexDeletion::No, OpGroupTransfer::Merge);
+  while (true) {
+    std::vector<std::pair<Vertex, const Box*>> boxes;
+    std::map<boost::uuids::uuid, const Box*> distinct;
+    std::vector<const Box*> to_generate;
+    BGL_FORALL_VERTICES(v, dag, DAG) {
+      const Box* b = get_box(get_Op_ptr_from_Vertex(v));
+      if (!b) continue;
+      auto inserted = distinct.insert({b->get_id(), b});
+      if (inserted.second) to_generate.push_back(b);
+      boxes.push_back({v, inserted.first->second});
+    }
+    if (boxes.empty()) return success;
+    generate_box_circuits(to_generate);
+    VertexList bin;
+    for (const std::pair<Vertex, const Box*>& vb : boxes) {
+      substitute_box(*this, *vb.second->to_circuit(), vb.first);
+      bin.push_back(vb.first);
     }
-    bin.push_back(v);
+    remove_vertices(bin, GraphRewiring::No, VertexDeletion::Yes);
     success = true;
   }
-  remove_vertices(bin, GraphRewiring::No, VertexDeletion::Yes);
-  return success;
+}
+
+// Flattened circuits of boxes, by box id
+typedef std::map<boost::uuids::uuid, Circuit> flattened_boxes_t;
+
+// The distinct boxes in a circuit, in order of first appearance
+static std::vector<const Box*> distinct_boxes(const Circuit& circ) {
+  std::vector<const Box*> boxes;
+  std::set<boost::uuids::uuid> seen;
+  BGL_FORALL_VERTICES(v, circ.dag, DAG) {
+    const Box* b = get_box(circ.get_Op_ptr_from_Vertex(v));
+    if (b && seen.insert(b->get_id()).second) boxes.push_back(b);
+  }
+  return boxes;
+}
+
+// Replace all boxes in a circuit by their flattened circuits, which must be
+// in the cache. Unconditional boxes are spliced in one batch.
+static void substitute_flattened(
+    Circuit& circ, const flattened_boxes_t& cache) {
+  std::vector<std::pair<Subcircuit, const Circuit*>> replacements;
+  std::vector<std::pair<Vertex, const Circuit*>> conditionals;
+  BGL_FORALL_VERTICES(v, circ.dag, DAG) {
+    const Box* b = get_box(circ.get_Op_ptr_from_Vertex(v));
+    if (!b) continue;
+    const Circuit* body = &cache.at(b->get_id());
+    if (circ.get_OpType_from_Vertex(v) == OpType::Conditional) {
+      conditionals.push_back({v, body});
+    } else {
+      replacements.push_back({vertex_subcircuit(circ, v), body});
+    }
+  }
+  if (!replacements.empty()) {
+    circ.substitute_disjoint(
+        replacements, Circuit::VertexDeletion::Yes,
+        Circuit::OpGroupTransfer::Merge);
+  }
+  for (const std::pair<Vertex, const Circuit*>& vc : conditionals) {
+    circ.substitute_conditional(
+        *vc.second, vc.first, Circuit::VertexDeletion::Yes,
+        Circuit::OpGroupTransfer::Merge);
+  }
 }
 
 void Circuit::decompose_boxes_recursively() {
-  while (decompose_boxes()) {
+  // Find the distinct boxes (at any depth) level by level, generating the
+  // circuits of each level in parallel. Copies of a box share its id and its
+  // circuit.
+  std::vector<const Box*> boxes;
+  std::vector<std::vector<std::size_t>> nested;
+  std::map<boost::uuids::uuid, std::size_t> index;
+  std::vector<const Box*> level = distinct_boxes(*this);
+  for (const Box* b : level) index.insert({b->get_id(), index.size()});
+  while (!level.empty()) {
+    generate_box_circuits(level);
+    std::vector<std::vector<const Box*>> children(level.size());
+    parallel_for(0, level.size(), 4, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i) {
+        children[i] = distinct_boxes(*level[i]->to_circuit());
+      }
+    });
+    std::vector<const Box*> next_level;
+    for (std::size_t i = 0; i < level.size(); ++i) {
+      boxes.push_back(level[i]);
+      nested.emplace_back();
+      for (const Box* c : children[i]) {
+        auto inserted = index.insert({c->get_id(), index.size()});
+        if (inserted.second) next_level.push_back(c);
+        nested.back().push_back(inserted.first->second);
+      }
+    }
+    level = std::move(next_level);
+  }
+  if (boxes.empty()) return;
+
+  // Flatten the boxes in order of height (the depth of nesting within them),
+  // those of the same height in parallel, as they only contain boxes already
+  // flattened
+  std::vector<unsigned> height(boxes.size(), 0);
+  std::vector<bool> done(boxes.size(), false);
+  std::function<unsigned(std::size_t)> get_height = [&](std::size_t i) {
+    if (!done[i]) {
+      for (std::size_t c : nested[i]) {
+        height[i] = std::max(height[i], get_height(c) + 1);
+      }
+      done[i] = true;
+    }
+    return height[i];
+  };
+  std::vector<std::vector<const Box*>> by_height;
+  for (std::size_t i = 0; i < boxes.size(); ++i) {
+    unsigned h = get_height(i);
+    if (by_height.size() <= h) by_height.resize(h + 1);
+    by_height[h].push_back(boxes[i]);
   }
+  flattened_boxes_t cache;
+  for (const std::vector<const Box*>& same_height : by_height) {
+    std::vector<Circuit> bodies(same_height.size());
+    parallel_for(
+        0, same_height.size(), 4, [&](std::size_t begin, std::size_t end) {
+          for (std::size_t i = begin; i < end; ++i) {
+            bodies[i] = *same_height[i]->to_circuit();
+            substitute_flattened(bodies[i], cache);
+          }
+        });
+    for (std::size_t i = 0; i < same_height.size(); ++i) {
+      cache.emplace(same_height[i]->get_id(), std::move(bodies[i]));
+    }
+  }
+  substitute_flattened(*this, cache);
 }
 
 std::map<Bit, bool> Circuit::classical_eval(
@@ -701,4 +1124,98 @@ std::map<Bit, bool> Circuit::classical_eval(
   return v;
 }
 
+// Positions among the arguments of a classical operation of the bits it
+// reads and of the bits it writes, in the order of its inputs and outputs
+static void classical_arg_layout(
+    const ClassicalOp& op, unsigned offset, std::vector<unsigned>& in,
+    std::vector<unsigned>& out) {
+  if (op.get_type() == OpType::MultiBit) {
+    const MultiBitOp& mbop = static_cast<const MultiBitOp&>(op);
+    const ClassicalOp& inner = *mbop.get_op();
+    unsigned n_inner = inner.get_n_i() + inner.get_n_io() + inner.get_n_o();
+    for (unsigned i = 0; i < mbop.get_n(); i++) {
+      classical_arg_layout(inner, offset + i * n_inner, in, out);
+    }
+    return;
+  }
+  unsigned n_i = op.get_n_i(), n_io = op.get_n_io(), n_o = op.get_n_o();
+  for (unsigned i = 0; i < n_i + n_io; i++) in.push_back(offset + i);
+  for (unsigned j = n_i; j < n_i + n_io + n_o; j++) out.push_back(offset + j);
+}
+
+// Smallest number of (words x operations) worth evaluating in another thread
+static constexpr std::size_t classical_eval_min_work = 1u << 14;
+
+std::map<Bit, std::vector<std::uint64_t>> Circuit::classical_eval_packed(
+    const std::map<Bit, std::vector<std::uint64_t>>& values) const {
+  // Bits are numbered densely, those of the input map first
+  std::vector<Bit> bits;
+  std::map<Bit, unsigned> bit_index;
+  auto index_of = [&](const Bit& b) {
+    auto [it, added] = bit_index.insert({b, unsigned(bits.size())});
+    if (added) bits.push_back(b);
+    return it->second;
+  };
+  std::size_t n_words = values.empty() ? 0 : values.begin()->second.size();
+  for (const std::pair<const Bit, std::vector<std::uint64_t>>& bv : values) {
+    if (bv.second.size() != n_words) {
+      throw std::invalid_argument(
+          "Inputs to packed classical evaluation differ in length");
+    }
+    index_of(bv.first);
+  }
+  const unsigned n_inputs = bits.size();
+
+  struct Step {
+    std::shared_ptr<const ClassicalOp> op;
+    std::vector<unsigned> in;
+    std::vector<unsigned> out;
+  };
+  std::vector<Step> steps;
+  for (const Command& com : get_commands()) {
+    Op_ptr op = com.get_op_ptr();
+    if (!is_classical_type(op->get_type())) {
+      throw CircuitInvalidity("Non-classical operation");
+    }
+    Step step{std::dynamic_pointer_cast<const ClassicalOp>(op), {}, {}};
+    TKET_ASSERT(step.op);
+    std::vector<unsigned> in_pos, out_pos;
+    classical_arg_layout(*step.op, 0, in_pos, out_pos);
+    unit_vector_t args = com.get_args();
+    for (unsigned i : in_pos) step.in.push_back(index_of(Bit(args[i])));
+    for (unsigned j : out_pos) step.out.push_back(index_of(Bit(args[j])));
+    steps.push_back(std::move(step));
+  }
+
+  std::vector<std::vector<std::uint64_t>> words(
+      bits.size(), std::vector<std::uint64_t>(n_words, 0));
+  for (unsigned b = 0; b < n_inputs; b++) words[b] = values.at(bits[b]);
+  // Each run of words is evaluated independently, with its own state
+  const std::size_t min_words =
+      std::max<std::size_t>(1, classical_eval_min_work / (steps.size() + 1));
+  parallel_for(
+      0, n_words, min_words,
+      [&](std::size_t begin, std::size_t end) {
+        std::vector<std::uint64_t> state(bits.size());
+        std::vector<std::uint64_t> x;
+        for (std::size_t w = begin; w < end; w++) {
+          for (unsigned b = 0; b < bits.size(); b++) state[b] = words[b][w];
+          for (const Step& step : steps) {
+            x.resize(step.in.size());
+            for (unsigned i = 0; i < x.size(); i++) x[i] = state[step.in[i]];
+            std::vector<std::uint64_t> y = step.op->eval_packed(x);
+            TKET_ASSERT(y.size() == step.out.size());
+            for (unsigned j = 0; j < y.size(); j++) state[step.out[j]] = y[j];
+          }
+          for (unsigned b = 0; b < bits.size(); b++) words[b][w] = state[b];
+        }
+      });
+
+  std::map<Bit, std::vector<std::uint64_t>> result;
+  for (unsigned b = 0; b < bits.size(); b++) {
+    result.insert({bits[b], std::move(words[b])});
+  }
+  return result;
+}
+
 }  // namespace tket
@@ -0,0 +1,230 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <boost/functional/hash.hpp>
+#include <boost/mpl/size.hpp>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Boxes.hpp"
+#include "Circuit.hpp"
+#include "Gate/Gate.hpp"
+#include "Ops/Conditional.hpp"
+#include "UnitPaths.hpp"
+
+namespace tket {
+
+namespace {
+
+constexpr std::size_t ptr_bytes = sizeof(void *);
+
+// Link pointers of a node of a doubly-linked list
+constexpr std::size_t list_node_bytes = 2 * ptr_bytes;
+
+// Link pointers of a node of a red-black tree (the colour is packed)
+constexpr std::size_t tree_node_bytes = 3 * ptr_bytes;
+
+// Reference counts and deleter of a std::shared_ptr control block
+constexpr std::size_t control_block_bytes = 2 * sizeof(long) + ptr_bytes;
+
+// Size assumed for an expression node, whose dynamic type is unknown: the
+// common base plus a few members (arguments, a hash or a value)
+constexpr std::size_t expr_node_bytes =
+    sizeof(SymEngine::Basic) + 4 * ptr_bytes;
+
+// Bytes allocated by a string beyond the string object
+std::size_t string_heap_bytes(const std::string &s) {
+  static const std::size_t sso_capacity = std::string().capacity();
+  return s.capacity() > sso_capacity ? s.capacity() + 1 : 0;
+}
+
+// Bytes of a unit's interned name and index
+std::size_t unit_data_bytes(const UnitID &unit) {
+  return sizeof(std::string) + sizeof(std::vector<unsigned>) +
+         unit.reg_name().size() + 1 + unit.reg_dim() * sizeof(unsigned);
+}
+
+}  // namespace
+
+struct Circuit::MemoryUsageState {
+  std::unordered_set<const Op *> ops;
+  std::unordered_set<const SymEngine::Basic *> expr_nodes;
+  std::unordered_set<const Circuit *> circuits;
+  std::unordered_set<UnitID, boost::hash<UnitID>> units;
+
+  // Bytes of the nodes of an expression not yet counted
+  std::size_t expr_bytes(const Expr &e) {
+    std::size_t bytes = 0;
+    std::vector<const SymEngine::Basic *> stack{e.get_basic().get()};
+    while (!stack.empty()) {
+      const SymEngine::Basic *node = stack.back();
+      stack.pop_back();
+      if (!expr_nodes.insert(node).second) continue;
+      bytes += expr_node_bytes;
+      if (SymEngine::is_a<SymEngine::Symbol>(*node)) {
+        bytes +=
+            static_cast<const SymEngine::Symbol &>(*node).get_name().size();
+      }
+      for (const SymEngine::RCP<const SymEngine::Basic> &arg :
+           node->get_args()) {
+        stack.push_back(arg.get());
+      }
+    }
+    return bytes;
+  }
+
+  // Count an operation, if not yet counted, with its parameters and box
+  // circuit. It is shared if it has more than `refs` references.
+  void add_op(const Op_ptr &op, long refs, MemoryUsage &usage) {
+    if (!ops.insert(op.get()).second) return;
+    std::size_t bytes = control_block_bytes;
+    const OpType type = op->get_type();
+    if (op->get_desc().is_gate()) {
+      const Gate &gate = static_cast<const Gate &>(*op);
+      const std::vector<Param> &params = gate.get_param_values();
+      bytes += sizeof(Gate) + params.capacity() * sizeof(Param);
+      for (const Param &p : params) {
+        if (!p.is_double()) usage.expressions += expr_bytes(p.to_expr());
+      }
+    } else if (op->get_desc().is_box()) {
+      const Box &box = static_cast<const Box &>(*op);
+      bytes += sizeof(Box) + box.get_signature().size() * sizeof(EdgeType);
+      std::shared_ptr<const Circuit> circ = box.generated_circuit();
+      if (circ && circuits.insert(circ.get()).second) {
+        usage.boxes += circ->memory_usage(*this).total();
+      }
+    } else if (type == OpType::Conditional) {
+      const Conditional &cond = static_cast<const Conditional &>(*op);
+      bytes += sizeof(Conditional);
+      // Referenced by the conditional and the copy returned
+      add_op(cond.get_op(), 2, usage);
+    } else {
+      bytes += sizeof(Op);
+    }
+    if (op.use_count() > refs) {
+      usage.shared_ops += bytes;
+    } else {
+      usage.unique_ops += bytes;
+    }
+  }
+};
+
+std::size_t Circuit::MemoryUsage::total() const {
+  return vertices + edges + unique_ops + shared_ops + boxes + expressions +
+         units + opgroups + caches + other;
+}
+
+Circuit::MemoryUsage Circuit::memory_usage() const {
+  MemoryUsageState state;
+  state.circuits.insert(this);
+  return memory_usage(state);
+}
+
+Circuit::MemoryUsage Circuit::memory_usage(MemoryUsageState &state) const {
+  MemoryUsage usage;
+  usage.other = sizeof(Circuit);
+  if (name) usage.other += string_heap_bytes(*name);
+
+  // References to each operation from the DAG and the cached commands, to
+  // tell operations shared with other owners
+  std::unordered_map<const Op *, long> refs;
+  std::vector<Op_ptr> ops;
+  auto add_ref = [&](const Op_ptr &op) {
+    if (refs[op.get()]++ == 0) ops.push_back(op);
+  };
+
+  BGL_FORALL_VERTICES(v, dag, DAG) {
+    usage.vertices += sizeof(DAG::stored_vertex) + list_node_bytes;
+    const VertexProperties &props = dag[v];
+    add_ref(props.op);
+    if (props.opgroup) usage.opgroups += string_heap_bytes(*props.opgroup);
+  }
+  // Each edge is a node of the edge list, plus an entry (its target and an
+  // iterator to that node) in the out-edge list of its source and in the
+  // in-edge list of its target.
+  const std::size_t edge_bytes =
+      sizeof(boost::list_edge<Vertex, EdgeProperties>) + list_node_bytes +
+      2 * (2 * ptr_bytes + list_node_bytes);
+  usage.edges = boost::num_edges(dag) * edge_bytes;
+
+  constexpr std::size_t n_boundary_indices =
+      boost::mpl::size<boundary_t::index_type_list>::value;
+  for (const BoundaryElement &el : boundary.get<TagID>()) {
+    usage.units +=
+        sizeof(BoundaryElement) + n_boundary_indices * tree_node_bytes;
+    if (state.units.insert(el.id_).second) {
+      usage.units += unit_data_bytes(el.id_);
+    }
+  }
+
+  for (const std::pair<const std::string, op_signature_t> &sig :
+       opgroupsigs) {
+    usage.opgroups += sizeof(sig) + tree_node_bytes +
+                      string_heap_bytes(sig.first) +
+                      sig.second.capacity() * sizeof(EdgeType);
+  }
+
+  usage.expressions += state.expr_bytes(phase);
+
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    const TraversalCache &tc = traversal_cache_;
+    usage.caches += tc.boundary.size() *
+                    (sizeof(BoundaryElement) +
+                     n_boundary_indices * tree_node_bytes);
+    if (tc.slices) {
+      usage.caches += tc.slices->capacity() * sizeof(Slice);
+      for (const Slice &slice : *tc.slices) {
+        usage.caches += slice.capacity() * sizeof(Vertex);
+      }
+    }
+    if (tc.commands) {
+      usage.caches += tc.commands->capacity() * sizeof(Command);
+      for (const Command &com : *tc.commands) {
+        usage.caches += com.get_args().size() * sizeof(UnitID);
+        add_ref(com.get_op_ptr());
+      }
+    }
+    if (tc.unit_paths) usage.caches += sizeof(UnitPathIndex);
+    const DepthCache &dc = depth_cache_;
+    if (dc.layers) {
+      usage.caches +=
+          dc.layers->size() *
+              (sizeof(std::pair<const Vertex, unsigned>) + ptr_bytes) +
+          dc.layers->bucket_count() * ptr_bytes;
+    }
+    usage.caches +=
+        dc.by_type.size() *
+            (sizeof(std::pair<const OpType, unsigned>) + tree_node_bytes) +
+        dc.by_types.size() *
+            (sizeof(std::pair<const std::set<OpType>, unsigned>) +
+             tree_node_bytes);
+    if (changes_) {
+      usage.caches += changes_->capacity() * sizeof(Change);
+      for (const Change &change : *changes_) {
+        if (change.op) add_ref(change.op);
+      }
+    }
+  }
+
+  for (const Op_ptr &op : ops) {
+    // Referenced from the circuit and from `ops`
+    if (op) state.add_op(op, refs.at(op.get()) + 1, usage);
+  }
+  return usage;
+}
+
+}  // namespace tket
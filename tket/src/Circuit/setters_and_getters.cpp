@@ -52,15 +52,101 @@ Circuit::Circuit(const Circuit &circ) : Circuit() {
 Circuit &Circuit::operator=(const Circuit &other)  // (1)
 {
   dag = DAG();
+  ++dag_version_;
   boundary = boundary_t();
   copy_graph(other);
   phase = other.get_phase();
   name = other.name;
+  log_change(Change::Kind::Rebuilt, Vertex());
   return *this;
 }
 
+void Circuit::record_changes(bool enable) {
+  if (enable) {
+    changes_ = std::vector<Change>();
+  } else {
+    changes_.reset();
+  }
+}
+
+Circuit::ChangeLog Circuit::get_changes_since(std::size_t checkpoint) const {
+  if (!changes_) {
+    throw CircuitInvalidity("Changes to the circuit are not being recorded");
+  }
+  ChangeLog log;
+  for (std::size_t i = checkpoint; i < changes_->size(); i++) {
+    const Change &change = (*changes_)[i];
+    const Vertex &v = change.vertex;
+    switch (change.kind) {
+      case Change::Kind::Added:
+        log.added.insert(v);
+        break;
+      case Change::Kind::Removed: {
+        // Vertices added since the checkpoint leave no trace
+        if (log.added.erase(v) != 0) break;
+        std::map<Vertex, Op_ptr>::iterator replaced = log.replaced.find(v);
+        if (replaced == log.replaced.end()) {
+          log.removed.push_back(change.op);
+        } else {
+          log.removed.push_back(replaced->second);
+          log.replaced.erase(replaced);
+        }
+        log.rewired.erase(v);
+        break;
+      }
+      case Change::Kind::Replaced:
+        // Keep the first replaced operation, which is the one at the checkpoint
+        if (log.added.find(v) == log.added.end()) {
+          log.replaced.insert({v, change.op});
+        }
+        break;
+      case Change::Kind::Rewired:
+        if (log.added.find(v) == log.added.end()) log.rewired.insert(v);
+        break;
+      case Change::Kind::Rebuilt:
+        log.rebuilt = true;
+        break;
+    }
+  }
+  return log;
+}
+
 void Circuit::assert_valid() const {  //
   TKET_ASSERT(is_valid(dag));
+  TKET_ASSERT(boundary_is_valid());
+}
+
+bool Circuit::is_valid_since(std::size_t checkpoint) const {
+  if (!changes_) return is_valid(dag) && boundary_is_valid();
+  const ChangeLog log = get_changes_since(checkpoint);
+  if (log.rebuilt) return is_valid(dag) && boundary_is_valid();
+  VertexSet touched = log.added;
+  touched.insert(log.rewired.begin(), log.rewired.end());
+  for (const auto &[v, op] : log.replaced) touched.insert(v);
+  return is_valid(dag, touched) && boundary_is_valid();
+}
+
+void Circuit::assert_valid_since(std::size_t checkpoint) const {
+  TKET_ASSERT(is_valid_since(checkpoint));
+}
+
+bool Circuit::boundary_is_valid() const {
+  for (const BoundaryElement &el : boundary.get<TagID>()) {
+    const OpType in_type = get_OpType_from_Vertex(el.in_);
+    const OpType out_type = get_OpType_from_Vertex(el.out_);
+    if (el.type() == UnitType::Qubit) {
+      if (!is_initial_q_type(in_type) || !is_final_q_type(out_type)) {
+        return false;
+      }
+    } else if (in_type != OpType::ClInput || out_type != OpType::ClOutput) {
+      return false;
+    }
+    if (boost::in_degree(el.in_, dag) != 0 ||
+        boost::out_degree(el.out_, dag) != 0) {
+      return false;
+    }
+  }
+  return true;
 }
 
 VertexVec Circuit::all_inputs() const {
@@ -276,23 +362,112 @@ bool Circuit::is_discarded(const Qubit &id) const {
   return get_OpType_from_Vertex(get_out(id)) == OpType::Discard;
 }
 
+// The neighbourhood queries below are implemented once for any vector-like
+// container, so that the EdgeVec forms and the allocation-free SmallEdgeVec
+// forms agree exactly, including in the exceptions they throw.
+
+// Replaces verts with the distinct ends of edges, in order of first
+// appearance. Vertices have few neighbours, so a linear scan beats hashing.
+template <typename VertexContainer, typename EdgeContainer, typename EndFn>
+static void distinct_ends(
+    const EdgeContainer &edges, EndFn end, VertexContainer &verts) {
+  verts.clear();
+  if (edges.size() <= 16) {
+    for (const Edge &e : edges) {
+      Vertex v = end(e);
+      if (std::find(verts.begin(), verts.end(), v) == verts.end()) {
+        verts.push_back(v);
+      }
+    }
+    return;
+  }
+  std::unordered_set<Vertex> lookup;
+  for (const Edge &e : edges) {
+    Vertex v = end(e);
+    if (lookup.insert(v).second) verts.push_back(v);
+  }
+}
+
+template <typename EdgeContainer>
+static void fill_in_edges(
+    const Circuit &circ, const Vertex &vert, EdgeContainer &inedges) {
+  unsigned n = circ.n_in_edges(vert);
+  inedges.assign(n, Edge());
+  BGL_FORALL_INEDGES(vert, e, circ.dag, DAG) {
+    port_t port = circ.get_target_port(e);
+    // With n edges, a port beyond n leaves some port below n empty
+    if (port >= n) {
+      throw CircuitInvalidity("Input ports on Vertex are non-contiguous");
+    }
+    if (inedges[port] != Edge()) {
+      throw CircuitInvalidity("Vertex has multiple inputs on the same port");
+    }
+    inedges[port] = e;
+  }
+}
+
+template <typename OptEdgeContainer>
+static void fill_linear_out_edges(
+    const Circuit &circ, const Vertex &vert, OptEdgeContainer &outedges) {
+  unsigned n = circ.n_ports(vert);
+  outedges.assign(n, std::nullopt);
+  BGL_FORALL_OUTEDGES(vert, e, circ.dag, DAG) {
+    if (circ.get_edgetype(e) == EdgeType::Boolean) continue;
+    port_t port = circ.get_source_port(e);
+    if (port >= n) {
+      throw CircuitInvalidity("Vertex has an output on an unexpected port");
+    }
+    if (outedges[port]) {
+      throw CircuitInvalidity(
+          "Vertex has multiple linear outputs on the same port");
+    }
+    outedges[port] = e;
+  }
+}
+
+template <typename EdgeContainer>
+static void fill_all_out_edges(
+    const Circuit &circ, const Vertex &vert, EdgeContainer &outs) {
+  SmallOptEdgeVec lin_outs;
+  fill_linear_out_edges(circ, vert, lin_outs);
+  unsigned n_linear = 0;
+  for (const std::optional<Edge> &l_out : lin_outs) {
+    if (l_out) ++n_linear;
+  }
+  const bool has_boolean = circ.n_out_edges(vert) > n_linear;
+  outs.clear();
+  for (port_t i = 0; i < lin_outs.size(); ++i) {
+    if (!lin_outs[i]) continue;
+    outs.push_back(*lin_outs[i]);
+    // Boolean edges follow the Classical edge of the port they copy
+    if (has_boolean) {
+      BGL_FORALL_OUTEDGES(vert, e, circ.dag, DAG) {
+        if (circ.get_edgetype(e) == EdgeType::Boolean &&
+            circ.get_source_port(e) == i) {
+          outs.push_back(e);
+        }
+      }
+    }
+  }
+}
+
 // given a vertex, returns a set of all its successor vertices
 // this set can be empty, and no warnings are given if it is
 // there are no checks to ensure the vertex exists in the graph
 VertexVec Circuit::get_successors(const Vertex &vert) const {
-  EdgeVec outs = get_all_out_edges(vert);
+  SmallEdgeVec outs;
+  fill_all_out_edges(*this, vert, outs);
   VertexVec children;
-  std::unordered_set<Vertex> lookup;
-  for (const Edge &e : outs) {
-    Vertex succ = target(e);
-    if (lookup.find(succ) == lookup.end()) {
-      children.push_back(succ);
-      lookup.insert(succ);
-    }
-  }
+  distinct_ends(outs, [this](const Edge &e) { return target(e); }, children);
   return children;
 }
 
+void Circuit::get_successors(const Vertex &vert, SmallVertexVec &succs) const {
+  SmallEdgeVec outs;
+  fill_all_out_edges(*this, vert, outs);
+  distinct_ends(outs, [this](const Edge &e) { return target(e); }, succs);
+}
+
 VertexVec Circuit::get_successors_of_type(
     const Vertex &vert, EdgeType type) const {
   EdgeVec outs = get_out_edges_of_type(vert, type);
@@ -312,19 +487,20 @@ VertexVec Circuit::get_successors_of_type(
 // this set can be empty, and no warnings are given if it is
 // there are no checks to ensure the vertex exists in the graph
 VertexVec Circuit::get_predecessors(const Vertex &vert) const {
-  EdgeVec ins = get_in_edges(vert);
+  SmallEdgeVec ins;
+  fill_in_edges(*this, vert, ins);
   VertexVec parents;
-  std::unordered_set<Vertex> lookup;
-  for (const Edge &e : ins) {
-    Vertex pred = source(e);
-    if (lookup.find(pred) == lookup.end()) {
-      parents.push_back(pred);
-      lookup.insert(pred);
-    }
-  }
+  distinct_ends(ins, [this](const Edge &e) { return source(e); }, parents);
   return parents;
 }
 
+void Circuit::get_predecessors(
+    const Vertex &vert, SmallVertexVec &preds) const {
+  SmallEdgeVec ins;
+  fill_in_edges(*this, vert, ins);
+  distinct_ends(ins, [this](const Edge &e) { return source(e); }, preds);
+}
+
 VertexVec Circuit::get_predecessors_of_type(
     const Vertex &vert, EdgeType type) const {
   EdgeVec ins = get_in_edges_of_type(vert, type);
@@ -371,27 +547,15 @@ EdgeType Circuit::get_edgetype(const Edge &edge) const {
 }
 
 EdgeVec Circuit::get_in_edges(const Vertex &vert) const {
-  unsigned n = n_in_edges(vert);
-  EdgeVec inedges(n);
-  std::vector<bool> port_found(n, false);
-  BGL_FORALL_INEDGES(vert, e, dag, DAG) {
-    port_t port = get_target_port(e);
-    if (port >= n) {
-      inedges.resize(port + 1);
-      port_found.resize(port + 1, false);
-    } else if (port_found[port]) {
-      throw CircuitInvalidity("Vertex has multiple inputs on the same port");
-    }
-    port_found[port] = true;
-    inedges[port] = e;
-  }
-  for (unsigned i = 0; i < n; i++)
-    if (!port_found[i]) {
-      throw CircuitInvalidity("Input ports on Vertex are non-contiguous");
-    }
+  EdgeVec inedges;
+  fill_in_edges(*this, vert, inedges);
   return inedges;
 }
 
+void Circuit::get_in_edges(const Vertex &vert, SmallEdgeVec &ins) const {
+  fill_in_edges(*this, vert, ins);
+}
+
 EdgeVec Circuit::get_in_edges_of_type(const Vertex &vert, EdgeType type) const {
   EdgeVec ins = get_in_edges(vert);
   EdgeVec matching;
@@ -405,37 +569,26 @@ EdgeVec Circuit::get_in_edges_of_type(const Vertex &vert, EdgeType type) const {
 
 std::vector<std::optional<Edge>> Circuit::get_linear_out_edges(
     const Vertex &vert) const {
-  unsigned n = n_ports(vert);
-  std::vector<std::optional<Edge>> outedges(n);
-  BGL_FORALL_OUTEDGES(vert, e, dag, DAG) {
-    if (get_edgetype(e) == EdgeType::Boolean) continue;
-    port_t port = get_source_port(e);
-    if (port >= n) {
-      throw CircuitInvalidity("Vertex has an output on an unexpected port");
-    }
-    if (outedges[port]) {
-      throw CircuitInvalidity(
-          "Vertex has multiple linear outputs on the same port");
-    }
-    outedges[port] = e;
-  }
+  std::vector<std::optional<Edge>> outedges;
+  fill_linear_out_edges(*this, vert, outedges);
   return outedges;
 }
 
+void Circuit::get_linear_out_edges(
+    const Vertex &vert, SmallOptEdgeVec &outs) const {
+  fill_linear_out_edges(*this, vert, outs);
+}
+
 EdgeVec Circuit::get_all_out_edges(const Vertex &vert) const {
-  std::vector<std::optional<Edge>> lin_outs = get_linear_out_edges(vert);
-  std::vector<EdgeVec> b_bundles = get_b_out_bundles(vert);
   EdgeVec outs;
-  for (unsigned i = 0; i < lin_outs.size(); ++i) {
-    std::optional<Edge> &l_out = lin_outs[i];
-    if (l_out) {
-      outs.push_back(*l_out);
-      outs.insert(outs.end(), b_bundles[i].begin(), b_bundles[i].end());
-    }
-  }
+  fill_all_out_edges(*this, vert, outs);
   return outs;
 }
 
+void Circuit::get_all_out_edges(const Vertex &vert, SmallEdgeVec &outs) const {
+  fill_all_out_edges(*this, vert, outs);
+}
+
 EdgeVec Circuit::get_out_edges_of_type(
     const Vertex &vert, EdgeType type) const {
   if (type == EdgeType::Boolean) {
@@ -559,6 +712,13 @@ const std::optional<std::string> &Circuit::get_opgroup_from_Vertex(
 }
 
 void Circuit::set_vertex_Op_ptr(const Vertex &vert, const Op_ptr &op) {
+  log_change(Change::Kind::Replaced, vert, this->dag[vert].op);
+  const bool op_counts_were_current = op_counts_current();
+  ++op_version_;
+  if (op_counts_were_current) {
+    update_op_counts(this->dag[vert].op, -1);
+    update_op_counts(op, 1);
+  }
   this->dag[vert].op = op;
 }
 
@@ -137,6 +137,7 @@ class CliffTableau {
 
   friend CliffTableau circuit_to_tableau(const Circuit &circ);
   friend Circuit tableau_to_circuit(const CliffTableau &tab);
+  friend class PackedCliffTableau;
 
   friend std::ostream &operator<<(std::ostream &os, CliffTableau const &tab);
   bool operator==(const CliffTableau &other) const;
@@ -0,0 +1,455 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PackedCliffTableau.hpp"
+
+#include <bit>
+
+#include "OpType/OpType.hpp"
+#include "OpType/OpTypeInfo.hpp"
+#include "Utils/Exceptions.hpp"
+
+namespace tket {
+
+static bool get_bit(const std::uint64_t *words, unsigned j) {
+  return (words[j / 64] >> (j % 64)) & 1;
+}
+
+static void flip_bit(std::uint64_t *words, unsigned j) {
+  words[j / 64] ^= std::uint64_t{1} << (j % 64);
+}
+
+/**
+ * Apply a Clifford gate as a sequence of S, V and CX gates, in the same order
+ * as CliffTableau does.
+ */
+template <typename SFn, typename VFn, typename CXFn>
+static void apply_gate_sequence(
+    OpType type, const std::vector<unsigned> &qbs, SFn s, VFn v, CXFn cx) {
+  switch (type) {
+    case OpType::Z: {
+      s(qbs.at(0));
+      s(qbs.at(0));
+      break;
+    }
+    case OpType::X: {
+      v(qbs.at(0));
+      v(qbs.at(0));
+      break;
+    }
+    case OpType::Y: {
+      s(qbs.at(0));
+      s(qbs.at(0));
+      v(qbs.at(0));
+      v(qbs.at(0));
+      break;
+    }
+    case OpType::S: {
+      s(qbs.at(0));
+      break;
+    }
+    case OpType::Sdg: {
+      s(qbs.at(0));
+      s(qbs.at(0));
+      s(qbs.at(0));
+      break;
+    }
+    case OpType::V: {
+      v(qbs.at(0));
+      break;
+    }
+    case OpType::Vdg: {
+      v(qbs.at(0));
+      v(qbs.at(0));
+      v(qbs.at(0));
+      break;
+    }
+    case OpType::H: {
+      s(qbs.at(0));
+      v(qbs.at(0));
+      s(qbs.at(0));
+      break;
+    }
+    case OpType::CX: {
+      cx(qbs.at(0), qbs.at(1));
+      break;
+    }
+    case OpType::CY: {
+      v(qbs.at(1));
+      v(qbs.at(1));
+      v(qbs.at(1));
+      cx(qbs.at(0), qbs.at(1));
+      v(qbs.at(1));
+      break;
+    }
+    case OpType::CZ: {
+      s(qbs.at(1));
+      v(qbs.at(1));
+      s(qbs.at(1));
+      cx(qbs.at(0), qbs.at(1));
+      s(qbs.at(1));
+      v(qbs.at(1));
+      s(qbs.at(1));
+      break;
+    }
+    case OpType::SWAP: {
+      cx(qbs.at(0), qbs.at(1));
+      cx(qbs.at(1), qbs.at(0));
+      cx(qbs.at(0), qbs.at(1));
+      break;
+    }
+    case OpType::BRIDGE: {
+      cx(qbs.at(0), qbs.at(2));
+      break;
+    }
+    case OpType::noop: {
+      break;
+    }
+    default: {
+      throw NotValid(optypeinfo(type).name + " is not a Clifford gate");
+    }
+  }
+}
+
+PackedCliffTableau::PackedCliffTableau(unsigned n)
+    : size_(n),
+      n_words_((n + 63) / 64),
+      bits_(4 * std::size_t{n} * n_words_, 0),
+      phases_(2 * n, false) {
+  for (unsigned i = 0; i < n; i++) {
+    flip_bit(row_x(i), i);
+    flip_bit(row_z(n + i), i);
+    qubits_.insert({Qubit(q_default_reg(), i), i});
+  }
+}
+
+PackedCliffTableau::PackedCliffTableau(const qubit_vector_t &qbs)
+    : PackedCliffTableau(qbs.size()) {
+  qubits_.clear();
+  unsigned i = 0;
+  for (const Qubit &q : qbs) {
+    qubits_.insert({q, i});
+    i++;
+  }
+}
+
+PackedCliffTableau::PackedCliffTableau(const CliffTableau &tab)
+    : PackedCliffTableau(tab.size_) {
+  const unsigned n = size_;
+  std::fill(bits_.begin(), bits_.end(), 0);
+  for (unsigned i = 0; i < n; i++) {
+    for (unsigned j = 0; j < n; j++) {
+      if (tab.xpauli_x(i, j)) flip_bit(row_x(i), j);
+      if (tab.xpauli_z(i, j)) flip_bit(row_z(i), j);
+      if (tab.zpauli_x(i, j)) flip_bit(row_x(n + i), j);
+      if (tab.zpauli_z(i, j)) flip_bit(row_z(n + i), j);
+    }
+    phases_[i] = tab.xpauli_phase(i);
+    phases_[n + i] = tab.zpauli_phase(i);
+  }
+  qubits_ = tab.qubits_;
+}
+
+CliffTableau PackedCliffTableau::to_tableau() const {
+  const unsigned n = size_;
+  CliffTableau tab(n);
+  for (unsigned i = 0; i < n; i++) {
+    for (unsigned j = 0; j < n; j++) {
+      tab.xpauli_x(i, j) = get_bit(row_x(i), j);
+      tab.xpauli_z(i, j) = get_bit(row_z(i), j);
+      tab.zpauli_x(i, j) = get_bit(row_x(n + i), j);
+      tab.zpauli_z(i, j) = get_bit(row_z(n + i), j);
+    }
+    tab.xpauli_phase(i) = phases_[i];
+    tab.zpauli_phase(i) = phases_[n + i];
+  }
+  tab.qubits_ = qubits_;
+  return tab;
+}
+
+QubitPauliTensor PackedCliffTableau::get_row(unsigned r) const {
+  Complex phase = 1.;
+  if (phases_[r]) phase = -1.;
+  QubitPauliTensor res(phase);
+  for (boost::bimap<Qubit, unsigned>::const_iterator iter = qubits_.begin(),
+                                                     iend = qubits_.end();
+       iter != iend; ++iter) {
+    unsigned origin = iter->right;
+    if (get_bit(row_x(r), origin)) {
+      if (get_bit(row_z(r), origin)) {
+        res = res * QubitPauliTensor(iter->left, Pauli::Y);
+      } else {
+        res = res * QubitPauliTensor(iter->left, Pauli::X);
+      }
+    } else if (get_bit(row_z(r), origin)) {
+      res = res * QubitPauliTensor(iter->left, Pauli::Z);
+    }
+  }
+  return res;
+}
+
+QubitPauliTensor PackedCliffTableau::get_zpauli(const Qubit &qb) const {
+  return get_row(size_ + qubits_.left.at(qb));
+}
+
+QubitPauliTensor PackedCliffTableau::get_xpauli(const Qubit &qb) const {
+  return get_row(qubits_.left.at(qb));
+}
+
+bool PackedCliffTableau::row_mult(
+    const std::uint64_t *xa, const std::uint64_t *za, bool pa,
+    const std::uint64_t *xb, const std::uint64_t *zb, bool pb,
+    unsigned half_pis, std::uint64_t *xw, std::uint64_t *zw) const {
+  // Writing each Pauli as i^(xz) X^x Z^z, the product of single-qubit Paulis
+  // a and b is i^e times the Pauli with bits (xa ^ xb, za ^ zb), where
+  // e = xa.za + xb.zb + 2 za.xb - (xa ^ xb).(za ^ zb) mod 4.
+  // Unsigned wrap-around preserves the count mod 4.
+  unsigned e = half_pis + 2 * pa + 2 * pb;
+  for (unsigned k = 0; k < n_words_; k++) {
+    const std::uint64_t x1 = xa[k], z1 = za[k], x2 = xb[k], z2 = zb[k];
+    const std::uint64_t x = x1 ^ x2, z = z1 ^ z2;
+    e += std::popcount(x1 & z1) + std::popcount(x2 & z2) +
+         2 * std::popcount(z1 & x2);
+    e -= std::popcount(x & z);
+    xw[k] = x;
+    zw[k] = z;
+  }
+  return (e % 4) == 2;
+}
+
+void PackedCliffTableau::pack_pauli(
+    const QubitPauliTensor &pauli, std::vector<std::uint64_t> &x,
+    std::vector<std::uint64_t> &z) const {
+  x.assign(n_words_, 0);
+  z.assign(n_words_, 0);
+  for (const std::pair<const Qubit, Pauli> &term : pauli.string.map) {
+    unsigned uqb = qubits_.left.at(term.first);
+    if (term.second == Pauli::X || term.second == Pauli::Y) {
+      flip_bit(x.data(), uqb);
+    }
+    if (term.second == Pauli::Z || term.second == Pauli::Y) {
+      flip_bit(z.data(), uqb);
+    }
+  }
+}
+
+void PackedCliffTableau::apply_S_at_front(unsigned qb) {
+  for (unsigned r = 0; r < 2 * size_; r++) {
+    const bool x = get_bit(row_x(r), qb);
+    if (x) {
+      if (!get_bit(row_z(r), qb)) phases_[r] = !phases_[r];
+      flip_bit(row_z(r), qb);
+    }
+  }
+}
+
+void PackedCliffTableau::apply_S_at_end(unsigned qb) {
+  const unsigned z = size_ + qb;
+  phases_[qb] = row_mult(
+      row_x(z), row_z(z), phases_[z], row_x(qb), row_z(qb), phases_[qb], 1,
+      row_x(qb), row_z(qb));
+}
+
+void PackedCliffTableau::apply_V_at_front(unsigned qb) {
+  for (unsigned r = 0; r < 2 * size_; r++) {
+    const bool z = get_bit(row_z(r), qb);
+    if (z) {
+      if (get_bit(row_x(r), qb)) phases_[r] = !phases_[r];
+      flip_bit(row_x(r), qb);
+    }
+  }
+}
+
+void PackedCliffTableau::apply_V_at_end(unsigned qb) {
+  const unsigned z = size_ + qb;
+  phases_[z] = row_mult(
+      row_x(qb), row_z(qb), phases_[qb], row_x(z), row_z(z), phases_[z], 1,
+      row_x(z), row_z(z));
+}
+
+void PackedCliffTableau::apply_CX_at_front(unsigned control, unsigned target) {
+  for (unsigned r = 0; r < 2 * size_; r++) {
+    std::uint64_t *x = row_x(r);
+    std::uint64_t *z = row_z(r);
+    const bool xc = get_bit(x, control), xt = get_bit(x, target);
+    const bool zc = get_bit(z, control), zt = get_bit(z, target);
+    if (xc && zt && !(xt ^ zc)) phases_[r] = !phases_[r];
+    if (xc) flip_bit(x, target);
+    if (zt) flip_bit(z, control);
+  }
+}
+
+void PackedCliffTableau::apply_CX_at_end(unsigned control, unsigned target) {
+  const unsigned zc = size_ + control, zt = size_ + target;
+  phases_[control] = row_mult(
+      row_x(control), row_z(control), phases_[control], row_x(target),
+      row_z(target), phases_[target], 0, row_x(control), row_z(control));
+  phases_[zt] = row_mult(
+      row_x(zc), row_z(zc), phases_[zc], row_x(zt), row_z(zt), phases_[zt], 0,
+      row_x(zt), row_z(zt));
+}
+
+void PackedCliffTableau::apply_gate_at_front(
+    OpType type, const std::vector<unsigned> &qbs) {
+  apply_gate_sequence(
+      type, qbs, [this](unsigned q) { apply_S_at_front(q); },
+      [this](unsigned q) { apply_V_at_front(q); },
+      [this](unsigned c, unsigned t) { apply_CX_at_front(c, t); });
+}
+
+void PackedCliffTableau::apply_gate_at_front(
+    OpType type, const qubit_vector_t &qbs) {
+  std::vector<unsigned> uqbs;
+  for (const Qubit &qb : qbs) {
+    uqbs.push_back(qubits_.left.at(qb));
+  }
+  apply_gate_at_front(type, uqbs);
+}
+
+void PackedCliffTableau::apply_gate_at_end(
+    OpType type, const std::vector<unsigned> &qbs) {
+  apply_gate_sequence(
+      type, qbs, [this](unsigned q) { apply_S_at_end(q); },
+      [this](unsigned q) { apply_V_at_end(q); },
+      [this](unsigned c, unsigned t) { apply_CX_at_end(c, t); });
+}
+
+void PackedCliffTableau::apply_gate_at_end(
+    OpType type, const qubit_vector_t &qbs) {
+  std::vector<unsigned> uqbs;
+  for (const Qubit &qb : qbs) {
+    uqbs.push_back(qubits_.left.at(qb));
+  }
+  apply_gate_at_end(type, uqbs);
+}
+
+static OpType pi_rotation(Pauli p) {
+  switch (p) {
+    case Pauli::X:
+      return OpType::X;
+    case Pauli::Y:
+      return OpType::Y;
+    case Pauli::Z:
+      return OpType::Z;
+    default:
+      return OpType::noop;
+  }
+}
+
+void PackedCliffTableau::apply_pauli_at_front(
+    const QubitPauliTensor &pauli, unsigned half_pis) {
+  half_pis = half_pis % 4;
+  if (half_pis == 0) return;  // Identity
+  if (half_pis == 2) {        // Degenerates to product of PI rotations
+    for (const std::pair<const Qubit, Pauli> &term : pauli.string.map) {
+      apply_gate_at_front(pi_rotation(term.second), {term.first});
+    }
+    return;
+  }
+  if (pauli.coeff != 1. && pauli.coeff != -1.)
+    throw NotValid(
+        "Can only apply Paulis with real unit coefficients to "
+        "CliffTableaus");
+  // Each row R that anti-commutes with the gadget's Pauli P becomes i P R
+  // (-i P R for half_pis == 3).
+  std::vector<std::uint64_t> px, pz;
+  pack_pauli(pauli, px, pz);
+  const bool phase = (pauli.coeff == -1.) ^ (half_pis == 3);
+  for (unsigned r = 0; r < 2 * size_; r++) {
+    std::uint64_t *x = row_x(r);
+    std::uint64_t *z = row_z(r);
+    unsigned anti = 0;
+    for (unsigned k = 0; k < n_words_; k++) {
+      anti += std::popcount((x[k] & pz[k]) ^ (z[k] & px[k]));
+    }
+    if (anti % 2 == 1) {
+      phases_[r] =
+          row_mult(px.data(), pz.data(), phase, x, z, phases_[r], 1, x, z);
+    }
+  }
+}
+
+void PackedCliffTableau::apply_pauli_at_end(
+    const QubitPauliTensor &pauli, unsigned half_pis) {
+  half_pis = half_pis % 4;
+  if (half_pis == 0) return;  // Identity
+  if (half_pis == 2) {        // Degenerates to product of PI rotations
+    for (const std::pair<const Qubit, Pauli> &term : pauli.string.map) {
+      apply_gate_at_end(pi_rotation(term.second), {term.first});
+    }
+    return;
+  }
+
+  // From here, half_pis == 1 or 3
+  // They act the same except for a phase flip on the product term
+  if (pauli.coeff != 1. && pauli.coeff != -1.)
+    throw NotValid(
+        "Can only apply Paulis with real unit coefficients to "
+        "CliffTableaus");
+  std::vector<std::uint64_t> px(n_words_, 0), pz(n_words_, 0);
+  std::uint64_t *x = px.data();
+  std::uint64_t *z = pz.data();
+  bool phase = (pauli.coeff == -1.) ^ (half_pis == 3);
+
+  // Collect the product term
+  for (const std::pair<const Qubit, Pauli> &term : pauli.string.map) {
+    const unsigned xr = qubits_.left.at(term.first);
+    const unsigned zr = size_ + xr;
+    switch (term.second) {
+      case Pauli::I: {
+        break;
+      }
+      case Pauli::X: {
+        phase = row_mult(
+            row_x(xr), row_z(xr), phases_[xr], x, z, phase, 0, x, z);
+        break;
+      }
+      case Pauli::Y: {
+        phase = row_mult(
+            row_x(zr), row_z(zr), phases_[zr], x, z, phase, 0, x, z);
+        phase = row_mult(
+            row_x(xr), row_z(xr), phases_[xr], x, z, phase, 1, x, z);
+        break;
+      }
+      case Pauli::Z: {
+        phase = row_mult(
+            row_x(zr), row_z(zr), phases_[zr], x, z, phase, 0, x, z);
+        break;
+      }
+    }
+  }
+
+  // Apply the product term on the anti-commuting rows
+  for (const std::pair<const Qubit, Pauli> &term : pauli.string.map) {
+    const unsigned xr = qubits_.left.at(term.first);
+    const unsigned zr = size_ + xr;
+    if (term.second == Pauli::X || term.second == Pauli::Y) {
+      phases_[zr] = row_mult(
+          x, z, phase, row_x(zr), row_z(zr), phases_[zr], 1, row_x(zr),
+          row_z(zr));
+    }
+    if (term.second == Pauli::Y || term.second == Pauli::Z) {
+      phases_[xr] = row_mult(
+          x, z, phase, row_x(xr), row_z(xr), phases_[xr], 1, row_x(xr),
+          row_z(xr));
+    }
+  }
+}
+
+bool PackedCliffTableau::operator==(const PackedCliffTableau &other) const {
+  return size_ == other.size_ && qubits_ == other.qubits_ &&
+         bits_ == other.bits_ && phases_ == other.phases_;
+}
+
+}  // namespace tket
@@ -0,0 +1,159 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Clifford/CliffTableau.hpp"
+
+namespace tket {
+
+class Circuit;
+
+/**
+ * A Clifford tableau with the same semantics as \ref CliffTableau, but with
+ * each row stored as 64-bit words of bits rather than as one byte per bit.
+ *
+ * Row operations (gates at the end of the circuit, Pauli gadgets at either
+ * end) act on 64 inputs per word; the phase of a product of rows is computed
+ * with popcounts rather than a per-qubit table lookup. Column operations
+ * (single gates at the front) touch one bit in each row.
+ *
+ * This is intended for building, manipulating and synthesising large
+ * tableaus; convert to a \ref CliffTableau for comparison with existing code.
+ */
+class PackedCliffTableau {
+ public:
+  /**
+   * Construct the tableau for the identity over n qubits (given default qubit
+   * names).
+   */
+  explicit PackedCliffTableau(unsigned n);
+
+  /**
+   * Construct the tableau for the identity over specific qubits.
+   */
+  explicit PackedCliffTableau(const qubit_vector_t &qbs);
+
+  /**
+   * Pack an existing tableau.
+   */
+  explicit PackedCliffTableau(const CliffTableau &tab);
+
+  /**
+   * Unpack into a tableau over the same qubits.
+   */
+  CliffTableau to_tableau() const;
+
+  /**
+   * Access the Pauli string on the Z-channel of a given qubit with respect to
+   * all inputs.
+   */
+  QubitPauliTensor get_zpauli(const Qubit &qb) const;
+
+  /**
+   * Access the Pauli string on the X-channel of a given qubit with respect to
+   * all inputs.
+   */
+  QubitPauliTensor get_xpauli(const Qubit &qb) const;
+
+  /**
+   * Transform the tableau according to consuming a Clifford gate at either
+   * end of the circuit.
+   * Args are indices in the tableau's qubit ordering.
+   */
+  void apply_S_at_front(unsigned qb);
+  void apply_S_at_end(unsigned qb);
+  void apply_V_at_front(unsigned qb);
+  void apply_V_at_end(unsigned qb);
+  void apply_CX_at_front(unsigned control, unsigned target);
+  void apply_CX_at_end(unsigned control, unsigned target);
+
+  /**
+   * Transform the tableau according to consuming a Clifford gate at either
+   * end of the circuit.
+   */
+  void apply_gate_at_front(OpType type, const std::vector<unsigned> &qbs);
+  void apply_gate_at_front(OpType type, const qubit_vector_t &qbs);
+  void apply_gate_at_end(OpType type, const std::vector<unsigned> &qbs);
+  void apply_gate_at_end(OpType type, const qubit_vector_t &qbs);
+
+  /**
+   * Transform the tableau according to consuming a Clifford-phase pauli
+   * gadget at either end of the circuit.
+   *
+   * @param pauli The string of the pauli gadget
+   * @param half_pis The Clifford angle: {0, 1, 2, 3} represents {0, pi/2, pi,
+   * -pi/2}
+   */
+  void apply_pauli_at_front(const QubitPauliTensor &pauli, unsigned half_pis);
+  void apply_pauli_at_end(const QubitPauliTensor &pauli, unsigned half_pis);
+
+  bool operator==(const PackedCliffTableau &other) const;
+
+  friend Circuit tableau_to_circuit(const PackedCliffTableau &tab);
+
+ private:
+  /** Number of qubits */
+  unsigned size_;
+
+  /** Number of words per row of x (or z) bits */
+  unsigned n_words_;
+
+  /**
+   * Rows 0 to n-1 are the X-channels of the outputs, rows n to 2n-1 the
+   * Z-channels. Row r holds its x bits in words [2r * n_words_, (2r + 1) *
+   * n_words_) and its z bits in the following n_words_ words; bit j of a row
+   * refers to input j.
+   */
+  std::vector<std::uint64_t> bits_;
+
+  /** Whether there is a phase-flip on each row */
+  std::vector<bool> phases_;
+
+  /** Map from qubit IDs to their row/column index in tableau */
+  boost::bimap<Qubit, unsigned> qubits_;
+
+  std::uint64_t *row_x(unsigned r) { return bits_.data() + 2 * r * n_words_; }
+  std::uint64_t *row_z(unsigned r) {
+    return bits_.data() + (2 * r + 1) * n_words_;
+  }
+  const std::uint64_t *row_x(unsigned r) const {
+    return bits_.data() + 2 * r * n_words_;
+  }
+  const std::uint64_t *row_z(unsigned r) const {
+    return bits_.data() + (2 * r + 1) * n_words_;
+  }
+
+  /**
+   * Write into w the product of Pauli strings a and b (in that order), each
+   * given by its x and z words and phase-flip, times i^half_pis. Returns the
+   * phase-flip of the product. Either of a and b may alias w.
+   */
+  bool row_mult(
+      const std::uint64_t *xa, const std::uint64_t *za, bool pa,
+      const std::uint64_t *xb, const std::uint64_t *zb, bool pb,
+      unsigned half_pis, std::uint64_t *xw, std::uint64_t *zw) const;
+
+  /** Pack a Pauli tensor over the tableau's qubits into x and z words */
+  void pack_pauli(
+      const QubitPauliTensor &pauli, std::vector<std::uint64_t> &x,
+      std::vector<std::uint64_t> &z) const;
+
+  QubitPauliTensor get_row(unsigned r) const;
+};
+
+}  // namespace tket
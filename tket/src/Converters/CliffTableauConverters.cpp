@@ -12,23 +12,40 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstdint>
+
+#include "Clifford/PackedCliffTableau.hpp"
 #include "Converters.hpp"
 
 namespace tket {
 
+// Smallest tableau synthesised through PackedCliffTableau: below one word
+// per row, the Aaronson-Gottesman construction is as fast.
+static constexpr unsigned packed_synthesis_min_qubits = 64;
+
 CliffTableau circuit_to_tableau(const Circuit &circ) {
-  CliffTableau tab(circ.all_qubits());
+  // Gates at the end are row operations, which the packed tableau performs a
+  // word at a time.
+  const qubit_vector_t qubits = circ.all_qubits();
+  std::map<Qubit, unsigned> index;
+  for (unsigned i = 0; i < qubits.size(); i++) {
+    index.insert({qubits[i], i});
+  }
+  PackedCliffTableau tab(qubits);
   for (const Command &com : circ) {
     std::vector<unsigned> qbs;
     for (const UnitID &qb : com.get_args()) {
-      qbs.push_back(tab.qubits_.left.at(Qubit(qb)));
+      qbs.push_back(index.at(Qubit(qb)));
     }
     tab.apply_gate_at_end(com.get_op_ptr()->get_type(), qbs);
   }
-  return tab;
+  return tab.to_tableau();
 }
 
 Circuit tableau_to_circuit(const CliffTableau &tab) {
+  if (tab.size_ >= packed_synthesis_min_qubits) {
+    return tableau_to_circuit(PackedCliffTableau(tab));
+  }
   CliffTableau tabl(tab);
   unsigned size = tabl.size_;
   /*
@@ -252,4 +269,124 @@ Circuit tableau_to_circuit(const CliffTableau &tab) {
   return c;
 }
 
+static Pauli pauli_from_bits(bool x, bool z) {
+  if (x) return z ? Pauli::Y : Pauli::X;
+  return z ? Pauli::Z : Pauli::I;
+}
+
+static bool anticommute(Pauli p, Pauli q) {
+  return p != Pauli::I && q != Pauli::I && p != q;
+}
+
+Circuit tableau_to_circuit(const PackedCliffTableau &tab) {
+  PackedCliffTableau tabl(tab);
+  const unsigned size = tabl.size_;
+  /*
+   * The rows of the tableau of a unitary U are U^dagger P U for each output
+   * Pauli P. Appending a gate g to the end replaces U by gU, so we append
+   * gates until the tableau is the identity; U is then the inverse of the
+   * gates appended.
+   *
+   * Working on input qubit j in turn, let A = U X_j U^dagger and
+   * B = U Z_j U^dagger, which anticommute. The term of A on output k
+   * anticommutes with X_k (Z_k) exactly when row X_k (Z_k) has a Z on input
+   * j, and likewise for B with X on input j. Appended gates conjugate A and
+   * B, so we reduce them to X_j and Z_j as Pauli strings over the outputs.
+   * The outputs before j are already done, and A and B have no terms there.
+   */
+  std::vector<std::pair<OpType, std::vector<unsigned>>> gates;
+  auto append = [&](OpType type, const std::vector<unsigned> &qbs) {
+    tabl.apply_gate_at_end(type, qbs);
+    gates.push_back({type, qbs});
+  };
+  auto get_bit = [](const std::uint64_t *words, unsigned j) -> bool {
+    return (words[j / 64] >> (j % 64)) & 1;
+  };
+  auto a_term = [&](unsigned k, unsigned j) {
+    return pauli_from_bits(
+        get_bit(tabl.row_z(size + k), j), get_bit(tabl.row_z(k), j));
+  };
+  auto b_term = [&](unsigned k, unsigned j) {
+    return pauli_from_bits(
+        get_bit(tabl.row_x(size + k), j), get_bit(tabl.row_x(k), j));
+  };
+
+  for (unsigned j = 0; j < size; j++) {
+    // Some output has anticommuting terms of A and B; swap it to j.
+    unsigned pivot = j;
+    while (pivot < size && !anticommute(a_term(pivot, j), b_term(pivot, j))) {
+      pivot++;
+    }
+    if (pivot == size)
+      throw NotValid("Stabilisers are not mutually independent");
+    if (pivot != j) {
+      append(OpType::CX, {j, pivot});
+      append(OpType::CX, {pivot, j});
+      append(OpType::CX, {j, pivot});
+    }
+
+    // Make the terms on j X and Z.
+    Pauli a = a_term(j, j);
+    if (a == Pauli::Y) {
+      append(OpType::S, {j});
+    } else if (a == Pauli::Z) {
+      append(OpType::H, {j});
+    }
+    if (b_term(j, j) == Pauli::Y) append(OpType::V, {j});
+
+    // Turn each other term of A into X and cancel it with a CX from j. This
+    // only changes the Z part of the term of B on j.
+    for (unsigned k = j + 1; k < size; k++) {
+      a = a_term(k, j);
+      if (a == Pauli::I) continue;
+      if (a == Pauli::Y) {
+        append(OpType::S, {k});
+      } else if (a == Pauli::Z) {
+        append(OpType::H, {k});
+      }
+      append(OpType::CX, {j, k});
+    }
+
+    // A is now X_j, so B has Z on j. Turn each other term of B into Z and
+    // cancel it with a CX onto j, which leaves A unchanged.
+    for (unsigned k = j + 1; k < size; k++) {
+      const Pauli b = b_term(k, j);
+      if (b == Pauli::I) continue;
+      if (b == Pauli::X) {
+        append(OpType::H, {k});
+      } else if (b == Pauli::Y) {
+        append(OpType::V, {k});
+      }
+      append(OpType::CX, {k, j});
+    }
+  }
+
+  // The tableau is now the identity up to the sign of each row.
+  for (unsigned k = 0; k < size; k++) {
+    if (tabl.phases_[k]) append(OpType::Z, {k});
+    if (tabl.phases_[size + k]) append(OpType::X, {k});
+  }
+
+  Circuit c(size);
+  for (auto it = gates.rbegin(); it != gates.rend(); ++it) {
+    OpType type = it->first;
+    if (type == OpType::S) {
+      type = OpType::Sdg;
+    } else if (type == OpType::V) {
+      type = OpType::Vdg;
+    }
+    c.add_op<unsigned>(type, it->second);
+  }
+
+  unit_map_t rename_map;
+  for (boost::bimap<Qubit, unsigned>::iterator iter = tabl.qubits_.begin(),
+                                               iend = tabl.qubits_.end();
+       iter != iend; ++iter) {
+    rename_map.insert({Qubit(q_default_reg(), iter->right), iter->left});
+  }
+  c.rename_units(rename_map);
+
+  return c;
+}
+
 }  // namespace tket
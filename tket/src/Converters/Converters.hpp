@@ -16,7 +16,10 @@
 
 #include "Circuit/Circuit.hpp"
 #include "Clifford/CliffTableau.hpp"
+#include "Clifford/PackedCliffTableau.hpp"
+#include "Diagonalisation/PauliPartition.hpp"
 #include "PauliGraph/PauliGraph.hpp"
+#include "ZX/ZXDiagram.hpp"
 
 namespace tket {
 
@@ -31,9 +34,21 @@ CliffTableau circuit_to_tableau(const Circuit &circ);
  * Uses the method from Aaronson-Gottesman: Improved Simulation of
  * Stabilizer Circuits, Theorem 8.
  * CAUTION: GATE COUNT IS ATROCIOUS IN PRACTICE
+ * Tableaus of 64 or more qubits are synthesised as a PackedCliffTableau.
  */
 Circuit tableau_to_circuit(const CliffTableau &tab);
 
+/**
+ * Constructs a circuit producing the same effect as the packed tableau.
+ * Each qubit in turn is eliminated by gates appended to the end of the
+ * tableau, greedily: a qubit whose X and Z images anticommute on the
+ * current input is swapped into place, then the other qubits' terms are
+ * removed by one CX each, plus single-qubit gates. The circuit is the
+ * inverse of the gates applied. Each gate is a word-level row operation, so
+ * this takes O(n^3/64) time and produces at most about 2n^2 CX gates.
+ */
+Circuit tableau_to_circuit(const PackedCliffTableau &tab);
+
 PauliGraph circuit_to_pauli_graph(const Circuit &circ);
 
 /**
@@ -62,4 +77,79 @@ Circuit pauli_graph_to_circuit_pairwise(
 Circuit pauli_graph_to_circuit_sets(
     const PauliGraph &pg, CXConfigType cx_config = CXConfigType::Snake);
 
+/**
+ * Constructs a Trotterised circuit for the operator directly, without
+ * building a PauliExpBox for each term or a PauliGraph.
+ *
+ * Each term (P, t) stands for exp(-i (pi/2) t P), as for a PauliExpBox with
+ * angle t. The terms are partitioned into mutually commuting sets by
+ * term_sequence, and each set is diagonalised by mutual_diagonalise and
+ * synthesised as a phase polynomial. The sets are synthesised independently
+ * of each other in parallel (see \ref parallel_for), so the result does not
+ * depend on the number of threads.
+ *
+ * A step of order 1 exponentiates the sets in turn; a step of even order
+ * 2k is the symmetric Suzuki product formula of that order, which for
+ * order 2 exponentiates half of each set forwards and then backwards.
+ * Consecutive exponentials of the same set are merged, including across
+ * steps. Terms on no qubits only contribute a global phase.
+ *
+ * @param terms angle of each Pauli string, in half-turns
+ * @param order order of the product formula: 1, or a positive even number
+ * @param n_steps number of Trotter steps, each with angles scaled by
+ *   1 / n_steps
+ * @param strat strategy for partitioning the terms
+ * @param method graph colouring method for partitioning the terms
+ * @param cx_config which type of CX configuration to decompose into
+ * @return circuit on the qubits of the terms, in their default order
+ */
+Circuit trotter_circuit(
+    const std::map<QubitPauliString, Expr> &terms, unsigned order = 1,
+    unsigned n_steps = 1,
+    PauliPartitionStrat strat = PauliPartitionStrat::CommutingSets,
+    GraphColourMethod method = GraphColourMethod::Lazy,
+    CXConfigType cx_config = CXConfigType::Snake);
+
+/**
+ * Synthesises the PauliGraph in pieces, passing each to \p sink as soon as
+ * it is built, and removing each gadget from \p pg once it is synthesised,
+ * so that neither the whole graph nor the whole circuit need be held at once.
+ *
+ * Gadgets are taken in the order given by TopSortIterator and built as by
+ * pauli_graph_to_circuit_individually (or _pairwise, if \p pairwise). Every
+ * piece has all the qubits and bits of \p pg; appended in order they give the
+ * same circuit, with the tableau and the final measurements in the last piece.
+ * \p sink may append the pieces to a Circuit, or serialise and write them out.
+ *
+ * @param pg graph to synthesise, left with no gadgets
+ * @param sink called with each piece of the circuit, in order
+ * @param pairwise whether to synthesise the gadgets in pairs
+ * @param cx_config which type of CX configuration to decompose into
+ */
+void pauli_graph_to_circuit_streaming(
+    PauliGraph &pg, const std::function<void(const Circuit &)> &sink,
+    bool pairwise = false, CXConfigType cx_config = CXConfigType::Snake);
+
+/**
+ * Construct a ZXDiagram equal to the circuit up to a positive real scalar,
+ * with an input and an output for each qubit, in the order of `all_qubits`.
+ * The global phase of the circuit is held in the scalar of the diagram.
+ * Implicit qubit permutations are kept as crossed wires.
+ * Will throw an exception if the circuit has bits, or gates other than
+ * Clifford+T gates, Rz, Rx, Ry, U1, TK1, CX, CZ and SWAP.
+ */
+zx::ZXDiagram circuit_to_zx(const Circuit &circ);
+
+/**
+ * Extracts a circuit of Rz, H, CX, CZ and SWAP gates equal to a ZXDiagram
+ * up to a positive real scalar, using the gflow-based method of Duncan et al.
+ * Graph-theoretic Simplification of Quantum Circuits with the ZX-calculus,
+ * Section 5. The phase of the scalar becomes the global phase of the circuit,
+ * unless it cannot be evaluated because it depends on symbols, in which case
+ * the circuit is only equal to the diagram up to a global scalar.
+ * Will throw a ZXError if the diagram has classical boundaries or no gflow,
+ * as can happen for diagrams not built from circuits.
+ */
+Circuit zx_to_circuit(const zx::ZXDiagram &diag);
+
 }  // namespace tket
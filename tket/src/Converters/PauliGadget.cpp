@@ -14,7 +14,11 @@
 
 #include "PauliGadget.hpp"
 
+#include <algorithm>
+
 #include "Circuit/CircUtils.hpp"
+#include "Utils/Cancellation.hpp"
+#include "Utils/Parallel.hpp"
 
 namespace tket {
 
@@ -302,4 +306,44 @@ void append_pauli_gadget_pair(
   circ.append(udg);
 }
 
+// Number of consecutive pairs of gadgets synthesised together by one task.
+static constexpr std::size_t pairs_per_block = 64;
+
+void append_pauli_gadgets_pairwise(
+    Circuit &circ,
+    const std::vector<std::pair<QubitPauliTensor, Expr>> &gadgets,
+    CXConfigType cx_config) {
+  Circuit spare_circ;
+  for (const Qubit &qb : circ.all_qubits()) {
+    spare_circ.add_qubit(qb);
+  }
+  const std::size_t block_size = 2 * pairs_per_block;
+  const std::size_t n_blocks = (gadgets.size() + block_size - 1) / block_size;
+  std::vector<Circuit> block_circs(n_blocks);
+  parallel_for(0, n_blocks, 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t b = begin; b < end; ++b) {
+      check_cancellation();
+      Circuit block_circ = spare_circ;
+      const std::size_t last =
+          std::min(gadgets.size(), (b + 1) * block_size);
+      std::size_t g = b * block_size;
+      for (; g + 1 < last; g += 2) {
+        append_pauli_gadget_pair(
+            block_circ, gadgets[g].first, gadgets[g].second,
+            gadgets[g + 1].first, gadgets[g + 1].second, cx_config);
+      }
+      // Blocks hold an even number of gadgets, so only the last can have
+      // one left over.
+      if (g < last) {
+        append_single_pauli_gadget(
+            block_circ, gadgets[g].first, gadgets[g].second, cx_config);
+      }
+      block_circs[b] = std::move(block_circ);
+    }
+  });
+  for (const Circuit &block_circ : block_circs) {
+    circ.append(block_circ);
+  }
+}
+
 }  // namespace tket
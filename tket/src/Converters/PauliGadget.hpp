@@ -52,4 +52,21 @@ void append_pauli_gadget_pair(
     QubitPauliTensor pauli1, Expr angle1,
     CXConfigType cx_config = CXConfigType::Snake);
 
+/**
+ * Append a sequence of Pauli gadgets to the end of a given circuit, as
+ * consecutive pairs (see \ref append_pauli_gadget_pair), with the last one
+ * on its own if there are an odd number.
+ *
+ * Blocks of pairs are synthesised in parallel (see \ref parallel_for) and
+ * appended in order, so the result does not depend on the number of threads.
+ *
+ * @param circ circuit to append to
+ * @param gadgets Pauli strings and their angles (half-turns), in order
+ * @param cx_config which type of CX configuration to decompose into
+ */
+void append_pauli_gadgets_pairwise(
+    Circuit& circ,
+    const std::vector<std::pair<QubitPauliTensor, Expr>>& gadgets,
+    CXConfigType cx_config = CXConfigType::Snake);
+
 }  // namespace tket
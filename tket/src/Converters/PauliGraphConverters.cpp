@@ -12,12 +12,17 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cmath>
+
 #include "Circuit/Boxes.hpp"
+#include "Circuit/CommandView.hpp"
 #include "Converters.hpp"
 #include "Converters/PhasePoly.hpp"
 #include "Diagonalisation/Diagonalisation.hpp"
 #include "Gate/Gate.hpp"
 #include "PauliGadget.hpp"
+#include "Utils/Cancellation.hpp"
+#include "Utils/Parallel.hpp"
 
 namespace tket {
 
@@ -34,7 +39,7 @@ PauliGraph circuit_to_pauli_graph(const Circuit &circ) {
     }
   }
   PauliGraph pg(circ.all_qubits(), circ.all_bits());
-  for (const Command &com : circ) {
+  for (const CommandView &com : CommandViews(circ)) {
     const Op &op = *com.get_op_ptr();
     unit_vector_t args = com.get_args();
     OpDesc od = op.get_desc();
@@ -83,6 +88,7 @@ Circuit pauli_graph_to_circuit_individually(
     circ.add_bit(b);
   }
   for (PauliGraph::TopSortIterator it = pg.begin(); it != pg.end(); ++it) {
+    check_cancellation();
     PauliVert vert = *it;
     const QubitPauliTensor &pauli = pg.graph_[vert].tensor_;
     const Expr &angle = pg.graph_[vert].angle_;
@@ -105,22 +111,13 @@ Circuit pauli_graph_to_circuit_pairwise(
   for (const Bit &b : pg.bits_) {
     circ.add_bit(b);
   }
-  PauliGraph::TopSortIterator it = pg.begin();
-  while (it != pg.end()) {
-    PauliVert vert0 = *it;
-    const QubitPauliTensor &pauli0 = pg.graph_[vert0].tensor_;
-    const Expr &angle0 = pg.graph_[vert0].angle_;
-    ++it;
-    if (it == pg.end()) {
-      append_single_pauli_gadget(circ, pauli0, angle0, cx_config);
-    } else {
-      PauliVert vert1 = *it;
-      const QubitPauliTensor &pauli1 = pg.graph_[vert1].tensor_;
-      const Expr &angle1 = pg.graph_[vert1].angle_;
-      ++it;
-      append_pauli_gadget_pair(circ, pauli0, angle0, pauli1, angle1, cx_config);
-    }
+  std::vector<std::pair<QubitPauliTensor, Expr>> gadgets;
+  for (PauliGraph::TopSortIterator it = pg.begin(); it != pg.end(); ++it) {
+    check_cancellation();
+    const PauliGadgetProperties &pgp = pg.graph_[*it];
+    gadgets.push_back({pgp.tensor_, pgp.angle_});
   }
+  append_pauli_gadgets_pairwise(circ, gadgets, cx_config);
   Circuit cliff_circuit = tableau_to_circuit(pg.cliff_);
   circ.append(cliff_circuit);
   for (auto it = pg.measures_.begin(); it != pg.measures_.end(); ++it) {
@@ -129,7 +126,113 @@ Circuit pauli_graph_to_circuit_pairwise(
   return circ;
 }
 
-/* Currently follows a greedy set-building method */
+// Gadgets synthesised into each piece of a streamed circuit.
+static constexpr unsigned gadgets_per_piece = 128;
+
+void pauli_graph_to_circuit_streaming(
+    PauliGraph &pg, const std::function<void(const Circuit &)> &sink,
+    bool pairwise, CXConfigType cx_config) {
+  Circuit spare_circ;
+  for (const Qubit &qb : pg.cliff_.get_qubits()) {
+    spare_circ.add_qubit(qb);
+  }
+  for (const Bit &b : pg.bits_) {
+    spare_circ.add_bit(b);
+  }
+  // The gadgets with no predecessors left, in the order TopSortIterator
+  // would visit them.
+  std::set<std::pair<QubitPauliTensor, PauliVert>> ready;
+  for (const PauliVert &vert : pg.start_line_) {
+    ready.insert({pg.graph_[vert].tensor_, vert});
+  }
+  // Remove the first ready gadget from the graph.
+  auto pop_gadget = [&]() {
+    const PauliVert vert = ready.begin()->second;
+    ready.erase(ready.begin());
+    std::pair<QubitPauliTensor, Expr> gadget = {
+        std::move(pg.graph_[vert].tensor_), std::move(pg.graph_[vert].angle_)};
+    const PauliVertSet children = pg.get_successors(vert);
+    pg.unindex_gadget(vert);
+    pg.start_line_.erase(vert);
+    pg.end_line_.erase(vert);
+    boost::clear_vertex(vert, pg.graph_);
+    boost::remove_vertex(vert, pg.graph_);
+    for (const PauliVert &child : children) {
+      if (boost::in_degree(child, pg.graph_) == 0) {
+        pg.start_line_.insert(child);
+        ready.insert({pg.graph_[child].tensor_, child});
+      }
+    }
+    return gadget;
+  };
+  while (!ready.empty()) {
+    Circuit piece = spare_circ;
+    for (unsigned g = 0; g < gadgets_per_piece && !ready.empty(); g++) {
+      check_cancellation();
+      auto [pauli0, angle0] = pop_gadget();
+      if (pairwise && !ready.empty()) {
+        auto [pauli1, angle1] = pop_gadget();
+        g++;
+        append_pauli_gadget_pair(
+            piece, pauli0, angle0, pauli1, angle1, cx_config);
+      } else {
+        append_single_pauli_gadget(piece, pauli0, angle0, cx_config);
+      }
+    }
+    sink(piece);
+  }
+  Circuit piece = spare_circ;
+  piece.append(tableau_to_circuit(pg.cliff_));
+  for (auto it = pg.measures_.begin(); it != pg.measures_.end(); ++it) {
+    piece.add_measure(it->left, it->right);
+  }
+  sink(piece);
+}
+
+/**
+ * Synthesise a set of mutually commuting gadgets as a circuit over all the
+ * qubits of \p spare_circ (which has no gates).
+ */
+static Circuit gadget_set_to_circuit(
+    const QubitOperator &gadget_map, const std::set<Qubit> &qbs,
+    const Circuit &spare_circ, CXConfigType cx_config) {
+  Circuit circ(spare_circ);
+  if (gadget_map.size() == 1) {
+    const std::pair<const QubitPauliTensor, Expr> &pgp0 = *gadget_map.begin();
+    append_single_pauli_gadget(circ, pgp0.first, pgp0.second, cx_config);
+  } else if (gadget_map.size() == 2) {
+    const std::pair<const QubitPauliTensor, Expr> &pgp0 = *gadget_map.begin();
+    const std::pair<const QubitPauliTensor, Expr> &pgp1 =
+        *(++gadget_map.begin());
+    append_pauli_gadget_pair(
+        circ, pgp0.first, pgp0.second, pgp1.first, pgp1.second, cx_config);
+  } else {
+    std::list<std::pair<QubitPauliTensor, Expr>> gadgets;
+    for (const std::pair<const QubitPauliTensor, Expr> &qps_pair :
+         gadget_map) {
+      gadgets.push_back(qps_pair);
+    }
+    Circuit cliff_circ = mutual_diagonalise(gadgets, qbs, cx_config);
+    circ.append(cliff_circ);
+    Circuit phase_poly_circ(spare_circ);
+    for (const std::pair<QubitPauliTensor, Expr> &pgp : gadgets) {
+      append_single_pauli_gadget(phase_poly_circ, pgp.first, pgp.second);
+    }
+    PhasePolyBox ppbox(phase_poly_circ);
+    Circuit after_synth_circ = *ppbox.to_circuit();
+    circ.append(after_synth_circ);
+    circ.append(cliff_circ.dagger());
+  }
+  return circ;
+}
+
+/**
+ * Currently follows a greedy set-building method.
+ *
+ * The sets are chosen in topological order, then synthesised independently
+ * of each other in parallel (see \ref parallel_for) and appended in order,
+ * so the result does not depend on the number of threads.
+ */
 Circuit pauli_graph_to_circuit_sets(
     const PauliGraph &pg, CXConfigType cx_config) {
   Circuit circ;
@@ -142,8 +245,10 @@ Circuit pauli_graph_to_circuit_sets(
   for (const Bit &b : pg.bits_) {
     circ.add_bit(b);
   }
+  std::vector<QubitOperator> gadget_sets;
   PauliGraph::TopSortIterator it = pg.begin();
   while (it != pg.end()) {
+    check_cancellation();
     const PauliGadgetProperties &pgp = pg.graph_[*it];
     QubitOperator gadget_map;
     gadget_map[pgp.tensor_] = pgp.angle_;
@@ -166,32 +271,19 @@ Circuit pauli_graph_to_circuit_sets(
       }
       ++it;
     }
-    if (gadget_map.size() == 1) {
-      const std::pair<const QubitPauliTensor, Expr> &pgp0 = *gadget_map.begin();
-      append_single_pauli_gadget(circ, pgp0.first, pgp0.second, cx_config);
-    } else if (gadget_map.size() == 2) {
-      const std::pair<const QubitPauliTensor, Expr> &pgp0 = *gadget_map.begin();
-      const std::pair<const QubitPauliTensor, Expr> &pgp1 =
-          *(++gadget_map.begin());
-      append_pauli_gadget_pair(
-          circ, pgp0.first, pgp0.second, pgp1.first, pgp1.second, cx_config);
-    } else {
-      std::list<std::pair<QubitPauliTensor, Expr>> gadgets;
-      for (const std::pair<const QubitPauliTensor, Expr> &qps_pair :
-           gadget_map) {
-        gadgets.push_back(qps_pair);
-      }
-      Circuit cliff_circ = mutual_diagonalise(gadgets, qbs, cx_config);
-      circ.append(cliff_circ);
-      Circuit phase_poly_circ(spare_circ);
-      for (const std::pair<QubitPauliTensor, Expr> &pgp : gadgets) {
-        append_single_pauli_gadget(phase_poly_circ, pgp.first, pgp.second);
-      }
-      PhasePolyBox ppbox(phase_poly_circ);
-      Circuit after_synth_circ = *ppbox.to_circuit();
-      circ.append(after_synth_circ);
-      circ.append(cliff_circ.dagger());
-    }
+    gadget_sets.push_back(std::move(gadget_map));
+  }
+  std::vector<Circuit> set_circs(gadget_sets.size());
+  parallel_for(
+      0, gadget_sets.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+          check_cancellation();
+          set_circs[i] = gadget_set_to_circuit(
+              gadget_sets[i], qbs, spare_circ, cx_config);
+        }
+      });
+  for (const Circuit &set_circ : set_circs) {
+    circ.append(set_circ);
   }
   Circuit cliff_circuit = tableau_to_circuit(pg.cliff_);
   circ.append(cliff_circuit);
@@ -201,4 +293,120 @@ Circuit pauli_graph_to_circuit_sets(
   return circ;
 }
 
+namespace {
+
+// The exponentials making up a Trotterised circuit, as the index of the set
+// of terms and the fraction of their angles for each, in order
+class TrotterSchedule {
+ public:
+  // Append one step of the product formula of the given order, on sets
+  // 0, ..., n_sets - 1, with angles scaled by fraction
+  void add_step(unsigned n_sets, unsigned order, double fraction) {
+    if (order == 1) {
+      for (unsigned i = 0; i < n_sets; ++i) add(i, fraction);
+    } else if (order == 2) {
+      for (unsigned i = 0; i < n_sets; ++i) add(i, fraction / 2);
+      for (unsigned i = n_sets; i-- > 0;) add(i, fraction / 2);
+    } else {
+      // Suzuki's recursion, from order - 2 to order
+      const double p = 1. / (4. - std::pow(4., 1. / (order - 1)));
+      add_step(n_sets, order - 2, p * fraction);
+      add_step(n_sets, order - 2, p * fraction);
+      add_step(n_sets, order - 2, (1. - 4. * p) * fraction);
+      add_step(n_sets, order - 2, p * fraction);
+      add_step(n_sets, order - 2, p * fraction);
+    }
+  }
+
+  const std::vector<std::pair<unsigned, double>> &entries() const {
+    return entries_;
+  }
+
+ private:
+  std::vector<std::pair<unsigned, double>> entries_;
+
+  // Consecutive exponentials of the same set commute, so are merged
+  void add(unsigned set, double fraction) {
+    if (!entries_.empty() && entries_.back().first == set) {
+      entries_.back().second += fraction;
+    } else {
+      entries_.push_back({set, fraction});
+    }
+  }
+};
+
+}  // namespace
+
+Circuit trotter_circuit(
+    const std::map<QubitPauliString, Expr> &terms, unsigned order,
+    unsigned n_steps, PauliPartitionStrat strat, GraphColourMethod method,
+    CXConfigType cx_config) {
+  if (order == 0 || (order > 1 && order % 2 != 0)) {
+    throw NotValid("Trotter order must be 1 or a positive even number");
+  }
+  if (n_steps == 0) {
+    throw NotValid("Number of Trotter steps must be positive");
+  }
+  std::map<QubitPauliString, Expr> angles;
+  std::set<Qubit> qbs;
+  Expr phase(0);
+  for (const std::pair<const QubitPauliString, Expr> &term : terms) {
+    QubitPauliString qps = term.first;
+    qps.compress();
+    if (qps.map.empty()) {
+      // exp(-i (pi/2) t I) is a phase of -t/2 half-turns
+      phase -= term.second / 2;
+      continue;
+    }
+    for (const std::pair<const Qubit, Pauli> &qp : qps.map) {
+      qbs.insert(qp.first);
+    }
+    angles[qps] += term.second;
+  }
+  Circuit spare_circ;
+  for (const Qubit &qb : qbs) spare_circ.add_qubit(qb);
+  Circuit circ(spare_circ);
+  circ.add_phase(phase);
+  if (angles.empty()) return circ;
+
+  std::list<QubitPauliString> strings;
+  for (const std::pair<const QubitPauliString, Expr> &term : angles) {
+    strings.push_back(term.first);
+  }
+  const std::list<std::list<QubitPauliString>> sets =
+      term_sequence(strings, strat, method);
+  std::vector<const std::list<QubitPauliString> *> set_ptrs;
+  for (const std::list<QubitPauliString> &set : sets) set_ptrs.push_back(&set);
+
+  TrotterSchedule schedule;
+  for (unsigned i = 0; i < n_steps; ++i) {
+    schedule.add_step(set_ptrs.size(), order, 1. / n_steps);
+  }
+  // Each distinct exponential is synthesised once
+  std::map<std::pair<unsigned, double>, unsigned> index_of;
+  std::vector<std::pair<unsigned, double>> distinct;
+  for (const std::pair<unsigned, double> &entry : schedule.entries()) {
+    if (index_of.insert({entry, distinct.size()}).second) {
+      distinct.push_back(entry);
+    }
+  }
+  std::vector<Circuit> set_circs(distinct.size());
+  parallel_for(0, distinct.size(), 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      check_cancellation();
+      QubitOperator gadget_map;
+      for (const QubitPauliString &qps : *set_ptrs[distinct[i].first]) {
+        gadget_map[QubitPauliTensor(qps)] =
+            angles.at(qps) * Expr(distinct[i].second);
+      }
+      set_circs[i] =
+          gadget_set_to_circuit(gadget_map, qbs, spare_circ, cx_config);
+    }
+  });
+  for (const std::pair<unsigned, double> &entry : schedule.entries()) {
+    circ.append(set_circs[index_of.at(entry)]);
+  }
+  return circ;
+}
+
 }  // namespace tket
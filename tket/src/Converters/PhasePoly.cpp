@@ -15,7 +15,11 @@
 #include "PhasePoly.hpp"
 
 #include <algorithm>
+#include <bit>
+#include <boost/functional/hash.hpp>
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "Circuit/Boxes.hpp"
@@ -25,15 +29,48 @@
 #include "Ops/MetaOp.hpp"
 #include "Ops/OpJsonFactory.hpp"
 #include "Ops/OpPtr.hpp"
+#include "Utils/BinaryMatrix.hpp"
 #include "Utils/GraphHeaders.hpp"
 #include "Utils/Json.hpp"
 #include "Utils/TketLog.hpp"
 
 namespace tket {
 
+/* A parity packed 64 qubits to a word; bits past the qubit count are zero.
+Terms are merged and the split heuristic counted on these, so that adding a
+row of the linear transformation or hashing a parity is a few word
+operations rather than one per qubit. */
+typedef std::vector<std::uint64_t> packed_parity_t;
+typedef std::pair<packed_parity_t, Expr> packed_term_t;
+
+struct PackedParityHash {
+  std::size_t operator()(const packed_parity_t& parity) const {
+    return boost::hash_range(parity.begin(), parity.end());
+  }
+};
+
+static bool parity_bit(const packed_parity_t& parity, unsigned i) {
+  return (parity[i / 64] >> (i % 64)) & 1;
+}
+
+static packed_parity_t pack_parity(const std::vector<bool>& vec) {
+  packed_parity_t parity((vec.size() + 63) / 64, 0);
+  for (unsigned i = 0; i < vec.size(); ++i) {
+    if (vec[i]) parity[i / 64] |= std::uint64_t{1} << (i % 64);
+  }
+  return parity;
+}
+
+static std::vector<bool> unpack_parity(
+    const packed_parity_t& parity, unsigned n_qubits) {
+  std::vector<bool> vec(n_qubits);
+  for (unsigned i = 0; i < n_qubits; ++i) vec[i] = parity_bit(parity, i);
+  return vec;
+}
+
 /* Used only for gray_synth */
 struct SynthStruct {
-  std::list<phase_term_t> terms;
+  std::list<packed_term_t> terms;
   std::set<unsigned> remaining_indices;
   std::optional<unsigned> target;
 };
@@ -41,10 +78,10 @@ struct SynthStruct {
 // update the phase gadgets when adding a CNOT
 static void adjust_vectors(
     unsigned ctrl, unsigned tgt, std::list<SynthStruct>& Q) {
+  const std::uint64_t ctrl_mask = std::uint64_t{1} << (ctrl % 64);
   for (SynthStruct& S : Q) {
-    for (std::pair<std::vector<bool>, Expr>& term : S.terms) {
-      std::vector<bool>& vec = term.first;
-      vec[ctrl] = vec[ctrl] ^ vec[tgt];
+    for (packed_term_t& term : S.terms) {
+      if (parity_bit(term.first, tgt)) term.first[ctrl / 64] ^= ctrl_mask;
     }
   }
 }
@@ -52,15 +89,21 @@ static void adjust_vectors(
 // see https://arxiv.org/pdf/1712.01859.pdf p12, line 18
 // get qubit with either greatest or least hamming weight
 static unsigned find_best_split(
-    const std::list<phase_term_t>& terms, const std::set<unsigned>& indices) {
+    unsigned n_qubits, const std::list<packed_term_t>& terms,
+    const std::set<unsigned>& indices) {
+  // count the ones of every qubit at once, visiting only the set bits
+  std::vector<int> ones(n_qubits, 0);
+  for (const packed_term_t& term : terms) {
+    for (unsigned w = 0; w < term.first.size(); ++w) {
+      for (std::uint64_t word = term.first[w]; word; word &= word - 1) {
+        ++ones[64 * w + std::countr_zero(word)];
+      }
+    }
+  }
   int max = -1;
   int max_i = -1;
   for (unsigned i : indices) {
-    int num_ones = std::count_if(
-        terms.begin(), terms.end(),
-        [=](const std::pair<std::vector<bool>, Expr>& term) {
-          return term.first[i];
-        });
+    int num_ones = ones[i];
     int num_zeros = terms.size() - num_ones;
 
     if (num_zeros > max || num_ones > max) {
@@ -73,35 +116,41 @@ static unsigned find_best_split(
 }
 
 // divide into S0 and S1 based on value at qubit j
-static std::pair<std::list<phase_term_t>, std::list<phase_term_t>> split(
-    std::list<phase_term_t>& terms, int j) {
-  std::list<phase_term_t> zeros;
-  std::list<phase_term_t> ones;
+static std::pair<std::list<packed_term_t>, std::list<packed_term_t>> split(
+    std::list<packed_term_t>& terms, int j) {
+  std::list<packed_term_t> zeros;
+  std::list<packed_term_t> ones;
 
   while (!terms.empty()) {
-    if (terms.front().first[j])
+    if (parity_bit(terms.front().first, j))
       ones.splice(ones.end(), terms, terms.begin());
     else
       zeros.splice(zeros.end(), terms, terms.begin());
   }
 
-  return std::make_pair(zeros, ones);
+  return std::make_pair(std::move(zeros), std::move(ones));
 }
 
 /* see: arXiv:1712.01859 */
 Circuit gray_synth(
     unsigned n_qubits, const std::list<phase_term_t>& parities,
     const MatrixXb& linear_transformation) {
-  MatrixXb A = linear_transformation;
+  // column operations on the linear transformation are row operations on
+  // its transpose
+  BinaryMatrix At(MatrixXb(linear_transformation.transpose()));
   Circuit circ(n_qubits);
   std::list<SynthStruct> Q;  // used to recur over
   std::set<unsigned>
       indices;  // correspond to qubits which have to be recurred over
   for (unsigned i = 0; i < n_qubits; ++i) indices.insert(i);
-  Q.push_front({parities, indices, std::nullopt});
+  std::list<packed_term_t> terms;
+  for (const phase_term_t& term : parities) {
+    terms.push_back({pack_parity(term.first), term.second});
+  }
+  Q.push_front({std::move(terms), indices, std::nullopt});
 
   while (!Q.empty()) {
-    SynthStruct S = Q.front();
+    SynthStruct S = std::move(Q.front());
     Q.pop_front();
 
     if (S.terms.size() == 0) continue;
@@ -110,34 +159,32 @@ Circuit gray_synth(
       // special case to avoid doing extra recursion
       unsigned tgt = *(S.target);
       auto& [vec, angle] = S.terms.front();
-      for (unsigned ctrl = 0; ctrl < vec.size(); ++ctrl) {
-        if (ctrl != tgt && vec[ctrl]) {
+      for (unsigned ctrl = 0; ctrl < n_qubits; ++ctrl) {
+        if (ctrl != tgt && parity_bit(vec, ctrl)) {
           circ.add_op<unsigned>(OpType::CX, {ctrl, tgt});
           adjust_vectors(ctrl, tgt, Q);
-          for (unsigned i = 0; i < A.rows(); i++) {
-            // do column operation on linear
-            // transformation
-            // this will allow us to correct for the CXs
-            // we produce here using Gaussian elim
-            A(i, ctrl) ^= A(i, tgt);
-          }
+          // do column operation on linear transformation
+          // this will allow us to correct for the CXs
+          // we produce here using Gaussian elim
+          At.add_row(tgt, ctrl);
         }
       }
       circ.add_op<unsigned>(OpType::Rz, angle, {tgt});
     } else if (!S.remaining_indices.empty()) {
-      unsigned i = find_best_split(S.terms, S.remaining_indices);
+      unsigned i = find_best_split(n_qubits, S.terms, S.remaining_indices);
       auto [S0, S1] = split(S.terms, i);
 
       S.remaining_indices.erase(i);
 
       if (S.target) {
-        Q.push_front({S1, S.remaining_indices, S.target});
+        Q.push_front({std::move(S1), S.remaining_indices, S.target});
       } else {
-        Q.push_front({S1, S.remaining_indices, i});
+        Q.push_front({std::move(S1), S.remaining_indices, i});
       }
-      Q.push_front({S0, S.remaining_indices, S.target});
+      Q.push_front({std::move(S0), S.remaining_indices, S.target});
     }
   }
+  MatrixXb A = At.to_MatrixXb().transpose();
   DiagMatrix m(A);
   CXMaker cxmaker(n_qubits, false);
   m.gauss(cxmaker);
@@ -194,31 +241,37 @@ PhasePolyBox::PhasePolyBox(const Circuit& circ)
     qubit_indices_.insert({qb, i});
     ++i;
   }
-  linear_transformation_ = MatrixXb::Identity(n_qubits_, n_qubits_);
+  // rows of the linear transformation, and the distinct parities in order
+  // of first appearance with their merged angles
+  BinaryMatrix rows(n_qubits_, n_qubits_);
+  for (unsigned j = 0; j < n_qubits_; ++j) rows.set(j, j, true);
+  std::unordered_map<packed_parity_t, unsigned, PackedParityHash> term_index;
+  std::vector<packed_term_t> terms;
+  packed_parity_t parity;
   for (const Command& com : newcirc) {
     OpType ot = com.get_op_ptr()->get_type();
     unit_vector_t qbs = com.get_args();
     if (ot == OpType::CX) {
       unsigned ctrl = qubit_indices_.left.at(Qubit(qbs[0]));
       unsigned target = qubit_indices_.left.at(Qubit(qbs[1]));
-      for (unsigned j = 0; j < n_qubits_; ++j) {
-        linear_transformation_.row(target)[j] ^=
-            linear_transformation_.row(ctrl)[j];
-      }
+      rows.add_row(ctrl, target);
     } else if (ot == OpType::Rz) {
       unsigned qb = qubit_indices_.left.at(Qubit(qbs[0]));
-      std::vector<bool> boolvec(n_qubits_);
-      for (unsigned j = 0; j < n_qubits_; ++j) {
-        boolvec[j] = linear_transformation_.row(qb)[j];
-      }
-      PhasePolynomial::iterator pp_it = phase_polynomial_.find(boolvec);
-      if (pp_it == phase_polynomial_.end())
-        phase_polynomial_[boolvec] = com.get_op_ptr()->get_params().at(0);
+      rows.get_segment(qb, 0, n_qubits_, parity);
+      const Expr angle = com.get_op_ptr()->get_params().at(0);
+      auto [it, inserted] = term_index.insert({parity, unsigned(terms.size())});
+      if (inserted)
+        terms.push_back({parity, angle});
       else
-        pp_it->second += com.get_op_ptr()->get_params().at(0);
+        terms[it->second].second += angle;
     } else
       TKET_ASSERT(!"Only CXs and Rzs allowed in Phase Polynomials");
   }
+  linear_transformation_ = rows.to_MatrixXb();
+  for (const packed_term_t& term : terms) {
+    phase_polynomial_.insert(
+        {unpack_parity(term.first, n_qubits_), term.second});
+  }
 }
 
 PhasePolyBox::PhasePolyBox(
@@ -0,0 +1,364 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "Circuit/CommandView.hpp"
+#include "Converters.hpp"
+#include "Utils/Constants.hpp"
+#include "Utils/Expression.hpp"
+#include "Utils/MatrixAnalysis.hpp"
+#include "ZX/CompactZXGraph.hpp"
+#include "ZX/Rewrite.hpp"
+
+namespace tket {
+
+using namespace zx;
+
+namespace {
+
+// The open end of a qubit's wire while building a diagram from a circuit
+struct QubitTrack {
+  ZXVert last;
+  // Whether the next wire from `last` is a Hadamard wire
+  bool h_pending;
+};
+
+ZXVert extend_track(
+    ZXDiagram &diag, QubitTrack &track, ZXType type, const Expr &phase) {
+  ZXVert v = diag.add_vertex(type, phase);
+  diag.add_wire(
+      track.last, v, track.h_pending ? ZXWireType::H : ZXWireType::Basic);
+  track.last = v;
+  track.h_pending = false;
+  return v;
+}
+
+// A gate of an extracted circuit
+struct ExtractedGate {
+  OpType type;
+  std::vector<unsigned> qubits;
+  Expr phase;
+};
+
+}  // namespace
+
+ZXDiagram circuit_to_zx(const Circuit &circ) {
+  if (circ.n_bits() != 0) {
+    throw Unsupported("Cannot convert a circuit with bits to a ZXDiagram");
+  }
+  const qubit_vector_t qubits = circ.all_qubits();
+  const unsigned n = qubits.size();
+  std::map<Qubit, unsigned> index;
+  for (unsigned i = 0; i < n; ++i) index.insert({qubits[i], i});
+  ZXDiagram diag(n, n, 0, 0);
+  ZXVertVec ins = diag.get_boundary(ZXType::Input);
+  ZXVertVec outs = diag.get_boundary(ZXType::Output);
+  std::vector<QubitTrack> tracks;
+  tracks.reserve(n);
+  for (unsigned i = 0; i < n; ++i) tracks.push_back({ins[i], false});
+  // Phase by which the circuit differs from its spiders, in half-turns. A
+  // Z spider with phase a is diag(1, e^{i pi a}) = e^{i pi a/2} Rz(a).
+  Expr phase = circ.get_phase();
+
+  for (const CommandView &com : CommandViews(circ)) {
+    const Op_ptr &op = com.get_op_ptr();
+    std::vector<unsigned> qbs;
+    for (const UnitID &qb : com.get_args()) {
+      qbs.push_back(index.at(Qubit(qb)));
+    }
+    std::vector<Expr> params = op->get_params();
+    switch (op->get_type()) {
+      case OpType::noop:
+        break;
+      case OpType::Z:
+        extend_track(diag, tracks[qbs[0]], ZXType::ZSpider, 1);
+        break;
+      case OpType::S:
+        extend_track(diag, tracks[qbs[0]], ZXType::ZSpider, 0.5);
+        break;
+      case OpType::Sdg:
+        extend_track(diag, tracks[qbs[0]], ZXType::ZSpider, -0.5);
+        break;
+      case OpType::T:
+        extend_track(diag, tracks[qbs[0]], ZXType::ZSpider, 0.25);
+        break;
+      case OpType::Tdg:
+        extend_track(diag, tracks[qbs[0]], ZXType::ZSpider, -0.25);
+        break;
+      case OpType::Rz:
+        extend_track(diag, tracks[qbs[0]], ZXType::ZSpider, params[0]);
+        phase -= params[0] / 2;
+        break;
+      case OpType::U1:
+        extend_track(diag, tracks[qbs[0]], ZXType::ZSpider, params[0]);
+        break;
+      case OpType::X:
+        extend_track(diag, tracks[qbs[0]], ZXType::XSpider, 1);
+        break;
+      case OpType::SX:
+        extend_track(diag, tracks[qbs[0]], ZXType::XSpider, 0.5);
+        break;
+      case OpType::SXdg:
+        extend_track(diag, tracks[qbs[0]], ZXType::XSpider, -0.5);
+        break;
+      case OpType::V:
+        // V = Rx(1/2)
+        extend_track(diag, tracks[qbs[0]], ZXType::XSpider, 0.5);
+        phase -= 0.25;
+        break;
+      case OpType::Vdg:
+        extend_track(diag, tracks[qbs[0]], ZXType::XSpider, -0.5);
+        phase += 0.25;
+        break;
+      case OpType::Rx:
+        extend_track(diag, tracks[qbs[0]], ZXType::XSpider, params[0]);
+        phase -= params[0] / 2;
+        break;
+      case OpType::Y:
+        // Y = iXZ
+        extend_track(diag, tracks[qbs[0]], ZXType::ZSpider, 1);
+        extend_track(diag, tracks[qbs[0]], ZXType::XSpider, 1);
+        phase += 0.5;
+        break;
+      case OpType::Ry:
+        // Ry(a) = S Rx(a) Sdg
+        extend_track(diag, tracks[qbs[0]], ZXType::ZSpider, -0.5);
+        extend_track(diag, tracks[qbs[0]], ZXType::XSpider, params[0]);
+        extend_track(diag, tracks[qbs[0]], ZXType::ZSpider, 0.5);
+        phase -= params[0] / 2;
+        break;
+      case OpType::tk1:
+        extend_track(diag, tracks[qbs[0]], ZXType::ZSpider, params[2]);
+        extend_track(diag, tracks[qbs[0]], ZXType::XSpider, params[1]);
+        extend_track(diag, tracks[qbs[0]], ZXType::ZSpider, params[0]);
+        phase -= (params[0] + params[1] + params[2]) / 2;
+        break;
+      case OpType::H:
+        tracks[qbs[0]].h_pending = !tracks[qbs[0]].h_pending;
+        break;
+      case OpType::CX: {
+        ZXVert c = extend_track(diag, tracks[qbs[0]], ZXType::ZSpider, 0);
+        ZXVert t = extend_track(diag, tracks[qbs[1]], ZXType::XSpider, 0);
+        diag.add_wire(c, t);
+        break;
+      }
+      case OpType::CZ: {
+        ZXVert c = extend_track(diag, tracks[qbs[0]], ZXType::ZSpider, 0);
+        ZXVert t = extend_track(diag, tracks[qbs[1]], ZXType::ZSpider, 0);
+        diag.add_wire(c, t, ZXWireType::H);
+        break;
+      }
+      case OpType::SWAP:
+        std::swap(tracks[qbs[0]], tracks[qbs[1]]);
+        break;
+      default:
+        throw Unsupported(
+            "Cannot convert gate of type " + op->get_name() +
+            " to a ZXDiagram");
+    }
+  }
+
+  // The wire starting at a qubit's input ends at the output of its image
+  // under the implicit permutation
+  const qubit_map_t perm = circ.implicit_qubit_permutation();
+  for (unsigned i = 0; i < n; ++i) {
+    const QubitTrack &track = tracks[i];
+    diag.add_wire(
+        track.last, outs[index.at(perm.at(qubits[i]))],
+        track.h_pending ? ZXWireType::H : ZXWireType::Basic);
+  }
+  diag.multiply_scalar_phase(phase);
+  return diag;
+}
+
+Circuit zx_to_circuit(const ZXDiagram &diag) {
+  if (!diag.get_boundary(std::nullopt, QuantumType::Classical).empty()) {
+    throw ZXError(
+        "Cannot extract a circuit from a diagram with classical boundaries");
+  }
+  ZXDiagram gl(diag);
+  Rewrite::decompose_boxes().apply(gl);
+  Rewrite::to_graphlike_form().apply(gl);
+  const ZXVertVec ins = gl.get_boundary(ZXType::Input);
+  const ZXVertVec outs = gl.get_boundary(ZXType::Output);
+  const unsigned n = outs.size();
+  if (ins.size() != n) {
+    throw ZXError(
+        "Cannot extract a circuit from a diagram with different numbers of "
+        "inputs and outputs");
+  }
+  CompactZXGraph g(gl);
+  std::unordered_map<ZXVert, unsigned> index;
+  for (unsigned v = 0; v < g.n_vertices(); ++v) {
+    index.insert({g.get_vertex(v), v});
+  }
+
+  // Input spiders, with the input they lie on and whether the input wire is
+  // a Hadamard wire
+  std::unordered_map<unsigned, std::pair<unsigned, bool>> input_of;
+  for (unsigned j = 0; j < n; ++j) {
+    Wire w = gl.adj_wires(ins[j]).at(0);
+    unsigned s = index.at(gl.other_end(w, ins[j]));
+    input_of.insert({s, {j, gl.get_wire_type(w) == ZXWireType::H}});
+    g.remove_vertex(index.at(ins[j]));
+  }
+
+  // Gates are extracted from the outputs backwards
+  std::vector<ExtractedGate> gates;
+  std::vector<unsigned> frontier(n);
+  for (unsigned q = 0; q < n; ++q) {
+    Wire w = gl.adj_wires(outs[q]).at(0);
+    frontier[q] = index.at(gl.other_end(w, outs[q]));
+    if (gl.get_wire_type(w) == ZXWireType::H) {
+      gates.push_back({OpType::H, {q}});
+    }
+    g.remove_vertex(index.at(outs[q]));
+  }
+  std::vector<bool> done(n, false);
+  // Input on which the wire of each output ends
+  std::vector<unsigned> perm(n);
+  unsigned n_done = 0;
+  while (n_done < n) {
+    // Phases and CZs between frontier spiders
+    for (unsigned q = 0; q < n; ++q) {
+      if (done[q]) continue;
+      const ZXPhase &phase = g.get_phase(frontier[q]);
+      if (!phase.is_zero()) {
+        gates.push_back({OpType::Rz, {q}, phase.to_expr()});
+        g.set_phase(frontier[q], ZXPhase());
+      }
+    }
+    for (unsigned q = 0; q < n; ++q) {
+      if (done[q]) continue;
+      for (unsigned r = q + 1; r < n; ++r) {
+        if (!done[r] && g.edge_exists(frontier[q], frontier[r])) {
+          gates.push_back({OpType::CZ, {q, r}});
+          g.toggle_edge(frontier[q], frontier[r]);
+        }
+      }
+    }
+    // Move the frontier past spiders with a single neighbour
+    bool progress = false;
+    for (unsigned q = 0; q < n; ++q) {
+      if (done[q]) continue;
+      unsigned v = frontier[q];
+      std::unordered_map<unsigned, std::pair<unsigned, bool>>::const_iterator
+          in = input_of.find(v);
+      if (in != input_of.end()) {
+        if (!g.neighbours(v).empty()) continue;
+        if (in->second.second) gates.push_back({OpType::H, {q}});
+        perm[q] = in->second.first;
+        done[q] = true;
+        ++n_done;
+        g.remove_vertex(v);
+        progress = true;
+      } else if (g.neighbours(v).size() == 1) {
+        unsigned w = g.neighbours(v).front();
+        gates.push_back({OpType::H, {q}});
+        g.remove_vertex(v);
+        frontier[q] = w;
+        progress = true;
+      }
+    }
+    if (n_done == n) break;
+    if (progress) continue;
+
+    // Otherwise, reduce the biadjacency matrix between the frontier and its
+    // neighbours with CXs until some frontier spider has a single neighbour
+    std::vector<unsigned> rows;
+    for (unsigned q = 0; q < n; ++q) {
+      if (done[q]) continue;
+      rows.push_back(q);
+      unsigned v = frontier[q];
+      std::unordered_map<unsigned, std::pair<unsigned, bool>>::iterator in =
+          input_of.find(v);
+      if (in == input_of.end()) continue;
+      // Split an input spider with neighbours off its input wire
+      unsigned v2 = g.add_spider(ZXPhase());
+      g.toggle_edge(v, v2);
+      std::pair<unsigned, bool> wire = in->second;
+      input_of.erase(in);
+      input_of.insert({v2, {wire.first, !wire.second}});
+    }
+    std::vector<unsigned> cols;
+    for (unsigned q : rows) {
+      const std::vector<unsigned> &ns = g.neighbours(frontier[q]);
+      cols.insert(cols.end(), ns.begin(), ns.end());
+    }
+    std::sort(cols.begin(), cols.end());
+    cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+    MatrixXb m = MatrixXb::Zero(rows.size(), cols.size());
+    for (unsigned r = 0; r < rows.size(); ++r) {
+      for (unsigned u : g.neighbours(frontier[rows[r]])) {
+        m(r, std::lower_bound(cols.begin(), cols.end(), u) - cols.begin()) =
+            true;
+      }
+    }
+    // Adding row s to row t is a CX with control t and target s
+    for (const std::pair<unsigned, unsigned> &op :
+         gaussian_elimination_row_ops(m)) {
+      unsigned s = frontier[rows[op.first]];
+      unsigned t = frontier[rows[op.second]];
+      const std::vector<unsigned> ns = g.neighbours(s);
+      for (unsigned u : ns) g.toggle_edge(t, u);
+      gates.push_back({OpType::CX, {rows[op.second], rows[op.first]}});
+    }
+    bool reduced = false;
+    for (unsigned q : rows) {
+      if (g.neighbours(frontier[q]).size() == 1) {
+        reduced = true;
+        break;
+      }
+    }
+    if (!reduced) {
+      throw ZXError("Cannot extract a circuit from a diagram without a gflow");
+    }
+  }
+
+  // The input on each wire is permuted by SWAPs before the extracted gates
+  Circuit circ(n);
+  // Each extracted spider phase a is e^{i pi a/2} Rz(a)
+  Expr scalar = gl.get_scalar();
+  for (const ExtractedGate &gate : gates) {
+    if (gate.type == OpType::Rz) {
+      scalar *= SymEngine::exp(gate.phase / 2 * SymEngine::I * SymEngine::pi);
+    }
+  }
+  std::optional<Complex> scalar_value = eval_expr_c(scalar);
+  if (scalar_value && std::abs(*scalar_value) > EPS) {
+    circ.add_phase(std::arg(*scalar_value) / PI);
+  }
+  std::vector<unsigned> current(n);
+  for (unsigned q = 0; q < n; ++q) current[q] = q;
+  for (unsigned q = 0; q < n; ++q) {
+    if (current[q] == perm[q]) continue;
+    unsigned w = std::find(current.begin(), current.end(), perm[q]) -
+                 current.begin();
+    circ.add_op<unsigned>(OpType::SWAP, {q, w});
+    std::swap(current[q], current[w]);
+  }
+  for (std::vector<ExtractedGate>::const_reverse_iterator it = gates.rbegin();
+       it != gates.rend(); ++it) {
+    if (it->type == OpType::Rz) {
+      circ.add_op<unsigned>(OpType::Rz, it->phase, it->qubits);
+    } else {
+      circ.add_op<unsigned>(it->type, it->qubits);
+    }
+  }
+  return circ;
+}
+
+}  // namespace tket
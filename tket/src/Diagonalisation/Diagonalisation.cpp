@@ -14,6 +14,10 @@
 
 #include "Diagonalisation.hpp"
 
+#include <boost/functional/hash.hpp>
+#include <shared_mutex>
+#include <unordered_map>
+
 #include "Ops/Op.hpp"
 #include "PauliGraph/ConjugatePauliFunctions.hpp"
 #include "Utils/Assert.hpp"
@@ -243,7 +247,7 @@ void greedy_diagonalise(
 }
 
 /* Diagonalise a set of Pauli Gadgets simultaneously using Cliffords*/
-Circuit mutual_diagonalise(
+static Circuit mutual_diagonalise_uncached(
     std::list<std::pair<QubitPauliTensor, Expr>> &gadgets,
     std::set<Qubit> qubits, CXConfigType cx_config) {
   Circuit cliff_circ;
@@ -331,13 +335,158 @@ Circuit mutual_diagonalise(
   return cliff_circ;
 }
 
+namespace {
+
+/**
+ * Identifies a call to mutual_diagonalise up to an order-preserving
+ * relabelling of the qubits: the CX configuration, which of the qubits are
+ * to be diagonalised, and the entries of each gadget's string, with each
+ * qubit replaced by its rank among all the qubits involved.
+ */
+struct DiagonaliseKey {
+  std::vector<unsigned> codes;
+
+  bool operator==(const DiagonaliseKey &other) const {
+    return codes == other.codes;
+  }
+};
+
+struct DiagonaliseKeyHash {
+  std::size_t operator()(const DiagonaliseKey &key) const {
+    return boost::hash_range(key.codes.begin(), key.codes.end());
+  }
+};
+
+/** Result of mutual_diagonalise on the qubits q[0], q[1], ... by rank */
+struct DiagonaliseResult {
+  Circuit circuit;
+  // Diagonalised string of each gadget, and the factor applied to its
+  // coefficient
+  std::vector<std::pair<QubitPauliMap, Complex>> strings;
+};
+
+/** Maximum number of cached diagonalisations */
+constexpr unsigned max_cached_diagonalisations = 1024;
+
+typedef std::unordered_map<
+    DiagonaliseKey, DiagonaliseResult, DiagonaliseKeyHash>
+    diagonalise_cache_t;
+
+// The cache is never destroyed, so that it can be used during static
+// deinitialization.
+diagonalise_cache_t &diagonalise_cache() {
+  static diagonalise_cache_t *cache = new diagonalise_cache_t();
+  return *cache;
+}
+
+std::shared_mutex &diagonalise_cache_mutex() {
+  static std::shared_mutex *mutex = new std::shared_mutex();
+  return *mutex;
+}
+
+}  // namespace
+
+Circuit mutual_diagonalise(
+    std::list<std::pair<QubitPauliTensor, Expr>> &gadgets,
+    std::set<Qubit> qubits, CXConfigType cx_config) {
+  // Partitioned Hamiltonians repeat the same shapes of commuting set on
+  // different qubits, so diagonalisations are memoised by rank of qubit.
+  std::set<Qubit> all_qubits = qubits;
+  for (const std::pair<QubitPauliTensor, Expr> &gadget : gadgets) {
+    for (const std::pair<const Qubit, Pauli> &qp : gadget.first.string.map) {
+      all_qubits.insert(qp.first);
+    }
+  }
+  qubit_vector_t labels(all_qubits.begin(), all_qubits.end());
+  std::map<Qubit, unsigned> rank;
+  for (unsigned r = 0; r < labels.size(); ++r) rank.insert({labels[r], r});
+
+  DiagonaliseKey key;
+  key.codes.push_back(static_cast<unsigned>(cx_config));
+  key.codes.push_back(labels.size());
+  for (const Qubit &qb : labels) key.codes.push_back(qubits.count(qb));
+  key.codes.push_back(gadgets.size());
+  for (const std::pair<QubitPauliTensor, Expr> &gadget : gadgets) {
+    key.codes.push_back(gadget.first.string.map.size());
+    for (const std::pair<const Qubit, Pauli> &qp : gadget.first.string.map) {
+      key.codes.push_back(4 * rank.at(qp.first) + qp.second);
+    }
+  }
+
+  std::optional<DiagonaliseResult> result;
+  {
+    std::shared_lock<std::shared_mutex> lock(diagonalise_cache_mutex());
+    diagonalise_cache_t::const_iterator found = diagonalise_cache().find(key);
+    if (found != diagonalise_cache().end()) result = found->second;
+  }
+  if (!result) {
+    std::list<std::pair<QubitPauliTensor, Expr>> ranked_gadgets;
+    for (const std::pair<QubitPauliTensor, Expr> &gadget : gadgets) {
+      QubitPauliMap ranked;
+      for (const std::pair<const Qubit, Pauli> &qp :
+           gadget.first.string.map) {
+        ranked.insert({Qubit(rank.at(qp.first)), qp.second});
+      }
+      ranked_gadgets.push_back({QubitPauliTensor(ranked), gadget.second});
+    }
+    std::set<Qubit> ranked_qubits;
+    for (const Qubit &qb : qubits) ranked_qubits.insert(Qubit(rank.at(qb)));
+    result = DiagonaliseResult{
+        mutual_diagonalise_uncached(ranked_gadgets, ranked_qubits, cx_config),
+        {}};
+    for (const std::pair<QubitPauliTensor, Expr> &gadget : ranked_gadgets) {
+      result->strings.push_back({gadget.first.string.map, gadget.first.coeff});
+    }
+    std::unique_lock<std::shared_mutex> lock(diagonalise_cache_mutex());
+    if (diagonalise_cache().size() >= max_cached_diagonalisations) {
+      diagonalise_cache().clear();
+    }
+    diagonalise_cache().insert({std::move(key), *result});
+  }
+
+  Circuit cliff_circ;
+  for (const Qubit &qb : qubits) {
+    cliff_circ.add_qubit(qb);
+  }
+  for (const Command &com : result->circuit) {
+    qubit_vector_t args;
+    for (const UnitID &arg : com.get_args()) {
+      args.push_back(labels[arg.index().at(0)]);
+    }
+    cliff_circ.add_op<Qubit>(com.get_op_ptr(), args);
+  }
+  cliff_circ.add_phase(result->circuit.get_phase());
+  std::vector<std::pair<QubitPauliMap, Complex>>::const_iterator string =
+      result->strings.begin();
+  for (std::pair<QubitPauliTensor, Expr> &gadget : gadgets) {
+    QubitPauliMap relabelled;
+    for (const std::pair<const Qubit, Pauli> &qp : string->first) {
+      relabelled.insert({labels[qp.first.index().at(0)], qp.second});
+    }
+    gadget.first =
+        QubitPauliTensor(relabelled, gadget.first.coeff * string->second);
+    ++string;
+  }
+  return cliff_circ;
+}
+
+unsigned mutual_diagonalise_cache_size() {
+  std::shared_lock<std::shared_mutex> lock(diagonalise_cache_mutex());
+  return diagonalise_cache().size();
+}
+
+void clear_mutual_diagonalise_cache() {
+  std::unique_lock<std::shared_mutex> lock(diagonalise_cache_mutex());
+  diagonalise_cache().clear();
+}
+
 void apply_conjugations(
     QubitPauliTensor &qps, const Conjugations &conjugations) {
   for (const auto &optype_qubit_pair : conjugations) {
     OpType ot = optype_qubit_pair.first;
     const qubit_vector_t &qbs = optype_qubit_pair.second;
-    if (!optypeinfo().at(ot).signature ||
-        optypeinfo().at(ot).signature->size() != qbs.size())
+    if (!optypeinfo(ot).signature ||
+        optypeinfo(ot).signature->size() != qbs.size())
       throw std::logic_error("Incompatible qubit count for conjugations");
     switch (ot) {
       case OpType::H:
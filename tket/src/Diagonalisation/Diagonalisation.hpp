@@ -50,10 +50,20 @@ void greedy_diagonalise(
  * Diagonalise a mutually commuting set of Pauli strings. Modifies the
  * list of Pauli strings in place, and returns the Clifford circuit
  * required to generate the initial set.
+ *
+ * Results are memoised up to relabelling of the qubits by any map that
+ * preserves their order, which does not change the choices made, so sets
+ * of the same shape on different qubits are only diagonalised once.
  */
 Circuit mutual_diagonalise(
     std::list<std::pair<QubitPauliTensor, Expr>> &gadgets,
     std::set<Qubit> qubits, CXConfigType cx_config);
+
+/** Number of diagonalisations memoised by \ref mutual_diagonalise */
+unsigned mutual_diagonalise_cache_size();
+
+/** Forget all diagonalisations memoised by \ref mutual_diagonalise */
+void clear_mutual_diagonalise_cache();
 /**
  * Applies Clifford conjugations to a QubitPauliTensor
  */
@@ -14,40 +14,75 @@
 
 #include "PauliPartition.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <numeric>
 
 #include "Graphs/AdjacencyData.hpp"
 #include "Graphs/GraphColouring.hpp"
 #include "Utils/Assert.hpp"
+#include "Utils/DensePauliString.hpp"
 #include "Utils/GraphHeaders.hpp"
+#include "Utils/Parallel.hpp"
 
 namespace tket {
 
+// Whether two packed strings must go in different sets.
+static bool strings_clash(
+    const DensePauliString& a, const DensePauliString& b,
+    PauliPartitionStrat strat) {
+  switch (strat) {
+    case (PauliPartitionStrat::NonConflictingSets):
+      return a.n_conflicts(b) != 0;
+    case (PauliPartitionStrat::CommutingSets):
+      return !a.commutes_with(b);
+    default:
+      throw UnknownPauliPartitionStrat();
+  }
+}
+
 PauliPartitionerGraph::PauliPartitionerGraph(
     const std::list<QubitPauliString>& strings, PauliPartitionStrat strat) {
   pac_graph = {};
   for (const QubitPauliString& tensor : strings) {
-    PauliACVertex new_vert = boost::add_vertex(tensor, pac_graph);
-    BGL_FORALL_VERTICES(v, pac_graph, PauliACGraph) {
-      if (v != new_vert) {
-        switch (strat) {
-          case (PauliPartitionStrat::NonConflictingSets): {
-            bool conflict = !tensor.conflicting_qubits(pac_graph[v]).empty();
-            if (conflict) boost::add_edge(new_vert, v, pac_graph);
-            break;
-          }
-          case (PauliPartitionStrat::CommutingSets): {
-            if (!tensor.commutes_with(pac_graph[v])) {
-              boost::add_edge(new_vert, v, pac_graph);
-            }
-            break;
-          }
-          default: {
-            throw UnknownPauliPartitionStrat();
-          }
-        }
+    boost::add_vertex(tensor, pac_graph);
+  }
+  if (strings.size() < 2) return;
+  // Validate the strategy before any threads start.
+  if (strat != PauliPartitionStrat::NonConflictingSets &&
+      strat != PauliPartitionStrat::CommutingSets) {
+    throw UnknownPauliPartitionStrat();
+  }
+
+  qubit_vector_t qubits;
+  const std::vector<DensePauliString> packed =
+      pack_pauli_strings(strings, qubits);
+  const std::size_t n = packed.size();
+
+  // For each vertex, its neighbours with smaller index, in increasing order.
+  // Row i costs i comparisons, so each task takes row k together with row
+  // n-1-k to balance the work between threads.
+  std::vector<std::vector<unsigned>> lower_neighbours(n);
+  auto fill_row = [&](std::size_t i) {
+    for (std::size_t j = 0; j < i; j++) {
+      if (strings_clash(packed[i], packed[j], strat)) {
+        lower_neighbours[i].push_back(j);
       }
     }
+  };
+  parallel_for(0, (n + 1) / 2, 64, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t k = begin; k < end; k++) {
+      fill_row(k);
+      if (n - 1 - k != k) fill_row(n - 1 - k);
+    }
+  });
+
+  // Add edges in the order of the sequential construction, so that the
+  // adjacency lists (and hence the colourings) are unchanged.
+  for (std::size_t i = 0; i < n; i++) {
+    for (unsigned j : lower_neighbours[i]) {
+      boost::add_edge(i, j, pac_graph);
+    }
   }
 }
 
@@ -202,54 +237,108 @@ PauliPartitionerGraph::partition_paulis(GraphColourMethod method) const {
   }
 }
 
-static std::list<std::list<QubitPauliString>>
-get_term_sequence_for_lazy_colouring_method(
-    const std::list<QubitPauliString>& strings, PauliPartitionStrat strat) {
-  std::list<std::list<QubitPauliString>> terms;
-  for (const QubitPauliString& qpt : strings) {
-    if (terms.empty()) {
-      terms.push_back({qpt});
-      continue;
+StreamingPauliPartitioner::StreamingPauliPartitioner(
+    PauliPartitionStrat strat)
+    : strat_(strat), capacity_(0) {
+  if (strat != PauliPartitionStrat::NonConflictingSets &&
+      strat != PauliPartitionStrat::CommutingSets) {
+    throw UnknownPauliPartitionStrat();
+  }
+}
+
+DensePauliString StreamingPauliPartitioner::pack(const QubitPauliString& qps) {
+  for (const std::pair<const Qubit, Pauli>& term : qps.map) {
+    if (term.second != Pauli::I) {
+      index_.insert({term.first, index_.size()});
+    }
+  }
+  if (index_.size() > capacity_) {
+    // Grow geometrically, so summaries are resized O(log n) times.
+    const unsigned needed = 64 * ((index_.size() + 63) / 64);
+    capacity_ = std::max(2 * capacity_, needed);
+    for (Group& group : groups_) {
+      group.letters.resize(capacity_);
+      for (DensePauliString& b : group.basis) b.resize(capacity_);
     }
+  }
+  DensePauliString s(capacity_);
+  for (const std::pair<const Qubit, Pauli>& term : qps.map) {
+    if (term.second != Pauli::I) s.set(index_.at(term.first), term.second);
+  }
+  return s;
+}
 
-    bool found_bin = false;
-    for (std::list<std::list<QubitPauliString>>::iterator term_iter =
-             terms.begin();
-         term_iter != terms.end(); ++term_iter) {
-      const std::list<QubitPauliString>& qpt_list = *term_iter;
-      bool viable_bin = true;
-      for (const QubitPauliString& qpt2 : qpt_list) {
-        switch (strat) {
-          case (PauliPartitionStrat::NonConflictingSets): {
-            bool conflict = !qpt.conflicting_qubits(qpt2).empty();
-            if (conflict) viable_bin = false;
-            break;
-          }
-          case (PauliPartitionStrat::CommutingSets): {
-            if (!qpt.commutes_with(qpt2)) viable_bin = false;
-            break;
-          }
-          default: {
-            throw UnknownPauliPartitionStrat();
-          }
-        }
-
-        if (viable_bin == false) break;
-      }
-      if (viable_bin) {
-        term_iter->push_back(qpt);
-        found_bin = true;
-        break;
+static bool get_bit(const std::vector<std::uint64_t>& words, unsigned i) {
+  return (words[i / 64] >> (i % 64)) & 1;
+}
+
+bool StreamingPauliPartitioner::compatible(
+    const Group& group, const DensePauliString& s) const {
+  if (strat_ == PauliPartitionStrat::NonConflictingSets) {
+    return group.letters.n_conflicts(s) == 0;
+  }
+  for (const DensePauliString& b : group.basis) {
+    if (!b.commutes_with(s)) return false;
+  }
+  return true;
+}
+
+void StreamingPauliPartitioner::insert(
+    Group& group, DensePauliString s) const {
+  if (strat_ == PauliPartitionStrat::NonConflictingSets) {
+    // Compatible letters agree wherever both are not I.
+    const std::vector<unsigned> own = s.own_qubits(group.letters);
+    for (unsigned q : own) group.letters.set(q, s.get(q));
+    return;
+  }
+  // Reduce by the basis in insertion order; a later basis vector has zeros
+  // at the pivots of all earlier ones, so pivots are never reintroduced.
+  for (unsigned k = 0; k < group.basis.size(); k++) {
+    const auto& [is_z, q] = group.pivots[k];
+    if (get_bit(is_z ? s.z_words() : s.x_words(), q)) s ^= group.basis[k];
+  }
+  for (bool is_z : {false, true}) {
+    const std::vector<std::uint64_t>& words = is_z ? s.z_words() : s.x_words();
+    for (unsigned w = 0; w < words.size(); w++) {
+      if (words[w] != 0) {
+        group.pivots.push_back({is_z, 64 * w + std::countr_zero(words[w])});
+        group.basis.push_back(std::move(s));
+        return;
       }
     }
+  }
+}
 
-    if (found_bin == false) {
-      terms.push_back({qpt});
-    }
+unsigned StreamingPauliPartitioner::add(const QubitPauliString& qps) {
+  const DensePauliString s = pack(qps);
+  unsigned g = 0;
+  for (; g < groups_.size(); g++) {
+    if (compatible(groups_[g], s)) break;
+  }
+  if (g == groups_.size()) {
+    Group& group = groups_.emplace_back();
+    group.letters = DensePauliString(capacity_);
   }
+  groups_[g].members.push_back(qps);
+  insert(groups_[g], s);
+  return g;
+}
+
+std::list<std::list<QubitPauliString>> StreamingPauliPartitioner::get_groups()
+    const {
+  std::list<std::list<QubitPauliString>> terms;
+  for (const Group& group : groups_) terms.push_back(group.members);
   return terms;
 }
 
+static std::list<std::list<QubitPauliString>>
+get_term_sequence_for_lazy_colouring_method(
+    const std::list<QubitPauliString>& strings, PauliPartitionStrat strat) {
+  StreamingPauliPartitioner partitioner(strat);
+  for (const QubitPauliString& qpt : strings) partitioner.add(qpt);
+  return partitioner.get_groups();
+}
+
 static std::list<std::list<QubitPauliString>>
 get_term_sequence_with_constructed_dependency_graph(
     const std::list<QubitPauliString>& strings, PauliPartitionStrat strat,
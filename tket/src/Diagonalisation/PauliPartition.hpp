@@ -15,6 +15,7 @@
 #pragma once
 
 #include "DiagUtils.hpp"
+#include "Utils/DensePauliString.hpp"
 
 namespace tket {
 
@@ -93,6 +94,59 @@ class PauliPartitionerGraph {
   PauliACGraph pac_graph;
 };
 
+/**
+ * Partitions Pauli strings as they arrive, without building a conflict
+ * graph.
+ *
+ * Each string goes into the first existing group it is compatible with, as
+ * for GraphColourMethod::Lazy. Rather than comparing the string with every
+ * member of a group, each group keeps a summary that answers the question
+ * exactly in time linear in the number of qubits:
+ * - for NonConflictingSets, the Pauli letter the group uses on each qubit
+ *   (members agree wherever they are not I);
+ * - for CommutingSets, a basis of the symplectic vectors of its members
+ *   (a string commutes with every member iff it commutes with every basis
+ *   vector), which has at most as many vectors as there are qubits.
+ * Memory use is linear in the number of strings.
+ */
+class StreamingPauliPartitioner {
+ public:
+  explicit StreamingPauliPartitioner(PauliPartitionStrat strat);
+
+  /**
+   * Add a string to the first compatible group, starting a new group if
+   * there is none.
+   *
+   * @return index of the group the string was added to
+   */
+  unsigned add(const QubitPauliString& qps);
+
+  unsigned n_groups() const { return groups_.size(); }
+
+  /** The groups, in order of creation, each in order of insertion */
+  std::list<std::list<QubitPauliString>> get_groups() const;
+
+ private:
+  struct Group {
+    std::list<QubitPauliString> members;
+    // NonConflictingSets: the letter used on each qubit
+    DensePauliString letters;
+    // CommutingSets: basis in echelon form, with the pivot of each vector
+    // given as (is z component, qubit index)
+    std::vector<DensePauliString> basis;
+    std::vector<std::pair<bool, unsigned>> pivots;
+  };
+
+  PauliPartitionStrat strat_;
+  std::map<Qubit, unsigned> index_;
+  unsigned capacity_;
+  std::vector<Group> groups_;
+
+  DensePauliString pack(const QubitPauliString& qps);
+  bool compatible(const Group& group, const DensePauliString& s) const;
+  void insert(Group& group, DensePauliString s) const;
+};
+
 /**
  * Partitions a QubitOperator into lists of mutually commuting gadgets.
  * Assumes that each `QubitPauliString` is unique and does not attempt
@@ -0,0 +1,173 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Table of the Paulis commuting with each gate type at its ports
+ *
+ * These answer \ref Op::commuting_basis and \ref Op::commutes_with_basis by
+ * a table lookup on the operation type, without virtual calls, for passes
+ * asking about many vertices and ports.
+ */
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <optional>
+
+#include "OpType/OpType.hpp"
+#include "OpType/OpTypeFunctions.hpp"
+#include "Ops/Op.hpp"
+#include "Utils/PauliStrings.hpp"
+
+namespace tket {
+
+/**
+ * The Paulis commuting with a gate type at its ports, as for
+ * \ref Op::commuting_basis
+ *
+ * Gates commute with the same Pauli at all their ports other than the first
+ * and the last; a single-qubit gate's only port is its last.
+ */
+struct PortCommutation {
+  /** Pauli commuting at the first port, when it is not the last */
+  std::optional<Pauli> first;
+  /** Pauli commuting at the ports other than the first and the last */
+  std::optional<Pauli> middle;
+  /** Pauli commuting at the last port */
+  std::optional<Pauli> last;
+  /** Number of qubits of the type, or 0 if it varies or is not listed */
+  unsigned n_qubits = 0;
+};
+
+namespace detail {
+
+constexpr std::array<PortCommutation, n_optypes> make_commutation_table() {
+  std::array<PortCommutation, n_optypes> table{};
+  auto set = [&table](
+                 std::initializer_list<OpType> optypes, unsigned n_qubits,
+                 std::optional<Pauli> first, std::optional<Pauli> middle,
+                 std::optional<Pauli> last) {
+    for (OpType optype : optypes) {
+      table[static_cast<std::size_t>(optype)] = {
+          first, middle, last, n_qubits};
+    }
+  };
+  const std::optional<Pauli> none = std::nullopt;
+  // The same Pauli at every port
+  set({OpType::XXPhase}, 2, Pauli::X, Pauli::X, Pauli::X);
+  set({OpType::XXPhase3}, 3, Pauli::X, Pauli::X, Pauli::X);
+  set({OpType::YYPhase}, 2, Pauli::Y, Pauli::Y, Pauli::Y);
+  set({OpType::Z, OpType::S, OpType::Sdg, OpType::T, OpType::Tdg, OpType::Rz,
+       OpType::U1},
+      1, Pauli::Z, Pauli::Z, Pauli::Z);
+  set({OpType::CZ, OpType::CRz, OpType::CU1, OpType::ZZMax, OpType::ZZPhase},
+      2, Pauli::Z, Pauli::Z, Pauli::Z);
+  set({OpType::PhaseGadget}, 0, Pauli::Z, Pauli::Z, Pauli::Z);
+  set({OpType::noop}, 1, Pauli::I, Pauli::I, Pauli::I);
+  set({OpType::H, OpType::U3, OpType::U2, OpType::PhasedX, OpType::tk1}, 1,
+      none, none, none);
+  set({OpType::NPhasedX}, 0, none, none, none);
+  // Controls commute with Z; the target only with the Pauli of its operation
+  set({OpType::CH, OpType::CU3}, 2, Pauli::Z, none, none);
+  set({OpType::CSWAP}, 3, Pauli::Z, none, none);
+  set({OpType::BRIDGE}, 3, Pauli::Z, Pauli::I, Pauli::X);
+  set({OpType::X, OpType::V, OpType::Vdg, OpType::SX, OpType::SXdg,
+       OpType::Rx},
+      1, Pauli::Z, Pauli::Z, Pauli::X);
+  set({OpType::CV, OpType::CVdg, OpType::CSX, OpType::CSXdg, OpType::CRx,
+       OpType::CX},
+      2, Pauli::Z, Pauli::Z, Pauli::X);
+  set({OpType::CCX}, 3, Pauli::Z, Pauli::Z, Pauli::X);
+  set({OpType::CnX}, 0, Pauli::Z, Pauli::Z, Pauli::X);
+  set({OpType::ECR}, 2, none, none, Pauli::X);
+  set({OpType::Y, OpType::Ry}, 1, Pauli::Z, Pauli::Z, Pauli::Y);
+  set({OpType::CY, OpType::CRy}, 2, Pauli::Z, Pauli::Z, Pauli::Y);
+  set({OpType::CnRy}, 0, Pauli::Z, Pauli::Z, Pauli::Y);
+  return table;
+}
+
+}  // namespace detail
+
+/** Paulis commuting with each gate type at its ports, indexed by the type */
+inline constexpr std::array<PortCommutation, n_optypes> commutation_table =
+    detail::make_commutation_table();
+
+/**
+ * Which Pauli, if any, commutes with a gate type at a given port
+ *
+ * @param optype gate type
+ * @param port port number, less than \p n_qubits
+ * @param n_qubits number of qubits of the gate
+ * @retval std::nullopt no Pauli commutes
+ * @retval Pauli::I any Pauli commutes
+ */
+constexpr std::optional<Pauli> optype_commuting_basis(
+    OpType optype, port_t port, unsigned n_qubits) {
+  const PortCommutation &c =
+      commutation_table[static_cast<std::size_t>(optype)];
+  if (port + 1 == n_qubits) return c.last;
+  return (port == 0) ? c.first : c.middle;
+}
+
+/**
+ * Whether a Pauli commutes with an operation whose port commutes with
+ * \p basis
+ *
+ * @param colour Pauli, or std::nullopt for none
+ * @param basis Pauli commuting at the port, as from \ref
+ *  optype_commuting_basis
+ */
+constexpr bool commutes_in_basis(
+    const std::optional<Pauli> &colour, const std::optional<Pauli> &basis) {
+  if (colour == Pauli::I) return true;
+  if (!colour && !basis) return false;
+  return basis == Pauli::I || basis == colour;
+}
+
+/**
+ * Equivalent to `op.commuting_basis(port)`, by table lookup
+ *
+ * Only multi-controlled gates and gates not in the table ask the operation
+ * for its number of qubits.
+ *
+ * @throw NotValid if the operation is not a gate or \p port is not one of
+ *  its ports
+ */
+inline std::optional<Pauli> op_commuting_basis(const Op &op, port_t port) {
+  const OpType optype = op.get_type();
+  if (!has_optype_flags<OpTypeFlag::Gate>(optype)) throw NotValid();
+  unsigned n_qubits =
+      commutation_table[static_cast<std::size_t>(optype)].n_qubits;
+  if (n_qubits == 0) n_qubits = op.n_qubits();
+  if (port >= n_qubits) throw NotValid();
+  return optype_commuting_basis(optype, port, n_qubits);
+}
+
+/**
+ * Equivalent to `op.commutes_with_basis(colour, port)`, by table lookup
+ *
+ * @throw NotValid if the operation is not a gate, or \p colour is not
+ *  Pauli::I and \p port is not one of its ports
+ */
+inline bool op_commutes_with_basis(
+    const Op &op, const std::optional<Pauli> &colour, port_t port) {
+  if (!has_optype_flags<OpTypeFlag::Gate>(op.get_type())) throw NotValid();
+  if (colour == Pauli::I) return true;
+  return commutes_in_basis(colour, op_commuting_basis(op, port));
+}
+
+}  // namespace tket
@@ -16,6 +16,7 @@
 
 #include <vector>
 
+#include "Commutation.hpp"
 #include "GateUnitaryMatrix.hpp"
 #include "GateUnitaryMatrixError.hpp"
 #include "OpPtrFunctions.hpp"
@@ -25,6 +26,7 @@
 namespace tket {
 
 Op_ptr Gate::dagger() const {
+  const std::vector<Expr> params = get_params();
   OpType optype = get_type();
   switch (optype) {
     case OpType::H:
@@ -98,7 +100,7 @@ Op_ptr Gate::dagger() const {
     case OpType::XXPhase3:
     case OpType::ISWAP:
     case OpType::ESWAP: {
-      return get_op_ptr(optype, -params_[0], n_qubits_);
+      return get_op_ptr(optype, -params[0], n_qubits_);
     }
     case OpType::ZZMax: {
       // ZZMax.dagger = ZZPhase(-0.5)
@@ -106,7 +108,7 @@ Op_ptr Gate::dagger() const {
     }
     case OpType::FSim: {
       // FSim(a,b).dagger() == FSim(-a,-b)
-      return get_op_ptr(OpType::FSim, {-params_[0], -params_[1]});
+      return get_op_ptr(OpType::FSim, {-params[0], -params[1]});
     }
     case OpType::Sycamore: {
       return get_op_ptr(OpType::FSim, {-0.5, -1. / 6.});
@@ -116,24 +118,24 @@ Op_ptr Gate::dagger() const {
     }
     case OpType::U2: {
       // U2(a,b).dagger() == U3(-pi/2,-b,-a)
-      return get_op_ptr(OpType::U3, {-0.5, -params_[1], -params_[0]});
+      return get_op_ptr(OpType::U3, {-0.5, -params[1], -params[0]});
     }
     case OpType::U3:
     case OpType::CU3:
       // U3(a,b,c).dagger() == U3(-a,-c.-b)
-      { return get_op_ptr(optype, {-params_[0], -params_[2], -params_[1]}); }
+      { return get_op_ptr(optype, {-params[0], -params[2], -params[1]}); }
     case OpType::tk1:
       // tk1(a,b,c).dagger() == tk1(-c,-b,-a)
       {
-        return get_op_ptr(OpType::tk1, {-params_[2], -params_[1], -params_[0]});
+        return get_op_ptr(OpType::tk1, {-params[2], -params[1], -params[0]});
       }
     case OpType::PhasedX:
     case OpType::NPhasedX:
       // PhasedX(a,b).dagger() == PhasedX(-a,b)
-      { return get_op_ptr(optype, {-params_[0], params_[1]}, n_qubits_); }
+      { return get_op_ptr(optype, {-params[0], params[1]}, n_qubits_); }
     case OpType::PhasedISWAP:
       // PhasedISWAP(a,b).dagger() == PhasedISWAP(a,-b)
-      { return get_op_ptr(OpType::PhasedISWAP, {params_[0], -params_[1]}); }
+      { return get_op_ptr(OpType::PhasedISWAP, {params[0], -params[1]}); }
     default: {
       throw NotImplemented(
           "Cannot retrieve the dagger of OpType::" + get_desc().name());
@@ -142,6 +144,7 @@ Op_ptr Gate::dagger() const {
 }
 
 Op_ptr Gate::transpose() const {
+  const std::vector<Expr> params = get_params();
   OpType optype = get_type();
   switch (optype) {
     case OpType::H:
@@ -178,7 +181,7 @@ Op_ptr Gate::transpose() const {
     case OpType::XXPhase3:
     case OpType::ESWAP:
     case OpType::FSim: {
-      return get_op_ptr(optype, params_);
+      return get_op_ptr(optype, params);
     }
     case OpType::Y: {
       return get_op_ptr(OpType::U3, {3, 0.5, 0.5});
@@ -186,32 +189,32 @@ Op_ptr Gate::transpose() const {
     case OpType::Ry:
     case OpType::CRy:
     case OpType::CnRy: {
-      return get_op_ptr(optype, -params_[0], n_qubits_);
+      return get_op_ptr(optype, -params[0], n_qubits_);
     }
     case OpType::CnX: {
       return get_op_ptr(optype, std::vector<Expr>(), n_qubits_);
     }
     case OpType::U2: {
       // U2(a,b).transpose() == U2(b+1,a+1)
-      return get_op_ptr(OpType::U2, {params_[1] + 1., params_[0] + 1.});
+      return get_op_ptr(OpType::U2, {params[1] + 1., params[0] + 1.});
     }
     case OpType::U3:
     case OpType::CU3: {
       // U3(a,b,c).transpose() == U3(-a,c,b)
-      return get_op_ptr(OpType::U3, {-params_[0], params_[2], params_[1]});
+      return get_op_ptr(OpType::U3, {-params[0], params[2], params[1]});
     }
     case OpType::tk1: {
       // tk1(a,b,c).transpose() == tk1(c,b,a)
-      return get_op_ptr(OpType::tk1, {params_[2], params_[1], params_[0]});
+      return get_op_ptr(OpType::tk1, {params[2], params[1], params[0]});
     }
     case OpType::PhasedX:
     case OpType::NPhasedX: {
       // PhasedX(a,b).transpose() == PhasedX(a,-b)
-      return get_op_ptr(optype, {params_[0], -params_[1]}, n_qubits_);
+      return get_op_ptr(optype, {params[0], -params[1]}, n_qubits_);
     }
     case OpType::PhasedISWAP: {
       // PhasedISWAP(a,b).transpose() == PhasedISWAP(-a,b)
-      return get_op_ptr(OpType::PhasedISWAP, {-params_[0], params_[1]});
+      return get_op_ptr(OpType::PhasedISWAP, {-params[0], params[1]});
     }
 
     default: {
@@ -224,8 +227,8 @@ Op_ptr Gate::transpose() const {
 Op_ptr Gate::symbol_substitution(
     const SymEngine::map_basic_basic& sub_map) const {
   std::vector<Expr> new_params;
-  for (const Expr& p : this->params_) {
-    new_params.push_back(p.subs(sub_map));
+  for (const Param& p : this->params_) {
+    new_params.push_back(p.to_expr().subs(sub_map));
   }
   return get_op_ptr(this->type_, new_params, this->n_qubits_);
 }
@@ -315,7 +318,7 @@ std::string Gate::get_name(bool latex) const {
       if (reduced) {
         name << reduced.value();
       } else {
-        name << params_[i];
+        name << params_[i].to_expr();
       }
       if (i < params_.size() - 1) name << ", ";
     }
@@ -350,8 +353,8 @@ bool Gate::is_equal(const Op& op_other) const {
 
   OpDesc desc = get_desc();
   if (n_qubits() != other.n_qubits()) return false;
-  std::vector<Expr> params1 = this->get_params();
-  std::vector<Expr> params2 = other.get_params();
+  const std::vector<Param>& params1 = this->params_;
+  const std::vector<Param>& params2 = other.params_;
   unsigned param_count = params1.size();
   if (params2.size() != param_count) return false;
   for (unsigned i = 0; i < param_count; i++) {
@@ -365,18 +368,18 @@ std::vector<Expr> Gate::get_params_reduced() const {
   unsigned n_params = desc.n_params();
   std::vector<Expr> params(n_params);
   for (unsigned i = 0; i < n_params; i++) {
-    Expr param = params_[i];
-    std::optional<double> e = eval_expr_mod(param, desc.param_mod(i));
+    std::optional<double> e = eval_expr_mod(params_[i], desc.param_mod(i));
     if (e) {
       params[i] = e.value();
     } else {
-      params[i] = param;
+      params[i] = params_[i].to_expr();
     }
   }
   return params;
 }
 
 std::vector<Expr> Gate::get_tk1_angles() const {
+  const std::vector<Expr> params = get_params();
   switch (get_type()) {
     case OpType::noop: {
       return {0., 0., 0., 0.};
@@ -418,27 +421,27 @@ std::vector<Expr> Gate::get_tk1_angles() const {
       return {0.5, 0.5, 0.5, 0.5};
     }
     case OpType::Rx: {
-      return {0., params_.at(0), 0., 0.};
+      return {0., params.at(0), 0., 0.};
     }
     case OpType::Ry: {
-      return {0.5, params_.at(0), -0.5, 0.};
+      return {0.5, params.at(0), -0.5, 0.};
     }
     case OpType::Rz:
     case OpType::PhaseGadget: {
-      return {0., 0., params_.at(0), 0.};
+      return {0., 0., params.at(0), 0.};
     }
     case OpType::U1: {
-      return {0., 0., params_.at(0), params_.at(0) / 2};
+      return {0., 0., params.at(0), params.at(0) / 2};
     }
     case OpType::U2: {
       return {
-          params_.at(0) + 0.5, 0.5, params_.at(1) - 0.5,
-          (params_.at(0) + params_.at(1)) / 2};
+          params.at(0) + 0.5, 0.5, params.at(1) - 0.5,
+          (params.at(0) + params.at(1)) / 2};
     }
     case OpType::U3: {
       return {
-          params_.at(1) + 0.5, params_.at(0), params_.at(2) - 0.5,
-          (params_.at(1) + params_.at(2)) / 2};
+          params.at(1) + 0.5, params.at(0), params.at(2) - 0.5,
+          (params.at(1) + params.at(2)) / 2};
     }
     case OpType::NPhasedX: {
       if (n_qubits_ != 1) {
@@ -446,13 +449,13 @@ std::vector<Expr> Gate::get_tk1_angles() const {
             "OpType::NPhasedX can only be decomposed into a TK1 "
             "if it acts on a single qubit");
       }
-      return {params_.at(1), params_.at(0), -params_.at(1), 0.};
+      return {params.at(1), params.at(0), -params.at(1), 0.};
     }
     case OpType::PhasedX: {
-      return {params_.at(1), params_.at(0), -params_.at(1), 0.};
+      return {params.at(1), params.at(0), -params.at(1), 0.};
     }
     case OpType::tk1: {
-      return {params_.at(0), params_.at(1), params_.at(2), 0.};
+      return {params.at(0), params.at(1), params.at(2), 0.};
     }
     default: {
       throw NotImplemented(
@@ -461,116 +464,33 @@ std::vector<Expr> Gate::get_tk1_angles() const {
   }
 }
 
-std::vector<Expr> Gate::get_params() const { return params_; }
+std::vector<Expr> Gate::get_params() const {
+  std::vector<Expr> params;
+  params.reserve(params_.size());
+  for (const Param& p : params_) params.push_back(p.to_expr());
+  return params;
+}
 
-SymSet Gate::free_symbols() const { return expr_free_symbols(get_params()); }
+SymSet Gate::free_symbols() const {
+  SymSet symbols;
+  for (const Param& p : params_) {
+    if (p.is_double()) continue;
+    SymSet p_symbols = p.free_symbols();
+    symbols.insert(p_symbols.begin(), p_symbols.end());
+  }
+  return symbols;
+}
 
 std::optional<Pauli> Gate::commuting_basis(port_t port) const {
   unsigned n_q = n_qubits();
   if (port >= n_q) throw NotValid();
-  switch (get_type()) {
-    case OpType::XXPhase:
-    case OpType::XXPhase3: {
-      return Pauli::X;
-    }
-    case OpType::YYPhase: {
-      return Pauli::Y;
-    }
-    case OpType::Z:
-    case OpType::S:
-    case OpType::Sdg:
-    case OpType::T:
-    case OpType::Tdg:
-    case OpType::Rz:
-    case OpType::U1:
-    case OpType::CZ:
-    case OpType::CRz:
-    case OpType::CU1:
-    case OpType::PhaseGadget:
-    case OpType::ZZMax:
-    case OpType::ZZPhase: {
-      return Pauli::Z;
-    }
-    case OpType::noop: {
-      return Pauli::I;
-    }
-    case OpType::H:
-    case OpType::U3:
-    case OpType::U2:
-    case OpType::PhasedX:
-    case OpType::NPhasedX:
-    case OpType::tk1: {
-      return std::nullopt;
-    }
-    case OpType::CH:
-    case OpType::CU3:
-    case OpType::CSWAP: {
-      if (port == 0) {
-        return Pauli::Z;
-      } else {
-        return std::nullopt;
-      }
-    }
-    case OpType::BRIDGE: {
-      if (port == 0) {
-        return Pauli::Z;
-      } else if (port == 2) {
-        return Pauli::X;
-      } else {
-        return Pauli::I;
-      }
-    }
-    case OpType::X:
-    case OpType::V:
-    case OpType::Vdg:
-    case OpType::CV:
-    case OpType::CVdg:
-    case OpType::SX:
-    case OpType::SXdg:
-    case OpType::CSX:
-    case OpType::CSXdg:
-    case OpType::Rx:
-    case OpType::CRx:
-    case OpType::CX:
-    case OpType::CCX:
-    case OpType::CnX: {
-      if (port == n_q - 1) {
-        return Pauli::X;
-      } else {
-        return Pauli::Z;
-      }
-    }
-    case OpType::ECR: {
-      if (port == 1) {
-        return Pauli::X;
-      } else {
-        return std::nullopt;
-      }
-    }
-    case OpType::Y:
-    case OpType::Ry:
-    case OpType::CY:
-    case OpType::CRy:
-    case OpType::CnRy: {
-      if (port == n_q - 1) {
-        return Pauli::Y;
-      } else {
-        return Pauli::Z;
-      }
-    }
-    default: {
-      return std::nullopt;
-    }
-  }
+  return optype_commuting_basis(get_type(), port, n_q);
 }
 
 bool Gate::commutes_with_basis(
     const std::optional<Pauli>& colour, port_t port) const {
   if (colour == Pauli::I) return true;
-  const std::optional<Pauli> my_colour = commuting_basis(port);
-  if (!colour && !my_colour) return false;
-  if (my_colour == Pauli::I || my_colour == colour) return true;
-  return false;
+  return commutes_in_basis(colour, commuting_basis(port));
 }
 
 op_signature_t Gate::get_signature() const {
@@ -586,7 +506,7 @@ nlohmann::json Gate::serialize() const {
   OpType optype = get_type();
   j["type"] = optype;
   // if type has a fixed signature, don't store number of qubits
-  if (!optypeinfo().at(optype).signature) {
+  if (!optypeinfo(optype).signature) {
     j["n_qb"] = n_qubits();
   }
   std::vector<Expr> params = get_params();
@@ -604,7 +524,7 @@ Op_ptr Gate::deserialize(const nlohmann::json& j) {
   }
   // if type has fixed number of qubits use it, otherwise it should have been
   // stored
-  const auto& sig = optypeinfo().at(optype).signature;
+  const auto& sig = optypeinfo(optype).signature;
   unsigned n_qb;
   if (sig) {
     auto check_quantum = [](unsigned sum, const EdgeType& e) {
@@ -633,12 +553,19 @@ Eigen::MatrixXcd Gate::get_unitary() const {
   }
 }
 
+static std::vector<Param> to_params(const std::vector<Expr>& params) {
+  std::vector<Param> result;
+  result.reserve(params.size());
+  for (const Expr& e : params) result.emplace_back(e);
+  return result;
+}
+
 Gate::Gate(OpType type, const std::vector<Expr>& params, unsigned n_qubits)
-    : Op(type), params_(params), n_qubits_(n_qubits) {
+    : Op(type), params_(to_params(params)), n_qubits_(n_qubits) {
   if (!is_gate_type(type)) {
     throw NotValid();
   }
-  if (params.size() != optypeinfo().at(type).n_params()) {
+  if (params.size() != optypeinfo(type).n_params()) {
     throw InvalidParameterCount();
   }
 }
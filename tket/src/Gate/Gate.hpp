@@ -44,6 +44,13 @@ class Gate : public Op {
    */
   std::vector<Expr> get_tk1_angles() const;
   std::vector<Expr> get_params() const override;
+
+  /**
+   * Parameters in their stored form, without building expressions for
+   * numerical values
+   */
+  const std::vector<Param> &get_param_values() const { return params_; }
+
   std::vector<Expr> get_params_reduced() const override;
   SymSet free_symbols() const override;
 
@@ -76,8 +83,8 @@ class Gate : public Op {
   Gate();
 
  private:
-  // vector of symbolic params
-  const std::vector<Expr> params_;
+  // vector of (possibly symbolic) params
+  const std::vector<Param> params_;
   unsigned n_qubits_; /**< Number of qubits, when not deducible from type */
 };
 
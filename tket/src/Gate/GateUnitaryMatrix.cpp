@@ -14,7 +14,9 @@
 
 #include "GateUnitaryMatrix.hpp"
 
+#include <array>
 #include <cmath>
+#include <optional>
 #include <sstream>
 
 #include "Gate/Gate.hpp"
@@ -23,6 +25,7 @@
 #include "GateUnitaryMatrixUtils.hpp"
 #include "GateUnitaryMatrixVariableQubits.hpp"
 #include "GateUnitarySparseMatrix.hpp"
+#include "OpType/OpTypeFunctions.hpp"
 #include "Utils/Assert.hpp"
 
 // This is just for the main Gate -> matrix function, so the only part
@@ -170,9 +173,41 @@ static Eigen::MatrixXcd get_unitary_for_ordinary_fixed_size_case(
       ss.str(), GateUnitaryMatrixError::Cause::INPUT_ERROR);
 }
 
+// Gate types taking no parameters and acting on a fixed number of qubits
+static constexpr std::array<OpType, 29> fixed_types{
+    OpType::X,         OpType::Y,         OpType::Z,         OpType::S,
+    OpType::Sdg,       OpType::T,         OpType::Tdg,       OpType::V,
+    OpType::Vdg,       OpType::H,         OpType::BRIDGE,    OpType::noop,
+    OpType::ECR,       OpType::SX,        OpType::SXdg,      OpType::CSWAP,
+    OpType::CCX,       OpType::CX,        OpType::CY,        OpType::CZ,
+    OpType::CH,        OpType::CV,        OpType::CVdg,      OpType::CSX,
+    OpType::CSXdg,     OpType::SWAP,      OpType::ZZMax,     OpType::Sycamore,
+    OpType::ISWAPMax};
+
+const Eigen::MatrixXcd* GateUnitaryMatrix::get_fixed_unitary(OpType optype) {
+  // Empty for the types which are not fixed
+  static const std::array<Eigen::MatrixXcd, n_optypes> table = [] {
+    std::array<Eigen::MatrixXcd, n_optypes> unitaries;
+    for (OpType type : fixed_types) {
+      unitaries[static_cast<std::size_t>(type)] =
+          get_unitary_or_throw(type, 0, {});
+    }
+    return unitaries;
+  }();
+  const Eigen::MatrixXcd& unitary = table[static_cast<std::size_t>(optype)];
+  if (unitary.size() == 0) return nullptr;
+  return &unitary;
+}
+
 Eigen::MatrixXcd GateUnitaryMatrix::get_unitary(
     OpType op_type, unsigned number_of_qubits,
     const std::vector<double>& parameters) {
+  if (parameters.empty()) {
+    const Eigen::MatrixXcd* fixed = get_fixed_unitary(op_type);
+    if (fixed && get_number_of_qubits(fixed->cols()) == number_of_qubits) {
+      return *fixed;
+    }
+  }
   const internal::GateUnitaryMatrixVariableQubits variable_qubits_data(op_type);
   if (!variable_qubits_data.is_known_type()) {
     return get_unitary_for_ordinary_fixed_size_case(
@@ -197,10 +232,155 @@ Eigen::MatrixXcd GateUnitaryMatrix::get_unitary(const Gate& gate) {
   return get_unitary(gate.get_type(), gate.n_qubits(), parameters);
 }
 
+namespace {
+// The parameters of a gate taking at most three, checked as
+// get_checked_parameters does but without allocating
+struct SmallParameters {
+  std::array<double, 3> values;
+  unsigned size;
+
+  std::vector<double> to_vector() const {
+    return std::vector<double>(values.begin(), values.begin() + size);
+  }
+};
+}  // namespace
+
+// Returns nullopt if there are more than three parameters
+static std::optional<SmallParameters> get_checked_small_parameters(
+    const Gate& gate) {
+  const std::vector<Param>& param_values = gate.get_param_values();
+  SmallParameters parameters{{}, static_cast<unsigned>(param_values.size())};
+  if (parameters.size > parameters.values.size()) return std::nullopt;
+  for (unsigned nn = 0; nn < parameters.size; ++nn) {
+    const std::optional<double> value = param_values[nn].eval();
+    if (!value || !std::isfinite(value.value())) {
+      // Throws the error for the first bad parameter
+      GateUnitaryMatrixUtils::get_checked_parameters(gate);
+      TKET_ASSERT(!"Bad parameter not reported");
+    }
+    parameters.values[nn] = value.value();
+  }
+  return parameters;
+}
+
+static void check_and_throw_upon_wrong_number_of_small_parameters(
+    OpType op_type, unsigned number_of_qubits,
+    const SmallParameters& parameters, unsigned expected_number_of_parameters) {
+  if (parameters.size == expected_number_of_parameters) return;
+  GateUnitaryMatrixUtils::check_and_throw_upon_wrong_number_of_parameters(
+      op_type, number_of_qubits, parameters.to_vector(),
+      expected_number_of_parameters);
+}
+
+static void check_and_throw_upon_wrong_number_of_qubits(
+    const Gate& gate, unsigned expected_number_of_qubits) {
+  if (gate.n_qubits() == expected_number_of_qubits) return;
+  std::stringstream ss;
+  ss << GateUnitaryMatrixUtils::get_error_prefix(
+            gate.get_name(), gate.n_qubits(), {})
+     << "wrong number of qubits (expected " << expected_number_of_qubits << ")";
+  throw GateUnitaryMatrixError(
+      ss.str(), GateUnitaryMatrixError::Cause::INPUT_ERROR);
+}
+
+#ifdef CASE_RETURN_SMALL
+#error "Macro already defined!"
+#endif
+#define CASE_RETURN_SMALL(function_name, n_parameters, ...)         \
+  case OpType::function_name:                                       \
+    check_and_throw_upon_wrong_number_of_small_parameters(          \
+        OpType::function_name, gate.n_qubits(), p, n_parameters);   \
+    return GateUnitaryMatrixImplementations::function_name(__VA_ARGS__);
+
+Eigen::Matrix2cd GateUnitaryMatrix::get_unitary_1q(const Gate& gate) {
+  check_and_throw_upon_wrong_number_of_qubits(gate, 1);
+  const std::optional<SmallParameters> small_parameters =
+      get_checked_small_parameters(gate);
+  if (small_parameters) {
+    const SmallParameters& p = small_parameters.value();
+    const std::array<double, 3>& v = p.values;
+    switch (gate.get_type()) {
+      CASE_RETURN_SMALL(X, 0)
+      CASE_RETURN_SMALL(Y, 0)
+      CASE_RETURN_SMALL(Z, 0)
+      CASE_RETURN_SMALL(S, 0)
+      CASE_RETURN_SMALL(Sdg, 0)
+      CASE_RETURN_SMALL(T, 0)
+      CASE_RETURN_SMALL(Tdg, 0)
+      CASE_RETURN_SMALL(V, 0)
+      CASE_RETURN_SMALL(Vdg, 0)
+      CASE_RETURN_SMALL(H, 0)
+      CASE_RETURN_SMALL(SX, 0)
+      CASE_RETURN_SMALL(SXdg, 0)
+      CASE_RETURN_SMALL(noop, 0)
+      CASE_RETURN_SMALL(Rx, 1, v[0])
+      CASE_RETURN_SMALL(Ry, 1, v[0])
+      CASE_RETURN_SMALL(Rz, 1, v[0])
+      CASE_RETURN_SMALL(U1, 1, v[0])
+      CASE_RETURN_SMALL(U2, 2, v[0], v[1])
+      CASE_RETURN_SMALL(PhasedX, 2, v[0], v[1])
+      CASE_RETURN_SMALL(U3, 3, v[0], v[1], v[2])
+      CASE_RETURN_SMALL(tk1, 3, v[0], v[1], v[2])
+      default:
+        break;
+    }
+  }
+  // Any other types go through the general case
+  return get_unitary(gate);
+}
+
+Eigen::Matrix4cd GateUnitaryMatrix::get_unitary_2q(const Gate& gate) {
+  check_and_throw_upon_wrong_number_of_qubits(gate, 2);
+  const std::optional<SmallParameters> small_parameters =
+      get_checked_small_parameters(gate);
+  if (small_parameters) {
+    const SmallParameters& p = small_parameters.value();
+    const std::array<double, 3>& v = p.values;
+    switch (gate.get_type()) {
+      CASE_RETURN_SMALL(CX, 0)
+      CASE_RETURN_SMALL(CY, 0)
+      CASE_RETURN_SMALL(CZ, 0)
+      CASE_RETURN_SMALL(CH, 0)
+      CASE_RETURN_SMALL(CV, 0)
+      CASE_RETURN_SMALL(CVdg, 0)
+      CASE_RETURN_SMALL(CSX, 0)
+      CASE_RETURN_SMALL(CSXdg, 0)
+      CASE_RETURN_SMALL(SWAP, 0)
+      CASE_RETURN_SMALL(ECR, 0)
+      CASE_RETURN_SMALL(ZZMax, 0)
+      CASE_RETURN_SMALL(Sycamore, 0)
+      CASE_RETURN_SMALL(ISWAPMax, 0)
+      CASE_RETURN_SMALL(CRx, 1, v[0])
+      CASE_RETURN_SMALL(CRy, 1, v[0])
+      CASE_RETURN_SMALL(CRz, 1, v[0])
+      CASE_RETURN_SMALL(CU1, 1, v[0])
+      CASE_RETURN_SMALL(ISWAP, 1, v[0])
+      CASE_RETURN_SMALL(XXPhase, 1, v[0])
+      CASE_RETURN_SMALL(YYPhase, 1, v[0])
+      CASE_RETURN_SMALL(ZZPhase, 1, v[0])
+      CASE_RETURN_SMALL(ESWAP, 1, v[0])
+      CASE_RETURN_SMALL(PhasedISWAP, 2, v[0], v[1])
+      CASE_RETURN_SMALL(FSim, 2, v[0], v[1])
+      CASE_RETURN_SMALL(CU3, 3, v[0], v[1], v[2])
+      default:
+        break;
+    }
+  }
+  // Any other types go through the general case
+  return get_unitary(gate);
+}
+#undef CASE_RETURN_SMALL
+
 std::vector<TripletCd> GateUnitaryMatrix::get_unitary_triplets(
     const Gate& gate, double abs_epsilon) {
   auto triplets = internal::GateUnitarySparseMatrix::get_unitary_triplets(
       gate, abs_epsilon);
+  if (triplets.empty() && gate.get_param_values().empty()) {
+    const Eigen::MatrixXcd* fixed = get_fixed_unitary(gate.get_type());
+    if (fixed && get_number_of_qubits(fixed->cols()) == gate.n_qubits()) {
+      return get_triplets(*fixed, abs_epsilon);
+    }
+  }
   if (triplets.empty()) {
     // Not recognised as a specific sparse type, so just get the dense matrix
     const auto unitary_matr = get_unitary(gate);
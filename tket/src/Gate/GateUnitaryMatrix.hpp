@@ -40,6 +40,27 @@ struct GateUnitaryMatrix {
       OpType optype, unsigned number_of_qubits,
       const std::vector<double>& parameters);
 
+  /** The unitary of a gate type taking no parameters and acting on a fixed
+   *  number of qubits, computed once and shared; or null if the type is
+   *  not of this kind.
+   *  Uses ILO-BE convention.
+   */
+  static const Eigen::MatrixXcd* get_fixed_unitary(OpType optype);
+
+  /** As get_unitary, for a gate on one qubit, but returning a fixed-size
+   *  matrix. This does not allocate for the standard single-qubit gates.
+   *  Throws GateUnitaryMatrixError if the gate is not on one qubit, or
+   *  upon any other error.
+   */
+  static Eigen::Matrix2cd get_unitary_1q(const Gate& gate);
+
+  /** As get_unitary, for a gate on two qubits, but returning a fixed-size
+   *  matrix. This does not allocate for the standard two-qubit gates.
+   *  Throws GateUnitaryMatrixError if the gate is not on two qubits, or
+   *  upon any other error.
+   */
+  static Eigen::Matrix4cd get_unitary_2q(const Gate& gate);
+
   /** Return the unitary matrix of the gate, in sparse format, i.e.
    *  a collection of (i,j,z) tuples, meaning that U(i,j) = z.
    *  @param gate The gate. Throws GateUnitaryMatrixError upon error.
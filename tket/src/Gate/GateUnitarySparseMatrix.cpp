@@ -45,30 +45,24 @@ static OpType get_primitive_type(OpType type_without_controls) {
   }
 }
 
-// We have a type acting on 1 qubit.
-// Convert this to a type acting on n qubits (given by the Gate object)
-// by adding controls.
-static std::vector<TripletCd>
-convert_1qb_type_to_controlled_type_and_get_triplets(
-    const Gate& gate, OpType one_qubit_type, double abs_epsilon) {
-  const Gate new_gate(one_qubit_type, gate.get_params(), 1);
-  const auto small_unitary = GateUnitaryMatrix::get_unitary(new_gate);
-  auto triplets = get_triplets(small_unitary, abs_epsilon);
-
+// The triplets of a gate with controls on all but the last qubit, given
+// the triplets of the 2x2 target unitary: the identity, apart from
+// the bottom right corner. They are generated directly in order.
+static std::vector<TripletCd> get_controlled_gate_triplets(
+    const Gate& gate, const std::vector<TripletCd>& target_triplets) {
   // e.g., if CnX or CnRy for n=3, then U is 2x2, but we are embedding into
   // the bottom right corner of an 8x8 identity matrix
-  unsigned full_matr_size = get_matrix_size(gate.n_qubits());
-  unsigned translation = full_matr_size - small_unitary.rows();
-  if (translation > 0) {
-    for (auto& triplet : triplets) {
-      triplet = TripletCd(
-          triplet.row() + translation, triplet.col() + translation,
-          triplet.value());
-    }
-    triplets.reserve(triplets.size() + translation);
-    for (unsigned ii = 0; ii < translation; ++ii) {
-      triplets.emplace_back(ii, ii, 1.0);
-    }
+  const unsigned full_matr_size = get_matrix_size(gate.n_qubits());
+  const unsigned translation = full_matr_size - 2;
+  std::vector<TripletCd> triplets;
+  triplets.reserve(translation + target_triplets.size());
+  for (unsigned ii = 0; ii < translation; ++ii) {
+    triplets.emplace_back(ii, ii, 1.0);
+  }
+  for (const TripletCd& triplet : target_triplets) {
+    triplets.emplace_back(
+        triplet.row() + translation, triplet.col() + translation,
+        triplet.value());
   }
   return triplets;
 }
@@ -144,22 +138,33 @@ static std::vector<TripletCd> get_triplets_for_noncontrolled_gate(
   }
 }
 
+std::vector<TripletCd> GateUnitarySparseMatrix::get_controlled_target_triplets(
+    const Gate& gate, double abs_epsilon) {
+  const auto primitive_type = get_primitive_type(gate.get_type());
+  if (primitive_type == OpType::noop) {
+    return {};
+  }
+  try {
+    const Gate target_gate(primitive_type, gate.get_params(), 1);
+    const Eigen::MatrixXcd target_unitary =
+        GateUnitaryMatrix::get_unitary_1q(target_gate);
+    return get_triplets(target_unitary, abs_epsilon);
+  } catch (const GateUnitaryMatrixError& e) {
+    std::stringstream ss;
+    OpDesc desc(primitive_type);
+    ss << "Converting " << gate.get_name()
+       << " to sparse unitary, via adding controls to gate type "
+       << desc.name() << ": " << e.what();
+    throw GateUnitaryMatrixError(ss.str(), e.cause);
+  }
+}
+
 std::vector<TripletCd> GateUnitarySparseMatrix::get_unitary_triplets(
     const Gate& gate, double abs_epsilon) {
-  const auto type = gate.get_type();
-  const auto primitive_type = get_primitive_type(type);
-  if (primitive_type != OpType::noop) {
-    try {
-      return convert_1qb_type_to_controlled_type_and_get_triplets(
-          gate, primitive_type, abs_epsilon);
-    } catch (const GateUnitaryMatrixError& e) {
-      std::stringstream ss;
-      OpDesc desc(primitive_type);
-      ss << "Converting " << gate.get_name()
-         << " to sparse unitary, via adding controls to gate type "
-         << desc.name() << ": " << e.what();
-      throw GateUnitaryMatrixError(ss.str(), e.cause);
-    }
+  const auto target_triplets =
+      get_controlled_target_triplets(gate, abs_epsilon);
+  if (!target_triplets.empty()) {
+    return get_controlled_gate_triplets(gate, target_triplets);
   }
   return get_triplets_for_noncontrolled_gate(gate);
 }
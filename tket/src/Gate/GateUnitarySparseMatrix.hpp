@@ -40,6 +40,22 @@ struct GateUnitarySparseMatrix {
    */
   static std::vector<TripletCd> get_unitary_triplets(
       const Gate& gate, double abs_epsilon = EPS);
+
+  /** If the gate is a number of controls applied to a single-qubit gate
+   *  (such as CnX or CnRy), return the sparse unitary of that single-qubit
+   *  gate, which acts on the last qubit when all the others are 1,
+   *  and as the identity otherwise. For other types, returns an empty vector.
+   *
+   *  Thus, the work needed to apply the gate depends only on the nonzero
+   *  entries away from the identity, not on the number of controls.
+   *  Throws GateUnitaryMatrixError upon error.
+   *
+   *  @param gate unitary quantum gate
+   *  @param abs_epsilon As for get_unitary_triplets.
+   *  @return The triplets of the 2x2 target unitary, or empty.
+   */
+  static std::vector<TripletCd> get_controlled_target_triplets(
+      const Gate& gate, double abs_epsilon = EPS);
 };
 
 }  // namespace internal
@@ -14,24 +14,119 @@
 
 #include "OpPtrFunctions.hpp"
 
+#include <boost/functional/hash.hpp>
+#include <cmath>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
 #include "Gate.hpp"
 #include "Ops/MetaOp.hpp"
 #include "SymTable.hpp"
 
 namespace tket {
 
-Op_ptr get_op_ptr(OpType chosen_type, const Expr& param, unsigned n_qubits) {
-  return get_op_ptr(chosen_type, std::vector<Expr>{param}, n_qubits);
+namespace {
+
+/** Identifies an operation constructed by get_op_ptr */
+struct OpKey {
+  OpType type;
+  unsigned n_qubits;
+  std::vector<Expr> params;
+
+  bool operator==(const OpKey& other) const {
+    if (type != other.type || n_qubits != other.n_qubits ||
+        params.size() != other.params.size()) {
+      return false;
+    }
+    for (unsigned i = 0; i < params.size(); ++i) {
+      // Structural comparison, so that a cached op has exactly the parameters
+      // it is requested with.
+      if (!SymEngine::eq(*params[i].get_basic(), *other.params[i].get_basic()))
+        return false;
+    }
+    return true;
+  }
+};
+
+struct OpKeyHash {
+  std::size_t operator()(const OpKey& key) const {
+    std::size_t seed = 0;
+    boost::hash_combine(seed, key.type);
+    boost::hash_combine(seed, key.n_qubits);
+    for (const Expr& e : key.params) {
+      boost::hash_combine(seed, e.get_basic()->hash());
+    }
+    return seed;
+  }
+};
+
+/** Maximum number of cached operations with parameters */
+constexpr unsigned max_cached_param_ops = 4096;
+
+/**
+ * Whether operations with these parameters are worth sharing.
+ *
+ * Numeric multiples of a quarter turn up to 4 in absolute value: these are
+ * the angles produced by rebases and Clifford decompositions.
+ */
+bool is_common_params(const std::vector<Expr>& params) {
+  for (const Expr& e : params) {
+    if (!SymEngine::is_a_Number(*e.get_basic())) return false;
+    std::optional<double> x = eval_expr(e);
+    if (!x) return false;
+    double q = 4. * *x;
+    if (std::abs(q) > 16. || q != std::round(q)) return false;
+  }
+  return true;
 }
 
-Op_ptr get_op_ptr(
+Op_ptr make_op_ptr(
     OpType chosen_type, const std::vector<Expr>& params, unsigned n_qubits) {
   if (is_gate_type(chosen_type)) {
-    SymTable::register_symbols(expr_free_symbols(params));
     return std::make_shared<const Gate>(chosen_type, params, n_qubits);
   } else {
     return std::make_shared<const MetaOp>(chosen_type);
   }
 }
 
+}  // namespace
+
+Op_ptr get_op_ptr(OpType chosen_type, const Expr& param, unsigned n_qubits) {
+  return get_op_ptr(chosen_type, std::vector<Expr>{param}, n_qubits);
+}
+
+Op_ptr get_op_ptr(
+    OpType chosen_type, const std::vector<Expr>& params, unsigned n_qubits) {
+  // Operations are immutable, so identical ones can share a single object.
+  // The cache is never destroyed, so that it can be used during static
+  // deinitialization.
+  static std::unordered_map<OpKey, Op_ptr, OpKeyHash>* cache =
+      new std::unordered_map<OpKey, Op_ptr, OpKeyHash>();
+  static std::shared_mutex* cache_mutex = new std::shared_mutex();
+  static unsigned n_param_ops = 0;
+
+  bool cacheable = params.empty() || is_common_params(params);
+  if (!cacheable) {
+    if (is_gate_type(chosen_type)) {
+      SymTable::register_symbols(expr_free_symbols(params));
+    }
+    return make_op_ptr(chosen_type, params, n_qubits);
+  }
+  // Meta operations do not depend on the qubit count.
+  OpKey key{chosen_type, is_gate_type(chosen_type) ? n_qubits : 0, params};
+  {
+    std::shared_lock<std::shared_mutex> lock(*cache_mutex);
+    std::unordered_map<OpKey, Op_ptr, OpKeyHash>::const_iterator found =
+        cache->find(key);
+    if (found != cache->end()) return found->second;
+  }
+  Op_ptr op = make_op_ptr(chosen_type, params, n_qubits);
+  std::unique_lock<std::shared_mutex> lock(*cache_mutex);
+  if (!params.empty() && n_param_ops >= max_cached_param_ops) return op;
+  auto [it, inserted] = cache->insert({std::move(key), op});
+  if (inserted && !params.empty()) ++n_param_ops;
+  return it->second;
+}
+
 }  // namespace tket
@@ -61,6 +61,20 @@ static Expr expr_div(const Expr &num, const Expr &den) {
   return SymEngine::div(num, den);
 }
 
+static bool approx_0(double v) { return std::abs(v) < EPS; }
+
+static double atan2_bypi(double a, double b) {
+  if (std::abs(a) < EPS && std::abs(b) < EPS) return 0.;
+  return atan2(a, b) / PI;
+}
+
+static double acos_bypi(double a) {
+  // avoid undefined values due to rounding
+  if (a >= 1.) return 0.;
+  if (a <= -1.) return 1.;
+  return acos(a) / PI;
+}
+
 static std::tuple<Expr, Expr, Expr> xyx_angles_from_coeffs(
     const Expr &s, const Expr &i, const Expr &j, const Expr &k) {
   // Handle exceptional cases first.
@@ -148,35 +162,144 @@ static std::tuple<Expr, Expr, Expr> xyx_angles_from_coeffs(
   return std::tuple<Expr, Expr, Expr>(a - b, q, a + b);
 }
 
-Rotation::Rotation(OpType optype, Expr a)
-    : i_(0), j_(0), k_(0), optype_(optype), a_(a) {
-  if (equiv_0(a, 4)) {
-    rep_ = Rep::id;
-    s_ = 1;
-    i_ = j_ = k_ = 0;
-  } else if (equiv_0(a - 2, 4)) {
-    rep_ = Rep::minus_id;
-    s_ = -1;
-    i_ = j_ = k_ = 0;
+// Numeric version of the above, with the same choice of angles.
+static std::tuple<double, double, double> xyx_angles_from_coeffs(
+    double s, double i, double j, double k) {
+  bool s_zero = approx_0(s);
+  bool s_one = approx_0(s - 1);
+  bool i_zero = approx_0(i);
+  bool i_one = approx_0(i - 1);
+  bool j_zero = approx_0(j);
+  bool j_one = approx_0(j - 1);
+  bool k_zero = approx_0(k);
+  bool k_one = approx_0(k - 1);
+  if (i_zero && j_zero && k_zero) {
+    if (s_one)
+      return {0, 0, 0};
+    else
+      return {2, 0, 0};
+  }
+  if (s_zero && j_zero && k_zero) {
+    if (i_one)
+      return {1, 0, 0};
+    else
+      return {3, 0, 0};
+  }
+  if (s_zero && i_zero && k_zero) {
+    if (j_one)
+      return {0, 1, 0};
+    else
+      return {0, 3, 0};
+  }
+  if (s_zero && i_zero && j_zero) {
+    if (k_one)
+      return {3, 1, 0};
+    else
+      return {1, 1, 0};
+  }
+  if (s_zero && i_zero) return {-2 * atan2_bypi(k, j), 1, 0};
+  if (s_zero && j_zero) return {0, 2 * atan2_bypi(k, i), 1};
+  if (s_zero && k_zero) return {0.5, 2 * atan2_bypi(j, i), 0.5};
+  if (i_zero && j_zero) return {-0.5, 2 * atan2_bypi(k, s), 0.5};
+  if (i_zero && k_zero) return {0, 2 * atan2_bypi(j, s), 0};
+  if (j_zero && k_zero) return {2 * atan2_bypi(i, s), 0, 0};
+
+  // Factorizations as an Rx and an Ry, as in the symbolic case.
+  if (approx_0(i * j + s * k)) {
+    return {2 * atan(i / s) / PI, 2 * atan2_bypi(j, s), 0};
+  } else if (approx_0(i * j - s * k)) {
+    return {0, 2 * atan2_bypi(j, s), 2 * atan(i / s) / PI};
+  }
+
+  double a = atan2_bypi(i, s);
+  double b = atan2_bypi(k, j);
+  double q = acos_bypi(s * s + i * i - j * j - k * k);
+  return {a - b, q, a + b};
+}
+
+// Angles (p1, q, p2) from the coordinates of a rotation, for either
+// representation.
+template <typename T>
+static std::tuple<T, T, T> pqp_angles_from_coeffs(
+    OpType p, OpType q, const T &s, const T &i, const T &j, const T &k) {
+  if (p == OpType::Rx && q == OpType::Ry) {
+    return xyx_angles_from_coeffs(s, i, j, k);
+  } else if (p == OpType::Ry && q == OpType::Rx) {
+    return xyx_angles_from_coeffs(s, j, i, -k);
+  } else if (p == OpType::Ry && q == OpType::Rz) {
+    return xyx_angles_from_coeffs(s, j, k, i);
+  } else if (p == OpType::Rz && q == OpType::Ry) {
+    return xyx_angles_from_coeffs(s, k, j, -i);
+  } else if (p == OpType::Rz && q == OpType::Rx) {
+    return xyx_angles_from_coeffs(s, k, i, j);
+  } else if (p == OpType::Rx && q == OpType::Rz) {
+    return xyx_angles_from_coeffs(s, i, k, -j);
   } else {
-    rep_ = Rep::orth_rot;
-    s_ = cos_halfpi_times(a);
-    Expr t = sin_halfpi_times(a);
-    switch (optype) {
-      case OpType::Rx:
-        i_ = t;
-        break;
-      case OpType::Ry:
-        j_ = t;
-        break;
-      case OpType::Rz:
-        k_ = t;
-        break;
-      default:
-        throw std::logic_error(
-            "Quaternions can only be constructed "
-            "from Rx, Ry or Rz rotations");
+    throw std::logic_error("Axes must be a pair of X, Y, Z.");
+  }
+}
+
+Rotation::Rotation(OpType optype, Expr a)
+    : i_(0),
+      j_(0),
+      k_(0),
+      optype_(optype),
+      a_(a),
+      numeric_(false),
+      vs_(0),
+      vi_(0),
+      vj_(0),
+      vk_(0),
+      va_(0) {
+  std::optional<double> v = eval_expr(a);
+  if (v) {
+    numeric_ = true;
+    va_ = v.value();
+    if (approx_eq(va_, 0., 4)) {
+      rep_ = Rep::id;
+      vs_ = 1;
+    } else if (approx_eq(va_, 2., 4)) {
+      rep_ = Rep::minus_id;
+      vs_ = -1;
+    } else {
+      rep_ = Rep::orth_rot;
+      vs_ = cos(PI * va_ / 2);
+      double t = sin(PI * va_ / 2);
+      switch (optype) {
+        case OpType::Rx:
+          vi_ = t;
+          break;
+        case OpType::Ry:
+          vj_ = t;
+          break;
+        case OpType::Rz:
+          vk_ = t;
+          break;
+        default:
+          throw std::logic_error(
+              "Quaternions can only be constructed "
+              "from Rx, Ry or Rz rotations");
+      }
     }
+    return;
+  }
+  rep_ = Rep::orth_rot;
+  s_ = cos_halfpi_times(a);
+  Expr t = sin_halfpi_times(a);
+  switch (optype) {
+    case OpType::Rx:
+      i_ = t;
+      break;
+    case OpType::Ry:
+      j_ = t;
+      break;
+    case OpType::Rz:
+      k_ = t;
+      break;
+    default:
+      throw std::logic_error(
+          "Quaternions can only be constructed "
+          "from Rx, Ry or Rz rotations");
   }
 }
 
@@ -186,7 +309,7 @@ std::optional<Expr> Rotation::angle(OpType optype) const {
   } else if (rep_ == Rep::minus_id) {
     return Expr(2);
   } else if (rep_ == Rep::orth_rot && optype_ == optype) {
-    return a_;
+    return numeric_ ? Expr(va_) : a_;
   } else {
     return std::nullopt;
   }
@@ -198,27 +321,28 @@ std::tuple<Expr, Expr, Expr> Rotation::to_pqp(OpType p, OpType q) const {
   } else if (rep_ == Rep::minus_id) {
     return {Expr(2), Expr(0), Expr(0)};
   } else if (rep_ == Rep::orth_rot) {
+    Expr a = numeric_ ? Expr(va_) : a_;
     if (optype_ == p) {
-      return {a_, Expr(0), Expr(0)};
+      return {a, Expr(0), Expr(0)};
     } else if (optype_ == q) {
-      return {Expr(0), a_, Expr(0)};
+      return {Expr(0), a, Expr(0)};
     }
   }
-  if (p == OpType::Rx && q == OpType::Ry) {
-    return xyx_angles_from_coeffs(s_, i_, j_, k_);
-  } else if (p == OpType::Ry && q == OpType::Rx) {
-    return xyx_angles_from_coeffs(s_, j_, i_, -k_);
-  } else if (p == OpType::Ry && q == OpType::Rz) {
-    return xyx_angles_from_coeffs(s_, j_, k_, i_);
-  } else if (p == OpType::Rz && q == OpType::Ry) {
-    return xyx_angles_from_coeffs(s_, k_, j_, -i_);
-  } else if (p == OpType::Rz && q == OpType::Rx) {
-    return xyx_angles_from_coeffs(s_, k_, i_, j_);
-  } else if (p == OpType::Rx && q == OpType::Rz) {
-    return xyx_angles_from_coeffs(s_, i_, k_, -j_);
-  } else {
-    throw std::logic_error("Axes must be a pair of X, Y, Z.");
+  if (numeric_) {
+    auto [p1, q1, p2] = pqp_angles_from_coeffs(p, q, vs_, vi_, vj_, vk_);
+    return {Expr(p1), Expr(q1), Expr(p2)};
   }
+  return pqp_angles_from_coeffs(p, q, s_, i_, j_, k_);
+}
+
+void Rotation::make_symbolic() {
+  if (!numeric_) return;
+  numeric_ = false;
+  s_ = vs_;
+  i_ = vi_;
+  j_ = vj_;
+  k_ = vk_;
+  a_ = va_;
 }
 
 // Table of compositions
@@ -252,6 +376,115 @@ static const std::map<
 };
 
 void Rotation::apply(const Rotation &other) {
+  if (numeric_ && other.numeric_) {
+    apply_numeric(other);
+    return;
+  }
+  make_symbolic();
+  if (other.numeric_) {
+    Rotation symbolic_other = other;
+    symbolic_other.make_symbolic();
+    apply_symbolic(symbolic_other);
+  } else {
+    apply_symbolic(other);
+  }
+}
+
+// Follows the same steps as apply_symbolic below, on doubles.
+void Rotation::apply_numeric(const Rotation &other) {
+  if (other.rep_ == Rep::id) return;
+
+  if (rep_ == Rep::id) {
+    *this = other;
+    return;
+  }
+
+  if (rep_ == Rep::minus_id) {
+    if (other.rep_ == Rep::minus_id) {
+      rep_ = Rep::id;
+      vs_ = 1;
+      vi_ = vj_ = vk_ = 0;
+    } else {
+      rep_ = other.rep_;
+      optype_ = other.optype_;
+      va_ = other.va_ + 2;
+      vs_ = -other.vs_;
+      vi_ = -other.vi_;
+      vj_ = -other.vj_;
+      vk_ = -other.vk_;
+    }
+    return;
+  }
+
+  if (rep_ == Rep::orth_rot && other.rep_ == Rep::orth_rot) {
+    if (optype_ == other.optype_) {
+      va_ += other.va_;
+      if (approx_eq(va_, 0., 4)) {
+        rep_ = Rep::id;
+      } else if (approx_eq(va_, 0., 2)) {
+        rep_ = Rep::minus_id;
+      }
+    } else if (
+        (approx_eq(va_, 1., 4) || approx_eq(va_, -1., 4)) &&
+        (approx_eq(other.va_, 1., 4) || approx_eq(other.va_, -1., 4))) {
+      // We are in a subgroup of order 8
+      int m0 = approx_eq(va_, 1., 4) ? 1 : -1;
+      int m1 = approx_eq(other.va_, 1., 4) ? 1 : -1;
+      std::pair<OpType, int> r = product.at({optype_, m0, other.optype_, m1});
+      optype_ = r.first;
+      va_ = r.second;
+    } else
+      rep_ = Rep::quat;
+  } else
+    rep_ = Rep::quat;
+
+  double s1 = other.vs_ * vs_ - other.vi_ * vi_ - other.vj_ * vj_ -
+              other.vk_ * vk_;
+  double i1 = other.vs_ * vi_ + other.vi_ * vs_ + other.vj_ * vk_ -
+              other.vk_ * vj_;
+  double j1 = other.vs_ * vj_ - other.vi_ * vk_ + other.vj_ * vs_ +
+              other.vk_ * vi_;
+  double k1 = other.vs_ * vk_ + other.vi_ * vj_ - other.vj_ * vi_ +
+              other.vk_ * vs_;
+  vs_ = s1;
+  vi_ = i1;
+  vj_ = j1;
+  vk_ = k1;
+
+  if (rep_ == Rep::quat) {
+    // See if we can simplify the representation.
+    bool i_zero = approx_0(vi_);
+    bool j_zero = approx_0(vj_);
+    bool k_zero = approx_0(vk_);
+    if (i_zero && j_zero && k_zero) {
+      if (approx_0(vs_ - 1)) {
+        rep_ = Rep::id;
+        vs_ = 1;
+      } else {
+        rep_ = Rep::minus_id;
+        vs_ = -1;
+      }
+      vi_ = vj_ = vk_ = 0;
+    } else if (j_zero && k_zero) {
+      rep_ = Rep::orth_rot;
+      optype_ = OpType::Rx;
+      va_ = 2 * atan2_bypi(vi_, vs_);
+      vj_ = vk_ = 0;
+    } else if (k_zero && i_zero) {
+      rep_ = Rep::orth_rot;
+      optype_ = OpType::Ry;
+      va_ = 2 * atan2_bypi(vj_, vs_);
+      vk_ = vi_ = 0;
+    } else if (i_zero && j_zero) {
+      rep_ = Rep::orth_rot;
+      optype_ = OpType::Rz;
+      va_ = 2 * atan2_bypi(vk_, vs_);
+      vi_ = vj_ = 0;
+    }
+  }
+}
+
+void Rotation::apply_symbolic(const Rotation &other) {
   if (other.rep_ == Rep::id) return;
 
   if (rep_ == Rep::id) {
@@ -355,7 +588,16 @@ std::ostream &operator<<(std::ostream &os, const Rotation &q) {
   } else if (q.rep_ == Rotation::Rep::minus_id) {
     return os << "-I";
   } else if (q.rep_ == Rotation::Rep::orth_rot) {
-    return os << OpDesc(q.optype_).name() << "(" << q.a_ << ")";
+    os << OpDesc(q.optype_).name() << "(";
+    if (q.numeric_) {
+      os << q.va_;
+    } else {
+      os << q.a_;
+    }
+    return os << ")";
+  } else if (q.numeric_) {
+    return os << q.vs_ << " + " << q.vi_ << " i + " << q.vj_ << " j + "
+              << q.vk_ << " k";
   } else {
     return os << q.s_ << " + " << q.i_ << " i + " << q.j_ << " j + " << q.k_
               << " k";
@@ -20,12 +20,29 @@
 
 namespace tket {
 
-/** A faithful representation of SU(2). */
+/**
+ * A faithful representation of SU(2).
+ *
+ * Rotations with no free symbols are held as doubles and composed without
+ * building any expressions; they are only converted to \ref Expr when they
+ * are read out, or when they are composed with a symbolic rotation.
+ */
 class Rotation {
  public:
   /** Identity */
   Rotation()
-      : rep_(Rep::id), s_(1), i_(0), j_(0), k_(0), optype_(OpType::noop) {}
+      : rep_(Rep::id),
+        s_(1),
+        i_(0),
+        j_(0),
+        k_(0),
+        optype_(OpType::noop),
+        numeric_(true),
+        vs_(1),
+        vi_(0),
+        vj_(0),
+        vk_(0),
+        va_(0) {}
 
   /**
    * Represent an X, Y or Z rotation
@@ -44,6 +61,9 @@ class Rotation {
   /** Is it minus the identity? */
   bool is_minus_id() const { return rep_ == Rep::minus_id; }
 
+  /** Is it free of symbols (and so held numerically)? */
+  bool is_numeric() const { return numeric_; }
+
   /**
    * Return the angle given the axis
    *
@@ -89,6 +109,21 @@ class Rotation {
   // If rep_ == Rep::orth_rot, we represent the rotation as an axis and angle:
   OpType optype_;
   Expr a_;
+
+  // If numeric_, the coordinates and angle are held in the doubles below
+  // instead of s_, i_, j_, k_ and a_, which are not kept up to date.
+  bool numeric_;
+  double vs_;
+  double vi_;
+  double vj_;
+  double vk_;
+  double va_;
+
+  /** Move the numeric values into the symbolic representation */
+  void make_symbolic();
+
+  void apply_numeric(const Rotation& other);
+  void apply_symbolic(const Rotation& other);
 };
 
 /**
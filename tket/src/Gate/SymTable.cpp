@@ -14,33 +14,91 @@
 
 #include "SymTable.hpp"
 
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+
 namespace tket {
 
-std::unordered_set<std::string>& SymTable::get_registered_symbols() {
-  static std::unordered_set<std::string> symbols;
-  return symbols;
+namespace {
+
+/**
+ * Set of symbol names, split into shards by hash, each with its own lock.
+ *
+ * Threads registering different symbols rarely contend, and registering a
+ * symbol that is already present (the common case, as every operation with
+ * symbolic parameters registers its symbols) only takes a shared lock.
+ */
+class SymbolRegistry {
+ public:
+  /** Add a name; return false if it was already present */
+  bool insert(const std::string& name) {
+    Shard& shard = get_shard(name);
+    {
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      if (shard.names.find(name) != shard.names.end()) return false;
+    }
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.names.insert(name).second;
+  }
+
+  void clear() {
+    for (Shard& shard : shards_) {
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      shard.names.clear();
+    }
+  }
+
+ private:
+  static constexpr std::size_t n_shards = 64;
+
+  // Aligned so that the locks of different shards do not share cache lines
+  struct alignas(64) Shard {
+    std::shared_mutex mutex;
+    std::unordered_set<std::string> names;
+  };
+
+  Shard& get_shard(const std::string& name) {
+    return shards_[std::hash<std::string>()(name) % n_shards];
+  }
+
+  std::array<Shard, n_shards> shards_;
+};
+
+}  // namespace
+
+// Never destroyed, so that operations created during static destruction
+// may still register their symbols
+static SymbolRegistry& get_registry() {
+  static SymbolRegistry *registry = new SymbolRegistry();
+  return *registry;
 }
 
 Sym SymTable::fresh_symbol(const std::string& preferred) {
+  // Checking and claiming each candidate is a single insertion, so two
+  // threads never receive the same symbol.
   std::string new_symbol = preferred;
   unsigned suffix = 0;
-  while (get_registered_symbols().find(new_symbol) !=
-         get_registered_symbols().cend()) {
+  while (!get_registry().insert(new_symbol)) {
     suffix++;
     new_symbol = preferred + "_" + std::to_string(suffix);
   }
-  register_symbol(new_symbol);
   return SymEngine::symbol(new_symbol);
 }
 
 void SymTable::register_symbol(const std::string& symbol) {
-  get_registered_symbols().insert(symbol);
+  get_registry().insert(symbol);
 }
 
 void SymTable::register_symbols(const SymSet& ss) {
   for (const auto& s : ss) {
-    get_registered_symbols().insert(s->get_name());
+    get_registry().insert(s->get_name());
   }
 }
 
+void SymTable::clear() { get_registry().clear(); }
+
 }  // namespace tket
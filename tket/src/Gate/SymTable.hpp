@@ -29,7 +29,10 @@ void clear_symbol_table();
  * All members are static. There are no instances of this class.
  *
  * When an operation is created using \p get_op_ptr, any symbols in its
- * parameters are added to a global registry of symbols.
+ * parameters are added to a global registry of symbols. The functions may be
+ * called from several threads at once. The registry is sharded, so threads
+ * registering different symbols do not wait for each other, and registering
+ * a symbol already present only takes a shared lock.
  */
 struct SymTable {
   /** Create a new symbol (not currently registered), and register it */
@@ -41,7 +44,7 @@ struct SymTable {
 
  private:
   friend void test_Ops::clear_symbol_table();
-  static std::unordered_set<std::string> &get_registered_symbols();
+  static void clear();
 };
 
 }  // namespace tket
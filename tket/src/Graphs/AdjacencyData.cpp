@@ -78,15 +78,52 @@ std::size_t AdjacencyData::get_number_of_vertices() const {
 }
 
 std::size_t AdjacencyData::get_number_of_edges() const {
-  // Each edge i-j is counted twice, i->j and j->i, except for loops.
-  std::size_t edges = 0;
-  std::size_t loops = 0;
+  return m_number_of_edges;
+}
+
+bool AdjacencyData::is_dense() const { return !m_bit_rows.empty(); }
 
-  for (std::size_t ii = 0; ii < m_cleaned_data.size(); ++ii) {
-    edges += m_cleaned_data[ii].size();
-    loops += m_cleaned_data[ii].count(ii);
+std::size_t AdjacencyData::get_words_per_row() const {
+  return m_words_per_row;
+}
+
+const std::uint64_t* AdjacencyData::get_neighbour_bits(
+    std::size_t vertex) const {
+  if (!is_dense() || vertex >= m_cleaned_data.size()) {
+    stringstream ss;
+    ss << "AdjacencyData: get_neighbour_bits called with vertex " << vertex
+       << "; there are " << m_cleaned_data.size() << " vertices, and the graph "
+       << (is_dense() ? "is" : "is not") << " dense";
+    throw runtime_error(ss.str());
+  }
+  return m_bit_rows.data() + vertex * m_words_per_row;
+}
+
+bool AdjacencyData::insert_edge(std::size_t i, std::size_t j) {
+  if (!m_cleaned_data[i].insert(j).second) {
+    return false;
+  }
+  m_cleaned_data[j].insert(i);
+  ++m_number_of_edges;
+  if (is_dense()) {
+    m_bit_rows[i * m_words_per_row + j / 64] |= std::uint64_t{1} << (j % 64);
+    m_bit_rows[j * m_words_per_row + i / 64] |= std::uint64_t{1} << (i % 64);
+  }
+  return true;
+}
+
+void AdjacencyData::update_dense_representation() {
+  const std::size_t n = m_cleaned_data.size();
+  if (is_dense() || 16 * m_number_of_edges < n * n) {
+    return;
+  }
+  m_words_per_row = (n + 63) / 64;
+  m_bit_rows.assign(n * m_words_per_row, 0);
+  for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j : m_cleaned_data[i]) {
+      m_bit_rows[i * m_words_per_row + j / 64] |= std::uint64_t{1} << (j % 64);
+    }
   }
-  return loops + (edges - loops) / 2;
 }
 
 bool AdjacencyData::add_edge(std::size_t i, std::size_t j) {
@@ -95,8 +132,8 @@ bool AdjacencyData::add_edge(std::size_t i, std::size_t j) {
     if (exists) {
       return false;
     }
-    m_cleaned_data[i].insert(j);
-    m_cleaned_data[j].insert(i);
+    insert_edge(i, j);
+    update_dense_representation();
     return true;
   } catch (const exception& e) {
     stringstream ss;
@@ -112,6 +149,9 @@ bool AdjacencyData::edge_exists(std::size_t i, std::size_t j) const {
        << ", but there are only " << m_cleaned_data.size() << " vertices";
     throw runtime_error(ss.str());
   }
+  if (is_dense()) {
+    return (m_bit_rows[i * m_words_per_row + j / 64] >> (j % 64)) & 1;
+  }
   return m_cleaned_data[i].count(j) != 0;
 }
 
@@ -120,15 +160,20 @@ void AdjacencyData::clear(std::size_t number_of_vertices) {
   for (auto& entry : m_cleaned_data) {
     entry.clear();
   }
+  m_number_of_edges = 0;
+  m_bit_rows.clear();
+  m_words_per_row = 0;
 }
 
-AdjacencyData::AdjacencyData(std::size_t number_of_vertices) {
+AdjacencyData::AdjacencyData(std::size_t number_of_vertices)
+    : m_number_of_edges(0), m_words_per_row(0) {
   m_cleaned_data.resize(number_of_vertices);
 }
 
 AdjacencyData::AdjacencyData(
     const map<std::size_t, vector<std::size_t>>& raw_data,
-    std::size_t number_of_vertices) {
+    std::size_t number_of_vertices)
+    : m_number_of_edges(0), m_words_per_row(0) {
   for (const auto& entry : raw_data) {
     number_of_vertices = std::max(number_of_vertices, entry.first + 1);
     for (std::size_t neighbour : entry.second) {
@@ -150,7 +195,8 @@ AdjacencyData::AdjacencyData(
 }
 
 AdjacencyData::AdjacencyData(
-    const vector<vector<std::size_t>>& raw_data, bool allow_loops) {
+    const vector<vector<std::size_t>>& raw_data, bool allow_loops)
+    : m_number_of_edges(0), m_words_per_row(0) {
   m_cleaned_data.resize(raw_data.size());
 
   try {
@@ -161,15 +207,15 @@ AdjacencyData::AdjacencyData(
           ss << "vertex " << i << " has a loop.";
           throw runtime_error(ss.str());
         }
-        if (j > raw_data.size()) {
+        if (j >= raw_data.size()) {
           stringstream ss;
           ss << "vertex " << i << " has illegal neighbour vertex " << j;
           throw runtime_error(ss.str());
         }
-        m_cleaned_data[i].insert(j);
-        m_cleaned_data[j].insert(i);
+        insert_edge(i, j);
       }
     }
+    update_dense_representation();
   } catch (const exception& e) {
     stringstream ss;
     ss << "AdjacencyData: we have " << raw_data.size()
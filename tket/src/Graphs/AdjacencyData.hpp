@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <set>
@@ -58,6 +59,11 @@ namespace graphs {
  * The number of vertices must be known at the start
  * (or, it can be reset later, but only by clearing all data),
  * so it is not completely dynamic. The constructors throw upon invalid data.
+ *
+ * Neighbours are always available as sets. Once the graph becomes dense
+ * (see is_dense), an adjacency matrix of bits is also kept, so that
+ * edge_exists is a single bit test and algorithms can intersect
+ * neighbourhoods 64 vertices at a time.
  */
 class AdjacencyData {
  public:
@@ -120,6 +126,21 @@ class AdjacencyData {
    */
   bool add_edge(std::size_t i, std::size_t j);
 
+  /** True if the bit matrix is available, i.e. get_neighbour_bits
+   * can be used. This is automatically switched on once at least
+   * 1/8 of all possible edges are present.
+   */
+  bool is_dense() const;
+
+  /** The number of 64-bit words in each row of the bit matrix. */
+  std::size_t get_words_per_row() const;
+
+  /** For a dense graph, the row of the bit matrix for the given vertex:
+   * bit (j % 64) of word (j / 64) is set iff j-v is an edge.
+   * Throws if the graph is not dense, or the vertex is invalid.
+   */
+  const std::uint64_t* get_neighbour_bits(std::size_t vertex) const;
+
   /** to_string is useful for debugging. You can copy the graph data
    * and easily paste it back into C++ code.
    */
@@ -128,6 +149,20 @@ class AdjacencyData {
  private:
   // Element i gives all neighbours j for vertex i, including j<i for speed.
   std::vector<std::set<std::size_t>> m_cleaned_data;
+
+  std::size_t m_number_of_edges;
+
+  // Empty unless the graph is dense; otherwise row i holds the neighbours
+  // of vertex i, in words [i * m_words_per_row, (i + 1) * m_words_per_row).
+  std::vector<std::uint64_t> m_bit_rows;
+  std::size_t m_words_per_row;
+
+  // Adds i-j to the sets (and bits, if dense), without checking the vertices.
+  // Returns false if the edge already existed.
+  bool insert_edge(std::size_t i, std::size_t j);
+
+  // Builds the bit matrix if the graph has become dense enough.
+  void update_dense_representation();
 };
 
 }  // namespace graphs
@@ -22,6 +22,7 @@
 #include <utility>
 #include <vector>
 
+#include "Graphs/AbstractGraph.hpp"
 #include "Graphs/Utils.hpp"
 #include "Utils/GraphHeaders.hpp"
 
@@ -219,6 +220,102 @@ std::set<T> get_subgraph_aps(
   return bicomp_graph.get_inner_edges();
 }
 
+template <typename T>
+ArticulationPointTracker<T>::ArticulationPointTracker(
+    const UndirectedConnGraph<T>& graph) {
+  for (auto v : boost::make_iterator_range(boost::vertices(graph))) {
+    neighbours_[graph[v]];
+  }
+  for (auto e : boost::make_iterator_range(boost::edges(graph))) {
+    const T& u = graph[boost::source(e, graph)];
+    const T& v = graph[boost::target(e, graph)];
+    if (u != v) {
+      neighbours_[u].insert(v);
+      neighbours_[v].insert(u);
+    }
+  }
+  std::set<T> all;
+  for (const auto& [node, _] : neighbours_) {
+    all.insert(node);
+    vertex_blocks_[node];
+  }
+  add_blocks(all);
+}
+
+template <typename T>
+void ArticulationPointTracker<T>::remove_vertex(const T& node) {
+  auto it = vertex_blocks_.find(node);
+  if (it == vertex_blocks_.end()) {
+    throw NodeDoesNotExistError(
+        "Trying to remove a vertex not in the articulation point tracker");
+  }
+  std::set<T> affected;
+  if (it->second.size() == 1) {
+    // Only this vertex's block changes.
+    const unsigned b = *it->second.begin();
+    affected = std::move(blocks_[b]);
+    blocks_[b].clear();
+    for (const T& v : affected) vertex_blocks_[v].erase(b);
+    affected.erase(node);
+  } else {
+    blocks_.clear();
+    for (auto& [v, bs] : vertex_blocks_) {
+      bs.clear();
+      if (v != node) affected.insert(v);
+    }
+  }
+  for (const T& v : neighbours_[node]) neighbours_[v].erase(node);
+  neighbours_.erase(node);
+  vertex_blocks_.erase(it);
+  aps_.erase(node);
+  add_blocks(affected);
+}
+
+template <typename T>
+void ArticulationPointTracker<T>::add_blocks(const std::set<T>& vertices) {
+  using Graph =
+      boost::adjacency_list<boost::vecS, boost::vecS, boost::undirectedS>;
+  const std::vector<T> nodes(vertices.begin(), vertices.end());
+  std::map<T, unsigned> index;
+  for (unsigned i = 0; i < nodes.size(); ++i) index[nodes[i]] = i;
+  Graph g(nodes.size());
+  for (unsigned i = 0; i < nodes.size(); ++i) {
+    for (const T& v : neighbours_[nodes[i]]) {
+      auto j = index.find(v);
+      if (j != index.end() && j->second > i) {
+        boost::add_edge(i, j->second, g);
+      }
+    }
+  }
+
+  std::map<utils::edge<Graph>, unsigned> edge_to_comp;
+  const unsigned n_comps = boost::biconnected_components(
+      g, boost::make_assoc_property_map(edge_to_comp));
+  const unsigned offset = blocks_.size();
+  blocks_.resize(offset + n_comps);
+  for (const auto& [e, c] : edge_to_comp) {
+    for (unsigned v : {boost::source(e, g), boost::target(e, g)}) {
+      blocks_[offset + c].insert(nodes[v]);
+      vertex_blocks_[nodes[v]].insert(offset + c);
+    }
+  }
+  for (unsigned i = 0; i < nodes.size(); ++i) {
+    std::set<unsigned>& bs = vertex_blocks_[nodes[i]];
+    if (bs.empty()) {
+      bs.insert(blocks_.size());
+      blocks_.push_back({nodes[i]});
+    }
+    if (bs.size() > 1) {
+      aps_.insert(nodes[i]);
+    } else {
+      aps_.erase(nodes[i]);
+    }
+  }
+}
+
+template class ArticulationPointTracker<UnitID>;
+template class ArticulationPointTracker<Node>;
+
 template std::set<UnitID> get_subgraph_aps(
     const UndirectedConnGraph<UnitID>& graph,
     const UndirectedConnGraph<UnitID>& subgraph);
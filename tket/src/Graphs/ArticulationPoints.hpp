@@ -15,7 +15,9 @@
 #pragma once
 
 #include <boost/graph/biconnected_components.hpp>
+#include <map>
 #include <set>
+#include <vector>
 
 #include "Graphs/ArticulationPoints_impl.hpp"
 
@@ -79,7 +81,46 @@ std::set<T> get_subgraph_aps(
     const UndirectedConnGraph<T>& graph,
     const UndirectedConnGraph<T>& subgraph);
 
+/**
+ * The APs of a graph, maintained as vertices are removed from it.
+ *
+ * The biconnected components (blocks) of the graph are held as sets of
+ * vertices, and the APs are the vertices in more than one block. A vertex
+ * that is not an AP belongs to a single block, and removing it can only
+ * change that block: it splits into the blocks of what remains of it, and
+ * only the vertices of that block can gain or lose AP status. So such a
+ * removal costs time linear in the size of the block rather than of the
+ * graph. Removing an AP recomputes all the blocks.
+ */
+template <typename T>
+class ArticulationPointTracker {
+ public:
+  explicit ArticulationPointTracker(const UndirectedConnGraph<T>& graph);
+
+  /** The current APs */
+  const std::set<T>& get_aps() const { return aps_; }
+
+  /** Remove a vertex and its edges, updating the APs */
+  void remove_vertex(const T& node);
+
+ private:
+  // undirected adjacency, without self-loops
+  std::map<T, std::set<T>> neighbours_;
+  // vertex sets of the blocks; blocks that have been split are left empty
+  std::vector<std::set<T>> blocks_;
+  // blocks each vertex belongs to
+  std::map<T, std::set<unsigned>> vertex_blocks_;
+  std::set<T> aps_;
+
+  /** Add the blocks of the subgraph induced by `vertices`, and update the AP
+   * status of its vertices. Isolated vertices get a block of their own only if
+   * they are in no other block */
+  void add_blocks(const std::set<T>& vertices);
+};
+
 // template explicit instations, with implementations in cpp file
+extern template class ArticulationPointTracker<UnitID>;
+extern template class ArticulationPointTracker<Node>;
 extern template std::set<UnitID> get_subgraph_aps(
     const UndirectedConnGraph<UnitID>& graph,
     const UndirectedConnGraph<UnitID>& subgraph);
@@ -14,12 +14,16 @@
 
 #include "BruteForceColouring.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <set>
 #include <sstream>
 #include <stdexcept>
 
 #include "ColouringPriority.hpp"
 #include "Utils/Assert.hpp"
+#include "Utils/Parallel.hpp"
 
 using std::map;
 using std::set;
@@ -117,16 +121,27 @@ struct BruteForceColouring::Impl {
     }
   }
 
-  bool attempt_brute_force_colouring(const ColouringPriority& priority) {
-    for (auto& data : colouring_data) {
-      data.current_colour_index = 0;
-    }
-    const auto& nodes = priority.get_nodes();
+  enum class SearchResult { FOUND, EXHAUSTED, STOPPED };
+
+  // Depth-first search through the colourings of nodes from "start_index"
+  // onwards, the colours of earlier nodes being fixed in "data".
+  // "should_stop" is polled every so often.
+  static SearchResult search(
+      const ColouringPriority::Nodes& nodes, vector<NodeColouringData>& data,
+      size_t start_index, const std::function<bool()>& should_stop) {
     const size_t number_of_nodes = nodes.size();
+    if (start_index >= number_of_nodes) {
+      return SearchResult::FOUND;
+    }
+    data[start_index].current_colour_index = 0;
+    size_t steps = 0;
 
-    for (size_t current_node_index = 0;;) {
+    for (size_t current_node_index = start_index;;) {
+      if (++steps % 4096 == 0 && should_stop()) {
+        return SearchResult::STOPPED;
+      }
       const auto& current_node = nodes[current_node_index];
-      auto& current_colouring_node = colouring_data[current_node_index];
+      auto& current_colouring_node = data[current_node_index];
 
       if (current_colouring_node.is_valid_colour()) {
         // We have a candidate colour, now test it for consistency.
@@ -136,7 +151,7 @@ struct BruteForceColouring::Impl {
         // TODO: would a set of colours be faster here?
         for (size_t earlier_node_index :
              current_node.earlier_neighbour_node_indices) {
-          if (colouring_data[earlier_node_index].get_colour() == current_col) {
+          if (data[earlier_node_index].get_colour() == current_col) {
             colour_is_impossible = true;
             break;
           }
@@ -145,34 +160,169 @@ struct BruteForceColouring::Impl {
           // Advance to the next node to colour.
           ++current_node_index;
           if (current_node_index < number_of_nodes) {
-            colouring_data[current_node_index].current_colour_index = 0;
+            data[current_node_index].current_colour_index = 0;
             continue;
           }
           // We've hit the end! We are finished.
-          return true;
+          return SearchResult::FOUND;
         }
         ++current_colouring_node.current_colour_index;
         continue;
       }
 
       // We must backtrack.
-      if (current_node_index == 0) {
-        return false;
+      if (current_node_index == start_index) {
+        return SearchResult::EXHAUSTED;
       }
       --current_node_index;
 
       // Advance the colour.
-      ++colouring_data[current_node_index].current_colour_index;
+      ++data[current_node_index].current_colour_index;
     }
     // We cannot actually reach here, the outer loop only returns, never breaks.
   }
+
+  // Whether the node at "index" may take its current colour, given the
+  // colours of earlier nodes.
+  bool colour_is_consistent(
+      const ColouringPriority::Nodes& nodes,
+      const vector<NodeColouringData>& data, size_t index) const {
+    const auto col = data[index].get_colour();
+    for (size_t earlier : nodes[index].earlier_neighbour_node_indices) {
+      if (data[earlier].get_colour() == col) return false;
+    }
+    return true;
+  }
+
+  // All consistent choices of colour index for the nodes from "start_index"
+  // on, as far as is needed to give at least "target" of them (or fewer,
+  // if every node is reached), in the order the sequential search would
+  // visit them.
+  vector<vector<size_t>> get_prefixes(
+      const ColouringPriority::Nodes& nodes, size_t start_index,
+      size_t target) const {
+    vector<vector<size_t>> prefixes(1);
+    vector<NodeColouringData> data = colouring_data;
+    for (size_t index = start_index;
+         index < nodes.size() && prefixes.size() < target; ++index) {
+      vector<vector<size_t>> next;
+      for (const auto& prefix : prefixes) {
+        for (size_t i = 0; i < prefix.size(); ++i) {
+          data[start_index + i].current_colour_index = prefix[i];
+        }
+        const size_t n_choices = data[index].allowed_colours.size();
+        for (size_t choice = 0; choice < n_choices; ++choice) {
+          data[index].current_colour_index = choice;
+          if (colour_is_consistent(nodes, data, index)) {
+            next.push_back(prefix);
+            next.back().push_back(choice);
+          }
+        }
+      }
+      prefixes = std::move(next);
+    }
+    return prefixes;
+  }
+
+  // Returns true if a colouring was found, leaving it in "colouring_data".
+  // Sets "m_timed_out" if the deadline passed first.
+  bool attempt_brute_force_colouring(const ColouringPriority& priority) {
+    for (auto& data : colouring_data) {
+      data.current_colour_index = 0;
+    }
+    const auto& nodes = priority.get_nodes();
+    const size_t start_index =
+        std::min(priority.get_initial_clique().size(), nodes.size());
+    const auto deadline_passed = [this]() {
+      return deadline && std::chrono::steady_clock::now() > *deadline;
+    };
+
+    const unsigned n_threads = get_max_threads();
+    if (n_threads <= 1) {
+      const SearchResult result =
+          search(nodes, colouring_data, start_index, deadline_passed);
+      m_timed_out = (result == SearchResult::STOPPED);
+      return result == SearchResult::FOUND;
+    }
+
+    // Split the search between threads by the colours of the first few
+    // nodes. The lowest-numbered prefix with a colouring gives the same
+    // colouring as the sequential search; searches from higher prefixes stop
+    // as soon as one is known.
+    const vector<vector<size_t>> prefixes =
+        get_prefixes(nodes, start_index, 8 * n_threads);
+    if (prefixes.empty()) return false;
+    const size_t none = prefixes.size();
+    std::atomic<size_t> best(none);
+    vector<vector<NodeColouringData>> solutions(prefixes.size());
+    vector<char> stopped(prefixes.size(), 0);
+
+    parallel_for(0, prefixes.size(), 1, [&](size_t begin, size_t end) {
+      vector<NodeColouringData> data = colouring_data;
+      for (size_t p = begin; p < end; ++p) {
+        if (p > best.load()) return;
+        const auto& prefix = prefixes[p];
+        for (size_t i = 0; i < prefix.size(); ++i) {
+          data[start_index + i].current_colour_index = prefix[i];
+        }
+        const SearchResult result =
+            search(nodes, data, start_index + prefix.size(), [&]() {
+              return p > best.load() || deadline_passed();
+            });
+        if (result == SearchResult::FOUND) {
+          solutions[p] = data;
+          size_t current = best.load();
+          while (p < current && !best.compare_exchange_weak(current, p)) {
+          }
+          return;
+        }
+        if (result == SearchResult::STOPPED && deadline_passed()) {
+          stopped[p] = 1;
+        }
+      }
+    });
+
+    const size_t found = best.load();
+    for (size_t p = 0; p < std::min(found, none); ++p) {
+      if (stopped[p]) {
+        m_timed_out = true;
+        return false;
+      }
+    }
+    if (found == none) return false;
+    colouring_data = std::move(solutions[found]);
+    return true;
+  }
+
+  // Colour each node in priority order with the first colour not used by an
+  // earlier neighbour.
+  void fill_greedy_colour_map(const ColouringPriority& priority) {
+    const auto& nodes = priority.get_nodes();
+    vector<size_t> node_colours(nodes.size());
+    vector<bool> used;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      used.assign(nodes[i].earlier_neighbour_node_indices.size() + 1, false);
+      for (size_t j : nodes[i].earlier_neighbour_node_indices) {
+        if (node_colours[j] < used.size()) used[node_colours[j]] = true;
+      }
+      size_t col = 0;
+      while (used[col]) ++col;
+      node_colours[i] = col;
+      colours[nodes[i].vertex] = col;
+    }
+  }
+
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+  bool m_timed_out = false;
 };
 
 BruteForceColouring::~BruteForceColouring() {}
 
 BruteForceColouring::BruteForceColouring(
-    const ColouringPriority& priority, size_t suggested_number_of_colours)
+    const ColouringPriority& priority, size_t suggested_number_of_colours,
+    std::optional<std::chrono::steady_clock::time_point> deadline)
     : m_pimpl(std::make_unique<BruteForceColouring::Impl>()) {
+  m_pimpl->deadline = deadline;
   const auto number_of_nodes = priority.get_nodes().size();
   if (suggested_number_of_colours >= number_of_nodes) {
     // We've been given permission to use many colours;
@@ -203,6 +353,11 @@ BruteForceColouring::BruteForceColouring(
         m_pimpl->fill_colour_map(priority);
         return;
       }
+      if (m_pimpl->m_timed_out) {
+        m_pimpl->colours.clear();
+        m_pimpl->fill_greedy_colour_map(priority);
+        return;
+      }
       // It's impossible with this number of colours,
       // so try again with one more.
       // If we were really fancy we might consider
@@ -229,5 +384,7 @@ const map<size_t, size_t>& BruteForceColouring::get_colours() const {
   return m_pimpl->colours;
 }
 
+bool BruteForceColouring::timed_out() const { return m_pimpl->m_timed_out; }
+
 }  // namespace graphs
 }  // namespace tket
@@ -14,9 +14,11 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstddef>
 #include <map>
 #include <memory>
+#include <optional>
 
 namespace tket {
 namespace graphs {
@@ -30,6 +32,11 @@ class ColouringPriority;
  * (like traversing a "game tree"), there is the potential for pruning,
  * and hence it can be much quicker than simply trying every possible colouring.
  * It only looks for ONE colouring.
+ *
+ * Each search is split between threads (see \ref parallel_for) by fixing
+ * the colours of the first few vertices after the initial clique; the
+ * result is the same as that of the sequential search, whatever the number
+ * of threads.
  */
 class BruteForceColouring {
  public:
@@ -41,10 +48,14 @@ class BruteForceColouring {
    * @param suggested_number_of_colours A hint that you think this many colours
    * are needed. If you set it too high you may end up with a suboptimal
    * colouring, but it might be quicker.
+   * @param deadline If given, and the search is not finished by then, give
+   * up and use a greedy colouring in the priority order instead.
    */
   BruteForceColouring(
       const ColouringPriority& priority,
-      std::size_t suggested_number_of_colours = 0);
+      std::size_t suggested_number_of_colours = 0,
+      std::optional<std::chrono::steady_clock::time_point> deadline =
+          std::nullopt);
 
   /**
    * The colours found for this component (already calculated during
@@ -52,6 +63,12 @@ class BruteForceColouring {
    */
   const std::map<std::size_t, std::size_t>& get_colours() const;
 
+  /**
+   * Whether the deadline passed, so that the colours are a greedy colouring
+   * which need not use the fewest colours.
+   */
+  bool timed_out() const;
+
   ~BruteForceColouring();
 
  private:
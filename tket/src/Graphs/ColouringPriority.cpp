@@ -14,6 +14,7 @@
 
 #include "ColouringPriority.hpp"
 
+#include <cstdint>
 #include <sstream>
 #include <stdexcept>
 
@@ -99,6 +100,22 @@ static void fill_initial_node_sequence(
 // Fills in "earlier_neighbour_node_indices".
 static void fill_node_dependencies(
     ColouringPriority::Nodes& nodes, const AdjacencyData& adjacency_data) {
+  if (adjacency_data.is_dense()) {
+    // Test the bits directly, rather than checking the vertices every time.
+    for (size_t node_index = 1; node_index < nodes.size(); ++node_index) {
+      auto& this_node = nodes[node_index];
+      const std::uint64_t* row =
+          adjacency_data.get_neighbour_bits(this_node.vertex);
+
+      for (size_t other_index = 0; other_index < node_index; ++other_index) {
+        const size_t other_v = nodes[other_index].vertex;
+        if ((row[other_v / 64] >> (other_v % 64)) & 1) {
+          this_node.earlier_neighbour_node_indices.emplace_back(other_index);
+        }
+      }
+    }
+    return;
+  }
   for (size_t node_index = 1; node_index < nodes.size(); ++node_index) {
     auto& this_node = nodes[node_index];
 
@@ -15,20 +15,29 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <boost/functional/hash.hpp>
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/range/iterator_range_core.hpp>
+#include <cstdint>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "Graphs/AbstractGraph.hpp"
 #include "Graphs/TreeSearch.hpp"
 #include "Graphs/Utils.hpp"
 #include "Utils/GraphHeaders.hpp"
+#include "Utils/Parallel.hpp"
 
 namespace tket::graphs {
 
@@ -364,6 +373,197 @@ class DirectedGraphBase : public AbstractGraph<T> {
   vertex_bimap node_to_vertex;
 };
 
+/**
+ * Dense table of the distances between all pairs of nodes of a graph.
+ *
+ * Nodes are numbered from 0, and the distance between nodes i and j is a
+ * single load from a flat array. The table is immutable once built, so it may
+ * be shared between copies of a graph and read from several threads at once.
+ *
+ * @tparam T node type
+ */
+template <typename T>
+class DistanceMatrix {
+ public:
+  /** Type of each entry; 0 means the nodes are equal or disconnected */
+  using entry_t = std::uint16_t;
+
+  /**
+   * Construct from the nodes and the row-major table of their distances.
+   *
+   * @param nodes the nodes, in index order
+   * @param dists \f$ n^2 \f$ distances, where n is the number of nodes
+   */
+  DistanceMatrix(std::vector<T> nodes, std::vector<entry_t> dists)
+      : nodes_(std::move(nodes)), dists_(std::move(dists)), diameter_(0) {
+    const unsigned n = nodes_.size();
+    index_.reserve(n);
+    for (unsigned i = 0; i < n; i++) {
+      index_.insert({nodes_[i], i});
+    }
+    for (unsigned i = 0; i < n; i++) {
+      for (unsigned j = 0; j < n; j++) {
+        const unsigned d = (*this)(i, j);
+        if (d == 0 && i != j && !disconnected_) {
+          disconnected_ = {i, j};
+        }
+        if (d > diameter_) diameter_ = d;
+      }
+    }
+  }
+
+  /** Number of nodes. */
+  unsigned n_nodes() const { return nodes_.size(); }
+
+  /** Index of a node. */
+  unsigned index(const T& node) const {
+    auto it = index_.find(node);
+    if (it == index_.end()) {
+      throw NodeDoesNotExistError(
+          "Node " + node.repr() + " is not in the distance matrix");
+    }
+    return it->second;
+  }
+
+  /** Node with a given index. */
+  const T& node(unsigned i) const { return nodes_.at(i); }
+
+  /** Distance between the nodes with indices i and j, 0 if disconnected. */
+  unsigned operator()(unsigned i, unsigned j) const {
+    return dists_[std::size_t{i} * nodes_.size() + j];
+  }
+
+  /** Distance between two connected nodes. */
+  unsigned get_distance(const T& node1, const T& node2) const {
+    if (node1 == node2) {
+      return 0;
+    }
+    const unsigned d = (*this)(index(node1), index(node2));
+    if (d == 0) {
+      throw NodesNotConnected(node1, node2);
+    }
+    return d;
+  }
+
+  /** Greatest distance between two nodes of a connected graph. */
+  unsigned get_diameter() const {
+    if (nodes_.empty()) {
+      throw std::logic_error("Graph is empty.");
+    }
+    if (disconnected_) {
+      throw NodesNotConnected(
+          nodes_[disconnected_->first], nodes_[disconnected_->second]);
+    }
+    return diameter_;
+  }
+
+ private:
+  std::vector<T> nodes_;
+  std::unordered_map<T, unsigned, boost::hash<T>> index_;
+  std::vector<entry_t> dists_;
+  unsigned diameter_;
+  std::optional<std::pair<unsigned, unsigned>> disconnected_;
+};
+
+/**
+ * Compiled view of the connectivity of a graph.
+ *
+ * Nodes are numbered from 0. Whether there is an edge from node i to node j is
+ * a single bit test, and the neighbours of each node, in either direction,
+ * are a contiguous run of indices listed in node order. Like
+ * \ref DistanceMatrix, the view is immutable once built, so it may be shared
+ * between copies of a graph and read from several threads at once.
+ *
+ * @tparam T node type
+ */
+template <typename T>
+class ConnectivityView {
+ public:
+  using neighbour_range =
+      boost::iterator_range<std::vector<unsigned>::const_iterator>;
+
+  /**
+   * Construct from the nodes and the directed edges between them.
+   *
+   * @param nodes the nodes, in index order
+   * @param edges pairs of (source, target) indices
+   */
+  ConnectivityView(
+      std::vector<T> nodes,
+      const std::vector<std::pair<unsigned, unsigned>>& edges)
+      : nodes_(std::move(nodes)),
+        words_per_row_((nodes_.size() + 63) / 64),
+        bits_(nodes_.size() * words_per_row_, 0),
+        row_start_(nodes_.size() + 1, 0) {
+    const unsigned n = nodes_.size();
+    index_.reserve(n);
+    for (unsigned i = 0; i < n; i++) {
+      index_.insert({nodes_[i], i});
+    }
+    std::vector<std::vector<unsigned>> rows(n);
+    for (const auto& [i, j] : edges) {
+      if (!edge_exists(i, j) && !edge_exists(j, i)) {
+        rows[i].push_back(j);
+        rows[j].push_back(i);
+      }
+      bits_[i * words_per_row_ + j / 64] |= std::uint64_t{1} << (j % 64);
+    }
+    for (unsigned i = 0; i < n; i++) {
+      std::sort(rows[i].begin(), rows[i].end(), [this](unsigned a, unsigned b) {
+        return nodes_[a] < nodes_[b];
+      });
+      row_start_[i + 1] = row_start_[i] + rows[i].size();
+      neighbours_.insert(neighbours_.end(), rows[i].begin(), rows[i].end());
+    }
+  }
+
+  /** Number of nodes. */
+  unsigned n_nodes() const { return nodes_.size(); }
+
+  /** Index of a node. */
+  unsigned index(const T& node) const {
+    auto it = index_.find(node);
+    if (it == index_.end()) {
+      throw NodeDoesNotExistError(
+          "Node " + node.repr() + " is not in the connectivity view");
+    }
+    return it->second;
+  }
+
+  /** Node with a given index. */
+  const T& node(unsigned i) const { return nodes_.at(i); }
+
+  /** Whether there is an edge from node i to node j. */
+  bool edge_exists(unsigned i, unsigned j) const {
+    return (bits_[i * words_per_row_ + j / 64] >> (j % 64)) & 1;
+  }
+
+  /** Whether there is an edge between nodes i and j in either direction. */
+  bool connected(unsigned i, unsigned j) const {
+    return edge_exists(i, j) || edge_exists(j, i);
+  }
+
+  /** Whether there is an edge from one node to another. */
+  bool edge_exists(const T& node1, const T& node2) const {
+    return edge_exists(index(node1), index(node2));
+  }
+
+  /** Indices of the neighbours of node i, in either direction. */
+  neighbour_range neighbours(unsigned i) const {
+    return {
+        neighbours_.begin() + row_start_[i],
+        neighbours_.begin() + row_start_[i + 1]};
+  }
+
+ private:
+  std::vector<T> nodes_;
+  std::unordered_map<T, unsigned, boost::hash<T>> index_;
+  std::size_t words_per_row_;
+  std::vector<std::uint64_t> bits_;
+  std::vector<unsigned> row_start_;
+  std::vector<unsigned> neighbours_;
+};
+
 /**
  * DirectedGraph instances are directed graphs. It is a wrapper around a
  * BGL graph that provides a clean class API, taking care of mapping all BGL
@@ -375,6 +575,15 @@ class DirectedGraphBase : public AbstractGraph<T> {
  * All functionality for this class is implemented in the base class
  * DirectedGraphBase. This class only adds caching of some function calls for
  * efficiency, invalidating cache in case of changes on the underlying graph.
+ *
+ * Distances are cached one root at a time as they are queried. Alternatively
+ * \ref precompute_distances fills a \ref DistanceMatrix for all pairs at
+ * once, after which distance queries only read the matrix.
+ * \ref compile_connectivity similarly builds a \ref ConnectivityView, which
+ * \ref edge_exists then reads instead of the BGL graph.
+ *
+ * The caches are guarded by a mutex, so const methods may be called from
+ * several threads at once. Copies share the matrix and the view.
  */
 template <typename T>
 class DirectedGraph : public DirectedGraphBase<T> {
@@ -392,29 +601,58 @@ class DirectedGraph : public DirectedGraphBase<T> {
   using Connection = typename Base::Connection;
   using Vertex = typename Base::Vertex;
 
+  DirectedGraph() = default;
+
+  DirectedGraph(const DirectedGraph& other) : Base(other) {
+    std::lock_guard<std::mutex> lock(other.cache_mutex_);
+    copy_cache(other);
+  }
+
+  DirectedGraph& operator=(const DirectedGraph& other) {
+    if (this == &other) return *this;
+    Base::operator=(other);
+    std::scoped_lock lock(cache_mutex_, other.cache_mutex_);
+    copy_cache(other);
+    return *this;
+  }
+
   /**
    * Get all distances between nodes.
    */
   const std::vector<std::size_t>& get_distances(const T& root) const& {
-    // We cache distances. A value of zero in the cache implies that the nodes
-    // are disconnected (unless they are equal).
-    if (distance_cache.find(root) == distance_cache.end()) {
-      distance_cache[root] = Base::get_distances(root);
-    }
-    return distance_cache[root];
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return cached_distances(root);
   }
 
   /**
    * Get all distances between nodes.
    */
   std::vector<std::size_t>&& get_distances(const T& root) const&& {
-    if (distance_cache.find(root) == distance_cache.end()) {
-      distance_cache[root] = Base::get_distances(root);
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return std::move(cached_distances(root));
+  }
+
+  bool edge_exists(const T& node1, const T& node2) const override {
+    std::shared_ptr<const ConnectivityView<T>> view;
+    {
+      std::lock_guard<std::mutex> lock(cache_mutex_);
+      view = connectivity_view;
     }
-    return std::move(distance_cache[root]);
+    if (view) {
+      if (!node_exists(node1) || !node_exists(node2)) {
+        throw NodeDoesNotExistError(
+            "The nodes passed to DirectedGraph::edge_exists must exist");
+      }
+      return view->edge_exists(node1, node2);
+    }
+    return Base::edge_exists(node1, node2);
   }
 
   unsigned get_distance(const T& node1, const T& node2) const override {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (distance_matrix) {
+      return distance_matrix->get_distance(node1, node2);
+    }
     if (node1 == node2) {
       return 0;
     }
@@ -424,8 +662,7 @@ class DirectedGraph : public DirectedGraphBase<T> {
     } else if (distance_cache.find(node2) != distance_cache.end()) {
       d = distance_cache[node2][this->to_vertices(node1)];
     } else {
-      distance_cache[node1] = Base::get_distances(node1);
-      d = distance_cache[node1][this->to_vertices(node2)];
+      d = cached_distances(node1)[this->to_vertices(node2)];
     }
     if (d == 0) {
       throw NodesNotConnected(node1, node2);
@@ -434,6 +671,14 @@ class DirectedGraph : public DirectedGraphBase<T> {
   }
 
   unsigned get_diameter() const override {
+    std::shared_ptr<const DistanceMatrix<T>> matrix;
+    {
+      std::lock_guard<std::mutex> lock(cache_mutex_);
+      matrix = distance_matrix;
+    }
+    if (matrix) {
+      return matrix->get_diameter();
+    }
     unsigned N = n_nodes();
     if (N == 0) {
       throw std::logic_error("Graph is empty.");
@@ -449,6 +694,93 @@ class DirectedGraph : public DirectedGraphBase<T> {
     return max;
   }
 
+  /**
+   * Compute the distances between all pairs of nodes, if not already done.
+   *
+   * Subsequent calls to \ref get_distance and \ref get_diameter read the
+   * resulting \ref DistanceMatrix until the graph is next modified. Copies
+   * of the graph share the matrix.
+   */
+  void precompute_distances() const {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (distance_matrix) return;
+    const UndirectedConnGraph& undirected = cached_undirected_connectivity();
+    const unsigned n = n_nodes();
+    std::vector<T> nodes(n);
+    for (unsigned v = 0; v < n; v++) {
+      nodes[v] = this->get_node(v);
+    }
+    std::vector<typename DistanceMatrix<T>::entry_t> dists(
+        std::size_t{n} * n);
+    std::atomic<bool> overflow = false;
+    parallel_for(0, n, 16, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t v = begin; v < end; v++) {
+        const std::vector<std::size_t> row = run_bfs(v, undirected).get_dists();
+        for (unsigned u = 0; u < n; u++) {
+          if (row[u] > std::numeric_limits<
+                           typename DistanceMatrix<T>::entry_t>::max()) {
+            overflow = true;
+          }
+          dists[v * n + u] = row[u];
+        }
+      }
+    });
+    if (overflow) {
+      throw std::logic_error("Graph too large for a dense distance matrix");
+    }
+    distance_matrix = std::make_shared<const DistanceMatrix<T>>(
+        std::move(nodes), std::move(dists));
+  }
+
+  /**
+   * All-pairs distance matrix, computed if not already done.
+   *
+   * The matrix stays valid after the graph is modified, but then describes
+   * the graph as it was.
+   */
+  std::shared_ptr<const DistanceMatrix<T>> get_distance_matrix() const {
+    precompute_distances();
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return distance_matrix;
+  }
+
+  /**
+   * Build the connectivity view of the graph, if not already done.
+   *
+   * Subsequent calls to \ref edge_exists read the resulting
+   * \ref ConnectivityView until the graph is next modified. Copies of the
+   * graph share the view.
+   */
+  void compile_connectivity() const {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (connectivity_view) return;
+    const unsigned n = n_nodes();
+    std::vector<T> nodes(n);
+    for (unsigned v = 0; v < n; v++) {
+      nodes[v] = this->get_node(v);
+    }
+    std::vector<std::pair<unsigned, unsigned>> edges;
+    for (auto [it, end] = boost::edges(this->graph); it != end; ++it) {
+      edges.push_back(
+          {static_cast<unsigned>(boost::source(*it, this->graph)),
+           static_cast<unsigned>(boost::target(*it, this->graph))});
+    }
+    connectivity_view = std::make_shared<const ConnectivityView<T>>(
+        std::move(nodes), edges);
+  }
+
+  /**
+   * Connectivity view, built if not already done.
+   *
+   * The view stays valid after the graph is modified, but then describes the
+   * graph as it was.
+   */
+  std::shared_ptr<const ConnectivityView<T>> get_connectivity_view() const {
+    compile_connectivity();
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return connectivity_view;
+  }
+
   /** Returns all nodes at a given distance from a given 'source' node */
   std::vector<T> nodes_at_distance(const T& root, std::size_t distance) const {
     auto dists = get_distances(root);
@@ -463,19 +795,15 @@ class DirectedGraph : public DirectedGraphBase<T> {
 
   /** Return an unweighted undirected graph with the same connectivity. */
   const UndirectedConnGraph& get_undirected_connectivity() const& {
-    // we cache the undirected graph
-    if (!undir_graph) {
-      undir_graph = Base::get_undirected_connectivity();
-    }
-    return undir_graph.value();
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return cached_undirected_connectivity();
   }
 
   /** Return an unweighted undirected graph with the same connectivity. */
   UndirectedConnGraph&& get_undirected_connectivity() const&& {
-    if (!undir_graph) {
-      undir_graph = Base::get_undirected_connectivity();
-    }
-    return std::move(undir_graph.value());
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    cached_undirected_connectivity();
+    return std::move(*undir_graph);
   }
 
   // The following functions invalidate caching.
@@ -504,6 +832,37 @@ class DirectedGraph : public DirectedGraphBase<T> {
     Base::add_connection(node1, node2, weight);
   }
 
+  /**
+   * Add a new node together with edges between it and existing nodes.
+   *
+   * If the distances have been precomputed, the matrix is extended to the
+   * new node rather than searched again, in time quadratic in the number of
+   * nodes: a shortest path through the new node enters and leaves it by its
+   * neighbours, and any other shortest path is unchanged.
+   *
+   * @param node node to add, which must not be in the graph
+   * @param connections edges to add, each with `node` as one end
+   */
+  void add_node_with_connections(
+      const T& node, const std::vector<Connection>& connections) {
+    if (node_exists(node)) {
+      throw std::logic_error(
+          "The node passed to DirectedGraph::add_node_with_connections must "
+          "be new");
+    }
+    std::shared_ptr<const DistanceMatrix<T>> old_matrix;
+    {
+      std::lock_guard<std::mutex> lock(cache_mutex_);
+      old_matrix = distance_matrix;
+      invalidate_cache();
+    }
+    Base::add_node(node);
+    for (const Connection& conn : connections) {
+      Base::add_connection(conn.first, conn.second);
+    }
+    if (old_matrix) extend_distances(*old_matrix, node);
+  }
+
   /** Remove an edge. */
   void remove_connection(const Connection& edge) {
     invalidate_cache();
@@ -516,12 +875,228 @@ class DirectedGraph : public DirectedGraphBase<T> {
     Base::remove_connection(node1, node2);
   }
 
+ protected:
+  /**
+   * Make this graph, which must be empty, the subgraph of another induced by
+   * some of its nodes.
+   *
+   * Vertices are numbered in the order of `nodes`, and the edges are copied
+   * from the adjacency of `parent` through a dense remapping of its vertices,
+   * in time linear in their number. Nodes not in `parent` are added without
+   * edges.
+   *
+   * If the distances of `parent` have been precomputed, so are those of the
+   * subgraph, derived from them: a row of the parent's matrix is kept, as
+   * restricted to the subgraph, if each of its nodes at distance d > 0 from
+   * the root has a neighbour in the subgraph at distance d - 1, so that a
+   * shortest path survives. Only the other rows are searched again.
+   */
+  void build_induced_subgraph(
+      const DirectedGraph& parent, const std::vector<T>& nodes) {
+    static constexpr unsigned absent = std::numeric_limits<unsigned>::max();
+    // Index in this graph of each vertex of the parent, and conversely
+    std::vector<unsigned> to_sub(boost::num_vertices(parent.graph), absent);
+    std::vector<unsigned> from_sub;
+    from_sub.reserve(nodes.size());
+    for (const T& node : nodes) {
+      if (node_exists(node)) continue;
+      Base::add_node(node);
+      auto found = parent.to_vertices().find(node);
+      if (found == parent.to_vertices().end()) {
+        from_sub.push_back(absent);
+      } else {
+        to_sub[found->second] = from_sub.size();
+        from_sub.push_back(found->second);
+      }
+    }
+    // In the order of the parent's edges
+    for (Vertex u = 0; u < to_sub.size(); u++) {
+      if (to_sub[u] == absent) continue;
+      for (auto [it, end] = boost::out_edges(u, parent.graph); it != end;
+           ++it) {
+        const Vertex v = boost::target(*it, parent.graph);
+        if (to_sub[v] == absent) continue;
+        boost::add_edge(to_sub[u], to_sub[v], parent.graph[*it], this->graph);
+      }
+    }
+
+    std::shared_ptr<const DistanceMatrix<T>> parent_matrix;
+    {
+      std::lock_guard<std::mutex> lock(parent.cache_mutex_);
+      parent_matrix = parent.distance_matrix;
+    }
+    if (parent_matrix) derive_distances(*parent_matrix, from_sub);
+  }
+
  private:
   inline void invalidate_cache() {
     distance_cache.clear();
+    distance_matrix.reset();
+    connectivity_view.reset();
     undir_graph = std::nullopt;
   }
+
+  // The cached functions below must be called with `cache_mutex_` held.
+
+  // Distances from `root`, computed on the cached undirected graph. A value
+  // of zero implies that the nodes are disconnected (unless they are equal).
+  std::vector<std::size_t>& cached_distances(const T& root) const {
+    typename std::map<T, std::vector<std::size_t>>::iterator it =
+        distance_cache.find(root);
+    if (it != distance_cache.end()) return it->second;
+    if (!node_exists(root)) {
+      throw NodeDoesNotExistError(
+          "Trying to get distances from non-existent root vertex");
+    }
+    std::vector<std::size_t> dists =
+        run_bfs(this->to_vertices(root), cached_undirected_connectivity())
+            .get_dists();
+    return distance_cache.emplace(root, std::move(dists)).first->second;
+  }
+
+  const UndirectedConnGraph& cached_undirected_connectivity() const {
+    if (!undir_graph) {
+      undir_graph = Base::get_undirected_connectivity();
+    }
+    return *undir_graph;
+  }
+
+  // Fill the distance matrix of an induced subgraph from that of its parent,
+  // the parent's matrix index of each vertex being given (or the maximum
+  // unsigned value for vertices not in the parent).
+  void derive_distances(
+      const DistanceMatrix<T>& parent_matrix,
+      const std::vector<unsigned>& from_parent) {
+    using entry_t = typename DistanceMatrix<T>::entry_t;
+    const unsigned n = n_nodes();
+    // Distances in the subgraph are less than n, so fit in the entries
+    if (n > std::numeric_limits<entry_t>::max()) return;
+    static constexpr unsigned absent = std::numeric_limits<unsigned>::max();
+    const std::shared_ptr<const ConnectivityView<T>> view =
+        get_connectivity_view();
+    std::vector<T> nodes(n);
+    for (unsigned v = 0; v < n; v++) {
+      nodes[v] = this->get_node(v);
+    }
+    std::vector<entry_t> dists(std::size_t{n} * n, 0);
+    parallel_for(0, n, 16, [&](std::size_t begin, std::size_t end) {
+      std::vector<unsigned> queue;
+      for (std::size_t r = begin; r < end; r++) {
+        entry_t* row = &dists[r * n];
+        const unsigned pr = from_parent[r];
+        bool valid = pr != absent;
+        for (unsigned v = 0; valid && v < n; v++) {
+          const unsigned pv = from_parent[v];
+          if (v == r || pv == absent) continue;
+          const unsigned d = parent_matrix(pr, pv);
+          if (d == 0) continue;
+          bool has_parent = false;
+          for (unsigned u : view->neighbours(v)) {
+            const unsigned pu = from_parent[u];
+            if ((d == 1) ? u == r
+                         : (pu != absent && parent_matrix(pr, pu) == d - 1)) {
+              has_parent = true;
+              break;
+            }
+          }
+          valid = has_parent;
+        }
+        if (valid) {
+          for (unsigned v = 0; v < n; v++) {
+            if (from_parent[v] != absent) {
+              row[v] = parent_matrix(pr, from_parent[v]);
+            }
+          }
+          continue;
+        }
+        // Breadth-first search; 0 marks nodes not reached, as in the matrix
+        queue.assign(1, r);
+        for (std::size_t i = 0; i < queue.size(); i++) {
+          const unsigned u = queue[i];
+          for (unsigned v : view->neighbours(u)) {
+            if (v == r || row[v] != 0) continue;
+            row[v] = row[u] + 1;
+            queue.push_back(v);
+          }
+        }
+      }
+    });
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    distance_matrix = std::make_shared<const DistanceMatrix<T>>(
+        std::move(nodes), std::move(dists));
+  }
+
+  // Fill the distance matrix from that of the graph before `node` was added
+  // with its edges, relaxing each old distance through the new node.
+  void extend_distances(const DistanceMatrix<T>& old_matrix, const T& node) {
+    using entry_t = typename DistanceMatrix<T>::entry_t;
+    const unsigned n = n_nodes();
+    if (n > std::numeric_limits<entry_t>::max()) return;
+    static constexpr unsigned absent = std::numeric_limits<unsigned>::max();
+    const Vertex new_v = this->to_vertices(node);
+    std::vector<T> nodes(n);
+    // Index in the old matrix of each vertex
+    std::vector<unsigned> from_old(n, absent);
+    for (unsigned v = 0; v < n; v++) {
+      nodes[v] = this->get_node(v);
+      if (v != new_v) from_old[v] = old_matrix.index(nodes[v]);
+    }
+    // Old indices of the neighbours of the new node, in either direction
+    std::vector<unsigned> neighbours;
+    for (auto [it, end] = boost::out_edges(new_v, this->graph); it != end;
+         ++it) {
+      neighbours.push_back(from_old[boost::target(*it, this->graph)]);
+    }
+    for (auto [it, end] = boost::in_edges(new_v, this->graph); it != end;
+         ++it) {
+      neighbours.push_back(from_old[boost::source(*it, this->graph)]);
+    }
+    // Distances from the new node; 0 marks nodes not reached
+    std::vector<unsigned> through(n, 0);
+    for (unsigned v = 0; v < n; v++) {
+      if (v == new_v) continue;
+      const unsigned ov = from_old[v];
+      for (unsigned u : neighbours) {
+        const unsigned d = (u == ov) ? 0 : old_matrix(u, ov);
+        if (d == 0 && u != ov) continue;
+        if (through[v] == 0 || d + 1 < through[v]) through[v] = d + 1;
+      }
+    }
+    std::vector<entry_t> dists(std::size_t{n} * n, 0);
+    for (unsigned v = 0; v < n; v++) {
+      entry_t* row = &dists[std::size_t{v} * n];
+      if (v == new_v) {
+        for (unsigned u = 0; u < n; u++) row[u] = through[u];
+        continue;
+      }
+      row[new_v] = through[v];
+      for (unsigned u = 0; u < n; u++) {
+        if (u == v || u == new_v) continue;
+        unsigned d = old_matrix(from_old[v], from_old[u]);
+        if (through[v] != 0 && through[u] != 0) {
+          const unsigned via = through[v] + through[u];
+          if (d == 0 || via < d) d = via;
+        }
+        row[u] = d;
+      }
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    distance_matrix = std::make_shared<const DistanceMatrix<T>>(
+        std::move(nodes), std::move(dists));
+  }
+
+  void copy_cache(const DirectedGraph& other) {
+    distance_cache = other.distance_cache;
+    distance_matrix = other.distance_matrix;
+    connectivity_view = other.connectivity_view;
+    undir_graph = other.undir_graph;
+  }
+
+  // Guards the caches, so that const methods may be called concurrently
+  mutable std::mutex cache_mutex_;
   mutable std::map<T, std::vector<std::size_t>> distance_cache;
+  mutable std::shared_ptr<const DistanceMatrix<T>> distance_matrix;
+  mutable std::shared_ptr<const ConnectivityView<T>> connectivity_view;
   mutable std::optional<UndirectedConnGraph> undir_graph;
 };
 
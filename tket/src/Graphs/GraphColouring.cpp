@@ -15,6 +15,9 @@
 #include "GraphColouring.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <limits>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <stdexcept>
@@ -24,6 +27,7 @@
 #include "ColouringPriority.hpp"
 #include "GraphRoutines.hpp"
 #include "LargeCliquesResult.hpp"
+#include "Utils/Parallel.hpp"
 
 using std::exception;
 using std::map;
@@ -57,35 +61,39 @@ GraphColouringResult::GraphColouringResult(const vector<std::size_t>& _colours)
   }
 }
 
-// Also updates the number of colours used in "result".
-static void colour_single_component(
+// Nodes of the clique search per component: enough to prove the maximum for
+// most graphs, while bounding the time spent on the rest. Any clique gives a
+// valid lower bound.
+static constexpr std::size_t max_clique_search_nodes = 100000;
+
+// Colours a component with at least "number_of_colours" colours, writing
+// them into "colours". Returns whether the colouring is exact.
+static bool colour_single_component(
     const AdjacencyData& adjacency_data,
     const vector<set<std::size_t>>& connected_components,
     const vector<set<std::size_t>>& cliques, std::size_t component_index,
-    GraphColouringResult& result) {
-  result.number_of_colours =
-      std::max(result.number_of_colours, cliques[component_index].size());
-
+    std::size_t number_of_colours,
+    std::optional<std::chrono::steady_clock::time_point> deadline,
+    vector<std::size_t>& colours) {
   const ColouringPriority colouring_priority(
       adjacency_data, connected_components[component_index],
       cliques[component_index]);
 
   const BruteForceColouring brute_force_colouring(
-      colouring_priority, result.number_of_colours);
+      colouring_priority, number_of_colours, deadline);
 
   const auto& partial_colour_map = brute_force_colouring.get_colours();
 
   for (const auto& entry : partial_colour_map) {
     const auto& vertex = entry.first;
     const auto& colour = entry.second;
-    result.number_of_colours = std::max(result.number_of_colours, colour + 1);
 
     try {
-      if (vertex >= result.colours.size()) {
+      if (vertex >= colours.size()) {
         throw runtime_error("illegal vertex index");
       }
-      auto& colour_to_assign = result.colours[vertex];
-      if (colour_to_assign < result.colours.size()) {
+      auto& colour_to_assign = colours[vertex];
+      if (colour_to_assign < colours.size()) {
         stringstream ss;
         ss << "colour already assigned! Existing colour " << colour_to_assign;
         throw runtime_error(ss.str());
@@ -99,6 +107,7 @@ static void colour_single_component(
       throw runtime_error(ss.str());
     }
   }
+  return !brute_force_colouring.timed_out();
 }
 
 // Check that everything was coloured,
@@ -119,47 +128,56 @@ static void check_final_colouring(GraphColouringResult& result) {
 }
 
 GraphColouringResult GraphColouringRoutines::get_colouring(
-    const AdjacencyData& adjacency_data) {
+    const AdjacencyData& adjacency_data, unsigned max_time_ms) {
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+  if (max_time_ms != 0) {
+    deadline = std::chrono::steady_clock::now() +
+               std::chrono::milliseconds(max_time_ms);
+  }
   const auto connected_components =
       GraphRoutines::get_connected_components(adjacency_data);
-  vector<set<std::size_t>> cliques(connected_components.size());
-  vector<std::size_t> component_indices(connected_components.size());
+  const std::size_t n_components = connected_components.size();
+  vector<set<std::size_t>> cliques(n_components);
 
   try {
-    for (std::size_t i = 0; i < connected_components.size(); ++i) {
-      const LargeCliquesResult cliques_in_this_component(
-          adjacency_data, connected_components[i]);
-
-      if (cliques_in_this_component.cliques.empty()) {
-        stringstream ss;
-        ss << "component " << i << " has " << connected_components[i].size()
-           << " vertices, but couldn't find a clique!";
-        throw runtime_error(ss.str());
+    parallel_for(0, n_components, 1, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i) {
+        const MaxCliqueResult clique_in_this_component(
+            adjacency_data, connected_components[i], max_clique_search_nodes);
+
+        if (clique_in_this_component.clique.empty()) {
+          stringstream ss;
+          ss << "component " << i << " has " << connected_components[i].size()
+             << " vertices, but couldn't find a clique!";
+          throw runtime_error(ss.str());
+        }
+        cliques[i] = clique_in_this_component.clique;
       }
-      cliques[i] = cliques_in_this_component.cliques[0];
-      component_indices[i] = i;
-    }
+    });
 
-    // Now, we might as well start with the component containing the LARGEST
-    // clique first (since, colouring becomes easier with more colours, and once
-    // we've coloured one component, no point in trying to colour the others
-    // with fewer colours).
-    std::sort(
-        component_indices.begin(), component_indices.end(),
-        [&cliques](std::size_t lhs, std::size_t rhs) {
-          return cliques[lhs].size() > cliques[rhs].size();
-        });
+    // The whole graph needs at least as many colours as the largest clique,
+    // so there is no point in trying to colour any component with fewer.
+    std::size_t number_of_colours = 0;
+    for (const auto& clique : cliques) {
+      number_of_colours = std::max(number_of_colours, clique.size());
+    }
 
     GraphColouringResult result;
     result.colours.assign(
         adjacency_data.get_number_of_vertices(),
         std::numeric_limits<std::size_t>::max());
 
-    for (auto component_index : component_indices) {
-      colour_single_component(
-          adjacency_data, connected_components, cliques, component_index,
-          result);
-    }
+    // Components are disjoint, so each writes its own entries of "colours".
+    vector<char> exact(n_components, 1);
+    parallel_for(0, n_components, 1, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i) {
+        exact[i] = colour_single_component(
+            adjacency_data, connected_components, cliques, i,
+            number_of_colours, deadline, result.colours);
+      }
+    });
+    result.is_exact =
+        std::all_of(exact.cbegin(), exact.cend(), [](char e) { return e; });
     check_final_colouring(result);
     return result;
   } catch (const exception& e) {
@@ -43,6 +43,12 @@ struct GraphColouringResult {
    */
   std::vector<std::size_t> colours;
 
+  /**
+   * False if the time limit was reached, so that some component was given a
+   * greedy colouring and the number of colours need not be minimal.
+   */
+  bool is_exact = true;
+
   GraphColouringResult();
 
   /**
@@ -59,10 +65,18 @@ struct GraphColouringResult {
 struct GraphColouringRoutines {
   /**
    * The main end-to-end colouring function.
+   *
+   * Connected components are coloured in parallel (see \ref parallel_for),
+   * each allowed at least as many colours as the largest clique found in
+   * any component. The result does not depend on the number of threads.
+   *
    * @param adjacency_data The graph to be coloured.
+   * @param max_time_ms If nonzero, a wall-clock limit in milliseconds;
+   *  components whose exact colouring is not finished in time get a greedy
+   *  colouring instead.
    */
   static GraphColouringResult get_colouring(
-      const AdjacencyData& adjacency_data);
+      const AdjacencyData& adjacency_data, unsigned max_time_ms = 0);
 };
 
 }  // namespace graphs
@@ -14,7 +14,15 @@
 
 #include "LargeCliquesResult.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+
 #include "AdjacencyData.hpp"
+#include "Utils/Parallel.hpp"
 
 using std::set;
 using std::size_t;
@@ -38,6 +46,9 @@ LargeCliquesResult::LargeCliquesResult(
   }
   bool hit_internal_limit = false;
 
+  // For dense graphs: the vertices adjoining every vertex of a clique.
+  vector<std::uint64_t> common_neighbours;
+
   // A little trick: the vertex indices can always be stored in order: v1 < v2 <
   // ... Therefore, within each vertex set, if we only allow adding vertices
   // with LARGER index than the largest already stored, we will automatically
@@ -52,6 +63,37 @@ LargeCliquesResult::LargeCliquesResult(
         hit_internal_limit = true;
         break;
       }
+      if (adjacency_data.is_dense()) {
+        // Intersect the neighbourhoods 64 vertices at a time; the candidates
+        // come out in increasing order, as from the set below.
+        const size_t words = adjacency_data.get_words_per_row();
+        const std::uint64_t* row = adjacency_data.get_neighbour_bits(
+            largest_index);
+        common_neighbours.assign(row, row + words);
+        for (size_t existing_v : clique) {
+          row = adjacency_data.get_neighbour_bits(existing_v);
+          for (size_t k = 0; k < words; ++k) {
+            common_neighbours[k] &= row[k];
+          }
+        }
+        for (size_t k = largest_index / 64; k < words; ++k) {
+          std::uint64_t word = common_neighbours[k];
+          if (k == largest_index / 64) {
+            // Only vertices with larger index than largest_index.
+            word &= ~std::uint64_t{0} << (largest_index % 64) << 1;
+          }
+          while (word != 0 && extended_result.size() < internal_size_limit) {
+            extended_result.emplace_back(clique);
+            extended_result.back().insert(64 * k + std::countr_zero(word));
+            word &= word - 1;
+          }
+          if (extended_result.size() >= internal_size_limit) {
+            hit_internal_limit = true;
+            break;
+          }
+        }
+        continue;
+      }
       // We only have to check the neighbours of ONE vertex to form a larger
       // clique.
       const auto& neighbours = adjacency_data.get_neighbours(largest_index);
@@ -91,5 +133,280 @@ LargeCliquesResult::LargeCliquesResult(
   cliques_are_definitely_max_size = false;
 }
 
+namespace {
+
+// Branch and bound search for a maximum clique in one component.
+//
+// The vertices are relabelled 0, 1, ..., m-1 in a degeneracy order, i.e.
+// repeatedly taking a vertex of least degree among those left, so that each
+// has few neighbours later in the order. The top-level branch for vertex i
+// searches the cliques in which i comes first, i.e. within its later
+// neighbours, which are copied into a small bit matrix for the branch.
+class MaxCliqueSearch {
+ public:
+  MaxCliqueSearch(
+      const AdjacencyData& adjacency_data,
+      const set<size_t>& vertices_in_component, size_t node_budget);
+
+  // Search every top-level branch, on as many threads as are worthwhile.
+  void run();
+
+  set<size_t> get_clique() const;
+  bool stopped() const { return stop_.load(); }
+  size_t nodes() const { return nodes_.load(); }
+
+ private:
+  // One thread's working space: the current branch as a bit matrix, and
+  // candidate sets and colour orderings for each level of its search.
+  struct Scratch {
+    size_t root = 0;
+    vector<size_t> branch_vertices;
+    size_t words = 0;
+    vector<std::uint64_t> rows;
+    vector<vector<std::uint64_t>> candidates;
+    vector<vector<size_t>> order;
+    vector<vector<size_t>> bound;
+    vector<std::uint64_t> uncoloured;
+    vector<std::uint64_t> colour_class;
+
+    const std::uint64_t* row(size_t v) const { return &rows[v * words]; }
+  };
+
+  // Search every clique with vertex i first.
+  void branch(size_t i, Scratch& scratch);
+
+  // Search the extensions of a clique, of the branch root and the given
+  // branch vertices, by the candidates at the given level.
+  void expand(vector<size_t>& clique, size_t level, Scratch& scratch);
+
+  void record(const vector<size_t>& clique, const Scratch& scratch);
+
+  vector<size_t> original_vertex_;
+  // Neighbours of each vertex later in the order, in increasing order
+  vector<vector<size_t>> later_neighbours_;
+  size_t node_budget_;
+
+  std::atomic<size_t> next_branch_{0};
+  std::atomic<size_t> nodes_{0};
+  std::atomic<bool> stop_{false};
+  std::atomic<size_t> best_size_{0};
+  mutable std::mutex best_mutex_;
+  // In original labels
+  set<size_t> best_clique_;
+};
+
+}  // namespace
+
+MaxCliqueSearch::MaxCliqueSearch(
+    const AdjacencyData& adjacency_data,
+    const set<size_t>& vertices_in_component, size_t node_budget)
+    : node_budget_(node_budget) {
+  const size_t m = vertices_in_component.size();
+  if (m == 0) return;
+  const vector<size_t> vertices(
+      vertices_in_component.cbegin(), vertices_in_component.cend());
+  // Component indices of the original vertices, by binary search
+  auto index_of = [&vertices](size_t v) {
+    return size_t(
+        std::lower_bound(vertices.cbegin(), vertices.cend(), v) -
+        vertices.cbegin());
+  };
+
+  // Degeneracy order, with vertices bucketed by their remaining degree.
+  vector<size_t> degree(m);
+  size_t max_degree = 0;
+  for (size_t i = 0; i < m; ++i) {
+    degree[i] = adjacency_data.get_neighbours(vertices[i]).size();
+    max_degree = std::max(max_degree, degree[i]);
+  }
+  vector<vector<size_t>> buckets(max_degree + 1);
+  for (size_t i = 0; i < m; ++i) buckets[degree[i]].push_back(i);
+  constexpr size_t none = std::numeric_limits<size_t>::max();
+  vector<size_t> position(m, none);
+  original_vertex_.reserve(m);
+  size_t d = 0;
+  while (original_vertex_.size() < m) {
+    // Removing a vertex lowers degrees by at most one.
+    d = d > 0 ? d - 1 : 0;
+    while (buckets[d].empty()) ++d;
+    const size_t i = buckets[d].back();
+    buckets[d].pop_back();
+    // Skip stale entries, left behind when a degree was lowered.
+    if (position[i] != none || degree[i] != d) continue;
+    position[i] = original_vertex_.size();
+    original_vertex_.push_back(vertices[i]);
+    for (size_t v : adjacency_data.get_neighbours(vertices[i])) {
+      const size_t j = index_of(v);
+      if (position[j] == none) buckets[--degree[j]].push_back(j);
+    }
+  }
+
+  later_neighbours_.resize(m);
+  for (size_t i = 0; i < m; ++i) {
+    for (size_t v : adjacency_data.get_neighbours(vertices[i])) {
+      const size_t j = index_of(v);
+      if (position[j] > position[i]) {
+        later_neighbours_[position[i]].push_back(position[j]);
+      }
+    }
+    std::sort(
+        later_neighbours_[position[i]].begin(),
+        later_neighbours_[position[i]].end());
+  }
+  best_clique_ = {original_vertex_[0]};
+  best_size_ = 1;
+}
+
+void MaxCliqueSearch::run() {
+  const size_t m = original_vertex_.size();
+  // Each thread keeps taking the next unsearched branch, so that those
+  // finishing early take on the work left. The last vertices in the order
+  // have the densest neighbourhoods, so they go first.
+  auto search = [this, m](size_t, size_t) {
+    Scratch scratch;
+    for (size_t k = next_branch_++; k < m && !stop_; k = next_branch_++) {
+      branch(m - 1 - k, scratch);
+    }
+  };
+  // Small components are not worth starting threads for.
+  const size_t min_vertices_per_thread = 64;
+  if (m < 2 * min_vertices_per_thread) {
+    search(0, 1);
+    return;
+  }
+  const size_t n_threads =
+      std::min<size_t>(get_max_threads(), m / min_vertices_per_thread);
+  parallel_for(0, n_threads, 1, search);
+}
+
+void MaxCliqueSearch::branch(size_t i, Scratch& scratch) {
+  const vector<size_t>& vertices = later_neighbours_[i];
+  const size_t n = vertices.size();
+  if (1 + n <= best_size_) return;
+  scratch.root = i;
+  scratch.branch_vertices = vertices;
+  vector<size_t> clique;
+  if (n == 0) {
+    record(clique, scratch);
+    return;
+  }
+  // Adjacency among the candidates, as a bit matrix.
+  scratch.words = (n + 63) / 64;
+  const size_t words = scratch.words;
+  scratch.rows.assign(n * words, 0);
+  for (size_t a = 0; a < n; ++a) {
+    const vector<size_t>& later = later_neighbours_[vertices[a]];
+    auto it = vertices.cbegin() + a + 1;
+    for (size_t w : later) {
+      it = std::lower_bound(it, vertices.cend(), w);
+      if (it == vertices.cend()) break;
+      if (*it != w) continue;
+      const size_t b = it - vertices.cbegin();
+      scratch.rows[a * words + b / 64] |= std::uint64_t{1} << (b % 64);
+      scratch.rows[b * words + a / 64] |= std::uint64_t{1} << (a % 64);
+    }
+  }
+  if (scratch.candidates.size() < n + 1) {
+    scratch.candidates.resize(n + 1);
+    scratch.order.resize(n + 1);
+    scratch.bound.resize(n + 1);
+  }
+  scratch.uncoloured.resize(words);
+  scratch.colour_class.resize(words);
+  scratch.candidates[0].assign(words, ~std::uint64_t{0});
+  if (n % 64 != 0) scratch.candidates[0].back() >>= 64 - n % 64;
+  expand(clique, 0, scratch);
+}
+
+void MaxCliqueSearch::expand(
+    vector<size_t>& clique, size_t level, Scratch& scratch) {
+  if (node_budget_ > 0 && nodes_ >= node_budget_) {
+    stop_ = true;
+    return;
+  }
+  ++nodes_;
+  const size_t words = scratch.words;
+  vector<std::uint64_t>& candidates = scratch.candidates[level];
+
+  // Colour the candidates greedily: no clique among them can have more
+  // vertices than there are colours, and the vertices are listed by colour.
+  vector<size_t>& order = scratch.order[level];
+  vector<size_t>& bound = scratch.bound[level];
+  order.clear();
+  bound.clear();
+  vector<std::uint64_t>& uncoloured = scratch.uncoloured;
+  vector<std::uint64_t>& colour_class = scratch.colour_class;
+  uncoloured = candidates;
+  for (size_t colour = 1;
+       std::any_of(uncoloured.cbegin(), uncoloured.cend(),
+                   [](std::uint64_t word) { return word != 0; });
+       ++colour) {
+    colour_class = uncoloured;
+    for (size_t k = 0; k < words; ++k) {
+      while (colour_class[k] != 0) {
+        const int b = std::countr_zero(colour_class[k]);
+        const size_t v = 64 * k + b;
+        colour_class[k] &= colour_class[k] - 1;
+        uncoloured[k] &= ~(std::uint64_t{1} << b);
+        const std::uint64_t* r = scratch.row(v);
+        for (size_t j = k; j < words; ++j) colour_class[j] &= ~r[j];
+        order.push_back(v);
+        bound.push_back(colour);
+      }
+    }
+  }
+
+  // The root is in the clique too.
+  const size_t clique_size = 1 + clique.size();
+  vector<std::uint64_t>& next = scratch.candidates[level + 1];
+  next.resize(words);
+  for (size_t idx = order.size(); idx-- > 0;) {
+    if (stop_ || clique_size + bound[idx] <= best_size_) return;
+    const size_t v = order[idx];
+    const std::uint64_t* r = scratch.row(v);
+    bool any = false;
+    for (size_t k = 0; k < words; ++k) {
+      next[k] = candidates[k] & r[k];
+      any = any || next[k] != 0;
+    }
+    clique.push_back(v);
+    if (any) {
+      expand(clique, level + 1, scratch);
+    } else {
+      record(clique, scratch);
+    }
+    clique.pop_back();
+    candidates[v / 64] &= ~(std::uint64_t{1} << (v % 64));
+  }
+}
+
+void MaxCliqueSearch::record(
+    const vector<size_t>& clique, const Scratch& scratch) {
+  const size_t size = 1 + clique.size();
+  if (size <= best_size_) return;
+  const std::lock_guard<std::mutex> lock(best_mutex_);
+  if (size <= best_size_) return;
+  best_clique_ = {original_vertex_[scratch.root]};
+  for (size_t v : clique) {
+    best_clique_.insert(original_vertex_[scratch.branch_vertices[v]]);
+  }
+  best_size_ = size;
+}
+
+set<size_t> MaxCliqueSearch::get_clique() const {
+  const std::lock_guard<std::mutex> lock(best_mutex_);
+  return best_clique_;
+}
+
+MaxCliqueResult::MaxCliqueResult(
+    const AdjacencyData& adjacency_data,
+    const set<size_t>& vertices_in_component, size_t node_budget) {
+  MaxCliqueSearch search(adjacency_data, vertices_in_component, node_budget);
+  search.run();
+  clique = search.get_clique();
+  clique_is_definitely_max_size = !search.stopped();
+  nodes_searched = search.nodes();
+}
+
 }  // namespace graphs
 }  // namespace tket
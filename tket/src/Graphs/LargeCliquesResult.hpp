@@ -57,5 +57,40 @@ struct LargeCliquesResult {
       std::size_t internal_size_limit = 100);
 };
 
+/**
+ * Find a maximum clique in a single connected component of a graph, by
+ * branch and bound.
+ *
+ * The component is copied into a bit matrix, with its vertices ordered by
+ * decreasing degree, and searched with a greedy colouring bound. Each vertex
+ * roots one top-level branch, holding the cliques in which it comes first.
+ * Idle threads take the next unsearched branch, and all share the size of
+ * the best clique found so far to prune with. Unlike
+ * \ref LargeCliquesResult, the work does not grow with the number of large
+ * cliques, only with the size of the search tree.
+ */
+struct MaxCliqueResult {
+  /** The largest clique found; nonempty if the component is. */
+  std::set<std::size_t> clique;
+
+  /** Is the clique guaranteed to be of maximum possible size? */
+  bool clique_is_definitely_max_size = false;
+
+  /** Number of nodes of the search tree visited, over all threads. */
+  std::size_t nodes_searched = 0;
+
+  /**
+   * @param adjacency_data The full graph.
+   * @param vertices_in_component The vertices in the single connected
+   * component we consider here, as for \ref LargeCliquesResult.
+   * @param node_budget If nonzero, the search stops after roughly this many
+   * nodes of the search tree, and the clique might not be of maximum size.
+   */
+  MaxCliqueResult(
+      const AdjacencyData& adjacency_data,
+      const std::set<std::size_t>& vertices_in_component,
+      std::size_t node_budget = 0);
+};
+
 }  // namespace graphs
 }  // namespace tket
@@ -14,11 +14,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <utility>
 #include <vector>
 
 #include "Graphs/TreeSearch_impl.hpp"
 #include "Graphs/Utils.hpp"
+#include "Utils/Parallel.hpp"
 
 /* A wrapper around the BFS and DFS implementation of boost graph. The hope is
  * that this is less awkward (albeit less flexible) to use than the direct boost
@@ -92,24 +95,59 @@ DFS<Graph> run_dfs_with_visitor(
 /* Computes the longest simple path in a graph using DFS
  *
  * This is a naive implementation starting a new search from every
- * possible vertex
+ * possible vertex, and returning the longest root-to-leaf path of any of the
+ * DFS trees (the first found, in vertex order). The search stops early once a
+ * path of at least `cutoff_length` vertices is found, if that is nonzero.
+ *
+ * Roots are searched in blocks, the roots of each block in parallel, each
+ * thread with its own DFS; the result is the same as searching them one by
+ * one. If `budget` (in milliseconds) is nonzero, no new block is started once
+ * it has run out, and the longest path found so far is returned.
  */
 template <typename Graph>
 std::vector<utils::vertex<Graph>> longest_simple_path(
-    const Graph& g, std::size_t cutoff_length = 0) {
-  std::vector<utils::vertex<const Graph>> longest;
-  auto root = boost::vertex(0, g);
-  auto dfs = run_dfs(root, g);
-  for (auto [it, end] = boost::vertices(g); it != end; ++it) {
-    root = *it;
-    dfs.change_root(root);
-    if (dfs.max_depth() + 1 > longest.size()) {
-      longest = dfs.longest_path();
-      if (cutoff_length > 0 && longest.size() >= cutoff_length) {
-        break;
+    const Graph& g, std::size_t cutoff_length = 0, unsigned budget = 0) {
+  using vertex = utils::vertex<const Graph>;
+  const std::size_t n = boost::num_vertices(g);
+  if (n == 0) return {};
+  // Roots per block, and per thread within a block
+  constexpr std::size_t block = 256;
+  constexpr std::size_t min_range = 16;
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::size_t> lengths(block);
+  std::size_t best_root = 0;
+  std::size_t best_length = 0;
+  for (std::size_t first = 0; first < n; first += block) {
+    const std::size_t last = std::min(first + block, n);
+    parallel_for(
+        first, last, min_range, [&](std::size_t begin, std::size_t end) {
+          auto dfs = run_dfs(boost::vertex(begin, g), g);
+          for (std::size_t i = begin; i < end; ++i) {
+            dfs.change_root(boost::vertex(i, g));
+            // Not max_depth() + 1: the deepest vertex may be in another
+            // component, and then there is no path to it.
+            lengths[i - first] = dfs.longest_path().size();
+          }
+        });
+    bool done = false;
+    for (std::size_t i = first; i < last; ++i) {
+      if (lengths[i - first] > best_length) {
+        best_root = i;
+        best_length = lengths[i - first];
+        if (cutoff_length > 0 && best_length >= cutoff_length) {
+          done = true;
+          break;
+        }
       }
     }
+    if (done) break;
+    if (budget > 0 && std::chrono::steady_clock::now() - start >=
+                          std::chrono::milliseconds(budget)) {
+      break;
+    }
   }
+  std::vector<vertex> longest =
+      run_dfs(boost::vertex(best_root, g), g).longest_path();
   return longest;
 }
 
@@ -16,6 +16,49 @@
 
 namespace tket {
 
+// Diagonalises mutually commuting terms over qubits, returning the
+// measurement circuit and, for each term, the bits to XOR together and
+// whether to invert the result
+static Circuit measure_terms(
+    const std::list<QubitPauliString>& terms, const std::set<Qubit>& qubits,
+    CXConfigType cx_config,
+    std::list<std::pair<std::vector<unsigned>, bool>>& results) {
+  std::map<Qubit, unsigned> qb_location_map;
+  unsigned u = 0;
+  for (const Qubit& qb : qubits) {
+    qb_location_map[qb] = u;
+    ++u;
+  }
+
+  std::list<std::pair<QubitPauliTensor, Expr>> gadgets;
+  for (const QubitPauliString& string : terms) {
+    QubitPauliTensor qps(string);
+    gadgets.push_back({qps, 1.});
+  }
+
+  std::set<Qubit> mutable_qb_set(qubits);
+  Circuit cliff_circ = mutual_diagonalise(gadgets, mutable_qb_set, cx_config);
+  unsigned bit_count = 0;
+  for (const Qubit& qb : cliff_circ.all_qubits()) {
+    cliff_circ.add_bit(Bit(bit_count));
+    cliff_circ.add_measure(qb, Bit(bit_count));
+    ++bit_count;
+  }
+
+  results.clear();
+  for (const std::pair<QubitPauliTensor, Expr>& new_gadget : gadgets) {
+    std::vector<unsigned> bits;
+    for (const std::pair<const Qubit, Pauli>& qp_pair :
+         new_gadget.first.string.map) {
+      if (qp_pair.second == Pauli::Z)
+        bits.push_back(qb_location_map.at(qp_pair.first));
+    }
+    bool invert = (std::abs(new_gadget.first.coeff + Complex(1)) < EPS);
+    results.push_back({bits, invert});
+  }
+  return cliff_circ;
+}
+
 MeasurementSetup measurement_reduction(
     const std::list<QubitPauliString>& strings, PauliPartitionStrat strat,
     GraphColourMethod method, CXConfigType cx_config) {
@@ -25,51 +68,67 @@ MeasurementSetup measurement_reduction(
       qubits.insert(qb_p.first);
   }
 
-  std::map<Qubit, unsigned> qb_location_map;
-  unsigned u = 0;
-  for (const Qubit& qb : qubits) {
-    qb_location_map[qb] = u;
-    ++u;
-  }
-
   std::list<std::list<QubitPauliString>> all_terms =
       term_sequence(strings, strat, method);
   MeasurementSetup ms;
   unsigned i = 0;
   for (const std::list<QubitPauliString>& terms : all_terms) {
-    std::list<std::pair<QubitPauliTensor, Expr>> gadgets;
+    std::list<std::pair<std::vector<unsigned>, bool>> results;
+    ms.add_measurement_circuit(
+        measure_terms(terms, qubits, cx_config, results));
+    std::list<std::pair<std::vector<unsigned>, bool>>::const_iterator
+        results_iter = results.begin();
     for (const QubitPauliString& string : terms) {
-      QubitPauliTensor qps(string);
-      gadgets.push_back({qps, 1.});
+      ms.add_result_for_term(
+          string, {i, results_iter->first, results_iter->second});
+      ++results_iter;
     }
+    ++i;
+  }
 
-    std::set<Qubit> mutable_qb_set(qubits);
-    Circuit cliff_circ = mutual_diagonalise(gadgets, mutable_qb_set, cx_config);
-    unsigned bit_count = 0;
-    for (const Qubit& qb : cliff_circ.all_qubits()) {
-      cliff_circ.add_bit(Bit(bit_count));
-      cliff_circ.add_measure(qb, Bit(bit_count));
-      ++bit_count;
-    }
-    ms.add_measurement_circuit(cliff_circ);
+  return ms;
+}
 
-    std::list<std::pair<QubitPauliTensor, Expr>>::const_iterator gadgets_iter =
-        gadgets.begin();
-    for (const QubitPauliString& string : terms) {
-      const std::pair<QubitPauliTensor, Expr>& new_gadget = *gadgets_iter;
-      std::vector<unsigned> bits;
-      for (const std::pair<const Qubit, Pauli>& qp_pair :
-           new_gadget.first.string.map) {
-        if (qp_pair.second == Pauli::Z)
-          bits.push_back(qb_location_map.at(qp_pair.first));
+IncrementalMeasurementReduction::IncrementalMeasurementReduction(
+    PauliPartitionStrat strat, CXConfigType cx_config)
+    : cx_config_(cx_config), partitioner_(strat) {}
+
+void IncrementalMeasurementReduction::add_terms(
+    const std::list<QubitPauliString>& strings) {
+  for (const QubitPauliString& string : strings) {
+    if (!terms_.insert(string).second) continue;
+    unsigned g = partitioner_.add(string);
+    if (g == groups_.size()) groups_.push_back(Group());
+    Group& group = groups_[g];
+    group.terms.push_back(string);
+    group.changed = true;
+  }
+}
+
+MeasurementSetup IncrementalMeasurementReduction::get_setup() {
+  MeasurementSetup ms;
+  unsigned i = 0;
+  for (Group& group : groups_) {
+    if (group.changed) {
+      std::set<Qubit> qubits;
+      for (const QubitPauliString& qpt : group.terms) {
+        for (const std::pair<const Qubit, Pauli>& qb_p : qpt.map)
+          qubits.insert(qb_p.first);
       }
-      bool invert = (std::abs(new_gadget.first.coeff + Complex(1)) < EPS);
-      ms.add_result_for_term(string, {i, bits, invert});
-      ++gadgets_iter;
+      group.circuit =
+          measure_terms(group.terms, qubits, cx_config_, group.results);
+      group.changed = false;
+    }
+    ms.add_measurement_circuit(group.circuit);
+    std::list<std::pair<std::vector<unsigned>, bool>>::const_iterator
+        results_iter = group.results.begin();
+    for (const QubitPauliString& string : group.terms) {
+      ms.add_result_for_term(
+          string, {i, results_iter->first, results_iter->second});
+      ++results_iter;
     }
     ++i;
   }
-
   return ms;
 }
 
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <unordered_set>
+
 #include "Diagonalisation/Diagonalisation.hpp"
 #include "Diagonalisation/PauliPartition.hpp"
 #include "MeasurementSetup.hpp"
@@ -33,4 +35,49 @@ MeasurementSetup measurement_reduction(
     GraphColourMethod method = GraphColourMethod::Lazy,
     CXConfigType cx_config = CXConfigType::Snake);
 
+/**
+ * Builds a MeasurementSetup for a set of terms that grows over time, such
+ * as the operator pool of an adaptive variational algorithm.
+ *
+ * New terms join the first compatible group, as for
+ * GraphColourMethod::Lazy, using a StreamingPauliPartitioner. Only the
+ * groups that gained terms since the last call to \ref get_setup are
+ * diagonalised again, so the cost of an update grows with the number of
+ * new terms rather than the total. Each measurement circuit acts on the
+ * qubits of its own group's terms.
+ */
+class IncrementalMeasurementReduction {
+ public:
+  explicit IncrementalMeasurementReduction(
+      PauliPartitionStrat strat, CXConfigType cx_config = CXConfigType::Snake);
+
+  /** Add terms; terms that have already been added are ignored */
+  void add_terms(const std::list<QubitPauliString>& strings);
+
+  unsigned n_terms() const { return terms_.size(); }
+
+  unsigned n_groups() const { return groups_.size(); }
+
+  /**
+   * Setup measuring every term added so far, with one circuit per group in
+   * order of creation
+   */
+  MeasurementSetup get_setup();
+
+ private:
+  struct Group {
+    std::list<QubitPauliString> terms;
+    // Whether terms were added since the circuit was last built
+    bool changed = true;
+    Circuit circuit;
+    // Bits and inversion for each term, in the order of terms
+    std::list<std::pair<std::vector<unsigned>, bool>> results;
+  };
+
+  CXConfigType cx_config_;
+  StreamingPauliPartitioner partitioner_;
+  std::unordered_set<QubitPauliString, MeasurementSetup::QPSHasher> terms_;
+  std::vector<Group> groups_;
+};
+
 }  // namespace tket
@@ -14,7 +14,14 @@
 
 #include "MeasurementSetup.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
 #include "Converters/Converters.hpp"
+#include "Utils/Parallel.hpp"
 
 namespace tket {
 
@@ -89,6 +96,104 @@ bool MeasurementSetup::verify() const {
   return true;
 }
 
+// Smallest number of shots worth counting in a separate thread
+static const std::size_t min_parallel_shots = 1 << 12;
+
+MeasurementSetup::expectation_map_t MeasurementSetup::expectation_values(
+    const std::vector<packed_shots_t> &shots) const {
+  const unsigned n_circs = measurement_circs.size();
+  if (shots.size() != n_circs) {
+    throw std::invalid_argument(
+        "Expected shots for " + std::to_string(n_circs) +
+        " measurement circuits, got " + std::to_string(shots.size()));
+  }
+  // Distinct sets of bits to take the parity of in each circuit, as masks
+  std::vector<std::map<std::vector<std::uint64_t>, unsigned>> masks(n_circs);
+  // Mask of each MeasurementBitMap, in the iteration order of result_map
+  std::vector<unsigned> bitmap_masks;
+  for (const std::pair<const QubitPauliString, std::vector<MeasurementBitMap>>
+           &term : result_map) {
+    for (const MeasurementBitMap &mbm : term.second) {
+      if (mbm.circ_index >= n_circs) {
+        throw std::invalid_argument(
+            "No measurement circuit " + std::to_string(mbm.circ_index));
+      }
+      const std::size_t n_words = shots[mbm.circ_index].cols();
+      std::vector<std::uint64_t> mask(n_words, 0);
+      for (unsigned bit : mbm.bits) {
+        if (bit / 64 >= n_words) {
+          throw std::invalid_argument(
+              "Bit " + std::to_string(bit) + " is not in the shots of " +
+              "measurement circuit " + std::to_string(mbm.circ_index));
+        }
+        // A repeated bit cancels out of the parity
+        mask[bit / 64] ^= std::uint64_t{1} << (bit % 64);
+      }
+      std::map<std::vector<std::uint64_t>, unsigned> &circ_masks =
+          masks[mbm.circ_index];
+      unsigned index = circ_masks.size();
+      bitmap_masks.push_back(circ_masks.insert({mask, index}).first->second);
+    }
+  }
+  // Number of shots of each circuit with odd parity under each mask
+  std::vector<std::vector<std::size_t>> n_odd(n_circs);
+  for (unsigned c = 0; c < n_circs; ++c) {
+    const packed_shots_t &table = shots[c];
+    const std::size_t n_words = table.cols();
+    const std::size_t n_masks = masks[c].size();
+    n_odd[c].assign(n_masks, 0);
+    if (n_masks == 0) continue;
+    std::vector<std::uint64_t> packed_masks(n_masks * n_words);
+    for (const std::pair<const std::vector<std::uint64_t>, unsigned> &mask :
+         masks[c]) {
+      std::copy(
+          mask.first.begin(), mask.first.end(),
+          packed_masks.begin() + mask.second * n_words);
+    }
+    std::mutex n_odd_mutex;
+    parallel_for(
+        0, table.rows(), min_parallel_shots,
+        [&](std::size_t begin, std::size_t end) {
+          std::vector<std::size_t> odd(n_masks, 0);
+          for (std::size_t row = begin; row < end; ++row) {
+            const std::uint64_t *shot = table.data() + row * n_words;
+            const std::uint64_t *mask = packed_masks.data();
+            for (std::size_t m = 0; m < n_masks; ++m, mask += n_words) {
+              // The parity of a XOR of words is the XOR of their parities
+              std::uint64_t bits = 0;
+              for (std::size_t w = 0; w < n_words; ++w) {
+                bits ^= shot[w] & mask[w];
+              }
+              odd[m] += std::popcount(bits) & 1;
+            }
+          }
+          std::lock_guard<std::mutex> lock(n_odd_mutex);
+          for (std::size_t m = 0; m < n_masks; ++m) n_odd[c][m] += odd[m];
+        });
+  }
+  expectation_map_t values;
+  std::vector<unsigned>::const_iterator mask = bitmap_masks.begin();
+  for (const std::pair<const QubitPauliString, std::vector<MeasurementBitMap>>
+           &term : result_map) {
+    double total = 0.;
+    std::size_t n_shots = 0;
+    for (const MeasurementBitMap &mbm : term.second) {
+      const std::size_t n = shots[mbm.circ_index].rows();
+      const double odd = n_odd[mbm.circ_index][*mask++];
+      // Even parity measures +1 and odd parity -1, unless inverted
+      const double sum = double(n) - 2. * odd;
+      total += mbm.invert ? -sum : sum;
+      n_shots += n;
+    }
+    if (n_shots == 0) {
+      throw std::invalid_argument(
+          "No shots measure the term " + term.first.to_str());
+    }
+    values.insert({term.first, total / double(n_shots)});
+  }
+  return values;
+}
+
 std::string MeasurementSetup::to_str() const {
   std::stringstream ss;
   ss << "Circuits: ";
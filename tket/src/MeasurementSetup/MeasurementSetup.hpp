@@ -14,6 +14,9 @@
 
 #pragma once
 
+#include <Eigen/Dense>
+#include <cstdint>
+
 #include "Circuit/Circuit.hpp"
 #include "Utils/PauliStrings.hpp"
 
@@ -60,6 +63,16 @@ class MeasurementSetup {
   typedef std::unordered_map<
       QubitPauliString, std::vector<MeasurementBitMap>, QPSHasher>
       measure_result_map_t;
+  typedef std::unordered_map<QubitPauliString, double, QPSHasher>
+      expectation_map_t;
+
+  /**
+   * Shots of one measurement circuit, packed 64 bits to a word: one row per
+   * shot, with bit i of the circuit in bit (i % 64) of column (i / 64).
+   */
+  typedef Eigen::Matrix<
+      std::uint64_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      packed_shots_t;
 
   const std::vector<Circuit> &get_circs() const { return measurement_circs; }
   const measure_result_map_t &get_result_map() const { return result_map; }
@@ -80,6 +93,25 @@ class MeasurementSetup {
    */
   bool verify() const;
 
+  /**
+   * Expectation value of every term in the result map.
+   *
+   * Each shot of a measurement circuit contributes the parity of the bits
+   * of a MeasurementBitMap, inverted if required, to the term's value. Shots
+   * from all the circuits measuring a term are pooled, so the value is the
+   * mean over every shot that measured it.
+   *
+   * Parities of all the bit sets of a circuit are computed in one pass over
+   * its shots, split between threads up to \ref get_max_threads.
+   *
+   * @param shots packed shots of each measurement circuit, in order
+   * @return map from each term to its expectation value
+   * @throw std::invalid_argument if there is not one table of shots per
+   *   circuit, if a bit is outside its table, or if a term has no shots
+   */
+  expectation_map_t expectation_values(
+      const std::vector<packed_shots_t> &shots) const;
+
   std::string to_str() const;
 
  private:
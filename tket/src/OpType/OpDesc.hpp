@@ -18,6 +18,7 @@
 #include <string>
 
 #include "OpType.hpp"
+#include "OpTypeFunctions.hpp"
 #include "OpTypeInfo.hpp"
 
 namespace tket {
@@ -109,16 +110,8 @@ class OpDesc {
 
  private:
   const OpType type_;
-  const OpTypeInfo info_;
-  const bool is_meta_;
-  const bool is_box_;
-  const bool is_gate_;
-  const bool is_flowop_;
-  const bool is_classical_;
-  const bool is_rotation_;
-  const bool is_oneway_;
-  const bool is_clifford_;
-  const bool is_parameterised_pauli_rotation_;
+  const OpTypeInfo *info_;
+  const optype_flags_t flags_;
 };
 
 }  // namespace tket
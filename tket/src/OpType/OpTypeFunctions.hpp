@@ -14,6 +14,11 @@
 
 #pragma once
 
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
 #include <unordered_set>
 #include <vector>
 
@@ -27,6 +32,153 @@ typedef std::unordered_set<OpType> OpTypeSet;
 /** Vector of operation types */
 typedef std::vector<OpType> OpTypeVector;
 
+/** Bitwise combination of \ref OpTypeFlag values */
+typedef std::uint32_t optype_flags_t;
+
+/** Properties of operation types, as single bits */
+namespace OpTypeFlag {
+constexpr optype_flags_t Metaop = 1u << 0;
+constexpr optype_flags_t Box = 1u << 1;
+constexpr optype_flags_t Gate = 1u << 2;
+constexpr optype_flags_t Flowop = 1u << 3;
+constexpr optype_flags_t Rotation = 1u << 4;
+constexpr optype_flags_t ParameterisedPauliRotation = 1u << 5;
+constexpr optype_flags_t MultiQubit = 1u << 6;
+constexpr optype_flags_t SingleQubit = 1u << 7;
+constexpr optype_flags_t Oneway = 1u << 8;
+constexpr optype_flags_t Clifford = 1u << 9;
+constexpr optype_flags_t Projective = 1u << 10;
+constexpr optype_flags_t Classical = 1u << 11;
+}  // namespace OpTypeFlag
+
+/**
+ * Number of operation types
+ *
+ * This relies on \ref OpType::StabiliserAssertionBox being the last member
+ * of \ref OpType.
+ */
+constexpr std::size_t n_optypes =
+    static_cast<std::size_t>(OpType::StabiliserAssertionBox) + 1;
+
+namespace detail {
+
+constexpr std::array<optype_flags_t, n_optypes> make_optype_flags() {
+  std::array<optype_flags_t, n_optypes> flags{};
+  auto mark = [&flags](
+                  optype_flags_t flag, std::initializer_list<OpType> optypes) {
+    for (OpType optype : optypes) {
+      flags[static_cast<std::size_t>(optype)] |= flag;
+    }
+  };
+  mark(
+      OpTypeFlag::Metaop,
+      {OpType::Input, OpType::Output, OpType::ClInput, OpType::ClOutput,
+       OpType::Barrier, OpType::Create, OpType::Discard});
+  mark(
+      OpTypeFlag::Box,
+      {OpType::CircBox, OpType::Unitary1qBox, OpType::Unitary2qBox,
+       OpType::Unitary3qBox, OpType::ExpBox, OpType::PauliExpBox,
+       OpType::Composite, OpType::CliffBox, OpType::PhasePolyBox,
+       OpType::QControlBox, OpType::ClassicalExpBox,
+       OpType::ProjectorAssertionBox, OpType::StabiliserAssertionBox});
+  mark(
+      OpTypeFlag::Flowop,
+      {OpType::Label, OpType::Branch, OpType::Goto, OpType::Stop});
+  mark(
+      OpTypeFlag::SingleQubit | OpTypeFlag::Gate,
+      {OpType::Z,     OpType::X,        OpType::Y,       OpType::S,
+       OpType::Sdg,   OpType::T,        OpType::Tdg,     OpType::V,
+       OpType::Vdg,   OpType::SX,       OpType::SXdg,    OpType::H,
+       OpType::Rx,    OpType::Ry,       OpType::Rz,      OpType::U3,
+       OpType::U2,    OpType::U1,       OpType::tk1,     OpType::Measure,
+       OpType::Reset, OpType::Collapse, OpType::PhasedX, OpType::noop});
+  mark(
+      OpTypeFlag::MultiQubit | OpTypeFlag::Gate,
+      {OpType::CX,          OpType::CY,          OpType::CZ,
+       OpType::CH,          OpType::CV,          OpType::CVdg,
+       OpType::CSX,         OpType::CSXdg,       OpType::CRz,
+       OpType::CRx,         OpType::CRy,         OpType::CU1,
+       OpType::CU3,         OpType::PhaseGadget, OpType::CCX,
+       OpType::SWAP,        OpType::CSWAP,       OpType::ECR,
+       OpType::ISWAP,       OpType::ZZMax,       OpType::XXPhase,
+       OpType::YYPhase,     OpType::ZZPhase,     OpType::CnRy,
+       OpType::CnX,         OpType::BRIDGE,      OpType::ESWAP,
+       OpType::FSim,        OpType::Sycamore,    OpType::ISWAPMax,
+       OpType::PhasedISWAP, OpType::XXPhase3,    OpType::NPhasedX});
+  mark(
+      OpTypeFlag::Rotation,
+      {OpType::Rx, OpType::Ry, OpType::Rz, OpType::U1, OpType::CnRy,
+       OpType::CRz, OpType::CRx, OpType::CRy, OpType::CU1, OpType::XXPhase,
+       OpType::YYPhase, OpType::ZZPhase, OpType::ESWAP, OpType::ISWAP,
+       OpType::XXPhase3});
+  mark(
+      OpTypeFlag::ParameterisedPauliRotation,
+      {OpType::Rx, OpType::Ry, OpType::Rz, OpType::U1});
+  // Only gates for which a dagger is nonsensical or we do not yet have the
+  // dagger gate as an OpType. If the gate can have a dagger, define it in
+  // the dagger() method.
+  mark(
+      OpTypeFlag::Oneway,
+      {OpType::Input, OpType::Output, OpType::Measure, OpType::ClInput,
+       OpType::ClOutput, OpType::Barrier, OpType::Reset, OpType::Collapse,
+       OpType::Composite, OpType::PhasePolyBox, OpType::Create,
+       OpType::Discard});
+  mark(
+      OpTypeFlag::Clifford,
+      {OpType::Z, OpType::X, OpType::Y, OpType::S, OpType::Sdg, OpType::V,
+       OpType::Vdg, OpType::SX, OpType::SXdg, OpType::H, OpType::CX,
+       OpType::CY, OpType::CZ, OpType::SWAP, OpType::BRIDGE, OpType::noop,
+       OpType::ZZMax, OpType::ECR, OpType::ISWAPMax});
+  mark(
+      OpTypeFlag::Projective,
+      {OpType::Measure, OpType::Collapse, OpType::Reset});
+  mark(
+      OpTypeFlag::Classical,
+      {OpType::ClassicalTransform, OpType::SetBits, OpType::CopyBits,
+       OpType::RangePredicate, OpType::ExplicitPredicate,
+       OpType::ExplicitModifier, OpType::MultiBit});
+  return flags;
+}
+
+}  // namespace detail
+
+/** Properties of each operation type, indexed by the type */
+inline constexpr std::array<optype_flags_t, n_optypes> optype_flags_table =
+    detail::make_optype_flags();
+
+/** Properties of an operation type */
+constexpr optype_flags_t optype_flags(OpType optype) {
+  return optype_flags_table[static_cast<std::size_t>(optype)];
+}
+
+/** Whether an operation type has all of the given properties */
+constexpr bool has_optype_flags(OpType optype, optype_flags_t flags) {
+  return (optype_flags(optype) & flags) == flags;
+}
+
+/**
+ * Properties of an operation type known at compile time
+ *
+ * For example `optype_flags_v<OpType::CX> & OpTypeFlag::Clifford`.
+ */
+template <OpType optype>
+inline constexpr optype_flags_t optype_flags_v = optype_flags(optype);
+
+/** Whether an operation type has the properties \p flags */
+template <optype_flags_t flags>
+constexpr bool has_optype_flags(OpType optype) {
+  return (optype_flags(optype) & flags) == flags;
+}
+
+/** Set of operation types as a bitmask, indexed by the type */
+typedef std::bitset<n_optypes> OpTypeMask;
+
+/** Bitmask of a set of operation types */
+OpTypeMask optype_mask(const OpTypeSet &optypes);
+
+/** Bitmask of the operation types having all of the properties \p flags */
+OpTypeMask optype_mask(optype_flags_t flags);
+
 /** Set of all elementary gates */
 const OpTypeSet &all_gate_types();
 
@@ -40,52 +192,84 @@ const OpTypeSet &all_single_qubit_types();
 const OpTypeSet &all_projective_types();
 
 /** Test for initial, final and barrier "ops" */
-bool is_metaop_type(OpType optype);
+constexpr bool is_metaop_type(OpType optype) {
+  return has_optype_flags<OpTypeFlag::Metaop>(optype);
+}
 
 /** Test for input or creation quantum "ops" */
-bool is_initial_q_type(OpType optype);
+constexpr bool is_initial_q_type(OpType optype) {
+  return optype == OpType::Input || optype == OpType::Create;
+}
 
 /** Test for output or discard quantum "ops" */
-bool is_final_q_type(OpType optype);
+constexpr bool is_final_q_type(OpType optype) {
+  return optype == OpType::Output || optype == OpType::Discard;
+}
 
 /** Test for input, creation, output or discard quantum "ops" */
-bool is_boundary_q_type(OpType optype);
+constexpr bool is_boundary_q_type(OpType optype) {
+  return is_initial_q_type(optype) || is_final_q_type(optype);
+}
 
 /** Test for input or output for classical "ops" */
-bool is_boundary_c_type(OpType optype);
+constexpr bool is_boundary_c_type(OpType optype) {
+  return optype == OpType::ClInput || optype == OpType::ClOutput;
+}
 
 /** Test for elementary gates */
-bool is_gate_type(OpType optype);
+constexpr bool is_gate_type(OpType optype) {
+  return has_optype_flags<OpTypeFlag::Gate>(optype);
+}
 
 /** Test for boxes (complex packaged operations) */
-bool is_box_type(OpType optype);
+constexpr bool is_box_type(OpType optype) {
+  return has_optype_flags<OpTypeFlag::Box>(optype);
+}
 
 /** Test for flowops (just for high-level control flow) */
-bool is_flowop_type(OpType optype);
+constexpr bool is_flowop_type(OpType optype) {
+  return has_optype_flags<OpTypeFlag::Flowop>(optype);
+}
 
 /** Test for rotations (including controlled rotations) */
-bool is_rotation_type(OpType optype);
+constexpr bool is_rotation_type(OpType optype) {
+  return has_optype_flags<OpTypeFlag::Rotation>(optype);
+}
 
 /** Test for rotations around Pauli axes */
-bool is_parameterised_pauli_rotation_type(OpType optype);
+constexpr bool is_parameterised_pauli_rotation_type(OpType optype) {
+  return has_optype_flags<OpTypeFlag::ParameterisedPauliRotation>(optype);
+}
 
 /** Test for gates over more than one qubit */
-bool is_multi_qubit_type(OpType optype);
+constexpr bool is_multi_qubit_type(OpType optype) {
+  return has_optype_flags<OpTypeFlag::MultiQubit>(optype);
+}
 
 /** Test for gates over a single qubit */
-bool is_single_qubit_type(OpType optype);
+constexpr bool is_single_qubit_type(OpType optype) {
+  return has_optype_flags<OpTypeFlag::SingleQubit>(optype);
+}
 
 /** Test for non-invertible operations */
-bool is_oneway_type(OpType optype);
+constexpr bool is_oneway_type(OpType optype) {
+  return has_optype_flags<OpTypeFlag::Oneway>(optype);
+}
 
 /** Test for Clifford operations */
-bool is_clifford_type(OpType optype);
+constexpr bool is_clifford_type(OpType optype) {
+  return has_optype_flags<OpTypeFlag::Clifford>(optype);
+}
 
 /** Test for measurement and reset gates */
-bool is_projective_type(OpType optype);
+constexpr bool is_projective_type(OpType optype) {
+  return has_optype_flags<OpTypeFlag::Projective>(optype);
+}
 
 /** Test for purely classical gates derived from ClassicalOp */
-bool is_classical_type(OpType optype);
+constexpr bool is_classical_type(OpType optype) {
+  return has_optype_flags<OpTypeFlag::Classical>(optype);
+}
 
 /** Whether a given operation type belongs to a given set */
 bool find_in_set(const OpType &val, const OpTypeSet &set);
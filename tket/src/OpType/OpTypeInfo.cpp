@@ -14,7 +14,11 @@
 
 #include "OpTypeInfo.hpp"
 
+#include <array>
 #include <memory>
+#include <stdexcept>
+
+#include "OpTypeFunctions.hpp"
 
 namespace tket {
 const std::map<OpType, OpTypeInfo>& optypeinfo() {
@@ -144,4 +148,20 @@ const std::map<OpType, OpTypeInfo>& optypeinfo() {
   return *opinfo;
 }
 
+const OpTypeInfo& optypeinfo(OpType type) {
+  // Pointers into the map, which is never modified
+  static const std::array<const OpTypeInfo*, n_optypes> table = [] {
+    std::array<const OpTypeInfo*, n_optypes> t{};
+    for (const std::pair<const OpType, OpTypeInfo>& entry : optypeinfo()) {
+      t[static_cast<std::size_t>(entry.first)] = &entry.second;
+    }
+    return t;
+  }();
+  std::size_t i = static_cast<std::size_t>(type);
+  if (i >= n_optypes || table[i] == nullptr) {
+    throw std::out_of_range("No OpTypeInfo for operation type");
+  }
+  return *table[i];
+}
+
 }  // namespace tket
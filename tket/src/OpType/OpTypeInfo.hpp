@@ -48,4 +48,14 @@ struct OpTypeInfo {
 /** Information including name and shape of each operation type */
 const std::map<OpType, OpTypeInfo> &optypeinfo();
 
+/**
+ * Information about a single operation type
+ *
+ * Equivalent to `optypeinfo(type)`, but indexed by the type rather than
+ * searched for.
+ *
+ * @throws std::out_of_range if there is no information for \p type
+ */
+const OpTypeInfo &optypeinfo(OpType type);
+
 }  // namespace tket
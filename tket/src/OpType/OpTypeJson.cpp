@@ -12,41 +12,95 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <map>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 
 #include "OpType.hpp"
 #include "OpTypeInfo.hpp"
 
 namespace tket {
 
-// map from OpType name to OpType
-// Relies on unique OpType names.
-const std::map<std::string, OpType>& name_to_optype() {
-  auto mapfiller = []() {
-    std::map<std::string, OpType> fill_map;
+namespace {
+
+/**
+ * Perfect hash table from OpType name to OpType.
+ *
+ * A seed for the hash function is searched for on construction such that no
+ * two names fall in the same slot, so that a lookup is one hash and at most
+ * one string comparison. Relies on unique OpType names.
+ */
+class OpTypeNameTable {
+ public:
+  OpTypeNameTable() : seed_(0) {
+    while (!try_fill()) ++seed_;
+  }
+
+  std::optional<OpType> find(std::string_view name) const {
+    const Slot& slot = slots_[index(name)];
+    if (slot.name == nullptr || *slot.name != name) return std::nullopt;
+    return slot.type;
+  }
+
+ private:
+  // With under a hundred names, a random seed gives no collision in this
+  // many slots with probability about 1/7.
+  static constexpr std::size_t n_slots = 2048;
+
+  struct Slot {
+    const std::string* name = nullptr;
+    OpType type = OpType::Input;
+  };
+
+  // Seeded FNV-1a, with a final mix so that the low bits are usable
+  std::size_t index(std::string_view name) const {
+    std::uint64_t h = 14695981039346656037ull ^ seed_;
+    for (char c : name) {
+      h ^= static_cast<unsigned char>(c);
+      h *= 1099511628211ull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h & (n_slots - 1);
+  }
+
+  bool try_fill() {
+    slots_.fill(Slot());
     for (const auto& info : optypeinfo()) {
-      fill_map.insert({info.second.name, info.first});
+      Slot& slot = slots_[index(info.second.name)];
+      if (slot.name != nullptr) return false;
+      slot = {&info.second.name, info.first};
     }
-    return fill_map;
-  };
-  static auto final_map =
-      std::make_unique<const std::map<std::string, OpType>>(mapfiller());
-  return *final_map;
+    return true;
+  }
+
+  std::uint64_t seed_;
+  std::array<Slot, n_slots> slots_;
+};
+
+}  // namespace
+
+static const OpTypeNameTable& name_table() {
+  static const std::unique_ptr<const OpTypeNameTable> table =
+      std::make_unique<const OpTypeNameTable>();
+  return *table;
 }
 
 void to_json(nlohmann::json& j, const OpType& type) {
-  j = optypeinfo().at(type).name;
+  j = optypeinfo(type).name;
 }
 
 void from_json(const nlohmann::json& j, OpType& type) {
-  const std::string name = j.get<std::string>();
-  const auto result = name_to_optype().find(name);
-  if (result == name_to_optype().end()) {
+  const std::string& name = j.get_ref<const std::string&>();
+  const std::optional<OpType> result = name_table().find(name);
+  if (!result) {
     throw JsonError("No OpType with name " + name);
   }
-
-  type = result->second;
+  type = *result;
 }
 
 }  // namespace tket
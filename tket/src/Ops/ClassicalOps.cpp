@@ -14,7 +14,11 @@
 
 #include "ClassicalOps.hpp"
 
+#include <algorithm>
+#include <array>
+
 #include "OpType/OpType.hpp"
+#include "Utils/Assert.hpp"
 #include "Utils/Json.hpp"
 
 namespace tket {
@@ -31,6 +35,59 @@ static uint32_t u32_from_boolvec(const std::vector<bool> &x) {
   return X;
 }
 
+// Number of assignments evaluated by eval_packed
+static constexpr unsigned n_lanes = 64;
+
+// Largest number of inputs of a truth table that eval_packed evaluates
+// bitwise, through a tree of 2^n - 1 multiplexers per output; larger tables
+// are looked up once per assignment instead
+static constexpr unsigned max_packed_table_inputs = 6;
+
+// Index into a truth table of the inputs of one assignment
+static uint32_t lane_index(const std::vector<uint64_t> &x, unsigned lane) {
+  uint32_t X = 0;
+  for (unsigned i = 0; i < x.size(); i++) {
+    X |= uint32_t((x[i] >> lane) & 1) << i;
+  }
+  return X;
+}
+
+// Bitwise evaluation of one output of a truth table with at most
+// max_packed_table_inputs inputs, given as a word whose j-th bit is the j-th
+// entry, by selecting between pairs of entries on each input in turn
+static uint64_t mux_table(const std::vector<uint64_t> &x, uint64_t table) {
+  TKET_ASSERT(x.size() <= max_packed_table_inputs);
+  std::array<uint64_t, std::size_t(1) << max_packed_table_inputs> entries;
+  std::size_t n = std::size_t(1) << x.size();
+  for (std::size_t j = 0; j < n; j++) {
+    entries[j] = ((table >> j) & 1) ? ~uint64_t(0) : 0;
+  }
+  for (uint64_t sel : x) {
+    n /= 2;
+    for (std::size_t j = 0; j < n; j++) {
+      entries[j] = (sel & entries[2 * j + 1]) | (~sel & entries[2 * j]);
+    }
+  }
+  return entries[0];
+}
+
+// Bitwise evaluation of a single-output truth table
+static uint64_t eval_packed_table(
+    const std::vector<uint64_t> &x, const std::vector<bool> &values) {
+  if (x.size() <= max_packed_table_inputs) {
+    uint64_t table = 0;
+    for (std::size_t j = 0; j < values.size(); j++) {
+      if (values[j]) table |= uint64_t(1) << j;
+    }
+    return mux_table(x, table);
+  }
+  uint64_t y = 0;
+  for (unsigned lane = 0; lane < n_lanes; lane++) {
+    if (values[lane_index(x, lane)]) y |= uint64_t(1) << lane;
+  }
+  return y;
+}
+
 static nlohmann::json classical_to_json(const Op_ptr &op, const OpType &type) {
   nlohmann::json j_class;
   switch (type) {
@@ -80,7 +137,7 @@ static nlohmann::json classical_to_json(const Op_ptr &op, const OpType &type) {
     }
     default:
       throw JsonError(
-          "Classical op with type " + optypeinfo().at(type).name +
+          "Classical op with type " + optypeinfo(type).name +
           " cannot be serialized.");
   }
 }
@@ -151,6 +208,22 @@ Op_ptr ClassicalOp::deserialize(const nlohmann::json &j) {
 
 std::string ClassicalOp::get_name(bool) const { return name_; }
 
+std::vector<uint64_t> ClassicalOp::eval_packed(
+    const std::vector<uint64_t> &x) const {
+  std::vector<uint64_t> y(n_io_ + n_o_, 0);
+  std::vector<bool> x_lane(x.size());
+  for (unsigned lane = 0; lane < n_lanes; lane++) {
+    for (unsigned i = 0; i < x.size(); i++) {
+      x_lane[i] = (x[i] >> lane) & 1;
+    }
+    std::vector<bool> y_lane = eval(x_lane);
+    for (unsigned j = 0; j < y.size(); j++) {
+      if (y_lane[j]) y[j] |= uint64_t(1) << lane;
+    }
+  }
+  return y;
+}
+
 bool ClassicalOp::is_equal(const Op &op_other) const {
   const ClassicalOp &other = dynamic_cast<const ClassicalOp &>(op_other);
 
@@ -189,6 +262,31 @@ std::vector<bool> ClassicalTransformOp::eval(const std::vector<bool> &x) const {
   return y;
 }
 
+std::vector<uint64_t> ClassicalTransformOp::eval_packed(
+    const std::vector<uint64_t> &x) const {
+  if (x.size() != n_io_) {
+    throw std::domain_error("Incorrect input size");
+  }
+  std::vector<uint64_t> y(n_io_, 0);
+  if (n_io_ <= max_packed_table_inputs) {
+    for (unsigned j = 0; j < n_io_; j++) {
+      uint64_t table = 0;
+      for (std::size_t k = 0; k < values_.size(); k++) {
+        table |= uint64_t((values_[k] >> j) & 1) << k;
+      }
+      y[j] = mux_table(x, table);
+    }
+    return y;
+  }
+  for (unsigned lane = 0; lane < n_lanes; lane++) {
+    uint32_t val = values_[lane_index(x, lane)];
+    for (unsigned j = 0; j < n_io_; j++) {
+      y[j] |= uint64_t((val >> j) & 1) << lane;
+    }
+  }
+  return y;
+}
+
 std::string SetBitsOp::get_name(bool) const {
   std::stringstream name;
   name << name_ << "(";
@@ -206,6 +304,18 @@ std::vector<bool> SetBitsOp::eval(const std::vector<bool> &x) const {
   return values_;
 }
 
+std::vector<uint64_t> SetBitsOp::eval_packed(
+    const std::vector<uint64_t> &x) const {
+  if (!x.empty()) {
+    throw std::domain_error("Non-empty input");
+  }
+  std::vector<uint64_t> y(values_.size());
+  for (unsigned j = 0; j < values_.size(); j++) {
+    y[j] = values_[j] ? ~uint64_t(0) : 0;
+  }
+  return y;
+}
+
 std::vector<bool> CopyBitsOp::eval(const std::vector<bool> &x) const {
   if (x.size() != n_i_) {
     throw std::domain_error("Incorrect input size");
@@ -213,6 +323,14 @@ std::vector<bool> CopyBitsOp::eval(const std::vector<bool> &x) const {
   return x;
 }
 
+std::vector<uint64_t> CopyBitsOp::eval_packed(
+    const std::vector<uint64_t> &x) const {
+  if (x.size() != n_i_) {
+    throw std::domain_error("Incorrect input size");
+  }
+  return x;
+}
+
 std::string RangePredicateOp::get_name(bool) const {
   std::stringstream name;
   name << name_ << "([" << a << "," << b << "])";
@@ -229,6 +347,42 @@ std::vector<bool> RangePredicateOp::eval(const std::vector<bool> &x) const {
   return y;
 }
 
+std::vector<uint64_t> RangePredicateOp::eval_packed(
+    const std::vector<uint64_t> &x) const {
+  if (x.size() != n_i_) {
+    throw std::domain_error("Incorrect input size");
+  }
+  if (n_i_ > 32) {
+    throw std::domain_error("Vector of bool exceeds maximum size (32)");
+  }
+  // Compare the encoded numbers with both bounds at once, from the most
+  // significant bit down, keeping the lanes still equal to each bound
+  const uint64_t ones = ~uint64_t(0);
+  // Bounds beyond the largest encodable number decide every lane
+  const bool a_too_big = n_i_ < 32 && (a >> n_i_) != 0;
+  const bool b_too_big = n_i_ < 32 && (b >> n_i_) != 0;
+  uint64_t eq_a = a_too_big ? 0 : ones;
+  uint64_t eq_b = b_too_big ? 0 : ones;
+  uint64_t above_a = 0;
+  uint64_t below_b = b_too_big ? ones : 0;
+  for (unsigned i = n_i_; i-- > 0;) {
+    const uint64_t xi = x[i];
+    if ((a >> i) & 1) {
+      eq_a &= xi;
+    } else {
+      above_a |= eq_a & xi;
+      eq_a &= ~xi;
+    }
+    if ((b >> i) & 1) {
+      below_b |= eq_b & ~xi;
+      eq_b &= xi;
+    } else {
+      eq_b &= ~xi;
+    }
+  }
+  return {(above_a | eq_a) & (below_b | eq_b)};
+}
+
 bool RangePredicateOp::is_equal(const Op &op_other) const {
   const RangePredicateOp &other =
       dynamic_cast<const RangePredicateOp &>(op_other);
@@ -254,6 +408,14 @@ std::vector<bool> ExplicitPredicateOp::eval(const std::vector<bool> &x) const {
   return y;
 }
 
+std::vector<uint64_t> ExplicitPredicateOp::eval_packed(
+    const std::vector<uint64_t> &x) const {
+  if (x.size() != n_i_) {
+    throw std::domain_error("Incorrect input size");
+  }
+  return {eval_packed_table(x, values_)};
+}
+
 ExplicitModifierOp::ExplicitModifierOp(
     unsigned n, const std::vector<bool> &values, const std::string &name)
     : ModifyingOp(OpType::ExplicitModifier, n, name), values_(values) {
@@ -271,6 +433,14 @@ std::vector<bool> ExplicitModifierOp::eval(const std::vector<bool> &x) const {
   return y;
 }
 
+std::vector<uint64_t> ExplicitModifierOp::eval_packed(
+    const std::vector<uint64_t> &x) const {
+  if (x.size() != n_i_ + 1) {
+    throw std::domain_error("Incorrect input size");
+  }
+  return {eval_packed_table(x, values_)};
+}
+
 MultiBitOp::MultiBitOp(std::shared_ptr<const ClassicalOp> op, unsigned n)
     : ClassicalOp(
           OpType::MultiBit, n * op->get_n_i(), n * op->get_n_io(),
@@ -312,6 +482,23 @@ std::vector<bool> MultiBitOp::eval(const std::vector<bool> &x) const {
   return y;
 }
 
+std::vector<uint64_t> MultiBitOp::eval_packed(
+    const std::vector<uint64_t> &x) const {
+  if (x.size() != n_i_ + n_io_) {
+    throw std::domain_error("Incorrect input size");
+  }
+  unsigned n_op_inputs = op_->get_n_i() + op_->get_n_io();
+  unsigned n_op_outputs = op_->get_n_io() + op_->get_n_o();
+  std::vector<uint64_t> y(n_io_ + n_o_);
+  std::vector<uint64_t> x_i(n_op_inputs);
+  for (unsigned i = 0; i < n_; i++) {
+    std::copy_n(x.begin() + n_op_inputs * i, n_op_inputs, x_i.begin());
+    std::vector<uint64_t> y_i = op_->eval_packed(x_i);
+    std::copy_n(y_i.begin(), n_op_outputs, y.begin() + n_op_outputs * i);
+  }
+  return y;
+}
+
 bool MultiBitOp::is_equal(const Op &op_other) const {
   const MultiBitOp &other = dynamic_cast<const MultiBitOp &>(op_other);
 
@@ -19,6 +19,8 @@
  * @brief Classical operations
  */
 
+#include <cstdint>
+
 #include "Op.hpp"
 #include "Utils/Json.hpp"
 
@@ -76,6 +78,24 @@ class ClassicalOp : public Op {
    */
   virtual std::vector<bool> eval(const std::vector<bool> &x) const = 0;
 
+  /**
+   * Evaluation on 64 assignments of the inputs at once
+   *
+   * Each input bit is given as a word whose k-th bit is its value in the k-th
+   * assignment, and each output bit is returned in the same way, so that the
+   * k-th bits of the output words are the result of \ref eval on the k-th
+   * bits of the input words.
+   *
+   * The default evaluates each assignment separately; subclasses that can
+   * operate on whole words override it.
+   *
+   * @param x vector of input words
+   *
+   * @return vector of output words
+   */
+  virtual std::vector<std::uint64_t> eval_packed(
+      const std::vector<std::uint64_t> &x) const;
+
   /**
    * Equality check between two ClassicalOp instances
    */
@@ -112,6 +132,8 @@ class ClassicalTransformOp : public ClassicalOp {
       const std::string &name = "ClassicalTransform");
 
   std::vector<bool> eval(const std::vector<bool> &x) const override;
+  std::vector<std::uint64_t> eval_packed(
+      const std::vector<std::uint64_t> &x) const override;
 
   std::vector<uint32_t> get_values() const { return values_; }
 
@@ -138,6 +160,8 @@ class SetBitsOp : public ClassicalOp {
   std::vector<bool> get_values() const { return values_; }
 
   std::vector<bool> eval(const std::vector<bool> &x) const override;
+  std::vector<std::uint64_t> eval_packed(
+      const std::vector<std::uint64_t> &x) const override;
 
  private:
   std::vector<bool> values_;
@@ -154,6 +178,8 @@ class CopyBitsOp : public ClassicalOp {
       : ClassicalOp(OpType::CopyBits, n, 0, n, "CopyBits") {}
 
   std::vector<bool> eval(const std::vector<bool> &x) const override;
+  std::vector<std::uint64_t> eval_packed(
+      const std::vector<std::uint64_t> &x) const override;
 };
 
 /**
@@ -202,6 +228,13 @@ class RangePredicateOp : public PredicateOp {
 
   std::vector<bool> eval(const std::vector<bool> &x) const override;
 
+  /**
+   * Compares the encoded numbers of all 64 assignments with both bounds at
+   * once, one input word at a time.
+   */
+  std::vector<std::uint64_t> eval_packed(
+      const std::vector<std::uint64_t> &x) const override;
+
   /**
    * Equality check between two RangePredicateOp instances
    */
@@ -234,6 +267,8 @@ class ExplicitPredicateOp : public PredicateOp {
       const std::string &name = "ExplicitPredicate");
 
   std::vector<bool> eval(const std::vector<bool> &x) const override;
+  std::vector<std::uint64_t> eval_packed(
+      const std::vector<std::uint64_t> &x) const override;
 
   std::vector<bool> get_values() const { return values_; }
 
@@ -280,6 +315,8 @@ class ExplicitModifierOp : public ModifyingOp {
       const std::string &name = "ExplicitModifier");
 
   std::vector<bool> eval(const std::vector<bool> &x) const override;
+  std::vector<std::uint64_t> eval_packed(
+      const std::vector<std::uint64_t> &x) const override;
 
   std::vector<bool> get_values() const { return values_; }
 
@@ -304,6 +341,8 @@ class MultiBitOp : public ClassicalOp {
   unsigned get_n() const { return n_; }
 
   std::vector<bool> eval(const std::vector<bool> &x) const override;
+  std::vector<std::uint64_t> eval_packed(
+      const std::vector<std::uint64_t> &x) const override;
 
   /**
    * Equality check between two MultiBitOp instances
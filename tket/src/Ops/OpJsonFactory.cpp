@@ -19,46 +19,43 @@
 #include "Utils/Json.hpp"
 
 namespace tket {
-std::map<OpType, OpJsonFactory::JsonConstruct>& OpJsonFactory::c_methods_() {
-  static std::unique_ptr<std::map<OpType, OpJsonFactory::JsonConstruct>>
-      methods =
-          std::make_unique<std::map<OpType, OpJsonFactory::JsonConstruct>>();
-  return *methods;
+std::array<OpJsonFactory::JsonConstruct, n_optypes>&
+OpJsonFactory::c_methods_() {
+  static std::array<JsonConstruct, n_optypes> methods{};
+  return methods;
 }
-std::map<OpType, OpJsonFactory::JsonProduce>& OpJsonFactory::p_methods_() {
-  static std::unique_ptr<std::map<OpType, OpJsonFactory::JsonProduce>> methods =
-      std::make_unique<std::map<OpType, OpJsonFactory::JsonProduce>>();
-  return *methods;
+std::array<OpJsonFactory::JsonProduce, n_optypes>& OpJsonFactory::p_methods_() {
+  static std::array<JsonProduce, n_optypes> methods{};
+  return methods;
 }
 
 bool OpJsonFactory::register_method(
     const OpType& type, JsonConstruct create_method,
     JsonProduce produce_method) {
-  if (auto it = c_methods_().find(type); it == c_methods_().end()) {
-    c_methods_()[type] = create_method;
-    p_methods_()[type] = produce_method;
-    return true;
-  }
-  return false;
+  const std::size_t i = static_cast<std::size_t>(type);
+  if (c_methods_()[i] != nullptr) return false;
+  c_methods_()[i] = create_method;
+  p_methods_()[i] = produce_method;
+  return true;
 }
 
 Op_ptr OpJsonFactory::from_json(const nlohmann::json& j) {
   const auto type = j.at("type").get<OpType>();
-  if (auto it = c_methods_().find(type); it != c_methods_().end()) {
-    return it->second(j);
+  if (JsonConstruct method = c_methods_()[static_cast<std::size_t>(type)]) {
+    return method(j);
   }
   throw JsonError(
-      "No from_json conversion for type " + optypeinfo().at(type).name);
+      "No from_json conversion for type " + optypeinfo(type).name);
 }
 
 nlohmann::json OpJsonFactory::to_json(const Op_ptr& op) {
   const OpType& type = op->get_type();
-  if (auto it = p_methods_().find(type); it != p_methods_().end()) {
-    return it->second(op);
+  if (JsonProduce method = p_methods_()[static_cast<std::size_t>(type)]) {
+    return method(op);
   }
   throw JsonError(
       "No to_json conversion registered for type: " +
-      optypeinfo().at(type).name);
+      optypeinfo(type).name);
 }
 
 }  // namespace tket
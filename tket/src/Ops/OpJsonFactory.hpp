@@ -14,7 +14,10 @@
 
 #pragma once
 
+#include <array>
+
 #include "OpType/OpType.hpp"
+#include "OpType/OpTypeFunctions.hpp"
 #include "Ops/OpPtr.hpp"
 #include "Utils/Json.hpp"
 
@@ -46,10 +49,10 @@ class OpJsonFactory {
   static nlohmann::json to_json(const Op_ptr &op);
 
  private:
-  // map from optype to method which can produce JSON for that Op
-  static std::map<OpType, JsonConstruct> &c_methods_();
-  // map from optype to method which can construct that Op from JSON
-  static std::map<OpType, JsonProduce> &p_methods_();
+  // method which can construct each Op from JSON, indexed by OpType
+  static std::array<JsonConstruct, n_optypes> &c_methods_();
+  // method which can produce JSON for each Op, indexed by OpType
+  static std::array<JsonProduce, n_optypes> &p_methods_();
 };
 
 }  // namespace tket
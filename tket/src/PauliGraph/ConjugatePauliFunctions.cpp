@@ -14,87 +14,186 @@
 
 #include "ConjugatePauliFunctions.hpp"
 
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
 #include "PauliGraph/PauliGraph.hpp"
 #include "Utils/Assert.hpp"
 #include "Utils/Exceptions.hpp"
 
 namespace tket {
 
-std::pair<Pauli, bool> conjugate_Pauli(OpType op, Pauli p, bool reverse) {
-  static const std::map<std::pair<OpType, Pauli>, std::pair<Pauli, bool>>
-      conj_lut{
-          {{OpType::H, Pauli::I}, {Pauli::I, false}},
-          {{OpType::H, Pauli::X}, {Pauli::Z, false}},
-          {{OpType::H, Pauli::Y}, {Pauli::Y, true}},
-          {{OpType::H, Pauli::Z}, {Pauli::X, false}},
-          {{OpType::S, Pauli::I}, {Pauli::I, false}},
-          {{OpType::S, Pauli::X}, {Pauli::Y, true}},
-          {{OpType::S, Pauli::Y}, {Pauli::X, false}},
-          {{OpType::S, Pauli::Z}, {Pauli::Z, false}},
-          {{OpType::Sdg, Pauli::I}, {Pauli::I, false}},
-          {{OpType::Sdg, Pauli::X}, {Pauli::Y, false}},
-          {{OpType::Sdg, Pauli::Y}, {Pauli::X, true}},
-          {{OpType::Sdg, Pauli::Z}, {Pauli::Z, false}},
-          {{OpType::V, Pauli::I}, {Pauli::I, false}},
-          {{OpType::V, Pauli::X}, {Pauli::X, false}},
-          {{OpType::V, Pauli::Y}, {Pauli::Z, true}},
-          {{OpType::V, Pauli::Z}, {Pauli::Y, false}},
-          {{OpType::Vdg, Pauli::I}, {Pauli::I, false}},
-          {{OpType::Vdg, Pauli::X}, {Pauli::X, false}},
-          {{OpType::Vdg, Pauli::Y}, {Pauli::Z, false}},
-          {{OpType::Vdg, Pauli::Z}, {Pauli::Y, true}},
-          {{OpType::X, Pauli::I}, {Pauli::I, false}},
-          {{OpType::X, Pauli::X}, {Pauli::X, false}},
-          {{OpType::X, Pauli::Y}, {Pauli::Y, true}},
-          {{OpType::X, Pauli::Z}, {Pauli::Z, true}},
-          {{OpType::Y, Pauli::I}, {Pauli::I, false}},
-          {{OpType::Y, Pauli::X}, {Pauli::X, true}},
-          {{OpType::Y, Pauli::Y}, {Pauli::Y, false}},
-          {{OpType::Y, Pauli::Z}, {Pauli::Z, true}},
-          {{OpType::Z, Pauli::I}, {Pauli::I, false}},
-          {{OpType::Z, Pauli::X}, {Pauli::X, true}},
-          {{OpType::Z, Pauli::Y}, {Pauli::Y, true}},
-          {{OpType::Z, Pauli::Z}, {Pauli::Z, false}}};
-
-  static const std::map<std::pair<OpType, Pauli>, std::pair<Pauli, bool>>
-      rev_conj_lut{
-          {{OpType::H, Pauli::I}, {Pauli::I, false}},
-          {{OpType::H, Pauli::X}, {Pauli::Z, false}},
-          {{OpType::H, Pauli::Y}, {Pauli::Y, true}},
-          {{OpType::H, Pauli::Z}, {Pauli::X, false}},
-          {{OpType::S, Pauli::I}, {Pauli::I, false}},
-          {{OpType::S, Pauli::X}, {Pauli::Y, false}},
-          {{OpType::S, Pauli::Y}, {Pauli::X, true}},
-          {{OpType::S, Pauli::Z}, {Pauli::Z, false}},
-          {{OpType::Sdg, Pauli::I}, {Pauli::I, false}},
-          {{OpType::Sdg, Pauli::X}, {Pauli::Y, true}},
-          {{OpType::Sdg, Pauli::Y}, {Pauli::X, false}},
-          {{OpType::Sdg, Pauli::Z}, {Pauli::Z, false}},
-          {{OpType::V, Pauli::I}, {Pauli::I, false}},
-          {{OpType::V, Pauli::X}, {Pauli::X, false}},
-          {{OpType::V, Pauli::Y}, {Pauli::Z, false}},
-          {{OpType::V, Pauli::Z}, {Pauli::Y, true}},
-          {{OpType::Vdg, Pauli::I}, {Pauli::I, false}},
-          {{OpType::Vdg, Pauli::X}, {Pauli::X, false}},
-          {{OpType::Vdg, Pauli::Y}, {Pauli::Z, true}},
-          {{OpType::Vdg, Pauli::Z}, {Pauli::Y, false}},
-          {{OpType::X, Pauli::I}, {Pauli::I, false}},
-          {{OpType::X, Pauli::X}, {Pauli::X, false}},
-          {{OpType::X, Pauli::Y}, {Pauli::Y, true}},
-          {{OpType::X, Pauli::Z}, {Pauli::Z, true}},
-          {{OpType::Y, Pauli::I}, {Pauli::I, false}},
-          {{OpType::Y, Pauli::X}, {Pauli::X, true}},
-          {{OpType::Y, Pauli::Y}, {Pauli::Y, false}},
-          {{OpType::Y, Pauli::Z}, {Pauli::Z, true}},
-          {{OpType::Z, Pauli::I}, {Pauli::I, false}},
-          {{OpType::Z, Pauli::X}, {Pauli::X, true}},
-          {{OpType::Z, Pauli::Y}, {Pauli::Y, true}},
-          {{OpType::Z, Pauli::Z}, {Pauli::Z, false}}};
+namespace {
 
-  if (reverse) {
-    return rev_conj_lut.at({op, p});
+struct PauliImage {
+  Pauli p;
+  bool negated;
+};
+
+// Images of I, X, Y, Z under conjugation by a single-qubit Clifford
+typedef std::array<PauliImage, 4> PauliImages;
+
+// Images of each pair of Paulis, indexed by 4 * p0 + p1, under conjugation
+// by a two-qubit Clifford
+struct PauliPairImage {
+  Pauli p0;
+  Pauli p1;
+  bool negated;
+};
+typedef std::array<PauliPairImage, 16> PauliPairImages;
+
+}  // namespace
+
+// The tables for reverse = false; since H, X, Y and Z are self-inverse and
+// S, V are the inverses of Sdg, Vdg, those for reverse = true are the same
+// tables with S and Sdg, V and Vdg exchanged.
+static constexpr PauliImages h_conj{{
+    {Pauli::I, false},
+    {Pauli::Z, false},
+    {Pauli::Y, true},
+    {Pauli::X, false},
+}};
+static constexpr PauliImages s_conj{{
+    {Pauli::I, false},
+    {Pauli::Y, true},
+    {Pauli::X, false},
+    {Pauli::Z, false},
+}};
+static constexpr PauliImages sdg_conj{{
+    {Pauli::I, false},
+    {Pauli::Y, false},
+    {Pauli::X, true},
+    {Pauli::Z, false},
+}};
+static constexpr PauliImages v_conj{{
+    {Pauli::I, false},
+    {Pauli::X, false},
+    {Pauli::Z, true},
+    {Pauli::Y, false},
+}};
+static constexpr PauliImages vdg_conj{{
+    {Pauli::I, false},
+    {Pauli::X, false},
+    {Pauli::Z, false},
+    {Pauli::Y, true},
+}};
+static constexpr PauliImages x_conj{{
+    {Pauli::I, false},
+    {Pauli::X, false},
+    {Pauli::Y, true},
+    {Pauli::Z, true},
+}};
+static constexpr PauliImages y_conj{{
+    {Pauli::I, false},
+    {Pauli::X, true},
+    {Pauli::Y, false},
+    {Pauli::Z, true},
+}};
+static constexpr PauliImages z_conj{{
+    {Pauli::I, false},
+    {Pauli::X, true},
+    {Pauli::Y, true},
+    {Pauli::Z, false},
+}};
+
+static constexpr PauliPairImages cx_conj{{
+    {Pauli::I, Pauli::I, false},
+    {Pauli::I, Pauli::X, false},
+    {Pauli::Z, Pauli::Y, false},
+    {Pauli::Z, Pauli::Z, false},
+    {Pauli::X, Pauli::X, false},
+    {Pauli::X, Pauli::I, false},
+    {Pauli::Y, Pauli::Z, false},
+    {Pauli::Y, Pauli::Y, true},
+    {Pauli::Y, Pauli::X, false},
+    {Pauli::Y, Pauli::I, false},
+    {Pauli::X, Pauli::Z, true},
+    {Pauli::X, Pauli::Y, false},
+    {Pauli::Z, Pauli::I, false},
+    {Pauli::Z, Pauli::X, false},
+    {Pauli::I, Pauli::Y, false},
+    {Pauli::I, Pauli::Z, false},
+}};
+static constexpr PauliPairImages cz_conj{{
+    {Pauli::I, Pauli::I, false},
+    {Pauli::Z, Pauli::X, false},
+    {Pauli::Z, Pauli::Y, false},
+    {Pauli::I, Pauli::Z, false},
+    {Pauli::X, Pauli::Z, false},
+    {Pauli::Y, Pauli::Y, false},
+    {Pauli::Y, Pauli::X, true},
+    {Pauli::X, Pauli::I, false},
+    {Pauli::Y, Pauli::Z, false},
+    {Pauli::X, Pauli::Y, true},
+    {Pauli::X, Pauli::X, false},
+    {Pauli::Y, Pauli::I, false},
+    {Pauli::Z, Pauli::I, false},
+    {Pauli::I, Pauli::X, false},
+    {Pauli::I, Pauli::Y, false},
+    {Pauli::Z, Pauli::Z, false},
+}};
+static constexpr PauliPairImages swap_conj{{
+    {Pauli::I, Pauli::I, false},
+    {Pauli::X, Pauli::I, false},
+    {Pauli::Y, Pauli::I, false},
+    {Pauli::Z, Pauli::I, false},
+    {Pauli::I, Pauli::X, false},
+    {Pauli::X, Pauli::X, false},
+    {Pauli::Y, Pauli::X, false},
+    {Pauli::Z, Pauli::X, false},
+    {Pauli::I, Pauli::Y, false},
+    {Pauli::X, Pauli::Y, false},
+    {Pauli::Y, Pauli::Y, false},
+    {Pauli::Z, Pauli::Y, false},
+    {Pauli::I, Pauli::Z, false},
+    {Pauli::X, Pauli::Z, false},
+    {Pauli::Y, Pauli::Z, false},
+    {Pauli::Z, Pauli::Z, false},
+}};
+
+static const PauliImages& single_qubit_images(OpType op, bool reverse) {
+  switch (op) {
+    case OpType::H:
+      return h_conj;
+    case OpType::S:
+      return reverse ? sdg_conj : s_conj;
+    case OpType::Sdg:
+      return reverse ? s_conj : sdg_conj;
+    case OpType::V:
+      return reverse ? vdg_conj : v_conj;
+    case OpType::Vdg:
+      return reverse ? v_conj : vdg_conj;
+    case OpType::X:
+      return x_conj;
+    case OpType::Y:
+      return y_conj;
+    case OpType::Z:
+      return z_conj;
+    default:
+      throw NotImplemented(
+          "Conjugations of Paulis only defined for H, S, Sdg, V, Vdg, X, Y "
+          "and Z");
+  }
+}
+
+static const PauliPairImages& two_qubit_images(OpType op) {
+  switch (op) {
+    case OpType::CX:
+      return cx_conj;
+    case OpType::CZ:
+      return cz_conj;
+    case OpType::SWAP:
+      return swap_conj;
+    default:
+      throw NotImplemented(
+          "Conjugations of Pauli strings only defined for CX, CZ and SWAP");
   }
-  return conj_lut.at({op, p});
+}
+
+std::pair<Pauli, bool> conjugate_Pauli(OpType op, Pauli p, bool reverse) {
+  const PauliImage& image = single_qubit_images(op, reverse)[p];
+  return {image.p, image.negated};
 }
 
 void conjugate_PauliTensor(
@@ -112,28 +211,7 @@ void conjugate_PauliTensor(
 
 void conjugate_PauliTensor(
     QubitPauliTensor& qpt, OpType op, const Qubit& q0, const Qubit& q1) {
-  static const std::map<std::pair<Pauli, Pauli>, std::tuple<Pauli, Pauli, bool>>
-      cx_conj_lut{
-          {{Pauli::I, Pauli::I}, {Pauli::I, Pauli::I, false}},
-          {{Pauli::I, Pauli::X}, {Pauli::I, Pauli::X, false}},
-          {{Pauli::I, Pauli::Y}, {Pauli::Z, Pauli::Y, false}},
-          {{Pauli::I, Pauli::Z}, {Pauli::Z, Pauli::Z, false}},
-          {{Pauli::X, Pauli::I}, {Pauli::X, Pauli::X, false}},
-          {{Pauli::X, Pauli::X}, {Pauli::X, Pauli::I, false}},
-          {{Pauli::X, Pauli::Y}, {Pauli::Y, Pauli::Z, false}},
-          {{Pauli::X, Pauli::Z}, {Pauli::Y, Pauli::Y, true}},
-          {{Pauli::Y, Pauli::I}, {Pauli::Y, Pauli::X, false}},
-          {{Pauli::Y, Pauli::X}, {Pauli::Y, Pauli::I, false}},
-          {{Pauli::Y, Pauli::Y}, {Pauli::X, Pauli::Z, true}},
-          {{Pauli::Y, Pauli::Z}, {Pauli::X, Pauli::Y, false}},
-          {{Pauli::Z, Pauli::I}, {Pauli::Z, Pauli::I, false}},
-          {{Pauli::Z, Pauli::X}, {Pauli::Z, Pauli::X, false}},
-          {{Pauli::Z, Pauli::Y}, {Pauli::I, Pauli::Y, false}},
-          {{Pauli::Z, Pauli::Z}, {Pauli::I, Pauli::Z, false}},
-      };
-  if (op != OpType::CX) {
-    throw NotImplemented("Conjugations of Pauli strings only defined for CXs");
-  }
+  const PauliPairImages& images = two_qubit_images(op);
   QubitPauliMap::iterator it0 = qpt.string.map.find(q0);
   QubitPauliMap::iterator it1 = qpt.string.map.find(q1);
   Pauli p0, p1;
@@ -147,10 +225,10 @@ void conjugate_PauliTensor(
   } else {
     p1 = it1->second;
   }
-  std::tuple<Pauli, Pauli, bool> conj = cx_conj_lut.at({p0, p1});
-  qpt.string.map[q0] = std::get<0>(conj);
-  qpt.string.map[q1] = std::get<1>(conj);
-  if (std::get<2>(conj)) {
+  const PauliPairImage& image = images[4 * p0 + p1];
+  qpt.string.map[q0] = image.p0;
+  qpt.string.map[q1] = image.p1;
+  if (image.negated) {
     qpt.coeff *= -1;
   }
 }
@@ -194,4 +272,184 @@ void conjugate_PauliTensor(
   }
 }
 
+PackedPauliStrings::PackedPauliStrings(unsigned n_qubits, unsigned n_strings)
+    : n_qubits_(n_qubits),
+      n_strings_(n_strings),
+      n_words_((n_strings + 63) / 64),
+      x_(n_qubits * n_words_, 0),
+      z_(n_qubits * n_words_, 0),
+      negated_(n_words_, 0) {}
+
+void PackedPauliStrings::check_indices(unsigned string, unsigned qubit) const {
+  if (string >= n_strings_ || qubit >= n_qubits_) {
+    throw std::out_of_range("Index out of range of PackedPauliStrings");
+  }
+}
+
+Pauli PackedPauliStrings::get(unsigned string, unsigned qubit) const {
+  check_indices(string, qubit);
+  const unsigned w = qubit * n_words_ + string / 64;
+  const bool x = (x_[w] >> (string % 64)) & 1;
+  const bool z = (z_[w] >> (string % 64)) & 1;
+  if (x) return z ? Pauli::Y : Pauli::X;
+  return z ? Pauli::Z : Pauli::I;
+}
+
+void PackedPauliStrings::set(unsigned string, unsigned qubit, Pauli p) {
+  check_indices(string, qubit);
+  const unsigned w = qubit * n_words_ + string / 64;
+  const std::uint64_t bit = std::uint64_t{1} << (string % 64);
+  if (p == Pauli::X || p == Pauli::Y) {
+    x_[w] |= bit;
+  } else {
+    x_[w] &= ~bit;
+  }
+  if (p == Pauli::Z || p == Pauli::Y) {
+    z_[w] |= bit;
+  } else {
+    z_[w] &= ~bit;
+  }
+}
+
+bool PackedPauliStrings::is_negated(unsigned string) const {
+  check_indices(string, 0);
+  return (negated_[string / 64] >> (string % 64)) & 1;
+}
+
+void PackedPauliStrings::set_negated(unsigned string, bool negated) {
+  check_indices(string, 0);
+  const std::uint64_t bit = std::uint64_t{1} << (string % 64);
+  if (negated) {
+    negated_[string / 64] |= bit;
+  } else {
+    negated_[string / 64] &= ~bit;
+  }
+}
+
+// Each update below is the rule of the corresponding table above, on the
+// symplectic bits (x, z) of I = (0, 0), X = (1, 0), Y = (1, 1), Z = (0, 1).
+// Bits of the planes past n_strings_ stay zero, as every change of a plane
+// is masked by another plane.
+
+void PackedPauliStrings::conjugate(OpType op, unsigned qubit, bool reverse) {
+  check_indices(0, qubit);
+  // S conjugated in reverse acts as Sdg forwards, and so on
+  if (reverse) {
+    switch (op) {
+      case OpType::S:
+        op = OpType::Sdg;
+        break;
+      case OpType::Sdg:
+        op = OpType::S;
+        break;
+      case OpType::V:
+        op = OpType::Vdg;
+        break;
+      case OpType::Vdg:
+        op = OpType::V;
+        break;
+      default:
+        break;
+    }
+  }
+  std::uint64_t *xs = x_plane(qubit);
+  std::uint64_t *zs = z_plane(qubit);
+  auto update = [&](auto rule) {
+    for (unsigned w = 0; w < n_words_; ++w) {
+      rule(xs[w], zs[w], negated_[w]);
+    }
+  };
+  switch (op) {
+    case OpType::H:
+      // X <-> Z, Y -> -Y
+      update([](std::uint64_t &x, std::uint64_t &z, std::uint64_t &neg) {
+        neg ^= x & z;
+        std::swap(x, z);
+      });
+      break;
+    case OpType::S:
+      // X -> -Y, Y -> X
+      update([](std::uint64_t &x, std::uint64_t &z, std::uint64_t &neg) {
+        neg ^= x & ~z;
+        z ^= x;
+      });
+      break;
+    case OpType::Sdg:
+      // X -> Y, Y -> -X
+      update([](std::uint64_t &x, std::uint64_t &z, std::uint64_t &neg) {
+        neg ^= x & z;
+        z ^= x;
+      });
+      break;
+    case OpType::V:
+      // Y -> -Z, Z -> Y
+      update([](std::uint64_t &x, std::uint64_t &z, std::uint64_t &neg) {
+        neg ^= x & z;
+        x ^= z;
+      });
+      break;
+    case OpType::Vdg:
+      // Y -> Z, Z -> -Y
+      update([](std::uint64_t &x, std::uint64_t &z, std::uint64_t &neg) {
+        neg ^= ~x & z;
+        x ^= z;
+      });
+      break;
+    case OpType::X:
+      update([](std::uint64_t &, std::uint64_t &z, std::uint64_t &neg) {
+        neg ^= z;
+      });
+      break;
+    case OpType::Y:
+      update([](std::uint64_t &x, std::uint64_t &z, std::uint64_t &neg) {
+        neg ^= x ^ z;
+      });
+      break;
+    case OpType::Z:
+      update([](std::uint64_t &x, std::uint64_t &, std::uint64_t &neg) {
+        neg ^= x;
+      });
+      break;
+    default:
+      throw NotImplemented(
+          "Conjugations of Paulis only defined for H, S, Sdg, V, Vdg, X, Y "
+          "and Z");
+  }
+}
+
+void PackedPauliStrings::conjugate(OpType op, unsigned q0, unsigned q1) {
+  check_indices(0, q0);
+  check_indices(0, q1);
+  if (q0 == q1) {
+    throw std::invalid_argument("Two-qubit conjugation on a repeated qubit");
+  }
+  std::uint64_t *x0 = x_plane(q0);
+  std::uint64_t *z0 = z_plane(q0);
+  std::uint64_t *x1 = x_plane(q1);
+  std::uint64_t *z1 = z_plane(q1);
+  switch (op) {
+    case OpType::CX:
+      for (unsigned w = 0; w < n_words_; ++w) {
+        negated_[w] ^= x0[w] & z1[w] & ~(x1[w] ^ z0[w]);
+        x1[w] ^= x0[w];
+        z0[w] ^= z1[w];
+      }
+      break;
+    case OpType::CZ:
+      for (unsigned w = 0; w < n_words_; ++w) {
+        negated_[w] ^= x0[w] & x1[w] & (z0[w] ^ z1[w]);
+        z0[w] ^= x1[w];
+        z1[w] ^= x0[w];
+      }
+      break;
+    case OpType::SWAP:
+      std::swap_ranges(x0, x0 + n_words_, x1);
+      std::swap_ranges(z0, z0 + n_words_, z1);
+      break;
+    default:
+      throw NotImplemented(
+          "Conjugations of Pauli strings only defined for CX, CZ and SWAP");
+  }
+}
+
 }  // namespace tket
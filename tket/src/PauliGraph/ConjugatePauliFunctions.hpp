@@ -14,6 +14,9 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include "OpType/OpType.hpp"
 #include "Utils/PauliStrings.hpp"
 
@@ -23,6 +26,8 @@ namespace tket {
  * Captures rules for conjugating a pauli-gadget with single-qubit Clifford
  * gates Maps gate and pauli to the new pauli after the conjugation and whether
  * or not a phase-flip is induced
+ * op must be one of H, S, Sdg, V, Vdg, X, Y, Z; the rules are constant
+ * tables indexed by the Pauli.
  */
 std::pair<Pauli, bool> conjugate_Pauli(
     OpType op, Pauli p, bool reverse = false);
@@ -33,6 +38,7 @@ std::pair<Pauli, bool> conjugate_Pauli(
  * Transforms P to P' such that
  * reverse = false : --P'-- = --op--P--opdg--
  * reverse = true  : --P'-- = --opdg--P--op--
+ * The two-qubit gate may be CX, CZ or SWAP (all self-inverse).
  */
 void conjugate_PauliTensor(
     QubitPauliTensor &qpt, OpType op, const Qubit &q, bool reverse = false);
@@ -42,4 +48,70 @@ void conjugate_PauliTensor(
     QubitPauliTensor &qpt, OpType op, const Qubit &q0, const Qubit &q1,
     const Qubit &qb2);
 
+/**
+ * Many Pauli strings over the same qubits, stored as bit-planes for
+ * conjugating them all by the same Clifford gates: for each qubit there is
+ * a plane of the X components and a plane of the Z components of every
+ * string (Y has both bits set), one string per bit, and one more plane
+ * holds whether each string is negated.
+ *
+ * Conjugating by a generator then only touches the planes of its qubits,
+ * updating 64 strings per word with a few bitwise operations, where
+ * \ref conjugate_PauliTensor looks up each string in turn.
+ */
+class PackedPauliStrings {
+ public:
+  /**
+   * n_strings copies of the identity over n_qubits qubits
+   */
+  PackedPauliStrings(unsigned n_qubits, unsigned n_strings);
+
+  unsigned n_qubits() const { return n_qubits_; }
+  unsigned n_strings() const { return n_strings_; }
+
+  Pauli get(unsigned string, unsigned qubit) const;
+  void set(unsigned string, unsigned qubit, Pauli p);
+
+  /**
+   * Whether the string has coefficient -1 rather than 1
+   */
+  bool is_negated(unsigned string) const;
+  void set_negated(unsigned string, bool negated);
+
+  /**
+   * Conjugate every string by a single-qubit gate, as conjugate_Pauli
+   *
+   * @param op one of H, S, Sdg, V, Vdg, X, Y, Z
+   * @param qubit qubit acted on
+   * @param reverse as for conjugate_PauliTensor
+   */
+  void conjugate(OpType op, unsigned qubit, bool reverse = false);
+
+  /**
+   * Conjugate every string by a two-qubit gate, as conjugate_PauliTensor
+   *
+   * @param op one of CX, CZ, SWAP
+   * @param q0 first qubit (control of CX)
+   * @param q1 second qubit
+   */
+  void conjugate(OpType op, unsigned q0, unsigned q1);
+
+ private:
+  unsigned n_qubits_;
+  unsigned n_strings_;
+  unsigned n_words_;
+  /** Words of the X plane of each qubit in turn, then likewise for Z */
+  std::vector<std::uint64_t> x_;
+  std::vector<std::uint64_t> z_;
+  std::vector<std::uint64_t> negated_;
+
+  std::uint64_t *x_plane(unsigned qubit) {
+    return x_.data() + qubit * n_words_;
+  }
+  std::uint64_t *z_plane(unsigned qubit) {
+    return z_.data() + qubit * n_words_;
+  }
+  void check_indices(unsigned string, unsigned qubit) const;
+};
+
 }  // namespace tket
@@ -14,6 +14,9 @@
 
 #include "PauliGraph.hpp"
 
+#include <algorithm>
+#include <unordered_set>
+
 #include "Gate/Gate.hpp"
 #include "Utils/GraphHeaders.hpp"
 
@@ -24,10 +27,20 @@ bool operator<(
   return (pgp1.tensor_.string < pgp2.tensor_.string);
 }
 
-PauliGraph::PauliGraph(unsigned n) : cliff_(n) {}
+PauliGraph::PauliGraph(unsigned n) : cliff_(n), next_order_(0) {
+  for (const Qubit &qb : cliff_.get_qubits()) {
+    qubit_index_.insert({qb, qubit_index_.size()});
+  }
+  qubit_gadgets_.resize(qubit_index_.size());
+}
 
 PauliGraph::PauliGraph(const qubit_vector_t &qbs, const bit_vector_t &bits)
-    : cliff_(qbs), bits_(bits) {}
+    : cliff_(qbs), bits_(bits), next_order_(0) {
+  for (const Qubit &qb : cliff_.get_qubits()) {
+    qubit_index_.insert({qb, qubit_index_.size()});
+  }
+  qubit_gadgets_.resize(qubit_index_.size());
+}
 
 PauliVertSet PauliGraph::get_successors(const PauliVert &vert) const {
   PauliVertSet succs;
@@ -247,67 +260,130 @@ void PauliGraph::apply_gate_at_end(
   }
 }
 
+void PauliGraph::index_gadget(
+    const PauliVert &vert, const DensePauliString &packed) {
+  const unsigned order = next_order_++;
+  gadget_index_.insert({vert, {order, packed}});
+  bool is_identity = true;
+  for (unsigned q = 0; q < packed.n_qubits(); q++) {
+    if (packed.get(q) != Pauli::I) {
+      qubit_gadgets_[q].insert({order, vert});
+      is_identity = false;
+    }
+  }
+  if (is_identity) identity_gadgets_.insert({order, vert});
+}
+
+void PauliGraph::unindex_gadget(const PauliVert &vert) {
+  const IndexedGadget &gadget = gadget_index_.at(vert);
+  for (unsigned q = 0; q < gadget.packed.n_qubits(); q++) {
+    qubit_gadgets_[q].erase(gadget.order);
+  }
+  identity_gadgets_.erase(gadget.order);
+  gadget_index_.erase(vert);
+}
+
 void PauliGraph::apply_pauli_gadget_at_end(
     const QubitPauliTensor &pauli, const Expr &angle) {
-  PauliVertSet to_search = end_line_;
-  PauliVertSet commuted;
-  PauliVert new_vert = boost::add_vertex(graph_);
-  graph_[new_vert] = {pauli, angle};
-  while (!to_search.empty()) {
-    // Get next candidate parent
-    PauliVert to_compare = *to_search.begin();
-    to_search.erase(to_search.begin());
-
-    // Check that we have already commuted past all of its children
-    bool ready = true;
-    for (const PauliVert &child : get_successors(to_compare)) {
-      if (commuted.get<TagKey>().find(child) == commuted.get<TagKey>().end()) {
-        ready = false;
-        break;
-      }
+  const DensePauliString packed(pauli.string, qubit_index_);
+
+  // Only gadgets sharing a qubit can fail to commute or have the same
+  // string (unless the string is the identity).
+  std::map<unsigned, PauliVert> candidates;
+  for (const std::pair<const Qubit, Pauli> &term : pauli.string.map) {
+    if (term.second == Pauli::I) continue;
+    const std::map<unsigned, PauliVert> &on_qubit =
+        qubit_gadgets_[qubit_index_.at(term.first)];
+    candidates.insert(on_qubit.begin(), on_qubit.end());
+  }
+  if (candidates.empty()) candidates = identity_gadgets_;
+
+  std::unordered_set<PauliVert> anticommuting;
+  std::vector<PauliVert> to_check;  // anti-commuting, in reverse order
+  std::vector<PauliVert> same_string;  // in reverse order
+  for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+    const DensePauliString &other = gadget_index_.at(it->second).packed;
+    if (!packed.commutes_with(other)) {
+      anticommuting.insert(it->second);
+      to_check.push_back(it->second);
+    } else if (packed == other) {
+      same_string.push_back(it->second);
     }
-    if (!ready) continue;
-
-    // Check if we can commute past it
-    QubitPauliTensor compare_pauli = graph_[to_compare].tensor_;
-    if (pauli.commutes_with(compare_pauli)) {
-      if (pauli.string == compare_pauli.string) {
-        // Identical strings - we can merge vertices
-        if (pauli.coeff == compare_pauli.coeff) {
-          graph_[to_compare].angle_ += angle;
-        } else {
-          graph_[to_compare].angle_ -= angle;
+  }
+
+  // Whether any descendant of a vertex anti-commutes with the new gadget.
+  // Descendants are added later than their ancestors, so the search stops at
+  // gadgets added after the last anti-commuting one.
+  const unsigned last_order =
+      to_check.empty() ? 0 : gadget_index_.at(to_check.front()).order;
+  std::unordered_set<PauliVert> clear_below;
+  std::unordered_set<PauliVert> blocked_below;
+  auto has_anticommuting_descendant = [&](const PauliVert &root) {
+    std::vector<PauliVert> stack{root};
+    std::unordered_set<PauliVert> visited{root};
+    while (!stack.empty()) {
+      PauliVert v = stack.back();
+      stack.pop_back();
+      for (auto iter = boost::adjacent_vertices(v, graph_);
+           iter.first != iter.second; iter.first++) {
+        const PauliVert &child = *iter.first;
+        if (anticommuting.contains(child) || blocked_below.contains(child)) {
+          blocked_below.insert(root);
+          return true;
         }
-        boost::clear_vertex(new_vert, graph_);
-        boost::remove_vertex(new_vert, graph_);
-
-        std::optional<unsigned> cl_ang =
-            equiv_Clifford(graph_[to_compare].angle_);
-        if (cl_ang) {
-          cliff_.apply_pauli_at_front(graph_[to_compare].tensor_, *cl_ang);
-          start_line_.erase(to_compare);
-          for (const PauliVert &v : get_predecessors(to_compare)) {
-            if (boost::out_degree(v, graph_) == 1) {
-              end_line_.insert(v);
-            }
-          }
-          end_line_.erase(to_compare);
-          boost::clear_vertex(to_compare, graph_);
-          boost::remove_vertex(to_compare, graph_);
+        if (gadget_index_.at(child).order > last_order ||
+            clear_below.contains(child) || !visited.insert(child).second) {
+          continue;
         }
-        return;
-      } else {
-        // Commute and continue searching
-        PauliVertSet preds = get_predecessors(to_compare);
-        to_search.insert(preds.begin(), preds.end());
-        commuted.insert(to_compare);
+        stack.push_back(child);
       }
+    }
+    clear_below.insert(visited.begin(), visited.end());
+    return false;
+  };
+
+  // Merge into the latest gadget with the same string that the new one can
+  // be commuted back to.
+  std::vector<PauliVert>::const_iterator to_merge = std::find_if_not(
+      same_string.cbegin(), same_string.cend(), has_anticommuting_descendant);
+  if (to_merge != same_string.cend()) {
+    // Identical strings - we can merge vertices
+    const PauliVert to_compare = *to_merge;
+    if (pauli.coeff == graph_[to_compare].tensor_.coeff) {
+      graph_[to_compare].angle_ += angle;
     } else {
-      // Does not commute - add dependency edge
-      boost::add_edge(to_compare, new_vert, graph_);
+      graph_[to_compare].angle_ -= angle;
+    }
+
+    std::optional<unsigned> cl_ang = equiv_Clifford(graph_[to_compare].angle_);
+    if (cl_ang) {
+      cliff_.apply_pauli_at_front(graph_[to_compare].tensor_, *cl_ang);
+      start_line_.erase(to_compare);
+      for (const PauliVert &v : get_predecessors(to_compare)) {
+        if (boost::out_degree(v, graph_) == 1) {
+          end_line_.insert(v);
+        }
+      }
       end_line_.erase(to_compare);
+      unindex_gadget(to_compare);
+      boost::clear_vertex(to_compare, graph_);
+      boost::remove_vertex(to_compare, graph_);
     }
+    return;
+  }
+
+  std::vector<PauliVert> parents;
+  for (const PauliVert &v : to_check) {
+    if (!has_anticommuting_descendant(v)) parents.push_back(v);
+  }
+  PauliVert new_vert = boost::add_vertex(graph_);
+  graph_[new_vert] = {pauli, angle};
+  for (auto it = parents.rbegin(); it != parents.rend(); ++it) {
+    // Does not commute - add dependency edge
+    boost::add_edge(*it, new_vert, graph_);
+    end_line_.erase(*it);
   }
+  index_gadget(new_vert, packed);
   end_line_.insert(new_vert);
   if (get_predecessors(new_vert).empty()) start_line_.insert(new_vert);
 }
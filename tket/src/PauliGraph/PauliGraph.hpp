@@ -15,8 +15,10 @@
 #pragma once
 
 #include <fstream>
+#include <functional>
 
 #include "Clifford/CliffTableau.hpp"
+#include "Utils/DensePauliString.hpp"
 #include "Utils/Expression.hpp"
 #include "Utils/GraphHeaders.hpp"
 #include "Utils/PauliStrings.hpp"
@@ -83,6 +85,9 @@ class PauliGraph {
       const PauliGraph &pg, CXConfigType cx_config);
   friend Circuit pauli_graph_to_circuit_sets(
       const PauliGraph &pg, CXConfigType cx_config);
+  friend void pauli_graph_to_circuit_streaming(
+      PauliGraph &pg, const std::function<void(const Circuit &)> &sink,
+      bool pairwise, CXConfigType cx_config);
 
  private:
   /** The dependency graph of Pauli gadgets */
@@ -99,6 +104,27 @@ class PauliGraph {
   PauliVertSet start_line_;
   PauliVertSet end_line_;
 
+  /**
+   * Index of the gadgets by the qubits they act on, so that a new gadget is
+   * only compared against gadgets sharing a qubit with it. Each gadget is
+   * stored with its string packed over the tableau's qubits and the order in
+   * which it was added; the order is a topological order of the graph.
+   */
+  struct IndexedGadget {
+    unsigned order;
+    DensePauliString packed;
+  };
+  std::map<Qubit, unsigned> qubit_index_;
+  std::unordered_map<PauliVert, IndexedGadget> gadget_index_;
+  /** Live gadgets acting on each qubit, keyed by order */
+  std::vector<std::map<unsigned, PauliVert>> qubit_gadgets_;
+  /** Live gadgets with the identity string, keyed by order */
+  std::map<unsigned, PauliVert> identity_gadgets_;
+  unsigned next_order_;
+
+  void index_gadget(const PauliVert &vert, const DensePauliString &packed);
+  void unindex_gadget(const PauliVert &vert);
+
   PauliVertSet get_successors(const PauliVert &vert) const;
   PauliVertSet get_predecessors(const PauliVert &vert) const;
   PauliEdgeSet get_in_edges(const PauliVert &vert) const;
@@ -110,6 +136,10 @@ class PauliGraph {
    * Appends a pauli gadget at the end of the dependency graph.
    * Assumes this is the result AFTER pushing it through the Clifford
    * tableau.
+   *
+   * The gadget depends on each anti-commuting gadget that has no
+   * anti-commuting descendant; if a gadget with the same string has no
+   * anti-commuting descendant, the two are merged instead.
    */
   void apply_pauli_gadget_at_end(
       const QubitPauliTensor &pauli, const Expr &angle);
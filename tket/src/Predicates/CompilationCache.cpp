@@ -0,0 +1,219 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CompilationCache.hpp"
+
+#include <fstream>
+
+#include "Utils/Json.hpp"
+
+namespace tket {
+
+// Pass configurations mark parameters which cannot be serialized (such as
+// functions and metrics) with a placeholder string, so two passes differing
+// only in those parameters have the same configuration.
+static bool has_placeholder(const nlohmann::json& j) {
+  if (j.is_string()) {
+    return j.get<std::string>().rfind("SERIALIZATION", 0) == 0;
+  }
+  if (j.is_structured()) {
+    for (const nlohmann::json& child : j) {
+      if (has_placeholder(child)) return true;
+    }
+  }
+  return false;
+}
+
+static nlohmann::json unit_to_json(const UnitID& u) {
+  nlohmann::json j;
+  if (u.type() == UnitType::Qubit) {
+    j["qubit"] = Qubit(u);
+  } else {
+    j["bit"] = Bit(u);
+  }
+  return j;
+}
+
+static UnitID unit_from_json(const nlohmann::json& j) {
+  if (j.contains("qubit")) return j.at("qubit").get<Qubit>();
+  return j.at("bit").get<Bit>();
+}
+
+static nlohmann::json bimap_to_json(const unit_bimap_t& map) {
+  nlohmann::json j = nlohmann::json::array();
+  for (const unit_bimap_t::left_value_type& pair : map.left) {
+    j.push_back({unit_to_json(pair.first), unit_to_json(pair.second)});
+  }
+  return j;
+}
+
+static unit_bimap_t bimap_from_json(const nlohmann::json& j) {
+  unit_bimap_t map;
+  for (const nlohmann::json& pair : j) {
+    map.insert({unit_from_json(pair.at(0)), unit_from_json(pair.at(1))});
+  }
+  return map;
+}
+
+CompilationCache::CompilationCache(unsigned capacity)
+    : capacity_(capacity), n_hits_(0), n_misses_(0) {}
+
+std::string CompilationCache::fingerprint(
+    const BasePass& pass, const CompilationUnit& c_unit) {
+  nlohmann::json j;
+  j["pass"] = pass.get_config();
+  if (has_placeholder(j["pass"])) {
+    throw std::logic_error(
+        "Cannot cache a pass whose configuration is not fully serializable");
+  }
+  j["circuit"] = c_unit.get_circ_ref();
+  j["initial_map"] = bimap_to_json(c_unit.get_initial_map_ref());
+  j["final_map"] = bimap_to_json(c_unit.get_final_map_ref());
+  return j.dump();
+}
+
+bool CompilationCache::apply(
+    const BasePass& pass, CompilationUnit& c_unit, SafetyMode safe_mode) {
+  const std::string key = fingerprint(pass, c_unit);
+  std::optional<Entry> found = find(key);
+  if (!found) {
+    bool changed = pass.apply(c_unit, safe_mode);
+    insert(
+        key,
+        {c_unit.circ_.share(), c_unit.initial_map_, c_unit.final_map_,
+         changed});
+    return changed;
+  }
+  c_unit.circ_ = std::move(found->circ);
+  c_unit.initial_map_ = std::move(found->initial_map);
+  c_unit.final_map_ = std::move(found->final_map);
+  c_unit.memo_.clear();
+  c_unit.memo_version_.reset();
+  // Same update of the predicate cache as `BasePass::update_cache`
+  PassConditions conditions = pass.get_conditions();
+  for (std::pair<const std::type_index, std::pair<PredicatePtr, bool>>& entry :
+       c_unit.cache_) {
+    if (BasePass::get_guarantee(entry.first, conditions) == Guarantee::Clear)
+      entry.second.second = false;
+  }
+  for (const TypePredicatePair& pp : conditions.second.specific_postcons_) {
+    c_unit.cache_[pp.first] = {pp.second, true};
+  }
+  return found->changed;
+}
+
+std::optional<CompilationCache::Entry> CompilationCache::find(
+    const std::string& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unordered_map<std::string, EntryList::iterator>::iterator it =
+      index_.find(key);
+  if (it == index_.end()) {
+    ++n_misses_;
+    return std::nullopt;
+  }
+  ++n_hits_;
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->second;
+}
+
+void CompilationCache::insert(const std::string& key, Entry entry) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (capacity_ == 0) return;
+  std::unordered_map<std::string, EntryList::iterator>::iterator it =
+      index_.find(key);
+  if (it != index_.end()) {
+    it->second->second = std::move(entry);
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return;
+  }
+  entries_.emplace_front(key, std::move(entry));
+  index_.insert({key, entries_.begin()});
+  if (entries_.size() > capacity_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+}
+
+unsigned CompilationCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+unsigned CompilationCache::n_hits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return n_hits_;
+}
+
+unsigned CompilationCache::n_misses() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return n_misses_;
+}
+
+void CompilationCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  index_.clear();
+  n_hits_ = 0;
+  n_misses_ = 0;
+}
+
+void CompilationCache::save(const std::string& filename) const {
+  nlohmann::json j = nlohmann::json::array();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const std::pair<const std::string, Entry>& kv : entries_) {
+      nlohmann::json entry;
+      entry["key"] = kv.first;
+      entry["circuit"] = *kv.second.circ;
+      entry["initial_map"] = bimap_to_json(kv.second.initial_map);
+      entry["final_map"] = bimap_to_json(kv.second.final_map);
+      entry["changed"] = kv.second.changed;
+      j.push_back(entry);
+    }
+  }
+  std::ofstream file(filename);
+  file << j.dump();
+  if (!file) {
+    throw std::runtime_error(
+        "Could not write compilation cache to " + filename);
+  }
+}
+
+void CompilationCache::load(const std::string& filename) {
+  std::ifstream file(filename);
+  std::vector<std::pair<std::string, Entry>> loaded;
+  try {
+    nlohmann::json j;
+    file >> j;
+    for (const nlohmann::json& entry : j) {
+      loaded.push_back(
+          {entry.at("key").get<std::string>(),
+           {std::make_shared<Circuit>(entry.at("circuit").get<Circuit>()),
+            bimap_from_json(entry.at("initial_map")),
+            bimap_from_json(entry.at("final_map")),
+            entry.at("changed").get<bool>()}});
+    }
+  } catch (const nlohmann::json::exception&) {
+    throw std::runtime_error(
+        "Could not read compilation cache from " + filename);
+  }
+  // Insert the least recently used first so that the order is kept
+  for (std::vector<std::pair<std::string, Entry>>::reverse_iterator it =
+           loaded.rbegin();
+       it != loaded.rend(); ++it) {
+    insert(it->first, std::move(it->second));
+  }
+}
+
+}  // namespace tket
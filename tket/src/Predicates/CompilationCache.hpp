@@ -0,0 +1,106 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "CompilerPass.hpp"
+
+namespace tket {
+
+/**
+ * Store of the results of applying passes to circuits.
+ *
+ * Entries are keyed by a fingerprint of the serialized circuit, the pass
+ * configuration and the initial and final maps of the CompilationUnit, and
+ * hold the resulting circuit and maps. At most `capacity` entries are kept,
+ * the least recently used being evicted first. Safe to use from several
+ * threads at once; the pass itself is applied outside the lock.
+ */
+class CompilationCache {
+ public:
+  explicit CompilationCache(unsigned capacity = 128);
+
+  /**
+   * Canonical fingerprint of a pass application.
+   *
+   * @throw std::logic_error if the pass is not serializable
+   */
+  static std::string fingerprint(
+      const BasePass& pass, const CompilationUnit& c_unit);
+
+  /**
+   * Apply a pass, reusing a stored result for the same input if there is one.
+   *
+   * On a stored result the circuit and maps of `c_unit` are replaced, and its
+   * predicate cache is updated from the postconditions of the pass as it
+   * would be by applying it; the callbacks of `BasePass::apply` are not
+   * invoked. Otherwise the pass is applied and the result stored.
+   *
+   * @return True if the pass modified the circuit, else False
+   */
+  bool apply(
+      const BasePass& pass, CompilationUnit& c_unit,
+      SafetyMode safe_mode = SafetyMode::Default);
+
+  unsigned size() const;
+  unsigned capacity() const { return capacity_; }
+  unsigned n_hits() const;
+  unsigned n_misses() const;
+  void clear();
+
+  /**
+   * Write all entries to a JSON file, most recently used first.
+   *
+   * @throw std::runtime_error if the file cannot be written
+   */
+  void save(const std::string& filename) const;
+
+  /**
+   * Add the entries of a file written by \ref save, replacing existing ones
+   * with the same fingerprint.
+   *
+   * @throw std::runtime_error if the file cannot be read
+   */
+  void load(const std::string& filename);
+
+ private:
+  struct Entry {
+    /** Shared with the compilation units it was taken from or given to */
+    std::shared_ptr<const Circuit> circ;
+    unit_bimap_t initial_map;
+    unit_bimap_t final_map;
+    bool changed;
+  };
+  typedef std::list<std::pair<std::string, Entry>> EntryList;
+
+  unsigned capacity_;
+  mutable std::mutex mutex_;
+  // Entries, most recently used first
+  EntryList entries_;
+  std::unordered_map<std::string, EntryList::iterator> index_;
+  unsigned n_hits_;
+  unsigned n_misses_;
+
+  std::optional<Entry> find(const std::string& key);
+  void insert(const std::string& key, Entry entry);
+};
+
+}  // namespace tket
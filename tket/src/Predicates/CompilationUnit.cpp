@@ -13,6 +13,11 @@
 // limitations under the License.
 
 #include "CompilationUnit.hpp"
+
+#include <algorithm>
+#include <set>
+#include <utility>
+
 namespace tket {
 
 CompilationUnit::CompilationUnit(const Circuit& circ) : circ_(circ) {
@@ -41,20 +46,70 @@ TypePredicatePair CompilationUnit::make_type_pair(const PredicatePtr& ptr) {
 }
 
 bool CompilationUnit::calc_predicate(const Predicate& pred) const {
-  return pred.verify(circ_);
+  return pred.verify(circ_.get());
+}
+
+bool CompilationUnit::calc_predicate(const PredicatePtr& pred) const {
+  if (!memo_version_ || !circ_->has_version(*memo_version_)) {
+    memo_.clear();
+    memo_version_ = circ_->get_version();
+  }
+  std::map<const Predicate*, std::pair<PredicatePtr, bool>>::const_iterator
+      found = memo_.find(pred.get());
+  if (found != memo_.end()) return found->second.second;
+  bool result = pred->verify(circ_.get());
+  // Keep `pred` alive so that its address is not reused by another predicate
+  memo_.insert({pred.get(), {pred, result}});
+  return result;
 }
 
 bool CompilationUnit::check_all_predicates() const {
   for (const TypePredicatePair& ref_pred : target_preds) {
-    if (!calc_predicate(*ref_pred.second)) return false;
+    if (!calc_predicate(ref_pred.second)) return false;
   }
   return true;
 }
 
+Circuit& CompilationUnit::SharedCircuit::get_mutable() {
+  // A unique owner cannot be copied concurrently, so a count of 1 is exact.
+  if (ptr_.use_count() > 1) ptr_ = std::make_shared<Circuit>(*ptr_);
+  // Every circuit held here was created non-const.
+  return const_cast<Circuit&>(*ptr_);
+}
+
+std::shared_ptr<const Circuit> CompilationUnit::SharedCircuit::share() const {
+  if (ptr_->is_recording_changes()) return std::make_shared<Circuit>(*ptr_);
+  return ptr_;
+}
+
+void CompilationUnit::record_changes(bool enable) {
+  circ_.get_mutable().record_changes(enable);
+  std::fill(checkpoints_.begin(), checkpoints_.end(), 0);
+}
+
+std::optional<Circuit::ChangeLog> CompilationUnit::get_changes() const {
+  if (!circ_->is_recording_changes()) return std::nullopt;
+  return circ_->get_changes_since(
+      checkpoints_.empty() ? 0 : checkpoints_.back());
+}
+
+CompilationUnit::PassCheckpoint::PassCheckpoint(CompilationUnit& c_unit)
+    : c_unit_(c_unit), pushed_(c_unit.circ_->is_recording_changes()) {
+  if (pushed_) {
+    c_unit_.checkpoints_.push_back(c_unit_.circ_->get_change_checkpoint());
+  }
+}
+
+CompilationUnit::PassCheckpoint::~PassCheckpoint() {
+  if (pushed_ && !c_unit_.checkpoints_.empty()) {
+    c_unit_.checkpoints_.pop_back();
+  }
+}
+
 std::string CompilationUnit::to_string() const {
   std::string str = "~~~CompilationUnit~~~\n<tket::Circuit qubits=" +
-                    std::to_string(circ_.n_qubits()) +
-                    ", gates=" + std::to_string(circ_.n_gates()) + ">\n";
+                    std::to_string(circ_->n_qubits()) +
+                    ", gates=" + std::to_string(circ_->n_gates()) + ">\n";
 
   if (!target_preds.empty()) {
     str += "Target Predicates:\n";
@@ -75,6 +130,50 @@ std::string CompilationUnit::to_string() const {
   return str;
 }
 
+std::size_t CompilationUnit::MemoryUsage::total() const {
+  return circuit.total() + unit_maps + predicates + other;
+}
+
+CompilationUnit::MemoryUsage CompilationUnit::memory_usage() const {
+  // Link pointers of a node of a red-black tree
+  constexpr std::size_t tree_node_bytes = 3 * sizeof(void*);
+  // A predicate and the control block of its shared pointer
+  constexpr std::size_t predicate_bytes =
+      sizeof(Predicate) + 2 * sizeof(long) + sizeof(void*);
+
+  MemoryUsage usage;
+  usage.circuit = circ_->memory_usage();
+  // A bimap node holds both units and links into a tree for each side.
+  usage.unit_maps = (initial_map_.size() + final_map_.size()) *
+                    (2 * sizeof(UnitID) + 2 * tree_node_bytes);
+
+  std::set<const Predicate*> preds;
+  auto add_pred = [&](const PredicatePtr& pred) {
+    if (pred && preds.insert(pred.get()).second) {
+      usage.predicates += predicate_bytes;
+    }
+  };
+  for (const TypePredicatePair& pp : target_preds) {
+    usage.predicates += sizeof(pp) + tree_node_bytes;
+    add_pred(pp.second);
+  }
+  for (const std::pair<const std::type_index, std::pair<PredicatePtr, bool>>&
+           tp : cache_) {
+    usage.predicates += sizeof(tp) + tree_node_bytes;
+    add_pred(tp.second.first);
+  }
+  for (const std::pair<
+           const Predicate* const, std::pair<PredicatePtr, bool>>& entry :
+       memo_) {
+    usage.predicates += sizeof(entry) + tree_node_bytes;
+    add_pred(entry.second.first);
+  }
+
+  usage.other = sizeof(CompilationUnit) +
+                checkpoints_.capacity() * sizeof(std::size_t);
+  return usage;
+}
+
 void CompilationUnit::empty_cache() const { cache_ = {}; }
 
 void CompilationUnit::initialize_cache() const {
@@ -85,7 +184,7 @@ void CompilationUnit::initialize_cache() const {
     std::type_index ti = typeid(p);
     if (cache_.find(ti) != cache_.end())
       throw std::logic_error("Duplicate verify type in Predicate list");
-    bool to_cache = calc_predicate(p);
+    bool to_cache = calc_predicate(pr.second);
     cache_.insert({ti, {pr.second, to_cache}});
   }
 }
@@ -95,7 +194,7 @@ void CompilationUnit::initialize_maps() {
     throw std::logic_error("Initial map must be empty to be initialized");
   if (!final_map_.empty())
     throw std::logic_error("Final map must be empty to be initialized");
-  for (const UnitID& u : circ_.all_units()) {
+  for (const UnitID& u : circ_->all_units()) {
     initial_map_.insert({u, u});
     final_map_.insert({u, u});
   }
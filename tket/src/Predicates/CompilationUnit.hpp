@@ -14,6 +14,11 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
 #include "Predicates.hpp"
 
 namespace tket {
@@ -36,38 +41,154 @@ class CompilationUnit {
   CompilationUnit(const Circuit& circ, const std::vector<PredicatePtr>& preds);
 
   bool calc_predicate(const Predicate& pred) const;
+
+  /**
+   * Evaluate a predicate, reusing the result of an earlier evaluation of the
+   * same predicate object if the circuit has not changed since.
+   */
+  bool calc_predicate(const PredicatePtr& pred) const;
   bool check_all_predicates()
       const;  // returns false if any of the preds are unsatisfied
 
   /* getters to inspect the data members */
-  const Circuit& get_circ_ref() const { return circ_; }
+  const Circuit& get_circ_ref() const { return circ_.get(); }
   const PredicateCache& get_cache_ref() const { return cache_; }
   const unit_bimap_t& get_initial_map_ref() const { return initial_map_; }
   const unit_bimap_t& get_final_map_ref() const { return final_map_; }
   std::string to_string() const;
 
+  /** Estimated memory used by a unit, in bytes, as from \ref memory_usage */
+  struct MemoryUsage {
+    /**
+     * The circuit, as from \ref Circuit::memory_usage
+     *
+     * Copies of a unit share its circuit until one is modified, so this may
+     * also be counted by other units.
+     */
+    Circuit::MemoryUsage circuit;
+    /** Initial and final unit maps */
+    std::size_t unit_maps = 0;
+    /** Target predicates and cached predicate results */
+    std::size_t predicates = 0;
+    /** The unit object itself and its pass checkpoints */
+    std::size_t other = 0;
+
+    /** Sum over all categories, including those of the circuit */
+    std::size_t total() const;
+  };
+
+  /**
+   * Estimate the memory used by the unit, on the same terms as
+   * \ref Circuit::memory_usage. Predicate objects are counted at the size of
+   * their common base.
+   */
+  MemoryUsage memory_usage() const;
+
+  /**
+   * Start or stop recording the changes made to the circuit, so that pass
+   * callbacks can inspect them with \ref get_changes instead of comparing
+   * copies of the circuit.
+   *
+   * Starting discards the changes recorded so far. Copies of the unit do not
+   * record; they also do not share the circuit of a recording unit, so copy
+   * it at once.
+   */
+  void record_changes(bool enable);
+
+  /**
+   * The changes made to the circuit by the innermost pass being applied (so,
+   * in an `after_apply` callback, by the pass just applied), or since
+   * recording started if no pass is being applied.
+   *
+   * @return the changes, or std::nullopt if changes are not being recorded
+   */
+  std::optional<Circuit::ChangeLog> get_changes() const;
+
+  /**
+   * Marks the application of a pass to a unit for \ref get_changes, for the
+   * lifetime of the object.
+   */
+  class PassCheckpoint {
+   public:
+    explicit PassCheckpoint(CompilationUnit& c_unit);
+    ~PassCheckpoint();
+
+    PassCheckpoint(const PassCheckpoint&) = delete;
+    PassCheckpoint& operator=(const PassCheckpoint&) = delete;
+
+   private:
+    CompilationUnit& c_unit_;
+    bool pushed_;
+  };
+
   friend class Circuit;
   friend class BasePass;
   friend class StandardPass;
+  friend class CompilationCache;
 
   static TypePredicatePair make_type_pair(const PredicatePtr& ptr);
 
  private:
+  /**
+   * A circuit shared between copies of a unit until one of them modifies it.
+   *
+   * Copying a unit (as passes such as \ref RepeatWithMetricPass do to try
+   * candidates) then costs no copy of its DAG, which is only made if the
+   * copy is modified. A circuit that is recording changes is never shared,
+   * so that the recording unit keeps its vertices and log.
+   */
+  class SharedCircuit {
+   public:
+    explicit SharedCircuit(const Circuit& circ)
+        : ptr_(std::make_shared<Circuit>(circ)) {}
+    SharedCircuit(const SharedCircuit& other) : ptr_(other.share()) {}
+    SharedCircuit(SharedCircuit&&) = default;
+    SharedCircuit& operator=(const SharedCircuit& other) {
+      ptr_ = other.share();
+      return *this;
+    }
+    SharedCircuit& operator=(SharedCircuit&&) = default;
+    /** Share a circuit, which must have been created non-const */
+    SharedCircuit& operator=(std::shared_ptr<const Circuit> circ) {
+      ptr_ = std::move(circ);
+      return *this;
+    }
+
+    const Circuit& get() const { return *ptr_; }
+    const Circuit* operator->() const { return ptr_.get(); }
+
+    /** The circuit, copied first if it is shared */
+    Circuit& get_mutable();
+
+    /** A pointer to share the circuit with, never to be modified through */
+    std::shared_ptr<const Circuit> share() const;
+
+   private:
+    std::shared_ptr<const Circuit> ptr_;
+  };
+
   void empty_cache() const;
   void initialize_cache() const;
   void initialize_maps();
-  Circuit circ_;  // modified continuously
+  SharedCircuit circ_;  // modified continuously, through get_mutable()
   PredicatePtrMap
       target_preds;  // these are the predicates you WANT your circuit to
                      // satisfy by the end of your Compiler Passes
   mutable PredicateCache cache_;  // updated continuously
 
+  /** Results of `calc_predicate` for the circuit at `memo_version_` */
+  mutable std::map<const Predicate*, std::pair<PredicatePtr, bool>> memo_;
+  mutable std::optional<Circuit::Version> memo_version_;
+
   /** Map from original logical qubits to corresponding current qubits wtr
    * inputs */
   unit_bimap_t initial_map_;
   /** Map from original logical qubits to corresponding current qubits wtr
    * outputs */
   unit_bimap_t final_map_;
+
+  /** Change log checkpoints of the passes being applied, innermost last */
+  std::vector<std::size_t> checkpoints_;
 };
 
 }  // namespace tket
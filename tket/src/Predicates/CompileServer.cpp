@@ -0,0 +1,145 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CompileServer.hpp"
+
+#include <sstream>
+
+#include "Circuit/CircuitBinary.hpp"
+#include "Utils/Json.hpp"
+#include "Utils/Parallel.hpp"
+
+namespace tket {
+
+static Circuit read_circuit(const std::string& data, CircuitFormat format) {
+  if (format == CircuitFormat::Binary) {
+    return read_circuit_binary(data.data(), data.size());
+  }
+  return nlohmann::json::parse(data).get<Circuit>();
+}
+
+static std::string write_circuit(const Circuit& circ, CircuitFormat format) {
+  if (format == CircuitFormat::Binary) {
+    std::ostringstream out;
+    write_circuit_binary(out, circ);
+    return out.str();
+  }
+  return nlohmann::json(circ).dump();
+}
+
+CompileServer::CompileServer(unsigned n_workers, unsigned cache_capacity)
+    : cache_(cache_capacity) {
+  if (n_workers == 0) n_workers = get_max_threads();
+  workers_.reserve(n_workers);
+  for (unsigned i = 0; i < n_workers; i++) {
+    workers_.emplace_back([this]() { work(); });
+  }
+}
+
+CompileServer::~CompileServer() {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    stopping_ = true;
+  }
+  queue_cv_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+}
+
+std::future<CompileResponse> CompileServer::submit(CompileRequest request) {
+  std::promise<CompileResponse> promise;
+  std::future<CompileResponse> future = promise.get_future();
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    queue_.push_back({std::move(request), std::move(promise)});
+  }
+  queue_cv_.notify_one();
+  return future;
+}
+
+void CompileServer::work() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_cv_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+      // Requests already queued are finished before stopping
+      if (queue_.empty()) return;
+      job = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    job.promise.set_value(compile(job.request));
+  }
+}
+
+CompileResponse CompileServer::compile(const CompileRequest& request) {
+  CompileResponse response;
+  try {
+    PassPtr pass = get_pass(request.pass);
+    CompilationUnit c_unit(read_circuit(request.circuit, request.format));
+    response.changed = cache_.apply(*pass, c_unit);
+    response.circuit = write_circuit(c_unit.get_circ_ref(), request.format);
+    response.initial_map = c_unit.get_initial_map_ref();
+    response.final_map = c_unit.get_final_map_ref();
+  } catch (const std::exception& e) {
+    response = CompileResponse();
+    response.error = e.what();
+  }
+  return response;
+}
+
+std::vector<CompileResponse> CompileServer::compile_all(
+    const std::vector<CompileRequest>& requests) {
+  std::vector<std::future<CompileResponse>> futures;
+  futures.reserve(requests.size());
+  for (const CompileRequest& request : requests) {
+    futures.push_back(submit(request));
+  }
+  std::vector<CompileResponse> responses;
+  responses.reserve(requests.size());
+  for (std::future<CompileResponse>& future : futures) {
+    responses.push_back(future.get());
+  }
+  return responses;
+}
+
+PassPtr CompileServer::get_pass(const std::string& pass_json) {
+  const nlohmann::json j = nlohmann::json::parse(pass_json);
+  // Serializations differing only in layout share a pass
+  const std::string key = j.dump();
+  {
+    std::lock_guard<std::mutex> lock(passes_mutex_);
+    auto it = passes_.find(key);
+    if (it != passes_.end()) return it->second;
+  }
+  // Deserialized outside the lock, as it may precompute much; if another
+  // thread has kept the same pass meanwhile, that one is used
+  PassPtr pass = j.get<PassPtr>();
+  std::lock_guard<std::mutex> lock(passes_mutex_);
+  return passes_.insert({key, pass}).first->second;
+}
+
+unsigned CompileServer::n_passes() const {
+  std::lock_guard<std::mutex> lock(passes_mutex_);
+  return passes_.size();
+}
+
+void CompileServer::clear() {
+  {
+    std::lock_guard<std::mutex> lock(passes_mutex_);
+    passes_.clear();
+  }
+  cache_.clear();
+}
+
+}  // namespace tket
@@ -0,0 +1,160 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "CompilationCache.hpp"
+#include "CompilerPass.hpp"
+
+namespace tket {
+
+/** Serialization of the circuits of a \ref CompileRequest */
+enum class CircuitFormat {
+  /** The JSON serialization of the circuit */
+  JSON,
+  /** The format of \ref write_circuit_binary */
+  Binary
+};
+
+/** A circuit to compile, and the pass to compile it with */
+struct CompileRequest {
+  /** Serialized circuit */
+  std::string circuit;
+  /** Format of \ref circuit, and of the compiled circuit returned */
+  CircuitFormat format = CircuitFormat::JSON;
+  /** JSON serialization of the pass, as from BasePass::get_config */
+  std::string pass;
+};
+
+/** Result of a \ref CompileRequest */
+struct CompileResponse {
+  /** Compiled circuit, in the format of the request */
+  std::string circuit;
+  /** Whether the pass modified the circuit */
+  bool changed = false;
+  /** Initial map of the compilation unit after the pass */
+  unit_bimap_t initial_map;
+  /** Final map of the compilation unit after the pass */
+  unit_bimap_t final_map;
+  /**
+   * Description of the error if the request could not be completed, in
+   * which case the other fields are empty; empty on success
+   */
+  std::string error;
+};
+
+/**
+ * Long-lived compiler for a stream of requests, keeping its state warm
+ * between them.
+ *
+ * Each distinct pass serialization is deserialized once and kept, together
+ * with what its construction precomputed (such as the \ref RoutingContext of
+ * a routing pass, with the distances of its architecture), so that later
+ * requests with the same pass skip that work. Results are stored in a
+ * \ref CompilationCache, so that a request repeating an earlier one returns
+ * its result without compiling again.
+ *
+ * Requests are compiled on a fixed set of worker threads, started with the
+ * server and stopped when it is destroyed, each request by a single worker.
+ * Reading and writing requests is left to the host: the server takes and
+ * returns serialized circuits, so a loop reading a socket or a queue in
+ * shared memory need only pass their bytes through.
+ */
+class CompileServer {
+ public:
+  /**
+   * Start the worker threads.
+   *
+   * @param n_workers number of worker threads; 0 for the number of hardware
+   *   threads
+   * @param cache_capacity capacity of the result cache
+   */
+  explicit CompileServer(unsigned n_workers = 0, unsigned cache_capacity = 128);
+
+  /** Finish the requests already submitted, then stop the workers */
+  ~CompileServer();
+
+  CompileServer(const CompileServer&) = delete;
+  CompileServer& operator=(const CompileServer&) = delete;
+
+  /**
+   * Queue a request for the workers.
+   *
+   * Errors in the request are reported in \ref CompileResponse::error rather
+   * than through the future.
+   */
+  std::future<CompileResponse> submit(CompileRequest request);
+
+  /**
+   * Compile a request in the calling thread.
+   *
+   * Errors in the request are reported in \ref CompileResponse::error.
+   */
+  CompileResponse compile(const CompileRequest& request);
+
+  /**
+   * Compile several requests on the workers, waiting for all of them.
+   *
+   * @return responses in the order of the requests
+   */
+  std::vector<CompileResponse> compile_all(
+      const std::vector<CompileRequest>& requests);
+
+  /**
+   * The pass with a JSON serialization, deserialized on first use and kept.
+   *
+   * @throw JsonError or nlohmann::json::exception if the pass cannot be
+   *   deserialized
+   */
+  PassPtr get_pass(const std::string& pass_json);
+
+  /** Number of distinct passes kept */
+  unsigned n_passes() const;
+
+  unsigned n_workers() const { return workers_.size(); }
+
+  const CompilationCache& get_cache() const { return cache_; }
+
+  /** Forget the passes kept and the results stored */
+  void clear();
+
+ private:
+  struct Job {
+    CompileRequest request;
+    std::promise<CompileResponse> promise;
+  };
+
+  CompilationCache cache_;
+  mutable std::mutex passes_mutex_;
+  std::unordered_map<std::string, PassPtr> passes_;
+
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cv_;
+  std::deque<Job> queue_;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+
+  void work();
+};
+
+}  // namespace tket
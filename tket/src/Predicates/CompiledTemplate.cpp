@@ -0,0 +1,88 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CompiledTemplate.hpp"
+
+#include "OpType/OpTypeFunctions.hpp"
+#include "Utils/GraphHeaders.hpp"
+
+namespace tket {
+
+// An expression is affine iff its derivative by each symbol is constant
+static bool is_affine_expr(const Expr& e) {
+  for (const Sym& s : expr_free_symbols(e)) {
+    if (!expr_free_symbols(e.diff(s)).empty()) return false;
+  }
+  return true;
+}
+
+CompiledTemplate::CompiledTemplate(
+    const PassPtr& pass, const Circuit& circ, SafetyMode safe_mode)
+    : c_unit_(circ) {
+  pass->apply(c_unit_, safe_mode);
+  const Circuit& compiled = c_unit_.get_circ_ref();
+  symbols_ = compiled.free_symbols();
+  for (const Command& com : compiled) {
+    Op_ptr op = com.get_op_ptr();
+    if (!is_gate_type(op->get_type()) || op->free_symbols().empty()) continue;
+    std::vector<Expr> params = op->get_params();
+    for (unsigned i = 0; i < params.size(); i++) {
+      if (expr_free_symbols(params[i]).empty()) continue;
+      parameters_.push_back({com, i, params[i], is_affine_expr(params[i])});
+    }
+  }
+}
+
+bool CompiledTemplate::is_affine() const {
+  for (const Parameter& p : parameters_) {
+    if (!p.affine) return false;
+  }
+  return true;
+}
+
+Circuit CompiledTemplate::bind(const symbol_map_t& symbol_map) const {
+  SymEngine::map_basic_basic sub_map;
+  for (const Sym& s : symbols_) {
+    symbol_map_t::const_iterator found = symbol_map.find(s);
+    if (found == symbol_map.end()) {
+      throw std::invalid_argument("No value given for symbol " + s->get_name());
+    }
+    ExprPtr e = found->second;
+    sub_map[s] = e;
+  }
+  Circuit circ = c_unit_.get_circ_ref();
+  VertexList identities;
+  BGL_FORALL_VERTICES(v, circ.dag, DAG) {
+    Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
+    if (op->free_symbols().empty()) continue;
+    Op_ptr new_op = op->symbol_substitution(sub_map);
+    if (!new_op) continue;
+    circ.set_vertex_Op_ptr(v, new_op);
+    if (!is_gate_type(new_op->get_type())) continue;
+    std::optional<double> a = new_op->is_identity();
+    if (a) {
+      identities.push_back(v);
+      circ.add_phase(*a);
+    }
+  }
+  circ.remove_vertices(
+      identities, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::Yes);
+  Expr phase = circ.get_phase();
+  if (!expr_free_symbols(phase).empty()) {
+    circ.add_phase(phase.subs(sub_map) - phase);
+  }
+  return circ;
+}
+
+}  // namespace tket
@@ -0,0 +1,78 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <vector>
+
+#include "CompilerPass.hpp"
+
+namespace tket {
+
+/**
+ * A symbolic circuit compiled once, from which numeric circuits are produced
+ * by binding values to the symbols.
+ *
+ * Compilation applies a pass to the symbolic circuit, so the result of
+ * binding is equivalent to the compiled circuit of the bound circuit (though
+ * it may not be the same: passes simplify numeric angles more aggressively
+ * than symbolic ones). Binding only substitutes the values into the
+ * parameterised gates and removes those which become the identity.
+ */
+class CompiledTemplate {
+ public:
+  /** A parameter of a gate in the compiled circuit depending on symbols */
+  struct Parameter {
+    Command command;
+    unsigned index;
+    Expr expr;
+    /** Whether the expression is an affine function of the symbols */
+    bool affine;
+  };
+
+  /**
+   * Compile a symbolic circuit.
+   *
+   * @throw UnsatisfiedPredicate if the pass cannot be applied to the circuit
+   */
+  CompiledTemplate(
+      const PassPtr& pass, const Circuit& circ,
+      SafetyMode safe_mode = SafetyMode::Default);
+
+  /** The compiled symbolic circuit with its initial and final maps */
+  const CompilationUnit& get_compilation_unit() const { return c_unit_; }
+
+  /** The symbols of the compiled circuit */
+  const SymSet& get_symbols() const { return symbols_; }
+
+  /** The symbolic gate parameters of the compiled circuit, in command order */
+  const std::vector<Parameter>& get_parameters() const { return parameters_; }
+
+  /** Whether every symbolic gate parameter is an affine function */
+  bool is_affine() const;
+
+  /**
+   * The compiled circuit with values bound to all its symbols.
+   *
+   * @throw std::invalid_argument if a symbol of the circuit has no value
+   */
+  Circuit bind(const symbol_map_t& symbol_map) const;
+
+ private:
+  CompilationUnit c_unit_;
+  SymSet symbols_;
+  std::vector<Parameter> parameters_;
+};
+
+}  // namespace tket
@@ -14,9 +14,15 @@
 
 #include "CompilerPass.hpp"
 
+#include <algorithm>
+#include <atomic>
+
 #include "PassGenerators.hpp"
 #include "PassLibrary.hpp"
+#include "Utils/Cancellation.hpp"
+#include "Utils/Trace.hpp"
 #include "Utils/Json.hpp"
+#include "Utils/Parallel.hpp"
 #include "Utils/TketLog.hpp"
 
 namespace tket {
@@ -48,29 +54,64 @@ std::string BasePass::to_string() const {
   return str;
 };
 
+std::vector<bool> BasePass::apply_all(
+    std::vector<CompilationUnit>& c_units, SafetyMode safe_mode) const {
+  const std::size_t n = c_units.size();
+  // Not std::vector<bool>, whose elements cannot be written concurrently
+  std::vector<char> changed(n, false);
+  std::atomic<std::size_t> next = 0;
+  std::atomic<bool> failed = false;
+  const std::size_t n_workers = std::min<std::size_t>(get_max_threads(), n);
+  parallel_for(0, n_workers, 1, [&](std::size_t, std::size_t) {
+    // Units vary in size, so each worker takes the next one when it is free
+    for (std::size_t i = next++; i < n && !failed; i = next++) {
+      try {
+        changed[i] = apply(c_units[i], safe_mode);
+      } catch (...) {
+        failed = true;
+        throw;
+      }
+    }
+  });
+  return std::vector<bool>(changed.begin(), changed.end());
+}
+
 std::optional<PredicatePtr> BasePass::unsatisfied_precondition(
     const CompilationUnit& c_unit, SafetyMode safe_mode) const {
+  // Whether a predicate of another class set in the cache implies the
+  // precondition, so that it need not be verified on the circuit
+  auto implied_by_cache = [&c_unit](const TypePredicatePair& pp) {
+    for (const PredicateCache::value_type& entry : c_unit.cache_) {
+      if (entry.first != pp.first && entry.second.second &&
+          predicate_implies(*entry.second.first, *pp.second))
+        return true;
+    }
+    return false;
+  };
   for (const TypePredicatePair& pp : precons_) {
     PredicateCache::const_iterator cache_iter = c_unit.cache_.find(pp.first);
     if (cache_iter == c_unit.cache_.end()) {  // cache does not contain
                                               // predicate
-      if (!c_unit.calc_predicate(*pp.second)) return pp.second;
+      if (!implied_by_cache(pp) && !c_unit.calc_predicate(pp.second))
+        return pp.second;
       c_unit.cache_.insert({pp.first, {pp.second, true}});
     } else {
       /* if a Predicate is not `true` in the cache or implied by a set Predicate
          in the cache then it is assumed to be `false` */
       if (cache_iter->second.second) {
         if (!cache_iter->second.first->implies(*pp.second)) {
-          if (!c_unit.calc_predicate(*pp.second)) return pp.second;
+          if (!implied_by_cache(pp) && !c_unit.calc_predicate(pp.second))
+            return pp.second;
         }
       } else {
-        if (!c_unit.calc_predicate(*pp.second)) return pp.second;
+        if (!implied_by_cache(pp) && !c_unit.calc_predicate(pp.second))
+          return pp.second;
       }
     }
   }
   if (safe_mode == SafetyMode::Audit) {
     for (const TypePredicatePair& pp : precons_) {
-      if (!c_unit.calc_predicate(*pp.second)) return pp.second;
+      if (!c_unit.calc_predicate(pp.second)) return pp.second;
     }
   }
   return {};
@@ -92,7 +133,7 @@ void BasePass::update_cache(
     }
   }
   for (const TypePredicatePair& pp : postcons_.specific_postcons_) {
-    if (safe_mode == SafetyMode::Audit && !pp.second->verify(c_unit.circ_))
+    if (safe_mode == SafetyMode::Audit && !c_unit.calc_predicate(pp.second))
       throw UnsatisfiedPredicate(pp.second->to_string());
     std::pair<PredicatePtr, bool> cache_pair{pp.second, true};
     c_unit.cache_[pp.first] = cache_pair;
@@ -181,9 +222,35 @@ PassConditions BasePass::match_passes(const PassPtr& lhs, const PassPtr& rhs) {
   return match_passes(lhs->get_conditions(), rhs->get_conditions());
 }
 
+namespace {
+
+// Records the changes to a circuit while in scope, unless it is recording
+// already, and stops recording again on every way out
+class ChangeRecordingGuard {
+ public:
+  ChangeRecordingGuard(Circuit& circ, bool enable)
+      : circ_(circ), started_(enable && !circ.is_recording_changes()) {
+    if (started_) circ_.record_changes(true);
+  }
+  ~ChangeRecordingGuard() {
+    if (started_) circ_.record_changes(false);
+  }
+  ChangeRecordingGuard(const ChangeRecordingGuard&) = delete;
+  ChangeRecordingGuard& operator=(const ChangeRecordingGuard&) = delete;
+
+ private:
+  Circuit& circ_;
+  const bool started_;
+};
+
+}  // namespace
+
 bool StandardPass::apply(
     CompilationUnit& c_unit, SafetyMode safe_mode,
     const PassCallback& before_apply, const PassCallback& after_apply) const {
+  TKET_TRACE_SPAN("StandardPass::apply");
+  TKET_TRACE_ARG("name", pass_config_.value("name", "StandardPass"));
+  CompilationUnit::PassCheckpoint checkpoint(c_unit);
   before_apply(c_unit, this->get_config());
   std::optional<PredicatePtr> unsatisfied_precon =
       unsatisfied_precondition(c_unit, safe_mode);
@@ -191,10 +258,34 @@ bool StandardPass::apply(
     throw UnsatisfiedPredicate(
         unsatisfied_precon.value()
             ->to_string());  // just raise warning in super-unsafe mode
+  check_cancellation();
+  // A cancelled transformation may leave the circuit half-rewritten, so keep
+  // the unit as it was in order to restore it. The backup shares the circuit,
+  // which is copied below only if the unit still shares it.
+  std::optional<CompilationUnit> backup;
+  if (current_cancellation_token()) backup = c_unit;
   // Allow trans_ to update the initial and final map
-  c_unit.circ_.unit_bimaps_ = {&c_unit.initial_map_, &c_unit.final_map_};
-  bool changed = trans_.apply(c_unit.circ_);
-  c_unit.circ_.unit_bimaps_ = {nullptr, nullptr};
+  Circuit& circ = c_unit.circ_.get_mutable();
+  circ.unit_bimaps_ = {&c_unit.initial_map_, &c_unit.final_map_};
+  // In audit mode, record the changes so as to check only what they touch.
+  // The guard ends with the try block, before a cancelled unit is restored.
+  const bool audit = safe_mode == SafetyMode::Audit;
+  bool changed;
+  try {
+    ChangeRecordingGuard recording(circ, audit);
+    const std::size_t audit_checkpoint = circ.get_change_checkpoint();
+    changed = trans_.apply(circ);
+    circ.unit_bimaps_ = {nullptr, nullptr};
+    if (audit && !circ.is_valid_since(audit_checkpoint)) {
+      throw CircuitInvalidity(
+          "Pass " + pass_config_.value("name", std::string("StandardPass")) +
+          " left the circuit invalid");
+    }
+  } catch (const CompilationCancelled&) {
+    c_unit = std::move(*backup);
+    throw;
+  }
+  TKET_TRACE_COUNT("changed", changed);
   update_cache(c_unit, safe_mode);
   after_apply(c_unit, this->get_config());
   return changed;
@@ -277,6 +368,7 @@ RepeatWithMetricPass::RepeatWithMetricPass(
 bool RepeatWithMetricPass::apply(
     CompilationUnit& c_unit, SafetyMode safe_mode,
     const PassCallback& before_apply, const PassCallback& after_apply) const {
+  CompilationUnit::PassCheckpoint checkpoint(c_unit);
   before_apply(c_unit, this->get_config());
   bool success = false;
   unsigned currentVal = metric_(c_unit.get_circ_ref());
@@ -322,9 +414,10 @@ RepeatUntilSatisfiedPass::RepeatUntilSatisfiedPass(
 bool RepeatUntilSatisfiedPass::apply(
     CompilationUnit& c_unit, SafetyMode safe_mode,
     const PassCallback& before_apply, const PassCallback& after_apply) const {
+  CompilationUnit::PassCheckpoint checkpoint(c_unit);
   before_apply(c_unit, this->get_config());
   bool success = false;
-  while (!pred_->verify(c_unit.get_circ_ref())) {
+  while (!c_unit.calc_predicate(pred_)) {
     pass_->apply(c_unit, safe_mode, before_apply, after_apply);
     success = true;
   }
@@ -417,6 +510,8 @@ void from_json(const nlohmann::json& j, PassPtr& pp) {
       pp = SimplifyMeasured();
     } else if (passname == "RemoveBarriers") {
       pp = RemoveBarriers();
+    } else if (passname == "ZXGraphlikeOptimisation") {
+      pp = ZXGraphlikeOptimisation();
     } else if (passname == "ComposePhasePolyBoxes") {
       pp = ComposePhasePolyBoxes();
     } else if (passname == "RebaseCustom") {
@@ -513,6 +608,8 @@ void from_json(const nlohmann::json& j, PassPtr& pp) {
           allow_classical ? Transform::AllowClassical::Yes
                           : Transform::AllowClassical::No,
           xcirc);
+    } else if (passname == "ParallelRegions") {
+      pp = gen_parallel_regions_pass(content.at("region_pass").get<PassPtr>());
     } else {
       throw JsonError("Cannot load StandardPass of unknown type");
     }
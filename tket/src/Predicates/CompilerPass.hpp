@@ -95,15 +95,33 @@ class BasePass {
    * configuration.
    * @param after_apply Called at the end of the apply procedure.
    * The parameters are the CompilationUnit and a summary of the pass
-   * configuration.
+   * configuration. If the unit records changes, the changes made by the pass
+   * are given by CompilationUnit::get_changes.
    * @param safe_mode
    * @return True if pass modified the circuit, else False
+   *
+   * Passes are not modified by being applied, so one pass may be applied to
+   * different CompilationUnits from several threads at once.
    */
   virtual bool apply(
       CompilationUnit& c_unit, SafetyMode safe_mode = SafetyMode::Default,
       const PassCallback& before_apply = trivial_callback,
       const PassCallback& after_apply = trivial_callback) const = 0;
 
+  /**
+   * @brief Apply the pass to each of several CompilationUnits in parallel
+   *
+   * The units are handed out one at a time to up to \ref get_max_threads
+   * threads. If applying the pass to a unit throws, the first exception is
+   * rethrown once the other threads have finished, and the units which were
+   * not reached are left unchanged.
+   *
+   * @return For each unit, true if the pass modified its circuit
+   */
+  std::vector<bool> apply_all(
+      std::vector<CompilationUnit>& c_units,
+      SafetyMode safe_mode = SafetyMode::Default) const;
+
   friend PassPtr operator>>(const PassPtr& lhs, const PassPtr& rhs);
 
   virtual std::string to_string() const = 0;
@@ -184,6 +202,7 @@ class SequencePass : public BasePass {
       CompilationUnit& c_unit, SafetyMode safe_mode = SafetyMode::Default,
       const PassCallback& before_apply = trivial_callback,
       const PassCallback& after_apply = trivial_callback) const override {
+    CompilationUnit::PassCheckpoint checkpoint(c_unit);
     before_apply(c_unit, this->get_config());
     bool success = false;
     for (const PassPtr& b : seq_)
@@ -209,6 +228,7 @@ class RepeatPass : public BasePass {
       CompilationUnit& c_unit, SafetyMode safe_mode = SafetyMode::Default,
       const PassCallback& before_apply = trivial_callback,
       const PassCallback& after_apply = trivial_callback) const override {
+    CompilationUnit::PassCheckpoint checkpoint(c_unit);
     before_apply(c_unit, this->get_config());
     bool success = false;
     while (pass_->apply(c_unit, safe_mode, before_apply, after_apply))
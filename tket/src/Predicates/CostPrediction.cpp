@@ -0,0 +1,370 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CostPrediction.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <set>
+
+#include "Circuit/Boxes.hpp"
+#include "OpType/OpTypeFunctions.hpp"
+#include "Ops/Conditional.hpp"
+
+namespace tket {
+
+namespace {
+
+// Estimated CX and single-qubit gates of the decomposition of an operation
+struct GateCost {
+  unsigned n_cx = 0;
+  unsigned n_1qb = 0;
+
+  GateCost &operator+=(const GateCost &other) {
+    n_cx += other.n_cx;
+    n_1qb += other.n_1qb;
+    return *this;
+  }
+};
+
+typedef std::map<boost::uuids::uuid, GateCost> BoxCosts;
+
+GateCost circuit_cost(const Circuit &circ, BoxCosts &box_costs);
+
+// CX gates of a multi-controlled X with n_controls controls
+unsigned cnx_cost(unsigned n_controls) {
+  switch (n_controls) {
+    case 0:
+      return 0;
+    case 1:
+      return 1;
+    case 2:
+      return 6;
+    default:
+      // A ladder of 2n - 3 Toffolis
+      return 6 * (2 * n_controls - 3);
+  }
+}
+
+// Costs of the decompositions of gate types, with each CX of the
+// decomposition of a multi-qubit gate other than CX taken to come with one
+// single-qubit gate
+GateCost gate_cost(OpType type, unsigned n_qubits) {
+  switch (type) {
+    case OpType::noop:
+    case OpType::Measure:
+    case OpType::Reset:
+    case OpType::Collapse:
+      return {};
+    default:
+      if (is_single_qubit_type(type)) return {0, 1};
+  }
+  unsigned n_cx;
+  switch (type) {
+    case OpType::CX:
+      return {1, 0};
+    case OpType::CY:
+    case OpType::CZ:
+    case OpType::CH:
+    case OpType::ZZMax:
+    case OpType::ECR:
+      n_cx = 1;
+      break;
+    case OpType::CV:
+    case OpType::CVdg:
+    case OpType::CSX:
+    case OpType::CSXdg:
+    case OpType::CRz:
+    case OpType::CRx:
+    case OpType::CRy:
+    case OpType::CU1:
+    case OpType::CU3:
+    case OpType::XXPhase:
+    case OpType::YYPhase:
+    case OpType::ZZPhase:
+    case OpType::ISWAP:
+    case OpType::ISWAPMax:
+    case OpType::PhasedISWAP:
+      n_cx = 2;
+      break;
+    case OpType::SWAP:
+      return {3, 0};
+    case OpType::ESWAP:
+    case OpType::FSim:
+    case OpType::Sycamore:
+      n_cx = 3;
+      break;
+    case OpType::BRIDGE:
+      return {4, 0};
+    case OpType::XXPhase3:
+      n_cx = 6;
+      break;
+    case OpType::CCX:
+      n_cx = cnx_cost(2);
+      break;
+    case OpType::CSWAP:
+      n_cx = cnx_cost(2) + 2;
+      break;
+    case OpType::CnX:
+      n_cx = cnx_cost(n_qubits - 1);
+      break;
+    case OpType::CnRy:
+      n_cx = 2 * cnx_cost(n_qubits - 1);
+      break;
+    case OpType::PhaseGadget:
+      n_cx = 2 * (n_qubits - 1);
+      break;
+    case OpType::NPhasedX:
+      return {0, n_qubits};
+    default:
+      // Non-gate operations
+      return {};
+  }
+  return {n_cx, n_cx};
+}
+
+GateCost op_cost(const Op &op, BoxCosts &box_costs) {
+  const OpType type = op.get_type();
+  if (type == OpType::Conditional) {
+    return op_cost(*static_cast<const Conditional &>(op).get_op(), box_costs);
+  }
+  if (!is_box_type(type)) return gate_cost(type, op.n_qubits());
+  switch (type) {
+    case OpType::Unitary1qBox:
+      return {0, 1};
+    case OpType::Unitary2qBox:
+    case OpType::ExpBox:
+      return {3, 3};
+    case OpType::Unitary3qBox:
+      return {20, 20};
+    case OpType::PauliExpBox: {
+      const std::vector<Pauli> paulis =
+          static_cast<const PauliExpBox &>(op).get_paulis();
+      const unsigned weight = std::count_if(
+          paulis.begin(), paulis.end(), [](Pauli p) { return p != Pauli::I; });
+      if (weight == 0) return {};
+      // Basis changes on either side of a CX ladder around an Rz
+      return {2 * (weight - 1), 2 * weight + 1};
+    }
+    default:
+      break;
+  }
+  const Box &box = static_cast<const Box &>(op);
+  auto found = box_costs.find(box.get_id());
+  if (found != box_costs.end()) return found->second;
+  const GateCost cost = circuit_cost(*box.to_circuit(), box_costs);
+  box_costs.insert({box.get_id(), cost});
+  return cost;
+}
+
+GateCost circuit_cost(const Circuit &circ, BoxCosts &box_costs) {
+  GateCost cost;
+  BGL_FORALL_VERTICES(v, circ.dag, DAG) {
+    cost += op_cost(*circ.get_Op_ptr_from_Vertex(v), box_costs);
+  }
+  return cost;
+}
+
+// Distinct pairs of qubits acting together, by index in the circuit, with
+// the number of operations acting on each; operations on more than two
+// qubits are taken to act on each consecutive pair of their qubits
+std::map<std::pair<unsigned, unsigned>, unsigned> interaction_counts(
+    const Circuit &circ, CircuitCostEstimate &estimate) {
+  std::map<Qubit, unsigned> index;
+  for (const Qubit &qb : circ.all_qubits()) index.insert({qb, index.size()});
+  std::map<std::pair<unsigned, unsigned>, unsigned> counts;
+  BoxCosts box_costs;
+  GateCost cost;
+  for (const Command &com : circ) {
+    const Op_ptr op = com.get_op_ptr();
+    cost += op_cost(*op, box_costs);
+    if (op->get_type() == OpType::Barrier) continue;
+    const qubit_vector_t qbs = com.get_qubits();
+    for (unsigned i = 1; i < qbs.size(); i++) {
+      unsigned a = index.at(qbs[i - 1]);
+      unsigned b = index.at(qbs[i]);
+      counts[{std::min(a, b), std::max(a, b)}]++;
+    }
+  }
+  estimate.n_cx = cost.n_cx;
+  estimate.n_1qb = cost.n_1qb;
+  estimate.n_interactions = counts.size();
+  return counts;
+}
+
+// Nodes nearest a node of highest degree, in breadth-first order
+std::vector<Node> compact_region(const Architecture &arc, unsigned n_nodes) {
+  std::vector<Node> region;
+  std::set<Node> seen;
+  std::deque<Node> queue;
+  const Node root = *arc.max_degree_nodes().begin();
+  queue.push_back(root);
+  seen.insert(root);
+  while (!queue.empty() && region.size() < n_nodes) {
+    const Node node = queue.front();
+    queue.pop_front();
+    region.push_back(node);
+    for (const Node &next : arc.get_neighbour_nodes(node)) {
+      if (seen.insert(next).second) queue.push_back(next);
+    }
+  }
+  return region;
+}
+
+}  // namespace
+
+CircuitCostEstimate estimate_circuit_cost(const Circuit &circ) {
+  CircuitCostEstimate estimate;
+  estimate.n_qubits = circ.n_qubits();
+  estimate.n_gates = circ.n_gates();
+  interaction_counts(circ, estimate);
+  return estimate;
+}
+
+CircuitCostEstimate estimate_circuit_cost(
+    const Circuit &circ, const Architecture &arc) {
+  CircuitCostEstimate estimate;
+  estimate.n_qubits = circ.n_qubits();
+  estimate.n_gates = circ.n_gates();
+  const std::map<std::pair<unsigned, unsigned>, unsigned> counts =
+      interaction_counts(circ, estimate);
+  if (estimate.n_qubits > arc.n_nodes()) {
+    estimate.fits = false;
+    return estimate;
+  }
+  if (counts.empty()) return estimate;
+  const qubit_vector_t qubits = circ.all_qubits();
+
+  // Already placed: the distances between the nodes
+  bool placed = true;
+  for (const Qubit &qb : qubits) {
+    if (!arc.node_exists(Node(qb))) placed = false;
+  }
+  if (placed) {
+    for (const auto &[pair, count] : counts) {
+      try {
+        const unsigned d = arc.get_distance(
+            Node(qubits[pair.first]), Node(qubits[pair.second]));
+        if (d > 1) estimate.n_swaps += d - 1;
+      } catch (const graphs::NodesNotConnected<Node> &) {
+        estimate.fits = false;
+      }
+    }
+    return estimate;
+  }
+
+  // Not placed: a compact region of the architecture
+  const std::vector<Node> region = compact_region(arc, estimate.n_qubits);
+  if (region.size() < estimate.n_qubits) {
+    // The component of the root is too small
+    estimate.fits = false;
+    return estimate;
+  }
+  const std::set<Node> region_nodes(region.begin(), region.end());
+  unsigned n_links = 0;
+  unsigned max_degree = 0;
+  double total_distance = 0.;
+  for (unsigned i = 0; i < region.size(); i++) {
+    unsigned degree = 0;
+    for (const Node &next : arc.get_neighbour_nodes(region[i])) {
+      if (region_nodes.count(next) != 0) degree++;
+    }
+    n_links += degree;
+    max_degree = std::max(max_degree, degree);
+    for (unsigned j = i + 1; j < region.size(); j++) {
+      total_distance += arc.get_distance(region[i], region[j]);
+    }
+  }
+  n_links /= 2;
+  const double n_pairs = 0.5 * region.size() * (region.size() - 1);
+  const double mean_distance =
+      (n_pairs > 0.) ? total_distance / n_pairs : 1.;
+  // A qubit can be adjacent to at most max_degree of those it acts with
+  std::vector<unsigned> degrees(estimate.n_qubits, 0);
+  for (const auto &[pair, count] : counts) {
+    degrees[pair.first]++;
+    degrees[pair.second]++;
+  }
+  unsigned max_adjacent = 0;
+  for (unsigned degree : degrees) max_adjacent += std::min(degree, max_degree);
+  max_adjacent = std::min(max_adjacent / 2, n_links);
+  if (counts.size() <= max_adjacent) return estimate;
+  const double n_distant = counts.size() - max_adjacent;
+  estimate.n_swaps = static_cast<unsigned>(
+      std::lround(n_distant * std::max(0., mean_distance - 1.)));
+  return estimate;
+}
+
+void CompileTimeModel::add_profile(const nlohmann::json &profile) {
+  for (const nlohmann::json &record : profile) add_record(record);
+}
+
+void CompileTimeModel::add_record(const nlohmann::json &record) {
+  Totals &totals = totals_[record.at("name").get<std::string>()];
+  totals.wall_time_ms += record.at("wall_time_ms").get<double>();
+  totals.gates +=
+      std::max(1u, record.at("gate_count_before").get<unsigned>());
+  totals.n_records++;
+  if (record.contains("children")) {
+    for (const nlohmann::json &child : record.at("children")) {
+      add_record(child);
+    }
+  }
+}
+
+std::optional<double> CompileTimeModel::estimate_ms(
+    const std::string &name, unsigned n_gates) const {
+  auto found = totals_.find(name);
+  if (found == totals_.end()) return std::nullopt;
+  const Totals &totals = found->second;
+  return totals.wall_time_ms / totals.gates * std::max(1u, n_gates);
+}
+
+std::vector<std::pair<std::string, double>> CompileTimeModel::estimate_ms(
+    const BasePass &pass, unsigned n_gates) const {
+  std::vector<std::pair<std::string, double>> estimates;
+  add_estimates(pass.get_config(), n_gates, estimates);
+  return estimates;
+}
+
+void CompileTimeModel::add_estimates(
+    const nlohmann::json &config, unsigned n_gates,
+    std::vector<std::pair<std::string, double>> &estimates) const {
+  const std::string pass_class = config.at("pass_class").get<std::string>();
+  if (pass_class == "StandardPass") {
+    const std::string name =
+        config.at("StandardPass").at("name").get<std::string>();
+    std::optional<double> ms = estimate_ms(name, n_gates);
+    if (ms) estimates.push_back({name, *ms});
+  } else if (pass_class == "SequencePass") {
+    for (const nlohmann::json &child :
+         config.at("SequencePass").at("sequence")) {
+      add_estimates(child, n_gates, estimates);
+    }
+  } else if (pass_class == "RepeatPass") {
+    // Serialized under this key by RepeatPass::get_config
+    add_estimates(config.at("RepeatClass").at("body"), n_gates, estimates);
+  } else {
+    add_estimates(config.at(pass_class).at("body"), n_gates, estimates);
+  }
+}
+
+unsigned CompileTimeModel::n_records() const {
+  unsigned n = 0;
+  for (const auto &[name, totals] : totals_) n += totals.n_records;
+  return n;
+}
+
+}  // namespace tket
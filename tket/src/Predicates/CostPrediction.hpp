@@ -0,0 +1,155 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Quick estimates of the cost of compiling a circuit for a device
+ */
+
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Architecture/Architecture.hpp"
+#include "Circuit/Circuit.hpp"
+#include "CompilerPass.hpp"
+#include "Utils/Json.hpp"
+
+namespace tket {
+
+/**
+ * Estimated size of a circuit once rebased to CX and single-qubit gates and
+ * routed, found in a single pass over its commands.
+ *
+ * Each operation is charged the number of CX gates of a typical
+ * decomposition of its type (for example 2 for ZZPhase, 3 for SWAP, 6 for
+ * CCX), boxes being charged for the operations of their circuits. These are
+ * estimates for scheduling and early rejection, not bounds: synthesis and
+ * optimisation passes may do better or worse.
+ */
+struct CircuitCostEstimate {
+  /** Number of qubits of the circuit */
+  unsigned n_qubits = 0;
+  /** Number of operations, as given by \ref Circuit::n_gates */
+  unsigned n_gates = 0;
+  /** Estimated number of CX gates after rebasing */
+  unsigned n_cx = 0;
+  /**
+   * Estimated number of single-qubit gates after rebasing, before they are
+   * squashed together
+   */
+  unsigned n_1qb = 0;
+  /** Number of distinct pairs of qubits acted on together */
+  unsigned n_interactions = 0;
+  /**
+   * Whether the circuit can be routed on the architecture: it has no more
+   * qubits than the architecture has nodes and, if its qubits are already
+   * nodes, they are all nodes of the architecture and connected. Always true
+   * without an architecture.
+   */
+  bool fits = true;
+  /** Estimated number of SWAPs added by routing */
+  unsigned n_swaps = 0;
+
+  /** Estimated number of CX gates after routing and decomposing SWAPs */
+  unsigned n_cx_routed() const { return n_cx + 3 * n_swaps; }
+};
+
+/**
+ * Estimate the size of a circuit after rebasing to CX and single-qubit gates.
+ *
+ * One pass over the commands of the circuit, each distinct box being
+ * expanded once.
+ */
+CircuitCostEstimate estimate_circuit_cost(const Circuit &circ);
+
+/**
+ * Estimate the size of a circuit after rebasing and routing on an
+ * architecture.
+ *
+ * SWAPs are estimated from the distinct pairs of qubits acting together. If
+ * the qubits of the circuit are nodes of the architecture, each pair needs
+ * one SWAP per step of the distance between its nodes beyond the first.
+ * Otherwise the qubits are taken to be placed on a compact region of as many
+ * nodes, around a node of highest degree: as many pairs are taken to be
+ * adjacent as the region has links and the degrees of the nodes allow, and
+ * each of the others to need as many SWAPs as the mean distance between
+ * nodes of the region, less one.
+ *
+ * O(G log G) in the number of operations, plus O(n^2) distance queries for
+ * a circuit of n qubits.
+ */
+CircuitCostEstimate estimate_circuit_cost(
+    const Circuit &circ, const Architecture &arc);
+
+/**
+ * Model of the time taken by each pass, learnt from profiles.
+ *
+ * The time of a pass is taken to be proportional to the number of
+ * operations of the circuit it is applied to, at the mean rate over all
+ * profiled applications of passes of the same name.
+ */
+class CompileTimeModel {
+ public:
+  /**
+   * Learn from the records of a profile, as from
+   * \ref PassProfiler::get_profile, including those of nested passes.
+   */
+  void add_profile(const nlohmann::json &profile);
+
+  /**
+   * Estimated wall time in milliseconds of a pass on a circuit, or nullopt
+   * if no pass of that name has been profiled.
+   *
+   * @param name name of the pass, as recorded by \ref PassProfiler
+   * @param n_gates number of operations of the circuit
+   */
+  std::optional<double> estimate_ms(
+      const std::string &name, unsigned n_gates) const;
+
+  /**
+   * Estimated wall time in milliseconds of each profiled standard pass of a
+   * pass, in the order they are first applied, looking into combinators.
+   * The bodies of repeating combinators are counted once.
+   *
+   * @param pass pass, which must be serializable
+   * @param n_gates number of operations of the circuit
+   */
+  std::vector<std::pair<std::string, double>> estimate_ms(
+      const BasePass &pass, unsigned n_gates) const;
+
+  /** Number of pass applications learnt from */
+  unsigned n_records() const;
+
+  void clear() { totals_.clear(); }
+
+ private:
+  struct Totals {
+    double wall_time_ms = 0.;
+    double gates = 0.;
+    unsigned n_records = 0;
+  };
+  std::map<std::string, Totals> totals_;
+
+  void add_record(const nlohmann::json &record);
+  void add_estimates(
+      const nlohmann::json &config, unsigned n_gates,
+      std::vector<std::pair<std::string, double>> &estimates) const;
+};
+
+}  // namespace tket
@@ -0,0 +1,164 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PassCompiler.hpp"
+
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+#include "Predicates.hpp"
+
+namespace tket {
+
+// Library passes without parameters which change nothing when run again
+// straight away: rebases and decompositions only rewrite operations they do
+// not produce, and RemoveRedundancies already runs to a fixed point.
+static const std::set<std::string>& idempotent_pass_names() {
+  static const std::set<std::string> names{
+      "DecomposeBoxes", "DecomposeBridges", "DecomposeMultiQubitsCX",
+      "DecomposeSingleQubitsTK1", "FlattenRegisters", "RebaseCirq",
+      "RebaseHQS", "RebaseOQC", "RebaseProjectQ", "RebasePyZX", "RebaseQuil",
+      "RebaseTket", "RebaseUFR", "RebaseUMD", "RemoveBarriers",
+      "RemoveRedundancies"};
+  return names;
+}
+
+// The name in the configuration of a StandardPass
+static std::optional<std::string> standard_pass_name(const PassPtr& pass) {
+  if (!std::dynamic_pointer_cast<StandardPass>(pass)) return std::nullopt;
+  return pass->get_config().at("StandardPass").value("name", "StandardPass");
+}
+
+static bool is_idempotent(const PassPtr& pass) {
+  std::optional<std::string> name = standard_pass_name(pass);
+  return name && idempotent_pass_names().count(*name) != 0;
+}
+
+// Whether two passes certainly act in the same way. Configurations only
+// identify library passes without parameters: others may hold functions
+// that are not serialised.
+static bool same_pass(const PassPtr& lhs, const PassPtr& rhs) {
+  if (lhs == rhs) return true;
+  return is_idempotent(lhs) && is_idempotent(rhs) &&
+         lhs->get_config() == rhs->get_config();
+}
+
+// The body of a RepeatPass, or null
+static PassPtr repeated_body(const PassPtr& pass) {
+  std::shared_ptr<RepeatPass> repeat =
+      std::dynamic_pointer_cast<RepeatPass>(pass);
+  return repeat ? repeat->get_pass() : nullptr;
+}
+
+// Whether a rebase leaves every circuit satisfying the conditions alone,
+// which holds if they guarantee its target gate set
+static bool rebase_is_redundant(
+    const PassPtr& stage, const PassConditions& before) {
+  std::optional<std::string> name = standard_pass_name(stage);
+  if (!name || name->rfind("Rebase", 0) != 0) return false;
+  const std::type_index ti = typeid(GateSetPredicate);
+  const PredicatePtrMap& targets =
+      stage->get_conditions().second.specific_postcons_;
+  const PredicatePtrMap& held = before.second.specific_postcons_;
+  PredicatePtrMap::const_iterator target = targets.find(ti);
+  PredicatePtrMap::const_iterator guaranteed = held.find(ti);
+  return target != targets.end() && guaranteed != held.end() &&
+         guaranteed->second->implies(*target->second);
+}
+
+// Whether a stage cannot change the circuit left by the previous stage,
+// given the conditions guaranteed by the stages kept so far
+static bool is_redundant(
+    const PassPtr& previous, const PassPtr& stage,
+    const PassConditions& before) {
+  if (is_idempotent(stage) && same_pass(previous, stage)) return true;
+  PassPtr body = repeated_body(previous);
+  if (body) {
+    PassPtr stage_body = repeated_body(stage);
+    if (same_pass(body, stage) || (stage_body && same_pass(body, stage_body)))
+      return true;
+  }
+  return rebase_is_redundant(stage, before);
+}
+
+// Append the stages of a pass, flattening sequences
+static void flatten_stages(const PassPtr& pass, std::vector<PassPtr>& stages) {
+  std::shared_ptr<SequencePass> seq =
+      std::dynamic_pointer_cast<SequencePass>(pass);
+  if (!seq) {
+    stages.push_back(pass);
+    return;
+  }
+  for (const PassPtr& sub : seq->get_sequence()) flatten_stages(sub, stages);
+}
+
+static PassPtr compile_sequence(const PassPtr& pass) {
+  std::vector<PassPtr> stages;
+  flatten_stages(pass, stages);
+  std::vector<PassPtr> kept;
+  bool changed = false;
+  // The stages kept so far, composed to track what they guarantee
+  PassPtr prefix;
+  for (const PassPtr& original : stages) {
+    PassPtr stage = compile_pass(original);
+    changed |= stage != original;
+    if (prefix) {
+      if (is_redundant(kept.back(), stage, prefix->get_conditions())) {
+        changed = true;
+        continue;
+      }
+      prefix = prefix >> stage;
+    } else {
+      prefix = stage;
+    }
+    kept.push_back(stage);
+  }
+  if (!changed) return pass;
+  if (kept.size() == 1) return kept.front();
+  return std::make_shared<SequencePass>(kept);
+}
+
+PassPtr compile_pass(const PassPtr& pass) {
+  if (std::dynamic_pointer_cast<SequencePass>(pass)) {
+    return compile_sequence(pass);
+  }
+  if (PassPtr body = repeated_body(pass)) {
+    PassPtr compiled = compile_pass(body);
+    // Repeating a pass which runs to a fixed point changes nothing
+    if (repeated_body(compiled)) return compiled;
+    if (compiled == body) return pass;
+    return std::make_shared<RepeatPass>(compiled);
+  }
+  if (std::shared_ptr<RepeatWithMetricPass> repeat =
+          std::dynamic_pointer_cast<RepeatWithMetricPass>(pass)) {
+    PassPtr compiled = compile_pass(repeat->get_pass());
+    if (compiled == repeat->get_pass()) return pass;
+    return std::make_shared<RepeatWithMetricPass>(
+        compiled, repeat->get_metric());
+  }
+  if (std::shared_ptr<RepeatUntilSatisfiedPass> repeat =
+          std::dynamic_pointer_cast<RepeatUntilSatisfiedPass>(pass)) {
+    PassPtr compiled = compile_pass(repeat->get_pass());
+    if (compiled == repeat->get_pass()) return pass;
+    return std::make_shared<RepeatUntilSatisfiedPass>(
+        compiled, repeat->get_predicate());
+  }
+  return pass;
+}
+
+}  // namespace tket
@@ -0,0 +1,48 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CompilerPass.hpp"
+
+namespace tket {
+
+/**
+ * A pass with the same effect on circuits as the given one, but with the
+ * stages that cannot change the circuit removed.
+ *
+ * Nested sequences are flattened into one, and the bodies of repeating
+ * combinators compiled in turn. A stage of a sequence is then dropped if,
+ * from what is known of the stages kept before it, it would leave the
+ * circuit unchanged:
+ *  - it is the same as the stage before, and a library pass known to be
+ *    idempotent (e.g. a rebase, RemoveRedundancies or DecomposeBoxes);
+ *  - the stage before is a RepeatPass of it (or of its own body, if it is a
+ *    RepeatPass too), which has already run it until it reported no change;
+ *  - it is a rebase and the stages before guarantee that the circuit is in
+ *    its target gate set, which it leaves alone.
+ * A RepeatPass of a RepeatPass becomes a single one.
+ *
+ * Passes count as the same if they are the same object, or library passes
+ * without parameters with equal configurations. The passes that remain are
+ * the original objects, so the result still serialises; callbacks are only
+ * made for them. Transforms are opaque functions, so stages are not merged.
+ *
+ * @param pass pass to compile
+ * @return equivalent pass, which is \p pass itself if no stage was removed
+ *  or changed
+ */
+PassPtr compile_pass(const PassPtr& pass);
+
+}  // namespace tket
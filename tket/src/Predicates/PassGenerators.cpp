@@ -25,6 +25,7 @@
 #include "Routing/Placement.hpp"
 #include "Transformations/Transform.hpp"
 #include "Utils/Json.hpp"
+#include "Utils/Parallel.hpp"
 
 namespace tket {
 
@@ -187,21 +188,29 @@ PassPtr gen_cx_mapping_pass(
       {OpType::CX}, CircPool::CX(), all_single_qubit_types(),
       Transform::tk1_to_tk1);
 
+  RoutingConfig routing_config = config;
+  routing_config.directed_cx |= directed_cx;
   PassPtr return_pass =
-      rebase_pass >> gen_full_mapping_pass(arc, placement_ptr, config);
+      rebase_pass >> gen_full_mapping_pass(arc, placement_ptr, routing_config);
   if (delay_measures) return_pass = return_pass >> DelayMeasures();
   return_pass = return_pass >> rebase_pass >>
                 gen_decompose_routing_gates_to_cxs_pass(arc, directed_cx);
   return return_pass;
 }
 
-PassPtr gen_routing_pass(const Architecture& arc, const RoutingConfig& config) {
+PassPtr gen_routing_pass(
+    const Architecture& arc, const RoutingConfig& config,
+    const std::function<void(const Routing::Stats&)>& stats_callback) {
+  // Shared by every application of the pass
+  const RoutingContextPtr context =
+      std::make_shared<const RoutingContext>(arc, config.link_errors);
   Transform::Transformation trans =
       [=](Circuit& circ) {  // this doesn't work if capture by ref for some
                             // reason....
-        Routing route(circ, arc);
+        Routing route(circ, context);
         std::pair<Circuit, bool> circbool = route.solve(config);
         circ = circbool.first;
+        if (stats_callback) stats_callback(route.get_stats());
         return circbool.second;
       };
   Transform t = Transform(trans);
@@ -306,20 +315,34 @@ PassPtr aas_routing_pass(
     circ.remove_vertices(
         bin, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::Yes);
 
-    for (const Command& com : input_circ) {
+    // The boxes are disjoint regions of the circuit, so synthesise them all
+    // in parallel before rebuilding the circuit in order.
+    std::vector<Command> coms = input_circ.get_commands();
+    std::vector<std::size_t> box_coms;
+    for (std::size_t i = 0; i < coms.size(); ++i) {
+      if (coms[i].get_op_ptr()->get_type() == OpType::PhasePolyBox) {
+        box_coms.push_back(i);
+      }
+    }
+    std::vector<Circuit> box_results(box_coms.size());
+    parallel_for(
+        0, box_coms.size(), 1, [&](std::size_t begin, std::size_t end) {
+          for (std::size_t i = begin; i < end; ++i) {
+            Op_ptr op = coms[box_coms[i]].get_op_ptr();
+            const PhasePolyBox& b = static_cast<const PhasePolyBox&>(*op);
+            PhasePolyBox ppb(*b.to_circuit());
+            box_results[i] =
+                aas::phase_poly_synthesis(arc, ppb, lookahead, cnotsynthtype);
+          }
+        });
+    std::vector<Circuit>::const_iterator next_result = box_results.begin();
+
+    for (const Command& com : coms) {
       OpType ot = com.get_op_ptr()->get_type();
       unit_vector_t qbs = com.get_args();
       switch (ot) {
         case OpType::PhasePolyBox: {
-          Op_ptr op = com.get_op_ptr();
-          const PhasePolyBox& b = static_cast<const PhasePolyBox&>(*op);
-
-          Circuit b_circ(*b.to_circuit());
-
-          PhasePolyBox ppb(b_circ);
-
-          Circuit result =
-              aas::phase_poly_synthesis(arc, ppb, lookahead, cnotsynthtype);
+          const Circuit& result = *next_result++;
 
           for (const Command& res_com : result) {
             OpType ot = res_com.get_op_ptr()->get_type();
@@ -405,7 +428,11 @@ PassPtr gen_full_mapping_pass_phase_poly(
 PassPtr gen_directed_cx_routing_pass(
     const Architecture& arc, const RoutingConfig& config) {
   OpTypeSet multis = {OpType::CX, OpType::BRIDGE, OpType::SWAP};
-  return gen_routing_pass(arc, config) >>
+  // Let routing prefer SWAPs that leave CXs along their edges, so that fewer
+  // need reversing afterwards
+  RoutingConfig directed_config = config;
+  directed_config.directed_cx = true;
+  return gen_routing_pass(arc, directed_config) >>
          gen_rebase_pass(
              multis, CircPool::CX(), all_single_qubit_types(),
              Transform::tk1_to_tk1) >>
@@ -492,7 +519,7 @@ PassPtr KAKDecomposition(double cx_fidelity) {
 
 PassPtr ThreeQubitSquash(bool allow_swaps) {
   Transform t = Transform::two_qubit_squash() >>
-                Transform::three_qubit_squash() >>
+                Transform::three_qubit_squash(true) >>
                 Transform::clifford_simp(allow_swaps);
   OpTypeSet ots{all_single_qubit_types()};
   ots.insert(OpType::CX);
@@ -668,4 +695,138 @@ PassPtr PauliSquash(PauliSynthStrat strat, CXConfigType cx_config) {
   return std::make_shared<SequencePass>(seq);
 }
 
+// Representative of the group of units containing u
+static UnitID find_group(std::map<UnitID, UnitID>& parent, const UnitID& u) {
+  UnitID root = u;
+  while (parent.at(root) != root) root = parent.at(root);
+  parent[u] = root;
+  return root;
+}
+
+// Split the commands between two barriers into circuits acting on disjoint
+// sets of units, appending them to regions
+static void split_segment(
+    const std::vector<Command>& segment, std::vector<Circuit>& regions) {
+  std::map<UnitID, UnitID> parent;
+  for (const Command& com : segment) {
+    for (const UnitID& u : com.get_args()) parent.insert({u, u});
+  }
+  for (const Command& com : segment) {
+    unit_vector_t args = com.get_args();
+    UnitID root = find_group(parent, args[0]);
+    for (unsigned i = 1; i < args.size(); i++) {
+      UnitID other = find_group(parent, args[i]);
+      if (other != root) parent[other] = root;
+    }
+  }
+  std::map<UnitID, std::size_t> region_of_group;
+  for (const Command& com : segment) {
+    UnitID root = find_group(parent, com.get_args()[0]);
+    if (region_of_group.insert({root, regions.size()}).second) {
+      regions.push_back(Circuit());
+    }
+  }
+  for (const std::pair<const UnitID, UnitID>& pair : parent) {
+    Circuit& region = regions[region_of_group[find_group(parent, pair.first)]];
+    if (pair.first.type() == UnitType::Qubit) {
+      region.add_qubit(Qubit(pair.first));
+    } else {
+      region.add_bit(Bit(pair.first));
+    }
+  }
+  for (const Command& com : segment) {
+    Circuit& region =
+        regions[region_of_group[find_group(parent, com.get_args()[0])]];
+    region.add_op<UnitID>(
+        com.get_op_ptr(), com.get_args(), com.get_opgroup());
+  }
+}
+
+PassPtr gen_parallel_regions_pass(const PassPtr& pass) {
+  Transform t([=](Circuit& circ) {
+    // Regions in the order they are put back together, with the barriers
+    // (and any commands without arguments) as regions which are not compiled
+    std::vector<Circuit> regions;
+    std::vector<char> compile;
+    std::vector<Command> segment;
+    auto end_segment = [&]() {
+      split_segment(segment, regions);
+      compile.resize(regions.size(), true);
+      segment.clear();
+    };
+    if (!circ.has_implicit_wireswaps()) {
+      for (const Command& com : circ) {
+        if (com.get_op_ptr()->get_type() != OpType::Barrier &&
+            !com.get_args().empty()) {
+          segment.push_back(com);
+          continue;
+        }
+        end_segment();
+        Circuit separator;
+        for (const UnitID& u : com.get_args()) {
+          if (u.type() == UnitType::Qubit) {
+            separator.add_qubit(Qubit(u));
+          } else {
+            separator.add_bit(Bit(u));
+          }
+        }
+        separator.add_op<UnitID>(
+            com.get_op_ptr(), com.get_args(), com.get_opgroup());
+        regions.push_back(separator);
+        compile.push_back(false);
+      }
+      end_segment();
+    } else {
+      // The regions could not be put back together with the permutation
+      regions = {circ};
+      compile = {true};
+    }
+
+    std::vector<char> changed(regions.size(), false);
+    parallel_for(0, regions.size(), 1, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i) {
+        if (!compile[i]) continue;
+        CompilationUnit cu(regions[i]);
+        bool region_changed = pass->apply(cu);
+        const Circuit& compiled = cu.get_circ_ref();
+        if (compiled.all_qubits() != regions[i].all_qubits() ||
+            compiled.all_bits() != regions[i].all_bits()) {
+          throw std::logic_error(
+              "A pass applied to regions of a circuit must preserve its "
+              "units");
+        }
+        if (!region_changed) continue;
+        regions[i] = compiled;
+        changed[i] = true;
+      }
+    });
+    if (std::find(changed.begin(), changed.end(), true) == changed.end()) {
+      return false;
+    }
+
+    Circuit result;
+    for (const Qubit& qb : circ.all_qubits()) result.add_qubit(qb);
+    for (const Bit& b : circ.all_bits()) result.add_bit(b);
+    for (const Circuit& region : regions) result.append(region);
+    for (const Qubit& qb : circ.all_qubits()) {
+      if (circ.is_created(qb)) result.qubit_create(qb);
+      if (circ.is_discarded(qb)) result.qubit_discard(qb);
+    }
+    result.add_phase(circ.get_phase());
+    std::optional<std::string> name = circ.get_name();
+    if (name) result.set_name(*name);
+    circ = result;
+    return true;
+  });
+  PassConditions conditions = pass->get_conditions();
+
+  // record pass config
+  nlohmann::json j;
+  j["name"] = "ParallelRegions";
+  j["region_pass"] = pass;
+
+  return std::make_shared<StandardPass>(
+      conditions.first, t, conditions.second, j);
+}
+
 }  // namespace tket
@@ -50,8 +50,20 @@ PassPtr gen_default_mapping_pass(const Architecture& arc);
 PassPtr gen_cx_mapping_pass(
     const Architecture& arc, const PlacementPtr& placement_ptr,
     const RoutingConfig& config, bool directed_cx, bool delay_measures);
+/**
+ * Pass to route a placed circuit to an architecture.
+ *
+ * @param arc architecture to route for
+ * @param config routing configuration
+ * @param stats_callback called with the statistics (counts of SWAPs and
+ *  BRIDGEs and the time spent in each phase) of every application of the
+ *  pass; it may be called from several threads at once if the pass is
+ *  applied concurrently
+ */
 PassPtr gen_routing_pass(
-    const Architecture& arc, const RoutingConfig& config = {});
+    const Architecture& arc, const RoutingConfig& config = {},
+    const std::function<void(const Routing::Stats&)>& stats_callback =
+        nullptr);
 PassPtr gen_directed_cx_routing_pass(
     const Architecture& arc, const RoutingConfig& config = {});
 
@@ -187,4 +199,19 @@ PassPtr gen_contextual_pass(
  */
 PassPtr PauliSquash(PauliSynthStrat strat, CXConfigType cx_config);
 
+/**
+ * Applies a pass to the independent regions of a circuit in parallel.
+ *
+ * The circuit is cut at each Barrier, and the commands between two barriers
+ * are split into groups acting on disjoint sets of units. Each group is
+ * compiled as a circuit of its own (using \ref parallel_for) and the results
+ * are put back together in order.
+ *
+ * The pass must keep the units of the circuits it is applied to, so it cannot
+ * be a placement or routing pass. It may introduce implicit wire swaps.
+ *
+ * @param pass pass to apply to each region
+ */
+PassPtr gen_parallel_regions_pass(const PassPtr& pass);
+
 }  // namespace tket
@@ -16,10 +16,12 @@
 
 #include <memory>
 
+#include "Converters/Converters.hpp"
 #include "PassGenerators.hpp"
 #include "Predicates/CompilerPass.hpp"
 #include "Transformations/Transform.hpp"
 #include "Utils/Json.hpp"
+#include "ZX/Rewrite.hpp"
 
 namespace tket {
 
@@ -453,4 +455,61 @@ const PassPtr &SimplifyMeasured() {
   return pp;
 }
 
+const PassPtr &ZXGraphlikeOptimisation() {
+  static const PassPtr pp([]() {
+    Transform t = Transform([](Circuit &circ) {
+      zx::ZXDiagram diag = circuit_to_zx(circ);
+      zx::Rewrite::sequence({zx::Rewrite::to_graphlike_form(),
+                             zx::Rewrite::reduce_graphlike_form()})
+          .apply(diag);
+      // The extracted circuit has default qubits in the order of the original
+      const qubit_vector_t qubits = circ.all_qubits();
+      Circuit result;
+      for (const Qubit &qb : qubits) result.add_qubit(qb);
+      const Circuit extracted = zx_to_circuit(diag);
+      for (const Command &com : extracted) {
+        unit_vector_t args;
+        for (const UnitID &qb : com.get_args()) {
+          args.push_back(qubits[qb.index().at(0)]);
+        }
+        result.add_op<UnitID>(com.get_op_ptr(), args);
+      }
+      // The global phase is carried through the diagram scalar
+      result.add_phase(extracted.get_phase());
+      if (circ.get_name()) result.set_name(*circ.get_name());
+      if (result == circ) return false;
+      circ = result;
+      return true;
+    });
+    // The gates circuit_to_zx accepts
+    OpTypeSet in_gates = {
+        OpType::noop, OpType::Z,   OpType::X,  OpType::Y,    OpType::S,
+        OpType::Sdg,  OpType::T,   OpType::Tdg, OpType::V,   OpType::Vdg,
+        OpType::SX,   OpType::SXdg, OpType::H, OpType::Rx,   OpType::Ry,
+        OpType::Rz,   OpType::U1,  OpType::tk1, OpType::CX,  OpType::CZ,
+        OpType::SWAP};
+    PredicatePtr in_gateset = std::make_shared<GateSetPredicate>(in_gates);
+    PredicatePtr noclas = std::make_shared<NoClassicalBitsPredicate>();
+    PredicatePtrMap precons{
+        CompilationUnit::make_type_pair(in_gateset),
+        CompilationUnit::make_type_pair(noclas)};
+    OpTypeSet out_gates = {
+        OpType::Rz, OpType::H, OpType::CX, OpType::CZ, OpType::SWAP};
+    PredicatePtr out_gateset = std::make_shared<GateSetPredicate>(out_gates);
+    PredicatePtr max2qb = std::make_shared<MaxTwoQubitGatesPredicate>();
+    PredicatePtrMap spec_postcons{
+        CompilationUnit::make_type_pair(out_gateset),
+        CompilationUnit::make_type_pair(max2qb)};
+    // Extraction routes CXs and CZs between arbitrary qubits
+    PredicateClassGuarantees g_postcons{
+        {typeid(ConnectivityPredicate), Guarantee::Clear},
+        {typeid(DirectednessPredicate), Guarantee::Clear}};
+    PostConditions postcon{spec_postcons, g_postcons, Guarantee::Preserve};
+    nlohmann::json j;
+    j["name"] = "ZXGraphlikeOptimisation";
+    return std::make_shared<StandardPass>(precons, t, postcon, j);
+  }());
+  return pp;
+}
+
 }  // namespace tket
@@ -76,4 +76,13 @@ const PassPtr &RemoveDiscarded();
  */
 const PassPtr &SimplifyMeasured();
 
+/**
+ * Optimise a circuit of Clifford+T, rotation, CX, CZ and SWAP gates through
+ * the ZX-calculus: convert it to a graph-like ZXDiagram, remove interior
+ * Clifford spiders by local complementation and pivoting, and extract a
+ * circuit of Rz, H, CX, CZ and SWAP gates. The result is equal to the
+ * original, including its global phase unless that depends on symbols.
+ */
+const PassPtr &ZXGraphlikeOptimisation();
+
 }  // namespace tket
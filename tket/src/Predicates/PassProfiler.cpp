@@ -0,0 +1,128 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PassProfiler.hpp"
+
+namespace tket {
+
+PassProfiler::PassProfiler(
+    bool record_depth, const AllocationCounter& allocation_counter)
+    : record_depth_(record_depth), allocation_counter_(allocation_counter) {}
+
+PassCallback PassProfiler::before_apply_callback() {
+  return [this](const CompilationUnit& c_unit, const nlohmann::json& config) {
+    begin(c_unit, config);
+  };
+}
+
+PassCallback PassProfiler::after_apply_callback() {
+  return [this](const CompilationUnit& c_unit, const nlohmann::json&) {
+    end(c_unit);
+  };
+}
+
+void PassProfiler::begin(
+    const CompilationUnit& c_unit, const nlohmann::json& config) {
+  Record r;
+  r.pass_class = config.at("pass_class").get<std::string>();
+  r.name = r.pass_class;
+  if (r.pass_class == "StandardPass") {
+    const nlohmann::json& pass_config = config.at("StandardPass");
+    if (pass_config.contains("name"))
+      r.name = pass_config.at("name").get<std::string>();
+  }
+  const Circuit& circ = c_unit.get_circ_ref();
+  r.gates_before = circ.n_gates();
+  r.gate_delta = 0;
+  if (record_depth_) r.depth_before = circ.depth();
+  r.depth_delta = 0;
+  if (allocation_counter_) r.allocs_before = allocation_counter_();
+  r.allocations = 0;
+  r.allocated_bytes = 0;
+  r.wall_time_ms = 0.;
+  r.cpu_time_ms = 0.;
+
+  unsigned i = records_.size();
+  if (open_.empty())
+    roots_.push_back(i);
+  else
+    records_[open_.back()].children.push_back(i);
+  open_.push_back(i);
+  // Start the clocks last so that the bookkeeping above is excluded
+  r.cpu_start = std::clock();
+  r.wall_start = std::chrono::steady_clock::now();
+  records_.push_back(std::move(r));
+}
+
+void PassProfiler::end(const CompilationUnit& c_unit) {
+  std::chrono::steady_clock::time_point wall_end =
+      std::chrono::steady_clock::now();
+  std::clock_t cpu_end = std::clock();
+  if (open_.empty()) return;
+  Record& r = records_[open_.back()];
+  open_.pop_back();
+  r.wall_time_ms =
+      std::chrono::duration<double, std::milli>(wall_end - r.wall_start)
+          .count();
+  r.cpu_time_ms = 1000. * double(cpu_end - r.cpu_start) / CLOCKS_PER_SEC;
+  const Circuit& circ = c_unit.get_circ_ref();
+  r.gate_delta = int(circ.n_gates()) - int(r.gates_before);
+  if (r.depth_before) r.depth_delta = int(circ.depth()) - int(*r.depth_before);
+  if (r.allocs_before) {
+    std::pair<std::uint64_t, std::uint64_t> allocs = allocation_counter_();
+    r.allocations = allocs.first - r.allocs_before->first;
+    r.allocated_bytes = allocs.second - r.allocs_before->second;
+  }
+}
+
+nlohmann::json PassProfiler::to_json(unsigned i) const {
+  const Record& r = records_[i];
+  nlohmann::json j;
+  j["pass_class"] = r.pass_class;
+  j["name"] = r.name;
+  j["wall_time_ms"] = r.wall_time_ms;
+  j["cpu_time_ms"] = r.cpu_time_ms;
+  j["gate_count_before"] = r.gates_before;
+  j["gate_count_delta"] = r.gate_delta;
+  if (r.depth_before) {
+    j["depth_before"] = *r.depth_before;
+    j["depth_delta"] = r.depth_delta;
+  }
+  if (r.allocs_before) {
+    j["allocations"] = r.allocations;
+    j["allocated_bytes"] = r.allocated_bytes;
+  }
+  if (r.pass_class == "RepeatPass" || r.pass_class == "RepeatWithMetricPass" ||
+      r.pass_class == "RepeatUntilSatisfiedPass")
+    j["iterations"] = r.children.size();
+  if (r.pass_class != "StandardPass") {
+    j["children"] = nlohmann::json::array();
+    for (unsigned c : r.children) j["children"].push_back(to_json(c));
+  }
+  return j;
+}
+
+nlohmann::json PassProfiler::get_profile() const {
+  nlohmann::json j = nlohmann::json::array();
+  for (unsigned i : roots_) j.push_back(to_json(i));
+  return j;
+}
+
+void PassProfiler::clear() {
+  records_.clear();
+  roots_.clear();
+  open_.clear();
+}
+
+}  // namespace tket
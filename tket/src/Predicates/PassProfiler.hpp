@@ -0,0 +1,109 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CompilerPass.hpp"
+#include "Utils/Json.hpp"
+
+namespace tket {
+
+/**
+ * Records a profile of a pass application through the apply callbacks.
+ *
+ * Pass `before_apply_callback()` and `after_apply_callback()` to
+ * `BasePass::apply`; the profiler must outlive that call. Every pass
+ * applied, including those nested inside combinators, gets a record with its
+ * wall and CPU time and the changes in gate count and depth of the circuit.
+ * Records of passes inside combinators are nested in the same way, so for a
+ * repeating combinator the number of children is the number of iterations.
+ *
+ * The library does not track allocations itself: to record allocation counts
+ * and bytes, supply an `AllocationCounter` reading counters maintained by the
+ * application (e.g. from a replacement global `operator new`).
+ */
+class PassProfiler {
+ public:
+  /**
+   * Returns the total number of allocations and of bytes allocated so far
+   */
+  typedef std::function<std::pair<std::uint64_t, std::uint64_t>()>
+      AllocationCounter;
+
+  /**
+   * @param record_depth whether to record circuit depth, which may take time
+   *  linear in the size of the circuit whenever a pass has changed it
+   * @param allocation_counter optional source of allocation statistics
+   */
+  explicit PassProfiler(
+      bool record_depth = true,
+      const AllocationCounter& allocation_counter = nullptr);
+
+  PassCallback before_apply_callback();
+  PassCallback after_apply_callback();
+
+  /**
+   * Profile of all passes applied since construction or the last `clear()`.
+   *
+   * @return JSON array with one object per top-level pass application, each
+   *  with "pass_class", "name", "wall_time_ms", "cpu_time_ms",
+   *  "gate_count_before", "gate_count_delta", optionally "depth_before",
+   *  "depth_delta", "allocations" and "allocated_bytes", "iterations" for
+   *  repeating combinators and "children" for combinators.
+   */
+  nlohmann::json get_profile() const;
+
+  void clear();
+
+ private:
+  struct Record {
+    std::string pass_class;
+    std::string name;
+    std::chrono::steady_clock::time_point wall_start;
+    std::clock_t cpu_start;
+    double wall_time_ms;
+    double cpu_time_ms;
+    unsigned gates_before;
+    int gate_delta;
+    std::optional<unsigned> depth_before;
+    int depth_delta;
+    std::optional<std::pair<std::uint64_t, std::uint64_t>> allocs_before;
+    std::uint64_t allocations;
+    std::uint64_t allocated_bytes;
+    std::vector<unsigned> children;
+  };
+
+  bool record_depth_;
+  AllocationCounter allocation_counter_;
+  // All records, each one before its children
+  std::vector<Record> records_;
+  std::vector<unsigned> roots_;
+  // Records of the passes currently being applied, innermost last
+  std::vector<unsigned> open_;
+
+  void begin(const CompilationUnit& c_unit, const nlohmann::json& config);
+  void end(const CompilationUnit& c_unit);
+  nlohmann::json to_json(unsigned i) const;
+};
+
+}  // namespace tket
@@ -14,7 +14,11 @@
 
 #include "Predicates.hpp"
 
+#include <algorithm>
+#include <optional>
+
 #include "Gate/Gate.hpp"
+#include "OpType/OpTypeInfo.hpp"
 #include "Routing/Verification.hpp"
 
 namespace tket {
@@ -76,16 +80,19 @@ const std::string& predicate_name(std::type_index idx) {
 /////////////////////
 
 bool GateSetPredicate::verify(const Circuit& circ) const {
-  BGL_FORALL_VERTICES(v, circ.dag, DAG) {
-    Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
-    OpDesc desc = op->get_desc();
-    if (desc.is_meta()) continue;
-    OpType type = op->get_type();
-    if (type == OpType::Conditional) {
-      const Conditional& cond = static_cast<const Conditional&>(*op);
-      type = cond.get_op()->get_type();
-    }
-    if (!find_in_set(type, allowed_types_)) return false;
+  static const OpTypeMask meta = optype_mask(OpTypeFlag::Metaop);
+  const Circuit::OpTypeCounts counts = circ.optype_counts();
+  // Conditional operations count as the operation they condition.
+  OpTypeMask types = counts.types() & ~meta;
+  types.reset(static_cast<std::size_t>(OpType::Conditional));
+  types |= counts.conditioned_types();
+  return (types & ~allowed_mask_).none();
+}
+
+bool GateSetPredicate::verify_expanded(
+    const Circuit& circ, HierarchicalMetrics& metrics) const {
+  for (OpType type : metrics.gate_types(circ)) {
+    if (!allowed_mask_.test(static_cast<std::size_t>(type))) return false;
   }
   return true;
 }
@@ -331,6 +338,7 @@ bool ConnectivityPredicate::implies(const Predicate& other) const {
         dynamic_cast<const ConnectivityPredicate&>(other);
     const Architecture& arc1 = arch_;
     const Architecture& arc2 = other_c.arch_;
+    arc2.compile_connectivity();
     // Collect all edges in arc1
     for (auto [n1, n2] : arc1.get_all_edges_vec()) {
       if (!arc2.edge_exists(n1, n2) && !arc2.edge_exists(n2, n1)) {
@@ -351,6 +359,7 @@ PredicatePtr ConnectivityPredicate::meet(const Predicate& other) const {
     const Architecture& arc1 = arch_;
     const Architecture& arc2 = other_c.arch_;
     std::vector<std::pair<Node, Node>> new_edges;
+    arc2.compile_connectivity();
     // Collect all edges in arc1 which are also in arc2
     for (auto [n1, n2] : arc1.get_all_edges_vec()) {
       if (arc2.edge_exists(n1, n2)) {
@@ -385,6 +394,7 @@ bool DirectednessPredicate::implies(const Predicate& other) const {
         dynamic_cast<const DirectednessPredicate&>(other);
     const Architecture& arc1 = arch_;
     const Architecture& arc2 = other_c.arch_;
+    arc2.compile_connectivity();
     // Collect all edges in arc1
     for (auto [n1, n2] : arc1.get_all_edges_vec()) {
       // directedness accounted for
@@ -406,6 +416,7 @@ PredicatePtr DirectednessPredicate::meet(const Predicate& other) const {
     const Architecture& arc1 = arch_;
     const Architecture& arc2 = other_c.arch_;
     std::vector<std::pair<Node, Node>> new_edges;
+    arc2.compile_connectivity();
     // Collect all edges in arc1 which are also in arc2
     for (auto [n1, n2] : arc1.get_all_edges_vec()) {
       // this also accounts for directedness, do we want that?
@@ -652,6 +663,57 @@ std::string GlobalPhasedXPredicate::to_string() const {
   return auto_name(*this);
 }
 
+// Whether no operation of a type in the set acts on more than two qubits
+static bool all_at_most_two_qubits(const OpTypeSet& types) {
+  for (OpType type : types) {
+    if (type == OpType::Barrier) continue;
+    const std::optional<op_signature_t>& sig = optypeinfo().at(type).signature;
+    if (!sig) return false;
+    if (std::count(sig->begin(), sig->end(), EdgeType::Quantum) > 2)
+      return false;
+  }
+  return true;
+}
+
+bool predicate_implies(const Predicate& known, const Predicate& other) {
+  if (typeid(known) == typeid(other)) return known.implies(other);
+  if (const GateSetPredicate* gate_set =
+          dynamic_cast<const GateSetPredicate*>(&known)) {
+    const OpTypeSet& types = gate_set->get_allowed_types();
+    if (dynamic_cast<const MaxTwoQubitGatesPredicate*>(&other)) {
+      return all_at_most_two_qubits(types);
+    }
+    if (dynamic_cast<const GlobalPhasedXPredicate*>(&other)) {
+      return types.find(OpType::NPhasedX) == types.end();
+    }
+    return false;
+  }
+  if (dynamic_cast<const NoClassicalBitsPredicate*>(&known)) {
+    // Conditions and measurements write or read bits
+    return dynamic_cast<const NoClassicalControlPredicate*>(&other) ||
+           dynamic_cast<const NoFastFeedforwardPredicate*>(&other) ||
+           dynamic_cast<const NoMidMeasurePredicate*>(&other);
+  }
+  if (const DirectednessPredicate* directed =
+          dynamic_cast<const DirectednessPredicate*>(&known)) {
+    const ConnectivityPredicate* connected =
+        dynamic_cast<const ConnectivityPredicate*>(&other);
+    if (!connected) return false;
+    const Architecture& arc = connected->get_arch();
+    for (const Node& node : directed->get_arch().get_all_nodes_vec()) {
+      if (!arc.node_exists(node)) return false;
+    }
+    // Directedness only allows two-qubit gates between connected nodes, and
+    // no BRIDGEs
+    arc.compile_connectivity();
+    for (auto [n1, n2] : directed->get_arch().get_all_edges_vec()) {
+      if (!arc.edge_exists(n1, n2) && !arc.edge_exists(n2, n1)) return false;
+    }
+    return true;
+  }
+  return false;
+}
+
 void to_json(nlohmann::json& j, const PredicatePtr& pred_ptr) {
   if (std::shared_ptr<GateSetPredicate> cast_pred =
           std::dynamic_pointer_cast<GateSetPredicate>(pred_ptr)) {
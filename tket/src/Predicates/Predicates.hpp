@@ -15,6 +15,7 @@
 #pragma once
 #include <typeindex>
 
+#include "Circuit/HierarchicalMetrics.hpp"
 #include "Routing/Routing.hpp"
 #include "Transformations/Transform.hpp"
 
@@ -50,6 +51,7 @@ class Predicate {
   virtual bool verify(const Circuit& circ) const = 0;
 
   // implication currently only works between predicates of the same subclass
+  // (see predicate_implies for rules across subclasses)
   virtual bool implies(const Predicate& other) const = 0;
   virtual PredicatePtr meet(const Predicate& other) const = 0;
   virtual std::string to_string() const = 0;
@@ -60,16 +62,33 @@ class Predicate {
 class GateSetPredicate : public Predicate {
  public:
   explicit GateSetPredicate(const OpTypeSet& allowed_types)
-      : allowed_types_(allowed_types) {}
+      : allowed_types_(allowed_types),
+        allowed_mask_(optype_mask(allowed_types)) {}
+
+  /**
+   * Checked against the counts of operation types kept by the circuit, so in
+   * O(number of OpTypes) if they are current.
+   */
   bool verify(const Circuit& circ) const override;
   bool implies(const Predicate& other) const override;
   PredicatePtr meet(const Predicate& other) const override;
 
+  /**
+   * Whether the circuit would satisfy the predicate after decomposing all
+   * its boxes, checked without decomposing them
+   *
+   * @param circ circuit to check
+   * @param metrics analysis holding the box summaries to reuse
+   */
+  bool verify_expanded(
+      const Circuit& circ, HierarchicalMetrics& metrics) const;
+
   std::string to_string() const override;
   const OpTypeSet& get_allowed_types() const { return allowed_types_; }
 
  private:
   const OpTypeSet allowed_types_;
+  const OpTypeMask allowed_mask_;
 };
 
 /**
@@ -254,4 +273,24 @@ class GlobalPhasedXPredicate : public Predicate {
   std::string to_string() const override;
 };
 
+/**
+ * Whether every circuit satisfying one predicate satisfies another, which
+ * may be of a different subclass.
+ *
+ * Predicates of the same subclass are compared by Predicate::implies. Across
+ * subclasses the rules known are:
+ *  - a GateSetPredicate implies MaxTwoQubitGatesPredicate if none of its
+ *    types acts on more than two qubits, and GlobalPhasedXPredicate if it
+ *    excludes OpType::NPhasedX;
+ *  - NoClassicalBitsPredicate implies NoClassicalControlPredicate,
+ *    NoFastFeedforwardPredicate and NoMidMeasurePredicate;
+ *  - a DirectednessPredicate implies the ConnectivityPredicate of an
+ *    architecture with all its nodes and, either way round, all its edges.
+ * For other pairs of subclasses the result is false.
+ *
+ * @param known predicate satisfied
+ * @param other predicate to deduce
+ */
+bool predicate_implies(const Predicate& known, const Predicate& other);
+
 }  // namespace tket
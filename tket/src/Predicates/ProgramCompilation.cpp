@@ -0,0 +1,85 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ProgramCompilation.hpp"
+
+namespace tket {
+
+// Whether a unit map leaves every unit where it was
+static bool is_identity(const unit_bimap_t &map) {
+  for (const unit_bimap_t::left_value_type &pair : map.left) {
+    if (pair.first != pair.second) return false;
+  }
+  return true;
+}
+
+bool compile_program(
+    Program &prog, const PassPtr &pass, SafetyMode safe_mode) {
+  FGVertVec blocks;
+  std::vector<CompilationUnit> c_units;
+  for (Program::BlockIterator it = prog.block_begin();
+       it != prog.block_end(); ++it) {
+    blocks.push_back(*it);
+    c_units.push_back(CompilationUnit(prog.get_circuit_ref(*it)));
+  }
+  std::vector<bool> changed = pass->apply_all(c_units, safe_mode);
+  for (unsigned i = 0; i < blocks.size(); ++i) {
+    const Circuit &before = prog.get_circuit_ref(blocks[i]);
+    const CompilationUnit &c_unit = c_units[i];
+    const Circuit &after = c_unit.get_circ_ref();
+    if (!is_identity(c_unit.get_initial_map_ref()) ||
+        !is_identity(c_unit.get_final_map_ref()) ||
+        after.all_units() != before.all_units() ||
+        after.implicit_qubit_permutation() !=
+            before.implicit_qubit_permutation()) {
+      throw ProgramError(
+          "Pass changed the units of a block; blocks of a program must be "
+          "compiled without relabelling their qubits");
+    }
+  }
+  bool modified = false;
+  for (unsigned i = 0; i < blocks.size(); ++i) {
+    if (!changed[i]) continue;
+    prog.get_circuit_ref(blocks[i]) = c_units[i].get_circ_ref();
+    modified = true;
+  }
+  return modified;
+}
+
+bool place_program(Program &prog, const Placement &placement) {
+  Circuit merged;
+  for (const Qubit &qb : prog.all_qubits()) merged.add_qubit(qb);
+  for (const Bit &b : prog.all_bits()) merged.add_bit(b);
+  for (Program::BlockIterator it = prog.block_begin();
+       it != prog.block_end(); ++it) {
+    for (const Command &com : prog.get_circuit_ref(*it)) {
+      merged.add_op<UnitID>(com.get_op_ptr(), com.get_args());
+    }
+  }
+  qubit_mapping_t map = placement.get_placement_map(merged);
+  unit_map_t qm;
+  unsigned n_unplaced = 0;
+  for (const Qubit &qb : prog.all_qubits()) {
+    qubit_mapping_t::const_iterator found = map.find(qb);
+    Node node = (found == map.end())
+                    ? Node(Placement::unplaced_reg(), n_unplaced++)
+                    : found->second;
+    if (node != qb) qm.insert({qb, node});
+  }
+  if (qm.empty()) return false;
+  prog.rename_units(qm);
+  return true;
+}
+
+}  // namespace tket
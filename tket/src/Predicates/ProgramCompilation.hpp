@@ -0,0 +1,56 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CompilerPass.hpp"
+#include "Program/Program.hpp"
+#include "Routing/Placement.hpp"
+
+namespace tket {
+
+/**
+ * Apply a pass to the circuit of every block of a program, in parallel.
+ *
+ * Blocks are compiled independently with BasePass::apply_all. Control can
+ * reach a block from several others, which must all agree on the labelling
+ * of its units, so the pass must not rename or permute them. Passes that
+ * map circuits to an architecture are rejected; use \ref place_program to
+ * give all the blocks one placement instead.
+ *
+ * @param prog program to compile
+ * @param pass pass to apply to each block
+ * @param safe_mode safety mode for applying the pass
+ *
+ * @return true if the pass modified the circuit of any block
+ * @throw ProgramError, leaving the program unchanged, if the pass changed
+ *   the units of any block
+ */
+bool compile_program(
+    Program &prog, const PassPtr &pass,
+    SafetyMode safe_mode = SafetyMode::Default);
+
+/**
+ * Place the qubits of every block of a program with a single placement.
+ *
+ * The placement map is found for the circuits of all the blocks appended
+ * in block order, and then applied throughout the program, so that every
+ * block holds each qubit on the same node. As for Placement::place, qubits
+ * that are not placed are moved to the unplaced register.
+ *
+ * @return true if any qubit was renamed
+ */
+bool place_program(Program &prog, const Placement &placement);
+
+}  // namespace tket
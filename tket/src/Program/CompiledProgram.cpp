@@ -0,0 +1,108 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CompiledProgram.hpp"
+
+#include "Ops/FlowOp.hpp"
+
+namespace tket {
+
+CompiledProgram::CompiledProgram(const Program &prog) {
+  std::map<FGVert, unsigned> index;
+  for (Program::BlockIterator it = prog.block_begin(); it != prog.block_end();
+       ++it) {
+    index.insert({*it, blocks_.size()});
+    blocks_.push_back(
+        {*it, &prog.get_circuit_ref(*it), prog.get_condition(*it),
+         std::nullopt, std::nullopt, 0, 0});
+  }
+  const unsigned exit = exit_block();
+  index.insert({prog.exit_, exit});
+
+  succ_offsets_.push_back(0);
+  pred_offsets_.push_back(0);
+  for (Block &b : blocks_) {
+    for (const FGEdge &e : prog.get_out_edges(b.vert)) {
+      const unsigned target = index.at(prog.get_target(e));
+      succ_targets_.push_back(target);
+      std::optional<unsigned> &succ =
+          prog.get_branch(e) ? b.true_succ : b.false_succ;
+      if (!succ) succ = target;
+    }
+    succ_offsets_.push_back(succ_targets_.size());
+    for (const FGEdge &e : prog.get_in_edges(b.vert)) {
+      std::map<FGVert, unsigned>::const_iterator found =
+          index.find(prog.get_source(e));
+      if (found != index.end()) pred_sources_.push_back(found->second);
+    }
+    pred_offsets_.push_back(pred_sources_.size());
+  }
+
+  // Generate the commands as Program::CommandIterator does, naming labels
+  // in the same order
+  std::map<unsigned, std::string> labels;
+  auto get_label = [&](unsigned block) -> std::string {
+    std::map<unsigned, std::string>::const_iterator found =
+        labels.find(block);
+    if (found != labels.end()) return found->second;
+    std::optional<std::string> label =
+        prog.get_label(block == exit ? prog.exit_ : blocks_[block].vert);
+    if (!label) label = "lab_" + std::to_string(labels.size());
+    labels.insert({block, *label});
+    return *label;
+  };
+  FGVert prev = prog.entry_;
+  for (unsigned i = 0; i < exit; ++i) {
+    Block &b = blocks_[i];
+    FGEdgeVec ins = prog.get_in_edges(b.vert);
+    if (ins.size() != 1 || prog.get_source(ins.front()) != prev ||
+        prog.get_branch(ins.front())) {
+      Op_ptr op = std::make_shared<FlowOp>(OpType::Label, get_label(i));
+      commands_.push_back(Command(op, {}));
+    }
+    b.first_command = commands_.size();
+    for (const Command &com : *b.circ) commands_.push_back(com);
+    b.n_commands = commands_.size() - b.first_command;
+    if (b.condition) {
+      Op_ptr op = std::make_shared<FlowOp>(
+          OpType::Branch, get_label(get_branch_successor(i, true)));
+      commands_.push_back(Command(op, {*b.condition}));
+    }
+    prev = b.vert;
+    // No Goto is needed to fall through to the next block, or to the exit
+    // from the last block
+    if (get_branch_successor(i, false) != i + 1) {
+      Op_ptr op = std::make_shared<FlowOp>(
+          OpType::Goto, get_label(get_branch_successor(i, false)));
+      commands_.push_back(Command(op, {}));
+    }
+  }
+  if (labels.find(exit) != labels.end()) {
+    Op_ptr op = std::make_shared<FlowOp>(OpType::Label, labels.at(exit));
+    commands_.push_back(Command(op, {}));
+  }
+  commands_.push_back(Command(std::make_shared<FlowOp>(OpType::Stop), {}));
+}
+
+unsigned CompiledProgram::get_branch_successor(
+    unsigned block, bool branch) const {
+  const Block &b = blocks_.at(block);
+  const std::optional<unsigned> &succ = branch ? b.true_succ : b.false_succ;
+  if (!succ) {
+    throw ProgramError("Could not find successor on desired branch");
+  }
+  return *succ;
+}
+
+}  // namespace tket
@@ -0,0 +1,103 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <span>
+
+#include "Program.hpp"
+
+namespace tket {
+
+/**
+ * An immutable, index-based view of a Program for repeated traversal.
+ *
+ * Blocks are numbered in the order of Program::BlockIterator, and the exit
+ * of the program is numbered \ref exit_block. Successors and predecessors
+ * are stored in compressed sparse row form, and the commands produced by
+ * Program::CommandIterator are generated once, so that queries and
+ * iteration do not allocate.
+ *
+ * The view refers to the circuits of the Program it was built from, which
+ * must outlive it and not be modified.
+ */
+class CompiledProgram {
+ public:
+  explicit CompiledProgram(const Program &prog);
+
+  unsigned n_blocks() const { return blocks_.size(); }
+
+  /** Index standing for the exit of the program */
+  unsigned exit_block() const { return blocks_.size(); }
+
+  /** Blocks (or \ref exit_block) that control can pass to from a block */
+  std::span<const unsigned> get_successors(unsigned block) const {
+    return {
+        succ_targets_.data() + succ_offsets_.at(block),
+        succ_targets_.data() + succ_offsets_.at(block + 1)};
+  }
+
+  /** Blocks that can pass control to a block, excluding the entry */
+  std::span<const unsigned> get_predecessors(unsigned block) const {
+    return {
+        pred_sources_.data() + pred_offsets_.at(block),
+        pred_sources_.data() + pred_offsets_.at(block + 1)};
+  }
+
+  /**
+   * Successor of a block taken when its condition has the given value, or
+   * unconditionally for branch = false
+   *
+   * @throw ProgramError if the block has no such successor
+   */
+  unsigned get_branch_successor(unsigned block, bool branch = false) const;
+
+  const Circuit &get_circuit_ref(unsigned block) const {
+    return *blocks_.at(block).circ;
+  }
+  const std::optional<Bit> &get_condition(unsigned block) const {
+    return blocks_.at(block).condition;
+  }
+  FGVert get_vertex(unsigned block) const { return blocks_.at(block).vert; }
+
+  /** Commands of the program, as produced by Program::CommandIterator */
+  const std::vector<Command> &get_commands() const { return commands_; }
+
+  /** Commands of the circuit of a block, within \ref get_commands */
+  std::span<const Command> get_block_commands(unsigned block) const {
+    const Block &b = blocks_.at(block);
+    return {commands_.data() + b.first_command, b.n_commands};
+  }
+
+ private:
+  struct Block {
+    FGVert vert;
+    const Circuit *circ;
+    std::optional<Bit> condition;
+    // Successors when the condition is false (or unconditionally) and true
+    std::optional<unsigned> false_succ;
+    std::optional<unsigned> true_succ;
+    std::size_t first_command;
+    std::size_t n_commands;
+  };
+
+  std::vector<Block> blocks_;
+  std::vector<std::size_t> succ_offsets_;
+  std::vector<unsigned> succ_targets_;
+  std::vector<std::size_t> pred_offsets_;
+  std::vector<unsigned> pred_sources_;
+  std::vector<Command> commands_;
+};
+
+}  // namespace tket
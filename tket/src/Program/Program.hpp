@@ -90,6 +90,15 @@ class Program {
   register_t add_q_register(std::string reg_name, unsigned size);
   register_t add_c_register(std::string reg_name, unsigned size);
 
+  /**
+   * Rename units throughout the program: in the circuit of every block, in
+   * branch conditions, and in the program's units.
+   *
+   * @throw CircuitInvalidity if two units would have the same id, or a
+   *   qubit would be renamed to a bit or vice versa
+   */
+  void rename_units(const unit_map_t &qm);
+
   /** Graph accessors */
   Circuit &get_circuit_ref(const FGVert &vert);
   const Circuit &get_circuit_ref(const FGVert &vert) const;
@@ -277,6 +286,8 @@ class Program {
   FGVert exit_;
 
   unit_lookup_t units_;
+
+  friend class CompiledProgram;
 };
 
 }  // namespace tket
@@ -167,4 +167,34 @@ register_t Program::add_c_register(std::string reg_name, unsigned size) {
   return ids;
 }
 
+void Program::rename_units(const unit_map_t &qm) {
+  auto renamed = [&qm](const UnitID &u) {
+    unit_map_t::const_iterator found = qm.find(u);
+    return (found == qm.end()) ? u : found->second;
+  };
+  unit_lookup_t new_units;
+  for (const UnitID &u : units_.get<TagID>()) {
+    UnitID new_u = renamed(u);
+    if (new_u.type() != u.type())
+      throw CircuitInvalidity(
+          "Cannot rename " + u.repr() + " to a unit of another type");
+    if (!new_units.insert(new_u).second)
+      throw CircuitInvalidity(
+          "Mapping two units to the same id: " + new_u.repr());
+  }
+  for (auto [it, end] = boost::vertices(flow_); it != end; ++it) {
+    FlowVertProperties &block = flow_[*it];
+    unit_map_t block_map;
+    for (const UnitID &u : block.circ.all_units()) {
+      unit_map_t::const_iterator found = qm.find(u);
+      if (found != qm.end()) block_map.insert(*found);
+    }
+    block.circ.rename_units(block_map);
+    if (block.branch_condition) {
+      block.branch_condition = Bit(renamed(*block.branch_condition));
+    }
+  }
+  units_ = std::move(new_units);
+}
+
 }  // namespace tket
@@ -16,19 +16,14 @@
 
 namespace tket {
 
-bool node_active(const qubit_bimap_t& map, Node node) {
-  const bool found = map.right.find(node) != map.right.end();
-  return found;
-}
-
-Node Routing::find_best_inactive_node(
-    const Node& target_node, const Architecture& arc) const {
-  const unsigned diameter = arc.get_diameter();
+Node Routing::find_best_inactive_node(const Node& target_node) const {
+  const graphs::DistanceMatrix<Node>& dists = context_->get_distance_matrix();
+  const unsigned diameter = dists.get_diameter();
+  const unsigned target = dists.index(target_node);
   for (unsigned k = 1; k <= diameter; k++) {
-    std::vector<Node> potential_nodes = arc.nodes_at_distance(target_node, k);
-    for (Node potential : potential_nodes) {
-      if (!node_active(qmap, potential)) {
-        return potential;
+    for (unsigned i = 0; i < dists.n_nodes(); i++) {
+      if (dists(target, i) == k && !qmap.node_active(dists.node(i))) {
+        return dists.node(i);
       }
     }
   }
@@ -36,28 +31,36 @@ Node Routing::find_best_inactive_node(
 }
 
 void Routing::activate_node(const Node& node) {
-  current_arc_.add_node(node);
-  for (Node neigh : original_arc_.get_neighbour_nodes(node)) {
-    if (node_active(qmap, neigh)) {
-      if (original_arc_.edge_exists(node, neigh)) {
-        current_arc_.add_connection(node, neigh);
+  const graphs::ConnectivityView<Node>& view =
+      context_->get_connectivity_view();
+  const unsigned i = view.index(node);
+  std::vector<std::pair<Node, Node>> connections;
+  for (unsigned j : view.neighbours(i)) {
+    const Node& neigh = view.node(j);
+    if (qmap.node_active(neigh)) {
+      if (view.edge_exists(i, j)) {
+        connections.push_back({node, neigh});
       }
-      if (original_arc_.edge_exists(neigh, node)) {
-        current_arc_.add_connection(neigh, node);
+      if (view.edge_exists(j, i)) {
+        connections.push_back({neigh, node});
       }
     }
   }
+  // Extends the distances of the active nodes by those of the new one, only
+  // searching them all again if they had not been computed
+  current_arc_.add_node_with_connections(node, connections);
+  current_arc_.precompute_distances();
+  interaction_current_ = false;
 }
 
 void Routing::reactivate_qubit(const Qubit& qb, const Qubit& target) {
   // finds 'best' available node
-  Node node = find_best_inactive_node(qmap.left.at(target), original_arc_);
+  Node node = find_best_inactive_node(qmap.node_of(target));
 
   // updates qmap and initial maps to reflect this qb being at that node
   activate_node(node);
-  std::pair<Qubit, Node> new_in = {qb, node};
-  qmap.left.insert(new_in);
-  init_map.left.insert(new_in);
+  qmap.insert(qb, node);
+  init_map.left.insert({qb, node});
 }
 
 }  // namespace tket
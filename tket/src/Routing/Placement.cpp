@@ -14,6 +14,10 @@
 
 #include "Placement.hpp"
 
+#include <fstream>
+#include <optional>
+#include <tuple>
+
 #include "Utils/HelperFunctions.hpp"
 #include "Utils/Json.hpp"
 
@@ -164,12 +168,106 @@ std::vector<qubit_mapping_t> LinePlacement::get_all_placement_maps(
   return {partial_map};
 }
 
+std::string PlacementCache::fingerprint(
+    const QubitGraph &q_graph, const Architecture &arc,
+    const PlacementConfig &config) {
+  std::vector<std::tuple<Qubit, Qubit, unsigned>> interactions;
+  for (const auto &[q1, q2] : q_graph.get_all_edges_vec()) {
+    const unsigned weight = q_graph.get_connection_weight(q1, q2);
+    if (q2 < q1) {
+      interactions.push_back({q2, q1, weight});
+    } else {
+      interactions.push_back({q1, q2, weight});
+    }
+  }
+  std::sort(interactions.begin(), interactions.end());
+  nlohmann::json j;
+  j["qubits"] = q_graph.get_all_nodes_vec();
+  nlohmann::json j_interactions = nlohmann::json::array();
+  for (const auto &[q1, q2, weight] : interactions) {
+    j_interactions.push_back({q1, q2, weight});
+  }
+  j["interactions"] = j_interactions;
+  j["architecture"] = arc;
+  j["config"] = config;
+  return j.dump();
+}
+
+std::optional<qubit_mapping_t> PlacementCache::find(
+    const std::string &key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) return std::nullopt;
+  return it->second;
+}
+
+void PlacementCache::insert(
+    const std::string &key, const qubit_mapping_t &map) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_[key] = map;
+}
+
+unsigned PlacementCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+void PlacementCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+}
+
+void PlacementCache::save(const std::string &filename) const {
+  nlohmann::json j = nlohmann::json::array();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &[key, map] : entries_) {
+      nlohmann::json entry;
+      entry["key"] = key;
+      entry["map"] = map;
+      j.push_back(entry);
+    }
+  }
+  std::ofstream file(filename);
+  file << j.dump();
+  if (!file) {
+    throw PlacementError("Could not write placement cache to " + filename);
+  }
+}
+
+void PlacementCache::load(const std::string &filename) {
+  std::ifstream file(filename);
+  std::unordered_map<std::string, qubit_mapping_t> loaded;
+  try {
+    nlohmann::json j;
+    file >> j;
+    for (const nlohmann::json &entry : j) {
+      loaded[entry.at("key").get<std::string>()] =
+          entry.at("map").get<qubit_mapping_t>();
+    }
+  } catch (const nlohmann::json::exception &) {
+    throw PlacementError("Could not read placement cache from " + filename);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &[key, map] : loaded) entries_[key] = std::move(map);
+}
+
 qubit_mapping_t GraphPlacement::get_placement_map(const Circuit &circ_) const {
   QubitGraph q_graph = monomorph_interaction_graph(
       circ_, arc_.n_connections(), config_.depth_limit);
+  std::string key;
+  if (cache_) {
+    key = PlacementCache::fingerprint(q_graph, arc_, config_);
+    std::optional<qubit_mapping_t> cached = cache_->find(key);
+    if (cached) {
+      fill_partial_mapping(circ_.all_qubits(), *cached);
+      return *cached;
+    }
+  }
   std::vector<qubit_bimap_t> all_bimaps = monomorphism_edge_break(
       arc_, q_graph, config_.vf2_max_matches, config_.timeout);
   qubit_mapping_t out_map = bimap_to_map(all_bimaps[0].left);
+  if (cache_) cache_->insert(key, out_map);
   fill_partial_mapping(circ_.all_qubits(), out_map);
   return out_map;
 }
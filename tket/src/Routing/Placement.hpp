@@ -15,15 +15,21 @@
 #pragma once
 
 #include <algorithm>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "Architecture/Architecture.hpp"
 #include "Characterisation/DeviceCharacterisation.hpp"
+#include "Characterisation/ErrorTables.hpp"
 #include "Circuit/Circuit.hpp"
 #include "Graphs/Utils.hpp"
 #include "Utils/BiMapHeaders.hpp"
@@ -115,6 +121,63 @@ class QubitGraph : public graphs::DirectedGraph<Qubit> {
   explicit QubitGraph(const qubit_vector_t& _qubits) : Base(_qubits) {}
 };
 
+/**
+ * Builds a \ref QubitGraph from interactions found in a circuit.
+ *
+ * Adding connections to a \ref QubitGraph one at a time, and checking for
+ * existing ones, goes through its boost graph and node map. This records
+ * the interactions in a dense matrix over the qubit indices instead (or a
+ * hash map, for circuits too wide for an n-by-n matrix), and emits the
+ * graph in one go, with the connections in the order in which they were
+ * first added.
+ */
+class QubitGraphBuilder {
+ public:
+  explicit QubitGraphBuilder(const qubit_vector_t& qubits);
+
+  /**
+   * Index of a qubit
+   *
+   * @throw QubitGraphInvalidity if the qubit was not given to the builder
+   */
+  unsigned index(const Qubit& qb) const;
+
+  /** Whether there is a connection between two qubits, in either direction */
+  bool connected(unsigned i, unsigned j) const {
+    return get_weight(i, j) != 0 || get_weight(j, i) != 0;
+  }
+
+  /** Weight of the connection from one qubit to another, or 0 if none */
+  unsigned get_weight(unsigned i, unsigned j) const;
+
+  /**
+   * Add a connection from one qubit to another, unless there is one already
+   *
+   * @param weight nonzero weight of the connection
+   * @return whether the connection was added
+   */
+  bool add_connection(unsigned i, unsigned j, unsigned weight);
+
+  /** Number of connections to and from a qubit */
+  unsigned get_degree(unsigned i) const { return degrees_[i]; }
+
+  unsigned n_connections() const { return connections_.size(); }
+
+  /** The graph of all qubits and connections, without unconnected qubits */
+  QubitGraph build() const;
+
+ private:
+  qubit_vector_t qubits_;
+  std::map<Qubit, unsigned> index_;
+  unsigned n_;
+  /** Row-major weights, if dense */
+  std::vector<unsigned> weights_;
+  /** Weights by row-major position, if sparse */
+  std::unordered_map<std::size_t, unsigned> sparse_weights_;
+  std::vector<unsigned> degrees_;
+  std::vector<std::pair<unsigned, unsigned>> connections_;
+};
+
 /* ACTUALLY PLACEMENT METHODS */
 
 // generate interaction graph of circuit
@@ -210,6 +273,55 @@ class vf2_match_add_callback {
   const GraphT& target_graph_;
 };
 
+/**
+ * Store of placement maps found for interaction graphs.
+ *
+ * Entries are keyed by a fingerprint of the weighted interaction graph, the
+ * architecture and the placement configuration, so circuits with the same
+ * structure (for example the same ansatz with different angles) share an
+ * entry. Safe to use from several threads at once.
+ */
+class PlacementCache {
+ public:
+  /**
+   * Canonical fingerprint of a placement problem.
+   *
+   * Interactions are taken as undirected and listed in sorted order, so the
+   * fingerprint does not depend on the order in which they were added.
+   */
+  static std::string fingerprint(
+      const QubitGraph& q_graph, const Architecture& arc,
+      const PlacementConfig& config);
+
+  /** The stored map for a fingerprint, if any */
+  std::optional<qubit_mapping_t> find(const std::string& key) const;
+
+  /** Store a map, replacing any existing one for the fingerprint */
+  void insert(const std::string& key, const qubit_mapping_t& map);
+
+  unsigned size() const;
+  void clear();
+
+  /**
+   * Write all entries to a JSON file.
+   *
+   * @throw PlacementError if the file cannot be written
+   */
+  void save(const std::string& filename) const;
+
+  /**
+   * Add the entries of a file written by \ref save, replacing existing ones
+   * with the same fingerprint.
+   *
+   * @throw PlacementError if the file cannot be read
+   */
+  void load(const std::string& filename);
+
+ private:
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, qubit_mapping_t> entries_;
+};
+
 class Placement {
  public:
   explicit Placement(const Architecture& _arc) : arc_(_arc) {}
@@ -274,6 +386,16 @@ class GraphPlacement : public Placement {
   PlacementConfig get_config() { return config_; }
   void set_config(const PlacementConfig& new_config) { config_ = new_config; }
 
+  /**
+   * Look up and store placement maps in a cache.
+   *
+   * Circuits whose interaction graph, architecture and configuration have
+   * been placed before get the stored map without a new search. The cache
+   * may be shared between placements. Pass nullptr to stop caching.
+   */
+  void set_cache(std::shared_ptr<PlacementCache> cache) { cache_ = cache; }
+  std::shared_ptr<PlacementCache> get_cache() const { return cache_; }
+
   qubit_mapping_t get_placement_map(const Circuit& circ_) const override;
   // methods that return maps, for base this returns one empty map
   std::vector<qubit_mapping_t> get_all_placement_maps(
@@ -281,6 +403,7 @@ class GraphPlacement : public Placement {
 
  private:
   PlacementConfig config_;
+  std::shared_ptr<PlacementCache> cache_;
 };
 
 ///////////////////////////////
@@ -296,7 +419,7 @@ class Monomorpher {
       const PlacementConfig& _config)
       : circ(_circ),
         arc(_arc),
-        characterisation(_characterisation),
+        errors(_characterisation),
         config(_config) {
     q_graph = monomorph_interaction_graph(
         circ, config.max_interaction_edges, config.depth_limit);
@@ -304,13 +427,45 @@ class Monomorpher {
 
   // return best maps, up to max_return in number, unsorted
   std::vector<MapCost> place(unsigned max_return);
+  /**
+   * Return the best maps found within a wall-clock budget, up to max_return
+   * in number, unsorted.
+   *
+   * Where \ref place bounds only the subgraph search, by config.timeout, the
+   * budget here covers the whole call: matching and then scoring the
+   * matches. If it runs out while scoring, the best of the maps scored so far
+   * are returned. At least one map is always scored.
+   *
+   * @param max_return maximum number of maps to return
+   * @param budget wall-clock budget in milliseconds
+   */
+  std::vector<MapCost> place_anytime(unsigned max_return, unsigned budget);
   // calculate cost of map
   double map_cost(const qubit_bimap_t& n_map);
+  /**
+   * Calculate the costs of many maps in one pass.
+   *
+   * Gives the same values as \ref map_cost, but flattens the fidelities and
+   * interaction weights once into dense arrays indexed by node and qubit, so
+   * that each map is scored without any set or map lookups. Maps are scored
+   * in chunks, spread across threads. If \p stop is given it is checked
+   * after each chunk, and scoring ends once it returns true.
+   *
+   * @return costs of the maps scored, in order: all of them unless stopped
+   */
+  std::vector<double> map_costs(
+      const std::vector<qubit_bimap_t>& maps,
+      const std::function<bool()>& stop = {});
 
  private:
+  // contract the architecture if the circuit is dense enough
+  void contract_arc();
+  // keep the best max_return maps, in place
+  static void keep_best(std::vector<MapCost>& map_costs, unsigned max_return);
+
   const Circuit& circ;
   Architecture arc;
-  DeviceCharacterisation characterisation;
+  DeviceErrorTables errors;
   PlacementConfig config;
   QubitGraph q_graph;
 };
@@ -361,4 +516,64 @@ class NoiseAwarePlacement : public Placement {
   DeviceCharacterisation characterisation_;
 };
 
+///////////////////////////////
+//   PLACEMENT REFINEMENT    //
+///////////////////////////////
+
+// structure of configuration parameters for placement refinement
+struct PlacementRefinementConfig {
+  // wall-clock budget in milliseconds
+  unsigned budget = 100;
+  // maximum number of moves tried by each chain
+  unsigned max_steps = 100000;
+  // number of annealing chains, or 0 for one per thread
+  unsigned n_chains = 0;
+  // number of slices of the circuit whose interactions are scored
+  unsigned depth_limit = 20;
+  // seed of the first chain; chain i is seeded with seed + i
+  unsigned seed = 0;
+};
+
+/**
+ * Cost of a placement map, as minimised by \ref refine_placement.
+ *
+ * The sum over the two-qubit gates in the first \p depth_limit slices of
+ * the circuit of the distance between the nodes of their qubits, weighted
+ * by depth_limit - s for a gate in slice s, so that earlier gates count
+ * more. Qubits not placed on nodes of \p arc do not contribute.
+ */
+double placement_interaction_cost(
+    const Circuit& circ, const Architecture& arc, const qubit_mapping_t& map,
+    unsigned depth_limit);
+
+/**
+ * Improve placement maps by simulated annealing.
+ *
+ * Several independent chains are run in parallel, starting from the maps of
+ * \p starts in order of cost, e.g. the maps of \ref GraphPlacement or
+ * \ref NoiseAwarePlacement. A move takes a qubit that interacts with others
+ * to a neighbouring or random node, swapping it with the qubit there if
+ * any, and is scored incrementally against dense matrices of interaction
+ * weights and node distances. Each chain stops after config.max_steps moves
+ * or when config.budget runs out, whichever is first; with a budget long
+ * enough the result depends only on the configuration.
+ *
+ * Interacting qubits that \p starts leaves off the architecture are put on
+ * free nodes; other qubits keep their nodes unless moved out of the way.
+ *
+ * @param circ circuit to place
+ * @param arc architecture to place on
+ * @param starts maps to start the chains from, at least one
+ * @param config refinement parameters
+ * @return the map of least \ref placement_interaction_cost found, which is
+ *   no worse than the best of \p starts if these place every interacting
+ *   qubit; ties go to the earliest chain
+ * @throw PlacementError if starts is empty, or the architecture has too
+ *   few nodes for the interacting qubits
+ */
+qubit_mapping_t refine_placement(
+    const Circuit& circ, const Architecture& arc,
+    const std::vector<qubit_mapping_t>& starts,
+    const PlacementRefinementConfig& config = {});
+
 }  // namespace tket
@@ -0,0 +1,138 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "QubitNodeMap.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace tket {
+
+QubitNodeMap::QubitNodeMap(
+    const qubit_vector_t &qubits, const node_vector_t &nodes) {
+  qubits_.reserve(qubits.size());
+  node_of_.reserve(qubits.size());
+  for (const Qubit &qb : qubits) add_qubit(qb);
+  nodes_.reserve(nodes.size());
+  qubit_on_.reserve(nodes.size());
+  for (const Node &node : nodes) add_node(node);
+}
+
+void QubitNodeMap::assign(const qubit_bimap_t &map) {
+  std::fill(node_of_.begin(), node_of_.end(), none);
+  std::fill(qubit_on_.begin(), qubit_on_.end(), none);
+  n_placed_ = 0;
+  for (const qubit_bimap_t::value_type &entry : map) {
+    insert(entry.left, entry.right);
+  }
+}
+
+qubit_bimap_t QubitNodeMap::to_bimap() const {
+  qubit_bimap_t map;
+  for (unsigned q = 0; q < qubits_.size(); q++) {
+    if (node_of_[q] != none) map.insert({qubits_[q], nodes_[node_of_[q]]});
+  }
+  return map;
+}
+
+const Node *QubitNodeMap::find_node(const Qubit &qb) const {
+  const unsigned q = qubit_index(qb);
+  if (q == none || node_of_[q] == none) return nullptr;
+  return &nodes_[node_of_[q]];
+}
+
+const Qubit *QubitNodeMap::find_qubit(const Node &node) const {
+  const unsigned n = node_index(node);
+  if (n == none || qubit_on_[n] == none) return nullptr;
+  return &qubits_[qubit_on_[n]];
+}
+
+const Node &QubitNodeMap::node_of(const Qubit &qb) const {
+  const Node *node = find_node(qb);
+  if (node == nullptr) {
+    throw std::out_of_range("Qubit " + qb.repr() + " is not placed");
+  }
+  return *node;
+}
+
+const Qubit &QubitNodeMap::qubit_on(const Node &node) const {
+  const Qubit *qb = find_qubit(node);
+  if (qb == nullptr) {
+    throw std::out_of_range("Node " + node.repr() + " holds no qubit");
+  }
+  return *qb;
+}
+
+bool QubitNodeMap::insert(const Qubit &qb, const Node &node) {
+  const unsigned q = add_qubit(qb);
+  const unsigned n = add_node(node);
+  if (node_of_[q] != none || qubit_on_[n] != none) return false;
+  node_of_[q] = n;
+  qubit_on_[n] = q;
+  n_placed_++;
+  return true;
+}
+
+void QubitNodeMap::swap_nodes(const Node &node1, const Node &node2) {
+  const unsigned n1 = node_index(node1);
+  const unsigned n2 = node_index(node2);
+  if (n1 == none || n2 == none) {
+    throw std::out_of_range("Swapping qubits on unknown nodes");
+  }
+  std::swap(qubit_on_[n1], qubit_on_[n2]);
+  if (qubit_on_[n1] != none) node_of_[qubit_on_[n1]] = n1;
+  if (qubit_on_[n2] != none) node_of_[qubit_on_[n2]] = n2;
+}
+
+std::vector<std::pair<Qubit, Node>> QubitNodeMap::placed() const {
+  std::vector<std::pair<Qubit, Node>> entries;
+  entries.reserve(n_placed_);
+  for (unsigned q = 0; q < qubits_.size(); q++) {
+    if (node_of_[q] != none) {
+      entries.push_back({qubits_[q], nodes_[node_of_[q]]});
+    }
+  }
+  std::sort(entries.begin(), entries.end());
+  return entries;
+}
+
+unsigned QubitNodeMap::qubit_index(const Qubit &qb) const {
+  auto it = qubit_indices_.find(qb);
+  return it == qubit_indices_.end() ? none : it->second;
+}
+
+unsigned QubitNodeMap::node_index(const Node &node) const {
+  auto it = node_indices_.find(node);
+  return it == node_indices_.end() ? none : it->second;
+}
+
+unsigned QubitNodeMap::add_qubit(const Qubit &qb) {
+  auto [it, added] = qubit_indices_.insert({qb, unsigned(qubits_.size())});
+  if (added) {
+    qubits_.push_back(qb);
+    node_of_.push_back(none);
+  }
+  return it->second;
+}
+
+unsigned QubitNodeMap::add_node(const Node &node) {
+  auto [it, added] = node_indices_.insert({node, unsigned(nodes_.size())});
+  if (added) {
+    nodes_.push_back(node);
+    qubit_on_.push_back(none);
+  }
+  return it->second;
+}
+
+}  // namespace tket
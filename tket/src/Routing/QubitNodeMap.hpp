@@ -0,0 +1,131 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <boost/functional/hash.hpp>
+#include <cstddef>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Placement.hpp"
+#include "Utils/UnitID.hpp"
+
+namespace tket {
+
+/**
+ * Placement of qubits on nodes, held in flat arrays while routing.
+ *
+ * Qubits and nodes are numbered from 0: those given to the constructor in
+ * order, then any others in the order they are first placed. Two arrays map
+ * the number of each qubit to the number of its node, and the number of each
+ * node to the number of its qubit, so that exchanging the qubits on two nodes
+ * is a handful of array writes. Routing converts the placement to and from a
+ * qubit_bimap_t only where it is passed in or out.
+ *
+ * Like qubit_bimap_t, each qubit is on at most one node and each node holds
+ * at most one qubit.
+ */
+class QubitNodeMap {
+ public:
+  QubitNodeMap() = default;
+
+  /**
+   * Empty placement, numbering the given qubits and nodes.
+   *
+   * @param qubits qubits expected to be placed
+   * @param nodes nodes expected to be used
+   */
+  QubitNodeMap(const qubit_vector_t &qubits, const node_vector_t &nodes);
+
+  /** Replace the placement by that of a bimap. */
+  void assign(const qubit_bimap_t &map);
+
+  /** The placement as a bimap. */
+  qubit_bimap_t to_bimap() const;
+
+  /** Number of placed qubits. */
+  std::size_t size() const { return n_placed_; }
+
+  bool empty() const { return n_placed_ == 0; }
+
+  /** Node holding a qubit, or nullptr if the qubit is not placed. */
+  const Node *find_node(const Qubit &qb) const;
+
+  /** Qubit on a node, or nullptr if the node holds none. */
+  const Qubit *find_qubit(const Node &node) const;
+
+  /**
+   * Node holding a qubit.
+   *
+   * @throw std::out_of_range if the qubit is not placed
+   */
+  const Node &node_of(const Qubit &qb) const;
+
+  /**
+   * Qubit on a node.
+   *
+   * @throw std::out_of_range if the node holds no qubit
+   */
+  const Qubit &qubit_on(const Node &node) const;
+
+  /** Whether a node holds a qubit. */
+  bool node_active(const Node &node) const {
+    return find_qubit(node) != nullptr;
+  }
+
+  /**
+   * Place a qubit on a node.
+   *
+   * As with inserting into a qubit_bimap_t, nothing changes if the qubit is
+   * already placed or the node already holds a qubit.
+   *
+   * @return whether the qubit was placed
+   */
+  bool insert(const Qubit &qb, const Node &node);
+
+  /**
+   * Exchange the qubits on two nodes, either of which may hold none.
+   *
+   * @throw std::out_of_range if a node has never been used
+   */
+  void swap_nodes(const Node &node1, const Node &node2);
+
+  /** The placed qubits with their nodes, in qubit order. */
+  std::vector<std::pair<Qubit, Node>> placed() const;
+
+ private:
+  static constexpr unsigned none = std::numeric_limits<unsigned>::max();
+
+  // Number of a qubit or node, or none if it has not been numbered
+  unsigned qubit_index(const Qubit &qb) const;
+  unsigned node_index(const Node &node) const;
+  // Number of a qubit or node, numbering it if necessary
+  unsigned add_qubit(const Qubit &qb);
+  unsigned add_node(const Node &node);
+
+  qubit_vector_t qubits_;
+  node_vector_t nodes_;
+  std::unordered_map<Qubit, unsigned, boost::hash<Qubit>> qubit_indices_;
+  std::unordered_map<Node, unsigned, boost::hash<Node>> node_indices_;
+  // Number of the node holding each qubit, or none
+  std::vector<unsigned> node_of_;
+  // Number of the qubit on each node, or none
+  std::vector<unsigned> qubit_on_;
+  std::size_t n_placed_ = 0;
+};
+
+}  // namespace tket
@@ -14,14 +14,26 @@
 
 //#define DEBUG
 #include <algorithm>
+#include <boost/functional/hash.hpp>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
 #include <numeric>
 #include <optional>
 #include <queue>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "Architecture/Architecture.hpp"
 #include "Graphs/Utils.hpp"
 #include "Placement.hpp"
 #include "Routing.hpp"
+#include "Utils/Parallel.hpp"
+#include "Utils/TketLog.hpp"
 
 namespace tket {
 
@@ -38,11 +50,90 @@ std::set<Qubit> interacting_qbs(const Circuit& circ) {
   return qbs;
 }
 
+// Widest circuit whose interactions are kept in a dense matrix (64 MiB)
+static constexpr unsigned max_dense_qubits = 4096;
+
+QubitGraphBuilder::QubitGraphBuilder(const qubit_vector_t& qubits)
+    : qubits_(qubits), n_(qubits.size()), degrees_(qubits.size(), 0) {
+  for (unsigned i = 0; i < n_; ++i) index_.insert({qubits_[i], i});
+  if (n_ <= max_dense_qubits) weights_.assign(std::size_t(n_) * n_, 0);
+}
+
+unsigned QubitGraphBuilder::index(const Qubit& qb) const {
+  std::map<Qubit, unsigned>::const_iterator found = index_.find(qb);
+  if (found == index_.end()) {
+    throw QubitGraphInvalidity(qb.repr() + " is not in the interaction graph");
+  }
+  return found->second;
+}
+
+unsigned QubitGraphBuilder::get_weight(unsigned i, unsigned j) const {
+  const std::size_t pos = std::size_t(i) * n_ + j;
+  if (!weights_.empty()) return weights_[pos];
+  std::unordered_map<std::size_t, unsigned>::const_iterator found =
+      sparse_weights_.find(pos);
+  return (found == sparse_weights_.end()) ? 0 : found->second;
+}
+
+bool QubitGraphBuilder::add_connection(
+    unsigned i, unsigned j, unsigned weight) {
+  if (get_weight(i, j) != 0) return false;
+  const std::size_t pos = std::size_t(i) * n_ + j;
+  if (!weights_.empty()) {
+    weights_[pos] = weight;
+  } else {
+    sparse_weights_[pos] = weight;
+  }
+  ++degrees_[i];
+  ++degrees_[j];
+  connections_.push_back({i, j});
+  return true;
+}
+
+QubitGraph QubitGraphBuilder::build() const {
+  qubit_vector_t connected_qubits;
+  for (unsigned i = 0; i < n_; ++i) {
+    if (degrees_[i] != 0) connected_qubits.push_back(qubits_[i]);
+  }
+  QubitGraph q_graph(connected_qubits);
+  for (const auto& [i, j] : connections_) {
+    q_graph.add_connection(qubits_[i], qubits_[j], get_weight(i, j));
+  }
+  return q_graph;
+}
+
+// Indices of the first two qubits acted on by each vertex of a routing slice
+static std::vector<std::pair<unsigned, unsigned>> slice_interactions(
+    const Circuit& circ, const RoutingFrontier& sf,
+    const QubitGraphBuilder& builder) {
+  // Look up the qubit on each out-edge once per slice, rather than searching
+  // the frontier for every vertex
+  std::unordered_map<Edge, unsigned, boost::hash<Edge>> edge_qubit;
+  edge_qubit.reserve(sf.quantum_out_edges->size());
+  for (const std::pair<UnitID, Edge>& pair :
+       sf.quantum_out_edges->get<TagKey>()) {
+    edge_qubit.insert({pair.second, builder.index(Qubit(pair.first))});
+  }
+  auto qubit_on = [&](const Edge& e) {
+    auto found = edge_qubit.find(e);
+    return (found == edge_qubit.end()) ? builder.index(Qubit())
+                                       : found->second;
+  };
+  std::vector<std::pair<unsigned, unsigned>> interactions;
+  interactions.reserve(sf.slice->size());
+  for (const Vertex& vert : *sf.slice) {
+    EdgeVec q_out_edges = circ.get_out_edges_of_type(vert, EdgeType::Quantum);
+    interactions.push_back(
+        {qubit_on(q_out_edges[0]), qubit_on(q_out_edges[1])});
+  }
+  return interactions;
+}
+
 QubitGraph monomorph_interaction_graph(
     const Circuit& circ, const unsigned max_edges, unsigned depth_limit) {
   std::set<Qubit> qubits_considered = interacting_qbs(circ);
 
-  QubitGraph q_graph(circ.all_qubits());
+  QubitGraphBuilder builder(circ.all_qubits());
 
   RoutingFrontier current_sf(circ);
   unsigned count_edges = 0;
@@ -50,79 +141,69 @@ QubitGraph monomorph_interaction_graph(
        slice < depth_limit && count_edges < max_edges &&
        !current_sf.slice->empty() && qubits_considered.size() > 1;
        slice++) {
-    for (const Vertex& vert : *current_sf.slice) {
-      EdgeVec q_out_edges = circ.get_out_edges_of_type(vert, EdgeType::Quantum);
-      Qubit qb1;
-      Qubit qb2;
-      for (const std::pair<UnitID, Edge>& pair :
-           current_sf.quantum_out_edges->get<TagKey>()) {
-        if (pair.second == q_out_edges[0])
-          qb1 = Qubit(pair.first);
-        else if (pair.second == q_out_edges[1])
-          qb2 = Qubit(pair.first);
-      }
-      if (!q_graph.edge_exists(qb1, qb2) && !q_graph.edge_exists(qb2, qb1)) {
-        q_graph.add_connection(qb1, qb2, slice + 1);
+    for (const auto& [qb1, qb2] :
+         slice_interactions(circ, current_sf, builder)) {
+      if (!builder.connected(qb1, qb2)) {
+        builder.add_connection(qb1, qb2, slice + 1);
         count_edges++;
       }
     }
 
     current_sf.next_slicefrontier();
   }
-  q_graph.remove_stray_nodes();
-  return q_graph;
+  return builder.build();
 }
 
 QubitGraph generate_interaction_graph(
     const Circuit& circ, unsigned depth_limit) {
-  std::set<Qubit> qubits_considered = interacting_qbs(circ);
-  QubitGraph q_graph(circ.all_qubits());
+  const qubit_vector_t all_qbs = circ.all_qubits();
+  QubitGraphBuilder builder(all_qbs);
+  std::vector<bool> considered(all_qbs.size(), false);
+  unsigned n_considered = 0;
+  for (const Qubit& qb : interacting_qbs(circ)) {
+    considered[builder.index(qb)] = true;
+    ++n_considered;
+  }
+  auto discard = [&](unsigned qb) {
+    if (considered[qb]) {
+      considered[qb] = false;
+      --n_considered;
+    }
+  };
   RoutingFrontier current_sf(circ);
 
   for (unsigned slice = 0; slice < depth_limit && !current_sf.slice->empty() &&
-                           qubits_considered.size() > 1;
+                           n_considered > 1;
        slice++) {
-    for (const Vertex& vert : *current_sf.slice) {
-      EdgeVec q_out_edges = circ.get_out_edges_of_type(vert, EdgeType::Quantum);
-      Qubit qb1;
-      Qubit qb2;
-      for (const std::pair<UnitID, Edge>& pair :
-           current_sf.quantum_out_edges->get<TagKey>()) {
-        if (pair.second == q_out_edges[0])
-          qb1 = Qubit(pair.first);
-        else if (pair.second == q_out_edges[1])
-          qb2 = Qubit(pair.first);
-      }
-      const bool qb1_considered =
-          (qubits_considered.find(qb1) != qubits_considered.end());
-      const bool qb2_considered =
-          (qubits_considered.find(qb2) != qubits_considered.end());
+    for (const auto& [qb1, qb2] :
+         slice_interactions(circ, current_sf, builder)) {
+      const bool qb1_considered = considered[qb1];
+      const bool qb2_considered = considered[qb2];
       if ((qb2 != qb1) && (qb1_considered || qb2_considered)) {
         if (!qb1_considered) {
-          qubits_considered.erase(qb2);
+          discard(qb2);
         } else if (!qb2_considered) {
-          qubits_considered.erase(qb1);
-        } else if (!q_graph.edge_exists(qb1, qb2)) {
-          const unsigned out1 = q_graph.get_degree(qb1);
-          const unsigned out2 = q_graph.get_degree(qb2);
-          q_graph.add_connection(qb1, qb2, slice + 1);
+          discard(qb1);
+        } else if (builder.get_weight(qb1, qb2) == 0) {
+          const unsigned out1 = builder.get_degree(qb1);
+          const unsigned out2 = builder.get_degree(qb2);
+          builder.add_connection(qb1, qb2, slice + 1);
           if (out1 == 1) {
-            qubits_considered.erase(qb1);
+            discard(qb1);
           }
           if (out2 == 1) {
-            qubits_considered.erase(qb2);
+            discard(qb2);
           }
         } else {
-          qubits_considered.erase(qb1);
-          qubits_considered.erase(qb2);
+          discard(qb1);
+          discard(qb2);
         }
       }
     }
     current_sf.next_slicefrontier();
   }
-  q_graph.remove_stray_nodes();
 
-  return q_graph;
+  return builder.build();
 }
 
 QubitLineList qubit_lines(const Circuit& circ) {
@@ -267,6 +348,27 @@ qubit_mapping_t line_placement(const Circuit& circ, Architecture arc) {
   }
 }
 
+// Errors as DeviceCharacterisation::get_error gives them, from the tables
+static gate_error_t node_error(const DeviceErrorTables& errors, const Node& n) {
+  const unsigned i = errors.node_index(n);
+  return i == DeviceErrorTables::none ? 0. : errors.node_error(i);
+}
+static gate_error_t link_error(
+    const DeviceErrorTables& errors, const Node& n0, const Node& n1) {
+  const unsigned i0 = errors.node_index(n0);
+  const unsigned i1 = errors.node_index(n1);
+  if (i0 == DeviceErrorTables::none || i1 == DeviceErrorTables::none) {
+    return 0.;
+  }
+  const unsigned l = errors.link_index(i0, i1);
+  return l == DeviceErrorTables::none ? 0. : errors.link_error(l);
+}
+static readout_error_t readout_error(
+    const DeviceErrorTables& errors, const Node& n) {
+  const unsigned i = errors.node_index(n);
+  return i == DeviceErrorTables::none ? 0. : errors.readout_error(i);
+}
+
 // calculate a cost value for map being considered
 double Monomorpher::map_cost(const qubit_bimap_t& n_map) {
   double cost = 0.0;
@@ -300,8 +402,8 @@ double Monomorpher::map_cost(const qubit_bimap_t& n_map) {
         }
       }
       // }
-      gate_error_t fwd_error = characterisation.get_error({node, nei});
-      gate_error_t bck_error = characterisation.get_error({nei, node});
+      gate_error_t fwd_error = link_error(errors, node, nei);
+      gate_error_t bck_error = link_error(errors, nei, node);
       edge_sum += fwd_edge_weighting * (1.0 - fwd_error);
       edge_sum += bck_edge_weighting * (1.0 - bck_error);
     }
@@ -310,38 +412,134 @@ double Monomorpher::map_cost(const qubit_bimap_t& n_map) {
     cost += 1.0 / (edge_sum);
 
     // add error rate of node
-    gate_error_t single_error = characterisation.get_error(node);
+    gate_error_t single_error = node_error(errors, node);
     cost += d1 + 1.0 / ((1.0 - single_error) + c1);
-    readout_error_t readout_error = characterisation.get_readout_error(node);
-    cost += (d1 + 1.0 / ((1.0 - readout_error) + c1)) / (approx_depth * 20);
+    readout_error_t ro_error = readout_error(errors, node);
+    cost += (d1 + 1.0 / ((1.0 - ro_error) + c1)) / (approx_depth * 20);
     // TODO add readout weighting to PlacementConfig?
   }
 
   return cost;
 }
 
-std::vector<MapCost> Monomorpher::place(unsigned max_return) {
-  if (max_return < 1)
-    throw PlacementError("Max return maps for place must be at least 1.");
+std::vector<double> Monomorpher::map_costs(
+    const std::vector<qubit_bimap_t>& maps, const std::function<bool()>& stop) {
+  const int approx_depth = circ.n_gates() / circ.n_qubits() + 1;
+  constexpr double c1 = 0.5;
+  constexpr double d1 = 1 - 1 / c1;
+
+  // Qubits in order, each with its neighbours in order, as map_cost visits
+  // them, so that the sums are taken in the same order.
+  const node_vector_t nodes = arc.get_all_nodes_vec();
+  std::map<Node, unsigned> node_index;
+  for (unsigned i = 0; i < nodes.size(); ++i) node_index[nodes[i]] = i;
+  const unsigned n_nodes = nodes.size();
+  std::vector<double> single_term(n_nodes);
+  std::vector<double> readout_term(n_nodes);
+  // Neighbours of node i are entries row_start[i] to row_start[i + 1].
+  std::vector<unsigned> row_start(n_nodes + 1, 0);
+  std::vector<unsigned> neighbour;
+  std::vector<double> fwd_fidelity;
+  std::vector<double> bck_fidelity;
+  for (unsigned i = 0; i < n_nodes; ++i) {
+    const Node& node = nodes[i];
+    for (const Node& nei : arc.get_neighbour_nodes(node)) {
+      neighbour.push_back(node_index.at(nei));
+      fwd_fidelity.push_back(1.0 - link_error(errors, node, nei));
+      bck_fidelity.push_back(1.0 - link_error(errors, nei, node));
+    }
+    row_start[i + 1] = neighbour.size();
+    gate_error_t single_error = node_error(errors, node);
+    single_term[i] = d1 + 1.0 / ((1.0 - single_error) + c1);
+    readout_error_t ro_error = readout_error(errors, node);
+    readout_term[i] =
+        (d1 + 1.0 / ((1.0 - ro_error) + c1)) / (approx_depth * 20);
+  }
+
+  // Interaction boosts between qubits a and b, at a * n_qubits + b: the
+  // forward one if a interacts with b, otherwise the backward one if b
+  // interacts with a.
+  qubit_vector_t qubits = q_graph.get_all_nodes_vec();
+  std::sort(qubits.begin(), qubits.end());
+  std::map<Qubit, unsigned> qubit_index;
+  for (unsigned a = 0; a < qubits.size(); ++a) qubit_index[qubits[a]] = a;
+  const unsigned n_qubits = qubits.size();
+  std::vector<double> fwd_boost(n_qubits * n_qubits, 0.);
+  std::vector<double> bck_boost(n_qubits * n_qubits, 0.);
+  for (unsigned a = 0; a < n_qubits; ++a) {
+    for (unsigned b = 0; b < n_qubits; ++b) {
+      const unsigned fwd = q_graph.get_connection_weight(qubits[a], qubits[b]);
+      const unsigned bck = q_graph.get_connection_weight(qubits[b], qubits[a]);
+      if (fwd) {
+        fwd_boost[a * n_qubits + b] = config.depth_limit - fwd + 1;
+      } else if (bck) {
+        bck_boost[a * n_qubits + b] = config.depth_limit - bck + 1;
+      }
+    }
+  }
+
+  constexpr unsigned chunk = 256;
+  constexpr unsigned unmapped = std::numeric_limits<unsigned>::max();
+  std::vector<double> costs;
+  costs.reserve(maps.size());
+  for (std::size_t first = 0; first < maps.size(); first += chunk) {
+    const std::size_t last = std::min(first + chunk, maps.size());
+    // Qubit of each node and node of each qubit, per map, as indices.
+    std::vector<unsigned> qubit_at((last - first) * n_nodes, unmapped);
+    std::vector<unsigned> node_of((last - first) * n_qubits, unmapped);
+    for (std::size_t k = first; k < last; ++k) {
+      unsigned* q_at = &qubit_at[(k - first) * n_nodes];
+      unsigned* n_of = &node_of[(k - first) * n_qubits];
+      for (const auto& [qb, node] : maps[k].left) {
+        auto q_it = qubit_index.find(qb);
+        auto n_it = node_index.find(node);
+        if (q_it == qubit_index.end() || n_it == node_index.end()) {
+          throw PlacementError("Map to score is not between graph nodes.");
+        }
+        q_at[n_it->second] = q_it->second;
+        n_of[q_it->second] = n_it->second;
+      }
+    }
+    costs.resize(last);
+    parallel_for(first, last, 16, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t k = begin; k < end; ++k) {
+        const unsigned* q_at = &qubit_at[(k - first) * n_nodes];
+        const unsigned* n_of = &node_of[(k - first) * n_qubits];
+        double cost = 0.0;
+        for (unsigned a = 0; a < n_qubits; ++a) {
+          const unsigned i = n_of[a];
+          if (i == unmapped) continue;
+          const double* fwd_row = &fwd_boost[a * n_qubits];
+          const double* bck_row = &bck_boost[a * n_qubits];
+          double edge_sum = 1.0;
+          for (unsigned e = row_start[i]; e < row_start[i + 1]; ++e) {
+            const unsigned b = q_at[neighbour[e]];
+            if (b == unmapped) continue;
+            edge_sum += (1.0 + fwd_row[b]) * fwd_fidelity[e];
+            edge_sum += (1.0 + bck_row[b]) * bck_fidelity[e];
+          }
+          cost += 1.0 / (edge_sum);
+          cost += single_term[i];
+          cost += readout_term[i];
+        }
+        costs[k] = cost;
+      }
+    });
+    if (stop && stop()) break;
+  }
+  return costs;
+}
+
+void Monomorpher::contract_arc() {
   const unsigned interacting_nodes = q_graph.n_connected();
   if ((circ.n_gates() / circ.n_qubits()) >= config.arc_contraction_ratio &&
       circ.n_qubits() > 3) {
     best_nodes(arc, arc.n_nodes() - interacting_nodes);
   }
+}
 
-  std::vector<qubit_bimap_t> potential_maps = monomorphism_edge_break(
-      arc, q_graph, config.vf2_max_matches, config.timeout);
-  std::vector<MapCost> map_costs;
-  for (unsigned i = 0; i < potential_maps.size(); i++) {
-    qubit_bimap_t& chosen = potential_maps[i];
-    double cost = map_cost(chosen);
-    qubit_mapping_t converted_map;
-    for (auto [qb, node] : chosen.left) {
-      converted_map[qb] = node;
-    }
-    map_costs.push_back({converted_map, cost});
-  }
-
+void Monomorpher::keep_best(
+    std::vector<MapCost>& map_costs, unsigned max_return) {
   max_return = std::min(static_cast<unsigned>(map_costs.size()), max_return);
   std::nth_element(
       map_costs.begin(), map_costs.begin() + max_return - 1, map_costs.end());
@@ -356,7 +554,298 @@ std::vector<MapCost> Monomorpher::place(unsigned max_return) {
   }
 
   if (max_return < map_costs.size()) map_costs.resize(max_return);
+}
+
+static qubit_mapping_t converted_map(const qubit_bimap_t& chosen) {
+  qubit_mapping_t converted;
+  for (auto [qb, node] : chosen.left) {
+    converted[qb] = node;
+  }
+  return converted;
+}
+
+std::vector<MapCost> Monomorpher::place(unsigned max_return) {
+  if (max_return < 1)
+    throw PlacementError("Max return maps for place must be at least 1.");
+  contract_arc();
+
+  std::vector<qubit_bimap_t> potential_maps = monomorphism_edge_break(
+      arc, q_graph, config.vf2_max_matches, config.timeout);
+  const std::vector<double> costs = map_costs(potential_maps);
+  std::vector<MapCost> map_costs;
+  for (unsigned i = 0; i < potential_maps.size(); i++) {
+    map_costs.push_back({converted_map(potential_maps[i]), costs[i]});
+  }
+
+  keep_best(map_costs, max_return);
   return map_costs;
 }
 
+std::vector<MapCost> Monomorpher::place_anytime(
+    unsigned max_return, unsigned budget) {
+  if (max_return < 1)
+    throw PlacementError("Max return maps for place must be at least 1.");
+  const std::chrono::steady_clock::time_point end_time =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(budget);
+  contract_arc();
+
+  // Leave a tenth of the budget for scoring.
+  std::vector<qubit_bimap_t> potential_maps = monomorphism_edge_break(
+      arc, q_graph, config.vf2_max_matches, std::max(budget - budget / 10, 1u));
+  const std::vector<double> costs = map_costs(potential_maps, [&end_time]() {
+    return std::chrono::steady_clock::now() >= end_time;
+  });
+  if (costs.size() < potential_maps.size()) {
+    tket_log()->warn(
+        "Placement budget of {} milliseconds ran out after scoring {} of {} "
+        "matches.",
+        budget, costs.size(), potential_maps.size());
+  }
+  std::vector<MapCost> map_costs;
+  for (unsigned i = 0; i < costs.size(); i++) {
+    map_costs.push_back({converted_map(potential_maps[i]), costs[i]});
+  }
+
+  keep_best(map_costs, max_return);
+  return map_costs;
+}
+
+namespace {
+
+// The interactions of a circuit and the distances between the nodes of an
+// architecture, as dense arrays indexed by qubit and node
+struct PlacementProblem {
+  qubit_vector_t qubits;
+  std::shared_ptr<const graphs::DistanceMatrix<Node>> distances;
+  unsigned n_qubits;
+  unsigned n_nodes;
+  // Row-major interaction weights between qubits
+  std::vector<double> weights;
+  // The qubits each qubit interacts with, and the weights
+  std::vector<std::vector<std::pair<unsigned, double>>> partners;
+  // The neighbours of each node
+  std::vector<std::vector<unsigned>> neighbours;
+
+  // Distance between nodes, with disconnected nodes as far apart as any
+  unsigned distance(unsigned a, unsigned b) const {
+    if (a == b) return 0;
+    const unsigned d = (*distances)(a, b);
+    return d == 0 ? n_nodes : d;
+  }
+
+  // Node index of each qubit in a map, or -1 if not on the architecture
+  std::vector<int> positions(const qubit_mapping_t& map) const {
+    std::vector<int> pos(n_qubits, -1);
+    for (unsigned q = 0; q < n_qubits; q++) {
+      qubit_mapping_t::const_iterator it = map.find(qubits[q]);
+      if (it == map.end()) continue;
+      try {
+        pos[q] = distances->index(it->second);
+      } catch (const NodeDoesNotExistError&) {
+      }
+    }
+    return pos;
+  }
+
+  double cost(const std::vector<int>& pos) const {
+    double total = 0.;
+    for (unsigned q = 0; q < n_qubits; q++) {
+      if (pos[q] < 0) continue;
+      for (const auto& [k, w] : partners[q]) {
+        if (k > q && pos[k] >= 0) total += w * distance(pos[q], pos[k]);
+      }
+    }
+    return total;
+  }
+};
+
+}  // namespace
+
+static PlacementProblem placement_problem(
+    const Circuit& circ, const Architecture& arc, unsigned depth_limit) {
+  PlacementProblem problem;
+  problem.qubits = circ.all_qubits();
+  problem.distances = arc.get_distance_matrix();
+  const unsigned n = problem.qubits.size();
+  const unsigned n_nodes = problem.distances->n_nodes();
+  problem.n_qubits = n;
+  problem.n_nodes = n_nodes;
+  problem.weights.assign(std::size_t{n} * n, 0.);
+  QubitGraphBuilder builder(problem.qubits);
+  RoutingFrontier current_sf(circ);
+  for (unsigned slice = 0; slice < depth_limit && !current_sf.slice->empty();
+       slice++) {
+    for (const auto& [qb1, qb2] :
+         slice_interactions(circ, current_sf, builder)) {
+      if (qb1 == qb2) continue;
+      problem.weights[std::size_t{qb1} * n + qb2] += depth_limit - slice;
+      problem.weights[std::size_t{qb2} * n + qb1] += depth_limit - slice;
+    }
+    current_sf.next_slicefrontier();
+  }
+  problem.partners.resize(n);
+  for (unsigned i = 0; i < n; i++) {
+    for (unsigned j = 0; j < n; j++) {
+      const double w = problem.weights[std::size_t{i} * n + j];
+      if (w > 0.) problem.partners[i].push_back({j, w});
+    }
+  }
+  problem.neighbours.resize(n_nodes);
+  for (unsigned a = 0; a < n_nodes; a++) {
+    for (unsigned b = 0; b < n_nodes; b++) {
+      if ((*problem.distances)(a, b) == 1) problem.neighbours[a].push_back(b);
+    }
+  }
+  return problem;
+}
+
+double placement_interaction_cost(
+    const Circuit& circ, const Architecture& arc, const qubit_mapping_t& map,
+    unsigned depth_limit) {
+  const PlacementProblem problem = placement_problem(circ, arc, depth_limit);
+  return problem.cost(problem.positions(map));
+}
+
+namespace {
+
+// Best positions and their cost found by one annealing chain
+struct ChainResult {
+  std::vector<int> pos;
+  double cost;
+};
+
+}  // namespace
+
+static ChainResult anneal_placement(
+    const PlacementProblem& problem, std::vector<int> pos, unsigned seed,
+    unsigned max_steps,
+    const std::chrono::steady_clock::time_point& end_time) {
+  const unsigned n_nodes = problem.n_nodes;
+  std::vector<int> occupant(n_nodes, -1);
+  for (unsigned q = 0; q < problem.n_qubits; q++) {
+    if (pos[q] >= 0) occupant[pos[q]] = q;
+  }
+  // Put interacting qubits left off the architecture on free nodes
+  unsigned free_node = 0;
+  std::vector<unsigned> movable;
+  double total_weight = 0.;
+  for (unsigned q = 0; q < problem.n_qubits; q++) {
+    if (problem.partners[q].empty()) continue;
+    if (pos[q] < 0) {
+      while (free_node < n_nodes && occupant[free_node] >= 0) free_node++;
+      if (free_node == n_nodes) {
+        throw PlacementError(
+            "Too few nodes in the architecture for the interacting qubits");
+      }
+      pos[q] = free_node;
+      occupant[free_node] = q;
+    }
+    movable.push_back(q);
+    for (const auto& [k, w] : problem.partners[q]) total_weight += w;
+  }
+  ChainResult best{pos, problem.cost(pos)};
+  if (movable.empty()) return best;
+
+  // Change in cost from moving q from one node to another, ignoring its
+  // interaction with the qubit it swaps with, whose distance is unchanged
+  auto move_delta = [&](unsigned q, unsigned from, unsigned to, int other) {
+    double delta = 0.;
+    for (const auto& [k, w] : problem.partners[q]) {
+      if (int(k) == other) continue;
+      delta += w * (double(problem.distance(to, pos[k])) -
+                    double(problem.distance(from, pos[k])));
+    }
+    return delta;
+  };
+
+  // Cool geometrically from half the mean weight of the interactions of a
+  // qubit to a thousandth of that, when in practice only moves that do not
+  // increase the cost are taken.
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> uniform(0., 1.);
+  const double t_start = total_weight / (2. * movable.size());
+  const double cooling = std::log(1e-3) / std::max(max_steps, 1u);
+  double cost = best.cost;
+  for (unsigned step = 0; step < max_steps; step++) {
+    if (step % 256 == 0 && std::chrono::steady_clock::now() >= end_time) {
+      break;
+    }
+    const unsigned q = movable[gen() % movable.size()];
+    const unsigned a = pos[q];
+    unsigned b;
+    if (gen() % 2 == 0 && !problem.neighbours[a].empty()) {
+      b = problem.neighbours[a][gen() % problem.neighbours[a].size()];
+    } else {
+      b = gen() % n_nodes;
+    }
+    if (a == b) continue;
+    const int r = occupant[b];
+    double delta = move_delta(q, a, b, r);
+    if (r >= 0) delta += move_delta(r, b, a, q);
+    const double temperature = t_start * std::exp(cooling * step);
+    if (delta > 0. && uniform(gen) >= std::exp(-delta / temperature)) {
+      continue;
+    }
+    pos[q] = b;
+    occupant[b] = q;
+    occupant[a] = r;
+    if (r >= 0) pos[r] = a;
+    cost += delta;
+    if (cost < best.cost - EPS) {
+      best.pos = pos;
+      best.cost = cost;
+    }
+  }
+  // Recompute rather than keep the sum of the deltas
+  best.cost = problem.cost(best.pos);
+  return best;
+}
+
+qubit_mapping_t refine_placement(
+    const Circuit& circ, const Architecture& arc,
+    const std::vector<qubit_mapping_t>& starts,
+    const PlacementRefinementConfig& config) {
+  if (starts.empty()) {
+    throw PlacementError("No placement maps to refine");
+  }
+  const std::chrono::steady_clock::time_point end_time =
+      std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(config.budget);
+  const PlacementProblem problem =
+      placement_problem(circ, arc, config.depth_limit);
+  // Chains take the starts in order of cost, so the first starts from the
+  // best of them.
+  std::vector<double> start_costs;
+  for (const qubit_mapping_t& start : starts) {
+    start_costs.push_back(problem.cost(problem.positions(start)));
+  }
+  std::vector<unsigned> order(starts.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](unsigned i, unsigned j) {
+    return start_costs[i] < start_costs[j];
+  });
+  const unsigned n_chains =
+      config.n_chains == 0 ? get_max_threads() : config.n_chains;
+  auto start_of = [&](unsigned c) { return order[c % order.size()]; };
+  std::vector<std::optional<ChainResult>> results(n_chains);
+  parallel_for(0, n_chains, 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t c = begin; c < end; c++) {
+      results[c] = anneal_placement(
+          problem, problem.positions(starts[start_of(c)]), config.seed + c,
+          config.max_steps, end_time);
+    }
+  });
+
+  unsigned best = 0;
+  for (unsigned c = 1; c < n_chains; c++) {
+    if (results[c]->cost < results[best]->cost) best = c;
+  }
+  qubit_mapping_t map = starts[start_of(best)];
+  for (unsigned q = 0; q < problem.n_qubits; q++) {
+    const int p = results[best]->pos[q];
+    if (p >= 0) map[problem.qubits[q]] = problem.distances->node(p);
+  }
+  return map;
+}
+
 }  // namespace tket
@@ -15,18 +15,27 @@
 #include "Routing.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <exception>
 #include <functional>
+#include <limits>
 #include <list>
 #include <map>
+#include <memory>
+#include <optional>
 #include <queue>
 #include <set>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "Utils/Cancellation.hpp"
 #include "Utils/HelperFunctions.hpp"
 #include "Utils/Json.hpp"
+#include "Utils/Parallel.hpp"
+#include "Utils/Trace.hpp"
 
 namespace tket {
 
@@ -34,7 +43,17 @@ bool RoutingConfig::operator==(const RoutingConfig& other) const {
   return (this->depth_limit == other.depth_limit) &&
          (this->distrib_limit == other.distrib_limit) &&
          (this->interactions_limit == other.interactions_limit) &&
-         (this->distrib_exponent == other.distrib_exponent);
+         (this->distrib_exponent == other.distrib_exponent) &&
+         (this->directed_cx == other.directed_cx) &&
+         (this->commute_front_layer == other.commute_front_layer) &&
+         (this->engine == other.engine) &&
+         (this->sabre_extended_set_size == other.sabre_extended_set_size) &&
+         (this->sabre_extended_set_weight ==
+          other.sabre_extended_set_weight) &&
+         (this->sabre_decay_delta == other.sabre_decay_delta) &&
+         (this->sabre_decay_reset == other.sabre_decay_reset) &&
+         (this->sabre_refinement_passes == other.sabre_refinement_passes) &&
+         (this->link_errors == other.link_errors);
 }
 
 // If unit map is same pre and both routing, then the same placement procedure
@@ -49,11 +68,18 @@ bool Routing::circuit_modified() const {
 
 /* Class Constructor */
 Routing::Routing(const Circuit& _circ, const Architecture& _arc)
-    : circ_(_circ), slice_frontier_(circ_), original_arc_(_arc) {
+    : Routing(_circ, std::make_shared<const RoutingContext>(_arc)) {}
+
+Routing::Routing(const Circuit& _circ, RoutingContextPtr _context)
+    : circ_(_circ),
+      slice_frontier_(circ_),
+      context_(std::move(_context)),
+      current_arc_(context_->get_architecture()),
+      original_arc_(context_->get_architecture()),
+      qmap(circ_.all_qubits(), original_arc_.get_all_nodes_vec()) {
   circ_.unit_bimaps_ = _circ.unit_bimaps_;
   original_boundary = circ_.boundary;
 
-  current_arc_ = original_arc_;
   // Checks for circuit and architecture compatibility
   if (circ_.n_qubits() > current_arc_.n_nodes() || current_arc_.n_nodes() < 1) {
     throw ArchitectureMismatch(circ_.n_qubits(), current_arc_.n_nodes());
@@ -74,6 +100,15 @@ void to_json(nlohmann::json& j, const RoutingConfig& config) {
   j["distrib_limit"] = config.distrib_limit;
   j["interactions_limit"] = config.interactions_limit;
   j["distrib_exponent"] = config.distrib_exponent;
+  j["directed_cx"] = config.directed_cx;
+  j["commute_front_layer"] = config.commute_front_layer;
+  j["engine"] = config.engine;
+  j["sabre_extended_set_size"] = config.sabre_extended_set_size;
+  j["sabre_extended_set_weight"] = config.sabre_extended_set_weight;
+  j["sabre_decay_delta"] = config.sabre_decay_delta;
+  j["sabre_decay_reset"] = config.sabre_decay_reset;
+  j["sabre_refinement_passes"] = config.sabre_refinement_passes;
+  j["link_errors"] = config.link_errors;
 }
 
 void from_json(const nlohmann::json& j, RoutingConfig& config) {
@@ -81,12 +116,32 @@ void from_json(const nlohmann::json& j, RoutingConfig& config) {
   config.distrib_limit = j.at("distrib_limit").get<unsigned>();
   config.interactions_limit = j.at("interactions_limit").get<unsigned>();
   config.distrib_exponent = j.at("distrib_exponent").get<double>();
+  // Configurations serialised before these options were added keep the
+  // defaults
+  const RoutingConfig defaults;
+  config.directed_cx = j.value("directed_cx", defaults.directed_cx);
+  config.commute_front_layer =
+      j.value("commute_front_layer", defaults.commute_front_layer);
+  config.engine = j.value("engine", defaults.engine);
+  config.sabre_extended_set_size =
+      j.value("sabre_extended_set_size", defaults.sabre_extended_set_size);
+  config.sabre_extended_set_weight =
+      j.value("sabre_extended_set_weight", defaults.sabre_extended_set_weight);
+  config.sabre_decay_delta =
+      j.value("sabre_decay_delta", defaults.sabre_decay_delta);
+  config.sabre_decay_reset =
+      j.value("sabre_decay_reset", defaults.sabre_decay_reset);
+  config.sabre_refinement_passes =
+      j.value("sabre_refinement_passes", defaults.sabre_refinement_passes);
+  if (j.contains("link_errors")) {
+    config.link_errors = j.at("link_errors").get<avg_link_errors_t>();
+  }
 }
 
 std::vector<Node> Routing::get_active_nodes() const {
   node_vector_t ret;
   ret.reserve(qmap.size());
-  for (auto [qb, n] : qmap.left) {
+  for (const auto& [qb, n] : qmap.placed()) {
     ret.push_back(n);
   }
   return ret;
@@ -178,7 +233,7 @@ qubit_mapping_t get_qmap_from_circuit(Architecture& arc, Circuit& circ) {
 }
 
 std::pair<Circuit, bool> Routing::solve(const RoutingConfig& config) {
-  config_ = config;
+  set_config(config);
   qubit_mapping_t qubit_map = get_qmap_from_circuit(current_arc_, circ_);
   slice_frontier_.init();
   if (slice_frontier_.slice->empty()) {
@@ -194,6 +249,12 @@ std::pair<Circuit, bool> Routing::solve(const RoutingConfig& config) {
     // If no placement, qubits placed sequentially on nodes i.e. qubit 0 -> node
     // 0 etc.
 
+    // The SABRE engine starts from the given mapping and improves it by
+    // routing the circuit forwards and backwards
+    if (config_.engine == RoutingEngine::Sabre &&
+        config_.sabre_refinement_passes > 0) {
+      qubit_map = sabre_refine_mapping(qubit_map);
+    }
     if (qubit_map.size() != 0) {
       init_map.left.insert(qubit_map.begin(), qubit_map.end());
     }
@@ -255,9 +316,15 @@ void Routing::organise_registers_and_maps() {
 // Remap completes the routing algorithm
 // slices passed as copy as 3 pass placement needs original preserved
 qubit_bimap_t Routing::remap(const qubit_bimap_t& init) {
-  qmap = init;
+  TKET_TRACE_SPAN("Routing::remap");
+  qmap.assign(init);
+  interaction_current_ = false;
+  // Distances are queried for every candidate swap, so tabulate them once.
+  current_arc_.precompute_distances();
 
+  const bool sabre = config_.engine == RoutingEngine::Sabre;
   advance_frontier();
+  if (sabre) sabre_advanced(true);
   // The routing algorithm:
   // 1) Slices of circuit are parallelised/packed/whatever into 'timesteps'
   // 2) Swaps are 'proposed' on edges connected to any nodes housing an
@@ -276,34 +343,257 @@ qubit_bimap_t Routing::remap(const qubit_bimap_t& init) {
   // distance between them is chosen. Algorithm then repeats 1)->4).
   // for(unsigned count=0;slice_frontier_.slice.size()!=0 && count<2;count++){
   while (!slice_frontier_.slice->empty()) {
+    check_cancellation();
+    TKET_TRACE_COUNT("iterations", 1);
+    if (sabre) {
+      if (!sabre_step()) {
+        throw RoutingFailure();
+      }
+      if (stop_condition_ && stop_condition_(route_stats)) {
+        throw RoutingAbandoned();
+      }
+      sabre_advanced(advance_frontier());
+      continue;
+    }
     SwapResults single_swap = try_all_swaps(current_arc_.get_all_edges_vec());
     if (single_swap.success) {
       route_stats.n_try_all_swaps++;
+      TKET_TRACE_COUNT("swaps", 1);
       perform_action(single_swap.swap);
     } else {
       route_stats.n_solve_furthest++;
+      TKET_TRACE_COUNT("solve_furthest", 1);
       if (!solve_furthest()) {
         throw RoutingFailure();
       }
     }
+    if (stop_condition_ && stop_condition_(route_stats)) {
+      throw RoutingAbandoned();
+    }
     advance_frontier();
   }
 
   qubit_bimap_t final_qmap;
-  for (l_const_iterator_t it = qmap.left.begin(); it != qmap.left.end(); ++it) {
-    Edge e = slice_frontier_.quantum_out_edges->get<TagKey>()
-                 .find(it->first)
-                 ->second;
+  for (const auto& [qb, node] : qmap.placed()) {
+    Edge e =
+        slice_frontier_.quantum_out_edges->get<TagKey>().find(qb)->second;
     Vertex v = circ_.target(e);
     while (!circ_.detect_final_Op(v)) {
       e = circ_.get_next_edge(v, e);
       v = circ_.target(e);
     }
     Qubit out_q(circ_.get_id_from_out(v));
-    final_qmap.insert({out_q, it->second});
+    final_qmap.insert({out_q, node});
   }
 
   return final_qmap;
 }
 
+PortfolioRoutingResult portfolio_route(
+    const Circuit& circ, const Architecture& arc,
+    const std::vector<RoutingConfig>& configs,
+    const std::vector<PlacementPtr>& placements) {
+  if (configs.empty()) {
+    throw std::invalid_argument("No routing configurations given");
+  }
+  // Placements are not safe to compute from several threads, so do them up
+  // front; the routing data of the architecture is shared by all tasks.
+  std::vector<std::optional<qubit_mapping_t>> maps;
+  for (const PlacementPtr& placement : placements) {
+    maps.push_back(placement->get_placement_map(circ));
+  }
+  if (maps.empty()) maps.push_back(std::nullopt);
+  // Configurations with the link errors of the first share its weighted
+  // distances too.
+  const RoutingContextPtr context = std::make_shared<const RoutingContext>(
+      arc, configs.front().link_errors);
+
+  const unsigned n_tasks = configs.size() * maps.size();
+  std::vector<std::optional<PortfolioRoutingResult>> results(n_tasks);
+  std::vector<std::exception_ptr> errors(n_tasks);
+  std::atomic<unsigned> best_cost = std::numeric_limits<unsigned>::max();
+  parallel_for(0, n_tasks, 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t t = begin; t < end; t++) {
+      const unsigned config_index = t / maps.size();
+      const unsigned placement_index = t % maps.size();
+      try {
+        Circuit placed = circ;
+        if (maps[placement_index]) {
+          qubit_mapping_t map = *maps[placement_index];
+          Placement::place_with_map(placed, map);
+        }
+        Routing router(placed, context);
+        router.set_stop_condition([&best_cost](const Routing::Stats& stats) {
+          return stats.swap_count + stats.bridge_count > best_cost;
+        });
+        std::pair<Circuit, bool> routed = router.solve(configs[config_index]);
+        const Routing::Stats stats = router.get_stats();
+        const unsigned task_cost = stats.swap_count + stats.bridge_count;
+        unsigned current = best_cost;
+        while (task_cost < current &&
+               !best_cost.compare_exchange_weak(current, task_cost)) {
+        }
+        results[t] = PortfolioRoutingResult{
+            routed.first, routed.second, stats, config_index,
+            placement_index};
+      } catch (const RoutingAbandoned&) {
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    }
+  });
+
+  auto cost = [&](unsigned t) {
+    return results[t]->stats.swap_count + results[t]->stats.bridge_count;
+  };
+  std::optional<unsigned> winner;
+  for (unsigned t = 0; t < n_tasks; t++) {
+    if (results[t] && (!winner || cost(t) < cost(*winner))) winner = t;
+  }
+  if (!winner) {
+    // A task is only abandoned once another has finished, so all failed.
+    for (const std::exception_ptr& e : errors) {
+      if (e) std::rethrow_exception(e);
+    }
+    throw RoutingFailure();
+  }
+  return std::move(*results[*winner]);
+}
+
+qubit_mapping_t route_in_windows(
+    const Circuit& circ, const Architecture& arc, unsigned window_slices,
+    const std::function<void(const Circuit&)>& emit,
+    const RoutingConfig& config) {
+  if (window_slices == 0) {
+    throw std::invalid_argument("Windows must contain at least one slice");
+  }
+  const RoutingContextPtr context =
+      std::make_shared<const RoutingContext>(arc, config.link_errors);
+  // Label of each qubit of circ in the current window: its own name until
+  // the first window has been routed, then the node holding it.
+  qubit_mapping_t labels;
+  for (const Qubit& qb : circ.all_qubits()) labels.insert({qb, qb});
+  const bit_vector_t bits = circ.all_bits();
+
+  bool first = true;
+  Circuit::SliceIterator sit = circ.slice_begin();
+  while (first || sit != circ.slice_end()) {
+    Circuit window;
+    for (const std::pair<const Qubit, Qubit>& label : labels) {
+      window.add_qubit(label.second);
+    }
+    for (const Bit& b : bits) window.add_bit(b);
+    if (first) window.add_phase(circ.get_phase());
+    bool multi_qubit = false;
+    for (unsigned i = 0; i < window_slices && sit != circ.slice_end();
+         ++i, ++sit) {
+      for (const Vertex& v : *sit) {
+        const Command com = circ.command_from_vertex(
+            v, sit.get_u_frontier(), sit.get_prev_b_frontier());
+        unit_vector_t args = com.get_args();
+        unsigned n_qubits = 0;
+        for (UnitID& u : args) {
+          if (u.type() == UnitType::Qubit) {
+            u = labels.at(Qubit(u));
+            ++n_qubits;
+          }
+        }
+        multi_qubit |= n_qubits > 1;
+        window.add_op<UnitID>(com.get_op_ptr(), args, com.get_opgroup());
+      }
+    }
+
+    if (!first && !multi_qubit) {
+      // Already placed, and nothing to route: the labels stay as they are.
+      emit(window);
+      continue;
+    }
+    // Later windows must start where the previous one ended
+    RoutingConfig window_config = config;
+    if (!first) window_config.sabre_refinement_passes = 0;
+    Routing router(window, context);
+    std::pair<Circuit, bool> routed = router.solve(window_config);
+    const qubit_mapping_t final_map = router.return_final_map();
+    for (std::pair<const Qubit, Qubit>& label : labels) {
+      label.second = final_map.at(label.second);
+    }
+    emit(routed.first);
+    first = false;
+  }
+  return labels;
+}
+
+Circuit reroute_slices(
+    const Circuit& routed, const Architecture& arc, unsigned first_slice,
+    unsigned n_slices, const RoutingConfig& config) {
+  if (n_slices == 0) {
+    throw std::invalid_argument("Windows must contain at least one slice");
+  }
+  Circuit result;
+  Circuit window;
+  for (const Qubit& qb : routed.all_qubits()) {
+    result.add_qubit(qb);
+    window.add_qubit(qb);
+  }
+  for (const Bit& b : routed.all_bits()) {
+    result.add_bit(b);
+    window.add_bit(b);
+  }
+  result.add_phase(routed.get_phase());
+  auto add_command = [](Circuit& c, const Command& com) {
+    c.add_op<UnitID>(com.get_op_ptr(), com.get_args(), com.get_opgroup());
+  };
+
+  std::vector<Command> suffix;
+  bool multi_qubit = false;
+  unsigned slice = 0;
+  for (Circuit::SliceIterator sit = routed.slice_begin();
+       sit != routed.slice_end(); ++sit, ++slice) {
+    for (const Vertex& v : *sit) {
+      const Command com = routed.command_from_vertex(
+          v, sit.get_u_frontier(), sit.get_prev_b_frontier());
+      if (slice < first_slice) {
+        add_command(result, com);
+      } else if (slice - first_slice < n_slices) {
+        const unit_vector_t args = com.get_args();
+        multi_qubit |=
+            std::count_if(args.begin(), args.end(), [](const UnitID& u) {
+              return u.type() == UnitType::Qubit;
+            }) > 1;
+        add_command(window, com);
+      } else {
+        suffix.push_back(com);
+      }
+    }
+  }
+
+  if (multi_qubit) {
+    // The window starts from the nodes its qubits are named by
+    RoutingConfig window_config = config;
+    window_config.sabre_refinement_passes = 0;
+    const RoutingContextPtr context =
+        std::make_shared<const RoutingContext>(arc, config.link_errors);
+    Routing router(window, context);
+    const Circuit routed_window = router.solve(window_config).first;
+    for (const Qubit& qb : routed_window.all_qubits()) {
+      if (!result.contains_unit(qb)) result.add_qubit(qb);
+    }
+    for (const Command& com : routed_window) add_command(result, com);
+    const std::vector<Swap>& swaps = router.get_swaps();
+    for (auto it = swaps.rbegin(); it != swaps.rend(); ++it) {
+      result.add_op<UnitID>(OpType::SWAP, {it->first, it->second});
+    }
+  } else {
+    for (const Command& com : window) add_command(result, com);
+  }
+  for (const Command& com : suffix) add_command(result, com);
+
+  if (routed.has_implicit_wireswaps()) {
+    qubit_map_t perm = routed.implicit_qubit_permutation();
+    for (const Qubit& qb : result.all_qubits()) perm.insert({qb, qb});
+    result.permute_boundary_output(perm);
+  }
+  return result;
+}
+
 }  // namespace tket
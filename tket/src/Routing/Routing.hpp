@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
 #include <map>
 #include <string>
 #include <utility>
@@ -22,6 +24,8 @@
 #include "Architecture/Architecture.hpp"
 #include "Circuit/Circuit.hpp"
 #include "Placement.hpp"
+#include "QubitNodeMap.hpp"
+#include "RoutingContext.hpp"
 #include "Utils/BiMapHeaders.hpp"
 #include "Utils/Json.hpp"
 
@@ -101,6 +105,12 @@ class RoutingFailure : public std::logic_error {
             "is connected.") {}
 };
 
+class RoutingAbandoned : public std::logic_error {
+ public:
+  RoutingAbandoned()
+      : std::logic_error("Routing abandoned by its stop condition.") {}
+};
+
 class BridgeInvalid : public std::logic_error {
  public:
   explicit BridgeInvalid(const std::string &message)
@@ -115,6 +125,19 @@ class BridgePathIncorrect : public std::logic_error {
   }
 };
 
+// Algorithm used by Routing to choose SWAPs
+enum class RoutingEngine {
+  // Slice lookahead with BRIDGE insertion, after Cowtan et al.
+  CowtanEtAl,
+  // Front layer search with a decaying extended set cost, after SABRE
+  // (Li, Ding & Xie); adds SWAPs only
+  Sabre
+};
+
+NLOHMANN_JSON_SERIALIZE_ENUM(
+    RoutingEngine, {{RoutingEngine::CowtanEtAl, "CowtanEtAl"},
+                    {RoutingEngine::Sabre, "Sabre"}});
+
 // structure of configuration parameters for routing
 struct RoutingConfig {
   // circuit look ahead limit for SWAP picking
@@ -130,6 +153,34 @@ struct RoutingConfig {
   // effect from later interactoins, distrib_exponent > 0 => greater effect,
   // distrib_exponent = 0 => no effect
   double distrib_exponent;
+  // whether to break ties between SWAPs in favour of those after which fewer
+  // CX gates of the front layer run against the direction of their edge,
+  // each of which would need reversing on a directed architecture
+  bool directed_cx = false;
+  // whether, when no gate of the front layer can run, a later two-qubit gate
+  // on adjacent nodes may be moved into it past the gates before it on its
+  // qubits, if it commutes with all of them (for example CZ or ZZPhase gates
+  // sharing a qubit); lets dense diagonal circuits run more gates per SWAP
+  bool commute_front_layer = false;
+  // algorithm used to choose SWAPs; the remaining parameters only apply to
+  // RoutingEngine::Sabre
+  RoutingEngine engine = RoutingEngine::CowtanEtAl;
+  // number of two-qubit gates beyond the front layer in the extended set
+  unsigned sabre_extended_set_size = 20;
+  // weight of the extended set cost relative to the front layer cost
+  double sabre_extended_set_weight = 0.5;
+  // increase in the decay factor of a node for each SWAP acting on it
+  double sabre_decay_delta = 0.001;
+  // number of SWAPs after which the decay factors are reset
+  unsigned sabre_decay_reset = 5;
+  // number of forward and backward routing passes used to refine the
+  // initial mapping before routing
+  unsigned sabre_refinement_passes = 1;
+  // if not empty, SWAPs are scored by the distances between nodes weighted
+  // by the error of each link (see error_weighted_distance_matrix) rather
+  // than by hop count, so that interacting qubits are brought together over
+  // and onto the better links; applies to both engines
+  avg_link_errors_t link_errors;
   // Constructors
   RoutingConfig(
       unsigned _depth_limit, unsigned _distrib_limit,
@@ -193,15 +244,29 @@ class Routing {
     unsigned n_solve_furthest;
     unsigned swap_count;
     unsigned bridge_count;
+    // Cumulative time spent in each phase of routing
+    std::chrono::nanoseconds advance_frontier_time;
+    std::chrono::nanoseconds swap_generation_time;
+    std::chrono::nanoseconds swap_scoring_time;
+    std::chrono::nanoseconds distributed_cx_time;
+    std::chrono::nanoseconds solve_furthest_time;
     Stats()
         : n_try_all_swaps(0),
           n_solve_furthest(0),
           swap_count(0),
-          bridge_count(0) {}
+          bridge_count(0),
+          advance_frontier_time(0),
+          swap_generation_time(0),
+          swap_scoring_time(0),
+          distributed_cx_time(0),
+          solve_furthest_time(0) {}
   };
 
   /* Class Constructor */
   Routing(const Circuit &_circ, const Architecture &_arc);
+  // Share the precomputed data of a context, which may be used by several
+  // instances at once
+  Routing(const Circuit &_circ, RoutingContextPtr _context);
   /* Solve Method */
   // solve using default mapping (line_placement) and default config
   // Default RoutingConfig provides a set of parameters that use all available
@@ -210,11 +275,19 @@ class Routing {
   // distrib_limit = 75
   // interactions_limit = 10
   // distrib_exponent = 0
+  // engine = RoutingEngine::CowtanEtAl
   // This configuration is used for any solve method that does not have config
-  // specified.
+  // specified. With RoutingEngine::Sabre, the mapping given by the qubit names
+  // is only a starting point, refined before routing unless
+  // sabre_refinement_passes = 0.
 
   // solve with default mapping and provided config
   std::pair<Circuit, bool> solve(const RoutingConfig &_config = {});
+  // Condition checked after each SWAP or BRIDGE is chosen; if it returns
+  // true, solve throws RoutingAbandoned.
+  void set_stop_condition(std::function<bool(const Stats &)> condition) {
+    stop_condition_ = std::move(condition);
+  }
   qubit_bimap_t remap(const qubit_bimap_t &init);
   void organise_registers_and_maps();
 
@@ -226,6 +299,8 @@ class Routing {
 
   RoutingFrontier get_slicefrontier() const { return slice_frontier_; }
   Stats get_stats() const { return route_stats; }
+  // SWAPs added so far, in order
+  const std::vector<Swap> &get_swaps() const { return swaps_; }
 
  private:
   // Circuit being solved
@@ -235,17 +310,42 @@ class Routing {
   // Configuration settings for routing
   RoutingConfig config_;
 
+  // Precomputed data of the original architecture
+  RoutingContextPtr context_;
   // Architecture being solved for and the original architecture given
   Architecture current_arc_;
-  Architecture original_arc_;
+  const Architecture &original_arc_;
 
   // Which qubits are interacting and total distance of a board state for
   // interacting qubits
   Interactions interaction;
   // Total distance of a board state for interacting qubits
   graphs::dist_vec dist_vector;
+  // Error-weighted distances by which SWAPs are scored, or null to score
+  // them by the hop distances of current_arc_
+  std::shared_ptr<const graphs::DistanceMatrix<Node>> scoring_distances_;
+  // Whether interaction and dist_vector describe slice_frontier_ under qmap,
+  // so that swaps and advances of the frontier may update them in place
+  bool interaction_current_ = false;
 
   Stats route_stats;
+  std::vector<Swap> swaps_;
+
+  // Adds the time from its construction to its destruction to a total of
+  // route_stats
+  class PhaseTimer {
+   public:
+    explicit PhaseTimer(std::chrono::nanoseconds &total)
+        : total_(total), start_(std::chrono::steady_clock::now()) {}
+    ~PhaseTimer() { total_ += std::chrono::steady_clock::now() - start_; }
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+   private:
+    std::chrono::nanoseconds &total_;
+    std::chrono::steady_clock::time_point start_;
+  };
+  std::function<bool(const Stats &)> stop_condition_;
 
   boundary_t original_boundary;
 
@@ -253,11 +353,18 @@ class Routing {
   // initial map is assigned from placement and the final map displays where
   // qubits end up while routed. Relative mapping is what the final mapping
   // would be if initial mapping was sequential.
-  qubit_bimap_t qmap, init_map, final_map;
+  QubitNodeMap qmap;
+  qubit_bimap_t init_map, final_map;
 
   /* Swap_Analysis.cpp methods */
   // Methods used in determining the best Swap for a given board state and
   // implementing it
+
+  // set config_, and the distances by which SWAPs are scored
+  void set_config(const RoutingConfig &config);
+  // distance by which SWAPs are scored, and its largest value
+  unsigned scoring_distance(const Node &n1, const Node &n2) const;
+  unsigned scoring_diameter() const;
   void increment_distance(
       graphs::dist_vec &new_dist_vector, const Swap &pair, int increment) const;
   graphs::dist_vec generate_distance_vector(const Interactions &inter) const;
@@ -296,11 +403,24 @@ class Routing {
 
   bool solve_furthest();
 
+  // number of the given CX gates that a swap leaves on adjacent nodes but
+  // against the direction of their edge
+  unsigned reversed_cxs(
+      const Swap &swap,
+      const std::vector<std::pair<Qubit, Qubit>> &cxs) const;
+  // of equally good swaps, the last leaving fewest front layer CX gates
+  // reversed
+  Swap least_reversing_swap(const std::vector<Swap> &swaps) const;
+
   /* Slice_Maniupation.cpp methods */
   // find nodes for qubits, activating if necessary
   std::vector<Node> nodes_from_qubits(const qubit_vector_t &qubs);
   // Advances slice frontier past any two_qubit operations on adjacent nodes
   bool advance_frontier();
+  // Moves one two-qubit gate on adjacent nodes into the front layer, past
+  // the gates before it on its qubits which it commutes with, returning
+  // whether any could be moved
+  bool commute_into_front_layer();
 
   bool circuit_modified() const;
 
@@ -309,6 +429,13 @@ class Routing {
   // qubit interactions rather than node
   Interactions generate_interaction_frontier(
       const RoutingFrontier &slice_front);
+  // add the interactions of some vertices of a slice to inter, and add their
+  // distances to dists if given
+  void add_slice_interactions(
+      Interactions &inter, const RoutingFrontier &slice_front,
+      const Slice &verts, graphs::dist_vec *dists) const;
+  // update interaction and dist_vector for the qubits on two nodes swapping
+  void swap_interactions(const Swap &nodes);
   /* Qubit_Placement.cpp methods */
   // Methods for producing a good intial qubit mapping to an architecture from
   // given circuit
@@ -316,12 +443,132 @@ class Routing {
   // void print_qubitlines(QubitLineList &in);
 
   /* Board_Analysis.cpp routing methods */
-  Node find_best_inactive_node(
-      const Node &target_node, const Architecture &arc) const;
+  // closest node of the original architecture not holding a qubit
+  Node find_best_inactive_node(const Node &target_node) const;
   void activate_node(const Node &node);
   void reactivate_qubit(const Qubit &qb, const Qubit &target);
+
+  /* Sabre_Routing.cpp methods */
+  // SABRE state: decay factor of each node, SWAPs since the decay factors
+  // were reset and since the frontier last advanced, and the qubit pairs of
+  // the extended set with the indices of the pairs of each qubit
+  std::map<Node, double> sabre_decay_;
+  unsigned sabre_swaps_since_reset_ = 0;
+  unsigned sabre_swaps_since_progress_ = 0;
+  std::vector<std::pair<Qubit, Qubit>> sabre_extended_;
+  std::map<Qubit, std::vector<unsigned>> sabre_extended_by_qubit_;
+
+  // qubit pairs of the two-qubit gates (or only the CX gates, as control
+  // and target) of some vertices of a slice
+  std::vector<std::pair<Qubit, Qubit>> slice_qubit_pairs(
+      const RoutingFrontier &slice_front, const Slice &verts,
+      bool cx_only = false) const;
+  // refill the extended set from the slices following slice_frontier_
+  void sabre_update_extended_set();
+  // choose and add one SWAP for the front layer, falling back to
+  // solve_furthest when no SWAP has let the frontier advance for a while
+  bool sabre_step();
+  // note whether the frontier advanced after the last step
+  void sabre_advanced(bool advanced);
+  // route the two-qubit interactions of circ_ forwards and backwards from
+  // the given mapping, returning the mapping reached at the end of the last
+  // backward pass
+  qubit_mapping_t sabre_refine_mapping(const qubit_mapping_t &initial) const;
 };
 
+/** Outcome of \ref portfolio_route */
+struct PortfolioRoutingResult {
+  // Routed circuit
+  Circuit circ;
+  // Whether routing changed the circuit
+  bool modified;
+  // Statistics of the winning run
+  Routing::Stats stats;
+  // Index of the winning configuration
+  unsigned config_index;
+  // Index of the winning placement, 0 if no placements were given
+  unsigned placement_index;
+};
+
+/**
+ * Route a circuit with several configurations and placements concurrently,
+ * keeping the result with the fewest SWAPs and BRIDGEs.
+ *
+ * Each configuration is tried with each placement, as separate tasks shared
+ * among up to \ref get_max_threads threads. A task is abandoned as soon as
+ * it has added more SWAPs and BRIDGEs than the best finished task, and ties
+ * go to the earliest configuration, then the earliest placement, so the
+ * result does not depend on the number of threads. Placement maps are
+ * computed before routing starts.
+ *
+ * @param circ circuit to route
+ * @param arc architecture to route for
+ * @param configs candidate routing configurations, at least one
+ * @param placements candidate placements; if empty, the circuit is routed
+ *   with its qubits as given, as by \ref Routing::solve
+ * @throw std::invalid_argument if configs is empty
+ * @throw the first exception thrown by a task, if none of them succeeds
+ */
+PortfolioRoutingResult portfolio_route(
+    const Circuit &circ, const Architecture &arc,
+    const std::vector<RoutingConfig> &configs,
+    const std::vector<PlacementPtr> &placements = {});
+
+/**
+ * Route a circuit one window of slices at a time.
+ *
+ * The circuit is cut into consecutive windows of \p window_slices slices.
+ * Each window is copied into a circuit of its own, with every qubit
+ * relabelled by the node holding it at the end of the previous window, then
+ * routed and passed to \p emit before the next window is built. The router
+ * only ever holds one window, and the first routed gates are available
+ * before the rest of the circuit has been routed. Look-ahead stops at the end
+ * of each window, so more SWAPs may be needed than when routing the whole
+ * circuit at once.
+ *
+ * Appending the emitted circuits in order gives the routed circuit.
+ *
+ * @param circ circuit to route; qubits already named by nodes of \p arc are
+ *   placed there, as by \ref Routing::solve
+ * @param arc architecture to route for
+ * @param window_slices number of slices per window, at least one
+ * @param emit called with each routed window, in order
+ * @param config routing configuration used for every window
+ * @return the node holding each qubit of \p circ at the end
+ */
+qubit_mapping_t route_in_windows(
+    const Circuit &circ, const Architecture &arc, unsigned window_slices,
+    const std::function<void(const Circuit &)> &emit,
+    const RoutingConfig &config = {});
+
+/**
+ * Reroute a window of slices of a routed circuit after it has been edited.
+ *
+ * The slices before \p first_slice and from \p first_slice + \p n_slices
+ * on are copied unchanged. The window between them is routed on its own,
+ * starting with each qubit on the node it is named by, and the SWAPs added
+ * are then undone in reverse order, so that the rest of the circuit finds
+ * every qubit where it was. The implicit qubit permutation of \p routed is
+ * kept, so the initial and final maps of the original routing still hold.
+ *
+ * Only the window is searched for SWAPs, which is much faster than routing
+ * the whole circuit again when the edits are local, at the cost of up to
+ * twice as many SWAPs in the window.
+ *
+ * @param routed circuit on nodes of \p arc, which respects its
+ *   connectivity outside the window
+ * @param arc architecture to route for
+ * @param first_slice first slice of the window
+ * @param n_slices number of slices in the window, at least one
+ * @param config routing configuration for the window
+ * @return the circuit with the window routed; nodes of \p arc that
+ *   \p routed does not use may be added as qubits
+ * @throw std::invalid_argument if n_slices is zero
+ */
+Circuit reroute_slices(
+    const Circuit &routed, const Architecture &arc, unsigned first_slice,
+    unsigned n_slices, const RoutingConfig &config = {});
+
 class RoutingTester {
  private:
   Routing *router;
@@ -361,6 +608,9 @@ class RoutingTester {
   distributed_cx_info check_distributed_cx(const Swap &nodes);
   void advance_frontier();
   void set_interaction();
+  void add_swap(const Swap &nodes);
+  // whether the maintained interactions match ones generated from scratch
+  bool interaction_matches_frontier();
 };
 
 }  // namespace tket
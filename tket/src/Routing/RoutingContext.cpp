@@ -0,0 +1,164 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "RoutingContext.hpp"
+
+#include <algorithm>
+#include <boost/graph/adjacency_list.hpp>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+#include "Utils/Parallel.hpp"
+
+namespace tket {
+
+std::shared_ptr<const graphs::DistanceMatrix<Node>>
+error_weighted_distance_matrix(
+    const Architecture &arc, const avg_link_errors_t &link_errors) {
+  using entry_t = graphs::DistanceMatrix<Node>::entry_t;
+  const std::shared_ptr<const graphs::DistanceMatrix<Node>> hops =
+      arc.get_distance_matrix();
+  const auto undirected = arc.get_undirected_connectivity();
+  const unsigned n = hops->n_nodes();
+  std::vector<Node> nodes(n);
+  for (unsigned i = 0; i < n; i++) nodes[i] = hops->node(i);
+
+  // -log fidelity of each link, by the indices of its ends
+  auto log_infidelity = [&](unsigned i, unsigned j) {
+    double weight = 0.;
+    bool found = false;
+    for (const std::pair<Node, Node> &link :
+         {std::make_pair(nodes[i], nodes[j]),
+          std::make_pair(nodes[j], nodes[i])}) {
+      avg_link_errors_t::const_iterator it = link_errors.find(link);
+      if (it == link_errors.end()) continue;
+      const double w = -std::log1p(-std::min(it->second, 1. - 1e-12));
+      weight = found ? std::min(weight, w) : w;
+      found = true;
+    }
+    return std::max(weight, 0.);
+  };
+  std::vector<std::vector<std::pair<unsigned, double>>> links(n);
+  double unit = std::numeric_limits<double>::infinity();
+  for (unsigned i = 0; i < n; i++) {
+    for (auto [it, end] = boost::adjacent_vertices(i, undirected); it != end;
+         ++it) {
+      const unsigned j = *it;
+      if (j == i) continue;
+      const double w = log_infidelity(i, j);
+      links[i].push_back({j, w});
+      if (w > 0.) unit = std::min(unit, w);
+    }
+  }
+  // Every shortest path has at most n - 1 links, so its cost fits an entry.
+  const unsigned max_cost = std::clamp<unsigned>(
+      std::numeric_limits<entry_t>::max() / std::max(n, 2u), 1u, 16u);
+  std::vector<std::vector<std::pair<unsigned, unsigned>>> costs(n);
+  for (unsigned i = 0; i < n; i++) {
+    for (const auto &[j, w] : links[i]) {
+      const double c = std::isinf(unit) ? 1. : std::round(w / unit);
+      costs[i].push_back(
+          {j, unsigned(std::clamp(c, 1., double(max_cost)))});
+    }
+  }
+
+  std::vector<entry_t> dists(std::size_t{n} * n, 0);
+  parallel_for(0, n, 16, [&](std::size_t begin, std::size_t end) {
+    std::vector<unsigned> dist(n);
+    for (std::size_t source = begin; source < end; source++) {
+      // Dijkstra's algorithm; unreached nodes keep distance 0
+      std::fill(dist.begin(), dist.end(), 0);
+      std::vector<bool> done(n, false);
+      typedef std::pair<unsigned, unsigned> item_t;
+      std::priority_queue<item_t, std::vector<item_t>, std::greater<item_t>>
+          queue;
+      queue.push({0, unsigned(source)});
+      while (!queue.empty()) {
+        const auto [d, i] = queue.top();
+        queue.pop();
+        if (done[i]) continue;
+        done[i] = true;
+        dist[i] = d;
+        for (const auto &[j, c] : costs[i]) {
+          if (!done[j] && (dist[j] == 0 || d + c < dist[j])) {
+            dist[j] = d + c;
+            queue.push({d + c, j});
+          }
+        }
+      }
+      dist[source] = 0;
+      for (unsigned j = 0; j < n; j++) {
+        dists[source * n + j] = entry_t(dist[j]);
+      }
+    }
+  });
+  return std::make_shared<const graphs::DistanceMatrix<Node>>(
+      std::move(nodes), std::move(dists));
+}
+
+RoutingContext::RoutingContext(
+    const Architecture &arc, const avg_link_errors_t &link_errors)
+    : arc_(arc), link_errors_(link_errors) {
+  distances_ = arc_.get_distance_matrix();
+  view_ = arc_.get_connectivity_view();
+  if (!link_errors_.empty()) {
+    weighted_distances_ = error_weighted_distance_matrix(arc_, link_errors_);
+  }
+
+  // Architecture::get_path searches breadth-first, so the central node it
+  // finds is the first neighbour of the start node, in the order of the
+  // undirected graph, that is adjacent to the end node.
+  const auto &undirected = arc_.get_undirected_connectivity();
+  const graphs::DistanceMatrix<Node> &dists = *distances_;
+  const unsigned n = dists.n_nodes();
+  central_nodes_.resize(n);
+  parallel_for(0, n, 16, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; i++) {
+      std::vector<std::pair<unsigned, unsigned>> &row = central_nodes_[i];
+      for (auto [kit, kend] = boost::adjacent_vertices(i, undirected);
+           kit != kend; ++kit) {
+        const unsigned k = *kit;
+        for (auto [jit, jend] = boost::adjacent_vertices(k, undirected);
+             jit != jend; ++jit) {
+          const unsigned j = *jit;
+          if (dists(i, j) == 2 &&
+              std::none_of(row.begin(), row.end(), [j](const auto &p) {
+                return p.first == j;
+              })) {
+            row.push_back({j, k});
+          }
+        }
+      }
+      std::sort(row.begin(), row.end());
+    }
+  });
+}
+
+std::optional<Node> RoutingContext::central_node(
+    const Node &from, const Node &to) const {
+  const std::vector<std::pair<unsigned, unsigned>> &row =
+      central_nodes_[distances_->index(from)];
+  const unsigned j = distances_->index(to);
+  auto it = std::lower_bound(
+      row.begin(), row.end(), j,
+      [](const std::pair<unsigned, unsigned> &p, unsigned target) {
+        return p.first < target;
+      });
+  if (it == row.end() || it->first != j) return std::nullopt;
+  return distances_->node(it->second);
+}
+
+}  // namespace tket
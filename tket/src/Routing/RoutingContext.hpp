@@ -0,0 +1,117 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "Architecture/Architecture.hpp"
+#include "Characterisation/DeviceCharacterisation.hpp"
+
+namespace tket {
+
+/**
+ * Distances between the nodes of an architecture weighted by the errors of
+ * their links, by which noise-aware routing scores SWAPs.
+ *
+ * Each link costs -log(1 - e) for its error e: that of the better direction
+ * where both are given, and zero where neither is. Costs are counted in
+ * units of the smallest positive cost, rounded, and clamped to at least 1
+ * and at most 16 (less on architectures too large for the entries). The
+ * distance between two nodes is the least total cost of a path between
+ * them. Hence neighbours on the best links are at distance 1, a link with
+ * three times their log infidelity counts as three hops, and with uniform
+ * errors these are the hop distances.
+ *
+ * @param arc architecture
+ * @param link_errors average two-qubit error of each link
+ * @return matrix of the weighted distances, with the node indices of
+ *   \ref Architecture::get_distance_matrix
+ */
+std::shared_ptr<const graphs::DistanceMatrix<Node>>
+error_weighted_distance_matrix(
+    const Architecture &arc, const avg_link_errors_t &link_errors);
+
+/**
+ * Architecture data used by routing, computed once per device.
+ *
+ * Building a context computes the all-pairs distance matrix and the
+ * connectivity view of the architecture, and tabulates the central node of
+ * every pair of nodes at distance 2, where a BRIDGE or distributed CX between
+ * them would act. The context is immutable once built, so a single context
+ * may be shared by any number of \ref Routing instances on any number of
+ * threads. Each of them starts from a copy of \ref get_architecture, which
+ * shares the matrix and the view rather than computing them again.
+ *
+ * Given link errors, the context also holds the error-weighted distances for
+ * routing with \ref RoutingConfig::link_errors set to the same errors.
+ */
+class RoutingContext {
+ public:
+  explicit RoutingContext(
+      const Architecture &arc, const avg_link_errors_t &link_errors = {});
+
+  /** The architecture, with its distances and connectivity precomputed */
+  const Architecture &get_architecture() const { return arc_; }
+
+  const graphs::DistanceMatrix<Node> &get_distance_matrix() const {
+    return *distances_;
+  }
+
+  const graphs::ConnectivityView<Node> &get_connectivity_view() const {
+    return *view_;
+  }
+
+  const avg_link_errors_t &get_link_errors() const { return link_errors_; }
+
+  /**
+   * The \ref error_weighted_distance_matrix of the link errors, or null if
+   * there are none
+   */
+  std::shared_ptr<const graphs::DistanceMatrix<Node>>
+  get_error_weighted_distance_matrix() const {
+    return weighted_distances_;
+  }
+
+  /**
+   * Central node between two nodes at distance 2.
+   *
+   * Where there are several, this is the one \ref Architecture::get_path
+   * passes through.
+   *
+   * @param from first node
+   * @param to second node
+   * @return the central node, or std::nullopt if the nodes are not at
+   *   distance 2
+   * @throw NodeDoesNotExistError if either node is not in the architecture
+   */
+  std::optional<Node> central_node(const Node &from, const Node &to) const;
+
+ private:
+  Architecture arc_;
+  std::shared_ptr<const graphs::DistanceMatrix<Node>> distances_;
+  std::shared_ptr<const graphs::ConnectivityView<Node>> view_;
+  avg_link_errors_t link_errors_;
+  std::shared_ptr<const graphs::DistanceMatrix<Node>> weighted_distances_;
+  // For each node index i, the pairs (j, k) of the index j of each node at
+  // distance 2 and the index k of the central node, sorted by j
+  std::vector<std::vector<std::pair<unsigned, unsigned>>> central_nodes_;
+};
+
+typedef std::shared_ptr<const RoutingContext> RoutingContextPtr;
+
+}  // namespace tket
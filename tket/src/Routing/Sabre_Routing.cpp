@@ -0,0 +1,226 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "Routing.hpp"
+#include "Utils/HelperFunctions.hpp"
+#include "Utils/Trace.hpp"
+
+namespace tket {
+
+/*
+The SABRE engine treats the gates of slice_frontier_ as the front layer, and
+the next sabre_extended_set_size two-qubit gates after it as the extended set.
+Each step scores the SWAPs on edges touching a node of the front layer by
+
+  max(decay(a), decay(b)) *
+      (F / |front| + sabre_extended_set_weight * E / |extended|)
+
+where F and E are the total distances of the front layer and extended set
+after the SWAP, and adds the cheapest. Only the pairs on the two swapped nodes
+change, so each candidate is scored from the change in distance of those
+pairs: a step costs O(front x neighbours) lookups in the distance matrix.
+*/
+
+bool Routing::sabre_step() {
+  std::vector<Swap> front;
+  for (const std::pair<const Node, Node> &inter : interaction) {
+    if (inter.first < inter.second) front.push_back(inter);
+  }
+  // Swaps chosen from the cost alone may cycle; once as many have been added
+  // as there are nodes without the frontier advancing, bring the furthest
+  // pair together along a shortest path instead.
+  if (front.empty() ||
+      sabre_swaps_since_progress_ >= current_arc_.n_nodes()) {
+    route_stats.n_solve_furthest++;
+    TKET_TRACE_COUNT("solve_furthest", 1);
+    sabre_swaps_since_progress_ = 0;
+    return solve_furthest();
+  }
+
+  auto dist = [this](const Node &n1, const Node &n2) {
+    return double(scoring_distance(n1, n2));
+  };
+  double front_total = 0.;
+  std::set<Swap> candidates;
+  {
+    PhaseTimer timer(route_stats.swap_generation_time);
+    for (const Swap &pair : front) {
+      front_total += dist(pair.first, pair.second);
+      for (const Node &n : {pair.first, pair.second}) {
+        for (const Node &neighbour : current_arc_.get_neighbour_nodes(n)) {
+          candidates.insert(Swap(std::minmax(n, neighbour)));
+        }
+      }
+    }
+  }
+  std::optional<PhaseTimer> scoring_timer;
+  scoring_timer.emplace(route_stats.swap_scoring_time);
+  // Nodes of the extended set pairs whose qubits are both placed
+  std::vector<std::optional<Swap>> extended_nodes;
+  double extended_total = 0.;
+  unsigned n_extended = 0;
+  for (const std::pair<Qubit, Qubit> &qbs : sabre_extended_) {
+    const Node *first = qmap.find_node(qbs.first);
+    const Node *second = qmap.find_node(qbs.second);
+    if (first == nullptr || second == nullptr) {
+      extended_nodes.push_back(std::nullopt);
+    } else {
+      extended_nodes.push_back(Swap{*first, *second});
+      extended_total += dist(*first, *second);
+      n_extended++;
+    }
+  }
+
+  auto decay = [this](const Node &n) {
+    std::map<Node, double>::const_iterator it = sabre_decay_.find(n);
+    return it == sabre_decay_.end() ? 1. : it->second;
+  };
+  // CX gates of the front layer, to break ties by their direction
+  std::vector<std::pair<Qubit, Qubit>> front_cxs;
+  if (config_.directed_cx) {
+    front_cxs =
+        slice_qubit_pairs(slice_frontier_, *slice_frontier_.slice, true);
+  }
+  std::optional<Swap> best;
+  double best_cost = 0.;
+  for (const Swap &swap : candidates) {
+    const Node &a = swap.first;
+    const Node &b = swap.second;
+    double front_change = 0.;
+    for (const auto &[from, to] : {swap, Swap{b, a}}) {
+      const Node &partner = interaction.at(from);
+      if (partner != from && partner != to) {
+        front_change += dist(to, partner) - dist(from, partner);
+      }
+    }
+    double extended_change = 0.;
+    for (const auto &[from, to] : {swap, Swap{b, a}}) {
+      const Qubit qb = qmap.qubit_on(from);
+      auto it = sabre_extended_by_qubit_.find(qb);
+      if (it == sabre_extended_by_qubit_.end()) continue;
+      for (unsigned i : it->second) {
+        if (!extended_nodes[i]) continue;
+        const Node &partner = extended_nodes[i]->first == from
+                                  ? extended_nodes[i]->second
+                                  : extended_nodes[i]->first;
+        if (partner != to) {
+          extended_change += dist(to, partner) - dist(from, partner);
+        }
+      }
+    }
+    double cost = (front_total + front_change) / front.size();
+    if (n_extended > 0) {
+      cost += config_.sabre_extended_set_weight *
+              (extended_total + extended_change) / n_extended;
+    }
+    cost *= std::max(decay(a), decay(b));
+    if (!best || cost < best_cost ||
+        (!front_cxs.empty() && cost == best_cost &&
+         reversed_cxs(swap, front_cxs) < reversed_cxs(*best, front_cxs))) {
+      best = swap;
+      best_cost = cost;
+    }
+  }
+  scoring_timer.reset();
+  if (!best) return solve_furthest();
+
+  TKET_TRACE_COUNT("swaps", 1);
+  add_swap(*best);
+  sabre_swaps_since_progress_++;
+  if (++sabre_swaps_since_reset_ >= config_.sabre_decay_reset) {
+    sabre_decay_.clear();
+    sabre_swaps_since_reset_ = 0;
+  } else {
+    sabre_decay_[best->first] = decay(best->first) + config_.sabre_decay_delta;
+    sabre_decay_[best->second] =
+        decay(best->second) + config_.sabre_decay_delta;
+  }
+  return true;
+}
+
+void Routing::sabre_advanced(bool advanced) {
+  if (!advanced) return;
+  sabre_decay_.clear();
+  sabre_swaps_since_reset_ = 0;
+  sabre_swaps_since_progress_ = 0;
+  sabre_update_extended_set();
+}
+
+void Routing::sabre_update_extended_set() {
+  sabre_extended_.clear();
+  sabre_extended_by_qubit_.clear();
+  const unsigned size = config_.sabre_extended_set_size;
+  RoutingFrontier high_sf = slice_frontier_;
+  while (sabre_extended_.size() < size && !high_sf.slice->empty()) {
+    high_sf.next_slicefrontier();
+    for (const std::pair<Qubit, Qubit> &qbs :
+         slice_qubit_pairs(high_sf, *high_sf.slice)) {
+      if (sabre_extended_.size() == size) break;
+      sabre_extended_by_qubit_[qbs.first].push_back(sabre_extended_.size());
+      sabre_extended_by_qubit_[qbs.second].push_back(sabre_extended_.size());
+      sabre_extended_.push_back(qbs);
+    }
+  }
+}
+
+qubit_mapping_t Routing::sabre_refine_mapping(
+    const qubit_mapping_t &initial) const {
+  // Circuits of the two-qubit interactions only, in each direction
+  Circuit forward, backward;
+  for (const Qubit &qb : circ_.all_qubits()) {
+    forward.add_qubit(qb);
+    backward.add_qubit(qb);
+  }
+  std::vector<qubit_vector_t> pairs;
+  for (const Command &com : circ_.get_commands()) {
+    qubit_vector_t qbs = com.get_qubits();
+    if (qbs.size() == 2 &&
+        com.get_op_ptr()->get_type() != OpType::Barrier) {
+      pairs.push_back(qbs);
+    }
+  }
+  if (pairs.empty()) return initial;
+  for (const qubit_vector_t &qbs : pairs) {
+    forward.add_op<Qubit>(OpType::CZ, qbs);
+  }
+  for (auto it = pairs.rbegin(); it != pairs.rend(); ++it) {
+    backward.add_op<Qubit>(OpType::CZ, *it);
+  }
+
+  RoutingConfig config = config_;
+  config.sabre_refinement_passes = 0;
+  qubit_mapping_t map = initial;
+  for (unsigned pass = 0; pass < config_.sabre_refinement_passes; pass++) {
+    for (const Circuit *skeleton : {&forward, &backward}) {
+      Routing router(*skeleton, context_);
+      router.config_ = config;
+      router.scoring_distances_ = scoring_distances_;
+      router.init_map.left.insert(map.begin(), map.end());
+      remove_unmapped_nodes(router.current_arc_, router.init_map, router.circ_);
+      router.remap(router.init_map);
+      // Where each qubit ends up is where it should start the next pass
+      map = bimap_to_map(router.qmap.to_bimap().left);
+    }
+  }
+  return map;
+}
+
+}  // namespace tket
@@ -13,12 +13,66 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <map>
 #include <numeric>
+#include <set>
 
+#include "Gate/Commutation.hpp"
 #include "Routing.hpp"
 
 namespace tket {
 
+// Qubit on each quantum out edge of a frontier
+static std::map<Edge, Qubit> qubits_by_edge(const unit_frontier_t& out_edges) {
+  std::map<Edge, Qubit> edge_qubits;
+  for (const std::pair<UnitID, Edge>& pair : out_edges.get<TagKey>()) {
+    edge_qubits.insert({pair.second, Qubit(pair.first)});
+  }
+  return edge_qubits;
+}
+
+// Qubits of the quantum out edges of a vertex which are in a frontier
+static qubit_vector_t vertex_qubits(
+    const Circuit& circ, const Vertex& vert,
+    const std::map<Edge, Qubit>& edge_qubits) {
+  qubit_vector_t qubs;
+  for (const Edge& q_out :
+       circ.get_out_edges_of_type(vert, EdgeType::Quantum)) {
+    auto it = edge_qubits.find(q_out);
+    if (it != edge_qubits.end()) qubs.push_back(it->second);
+  }
+  return qubs;
+}
+
+// Largest number of gates on a qubit looked through for gates to commute into
+// the front layer
+static constexpr unsigned max_front_block_size = 32;
+
+// Gates at the front of a wire, starting from its edge into the front layer,
+// each paired with the edge by which the wire enters it: the first gate, then
+// as many following gates as commute with the same Pauli on the wire as all
+// those before them, so that each commutes on the wire with those before it
+static std::vector<std::pair<Vertex, Edge>> front_block(
+    const Circuit& circ, Edge e) {
+  std::vector<std::pair<Vertex, Edge>> block;
+  std::optional<Pauli> basis = Pauli::I;
+  while (block.size() < max_front_block_size) {
+    Vertex v = circ.target(e);
+    Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
+    if (!op->get_desc().is_gate()) break;
+    std::optional<Pauli> b = op_commuting_basis(*op, circ.get_target_port(e));
+    if (!block.empty() && !(b == Pauli::I || (b && basis == Pauli::I) ||
+                            (b && b == basis))) {
+      break;
+    }
+    block.push_back({v, e});
+    if (!b) break;
+    if (*b != Pauli::I) basis = b;
+    e = circ.get_next_edge(v, e);
+  }
+  return block;
+}
+
 RoutingFrontier::RoutingFrontier(const Circuit& _circ) : circ(_circ) { init(); }
 void RoutingFrontier::init() {
   VertexVec input_slice;
@@ -66,32 +120,32 @@ std::vector<Node> Routing::nodes_from_qubits(const qubit_vector_t& qubs) {
   if (qmap.empty()) {
     Node node0 = *(original_arc_.max_degree_nodes().begin());
     activate_node(node0);
-    qmap.left.insert({qubs[0], node0});
+    qmap.insert(qubs[0], node0);
     init_map.left.insert({qubs[0], node0});
     nodes.push_back(node0);
     start++;
   }
 
   for (unsigned i = start; i < qubs.size(); i++) {
-    l_const_iterator_t node_find = qmap.left.find(qubs[i]);
-    if (node_find == qmap.left.end()) {
+    const Node* node_find = qmap.find_node(qubs[i]);
+    if (node_find == nullptr) {
       if (i < qubs.size() - 1 &&
-          qmap.left.find(qubs[i + 1]) !=
-              qmap.left.end()) {  // TODO: Could this if condition cause some
-                                  // nasty non determinism?
+          qmap.find_node(qubs[i + 1]) !=
+              nullptr) {  // TODO: Could this if condition cause some
+                          // nasty non determinism?
         reactivate_qubit(qubs[i], qubs[i + 1]);
-        nodes.push_back(qmap.left.at(qubs[i]));
+        nodes.push_back(qmap.node_of(qubs[i]));
       } else {
         if (i != 0) {
           reactivate_qubit(qubs[i], qubs[0]);
-          nodes.push_back(qmap.left.at(qubs[i]));
+          nodes.push_back(qmap.node_of(qubs[i]));
         } else {
-          reactivate_qubit(qubs[i], qmap.begin()->left);
-          nodes.push_back(qmap.left.at(qubs[i]));
+          reactivate_qubit(qubs[i], qmap.placed().front().first);
+          nodes.push_back(qmap.node_of(qubs[i]));
         }
       }
     } else {
-      nodes.push_back(node_find->second);
+      nodes.push_back(*node_find);
     }
   }
   return nodes;
@@ -101,21 +155,18 @@ std::vector<Node> Routing::nodes_from_qubits(const qubit_vector_t& qubs) {
 Advances slice frontier past any two_qubit operations on adjacent nodes
 */
 bool Routing::advance_frontier() {
+  PhaseTimer timer(route_stats.advance_frontier_time);
+  const Slice old_slice = *slice_frontier_.slice;
+  // Nodes of the two-qubit gates passed, for updating the interactions
+  std::vector<std::vector<Node>> passed_nodes;
+  bool incremental = interaction_current_;
   bool found_adjacent_op = true;
   while (found_adjacent_op && !slice_frontier_.slice->empty()) {
     found_adjacent_op = false;
+    const std::map<Edge, Qubit> edge_qubits =
+        qubits_by_edge(*slice_frontier_.quantum_out_edges);
     for (const Vertex& vert : *slice_frontier_.slice) {
-      qubit_vector_t qubs;
-      for (const Edge& q_out :
-           circ_.get_out_edges_of_type(vert, EdgeType::Quantum)) {
-        for (const std::pair<UnitID, Edge>& pair :
-             slice_frontier_.quantum_out_edges->get<TagKey>()) {
-          if (pair.second == q_out) {
-            qubs.push_back(Qubit(pair.first));
-            break;
-          }
-        }
-      }
+      qubit_vector_t qubs = vertex_qubits(circ_, vert, edge_qubits);
       // Find OpType. If OpType is a Conditional, unpack to find vertex inside.
       // If it's nested, this will fail.
       OpType vert_type = circ_.get_OpType_from_Vertex(vert);
@@ -147,6 +198,11 @@ bool Routing::advance_frontier() {
           vert_type == OpType::Barrier) {  // if by eachother
         found_adjacent_op = true;          // i.e. at least one 2qb gate has
                                            // been able to run
+        if (vert_type == OpType::Barrier || nods.size() != 2) {
+          incremental = false;
+        } else {
+          passed_nodes.push_back(nods);
+        }
         // for all qubits skip subsequent single qubit vertices to move
         // in edges to be prior to next multiqubit vertex
         for (const Qubit& qub : qubs) {
@@ -169,6 +225,13 @@ bool Routing::advance_frontier() {
         }
       }
     }
+    if (!found_adjacent_op && config_.commute_front_layer &&
+        commute_into_front_layer()) {
+      // The gates of the front layer on the qubits of the moved gate leave
+      // it, so the interactions are found afresh
+      found_adjacent_op = true;
+      incremental = false;
+    }
     if (found_adjacent_op) {
       CutFrontier next_cut = circ_.next_cut(
           slice_frontier_.quantum_in_edges, slice_frontier_.classical_in_edges);
@@ -186,11 +249,115 @@ bool Routing::advance_frontier() {
     }
   }
 
-  interaction = generate_interaction_frontier(slice_frontier_);  // reset
-  dist_vector = generate_distance_vector(interaction);
+  // Activating a node while advancing also clears interaction_current_.
+  if (incremental && interaction_current_) {
+    // The remaining gates of the old slice keep their interactions; only
+    // the nodes of gates passed and of newly exposed gates change.
+    for (const std::vector<Node>& nods : passed_nodes) {
+      for (const Node& n : nods) interaction[n] = n;
+    }
+    const std::set<Vertex> old_verts(old_slice.begin(), old_slice.end());
+    Slice exposed;
+    for (const Vertex& vert : *slice_frontier_.slice) {
+      if (old_verts.find(vert) == old_verts.end()) exposed.push_back(vert);
+    }
+    add_slice_interactions(interaction, slice_frontier_, exposed, &dist_vector);
+  } else {
+    interaction = generate_interaction_frontier(slice_frontier_);  // reset
+    dist_vector = generate_distance_vector(interaction);
+    interaction_current_ = true;
+  }
   return found_adjacent_op;
 }
 
+bool Routing::commute_into_front_layer() {
+  // Where each gate lies in the front blocks of its qubits: the qubit, the
+  // edge into the gate, and whether it is already in the front layer there
+  struct BlockEntry {
+    Qubit qb;
+    Edge in_edge;
+    bool in_front;
+  };
+  std::map<Vertex, std::vector<BlockEntry>> entries;
+  // Gates of the front blocks, in order along the qubits
+  std::vector<Vertex> candidates;
+  for (const std::pair<UnitID, Edge>& pair :
+       slice_frontier_.quantum_in_edges->get<TagKey>()) {
+    std::vector<std::pair<Vertex, Edge>> block =
+        front_block(circ_, pair.second);
+    for (unsigned i = 0; i < block.size(); i++) {
+      auto [it, inserted] = entries.insert({block[i].first, {}});
+      it->second.push_back({Qubit(pair.first), block[i].second, i == 0});
+      if (inserted) candidates.push_back(block[i].first);
+    }
+  }
+  for (const Vertex& vert : candidates) {
+    const std::vector<BlockEntry>& vert_entries = entries[vert];
+    // Two-qubit gates in the front blocks of both their qubits, not already
+    // in the front layer
+    if (vert_entries.size() != 2 ||
+        circ_.n_in_edges_of_type(vert, EdgeType::Quantum) != 2 ||
+        (vert_entries[0].in_front && vert_entries[1].in_front)) {
+      continue;
+    }
+    const Node* node0 = qmap.find_node(vert_entries[0].qb);
+    const Node* node1 = qmap.find_node(vert_entries[1].qb);
+    if (node0 == nullptr || node1 == nullptr ||
+        current_arc_.get_distance(*node0, *node1) != 1) {
+      continue;
+    }
+    // Rewire the gate out of its place on each qubit and in at the front
+    for (const BlockEntry& entry : vert_entries) {
+      if (entry.in_front) continue;
+      const Edge front_e =
+          slice_frontier_.quantum_in_edges->find(entry.qb)->second;
+      const port_t port = circ_.get_target_port(entry.in_edge);
+      const Edge out_e = circ_.get_nth_out_edge(vert, port);
+      const VertPort pred = {
+          circ_.source(entry.in_edge), circ_.get_source_port(entry.in_edge)};
+      const VertPort succ = {circ_.target(out_e), circ_.get_target_port(out_e)};
+      const VertPort front_source = {
+          circ_.source(front_e), circ_.get_source_port(front_e)};
+      const VertPort front_target = {
+          circ_.target(front_e), circ_.get_target_port(front_e)};
+      circ_.remove_edge(entry.in_edge);
+      circ_.remove_edge(out_e);
+      circ_.remove_edge(front_e);
+      circ_.add_edge(pred, succ, EdgeType::Quantum);
+      const Edge new_front_e =
+          circ_.add_edge(front_source, {vert, port}, EdgeType::Quantum);
+      circ_.add_edge({vert, port}, front_target, EdgeType::Quantum);
+      slice_frontier_.quantum_in_edges->replace(
+          slice_frontier_.quantum_in_edges->find(entry.qb),
+          {entry.qb, new_front_e});
+    }
+    // The moved gate has no Boolean inputs
+    for (const BlockEntry& entry : vert_entries) {
+      Bit b("frontier_bit", entry.qb.index());
+      auto b_it = slice_frontier_.classical_in_edges->find(b);
+      if (b_it != slice_frontier_.classical_in_edges->end()) {
+        slice_frontier_.classical_in_edges->replace(b_it, {b, {}});
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
+std::vector<std::pair<Qubit, Qubit>> Routing::slice_qubit_pairs(
+    const RoutingFrontier& slice_front, const Slice& verts,
+    bool cx_only) const {
+  const std::map<Edge, Qubit> edge_qubits =
+      qubits_by_edge(*slice_front.quantum_out_edges);
+  std::vector<std::pair<Qubit, Qubit>> pairs;
+  for (const Vertex& vert : verts) {
+    if (cx_only && circ_.get_OpType_from_Vertex(vert) != OpType::CX) continue;
+    qubit_vector_t qubs = vertex_qubits(circ_, vert, edge_qubits);
+    if (qubs.size() == 2) pairs.push_back({qubs[0], qubs[1]});
+  }
+  return pairs;
+}
+
 Interactions Routing::generate_interaction_frontier(
     const RoutingFrontier& slice_front) {
   Interactions inter;
@@ -198,18 +365,17 @@ Interactions Routing::generate_interaction_frontier(
     Node n(uid);
     inter.insert({n, n});
   }
-  for (const Vertex& vert : *slice_front.slice) {
-    qubit_vector_t qubs;
-    for (const Edge& q_out :
-         circ_.get_out_edges_of_type(vert, EdgeType::Quantum)) {
-      for (const std::pair<UnitID, Edge>& pair :
-           slice_front.quantum_out_edges->get<TagKey>()) {
-        if (pair.second == q_out) {
-          qubs.push_back(Qubit(pair.first));
-          break;
-        }
-      }
-    }
+  add_slice_interactions(inter, slice_front, *slice_front.slice, nullptr);
+  return inter;
+}
+
+void Routing::add_slice_interactions(
+    Interactions& inter, const RoutingFrontier& slice_front, const Slice& verts,
+    graphs::dist_vec* dists) const {
+  const std::map<Edge, Qubit> edge_qubits =
+      qubits_by_edge(*slice_front.quantum_out_edges);
+  for (const Vertex& vert : verts) {
+    qubit_vector_t qubs = vertex_qubits(circ_, vert, edge_qubits);
     // if generate_interaction_frontier called with slice_frontier_ no ops with
     // more than two qubits will be present if generate_interaction_frontier
     // called with frontier made in try_all_swaps or check_distributed_cx,
@@ -221,16 +387,16 @@ Interactions Routing::generate_interaction_frontier(
           "Vertex has " + std::to_string(qubs.size()) + " qubits, expected 2.");
     }
 
-    l_const_iterator_t node0_find = qmap.left.find(qubs[0]);
-    l_const_iterator_t node1_find = qmap.left.find(qubs[1]);
-    if (node0_find != qmap.left.end() && node1_find != qmap.left.end()) {
-      Node one = node0_find->second;
-      Node two = node1_find->second;
+    const Node* node0_find = qmap.find_node(qubs[0]);
+    const Node* node1_find = qmap.find_node(qubs[1]);
+    if (node0_find != nullptr && node1_find != nullptr) {
+      Node one = *node0_find;
+      Node two = *node1_find;
       inter[one] = two;
       inter[two] = one;
+      if (dists != nullptr) increment_distance(*dists, {one, two}, 2);
     }
   }
-  return inter;
 }
 
 }  // namespace tket
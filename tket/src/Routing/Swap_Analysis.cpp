@@ -12,14 +12,45 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <array>
+#include <optional>
+
 #include "Architecture/Architecture.hpp"
 #include "Circuit/CircPool.hpp"
 #include "Routing/Routing.hpp"
+#include "Utils/Parallel.hpp"
+#include "Utils/Trace.hpp"
 
 namespace tket {
 
 /* Routing Class Methods for picking optimal swaps */
 
+void Routing::set_config(const RoutingConfig &config) {
+  config_ = config;
+  if (config_.link_errors.empty()) {
+    scoring_distances_ = nullptr;
+  } else if (config_.link_errors == context_->get_link_errors()) {
+    scoring_distances_ = context_->get_error_weighted_distance_matrix();
+  } else {
+    scoring_distances_ =
+        error_weighted_distance_matrix(original_arc_, config_.link_errors);
+  }
+}
+
+// Nodes removed from current_arc_ still carry weighted paths, so with link
+// errors the distances are those of the original architecture; they only
+// guide the choice of SWAPs, which are always made on current_arc_.
+unsigned Routing::scoring_distance(const Node &n1, const Node &n2) const {
+  if (!scoring_distances_) return current_arc_.get_distance(n1, n2);
+  return scoring_distances_->get_distance(n1, n2);
+}
+
+unsigned Routing::scoring_diameter() const {
+  if (!scoring_distances_) return current_arc_.get_diameter();
+  return scoring_distances_->get_diameter();
+}
+
 /* Overloaded methods for generating distance vectors */
 // Distance vectors comprise of information pertaining to the architectural
 // distance between qubits immediately interacting
@@ -27,14 +58,14 @@ namespace tket {
 // Generates distance vector from input interaction vector
 std::vector<std::size_t> Routing::generate_distance_vector(
     const Interactions &inter) const {
-  const unsigned n = current_arc_.get_diameter();
+  const unsigned n = scoring_diameter();
   // const unsigned n = active_distance_matrix.maxCoeff();
   if (n < 1) {
     throw ArchitectureInvalidity("Architecture has diameter 0.");
   }
   std::vector<std::size_t> dv(n - 1);
   for (auto [n1, n2] : inter) {
-    unsigned dist = current_arc_.get_distance(n1, n2);
+    unsigned dist = scoring_distance(n1, n2);
     if (dist > 1) {
       ++dv[n - dist];
     }
@@ -46,8 +77,8 @@ std::vector<std::size_t> Routing::generate_distance_vector(
 // distance ordered (greatest first)
 const std::pair<unsigned, unsigned> Routing::pair_dists(
     const Node &n1, const Node &p1, const Node &n2, const Node &p2) const {
-  unsigned curr_dist1 = current_arc_.get_distance(n1, p1);
-  unsigned curr_dist2 = current_arc_.get_distance(n2, p2);
+  unsigned curr_dist1 = scoring_distance(n1, p1);
+  unsigned curr_dist2 = scoring_distance(n2, p2);
   return (curr_dist1 > curr_dist2) ? std::make_pair(curr_dist1, curr_dist2)
                                    : std::make_pair(curr_dist2, curr_dist1);
 }
@@ -76,9 +107,8 @@ bool Routing::swap_decreases(
 // change due to swaps nodes
 void Routing::increment_distance(
     graphs::dist_vec &new_dist_vector, const Swap &pair, int increment) const {
-  const unsigned n = current_arc_.get_diameter();
-  const unsigned dis_index =
-      n - current_arc_.get_distance(pair.first, pair.second);
+  const unsigned n = scoring_diameter();
+  const unsigned dis_index = n - scoring_distance(pair.first, pair.second);
   if (dis_index < new_dist_vector.size()) {
     new_dist_vector[dis_index] += increment;
   }
@@ -101,7 +131,7 @@ graphs::dist_vec Routing::update_distance_vector(
   return new_dist_vector;
 }
 
-// Updates qmap to reflect performed swap
+// Updates a bimap placement to reflect performed swap
 void Routing::update_qmap(qubit_bimap_t &map, const Swap &swap) {
   const Qubit qb1 = map.right.at(swap.first);
   const Qubit qb2 = map.right.at(swap.second);
@@ -126,28 +156,113 @@ std::vector<Swap> Routing::candidate_swaps(
   return potential_swaps;
 }
 
+namespace {
+
+/**
+ * Change to a distance vector caused by a proposed swap.
+ *
+ * Only the distances of the two swapped nodes to their interacting partners
+ * change, so this holds at most four (index, increment) entries rather than
+ * a copy of the whole vector.
+ */
+struct DistanceDelta {
+  std::array<std::pair<unsigned, int>, 4> entries;
+  unsigned size = 0;
+
+  int at(unsigned index) const {
+    int total = 0;
+    for (unsigned k = 0; k < size; k++) {
+      if (entries[k].first == index) total += entries[k].second;
+    }
+    return total;
+  }
+};
+
+// Mirrors Routing::update_distance_vector, with the scoring distance given by
+// dist.
+template <typename DistanceFn>
+DistanceDelta swap_delta(
+    const DistanceFn &dist, unsigned diameter, std::size_t dist_size,
+    const Swap &nodes, const Interactions &inte) {
+  DistanceDelta delta;
+  auto increment = [&](const Node &n1, const Node &n2, int inc) {
+    const unsigned dis_index = diameter - dist(n1, n2);
+    if (dis_index < dist_size) {
+      delta.entries[delta.size++] = {dis_index, inc};
+    }
+  };
+  increment(nodes.first, inte.at(nodes.first), -2);
+  increment(nodes.second, inte.at(nodes.second), -2);
+  increment(nodes.second, inte.at(nodes.first), 2);
+  increment(nodes.first, inte.at(nodes.second), 2);
+  return delta;
+}
+
+// Equivalent to tri_lexicographical_comparison(base + d1, base + d2), looking
+// only at the entries which either delta touches.
+int compare_deltas(
+    const graphs::dist_vec &base, const DistanceDelta &d1,
+    const DistanceDelta &d2) {
+  std::array<unsigned, 8> indices;
+  unsigned n_indices = 0;
+  for (unsigned k = 0; k < d1.size; k++) {
+    indices[n_indices++] = d1.entries[k].first;
+  }
+  for (unsigned k = 0; k < d2.size; k++) {
+    indices[n_indices++] = d2.entries[k].first;
+  }
+  std::sort(indices.begin(), indices.begin() + n_indices);
+  for (unsigned k = 0; k < n_indices; k++) {
+    const unsigned index = indices[k];
+    if (k > 0 && index == indices[k - 1]) continue;
+    const std::size_t v1 = base[index] + d1.at(index);
+    const std::size_t v2 = base[index] + d2.at(index);
+    if (v2 < v1) {
+      return 0;
+    } else if (v1 < v2) {
+      return 1;
+    }
+  }
+  return -1;
+}
+
+}  // namespace
+
 // Move heuristic in try_all_swaps loop outside, for testing help and easy
 // changing?
+// Candidates are scored in parallel; the choice of winners is made serially,
+// in candidate order, so the result does not depend on the number of threads.
 std::vector<Swap> Routing::cowtan_et_al_heuristic(
     std::vector<Swap> &candidate_swaps,
     const std::vector<std::size_t> &base_dists,
     const Interactions &interac) const {
+  // Distance queries must not fill the lazy cache from several threads.
+  current_arc_.precompute_distances();
+  const unsigned diameter = scoring_diameter();
+  auto dist = [this](const Node &n1, const Node &n2) {
+    return scoring_distance(n1, n2);
+  };
   const Swap winner = candidate_swaps.back();
   candidate_swaps.pop_back();
-  std::vector<std::size_t> winner_distances =
-      update_distance_vector(winner, base_dists, interac);
+  std::vector<DistanceDelta> deltas(candidate_swaps.size());
+  parallel_for(
+      0, candidate_swaps.size(), 256, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+          deltas[i] = swap_delta(
+              dist, diameter, base_dists.size(), candidate_swaps[i], interac);
+        }
+      });
+  DistanceDelta winner_delta =
+      swap_delta(dist, diameter, base_dists.size(), winner, interac);
   std::vector<Swap> smaller_set;
   smaller_set.push_back(winner);
-  for (const Swap &proposed_swap : candidate_swaps) {
-    const std::vector<std::size_t> proposed_distances =
-        update_distance_vector(proposed_swap, base_dists, interac);
-    const int comp =
-        tri_lexicographical_comparison(proposed_distances, winner_distances);
+  for (std::size_t i = 0; i < candidate_swaps.size(); i++) {
+    const int comp = compare_deltas(base_dists, deltas[i], winner_delta);
     if (comp == -1) {
-      smaller_set.push_back(proposed_swap);
+      smaller_set.push_back(candidate_swaps[i]);
     } else if (comp == 1) {
-      smaller_set = {proposed_swap};
-      winner_distances = proposed_distances;
+      smaller_set = {candidate_swaps[i]};
+      winner_delta = deltas[i];
     }
   }
   return smaller_set;
@@ -155,10 +270,16 @@ std::vector<Swap> Routing::cowtan_et_al_heuristic(
 
 SwapResults Routing::try_all_swaps(const std::vector<Architecture::Connection>
                                        &trial_edges) {  // don't need to change
-  std::vector<Swap> potential_swaps = candidate_swaps(trial_edges, interaction);
+  std::vector<Swap> potential_swaps;
+  {
+    PhaseTimer timer(route_stats.swap_generation_time);
+    potential_swaps = candidate_swaps(trial_edges, interaction);
+  }
+  TKET_TRACE_COUNT("swap_candidates", potential_swaps.size());
 
   if (potential_swaps.empty()) return {false, {Node(0), Node(0)}};
 
+  PhaseTimer timer(route_stats.swap_scoring_time);
   RoutingFrontier high_sf = slice_frontier_;
 
   for (unsigned i = 0; i < config_.depth_limit && !high_sf.slice->empty() &&
@@ -169,15 +290,57 @@ SwapResults Routing::try_all_swaps(const std::vector<Architecture::Connection>
     std::vector<std::size_t> base_dists =
         (i == 0) ? dist_vector : generate_distance_vector(interac);
 
+    TKET_TRACE_COUNT("swap_candidates_evaluated", potential_swaps.size());
     potential_swaps =
         cowtan_et_al_heuristic(potential_swaps, base_dists, interac);
 
     high_sf.next_slicefrontier();
   }
 
+  if (config_.directed_cx && potential_swaps.size() > 1) {
+    return {1, least_reversing_swap(potential_swaps)};
+  }
   return {1, potential_swaps.back()};
 }
 
+unsigned Routing::reversed_cxs(
+    const Swap &swap, const std::vector<std::pair<Qubit, Qubit>> &cxs) const {
+  auto moved = [&swap](const Node &n) {
+    if (n == swap.first) return swap.second;
+    if (n == swap.second) return swap.first;
+    return n;
+  };
+  unsigned count = 0;
+  for (const std::pair<Qubit, Qubit> &cx : cxs) {
+    const Node *ctrl = qmap.find_node(cx.first);
+    const Node *trgt = qmap.find_node(cx.second);
+    if (ctrl == nullptr || trgt == nullptr) continue;
+    const Node ctrl_node = moved(*ctrl);
+    const Node trgt_node = moved(*trgt);
+    if (!current_arc_.edge_exists(ctrl_node, trgt_node) &&
+        current_arc_.edge_exists(trgt_node, ctrl_node)) {
+      count++;
+    }
+  }
+  return count;
+}
+
+Swap Routing::least_reversing_swap(const std::vector<Swap> &swaps) const {
+  const std::vector<std::pair<Qubit, Qubit>> cxs =
+      slice_qubit_pairs(slice_frontier_, *slice_frontier_.slice, true);
+  Swap best = swaps.back();
+  unsigned best_count = reversed_cxs(best, cxs);
+  for (auto it = swaps.rbegin() + 1; it != swaps.rend() && best_count > 0;
+       ++it) {
+    const unsigned count = reversed_cxs(*it, cxs);
+    if (count < best_count) {
+      best = *it;
+      best_count = count;
+    }
+  }
+  return best;
+}
+
 std::vector<Swap> Routing::path_to_swaps(const std::vector<Node> &path) {
   const unsigned len = path.size();
   std::vector<Swap> output_swaps;
@@ -201,6 +364,7 @@ std::vector<Swap> Routing::path_to_swaps(const std::vector<Node> &path) {
 // path between the two interacting qubits at greatest distance and swap along
 // it.
 bool Routing::solve_furthest() {
+  PhaseTimer timer(route_stats.solve_furthest_time);
   bool success = false;
   std::optional<Node> max_node;
   unsigned max_dist = 0;
@@ -230,22 +394,29 @@ bool Routing::solve_furthest() {
 void Routing::update_central_nodes(
     const Swap &nodes, const Interactions &interac,
     distributed_cx_info &candidate_distributed_cx) {
+  // While no node has been removed, the central nodes of the original
+  // architecture are those of the current one
+  const bool full_arc = current_arc_.n_nodes() == original_arc_.n_nodes();
+  auto central = [&](const Node &from) {
+    const Node &to = interac.at(from);
+    if (full_arc) {
+      if (std::optional<Node> centre = context_->central_node(from, to)) {
+        return *centre;
+      }
+    }
+    return current_arc_.get_path(from, to)[1];
+  };
   if (candidate_distributed_cx.first.first) {
-    // TODO: check that there isnt a better way than get_path to do this
-    std::vector<Node> path =
-        current_arc_.get_path(nodes.first, interac.at(nodes.first));
-    candidate_distributed_cx.first.second = path[1];
-    if (interac.at(path[1]) != path[1]) {
+    const Node centre = central(nodes.first);
+    candidate_distributed_cx.first.second = centre;
+    if (interac.at(centre) != centre) {
       candidate_distributed_cx.first.first = false;
     }
   }
   if (candidate_distributed_cx.second.first) {
-    // TODO: this uses solve furthest -> maybe a better way just
-    // using the distance matrix alone for a speed up?
-    std::vector<Node> path =
-        current_arc_.get_path(nodes.second, interac.at(nodes.second));
-    candidate_distributed_cx.second.second = path[1];
-    if (interac.at(path[1]) != path[1]) {
+    const Node centre = central(nodes.second);
+    candidate_distributed_cx.second.second = centre;
+    if (interac.at(centre) != centre) {
       candidate_distributed_cx.second.first = false;
     }
   }
@@ -303,6 +474,7 @@ bool check_vertex_is_CX(const Circuit &circ_, const Vertex &v) {
 // distributed CX gate between nodes.first and its partner node and nodes.second
 // and its partner node respectively
 distributed_cx_info Routing::check_distributed_cx(const Swap &nodes) {
+  PhaseTimer timer(route_stats.distributed_cx_time);
   // 1) Determine which nodes in SWAP gate could complete their CX with a
   // distributed CX gate instead
   distributed_cx_info candidate_distributed_cx = {
@@ -319,10 +491,10 @@ distributed_cx_info Routing::check_distributed_cx(const Swap &nodes) {
     return true;
   };
   if (!cx_check(
-          candidate_distributed_cx.first.first, qmap.right.at(nodes.first)))
+          candidate_distributed_cx.first.first, qmap.qubit_on(nodes.first)))
     return {{false, Node(0)}, {false, Node(0)}};
   if (!cx_check(
-          candidate_distributed_cx.second.first, qmap.right.at(nodes.second)))
+          candidate_distributed_cx.second.first, qmap.qubit_on(nodes.second)))
     return {{false, Node(0)}, {false, Node(0)}};
 
   if (candidate_distributed_cx.first.first ||
@@ -376,6 +548,8 @@ distributed_cx_info Routing::check_distributed_cx(const Swap &nodes) {
 // with a distributed CX
 void Routing::add_distributed_cx(
     const Node &cx_node_0, const Node &cx_node_1, const Node &central_node) {
+  // Replaces a vertex of the slice, so interactions are regenerated.
+  interaction_current_ = false;
   // Find interacting node for starting_node, find node between them. Also swap
   // control and target node if necessary.
 
@@ -391,9 +565,9 @@ void Routing::add_distributed_cx(
 
   route_stats.bridge_count++;
   Edge edge_0 =
-      slice_frontier_.quantum_in_edges->find(qmap.right.at(cx_node_0))->second;
+      slice_frontier_.quantum_in_edges->find(qmap.qubit_on(cx_node_0))->second;
   Edge edge_1 =
-      slice_frontier_.quantum_in_edges->find(qmap.right.at(cx_node_1))->second;
+      slice_frontier_.quantum_in_edges->find(qmap.qubit_on(cx_node_1))->second;
 
   // Assign control and target nodes from cx_node_0 and cx_node_1
   // Depends on the port ordering of the cx_node_0 and cx_node_1 corresponding
@@ -408,9 +582,9 @@ void Routing::add_distributed_cx(
   }
 
   // Find qubits associated to each node
-  const Qubit control_qb = qmap.right.at(control_node);
-  const Qubit central_qb = qmap.right.at(central_node);
-  const Qubit target_qb = qmap.right.at(target_node);
+  const Qubit control_qb = qmap.qubit_on(control_node);
+  const Qubit central_qb = qmap.qubit_on(central_node);
+  const Qubit target_qb = qmap.qubit_on(target_node);
 
   // Initialize variables appropriate for substituting Conditionals with CX
   // gates to Conditionals with BRIDGE gates.
@@ -546,13 +720,29 @@ void Routing::add_distributed_cx(
   slice_frontier_.slice->push_back(bridge_vert);
 }
 
+// The qubits on the swapped nodes keep their partners, so only the entries
+// of the two nodes and of their partners change.
+void Routing::swap_interactions(const Swap &nodes) {
+  if (!interaction_current_) return;
+  const Node pair1 = interaction.at(nodes.first);
+  const Node pair2 = interaction.at(nodes.second);
+  if (pair1 == nodes.second) return;
+  dist_vector = update_distance_vector(nodes, dist_vector, interaction);
+  interaction[nodes.second] = (pair1 == nodes.first) ? nodes.second : pair1;
+  interaction[nodes.first] = (pair2 == nodes.second) ? nodes.first : pair2;
+  if (pair1 != nodes.first) interaction[pair1] = nodes.second;
+  if (pair2 != nodes.second) interaction[pair2] = nodes.first;
+}
+
 // Suitable swap found, amend all global constructs
 void Routing::add_swap(const Swap &nodes) {
   route_stats.swap_count++;
-  const Qubit qb1 = qmap.right.at(nodes.first);
-  const Qubit qb2 = qmap.right.at(nodes.second);
+  swaps_.push_back(nodes);
+  const Qubit qb1 = qmap.qubit_on(nodes.first);
+  const Qubit qb2 = qmap.qubit_on(nodes.second);
 
-  update_qmap(qmap, nodes);
+  qmap.swap_nodes(nodes.first, nodes.second);
+  swap_interactions(nodes);
 
   // ---   --X--\ /--
   //     =   |   X
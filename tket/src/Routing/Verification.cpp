@@ -14,81 +14,224 @@
 
 #include "Verification.hpp"
 
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include "Circuit/UnitPaths.hpp"
+#include "OpType/OpTypeFunctions.hpp"
+#include "Utils/Parallel.hpp"
+
 namespace tket {
-bool respects_connectivity_constraints(
-    const Circuit &circ, const Architecture &arch, bool directed,
-    bool bridge_allowed) {
-  unit_set_t qb_lookup;
-  for (const Qubit &qb : circ.all_qubits()) {
-    if (!arch.node_exists(Node(qb))) return false;
-    qb_lookup.insert(qb);
+
+namespace {
+
+// A gate of a box, by the position of each of its qubits among the qubits of
+// the box
+struct BoxGate {
+  OpType type;
+  std::vector<unsigned> wires;
+};
+
+// The gates of a box, flattened through nested boxes
+struct BoxGates {
+  unsigned n_qubits;
+  // False if some nested box does not match the wires it is placed on
+  bool valid;
+  std::vector<BoxGate> gates;
+};
+
+// Keyed by the box op, which is shared between equal boxes and kept alive
+// by the key
+typedef std::map<Op_ptr, BoxGates> BoxCache;
+
+}  // namespace
+
+static Op_ptr unwrap_conditional(Op_ptr op) {
+  while (op->get_type() == OpType::Conditional) {
+    op = static_cast<const Conditional &>(*op).get_op();
   }
-  for (Circuit::CommandIterator it = circ.begin(); it != circ.end(); ++it) {
-    const Command &com = *it;
-    unit_vector_t qbs;
-    for (const UnitID &arg : com.get_args()) {
-      if (qb_lookup.find(arg) != qb_lookup.end()) qbs.push_back(arg);
+  return op;
+}
+
+static bool gate_respects(
+    const graphs::ConnectivityView<Node> &view, OpType type,
+    const std::vector<unsigned> &nodes, bool directed, bool bridge_allowed) {
+  switch (nodes.size()) {
+    case 1:
+      return true;
+    case 2: {
+      if (!view.connected(nodes[0], nodes[1])) return false;
+      if (directed) {
+        if ((type == OpType::CX || type == OpType::ECR) &&
+            !view.edge_exists(nodes[0], nodes[1]))
+          return false;
+      }
+      return true;
     }
-    Op_ptr op = com.get_op_ptr();
-    if (op->get_type() == OpType::Barrier) continue;
-    if (op->get_type() == OpType::Conditional) {
-      std::shared_ptr<const Conditional> cond_ptr =
-          std::dynamic_pointer_cast<const Conditional>(op);
-      op = cond_ptr->get_op();
+    case 3: {
+      if (!bridge_allowed) return false;
+      if (directed)
+        throw std::logic_error(
+            "BRIDGE ops are disallowed on a directed "
+            "architecture. They must be decomposed.");
+      return type == OpType::BRIDGE && view.connected(nodes[0], nodes[1]) &&
+             view.connected(nodes[1], nodes[2]);
     }
-    if (op->get_type() == OpType::CircBox) {
-      std::shared_ptr<const Box> box_ptr =
-          std::dynamic_pointer_cast<const Box>(op);
-      Circuit box_circ = *box_ptr->to_circuit().get();
-      qubit_vector_t all_units = box_circ.all_qubits();
-      if (all_units.size() != qbs.size()) return false;
-      unit_map_t rename_map;
-      for (unsigned i = 0; i < all_units.size(); i++)
-        rename_map.insert({all_units[i], qbs[i]});
-      box_circ.rename_units(rename_map);
-      if (!respects_connectivity_constraints(
-              box_circ, arch, directed, bridge_allowed))
-        return false;
+    default:
+      return false;
+  }
+}
+
+// Split the vertices to check into gates and boxes
+static void classify_vertices(
+    const Circuit &circ, VertexVec &gates, VertexVec &boxes) {
+  BGL_FORALL_VERTICES(v, circ.dag, DAG) {
+    const OpType type = circ.get_OpType_from_Vertex(v);
+    if (is_boundary_q_type(type) || is_boundary_c_type(type) ||
+        type == OpType::Barrier)
       continue;
+    if (unwrap_conditional(circ.get_Op_ptr_from_Vertex(v))->get_type() ==
+        OpType::CircBox) {
+      boxes.push_back(v);
+    } else {
+      gates.push_back(v);
     }
-    unsigned n_qbs = qbs.size();
-    switch (n_qbs) {
-      case 1:
-        break;
-      case 2: {
-        if (arch.get_distance(Node(qbs[0]), Node(qbs[1])) != 1) {
-          return false;
-        }
-        if (directed) {
-          OpType ot = op->get_type();
-          if ((ot == OpType::CX || ot == OpType::ECR) &&
-              !arch.edge_exists(Node(qbs[0]), Node(qbs[1])))
-            return false;
-        }
-        break;
+  }
+}
+
+// Index in the unit path index of the wire of each quantum in-edge
+static std::vector<unsigned> wire_units(
+    const Circuit &circ, const UnitPathIndex &paths, const Vertex &v) {
+  std::vector<unsigned> wires;
+  for (const Edge &e : circ.get_in_edges_of_type(v, EdgeType::Quantum)) {
+    wires.push_back(paths.position(e)->unit);
+  }
+  return wires;
+}
+
+static const BoxGates &box_gates(const Op_ptr &box_op, BoxCache &cache) {
+  BoxCache::iterator found = cache.find(box_op);
+  if (found != cache.end()) return found->second;
+  const std::shared_ptr<const Box> box_ptr =
+      std::dynamic_pointer_cast<const Box>(box_op);
+  const std::shared_ptr<const Circuit> box_circ = box_ptr->to_circuit();
+  BoxGates result{box_circ->n_qubits(), true, {}};
+  const std::shared_ptr<const UnitPathIndex> paths =
+      box_circ->get_unit_path_index();
+  // Position among the qubits of the box of each unit of the path index
+  std::map<UnitID, unsigned> qubit_position;
+  for (const Qubit &qb : box_circ->all_qubits()) {
+    qubit_position.insert({qb, unsigned(qubit_position.size())});
+  }
+  std::vector<unsigned> position(paths->units().size());
+  for (unsigned u = 0; u < paths->units().size(); u++) {
+    std::map<UnitID, unsigned>::const_iterator it =
+        qubit_position.find(paths->units()[u]);
+    if (it != qubit_position.end()) position[u] = it->second;
+  }
+  VertexVec gates, boxes;
+  classify_vertices(*box_circ, gates, boxes);
+  for (const Vertex &v : gates) {
+    BoxGate gate{
+        unwrap_conditional(box_circ->get_Op_ptr_from_Vertex(v))->get_type(),
+        {}};
+    for (unsigned u : wire_units(*box_circ, *paths, v)) {
+      gate.wires.push_back(position[u]);
+    }
+    result.gates.push_back(std::move(gate));
+  }
+  for (const Vertex &v : boxes) {
+    const Op_ptr inner_op =
+        unwrap_conditional(box_circ->get_Op_ptr_from_Vertex(v));
+    const std::vector<unsigned> wires = wire_units(*box_circ, *paths, v);
+    const BoxGates &inner = box_gates(inner_op, cache);
+    if (!inner.valid || inner.n_qubits != wires.size()) {
+      result.valid = false;
+      result.gates.clear();
+      break;
+    }
+    for (const BoxGate &inner_gate : inner.gates) {
+      BoxGate gate{inner_gate.type, {}};
+      for (unsigned w : inner_gate.wires) {
+        gate.wires.push_back(position[wires[w]]);
       }
-      case 3: {
-        if (bridge_allowed) {
-          if (directed)
-            throw std::logic_error(
-                "BRIDGE ops are disallowed on a directed "
-                "architecture. They must be decomposed.");
-          if (op->get_type() == OpType::BRIDGE) {
-            if (arch.get_distance(Node(qbs[0]), Node(qbs[1])) != 1 ||
-                arch.get_distance(Node(qbs[1]), Node(qbs[2])) != 1) {
-              return false;
-            }
-          } else
-            return false;
-        } else
-          return false;
-        break;
+      result.gates.push_back(std::move(gate));
+    }
+  }
+  return cache.insert({box_op, std::move(result)}).first->second;
+}
+
+bool respects_connectivity_constraints(
+    const Circuit &circ, const Architecture &arch, bool directed,
+    bool bridge_allowed) {
+  const std::shared_ptr<const graphs::ConnectivityView<Node>> view =
+      arch.get_connectivity_view();
+  // Map every qubit to the index of its node once, so that each gate is
+  // checked by looking up the wires of its in-edges in the unit path index
+  // and testing bits of the compiled connectivity.
+  const std::shared_ptr<const UnitPathIndex> paths =
+      circ.get_unit_path_index();
+  const std::vector<UnitID> &units = paths->units();
+  std::vector<unsigned> node_index(units.size());
+  for (unsigned u = 0; u < units.size(); u++) {
+    if (units[u].type() != UnitType::Qubit) continue;
+    const Node node(units[u]);
+    if (!arch.node_exists(node)) return false;
+    node_index[u] = view->index(node);
+  }
+
+  VertexVec gates;
+  VertexVec boxes;
+  classify_vertices(circ, gates, boxes);
+
+  // Flatten each distinct box once, before checking in parallel, so that
+  // every placement of a box costs one pass over its gates rather than a
+  // copy and reindexing of its circuit.
+  BoxCache box_cache;
+  std::vector<const BoxGates *> box_contents(boxes.size());
+  for (unsigned i = 0; i < boxes.size(); i++) {
+    const Op_ptr op = unwrap_conditional(circ.get_Op_ptr_from_Vertex(boxes[i]));
+    const BoxGates &contents = box_gates(op, box_cache);
+    if (!contents.valid) return false;
+    box_contents[i] = &contents;
+  }
+
+  auto vertex_respects = [&](std::size_t i) {
+    if (i < gates.size()) {
+      const Vertex &v = gates[i];
+      std::vector<unsigned> nodes;
+      for (unsigned u : wire_units(circ, *paths, v)) {
+        nodes.push_back(node_index[u]);
       }
-      default:
+      return gate_respects(
+          *view, unwrap_conditional(circ.get_Op_ptr_from_Vertex(v))->get_type(),
+          nodes, directed, bridge_allowed);
+    }
+    const Vertex &v = boxes[i - gates.size()];
+    const BoxGates &contents = *box_contents[i - gates.size()];
+    const std::vector<unsigned> wires = wire_units(circ, *paths, v);
+    if (contents.n_qubits != wires.size()) return false;
+    std::vector<unsigned> nodes;
+    for (const BoxGate &gate : contents.gates) {
+      nodes.clear();
+      for (unsigned w : gate.wires) nodes.push_back(node_index[wires[w]]);
+      if (!gate_respects(*view, gate.type, nodes, directed, bridge_allowed))
         return false;
     }
-  }
-  return true;
+    return true;
+  };
+  // Gates and boxes are checked in one parallel pass, which stops early
+  // once any is found not to respect the architecture.
+  std::atomic<bool> respects = true;
+  parallel_for(
+      0, gates.size() + boxes.size(), 1024,
+      [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end && respects; i++) {
+          if (!vertex_respects(i)) respects = false;
+        }
+      });
+  return respects;
 }
 
 }  // namespace tket
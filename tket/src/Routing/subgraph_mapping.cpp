@@ -15,13 +15,17 @@
 #include <algorithm>
 #include <boost/algorithm/minmax_element.hpp>
 #include <chrono>
+#include <optional>
+#include <vector>
 
 #include "Architecture/Architecture.hpp"
 #include "Graphs/Utils.hpp"
 #include "Placement.hpp"
 #include "Routing/Placement.hpp"
 #include "Utils/Assert.hpp"
+#include "Utils/Cancellation.hpp"
 #include "Utils/GraphHeaders.hpp"
+#include "Utils/Parallel.hpp"
 #include "Utils/TketLog.hpp"
 
 namespace tket {
@@ -37,9 +41,85 @@ bool vf2_match_add_callback<GraphP, GraphT>::operator()(
     new_node_map.insert({qb, node});
   }
   n_maps_.push_back(new_node_map);
-  return (n_maps_.size() < max);
+  return n_maps_.size() < max && !cancellation_requested();
 }
 
+namespace {
+
+long remaining_ms(std::chrono::steady_clock::time_point end_time) {
+  const long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      end_time - std::chrono::steady_clock::now())
+                      .count();
+  return ms > 0 ? ms : 1;
+}
+
+// Find up to max_matches monomorphisms of pattern into target before
+// end_time, appending them to all_maps. Returns whether any were found.
+//
+// With more than one thread available the search is split on the node
+// assigned to the first pattern vertex in VF2's matching order: each target
+// vertex of large enough degree gets a search of its own, pinned there by the
+// vertex equivalence predicate. Each search looks for up to max_matches, and
+// the results are merged in target vertex order. When max_matches cuts the
+// search short, this keeps different matches from the single search done
+// with one thread: any number of threads above one gives the same matches,
+// but only the set of all matches (as found when fewer than max_matches
+// exist) is independent of the number of threads.
+template <typename GraphP, typename GraphT>
+bool search_monomorphisms(
+    const GraphP& pattern, const GraphT& target, unsigned max_matches,
+    std::chrono::steady_clock::time_point end_time,
+    std::vector<qubit_bimap_t>& all_maps) {
+  const unsigned n_targets = boost::num_vertices(target);
+  if (get_max_threads() <= 1 || boost::num_vertices(pattern) == 0 ||
+      n_targets < 2) {
+    vf2_match_add_callback<GraphP, GraphT> callback(
+        all_maps, pattern, target, max_matches);
+    return boost::vf2_subgraph_mono(
+        pattern, target, callback, remaining_ms(end_time));
+  }
+
+  using vertex_p = graphs::utils::vertex<GraphP>;
+  using vertex_t = graphs::utils::vertex<GraphT>;
+  const std::vector<vertex_p> order = boost::vertex_order_by_mult(pattern);
+  const vertex_p first = order.front();
+  const unsigned first_degree = boost::out_degree(first, pattern);
+  std::vector<vertex_t> roots;
+  BGL_FORALL_VERTICES_T(w, target, GraphT) {
+    if (boost::out_degree(w, target) >= first_degree) roots.push_back(w);
+  }
+
+  std::vector<std::vector<qubit_bimap_t>> root_maps(roots.size());
+  std::vector<char> root_found(roots.size(), false);
+  parallel_for(0, roots.size(), 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      const vertex_t root = roots[i];
+      vf2_match_add_callback<GraphP, GraphT> callback(
+          root_maps[i], pattern, target, max_matches);
+      root_found[i] = boost::vf2_subgraph_mono(
+          pattern, target, callback, boost::get(boost::vertex_index, pattern),
+          boost::get(boost::vertex_index, target), order,
+          boost::always_equivalent(),
+          [first, root](const vertex_p& v, const vertex_t& w) {
+            return v != first || w == root;
+          },
+          remaining_ms(end_time));
+    }
+  });
+
+  bool found = false;
+  for (std::size_t i = 0; i < roots.size(); ++i) {
+    found |= root_found[i] != 0;
+    for (qubit_bimap_t& map : root_maps[i]) {
+      if (all_maps.size() >= max_matches) return true;
+      all_maps.push_back(std::move(map));
+    }
+  }
+  return found;
+}
+
+}  // namespace
+
 std::vector<qubit_bimap_t> monomorphism_edge_break(
     const Architecture& arc, const QubitGraph& q_graph, unsigned max_matches,
     unsigned timeout) {
@@ -57,23 +137,28 @@ std::vector<qubit_bimap_t> monomorphism_edge_break(
   std::vector<qubit_bimap_t> all_maps;
   std::chrono::time_point<std::chrono::steady_clock> end_time =
       std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+  // Stop searching at the deadline of the current computation, if sooner
+  std::optional<CancellationToken> token = current_cancellation_token();
+  if (token && token->get_deadline()) {
+    end_time = std::min(end_time, *token->get_deadline());
+  }
 
   while (true) {
-    long search_timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
-                              (end_time - std::chrono::steady_clock::now()) / 2)
-                              .count();
-    if (search_timeout <= 0) search_timeout = 1;
-    vf2_match_add_callback<InteractionGraph, ArchitectureConn> callback(
-        all_maps, undirected_pattern, undirected_target, max_matches);
-    bool found_monomorphism = boost::vf2_subgraph_mono(
-        undirected_pattern, undirected_target, callback, search_timeout);
+    check_cancellation();
+    const std::chrono::steady_clock::time_point search_end =
+        std::chrono::steady_clock::now() +
+        (end_time - std::chrono::steady_clock::now()) / 2;
+    bool found_monomorphism = search_monomorphisms(
+        undirected_pattern, undirected_target, max_matches, search_end,
+        all_maps);
+    check_cancellation();
 
     if (std::chrono::steady_clock::now() >= end_time) {
       tket_log()->warn(
           "boost::vf2_subgraph_mono reached {} millisecond timeout before "
           "reaching set max matches {}, instead finding {} matches. "
           "Please change PlacementConfig.timeout to allow more matches.",
-          timeout, callback.max, all_maps.size());
+          timeout, max_matches, all_maps.size());
       if (all_maps.empty()) {
         throw std::runtime_error("No mappings found before timeout.");
       }
@@ -0,0 +1,203 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "AdjointGradient.hpp"
+
+#include <optional>
+#include <vector>
+
+#include "Circuit/Circuit.hpp"
+#include "Gate/Gate.hpp"
+#include "Gate/GateUnitaryMatrix.hpp"
+#include "Gate/GateUnitaryMatrixError.hpp"
+#include "GateNode.hpp"
+#include "Utils/Exceptions.hpp"
+
+namespace tket {
+namespace tket_sim {
+
+// Step in half-turns for the differences giving gate derivatives
+static const double derivative_step = 1e-3;
+
+namespace {
+
+// A gate of the flattened circuit, with the derivative of its matrix by
+// each parameter which depends on a symbol
+struct GateStep {
+  internal::GateNode node;
+  internal::GateNode adjoint;
+  struct Derivative {
+    internal::GateNode node;
+    // Derivative of the parameter by each symbol, by index in the binding
+    std::vector<std::pair<unsigned, double>> by_symbol;
+  };
+  std::vector<Derivative> derivatives;
+};
+
+}  // namespace
+
+static double evaluate(
+    const Expr& e, const SymEngine::map_basic_basic& sub_map) {
+  const std::optional<double> value = eval_expr(e.subs(sub_map));
+  if (!value) {
+    throw NotValid("No value given for a symbol of the circuit to simulate");
+  }
+  return *value;
+}
+
+static Eigen::MatrixXcd gate_unitary(
+    OpType type, unsigned n_qubits, const std::vector<double>& params) {
+  try {
+    return GateUnitaryMatrix::get_unitary(type, n_qubits, params);
+  } catch (const GateUnitaryMatrixError& e) {
+    throw NotImplemented(e.what());
+  }
+}
+
+// Derivative of the unitary of a gate by one parameter, from central
+// differences with Richardson extrapolation
+static Eigen::MatrixXcd gate_derivative(
+    OpType type, unsigned n_qubits, std::vector<double> params,
+    unsigned index) {
+  auto difference = [&](double h) {
+    const double p = params[index];
+    params[index] = p + h;
+    Eigen::MatrixXcd d = gate_unitary(type, n_qubits, params);
+    params[index] = p - h;
+    d -= gate_unitary(type, n_qubits, params);
+    params[index] = p;
+    return Eigen::MatrixXcd(d / (2 * h));
+  };
+  const double h = derivative_step;
+  return (4 * difference(h / 2) - difference(h)) / 3;
+}
+
+static std::vector<GateStep> flatten_gates(
+    const Circuit& circ, const symbol_map_t& binding) {
+  Circuit flat = circ;
+  flat.decompose_boxes_recursively();
+  std::map<Qubit, unsigned> index;
+  for (const Qubit& qb : flat.all_qubits()) {
+    index.insert({qb, unsigned(index.size())});
+  }
+  SymEngine::map_basic_basic sub_map;
+  std::vector<Sym> symbols;
+  for (const std::pair<const Sym, Expr>& pair : binding) {
+    sub_map[ExprPtr(pair.first)] = ExprPtr(pair.second);
+    symbols.push_back(pair.first);
+  }
+  std::vector<GateStep> steps;
+  for (const Command& com : flat) {
+    const Op_ptr op = com.get_op_ptr();
+    const OpType type = op->get_type();
+    if (type == OpType::noop || type == OpType::Barrier ||
+        type == OpType::Measure) {
+      continue;
+    }
+    if (!op->get_desc().is_gate()) {
+      throw NotImplemented(
+          "Cannot differentiate through " + op->get_name() +
+          ", which is not a gate");
+    }
+    GateStep step;
+    for (const UnitID& arg : com.get_args()) {
+      step.node.qubit_indices.push_back(index.at(Qubit(arg)));
+    }
+    const unsigned n_qubits = step.node.qubit_indices.size();
+    const std::vector<Expr> exprs = op->get_params();
+    std::vector<double> params;
+    for (const Expr& e : exprs) params.push_back(evaluate(e, sub_map));
+    const Eigen::MatrixXcd u = gate_unitary(type, n_qubits, params);
+    step.node.triplets = get_triplets(u, 0.);
+    step.adjoint.qubit_indices = step.node.qubit_indices;
+    step.adjoint.triplets = get_triplets(Eigen::MatrixXcd(u.adjoint()), 0.);
+    for (unsigned i = 0; i < exprs.size(); ++i) {
+      GateStep::Derivative derivative;
+      const SymSet free = expr_free_symbols(exprs[i]);
+      for (unsigned s = 0; s < symbols.size(); ++s) {
+        if (free.count(symbols[s]) == 0) continue;
+        const double d = evaluate(exprs[i].diff(symbols[s]), sub_map);
+        if (d != 0.) derivative.by_symbol.push_back({s, d});
+      }
+      if (derivative.by_symbol.empty()) continue;
+      derivative.node.qubit_indices = step.node.qubit_indices;
+      derivative.node.triplets =
+          get_triplets(gate_derivative(type, n_qubits, params, i), 0.);
+      step.derivatives.push_back(std::move(derivative));
+    }
+    steps.push_back(std::move(step));
+  }
+  return steps;
+}
+
+ExpectationGradient get_expectation_gradient(
+    const Circuit& circ, const symbol_map_t& binding, const OperatorSum& op,
+    unsigned max_number_of_qubits) {
+  const unsigned n = circ.n_qubits();
+  if (n > max_number_of_qubits) {
+    throw NotValid("Circuit to simulate has too many qubits");
+  }
+  const std::vector<GateStep> steps = flatten_gates(circ, binding);
+
+  Eigen::VectorXcd phi = Eigen::VectorXcd::Zero(get_matrix_size(n));
+  phi(0) = 1.;
+  for (const GateStep& step : steps) step.node.apply_full_unitary(phi, n);
+
+  // lambda = P^-1 H P phi, where P is the implicit qubit permutation.
+  const qubit_map_t perm = circ.implicit_qubit_permutation();
+  qubit_map_t inverse;
+  for (const std::pair<const Qubit, Qubit>& pair : perm) {
+    inverse.insert({pair.second, pair.first});
+  }
+  Eigen::VectorXcd psi = phi;
+  apply_qubit_permutation_in_place(psi, perm);
+  const qubit_vector_t qubits = circ.all_qubits();
+  Eigen::VectorXcd lambda = Eigen::VectorXcd::Zero(psi.size());
+  for (const std::pair<QubitPauliString, Complex>& term : op) {
+    lambda += term.second * term.first.dot_state(psi, qubits);
+  }
+  apply_qubit_permutation_in_place(lambda, inverse);
+
+  ExpectationGradient result;
+  result.expectation = phi.dot(lambda).real();
+  std::vector<double> gradient(binding.size(), 0.);
+  Eigen::VectorXcd dphi;
+  for (auto it = steps.rbegin(); it != steps.rend(); ++it) {
+    it->adjoint.apply_full_unitary(phi, n);
+    for (const GateStep::Derivative& derivative : it->derivatives) {
+      dphi = phi;
+      derivative.node.apply_full_unitary(dphi, n);
+      const double d = 2 * lambda.dot(dphi).real();
+      for (const std::pair<unsigned, double>& s : derivative.by_symbol) {
+        gradient[s.first] += s.second * d;
+      }
+    }
+    it->adjoint.apply_full_unitary(lambda, n);
+  }
+  unsigned s = 0;
+  for (const std::pair<const Sym, Expr>& pair : binding) {
+    result.gradient[pair.first] = gradient[s++];
+  }
+  return result;
+}
+
+ExpectationGradient get_expectation_gradient(
+    const Circuit& circ, const symbol_map_t& binding,
+    const QubitPauliString& op, unsigned max_number_of_qubits) {
+  return get_expectation_gradient(
+      circ, binding, OperatorSum{{op, 1.}}, max_number_of_qubits);
+}
+
+}  // namespace tket_sim
+}  // namespace tket
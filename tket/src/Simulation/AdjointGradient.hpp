@@ -0,0 +1,69 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <map>
+
+#include "Utils/Expression.hpp"
+#include "Utils/PauliStrings.hpp"
+
+namespace tket {
+class Circuit;
+
+namespace tket_sim {
+
+/** The expectation value of an operator in the state produced by a
+ *  circuit, and its derivatives by the symbols of the circuit.
+ */
+struct ExpectationGradient {
+  double expectation;
+  /** The derivative by each symbol of the binding */
+  std::map<Sym, double, SymEngine::RCPBasicKeyLess> gradient;
+};
+
+/** Calculate <psi|H|psi> and its gradient, where psi is the state produced
+ *  by applying a symbolic circuit to |00...0> with the symbols bound to the
+ *  given values, and H is a sum of Pauli strings on the qubits of the
+ *  circuit, assumed Hermitian.
+ *  The gradient is found by the adjoint method: the state is simulated
+ *  forwards once, then the state and H|psi> are run backwards through the
+ *  gates together, picking up the derivative of each gate in turn. This
+ *  costs about three simulations of the circuit however many symbols there
+ *  are, where the parameter shift rule needs two per symbol.
+ *  Boxes are decomposed into gates first. The derivative of each gate
+ *  matrix by its parameters is found numerically, accurate to about 1e-10;
+ *  that of the parameters by the symbols exactly.
+ *  (Note: if any OpType::Measure or OpType::Barrier occur,
+ *  they are simply ignored - the same as a noop).
+ *  @throw NotValid if a symbol of the circuit has no value, or the circuit
+ *              has too many qubits.
+ *  @throw NotImplemented if an operation is not a gate, e.g. conditional,
+ *              or has no unitary.
+ *  @param circ The circuit to simulate.
+ *  @param binding The value of each symbol.
+ *  @param op The operator H, as a sum of Pauli strings with coefficients.
+ *  @param max_number_of_qubits Throw an exception if this limit is exceeded.
+ */
+ExpectationGradient get_expectation_gradient(
+    const Circuit& circ, const symbol_map_t& binding, const OperatorSum& op,
+    unsigned max_number_of_qubits = 11);
+
+/** As above, for a single Pauli string. */
+ExpectationGradient get_expectation_gradient(
+    const Circuit& circ, const symbol_map_t& binding,
+    const QubitPauliString& op, unsigned max_number_of_qubits = 11);
+
+}  // namespace tket_sim
+}  // namespace tket
@@ -14,6 +14,11 @@
 
 #include "CircuitSimulator.hpp"
 
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <random>
 #include <sstream>
 
 #include "Circuit/Circuit.hpp"
@@ -21,6 +26,12 @@
 #include "Gate/GateUnitaryMatrixError.hpp"
 #include "GateNodesBuffer.hpp"
 #include "Utils/Exceptions.hpp"
+#include "Utils/Parallel.hpp"
+
+#ifdef TKET_SIM_CUDA
+#include "DeviceGateNodesBuffer.hpp"
+#include "DeviceKernels.hpp"
+#endif
 
 namespace tket {
 namespace tket_sim {
@@ -28,13 +39,20 @@ namespace tket_sim {
 Eigen::MatrixXcd get_unitary(
     const Circuit& circ, double abs_epsilon, unsigned max_number_of_qubits) {
   const auto matr_size = get_matrix_size(circ.n_qubits());
-  Eigen::MatrixXcd result = Eigen::MatrixXcd::Identity(matr_size, matr_size);
-  apply_unitary(circ, result, abs_epsilon, max_number_of_qubits);
+  Eigen::MatrixXcd result(matr_size, matr_size);
+  write_unitary(circ, result, abs_epsilon, max_number_of_qubits);
   return result;
 }
 
+void write_unitary(
+    const Circuit& circ, Eigen::Ref<Eigen::MatrixXcd> out, double abs_epsilon,
+    unsigned max_number_of_qubits) {
+  out.setIdentity();
+  apply_unitary(circ, out, abs_epsilon, max_number_of_qubits);
+}
+
 static void apply_unitary_may_throw(
-    const Circuit& circ, Eigen::MatrixXcd& matr, double abs_epsilon,
+    const Circuit& circ, Eigen::Ref<Eigen::MatrixXcd> matr, double abs_epsilon,
     unsigned max_number_of_qubits) {
   if (circ.n_qubits() > max_number_of_qubits) {
     throw GateUnitaryMatrixError(
@@ -51,13 +69,22 @@ static void apply_unitary_may_throw(
         "M has wrong number of rows",
         GateUnitaryMatrixError::Cause::INPUT_ERROR);
   }
+#ifdef TKET_SIM_CUDA
+  if (circ.n_qubits() >= internal::min_device_qubits &&
+      internal::device::available()) {
+    internal::DeviceGateNodesBuffer buffer(matr, abs_epsilon);
+    internal::decompose_circuit(circ, buffer, abs_epsilon);
+    apply_qubit_permutation_in_place(matr, circ.implicit_qubit_permutation());
+    return;
+  }
+#endif
   internal::GateNodesBuffer buffer(matr, abs_epsilon);
   internal::decompose_circuit(circ, buffer, abs_epsilon);
-  matr = apply_qubit_permutation(matr, circ.implicit_qubit_permutation());
+  apply_qubit_permutation_in_place(matr, circ.implicit_qubit_permutation());
 }
 
 void apply_unitary(
-    const Circuit& circ, Eigen::MatrixXcd& matr, double abs_epsilon,
+    const Circuit& circ, Eigen::Ref<Eigen::MatrixXcd> matr, double abs_epsilon,
     unsigned max_number_of_qubits) {
   try {
     apply_unitary_may_throw(circ, matr, abs_epsilon, max_number_of_qubits);
@@ -79,12 +106,247 @@ void apply_unitary(
 
 Eigen::VectorXcd get_statevector(
     const Circuit& circ, double abs_epsilon, unsigned max_number_of_qubits) {
-  Eigen::MatrixXcd result =
-      Eigen::MatrixXcd::Zero(get_matrix_size(circ.n_qubits()), 1);
-  result(0, 0) = 1.0;
-  apply_unitary(circ, result, abs_epsilon, max_number_of_qubits);
+  Eigen::VectorXcd result(get_matrix_size(circ.n_qubits()));
+  write_statevector(circ, result, abs_epsilon, max_number_of_qubits);
+  return result;
+}
+
+void write_statevector(
+    const Circuit& circ, Eigen::Ref<Eigen::VectorXcd> out, double abs_epsilon,
+    unsigned max_number_of_qubits) {
+  out.setZero();
+  if (out.size() > 0) out(0) = 1.0;
+  // View the vector as a single column, without copying it
+  Eigen::Map<Eigen::MatrixXcd> matr(out.data(), out.size(), 1);
+  apply_unitary(circ, matr, abs_epsilon, max_number_of_qubits);
+}
+
+std::vector<StateVector> get_statevectors(
+    const Circuit& circ, const std::vector<symbol_map_t>& bindings,
+    double abs_epsilon, unsigned max_number_of_qubits) {
+  // Substitute in this thread, then simulate the copies concurrently.
+  std::vector<Circuit> circs;
+  circs.reserve(bindings.size());
+  for (const symbol_map_t& binding : bindings) {
+    circs.push_back(circ);
+    circs.back().symbol_substitution(binding);
+  }
+  std::vector<StateVector> result(bindings.size());
+  parallel_for(0, circs.size(), 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      result[i] = get_statevector(circs[i], abs_epsilon, max_number_of_qubits);
+    }
+  });
   return result;
 }
 
+Eigen::MatrixXcd random_states(
+    unsigned n_qubits, unsigned n_states, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> dist;
+  Eigen::MatrixXcd states(get_matrix_size(n_qubits), n_states);
+  for (unsigned col = 0; col < n_states; ++col) {
+    for (Eigen::Index row = 0; row < states.rows(); ++row) {
+      states(row, col) = Complex(dist(rng), dist(rng));
+    }
+    states.col(col).normalize();
+  }
+  return states;
+}
+
+// Shots drawn with each random number generator
+static const unsigned shots_per_block = 1u << 12;
+// Smallest range of amplitudes worth handing to another thread
+static const std::size_t min_amplitudes_range = 1u << 16;
+
+static unsigned n_qubits_of_state(const StateVector& sv) {
+  unsigned n = 0;
+  while ((Eigen::Index(1) << n) < sv.size()) ++n;
+  if ((Eigen::Index(1) << n) != sv.size()) {
+    throw NotValid("State vector size is not a power of 2");
+  }
+  return n;
+}
+
+// Probabilities of the outcomes of measuring the given qubits, packed with
+// the first qubit most significant; not normalised.
+static std::vector<double> outcome_weights(
+    const StateVector& sv, const std::vector<unsigned>& qubits) {
+  const unsigned n = n_qubits_of_state(sv);
+  const unsigned m = qubits.size();
+  std::vector<bool> seen(n, false);
+  for (unsigned q : qubits) {
+    if (q >= n || seen[q]) {
+      throw NotValid("Qubits to sample are out of range or repeated");
+    }
+    seen[q] = true;
+  }
+  if (m > 63) throw NotValid("Too many qubits to sample");
+  std::vector<double> weights(std::size_t(1) << m, 0.);
+  std::mutex mutex;
+  parallel_for(
+      0, sv.size(), min_amplitudes_range,
+      [&](std::size_t begin, std::size_t end) {
+        std::vector<double> local(weights.size(), 0.);
+        for (std::size_t x = begin; x < end; ++x) {
+          std::size_t y = 0;
+          for (unsigned j = 0; j < m; ++j) {
+            y = (y << 1) | ((x >> (n - 1 - qubits[j])) & 1);
+          }
+          local[y] += std::norm(sv(x));
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::size_t y = 0; y < weights.size(); ++y) {
+          weights[y] += local[y];
+        }
+      });
+  return weights;
+}
+
+namespace {
+
+// Walker's alias table, for drawing from a discrete distribution in
+// constant time
+class AliasTable {
+ public:
+  explicit AliasTable(const std::vector<double>& weights)
+      : threshold_(weights.size()), alias_(weights.size()) {
+    double total = 0.;
+    for (double w : weights) total += w;
+    if (!(total > 0.)) throw NotValid("Cannot sample from a zero state");
+    const std::size_t n = weights.size();
+    std::vector<std::size_t> small, large;
+    for (std::size_t i = 0; i < n; ++i) {
+      threshold_[i] = weights[i] * n / total;
+      alias_[i] = i;
+      (threshold_[i] < 1. ? small : large).push_back(i);
+    }
+    while (!small.empty() && !large.empty()) {
+      const std::size_t s = small.back(), l = large.back();
+      small.pop_back();
+      alias_[s] = l;
+      threshold_[l] -= 1. - threshold_[s];
+      if (threshold_[l] < 1.) {
+        large.pop_back();
+        small.push_back(l);
+      }
+    }
+    // What is left is 1 up to rounding.
+    for (std::size_t i : small) threshold_[i] = 1.;
+    for (std::size_t i : large) threshold_[i] = 1.;
+  }
+
+  std::uint64_t draw(std::mt19937_64& rng) const {
+    std::uniform_int_distribution<std::size_t> column(
+        0, threshold_.size() - 1);
+    std::uniform_real_distribution<double> height(0., 1.);
+    const std::size_t i = column(rng);
+    return height(rng) < threshold_[i] ? i : alias_[i];
+  }
+
+ private:
+  std::vector<double> threshold_;
+  std::vector<std::size_t> alias_;
+};
+
+}  // namespace
+
+static std::vector<std::uint64_t> draw_shots(
+    const std::vector<double>& weights, unsigned n_shots, unsigned seed) {
+  const AliasTable table(weights);
+  std::vector<std::uint64_t> shots(n_shots);
+  const std::size_t n_blocks =
+      (std::size_t(n_shots) + shots_per_block - 1) / shots_per_block;
+  parallel_for(0, n_blocks, 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t block = begin; block < end; ++block) {
+      std::seed_seq seq{seed, unsigned(block)};
+      std::mt19937_64 rng(seq);
+      const std::size_t last =
+          std::min(std::size_t(n_shots), (block + 1) * shots_per_block);
+      for (std::size_t i = block * shots_per_block; i < last; ++i) {
+        shots[i] = table.draw(rng);
+      }
+    }
+  });
+  return shots;
+}
+
+std::vector<std::uint64_t> sample_shots(
+    const StateVector& sv, unsigned n_shots, unsigned seed) {
+  const unsigned n = n_qubits_of_state(sv);
+  std::vector<unsigned> qubits(n);
+  std::iota(qubits.begin(), qubits.end(), 0);
+  return sample_shots(sv, qubits, n_shots, seed);
+}
+
+std::vector<std::uint64_t> sample_shots(
+    const StateVector& sv, const std::vector<unsigned>& qubits,
+    unsigned n_shots, unsigned seed) {
+  return draw_shots(outcome_weights(sv, qubits), n_shots, seed);
+}
+
+std::vector<std::uint64_t> sample_readouts(
+    const Circuit& circ, const StateVector& sv, unsigned n_shots,
+    unsigned seed) {
+  if (sv.size() != Eigen::Index(get_matrix_size(circ.n_qubits()))) {
+    throw NotValid("State vector does not match the circuit");
+  }
+  const bit_vector_t bits = circ.all_bits();
+  if (bits.size() > 64) throw NotValid("Too many bits to sample");
+  std::map<Qubit, unsigned> qubit_index;
+  for (const Qubit& qb : circ.all_qubits()) {
+    qubit_index.insert({qb, unsigned(qubit_index.size())});
+  }
+  std::map<Bit, unsigned> bit_index;
+  for (const Bit& b : bits) bit_index.insert({b, unsigned(bit_index.size())});
+  std::vector<unsigned> qubits;
+  std::vector<unsigned> targets;
+  for (const std::pair<const Qubit, Bit>& pair : circ.qubit_to_bit_map()) {
+    qubits.push_back(qubit_index.at(pair.first));
+    targets.push_back(bit_index.at(pair.second));
+  }
+  std::vector<std::uint64_t> shots = sample_shots(sv, qubits, n_shots, seed);
+  const unsigned m = qubits.size();
+  const unsigned n_bits = bits.size();
+  for (std::uint64_t& shot : shots) {
+    std::uint64_t readout = 0;
+    for (unsigned j = 0; j < m; ++j) {
+      if ((shot >> (m - 1 - j)) & 1) {
+        readout |= std::uint64_t(1) << (n_bits - 1 - targets[j]);
+      }
+    }
+    shot = readout;
+  }
+  return shots;
+}
+
+bool compare_circuits_by_probing(
+    const Circuit& circ1, const Circuit& circ2, bool up_to_global_phase,
+    unsigned n_probes, double tolerance, unsigned max_number_of_qubits,
+    unsigned seed) {
+  if (circ1.n_qubits() != circ2.n_qubits()) {
+    throw NotValid(
+        "Circuits to compare have " + std::to_string(circ1.n_qubits()) +
+        " and " + std::to_string(circ2.n_qubits()) + " qubits");
+  }
+  if (n_probes == 0) {
+    throw NotValid("Comparing circuits needs at least one probe");
+  }
+  Eigen::MatrixXcd states1 = random_states(circ1.n_qubits(), n_probes, seed);
+  Eigen::MatrixXcd states2 = states1;
+  // The probes are the columns of one matrix, so each circuit is decomposed
+  // once and the probes are simulated in parallel.
+  apply_unitary(circ1, states1, EPS, max_number_of_qubits);
+  apply_unitary(circ2, states2, EPS, max_number_of_qubits);
+  if (up_to_global_phase) {
+    // The phase is that of the overlap summed over all the probes, so a
+    // different phase on each probe is still detected below.
+    const Complex overlap = states1.conjugate().cwiseProduct(states2).sum();
+    if (std::abs(overlap) <= tolerance) return false;
+    states1 *= overlap / std::abs(overlap);
+  }
+  return (states1 - states2).cwiseAbs().maxCoeff() <= tolerance;
+}
+
 }  // namespace tket_sim
 }  // namespace tket
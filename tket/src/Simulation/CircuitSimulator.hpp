@@ -14,6 +14,10 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
+#include "Utils/Expression.hpp"
 #include "Utils/MatrixAnalysis.hpp"
 
 namespace tket {
@@ -60,6 +64,11 @@ Eigen::MatrixXcd get_unitary(
  *  OpType::Measure is ignored if it occurs.
  *  Note that U is not calculated explicitly and sparse matrices are used,
  *  so it is quicker than calling calc_unitary if M is, e.g., a column vector.
+ *  To simulate a batch of states, pass them as the columns of M: the circuit
+ *  is decomposed once, and the columns are processed in parallel.
+ *  If tket was configured with TKET_SIM_CUDA and a CUDA device is present,
+ *  circuits of 18 or more qubits are simulated on the device instead.
+ *  The other functions here which simulate circuits all call this one.
  *  @throw NotImplemented if any unimplemented gate occurs.
  *  @param circ The circuit to simulate.
  *  @param matr The matrix M which will be premultiplied by the unitary matrix.
@@ -70,8 +79,131 @@ Eigen::MatrixXcd get_unitary(
  * @param max_number_of_qubits Throw an exception if this limit is exceeded.
  */
 void apply_unitary(
-    const Circuit& circ, Eigen::MatrixXcd& matr, double abs_epsilon = EPS,
-    unsigned max_number_of_qubits = 11);
+    const Circuit& circ, Eigen::Ref<Eigen::MatrixXcd> matr,
+    double abs_epsilon = EPS, unsigned max_number_of_qubits = 11);
+
+/** As get_statevector, but writes the statevector into a buffer owned by
+ *  the caller (e.g. an Eigen::Map over a NumPy array), so that no copy of
+ *  the result is made.
+ *  @param circ The circuit to simulate.
+ *  @param out Column vector of size 2^n, overwritten with the statevector.
+ *  @param abs_epsilon As for get_statevector.
+ *  @param max_number_of_qubits Throw an exception if this limit is exceeded.
+ */
+void write_statevector(
+    const Circuit& circ, Eigen::Ref<Eigen::VectorXcd> out,
+    double abs_epsilon = EPS, unsigned max_number_of_qubits = 11);
+
+/** As get_unitary, but writes the unitary into a buffer owned by the
+ *  caller, so that no copy of the result is made.
+ *  @param circ The circuit to simulate.
+ *  @param out Square matrix of size 2^n, overwritten with the unitary.
+ *  @param abs_epsilon As for get_unitary.
+ *  @param max_number_of_qubits Throw an exception if this limit is exceeded.
+ */
+void write_unitary(
+    const Circuit& circ, Eigen::Ref<Eigen::MatrixXcd> out,
+    double abs_epsilon = EPS, unsigned max_number_of_qubits = 11);
+
+/** Calculate the statevectors of a symbolic circuit for several
+ *  assignments of values to its symbols, applied to the state |00...0>,
+ *  using ILO-BE convention.
+ *  The symbols are substituted into a copy of the circuit for each binding,
+ *  and the copies are simulated concurrently.
+ *  @throw NotImplemented if any unimplemented gate occurs.
+ *  @param circ The circuit to simulate.
+ *  @param bindings The values of the symbols, one map per statevector.
+ *  @param abs_epsilon As for get_statevector.
+ *  @param max_number_of_qubits Throw an exception if this limit is exceeded.
+ *  @return The statevector for each element of bindings, in order.
+ */
+std::vector<StateVector> get_statevectors(
+    const Circuit& circ, const std::vector<symbol_map_t>& bindings,
+    double abs_epsilon = EPS, unsigned max_number_of_qubits = 11);
+
+/** Random normalised state vectors, as the columns of a matrix.
+ *  The amplitudes are complex Gaussian, so the states are uniformly
+ *  distributed, and depend only on the seed.
+ *  @param n_qubits Number of qubits of each state.
+ *  @param n_states Number of states (columns).
+ *  @param seed Seed for the random number generator.
+ */
+Eigen::MatrixXcd random_states(
+    unsigned n_qubits, unsigned n_states, unsigned seed = 0);
+
+/** Draw shots from the distribution of outcomes of measuring every qubit
+ *  of a state in the computational basis.
+ *  The outcomes are drawn in parallel from an alias table, with a random
+ *  number generator for each block of shots seeded from the seed and the
+ *  index of the block, so they depend only on the seed and not on the
+ *  number of threads.
+ *  @throw NotValid if the state is zero, or its size is not a power of 2.
+ *  @param sv The state, in ILO-BE convention; it need not be normalised.
+ *  @param n_shots Number of shots.
+ *  @param seed Seed for the random number generators.
+ *  @return The outcome of each shot, packed as the index of the basis
+ *              state measured (so qubit 0 is the most significant bit).
+ */
+std::vector<std::uint64_t> sample_shots(
+    const StateVector& sv, unsigned n_shots, unsigned seed = 0);
+
+/** As sample_shots, but measuring only some of the qubits.
+ *  @throw NotValid if the state is zero, its size is not a power of 2,
+ *              or the qubits are out of range or repeated.
+ *  @param sv The state, in ILO-BE convention.
+ *  @param qubits The indices of the qubits to measure.
+ *  @param n_shots Number of shots.
+ *  @param seed Seed for the random number generators.
+ *  @return The outcome of each shot, packed with the value of qubits[0]
+ *              as the most significant of qubits.size() bits.
+ */
+std::vector<std::uint64_t> sample_shots(
+    const StateVector& sv, const std::vector<unsigned>& qubits,
+    unsigned n_shots, unsigned seed = 0);
+
+/** Draw shots of the readouts of a circuit from its final state.
+ *  The qubits measured are those of Circuit::qubit_to_bit_map, i.e. those
+ *  whose last operation is a measurement into a bit which is not written
+ *  to afterwards; all other bits read 0.
+ *  @throw NotValid if the state does not have the size of the circuit,
+ *              or the circuit has more than 64 bits.
+ *  @param circ The circuit.
+ *  @param sv The final state of the circuit, e.g. from get_statevector.
+ *  @param n_shots Number of shots.
+ *  @param seed Seed for the random number generators.
+ *  @return The readout of each shot, packed with the first bit of
+ *              Circuit::all_bits() as the most significant of n_bits bits.
+ */
+std::vector<std::uint64_t> sample_readouts(
+    const Circuit& circ, const StateVector& sv, unsigned n_shots,
+    unsigned seed = 0);
+
+/** Check whether two circuits have the same unitary, without calculating
+ *  either unitary: both circuits are applied to the same random states,
+ *  and the results compared.
+ *  Two different unitaries agree on a random state with probability zero,
+ *  so a single probe suffices in exact arithmetic; more probes guard
+ *  against differences which are small on one state.
+ *  The cost is that of simulating each circuit on n_probes state vectors,
+ *  so much larger circuits can be checked than with get_unitary.
+ *  @throw NotValid if the circuits have different numbers of qubits, or
+ *              n_probes is zero.
+ *  @throw NotImplemented if any unimplemented gate occurs.
+ *  @param circ1 The first circuit.
+ *  @param circ2 The second circuit.
+ *  @param up_to_global_phase Whether to allow the unitaries to differ by
+ *              a global phase (common to every probe).
+ *  @param n_probes Number of random states to apply the circuits to.
+ *  @param tolerance Largest allowed difference between any two amplitudes.
+ *  @param max_number_of_qubits Throw an exception if this limit is exceeded.
+ *  @param seed Seed for the random states.
+ *  @return Whether the circuits appear to be equivalent.
+ */
+bool compare_circuits_by_probing(
+    const Circuit& circ1, const Circuit& circ2,
+    bool up_to_global_phase = false, unsigned n_probes = 2,
+    double tolerance = 1e-10, unsigned max_number_of_qubits = 20,
+    unsigned seed = 0);
 
 }  // namespace tket_sim
 }  // namespace tket
@@ -20,8 +20,7 @@
 #include "Circuit/Circuit.hpp"
 #include "Gate/Gate.hpp"
 #include "Gate/GateUnitaryMatrix.hpp"
-#include "GateNodesBuffer.hpp"
-#include "PauliExpBoxUnitaryCalculator.hpp"
+#include "Gate/GateUnitarySparseMatrix.hpp"
 #include "Utils/Assert.hpp"
 #include "Utils/Exceptions.hpp"
 
@@ -48,7 +47,8 @@ static QMap get_qmap_no_checks(
 
 // Already known to be a box, with a nonempty Op ptr.
 // If possible (if the op is able to calculate its own unitary matrix),
-// fill the node triplets with the raw unitary matrix represented by this box.
+// fill the node triplets with the raw unitary matrix represented by this box,
+// or, for a PauliExpBox, the node Paulis and phase.
 // Return true if it found the triplets.
 static bool fill_triplets_directly_from_box(
     GateNode& node, const std::shared_ptr<const Box>& box_ptr, OpType type,
@@ -75,17 +75,19 @@ static bool fill_triplets_directly_from_box(
     case OpType::PauliExpBox: {
       auto pauli_box_ptr = dynamic_cast<const PauliExpBox*>(box_ptr.get());
       TKET_ASSERT(pauli_box_ptr);
-      node.triplets = get_triplets(*pauli_box_ptr);
+      const auto phase_optional = eval_expr(pauli_box_ptr->get_phase());
+      if (!phase_optional) {
+        throw NotImplemented("PauliExpBox has symbolic phase parameter");
+      }
+      // No triplets: the gadget is applied analytically.
+      node.paulis = pauli_box_ptr->get_paulis();
+      node.pauli_phase = phase_optional.value();
       return true;
     }
     case OpType::ExpBox: {
       auto exp_box_ptr = dynamic_cast<const ExpBox*>(box_ptr.get());
       TKET_ASSERT(exp_box_ptr);
-      const auto numerical_data = exp_box_ptr->get_matrix_and_phase();
-      Eigen::Matrix4cd matrix =
-          numerical_data.first * (i_ * numerical_data.second);
-      matrix = matrix.exp();
-      node.triplets = tket::get_triplets(matrix);
+      node.triplets = tket::get_triplets(exp_box_ptr->get_exp_matrix());
       return true;
     }
     default:
@@ -93,7 +95,7 @@ static bool fill_triplets_directly_from_box(
   }
 }
 
-static void add_global_phase(const Circuit& circ, GateNodesBuffer& buffer) {
+static void add_global_phase(const Circuit& circ, GateNodeSink& buffer) {
   const auto global_phase = eval_expr(circ.get_phase());
   if (!global_phase) {
     throw NotImplemented("Circuit has symbolic global phase");
@@ -122,7 +124,7 @@ static void fill_qubit_indices(
 }
 
 static void decompose_circuit_recursive(
-    const Circuit& circ, GateNodesBuffer& buffer,
+    const Circuit& circ, GateNodeSink& buffer,
     const std::vector<unsigned>& parent_circuit_qubit_indices,
     double abs_epsilon) {
   const auto qmap = get_qmap_no_checks(circ, parent_circuit_qubit_indices);
@@ -152,11 +154,23 @@ static void decompose_circuit_recursive(
       throw_with_op_error_message(desc.name(), qmap, circ, "No args!");
     }
     fill_qubit_indices(args, qmap, node);
+    node.control_indices.clear();
+    node.paulis.clear();
     if (desc.is_gate()) {
       const Gate* gate = dynamic_cast<const Gate*>(current_op.get());
       TKET_ASSERT(gate);
-      node.triplets =
-          GateUnitaryMatrix::get_unitary_triplets(*gate, abs_epsilon);
+      node.triplets = tket::internal::GateUnitarySparseMatrix::
+          get_controlled_target_triplets(*gate, abs_epsilon);
+      if (!node.triplets.empty()) {
+        // Keep only the target block; the last qubit is the target.
+        node.control_indices.assign(
+            node.qubit_indices.begin(), node.qubit_indices.end() - 1);
+        node.qubit_indices.erase(
+            node.qubit_indices.begin(), node.qubit_indices.end() - 1);
+      } else {
+        node.triplets =
+            GateUnitaryMatrix::get_unitary_triplets(*gate, abs_epsilon);
+      }
       buffer.push(node);
       continue;
     }
@@ -172,7 +186,7 @@ static void decompose_circuit_recursive(
     const bool found_unitary = fill_triplets_directly_from_box(
         node, box_ptr, current_op->get_type(), abs_epsilon);
 
-    if (!node.triplets.empty()) {
+    if (!node.triplets.empty() || !node.paulis.empty()) {
       TKET_ASSERT(found_unitary);
       buffer.push(node);
       continue;
@@ -193,7 +207,7 @@ static void decompose_circuit_recursive(
 }
 
 void decompose_circuit(
-    const Circuit& circ, GateNodesBuffer& buffer, double abs_epsilon) {
+    const Circuit& circ, GateNodeSink& buffer, double abs_epsilon) {
   // The qubits are just [0,1,2,...].
   std::vector<unsigned> iota(circ.n_qubits());
   std::iota(iota.begin(), iota.end(), 0);
@@ -14,21 +14,22 @@
 
 #pragma once
 
+#include "GateNode.hpp"
 #include "Utils/MatrixAnalysis.hpp"
 
 namespace tket {
 class Circuit;
 namespace tket_sim {
 namespace internal {
-class GateNodesBuffer;
 
 /** Break up the circuit into individual gates and boxes,
- *  and pass the data for each component one-by-one into the buffer object.
- *  The buffer object is responsible for processing the data
- *  to obtain full (2^n)*(2^n) unitaries and multiplying them as appropriate.
+ *  and pass the data for each component one-by-one into the sink object,
+ *  e.g. a GateNodesBuffer, which processes the data to obtain full
+ *  (2^n)*(2^n) unitaries and multiplies them as appropriate.
+ *  The sink is flushed at the end.
  */
 void decompose_circuit(
-    const Circuit& circ, GateNodesBuffer& buffer, double abs_epsilon);
+    const Circuit& circ, GateNodeSink& buffer, double abs_epsilon);
 
 }  // namespace internal
 }  // namespace tket_sim
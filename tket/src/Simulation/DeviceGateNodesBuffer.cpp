@@ -0,0 +1,155 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "DeviceGateNodesBuffer.hpp"
+
+#include <algorithm>
+
+#include "DeviceKernels.hpp"
+#include "FusedGateBlock.hpp"
+#include "PauliExpBoxUnitaryCalculator.hpp"
+#include "Utils/Exceptions.hpp"
+
+namespace tket {
+namespace tket_sim {
+namespace internal {
+
+// The block in the form read by the device, acting on the given qubits of
+// the full matrix
+static FusedBlockData<Complex> get_block_data(
+    const std::vector<unsigned>& qubits, const Eigen::MatrixXcd& unitary,
+    unsigned full_number_of_qubits) {
+  FusedBlockData<Complex> data;
+  const unsigned k = qubits.size();
+  data.n_qubits = k;
+  for (unsigned r = 0; r < k; ++r) {
+    data.sorted_positions[r] = full_number_of_qubits - 1 - qubits[r];
+  }
+  std::sort(data.sorted_positions, data.sorted_positions + k);
+  const unsigned size = get_matrix_size(k);
+  for (unsigned j = 0; j < size; ++j) {
+    // Qubit r of the block is bit k-1-r of the local index (ILO-BE)
+    std::uint64_t bits = 0;
+    for (unsigned r = 0; r < k; ++r) {
+      if ((j >> (k - 1 - r)) & 1) {
+        bits |= std::uint64_t(1) << (full_number_of_qubits - 1 - qubits[r]);
+      }
+    }
+    data.offsets[j] = bits;
+    for (unsigned i = 0; i < size; ++i) {
+      data.unitary[i * size + j] = unitary(i, j);
+    }
+  }
+  return data;
+}
+
+struct DeviceGateNodesBuffer::Impl {
+  Eigen::Ref<Eigen::MatrixXcd> matrix;
+  const unsigned number_of_qubits;
+  double global_phase;
+
+  // The product of the gates pushed since the last block was applied.
+  FusedGateBlock fused;
+
+  // The matrix as updated by every block applied so far.
+  device::DeviceMatrix device_matrix;
+
+  Impl(Eigen::Ref<Eigen::MatrixXcd> matr, double abs_eps)
+      : matrix(matr),
+        number_of_qubits(get_number_of_qubits(matr.rows())),
+        global_phase(0.0),
+        fused(max_device_block_qubits, abs_eps),
+        device_matrix(matr.rows(), matr.cols()) {
+    if (matr.cols() == 0) {
+      throw NotValid("Matrix has zero cols");
+    }
+    device_matrix.upload(matrix.data(), matrix.outerStride());
+  }
+
+  void push(const GateNode&);
+
+  void add_global_phase(double ph) { global_phase += ph; }
+
+  void flush();
+
+  // Apply the fused block on the device, and empty it.
+  void apply_fused();
+
+  // Apply a gate too large for a block on the host.
+  void apply_on_host(const GateNode&);
+};
+
+void DeviceGateNodesBuffer::Impl::push(const GateNode& node) {
+  if (node.qubit_indices.size() + node.control_indices.size() >
+      max_device_block_qubits) {
+    apply_on_host(node);
+    return;
+  }
+  if (!node.paulis.empty()) {
+    GateNode dense;
+    dense.triplets = get_triplets(node.paulis, node.pauli_phase);
+    dense.qubit_indices = node.qubit_indices;
+    push(dense);
+    return;
+  }
+  if (!node.control_indices.empty()) {
+    push(node.without_controls());
+    return;
+  }
+  if (!fused.fits(node)) apply_fused();
+  fused.push(node);
+}
+
+void DeviceGateNodesBuffer::Impl::apply_fused() {
+  if (fused.empty()) return;
+  device_matrix.apply_block(
+      get_block_data(fused.qubits(), fused.unitary(), number_of_qubits));
+  fused.clear();
+}
+
+void DeviceGateNodesBuffer::Impl::apply_on_host(const GateNode& node) {
+  apply_fused();
+  device_matrix.download(matrix.data(), matrix.outerStride());
+  node.apply_full_unitary(matrix, number_of_qubits);
+  device_matrix.upload(matrix.data(), matrix.outerStride());
+}
+
+void DeviceGateNodesBuffer::Impl::flush() {
+  apply_fused();
+  device_matrix.download(matrix.data(), matrix.outerStride());
+  if (global_phase != 0.0) {
+    const auto factor = std::polar(1.0, PI * global_phase);
+    matrix *= factor;
+    global_phase = 0.0;
+  }
+}
+
+DeviceGateNodesBuffer::DeviceGateNodesBuffer(
+    Eigen::Ref<Eigen::MatrixXcd> matrix, double abs_epsilon)
+    : pimpl(std::make_unique<Impl>(matrix, abs_epsilon)) {}
+
+DeviceGateNodesBuffer::~DeviceGateNodesBuffer() {}
+
+void DeviceGateNodesBuffer::push(const GateNode& node) { pimpl->push(node); }
+
+void DeviceGateNodesBuffer::add_global_phase(double ph) {
+  pimpl->add_global_phase(ph);
+}
+
+void DeviceGateNodesBuffer::flush() { pimpl->flush(); }
+
+}  // namespace internal
+}  // namespace tket_sim
+}  // namespace tket
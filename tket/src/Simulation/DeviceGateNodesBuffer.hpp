@@ -0,0 +1,68 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <memory>
+
+#include "GateNode.hpp"
+#include "Utils/MatrixAnalysis.hpp"
+
+namespace tket {
+namespace tket_sim {
+namespace internal {
+
+/** Smallest number of qubits of a circuit worth simulating on the device,
+ *  rather than paying for the copies to and from it.
+ */
+constexpr unsigned min_device_qubits = 18;
+
+/** As GateNodesBuffer, but applying the gates to a copy of the matrix held
+ *  on the device; only built when tket is configured with TKET_SIM_CUDA.
+ *
+ *  Consecutive gates are multiplied together on the host into dense blocks
+ *  of up to max_device_block_qubits qubits, and each block is applied on the
+ *  device in a single pass over the matrix. The rare gates too large for a
+ *  block (e.g. wide Pauli gadgets) are applied on the host, copying the
+ *  matrix back and forth. On flush() the result is copied into the matrix
+ *  passed to the constructor.
+ */
+class DeviceGateNodesBuffer : public GateNodeSink {
+ public:
+  /** @param matrix The matrix to premultiply by the circuit's unitary,
+   *      which must remain valid throughout the lifetime of this object.
+   *  @param abs_epsilon Used to convert almost-zero entries to zero entries.
+   *  @throw std::runtime_error if the device cannot hold the matrix.
+   */
+  DeviceGateNodesBuffer(
+      Eigen::Ref<Eigen::MatrixXcd> matrix, double abs_epsilon);
+
+  ~DeviceGateNodesBuffer() override;
+
+  void push(const GateNode& node) override;
+
+  void add_global_phase(double) override;
+
+  void flush() override;
+
+ private:
+  // Pimpl idiom.
+  struct Impl;
+  std::unique_ptr<Impl> pimpl;
+};
+
+}  // namespace internal
+}  // namespace tket_sim
+}  // namespace tket
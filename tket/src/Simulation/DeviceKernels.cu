@@ -0,0 +1,115 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <cuda_runtime.h>
+#include <thrust/complex.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "DeviceKernels.hpp"
+
+namespace tket {
+namespace tket_sim {
+namespace internal {
+namespace device {
+
+typedef thrust::complex<double> DeviceComplex;
+
+static_assert(
+    sizeof(DeviceComplex) == sizeof(std::complex<double>),
+    "Device and host complex numbers must have the same layout");
+
+// The block being applied; small enough for constant memory, and read by
+// every thread. Held as raw storage, as constant memory cannot have a
+// constructor.
+__constant__ __align__(16) unsigned char
+    block_bytes[sizeof(FusedBlockData<DeviceComplex>)];
+
+static constexpr unsigned threads_per_block = 256;
+
+static void check(cudaError_t err, const char* what) {
+  if (err != cudaSuccess) {
+    throw std::runtime_error(
+        std::string(what) + " failed: " + cudaGetErrorString(err));
+  }
+}
+
+// One thread for each block of amplitudes of each column
+__global__ void apply_block_kernel(
+    DeviceComplex* matrix, std::size_t rows, std::uint64_t n_blocks,
+    std::uint64_t n_items) {
+  const std::uint64_t item =
+      std::uint64_t(blockIdx.x) * blockDim.x + threadIdx.x;
+  if (item >= n_items) return;
+  const auto& block =
+      *reinterpret_cast<const FusedBlockData<DeviceComplex>*>(block_bytes);
+  const std::uint64_t col = item / n_blocks;
+  apply_fused_block(block, matrix + col * rows, item % n_blocks);
+}
+
+bool available() {
+  int count = 0;
+  return cudaGetDeviceCount(&count) == cudaSuccess && count > 0;
+}
+
+DeviceMatrix::DeviceMatrix(std::size_t rows, std::size_t cols)
+    : data_(nullptr), rows_(rows), cols_(cols) {
+  check(
+      cudaMalloc(&data_, rows * cols * sizeof(DeviceComplex)), "cudaMalloc");
+}
+
+DeviceMatrix::~DeviceMatrix() { cudaFree(data_); }
+
+void DeviceMatrix::upload(
+    const std::complex<double>* host, std::size_t outer_stride) {
+  check(
+      cudaMemcpy2D(
+          data_, rows_ * sizeof(DeviceComplex), host,
+          outer_stride * sizeof(DeviceComplex), rows_ * sizeof(DeviceComplex),
+          cols_, cudaMemcpyHostToDevice),
+      "Copying the matrix to the device");
+}
+
+void DeviceMatrix::download(
+    std::complex<double>* host, std::size_t outer_stride) const {
+  check(
+      cudaMemcpy2D(
+          host, outer_stride * sizeof(DeviceComplex), data_,
+          rows_ * sizeof(DeviceComplex), rows_ * sizeof(DeviceComplex), cols_,
+          cudaMemcpyDeviceToHost),
+      "Copying the matrix from the device");
+}
+
+void DeviceMatrix::apply_block(
+    const FusedBlockData<std::complex<double>>& block) {
+  // Ordered after any kernel already queued, which may still be reading the
+  // previous block
+  check(
+      cudaMemcpyToSymbol(block_bytes, &block, sizeof(block)),
+      "Copying a block to the device");
+  const std::uint64_t n_blocks = rows_ >> block.n_qubits;
+  const std::uint64_t n_items = n_blocks * cols_;
+  const unsigned grid =
+      (n_items + threads_per_block - 1) / threads_per_block;
+  apply_block_kernel<<<grid, threads_per_block>>>(
+      static_cast<DeviceComplex*>(data_), rows_, n_blocks, n_items);
+  check(cudaGetLastError(), "Launching a block kernel");
+}
+
+}  // namespace device
+}  // namespace internal
+}  // namespace tket_sim
+}  // namespace tket
@@ -0,0 +1,77 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+/**
+ * @file
+ * @brief Host interface to the device used for simulation.
+ *
+ * Only built when tket is configured with TKET_SIM_CUDA; implemented in
+ * DeviceKernels.cu. Kept free of Eigen, so that it can be compiled by the
+ * device compiler.
+ */
+
+#include <complex>
+#include <cstddef>
+
+#include "FusedBlockKernel.hpp"
+
+namespace tket {
+namespace tket_sim {
+namespace internal {
+namespace device {
+
+/** Whether a device is present and usable. */
+bool available();
+
+/** A column-major complex matrix held in device memory.
+ *  CUDA errors are thrown as std::runtime_error.
+ */
+class DeviceMatrix {
+ public:
+  /** Allocate an uninitialised matrix on the device. */
+  DeviceMatrix(std::size_t rows, std::size_t cols);
+
+  ~DeviceMatrix();
+
+  DeviceMatrix(const DeviceMatrix&) = delete;
+  DeviceMatrix& operator=(const DeviceMatrix&) = delete;
+
+  /** Copy a host matrix to the device.
+   *  @param host The first entry of the host matrix, column-major.
+   *  @param outer_stride Distance between the starts of its columns.
+   */
+  void upload(const std::complex<double>* host, std::size_t outer_stride);
+
+  /** Copy the matrix back to the host, waiting for all work queued on it.
+   *  @param host The first entry of the host matrix, column-major.
+   *  @param outer_stride Distance between the starts of its columns.
+   */
+  void download(std::complex<double>* host, std::size_t outer_stride) const;
+
+  /** Queue premultiplication of every column by the block. */
+  void apply_block(const FusedBlockData<std::complex<double>>& block);
+
+ private:
+  void* data_;
+  std::size_t rows_;
+  std::size_t cols_;
+};
+
+}  // namespace device
+}  // namespace internal
+}  // namespace tket_sim
+}  // namespace tket
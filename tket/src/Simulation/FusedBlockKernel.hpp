@@ -0,0 +1,96 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+/**
+ * @file
+ * @brief Application of a fused block of gates to one block of amplitudes.
+ *
+ * This header is compiled both by the host compiler and by the device
+ * compiler (see DeviceKernels.cu), so that the index arithmetic done on the
+ * device is the same as that which can be checked on the host. It must not
+ * include Eigen or any other tket header.
+ */
+
+#include <cstdint>
+
+#if defined(__CUDACC__)
+#define TKET_SIM_HOST_DEVICE __host__ __device__
+#else
+#define TKET_SIM_HOST_DEVICE
+#endif
+
+namespace tket {
+namespace tket_sim {
+namespace internal {
+
+/** Largest number of qubits of a block applied on the device. */
+constexpr unsigned max_device_block_qubits = 5;
+
+constexpr unsigned max_device_block_size = 1u << max_device_block_qubits;
+
+/** A dense unitary on k <= max_device_block_qubits qubits, with the bit
+ *  positions it acts on within the full index of an amplitude.
+ *  C is a complex type with the layout of std::complex<double>.
+ */
+template <class C>
+struct FusedBlockData {
+  /** The number k of qubits. */
+  unsigned n_qubits;
+
+  /** The bit positions of the qubits within an index, in increasing order;
+   *  qubit q of an n-qubit circuit is at position n-1-q (ILO-BE).
+   */
+  unsigned sorted_positions[max_device_block_qubits];
+
+  /** For each local index j < 2^k, the bits of the full index it sets. */
+  std::uint64_t offsets[max_device_block_size];
+
+  /** The unitary, row-major, with row stride 2^k. */
+  C unitary[max_device_block_size * max_device_block_size];
+};
+
+/** Premultiply the amplitudes of one column which share the given values of
+ *  the bits not acted on (packed into block_index) by the block's unitary.
+ *  The 2^(n-k) blocks of a column are disjoint, so they may be processed
+ *  concurrently.
+ */
+template <class C>
+TKET_SIM_HOST_DEVICE inline void apply_fused_block(
+    const FusedBlockData<C>& block, C* column, std::uint64_t block_index) {
+  // Insert a zero bit at each position acted on
+  std::uint64_t base = block_index;
+  for (unsigned r = 0; r < block.n_qubits; ++r) {
+    const unsigned pos = block.sorted_positions[r];
+    const std::uint64_t low = base & ((std::uint64_t(1) << pos) - 1);
+    base = ((base >> pos) << (pos + 1)) | low;
+  }
+  const unsigned size = 1u << block.n_qubits;
+  C input[max_device_block_size];
+  for (unsigned j = 0; j < size; ++j) {
+    input[j] = column[base | block.offsets[j]];
+  }
+  for (unsigned i = 0; i < size; ++i) {
+    C sum = C(0.0);
+    const C* row = block.unitary + i * size;
+    for (unsigned j = 0; j < size; ++j) sum += row[j] * input[j];
+    column[base | block.offsets[i]] = sum;
+  }
+}
+
+}  // namespace internal
+}  // namespace tket_sim
+}  // namespace tket
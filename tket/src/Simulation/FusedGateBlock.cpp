@@ -0,0 +1,86 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "FusedGateBlock.hpp"
+
+#include <algorithm>
+
+#include "Utils/Assert.hpp"
+
+namespace tket {
+namespace tket_sim {
+namespace internal {
+
+FusedGateBlock::FusedGateBlock(unsigned max_qubits, double abs_epsilon)
+    : max_qubits_(max_qubits), abs_epsilon_(abs_epsilon) {}
+
+std::vector<unsigned> FusedGateBlock::new_qubits(const GateNode& node) const {
+  std::vector<unsigned> result;
+  for (unsigned qb : node.qubit_indices) {
+    if (std::find(qubits_.begin(), qubits_.end(), qb) == qubits_.end()) {
+      result.push_back(qb);
+    }
+  }
+  return result;
+}
+
+bool FusedGateBlock::fits(const GateNode& node) const {
+  return qubits_.size() + new_qubits(node).size() <= max_qubits_;
+}
+
+void FusedGateBlock::push(const GateNode& node) {
+  TKET_ASSERT(node.control_indices.empty() && node.paulis.empty());
+  const std::vector<unsigned> added = new_qubits(node);
+  TKET_ASSERT(qubits_.size() + added.size() <= max_qubits_);
+  if (!added.empty()) {
+    // Extend the block to the new qubits, which are appended, so the
+    // existing block acts on the leading qubits of the larger one.
+    const unsigned n_fused = qubits_.size() + added.size();
+    Eigen::MatrixXcd extended = Eigen::MatrixXcd::Identity(
+        get_matrix_size(n_fused), get_matrix_size(n_fused));
+    if (!qubits_.empty()) {
+      GateNode block;
+      block.triplets = tket::get_triplets(unitary_, abs_epsilon_);
+      for (unsigned i = 0; i < qubits_.size(); ++i) {
+        block.qubit_indices.push_back(i);
+      }
+      block.apply_full_unitary(extended, n_fused);
+    }
+    unitary_ = std::move(extended);
+    qubits_.insert(qubits_.end(), added.begin(), added.end());
+  }
+  // Premultiply the block by the gate, relabelled onto the block's qubits.
+  GateNode relabelled;
+  relabelled.triplets = node.triplets;
+  for (unsigned qb : node.qubit_indices) {
+    relabelled.qubit_indices.push_back(
+        std::find(qubits_.begin(), qubits_.end(), qb) - qubits_.begin());
+  }
+  relabelled.apply_full_unitary(unitary_, qubits_.size());
+}
+
+GateNode FusedGateBlock::take() {
+  GateNode block;
+  block.triplets = tket::get_triplets(unitary_, abs_epsilon_);
+  block.qubit_indices = std::move(qubits_);
+  clear();
+  return block;
+}
+
+void FusedGateBlock::clear() { qubits_.clear(); }
+
+}  // namespace internal
+}  // namespace tket_sim
+}  // namespace tket
@@ -0,0 +1,72 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <vector>
+
+#include "GateNode.hpp"
+#include "Utils/MatrixAnalysis.hpp"
+
+namespace tket {
+namespace tket_sim {
+namespace internal {
+
+/** The product of consecutive gates acting on at most a given number of
+ *  qubits between them, as a dense unitary, so that they can be applied to
+ *  the full matrix together in one pass.
+ */
+class FusedGateBlock {
+ public:
+  /** @param max_qubits Largest number of qubits the block may act on.
+   *  @param abs_epsilon Entries of the block with std::abs(z) <= abs_epsilon
+   *      are treated as zero when it is converted back to a GateNode.
+   */
+  FusedGateBlock(unsigned max_qubits, double abs_epsilon);
+
+  bool empty() const { return qubits_.empty(); }
+
+  /** Whether the gate, which must have no controls and no Pauli gadget,
+   *  can be added without the block acting on too many qubits.
+   */
+  bool fits(const GateNode& node) const;
+
+  /** Premultiply the block by the gate, which must fit. */
+  void push(const GateNode& node);
+
+  /** The qubits of the block, in the order of its unitary. */
+  const std::vector<unsigned>& qubits() const { return qubits_; }
+
+  /** The product of the gates pushed, in ILO-BE convention on qubits(). */
+  const Eigen::MatrixXcd& unitary() const { return unitary_; }
+
+  /** The block as a single gate, leaving the block empty. */
+  GateNode take();
+
+  void clear();
+
+ private:
+  const unsigned max_qubits_;
+  const double abs_epsilon_;
+  std::vector<unsigned> qubits_;
+  Eigen::MatrixXcd unitary_;
+
+  // The qubits of the gate not yet in the block
+  std::vector<unsigned> new_qubits(const GateNode& node) const;
+};
+
+}  // namespace internal
+}  // namespace tket_sim
+}  // namespace tket
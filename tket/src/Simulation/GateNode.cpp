@@ -15,7 +15,9 @@
 #include "GateNode.hpp"
 
 #include "BitOperations.hpp"
+#include "PauliRotations.hpp"
 #include "Utils/Assert.hpp"
+#include "Utils/Parallel.hpp"
 
 /*
 The following is intended to be helpful, but there are no guarantees
@@ -128,10 +130,14 @@ M becomes very sparse as n increases since k <= 2 for almost all gates.
 (In the few gates where k > 2, usually U is sparse, so that s << 1.
 e.g., CCX has an 8x8 matrix U, with 8 nonzero entries, so s=1/8).
 
-This sparsity is essential. On an ordinary 2020 laptop,
-for n=8, with 560 gates, the full unitary M is found in <1 second.
-A single statevector for n=16, with 1120 gates, is found in ~3 seconds.
-This is without any really fancy, clever optimisation.
+In fact M need never be built at all. For each fixed choice F of the n-k
+bits NOT in positions [q0, q1, ...], the 2^k strings x with those free bits
+equal to F are mapped among themselves, by exactly U. So we apply M in place:
+for each of the 2^{n-k} choices of F, gather the 2^k entries of each column
+at those positions, multiply by (the sparse) U, and scatter them back.
+This takes O(s.2^{n+k}) operations per column and no extra memory beyond
+O(2^k), and the blocks for different F are independent, so they can be
+processed in parallel.
 
 */
 
@@ -205,74 +211,125 @@ void LiftedBitsResult::set(
 }
 }  // namespace
 
-static void set_lifted_triplets(
-    const std::vector<TripletCd>& triplets, LiftedBitsResult& lifted_bits,
-    std::vector<TripletCd>& lifted_triplets, ExpansionData& expansion_data,
-    const std::vector<unsigned>& qubits, unsigned full_number_of_qubits) {
+// Smallest number of blocks of amplitudes worth handing to another thread.
+static constexpr SimUInt min_blocks_per_thread = SimUInt(1) << 12;
+
+void GateNode::apply_full_unitary(
+    Eigen::Ref<Eigen::MatrixXcd> matr, unsigned full_number_of_qubits) const {
+  if (!paulis.empty()) {
+    TKET_ASSERT(control_indices.empty());
+    apply_pauli_rotations(
+        matr, {PauliRotation(
+                  paulis, qubit_indices, pauli_phase, full_number_of_qubits)});
+    return;
+  }
   // translated_bits[j] gives the bits within the length n binary string,
   // which correspond to the length k binary representation of j,
   // but permuted and moved around so as to fit in the "slots" for qubits
   // [q0, q1, q2,...].
-  // Since U is unitary of size 2^k, no column or row can be all zeros,
-  // so every index j will be needed at least once.
-  // Hence, it is not a waste of time to compute all,
-  // even if U is very sparse.
-  lifted_bits.set(qubits, full_number_of_qubits);
-  lifted_triplets.clear();
-
-  expansion_data = get_expansion_data(
-      lifted_bits.translated_bits_mask, full_number_of_qubits);
-
-  const SimUInt free_bits_limit =
-      get_matrix_size(full_number_of_qubits - qubits.size());
-  if (free_bits_limit == 0) {
-    throw std::runtime_error("Too many bits");
+  LiftedBitsResult lifted_bits;
+  lifted_bits.set(qubit_indices, full_number_of_qubits);
+
+  // The control bits are fixed at 1, so only the blocks in which they are
+  // all set are visited; on all other blocks M is the identity.
+  SimUInt control_mask = 0;
+  for (unsigned qb : control_indices) {
+    TKET_ASSERT(full_number_of_qubits >= qb + 1);
+    control_mask |= SimUInt(1) << (full_number_of_qubits - (qb + 1));
   }
-  for (SimUInt free_bits = 0; free_bits < free_bits_limit; ++free_bits) {
-    const SimUInt expanded_free_bits =
-        get_expanded_bits(expansion_data, free_bits);
-
-    // Now go down the U matrix entries and copy them to the appropriate
-    // positions.
-    for (const auto& triplet : triplets) {
-      lifted_triplets.emplace_back(
-          lifted_bits.translated_bits.at(triplet.row()) | expanded_free_bits,
-          lifted_bits.translated_bits.at(triplet.col()) | expanded_free_bits,
-          triplet.value());
+  TKET_ASSERT((control_mask & lifted_bits.translated_bits_mask) == 0);
+  std::vector<SimUInt> translated_bits = std::move(lifted_bits.translated_bits);
+  for (SimUInt& bits : translated_bits) bits |= control_mask;
+
+  const SimUInt forbidden_mask =
+      lifted_bits.translated_bits_mask | control_mask;
+  const unsigned number_of_free_bits =
+      full_number_of_qubits - qubit_indices.size() - control_indices.size();
+  const ExpansionData expansion_data =
+      get_expansion_data(forbidden_mask, number_of_free_bits);
+
+  // Rather than building the sparse (2^n)*(2^n) matrix M, apply U in place:
+  // each choice of the free bits picks out a block of 2^k amplitudes
+  // (in each column) on which M acts as U.
+  const SimUInt block_size = translated_bits.size();
+  const SimUInt number_of_blocks = get_matrix_size(number_of_free_bits);
+
+  // Apply the gate to a range of columns and a range of blocks within them.
+  const auto apply_to_range = [&](Eigen::Index cols_begin,
+                                  Eigen::Index cols_end, SimUInt blocks_begin,
+                                  SimUInt blocks_end) {
+    std::vector<Complex> input(block_size);
+    std::vector<Complex> output(block_size);
+    for (Eigen::Index col = cols_begin; col < cols_end; ++col) {
+      Complex* const column = matr.col(col).data();
+      // Successive values of the free bits are found by adding 1 with
+      // the carry propagating through the forbidden positions.
+      SimUInt expanded_free_bits =
+          get_expanded_bits(expansion_data, blocks_begin);
+      for (SimUInt free_bits = blocks_begin; free_bits < blocks_end;
+           ++free_bits,
+                   expanded_free_bits =
+                       ((expanded_free_bits | forbidden_mask) + 1) &
+                       ~forbidden_mask) {
+        for (SimUInt jj = 0; jj < block_size; ++jj) {
+          input[jj] = column[translated_bits[jj] | expanded_free_bits];
+          output[jj] = 0.0;
+        }
+        for (const TripletCd& triplet : triplets) {
+          // Written out, to avoid the checks for infinite parts in
+          // std::complex multiplication.
+          const Complex& u = triplet.value();
+          const Complex& z = input[triplet.col()];
+          output[triplet.row()] += Complex(
+              u.real() * z.real() - u.imag() * z.imag(),
+              u.real() * z.imag() + u.imag() * z.real());
+        }
+        for (SimUInt jj = 0; jj < block_size; ++jj) {
+          column[translated_bits[jj] | expanded_free_bits] = output[jj];
+        }
+      }
     }
+  };
+
+  const Eigen::Index cols = matr.cols();
+  if (cols > 1 &&
+      number_of_blocks < min_blocks_per_thread * get_max_threads()) {
+    // Many small columns (e.g. a batch of states, or a full unitary):
+    // partition the columns between threads.
+    const std::size_t min_cols =
+        1 + min_blocks_per_thread / (number_of_blocks * triplets.size() + 1);
+    parallel_for(
+        0, cols, min_cols, [&](std::size_t cols_begin, std::size_t cols_end) {
+          apply_to_range(cols_begin, cols_end, 0, number_of_blocks);
+        });
+  } else {
+    parallel_for(
+        0, number_of_blocks, min_blocks_per_thread,
+        [&](std::size_t blocks_begin, std::size_t blocks_end) {
+          apply_to_range(0, cols, blocks_begin, blocks_end);
+        });
   }
 }
 
-namespace {
-// Contains data potentially of size roughly 2^n or larger,
-// to avoid expensive memeory reallocation.
-struct LargeWorkData {
-  LiftedBitsResult lifted_bits;
-  std::vector<TripletCd> lifted_triplets;
-  SparseMatrixXcd sparse_matrix;
-  ExpansionData expansion_data;
-
-  static LargeWorkData& get_work_data();
-};
-
-LargeWorkData& LargeWorkData::get_work_data() {
-  static LargeWorkData data;
-  return data;
-}
-}  // namespace
-
-void GateNode::apply_full_unitary(
-    Eigen::MatrixXcd& matr, unsigned full_number_of_qubits) const {
-  auto& work_data = LargeWorkData::get_work_data();
-
-  set_lifted_triplets(
-      triplets, work_data.lifted_bits, work_data.lifted_triplets,
-      work_data.expansion_data, qubit_indices, full_number_of_qubits);
-
-  work_data.sparse_matrix =
-      get_sparse_square_matrix(work_data.lifted_triplets, matr.rows());
-
-  matr = work_data.sparse_matrix * matr;
+GateNode GateNode::without_controls() const {
+  GateNode node;
+  node.qubit_indices = control_indices;
+  node.qubit_indices.insert(
+      node.qubit_indices.end(), qubit_indices.begin(), qubit_indices.end());
+  // The targets are the least significant qubits, so U is the bottom
+  // right corner of the larger unitary.
+  const unsigned translation = get_matrix_size(node.qubit_indices.size()) -
+                               get_matrix_size(qubit_indices.size());
+  node.triplets.reserve(translation + triplets.size());
+  for (unsigned ii = 0; ii < translation; ++ii) {
+    node.triplets.emplace_back(ii, ii, 1.0);
+  }
+  for (const TripletCd& triplet : triplets) {
+    node.triplets.emplace_back(
+        triplet.row() + translation, triplet.col() + translation,
+        triplet.value());
+  }
+  return node;
 }
 
 }  // namespace internal
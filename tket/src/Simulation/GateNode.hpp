@@ -15,6 +15,7 @@
 #pragma once
 
 #include "Utils/MatrixAnalysis.hpp"
+#include "Utils/PauliStrings.hpp"
 
 namespace tket {
 namespace tket_sim {
@@ -31,11 +32,50 @@ struct GateNode {
    */
   std::vector<unsigned> qubit_indices;
 
-  /** Lift the triplets to a full unitary matrix U acting on n qubits,
-   *  then premultiply the given matrix by U.
+  /** Further qubits in the original circuit, which must all be 1
+   *  for the gate to act; otherwise it acts as the identity.
+   *  The triplets and qubit_indices then describe only the gate on
+   *  the targets, so controlled gates are applied with work proportional
+   *  to the amplitudes they change.
+   */
+  std::vector<unsigned> control_indices;
+
+  /** If nonempty, the gate is instead the Pauli gadget exp(-i (pi/2) t P),
+   *  where P is the tensor product of these Paulis on qubit_indices and
+   *  t = pauli_phase; triplets is then unused, as the gadget is applied
+   *  analytically (see PauliRotation).
+   */
+  std::vector<Pauli> paulis;
+  double pauli_phase = 0.0;
+
+  /** Premultiply the given matrix by the full unitary matrix U of the gate
+   *  acting on n qubits. U is not constructed: the gate is applied in place
+   *  to each block of 2^k entries it mixes, in parallel when the matrix
+   *  is large.
    */
   void apply_full_unitary(
-      Eigen::MatrixXcd& matr, unsigned full_number_of_qubits) const;
+      Eigen::Ref<Eigen::MatrixXcd> matr, unsigned full_number_of_qubits) const;
+
+  /** The same gate as a node with no control qubits, acting on
+   *  the controls followed by the targets, with the identity on
+   *  all but the last block of its unitary.
+   */
+  GateNode without_controls() const;
+};
+
+/** Receives the gates of a circuit from decompose_circuit, in order. */
+class GateNodeSink {
+ public:
+  virtual ~GateNodeSink() = default;
+
+  /** Apply the next gate. */
+  virtual void push(const GateNode& node) = 0;
+
+  /** Multiply the state by e^{i pi phase}. */
+  virtual void add_global_phase(double phase) = 0;
+
+  /** Called once, after every gate has been pushed. */
+  virtual void flush() = 0;
 };
 
 }  // namespace internal
@@ -49,8 +49,17 @@ namespace internal {
  *  Of course, this would all be simulating the exact same gates, just in a
  *  computationally more efficient way; allowing the gates themselves to be
  *  changed could give yet more speedup possibilities.
+ *
+ *  Currently, consecutive gates are multiplied together into one dense
+ *  unitary for as long as they act on at most 4 qubits between them;
+ *  the combined unitary is applied to the matrix when the next gate
+ *  would take it beyond that, or on flush().
+ *
+ *  Larger Pauli gadgets are never expanded to a matrix: consecutive gadgets
+ *  with their X and Y factors on the same qubits are applied together,
+ *  analytically, in a single pass over the matrix.
  */
-class GateNodesBuffer {
+class GateNodesBuffer : public GateNodeSink {
  public:
   /** The full (2^n)*(2^n) unitaries of the nodes will be calculated,
    *  and left-multiply the matrix.
@@ -63,24 +72,24 @@ class GateNodesBuffer {
    *  @param abs_epsilon Used to convert almost-zero entries to zero entries:
    *      any z with std::abs(z) <= abs_epsilon is treated as zero.
    */
-  GateNodesBuffer(Eigen::MatrixXcd& matrix, double abs_epsilon);
+  GateNodesBuffer(Eigen::Ref<Eigen::MatrixXcd> matrix, double abs_epsilon);
 
-  ~GateNodesBuffer();
+  ~GateNodesBuffer() override;
 
   /** Process and store the next node, possibly with optimisation,
    *  e.g. combining gates etc. Note that this class might not update
    *  the original matrix immediately.
    */
-  void push(const GateNode& node);
+  void push(const GateNode& node) override;
 
-  void add_global_phase(double);
+  void add_global_phase(double) override;
 
   /** The buffer might be cleared and optimised regularly, but the caller
    *  must call this at the end to ensure that any leftover nodes
    *  are also processed; updates the original matrix
    *  passed into the constructor.
    */
-  void flush();
+  void flush() override;
 
  private:
   // Pimpl idiom.
@@ -0,0 +1,394 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "MPSSimulator.hpp"
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <string>
+
+#include "Circuit/Circuit.hpp"
+#include "DecomposeCircuit.hpp"
+#include "GateNode.hpp"
+#include "PauliExpBoxUnitaryCalculator.hpp"
+#include "Utils/Constants.hpp"
+#include "Utils/Exceptions.hpp"
+
+namespace tket {
+namespace tket_sim {
+
+// Largest number of qubits of a gate applied as a dense matrix
+static const unsigned max_gate_qubits = 10;
+
+MPSState::MPSState(
+    unsigned n_qubits, unsigned max_bond_dimension, double cutoff)
+    : max_bond_dimension_(max_bond_dimension),
+      cutoff_(cutoff),
+      sites_(n_qubits),
+      qubit_at_site_(n_qubits),
+      site_of_qubit_(n_qubits),
+      centre_(0),
+      phase_(0.),
+      fidelity_(1.) {
+  if (max_bond_dimension == 0) {
+    throw NotValid("MPS bond dimension must be positive");
+  }
+  for (Site& site : sites_) {
+    site[0] = Eigen::MatrixXcd::Ones(1, 1);
+    site[1] = Eigen::MatrixXcd::Zero(1, 1);
+  }
+  std::iota(qubit_at_site_.begin(), qubit_at_site_.end(), 0);
+  std::iota(site_of_qubit_.begin(), site_of_qubit_.end(), 0);
+}
+
+unsigned MPSState::get_bond_dimension() const {
+  unsigned dim = 1;
+  for (const Site& site : sites_) {
+    dim = std::max(dim, unsigned(site[0].cols()));
+  }
+  return dim;
+}
+
+void MPSState::move_centre(unsigned site) {
+  // QR decompose the centre, keeping Q and passing R on to the neighbour.
+  while (centre_ < site) {
+    Site& a = sites_[centre_];
+    const Eigen::Index dl = a[0].rows(), dr = a[0].cols();
+    Eigen::MatrixXcd m(2 * dl, dr);
+    m << a[0], a[1];
+    Eigen::HouseholderQR<Eigen::MatrixXcd> qr(m);
+    const Eigen::Index r = std::min(2 * dl, dr);
+    const Eigen::MatrixXcd q =
+        qr.householderQ() * Eigen::MatrixXcd::Identity(2 * dl, r);
+    const Eigen::MatrixXcd upper =
+        qr.matrixQR().topRows(r).triangularView<Eigen::Upper>();
+    a[0] = q.topRows(dl);
+    a[1] = q.bottomRows(dl);
+    Site& b = sites_[centre_ + 1];
+    b[0] = upper * b[0];
+    b[1] = upper * b[1];
+    ++centre_;
+  }
+  while (centre_ > site) {
+    Site& a = sites_[centre_];
+    const Eigen::Index dl = a[0].rows(), dr = a[0].cols();
+    Eigen::MatrixXcd m(2 * dr, dl);
+    m << a[0].adjoint(), a[1].adjoint();
+    Eigen::HouseholderQR<Eigen::MatrixXcd> qr(m);
+    const Eigen::Index r = std::min(2 * dr, dl);
+    const Eigen::MatrixXcd q =
+        qr.householderQ() * Eigen::MatrixXcd::Identity(2 * dr, r);
+    const Eigen::MatrixXcd upper =
+        qr.matrixQR().topRows(r).triangularView<Eigen::Upper>();
+    a[0] = q.topRows(dr).adjoint();
+    a[1] = q.bottomRows(dr).adjoint();
+    Site& b = sites_[centre_ - 1];
+    b[0] = b[0] * upper.adjoint();
+    b[1] = b[1] * upper.adjoint();
+    --centre_;
+  }
+}
+
+std::pair<unsigned, double> MPSState::truncation(
+    const Eigen::VectorXd& values) const {
+  const double total = values.squaredNorm();
+  unsigned keep = values.size();
+  double discarded = 0.;
+  while (keep > 1) {
+    const double weight = values(keep - 1) * values(keep - 1);
+    if (keep <= max_bond_dimension_ && discarded + weight > cutoff_ * total) {
+      break;
+    }
+    discarded += weight;
+    --keep;
+  }
+  return {keep, 1. - discarded / total};
+}
+
+void MPSState::apply_to_sites(unsigned first, const Eigen::MatrixXcd& u) {
+  unsigned k = 0;
+  while ((Eigen::Index(1) << k) < u.rows()) ++k;
+  move_centre(first);
+  // Contract the sites, the first being the most significant.
+  std::vector<Eigen::MatrixXcd> theta{sites_[first][0], sites_[first][1]};
+  for (unsigned s = first + 1; s < first + k; ++s) {
+    std::vector<Eigen::MatrixXcd> next;
+    next.reserve(2 * theta.size());
+    for (const Eigen::MatrixXcd& t : theta) {
+      next.push_back(t * sites_[s][0]);
+      next.push_back(t * sites_[s][1]);
+    }
+    theta = std::move(next);
+  }
+  std::vector<Eigen::MatrixXcd> applied(theta.size());
+  for (unsigned row = 0; row < theta.size(); ++row) {
+    applied[row] = Eigen::MatrixXcd::Zero(theta[0].rows(), theta[0].cols());
+    for (unsigned col = 0; col < theta.size(); ++col) {
+      if (u(row, col) != 0.) applied[row] += u(row, col) * theta[col];
+    }
+  }
+  theta = std::move(applied);
+  // Split off the sites again from the left.
+  for (unsigned s = first; s + 1 < first + k; ++s) {
+    const unsigned half = theta.size() / 2;
+    const Eigen::Index dl = theta[0].rows(), dr = theta[0].cols();
+    Eigen::MatrixXcd m(2 * dl, half * dr);
+    for (unsigned b = 0; b < 2; ++b) {
+      for (unsigned rest = 0; rest < half; ++rest) {
+        m.block(b * dl, rest * dr, dl, dr) = theta[b * half + rest];
+      }
+    }
+    Eigen::BDCSVD<Eigen::MatrixXcd> svd(
+        m, Eigen::ComputeThinU | Eigen::ComputeThinV);
+    const Eigen::VectorXd& values = svd.singularValues();
+    const auto [keep, kept] = truncation(values);
+    fidelity_ *= kept;
+    const Eigen::MatrixXcd left = svd.matrixU().leftCols(keep);
+    sites_[s][0] = left.topRows(dl);
+    sites_[s][1] = left.bottomRows(dl);
+    const Eigen::MatrixXcd right =
+        (values.head(keep) / std::sqrt(kept)).asDiagonal() *
+        svd.matrixV().leftCols(keep).adjoint();
+    theta.resize(half);
+    for (unsigned rest = 0; rest < half; ++rest) {
+      theta[rest] = right.middleCols(rest * dr, dr);
+    }
+  }
+  sites_[first + k - 1][0] = std::move(theta[0]);
+  sites_[first + k - 1][1] = std::move(theta[1]);
+  centre_ = first + k - 1;
+}
+
+void MPSState::swap_sites(unsigned first) {
+  static const Eigen::Matrix4cd swap =
+      (Eigen::Matrix4cd() << 1, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 1)
+          .finished();
+  apply_to_sites(first, swap);
+  std::swap(qubit_at_site_[first], qubit_at_site_[first + 1]);
+  site_of_qubit_[qubit_at_site_[first]] = first;
+  site_of_qubit_[qubit_at_site_[first + 1]] = first + 1;
+}
+
+void MPSState::apply_gate(
+    const Eigen::MatrixXcd& u, const std::vector<unsigned>& qubits) {
+  const unsigned k = qubits.size();
+  if (k == 0 || k > max_gate_qubits || u.rows() != (Eigen::Index(1) << k) ||
+      u.cols() != u.rows()) {
+    throw NotValid("MPS gate does not match its qubits");
+  }
+  for (unsigned q : qubits) {
+    if (q >= n_qubits() || std::count(qubits.begin(), qubits.end(), q) != 1) {
+      throw NotValid("MPS gate has invalid qubits");
+    }
+  }
+  if (k == 1) {
+    // A unitary on one site keeps it canonical.
+    Site& a = sites_[site_of_qubit_[qubits[0]]];
+    const Site old = a;
+    a[0] = u(0, 0) * old[0] + u(0, 1) * old[1];
+    a[1] = u(1, 0) * old[0] + u(1, 1) * old[1];
+    return;
+  }
+  // Gather the qubits around the middle one, keeping their order.
+  std::vector<unsigned> order(k);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](unsigned i, unsigned j) {
+    return site_of_qubit_[qubits[i]] < site_of_qubit_[qubits[j]];
+  });
+  const unsigned mid = k / 2;
+  const unsigned anchor = site_of_qubit_[qubits[order[mid]]];
+  for (unsigned j = mid; j-- > 0;) {
+    const unsigned dest = anchor - (mid - j);
+    for (unsigned s = site_of_qubit_[qubits[order[j]]]; s < dest; ++s) {
+      swap_sites(s);
+    }
+  }
+  for (unsigned j = mid + 1; j < k; ++j) {
+    const unsigned dest = anchor + (j - mid);
+    for (unsigned s = site_of_qubit_[qubits[order[j]]]; s > dest; --s) {
+      swap_sites(s - 1);
+    }
+  }
+  // Reorder the gate to act on the qubits in the order of their sites.
+  std::vector<unsigned> reindex(u.rows());
+  for (unsigned x = 0; x < u.rows(); ++x) {
+    unsigned y = 0;
+    for (unsigned j = 0; j < k; ++j) {
+      if (x & (1u << (k - 1 - j))) y |= 1u << (k - 1 - order[j]);
+    }
+    reindex[x] = y;
+  }
+  Eigen::MatrixXcd v(u.rows(), u.cols());
+  for (unsigned row = 0; row < u.rows(); ++row) {
+    for (unsigned col = 0; col < u.cols(); ++col) {
+      v(row, col) = u(reindex[row], reindex[col]);
+    }
+  }
+  apply_to_sites(anchor - mid, v);
+}
+
+void MPSState::permute_qubits(const std::vector<unsigned>& perm) {
+  if (perm.size() != n_qubits()) {
+    throw NotValid("MPS qubit permutation has the wrong size");
+  }
+  std::vector<unsigned> qubit_at_site(n_qubits());
+  std::vector<bool> seen(n_qubits(), false);
+  for (unsigned s = 0; s < n_qubits(); ++s) {
+    const unsigned q = perm.at(qubit_at_site_[s]);
+    if (q >= n_qubits() || seen[q]) {
+      throw NotValid("MPS qubit permutation is not a permutation");
+    }
+    seen[q] = true;
+    qubit_at_site[s] = q;
+  }
+  qubit_at_site_ = std::move(qubit_at_site);
+  for (unsigned s = 0; s < n_qubits(); ++s) {
+    site_of_qubit_[qubit_at_site_[s]] = s;
+  }
+}
+
+Complex MPSState::get_amplitude(const std::vector<bool>& bits) const {
+  if (bits.size() != n_qubits()) {
+    throw NotValid("Wrong number of bits for MPS amplitude");
+  }
+  Eigen::RowVectorXcd row = Eigen::RowVectorXcd::Ones(1);
+  for (unsigned s = 0; s < n_qubits(); ++s) {
+    row = row * sites_[s][bits[qubit_at_site_[s]]];
+  }
+  return std::polar(1., PI * phase_) * row(0);
+}
+
+double MPSState::get_expectation(const std::vector<Pauli>& paulis) const {
+  if (paulis.size() != n_qubits()) {
+    throw NotValid("Wrong number of Paulis for MPS expectation");
+  }
+  // Contract <psi|P|psi> along the chain.
+  Eigen::MatrixXcd env = Eigen::MatrixXcd::Ones(1, 1);
+  for (unsigned s = 0; s < n_qubits(); ++s) {
+    const Site& a = sites_[s];
+    switch (paulis[qubit_at_site_[s]]) {
+      case Pauli::I:
+        env = a[0].adjoint() * env * a[0] + a[1].adjoint() * env * a[1];
+        break;
+      case Pauli::X:
+        env = a[0].adjoint() * env * a[1] + a[1].adjoint() * env * a[0];
+        break;
+      case Pauli::Y:
+        env = -i_ * a[0].adjoint() * env * a[1] +
+              i_ * a[1].adjoint() * env * a[0];
+        break;
+      case Pauli::Z:
+        env = a[0].adjoint() * env * a[0] - a[1].adjoint() * env * a[1];
+        break;
+    }
+  }
+  return env(0, 0).real();
+}
+
+StateVector MPSState::get_statevector(unsigned max_number_of_qubits) const {
+  if (n_qubits() > max_number_of_qubits) {
+    throw NotValid("MPS has too many qubits for a statevector");
+  }
+  // Partial products for each assignment of the sites so far, the first
+  // site being the most significant.
+  std::vector<Eigen::RowVectorXcd> rows{Eigen::RowVectorXcd::Ones(1)};
+  for (const Site& site : sites_) {
+    std::vector<Eigen::RowVectorXcd> next;
+    next.reserve(2 * rows.size());
+    for (const Eigen::RowVectorXcd& row : rows) {
+      next.push_back(row * site[0]);
+      next.push_back(row * site[1]);
+    }
+    rows = std::move(next);
+  }
+  const unsigned n = n_qubits();
+  const Complex factor = std::polar(1., PI * phase_);
+  StateVector sv(rows.size());
+  for (unsigned x = 0; x < rows.size(); ++x) {
+    unsigned y = 0;
+    for (unsigned s = 0; s < n; ++s) {
+      if (x & (1u << (n - 1 - s))) y |= 1u << (n - 1 - qubit_at_site_[s]);
+    }
+    sv(y) = factor * rows[x](0);
+  }
+  return sv;
+}
+
+namespace {
+
+// Applies the gates of a circuit to an MPS as dense matrices
+class MPSGateSink : public internal::GateNodeSink {
+ public:
+  explicit MPSGateSink(MPSState& state) : state_(state) {}
+
+  void push(const internal::GateNode& node) override {
+    if (!node.paulis.empty()) {
+      internal::GateNode dense;
+      dense.triplets = internal::get_triplets(node.paulis, node.pauli_phase);
+      dense.qubit_indices = node.qubit_indices;
+      apply(dense);
+    } else if (!node.control_indices.empty()) {
+      apply(node.without_controls());
+    } else {
+      apply(node);
+    }
+  }
+
+  void add_global_phase(double phase) override {
+    state_.add_global_phase(phase);
+  }
+
+  void flush() override {}
+
+ private:
+  void apply(const internal::GateNode& node) {
+    const unsigned k = node.qubit_indices.size();
+    if (k > max_gate_qubits) {
+      throw NotImplemented(
+          "Gate on " + std::to_string(k) + " qubits is too large for MPS");
+    }
+    Eigen::MatrixXcd u = Eigen::MatrixXcd::Zero(1u << k, 1u << k);
+    for (const TripletCd& triplet : node.triplets) {
+      u(triplet.row(), triplet.col()) += triplet.value();
+    }
+    state_.apply_gate(u, node.qubit_indices);
+  }
+
+  MPSState& state_;
+};
+
+}  // namespace
+
+MPSState get_mps(
+    const Circuit& circ, unsigned max_bond_dimension, double cutoff,
+    double abs_epsilon) {
+  MPSState state(circ.n_qubits(), max_bond_dimension, cutoff);
+  MPSGateSink sink(state);
+  internal::decompose_circuit(circ, sink, abs_epsilon);
+  // The wire from each input qubit ends at an output qubit.
+  const qubit_vector_t qubits = circ.all_qubits();
+  std::map<Qubit, unsigned> index;
+  for (const Qubit& qb : qubits) index.insert({qb, unsigned(index.size())});
+  std::vector<unsigned> perm(qubits.size());
+  for (const std::pair<const Qubit, Qubit>& pair :
+       circ.implicit_qubit_permutation()) {
+    perm[index.at(pair.first)] = index.at(pair.second);
+  }
+  state.permute_qubits(perm);
+  return state;
+}
+
+}  // namespace tket_sim
+}  // namespace tket
@@ -0,0 +1,161 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "Simulation/CircuitSimulator.hpp"
+#include "Utils/PauliStrings.hpp"
+
+namespace tket {
+class Circuit;
+
+namespace tket_sim {
+
+/** A pure state of n qubits as a matrix product state (MPS).
+ *
+ *  Each qubit is one site of a chain, holding a pair of matrices, one for
+ *  each value of the qubit; an amplitude is the product of the matrices
+ *  along the chain. The size of the matrices between two sites, the bond
+ *  dimension, grows with the entanglement across that cut, so states of
+ *  many qubits with little entanglement, such as the output of shallow
+ *  circuits, are stored and simulated cheaply.
+ *
+ *  The chain is kept in mixed canonical form. A gate on several qubits is
+ *  applied by first moving its qubits next to each other with SWAPs (the
+ *  order of the qubits along the chain is tracked, so they are not moved
+ *  back), then contracting their sites, applying the gate and splitting
+ *  the result again with singular value decompositions. When splitting,
+ *  singular values are discarded while their total squared weight is at
+ *  most the cutoff, and beyond the maximum bond dimension; the state is
+ *  then renormalised, and the product of the kept weights recorded as
+ *  the truncation fidelity.
+ *
+ *  Qubits are numbered as in the circuit, i.e. in the order of
+ *  Circuit::all_qubits(), with qubit 0 the most significant in ILO-BE
+ *  convention.
+ */
+class MPSState {
+ public:
+  /** The state |00...0>.
+   *  @param n_qubits Number of qubits.
+   *  @param max_bond_dimension Largest bond dimension to keep.
+   *  @param cutoff Largest total squared weight of the singular values
+   *              discarded at each split, relative to the norm.
+   *  @throw NotValid if max_bond_dimension is zero.
+   */
+  explicit MPSState(
+      unsigned n_qubits, unsigned max_bond_dimension = 256,
+      double cutoff = 1e-16);
+
+  unsigned n_qubits() const { return sites_.size(); }
+
+  /** Largest bond dimension currently between any two sites. */
+  unsigned get_bond_dimension() const;
+
+  /** Product over all splits so far of the fraction of the squared norm
+   *  kept; 1 if nothing has been truncated. The squared overlap of the
+   *  state with the exact one is about this value.
+   */
+  double get_truncation_fidelity() const { return fidelity_; }
+
+  /** Apply a unitary gate.
+   *  @param u Unitary of size 2^k, in ILO-BE convention.
+   *  @param qubits The k distinct qubits it acts upon, in order.
+   *  @throw NotValid if the sizes do not match or a qubit is out of range.
+   */
+  void apply_gate(
+      const Eigen::MatrixXcd& u, const std::vector<unsigned>& qubits);
+
+  /** Multiply the state by e^{i pi phase}. */
+  void add_global_phase(double phase) { phase_ += phase; }
+
+  /** Relabel the qubits: the state of qubit q becomes that of perm[q].
+   *  @throw NotValid if perm is not a permutation of the qubits.
+   */
+  void permute_qubits(const std::vector<unsigned>& perm);
+
+  /** The amplitude of a computational basis state.
+   *  @param bits The value of each qubit.
+   *  @throw NotValid if the number of bits is wrong.
+   */
+  Complex get_amplitude(const std::vector<bool>& bits) const;
+
+  /** The expectation value of a tensor product of Paulis.
+   *  @param paulis The Pauli on each qubit.
+   *  @throw NotValid if the number of Paulis is wrong.
+   */
+  double get_expectation(const std::vector<Pauli>& paulis) const;
+
+  /** The dense statevector, in ILO-BE convention.
+   *  @param max_number_of_qubits Throw an exception if this limit is
+   *              exceeded.
+   */
+  StateVector get_statevector(unsigned max_number_of_qubits = 11) const;
+
+ private:
+  /** The matrix of each value of a qubit, of size D_left * D_right. */
+  typedef std::array<Eigen::MatrixXcd, 2> Site;
+
+  /** Move the orthogonality centre to the given site. */
+  void move_centre(unsigned site);
+
+  /** Apply a unitary to consecutive sites, starting at first, with the
+   *  first site the most significant; the centre ends at the last site.
+   */
+  void apply_to_sites(unsigned first, const Eigen::MatrixXcd& u);
+
+  /** Swap the qubits on two neighbouring sites. */
+  void swap_sites(unsigned first);
+
+  /** The number of the singular values to keep, and the fraction of the
+   *  squared norm they hold.
+   */
+  std::pair<unsigned, double> truncation(const Eigen::VectorXd& values) const;
+
+  unsigned max_bond_dimension_;
+  double cutoff_;
+  std::vector<Site> sites_;
+  /** The qubit on each site, and the site of each qubit */
+  std::vector<unsigned> qubit_at_site_;
+  std::vector<unsigned> site_of_qubit_;
+  /** Sites left of the centre are left-, those right of it right-canonical */
+  unsigned centre_;
+  double phase_;
+  double fidelity_;
+};
+
+/** Simulate a circuit applied to the state |00...0> as a matrix product
+ *  state, for circuits with too many qubits for get_statevector but
+ *  little entanglement between them. The gates are taken from the circuit
+ *  exactly as for get_statevector, and the implicit qubit permutation is
+ *  applied.
+ *  (Note: if any OpType::Measure or OpType::Barrier occur,
+ *  they are simply ignored - the same as a noop).
+ *  @throw NotImplemented if any unimplemented gate occurs, or a gate acts
+ *              on more qubits (controls included) than can be applied
+ *              as a dense matrix.
+ *  @param circ The circuit to simulate.
+ *  @param max_bond_dimension As for MPSState.
+ *  @param cutoff As for MPSState.
+ *  @param abs_epsilon As for get_statevector.
+ */
+MPSState get_mps(
+    const Circuit& circ, unsigned max_bond_dimension = 256,
+    double cutoff = 1e-16, double abs_epsilon = EPS);
+
+}  // namespace tket_sim
+}  // namespace tket
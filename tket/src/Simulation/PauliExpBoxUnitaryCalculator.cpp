@@ -109,7 +109,8 @@ struct PauliExpBoxUnitaryCalculator {
 };
 
 PauliExpBoxUnitaryCalculator& PauliExpBoxUnitaryCalculator::get() {
-  static PauliExpBoxUnitaryCalculator calculator;
+  // Work data, so one per thread.
+  static thread_local PauliExpBoxUnitaryCalculator calculator;
   return calculator;
 }
 
@@ -214,13 +215,17 @@ std::vector<TripletCd> get_triplets(const PauliExpBox& box) {
         "PauliExpBoxUnitaryCalculator called "
         "with symbolic phase parameter");
   }
-  const auto pauli_string = box.get_paulis();
+  return get_triplets(box.get_paulis(), phase_optional.value());
+}
+
+std::vector<TripletCd> get_triplets(
+    const std::vector<Pauli>& paulis, double phase) {
   auto& calculator = PauliExpBoxUnitaryCalculator::get();
   calculator.clear();
-  for (auto pauli : pauli_string) {
+  for (auto pauli : paulis) {
     calculator.append(pauli);
   }
-  calculator.fill_triplets(phase_optional.value());
+  calculator.fill_triplets(phase);
   return calculator.triplets;
 }
 
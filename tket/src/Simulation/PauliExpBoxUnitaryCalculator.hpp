@@ -15,6 +15,7 @@
 #pragma once
 
 #include "Utils/MatrixAnalysis.hpp"
+#include "Utils/PauliStrings.hpp"
 
 namespace tket {
 class PauliExpBox;
@@ -26,6 +27,13 @@ namespace internal {
  */
 std::vector<TripletCd> get_triplets(const PauliExpBox& box);
 
+/** Returns the triplets of the sparse unitary matrix of
+ *  exp(-i (pi/2) t P), where P is the tensor product of the Paulis
+ *  and t is the phase, in ILO-BE convention.
+ */
+std::vector<TripletCd> get_triplets(
+    const std::vector<Pauli>& paulis, double phase);
+
 }  // namespace internal
 }  // namespace tket_sim
 }  // namespace tket
@@ -0,0 +1,192 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PauliRotations.hpp"
+
+#include <bit>
+#include <cmath>
+#include <functional>
+
+#include "Utils/Assert.hpp"
+#include "Utils/Parallel.hpp"
+
+namespace tket {
+namespace tket_sim {
+namespace internal {
+
+PauliRotation::PauliRotation(
+    const std::vector<Pauli>& paulis,
+    const std::vector<unsigned>& qubit_indices, double phase,
+    unsigned full_number_of_qubits)
+    : x_mask(0), z_mask(0), y_count(0), phase(phase) {
+  TKET_ASSERT(paulis.size() == qubit_indices.size());
+  TKET_ASSERT(full_number_of_qubits < 32);
+  for (unsigned ii = 0; ii < paulis.size(); ++ii) {
+    TKET_ASSERT(full_number_of_qubits >= qubit_indices[ii] + 1);
+    const SimUInt bit = SimUInt(1)
+                        << (full_number_of_qubits - (qubit_indices[ii] + 1));
+    switch (paulis[ii]) {
+      case Pauli::I:
+        break;
+      case Pauli::X:
+        x_mask |= bit;
+        break;
+      case Pauli::Y:
+        x_mask |= bit;
+        z_mask |= bit;
+        ++y_count;
+        break;
+      case Pauli::Z:
+        z_mask |= bit;
+        break;
+    }
+  }
+}
+
+namespace {
+// exp(-i (pi/2) t P) = cc.I + coeff.(+/-1 permutation matrix), where the
+// factors of i from the Y are taken into coeff.
+struct RotationCoefficients {
+  double cc;
+  Complex coeff;
+  SimUInt z_mask;
+};
+}  // namespace
+
+static std::vector<RotationCoefficients> get_coefficients(
+    const std::vector<PauliRotation>& rotations) {
+  std::vector<RotationCoefficients> result;
+  result.reserve(rotations.size());
+  for (const PauliRotation& rotation : rotations) {
+    const double angle = -0.5 * PI * rotation.phase;
+    const double ss = std::sin(angle);
+    // i^(y+1).sin(angle), with the power of i taken exactly.
+    Complex coeff;
+    switch ((rotation.y_count + 1) % 4) {
+      case 0:
+        coeff = Complex(ss, 0.0);
+        break;
+      case 1:
+        coeff = Complex(0.0, ss);
+        break;
+      case 2:
+        coeff = Complex(-ss, 0.0);
+        break;
+      default:
+        coeff = Complex(0.0, -ss);
+    }
+    result.push_back({std::cos(angle), coeff, rotation.z_mask});
+  }
+  return result;
+}
+
+// Written out, to avoid the checks for infinite parts in
+// std::complex multiplication.
+static Complex multiply(const Complex& u, const Complex& z) {
+  return Complex(
+      u.real() * z.real() - u.imag() * z.imag(),
+      u.real() * z.imag() + u.imag() * z.real());
+}
+
+// (-1)^popcount(bits), as +coeff or -coeff.
+static Complex signed_coefficient(const Complex& coeff, SimUInt bits) {
+  return (std::popcount(bits) & 1) ? -coeff : coeff;
+}
+
+// Smallest number of rows (or pairs of rows) worth handing to another thread.
+static constexpr SimUInt min_rows_per_thread = SimUInt(1) << 12;
+
+void apply_pauli_rotations(
+    Eigen::Ref<Eigen::MatrixXcd> matr,
+    const std::vector<PauliRotation>& rotations) {
+  if (rotations.empty()) return;
+  const SimUInt x_mask = rotations[0].x_mask;
+  for (const PauliRotation& rotation : rotations) {
+    TKET_ASSERT(rotation.x_mask == x_mask);
+  }
+  const std::vector<RotationCoefficients> coefficients =
+      get_coefficients(rotations);
+  const SimUInt rows = matr.rows();
+  TKET_ASSERT(x_mask < rows);
+
+  std::function<void(Eigen::Index, Eigen::Index, SimUInt, SimUInt)>
+      apply_to_range;
+  SimUInt number_of_units;
+  if (x_mask == 0) {
+    // A product of diagonal gadgets: scale each row.
+    number_of_units = rows;
+    apply_to_range = [&](Eigen::Index cols_begin, Eigen::Index cols_end,
+                         SimUInt rows_begin, SimUInt rows_end) {
+      for (SimUInt row = rows_begin; row < rows_end; ++row) {
+        Complex factor = 1.0;
+        for (const RotationCoefficients& rc : coefficients) {
+          factor = multiply(
+              factor, rc.cc + signed_coefficient(rc.coeff, rc.z_mask & row));
+        }
+        for (Eigen::Index col = cols_begin; col < cols_end; ++col) {
+          matr(row, col) = multiply(factor, matr(row, col));
+        }
+      }
+    };
+  } else {
+    // Visit each pair (r, r^x) once, as the r with the highest bit of
+    // x_mask clear; the pairs are numbered by deleting that bit from r.
+    number_of_units = rows / 2;
+    const SimUInt low_mask = std::bit_floor(x_mask) - 1;
+    apply_to_range = [&, low_mask](
+                         Eigen::Index cols_begin, Eigen::Index cols_end,
+                         SimUInt pairs_begin, SimUInt pairs_end) {
+      for (Eigen::Index col = cols_begin; col < cols_end; ++col) {
+        Complex* const column = matr.col(col).data();
+        for (SimUInt pair = pairs_begin; pair < pairs_end; ++pair) {
+          const SimUInt row1 = ((pair & ~low_mask) << 1) | (pair & low_mask);
+          const SimUInt row2 = row1 ^ x_mask;
+          Complex amp1 = column[row1];
+          Complex amp2 = column[row2];
+          for (const RotationCoefficients& rc : coefficients) {
+            const Complex new_amp1 =
+                rc.cc * amp1 +
+                multiply(signed_coefficient(rc.coeff, rc.z_mask & row2), amp2);
+            amp2 =
+                rc.cc * amp2 +
+                multiply(signed_coefficient(rc.coeff, rc.z_mask & row1), amp1);
+            amp1 = new_amp1;
+          }
+          column[row1] = amp1;
+          column[row2] = amp2;
+        }
+      }
+    };
+  }
+
+  const Eigen::Index cols = matr.cols();
+  if (cols > 1 && number_of_units < min_rows_per_thread * get_max_threads()) {
+    const std::size_t min_cols =
+        1 + min_rows_per_thread / (number_of_units * coefficients.size() + 1);
+    parallel_for(
+        0, cols, min_cols, [&](std::size_t cols_begin, std::size_t cols_end) {
+          apply_to_range(cols_begin, cols_end, 0, number_of_units);
+        });
+  } else {
+    parallel_for(
+        0, number_of_units, min_rows_per_thread,
+        [&](std::size_t begin, std::size_t end) {
+          apply_to_range(0, cols, begin, end);
+        });
+  }
+}
+
+}  // namespace internal
+}  // namespace tket_sim
+}  // namespace tket
@@ -0,0 +1,67 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <vector>
+
+#include "BitOperations.hpp"
+#include "Utils/MatrixAnalysis.hpp"
+#include "Utils/PauliStrings.hpp"
+
+namespace tket {
+namespace tket_sim {
+namespace internal {
+
+/** The Pauli gadget exp(-i (pi/2) t P), for a Pauli string P and real
+ *  phase t (in half-turns), stored as bit masks over the length n binary
+ *  strings which index the rows of the unitary, in ILO-BE convention.
+ *
+ *  Writing P = i^y X^x Z^z, where x has a 1 for every X or Y factor,
+ *  z for every Z or Y factor, and y is the number of Y factors,
+ *  the amplitudes of P|psi> are
+ *
+ *    (P psi)[r] = i^y (-1)^popcount(z & (r^x)) psi[r^x],
+ *
+ *  and since P^2 = I, the gadget is cos(pi t/2) I - i sin(pi t/2) P.
+ *  So it can be applied with one pass over the amplitudes, pairing each
+ *  row r with r^x, without any matrix being built.
+ */
+struct PauliRotation {
+  SimUInt x_mask;
+  SimUInt z_mask;
+  unsigned y_count;
+  double phase;
+
+  /** The gadget with the given Paulis acting on the given qubits of the
+   *  full circuit.
+   */
+  PauliRotation(
+      const std::vector<Pauli>& paulis,
+      const std::vector<unsigned>& qubit_indices, double phase,
+      unsigned full_number_of_qubits);
+};
+
+/** Premultiply the given matrix by the gadgets, in order (the first is
+ *  applied first). All gadgets must flip the same bits, i.e. have the same
+ *  x_mask; then each pair of rows (r, r^x) is read and written only once,
+ *  however many gadgets there are.
+ */
+void apply_pauli_rotations(
+    Eigen::Ref<Eigen::MatrixXcd> matr,
+    const std::vector<PauliRotation>& rotations);
+
+}  // namespace internal
+}  // namespace tket_sim
+}  // namespace tket
@@ -0,0 +1,171 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "StabiliserSimulator.hpp"
+
+#include <bit>
+#include <cmath>
+#include <optional>
+#include <random>
+
+#include "Circuit/Circuit.hpp"
+#include "Clifford/CliffTableau.hpp"
+#include "OpType/OpTypeFunctions.hpp"
+#include "Utils/Exceptions.hpp"
+
+namespace tket {
+namespace tket_sim {
+
+/** The inverse of a supported Clifford gate, or noop if it is ignored,
+ *  or nullopt if it is not supported. */
+static std::optional<OpType> inverse_clifford_type(OpType type) {
+  switch (type) {
+    case OpType::S:
+      return OpType::Sdg;
+    case OpType::Sdg:
+      return OpType::S;
+    case OpType::V:
+      return OpType::Vdg;
+    case OpType::Vdg:
+      return OpType::V;
+    case OpType::Z:
+    case OpType::X:
+    case OpType::Y:
+    case OpType::H:
+    case OpType::CX:
+    case OpType::CY:
+    case OpType::CZ:
+    case OpType::SWAP:
+    case OpType::BRIDGE:
+      return type;
+    case OpType::noop:
+    case OpType::Barrier:
+    case OpType::Measure:
+      return OpType::noop;
+    default:
+      return std::nullopt;
+  }
+}
+
+bool is_stabiliser_circuit(const Circuit& circ) {
+  BGL_FORALL_VERTICES(v, circ.dag, DAG) {
+    const OpType type = circ.get_OpType_from_Vertex(v);
+    if (is_boundary_q_type(type) || is_boundary_c_type(type)) continue;
+    if (!inverse_clifford_type(type)) return false;
+  }
+  return true;
+}
+
+std::vector<QubitPauliTensor> get_stabilisers(const Circuit& circ) {
+  // Build the tableau of U^dagger, whose Z rows are then the images
+  // U Z_q U^dagger of the input stabilisers.
+  // U^dagger = G_1^dagger ... G_n^dagger applies the inverse gates in
+  // reverse order, so each one goes in front of those before it.
+  const qubit_vector_t qubits = circ.all_qubits();
+  CliffTableau tab(qubits);
+  for (const Command& com : circ) {
+    const OpType type = com.get_op_ptr()->get_type();
+    const std::optional<OpType> inverse = inverse_clifford_type(type);
+    if (!inverse) {
+      throw NotValid(
+          "Cannot simulate " + com.to_str() + " with a stabiliser tableau");
+    }
+    if (*inverse == OpType::noop) continue;
+    qubit_vector_t args;
+    for (const UnitID& u : com.get_args()) args.push_back(Qubit(u));
+    tab.apply_gate_at_front(*inverse, args);
+  }
+
+  // Wires are labelled by their input qubit; relabel them by their output.
+  const qubit_map_t perm = circ.implicit_qubit_permutation();
+  std::map<Qubit, QubitPauliTensor> by_output;
+  for (const Qubit& q : qubits) {
+    const QubitPauliTensor s = tab.get_zpauli(q);
+    QubitPauliTensor relabelled(s.coeff);
+    for (const std::pair<const Qubit, Pauli>& p : s.string.map) {
+      relabelled.string.map.insert({perm.at(p.first), p.second});
+    }
+    by_output.insert({perm.at(q), relabelled});
+  }
+  std::vector<QubitPauliTensor> stabilisers;
+  stabilisers.reserve(qubits.size());
+  for (const Qubit& q : qubits) stabilisers.push_back(by_output.at(q));
+  return stabilisers;
+}
+
+/** Replace v with Pv for a Pauli tensor P */
+static void apply_pauli(
+    const QubitPauliTensor& pauli, const std::map<Qubit, unsigned>& bit_of,
+    const StateVector& v, StateVector& result) {
+  // With the first qubit as the most significant bit, P|j> is
+  // coeff * i^(#Y) * (-1)^popcount(j & zmask) |j ^ xmask>.
+  const unsigned n = bit_of.size();
+  std::size_t xmask = 0;
+  std::size_t zmask = 0;
+  unsigned n_y = 0;
+  for (const std::pair<const Qubit, Pauli>& p : pauli.string.map) {
+    const std::size_t bit = std::size_t{1} << (n - 1 - bit_of.at(p.first));
+    if (p.second == Pauli::X || p.second == Pauli::Y) xmask |= bit;
+    if (p.second == Pauli::Z || p.second == Pauli::Y) zmask |= bit;
+    if (p.second == Pauli::Y) ++n_y;
+  }
+  static const Complex i_powers[4] = {1., i_, -1., -i_};
+  const Complex c = pauli.coeff * i_powers[n_y % 4];
+  for (std::size_t j = 0; j < std::size_t(v.size()); ++j) {
+    const bool odd = std::popcount(j & zmask) & 1;
+    result(j ^ xmask) = odd ? -c * v(j) : c * v(j);
+  }
+}
+
+StateVector get_statevector_from_stabilisers(
+    const std::vector<QubitPauliTensor>& stabilisers,
+    const qubit_vector_t& qubits, unsigned max_number_of_qubits) {
+  if (qubits.size() > max_number_of_qubits) {
+    throw NotValid("State to densify has too many qubits");
+  }
+  std::map<Qubit, unsigned> bit_of;
+  for (unsigned i = 0; i < qubits.size(); ++i) bit_of.insert({qubits[i], i});
+
+  // Project a fixed generic vector onto the common +1 eigenspace, applying
+  // (1 + S)/2 for each generator S, which is one-dimensional if they are
+  // independent. A fixed seed keeps the result (and its phase) repeatable.
+  const std::size_t size = std::size_t{1} << qubits.size();
+  std::mt19937 rng(0x5eed);
+  std::normal_distribution<double> dist;
+  StateVector v(size);
+  for (std::size_t j = 0; j < size; ++j) v(j) = Complex(dist(rng), dist(rng));
+  v.normalize();
+  StateVector sv(size);
+  for (const QubitPauliTensor& s : stabilisers) {
+    apply_pauli(s, bit_of, v, sv);
+    v = 0.5 * (v + sv);
+  }
+  const double norm = v.norm();
+  if (norm < EPS) {
+    throw NotValid("Stabilisers do not have a common +1 eigenstate");
+  }
+  return v / norm;
+}
+
+StateVector get_statevector_up_to_phase(
+    const Circuit& circ, double abs_epsilon, unsigned max_number_of_qubits) {
+  if (!is_stabiliser_circuit(circ)) {
+    return get_statevector(circ, abs_epsilon, max_number_of_qubits);
+  }
+  return get_statevector_from_stabilisers(
+      get_stabilisers(circ), circ.all_qubits(), max_number_of_qubits);
+}
+
+}  // namespace tket_sim
+}  // namespace tket
@@ -0,0 +1,74 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <vector>
+
+#include "Simulation/CircuitSimulator.hpp"
+#include "Utils/PauliStrings.hpp"
+
+namespace tket {
+class Circuit;
+
+namespace tket_sim {
+
+/** Whether every operation in the circuit can be simulated by
+ *  get_stabilisers: Clifford gates (Z, X, Y, S, Sdg, V, Vdg, H, CX, CY, CZ,
+ *  SWAP, BRIDGE), noop, Barrier and Measure (the last two are ignored).
+ *  @param circ The circuit to test.
+ */
+bool is_stabiliser_circuit(const Circuit& circ);
+
+/** Calculate a set of stabiliser generators of the state produced by
+ *  applying a Clifford circuit to |00...0>.
+ *  The state is tracked as a stabiliser tableau, so the cost is polynomial
+ *  in the number of qubits and there is no limit on the circuit size.
+ *  The implicit qubit permutation is applied; the global phase of the
+ *  state is not determined.
+ *  (Note: if any OpType::Measure or OpType::Barrier occur,
+ *  they are simply ignored - the same as a noop).
+ *  @throw NotValid if the circuit contains a non-Clifford operation.
+ *  @param circ The circuit to simulate.
+ *  @return One generator S_q = U Z_q U^dagger for each qubit q, where U is
+ *              the unitary of the circuit, in the order of circ.all_qubits().
+ */
+std::vector<QubitPauliTensor> get_stabilisers(const Circuit& circ);
+
+/** Calculate the dense statevector, using ILO-BE convention, of the state
+ *  stabilised by a full set of independent commuting generators.
+ *  The result is normalised, and correct up to global phase.
+ *  @throw NotValid if the generators do not stabilise a common state.
+ *  @param stabilisers The stabiliser generators, e.g. from get_stabilisers.
+ *  @param qubits The qubits of the state, in ILO-BE order.
+ *  @param max_number_of_qubits Throw an exception if this limit is exceeded.
+ */
+StateVector get_statevector_from_stabilisers(
+    const std::vector<QubitPauliTensor>& stabilisers,
+    const qubit_vector_t& qubits, unsigned max_number_of_qubits = 11);
+
+/** Calculate the statevector of the circuit applied to the state
+ *  |00...0>, using ILO-BE convention, taking the stabiliser path for
+ *  Clifford circuits and falling back to get_statevector for all others.
+ *  For a Clifford circuit the result is only correct up to global phase.
+ *  @param circ The circuit to simulate.
+ *  @param abs_epsilon As for get_statevector.
+ *  @param max_number_of_qubits Throw an exception if this limit is exceeded.
+ */
+StateVector get_statevector_up_to_phase(
+    const Circuit& circ, double abs_epsilon = EPS,
+    unsigned max_number_of_qubits = 11);
+
+}  // namespace tket_sim
+}  // namespace tket
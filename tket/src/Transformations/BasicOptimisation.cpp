@@ -12,178 +12,59 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <list>
+#include <memory>
 #include <optional>
+#include <unordered_map>
+#include <vector>
 
+#include "Characterisation/ErrorTables.hpp"
 #include "Circuit/CircPool.hpp"
 #include "Circuit/CircUtils.hpp"
 #include "Circuit/Command.hpp"
 #include "Circuit/DAGDefs.hpp"
+#include "Circuit/UnitPaths.hpp"
+#include "Gate/Commutation.hpp"
 #include "Gate/Gate.hpp"
 #include "Gate/GatePtr.hpp"
 #include "Gate/Rotation.hpp"
+#include "Peephole.hpp"
 #include "Transform.hpp"
 #include "Utils/Assert.hpp"
 #include "Utils/EigenConfig.hpp"
 
 namespace tket {
 
-static bool redundancy_removal(Circuit &circ);
-static bool remove_redundancy(
-    Circuit &circ, const Vertex &vert, VertexList &bin,
-    std::set<IVertex> &new_affected_verts, IndexMap &im);
-static bool commute_singles_to_front(Circuit &circ);
+static bool commute_singles_to_front(
+    Circuit &circ, std::optional<VertexSet> &region, VertexSet &touched);
 static bool squash_to_pqp(
     Circuit &circ, OpType q, OpType p, bool strict = false);
+static bool squash_chains_to_tk1(
+    Circuit &circ, std::optional<VertexSet> &region, VertexSet &touched);
 static bool replace_non_global_phasedx(Circuit &circ);
 
-Transform Transform::remove_redundancies() {
-  return Transform(redundancy_removal);
-}
-
 // this method annihilates all primitives next to each other (accounting for
 // previous annihilations)
 // also removes redundant non-classically controlled Z basis gates before a z
 // basis measurement so that eg. -H-X-X-H- always annihilates to -----
-static bool redundancy_removal(Circuit &circ) {
-  bool success = false;
-  bool found_redundancy = true;
-  IndexMap im = circ.index_map();
-  std::set<IVertex> old_affected_verts;
-  BGL_FORALL_VERTICES(v, circ.dag, DAG) {
-    old_affected_verts.insert({im.at(v), v});
-  }
-  VertexList bin;
-  while (found_redundancy) {
-    std::set<IVertex> new_affected_verts;
-    for (const IVertex &p : old_affected_verts) {
-      remove_redundancy(circ, p.second, bin, new_affected_verts, im);
-    }
-    found_redundancy = new_affected_verts.size() != 0;
-    success |= found_redundancy;
-    old_affected_verts = new_affected_verts;
-  }
-  circ.remove_vertices(
-      bin, Circuit::GraphRewiring::No, Circuit::VertexDeletion::Yes);
-  return success;
+Transform Transform::remove_redundancies() {
+  // Built once, as this is called for every chain by squash_to_pqp
+  static const Transform remove =
+      peephole(PeepholeRules::redundancy_rules());
+  return remove;
 }
 
-// called by the previous method. This should generally not be called
-// independently
-static bool remove_redundancy(
-    Circuit &circ, const Vertex &vert, VertexList &bin,
-    std::set<IVertex> &new_affected_verts, IndexMap &im) {
-  const Op_ptr op = circ.get_Op_ptr_from_Vertex(vert);
-  const OpDesc desc = op->get_desc();
-  if (!desc.is_gate()) return false;
-  if (circ.n_out_edges(vert) == 0 || circ.n_in_edges(vert) == 0) {
-    return false;  // either a boundary vert or we have already removed it
-  }
-
-  auto remove_single_vertex = [&bin, &circ, &new_affected_verts,
-                               &im](const Vertex &v_remove) {
-    bin.push_back(v_remove);
-    for (const Vertex &l : circ.get_predecessors(v_remove)) {
-      new_affected_verts.insert({im.at(l), l});
-    }
-    circ.remove_vertex(
-        v_remove, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::No);
-  };
-  // remove 0 angle rotations from circuit
-  std::optional<double> a = op->is_identity();
-  if (a) {
-    remove_single_vertex(vert);
-    circ.add_phase(a.value());
-    return true;
-  } else if (desc.type() == OpType::noop) {
-    // remove "noop" gates from circuit
-    remove_single_vertex(vert);
-    return true;
-  }
-  VertexVec kids = circ.get_successors(vert);
-
-  // if op is immediately followed by a z basis measurement on all qubits,
-  // remove
-  if (circ.n_out_edges_of_type(vert, EdgeType::Classical) == 0) {
-    bool z_followed_by_measures = true;
-    for (port_t port = 0; port < kids.size() && z_followed_by_measures;
-         port++) {
-      if (circ.get_OpType_from_Vertex(kids[port]) == OpType::Measure) {
-        z_followed_by_measures &= op->commutes_with_basis(Pauli::Z, port);
-      } else {
-        z_followed_by_measures = false;
-      }
-    }
-    if (z_followed_by_measures) {
-      remove_single_vertex(vert);
-      return true;
-    }
-  }
-
-  // check that both the vertex and its successor have each other and only each
-  // other
-  if ((kids.size() == 1) && (circ.get_predecessors(kids[0]).size() == 1)) {
-    // check that the ports match up between vertices
-    Vertex b = kids[0];
-    EdgeVec ins = circ.get_in_edges(b);
-    for (const Edge &in : ins) {
-      if (circ.get_source_port(in) != circ.get_target_port(in)) return false;
-    }
+Transform Transform::peephole(const std::vector<PeepholeRule> &rules) {
+  PeepholeEngine engine(rules);
+  return Transform(Transform::RegionTransformation(
+      [engine](
+          Circuit &circ, std::optional<VertexSet> &region,
+          VertexSet &touched) { return engine.apply(circ, region, touched); }));
+}
 
-    // check that the classical edges match up correctly
-    if (circ.n_in_edges_of_type(vert, EdgeType::Boolean) != 0) return false;
-
-    const Op_ptr b_op = circ.get_Op_ptr_from_Vertex(b);
-    const OpDesc b_desc = b_op->get_desc();
-
-    if (!b_desc.is_oneway()) {
-      // if A = B.dagger(), AB = I
-      // This method cannot detect matches between rotation gates.
-      // Rotation gates are covered by the rotation gate combiner, everything
-      // else in this.
-      if (*b_op->dagger() == *op) {
-        bin.push_back(vert);
-        bin.push_back(b);
-        VertexVec last_verts = circ.get_predecessors(vert);
-        for (const Vertex &l : last_verts) {
-          new_affected_verts.insert({im.at(l), l});
-        }
-        VertexList to_detach{vert, b};
-        // detached from circuit but not removed from graph
-        circ.remove_vertices(
-            to_detach, Circuit::GraphRewiring::Yes,
-            Circuit::VertexDeletion::No);
-        return true;
-      } else if (desc.is_rotation()) {
-        // combine two rotation gates together, then if the combined
-        // operation is the identity up to phase, remove from circuit
-        if (b_desc.type() == desc.type()) {
-          Expr expr1 = op->get_params()[0];
-          Expr expr2 = b_op->get_params()[0];
-          VertexVec last_verts = circ.get_predecessors(vert);
-          for (const Vertex &l : last_verts) {
-            new_affected_verts.insert({im.at(l), l});
-          }
-          circ.remove_vertex(
-              b, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::No);
-          bin.push_back(b);
-          std::vector<Expr> params_new = {expr1 + expr2};
-          Op_ptr op_new = get_op_ptr(desc.type(), params_new, ins.size());
-          std::optional<double> a = op_new->is_identity();
-          if (a) {
-            bin.push_back(vert);
-            circ.remove_vertex(
-                vert, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::No);
-            circ.add_phase(a.value());
-          } else {
-            new_affected_verts.insert({im[vert], vert});
-            circ.dag[vert].op = op_new;
-          }
-          return true;
-        }
-      }
-    }
-  }
-  return false;
+Transform Transform::clifford_peephole() {
+  return peephole(PeepholeRules::clifford_rules());
 }
 
 Transform Transform::squash_1qb_to_tk1() {
@@ -191,57 +72,152 @@ Transform Transform::squash_1qb_to_tk1() {
          decompose_ZYZ_to_TK1();
 }
 
+Transform Transform::squash_1qb_chains_to_tk1() {
+  return Transform(Transform::RegionTransformation(squash_chains_to_tk1));
+}
+
 Transform Transform::commute_through_multis() {
-  return Transform(commute_singles_to_front);
+  return Transform(Transform::RegionTransformation(commute_singles_to_front));
 }
 
 Transform Transform::globalise_phasedx() {
   return Transform(replace_non_global_phasedx);
 }
 
+// Whether `v` is a single-qubit gate that may be commuted through
+static bool is_single_qubit_gate(const Circuit &circ, const Vertex &v) {
+  return circ.get_Op_ptr_from_Vertex(v)->get_desc().is_gate() &&
+         circ.n_in_edges_of_type(v, EdgeType::Quantum) == 1;
+}
+
+// Whether `v` is a multi-qubit gate that singles may be commuted through
+static bool is_multi_qubit_gate(const Circuit &circ, const Vertex &v) {
+  return circ.n_in_edges_of_type(v, EdgeType::Quantum) > 1 &&
+         circ.get_Op_ptr_from_Vertex(v)->get_desc().is_gate();
+}
+
+// Moves the single qubit gate `single` from after to before the multiqubit
+// gate `multi`, on port `port` of `multi`, recording the vertices next to
+// the move in `touched`
+static void move_single_before(
+    Circuit &circ, const Vertex &single, const Vertex &multi, port_t port,
+    VertexSet &touched) {
+  Vertex next = circ.target(circ.get_nth_out_edge(single, 0));
+  circ.remove_vertex(
+      single, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::No);
+  Edge rewire_edge = circ.get_nth_in_edge(multi, port);
+  touched.insert({circ.source(rewire_edge), single, multi, next});
+  circ.rewire(single, {rewire_edge}, {EdgeType::Quantum});
+}
+
+// Moves the single qubit gate `single` backwards past any multiqubit gates it
+// commutes with
+static bool commute_single_back(
+    Circuit &circ, const Vertex &single, VertexSet &touched) {
+  if (!is_single_qubit_gate(circ, single)) return false;
+  const Op_ptr op = circ.get_Op_ptr_from_Vertex(single);
+  const std::optional<Pauli> colour = op_commuting_basis(*op, 0);
+  bool success = false;
+  while (true) {
+    Edge in_e = circ.get_nth_in_edge(single, 0);
+    Vertex multi = circ.source(in_e);
+    if (!is_multi_qubit_gate(circ, multi)) break;
+    port_t port = circ.get_source_port(in_e);
+    if (!op_commutes_with_basis(
+            *circ.get_Op_ptr_from_Vertex(multi), colour, port))
+      break;
+    move_single_before(circ, single, multi, port, touched);
+    success = true;
+  }
+  return success;
+}
+
 // moves single qubit operations past multiqubit operations they commute with,
 // towards front of circuit (hardcoded)
-static bool commute_singles_to_front(Circuit &circ) {
+static bool commute_singles_to_front(
+    Circuit &circ, std::optional<VertexSet> &region, VertexSet &touched) {
   bool success = false;
-  // follow each qubit path from output to input
+  if (region) {
+    // Only look at the singles in the region and those following multiqubit
+    // gates in the region
+    IndexMap im = circ.index_map();
+    std::set<IVertex> ordered;
+    for (const Vertex &v : *region) ordered.insert({im.at(v), v});
+    for (const IVertex &iv : ordered) {
+      if (is_multi_qubit_gate(circ, iv.second)) {
+        VertexVec singles =
+            circ.get_successors_of_type(iv.second, EdgeType::Quantum);
+        for (const Vertex &single : singles) {
+          success = commute_single_back(circ, single, touched) || success;
+        }
+      } else {
+        success = commute_single_back(circ, iv.second, touched) || success;
+      }
+    }
+    return success;
+  }
+  // Each move only changes the wire of the single, so wires are treated
+  // independently. Following each wire from output to input, carry the singles
+  // that may still move back, and land them once they meet a gate they do not
+  // commute with, so that each single is rewired at most once.
   for (const Qubit &q : circ.all_qubits()) {
-    Vertex prev_v = circ.get_out(q);
-    Edge current_e = circ.get_nth_in_edge(prev_v, 0);
-    Vertex current_v = circ.source(current_e);
-    while (!is_initial_q_type(circ.get_OpType_from_Vertex(current_v))) {
-      const Op_ptr curr_op = circ.get_Op_ptr_from_Vertex(current_v);
-      // if current vertex is a multiqubit gate
-      if (circ.n_in_edges_of_type(current_v, EdgeType::Quantum) > 1 &&
-          curr_op->get_desc().is_gate()) {
-        // need gate check to access commuting_basis
-        const std::pair<port_t, port_t> ports = circ.get_ports(current_e);
-      check_prev_commutes:
-        const Op_ptr prev_op = circ.get_Op_ptr_from_Vertex(prev_v);
-        // if previous vertex is single qubit gate
-        if (prev_op->get_desc().is_gate() &&
-            circ.n_in_edges_of_type(prev_v, EdgeType::Quantum) == 1) {
-          const std::optional<Pauli> prev_colour =
-              prev_op->commuting_basis(ports.second);
-
-          if (curr_op->commutes_with_basis(prev_colour, ports.first)) {
-            // subsequent op on qubit path is a single qubit gate
-            // and commutes with current multi qubit gate
-            success = true;
-            circ.remove_vertex(
-                prev_v, Circuit::GraphRewiring::Yes,
-                Circuit::VertexDeletion::No);
-            Edge rewire_edge = circ.get_nth_in_edge(current_v, ports.first);
-            circ.rewire(prev_v, {rewire_edge}, {EdgeType::Quantum});
-            current_e = circ.get_nth_out_edge(current_v, ports.first);
-            prev_v = circ.target(current_e);
-            // check if new previous gate can be commuted through too
-            goto check_prev_commutes;
-          }
+    std::vector<std::pair<Vertex, port_t>> wire;
+    Vertex v = circ.get_out(q);
+    Edge e = circ.get_nth_in_edge(v, 0);
+    v = circ.source(e);
+    while (!is_initial_q_type(circ.get_OpType_from_Vertex(v))) {
+      wire.push_back({v, circ.get_target_port(e)});
+      std::tie(v, e) = circ.get_prev_pair(v, e);
+    }
+    // singles carried back (in circuit order), with the last multiqubit gate
+    // and port each has moved before, if any
+    std::list<std::pair<Vertex, std::optional<VertPort>>> carried;
+    // singles to move, in circuit order, with the gate and port to precede
+    std::vector<std::pair<Vertex, VertPort>> landings;
+    auto land_all = [&]() {
+      for (const auto &c : carried) {
+        if (c.second) landings.push_back({c.first, *c.second});
+      }
+      carried.clear();
+    };
+    for (const std::pair<Vertex, port_t> &item : wire) {
+      const Vertex &current = item.first;
+      if (is_single_qubit_gate(circ, current)) {
+        carried.push_front({current, std::nullopt});
+      } else if (is_multi_qubit_gate(circ, current)) {
+        const Op_ptr multi_op = circ.get_Op_ptr_from_Vertex(current);
+        // the leading singles commuting with the gate move on; the rest land
+        auto it = carried.begin();
+        for (; it != carried.end(); ++it) {
+          const std::optional<Pauli> colour =
+              op_commuting_basis(*circ.get_Op_ptr_from_Vertex(it->first), 0);
+          if (!op_commutes_with_basis(*multi_op, colour, item.second)) break;
+          it->second = VertPort{current, item.second};
+          touched.insert(current);
+        }
+        for (auto stop = it; stop != carried.end(); ++stop) {
+          if (stop->second) landings.push_back({stop->first, *stop->second});
         }
+        carried.erase(it, carried.end());
+      } else {
+        land_all();
       }
-      // move to next vertex (towards input)
-      prev_v = current_v;
-      std::tie(current_v, current_e) = circ.get_prev_pair(current_v, current_e);
+    }
+    land_all();
+    if (landings.empty()) continue;
+    success = true;
+    // `landings` is ordered from output to input by landing point, and in
+    // circuit order within each; detach every single before placing any.
+    for (const std::pair<Vertex, VertPort> &l : landings) {
+      touched.insert(l.first);
+      touched.insert(circ.target(circ.get_nth_out_edge(l.first, 0)));
+      circ.remove_vertex(
+          l.first, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::No);
+    }
+    for (const std::pair<Vertex, VertPort> &l : landings) {
+      Edge rewire_edge = circ.get_nth_in_edge(l.second.first, l.second.second);
+      touched.insert(circ.source(rewire_edge));
+      circ.rewire(l.first, {rewire_edge}, {EdgeType::Quantum});
     }
   }
 
@@ -359,8 +335,9 @@ Transform Transform::commute_and_combine_HQS2() {
   return Transform([](Circuit &circ) {
     bool success = false;
     VertexList bin;
+    SmallEdgeVec outs;
     BGL_FORALL_VERTICES(v, circ.dag, DAG) {
-      EdgeVec outs = circ.get_all_out_edges(v);
+      circ.get_all_out_edges(v, outs);
       if (circ.get_OpType_from_Vertex(v) == OpType::ZZMax && outs.size() == 2) {
         Vertex next0 = boost::target(outs[0], circ.dag);
         Vertex next1 = boost::target(outs[1], circ.dag);
@@ -412,8 +389,9 @@ Transform Transform::two_qubit_squash(double cx_fidelity) {
     std::map<Qubit, Edge> current_edge_on_qb;
     std::vector<Interaction> i_vec;
     std::map<Qubit, int> current_interaction;
+    std::shared_ptr<const UnitPathIndex> paths = circ.get_unit_path_index();
     for (const Qubit &qb : circ.all_qubits()) {
-      for (const VertPort &vp : circ.unit_path(qb)) {
+      for (const VertPort &vp : paths->path(qb)) {
         v_to_qb.insert({vp, qb});
       }
       Vertex input = circ.get_in(qb);
@@ -718,13 +696,13 @@ class Squasher {
     if (smart_squash_ && is_gate_type(next_op_type)) {
       const port_t source_port = circ_.get_source_port(e);
       const std::optional<Pauli> commutation_colour =
-          next_op->commuting_basis(source_port);
+          op_commuting_basis(*next_op, source_port);
 
-      Gate P(p_, {0}, 1);
-      Gate Q(q_, {0}, 1);
-      if (P.commutes_with_basis(commutation_colour, 0)) {
+      if (commutes_in_basis(
+              commutation_colour, optype_commuting_basis(p_, 0, 1))) {
         commute_through = true;
-      } else if (Q.commutes_with_basis(commutation_colour, 0)) {
+      } else if (commutes_in_basis(
+                     commutation_colour, optype_commuting_basis(q_, 0, 1))) {
         choose_qpq = true;
         commute_through = true;
       }
@@ -747,7 +725,7 @@ class Squasher {
     }
     replacement.add_op<unsigned>(q, angle_q, {0});
     replacement.add_op<unsigned>(p, angle_p2, {0});
-    redundancy_removal(replacement);
+    Transform::remove_redundancies().apply(replacement);
 
     // check if replacement is any different from original chain
     if (!is_same_chain(replacement, rotation_chain)) {
@@ -807,6 +785,101 @@ static bool squash_to_pqp(Circuit &circ, OpType q, OpType p, bool strict) {
   return s.squash();
 }
 
+// Whether `v` is a single-qubit gate that squash_1qb_to_tk1 merges into TK1
+static bool is_squashable_single(const Circuit &circ, const Vertex &v) {
+  const Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
+  OpType optype = op->get_type();
+  return is_gate_type(optype) && !is_projective_type(optype) &&
+         op->n_qubits() == 1;
+}
+
+// The maximal chain of squashable singles through `v`, in circuit order
+static VertexList single_chain_through(const Circuit &circ, const Vertex &v) {
+  VertexList chain{v};
+  Vertex pred = circ.source(circ.get_nth_in_edge(v, 0));
+  while (is_squashable_single(circ, pred)) {
+    chain.push_front(pred);
+    pred = circ.source(circ.get_nth_in_edge(pred, 0));
+  }
+  Vertex succ = circ.target(circ.get_nth_out_edge(v, 0));
+  while (is_squashable_single(circ, succ)) {
+    chain.push_back(succ);
+    succ = circ.target(circ.get_nth_out_edge(succ, 0));
+  }
+  return chain;
+}
+
+// Squashes each chain of singles meeting the region, or next to a vertex of
+// the region, exactly as squash_1qb_to_tk1 would squash it. Chains that are
+// already a lone TK1 gate are left alone, so every squash removes a vertex or
+// converts one to TK1 and repeated application terminates.
+static bool squash_chains_to_tk1(
+    Circuit &circ, std::optional<VertexSet> &region, VertexSet &touched) {
+  static const Transform squash = Transform::squash_1qb_to_tk1();
+  // Find all the chains before changing the circuit; they are disjoint, so
+  // squashing one leaves the others intact
+  std::vector<VertexList> chains;
+  VertexSet seen;
+  auto add_chain_through = [&](const Vertex &v) {
+    if (seen.contains(v) || !is_squashable_single(circ, v)) return;
+    chains.push_back(single_chain_through(circ, v));
+    seen.insert(chains.back().begin(), chains.back().end());
+  };
+  auto visit = [&](const Vertex &v) {
+    if (is_squashable_single(circ, v)) {
+      add_chain_through(v);
+    } else if (region) {
+      // A change at a multiqubit gate may have joined or exposed the chains
+      // on either side of it
+      for (const Vertex &w :
+           circ.get_predecessors_of_type(v, EdgeType::Quantum)) {
+        add_chain_through(w);
+      }
+      for (const Vertex &w :
+           circ.get_successors_of_type(v, EdgeType::Quantum)) {
+        add_chain_through(w);
+      }
+    }
+  };
+  if (region) {
+    IndexMap im = circ.index_map();
+    std::set<IVertex> ordered;
+    for (const Vertex &v : *region) ordered.insert({im.at(v), v});
+    for (const IVertex &iv : ordered) visit(iv.second);
+  } else {
+    BGL_FORALL_VERTICES(v, circ.dag, DAG) { visit(v); }
+  }
+
+  bool success = false;
+  for (const VertexList &chain : chains) {
+    if (chain.size() == 1 &&
+        circ.get_OpType_from_Vertex(chain.front()) == OpType::tk1) {
+      continue;
+    }
+    Circuit replacement(1);
+    for (const Vertex &v : chain) {
+      replacement.add_op<unsigned>(circ.get_Op_ptr_from_Vertex(v), {0});
+    }
+    squash.apply(replacement);
+    Edge in_e = circ.get_nth_in_edge(chain.front(), 0);
+    Edge out_e = circ.get_nth_out_edge(chain.back(), 0);
+    Vertex pred = circ.source(in_e);
+    port_t port = circ.get_source_port(in_e);
+    Vertex succ = circ.target(out_e);
+    for (const Vertex &v : chain) {
+      touched.erase(v);
+      if (region) region->erase(v);
+    }
+    Subcircuit sub = {{in_e}, {out_e}, {chain.begin(), chain.end()}};
+    circ.substitute(replacement, sub, Circuit::VertexDeletion::Yes);
+    touched.insert({pred, succ});
+    Vertex squashed = circ.target(circ.get_nth_out_edge(pred, port));
+    if (squashed != succ) touched.insert(squashed);
+    success = true;
+  }
+  return success;
+}
+
 static bool standard_squash(
     Circuit &circ, const OpTypeSet &singleqs,
     const std::function<Circuit(const Expr &, const Expr &, const Expr &)>
@@ -905,109 +978,142 @@ Transform Transform::squash_factory(
   });
 }
 
-// Given a 'SWAP_chain', finds edge in chain (or qubit wire) with best fidelity
-// and rewires the associated single qubit vertex in to it
-static bool find_edge_rewire_vertex(
-    Circuit &circ,
-    std::pair<std::vector<std::pair<Edge, double>>, Vertex> &entry) {
-  std::vector<std::pair<Edge, double>> candidates = entry.first;
-  std::pair<Edge, double> best_pair = candidates[0];
-  bool do_rewire = false;  // prevents rewiring if current edge is best edge
-                           // (causes many issues...)
-  for (unsigned i = 1; i < candidates.size(); i++) {  // find best edge
-    if (candidates[i].second > best_pair.second) {
-      best_pair = candidates[i];
-      do_rewire = true;
-    }
+namespace {
+
+// The path of one qubit through a run of SWAP gates. Slot j is the stretch of
+// wire after the j-th SWAP of the run (slot 0 is before the first), on node
+// nodes[j], starting at out-port sources[j].first of vertex
+// sources[j].second. The single-qubit gates on the path are listed in order,
+// with the slot each is in.
+struct SwapRun {
+  std::vector<Node> nodes;
+  std::vector<std::pair<port_t, Vertex>> sources;
+  std::vector<std::pair<Vertex, unsigned>> gates;
+};
+
+}  // namespace
+
+// Follow the qubit entering a SWAP gate at the given port forwards through
+// SWAPs and single-qubit gates, until any other vertex.
+static SwapRun follow_swap_run(
+    const Circuit &circ,
+    const std::unordered_map<Vertex, unit_vector_t> &swap_args,
+    Vertex swap_v, port_t in_port) {
+  SwapRun run;
+  // Single-qubit gates before the first SWAP, found backwards
+  Edge e = circ.get_nth_in_edge(swap_v, in_port);
+  Vertex v = circ.source(e);
+  while (circ.detect_singleq_unitary_op(v)) {
+    run.gates.push_back({v, 0});
+    e = circ.get_nth_in_edge(v, 0);
+    v = circ.source(e);
   }
-  if (do_rewire) {
-    // rewire in to best edge
-    circ.remove_vertex(
-        entry.second, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::No);
-    circ.rewire(entry.second, {best_pair.first}, {EdgeType::Quantum});
+  std::reverse(run.gates.begin(), run.gates.end());
+  run.sources.push_back({circ.get_source_port(e), v});
+  run.nodes.push_back(Node(swap_args.at(swap_v)[in_port]));
+  while (true) {
+    const unsigned slot = run.nodes.size();
+    const port_t out_port = 1 - in_port;
+    run.sources.push_back({out_port, swap_v});
+    run.nodes.push_back(Node(swap_args.at(swap_v)[out_port]));
+    e = circ.get_nth_out_edge(swap_v, out_port);
+    v = circ.target(e);
+    while (circ.detect_singleq_unitary_op(v)) {
+      run.gates.push_back({v, slot});
+      e = circ.get_nth_out_edge(v, 0);
+      v = circ.target(e);
+    }
+    if (circ.get_OpType_from_Vertex(v) != OpType::SWAP) break;
+    swap_v = v;
+    in_port = circ.get_target_port(e);
   }
-  return do_rewire;
+  return run;
 }
 
-// Given a SWAP vertex, which has some predecessor SWAP vertex, find the
-// 'SWAP_chain' this predecessor SWAP vertex is in and add to it
-static void extend_SWAP_chain(
-    std::list<std::pair<std::vector<std::pair<Edge, double>>, Vertex>>
-        &swap_chains,
-    Edge entry_edge, Node entry_node, const Edge &match, const Circuit &circ,
-    const DeviceCharacterisation &characterisation) {
-  for (auto it = swap_chains.begin(); it != swap_chains.end(); ++it) {
-    if ((*it).first.back().first == match) {
-      // extend chain, adding a new pair of edge and double to the end
-      (*it).first.push_back(
-          {entry_edge,
-           1.0 - characterisation.get_error(
-                     entry_node, circ.get_OpType_from_Vertex((*it).second))});
-      return;
+// Finds the paths of qubits through runs of adjacent SWAP gates, and moves
+// each single-qubit gate on them to the node along the path where its error
+// is least, keeping the gates in order. Each gate moves only forwards, and
+// only to a strictly better node; of equally good nodes it takes the first.
+// Every run is found and settled in one sweep over the circuit, with the
+// errors read from compiled tables.
+static bool rewire_sq_through_swaps(
+    Circuit &circ, const DeviceErrorTables &errors) {
+  std::vector<Vertex> swaps;
+  std::unordered_map<Vertex, unit_vector_t> swap_args;
+  for (const Command &com : circ) {
+    if (com.get_op_ptr()->get_type() == OpType::SWAP) {
+      swaps.push_back(com.get_vertex());
+      swap_args.insert({com.get_vertex(), com.get_args()});
     }
   }
-}
+  auto fidelity = [&errors](unsigned node_index, OpType type) {
+    return node_index == DeviceErrorTables::none
+               ? 1.
+               : 1. - errors.node_error(node_index, type);
+  };
 
-// Finds sequences of adjacent SWAP gates, with a predecessor Single Qubit
-// Vertex. The error rate of the required Single Qubit Vertex is stored for each
-// of the PhysicalQubits the LogicalQubit passes through Once 'SWAP_chains' are
-// found throughout the whole circuit, predecessor Single Qubit Vertices are
-// rewired into the edge with best error rate
-static bool find_rewire_sq(
-    Circuit &circ, const DeviceCharacterisation &characterisation) {
-  std::list<std::pair<std::vector<std::pair<Edge, double>>, Vertex>>
-      swap_chains;
-  for (auto it = circ.begin(); it != circ.end(); ++it) {
-    if (it->get_op_ptr()->get_type() == OpType::SWAP) {
-      // find SWAP, if either predecessor is a single qubit unitary
-      // find resulting swap chain...
-      Vertex swap_vert = it.get_vertex();
-      unit_vector_t qubits = it->get_args();
-      node_vector_t nodes = {qubits.begin(), qubits.end()};
-      VertexVec pred_verts = circ.get_predecessors(swap_vert);
-      EdgeVec pred_edges = circ.get_in_edges(swap_vert);
-      EdgeVec post_edges = circ.get_all_out_edges(swap_vert);
-      for (unsigned i = 0; i < pred_verts.size(); i++) {
-        OpType optype = circ.get_OpType_from_Vertex(
-            pred_verts[i]);  // OPT IS PREDECESSOR OPTYPE
-        if (circ.detect_singleq_unitary_op(pred_verts[i])) {
-          // wire has single qubit unitary->add a new swap chain
-          std::vector<std::pair<Edge, double>> swap_chain = {
-              {pred_edges[i],
-               1.0 - characterisation.get_error(nodes[i], optype)},
-              {post_edges[1 - i],
-               1.0 - characterisation.get_error(nodes[1 - i], optype)}};
-          swap_chains.push_back(std::make_pair(swap_chain, pred_verts[i]));
-        } else if (optype == OpType::SWAP) {  // wire has swap->assume this swap
-                                              // already in chain, find chain
-          Edge pre_edge = pred_edges[i];
-          extend_SWAP_chain(
-              swap_chains, post_edges[1 - i], nodes[1 - i], pre_edge, circ,
-              characterisation);
+  bool success = false;
+  for (const Vertex &swap_v : swaps) {
+    for (port_t in_port = 0; in_port < 2; in_port++) {
+      // Runs are followed from their first SWAP only
+      Vertex pred = circ.source(circ.get_nth_in_edge(swap_v, in_port));
+      while (circ.detect_singleq_unitary_op(pred)) {
+        pred = circ.source(circ.get_nth_in_edge(pred, 0));
+      }
+      if (circ.get_OpType_from_Vertex(pred) == OpType::SWAP) continue;
+
+      const SwapRun run = follow_swap_run(circ, swap_args, swap_v, in_port);
+      if (run.gates.empty()) continue;
+      std::vector<unsigned> node_indices;
+      for (const Node &node : run.nodes) {
+        node_indices.push_back(errors.node_index(node));
+      }
+      // Settle the gates from last to first, each no further than the next
+      std::vector<unsigned> slots(run.gates.size());
+      unsigned limit = run.nodes.size() - 1;
+      bool moved = false;
+      for (unsigned g = run.gates.size(); g-- > 0;) {
+        const OpType type = circ.get_OpType_from_Vertex(run.gates[g].first);
+        unsigned best = run.gates[g].second;
+        double best_fidelity = fidelity(node_indices[best], type);
+        for (unsigned slot = best + 1; slot <= limit; slot++) {
+          const double f = fidelity(node_indices[slot], type);
+          if (f > best_fidelity) {
+            best = slot;
+            best_fidelity = f;
+          }
         }
+        slots[g] = best;
+        moved |= best != run.gates[g].second;
+        limit = best;
+      }
+      if (!moved) continue;
+      // A gate moved into a slot goes before the gates that stay there, so
+      // inserting at the start of slots from last gate to first keeps order.
+      for (unsigned g = 0; g < run.gates.size(); g++) {
+        if (slots[g] == run.gates[g].second) continue;
+        circ.remove_vertex(
+            run.gates[g].first, Circuit::GraphRewiring::Yes,
+            Circuit::VertexDeletion::No);
+      }
+      for (unsigned g = run.gates.size(); g-- > 0;) {
+        if (slots[g] == run.gates[g].second) continue;
+        const auto &[port, source] = run.sources[slots[g]];
+        circ.rewire(
+            run.gates[g].first, {circ.get_nth_out_edge(source, port)},
+            {EdgeType::Quantum});
       }
-    }
-  }
-  // having produced swap chains, now find best qubit for gate to act on and
-  // implement
-  bool success = false;
-  while (!swap_chains.empty()) {
-    if (find_edge_rewire_vertex(circ, (*swap_chains.begin())) == true) {
       success = true;
     }
-    swap_chains.erase(swap_chains.begin());
   }
   return success;
 }
 
 static Transform commute_SQ_gates_through_SWAPS_helper(
     const DeviceCharacterisation &characterisation) {
-  return Transform([characterisation](Circuit &circ) {
-    bool success = false;
-    while (find_rewire_sq(circ, characterisation)) {
-      success = true;
-    }
-    return success;
+  const DeviceErrorTables errors(characterisation);
+  return Transform([errors](Circuit &circ) {
+    return rewire_sq_through_swaps(circ, errors);
   });
 }
 Transform Transform::commute_SQ_gates_through_SWAPS(
@@ -16,6 +16,7 @@
 
 #include "Circuit/CircPool.hpp"
 #include "Circuit/DAGDefs.hpp"
+#include "Gate/Commutation.hpp"
 #include "Transform.hpp"
 
 namespace tket {
@@ -32,10 +33,10 @@ Transform Transform::multiq_clifford_replacement(bool allow_swaps) {
 static bool multiq_clifford_match(Circuit &circ, bool allow_swaps) {
   bool success = false;
   // map from vertex/port to qubit number
-  std::map<Vertex, unit_set_t> v_to_qb = circ.vertex_unit_map();
+  VertexArray<unit_set_t> v_to_qb = circ.vertex_unit_array();
   // map from vertex to its depth from slices/reverse_slices
-  std::map<Vertex, unsigned> v_to_depth = circ.vertex_depth_map();
-  std::map<Vertex, unsigned> v_to_rev_depth = circ.vertex_rev_depth_map();
+  VertexArray<unsigned> v_to_depth = circ.vertex_depth_array();
+  VertexArray<unsigned> v_to_rev_depth = circ.vertex_rev_depth_array();
   // Analysis complete, we can now go through and actually do the transformation
   VertexList bin;
   BGL_FORALL_VERTICES(v, circ.dag, DAG) {
@@ -78,13 +79,15 @@ static bool multiq_clifford_match(Circuit &circ, bool allow_swaps) {
       unsigned front0_index = 0;
       unsigned front1_index = 0;
       while (front0_index < path0_length &&
-             circ.get_Op_ptr_from_Vertex(path0[front0_index].first)
-                 ->commutes_with_basis(Pauli::Z, path0[front0_index].second)) {
+             op_commutes_with_basis(
+                 *circ.get_Op_ptr_from_Vertex(path0[front0_index].first),
+                 Pauli::Z, path0[front0_index].second)) {
         front0_index++;
       }
       while (front1_index < path1_length &&
-             circ.get_Op_ptr_from_Vertex(path1[front1_index].first)
-                 ->commutes_with_basis(Pauli::X, path1[front1_index].second)) {
+             op_commutes_with_basis(
+                 *circ.get_Op_ptr_from_Vertex(path1[front1_index].first),
+                 Pauli::X, path1[front1_index].second)) {
         front1_index++;
       }
       if (port == 0) {
@@ -94,14 +97,16 @@ static bool multiq_clifford_match(Circuit &circ, bool allow_swaps) {
         // -1 functions the same as if it were signed
         unsigned back0_index = path0_length - 1;
         while (back0_index != front0_index && back0_index != (unsigned)-1 &&
-               circ.get_Op_ptr_from_Vertex(path0[back0_index].first)
-                   ->commutes_with_basis(Pauli::Z, path0[back0_index].second)) {
+               op_commutes_with_basis(
+                   *circ.get_Op_ptr_from_Vertex(path0[back0_index].first),
+                   Pauli::Z, path0[back0_index].second)) {
           back0_index--;
         }
         unsigned back1_index = path1_length - 1;
         while (back1_index != front1_index && back1_index != (unsigned)-1 &&
-               circ.get_Op_ptr_from_Vertex(path1[back1_index].first)
-                   ->commutes_with_basis(Pauli::X, path1[back1_index].second)) {
+               op_commutes_with_basis(
+                   *circ.get_Op_ptr_from_Vertex(path1[back1_index].first),
+                   Pauli::X, path1[back1_index].second)) {
           back1_index--;
         }
         // Check for valid causal ordering
@@ -165,9 +170,12 @@ static bool multiq_clifford_match(Circuit &circ, bool allow_swaps) {
             /* --C--  ...  --C--      --C--  ...  --C--  */
             /*   |           |    =>    |           |    */
             /* --X--S--V--S--X--      --X--V--S--V--X--  */
-            circ.dag[path1[front1_index].first] = {get_op_ptr(OpType::V)};
-            circ.dag[path1[front1_index + 1].first] = {get_op_ptr(OpType::S)};
-            circ.dag[path1[front1_index + 2].first] = {get_op_ptr(OpType::V)};
+            circ.set_vertex_Op_ptr(
+                path1[front1_index].first, get_op_ptr(OpType::V));
+            circ.set_vertex_Op_ptr(
+                path1[front1_index + 1].first, get_op_ptr(OpType::S));
+            circ.set_vertex_Op_ptr(
+                path1[front1_index + 2].first, get_op_ptr(OpType::V));
             circ.add_phase(0.25);
             front1_index++;
             back1_index--;
@@ -264,7 +272,7 @@ static bool multiq_clifford_match(Circuit &circ, bool allow_swaps) {
         Edge ei0 = circ.get_nth_out_edge(b0, p0);
         Vertex vi0 = circ.target(ei0);
         while (vi0 != a0) {
-          v_to_qb.insert({vi0, {q0}});
+          v_to_qb.insert(vi0, {q0});
           v_to_depth[vi0] = new_depth;
           v_to_rev_depth[vi0] = new_rev_depth;
           ei0 = circ.get_next_edge(vi0, ei0);
@@ -273,8 +281,8 @@ static bool multiq_clifford_match(Circuit &circ, bool allow_swaps) {
         Edge ei1 = circ.get_nth_out_edge(b1, p1);
         Vertex vi1 = circ.target(ei1);
         while (vi1 != a1) {
-          if (v_to_qb.find(vi1) == v_to_qb.end())
-            v_to_qb.insert({vi1, {q1}});
+          if (!v_to_qb.count(vi1))
+            v_to_qb.insert(vi1, {q1});
           else
             v_to_qb.at(vi1).insert(q1);
           v_to_depth[vi1] = new_depth;
@@ -286,14 +294,16 @@ static bool multiq_clifford_match(Circuit &circ, bool allow_swaps) {
         // CXs have different orientation
         unsigned back0_index = path0_length - 1;
         while (back0_index >= front0_index && back0_index != (unsigned)-1 &&
-               circ.get_Op_ptr_from_Vertex(path0[back0_index].first)
-                   ->commutes_with_basis(Pauli::X, path0[back0_index].second)) {
+               op_commutes_with_basis(
+                   *circ.get_Op_ptr_from_Vertex(path0[back0_index].first),
+                   Pauli::X, path0[back0_index].second)) {
           back0_index--;
         }
         unsigned back1_index = path1_length - 1;
         while (back1_index >= front1_index && back1_index != (unsigned)-1 &&
-               circ.get_Op_ptr_from_Vertex(path1[back1_index].first)
-                   ->commutes_with_basis(Pauli::Z, path1[back1_index].second)) {
+               op_commutes_with_basis(
+                   *circ.get_Op_ptr_from_Vertex(path1[back1_index].first),
+                   Pauli::Z, path1[back1_index].second)) {
           back1_index--;
         }
         Vertex front0pre =
@@ -461,7 +471,7 @@ static bool multiq_clifford_match(Circuit &circ, bool allow_swaps) {
         Edge ei0 = circ.get_nth_out_edge(b0, p0);
         Vertex vi0 = circ.target(ei0);
         while (vi0 != a0) {
-          v_to_qb.insert({vi0, {q0}});
+          v_to_qb.insert(vi0, {q0});
           v_to_depth[vi0] = new_depth;
           v_to_rev_depth[vi0] = new_rev_depth;
           ei0 = circ.get_next_edge(vi0, ei0);
@@ -470,8 +480,8 @@ static bool multiq_clifford_match(Circuit &circ, bool allow_swaps) {
         Edge ei1 = circ.get_nth_out_edge(b1, p1);
         Vertex vi1 = circ.target(ei1);
         while (vi1 != a1) {
-          if (v_to_qb.find(vi1) == v_to_qb.end())
-            v_to_qb.insert({vi1, {q1}});
+          if (!v_to_qb.count(vi1))
+            v_to_qb.insert(vi1, {q1});
           else
             v_to_qb.at(vi1).insert(q1);
           v_to_depth[vi1] = new_depth;
@@ -14,6 +14,7 @@
 
 #include "CliffordReductionPass.hpp"
 
+#include "Gate/Commutation.hpp"
 #include "PauliGraph/ConjugatePauliFunctions.hpp"
 
 namespace tket {
@@ -204,7 +205,7 @@ void CliffordReductionPass::insert_interaction_point(InteractionPoint ip) {
         break;
       }
       default: {
-        if (!op->commutes_with_basis(ip.p, next_p)) {
+        if (!op_commutes_with_basis(*op, ip.p, next_p)) {
           commute = false;
           continue;
         }
@@ -233,7 +234,6 @@ std::optional<InteractionMatch> CliffordReductionPass::search_back_for_match(
   point[0] = rip0;
   point[1] = rip1;
   std::map<Edge, RevInteractionPoint> point_lookup;
-  IndexMap im = circ.index_map();
 
   // interactions met when commuting back; point lists are in causal order of
   // circuit:
@@ -247,7 +247,7 @@ std::optional<InteractionMatch> CliffordReductionPass::search_back_for_match(
       auto r = itable.get<TagEdge>().equal_range(point[i].e);
       for (auto it = r.first; it != r.second; ++it) {
         Vertex v = it->source;
-        candidates[i][{im.at(v), v}].push_front(*it);
+        candidates[i][{v_to_index.at(v), v}].push_front(*it);
       }
       Vertex pred = circ.source(point[i].e);
       port_t pred_port = circ.get_source_port(point[i].e);
@@ -276,7 +276,7 @@ std::optional<InteractionMatch> CliffordReductionPass::search_back_for_match(
           break;
         }
         default: {
-          commute = pred_op->commutes_with_basis(point[i].p, pred_port);
+          commute = op_commutes_with_basis(*pred_op, point[i].p, pred_port);
           break;
         }
       }
@@ -314,9 +314,10 @@ void CliffordReductionPass::process_new_interaction(const Vertex &inter) {
     Vertex v = to_process.front();
     to_process.pop_front();
     Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
-    Pauli basis0 = *op->commuting_basis(0);
-    Pauli basis1 = *op->commuting_basis(1);
-    EdgeVec ins = circ.get_in_edges(v);
+    Pauli basis0 = *op_commuting_basis(*op, 0);
+    Pauli basis1 = *op_commuting_basis(*op, 1);
+    SmallEdgeVec ins;
+    circ.get_in_edges(v, ins);
     RevInteractionPoint rip0 = {ins.at(0), basis0, false};
     RevInteractionPoint rip1 = {ins.at(1), basis1, false};
     std::optional<InteractionMatch> match = search_back_for_match(rip0, rip1);
@@ -461,6 +462,7 @@ Subcircuit CliffordReductionPass::substitute(
   for (const Vertex &v : to_replace.verts) {
     v_to_depth.erase(v);
     v_to_units.erase(v);
+    v_to_index.erase(v);
     auto r = itable.get<TagSource>().equal_range(v);
     for (auto next = r.first; next != r.second; r.first = next) {
       ++next;
@@ -498,6 +500,20 @@ Subcircuit CliffordReductionPass::substitute(
     e_to_unit.insert({in, units[qi]});
   }
 
+  // New vertices are added at the end of the vertex list; index them in that
+  // order, as Circuit::index_map would.
+  std::vector<Vertex> new_verts;
+  DAG::vertex_iterator vi = boost::vertices(circ.dag).second;
+  while (new_verts.size() < inserted.verts.size()) {
+    --vi;
+    if (inserted.verts.find(*vi) != inserted.verts.end()) {
+      new_verts.push_back(*vi);
+    }
+  }
+  for (auto it = new_verts.rbegin(); it != new_verts.rend(); ++it) {
+    v_to_index.insert({*it, next_index++});
+  }
+
   // Now `v_to_depth` is 0 at all `inserted.verts`. Fix this and propagate
   // updates to the depth map into the future cone, ensuring that the depths
   // are strictly increasing along wires. Stop when we reach a vertex that
@@ -511,22 +527,26 @@ Subcircuit CliffordReductionPass::substitute(
         // when tracing another qubit, so the check above is necessary.
         v_to_depth[next] = v_to_depth.at(preds[qi].first) + 1;
       }
-      std::function<bool(const Vertex &, const Vertex &)> c =
-          [&](const Vertex &a, const Vertex &b) {
-            unsigned deptha = v_to_depth.at(a);
-            unsigned depthb = v_to_depth.at(b);
-            if (deptha == depthb) {
-              unit_set_t unitsa = v_to_units.at(a);
-              unit_set_t unitsb = v_to_units.at(b);
-              return unitsa < unitsb;
-            }
-            return deptha < depthb;
-          };
-      std::set<Vertex> to_search;
+      typedef std::function<bool(const Vertex &, const Vertex &)> Comp;
+      Comp c = [&](const Vertex &a, const Vertex &b) {
+        unsigned deptha = v_to_depth.at(a);
+        unsigned depthb = v_to_depth.at(b);
+        if (deptha == depthb) {
+          const unit_set_t &unitsa = v_to_units.at(a);
+          const unit_set_t &unitsb = v_to_units.at(b);
+          if (unitsa == unitsb) return a < b;
+          return unitsa < unitsb;
+        }
+        return deptha < depthb;
+      };
+      // Ordered by depth, so vertices must be taken out before their depth is
+      // changed. Depths may clash until propagation is complete, hence the
+      // final comparison of vertices.
+      std::set<Vertex, Comp> to_search(c);
       to_search.insert(next);
       while (!to_search.empty()) {
-        Vertex v = *std::min_element(to_search.begin(), to_search.end(), c);
-        to_search.erase(v);
+        Vertex v = *to_search.begin();
+        to_search.erase(to_search.begin());
         unsigned v_depth = v_to_depth.at(v);
         EdgeVec outs = circ.get_all_out_edges(v);
         for (const Edge &e : outs) {
@@ -534,6 +554,7 @@ Subcircuit CliffordReductionPass::substitute(
           std::map<Vertex, unsigned>::iterator succ_it = v_to_depth.find(succ);
           if (succ_it != v_to_depth.end()) {
             if (succ_it->second <= v_depth) {
+              to_search.erase(succ);
               succ_it->second = v_depth + 1;
               if (v_depth >= current_depth) {
                 current_depth = v_depth + 1;
@@ -563,9 +584,7 @@ std::optional<Edge> CliffordReductionPass::find_earliest_successor(
     unsigned deptha = v_to_depth.at(a);
     unsigned depthb = v_to_depth.at(b);
     if (deptha == depthb) {
-      unit_set_t unitsa = v_to_units.at(a);
-      unit_set_t unitsb = v_to_units.at(b);
-      return unitsa < unitsb;
+      return v_to_units.at(a) < v_to_units.at(b);
     }
     return deptha < depthb;
   };
@@ -641,6 +660,8 @@ CliffordReductionPass::CliffordReductionPass(Circuit &c, bool swaps)
       allow_swaps(swaps) {
   v_to_units = circ.vertex_unit_map();
   e_to_unit = circ.edge_unit_map();
+  v_to_index = circ.index_map();
+  next_index = v_to_index.size();
 }
 
 bool CliffordReductionPass::reduce_circuit(Circuit &circ, bool allow_swaps) {
@@ -653,13 +674,15 @@ bool CliffordReductionPass::reduce_circuit(Circuit &circ, bool allow_swaps) {
   }
 
   // Process all 2qb Clifford vertices.
+  SmallEdgeVec ins;
+  SmallOptEdgeVec outs;
   for (const Slice &sl : slices) {
     for (const Vertex &v : sl) {
       context.v_to_depth.insert({v, context.current_depth});
       Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
       if (!op->get_desc().is_gate()) continue;
-      EdgeVec ins = circ.get_in_edges(v);
-      std::vector<std::optional<Edge>> outs = circ.get_linear_out_edges(v);
+      circ.get_in_edges(v, ins);
+      circ.get_linear_out_edges(v, outs);
       OpType type = op->get_type();
       std::list<InteractionPoint> new_points;
       switch (type) {
@@ -703,7 +726,7 @@ bool CliffordReductionPass::reduce_circuit(Circuit &circ, bool allow_swaps) {
             auto r = context.itable.get<TagEdge>().equal_range(ins[i]);
             for (auto it = r.first; it != r.second; ++it) {
               InteractionPoint ip = *it;
-              if (op->commutes_with_basis(ip.p, i)) {
+              if (op_commutes_with_basis(*op, ip.p, i)) {
                 ip.e = *outs[i];
                 new_points.push_back(ip);
               }
@@ -124,6 +124,15 @@ class CliffordReductionPass {
   /** Map from edge to corresponding unit */
   std::map<Edge, UnitID> e_to_unit;
 
+  /**
+   * Position of each vertex in the vertex list of the circuit, maintained
+   * through substitutions rather than recomputed for each search
+   */
+  IndexMap v_to_index;
+
+  /** Index to give the next vertex added to the circuit */
+  unsigned next_index;
+
   /** Whether any changes have been made to the circuit */
   bool success;
 
@@ -12,16 +12,44 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+
 #include "Transform.hpp"
+#include "Utils/Cancellation.hpp"
+#include "Utils/Trace.hpp"
 
 namespace tket {
 
+Transform::Transform(const RegionTransformation &trans)
+    : apply([trans](Circuit &circ) {
+        std::optional<VertexSet> region;
+        VertexSet touched;
+        return trans(circ, region, touched);
+      }),
+      apply_in_region(trans) {}
+
 Transform operator>>(const Transform &lhs, const Transform &rhs) {
   std::vector<Transform> l = {lhs, rhs};
   return Transform::sequence(l);
 }
 
 Transform Transform::sequence(std::vector<Transform> &tvec) {
+  if (std::all_of(tvec.begin(), tvec.end(), [](const Transform &t) {
+        return t.apply_in_region.has_value();
+      })) {
+    return Transform(RegionTransformation(
+        [=](Circuit &circ, std::optional<VertexSet> &region,
+            VertexSet &touched) {
+          bool success = false;
+          for (const Transform &t : tvec) {
+            // Later transforms also examine the vertices touched by earlier
+            // ones
+            if (region) region->insert(touched.begin(), touched.end());
+            success = (*t.apply_in_region)(circ, region, touched) || success;
+          }
+          return success;
+        }));
+  }
   return Transform([=](Circuit &circ) {
     bool success = false;
     for (std::vector<Transform>::const_iterator it = tvec.begin();
@@ -33,9 +61,34 @@ Transform Transform::sequence(std::vector<Transform> &tvec) {
 }
 
 Transform Transform::repeat(const Transform &trans) {
+  if (trans.apply_in_region) {
+    RegionTransformation region_trans = *trans.apply_in_region;
+    return Transform([=](Circuit &circ) {
+      TKET_TRACE_SPAN("Transform::repeat");
+      std::optional<VertexSet> region;
+      VertexSet touched;
+      if (!region_trans(circ, region, touched)) return false;
+      TKET_TRACE_COUNT("rewrites", 1);
+      // Only the neighbourhoods of the previous changes can have new matches
+      while (!touched.empty()) {
+        check_cancellation();
+        TKET_TRACE_COUNT("rewrites", 1);
+        TKET_TRACE_COUNT("region_vertices", touched.size());
+        region = std::move(touched);
+        touched.clear();
+        region_trans(circ, region, touched);
+      }
+      return true;
+    });
+  }
   return Transform([=](Circuit &circ) {
+    TKET_TRACE_SPAN("Transform::repeat");
     bool success = false;
-    while (trans.apply(circ)) success = true;
+    while (trans.apply(circ)) {
+      success = true;
+      TKET_TRACE_COUNT("rewrites", 1);
+      check_cancellation();
+    }
     return success;
   });
 }
@@ -53,6 +106,7 @@ Transform Transform::repeat_with_metric(
       currentCircuit = &newCircuit;
       currentVal = newVal;
       success = true;
+      check_cancellation();
       trans.apply(newCircuit);
       newVal = eval(newCircuit);
     }
@@ -67,6 +121,7 @@ Transform Transform::repeat_while(
     bool success = false;
     while (cond.apply(circ)) {
       success = true;
+      check_cancellation();
       body.apply(circ);
     }
     return success;
@@ -35,27 +35,23 @@ namespace tket {
 Transform Transform::remove_discarded_ops() {
   return Transform([](Circuit &circ) {
     // We want to keep all vertices that have an Output or ClOutput in their
-    // causal future. Start by constructing this set, then remove the
-    // remainder.
+    // causal future. Start by constructing this set, with one backward sweep
+    // from all the outputs, then remove the remainder.
     VertexSet keep;
+    VertexVec to_visit;
     for (auto v_end : circ.all_outputs()) {
       if (circ.get_OpType_from_Vertex(v_end) != OpType::Discard) {
-        // Trace back from v, adding to keep-set. We can ignore vertices
-        // that are already in the keep-set.
-        VertexSet v_frontier;
         keep.insert(v_end);
-        v_frontier.insert(v_end);
-        while (!v_frontier.empty()) {
-          VertexSet new_v_frontier;
-          for (auto v : v_frontier) {
-            for (const Vertex &v0 : circ.get_predecessors(v)) {
-              if (keep.find(v0) == keep.end()) {
-                keep.insert(v0);
-                new_v_frontier.insert(v0);
-              }
-            }
-          }
-          v_frontier = std::move(new_v_frontier);
+        to_visit.push_back(v_end);
+      }
+    }
+    // Each vertex is visited once, when it is first added to the keep-set.
+    while (!to_visit.empty()) {
+      Vertex v = to_visit.back();
+      to_visit.pop_back();
+      for (const Vertex &v0 : circ.get_predecessors(v)) {
+        if (keep.insert(v0).second) {
+          to_visit.push_back(v0);
         }
       }
     }
@@ -106,24 +102,6 @@ static std::optional<unsigned> unique_unit_row(
   throw NotUnitary(ss.str());
 }
 
-/**
- * Return the set of v in F all of whose quantum in-edges are in qvals.
- */
-static VertexSet known_inputs_only(
-    const Circuit &circ, const VertexSet &F,
-    const std::map<Edge, bool> &qvals) {
-  VertexSet v_frontier;
-  for (const Vertex &v : F) {
-    EdgeVec v_q_inedges = circ.get_in_edges_of_type(v, EdgeType::Quantum);
-    if (std::all_of(
-            v_q_inedges.begin(), v_q_inedges.end(),
-            [&qvals](const Edge &e) { return qvals.find(e) != qvals.end(); })) {
-      v_frontier.insert(v);
-    }
-  }
-  return v_frontier;
-}
-
 Transform Transform::simplify_initial(
     AllowClassical allow_classical, CreateAllQubits create_all_qubits,
     std::shared_ptr<const Circuit> xcirc) {
@@ -141,101 +119,100 @@ Transform Transform::simplify_initial(
       }
     }
 
-    // Partial map from quantum edges to values.
+    // Partial map from quantum edges to values. Each edge is given a value at
+    // most once, so a vertex becomes ready exactly when the last of its
+    // quantum in-edges is given one.
     std::map<Edge, bool> qvals;
 
-    // Assign 0 values to all edges coming out of zeroing vertices, and
-    // construct the set of their target vertices.
-    VertexSet F;
+    // Number of quantum in-edges with known values, for vertices with some.
+    std::map<Vertex, unsigned> n_known_inputs;
+
+    // Vertices with all-known input values, yet to be simplified.
+    VertexVec ready;
+
+    auto set_value = [&](const Edge &e, bool value) {
+      qvals[e] = value;
+      Vertex v = circ.target(e);
+      unsigned n_q = circ.n_in_edges_of_type(v, EdgeType::Quantum);
+      if (++n_known_inputs[v] == n_q) {
+        ready.push_back(v);
+      }
+    };
+
+    // Assign 0 values to all edges coming out of zeroing vertices.
     for (auto z : zeroing_vertices) {
       EdgeVec z_outedges = circ.get_all_out_edges(z);
       TKET_ASSERT(z_outedges.size() == 1);
       Edge z_out = z_outedges[0];
       TKET_ASSERT(circ.get_edgetype(z_out) == EdgeType::Quantum);
-      qvals[z_out] = false;
-      F.insert(circ.target(z_out));
+      set_value(z_out, false);
     }
 
-    // Construct frontier of vertices with all-known input values.
-    VertexSet v_frontier = known_inputs_only(circ, F, qvals);
-
     // Partial map from vertices to sequences of X gates to replace them.
     std::map<Vertex, std::vector<bool>> reductions;
 
     // Partial map from Measure vertices to bits to set after measure.
     std::map<Vertex, bool> measurebits;
 
-    while (!v_frontier.empty()) {
-      // Simplify vertices in the frontier that we can, and move it on.
-      F.clear();
-      for (const Vertex &v : v_frontier) {
-        // If there are any Boolean inputs to v, skip it.
-        if (circ.n_in_edges_of_type(v, EdgeType::Boolean) != 0) {
-          continue;
-        }
-
-        Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
-        std::optional<Eigen::MatrixXcd> U = op_unitary(op);
-        bool is_measure = (op->get_type() == OpType::Measure);
+    // Simplify the vertices we can, propagating values forward. Each vertex
+    // is considered once.
+    while (!ready.empty()) {
+      Vertex v = ready.back();
+      ready.pop_back();
 
-        if (!U && (!is_measure || allow_classical == AllowClassical::No)) {
-          continue;
-        }
-
-        // Compute input state.
-        EdgeVec v_q_inedges = circ.get_in_edges_of_type(v, EdgeType::Quantum);
-        unsigned n_q = v_q_inedges.size();
-        std::vector<bool> v_invals(n_q);
-        for (unsigned i = 0; i < n_q; i++) {
-          v_invals[i] = qvals[v_q_inedges[i]];
-        }
+      // If there are any Boolean inputs to v, skip it.
+      if (circ.n_in_edges_of_type(v, EdgeType::Boolean) != 0) {
+        continue;
+      }
 
-        if (U) {
-          // Compute relevant column J of U.
-          unsigned J = 0, pow2 = 1u << n_q;
-          for (unsigned i = 0; i < n_q; i++) {
-            pow2 >>= 1;
-            if (v_invals[i]) {
-              J |= pow2;
-            }
-          }
+      Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
+      std::optional<Eigen::MatrixXcd> U = op_unitary(op);
+      bool is_measure = (op->get_type() == OpType::Measure);
 
-          // Check if there is a unique I s.t. |U(I,J)| == 1.
-          std::optional<unsigned> I = unique_unit_row(*U, J);
-          if (!I) continue;
+      if (!U && (!is_measure || allow_classical == AllowClassical::No)) {
+        continue;
+      }
 
-          // Convert I to a vector of bool
-          std::vector<bool> v_outvals(n_q);
-          for (unsigned i = 0; i < n_q; i++) {
-            v_outvals[i] = (*I >> (n_q - 1 - i)) & 1;
-          }
+      // Compute input state.
+      EdgeVec v_q_inedges = circ.get_in_edges_of_type(v, EdgeType::Quantum);
+      unsigned n_q = v_q_inedges.size();
+      std::vector<bool> v_invals(n_q);
+      for (unsigned i = 0; i < n_q; i++) {
+        v_invals[i] = qvals.at(v_q_inedges[i]);
+      }
 
-          // Label out-edges of v; construct equivalent X-gate rep.
-          EdgeVec v_outedges = circ.get_all_out_edges(v);
-          TKET_ASSERT(v_outedges.size() == n_q);
-          std::vector<bool> x_gates(n_q);
-          for (unsigned i = 0; i < n_q; i++) {
-            bool outval = v_outvals[i];
-            qvals[v_outedges[i]] = outval;
-            x_gates[i] = v_invals[i] ^ outval;
+      if (U) {
+        // Compute relevant column J of U.
+        unsigned J = 0, pow2 = 1u << n_q;
+        for (unsigned i = 0; i < n_q; i++) {
+          pow2 >>= 1;
+          if (v_invals[i]) {
+            J |= pow2;
           }
+        }
 
-          // Record vertex for later replacement with X-gates.
-          reductions[v] = x_gates;
+        // Check if there is a unique I s.t. |U(I,J)| == 1.
+        std::optional<unsigned> I = unique_unit_row(*U, J);
+        if (!I) continue;
 
-          // Add all successors of v to potential next frontier F.
-          for (const Edge &e : v_outedges) {
-            F.insert(circ.target(e));
-          }
-        } else {
-          TKET_ASSERT(allow_classical == AllowClassical::Yes);
-          TKET_ASSERT(n_q == 1);
-          measurebits[v] = v_invals[0];
+        // Label out-edges of v, making their targets ready once all their
+        // inputs are known; construct equivalent X-gate rep.
+        EdgeVec v_outedges = circ.get_all_out_edges(v);
+        TKET_ASSERT(v_outedges.size() == n_q);
+        std::vector<bool> x_gates(n_q);
+        for (unsigned i = 0; i < n_q; i++) {
+          bool outval = (*I >> (n_q - 1 - i)) & 1;
+          set_value(v_outedges[i], outval);
+          x_gates[i] = v_invals[i] ^ outval;
         }
-      }
 
-      // Replace v_frontier with vertices from F having all-known inputs.
-      v_frontier = known_inputs_only(circ, F, qvals);
+        // Record vertex for later replacement with X-gates.
+        reductions[v] = x_gates;
+      } else {
+        TKET_ASSERT(allow_classical == AllowClassical::Yes);
+        TKET_ASSERT(n_q == 1);
+        measurebits[v] = v_invals[0];
+      }
     }
 
     // Perform substitutions.
@@ -325,57 +302,58 @@ Transform Transform::simplify_measured() {
         }
       }
     }
-    bool changed = false;
-    bool carry_on;
-    do {
-      carry_on = false;
-      VertexList bin;
+    // Measures whose predecessors may have changed, starting with all of M.
+    VertexVec to_visit(M.begin(), M.end());
+    VertexList bin;
+    while (!to_visit.empty()) {
+      Vertex v = to_visit.back();
+      to_visit.pop_back();
       // Find all classical maps all of whose successors are in M
-      for (const Vertex &v : M) {
-        VertexVec preds = circ.get_predecessors(v);
-        for (const Vertex &v0 : preds) {
-          // Any Boolean inputs?
-          if (circ.n_in_edges_of_type(v0, EdgeType::Boolean) != 0) {
-            continue;
-          }
-          // No. Are all successors in M?
-          VertexVec succs = circ.get_successors(v0);
-          if (std::any_of(succs.begin(), succs.end(), [&](const Vertex &u) {
-                return M.find(u) == M.end();
-              })) {
-            continue;
-          }
-          // Yes. Is it a classical map?
-          Op_ptr op = circ.get_Op_ptr_from_Vertex(v0);
-          std::optional<std::shared_ptr<const ClassicalTransformOp>> cm =
-              classical_transform(op);
-          if (!cm) continue;
-          // Yes. Remove v0.
-          unsigned n_qb = succs.size();
-          circ.remove_vertex(
-              v0, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::No);
-          bin.push_back(v0);
-          // Insert *cm on the classical target wires.
-          EdgeVec cl_edges(n_qb);
-          for (unsigned i = 0; i < n_qb; i++) {
-            EdgeVec m_c_outs =
-                circ.get_out_edges_of_type(succs[i], EdgeType::Classical);
-            TKET_ASSERT(m_c_outs.size() == 1);
-            cl_edges[i] = m_c_outs[0];
-          }
-          Subcircuit cl_subc{{}, {}, cl_edges, cl_edges, {}, {}};
-          Circuit cl_circ(0, n_qb);
-          std::vector<unsigned> args(n_qb);
-          std::iota(args.begin(), args.end(), 0);
-          cl_circ.add_op<unsigned>(*cm, args);
-          circ.substitute(cl_circ, cl_subc, Circuit::VertexDeletion::No);
-          changed = true;
-          carry_on = true;
+      VertexVec preds = circ.get_predecessors(v);
+      for (const Vertex &v0 : preds) {
+        // Any Boolean inputs?
+        if (circ.n_in_edges_of_type(v0, EdgeType::Boolean) != 0) {
+          continue;
+        }
+        // No. Are all successors in M?
+        VertexVec succs = circ.get_successors(v0);
+        if (std::any_of(succs.begin(), succs.end(), [&](const Vertex &u) {
+              return M.find(u) == M.end();
+            })) {
+          continue;
         }
+        // Yes. Is it a classical map?
+        Op_ptr op = circ.get_Op_ptr_from_Vertex(v0);
+        std::optional<std::shared_ptr<const ClassicalTransformOp>> cm =
+            classical_transform(op);
+        if (!cm) continue;
+        // Yes. Remove v0.
+        unsigned n_qb = succs.size();
+        circ.remove_vertex(
+            v0, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::No);
+        bin.push_back(v0);
+        // Insert *cm on the classical target wires.
+        EdgeVec cl_edges(n_qb);
+        for (unsigned i = 0; i < n_qb; i++) {
+          EdgeVec m_c_outs =
+              circ.get_out_edges_of_type(succs[i], EdgeType::Classical);
+          TKET_ASSERT(m_c_outs.size() == 1);
+          cl_edges[i] = m_c_outs[0];
+        }
+        Subcircuit cl_subc{{}, {}, cl_edges, cl_edges, {}, {}};
+        Circuit cl_circ(0, n_qb);
+        std::vector<unsigned> args(n_qb);
+        std::iota(args.begin(), args.end(), 0);
+        cl_circ.add_op<unsigned>(*cm, args);
+        circ.substitute(cl_circ, cl_subc, Circuit::VertexDeletion::No);
+        // The successors of v0 now have the predecessors of v0 instead, so
+        // look at them again. Nothing else can have become removable.
+        to_visit.insert(to_visit.end(), succs.begin(), succs.end());
       }
-      circ.remove_vertices(
-          bin, Circuit::GraphRewiring::No, Circuit::VertexDeletion::Yes);
-    } while (carry_on);
+    }
+    bool changed = !bin.empty();
+    circ.remove_vertices(
+        bin, Circuit::GraphRewiring::No, Circuit::VertexDeletion::Yes);
     return changed;
   });
 }
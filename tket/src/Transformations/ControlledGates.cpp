@@ -14,9 +14,11 @@
 
 #include <math.h>
 
+#include <algorithm>
 #include <numeric>
 #include <optional>
 
+#include "Circuit/Boxes.hpp"
 #include "Circuit/CircPool.hpp"
 #include "Circuit/DAGDefs.hpp"
 #include "Transform.hpp"
@@ -334,6 +336,46 @@ Circuit Transform::cnx_normal_decomp(unsigned n) {
   return circ;
 }
 
+// compute the AND of the controls pairwise into the ancillae, so that the
+// final CCX onto the target is at depth O(log n), then uncompute
+Circuit Transform::cnx_clean_ancilla_decomp(unsigned n) {
+  if (n < 3)
+    throw Unsupported(
+        "Cannot decompose a gate with " + std::to_string(n) +
+        " controls using ancillae");
+  Circuit circ(2 * n - 1);
+  std::vector<unsigned> layer(n);
+  std::iota(layer.begin(), layer.end(), 0);
+  unsigned ancilla = n + 1;
+  std::vector<std::vector<unsigned>> ands;
+  while (layer.size() > 2) {
+    std::vector<unsigned> next_layer;
+    for (unsigned i = 0; i + 1 < layer.size(); i += 2) {
+      ands.push_back({layer[i], layer[i + 1], ancilla});
+      next_layer.push_back(ancilla++);
+    }
+    if (layer.size() % 2 == 1) next_layer.push_back(layer.back());
+    layer = next_layer;
+  }
+  for (const std::vector<unsigned>& args : ands)
+    circ.add_op<unsigned>(OpType::CCX, args);
+  circ.add_op<unsigned>(OpType::CCX, {layer[0], layer[1], n});
+  for (auto it = ands.rbegin(); it != ands.rend(); ++it)
+    circ.add_op<unsigned>(OpType::CCX, *it);
+  return circ;
+}
+
+Circuit Transform::cnx_dirty_ancilla_decomp(unsigned n) {
+  // lemma 7.2 acts on controls 0..n-1, ancillae n..2n-3 and target 2n-2
+  std::vector<unsigned> qbs(2 * n - 1);
+  std::iota(qbs.begin(), qbs.begin() + n, 0);
+  std::iota(qbs.begin() + n, qbs.end() - 1, n + 1);
+  qbs.back() = n;
+  Circuit circ(2 * n - 1);
+  circ.append_qubits(lemma72(n), qbs);
+  return circ;
+}
+
 /* assumes vert is controlled Ry with 1 control */
 /* decomposes CRy into 2 CXs and 2 Ry gates */
 static Circuit lemma54(const Expr& angle) {
@@ -754,8 +796,94 @@ Transform Transform::decomp_controlled_Rys() {
   });
 }
 
-Transform Transform::decomp_arbitrary_controlled_gates() {
-  return Transform::decomp_controlled_Rys() >> Transform::decomp_CCX();
+// Edges on the qubits vert does not act on, each leaving the last vertex on
+// its qubit that precedes vert. None of their targets precede vert, so any of
+// them can be routed through a replacement of vert without making a cycle.
+// Each is paired with whether its qubit is known to be in |0> there.
+static std::vector<std::pair<Edge, bool>> idle_wires(
+    const Circuit& circ, const Vertex& vert) {
+  VertexSet ancestors;
+  VertexVec to_visit{vert};
+  while (!to_visit.empty()) {
+    Vertex v = to_visit.back();
+    to_visit.pop_back();
+    for (const Vertex& pred : circ.get_predecessors(v)) {
+      if (ancestors.insert(pred).second) to_visit.push_back(pred);
+    }
+  }
+  std::vector<std::pair<Edge, bool>> wires;
+  for (const Qubit& q : circ.all_qubits()) {
+    Edge e = circ.get_nth_out_edge(circ.get_in(q), 0);
+    while (ancestors.find(circ.target(e)) != ancestors.end())
+      e = circ.get_next_edge(circ.target(e), e);
+    if (circ.target(e) == vert) continue;
+    OpType type = circ.get_OpType_from_Vertex(circ.source(e));
+    wires.push_back({e, type == OpType::Create || type == OpType::Reset});
+  }
+  return wires;
+}
+
+Transform Transform::decomp_CnX_with_ancillas() {
+  return Transform([](Circuit& circ) {
+    VertexVec cnxs;
+    BGL_FORALL_VERTICES(v, circ.dag, DAG) {
+      if (circ.get_OpType_from_Vertex(v) == OpType::CnX &&
+          circ.n_in_edges(v) > 3)
+        cnxs.push_back(v);
+    }
+    for (const Vertex& v : cnxs) {
+      const unsigned n = circ.n_in_edges(v) - 1;
+      std::vector<std::pair<Edge, bool>> wires = idle_wires(circ, v);
+      EdgeVec in_edges = circ.get_in_edges(v);
+      EdgeVec out_edges = circ.get_all_out_edges(v);
+      Circuit rep;
+      if (wires.size() >= n - 2) {
+        // prefer qubits known to be |0>
+        std::stable_partition(
+            wires.begin(), wires.end(),
+            [](const std::pair<Edge, bool>& wire) { return wire.second; });
+        rep = wires[n - 3].second ? cnx_clean_ancilla_decomp(n)
+                                  : cnx_dirty_ancilla_decomp(n);
+        for (unsigned i = 0; i < n - 2; ++i) {
+          in_edges.push_back(wires[i].first);
+          out_edges.push_back(wires[i].first);
+        }
+      } else if (!wires.empty()) {
+        lemma73(circ, {wires[0].first, v});
+        continue;
+      } else {
+        rep = cnx_normal_decomp(n);
+      }
+      Subcircuit sub{in_edges, out_edges, {v}};
+      circ.substitute(rep, sub, Circuit::VertexDeletion::Yes);
+    }
+    return !cnxs.empty();
+  });
+}
+
+Transform Transform::decomp_arbitrary_controlled_gates(bool use_ancillas) {
+  if (!use_ancillas) {
+    return Transform::decomp_controlled_Rys() >> Transform::decomp_CCX();
+  }
+  // expand QControlBoxes in place so that their CnXs can borrow the rest of
+  // the circuit
+  Transform decomp_qcontrol_boxes([](Circuit& circ) {
+    VertexVec boxes;
+    BGL_FORALL_VERTICES(v, circ.dag, DAG) {
+      if (circ.get_OpType_from_Vertex(v) == OpType::QControlBox)
+        boxes.push_back(v);
+    }
+    for (const Vertex& v : boxes) {
+      const Box& box =
+          static_cast<const Box&>(*circ.get_Op_ptr_from_Vertex(v));
+      circ.substitute(
+          *box.to_circuit(), v, Circuit::VertexDeletion::Yes,
+          Circuit::OpGroupTransfer::Merge);
+    }
+    return !boxes.empty();
+  });
+  return decomp_qcontrol_boxes >> Transform::decomp_controlled_Rys() >>
+         Transform::decomp_CnX_with_ancillas() >> Transform::decomp_CCX();
 }
 
 }  // namespace tket
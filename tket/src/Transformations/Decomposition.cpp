@@ -15,6 +15,7 @@
 #include <optional>
 
 #include "Circuit/CircPool.hpp"
+#include "Circuit/UnitPaths.hpp"
 #include "Converters/PhasePoly.hpp"
 #include "Gate/GatePtr.hpp"
 #include "OpType/OpType.hpp"
@@ -23,6 +24,7 @@
 #include "Replacement.hpp"
 #include "Transform.hpp"
 #include "Utils/Expression.hpp"
+#include "Utils/Parallel.hpp"
 
 namespace tket {
 
@@ -190,9 +192,10 @@ Transform Transform::decompose_ZYZ_to_TK1() {
             }
             std::vector<Expr> new_params = {
                 angle_3 + half, angle_2, angle_1 - half};
-            circ.dag[v] = {get_op_ptr(OpType::tk1, new_params)};
+            circ.set_vertex_Op_ptr(v, get_op_ptr(OpType::tk1, new_params));
           } else {
-            circ.dag[v] = {get_op_ptr(OpType::tk1, {zero, zero, angle_1})};
+            circ.set_vertex_Op_ptr(
+                v, get_op_ptr(OpType::tk1, {zero, zero, angle_1}));
           }
         } else if (circ.get_OpType_from_Vertex(v) == OpType::Ry) {
           const Op_ptr v_g = circ.get_Op_ptr_from_Vertex(v);
@@ -208,7 +211,7 @@ Transform Transform::decompose_ZYZ_to_TK1() {
             bin.push_back(v2);
           }
           std::vector<Expr> new_params = {angle_3 + half, angle_2, -half};
-          circ.dag[v] = {get_op_ptr(OpType::tk1, new_params)};
+          circ.set_vertex_Op_ptr(v, get_op_ptr(OpType::tk1, new_params));
         }
         e = circ.get_next_edge(v, e);
         v = circ.target(e);
@@ -301,18 +304,18 @@ Transform Transform::decompose_ZX_to_HQS1() {
           const Op_ptr next_g = circ.get_Op_ptr_from_Vertex(next_vert);
           Expr phi = next_g->get_params()[0];
           std::vector<Expr> params{theta, phi};
-          circ.dag[v].op = get_op_ptr(OpType::PhasedX, params);
+          circ.set_vertex_Op_ptr(v, get_op_ptr(OpType::PhasedX, params));
           circ.remove_vertex(
               next_vert, Circuit::GraphRewiring::Yes,
               Circuit::VertexDeletion::No);
           to_bin.push_back(next_vert);
           Expr new_param = prev_g->get_params()[0] + phi;
-          circ.dag[prev_vert].op = get_op_ptr(OpType::Rz, new_param);
+          circ.set_vertex_Op_ptr(prev_vert, get_op_ptr(OpType::Rz, new_param));
         } else {
           // if no Rz, initialise a PhasedX op with theta=Rx.params[0],phi=0
           Expr phi(0);
           std::vector<Expr> params{theta, phi};
-          circ.dag[v].op = get_op_ptr(OpType::PhasedX, params);
+          circ.set_vertex_Op_ptr(v, get_op_ptr(OpType::PhasedX, params));
         }
       }
     }
@@ -352,7 +355,7 @@ Transform Transform::decompose_MolmerSorensen() {
                 circ.get_nth_in_edge(last, 1) == outs[1]) {
               // Recognise exp(-i XX * angle * pi/2)
               const Op_ptr op_ptr = get_op_ptr(OpType::XXPhase, angle);
-              circ.dag[v] = {op_ptr};
+              circ.set_vertex_Op_ptr(v, op_ptr);
               bin.push_back(next);
               circ.remove_vertex(
                   next, Circuit::GraphRewiring::Yes,
@@ -387,7 +390,8 @@ Transform Transform::decompose_ZZPhase() {
     BGL_FORALL_VERTICES(v, circ.dag, DAG) {
       if (circ.get_OpType_from_Vertex(v) == OpType::PhaseGadget) {
         const Op_ptr g = circ.get_Op_ptr_from_Vertex(v);
-        circ.dag[v] = {get_op_ptr(OpType::ZZPhase, g->get_params()[0])};
+        circ.set_vertex_Op_ptr(
+            v, get_op_ptr(OpType::ZZPhase, g->get_params()[0]));
       }
     }
     return success;
@@ -627,28 +631,28 @@ Transform Transform::decompose_ZX_to_cliffords() {
             }
             case 1: {
               if (is_rz) {
-                circ.dag[v] = {get_op_ptr(OpType::S)};
+                circ.set_vertex_Op_ptr(v, get_op_ptr(OpType::S));
                 circ.add_phase(-0.25);
               } else {
-                circ.dag[v] = {get_op_ptr(OpType::V)};
+                circ.set_vertex_Op_ptr(v, get_op_ptr(OpType::V));
               }
               break;
             }
             case 2: {
               if (is_rz) {
-                circ.dag[v] = {get_op_ptr(OpType::Z)};
+                circ.set_vertex_Op_ptr(v, get_op_ptr(OpType::Z));
               } else {
-                circ.dag[v] = {get_op_ptr(OpType::X)};
+                circ.set_vertex_Op_ptr(v, get_op_ptr(OpType::X));
               }
               circ.add_phase(-0.5);
               break;
             }
             case 3: {
               if (is_rz) {
-                circ.dag[v] = {get_op_ptr(OpType::Sdg)};
+                circ.set_vertex_Op_ptr(v, get_op_ptr(OpType::Sdg));
                 circ.add_phase(-0.75);
               } else {
-                circ.dag[v] = {get_op_ptr(OpType::Vdg)};
+                circ.set_vertex_Op_ptr(v, get_op_ptr(OpType::Vdg));
                 circ.add_phase(1);
               }
               break;
@@ -692,7 +696,8 @@ Transform Transform::decompose_PhaseGadgets() {
             if (type == OpType::tk1) {
               t += g->get_params()[2];
             }
-            circ.dag[*it] = {get_op_ptr(OpType::PhaseGadget, {t}, 2)};
+            circ.set_vertex_Op_ptr(
+                *it, get_op_ptr(OpType::PhaseGadget, {t}, 2));
             if (type == OpType::U1) {
               circ.add_phase(t / 2);
             } else if (
@@ -758,16 +763,17 @@ Transform Transform::decompose_SWAP(const Circuit &replacement_circuit) {
 }
 
 static void swap_sub(
-    Circuit &circ, const Circuit &swap_circ_1, const Circuit &swap_circ_2,
-    Subcircuit &sub, const std::pair<port_t, port_t> &port_comp) {
+    Circuit &circ, const ReplacementTemplate &swap_circ_1,
+    const ReplacementTemplate &swap_circ_2, const Vertex &v,
+    const std::pair<port_t, port_t> &port_comp) {
   std::pair<port_t, port_t> comp = {0, 1};
   // Ports only come in 2 cases, {0,1} or {1,0}. if {0,1} (first case),
   // swap_circ_1 leaves a CX{0,1} next to current CX{0,1}, if not we can assume
   // second case.
   if (port_comp == comp)
-    circ.substitute(swap_circ_1, sub, Circuit::VertexDeletion::Yes);
+    swap_circ_1.substitute(circ, v);
   else
-    circ.substitute(swap_circ_2, sub, Circuit::VertexDeletion::Yes);
+    swap_circ_2.substitute(circ, v);
 }
 
 Transform Transform::decompose_SWAP_to_CX(const Architecture &arc) {
@@ -801,13 +807,16 @@ Transform Transform::decompose_SWAP_to_CX(const Architecture &arc) {
       VertexVec succs = circ.get_successors(v.first);
       EdgeVec in_edges = circ.get_in_edges(v.first);
       EdgeVec out_edges = circ.get_all_out_edges(v.first);
-      Subcircuit sub = {in_edges, out_edges, {v.first}};
+      // The replacements are stamped from templates, without copying a DAG
+      // for each SWAP.
+      const ReplacementTemplate &swap_0 = CircPool::SWAP_using_CX_0_template();
+      const ReplacementTemplate &swap_1 = CircPool::SWAP_using_CX_1_template();
 
       if (preds.size() == 1 &&
           circ.get_OpType_from_Vertex(preds[0]) == OpType::CX) {
         // if conditions requires that there is a CX gate before SWAP
         swap_sub(
-            circ, CircPool::SWAP_using_CX_0(), CircPool::SWAP_using_CX_1(), sub,
+            circ, swap_0, swap_1, v.first,
             {circ.get_source_port(in_edges[0]),
              circ.get_source_port(in_edges[1])});
       } else if (
@@ -815,7 +824,7 @@ Transform Transform::decompose_SWAP_to_CX(const Architecture &arc) {
           circ.get_OpType_from_Vertex(succs[0]) == OpType::CX) {
         // if no CX gate before SWAP, check after.
         swap_sub(
-            circ, CircPool::SWAP_using_CX_0(), CircPool::SWAP_using_CX_1(), sub,
+            circ, swap_0, swap_1, v.first,
             {circ.get_target_port(out_edges[0]),
              circ.get_target_port(out_edges[1])});
       } else if (v.second) {
@@ -825,12 +834,10 @@ Transform Transform::decompose_SWAP_to_CX(const Architecture &arc) {
         // decomposition.
         // SWAP_using_CX_1 is added if the backwards direction is available on
         // the architecture
-        circ.substitute(
-            CircPool::SWAP_using_CX_1(), sub, Circuit::VertexDeletion::Yes);
+        swap_1.substitute(circ, v.first);
       } else {
         // SWAP_using_CX_0 is added as a default option
-        circ.substitute(
-            CircPool::SWAP_using_CX_0(), sub, Circuit::VertexDeletion::Yes);
+        swap_0.substitute(circ, v.first);
       }
     }
     return success;
@@ -855,15 +862,18 @@ Transform Transform::decompose_BRIDGE_to_CX() {
       }
     }
 
-    auto BRIDGE_sub =
-        [&circ](std::pair<Vertex, bool> &candidate, Circuit BRIDGE_circ) {
-          if (candidate.second)
-            circ.substitute_conditional(
-                BRIDGE_circ, candidate.first, Circuit::VertexDeletion::Yes);
-          else
-            circ.substitute(
-                BRIDGE_circ, candidate.first, Circuit::VertexDeletion::Yes);
-        };
+    // Unconditional BRIDGEs are stamped from templates, without copying a
+    // DAG for each.
+    auto BRIDGE_sub = [&circ](
+                          std::pair<Vertex, bool> &candidate,
+                          const Circuit &BRIDGE_circ,
+                          const ReplacementTemplate &BRIDGE_template) {
+      if (candidate.second)
+        circ.substitute_conditional(
+            BRIDGE_circ, candidate.first, Circuit::VertexDeletion::Yes);
+      else
+        BRIDGE_template.substitute(circ, candidate.first);
+    };
 
     for (std::pair<Vertex, bool> v : bin) {
       // Get predecessor vertices and successor vertices and find subcircuit for
@@ -883,12 +893,16 @@ Transform Transform::decompose_BRIDGE_to_CX() {
             circ.source(in_edges[2])};
         if (comps[0] ==
             comps[1]) {  // First two qubits in BRIDGE in multi-qubit op
-          BRIDGE_sub(v, CircPool::BRIDGE_using_CX_0());
+          BRIDGE_sub(
+              v, CircPool::BRIDGE_using_CX_0(),
+              CircPool::BRIDGE_using_CX_0_template());
           done = true;
         } else if (comps[2] == comps[1]) {  // Second two qubits in BRIDGE in
                                             // multi-qubit op together before
                                             // BRIDGE
-          BRIDGE_sub(v, CircPool::BRIDGE_using_CX_1());
+          BRIDGE_sub(
+              v, CircPool::BRIDGE_using_CX_1(),
+              CircPool::BRIDGE_using_CX_1_template());
           done = true;
         }
       }
@@ -899,17 +913,23 @@ Transform Transform::decompose_BRIDGE_to_CX() {
             circ.target(out_edges[2])};
         if (comps[0] == comps[1]) {  // First two qubits in BRIDGE in
                                      // multi-qubit op together before BRIDGE
-          BRIDGE_sub(v, CircPool::BRIDGE_using_CX_1());
+          BRIDGE_sub(
+              v, CircPool::BRIDGE_using_CX_1(),
+              CircPool::BRIDGE_using_CX_1_template());
           done = true;
         } else if (comps[2] == comps[1]) {  // Second two qubits in BRIDGE in
                                             // multi-qubit op together before
                                             // BRIDGE
-          BRIDGE_sub(v, CircPool::BRIDGE_using_CX_0());
+          BRIDGE_sub(
+              v, CircPool::BRIDGE_using_CX_0(),
+              CircPool::BRIDGE_using_CX_0_template());
           done = true;
         }
       }
       if (!done) {  // default decomposition
-        BRIDGE_sub(v, CircPool::BRIDGE_using_CX_1());
+        BRIDGE_sub(
+            v, CircPool::BRIDGE_using_CX_1(),
+            CircPool::BRIDGE_using_CX_1_template());
       }
     }
     return success;
@@ -918,35 +938,32 @@ Transform Transform::decompose_BRIDGE_to_CX() {
 
 Transform Transform::decompose_CX_directed(const Architecture &arc) {
   return Transform([arc](Circuit &circ) {
-    bool success = false;
-    // Collect all CX type vertices
-    std::vector<std::pair<Vertex, bool>> bin;
-    for (Circuit::CommandIterator it = circ.begin(); it != circ.end(); ++it) {
-      if (it->get_op_ptr()->get_type() == OpType::CX) {
-        unit_vector_t qbs = it->get_args();
-        node_vector_t nodes = {qbs.begin(), qbs.end()};
-        if (!arc.edge_exists(nodes[0], nodes[1]) &&
-            arc.edge_exists(nodes[1], nodes[0])) {
-          // Implies CX gate is valid, and needs flipping to respect
-          // Architecture
-          bin.push_back({it.get_vertex(), false});
-        }
+    // The node of each wire is read from the unit path index and the
+    // direction of each edge from the compiled connectivity
+    std::shared_ptr<const UnitPathIndex> paths = circ.get_unit_path_index();
+    std::shared_ptr<const graphs::ConnectivityView<Node>> view =
+        arc.get_connectivity_view();
+    auto wire_qubits = [&](const Vertex &v) {
+      qubit_vector_t qbs;
+      for (const Edge &e : circ.get_in_edges_of_type(v, EdgeType::Quantum)) {
+        qbs.push_back(Qubit(paths->units().at(paths->position(e)->unit)));
       }
-      if (it->get_op_ptr()->get_type() == OpType::Conditional) {
-        const Conditional &b =
-            static_cast<const Conditional &>(*it->get_op_ptr());
+      return qbs;
+    };
+    // Collect all CX type vertices; CircBoxes holding BRIDGEs are opened in
+    // place
+    VertexVec cxs;
+    VertexVec conditional_cxs;
+    BGL_FORALL_VERTICES(v, circ.dag, DAG) {
+      Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
+      if (op->get_type() == OpType::CX) {
+        cxs.push_back(v);
+      } else if (op->get_type() == OpType::Conditional) {
+        const Conditional &b = static_cast<const Conditional &>(*op);
         if (b.get_op()->get_type() == OpType::CX) {
-          qubit_vector_t qbs = it->get_qubits();
-          node_vector_t nodes = {qbs.begin(), qbs.end()};
-          if (!arc.edge_exists(nodes[0], nodes[1]) &&
-              arc.edge_exists(nodes[1], nodes[0])) {
-            // Implies CX gate is valid, and needs flipping to respect
-            // Architecture
-            bin.push_back({it.get_vertex(), true});
-          }
-        }
-        if (b.get_op()->get_type() == OpType::CircBox) {
-          qubit_vector_t qbs = it->get_qubits();
+          conditional_cxs.push_back(v);
+        } else if (b.get_op()->get_type() == OpType::CircBox) {
+          qubit_vector_t qbs = wire_qubits(v);
           std::shared_ptr<const Box> box_ptr =
               std::dynamic_pointer_cast<const Box>(b.get_op());
           qubit_vector_t all_qubits = box_ptr->to_circuit().get()->all_qubits();
@@ -961,20 +978,39 @@ Transform Transform::decompose_CX_directed(const Architecture &arc) {
         }
       }
     }
-    for (std::pair<Vertex, bool> v : bin) {
-      if (!v.second) {
-        Subcircuit sub = {
-            circ.get_in_edges(v.first),
-            circ.get_all_out_edges(v.first),
-            {v.first}};
-        circ.substitute(
-            CircPool::CX_using_flipped_CX(), sub, Circuit::VertexDeletion::Yes);
-      }
-      if (v.second) {
-        circ.substitute_conditional(
-            CircPool::CX_using_flipped_CX(), v.first,
-            Circuit::VertexDeletion::Yes);
-      }
+    // Each gate is checked independently, so the CXs are checked in parallel
+    auto reversed = [&](const Vertex &v) {
+      qubit_vector_t qbs = wire_qubits(v);
+      unsigned ctrl = view->index(Node(qbs[0]));
+      unsigned trgt = view->index(Node(qbs[1]));
+      // Implies CX gate is valid, and needs flipping to respect Architecture
+      return !view->edge_exists(ctrl, trgt) && view->edge_exists(trgt, ctrl);
+    };
+    std::vector<char> flip(cxs.size());
+    std::vector<char> flip_conditional(conditional_cxs.size());
+    parallel_for(0, cxs.size(), 256, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; i++) flip[i] = reversed(cxs[i]);
+    });
+    for (std::size_t i = 0; i < conditional_cxs.size(); i++) {
+      flip_conditional[i] = reversed(conditional_cxs[i]);
+    }
+
+    const Circuit flipped = CircPool::CX_using_flipped_CX();
+    std::vector<std::pair<Subcircuit, const Circuit *>> replacements;
+    for (std::size_t i = 0; i < cxs.size(); i++) {
+      if (!flip[i]) continue;
+      replacements.push_back(
+          {Subcircuit(
+               circ.get_in_edges(cxs[i]), circ.get_all_out_edges(cxs[i]),
+               {cxs[i]}),
+           &flipped});
+    }
+    bool success = !replacements.empty();
+    circ.substitute_disjoint(replacements);
+    for (std::size_t i = 0; i < conditional_cxs.size(); i++) {
+      if (!flip_conditional[i]) continue;
+      circ.substitute_conditional(
+          flipped, conditional_cxs[i], Circuit::VertexDeletion::Yes);
       success = true;
     }
     return success;
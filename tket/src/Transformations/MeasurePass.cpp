@@ -12,69 +12,102 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "Gate/Commutation.hpp"
 #include "Transform.hpp"
 
 namespace tket {
 
+namespace {
+
+// Measurements on the quantum path ending at a final vertex, found by
+// walking the path backwards from it (through SWAPs), in reverse order.
+// Those before the first other vertex found are already at the end of the
+// path.
+struct PathMeasures {
+  std::vector<Vertex> measures;
+  unsigned n_at_end = 0;
+};
+
+PathMeasures find_path_measures(const Circuit &circ, Vertex final) {
+  PathMeasures path;
+  // Whether some vertex since the final one does not commute with Z
+  bool blocked = false;
+  bool at_end = true;
+  Edge e = circ.get_nth_in_edge(final, 0);
+  while (true) {
+    Vertex v = circ.source(e);
+    port_t port = circ.get_source_port(e);
+    Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
+    OpType optype = op->get_type();
+    if (is_initial_q_type(optype)) break;
+    if (optype == OpType::Measure) {
+      Edge c_out_edge = circ.get_nth_out_edge(v, 1);
+      if (!circ.detect_final_Op(circ.target(c_out_edge)) ||
+          circ.n_out_edges_of_type(v, EdgeType::Boolean) != 0) {
+        throw CircuitInvalidity(
+            "Cannot commute Measure through classical operations to the end "
+            "of the circuit");
+      }
+      if (blocked) {
+        throw CircuitInvalidity(
+            "Cannot commute Measure through quantum gates to the end of the "
+            "circuit");
+      }
+      path.measures.push_back(v);
+      if (at_end) path.n_at_end++;
+    } else if (optype == OpType::SWAP) {
+      at_end = false;
+      port = 1 - port;
+    } else {
+      at_end = false;
+      blocked = blocked || !op->get_desc().is_gate() ||
+                !op_commutes_with_basis(*op, Pauli::Z, port);
+    }
+    e = circ.get_nth_in_edge(v, port);
+  }
+  return path;
+}
+
+}  // namespace
+
 Transform Transform::delay_measures() {
   return Transform([](Circuit &circ) {
-    bool success = false;
+    // Find every measurement's final position in one backward sweep along
+    // each quantum path, before changing the circuit
+    std::vector<std::pair<Vertex, PathMeasures>> paths;
     BGL_FORALL_VERTICES(v, circ.dag, DAG) {
-      if (circ.get_OpType_from_Vertex(v) == OpType::Measure) {
-        Edge c_out_edge = circ.get_nth_out_edge(v, 1);
-        if (!circ.detect_final_Op(circ.target(c_out_edge)) ||
-            circ.n_out_edges_of_type(v, EdgeType::Boolean) != 0) {
-          throw CircuitInvalidity(
-              "Cannot commute Measure through classical operations to the end "
-              "of the circuit");
+      if (is_final_q_type(circ.get_OpType_from_Vertex(v))) {
+        PathMeasures path = find_path_measures(circ, v);
+        if (path.measures.size() > path.n_at_end) {
+          paths.push_back({v, std::move(path)});
         }
-        Edge out_edge = circ.get_nth_out_edge(v, 0);
-        Edge current_edge = out_edge;
-        Vertex current_vertex = circ.target(current_edge);
-        port_t current_port = circ.get_target_port(current_edge);
-        Op_ptr current_op = circ.get_Op_ptr_from_Vertex(current_vertex);
-        OpType current_optype = current_op->get_type();
-        while (!is_final_q_type(current_optype) &&
-               (current_optype == OpType::SWAP ||
-                current_op->commutes_with_basis(Pauli::Z, current_port))) {
-          if (current_optype == OpType::SWAP) {
-            // Update from SWAP
-            current_edge =
-                circ.get_nth_out_edge(current_vertex, 1 - current_port);
-          } else {
-            // Update to successor
-            current_edge = circ.get_nth_out_edge(current_vertex, current_port);
-          }
-          current_vertex = circ.target(current_edge);
-          current_port = circ.get_target_port(current_edge);
-          current_op = circ.get_Op_ptr_from_Vertex(current_vertex);
-          current_optype = current_op->get_type();
-        }
-        // If we haven't moved it to an output, we can't continue
-        if (!is_final_q_type(current_optype)) {
-          throw CircuitInvalidity(
-              "Cannot commute Measure through quantum gates to the end of the "
-              "circuit");
-        }
-        // If the measure was already at an output, nothing to do
-        if (current_edge == out_edge) continue;
+      }
+    }
+    for (const std::pair<Vertex, PathMeasures> &p : paths) {
+      const std::vector<Vertex> &measures = p.second.measures;
+      const unsigned n_at_end = p.second.n_at_end;
+      // Move the others in front of those already at the end, in order
+      Vertex next = n_at_end == 0 ? p.first : measures[n_at_end - 1];
+      for (unsigned i = n_at_end; i < measures.size(); ++i) {
+        Vertex v = measures[i];
         Edge in_edge = circ.get_nth_in_edge(v, 0);
-        // Rewire measure
+        Edge out_edge = circ.get_nth_out_edge(v, 0);
         circ.add_edge(
             {circ.source(in_edge), circ.get_source_port(in_edge)},
             {circ.target(out_edge), circ.get_target_port(out_edge)},
             EdgeType::Quantum);
         circ.remove_edge(in_edge);
         circ.remove_edge(out_edge);
+        Edge next_edge = circ.get_nth_in_edge(next, 0);
         circ.add_edge(
-            {circ.source(current_edge), circ.get_source_port(current_edge)},
-            {v, 0}, EdgeType::Quantum);
-        circ.add_edge({v, 0}, {current_vertex, 0}, EdgeType::Quantum);
-        circ.remove_edge(current_edge);
-        success = true;
+            {circ.source(next_edge), circ.get_source_port(next_edge)}, {v, 0},
+            EdgeType::Quantum);
+        circ.add_edge({v, 0}, {next, 0}, EdgeType::Quantum);
+        circ.remove_edge(next_edge);
+        next = v;
       }
     }
-    return success;
+    return !paths.empty();
   });
 }
 
@@ -12,24 +12,94 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+
 #include "Circuit/CircUtils.hpp"
 #include "Gate/GatePtr.hpp"
 #include "Transform.hpp"
 
 namespace tket {
 
+namespace {
+
+// Cheap statistics on the two-qubit gates of a circuit, used to skip the
+// squashing passes in cases where they are known to leave it unchanged
+struct TwoQubitStats {
+  // Greatest number of two-qubit gates acting on the same pair of qubits
+  unsigned max_per_pair = 0;
+  // Greatest number of distinct qubits a qubit interacts with
+  unsigned max_partners = 0;
+
+  explicit TwoQubitStats(const Circuit &circ) {
+    std::map<std::pair<Qubit, Qubit>, unsigned> per_pair;
+    std::map<Qubit, std::set<Qubit>> partners;
+    for (const Command &com : circ) {
+      qubit_vector_t qbs = com.get_qubits();
+      if (qbs.size() != 2) continue;
+      std::pair<Qubit, Qubit> pair = std::minmax(qbs[0], qbs[1]);
+      max_per_pair = std::max(max_per_pair, ++per_pair[pair]);
+      partners[qbs[0]].insert(qbs[1]);
+      partners[qbs[1]].insert(qbs[0]);
+      max_partners = std::max<unsigned>(
+          max_partners,
+          std::max(partners[qbs[0]].size(), partners[qbs[1]].size()));
+    }
+  }
+
+  // `two_qubit_squash` only considers blocks with at least two 2-qubit gates
+  bool two_qubit_squash_can_help() const { return max_per_pair >= 2; }
+
+  // With neither, every block of `three_qubit_squash` acts on at most two
+  // qubits and contains at most one CX, which it cannot reduce
+  bool three_qubit_squash_can_help() const {
+    return max_per_pair >= 2 || max_partners >= 2;
+  }
+};
+
+}  // namespace
+
 Transform Transform::peephole_optimise_2q() {
-  return (
-      Transform::synthesise_tket() >> Transform::two_qubit_squash() >>
-      Transform::hyper_clifford_squash() >> Transform::synthesise_tket());
+  Transform synth = Transform::synthesise_tket();
+  Transform squash = Transform::two_qubit_squash();
+  Transform rest = Transform::hyper_clifford_squash() >> synth;
+  return Transform([=](Circuit &circ) {
+    bool success = synth.apply(circ);
+    if (TwoQubitStats(circ).two_qubit_squash_can_help()) {
+      success |= squash.apply(circ);
+    }
+    success |= rest.apply(circ);
+    return success;
+  });
 }
 
 Transform Transform::full_peephole_optimise(bool allow_swaps) {
-  return (
-      Transform::synthesise_tket() >> Transform::two_qubit_squash() >>
-      Transform::clifford_simp(allow_swaps) >> Transform::synthesise_tket() >>
-      Transform::three_qubit_squash() >>
-      Transform::clifford_simp(allow_swaps) >> Transform::synthesise_tket());
+  // The fixed sequence is synthesise_tket, two_qubit_squash, clifford_simp,
+  // synthesise_tket, three_qubit_squash, clifford_simp, synthesise_tket.
+  // Stages are skipped only where they would leave the circuit unchanged, so
+  // the result is the same as that of the full sequence.
+  Transform synth = Transform::synthesise_tket();
+  Transform squash2 = Transform::two_qubit_squash();
+  Transform squash3 = Transform::three_qubit_squash(true);
+  Transform simp = Transform::clifford_simp(allow_swaps) >> synth;
+  return Transform([=](Circuit &circ) {
+    bool success = synth.apply(circ);
+    if (TwoQubitStats(circ).two_qubit_squash_can_help()) {
+      success |= squash2.apply(circ);
+    }
+    bool simplified = simp.apply(circ);
+    success |= simplified;
+    bool squashed = false;
+    if (TwoQubitStats(circ).three_qubit_squash_can_help()) {
+      squashed = squash3.apply(circ);
+      success |= squashed;
+    }
+    // If neither changed the circuit, it is already a fixed point of `simp`
+    if (simplified || squashed) success |= simp.apply(circ);
+    return success;
+  });
 }
 
 Transform Transform::canonical_hyper_clifford_squash() {
@@ -61,6 +131,19 @@ Transform Transform::synthesise_tket() {
   return synth >> repeat_synth;
 }
 
+Transform Transform::synthesise_tket_fused() {
+  // Commute and cancel before the first squash, as synthesise_tket does, so
+  // that the squash does not block commutations it would have allowed
+  Transform commute = Transform::repeat(
+      Transform::commute_through_multis() >> Transform::remove_redundancies());
+  Transform sweep = Transform::remove_redundancies() >>
+                    Transform::commute_through_multis() >>
+                    Transform::squash_1qb_chains_to_tk1();
+  return Transform::decompose_multi_qubits_CX() >>
+         Transform::remove_redundancies() >> commute >>
+         Transform::repeat(sweep);
+}
+
 static Transform CXs_from_phase_gadgets(CXConfigType cx_config) {
   return Transform([=](Circuit &circ) {
     bool success = false;
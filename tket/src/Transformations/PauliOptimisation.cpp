@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "Clifford/PackedCliffTableau.hpp"
 #include "Converters/Converters.hpp"
 #include "Converters/PauliGadget.hpp"
 #include "PauliGraph/PauliGraph.hpp"
@@ -51,21 +52,22 @@ Transform Transform::pairwise_pauli_gadgets(CXConfigType cx_config) {
     // This gives a sequence of just Pauli gadgets (gadget_circ), followed by
     // all of the Clifford operations (clifford_circ)
     std::vector<std::pair<QubitPauliTensor, Expr>> pauli_gadgets;
-    // rx_pauli[i] specifies which Pauli gadget would be built by applying an Rx
-    // rotation on qubit i and then pushing it through the Cliffords to the
-    // front of the circuit. Likewise for rz_pauli with Rz rotations. Clifford
-    // operations will update these and non-Clifford rotations will introduce
-    // Pauli gadgets accordingly
+    // The X row of qubit i in the tableau specifies which Pauli gadget would
+    // be built by applying an Rx rotation on qubit i and then pushing it
+    // through the Cliffords to the front of the circuit. Likewise the Z row
+    // for Rz rotations. Clifford operations will update these (a word of
+    // qubits at a time) and non-Clifford rotations will introduce Pauli
+    // gadgets accordingly
     Circuit gadget_circ;
     Circuit clifford_circ;
-    std::map<Qubit, QubitPauliTensor> rx_pauli;
-    std::map<Qubit, QubitPauliTensor> rz_pauli;
-    for (const Qubit &qb : circ.all_qubits()) {
+    const qubit_vector_t qubits = circ.all_qubits();
+    std::map<Qubit, unsigned> qubit_index;
+    for (const Qubit &qb : qubits) {
       gadget_circ.add_qubit(qb);
       clifford_circ.add_qubit(qb);
-      rx_pauli.insert({qb, QubitPauliTensor(qb, Pauli::X)});
-      rz_pauli.insert({qb, QubitPauliTensor(qb, Pauli::Z)});
+      qubit_index.insert({qb, qubit_index.size()});
     }
+    PackedCliffTableau tab(qubits);
     for (const Bit &cb : circ.all_bits()) {
       gadget_circ.add_bit(cb);
       clifford_circ.add_bit(cb);
@@ -76,55 +78,32 @@ Transform Transform::pairwise_pauli_gadgets(CXConfigType cx_config) {
       unit_vector_t args = c.get_args();
       OpType type = op_ptr->get_type();
       switch (type) {
-        // Update rx_pauli and rz_pauli
-        case OpType::S: {
-          Qubit q(args[0]);
-          rx_pauli[q] = i_ * rz_pauli[q] * rx_pauli[q];
-          break;
-        }
-        case OpType::V: {
-          Qubit q(args[0]);
-          rz_pauli[q] = i_ * rx_pauli[q] * rz_pauli[q];
-          break;
-        }
-        case OpType::Z: {
-          Qubit q(args[0]);
-          rx_pauli[q] = -1. * rx_pauli[q];
-          break;
-        }
-        case OpType::X: {
-          Qubit q(args[0]);
-          rz_pauli[q] = -1. * rz_pauli[q];
-          break;
-        }
-        case OpType::Sdg: {
-          Qubit q(args[0]);
-          rx_pauli[q] = -i_ * rz_pauli[q] * rx_pauli[q];
-          break;
-        }
-        case OpType::Vdg: {
-          Qubit q(args[0]);
-          rz_pauli[q] = -i_ * rx_pauli[q] * rz_pauli[q];
-          break;
-        }
+        // Update the tableau
+        case OpType::S:
+        case OpType::V:
+        case OpType::Z:
+        case OpType::X:
+        case OpType::Sdg:
+        case OpType::Vdg:
         case OpType::CX: {
-          Qubit q_ctrl(args[0]);
-          Qubit q_trgt(args[1]);
-          rx_pauli[q_ctrl] = rx_pauli[q_ctrl] * rx_pauli[q_trgt];
-          rz_pauli[q_trgt] = rz_pauli[q_ctrl] * rz_pauli[q_trgt];
+          std::vector<unsigned> qbs;
+          for (const UnitID &arg : args) {
+            qbs.push_back(qubit_index.at(Qubit(arg)));
+          }
+          tab.apply_gate_at_end(type, qbs);
           break;
         }
         // Introduce a Pauli gadget
         case OpType::Rz: {
           Qubit q(args[0]);
           Expr angle = (op_ptr)->get_params()[0];
-          pauli_gadgets.push_back({rz_pauli[q], angle});
+          pauli_gadgets.push_back({tab.get_zpauli(q), angle});
           break;
         }
         case OpType::Rx: {
           Qubit q(args[0]);
           Expr angle = (op_ptr)->get_params()[0];
-          pauli_gadgets.push_back({rx_pauli[q], angle});
+          pauli_gadgets.push_back({tab.get_xpauli(q), angle});
           break;
         }
         case OpType::Measure:
@@ -152,20 +131,7 @@ Transform Transform::pairwise_pauli_gadgets(CXConfigType cx_config) {
       }
     }
     // Synthesise pairs of Pauli Gadgets
-    unsigned g = 0;
-    while (g + 1 < pauli_gadgets.size()) {
-      auto [pauli0, angle0] = pauli_gadgets[g];
-      auto [pauli1, angle1] = pauli_gadgets[g + 1];
-      append_pauli_gadget_pair(
-          gadget_circ, pauli0, angle0, pauli1, angle1, cx_config);
-      g += 2;
-    }
-    // As we synthesised Pauli gadgets 2 at a time, if there were an odd
-    // number, we will have one left over, so add that one on its own
-    if (g < pauli_gadgets.size()) {
-      auto [pauli, angle] = pauli_gadgets[g];
-      append_single_pauli_gadget(gadget_circ, pauli, angle, cx_config);
-    }
+    append_pauli_gadgets_pairwise(gadget_circ, pauli_gadgets, cx_config);
     // Stitch gadget circuit and Clifford circuit together
     circ = gadget_circ >> clifford_circ;
     circ.add_phase(t);
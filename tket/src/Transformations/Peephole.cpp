@@ -0,0 +1,317 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Peephole.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include "Gate/Commutation.hpp"
+#include "Gate/OpPtrFunctions.hpp"
+
+namespace tket {
+
+void PeepholeRewriter::revisit(const Vertex &v) {
+  // Vertices added by rules are indexed after all the others.
+  IndexMap::iterator it = im_.find(v);
+  if (it == im_.end()) it = im_.insert({v, im_.size()}).first;
+  revisit_.insert({it->second, v});
+}
+
+void PeepholeRewriter::revisit_predecessors(const Vertex &v) {
+  SmallVertexVec preds;
+  circ_.get_predecessors(v, preds);
+  for (const Vertex &pred : preds) revisit(pred);
+}
+
+void PeepholeRewriter::remove(const Vertex &v) {
+  revisit_predecessors(v);
+  bin_.push_back(v);
+  circ_.remove_vertex(
+      v, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::No);
+  changed_ = true;
+}
+
+void PeepholeRewriter::remove(const VertexList &vs) {
+  SmallVertexVec preds;
+  for (const Vertex &v : vs) {
+    circ_.get_predecessors(v, preds);
+    for (const Vertex &pred : preds) {
+      if (std::find(vs.begin(), vs.end(), pred) == vs.end()) revisit(pred);
+    }
+  }
+  bin_.insert(bin_.end(), vs.begin(), vs.end());
+  // detached from circuit but not removed from graph
+  circ_.remove_vertices(
+      vs, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::No);
+  changed_ = true;
+}
+
+void PeepholeRewriter::replace_op(const Vertex &v, const Op_ptr &op) {
+  revisit_predecessors(v);
+  revisit(v);
+  circ_.set_vertex_Op_ptr(v, op);
+  changed_ = true;
+}
+
+void PeepholeRewriter::move_before(
+    const Vertex &v, const Vertex &target, port_t port) {
+  revisit(target);
+  circ_.remove_vertex(
+      v, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::No);
+  Edge in_e = circ_.get_nth_in_edge(target, port);
+  circ_.rewire(v, {in_e}, {EdgeType::Quantum});
+  revisit(v);
+  revisit_predecessors(v);
+  changed_ = true;
+}
+
+PeepholeEngine::PeepholeEngine(const std::vector<PeepholeRule> &rules) {
+  for (const PeepholeRule &rule : rules) add_rule(rule);
+}
+
+void PeepholeEngine::add_rule(const PeepholeRule &rule) {
+  unsigned i = rules_.size();
+  rules_.push_back(rule);
+  if (rule.roots.empty()) {
+    any_root_.push_back(i);
+  } else {
+    for (OpType type : rule.roots) by_root_[type].push_back(i);
+  }
+}
+
+std::vector<unsigned> PeepholeEngine::rules_for(OpType type) const {
+  std::map<OpType, std::vector<unsigned>>::const_iterator found =
+      by_root_.find(type);
+  if (found == by_root_.end()) return any_root_;
+  std::vector<unsigned> indices;
+  std::merge(
+      any_root_.begin(), any_root_.end(), found->second.begin(),
+      found->second.end(), std::back_inserter(indices));
+  return indices;
+}
+
+bool PeepholeEngine::apply(Circuit &circ) const {
+  std::optional<VertexSet> region;
+  VertexSet touched;
+  return apply(circ, region, touched);
+}
+
+bool PeepholeEngine::apply(
+    Circuit &circ, std::optional<VertexSet> &region,
+    VertexSet &touched) const {
+  IndexMap im = circ.index_map();
+  std::set<IVertex> to_visit;
+  if (region) {
+    for (const Vertex &v : *region) to_visit.insert({im.at(v), v});
+  } else {
+    BGL_FORALL_VERTICES(v, circ.dag, DAG) { to_visit.insert({im.at(v), v}); }
+  }
+  PeepholeRewriter rewriter(circ, im);
+  // The rules to try for each type met so far
+  std::map<OpType, std::vector<unsigned>> rules_by_type;
+  while (!to_visit.empty()) {
+    for (const IVertex &p : to_visit) {
+      const Vertex &v = p.second;
+      // either a boundary vertex or one already removed
+      if (circ.n_out_edges(v) == 0 || circ.n_in_edges(v) == 0) continue;
+      OpType type = circ.get_OpType_from_Vertex(v);
+      std::map<OpType, std::vector<unsigned>>::iterator rules =
+          rules_by_type.find(type);
+      if (rules == rules_by_type.end()) {
+        rules = rules_by_type.insert({type, rules_for(type)}).first;
+      }
+      for (unsigned i : rules->second) {
+        if (rules_[i].rewrite(rewriter, v)) break;
+      }
+    }
+    to_visit = std::move(rewriter.revisit_);
+    rewriter.revisit_.clear();
+    for (const IVertex &p : to_visit) touched.insert(p.second);
+  }
+  for (const Vertex &v : rewriter.bin_) {
+    touched.erase(v);
+    if (region) region->erase(v);
+  }
+  circ.remove_vertices(
+      rewriter.bin_, Circuit::GraphRewiring::No, Circuit::VertexDeletion::Yes);
+  return rewriter.changed_;
+}
+
+namespace PeepholeRules {
+
+PeepholeRule remove_identities() {
+  return {"RemoveIdentities", {}, [](PeepholeRewriter &rw, const Vertex &v) {
+            Circuit &circ = rw.get_circ();
+            const Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
+            if (!op->get_desc().is_gate()) return false;
+            // remove 0 angle rotations from circuit
+            std::optional<double> a = op->is_identity();
+            if (a) {
+              rw.remove(v);
+              circ.add_phase(a.value());
+              return true;
+            } else if (op->get_type() == OpType::noop) {
+              rw.remove(v);
+              return true;
+            }
+            return false;
+          }};
+}
+
+PeepholeRule remove_before_measures() {
+  return {
+      "RemoveBeforeMeasures", {}, [](PeepholeRewriter &rw, const Vertex &v) {
+        Circuit &circ = rw.get_circ();
+        const Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
+        if (!op->get_desc().is_gate()) return false;
+        if (circ.n_out_edges_of_type(v, EdgeType::Classical) != 0) {
+          return false;
+        }
+        SmallVertexVec kids;
+        circ.get_successors(v, kids);
+        for (port_t port = 0; port < kids.size(); port++) {
+          if (circ.get_OpType_from_Vertex(kids[port]) != OpType::Measure ||
+              !op_commutes_with_basis(*op, Pauli::Z, port)) {
+            return false;
+          }
+        }
+        rw.remove(v);
+        return true;
+      }};
+}
+
+// If v and its successor have each other and only each other as neighbours,
+// with matching ports and no Boolean inputs to v, return the successor.
+static std::optional<Vertex> exclusive_successor(
+    const Circuit &circ, const Vertex &v) {
+  SmallVertexVec kids;
+  circ.get_successors(v, kids);
+  if (kids.size() != 1) return std::nullopt;
+  Vertex b = kids[0];
+  SmallVertexVec preds;
+  circ.get_predecessors(b, preds);
+  if (preds.size() != 1) return std::nullopt;
+  SmallEdgeVec b_ins;
+  circ.get_in_edges(b, b_ins);
+  for (const Edge &in : b_ins) {
+    if (circ.get_source_port(in) != circ.get_target_port(in)) {
+      return std::nullopt;
+    }
+  }
+  if (circ.n_in_edges_of_type(v, EdgeType::Boolean) != 0) return std::nullopt;
+  if (circ.get_Op_ptr_from_Vertex(b)->get_desc().is_oneway()) {
+    return std::nullopt;
+  }
+  return b;
+}
+
+PeepholeRule cancel_inverses() {
+  return {"CancelInverses", {}, [](PeepholeRewriter &rw, const Vertex &v) {
+            Circuit &circ = rw.get_circ();
+            const Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
+            if (!op->get_desc().is_gate()) return false;
+            std::optional<Vertex> b = exclusive_successor(circ, v);
+            if (!b) return false;
+            // if A = B.dagger(), AB = I
+            // This cannot detect matches between rotation gates, which are
+            // covered by merge_rotations.
+            if (!(*circ.get_Op_ptr_from_Vertex(*b)->dagger() == *op)) {
+              return false;
+            }
+            rw.remove(VertexList{v, *b});
+            return true;
+          }};
+}
+
+PeepholeRule merge_rotations() {
+  return {"MergeRotations", {}, [](PeepholeRewriter &rw, const Vertex &v) {
+            Circuit &circ = rw.get_circ();
+            const Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
+            const OpDesc desc = op->get_desc();
+            if (!desc.is_gate() || !desc.is_rotation()) return false;
+            std::optional<Vertex> b = exclusive_successor(circ, v);
+            if (!b) return false;
+            const Op_ptr b_op = circ.get_Op_ptr_from_Vertex(*b);
+            if (b_op->get_type() != desc.type()) return false;
+            // combine two rotation gates together, then if the combined
+            // operation is the identity up to phase, remove from circuit
+            Expr expr1 = op->get_params()[0];
+            Expr expr2 = b_op->get_params()[0];
+            unsigned n_qubits = circ.n_in_edges(*b);
+            rw.remove(*b);
+            Op_ptr op_new =
+                get_op_ptr(desc.type(), std::vector<Expr>{expr1 + expr2},
+                           n_qubits);
+            std::optional<double> a = op_new->is_identity();
+            if (a) {
+              rw.remove(v);
+              circ.add_phase(a.value());
+            } else {
+              rw.replace_op(v, op_new);
+            }
+            return true;
+          }};
+}
+
+std::vector<PeepholeRule> redundancy_rules() {
+  return {
+      remove_identities(), remove_before_measures(), cancel_inverses(),
+      merge_rotations()};
+}
+
+// Move a single-qubit gate v before the vertex feeding it, if that vertex is
+// a CX and v comes from the given port of it.
+static bool commute_back_through_cx(
+    PeepholeRewriter &rw, const Vertex &v, port_t cx_port) {
+  Circuit &circ = rw.get_circ();
+  if (circ.n_in_edges(v) != 1) return false;
+  Edge in = circ.get_nth_in_edge(v, 0);
+  Vertex cx = circ.source(in);
+  if (circ.get_OpType_from_Vertex(cx) != OpType::CX ||
+      circ.get_source_port(in) != cx_port) {
+    return false;
+  }
+  rw.move_before(v, cx, cx_port);
+  return true;
+}
+
+PeepholeRule commute_z_through_cx_control() {
+  return {
+      "CommuteZThroughCXControl",
+      {OpType::Z},
+      [](PeepholeRewriter &rw, const Vertex &v) {
+        return commute_back_through_cx(rw, v, 0);
+      }};
+}
+
+PeepholeRule commute_x_through_cx_target() {
+  return {
+      "CommuteXThroughCXTarget",
+      {OpType::X},
+      [](PeepholeRewriter &rw, const Vertex &v) {
+        return commute_back_through_cx(rw, v, 1);
+      }};
+}
+
+std::vector<PeepholeRule> clifford_rules() {
+  std::vector<PeepholeRule> rules = redundancy_rules();
+  rules.push_back(commute_z_through_cx_control());
+  rules.push_back(commute_x_through_cx_target());
+  return rules;
+}
+
+}  // namespace PeepholeRules
+
+}  // namespace tket
@@ -0,0 +1,168 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Local rewrite rules matched together in one worklist traversal
+ *
+ * A \ref PeepholeRule inspects the neighbourhood of a root vertex and
+ * rewrites it through a \ref PeepholeRewriter, which records the vertices
+ * next to the change. The \ref PeepholeEngine visits every vertex, tries the
+ * rules indexed by its OpType in order until one applies, and then revisits
+ * only the recorded vertices, until no rule applies anywhere.
+ */
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Circuit/Circuit.hpp"
+
+namespace tket {
+
+/** Interface through which peephole rules change a circuit */
+class PeepholeRewriter {
+ public:
+  Circuit &get_circ() { return circ_; }
+
+  /** Visit the vertex again in the next round */
+  void revisit(const Vertex &v);
+
+  /** Visit the predecessors of the vertex again in the next round */
+  void revisit_predecessors(const Vertex &v);
+
+  /**
+   * Remove a vertex, rewiring its neighbours together. Its predecessors are
+   * revisited.
+   */
+  void remove(const Vertex &v);
+
+  /**
+   * Remove a set of vertices, rewiring the neighbours of the set together.
+   * Their predecessors outside the set are revisited.
+   */
+  void remove(const VertexList &vs);
+
+  /** Replace the operation of a vertex, revisiting it and its predecessors */
+  void replace_op(const Vertex &v, const Op_ptr &op);
+
+  /**
+   * Move a single-qubit vertex onto an in-edge of another vertex. Both, and
+   * the new predecessors of the moved vertex, are revisited.
+   *
+   * @param v single-qubit vertex to move
+   * @param target vertex before which to place it
+   * @param port in-port of \p target on which to place it
+   */
+  void move_before(const Vertex &v, const Vertex &target, port_t port);
+
+ private:
+  PeepholeRewriter(Circuit &circ, IndexMap &im) : circ_(circ), im_(im) {}
+
+  Circuit &circ_;
+  IndexMap &im_;
+  VertexList bin_;
+  std::set<IVertex> revisit_;
+  bool changed_ = false;
+
+  friend class PeepholeEngine;
+};
+
+/** A local rewrite of the circuit around a root vertex */
+struct PeepholeRule {
+  /** Name, for debugging */
+  std::string name;
+  /** Operation types of the root vertices to try, or empty for all */
+  OpTypeSet roots;
+  /**
+   * Apply the rule at a vertex if it matches. Return true iff the circuit
+   * was changed, in which case all changes must go through the rewriter.
+   */
+  std::function<bool(PeepholeRewriter &, const Vertex &)> rewrite;
+};
+
+/** Applies a list of peephole rules until none matches */
+class PeepholeEngine {
+ public:
+  explicit PeepholeEngine(const std::vector<PeepholeRule> &rules = {});
+
+  /** Add a rule, tried after those already added */
+  void add_rule(const PeepholeRule &rule);
+
+  /** Apply the rules to the whole circuit. Return true iff it changed */
+  bool apply(Circuit &circ) const;
+
+  /**
+   * Apply the rules starting from the vertices of a region, in the form of
+   * \ref Transform::RegionTransformation.
+   */
+  bool apply(
+      Circuit &circ, std::optional<VertexSet> &region,
+      VertexSet &touched) const;
+
+ private:
+  std::vector<PeepholeRule> rules_;
+  /** Indices of the rules with a given root type, in order */
+  std::map<OpType, std::vector<unsigned>> by_root_;
+  /** Indices of the rules applying to every root type */
+  std::vector<unsigned> any_root_;
+
+  /** The rules to try at a vertex of the given type, in order */
+  std::vector<unsigned> rules_for(OpType type) const;
+};
+
+namespace PeepholeRules {
+
+/** Remove gates equal to the identity up to phase, and noops */
+PeepholeRule remove_identities();
+
+/**
+ * Remove unconditional gates commuting with Z and followed only by Z-basis
+ * measurements on all their qubits
+ */
+PeepholeRule remove_before_measures();
+
+/** Remove a gate immediately followed by its inverse */
+PeepholeRule cancel_inverses();
+
+/** Merge adjacent rotations of the same type */
+PeepholeRule merge_rotations();
+
+/**
+ * The rules of \ref Transform::remove_redundancies, in order:
+ * \ref remove_identities, \ref remove_before_measures,
+ * \ref cancel_inverses and \ref merge_rotations
+ */
+std::vector<PeepholeRule> redundancy_rules();
+
+/** Move a Z gate on the control of a CX to before the CX */
+PeepholeRule commute_z_through_cx_control();
+
+/** Move an X gate on the target of a CX to before the CX */
+PeepholeRule commute_x_through_cx_target();
+
+/**
+ * The rules of \ref redundancy_rules followed by
+ * \ref commute_z_through_cx_control and \ref commute_x_through_cx_target
+ */
+std::vector<PeepholeRule> clifford_rules();
+
+}  // namespace PeepholeRules
+
+}  // namespace tket
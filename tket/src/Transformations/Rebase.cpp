@@ -12,20 +12,47 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cmath>
+
 #include "Circuit/CircPool.hpp"
 #include "Circuit/CircUtils.hpp"
 #include "Gate/GatePtr.hpp"
 #include "Replacement.hpp"
 #include "Transform.hpp"
+#include "Utils/Assert.hpp"
 #include "Utils/TketLog.hpp"
 
 namespace tket {
 
+typedef std::function<Circuit(const Expr&, const Expr&, const Expr&)>
+    tk1_replacement_t;
+typedef std::function<double(const Circuit&)> circuit_cost_t;
+
 static bool standard_rebase(
     Circuit& circ, const OpTypeSet& multiqs, const Circuit& cx_replacement,
     const OpTypeSet& singleqs,
-    const std::function<Circuit(const Expr&, const Expr&, const Expr&)>&
-        tk1_replacement);
+    const std::vector<tk1_replacement_t>& tk1_replacements,
+    const circuit_cost_t& cost);
+
+// The cheapest of some candidate circuits. Ties go to the one with fewer
+// gates, then to the earliest. The cost is not computed if there is only one
+// candidate.
+static const Circuit& cheapest(
+    const std::vector<Circuit>& candidates, const circuit_cost_t& cost) {
+  TKET_ASSERT(!candidates.empty());
+  const Circuit* best = &candidates[0];
+  if (candidates.size() == 1) return *best;
+  double best_cost = cost(*best);
+  for (unsigned i = 1; i < candidates.size(); i++) {
+    double c = cost(candidates[i]);
+    if (c < best_cost - EPS ||
+        (c < best_cost + EPS && candidates[i].n_gates() < best->n_gates())) {
+      best = &candidates[i];
+      best_cost = c;
+    }
+  }
+  return *best;
+}
 
 Transform Transform::rebase_factory(
     const OpTypeSet& multiqs, const Circuit& cx_replacement,
@@ -34,17 +61,117 @@ Transform Transform::rebase_factory(
         tk1_replacement) {
   return Transform([=](Circuit& circ) {
     return standard_rebase(
-        circ, multiqs, cx_replacement, singleqs, tk1_replacement);
+        circ, multiqs, cx_replacement, singleqs, {tk1_replacement}, {});
   });
 }
 
+Transform Transform::rebase_factory(
+    const OpTypeSet& multiqs, const std::vector<Circuit>& cx_replacements,
+    const OpTypeSet& singleqs,
+    const std::vector<
+        std::function<Circuit(const Expr&, const Expr&, const Expr&)>>&
+        tk1_replacements,
+    const std::function<double(const Circuit&)>& cost) {
+  if (cx_replacements.empty() || tk1_replacements.empty()) {
+    throw std::invalid_argument("Rebase needs at least one candidate of each");
+  }
+  Circuit cx_replacement = cheapest(cx_replacements, cost);
+  return Transform([=](Circuit& circ) {
+    return standard_rebase(
+        circ, multiqs, cx_replacement, singleqs, tk1_replacements, cost);
+  });
+}
+
+std::function<double(const Circuit&)> Transform::rebase_error_cost(
+    const DeviceCharacterisation& characterisation) {
+  // The rebase templates already cache the choice per distinct operation, so
+  // this is only evaluated a handful of times per circuit.
+  return [characterisation](const Circuit& circ) {
+    double total = 0.;
+    for (const Command& com : circ) {
+      gate_error_t err = characterisation.get_average_error(
+          com.get_op_ptr()->get_type(), com.get_qubits().size());
+      total -= std::log1p(-std::min(err, 1. - EPS));
+    }
+    return total;
+  };
+}
+
+namespace {
+
+/**
+ * Replacement for one operation, built once per distinct operation in a
+ * rebase and then reused for every vertex holding it.
+ */
+struct RebaseTemplate {
+  Circuit replacement;
+  /** Phase added to the circuit besides that of the replacement */
+  Expr phase;
+  /**
+   * The gate of the replacement, if it consists of a single gate acting on
+   * the qubits in order; the vertex is then rewritten in place.
+   */
+  Op_ptr single_op;
+
+  RebaseTemplate(const Circuit& repl, const Expr& ph)
+      : replacement(repl), phase(ph), single_op() {
+    if (replacement.n_gates() != 1 || replacement.n_bits() != 0) return;
+    Command com = *replacement.begin();
+    unit_vector_t args = com.get_args();
+    for (unsigned i = 0; i < args.size(); ++i) {
+      if (args[i] != Qubit(i)) return;
+    }
+    single_op = com.get_op_ptr();
+  }
+};
+
+// Operations (without any condition) mapped to their templates. Keys are
+// shared pointers, so that an operation cannot be freed and another
+// allocated at the same address while the map exists.
+typedef std::map<Op_ptr, RebaseTemplate> template_map_t;
+
+}  // namespace
+
+// Replace the operation at v by its template. Return true iff v is to be
+// removed from the circuit.
+static bool apply_template(
+    Circuit& circ, const Vertex& v, const RebaseTemplate& tmpl) {
+  Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
+  bool conditional = op->get_type() == OpType::Conditional;
+  circ.add_phase(tmpl.phase);
+  // Substitution drops the vertex's opgroup, so rewrite in place only when
+  // there is none.
+  if (tmpl.single_op && !circ.get_opgroup_from_Vertex(v)) {
+    if (conditional) {
+      const Conditional& cond = static_cast<const Conditional&>(*op);
+      circ.set_vertex_Op_ptr(
+          v, std::make_shared<Conditional>(
+                 tmpl.single_op, cond.get_width(), cond.get_value()));
+    } else {
+      circ.set_vertex_Op_ptr(v, tmpl.single_op);
+    }
+    circ.add_phase(tmpl.replacement.get_phase());
+    return false;
+  }
+  if (conditional) {
+    circ.substitute_conditional(
+        tmpl.replacement, v, Circuit::VertexDeletion::No);
+  } else {
+    circ.substitute(tmpl.replacement, v, Circuit::VertexDeletion::No);
+  }
+  return true;
+}
+
 static bool standard_rebase(
     Circuit& circ, const OpTypeSet& multiqs, const Circuit& cx_replacement,
     const OpTypeSet& singleqs,
-    const std::function<Circuit(const Expr&, const Expr&, const Expr&)>&
-        tk1_replacement) {
+    const std::vector<tk1_replacement_t>& tk1_replacements,
+    const circuit_cost_t& cost) {
   bool success = false;
   VertexList bin;
+  // Large circuits repeat the same few operations, so each replacement is
+  // built once and then reused, in place where it is a single gate.
+  template_map_t multiq_templates;
   BGL_FORALL_VERTICES(v, circ.dag, DAG) {
     Op_ptr op = circ.get_Op_ptr_from_Vertex(v);
     unsigned n_qubits = circ.n_in_edges_of_type(v, EdgeType::Quantum);
@@ -59,19 +186,20 @@ static bool standard_rebase(
         type == OpType::Barrier)
       continue;
     // need to convert
-    Circuit replacement = CX_circ_from_multiq(op);
-    if (conditional) {
-      circ.substitute_conditional(replacement, v, Circuit::VertexDeletion::No);
-    } else {
-      circ.substitute(replacement, v, Circuit::VertexDeletion::No);
+    template_map_t::iterator found = multiq_templates.find(op);
+    if (found == multiq_templates.end()) {
+      found = multiq_templates
+                  .insert({op, RebaseTemplate(CX_circ_from_multiq(op), 0)})
+                  .first;
     }
-    bin.push_back(v);
+    if (apply_template(circ, v, found->second)) bin.push_back(v);
     success = true;
   }
   if (multiqs.find(OpType::CX) == multiqs.end()) {
     const Op_ptr cx_op = get_op_ptr(OpType::CX);
     success = circ.substitute_all(cx_replacement, cx_op) | success;
   }
+  template_map_t singleq_templates;
   BGL_FORALL_VERTICES(v, circ.dag, DAG) {
     if (circ.n_in_edges_of_type(v, EdgeType::Quantum) != 1 ||
         circ.n_in_edges_of_type(v, EdgeType::Quantum) != 1)
@@ -87,16 +215,20 @@ static bool standard_rebase(
         singleqs.find(type) != singleqs.end())
       continue;
     // need to convert
-    std::vector<Expr> tk1_angles = as_gate_ptr(op)->get_tk1_angles();
-    Circuit replacement =
-        tk1_replacement(tk1_angles[0], tk1_angles[1], tk1_angles[2]);
-    if (conditional) {
-      circ.substitute_conditional(replacement, v, Circuit::VertexDeletion::No);
-    } else {
-      circ.substitute(replacement, v, Circuit::VertexDeletion::No);
+    template_map_t::iterator found = singleq_templates.find(op);
+    if (found == singleq_templates.end()) {
+      std::vector<Expr> tk1_angles = as_gate_ptr(op)->get_tk1_angles();
+      std::vector<Circuit> candidates;
+      for (const tk1_replacement_t& tk1_replacement : tk1_replacements) {
+        candidates.push_back(
+            tk1_replacement(tk1_angles[0], tk1_angles[1], tk1_angles[2]));
+      }
+      const Circuit& replacement = cheapest(candidates, cost);
+      found = singleq_templates
+                  .insert({op, RebaseTemplate(replacement, tk1_angles[3])})
+                  .first;
     }
-    circ.add_phase(tk1_angles[3]);
-    bin.push_back(v);
+    if (apply_template(circ, v, found->second)) bin.push_back(v);
     success = true;
   }
   circ.remove_vertices(
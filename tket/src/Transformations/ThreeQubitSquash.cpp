@@ -18,8 +18,10 @@
 #include <iterator>
 #include <memory>
 #include <numeric>
+#include <optional>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "Circuit/CircUtils.hpp"
 #include "Circuit/Circuit.hpp"
@@ -30,6 +32,7 @@
 #include "Transform.hpp"
 #include "Utils/Assert.hpp"
 #include "Utils/GraphHeaders.hpp"
+#include "Utils/Parallel.hpp"
 
 namespace tket {
 
@@ -115,13 +118,33 @@ static Circuit candidate_sub(const Circuit &circ) {
   }
 }
 
+// A closed interaction whose substitution has been deferred. The boundary
+// edges are recorded by their targets, which remain valid when neighbouring
+// interactions are substituted first.
+struct DeferredInteraction {
+  std::vector<std::pair<Vertex, port_t>> in_vertex_ports;
+  std::vector<std::pair<Vertex, port_t>> out_vertex_ports;
+  VertexSet vertices;
+  Circuit subc;
+};
+
 // Helper class representing a system of disjoint interactions, each with at
 // most three qubits. The interactions are represented by integer labels.
+//
+// If `deferred`, closing an interaction does not squash it but records it, and
+// all the recorded interactions are squashed by `squash_deferred`. The
+// interactions closed are the same either way, since they never include
+// vertices that a substitution replaces.
 class QISystem {
  public:
   // Construct an empty system.
-  explicit QISystem(Circuit &circ)
-      : circ_(circ), bin_(), interactions_(), idx_(0) {}
+  explicit QISystem(Circuit &circ, bool deferred = false)
+      : circ_(circ),
+        bin_(),
+        interactions_(),
+        idx_(0),
+        deferred_(deferred),
+        closed_() {}
 
   // Add a new interaction to the system consisting of a single edge, and
   // return its index.
@@ -195,6 +218,19 @@ class QISystem {
       case 3: {
         Subcircuit sub = I->subcircuit();
         Circuit subc = circ_.subcircuit(sub);
+        if (deferred_) {
+          DeferredInteraction d{{}, {}, sub.verts, std::move(subc)};
+          for (const Edge &e : sub.q_in_hole) {
+            d.in_vertex_ports.push_back(
+                {circ_.target(e), circ_.get_target_port(e)});
+          }
+          for (const Edge &e : outs) {
+            d.out_vertex_ports.push_back(
+                {circ_.target(e), circ_.get_target_port(e)});
+          }
+          closed_.push_back(std::move(d));
+          break;
+        }
         Circuit replacement = candidate_sub(subc);
         if (replacement.count_gates(OpType::CX) <
             subc.count_gates(OpType::CX)) {
@@ -274,6 +310,41 @@ class QISystem {
     return changed;
   }
 
+  // Squash all the deferred interactions, computing the candidate
+  // substitutions in parallel. Return true iff any substitution is made.
+  bool squash_deferred() {
+    std::vector<std::optional<Circuit>> replacements(closed_.size());
+    parallel_for(0, closed_.size(), 1, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; i++) {
+        Circuit replacement = candidate_sub(closed_[i].subc);
+        if (replacement.count_gates(OpType::CX) <
+            closed_[i].subc.count_gates(OpType::CX)) {
+          replacements[i] = std::move(replacement);
+        }
+      }
+    });
+    // Interactions are closed in topological order, so substituting them in
+    // the same order leaves the recorded targets of later ones untouched.
+    bool changed = false;
+    for (std::size_t i = 0; i < closed_.size(); i++) {
+      if (!replacements[i]) continue;
+      const DeferredInteraction &d = closed_[i];
+      Subcircuit sub;
+      for (const auto &[v, p] : d.in_vertex_ports) {
+        sub.q_in_hole.push_back(circ_.get_nth_in_edge(v, p));
+      }
+      for (const auto &[v, p] : d.out_vertex_ports) {
+        sub.q_out_hole.push_back(circ_.get_nth_in_edge(v, p));
+      }
+      sub.verts = d.vertices;
+      bin_.insert(bin_.end(), d.vertices.begin(), d.vertices.end());
+      circ_.substitute(*replacements[i], sub, Circuit::VertexDeletion::No);
+      changed = true;
+    }
+    closed_.clear();
+    return changed;
+  }
+
   // Delete all vertices marked for deletion.
   void destroy_bin() {
     circ_.remove_vertices(
@@ -285,14 +356,16 @@ class QISystem {
   VertexList bin_;
   std::map<int, iptr> interactions_;
   int idx_;
+  bool deferred_;
+  std::vector<DeferredInteraction> closed_;
 };
 
-Transform Transform::three_qubit_squash() {
-  return Transform([](Circuit &circ) {
+Transform Transform::three_qubit_squash(bool parallel) {
+  return Transform([parallel](Circuit &circ) {
     bool changed = false;
 
     // Step through the vertices in topological order.
-    QISystem Is(circ);  // set of "live" interactions
+    QISystem Is(circ, parallel);  // set of "live" interactions
     for (const Vertex &v : circ.vertices_in_order()) {
       const EdgeVec v_q_ins = circ.get_in_edges_of_type(v, EdgeType::Quantum);
       const EdgeVec v_q_outs = circ.get_out_edges_of_type(v, EdgeType::Quantum);
@@ -355,6 +428,9 @@ Transform Transform::three_qubit_squash() {
     // Close all remaining interactions.
     changed |= Is.close_all_interactions();
 
+    // Squash the interactions, if this was deferred.
+    if (parallel) changed |= Is.squash_deferred();
+
     // Delete removed vertices.
     Is.destroy_bin();
 
@@ -16,6 +16,7 @@
 
 #include <functional>
 #include <map>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -23,6 +24,7 @@
 #include "Architecture/Architecture.hpp"
 #include "Characterisation/DeviceCharacterisation.hpp"
 #include "Circuit/Circuit.hpp"
+#include "Peephole.hpp"
 #include "Utils/Json.hpp"
 #include "Utils/MatrixAnalysis.hpp"
 #include "Utils/PauliStrings.hpp"
@@ -55,7 +57,27 @@ class Transform {
   Transformation apply;  // this would ideally be `const`, but that deletes the
                          // copy assignment operator for Transform.
 
+  /**
+   * Form of a transformation that can be restricted to a region.
+   *
+   * The region is the set of vertices to examine, or std::nullopt for the
+   * whole circuit. The transformation returns true iff it made some change.
+   * It adds to `touched` the vertices next to its changes, where a subsequent
+   * application might find new matches. It erases every vertex it deletes
+   * from both the region and `touched`.
+   */
+  typedef std::function<bool(Circuit&, std::optional<VertexSet>&, VertexSet&)>
+      RegionTransformation;
+
+  /**
+   * The region form of `apply`, if the transformation supports it.
+   * `repeat` uses it to revisit only the vertices touched by the previous
+   * iteration, and `sequence` preserves it when every component has one.
+   */
+  std::optional<RegionTransformation> apply_in_region;
+
   explicit Transform(const Transformation& trans) : apply(trans) {}
+  explicit Transform(const RegionTransformation& trans);
 
   static const Transform id;  // identity Transform (does nothing to Circuit)
 
@@ -69,7 +91,9 @@ class Transform {
   friend Transform operator>>(const Transform& lhs, const Transform& rhs);
   static Transform sequence(std::vector<Transform>& tvec);
 
-  // repeats a transform until it makes no changes (returns false)
+  // repeats a transform until it makes no changes (returns false); if the
+  // transform has a region form, only the first iteration examines the whole
+  // circuit
   static Transform repeat(const Transform& trans);
 
   // repeats a transform and stops when the metric stops decreasing
@@ -214,10 +238,21 @@ class Transform {
   // returns CX, H, T, Tdg + any previous gates
   static Transform decomp_CCX();
 
-  // does not use ancillae
+  // does not use ancillae unless use_ancillas is set, in which case
+  // QControlBoxes are decomposed first and CnXs borrow the qubits of the
+  // circuit they do not act on (see decomp_CnX_with_ancillas)
   // Expects: any CnRys + CnXs + any other gates
   // returns Ry, CX, H, T, Tdg + any previous gates
-  static Transform decomp_arbitrary_controlled_gates();
+  static Transform decomp_arbitrary_controlled_gates(bool use_ancillas = false);
+
+  // decomposes CnXs with at least 3 controls using the other qubits of the
+  // circuit as ancillae: with n-2 qubits known to be |0> (created or reset)
+  // and idle, a log-depth tree of 2n-3 CCXs; otherwise with n-2 idle qubits in
+  // any state, a ladder of 4(n-2) CCXs; otherwise with one idle qubit,
+  // corollary 7.4 of quant-ph/9503016; otherwise cnx_normal_decomp
+  // Expects: CnXs + any other gates
+  // returns CCX, CX, H, T, Tdg + any previous gates
+  static Transform decomp_CnX_with_ancillas();
 
   /**
    * Replaces all boxes by their decomposition using Box::to_circuit
@@ -247,6 +282,44 @@ class Transform {
       const std::function<Circuit(const Expr&, const Expr&, const Expr&)>&
           tk1_replacement);
 
+  /**
+   * Rebase choosing the cheapest of several candidate replacements.
+   *
+   * As \ref rebase_factory with a single candidate, but CX is replaced by the
+   * cheapest of \p cx_replacements, and each single-qubit operation by the
+   * cheapest of the circuits that \p tk1_replacements give for its angles.
+   * Ties go to the candidate with fewer gates, then to the earliest. The
+   * CX replacement is chosen once, and single-qubit replacements once for
+   * each distinct operation in the circuit.
+   *
+   * @param multiqs allowed multi-qubit gates
+   * @param cx_replacements candidate circuits implementing CX
+   * @param singleqs allowed single-qubit gates
+   * @param tk1_replacements candidate functions replacing a tk1 gate
+   * @param cost cost of a candidate circuit, e.g. \ref rebase_error_cost
+   */
+  static Transform rebase_factory(
+      const OpTypeSet& multiqs, const std::vector<Circuit>& cx_replacements,
+      const OpTypeSet& singleqs,
+      const std::vector<
+          std::function<Circuit(const Expr&, const Expr&, const Expr&)>>&
+          tk1_replacements,
+      const std::function<double(const Circuit&)>& cost);
+
+  /**
+   * Cost of a circuit under a device noise model, for choosing between
+   * rebase candidates.
+   *
+   * The cost of a circuit is the sum of -log(1 - e) over its gates, where e
+   * is the error of the gate's OpType averaged over the device (see
+   * \ref DeviceCharacterisation::get_average_error), so that the cheapest
+   * circuit has the highest estimated fidelity.
+   *
+   * @param characterisation device errors
+   */
+  static std::function<double(const Circuit&)> rebase_error_cost(
+      const DeviceCharacterisation& characterisation);
+
   // Multiqs: CX
   // Singleqs: tk1
   static Transform rebase_tket();
@@ -295,6 +368,20 @@ class Transform {
    */
   static Transform synthesise_tket();
 
+  /**
+   * Synthesise a circuit consisting of CX and TK1 gates only, in a single
+   * worklist sweep.
+   *
+   * Redundancy removal, commutation through multiqubit gates and
+   * single-qubit squashing are repeated together, each revisiting only the
+   * vertices touched by the previous changes, until none applies. This
+   * reaches the fixed point that \ref synthesise_tket approaches by
+   * alternating whole-circuit passes, without copying or re-traversing the
+   * circuit. Unlike \ref synthesise_tket, it does not re-squash single-qubit
+   * chains that are already a lone TK1 gate, so their parameters are kept.
+   */
+  static Transform synthesise_tket_fused();
+
   // converts a circuit into the HQS primitives (Rz, PhasedX, ZZMax) whilst
   // optimising Expects: CX and any single-qubit gates Produces: ZZMax, PhasedX,
   // Rz
@@ -413,6 +500,23 @@ class Transform {
   // same gate set
   static Transform remove_redundancies();
 
+  /**
+   * Apply peephole rules until none matches, revisiting only the
+   * neighbourhoods of rewrites. See \ref PeepholeEngine.
+   *
+   * Expects: any gates accepted by the rules
+   */
+  static Transform peephole(const std::vector<PeepholeRule>& rules);
+
+  /**
+   * \ref remove_redundancies together with commutation of Z gates through
+   * CX controls and X gates through CX targets, so that for example
+   * Z(0) CX(0,1) Z(0) reduces to CX(0,1).
+   *
+   * Expects: Any gates Produces: The same gate set
+   */
+  static Transform clifford_peephole();
+
   /**
    * general u_squash by converting any chains of p, q gates (p, q in
    * {Rx,Ry,Rz}) to triples -p-q-p- or -q-p-q-
@@ -438,6 +542,16 @@ class Transform {
    */
   static Transform squash_1qb_to_tk1();
 
+  /**
+   * Squash each chain of single-qubit gates to at most one TK1 gate.
+   *
+   * Chains are squashed as by \ref squash_1qb_to_tk1, except that chains
+   * consisting of a single TK1 gate are left unchanged. Unlike
+   * \ref squash_1qb_to_tk1, this has a region form, which squashes the
+   * chains containing or next to the vertices of the region.
+   */
+  static Transform squash_1qb_chains_to_tk1();
+
   // identifies single-qubit chains and squashes them in the target gate set
   // Expects: any gates
   // Produces: singleqs and any multi-qubit gates
@@ -488,9 +602,13 @@ class Transform {
    * may perform a combination of 2-qubit (KAK) and 3-qubit decompositions of
    * subcircuits, but only does so if this reduces the CX count.
    *
+   * @param parallel whether to collect all the candidate subcircuits first
+   *   and synthesise them in parallel (see \ref parallel_for); the result is
+   *   the same either way
+   *
    * @return Transform implementing the squash
    */
-  static Transform three_qubit_squash();
+  static Transform three_qubit_squash(bool parallel = false);
 
   ////////////////////////
   // Contextual Reduction//
@@ -581,6 +699,12 @@ class Transform {
   };
 
   static Circuit cnx_normal_decomp(unsigned n);
+  // `n` >= 3 controls on qubits 0..n-1, target n and n-2 ancillae n+1..2n-2
+  // which must start in |0> and are returned to it; depth is logarithmic in n
+  static Circuit cnx_clean_ancilla_decomp(unsigned n);
+  // as cnx_clean_ancilla_decomp, but the ancillae may be in any state and are
+  // returned to it; depth is linear in n
+  static Circuit cnx_dirty_ancilla_decomp(unsigned n);
   static Circuit decomposed_CnRy(const Op_ptr op, unsigned arity);
   static Circuit incrementer_borrow_n_qubits(unsigned n);
   static Circuit incrementer_borrow_1_qubit(unsigned n);
@@ -0,0 +1,98 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BinaryMatrix.hpp"
+
+#include <algorithm>
+
+namespace tket {
+
+BinaryMatrix::BinaryMatrix(unsigned rows, unsigned cols)
+    : rows_(rows),
+      cols_(cols),
+      words_per_row_((cols + 63) / 64),
+      words_(rows * words_per_row_, 0) {}
+
+BinaryMatrix::BinaryMatrix(const MatrixXb &m)
+    : BinaryMatrix(m.rows(), m.cols()) {
+  for (unsigned r = 0; r < rows_; ++r) {
+    std::uint64_t *row = row_ptr(r);
+    for (unsigned c = 0; c < cols_; ++c) {
+      if (m(r, c)) row[c / 64] |= std::uint64_t{1} << (c % 64);
+    }
+  }
+}
+
+MatrixXb BinaryMatrix::to_MatrixXb() const {
+  MatrixXb m(rows_, cols_);
+  for (unsigned r = 0; r < rows_; ++r) {
+    for (unsigned c = 0; c < cols_; ++c) m(r, c) = get(r, c);
+  }
+  return m;
+}
+
+void BinaryMatrix::set(unsigned r, unsigned c, bool value) {
+  std::uint64_t mask = std::uint64_t{1} << (c % 64);
+  std::uint64_t &word = row_ptr(r)[c / 64];
+  if (value) {
+    word |= mask;
+  } else {
+    word &= ~mask;
+  }
+}
+
+void BinaryMatrix::add_row(unsigned source, unsigned target) {
+  const std::uint64_t *s = row_ptr(source);
+  std::uint64_t *t = row_ptr(target);
+  for (unsigned w = 0; w < words_per_row_; ++w) t[w] ^= s[w];
+}
+
+bool BinaryMatrix::is_zero(unsigned r, unsigned c0, unsigned c1) const {
+  const std::uint64_t *row = row_ptr(r);
+  while (c0 < c1) {
+    unsigned offset = c0 % 64;
+    unsigned n = std::min(64 - offset, c1 - c0);
+    std::uint64_t mask = (n == 64) ? ~std::uint64_t{0}
+                                   : ((std::uint64_t{1} << n) - 1) << offset;
+    if (row[c0 / 64] & mask) return false;
+    c0 += n;
+  }
+  return true;
+}
+
+void BinaryMatrix::get_segment(
+    unsigned r, unsigned c0, unsigned c1,
+    std::vector<std::uint64_t> &words) const {
+  const std::uint64_t *row = row_ptr(r);
+  unsigned width = c1 - c0;
+  words.assign((width + 63) / 64, 0);
+  for (unsigned w = 0; w < words.size(); ++w) {
+    unsigned c = c0 + 64 * w;
+    unsigned offset = c % 64;
+    std::uint64_t word = row[c / 64] >> offset;
+    if (offset != 0 && c / 64 + 1 < words_per_row_) {
+      word |= row[c / 64 + 1] << (64 - offset);
+    }
+    unsigned n = std::min(64u, c1 - c);
+    if (n < 64) word &= (std::uint64_t{1} << n) - 1;
+    words[w] = word;
+  }
+}
+
+bool BinaryMatrix::operator==(const BinaryMatrix &other) const {
+  return rows_ == other.rows_ && cols_ == other.cols_ &&
+         words_ == other.words_;
+}
+
+}  // namespace tket
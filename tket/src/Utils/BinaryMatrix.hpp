@@ -0,0 +1,83 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Utils/MatrixAnalysis.hpp"
+
+namespace tket {
+
+/**
+ * A matrix over GF(2), stored row-major with 64 entries per word.
+ *
+ * Adding one row to another is a XOR over the words of the rows, so
+ * elimination on this type costs about 1/64 of the same on \ref MatrixXb.
+ * Convert to and from \ref MatrixXb at the boundaries of such algorithms.
+ */
+class BinaryMatrix {
+ public:
+  /** Zero matrix */
+  BinaryMatrix(unsigned rows, unsigned cols);
+
+  /** Pack a MatrixXb */
+  explicit BinaryMatrix(const MatrixXb &m);
+
+  /** Unpack into a MatrixXb */
+  MatrixXb to_MatrixXb() const;
+
+  unsigned rows() const { return rows_; }
+  unsigned cols() const { return cols_; }
+
+  bool get(unsigned r, unsigned c) const {
+    return (row_ptr(r)[c / 64] >> (c % 64)) & 1;
+  }
+  void set(unsigned r, unsigned c, bool value);
+
+  /** Add row \p source to row \p target */
+  void add_row(unsigned source, unsigned target);
+
+  /** Whether entries [c0, c1) of row \p r are all zero */
+  bool is_zero(unsigned r, unsigned c0, unsigned c1) const;
+
+  /**
+   * Entries [c0, c1) of row \p r, packed into words from bit 0 of the first.
+   * Bits past c1 - c0 are zero.
+   *
+   * @param[out] words result; resized to fit
+   */
+  void get_segment(
+      unsigned r, unsigned c0, unsigned c1,
+      std::vector<std::uint64_t> &words) const;
+
+  bool operator==(const BinaryMatrix &other) const;
+
+ private:
+  unsigned rows_;
+  unsigned cols_;
+  unsigned words_per_row_;
+  /** Bits past cols() in each row are zero */
+  std::vector<std::uint64_t> words_;
+
+  const std::uint64_t *row_ptr(unsigned r) const {
+    return words_.data() + r * words_per_row_;
+  }
+  std::uint64_t *row_ptr(unsigned r) {
+    return words_.data() + r * words_per_row_;
+  }
+};
+
+}  // namespace tket
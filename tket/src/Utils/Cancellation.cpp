@@ -0,0 +1,75 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Cancellation.hpp"
+
+namespace tket {
+
+// The token current in this thread, if any.
+static thread_local std::optional<CancellationToken> current_token;
+
+CancellationToken::CancellationToken(
+    const std::optional<time_point_t> &deadline)
+    : state_(std::make_shared<State>()) {
+  state_->deadline = deadline;
+}
+
+CancellationToken CancellationToken::with_timeout(
+    std::chrono::milliseconds timeout) {
+  return CancellationToken(std::chrono::steady_clock::now() + timeout);
+}
+
+void CancellationToken::cancel() const {
+  state_->cancelled.store(true, std::memory_order_relaxed);
+}
+
+bool CancellationToken::is_cancelled() const {
+  if (state_->cancelled.load(std::memory_order_relaxed)) return true;
+  return state_->deadline &&
+         std::chrono::steady_clock::now() >= *state_->deadline;
+}
+
+std::optional<CancellationToken::time_point_t>
+CancellationToken::get_deadline() const {
+  return state_->deadline;
+}
+
+CancellationScope::CancellationScope(const CancellationToken &token)
+    : previous_(current_token) {
+  current_token = token;
+}
+
+CancellationScope::CancellationScope(
+    const std::optional<CancellationToken> &token)
+    : previous_(current_token) {
+  current_token = token;
+}
+
+CancellationScope::~CancellationScope() { current_token = previous_; }
+
+std::optional<CancellationToken> current_cancellation_token() {
+  return current_token;
+}
+
+bool cancellation_requested() {
+  return current_token && current_token->is_cancelled();
+}
+
+void check_cancellation() {
+  if (cancellation_requested()) {
+    throw CompilationCancelled("Computation cancelled or past its deadline");
+  }
+}
+
+}  // namespace tket
@@ -0,0 +1,102 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Cooperative cancellation of long computations
+ *
+ * A computation is stopped by making a \ref CancellationToken current in the
+ * thread running it, with a \ref CancellationScope, and then cancelling the
+ * token from any thread or letting its deadline pass. Long-running loops call
+ * \ref check_cancellation at points where stopping leaves their inputs
+ * valid, and \ref parallel_for makes the token current in its worker threads.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace tket {
+
+/** Thrown when a computation is cancelled or passes its deadline */
+class CompilationCancelled : public std::runtime_error {
+ public:
+  explicit CompilationCancelled(const std::string &message)
+      : std::runtime_error(message) {}
+};
+
+/**
+ * Shared flag by which a computation can be stopped, with an optional
+ * deadline. Copies refer to the same flag.
+ */
+class CancellationToken {
+ public:
+  typedef std::chrono::steady_clock::time_point time_point_t;
+
+  explicit CancellationToken(
+      const std::optional<time_point_t> &deadline = std::nullopt);
+
+  /** Token whose deadline is the given time from now */
+  static CancellationToken with_timeout(std::chrono::milliseconds timeout);
+
+  /** Request cancellation. Safe to call from any thread. */
+  void cancel() const;
+
+  /** Whether cancellation has been requested or the deadline has passed */
+  bool is_cancelled() const;
+
+  std::optional<time_point_t> get_deadline() const;
+
+ private:
+  struct State {
+    std::atomic<bool> cancelled = false;
+    std::optional<time_point_t> deadline;
+  };
+  std::shared_ptr<State> state_;
+};
+
+/**
+ * Makes a token current in the calling thread for the lifetime of the scope,
+ * restoring the previous one (if any) afterwards.
+ */
+class CancellationScope {
+ public:
+  explicit CancellationScope(const CancellationToken &token);
+  explicit CancellationScope(const std::optional<CancellationToken> &token);
+  ~CancellationScope();
+
+  CancellationScope(const CancellationScope &) = delete;
+  CancellationScope &operator=(const CancellationScope &) = delete;
+
+ private:
+  std::optional<CancellationToken> previous_;
+};
+
+/** The token current in the calling thread, if any */
+std::optional<CancellationToken> current_cancellation_token();
+
+/** Whether the current token, if any, is cancelled */
+bool cancellation_requested();
+
+/**
+ * @throw CompilationCancelled if the current token, if any, is cancelled
+ */
+void check_cancellation();
+
+}  // namespace tket
@@ -23,8 +23,15 @@
 
 namespace tket {
 
-csd_t CS_decomp(const Eigen::MatrixXcd &u) {
-  if (!is_unitary(u)) {
+// The decomposition for matrices of type Mat, with blocks of type MatH and
+// real diagonals of type RealMatH. These are either all dynamic-size or all
+// fixed-size.
+template <typename Mat, typename MatH, typename RealMatH>
+static std::tuple<MatH, MatH, MatH, MatH, RealMatH, RealMatH> cs_decomp(
+    const Mat &u) {
+  constexpr int H = MatH::RowsAtCompileTime;
+  if (u.rows() != u.cols() ||
+      !Mat::Identity(u.rows(), u.cols()).isApprox(u.adjoint() * u, EPS)) {
     throw std::invalid_argument("Matrix for CS decomposition is not unitary");
   }
   unsigned N = u.rows();
@@ -33,25 +40,25 @@ csd_t CS_decomp(const Eigen::MatrixXcd &u) {
         "Matrix for CS decomposition has odd dimensions");
   }
   unsigned n = N / 2;
-  Eigen::MatrixXcd u00 = u.topLeftCorner(n, n);
-  Eigen::MatrixXcd u01 = u.topRightCorner(n, n);
-  Eigen::MatrixXcd u10 = u.bottomLeftCorner(n, n);
-  Eigen::MatrixXcd u11 = u.bottomRightCorner(n, n);
+  MatH u00 = u.template topLeftCorner<H, H>(n, n);
+  MatH u01 = u.template topRightCorner<H, H>(n, n);
+  MatH u10 = u.template bottomLeftCorner<H, H>(n, n);
+  MatH u11 = u.template bottomRightCorner<H, H>(n, n);
 
-  Eigen::JacobiSVD<Eigen::MatrixXcd, Eigen::NoQRPreconditioner> svd(
+  Eigen::JacobiSVD<MatH, Eigen::NoQRPreconditioner> svd(
       u00, Eigen::ComputeFullU | Eigen::ComputeFullV);
-  Eigen::MatrixXcd l0 = svd.matrixU().rowwise().reverse();
-  Eigen::MatrixXcd r0_dag = svd.matrixV().rowwise().reverse();
-  Eigen::MatrixXd c = svd.singularValues().reverse().asDiagonal();
-  Eigen::MatrixXcd r0 = r0_dag.adjoint();
+  MatH l0 = svd.matrixU().rowwise().reverse();
+  MatH r0_dag = svd.matrixV().rowwise().reverse();
+  RealMatH c = svd.singularValues().reverse().asDiagonal();
+  MatH r0 = r0_dag.adjoint();
 
   // Now u00 = l0 c r0; l0 and r0 are unitary, and c is diagonal with positive
   // non-decreasing entries. Because u00 is a submatrix of a unitary matrix, its
   // singular values (the entries of c) are all <= 1.
 
-  Eigen::HouseholderQR<Eigen::MatrixXcd> qr = (u10 * r0_dag).householderQr();
-  Eigen::MatrixXcd l1 = qr.householderQ();
-  Eigen::MatrixXcd S = qr.matrixQR().triangularView<Eigen::Upper>();
+  Eigen::HouseholderQR<MatH> qr(u10 * r0_dag);
+  MatH l1 = qr.householderQ();
+  MatH S = qr.matrixQR().template triangularView<Eigen::Upper>();
 
   // Now u10 r0* = l1 S; l1 is unitary, and S is upper triangular.
   //
@@ -90,7 +97,7 @@ csd_t CS_decomp(const Eigen::MatrixXcd &u) {
 
   // Now S is real and diagonal, and c^2 + S^2 = I.
 
-  Eigen::MatrixXd s = S.real();
+  RealMatH s = S.real();
 
   // Make all entries in s non-negative.
   for (unsigned j = 0; j < n; j++) {
@@ -101,7 +108,7 @@ csd_t CS_decomp(const Eigen::MatrixXcd &u) {
   }
 
   // Finally compute r1, being careful not to divide by small things.
-  Eigen::MatrixXcd r1 = Eigen::MatrixXcd::Zero(n, n);
+  MatH r1 = MatH::Zero(n, n);
   for (unsigned i = 0; i < n; i++) {
     if (s(i, i) > c(i, i)) {
       r1.row(i) = -(l0.adjoint() * u01).row(i) / s(i, i);
@@ -112,4 +119,12 @@ csd_t CS_decomp(const Eigen::MatrixXcd &u) {
   return {l0, l1, r0, r1, c, s};
 }
 
+csd_t CS_decomp(const Eigen::MatrixXcd &u) {
+  return cs_decomp<Eigen::MatrixXcd, Eigen::MatrixXcd, Eigen::MatrixXd>(u);
+}
+
+csd8_t CS_decomp(const Matrix8cd &u) {
+  return cs_decomp<Matrix8cd, Eigen::Matrix4cd, Eigen::Matrix4d>(u);
+}
+
 }  // namespace tket
@@ -15,6 +15,7 @@
 #pragma once
 
 #include "EigenConfig.hpp"
+#include "MatrixAnalysis.hpp"
 
 namespace tket {
 
@@ -34,6 +35,15 @@ typedef std::tuple<
     Eigen::MatrixXd, Eigen::MatrixXd>
     csd_t;
 
+/**
+ * Cosine-sine decomposition of an 8x8 unitary, as for \ref csd_t but with
+ * fixed-size 4x4 blocks.
+ */
+typedef std::tuple<
+    Eigen::Matrix4cd, Eigen::Matrix4cd, Eigen::Matrix4cd, Eigen::Matrix4cd,
+    Eigen::Matrix4d, Eigen::Matrix4d>
+    csd8_t;
+
 /**
  * Compute a cosine-sine decomposition of a unitary matrix.
  *
@@ -43,4 +53,16 @@ typedef std::tuple<
  */
 csd_t CS_decomp(const Eigen::MatrixXcd &u);
 
+/**
+ * Compute a cosine-sine decomposition of an 8x8 unitary matrix.
+ *
+ * This gives the same decomposition as for a dynamic-size matrix, but all the
+ * intermediate matrices and solvers are fixed-size, so nothing is allocated
+ * on the heap.
+ *
+ * @param u unitary matrix to be decomposed
+ * @return cosine-sine decomposition
+ */
+csd8_t CS_decomp(const Matrix8cd &u);
+
 }  // namespace tket
@@ -0,0 +1,189 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "DensePauliString.hpp"
+
+#include <bit>
+#include <set>
+
+namespace tket {
+
+DensePauliString::DensePauliString(unsigned n_qubits)
+    : n_qubits_(n_qubits),
+      x_((n_qubits + 63) / 64, 0),
+      z_((n_qubits + 63) / 64, 0) {}
+
+DensePauliString::DensePauliString(
+    const QubitPauliString &qps, const std::map<Qubit, unsigned> &index)
+    : DensePauliString(index.size()) {
+  for (const std::pair<const Qubit, Pauli> &term : qps.map) {
+    if (term.second == Pauli::I) continue;
+    std::map<Qubit, unsigned>::const_iterator found = index.find(term.first);
+    if (found == index.end()) {
+      throw std::out_of_range(
+          "Qubit " + term.first.repr() + " missing from Pauli string index");
+    }
+    set(found->second, term.second);
+  }
+}
+
+QubitPauliString DensePauliString::to_qubit_pauli_string(
+    const qubit_vector_t &qubits) const {
+  if (qubits.size() != n_qubits_) {
+    throw std::invalid_argument(
+        "Number of qubits does not match size of DensePauliString");
+  }
+  QubitPauliString qps;
+  for (unsigned i = 0; i < n_qubits_; i++) {
+    Pauli p = get(i);
+    if (p != Pauli::I) qps.map.insert({qubits[i], p});
+  }
+  return qps;
+}
+
+Pauli DensePauliString::get(unsigned i) const {
+  const bool x = (x_.at(i / 64) >> (i % 64)) & 1;
+  const bool z = (z_.at(i / 64) >> (i % 64)) & 1;
+  if (x) return z ? Pauli::Y : Pauli::X;
+  return z ? Pauli::Z : Pauli::I;
+}
+
+void DensePauliString::set(unsigned i, Pauli p) {
+  if (i >= n_qubits_) {
+    throw std::out_of_range("Index out of range of DensePauliString");
+  }
+  const std::uint64_t bit = std::uint64_t{1} << (i % 64);
+  if (p == Pauli::X || p == Pauli::Y) {
+    x_[i / 64] |= bit;
+  } else {
+    x_[i / 64] &= ~bit;
+  }
+  if (p == Pauli::Z || p == Pauli::Y) {
+    z_[i / 64] |= bit;
+  } else {
+    z_[i / 64] &= ~bit;
+  }
+}
+
+void DensePauliString::resize(unsigned n_qubits) {
+  const unsigned n_words = (n_qubits + 63) / 64;
+  x_.resize(n_words, 0);
+  z_.resize(n_words, 0);
+  if (n_qubits % 64 != 0) {
+    const std::uint64_t mask = (std::uint64_t{1} << (n_qubits % 64)) - 1;
+    x_.back() &= mask;
+    z_.back() &= mask;
+  }
+  n_qubits_ = n_qubits;
+}
+
+DensePauliString &DensePauliString::operator^=(const DensePauliString &other) {
+  check_size(other);
+  for (unsigned k = 0; k < x_.size(); k++) {
+    x_[k] ^= other.x_[k];
+    z_[k] ^= other.z_[k];
+  }
+  return *this;
+}
+
+void DensePauliString::check_size(const DensePauliString &other) const {
+  if (n_qubits_ != other.n_qubits_) {
+    throw std::invalid_argument(
+        "Cannot compare DensePauliStrings over different numbers of qubits");
+  }
+}
+
+// Collect the indices of the set bits of words produced by f(k).
+template <typename F>
+static std::vector<unsigned> set_bits(unsigned n_words, F f) {
+  std::vector<unsigned> bits;
+  for (unsigned k = 0; k < n_words; k++) {
+    std::uint64_t w = f(k);
+    while (w) {
+      bits.push_back(64 * k + std::countr_zero(w));
+      w &= w - 1;
+    }
+  }
+  return bits;
+}
+
+bool DensePauliString::commutes_with(const DensePauliString &other) const {
+  return n_conflicts(other) % 2 == 0;
+}
+
+std::vector<unsigned> DensePauliString::common_qubits(
+    const DensePauliString &other) const {
+  check_size(other);
+  return set_bits(x_.size(), [&](unsigned k) {
+    return (x_[k] | z_[k]) & ~(x_[k] ^ other.x_[k]) & ~(z_[k] ^ other.z_[k]);
+  });
+}
+
+std::vector<unsigned> DensePauliString::own_qubits(
+    const DensePauliString &other) const {
+  check_size(other);
+  return set_bits(x_.size(), [&](unsigned k) {
+    return (x_[k] | z_[k]) & ~(other.x_[k] | other.z_[k]);
+  });
+}
+
+std::vector<unsigned> DensePauliString::conflicting_qubits(
+    const DensePauliString &other) const {
+  check_size(other);
+  return set_bits(x_.size(), [&](unsigned k) {
+    return (x_[k] & other.z_[k]) ^ (z_[k] & other.x_[k]);
+  });
+}
+
+unsigned DensePauliString::n_conflicts(const DensePauliString &other) const {
+  check_size(other);
+  unsigned count = 0;
+  for (unsigned k = 0; k < x_.size(); k++) {
+    count += std::popcount((x_[k] & other.z_[k]) ^ (z_[k] & other.x_[k]));
+  }
+  return count;
+}
+
+bool DensePauliString::operator==(const DensePauliString &other) const {
+  return n_qubits_ == other.n_qubits_ && x_ == other.x_ && z_ == other.z_;
+}
+
+bool DensePauliString::operator<(const DensePauliString &other) const {
+  if (n_qubits_ != other.n_qubits_) return n_qubits_ < other.n_qubits_;
+  if (x_ != other.x_) return x_ < other.x_;
+  return z_ < other.z_;
+}
+
+std::vector<DensePauliString> pack_pauli_strings(
+    const std::list<QubitPauliString> &strings, qubit_vector_t &qubits) {
+  std::set<Qubit> all_qubits;
+  for (const QubitPauliString &qps : strings) {
+    for (const std::pair<const Qubit, Pauli> &term : qps.map) {
+      if (term.second != Pauli::I) all_qubits.insert(term.first);
+    }
+  }
+  qubits.assign(all_qubits.begin(), all_qubits.end());
+  std::map<Qubit, unsigned> index;
+  for (unsigned i = 0; i < qubits.size(); i++) {
+    index.insert({qubits[i], i});
+  }
+  std::vector<DensePauliString> packed;
+  packed.reserve(strings.size());
+  for (const QubitPauliString &qps : strings) {
+    packed.emplace_back(qps, index);
+  }
+  return packed;
+}
+
+}  // namespace tket
@@ -0,0 +1,136 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "Utils/PauliStrings.hpp"
+
+namespace tket {
+
+/**
+ * A string of Pauli letters over a fixed set of qubit indices, stored
+ * densely in symplectic form: one bit vector for the X components and one
+ * for the Z components (Y has both bits set).
+ *
+ * Queries between two strings over the same index space are word-parallel;
+ * for instance two strings commute iff the popcount of
+ * (x1 & z2) ^ (z1 & x2) is even. Use this in place of \ref QubitPauliString
+ * when many strings over the same qubits are compared against each other.
+ */
+class DensePauliString {
+ public:
+  /**
+   * Construct the identity over n qubits
+   */
+  explicit DensePauliString(unsigned n_qubits = 0);
+
+  /**
+   * Pack a QubitPauliString
+   *
+   * @param qps string to pack
+   * @param index index of each qubit; every qubit with a non-I term in \p qps
+   *  must appear, and the indices must lie in [0, index.size())
+   */
+  DensePauliString(
+      const QubitPauliString &qps, const std::map<Qubit, unsigned> &index);
+
+  /**
+   * Unpack into a QubitPauliString, omitting I terms
+   *
+   * @param qubits qubit for each index
+   */
+  QubitPauliString to_qubit_pauli_string(const qubit_vector_t &qubits) const;
+
+  unsigned n_qubits() const { return n_qubits_; }
+
+  Pauli get(unsigned i) const;
+  void set(unsigned i, Pauli p);
+
+  /**
+   * Change the number of qubits. New qubits get I; letters on removed
+   * qubits are dropped.
+   */
+  void resize(unsigned n_qubits);
+
+  /**
+   * Multiply by another string, ignoring the phase; that is, add the
+   * symplectic vectors over GF(2).
+   */
+  DensePauliString &operator^=(const DensePauliString &other);
+
+  /**
+   * Whether the two strings commute. Both must be over the same number of
+   * qubits, as must the arguments of the other binary queries.
+   */
+  bool commutes_with(const DensePauliString &other) const;
+
+  /**
+   * Indices on which both strings have the same non-I letter
+   */
+  std::vector<unsigned> common_qubits(const DensePauliString &other) const;
+
+  /**
+   * Indices on which this string has a non-I letter and the other has I
+   */
+  std::vector<unsigned> own_qubits(const DensePauliString &other) const;
+
+  /**
+   * Indices on which both strings have different non-I letters
+   */
+  std::vector<unsigned> conflicting_qubits(
+      const DensePauliString &other) const;
+
+  /**
+   * Number of indices on which both strings have different non-I letters
+   */
+  unsigned n_conflicts(const DensePauliString &other) const;
+
+  bool operator==(const DensePauliString &other) const;
+  bool operator!=(const DensePauliString &other) const {
+    return !(*this == other);
+  }
+  bool operator<(const DensePauliString &other) const;
+
+  /** X components, 64 qubits per word; bits past n_qubits() are zero */
+  const std::vector<std::uint64_t> &x_words() const { return x_; }
+
+  /** Z components, 64 qubits per word; bits past n_qubits() are zero */
+  const std::vector<std::uint64_t> &z_words() const { return z_; }
+
+ private:
+  unsigned n_qubits_;
+  std::vector<std::uint64_t> x_;
+  std::vector<std::uint64_t> z_;
+
+  void check_size(const DensePauliString &other) const;
+};
+
+/**
+ * Pack strings over the union of their qubits.
+ *
+ * @param strings strings to pack
+ * @param[out] qubits the qubits with a non-I term in any string, in order;
+ *  index i of each packed string refers to qubits[i]
+ *
+ * @return packed strings, in the same order as \p strings
+ */
+std::vector<DensePauliString> pack_pauli_strings(
+    const std::list<QubitPauliString> &strings, qubit_vector_t &qubits);
+
+}  // namespace tket
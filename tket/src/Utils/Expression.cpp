@@ -14,6 +14,8 @@
 
 #include "Expression.hpp"
 
+#include <symengine/real_double.h>
+
 #include "Constants.hpp"
 #include "Symbols.hpp"
 
@@ -48,7 +50,20 @@ SymSet expr_free_symbols(const std::vector<Expr>& es) {
   return symbols;
 }
 
+// Value of an expression that is a floating-point number
+static std::optional<double> as_double(const Expr& e) {
+  const SymEngine::Basic& b = *e.get_basic();
+  if (!SymEngine::is_a<SymEngine::RealDouble>(b)) return std::nullopt;
+  return SymEngine::down_cast<const SymEngine::RealDouble&>(b).as_double();
+}
+
 std::optional<double> eval_expr(const Expr& e) {
+  // Numbers need no search for free symbols
+  std::optional<double> x = as_double(e);
+  if (x) return x;
+  if (SymEngine::is_a_Number(*e.get_basic())) {
+    return SymEngine::eval_double(e);
+  }
   if (!SymEngine::free_symbols(e).empty()) {
     return std::nullopt;
   } else {
@@ -64,10 +79,8 @@ std::optional<Complex> eval_expr_c(const Expr& e) {
   }
 }
 
-std::optional<double> eval_expr_mod(const Expr& e, unsigned n) {
-  std::optional<double> reduced_val = eval_expr(e);
-  if (!reduced_val) return std::nullopt;
-  double val = reduced_val.value();
+// Reduce a value modulo n, clamping it to a multiple of 0.25 if within EPS
+static double reduce_mod(double val, unsigned n) {
   double val4 = 4 * val;
   long nearest_val4 = std::lrint(val4);
   if (std::abs(val4 - nearest_val4) < 4 * EPS) {
@@ -76,6 +89,12 @@ std::optional<double> eval_expr_mod(const Expr& e, unsigned n) {
   return fmodn(val, n);
 }
 
+std::optional<double> eval_expr_mod(const Expr& e, unsigned n) {
+  std::optional<double> reduced_val = eval_expr(e);
+  if (!reduced_val) return std::nullopt;
+  return reduce_mod(reduced_val.value(), n);
+}
+
 // Evaluate cos(pi x / 12). If x is close to a multiple of pi/12, it is clamped
 // to that exact multiple and the return value is exact.
 // Is is assumed that 0 <= x < 24.
@@ -132,4 +151,53 @@ std::optional<unsigned> equiv_Clifford(const Expr& e, unsigned n, double tol) {
     return std::nullopt;
 }
 
+Param::Param(const Expr& e) {
+  std::optional<double> x = as_double(e);
+  if (x) {
+    value_ = *x;
+  } else {
+    value_ = e;
+  }
+}
+
+std::optional<double> Param::eval() const {
+  if (is_double()) return std::get<double>(value_);
+  return eval_expr(std::get<Expr>(value_));
+}
+
+Expr Param::to_expr() const {
+  if (is_double()) return Expr(std::get<double>(value_));
+  return std::get<Expr>(value_);
+}
+
+SymSet Param::free_symbols() const {
+  if (is_double()) return {};
+  return expr_free_symbols(std::get<Expr>(value_));
+}
+
+std::optional<double> eval_expr(const Param& p) { return p.eval(); }
+
+std::optional<double> eval_expr_mod(const Param& p, unsigned n) {
+  std::optional<double> val = p.eval();
+  if (!val) return std::nullopt;
+  return reduce_mod(val.value(), n);
+}
+
+bool equiv_expr(const Param& p0, const Param& p1, unsigned n, double tol) {
+  if (!p0.is_double() || !p1.is_double()) {
+    return equiv_expr(p0.to_expr(), p1.to_expr(), n, tol);
+  }
+  return approx_eq(*p0.eval(), *p1.eval(), n, tol);
+}
+
+bool equiv_val(const Param& p, double x, unsigned n, double tol) {
+  std::optional<double> eval = p.eval();
+  if (!eval) return false;
+  return approx_eq(eval.value(), x, n, tol);
+}
+
+bool equiv_0(const Param& p, unsigned n, double tol) {
+  return equiv_val(p, 0., n, tol);
+}
+
 }  // namespace tket
@@ -22,6 +22,7 @@
 #include <map>
 #include <optional>
 #include <set>
+#include <variant>
 #include <vector>
 
 #include "Constants.hpp"
@@ -197,4 +198,53 @@ bool equiv_0(const Expr& e, unsigned n = 2, double tol = EPS);
 std::optional<unsigned> equiv_Clifford(
     const Expr& e, unsigned n = 2, double tol = EPS);
 
+/**
+ * Compact representation of a (possibly symbolic) parameter
+ *
+ * A floating-point number is held inline as a double; any other expression
+ * is held as an \ref Expr. Numerical parameters therefore need no SymEngine
+ * object, and can be evaluated and compared without calling into SymEngine.
+ *
+ * Only expressions that are floating-point numbers are stored as doubles, so
+ * that \ref to_expr gives back an identical expression: exact numbers such
+ * as 1/3 are kept as expressions.
+ */
+class Param {
+ public:
+  explicit Param(double x = 0.) : value_(x) {}
+
+  explicit Param(const Expr& e);
+
+  /** Whether the value is held as a double */
+  bool is_double() const { return value_.index() == 0; }
+
+  /** Value, if the parameter has no free symbols */
+  std::optional<double> eval() const;
+
+  /** Parameter as an expression */
+  Expr to_expr() const;
+
+  /** Set of all free symbols contained in the parameter */
+  SymSet free_symbols() const;
+
+ private:
+  std::variant<double, Expr> value_;
+};
+
+/** Value of a parameter, if it has no free symbols */
+std::optional<double> eval_expr(const Param& p);
+
+/** As \ref eval_expr_mod for expressions */
+std::optional<double> eval_expr_mod(const Param& p, unsigned n = 2);
+
+/** As \ref equiv_expr for expressions */
+bool equiv_expr(
+    const Param& p0, const Param& p1, unsigned n = 2, double tol = EPS);
+
+/** As \ref equiv_val for expressions */
+bool equiv_val(const Param& p, double x, unsigned n = 2, double tol = EPS);
+
+/** As \ref equiv_0 for expressions */
+bool equiv_0(const Param& p, unsigned n = 2, double tol = EPS);
+
 }  // namespace tket
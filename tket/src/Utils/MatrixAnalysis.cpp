@@ -14,6 +14,8 @@
 
 #include "MatrixAnalysis.hpp"
 
+#include <array>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <limits>
@@ -24,6 +26,7 @@
 #include <vector>
 
 #include "Utils/Assert.hpp"
+#include "Utils/BinaryMatrix.hpp"
 #include "Utils/EigenConfig.hpp"
 
 namespace tket {
@@ -74,21 +77,6 @@ std::vector<std::pair<unsigned, unsigned>> gaussian_elimination_col_ops(
   return gaussian_elimination_row_ops(a.transpose(), blocksize);
 }
 
-struct MatrixXbBlockCompare {
-  bool operator()(
-      const MatrixXb::BlockXpr &lhs, const MatrixXb::BlockXpr &rhs) const {
-    TKET_ASSERT(lhs.rows() == rhs.rows());
-    TKET_ASSERT(lhs.cols() == rhs.cols());
-    for (unsigned r = 0; r < lhs.rows(); ++r) {
-      for (unsigned c = 0; c < lhs.cols(); ++c) {
-        if (lhs(r, c) < rhs(r, c)) return true;
-        if (lhs(r, c) > rhs(r, c)) return false;
-      }
-    }
-    return false;
-  }
-};
-
 /* see https://web.eecs.umich.edu/~imarkov/pubs/jour/qic08-cnot.pdf for a full
  * explanation of this technique */
 /* K. Patel, I. Markov, J. Hayes. Optimal Synthesis of Linear Reversible
@@ -96,7 +84,8 @@ struct MatrixXbBlockCompare {
 std::vector<std::pair<unsigned, unsigned>> gaussian_elimination_row_ops(
     const MatrixXb &a, unsigned blocksize) {
   std::vector<std::pair<unsigned, unsigned>> ops;
-  MatrixXb m = a;
+  // Row additions are word-parallel on the packed matrix
+  BinaryMatrix m(a);
   unsigned rows = m.rows();
   unsigned cols = m.cols();
   std::vector<unsigned> pcols;  // we know which columns have non-zero entries
@@ -104,6 +93,7 @@ std::vector<std::pair<unsigned, unsigned>> gaussian_elimination_row_ops(
   unsigned pivot_row = 0;
   unsigned ceiling =
       (cols + blocksize - 1) / blocksize;  // ceil(cols/blocksize)
+  std::vector<std::uint64_t> chunk;
 
   // Get to upper echelon form
   for (unsigned sec = 0; sec < ceiling; ++sec) {
@@ -114,45 +104,39 @@ std::vector<std::pair<unsigned, unsigned>> gaussian_elimination_row_ops(
 
     /* first, try to eliminate sub-rows (ie chunks), for greater speed than
      * naively doing gaussian elim. */
-    std::map<MatrixXb::BlockXpr, unsigned, MatrixXbBlockCompare> chunks;
+    std::map<std::vector<std::uint64_t>, unsigned> chunks;
     for (unsigned r = pivot_row; r < rows; ++r) {
-      MatrixXb::BlockXpr t = m.block(r, i0, 1, i1 - i0);
-      if (t == MatrixXb::Zero(1, i1 - i0)) continue;
+      if (m.is_zero(r, i0, i1)) continue;
+      m.get_segment(r, i0, i1, chunk);
       /* if first copy of pattern, save. If duplicate then remove by adding
        * rows*/
-      auto chunk_it = chunks.find(t);
+      auto chunk_it = chunks.find(chunk);
       if (chunk_it != chunks.end()) {
-        for (unsigned k = 0; k < cols; ++k) {
-          m(r, k) ^= m(chunk_it->second, k);
-        }
+        m.add_row(chunk_it->second, r);
         ops.push_back({chunk_it->second, r});
       } else {
-        chunks.insert({t, r});
+        chunks.insert({chunk, r});
       }
     }
     /* do gaussian elim. on remaining entries */
     for (unsigned col = i0; col < i1; ++col) {
       // find first 1 element in column after pivot_row
       unsigned first_1 = pivot_row;
-      while (first_1 < rows && !m(first_1, col)) {
+      while (first_1 < rows && !m.get(first_1, col)) {
         ++first_1;
       }
       if (first_1 == rows) continue;
 
       // pull back to pivot
       if (first_1 != pivot_row) {
-        for (unsigned k = 0; k < cols; ++k) {
-          m(pivot_row, k) ^= m(first_1, k);
-        }
+        m.add_row(first_1, pivot_row);
         ops.push_back({first_1, pivot_row});
       }
 
       // clear all entries below pivot
       for (unsigned r = std::max(pivot_row + 1, first_1); r < rows; ++r) {
-        if (m(r, col)) {
-          for (unsigned k = 0; k < cols; ++k) {
-            m(r, k) ^= m(pivot_row, k);
-          }
+        if (m.get(r, col)) {
+          m.add_row(pivot_row, r);
           ops.push_back({pivot_row, r});
         }
       }
@@ -171,29 +155,25 @@ std::vector<std::pair<unsigned, unsigned>> gaussian_elimination_row_ops(
     unsigned i0 = sec * blocksize;
     unsigned i1 = std::min(cols, (sec + 1) * blocksize);
 
-    std::map<MatrixXb::BlockXpr, unsigned, MatrixXbBlockCompare> chunks;
+    std::map<std::vector<std::uint64_t>, unsigned> chunks;
     for (unsigned r = pivot_row + 1; r-- > 0;) {
-      MatrixXb::BlockXpr t = m.block(r, i0, 1, i1 - i0);
-      if (t == MatrixXb::Zero(1, i1 - i0)) continue;
+      if (m.is_zero(r, i0, i1)) continue;
+      m.get_segment(r, i0, i1, chunk);
 
-      auto chunk_it = chunks.find(t);
+      auto chunk_it = chunks.find(chunk);
       if (chunk_it != chunks.end()) {
-        for (unsigned k = 0; k < cols; ++k) {
-          m(r, k) ^= m(chunk_it->second, k);
-        }
+        m.add_row(chunk_it->second, r);
         ops.push_back({chunk_it->second, r});
       } else {
-        chunks.insert({t, r});
+        chunks.insert({chunk, r});
       }
     }
     while (!pcols.empty() && i0 <= pcols.back() && pcols.back() < i1) {
       unsigned pcol = pcols.back();
       pcols.pop_back();
       for (unsigned r = 0; r < pivot_row; ++r) {
-        if (m(r, pcol)) {
-          for (unsigned k = 0; k < cols; ++k) {
-            m(r, k) ^= m(pivot_row, k);
-          }
+        if (m.get(r, pcol)) {
+          m.add_row(pivot_row, r);
           ops.push_back({pivot_row, r});
         }
       }
@@ -292,6 +272,36 @@ Eigen::VectorXcd apply_qubit_permutation(
   return perm_m * v;
 }
 
+void apply_qubit_permutation_in_place(
+    Eigen::Ref<Eigen::MatrixXcd> m, const qubit_map_t &perm) {
+  bool identity = true;
+  for (const std::pair<const Qubit, Qubit> &pair : perm) {
+    identity &= pair.first == pair.second;
+  }
+  if (identity) return;
+  Eigen::PermutationMatrix<Eigen::Dynamic> perm_m = qubit_permutation(perm);
+  // Permutations are applied in place when the source is the destination
+  m = perm_m * m;
+}
+
+static const Eigen::Matrix2cd &pauli_x() {
+  static const Eigen::Matrix2cd m =
+      (Eigen::Matrix2cd() << 0, 1, 1, 0).finished();
+  return m;
+}
+
+static const Eigen::Matrix2cd &pauli_y() {
+  static const Eigen::Matrix2cd m =
+      (Eigen::Matrix2cd() << 0, -i_, i_, 0).finished();
+  return m;
+}
+
+static const Eigen::Matrix2cd &pauli_z() {
+  static const Eigen::Matrix2cd m =
+      (Eigen::Matrix2cd() << 1, 0, 0, -1).finished();
+  return m;
+}
+
 /**
  * returns average fidelity of the decomposition of the information
  * content with nb_cx CNOTS.
@@ -334,10 +344,8 @@ std::vector<std::tuple<Eigen::Matrix2cd, Eigen::Matrix2cd>> expgate_as_CX(
   }
 
   const auto [k_a, k_b, k_c] = k;
-  Mat2 PauliX, PauliY, PauliZ;
-  PauliX << 0, 1, 1, 0;
-  PauliY << 0, -i_, i_, 0;
-  PauliZ << 1, 0, 0, -1;
+  const Mat2 &PauliX = pauli_x();
+  const Mat2 &PauliZ = pauli_z();
 
   unsigned nb_cx = 0;
   double best_fid = 0.;
@@ -351,15 +359,15 @@ std::vector<std::tuple<Eigen::Matrix2cd, Eigen::Matrix2cd>> expgate_as_CX(
     }
   }
 
-  Mat2 cx_K1a, cx_K1b, cx_K2a, cx_K2b;
   // cnot KAK decomposition
-  cx_K1a << 1. - i_, 1. - i_, -1. - i_, 1. + i_;
-  cx_K1a /= 2.;
-  cx_K1b << -i_, 1., -1., i_;
-  cx_K1b /= sqrt(2.);
-  cx_K2a << i_, i_, i_, -i_;
-  cx_K2a /= sqrt(2.);
-  cx_K2b << 0., -1., 1., 0.;
+  static const Mat2 cx_K1a = (Mat2() << 1. - i_, 1. - i_, -1. - i_, 1. + i_)
+                                 .finished() /
+                             2.;
+  static const Mat2 cx_K1b =
+      (Mat2() << -i_, 1., -1., i_).finished() / sqrt(2.);
+  static const Mat2 cx_K2a =
+      (Mat2() << i_, i_, i_, -i_).finished() / sqrt(2.);
+  static const Mat2 cx_K2b = (Mat2() << 0., -1., 1., 0.).finished();
 
   auto Rz = [](const double theta) {
     Mat2 mat;
@@ -454,20 +462,17 @@ get_information_content(const Eigen::Matrix4cd &X) {
   using Mat4 = Eigen::Matrix4cd;
   using Vec4 = Eigen::Vector4cd;
 
-  if (!is_unitary(X)) {
+  // Same test as is_unitary, without converting to a dynamic-size matrix.
+  if (!Mat4::Identity().isApprox(X.adjoint() * X, EPS)) {
     throw std::invalid_argument(
         "Non-unitary matrix passed to get_information_content");
   }
 
-  Eigen::Matrix2cd PauliX, PauliY, PauliZ;
-  PauliX << 0, 1, 1, 0;
-  PauliY << 0, -i_, i_, 0;
-  PauliZ << 1, 0, 0, -1;
-
   // change of basis for SU(2) x SU(2) -> SO(4)
-  Mat4 MagicM;
-  MagicM << 1, 0, 0, i_, 0, i_, 1, 0, 0, i_, -1, 0, 1, 0, 0, -i_;
-  MagicM /= sqrt(2.);  // unitary
+  static const Mat4 MagicM =
+      (Mat4() << 1, 0, 0, i_, 0, i_, 1, 0, 0, i_, -1, 0, 1, 0, 0, -i_)
+          .finished() /
+      sqrt(2.);  // unitary
 
   // change to magic basis and make sure U in SU(4)
   const auto norm_X = pow(X.determinant(), 0.25);
@@ -488,7 +493,7 @@ get_information_content(const Eigen::Matrix4cd &X) {
     Eigen::SelfAdjointEigenSolver<Eigen::Matrix4d> ces(
         r * X2real + (1 - r) * X2imag);
     eigv = ces.eigenvectors().cast<Complex>();
-    eigs = (eigv.transpose() * Xprime.transpose() * Xprime * eigv).diagonal();
+    eigs = (eigv.transpose() * X2 * eigv).diagonal();
 
     if (std::abs((X2 - eigv * eigs.asDiagonal() * eigv.adjoint()).sum()) <
         EPS) {
@@ -503,8 +508,9 @@ get_information_content(const Eigen::Matrix4cd &X) {
   // make sure exp(i thetas) is in SU(4) ie Σ thetas = 0
   thetas(3) = -thetas.head<3>().sum();
 
-  const Mat4 tmp = (-i_ * thetas).asDiagonal();
-  const auto eigs_sqrt_inv = tmp.exp();
+  // exp(-i thetas), exponentiated entrywise since it is diagonal
+  const Mat4 eigs_sqrt_inv =
+      (-i_ * thetas.cast<Complex>()).array().exp().matrix().asDiagonal();
 
   Mat4 Q2 = eigv.transpose();
   Mat4 Q1 = Xprime * Q2.transpose() * eigs_sqrt_inv;
@@ -513,9 +519,10 @@ get_information_content(const Eigen::Matrix4cd &X) {
   // with Q1,Q2 in SO(4), exp(i thetas) in SU(4)
 
   // transform to Pauli basis exp(i k_i σ_ii)
-  Eigen::Matrix4d basis_change;
-  basis_change << 1, 1, -1, -1, -1, 1, -1, 1, 1, -1, -1, 1, 1, 1, 1,
-      1;  // k3 = 0 always
+  static const Eigen::Matrix4d basis_change =
+      (Eigen::Matrix4d() << 1, 1, -1, -1, -1, 1, -1, 1, 1, -1, -1, 1, 1, 1, 1,
+       1)
+          .finished();  // k3 = 0 always
   Eigen::Vector3d k =
       (.25 * basis_change * thetas).head<3>().unaryExpr([](double d) {
         return mod(d, 2 * PI);
@@ -524,7 +531,7 @@ get_information_content(const Eigen::Matrix4cd &X) {
   // move k into Weyl chamber ie pi/4 >= k_x >= k_y >= |k_z|
   //   1. permutate ks
   //   2. modulo pi/2 and pi/4
-  std::vector<int> ind_order{0, 1, 2};
+  std::array<int, 3> ind_order{0, 1, 2};
   std::sort(ind_order.begin(), ind_order.end(), [&k](int i, int j) {
     return dist_from_weyl(k(i)) > dist_from_weyl(k(j));
   });
@@ -551,17 +558,14 @@ get_information_content(const Eigen::Matrix4cd &X) {
   Mat4 K2 = MagicM * P * Q2 * MagicM.adjoint();
 
   // last minute adjustments (modulos and reflections to be in Weyl chamber)
-  const Eigen::Matrix4cd s_xx = Eigen::kroneckerProduct(PauliX, PauliX);
-  const Eigen::Matrix4cd s_yy = Eigen::kroneckerProduct(PauliY, PauliY);
-  const Eigen::Matrix4cd s_zz = Eigen::kroneckerProduct(PauliZ, PauliZ);
-  const Eigen::Matrix4cd s_zi =
-      Eigen::kroneckerProduct(PauliZ, Eigen::Matrix2cd::Identity());
-  const Eigen::Matrix4cd s_iz =
-      Eigen::kroneckerProduct(Eigen::Matrix2cd::Identity(), PauliZ);
-  const Eigen::Matrix4cd s_xi =
-      Eigen::kroneckerProduct(PauliX, Eigen::Matrix2cd::Identity());
-  const Eigen::Matrix4cd s_ix =
-      Eigen::kroneckerProduct(Eigen::Matrix2cd::Identity(), PauliX);
+  const Eigen::Matrix2cd I2 = Eigen::Matrix2cd::Identity();
+  static const Mat4 s_xx = Eigen::kroneckerProduct(pauli_x(), pauli_x());
+  static const Mat4 s_yy = Eigen::kroneckerProduct(pauli_y(), pauli_y());
+  static const Mat4 s_zz = Eigen::kroneckerProduct(pauli_z(), pauli_z());
+  static const Mat4 s_zi = Eigen::kroneckerProduct(pauli_z(), I2);
+  static const Mat4 s_iz = Eigen::kroneckerProduct(I2, pauli_z());
+  static const Mat4 s_xi = Eigen::kroneckerProduct(pauli_x(), I2);
+  static const Mat4 s_ix = Eigen::kroneckerProduct(I2, pauli_x());
   if (k(0) > PI / 2) {
     k(0) -= 1.5 * PI;
     K1 *= -i_ * s_xx;
@@ -605,21 +609,22 @@ std::pair<Eigen::Matrix2cd, Eigen::Matrix2cd> kronecker_decomposition(
     Eigen::Matrix4cd &U) {
   using Mat4 = Eigen::Matrix4cd;
   Mat4 Up = U / pow(U.determinant(), 0.25);
+  // Rearrange so that if Up = u0 (x) u1 then U_mod = vec(u0) vec(u1)^T, which
+  // has rank 1.
   Mat4 U_mod;
   U_mod << Up(0, 0), Up(1, 0), Up(0, 1), Up(1, 1), Up(2, 0), Up(3, 0), Up(2, 1),
       Up(3, 1), Up(0, 2), Up(1, 2), Up(0, 3), Up(1, 3), Up(2, 2), Up(3, 2),
       Up(2, 3), Up(3, 3);
-  Eigen::JacobiSVD<Mat4, Eigen::NoQRPreconditioner> svd(
-      U_mod, Eigen::DecompositionOptions::ComputeFullU |
-                 Eigen::DecompositionOptions::ComputeFullV);
-  Eigen::Vector4cd sings = svd.singularValues();
-  Mat4 l = svd.matrixU();
-  Mat4 r = svd.matrixV().conjugate();
+  // Rather than a full SVD, take vec(u0) along the largest column of U_mod,
+  // scaled so that u0 is unitary, and project U_mod onto it to get vec(u1).
+  // For a product this is exact, and agrees with the leading singular pair.
+  Eigen::Index j;
+  U_mod.colwise().squaredNorm().maxCoeff(&j);
+  const Eigen::Vector4cd a = U_mod.col(j) * (sqrt(2.) / U_mod.col(j).norm());
+  const Eigen::Vector4cd b = (a.adjoint() * U_mod).transpose() / 2.;
   Eigen::Matrix2cd u0, u1;
-  u0 << l(0, 0), l(2, 0), l(1, 0), l(3, 0);
-  u1 << r(0, 0), r(2, 0), r(1, 0), r(3, 0);
-  u0 *= sqrt(sings[0]);
-  u1 *= sqrt(sings[0]);
+  u0 << a(0), a(2), a(1), a(3);
+  u1 << b(0), b(2), b(1), b(3);
   return {u0, u1};
 }
 
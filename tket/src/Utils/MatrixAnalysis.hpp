@@ -69,6 +69,10 @@ Eigen::MatrixXcd apply_qubit_permutation(
 Eigen::VectorXcd apply_qubit_permutation(
     const Eigen::VectorXcd &v, const qubit_map_t &perm);
 
+/** As \ref apply_qubit_permutation, but permuting the rows of m in place */
+void apply_qubit_permutation_in_place(
+    Eigen::Ref<Eigen::MatrixXcd> m, const qubit_map_t &perm);
+
 std::pair<MatrixXb, MatrixXb> binary_LLT_decomposition(const MatrixXb &a);
 std::vector<std::pair<unsigned, unsigned>> gaussian_elimination_col_ops(
     const MatrixXb &a, unsigned blocksize = 6);
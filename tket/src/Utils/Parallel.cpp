@@ -0,0 +1,84 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Parallel.hpp"
+
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "Cancellation.hpp"
+
+namespace tket {
+
+static std::atomic<unsigned> &max_threads() {
+  static std::atomic<unsigned> n(0);
+  return n;
+}
+
+// Whether the current thread is running part of a parallel_for.
+static thread_local bool in_parallel_region = false;
+
+unsigned get_max_threads() {
+  unsigned n = max_threads().load(std::memory_order_relaxed);
+  if (n != 0) return n;
+  // Asking the system is slow enough to matter for small tasks.
+  static const unsigned hardware_threads = std::thread::hardware_concurrency();
+  return (hardware_threads == 0) ? 1 : hardware_threads;
+}
+
+void set_max_threads(unsigned n_threads) {
+  max_threads().store(n_threads, std::memory_order_relaxed);
+}
+
+void parallel_for(
+    std::size_t begin, std::size_t end, std::size_t min_range,
+    const std::function<void(std::size_t, std::size_t)> &body) {
+  if (end <= begin) return;
+  const std::size_t size = end - begin;
+  std::size_t n_tasks = (min_range == 0) ? size : size / min_range;
+  if (n_tasks > get_max_threads()) n_tasks = get_max_threads();
+  if (n_tasks <= 1 || in_parallel_region) {
+    body(begin, end);
+    return;
+  }
+  std::vector<std::exception_ptr> errors(n_tasks);
+  // Workers can be cancelled along with the calling thread
+  const std::optional<CancellationToken> token = current_cancellation_token();
+  auto run = [&](std::size_t task) {
+    std::size_t task_begin = begin + (size * task) / n_tasks;
+    std::size_t task_end = begin + (size * (task + 1)) / n_tasks;
+    CancellationScope scope(token);
+    in_parallel_region = true;
+    try {
+      body(task_begin, task_end);
+    } catch (...) {
+      errors[task] = std::current_exception();
+    }
+    in_parallel_region = false;
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(n_tasks - 1);
+  for (std::size_t task = 1; task < n_tasks; ++task) {
+    threads.emplace_back(run, task);
+  }
+  run(0);
+  for (std::thread &t : threads) t.join();
+  for (const std::exception_ptr &e : errors) {
+    if (e) std::rethrow_exception(e);
+  }
+}
+
+}  // namespace tket
@@ -0,0 +1,66 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Simple data parallelism over index ranges
+ */
+
+#include <cstddef>
+#include <functional>
+
+namespace tket {
+
+/**
+ * Maximum number of threads used by \ref parallel_for.
+ *
+ * Defaults to the number of hardware threads.
+ */
+unsigned get_max_threads();
+
+/**
+ * Set the maximum number of threads used by \ref parallel_for.
+ *
+ * @param n_threads maximum number of threads; 1 disables parallelism, and 0
+ *   restores the default
+ */
+void set_max_threads(unsigned n_threads);
+
+/**
+ * Apply a function to contiguous subranges of an index range, in parallel.
+ *
+ * The range [begin, end) is split into at most \ref get_max_threads
+ * subranges, each of at least \p min_range indices, and \p body is called
+ * once on each subrange. The calling thread handles one of them. If only one
+ * subrange results, or if called from within another \ref parallel_for,
+ * \p body is called on the whole range in the calling thread.
+ *
+ * \p body must be safe to call concurrently on disjoint subranges. If it
+ * throws, the first exception is rethrown once all subranges have finished.
+ * The \ref CancellationToken current in the calling thread, if any, is made
+ * current in the other threads.
+ *
+ * @param begin first index
+ * @param end one past the last index
+ * @param min_range smallest subrange worth handing to another thread
+ * @param body function called with the first and one-past-last index of
+ *   each subrange
+ */
+void parallel_for(
+    std::size_t begin, std::size_t end, std::size_t min_range,
+    const std::function<void(std::size_t, std::size_t)> &body);
+
+}  // namespace tket
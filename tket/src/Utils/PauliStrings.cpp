@@ -14,6 +14,8 @@
 
 #include "PauliStrings.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <map>
 #include <sstream>
 #include <string>
@@ -24,6 +26,7 @@
 #include "Utils/Constants.hpp"
 #include "Utils/EigenConfig.hpp"
 #include "Utils/Json.hpp"
+#include "Utils/Parallel.hpp"
 
 namespace tket {
 
@@ -151,53 +154,154 @@ CmplxSpMat operator_tensor(
   return sum;
 }
 
+/**
+ * Action of a Pauli string on a statevector without forming its matrix:
+ * with the first qubit as the most significant bit,
+ * P|j> = i^n_y (-1)^popcount(j & z) |j ^ x>
+ */
+struct PauliMasks {
+  unsigned long long x = 0;
+  unsigned long long z = 0;
+  unsigned n_y = 0;
+};
+
+static std::map<Qubit, unsigned> qubit_indices(const qubit_vector_t &qubits) {
+  std::map<Qubit, unsigned> index_map;
+  unsigned index = 0;
+  for (const Qubit &q : qubits) {
+    index_map.insert({q, index});
+    ++index;
+  }
+  if (index_map.size() != qubits.size())
+    throw std::logic_error("Qubit list given to dot_state contains repeats");
+  return index_map;
+}
+
+static PauliMasks pauli_masks(
+    const QubitPauliString &qps, const std::map<Qubit, unsigned> &index_map) {
+  const unsigned n_qubits = index_map.size();
+  PauliMasks masks;
+  for (const std::pair<const Qubit, Pauli> &pair : qps.map) {
+    std::map<Qubit, unsigned>::const_iterator found =
+        index_map.find(pair.first);
+    if (found == index_map.end())
+      throw std::logic_error(
+          "Qubit list given to dot_state doesn't contain " +
+          pair.first.repr());
+    const unsigned long long bit = 1ull << (n_qubits - 1 - found->second);
+    if (pair.second == Pauli::X || pair.second == Pauli::Y) masks.x |= bit;
+    if (pair.second == Pauli::Z || pair.second == Pauli::Y) masks.z |= bit;
+    if (pair.second == Pauli::Y) ++masks.n_y;
+  }
+  return masks;
+}
+
+static const Complex i_powers[4] = {1., i_, -1., -i_};
+
+static Eigen::VectorXcd masked_dot_state(
+    const PauliMasks &masks, const Eigen::VectorXcd &state) {
+  const unsigned long long size = state.size();
+  const Complex phase = i_powers[masks.n_y % 4];
+  Eigen::VectorXcd result(state.size());
+  for (unsigned long long j = 0; j < size; ++j) {
+    const bool odd = std::popcount(j & masks.z) & 1;
+    result[j ^ masks.x] = odd ? -phase * state[j] : phase * state[j];
+  }
+  return result;
+}
+
+static Complex masked_expectation(
+    const PauliMasks &masks, const Eigen::VectorXcd &state) {
+  // <state|P|state> = i^n_y sum_j conj(state[j ^ x]) (-1)^.. state[j];
+  // real and imaginary parts are accumulated separately so that the loop
+  // vectorises
+  const unsigned long long size = state.size();
+  const Complex *amps = state.data();
+  double re = 0.;
+  double im = 0.;
+  for (unsigned long long j = 0; j < size; ++j) {
+    const Complex a = amps[j ^ masks.x];
+    const Complex b = amps[j];
+    const double sign = (std::popcount(j & masks.z) & 1) ? -1. : 1.;
+    re += sign * (a.real() * b.real() + a.imag() * b.imag());
+    im += sign * (a.real() * b.imag() - a.imag() * b.real());
+  }
+  return i_powers[masks.n_y % 4] * Complex(re, im);
+}
+
+static qubit_vector_t default_qubits(unsigned n_qubits) {
+  qubit_vector_t qubits(n_qubits);
+  for (unsigned i = 0; i < n_qubits; ++i) {
+    qubits[i] = Qubit(i);
+  }
+  return qubits;
+}
+
+static void check_state_size(
+    const Eigen::VectorXcd &state, const qubit_vector_t &qubits) {
+  if (qubits.size() >= 64 ||
+      state.size() != Eigen::Index(1ull << qubits.size()))
+    throw std::logic_error(
+        "Size of statevector does not match number of qubits passed to "
+        "dot_state");
+}
+
 Eigen::VectorXcd QubitPauliString::dot_state(
     const Eigen::VectorXcd &state) const {
   const unsigned n_qubits = get_n_qb_from_statevector(state);
-  return (to_sparse_matrix(n_qubits) * state);
+  return dot_state(state, default_qubits(n_qubits));
 }
 
 Eigen::VectorXcd QubitPauliString::dot_state(
     const Eigen::VectorXcd &state, const qubit_vector_t &qubits) const {
-  if (state.size() != 1 << qubits.size())
-    throw std::logic_error(
-        "Size of statevector does not match number of qubits passed to "
-        "dot_state");
-  return (to_sparse_matrix(qubits) * state);
+  check_state_size(state, qubits);
+  return masked_dot_state(pauli_masks(*this, qubit_indices(qubits)), state);
 }
 
 Complex QubitPauliString::state_expectation(
     const Eigen::VectorXcd &state) const {
-  return state.dot(dot_state(state));
+  const unsigned n_qubits = get_n_qb_from_statevector(state);
+  return state_expectation(state, default_qubits(n_qubits));
 }
 
 Complex QubitPauliString::state_expectation(
     const Eigen::VectorXcd &state, const qubit_vector_t &qubits) const {
-  return state.dot(dot_state(state, qubits));
+  check_state_size(state, qubits);
+  return masked_expectation(pauli_masks(*this, qubit_indices(qubits)), state);
 }
 
 Complex operator_expectation(
     const OperatorSum &total_operator, const Eigen::VectorXcd &state) {
-  Complex exp(0, 0);
-
-  for (unsigned j = 0; j < total_operator.size(); j++) {
-    exp += total_operator[j].second *
-           total_operator[j].first.state_expectation(state);
-  }
-
-  return exp;
+  const unsigned n_qubits = get_n_qb_from_statevector(state);
+  return operator_expectation(total_operator, state, default_qubits(n_qubits));
 }
 
 Complex operator_expectation(
     const OperatorSum &total_operator, const Eigen::VectorXcd &state,
     const qubit_vector_t &qubits) {
+  check_state_size(state, qubits);
+  const std::map<Qubit, unsigned> index_map = qubit_indices(qubits);
+  std::vector<PauliMasks> masks;
+  masks.reserve(total_operator.size());
+  for (const std::pair<QubitPauliString, Complex> &term : total_operator) {
+    masks.push_back(pauli_masks(term.first, index_map));
+  }
+  // Terms are evaluated in parallel, with at least 2^16 amplitudes' work
+  // per thread, and summed in order so the result does not depend on the
+  // number of threads
+  std::vector<Complex> values(total_operator.size());
+  const std::size_t min_terms =
+      std::max<std::size_t>(1, (1ull << 16) / state.size());
+  parallel_for(
+      0, total_operator.size(), min_terms,
+      [&](std::size_t begin, std::size_t end) {
+        for (std::size_t j = begin; j < end; ++j) {
+          values[j] = total_operator[j].second *
+                      masked_expectation(masks[j], state);
+        }
+      });
   Complex exp(0, 0);
-
-  for (unsigned j = 0; j < total_operator.size(); j++) {
-    exp += total_operator[j].second *
-           total_operator[j].first.state_expectation(state, qubits);
-  }
-
+  for (const Complex &value : values) exp += value;
   return exp;
 }
 
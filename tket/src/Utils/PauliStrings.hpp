@@ -251,6 +251,13 @@ class QubitPauliString {
   CmplxSpMat to_sparse_matrix(const unsigned n_qubits) const;
   CmplxSpMat to_sparse_matrix(const qubit_vector_t &qubits) const;
 
+  /**
+   * Apply this string to a statevector, or find its expectation value,
+   * with the first of the qubits (by default q[0], q[1], ...) as the most
+   * significant bit. The string acts directly on the amplitudes as a flip
+   * of the X and Y bits with a phase from the Z and Y bits, without
+   * forming its matrix.
+   */
   Eigen::VectorXcd dot_state(const Eigen::VectorXcd &state) const;
   Eigen::VectorXcd dot_state(
       const Eigen::VectorXcd &state, const qubit_vector_t &qubits) const;
@@ -320,6 +327,8 @@ CmplxSpMat operator_tensor(
  * Calculate expectation value of QubitPauliString with respect to a state.
  * <state|Operator|state>
  *
+ * Terms are evaluated in parallel without forming their matrices.
+ *
  * @param total_operator Operator specified by sum of pauli strings
  * @param state state, encoded by a complex vector
  *
@@ -0,0 +1,187 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Trace.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include "Utils/Json.hpp"
+
+namespace tket {
+namespace trace {
+
+namespace detail {
+std::atomic<bool> enabled_flag{false};
+}  // namespace detail
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Event {
+  const char* name;
+  double ts_us;
+  double dur_us;
+  std::vector<std::pair<const char*, std::int64_t>> counters;
+  std::vector<std::pair<const char*, std::string>> args;
+};
+
+// Spans are appended to a buffer per thread, so that threads recording at
+// the same time only contend with an export
+struct ThreadBuffer {
+  unsigned tid;
+  std::mutex mutex;
+  std::vector<Event> events;
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  const Clock::time_point epoch = Clock::now();
+};
+
+// Never destroyed, so that threads may still record during shutdown
+Registry& registry() {
+  static Registry* reg = new Registry();
+  return *reg;
+}
+
+ThreadBuffer& thread_buffer() {
+  thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+    auto buf = std::make_shared<ThreadBuffer>();
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    buf->tid = unsigned(reg.buffers.size());
+    reg.buffers.push_back(buf);
+    return buf;
+  }();
+  return *buffer;
+}
+
+thread_local Span* current_span = nullptr;
+
+double micros(Clock::duration d) {
+  return std::chrono::duration<double, std::micro>(d).count();
+}
+
+}  // namespace
+
+void set_enabled(bool enable) {
+  // Create the registry first, so that the epoch precedes every span
+  registry();
+  detail::enabled_flag.store(enable, std::memory_order_relaxed);
+}
+
+void clear() {
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  for (const std::shared_ptr<ThreadBuffer>& buf : reg.buffers) {
+    std::lock_guard<std::mutex> buf_lock(buf->mutex);
+    buf->events.clear();
+  }
+}
+
+std::size_t n_recorded() {
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  std::size_t n = 0;
+  for (const std::shared_ptr<ThreadBuffer>& buf : reg.buffers) {
+    std::lock_guard<std::mutex> buf_lock(buf->mutex);
+    n += buf->events.size();
+  }
+  return n;
+}
+
+std::string chrome_json() {
+  nlohmann::json events = nlohmann::json::array();
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  for (const std::shared_ptr<ThreadBuffer>& buf : reg.buffers) {
+    std::lock_guard<std::mutex> buf_lock(buf->mutex);
+    for (const Event& event : buf->events) {
+      nlohmann::json args = nlohmann::json::object();
+      for (const auto& [key, value] : event.counters) args[key] = value;
+      for (const auto& [key, value] : event.args) args[key] = value;
+      events.push_back(
+          {{"name", event.name},
+           {"cat", "tket"},
+           {"ph", "X"},
+           {"ts", event.ts_us},
+           {"dur", event.dur_us},
+           {"pid", 1},
+           {"tid", buf->tid},
+           {"args", args}});
+    }
+  }
+  nlohmann::json j;
+  j["traceEvents"] = events;
+  j["displayTimeUnit"] = "ms";
+  return j.dump();
+}
+
+void write_chrome_json(const std::string& filename) {
+  std::ofstream out(filename);
+  if (!out) throw std::runtime_error("Cannot open trace file " + filename);
+  out << chrome_json();
+}
+
+void Span::start(const char* name) {
+  active_ = true;
+  name_ = name;
+  parent_ = current_span;
+  current_span = this;
+  start_ = Clock::now();
+}
+
+void Span::finish() {
+  const Clock::time_point end = Clock::now();
+  current_span = parent_;
+  Event event{
+      name_, micros(start_ - registry().epoch), micros(end - start_),
+      std::move(counters_), std::move(args_)};
+  ThreadBuffer& buf = thread_buffer();
+  std::lock_guard<std::mutex> lock(buf.mutex);
+  buf.events.push_back(std::move(event));
+}
+
+void Span::count(const char* counter, std::int64_t n) {
+  if (!active_) return;
+  for (std::pair<const char*, std::int64_t>& entry : counters_) {
+    if (std::strcmp(entry.first, counter) == 0) {
+      entry.second += n;
+      return;
+    }
+  }
+  counters_.push_back({counter, n});
+}
+
+void Span::arg(const char* key, std::string value) {
+  if (!active_) return;
+  args_.push_back({key, std::move(value)});
+}
+
+void count(const char* counter, std::int64_t n) {
+  if (current_span) current_span->count(counter, n);
+}
+
+void arg(const char* key, std::string value) {
+  if (current_span) current_span->arg(key, std::move(value));
+}
+
+}  // namespace trace
+}  // namespace tket
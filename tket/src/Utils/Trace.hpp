@@ -0,0 +1,145 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Tracing of compilation internals
+ *
+ * A \ref trace::Span records the time spent in a scope, together with
+ * counters incremented by the code it encloses (e.g. routing iterations or
+ * rewrites applied). Recorded spans can be exported as Chrome trace event
+ * JSON, which chrome://tracing and Perfetto can display.
+ *
+ * Recording is off until \ref trace::set_enabled is called; while it is off
+ * a span costs one relaxed atomic load. Library code uses the TKET_TRACE_*
+ * macros, which compile to nothing unless TKET_TRACING is defined (the CMake
+ * option of the same name).
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tket {
+namespace trace {
+
+namespace detail {
+extern std::atomic<bool> enabled_flag;
+}  // namespace detail
+
+/** Whether spans are being recorded */
+inline bool enabled() {
+  return detail::enabled_flag.load(std::memory_order_relaxed);
+}
+
+/** Start or stop recording spans. Safe to call from any thread. */
+void set_enabled(bool enable);
+
+/** Discard all recorded spans */
+void clear();
+
+/** Number of spans recorded so far, over all threads */
+std::size_t n_recorded();
+
+/**
+ * Recorded spans as Chrome trace event JSON, with one complete ("X") event
+ * per span, whose args are the span's counters and string arguments
+ */
+std::string chrome_json();
+
+/** Write \ref chrome_json to a file */
+void write_chrome_json(const std::string& filename);
+
+/**
+ * Records the time between its construction and destruction, if recording
+ * is enabled at construction.
+ *
+ * The innermost live span of each thread receives the counters and
+ * arguments given to \ref count and \ref arg in that thread. Names and
+ * counter names must be string literals (or otherwise outlive the
+ * recording).
+ */
+class Span {
+ public:
+  explicit Span(const char* name) {
+    if (enabled()) start(name);
+  }
+  ~Span() {
+    if (active_) finish();
+  }
+  Span(const Span&) = delete;
+  Span& operator=(const Span&) = delete;
+
+  bool active() const { return active_; }
+
+  /** Add n to the named counter of this span */
+  void count(const char* counter, std::int64_t n = 1);
+
+  /** Attach a string argument to this span */
+  void arg(const char* key, std::string value);
+
+ private:
+  void start(const char* name);
+  void finish();
+
+  bool active_ = false;
+  const char* name_ = nullptr;
+  std::chrono::steady_clock::time_point start_;
+  Span* parent_ = nullptr;
+  std::vector<std::pair<const char*, std::int64_t>> counters_;
+  std::vector<std::pair<const char*, std::string>> args_;
+};
+
+/** Add n to the named counter of the innermost live span of this thread */
+void count(const char* counter, std::int64_t n = 1);
+
+/** Attach a string argument to the innermost live span of this thread */
+void arg(const char* key, std::string value);
+
+}  // namespace trace
+}  // namespace tket
+
+#define TKET_TRACE_CONCAT_(a, b) a##b
+#define TKET_TRACE_CONCAT(a, b) TKET_TRACE_CONCAT_(a, b)
+
+#ifdef TKET_TRACING
+/** Record a span named by a string literal until the end of the scope */
+#define TKET_TRACE_SPAN(name) \
+  ::tket::trace::Span TKET_TRACE_CONCAT(tket_trace_span_, __LINE__)(name)
+/** Add to a counter of the innermost span; n is not evaluated if disabled */
+#define TKET_TRACE_COUNT(counter, n)                                \
+  do {                                                              \
+    if (::tket::trace::enabled()) ::tket::trace::count(counter, n); \
+  } while (false)
+/** Attach a string to the innermost span; not evaluated if disabled */
+#define TKET_TRACE_ARG(key, value)                                \
+  do {                                                            \
+    if (::tket::trace::enabled()) ::tket::trace::arg(key, value); \
+  } while (false)
+#else
+#define TKET_TRACE_SPAN(name) \
+  do {                        \
+  } while (false)
+#define TKET_TRACE_COUNT(counter, n) \
+  do {                               \
+  } while (false)
+#define TKET_TRACE_ARG(key, value) \
+  do {                             \
+  } while (false)
+#endif
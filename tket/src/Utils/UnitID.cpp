@@ -14,7 +14,11 @@
 
 #include "UnitID.hpp"
 
+#include <memory>
+#include <regex>
+#include <shared_mutex>
 #include <sstream>
+#include <unordered_map>
 
 #include "Json.hpp"
 
@@ -33,6 +37,42 @@ std::string UnitID::repr() const {
   return str.str();
 }
 
+const UnitID::UnitData* UnitID::intern(
+    const std::string& name, const std::vector<unsigned>& index) {
+  typedef std::unordered_map<
+      std::string,
+      std::map<std::vector<unsigned>, std::unique_ptr<const UnitData>>>
+      table_t;
+  // Never destroyed, so that units remain valid during static
+  // deinitialization.
+  static table_t* table = new table_t();
+  static std::shared_mutex* mutex = new std::shared_mutex();
+
+  {
+    std::shared_lock<std::shared_mutex> lock(*mutex);
+    table_t::const_iterator reg = table->find(name);
+    if (reg != table->end()) {
+      auto found = reg->second.find(index);
+      if (found != reg->second.end()) return found->second.get();
+    }
+  }
+  std::unique_lock<std::shared_mutex> lock(*mutex);
+  auto [reg, new_reg] = table->try_emplace(name);
+  if (new_reg) {
+    static const std::string id_regex_str = "[a-z][A-Za-z0-9_]*";
+    static const std::regex id_regex(id_regex_str);
+    if (!name.empty() && !std::regex_match(name, id_regex)) {
+      std::stringstream msg;
+      msg << "UnitID name '" << name << "' does not match '" << id_regex_str
+          << "', as required for QASM conversion.";
+      tket_log()->warn(msg.str());
+    }
+  }
+  std::unique_ptr<const UnitData>& entry = reg->second[index];
+  if (!entry) entry = std::make_unique<const UnitData>(UnitData{name, index});
+  return entry.get();
+}
+
 void to_json(nlohmann::json& j, const Qubit& qb) { unitid_to_json(j, qb); }
 void from_json(const nlohmann::json& j, Qubit& qb) { json_to_unitid(j, qb); }
 
@@ -100,4 +140,10 @@ const std::string& c_debug_default_name() {
   return *regname;
 }
 
+const std::string& q_debug_ancilla_reg() {
+  static std::unique_ptr<const std::string> regname =
+      std::make_unique<const std::string>("tk_DEBUG_ANCILLA");
+  return *regname;
+}
+
 }  // namespace tket
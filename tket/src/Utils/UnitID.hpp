@@ -22,7 +22,6 @@
 #include <boost/functional/hash.hpp>
 #include <map>
 #include <optional>
-#include <regex>
 #include <set>
 #include <sstream>
 #include <string>
@@ -47,6 +46,7 @@ const std::string &node_default_reg();
 const std::string &c_debug_zero_prefix();
 const std::string &c_debug_one_prefix();
 const std::string &c_debug_default_name();
+const std::string &q_debug_ancilla_reg();
 
 /** Conversion invalid */
 class InvalidUnitConversion : public std::logic_error {
@@ -60,10 +60,15 @@ class InvalidUnitConversion : public std::logic_error {
  *
  * Each location has a name (signifying the 'register' to which it belongs) and
  * an index within that register (which may be multi-dimensional).
+ *
+ * The name and index are interned: every distinct (name, index) pair is
+ * stored once, in a global table, and a UnitID refers to its entry by
+ * pointer. Copying, equality and hashing therefore take constant time and no
+ * reference counting. Entries are never released.
  */
 class UnitID {
  public:
-  UnitID() : data_(std::make_shared<UnitData>()) {}
+  UnitID() : data_(intern("", {})), type_(UnitType::Qubit) {}
 
   /** String representation including name and index */
   std::string repr() const;
@@ -78,59 +83,50 @@ class UnitID {
   std::vector<unsigned> index() const { return data_->index_; }
 
   /** Unit type */
-  UnitType type() const { return data_->type_; }
+  UnitType type() const { return type_; }
 
   /** Register dimension and type */
   register_info_t reg_info() const { return {type(), reg_dim()}; }
 
   bool operator<(const UnitID &other) const {
+    if (data_ == other.data_) return false;
     int n = data_->name_.compare(other.data_->name_);
     if (n > 0) return false;
     if (n < 0) return true;
     return data_->index_ < other.data_->index_;
   }
-  bool operator==(const UnitID &other) const {
-    return (this->data_->name_ == other.data_->name_) &&
-           (this->data_->index_ == other.data_->index_);
-  }
+  bool operator==(const UnitID &other) const { return data_ == other.data_; }
   bool operator!=(const UnitID &other) const { return !(*this == other); }
 
   friend std::size_t hash_value(UnitID const &unitid) {
-    size_t seed = 0;
-    boost::hash_combine(seed, unitid.data_->name_);
-    boost::hash_combine(seed, unitid.data_->index_);
-    boost::hash_combine(seed, unitid.data_->type_);
-    return seed;
+    return boost::hash_value(unitid.data_);
   }
 
  protected:
   UnitID(
       const std::string &name, const std::vector<unsigned> &index,
       UnitType type)
-      : data_(std::make_shared<UnitData>(name, index, type)) {}
+      : data_(intern(name, index)), type_(type) {}
 
  private:
   struct UnitData {
     std::string name_;
     std::vector<unsigned> index_;
-    UnitType type_;
-
-    UnitData() : name_(), index_(), type_(UnitType::Qubit) {}
-    UnitData(
-        const std::string &name, const std::vector<unsigned> &index,
-        UnitType type)
-        : name_(name), index_(index), type_(type) {
-      static const std::string id_regex_str = "[a-z][A-Za-z0-9_]*";
-      static const std::regex id_regex(id_regex_str);
-      if (!name.empty() && !std::regex_match(name, id_regex)) {
-        std::stringstream msg;
-        msg << "UnitID name '" << name << "' does not match '" << id_regex_str
-            << "', as required for QASM conversion.";
-        tket_log()->warn(msg.str());
-      }
-    }
   };
-  std::shared_ptr<UnitData> data_;
+
+  /**
+   * Entry of the intern table for a name and index.
+   *
+   * The name is checked against the identifier syntax required for QASM
+   * when it is first interned.
+   *
+   * Thread-safe.
+   */
+  static const UnitData *intern(
+      const std::string &name, const std::vector<unsigned> &index);
+
+  const UnitData *data_;
+  UnitType type_;
 };
 
 template <class Unit_T>
@@ -0,0 +1,268 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ZX/CompactZXGraph.hpp"
+
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+
+#include "Utils/GraphHeaders.hpp"
+
+namespace tket {
+
+namespace zx {
+
+bool CompactZXGraph::is_graph_like(const ZXDiagram& diag) {
+  BGL_FORALL_VERTICES(v, *diag.graph, ZXGraph) {
+    ZXType type = diag.get_zxtype(v);
+    if (type != ZXType::ZSpider && !is_boundary_type(type)) return false;
+  }
+  std::set<std::pair<ZXVert, ZXVert>> spider_pairs;
+  BGL_FORALL_EDGES(w, *diag.graph, ZXGraph) {
+    ZXVert s = diag.source(w);
+    ZXVert t = diag.target(w);
+    if (s == t) return false;
+    if (is_boundary_type(diag.get_zxtype(s)) ||
+        is_boundary_type(diag.get_zxtype(t)))
+      continue;
+    if (diag.get_wire_type(w) != ZXWireType::H) return false;
+    if (!spider_pairs.insert({std::min(s, t), std::max(s, t)}).second)
+      return false;
+  }
+  return true;
+}
+
+CompactZXGraph::CompactZXGraph(const ZXDiagram& diag) {
+  if (!is_graph_like(diag))
+    throw ZXError("CompactZXGraph requires a graph-like diagram");
+  std::unordered_map<ZXVert, unsigned> index;
+  BGL_FORALL_VERTICES(v, *diag.graph, ZXGraph) {
+    index.insert({v, verts_.size()});
+    verts_.push_back(v);
+    bool is_b = is_boundary_type(diag.get_zxtype(v));
+    boundary_.push_back(is_b);
+    qtypes_.push_back(*diag.get_qtype(v));
+    phases_.push_back(
+        is_b ? ZXPhase() : diag.get_vertex_ZXGen<BasicGen>(v).get_phase());
+  }
+  const unsigned n = verts_.size();
+  n_copied_ = n;
+  removed_.assign(n, false);
+  phase_changed_.assign(n, false);
+  adj_.resize(n);
+  BGL_FORALL_EDGES(w, *diag.graph, ZXGraph) {
+    unsigned s = index.at(diag.source(w));
+    unsigned t = index.at(diag.target(w));
+    adj_[s].push_back(t);
+    adj_[t].push_back(s);
+  }
+  for (std::vector<unsigned>& ns : adj_) std::sort(ns.begin(), ns.end());
+}
+
+unsigned CompactZXGraph::n_vertices() const { return verts_.size(); }
+
+bool CompactZXGraph::is_removed(unsigned v) const { return removed_.at(v); }
+
+bool CompactZXGraph::is_boundary(unsigned v) const { return boundary_.at(v); }
+
+QuantumType CompactZXGraph::get_qtype(unsigned v) const {
+  return qtypes_.at(v);
+}
+
+const ZXPhase& CompactZXGraph::get_phase(unsigned v) const {
+  return phases_.at(v);
+}
+
+void CompactZXGraph::set_phase(unsigned v, const ZXPhase& phase) {
+  if (boundary_.at(v)) throw ZXError("Cannot set the phase of a boundary");
+  phases_[v] = phase;
+  phase_changed_[v] = true;
+}
+
+bool CompactZXGraph::is_pauli_spider(unsigned v) const {
+  if (boundary_.at(v)) return false;
+  return phases_[v].is_pauli();
+}
+
+bool CompactZXGraph::is_proper_clifford_spider(unsigned v) const {
+  if (boundary_.at(v)) return false;
+  return phases_[v].is_proper_clifford();
+}
+
+const std::vector<unsigned>& CompactZXGraph::neighbours(unsigned v) const {
+  return adj_.at(v);
+}
+
+bool CompactZXGraph::edge_exists(unsigned u, unsigned v) const {
+  return std::binary_search(adj_.at(u).begin(), adj_.at(u).end(), v);
+}
+
+// Insert `v` into the sorted vector `ns` if absent, or remove it if present
+static void toggle_in(std::vector<unsigned>& ns, unsigned v) {
+  std::vector<unsigned>::iterator it =
+      std::lower_bound(ns.begin(), ns.end(), v);
+  if (it != ns.end() && *it == v)
+    ns.erase(it);
+  else
+    ns.insert(it, v);
+}
+
+void CompactZXGraph::toggle_edge(unsigned u, unsigned v) {
+  if (u == v || boundary_.at(u) || boundary_.at(v) || removed_.at(u) ||
+      removed_.at(v))
+    throw ZXError("CompactZXGraph can only toggle edges between two spiders");
+  toggle_in(adj_[u], v);
+  toggle_in(adj_[v], u);
+}
+
+// Replace the sorted vector `ns` by its symmetric difference with the sorted
+// `others`, leaving out `self` and, if `quantum_only`, Classical vertices
+static void toggle_all_in(
+    std::vector<unsigned>& ns, const std::vector<unsigned>& others,
+    unsigned self, bool quantum_only, const std::vector<QuantumType>& qtypes) {
+  std::vector<unsigned> result;
+  result.reserve(ns.size() + others.size());
+  std::vector<unsigned>::const_iterator a = ns.begin();
+  for (unsigned b : others) {
+    if (b == self || (quantum_only && qtypes[b] == QuantumType::Classical))
+      continue;
+    while (a != ns.end() && *a < b) result.push_back(*a++);
+    if (a != ns.end() && *a == b)
+      ++a;
+    else
+      result.push_back(b);
+  }
+  result.insert(result.end(), a, ns.end());
+  ns.swap(result);
+}
+
+void CompactZXGraph::complement(
+    const std::vector<unsigned>& verts, QuantumType qtype) {
+  for (unsigned v : verts) {
+    if (boundary_.at(v) || removed_.at(v))
+      throw ZXError("CompactZXGraph can only toggle edges between two spiders");
+  }
+  for (unsigned v : verts) {
+    toggle_all_in(
+        adj_[v], verts, v,
+        qtype == QuantumType::Quantum &&
+            qtypes_[v] == QuantumType::Classical,
+        qtypes_);
+  }
+}
+
+void CompactZXGraph::complement_bipartite(
+    const std::vector<unsigned>& sa, const std::vector<unsigned>& sb,
+    QuantumType qtype) {
+  for (const std::vector<unsigned>* side : {&sa, &sb}) {
+    for (unsigned v : *side) {
+      if (boundary_.at(v) || removed_.at(v))
+        throw ZXError(
+            "CompactZXGraph can only toggle edges between two spiders");
+    }
+  }
+  for (unsigned a : sa) {
+    toggle_all_in(
+        adj_[a], sb, a,
+        qtype == QuantumType::Quantum &&
+            qtypes_[a] == QuantumType::Classical,
+        qtypes_);
+  }
+  for (unsigned b : sb) {
+    toggle_all_in(
+        adj_[b], sa, b,
+        qtype == QuantumType::Quantum &&
+            qtypes_[b] == QuantumType::Classical,
+        qtypes_);
+  }
+}
+
+void CompactZXGraph::remove_vertex(unsigned v) {
+  for (unsigned n : adj_.at(v)) {
+    std::vector<unsigned>& n_ns = adj_[n];
+    n_ns.erase(std::lower_bound(n_ns.begin(), n_ns.end(), v));
+  }
+  adj_[v].clear();
+  removed_[v] = true;
+}
+
+unsigned CompactZXGraph::add_spider(
+    const ZXPhase& phase, QuantumType qtype) {
+  unsigned v = verts_.size();
+  verts_.push_back(ZXVert());
+  phases_.push_back(phase);
+  qtypes_.push_back(qtype);
+  boundary_.push_back(false);
+  removed_.push_back(false);
+  phase_changed_.push_back(true);
+  adj_.emplace_back();
+  return v;
+}
+
+ZXVert CompactZXGraph::get_vertex(unsigned v) const {
+  if (v >= n_copied_)
+    throw ZXError("Spider was added to the CompactZXGraph after copying");
+  return verts_[v];
+}
+
+void CompactZXGraph::apply_to(ZXDiagram& diag) const {
+  std::vector<ZXVert> verts(verts_);
+  std::unordered_map<ZXVert, unsigned> index;
+  for (unsigned v = 0; v < n_copied_; ++v) index.insert({verts[v], v});
+  for (unsigned v = 0; v < n_copied_; ++v) {
+    if (removed_[v]) diag.remove_vertex(verts[v]);
+  }
+  for (unsigned v = n_copied_; v < verts.size(); ++v) {
+    if (removed_[v]) continue;
+    verts[v] = diag.add_vertex(std::make_shared<const BasicGen>(
+        ZXType::ZSpider, phases_[v], qtypes_[v]));
+    index.insert({verts[v], v});
+  }
+  for (unsigned v = 0; v < verts.size(); ++v) {
+    if (removed_[v]) continue;
+    if (phase_changed_[v] && v < n_copied_) {
+      diag.set_vertex_ZXGen_ptr(
+          verts[v], std::make_shared<const BasicGen>(
+                        ZXType::ZSpider, phases_[v], qtypes_[v]));
+    }
+    // Remove the wires to later vertices which have been toggled off, and
+    // add the toggled on ones
+    std::vector<unsigned> existing;
+    WireVec to_remove;
+    for (const Wire& w : diag.adj_wires_range(verts[v])) {
+      unsigned u = index.at(diag.other_end(w, verts[v]));
+      if (u < v) continue;
+      if (edge_exists(v, u))
+        existing.push_back(u);
+      else
+        to_remove.push_back(w);
+    }
+    for (const Wire& w : to_remove) diag.remove_wire(w);
+    std::sort(existing.begin(), existing.end());
+    for (unsigned u : adj_[v]) {
+      if (u < v || std::binary_search(existing.begin(), existing.end(), u))
+        continue;
+      QuantumType qtype = (qtypes_[u] == QuantumType::Classical &&
+                           qtypes_[v] == QuantumType::Classical)
+                              ? QuantumType::Classical
+                              : QuantumType::Quantum;
+      diag.add_wire(verts[v], verts[u], ZXWireType::H, qtype);
+    }
+  }
+}
+
+}  // namespace zx
+
+}  // namespace tket
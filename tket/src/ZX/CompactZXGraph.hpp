@@ -0,0 +1,127 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ZX/ZXDiagram.hpp"
+
+namespace tket {
+
+namespace zx {
+
+/**
+ * Index-based copy of a graph-like ZXDiagram, for rewrites which make many
+ * neighbourhood queries and edge toggles.
+ *
+ * A diagram is graph-like here if every vertex is either a boundary or a
+ * ZSpider, and any two spiders are joined by at most one wire, which is a
+ * Hadamard wire between distinct spiders. The vertices are numbered in the
+ * order of the diagram's underlying graph; each spider's phase and
+ * QuantumType are stored inline, and each vertex's neighbours are kept in a
+ * sorted vector, so queries do not allocate.
+ *
+ * Rewrites work on the copy, then `apply_to` writes the changes back to the
+ * original diagram, preserving the vertices and wires that are unchanged.
+ * Modifications which touch disjoint sets of vertices (including the
+ * neighbourhoods they change) may be made from different threads.
+ */
+class CompactZXGraph {
+ public:
+  // Whether `diag` is graph-like in the above sense
+  static bool is_graph_like(const ZXDiagram& diag);
+
+  // Copy a graph-like diagram; throws ZXError if it is not graph-like
+  explicit CompactZXGraph(const ZXDiagram& diag);
+
+  // Number of vertices, including those removed since construction
+  unsigned n_vertices() const;
+
+  bool is_removed(unsigned v) const;
+  bool is_boundary(unsigned v) const;
+  QuantumType get_qtype(unsigned v) const;
+  const ZXPhase& get_phase(unsigned v) const;
+  void set_phase(unsigned v, const ZXPhase& phase);
+
+  // Same conditions as the corresponding `ZXDiagram` methods
+  bool is_pauli_spider(unsigned v) const;
+  bool is_proper_clifford_spider(unsigned v) const;
+
+  // Neighbours of `v` in increasing order
+  const std::vector<unsigned>& neighbours(unsigned v) const;
+  bool edge_exists(unsigned u, unsigned v) const;
+
+  /**
+   * Removes the wire between spiders `u` and `v` if there is one, and adds a
+   * Hadamard wire otherwise. When written back, a new wire is Classical if
+   * both ends are Classical and Quantum otherwise.
+   */
+  void toggle_edge(unsigned u, unsigned v);
+
+  /**
+   * Toggles the wire between every pair of the spiders `verts`, which must be
+   * sorted. When `qtype` is Quantum, pairs of Classical spiders are left
+   * alone, as toggling would give them a doubled wire. Each neighbourhood is
+   * updated by a single merge with `verts`, rather than an insertion per
+   * wire.
+   */
+  void complement(const std::vector<unsigned>& verts, QuantumType qtype);
+
+  /**
+   * Toggles the wire between every spider of `sa` and every spider of `sb`,
+   * which must be sorted and disjoint, skipping Classical pairs as above.
+   */
+  void complement_bipartite(
+      const std::vector<unsigned>& sa, const std::vector<unsigned>& sb,
+      QuantumType qtype);
+
+  // Removes `v` along with all of its wires
+  void remove_vertex(unsigned v);
+
+  /**
+   * Adds a spider with no wires, numbered after all existing vertices. When
+   * written back, it becomes a new ZSpider of the diagram.
+   */
+  unsigned add_spider(
+      const ZXPhase& phase, QuantumType qtype = QuantumType::Quantum);
+
+  // Vertex of the copied diagram numbered `v`; throws ZXError for a spider
+  // added since construction
+  ZXVert get_vertex(unsigned v) const;
+
+  /**
+   * Updates `diag`, which must be the diagram this was copied from (with no
+   * changes since), to match this graph.
+   */
+  void apply_to(ZXDiagram& diag) const;
+
+ private:
+  std::vector<ZXVert> verts_;
+  std::vector<ZXPhase> phases_;
+  std::vector<QuantumType> qtypes_;
+  std::vector<bool> boundary_;
+  // Bytes rather than bits, so that rewrites touching disjoint vertices can
+  // run concurrently
+  std::vector<std::uint8_t> removed_;
+  std::vector<std::uint8_t> phase_changed_;
+  std::vector<std::vector<unsigned>> adj_;
+  // Number of vertices copied from the diagram
+  unsigned n_copied_;
+};
+
+}  // namespace zx
+
+}  // namespace tket
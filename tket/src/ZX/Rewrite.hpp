@@ -43,6 +43,16 @@ class Rewrite {
   typedef std::function<bool(ZXDiagram&)> RewriteFun;
   typedef std::function<unsigned(const ZXDiagram&)> Metric;
 
+  /**
+   * A rewrite rule matched at a single vertex, for use with `worklist`.
+   * If the rule matches at the vertex, it performs the rewrite and returns
+   * true. It must then add to the worklist every remaining vertex (including
+   * the given one) at which a rule may newly match, and erase from it every
+   * vertex it removes.
+   */
+  typedef std::function<bool(ZXDiagram&, const ZXVert&, ZXVertSeqSet&)>
+      LocalRewriteFun;
+
   /**
    * The actual rewrite to be applied.
    * Performs the rewrite in place (optionally restricted to some subdiagram)
@@ -56,9 +66,24 @@ class Rewrite {
 
   static Rewrite sequence(const std::vector<Rewrite>& rvec);
   static Rewrite repeat(const Rewrite& rw);
+  /**
+   * Applies `rw` for as long as each application strictly decreases the
+   * metric. The application which fails to is undone through the diagram's
+   * journal, so the diagram is never copied.
+   */
   static Rewrite repeat_with_metric(const Rewrite& rw, const Metric& eval);
   static Rewrite repeat_while(const Rewrite& cond, const Rewrite& body);
 
+  /**
+   * Applies the local rules until none of them matches anywhere.
+   * Every vertex is visited once; afterwards only the vertices queued by a
+   * successful rewrite are revisited, so the cost scales with the number of
+   * rewrites performed rather than with the number of sweeps over the whole
+   * diagram as for `repeat`. At each vertex, the first matching rule in
+   * `rules` is applied.
+   */
+  static Rewrite worklist(const std::vector<LocalRewriteFun>& rules);
+
   //////////////////
   // Decompositions//
   //////////////////
@@ -107,6 +132,14 @@ class Rewrite {
    */
   static Rewrite parallel_h_removal();
 
+  // Local forms of the above rules for `worklist`
+  static bool spider_fusion_at(
+      ZXDiagram& diag, const ZXVert& v, ZXVertSeqSet& worklist);
+  static bool self_loop_removal_at(
+      ZXDiagram& diag, const ZXVert& v, ZXVertSeqSet& worklist);
+  static bool parallel_h_removal_at(
+      ZXDiagram& diag, const ZXVert& v, ZXVertSeqSet& worklist);
+
   /////////////////
   // GraphLikeForm//
   /////////////////
@@ -125,6 +158,14 @@ class Rewrite {
    */
   static Rewrite io_extension();
 
+  /**
+   * Brings a diagram of ZX spiders into graph-like form: every vertex is a
+   * boundary or a ZSpider, spiders are joined by at most one wire which is a
+   * Hadamard wire, and each boundary has a Basic wire to a spider adjacent to
+   * no other boundary.
+   */
+  static Rewrite to_graphlike_form();
+
   ///////////////////////////
   // GraphLikeSimplification//
   ///////////////////////////
@@ -136,6 +177,10 @@ class Rewrite {
    */
   static Rewrite remove_interior_cliffords();
 
+  // Local form of `remove_interior_cliffords` for `worklist`
+  static bool remove_interior_cliffords_at(
+      ZXDiagram& diag, const ZXVert& v, ZXVertSeqSet& worklist);
+
   /**
    * Removes adjacent interior Paulis (spiders where the phase is an integer
    * multiple of pi). Pivots about the edge connecting the vertices and removes
@@ -150,6 +195,13 @@ class Rewrite {
    */
   static Rewrite extend_at_boundary_paulis();
 
+  /**
+   * Removes interior proper Cliffords and pairs of adjacent interior Paulis
+   * from a graph-like diagram until neither applies. Both preserve the
+   * existence of a gflow, so a diagram from a circuit stays extractable.
+   */
+  static Rewrite reduce_graphlike_form();
+
  private:
   Rewrite(const RewriteFun& fun);
 
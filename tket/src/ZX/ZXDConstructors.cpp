@@ -59,12 +59,14 @@ ZXDiagram::ZXDiagram(const ZXDiagram& other) : ZXDiagram() {
 ZXDiagram::ZXDiagram(ZXDiagram&& other)
     : graph(std::move(other.graph)),
       boundary(std::move(other.boundary)),
-      scalar(std::move(other.scalar)) {}
+      scalar(std::move(other.scalar)),
+      journal(std::move(other.journal)) {}
 
 ZXDiagram& ZXDiagram::operator=(const ZXDiagram& other) {
   this->graph->clear();
   this->boundary.clear();
   this->scalar = 1.;
+  this->journal.reset();
 
   this->copy_graph(other, true);
 
@@ -75,6 +77,7 @@ ZXDiagram& ZXDiagram::operator=(ZXDiagram&& other) {
   this->graph = std::move(other.graph);
   this->boundary = std::move(other.boundary);
   this->scalar = std::move(other.scalar);
+  this->journal = std::move(other.journal);
 
   return *this;
 }
@@ -65,15 +65,15 @@ ZXDiagram ZXDiagram::to_doubled_diagram() const {
           case ZXType::XSpider: {
             const BasicGen& bg = static_cast<const BasicGen&>(*op);
             orig_op = std::make_shared<const BasicGen>(
-                op->get_type(), bg.get_param(), QuantumType::Classical);
+                op->get_type(), bg.get_phase(), QuantumType::Classical);
             conj_op = std::make_shared<const BasicGen>(
-                op->get_type(), -bg.get_param(), QuantumType::Classical);
+                op->get_type(), -bg.get_phase(), QuantumType::Classical);
             break;
           }
           case ZXType::Hbox: {
             const BasicGen& bg = static_cast<const BasicGen&>(*op);
             orig_op = std::make_shared<const BasicGen>(
-                op->get_type(), bg.get_param(), QuantumType::Classical);
+                op->get_type(), bg.get_phase(), QuantumType::Classical);
             conj_op = std::make_shared<const BasicGen>(
                 op->get_type(), SymEngine::conjugate(bg.get_param()),
                 QuantumType::Classical);
@@ -40,7 +40,18 @@ ZXVertVec ZXDiagram::get_boundary(
 
 const Expr& ZXDiagram::get_scalar() const { return scalar; }
 
-void ZXDiagram::multiply_scalar(const Expr& sc) { scalar *= sc; }
+void ZXDiagram::multiply_scalar(const Expr& sc) {
+  if (journal) {
+    JournalEntry e{JournalEntry::Kind::SetScalar};
+    e.scalar = scalar;
+    journal->push_back(std::move(e));
+  }
+  scalar *= sc;
+}
+
+void ZXDiagram::multiply_scalar_phase(const Expr& phase) {
+  multiply_scalar(SymEngine::exp(phase * SymEngine::I * SymEngine::pi));
+}
 
 unsigned ZXDiagram::n_vertices() const { return boost::num_vertices(*graph); }
 
@@ -76,18 +87,24 @@ ZXVertVec ZXDiagram::neighbours(const ZXVert& v) const {
 }
 
 WireVec ZXDiagram::adj_wires(const ZXVert& v) const {
-  WireVec adj;
-  BGL_FORALL_OUTEDGES(v, w, *graph, ZXGraph) adj.push_back(w);
-  BGL_FORALL_INEDGES(v, w, *graph, ZXGraph) {
-    // Only add self loops once (ignore the in_edge wires for loops)
-    if (source(w) != v) adj.push_back(w);
-  }
-  return adj;
+  AdjWireRange range = adj_wires_range(v);
+  return WireVec(range.begin(), range.end());
+}
+
+AdjWireRange ZXDiagram::adj_wires_range(const ZXVert& v) const {
+  return AdjWireRange(
+      AdjWireIterator(*graph, v, false), AdjWireIterator(*graph, v, true));
+}
+
+AdjVertRange ZXDiagram::neighbours_range(const ZXVert& v) const {
+  AdjWireRange wires = adj_wires_range(v);
+  return AdjVertRange(
+      AdjVertIterator(wires.begin()), AdjVertIterator(wires.end()));
 }
 
 WireVec ZXDiagram::wires_between(const ZXVert& u, const ZXVert& v) const {
   WireVec wires;
-  for (const Wire& w : adj_wires(u)) {
+  for (const Wire& w : adj_wires_range(u)) {
     ZXVert other = other_end(w, u);
     if (other == v) wires.push_back(w);
   }
@@ -145,6 +162,11 @@ std::optional<QuantumType> ZXDiagram::get_qtype(const ZXVert& v) const {
 }
 
 void ZXDiagram::set_vertex_ZXGen_ptr(const ZXVert& v, const ZXGen_ptr& op) {
+  if (journal) {
+    JournalEntry e{JournalEntry::Kind::SetVertexGen, v};
+    e.op = (*graph)[v].op;
+    journal->push_back(std::move(e));
+  }
   (*graph)[v].op = op;
 }
 
@@ -199,38 +221,44 @@ WireEnd ZXDiagram::end_of(const Wire& w, const ZXVert& u) const {
 }
 
 void ZXDiagram::set_wire_info(const Wire& w, const WireProperties& wp) {
+  if (journal) {
+    JournalEntry e{JournalEntry::Kind::SetWireInfo};
+    e.wire = w;
+    e.props = (*graph)[w];
+    journal->push_back(std::move(e));
+  }
   (*graph)[w] = wp;
 }
 
 void ZXDiagram::set_wire_qtype(const Wire& w, QuantumType qtype) {
-  (*graph)[w].qtype = qtype;
+  WireProperties wp = get_wire_info(w);
+  wp.qtype = qtype;
+  set_wire_info(w, wp);
 }
 
 void ZXDiagram::set_wire_type(const Wire& w, ZXWireType type) {
-  (*graph)[w].type = type;
+  WireProperties wp = get_wire_info(w);
+  wp.type = type;
+  set_wire_info(w, wp);
 }
 
 bool ZXDiagram::is_pauli_spider(const ZXVert& v) const {
   ZXGen_ptr op = get_vertex_ZXGen_ptr(v);
   if (!is_spider_type(op->get_type())) return false;
   const BasicGen& bg = static_cast<const BasicGen&>(*op);
-  std::optional<unsigned> pi2_mult = equiv_Clifford(bg.get_param());
-  return (pi2_mult && ((*pi2_mult % 2) == 0));
+  return bg.get_phase().is_pauli();
 }
 
 bool ZXDiagram::is_proper_clifford_spider(const ZXVert& v) const {
   ZXGen_ptr op = get_vertex_ZXGen_ptr(v);
   if (!is_spider_type(op->get_type())) return false;
   const BasicGen& bg = static_cast<const BasicGen&>(*op);
-  std::optional<unsigned> pi2_mult = equiv_Clifford(bg.get_param());
-  return (pi2_mult && ((*pi2_mult % 2) == 1));
+  return bg.get_phase().is_proper_clifford();
 }
 
-static std::string graphviz_vertex_props(ZXGen_ptr op) {
-  std::stringstream ss;
-
+static void graphviz_vertex_props(std::ostream& ss, const ZXGen_ptr& op) {
   // Tooltips (rollover text) contains the get_name information
-  ss << "tooltip=\"" + op->get_name() + "\" ";
+  ss << "tooltip=\"" << op->get_name() << "\" ";
 
   // Classical nodes are drawn thinner
   if (op->get_qtype() == QuantumType::Classical) ss << "penwidth=1 ";
@@ -280,12 +308,9 @@ static std::string graphviz_vertex_props(ZXGen_ptr op) {
           "ZXType");
     }
   }
-  return ss.str();
 }
 
-static std::string graphviz_wire_props(const WireProperties& wp) {
-  std::stringstream ss;
-
+static void graphviz_wire_props(std::ostream& ss, const WireProperties& wp) {
   // (default assumption is that qtype==Quantum)
   if (wp.qtype == QuantumType::Classical) ss << "penwidth=1 ";
 
@@ -296,14 +321,10 @@ static std::string graphviz_wire_props(const WireProperties& wp) {
   // and similarly, the 'tail' of an edge refers to the `Source` end
   if (wp.source_port) ss << " taillabel=\"" << *wp.source_port << "\"";
   if (wp.target_port) ss << " headlabel=\"" << *wp.target_port << "\"";
-
-  return ss.str();
 }
 
-std::string ZXDiagram::to_graphviz_str(
-    const std::set<ZXVert>& highlights) const {
-  std::stringstream out;
-
+void ZXDiagram::to_graphviz(
+    std::ostream& out, const std::set<ZXVert>& highlights) const {
   // Construct ZXVert index map (used as vertex IDs by graphviz)
   std::map<ZXVert, unsigned> idm;
   unsigned x = 0;
@@ -326,7 +347,7 @@ std::string ZXDiagram::to_graphviz_str(
     out << " [";
 
     // Define vertex properties based on ZXGen
-    out << graphviz_vertex_props(get_vertex_ZXGen_ptr(v));
+    graphviz_vertex_props(out, get_vertex_ZXGen_ptr(v));
 
     // Additional visual properties on node:
     // exterior labels for the node ID information
@@ -355,7 +376,7 @@ std::string ZXDiagram::to_graphviz_str(
 
     // Defining the properties bracket
     out << " [";
-    out << graphviz_wire_props(get_wire_info(w));
+    graphviz_wire_props(out, get_wire_info(w));
     out << "]\n";
   }
 
@@ -382,6 +403,12 @@ std::string ZXDiagram::to_graphviz_str(
   out << " [style=invis]; }\n";
 
   out << "}\n";
+}
+
+std::string ZXDiagram::to_graphviz_str(
+    const std::set<ZXVert>& highlights) const {
+  std::stringstream out;
+  to_graphviz(out, highlights);
   return out.str();
 }
 
@@ -22,7 +22,9 @@ namespace zx {
 
 ZXVert ZXDiagram::add_vertex(ZXGen_ptr op) {
   ZXVertProperties vp{op};
-  return boost::add_vertex(vp, *graph);
+  ZXVert v = boost::add_vertex(vp, *graph);
+  if (journal) journal->push_back({JournalEntry::Kind::AddVertex, v});
+  return v;
 }
 
 ZXVert ZXDiagram::add_vertex(ZXType type, QuantumType qtype) {
@@ -42,6 +44,11 @@ Wire ZXDiagram::add_wire(
   // add_edge only returns false if the graph cannot support parallel edges, but
   // we have set it up to allow this
   TKET_ASSERT(added);
+  if (journal) {
+    JournalEntry e{JournalEntry::Kind::AddWire};
+    e.wire = wire;
+    journal->push_back(std::move(e));
+  }
   return wire;
 }
 
@@ -52,17 +59,36 @@ Wire ZXDiagram::add_wire(
 }
 
 void ZXDiagram::remove_vertex(const ZXVert& v) {
+  std::optional<unsigned> boundary_index;
   // Remove from boundary if `v` is a boundary vertex
   if (is_boundary_type(get_zxtype(v))) {
     ZXVertVec::iterator v_it = std::find(boundary.begin(), boundary.end(), v);
-    if (v_it != boundary.end()) boundary.erase(v_it);
+    if (v_it != boundary.end()) {
+      boundary_index = v_it - boundary.begin();
+      boundary.erase(v_it);
+    }
   }
 
+  if (journal) {
+    // Record the wires individually so that they can be restored
+    for (const Wire& w : adj_wires(v)) remove_wire(w);
+    JournalEntry e{JournalEntry::Kind::RemoveVertex, v};
+    e.op = (*graph)[v].op;
+    e.boundary_index = boundary_index;
+    journal->push_back(std::move(e));
+  }
   boost::clear_vertex(v, *graph);
   boost::remove_vertex(v, *graph);
 }
 
-void ZXDiagram::remove_wire(const Wire& w) { boost::remove_edge(w, *graph); }
+void ZXDiagram::remove_wire(const Wire& w) {
+  if (journal) {
+    JournalEntry e{JournalEntry::Kind::RemoveWire, source(w), target(w), w};
+    e.props = (*graph)[w];
+    journal->push_back(std::move(e));
+  }
+  boost::remove_edge(w, *graph);
+}
 
 bool ZXDiagram::remove_wire(
     const ZXVert& va, const ZXVert& vb, const WireProperties& prop,
@@ -106,6 +132,11 @@ void ZXDiagram::symbol_substitution(
 }
 
 void ZXDiagram::symbol_substitution(const SymEngine::map_basic_basic& sub_map) {
+  if (journal) {
+    JournalEntry e{JournalEntry::Kind::SetScalar};
+    e.scalar = scalar;
+    journal->push_back(std::move(e));
+  }
   scalar = scalar.subs(sub_map);
   BGL_FORALL_VERTICES(v, *graph, ZXGraph) {
     ZXGen_ptr new_op = get_vertex_ZXGen_ptr(v)->symbol_substitution(sub_map);
@@ -124,6 +155,78 @@ SymSet ZXDiagram::free_symbols() const {
 
 bool ZXDiagram::is_symbolic() const { return !free_symbols().empty(); }
 
+std::size_t ZXDiagram::checkpoint() {
+  if (!journal) journal.emplace();
+  return journal->size();
+}
+
+void ZXDiagram::rollback(std::size_t mark) {
+  if (!journal || mark > journal->size())
+    throw ZXError("Rolling back to a checkpoint which is not in the journal");
+  // Current descriptors of the vertices and wires restored so far, keyed by
+  // the descriptors recorded in the journal. Descriptors may be reused by the
+  // graph once freed, so an entry only holds between the removal it undoes
+  // and the addition that preceded it.
+  std::map<ZXVert, ZXVert> vmap;
+  std::map<Wire, Wire> wmap;
+  auto current_vert = [&](const ZXVert& v) {
+    std::map<ZXVert, ZXVert>::const_iterator found = vmap.find(v);
+    return found == vmap.end() ? v : found->second;
+  };
+  auto current_wire = [&](const Wire& w) {
+    std::map<Wire, Wire>::const_iterator found = wmap.find(w);
+    return found == wmap.end() ? w : found->second;
+  };
+  std::vector<JournalEntry>& entries = *journal;
+  while (entries.size() > mark) {
+    const JournalEntry& e = entries.back();
+    switch (e.kind) {
+      case JournalEntry::Kind::AddVertex: {
+        // Any wires added to it have already been undone
+        boost::remove_vertex(current_vert(e.vert), *graph);
+        vmap.erase(e.vert);
+        break;
+      }
+      case JournalEntry::Kind::RemoveVertex: {
+        ZXVert v = boost::add_vertex(ZXVertProperties{e.op}, *graph);
+        vmap[e.vert] = v;
+        if (e.boundary_index) {
+          boundary.insert(boundary.begin() + *e.boundary_index, v);
+        }
+        break;
+      }
+      case JournalEntry::Kind::AddWire: {
+        boost::remove_edge(current_wire(e.wire), *graph);
+        wmap.erase(e.wire);
+        break;
+      }
+      case JournalEntry::Kind::RemoveWire: {
+        std::pair<Wire, bool> added = boost::add_edge(
+            current_vert(e.vert), current_vert(e.target), e.props, *graph);
+        wmap[e.wire] = added.first;
+        break;
+      }
+      case JournalEntry::Kind::SetVertexGen: {
+        (*graph)[current_vert(e.vert)].op = e.op;
+        break;
+      }
+      case JournalEntry::Kind::SetWireInfo: {
+        (*graph)[current_wire(e.wire)] = e.props;
+        break;
+      }
+      case JournalEntry::Kind::SetScalar: {
+        scalar = e.scalar;
+        break;
+      }
+    }
+    entries.pop_back();
+  }
+}
+
+void ZXDiagram::release() { journal.reset(); }
+
+bool ZXDiagram::is_journaling() const { return journal.has_value(); }
+
 static void check_valid_wire(
     const std::optional<unsigned>& port, QuantumType qtype,
     const std::optional<unsigned>& n_ports, std::vector<bool>& ports_found,
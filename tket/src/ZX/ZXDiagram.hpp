@@ -20,9 +20,10 @@ namespace tket {
 
 namespace zx {
 
-// Forward declare Rewrite, ZXDiagramPybind for friend access
+// Forward declare Rewrite, ZXDiagramPybind, CompactZXGraph for friend access
 class Rewrite;
 class ZXDiagramPybind;
+class CompactZXGraph;
 
 class ZXDiagram {
  private:
@@ -44,6 +45,37 @@ class ZXDiagram {
   // Global scalar for tracking during rewrites
   Expr scalar;
 
+  // A change to the diagram, with what is needed to undo it
+  struct JournalEntry {
+    enum class Kind {
+      AddVertex,
+      RemoveVertex,
+      AddWire,
+      RemoveWire,
+      SetVertexGen,
+      SetWireInfo,
+      SetScalar
+    };
+    Kind kind;
+    // Vertex added, removed or changed, or source of a removed wire
+    ZXVert vert;
+    // Target of a removed wire
+    ZXVert target;
+    // Wire added, removed or changed
+    Wire wire;
+    // Previous generator of a removed or changed vertex
+    ZXGen_ptr op;
+    // Previous properties of a removed or changed wire
+    WireProperties props;
+    // Previous scalar
+    Expr scalar;
+    // Position of a removed boundary vertex in `boundary`
+    std::optional<unsigned> boundary_index;
+  };
+
+  // Changes since the first checkpoint, if journaling
+  std::optional<std::vector<JournalEntry>> journal;
+
  public:
   /**
    * Constructors & assignment operators for:
@@ -71,6 +103,8 @@ class ZXDiagram {
   // Getting the global scalar and modifying by multiplication
   const Expr& get_scalar() const;
   void multiply_scalar(const Expr& sc);
+  // Multiplies the global scalar by exp(i*pi*phase)
+  void multiply_scalar_phase(const Expr& phase);
 
   // Counting all vertices / wires in the diagram
   unsigned n_vertices() const;
@@ -91,6 +125,12 @@ class ZXDiagram {
   WireVec adj_wires(const ZXVert& v) const;
   // Wires given in the same order as `adj_wires(u)`
   WireVec wires_between(const ZXVert& u, const ZXVert& v) const;
+  // Non-allocating views of the wires in `adj_wires(v)` and of the vertex at
+  // the other end of each. Unlike `neighbours(v)`, a vertex joined to `v` by
+  // several wires is visited once per wire. Invalidated by adding or removing
+  // wires at `v`.
+  AdjWireRange adj_wires_range(const ZXVert& v) const;
+  AdjVertRange neighbours_range(const ZXVert& v) const;
 
   /**
    * Searches for an arbitrary wire between `va` and `vb`.
@@ -174,6 +214,13 @@ class ZXDiagram {
    **/
   std::string to_graphviz_str(const std::set<ZXVert>& highlights = {}) const;
 
+  /**
+   * Writes the graphviz of `to_graphviz_str` to a stream, without building
+   * the string in memory.
+   **/
+  void to_graphviz(
+      std::ostream& out, const std::set<ZXVert>& highlights = {}) const;
+
   /**
    * Diagram manipulation
    */
@@ -229,6 +276,23 @@ class ZXDiagram {
       const ZXVert& va, const ZXVert& vb, const WireProperties& prop,
       WireSearchOption directed = WireSearchOption::UNDIRECTED);
 
+  /**
+   * Journaling
+   *
+   * After `checkpoint`, every change made through the methods of the diagram
+   * is recorded until `release`, so that `rollback` can undo the changes since
+   * a checkpoint in time and memory proportional to their number, rather than
+   * by copying the whole diagram. Vertices and wires restored by a rollback
+   * get new descriptors; all other descriptors stay valid.
+   */
+  // Starts recording changes if not already, and returns a mark for `rollback`
+  std::size_t checkpoint();
+  // Undoes all changes recorded since `mark`; throws ZXError if not journaling
+  void rollback(std::size_t mark);
+  // Stops recording changes and discards the journal
+  void release();
+  bool is_journaling() const;
+
   /**
    * Diagram conversion
    */
@@ -293,6 +357,7 @@ class ZXDiagram {
 
   friend Rewrite;
   friend ZXDiagramPybind;
+  friend CompactZXGraph;
 
  private:
   /**
@@ -16,6 +16,8 @@
 
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/graph_traits.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <iterator>
 
 #include "Utils/SequencedContainers.hpp"
 #include "ZX/ZXGenerator.hpp"
@@ -119,6 +121,118 @@ typedef boost::graph_traits<ZXGraph>::edge_iterator WireIterator;
 typedef boost::graph_traits<ZXGraph>::out_edge_iterator OutWireIterator;
 typedef boost::graph_traits<ZXGraph>::in_edge_iterator InWireIterator;
 
+/**
+ * Iterator over the wires incident to a vertex, in the same order as
+ * `ZXDiagram::adj_wires`: outedges (and self-loops) before inedges (ignoring
+ * self-loops). Nothing is allocated. Invalidated by adding or removing wires
+ * at the vertex.
+ */
+class AdjWireIterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = Wire;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const Wire*;
+  using reference = const Wire&;
+
+  AdjWireIterator() : graph_(nullptr) {}
+  AdjWireIterator(const ZXGraph& graph, const ZXVert& v, bool at_end)
+      : graph_(&graph), v_(v) {
+    std::tie(out_, out_end_) = boost::out_edges(v, graph);
+    std::tie(in_, in_end_) = boost::in_edges(v, graph);
+    if (at_end) {
+      out_ = out_end_;
+      in_ = in_end_;
+    }
+    settle();
+  }
+
+  reference operator*() const { return current_; }
+  pointer operator->() const { return &current_; }
+  AdjWireIterator& operator++() {
+    if (out_ != out_end_)
+      ++out_;
+    else
+      ++in_;
+    settle();
+    return *this;
+  }
+  AdjWireIterator operator++(int) {
+    AdjWireIterator it = *this;
+    ++*this;
+    return it;
+  }
+  bool operator==(const AdjWireIterator& other) const {
+    return out_ == other.out_ && in_ == other.in_;
+  }
+  bool operator!=(const AdjWireIterator& other) const {
+    return !(*this == other);
+  }
+
+  const ZXGraph& graph() const { return *graph_; }
+  const ZXVert& vertex() const { return v_; }
+
+ private:
+  const ZXGraph* graph_;
+  ZXVert v_;
+  OutWireIterator out_, out_end_;
+  InWireIterator in_, in_end_;
+  Wire current_;
+
+  // Skip self-loops among the inedges and cache the current wire
+  void settle() {
+    if (out_ != out_end_) {
+      current_ = *out_;
+      return;
+    }
+    while (in_ != in_end_ && boost::source(*in_, *graph_) == v_) ++in_;
+    if (in_ != in_end_) current_ = *in_;
+  }
+};
+
+/**
+ * Iterator over the vertex at the other end of each wire visited by an
+ * `AdjWireIterator`. A neighbour is visited once per wire joining it to the
+ * vertex, and a self-loop visits the vertex itself.
+ */
+class AdjVertIterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = ZXVert;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const ZXVert*;
+  using reference = ZXVert;
+
+  AdjVertIterator() {}
+  explicit AdjVertIterator(const AdjWireIterator& it) : it_(it) {}
+
+  ZXVert operator*() const {
+    const ZXVert s = boost::source(*it_, it_.graph());
+    return (s == it_.vertex()) ? boost::target(*it_, it_.graph()) : s;
+  }
+  AdjVertIterator& operator++() {
+    ++it_;
+    return *this;
+  }
+  AdjVertIterator operator++(int) {
+    AdjVertIterator it = *this;
+    ++it_;
+    return it;
+  }
+  bool operator==(const AdjVertIterator& other) const {
+    return it_ == other.it_;
+  }
+  bool operator!=(const AdjVertIterator& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  AdjWireIterator it_;
+};
+
+typedef boost::iterator_range<AdjWireIterator> AdjWireRange;
+typedef boost::iterator_range<AdjVertIterator> AdjVertRange;
+
 }  // namespace zx
 
 }  // namespace tket
@@ -14,6 +14,8 @@
 
 #include "ZX/ZXGenerator.hpp"
 
+#include <cmath>
+#include <numeric>
 #include <sstream>
 
 #include "Utils/Assert.hpp"
@@ -53,6 +55,145 @@ bool is_directed_type(ZXType type) {
   return find_in_set(type, directed);
 }
 
+/**
+ * ZXPhase implementation
+ */
+
+// Bound on the numerator and denominator of exact phases, so that the
+// products taken in additions cannot overflow
+static constexpr std::int64_t exact_phase_bound = std::int64_t{1} << 30;
+// Doubles are only taken as exact if they are multiples of 2^-max_dyadic_exp
+static constexpr int max_dyadic_exp = 16;
+
+ZXPhase::ZXPhase() : num_(0), den_(1), is_double_(false) {}
+
+ZXPhase::ZXPhase(std::int64_t num, std::int64_t den)
+    : num_(num), den_(den), is_double_(false) {
+  if (den_ == 0) throw ZXError("ZXPhase with zero denominator");
+  if (den_ < 0) {
+    num_ = -num_;
+    den_ = -den_;
+  }
+  std::int64_t g = std::gcd(num_, den_);
+  num_ /= g;
+  den_ /= g;
+  if (den_ < exact_phase_bound && std::abs(num_) >= exact_phase_bound) {
+    // Phases are only meaningful modulo 2
+    num_ %= 2 * den_;
+  }
+  if (std::abs(num_) >= exact_phase_bound || den_ >= exact_phase_bound) {
+    // Too large for the exact fast path; this only happens with unusually
+    // fine phases, so go through a string to stay independent of the width
+    // of long
+    expr_ = Expr(std::to_string(num_) + "/" + std::to_string(den_));
+  }
+}
+
+// Value of a SymEngine integer, if it is within the bound for exact phases
+static std::optional<std::int64_t> bounded_int(const SymEngine::Integer& i) {
+  long val;
+  try {
+    val = i.as_int();
+  } catch (const SymEngine::SymEngineException&) {
+    return std::nullopt;
+  }
+  if (std::abs(std::int64_t{val}) >= exact_phase_bound) return std::nullopt;
+  return val;
+}
+
+ZXPhase::ZXPhase(const Expr& e) : num_(0), den_(1), is_double_(false) {
+  const SymEngine::Basic& b = *ExprPtr(e);
+  std::optional<std::int64_t> num, den;
+  if (SymEngine::is_a<SymEngine::Integer>(b)) {
+    num = bounded_int(SymEngine::down_cast<const SymEngine::Integer&>(b));
+    den = 1;
+  } else if (SymEngine::is_a<SymEngine::Rational>(b)) {
+    const SymEngine::Rational& r =
+        SymEngine::down_cast<const SymEngine::Rational&>(b);
+    num = bounded_int(*r.get_num());
+    den = bounded_int(*r.get_den());
+  } else if (SymEngine::is_a<SymEngine::RealDouble>(b)) {
+    double x =
+        SymEngine::down_cast<const SymEngine::RealDouble&>(b).as_double();
+    for (int k = 0; std::isfinite(x) && k <= max_dyadic_exp; ++k) {
+      double scaled = std::ldexp(x, k);
+      if (std::abs(scaled) >= double(exact_phase_bound)) break;
+      if (scaled == std::floor(scaled)) {
+        num = std::int64_t(scaled);
+        den = std::int64_t{1} << k;
+        is_double_ = true;
+        break;
+      }
+    }
+  }
+  if (num && den) {
+    std::int64_t g = std::gcd(*num, *den);
+    num_ = *num / g;
+    den_ = *den / g;
+  } else {
+    is_double_ = false;
+    expr_ = e;
+  }
+}
+
+bool ZXPhase::is_exact() const { return !expr_; }
+
+std::optional<unsigned> ZXPhase::clifford_multiple() const {
+  if (expr_) return equiv_Clifford(*expr_);
+  // num/den = u/2 (mod 2) iff den divides 2*num
+  if ((2 * num_) % den_ != 0) return std::nullopt;
+  std::int64_t u = ((2 * num_) / den_) % 4;
+  return unsigned(u < 0 ? u + 4 : u);
+}
+
+bool ZXPhase::is_pauli() const {
+  std::optional<unsigned> pi2_mult = clifford_multiple();
+  return (pi2_mult && ((*pi2_mult % 2) == 0));
+}
+
+bool ZXPhase::is_proper_clifford() const {
+  std::optional<unsigned> pi2_mult = clifford_multiple();
+  return (pi2_mult && ((*pi2_mult % 2) == 1));
+}
+
+bool ZXPhase::is_zero() const {
+  std::optional<unsigned> pi2_mult = clifford_multiple();
+  return (pi2_mult && (*pi2_mult == 0));
+}
+
+Expr ZXPhase::to_expr() const {
+  if (expr_) return *expr_;
+  if (is_double_) return Expr(double(num_) / double(den_));
+  return Expr(SymEngine::div(
+      SymEngine::integer(long(num_)), SymEngine::integer(long(den_))));
+}
+
+ZXPhase ZXPhase::operator+(const ZXPhase& other) const {
+  if (expr_ || other.expr_) return ZXPhase(to_expr() + other.to_expr());
+  // Both fractions are within the bound, so none of these products overflow
+  ZXPhase sum(num_ * other.den_ + other.num_ * den_, den_ * other.den_);
+  // Follow SymEngine in that any double operand gives a double
+  sum.is_double_ = sum.is_exact() && (is_double_ || other.is_double_);
+  return sum;
+}
+
+ZXPhase ZXPhase::operator-(const ZXPhase& other) const {
+  return *this + (-other);
+}
+
+ZXPhase ZXPhase::operator-() const {
+  if (expr_) return ZXPhase(-*expr_);
+  ZXPhase neg(-num_, den_);
+  neg.is_double_ = is_double_;
+  return neg;
+}
+
+bool ZXPhase::operator==(const ZXPhase& other) const {
+  if (expr_ || other.expr_) return to_expr() == other.to_expr();
+  return num_ == other.num_ && den_ == other.den_ &&
+         is_double_ == other.is_double_;
+}
+
 /**
  * ZXGen (Base class) implementation
  */
@@ -174,6 +315,9 @@ bool BoundaryGen::operator==(const ZXGen& other) const {
  */
 
 BasicGen::BasicGen(ZXType type, const Expr& param, QuantumType qtype)
+    : BasicGen(type, ZXPhase(param), qtype) {}
+
+BasicGen::BasicGen(ZXType type, const ZXPhase& param, QuantumType qtype)
     : ZXGen(type), qtype_(qtype), param_(param) {
   if (!is_basic_gen_type(type)) {
     throw ZXError("Unsupported ZXType for BasicGen");
@@ -188,13 +332,22 @@ bool BasicGen::valid_edge(
                    this->qtype_ == QuantumType::Classical);
 }
 
-Expr BasicGen::get_param() const { return param_; }
+Expr BasicGen::get_param() const { return param_.to_expr(); }
 
-SymSet BasicGen::free_symbols() const { return expr_free_symbols(param_); }
+const ZXPhase& BasicGen::get_phase() const { return param_; }
+
+SymSet BasicGen::free_symbols() const {
+  if (param_.is_exact()) return {};
+  return expr_free_symbols(param_.to_expr());
+}
 
 ZXGen_ptr BasicGen::symbol_substitution(
     const SymEngine::map_basic_basic& sub_map) const {
-  return std::make_shared<const BasicGen>(type_, param_.subs(sub_map), qtype_);
+  if (param_.is_exact()) {
+    return std::make_shared<const BasicGen>(type_, param_, qtype_);
+  }
+  return std::make_shared<const BasicGen>(
+      type_, param_.to_expr().subs(sub_map), qtype_);
 }
 
 std::string BasicGen::get_name(bool) const {
@@ -217,7 +370,7 @@ std::string BasicGen::get_name(bool) const {
     default:
       throw ZXError("BasicGen with invalid ZXType");
   }
-  st << "(" << param_ << ")";
+  st << "(" << param_.to_expr() << ")";
   return st.str();
 }
 
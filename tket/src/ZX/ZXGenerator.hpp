@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <optional>
 #include <unordered_set>
 
@@ -72,6 +73,58 @@ bool is_basic_gen_type(ZXType type);
 bool is_spider_type(ZXType type);
 bool is_directed_type(ZXType type);
 
+/**
+ * Phase of a spider, in half-turns.
+ *
+ * Phases that are exact fractions (integers, SymEngine rationals, or doubles
+ * that are exact dyadic fractions such as 0.25) are held as a reduced
+ * numerator and denominator, so that Clifford checks and phase addition use
+ * integer arithmetic only. Any other phase is held as a symbolic Expr.
+ *
+ * The value is kept as given rather than reduced modulo 2 (unless it would
+ * not fit otherwise), and remembers whether it came from a double so that
+ * \ref to_expr gives the same Expr that SymEngine arithmetic would have given.
+ */
+class ZXPhase {
+ public:
+  /** Phase of 0 */
+  ZXPhase();
+
+  /** Exact phase num / den; throws ZXError if den is 0 */
+  ZXPhase(std::int64_t num, std::int64_t den);
+
+  explicit ZXPhase(const Expr& e);
+
+  /** Whether the phase is held as an exact fraction */
+  bool is_exact() const;
+
+  /**
+   * Multiple of 1/2 the phase is equivalent to modulo 2, if any.
+   * Symbolic phases are tested with \ref equiv_Clifford.
+   *
+   * @retval u phase is u/2 modulo 2, where 0 <= u < 4
+   */
+  std::optional<unsigned> clifford_multiple() const;
+
+  bool is_pauli() const;
+  bool is_proper_clifford() const;
+  bool is_zero() const;
+
+  Expr to_expr() const;
+
+  ZXPhase operator+(const ZXPhase& other) const;
+  ZXPhase operator-(const ZXPhase& other) const;
+  ZXPhase operator-() const;
+  bool operator==(const ZXPhase& other) const;
+
+ private:
+  std::int64_t num_;
+  std::int64_t den_;
+  bool is_double_;
+  // Set iff the phase is not exact
+  std::optional<Expr> expr_;
+};
+
 // Forward declaration so we can use ZXGen_ptr in the interface of ZXGen
 class ZXGen;
 typedef std::shared_ptr<const ZXGen> ZXGen_ptr;
@@ -182,9 +235,15 @@ class BasicGen : public ZXGen {
  public:
   BasicGen(
       ZXType type, const Expr& param, QuantumType qtype = QuantumType::Quantum);
+  BasicGen(
+      ZXType type, const ZXPhase& param,
+      QuantumType qtype = QuantumType::Quantum);
 
   Expr get_param() const;
 
+  /** The parameter, with the exact fast path for spider phases */
+  const ZXPhase& get_phase() const;
+
   // Overrides from ZXGen
   virtual std::optional<QuantumType> get_qtype() const override;
   virtual bool valid_edge(
@@ -197,7 +256,7 @@ class BasicGen : public ZXGen {
 
  protected:
   const QuantumType qtype_;
-  const Expr param_;
+  const ZXPhase param_;
 };
 
 /**
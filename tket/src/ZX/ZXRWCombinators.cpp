@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "Utils/GraphHeaders.hpp"
+#include "Utils/Trace.hpp"
 #include "ZX/Rewrite.hpp"
 
 namespace tket {
@@ -33,8 +35,12 @@ Rewrite Rewrite::sequence(const std::vector<Rewrite> &rvec) {
 
 Rewrite Rewrite::repeat(const Rewrite &rw) {
   return Rewrite([=](ZXDiagram &diag) {
+    TKET_TRACE_SPAN("zx::Rewrite::repeat");
     bool success = false;
-    while (rw.apply(diag)) success = true;
+    while (rw.apply(diag)) {
+      success = true;
+      TKET_TRACE_COUNT("rewrites", 1);
+    }
     return success;
   });
 }
@@ -44,18 +50,20 @@ Rewrite Rewrite::repeat_with_metric(
   return Rewrite([=](ZXDiagram &diag) {
     bool success = false;
     unsigned currentVal = eval(diag);
-    ZXDiagram newDiag = diag;
-    rw.apply(newDiag);
-    unsigned newVal = eval(newDiag);
-    while (newVal < currentVal) {
+    // Each application is speculative, and undone through the journal if it
+    // does not improve the metric
+    const bool outer_journal = diag.is_journaling();
+    std::size_t mark = diag.checkpoint();
+    while (rw.apply(diag)) {
+      unsigned newVal = eval(diag);
+      if (newVal >= currentVal) break;
       currentVal = newVal;
       success = true;
-      rw.apply(newDiag);
-      newVal = eval(newDiag);
-    }
-    if (success) {
-      diag = newDiag;
+      if (!outer_journal) diag.release();
+      mark = diag.checkpoint();
     }
+    diag.rollback(mark);
+    if (!outer_journal) diag.release();
     return success;
   });
 }
@@ -71,6 +79,30 @@ Rewrite Rewrite::repeat_while(const Rewrite &cond, const Rewrite &body) {
   });
 }
 
+Rewrite Rewrite::worklist(const std::vector<LocalRewriteFun> &rules) {
+  return Rewrite([=](ZXDiagram &diag) {
+    TKET_TRACE_SPAN("zx::Rewrite::worklist");
+    bool success = false;
+    ZXVertSeqSet candidates;
+    BGL_FORALL_VERTICES(v, *diag.graph, ZXGraph) { candidates.insert(v); }
+    auto &view = candidates.get<TagSeq>();
+    while (!candidates.empty()) {
+      ZXVert v = view.front();
+      view.pop_front();
+      TKET_TRACE_COUNT("vertices_visited", 1);
+      for (const LocalRewriteFun &rule : rules) {
+        // The rule requeues `v` if it is still present
+        if (rule(diag, v, candidates)) {
+          success = true;
+          TKET_TRACE_COUNT("rewrites", 1);
+          break;
+        }
+      }
+    }
+    return success;
+  });
+}
+
 }  // namespace zx
 
 }  // namespace tket
@@ -87,6 +87,16 @@ bool Rewrite::io_extension_fun(ZXDiagram& diag) {
 
 Rewrite Rewrite::io_extension() { return Rewrite(io_extension_fun); }
 
+Rewrite Rewrite::to_graphlike_form() {
+  return Rewrite::sequence(
+      {Rewrite::red_to_green(),
+       Rewrite::repeat(Rewrite::sequence(
+           {Rewrite::spider_fusion(), Rewrite::self_loop_removal(),
+            Rewrite::parallel_h_removal()})),
+       Rewrite::io_extension(), Rewrite::separate_boundaries(),
+       Rewrite::spider_fusion()});
+}
+
 }  // namespace zx
 
 }  // namespace tket
@@ -12,7 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <numeric>
+
 #include "Utils/GraphHeaders.hpp"
+#include "Utils/Parallel.hpp"
+#include "ZX/CompactZXGraph.hpp"
 #include "ZX/Rewrite.hpp"
 
 namespace tket {
@@ -35,56 +42,216 @@ static bool can_complement_neighbourhood(
   return true;
 }
 
+// As above, for a vertex of a CompactZXGraph
+static bool can_complement_neighbourhood(
+    const CompactZXGraph& g, unsigned v) {
+  QuantumType vqtype = g.get_qtype(v);
+  for (unsigned n : g.neighbours(v)) {
+    if (g.is_boundary(n) || (vqtype == QuantumType::Classical &&
+                             g.get_qtype(n) == QuantumType::Quantum))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * The compact forms of the rewrites below work in rounds. Each round
+ * greedily picks a maximal set of matches whose closed neighbourhoods are
+ * disjoint, then applies them concurrently, since a match only changes the
+ * wires and phases within its own neighbourhood. The matches that were
+ * blocked and the vertices next to an applied match are the candidates for
+ * the next round.
+ */
+
+// Smallest number of matches of a round worth handing to another thread
+static const std::size_t min_matches_per_thread = 64;
+
+static bool is_claimed(
+    const CompactZXGraph& g, unsigned v,
+    const std::vector<std::uint8_t>& claimed) {
+  if (claimed[v]) return true;
+  for (unsigned n : g.neighbours(v)) {
+    if (claimed[n]) return true;
+  }
+  return false;
+}
+
+// Claims the closed neighbourhood of `v`, recording the neighbours in
+// `touched`
+static void claim(
+    const CompactZXGraph& g, unsigned v, std::vector<std::uint8_t>& claimed,
+    std::vector<unsigned>& touched) {
+  claimed[v] = true;
+  for (unsigned n : g.neighbours(v)) {
+    claimed[n] = true;
+    touched.push_back(n);
+  }
+}
+
+// Releases the claims of a round and queues the touched vertices which
+// remain for the next
+static void end_round(
+    const CompactZXGraph& g, const std::vector<unsigned>& matched,
+    const std::vector<unsigned>& touched, std::vector<std::uint8_t>& claimed,
+    std::vector<std::uint8_t>& queued, std::vector<unsigned>& next) {
+  for (unsigned v : matched) claimed[v] = false;
+  for (unsigned n : touched) {
+    claimed[n] = false;
+    if (!g.is_removed(n) && !queued[n]) {
+      queued[n] = true;
+      next.push_back(n);
+    }
+  }
+}
+
+/**
+ * Phase, in half-turns, of the scalar picked up by local complementation
+ * about a Quantum spider with phase `vphase` (up to a positive factor). The
+ * scalars of Classical spiders are doubled, so they pick up no phase.
+ */
+static ZXPhase complementation_scalar_phase(
+    const ZXPhase& vphase, QuantumType vqtype) {
+  if (vqtype == QuantumType::Classical) return ZXPhase();
+  return *vphase.clifford_multiple() == 1 ? ZXPhase(1, 4) : ZXPhase(-1, 4);
+}
+
+// Phase of the scalar picked up by pivoting about a pair of Pauli spiders
+static ZXPhase pivot_scalar_phase(
+    const ZXPhase& vphase, const ZXPhase& uphase, QuantumType vqtype) {
+  if (vqtype == QuantumType::Classical || vphase.is_zero() ||
+      uphase.is_zero())
+    return ZXPhase();
+  return ZXPhase(1, 1);
+}
+
+// Local complementation about `v`, which is then removed. Returns the phase
+// of the scalar picked up.
+static ZXPhase complement_about(CompactZXGraph& g, unsigned v) {
+  QuantumType vqtype = g.get_qtype(v);
+  ZXPhase vphase = g.get_phase(v);
+  // Toggling edges between neighbours leaves the neighbourhood of `v` intact
+  const std::vector<unsigned>& neighbours = g.neighbours(v);
+  g.complement(neighbours, vqtype);
+  for (unsigned n : neighbours) {
+    // If `v` is Quantum, Classical neighbours pick up both the +theta and
+    // -theta phases, cancelling out
+    if (vqtype == QuantumType::Quantum &&
+        g.get_qtype(n) == QuantumType::Classical)
+      continue;
+    g.set_phase(n, g.get_phase(n) - vphase);
+  }
+  g.remove_vertex(v);
+  return complementation_scalar_phase(vphase, vqtype);
+}
+
+static bool remove_interior_cliffords_compact(
+    CompactZXGraph& g, ZXPhase& scalar_phase) {
+  bool success = false;
+  const unsigned n_verts = g.n_vertices();
+  std::vector<unsigned> candidates(n_verts);
+  std::iota(candidates.begin(), candidates.end(), 0);
+  std::vector<std::uint8_t> queued(n_verts, true);
+  std::vector<std::uint8_t> claimed(n_verts, false);
+  while (!candidates.empty()) {
+    std::vector<unsigned> matched, touched, next;
+    for (unsigned v : candidates) {
+      queued[v] = false;
+      if (g.is_removed(v) || !g.is_proper_clifford_spider(v)) continue;
+      if (!can_complement_neighbourhood(g, v)) continue;
+      if (is_claimed(g, v, claimed)) {
+        queued[v] = true;
+        next.push_back(v);
+        continue;
+      }
+      claim(g, v, claimed, touched);
+      matched.push_back(v);
+    }
+    std::vector<ZXPhase> phases(matched.size());
+    parallel_for(
+        0, matched.size(), min_matches_per_thread,
+        [&](std::size_t begin, std::size_t end) {
+          for (std::size_t i = begin; i < end; ++i) {
+            phases[i] = complement_about(g, matched[i]);
+          }
+        });
+    for (const ZXPhase& p : phases) scalar_phase = scalar_phase + p;
+    success = success || !matched.empty();
+    end_round(g, matched, touched, claimed, queued, next);
+    candidates.swap(next);
+  }
+  return success;
+}
+
+bool Rewrite::remove_interior_cliffords_at(
+    ZXDiagram& diag, const ZXVert& v, ZXVertSeqSet& worklist) {
+  if (!diag.is_proper_clifford_spider(v)) return false;
+  const BasicGen& spid = diag.get_vertex_ZXGen<BasicGen>(v);
+  QuantumType vqtype = *spid.get_qtype();
+  ZXVertVec neighbours = diag.neighbours(v);
+  if (!can_complement_neighbourhood(diag, vqtype, neighbours)) return false;
+  // Found an internal proper clifford spider on which we can perform local
+  // complementation
+  /**
+   * Complement the neighbourhoods' edges and modify the phase information
+   * on the neighbours.
+   **/
+  auto xi = neighbours.begin(), x_end = neighbours.end();
+  for (; xi != x_end; ++xi) {
+    for (auto yi = xi + 1; yi != x_end; ++yi) {
+      // Don't add a doubled edge between classicals to preserve graph-like
+      if (!(vqtype == QuantumType::Quantum &&
+            *diag.get_qtype(*xi) == QuantumType::Classical &&
+            *diag.get_qtype(*yi) == QuantumType::Classical)) {
+        std::optional<Wire> wire = diag.wire_between(*xi, *yi);
+        if (wire)
+          diag.remove_wire(*wire);
+        else
+          diag.add_wire(*xi, *yi, ZXWireType::H, vqtype);
+      }
+    }
+    // The neighbourhood of each neighbour has changed
+    worklist.insert(*xi);
+    const BasicGen& xi_op = diag.get_vertex_ZXGen<BasicGen>(*xi);
+    // If `v` is Quantum, Classical neighbours will pick up both the +theta
+    // and -theta phases, cancelling out
+    if (vqtype == QuantumType::Quantum &&
+        *xi_op.get_qtype() == QuantumType::Classical)
+      continue;
+    // Update phase information
+    ZXGen_ptr xi_new_op = std::make_shared<const BasicGen>(
+        ZXType::ZSpider, xi_op.get_phase() - spid.get_phase(),
+        *xi_op.get_qtype());
+    diag.set_vertex_ZXGen_ptr(*xi, xi_new_op);
+  }
+  ZXPhase scalar_phase =
+      complementation_scalar_phase(spid.get_phase(), vqtype);
+  diag.remove_vertex(v);
+  worklist.erase(v);
+  if (!scalar_phase.is_zero()) {
+    diag.multiply_scalar_phase(scalar_phase.to_expr());
+  }
+  return true;
+}
+
 bool Rewrite::remove_interior_cliffords_fun(ZXDiagram& diag) {
+  if (CompactZXGraph::is_graph_like(diag)) {
+    CompactZXGraph g(diag);
+    ZXPhase scalar_phase;
+    if (!remove_interior_cliffords_compact(g, scalar_phase)) return false;
+    g.apply_to(diag);
+    if (!scalar_phase.is_zero()) {
+      diag.multiply_scalar_phase(scalar_phase.to_expr());
+    }
+    return true;
+  }
   bool success = false;
   ZXVertSeqSet candidates;
   BGL_FORALL_VERTICES(v, *diag.graph, ZXGraph) { candidates.insert(v); }
   auto& view = candidates.get<TagSeq>();
   while (!candidates.empty()) {
-    auto it = view.begin();
-    ZXVert v = *it;
-    view.erase(it);
-    if (!diag.is_proper_clifford_spider(v)) continue;
-    const BasicGen& spid = diag.get_vertex_ZXGen<BasicGen>(v);
-    QuantumType vqtype = *spid.get_qtype();
-    ZXVertVec neighbours = diag.neighbours(v);
-    if (!can_complement_neighbourhood(diag, vqtype, neighbours)) continue;
-    // Found an internal proper clifford spider on which we can perform local
-    // complementation
-    /**
-     * Complement the neighbourhoods' edges and modify the phase information
-     * on the neighbours.
-     **/
-    auto xi = neighbours.begin(), x_end = neighbours.end();
-    for (; xi != x_end; ++xi) {
-      for (auto yi = xi + 1; yi != x_end; ++yi) {
-        // Don't add a doubled edge between classicals to preserve graph-like
-        if (!(vqtype == QuantumType::Quantum &&
-              *diag.get_qtype(*xi) == QuantumType::Classical &&
-              *diag.get_qtype(*yi) == QuantumType::Classical)) {
-          std::optional<Wire> wire = diag.wire_between(*xi, *yi);
-          if (wire)
-            diag.remove_wire(*wire);
-          else
-            diag.add_wire(*xi, *yi, ZXWireType::H, vqtype);
-        }
-      }
-      const BasicGen& xi_op = diag.get_vertex_ZXGen<BasicGen>(*xi);
-      // If `v` is Quantum, Classical neighbours will pick up both the +theta
-      // and -theta phases, cancelling out
-      if (vqtype == QuantumType::Quantum &&
-          *xi_op.get_qtype() == QuantumType::Classical)
-        continue;
-      // Update phase information
-      ZXGen_ptr xi_new_op = std::make_shared<const BasicGen>(
-          ZXType::ZSpider, xi_op.get_param() - spid.get_param(),
-          *xi_op.get_qtype());
-      diag.set_vertex_ZXGen_ptr(*xi, xi_new_op);
-      candidates.insert(
-          *xi);  // Changing the phase could introduce a new proper Clifford
-    }
-    diag.remove_vertex(v);
-    success = true;
+    ZXVert v = view.front();
+    view.pop_front();
+    success = remove_interior_cliffords_at(diag, v, candidates) || success;
   }
   return success;
 }
@@ -94,11 +261,11 @@ Rewrite Rewrite::remove_interior_cliffords() {
 }
 
 static void add_phase_to_vertices(
-    ZXDiagram& diag, const ZXVertSeqSet& verts, const Expr& phase) {
+    ZXDiagram& diag, const ZXVertSeqSet& verts, const ZXPhase& phase) {
   for (const ZXVert& v : verts) {
     const BasicGen& old_spid = diag.get_vertex_ZXGen<BasicGen>(v);
     ZXGen_ptr new_spid = std::make_shared<const BasicGen>(
-        ZXType::ZSpider, old_spid.get_param() + phase, *old_spid.get_qtype());
+        ZXType::ZSpider, old_spid.get_phase() + phase, *old_spid.get_qtype());
     diag.set_vertex_ZXGen_ptr(v, new_spid);
   }
 }
@@ -122,7 +289,115 @@ static void bipartite_complementation(
   }
 }
 
+static void add_phase_to_vertices(
+    CompactZXGraph& g, const std::vector<unsigned>& verts,
+    const ZXPhase& phase) {
+  for (unsigned v : verts) g.set_phase(v, g.get_phase(v) + phase);
+}
+
+// Pivot about the edge between `v` and `u`, which are then removed. Returns
+// the phase of the scalar picked up.
+static ZXPhase pivot_about(CompactZXGraph& g, unsigned v, unsigned u) {
+  const std::vector<unsigned>& v_ns = g.neighbours(v);
+  const std::vector<unsigned>& u_ns = g.neighbours(u);
+  // Neither neighbourhood contains its own vertex, so `u` and `v` only
+  // appear in the exclusive sets
+  std::vector<unsigned> joint, excl_u, excl_v;
+  std::set_intersection(
+      v_ns.begin(), v_ns.end(), u_ns.begin(), u_ns.end(),
+      std::back_inserter(joint));
+  std::set_difference(
+      u_ns.begin(), u_ns.end(), v_ns.begin(), v_ns.end(),
+      std::back_inserter(excl_u));
+  std::set_difference(
+      v_ns.begin(), v_ns.end(), u_ns.begin(), u_ns.end(),
+      std::back_inserter(excl_v));
+  excl_u.erase(std::find(excl_u.begin(), excl_u.end(), v));
+  excl_v.erase(std::find(excl_v.begin(), excl_v.end(), u));
+  ZXPhase vphase = g.get_phase(v);
+  ZXPhase uphase = g.get_phase(u);
+
+  add_phase_to_vertices(g, joint, vphase + uphase + ZXPhase(1, 1));
+  add_phase_to_vertices(g, excl_u, vphase);
+  add_phase_to_vertices(g, excl_v, uphase);
+
+  QuantumType vqtype = g.get_qtype(v);
+  g.complement_bipartite(joint, excl_u, vqtype);
+  g.complement_bipartite(joint, excl_v, vqtype);
+  g.complement_bipartite(excl_u, excl_v, vqtype);
+
+  g.remove_vertex(u);
+  g.remove_vertex(v);
+  return pivot_scalar_phase(vphase, uphase, vqtype);
+}
+
+static bool remove_interior_paulis_compact(
+    CompactZXGraph& g, ZXPhase& scalar_phase) {
+  bool success = false;
+  const unsigned n_verts = g.n_vertices();
+  std::vector<unsigned> candidates(n_verts);
+  std::iota(candidates.begin(), candidates.end(), 0);
+  std::vector<std::uint8_t> queued(n_verts, true);
+  std::vector<std::uint8_t> claimed(n_verts, false);
+  while (!candidates.empty()) {
+    std::vector<std::pair<unsigned, unsigned>> pairs;
+    std::vector<unsigned> matched, touched, next;
+    for (unsigned v : candidates) {
+      queued[v] = false;
+      if (g.is_removed(v) || !g.is_pauli_spider(v)) continue;
+      if (!can_complement_neighbourhood(g, v)) continue;
+      // Look for an interior Pauli neighbour, remembering whether one was
+      // only passed over for overlapping an earlier match
+      bool blocked = is_claimed(g, v, claimed);
+      std::optional<unsigned> found;
+      for (unsigned u : g.neighbours(v)) {
+        if (!g.is_pauli_spider(u) || !can_complement_neighbourhood(g, u))
+          continue;
+        if (blocked || is_claimed(g, u, claimed)) {
+          blocked = true;
+          continue;
+        }
+        found = u;
+        break;
+      }
+      if (found) {
+        claim(g, v, claimed, touched);
+        claim(g, *found, claimed, touched);
+        pairs.push_back({v, *found});
+        matched.push_back(v);
+        matched.push_back(*found);
+      } else if (blocked) {
+        queued[v] = true;
+        next.push_back(v);
+      }
+    }
+    std::vector<ZXPhase> phases(pairs.size());
+    parallel_for(
+        0, pairs.size(), min_matches_per_thread,
+        [&](std::size_t begin, std::size_t end) {
+          for (std::size_t i = begin; i < end; ++i) {
+            phases[i] = pivot_about(g, pairs[i].first, pairs[i].second);
+          }
+        });
+    for (const ZXPhase& p : phases) scalar_phase = scalar_phase + p;
+    success = success || !pairs.empty();
+    end_round(g, matched, touched, claimed, queued, next);
+    candidates.swap(next);
+  }
+  return success;
+}
+
 bool Rewrite::remove_interior_paulis_fun(ZXDiagram& diag) {
+  if (CompactZXGraph::is_graph_like(diag)) {
+    CompactZXGraph g(diag);
+    ZXPhase scalar_phase;
+    if (!remove_interior_paulis_compact(g, scalar_phase)) return false;
+    g.apply_to(diag);
+    if (!scalar_phase.is_zero()) {
+      diag.multiply_scalar_phase(scalar_phase.to_expr());
+    }
+    return true;
+  }
   bool success = false;
   ZXVertSeqSet candidates;  // Need an indirect iterator as BGL_FORALL_VERTICES
                             // breaks when removing the current vertex
@@ -171,9 +446,9 @@ bool Rewrite::remove_interior_paulis_fun(ZXDiagram& diag) {
     const BasicGen& u_spid = diag.get_vertex_ZXGen<BasicGen>(u);
 
     add_phase_to_vertices(
-        diag, joint, v_spid.get_param() + u_spid.get_param() + 1.);
-    add_phase_to_vertices(diag, excl_u, v_spid.get_param());
-    add_phase_to_vertices(diag, excl_v, u_spid.get_param());
+        diag, joint, v_spid.get_phase() + u_spid.get_phase() + ZXPhase(1, 1));
+    add_phase_to_vertices(diag, excl_u, v_spid.get_phase());
+    add_phase_to_vertices(diag, excl_v, u_spid.get_phase());
 
     // Because `can_complement_neighbourhood` checks all neighbours,
     // v and u have the same QuantumType
@@ -181,9 +456,14 @@ bool Rewrite::remove_interior_paulis_fun(ZXDiagram& diag) {
     bipartite_complementation(diag, joint, excl_v, vqtype);
     bipartite_complementation(diag, excl_u, excl_v, vqtype);
 
+    ZXPhase scalar_phase =
+        pivot_scalar_phase(v_spid.get_phase(), u_spid.get_phase(), vqtype);
     diag.remove_vertex(u);
     diag.remove_vertex(v);
     candidates.erase(u);
+    if (!scalar_phase.is_zero()) {
+      diag.multiply_scalar_phase(scalar_phase.to_expr());
+    }
     success = true;
   }
   return success;
@@ -237,6 +517,12 @@ Rewrite Rewrite::extend_at_boundary_paulis() {
   return Rewrite(extend_at_boundary_paulis_fun);
 }
 
+Rewrite Rewrite::reduce_graphlike_form() {
+  return Rewrite::repeat(Rewrite::sequence(
+      {Rewrite::remove_interior_cliffords(),
+       Rewrite::remove_interior_paulis()}));
+}
+
 }  // namespace zx
 
 }  // namespace tket
@@ -18,8 +18,10 @@
 #include "Circuit/CircUtils.hpp"
 #include "Circuit/Circuit.hpp"
 #include "Converters/PhasePoly.hpp"
+#include "Ops/Conditional.hpp"
 #include "Eigen/src/Core/Matrix.h"
 #include "Simulation/CircuitSimulator.hpp"
+#include "Utils/Parallel.hpp"
 
 namespace tket {
 namespace test_Boxes {
@@ -154,6 +156,21 @@ SCENARIO("Using Boxes", "[boxes]") {
     c.add_box(ubox, {0, 1});  // should act as the identity
     Eigen::MatrixXcd uc = tket_sim::get_unitary(c);
     REQUIRE((uc - Eigen::Matrix4cd::Identity()).cwiseAbs().sum() < ERR_EPS);
+    WHEN("Evaluating from the eigendecomposition") {
+      REQUIRE((ebox.get_unitary() - U.adjoint()).cwiseAbs().sum() < ERR_EPS);
+      for (double t : {0.25, 1.3, -2.}) {
+        const auto box = std::static_pointer_cast<const ExpBox>(
+            ebox.with_phase(t));
+        REQUIRE(box->get_matrix_and_phase().second == t);
+        Eigen::Matrix4cd V = (i_ * t * A).exp();
+        REQUIRE((box->get_exp_matrix() - V).cwiseAbs().sum() < ERR_EPS);
+      }
+      Eigen::MatrixXcd d = ebox.dagger()->get_unitary();
+      REQUIRE((d - U).cwiseAbs().sum() < ERR_EPS);
+      Eigen::MatrixXcd tr = ebox.transpose()->get_unitary();
+      Eigen::Matrix4cd V = (-0.5 * i_ * A.transpose()).exp();
+      REQUIRE((tr - V).cwiseAbs().sum() < ERR_EPS);
+    }
   }
 }
 
@@ -658,6 +675,28 @@ SCENARIO("QControlBox", "[boxes]") {
     }
     REQUIRE(U1.isApprox(V));
   }
+  GIVEN("repeated QControlBoxes") {
+    clear_qcontrol_box_cache();
+    QControlBox qcbox0(get_op_ptr(OpType::Ry, 0.3), 3);
+    QControlBox qcbox1(get_op_ptr(OpType::Ry, 0.3), 3);
+    QControlBox qcbox2(get_op_ptr(OpType::Ry, 0.3), 2);
+    QControlBox qcbox3(get_op_ptr(OpType::Ry, 0.5), 3);
+    std::shared_ptr<Circuit> c0 = qcbox0.to_circuit();
+    REQUIRE(qcontrol_box_cache_size() == 1);
+    // equal keys share one decomposition
+    REQUIRE(qcbox1.to_circuit() == c0);
+    REQUIRE(qcontrol_box_cache_size() == 1);
+    REQUIRE(qcbox2.to_circuit() != c0);
+    REQUIRE(qcbox3.to_circuit() != c0);
+    REQUIRE(qcontrol_box_cache_size() == 3);
+    Circuit c(4);
+    c.add_box(qcbox0, {0, 1, 2, 3});
+    c.add_box(qcbox3, {3, 2, 1, 0});
+    Circuit expected(4);
+    expected.add_op<unsigned>(OpType::CnRy, 0.3, {0, 1, 2, 3});
+    expected.add_op<unsigned>(OpType::CnRy, 0.5, {3, 2, 1, 0});
+    REQUIRE(test_unitary_comparison(c, expected));
+  }
 }
 
 SCENARIO("Unitary3qBox", "[boxes]") {
@@ -802,5 +841,103 @@ SCENARIO("Checking equality", "[boxes]") {
   }
 }
 
+SCENARIO("Interning and decomposing shared boxes", "[boxes]") {
+  GIVEN("Boxes interned for equal circuits") {
+    Circuit u(2);
+    u.add_op<unsigned>(OpType::Ry, 0.25, {0});
+    u.add_op<unsigned>(OpType::CX, {0, 1});
+    Circuit u2(2);
+    u2.add_op<unsigned>(OpType::Ry, 0.25, {0});
+    u2.add_op<unsigned>(OpType::CX, {0, 1});
+    std::shared_ptr<const CircBox> b1 = CircBox::intern(u);
+    std::shared_ptr<const CircBox> b2 = CircBox::intern(u2);
+    REQUIRE(b1 == b2);
+    REQUIRE(b1->to_circuit() == b2->to_circuit());
+    u2.set_name("other");
+    std::shared_ptr<const CircBox> b3 = CircBox::intern(u2);
+    REQUIRE(b3 != b1);
+    REQUIRE(!(*b3 == *b1));
+    u.add_op<unsigned>(OpType::H, {1});
+    REQUIRE(CircBox::intern(u) != b1);
+  }
+  GIVEN("Many instances of nested boxes") {
+    Circuit inner(2);
+    inner.add_op<unsigned>(OpType::Rz, 0.5, {1});
+    inner.add_op<unsigned>(OpType::CZ, {0, 1});
+    CircBox inner_box(inner);
+    Circuit outer(2);
+    outer.add_box(inner_box, {0, 1});
+    outer.add_op<unsigned>(OpType::H, {0});
+    outer.add_box(inner_box, {1, 0});
+    std::shared_ptr<const CircBox> outer_box = CircBox::intern(outer);
+    Circuit c(3, 1);
+    Op_ptr cond_box = std::make_shared<Conditional>(outer_box, 1, 1);
+    for (unsigned i = 0; i < 50; ++i) {
+      unsigned a = i % 3, b = (i + 1) % 3;
+      c.add_op<unsigned>(outer_box, {a, b});
+      if (i % 5 == 0) c.add_op<UnitID>(cond_box, {Bit(0), Qubit(b), Qubit(a)});
+    }
+    Circuit c2 = c;
+    REQUIRE(c.decompose_boxes());
+    c2.decompose_boxes_recursively();
+    REQUIRE(c.structural_hash() == c2.structural_hash());
+    REQUIRE(c.count_gates(OpType::CZ) == 100);
+    REQUIRE(c.count_gates(OpType::Conditional) == 50);
+    REQUIRE(c.count_gates(OpType::CircBox) == 0);
+  }
+  GIVEN("Many distinct boxes nested at different depths") {
+    Circuit leaf(2);
+    leaf.add_op<unsigned>(OpType::CX, {0, 1});
+    CircBox leaf_box(leaf);
+    Circuit c(4);
+    for (unsigned i = 0; i < 40; ++i) {
+      Circuit mid(2);
+      mid.add_op<unsigned>(OpType::Rz, 0.01 * (i + 1), {0});
+      mid.add_box(leaf_box, {i % 2, 1 - i % 2});
+      Circuit top(3);
+      top.add_box(CircBox(mid), {0, 2});
+      top.add_box(leaf_box, {1, 2});
+      c.add_box(CircBox(top), {i % 4, (i + 1) % 4, (i + 2) % 4});
+      c.add_box(leaf_box, {(i + 3) % 4, i % 4});
+    }
+    Circuit sequential = c;
+    Circuit by_levels = c;
+    const unsigned max_threads = get_max_threads();
+    set_max_threads(1);
+    sequential.decompose_boxes_recursively();
+    set_max_threads(max_threads);
+    c.decompose_boxes_recursively();
+    while (by_levels.decompose_boxes()) {
+    }
+    REQUIRE(c == sequential);
+    REQUIRE(c.structural_hash() == by_levels.structural_hash());
+    REQUIRE(c.count_gates(OpType::CX) == 120);
+    REQUIRE(c.count_gates(OpType::Rz) == 40);
+    REQUIRE(c.count_gates(OpType::CircBox) == 0);
+  }
+  GIVEN("Unitary boxes with equal matrices") {
+    Eigen::Matrix4cd m = Eigen::Matrix4cd::Zero();
+    m(0, 0) = 1.;
+    m(1, 2) = i_;
+    m(2, 1) = 1.;
+    m(3, 3) = 1.;
+    const Unitary2qBox b1(m);
+    const Unitary2qBox b2(m);
+    const Unitary2qBox b3(b1);
+    REQUIRE(&b1.get_matrix() == &b2.get_matrix());
+    REQUIRE(&b1.get_matrix() == &b3.get_matrix());
+    REQUIRE(!(b1 == b2));
+    const Unitary2qBox b4(m, BasisOrder::dlo);
+    REQUIRE(&b4.get_matrix() != &b1.get_matrix());
+    REQUIRE(b4.get_matrix() == reverse_indexing(m));
+    const Unitary1qBox u1(Eigen::Matrix2cd::Identity());
+    const Unitary1qBox u2;
+    REQUIRE(&u1.get_matrix() == &u2.get_matrix());
+    Op_ptr d = b1.dagger()->dagger();
+    const Unitary2qBox &b5 = static_cast<const Unitary2qBox &>(*d);
+    REQUIRE(&b5.get_matrix() == &b1.get_matrix());
+  }
+}
+
 }  // namespace test_Boxes
 }  // namespace tket
@@ -20,15 +20,22 @@
 #include <vector>
 
 #include "../testutil.hpp"
+#include "Circuit/CircPool.hpp"
 #include "Circuit/CircUtils.hpp"
 #include "Circuit/Circuit.hpp"
+#include "Circuit/CommandView.hpp"
+#include "Circuit/CompactDAG.hpp"
+#include "Circuit/DAGAllocator.hpp"
 #include "Circuit/DAGDefs.hpp"
+#include "Circuit/ReplacementTemplate.hpp"
+#include "Circuit/UnitPaths.hpp"
 #include "Gate/GatePtr.hpp"
 #include "OpType/EdgeType.hpp"
 #include "OpType/OpType.hpp"
 #include "OpType/OpTypeFunctions.hpp"
 #include "Ops/Op.hpp"
 #include "Ops/OpPtr.hpp"
+#include "Predicates/CompilationUnit.hpp"
 #include "Simulation/CircuitSimulator.hpp"
 #include "Transformations/Replacement.hpp"
 #include "Transformations/Transform.hpp"
@@ -192,6 +199,52 @@ SCENARIO("Creating gates via Qubits and Registers") {
   }
 }
 
+SCENARIO("Small-buffer edge and neighbour accessors") {
+  GIVEN("A circuit with Boolean edges and repeated neighbours") {
+    Circuit circ;
+    register_t qreg = circ.add_q_register("qb", 2);
+    register_t creg = circ.add_c_register("b", 2);
+    circ.add_op<UnitID>(OpType::CX, {qreg[0], qreg[1]});
+    circ.add_op<UnitID>(OpType::CZ, {qreg[0], qreg[1]});
+    circ.add_measure(Qubit(qreg[0]), Bit(creg[0]));
+    circ.add_conditional_gate<UnitID>(OpType::H, {}, {qreg[1]}, {creg[0]}, 1);
+    circ.add_conditional_gate<UnitID>(
+        OpType::Measure, {}, {qreg[1], creg[0]}, {creg[0], creg[1]}, 3);
+    THEN("Every vertex gets the same answers as from the vectors") {
+      SmallEdgeVec ins, outs;
+      SmallOptEdgeVec lin_outs;
+      SmallVertexVec succs, preds;
+      BGL_FORALL_VERTICES(v, circ.dag, DAG) {
+        circ.get_in_edges(v, ins);
+        circ.get_all_out_edges(v, outs);
+        circ.get_linear_out_edges(v, lin_outs);
+        circ.get_successors(v, succs);
+        circ.get_predecessors(v, preds);
+        EdgeVec ins_vec = circ.get_in_edges(v);
+        EdgeVec outs_vec = circ.get_all_out_edges(v);
+        std::vector<std::optional<Edge>> lin_vec =
+            circ.get_linear_out_edges(v);
+        VertexVec succs_vec = circ.get_successors(v);
+        VertexVec preds_vec = circ.get_predecessors(v);
+        CHECK(EdgeVec(ins.begin(), ins.end()) == ins_vec);
+        CHECK(EdgeVec(outs.begin(), outs.end()) == outs_vec);
+        CHECK(
+            std::vector<std::optional<Edge>>(
+                lin_outs.begin(), lin_outs.end()) == lin_vec);
+        CHECK(VertexVec(succs.begin(), succs.end()) == succs_vec);
+        CHECK(VertexVec(preds.begin(), preds.end()) == preds_vec);
+      }
+    }
+    THEN("Neighbours are listed once each, in port order") {
+      Vertex cx = circ.get_successors(circ.get_in(qreg[0]))[0];
+      SmallVertexVec succs_of_cx;
+      circ.get_successors(cx, succs_of_cx);
+      REQUIRE(succs_of_cx.size() == 1);
+      REQUIRE(circ.get_OpType_from_Vertex(succs_of_cx[0]) == OpType::CZ);
+    }
+  }
+}
+
 SCENARIO("Exception handling in get_(in/out)_edges") {
   GIVEN("A circuit with an unconnected input") {
     Circuit circ(2);
@@ -1235,6 +1288,291 @@ SCENARIO("Test depth_by_type method") {
   }
 }
 
+SCENARIO("Test CompactDAG snapshot") {
+  GIVEN("A circuit with quantum and classical wires") {
+    Circuit circ(3, 1);
+    circ.add_op<unsigned>(OpType::H, {1});
+    circ.add_op<unsigned>(OpType::H, {1});
+    circ.add_op<unsigned>(OpType::H, {1});
+    Vertex m0 = circ.add_measure(0, 0);
+    Vertex cx = circ.add_conditional_gate<unsigned>(
+        OpType::X, {}, uvec{1}, {0}, 1);
+    Vertex m1 = circ.add_measure(0, 0);
+    circ.add_barrier({0, 2});
+    circ.add_op<unsigned>(OpType::CX, {2, 0});
+    CompactDAG compact(circ);
+    WHEN("Checking the structure") {
+      REQUIRE(compact.n_vertices() == circ.n_vertices());
+      REQUIRE(compact.n_edges() == circ.n_edges());
+      for (unsigned i = 0; i < compact.n_vertices(); ++i) {
+        Vertex v = compact.get_vertex(i);
+        REQUIRE(compact.get_index(v) == i);
+        REQUIRE(compact.get_op(i) == circ.get_Op_ptr_from_Vertex(v));
+        auto [in_it, in_end] = compact.in_edges(i);
+        EdgeVec ins = circ.get_in_edges(v);
+        REQUIRE(unsigned(in_end - in_it) == ins.size());
+        for (unsigned p = 0; in_it != in_end; ++in_it, ++p) {
+          REQUIRE(in_it->edge == ins[p]);
+          REQUIRE(in_it->target_port == p);
+          REQUIRE(in_it->source < i);
+        }
+        auto [out_it, out_end] = compact.out_edges(i);
+        REQUIRE(unsigned(out_end - out_it) == circ.n_out_edges(v));
+        for (; out_it != out_end; ++out_it) {
+          REQUIRE(out_it->target > i);
+        }
+      }
+    }
+    WHEN("Comparing layers to slices") {
+      std::vector<std::optional<unsigned>> layers = compact.layers();
+      unsigned depth = 1;
+      for (Circuit::SliceIterator sit = circ.slice_begin();
+           sit != circ.slice_end(); ++sit) {
+        for (const Vertex& v : *sit) {
+          REQUIRE(layers[compact.get_index(v)] == depth);
+        }
+        depth++;
+      }
+      REQUIRE(layers[compact.get_index(m0)] == 1);
+      REQUIRE(layers[compact.get_index(cx)] == 4);
+      // The second measurement overwrites a bit read by the conditional
+      REQUIRE(layers[compact.get_index(m1)] == 5);
+      std::map<Vertex, unsigned> depth_map = circ.vertex_depth_map();
+      REQUIRE(depth_map.at(m1) == 4);
+      REQUIRE(depth_map.at(circ.get_out(Qubit(0))) == 7);
+    }
+    WHEN("Counting depth with skipped operations") {
+      REQUIRE(circ.depth_by_type(OpType::H) == 3);
+      REQUIRE(circ.depth_by_type(OpType::CX) == 1);
+      REQUIRE(compact.max_layer([](Op_ptr op) {
+        return op->get_type() != OpType::H;
+      }) == 3);
+    }
+  }
+  GIVEN("A circuit large enough to be layered in wavefronts") {
+    const unsigned n_qubits = 64;
+    Circuit circ(n_qubits, 1);
+    for (unsigned i = 0; i < 20000; ++i) {
+      const unsigned q = (i * 37) % n_qubits;
+      if (i % 3 == 0) {
+        circ.add_op<unsigned>(OpType::CX, {q, (q + 1 + i % 5) % n_qubits});
+      } else if (i % 101 == 0) {
+        circ.add_measure(q, 0);
+      } else if (i % 103 == 0) {
+        circ.add_conditional_gate<unsigned>(OpType::X, {}, uvec{q}, {0}, 1);
+      } else {
+        circ.add_op<unsigned>(OpType::H, {q});
+      }
+    }
+    SliceVec slices = circ.get_slices();
+    SliceVec by_layer = circ.get_slices_by_layer();
+    REQUIRE(by_layer.size() == slices.size());
+    for (unsigned k = 0; k < slices.size(); ++k) {
+      REQUIRE(
+          VertexSet(by_layer[k].begin(), by_layer[k].end()) ==
+          VertexSet(slices[k].begin(), slices[k].end()));
+    }
+  }
+  GIVEN("An empty circuit") {
+    Circuit circ(2);
+    CompactDAG compact(circ);
+    REQUIRE(compact.n_vertices() == 4);
+    REQUIRE(circ.depth() == 0);
+    REQUIRE_THROWS_AS(compact.get_index(Vertex()), MissingVertex);
+  }
+}
+
+SCENARIO("Indexing the paths of units") {
+  Circuit circ(2, 1);
+  circ.add_op<unsigned>(OpType::H, {0});
+  Vertex cx = circ.add_op<unsigned>(OpType::CX, {0, 1});
+  Vertex m = circ.add_measure(1, 0);
+  Vertex cz = circ.add_conditional_gate<unsigned>(
+      OpType::Z, {}, uvec{0}, {0}, 1);
+  std::shared_ptr<const UnitPathIndex> index = circ.get_unit_path_index();
+  REQUIRE(index->units().size() == 3);
+  for (const UnitID& unit : index->units()) {
+    const QPathDetailed& path = index->path(unit);
+    REQUIRE(path == circ.unit_path(unit));
+    for (unsigned k = 1; k < path.size(); ++k) {
+      Edge e = circ.get_nth_in_edge(path[k].first, path[k].second);
+      std::optional<UnitPathIndex::Position> pos = index->position(e);
+      REQUIRE(pos.has_value());
+      REQUIRE(index->units()[pos->unit] == unit);
+      REQUIRE(pos->index == k);
+      REQUIRE(index->at(unit, k) == path[k]);
+      if (k + 1 < path.size()) {
+        REQUIRE(index->next(e) == path[k + 1]);
+      } else {
+        REQUIRE(!index->next(e));
+      }
+    }
+  }
+  REQUIRE(index->at(Qubit(1), 1) == VertPort{cx, 1});
+  REQUIRE(index->at(Qubit(1), 2) == VertPort{m, 0});
+  // The conditional reads the bit through a Boolean edge, off the bit's wire
+  REQUIRE(!index->position(circ.get_nth_in_edge(cz, 0)));
+  REQUIRE_THROWS_AS(index->path(Qubit(2)), CircuitInvalidity);
+  // The index is kept until the circuit changes
+  REQUIRE(circ.get_unit_path_index() == index);
+  circ.add_op<unsigned>(OpType::X, {1});
+  std::shared_ptr<const UnitPathIndex> index2 = circ.get_unit_path_index();
+  REQUIRE(index2 != index);
+  REQUIRE(index2->path(Qubit(1)).size() == 5);
+  REQUIRE(circ.all_unit_paths().at(Qubit(1)) == index2->path(Qubit(1)));
+}
+
+SCENARIO("Viewing commands without copying them") {
+  Circuit circ(3, 2);
+  circ.add_op<unsigned>(OpType::H, {0}, "hadamard");
+  circ.add_op<unsigned>(OpType::CX, {0, 2});
+  circ.add_measure(2, 1);
+  circ.add_conditional_gate<unsigned>(OpType::Rz, {0.5}, uvec{1}, {1}, 1);
+  Vertex cx =
+      circ.add_conditional_gate<unsigned>(OpType::X, {}, uvec{0}, {0, 1}, 2);
+  circ.add_measure(1, 0);
+  std::vector<Command> coms;
+  for (const Command& com : circ) coms.push_back(com);
+  CommandViews views(circ);
+  REQUIRE(views.size() == coms.size());
+  for (unsigned i = 0; i < coms.size(); ++i) {
+    const CommandView& view = views[i];
+    REQUIRE(view.get_vertex() == coms[i].get_vertex());
+    REQUIRE(view.get_op_ptr() == coms[i].get_op_ptr());
+    REQUIRE(view.get_opgroup() == coms[i].get_opgroup());
+    REQUIRE(view.get_args() == coms[i].get_args());
+    REQUIRE(view.to_command() == coms[i]);
+    REQUIRE(nlohmann::json(view) == nlohmann::json(coms[i]));
+  }
+  REQUIRE(circ.get_commands() == coms);
+  // The conditional X reads both bits through Boolean edges
+  for (const CommandView& view : views) {
+    if (view.get_vertex() != cx) continue;
+    REQUIRE(view.n_args() == 3);
+    REQUIRE(view.get_arg(0) == Bit(0));
+    REQUIRE(view.get_arg(1) == Bit(1));
+    REQUIRE(view.get_arg(2) == Qubit(0));
+  }
+}
+
+SCENARIO("Test cached slices and commands") {
+  GIVEN("A circuit that is traversed and then modified") {
+    Circuit circ(3);
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    Vertex cx = circ.add_op<unsigned>(OpType::CX, {1, 2});
+    REQUIRE(circ.get_slices().size() == 3);
+    REQUIRE(circ.get_commands().size() == 3);
+    unsigned long version = circ.get_dag_version();
+    WHEN("Traversing again without changes") {
+      REQUIRE(circ.get_dag_version() == version);
+      REQUIRE(circ.get_slices().size() == 3);
+      REQUIRE(circ.get_commands().size() == 3);
+    }
+    WHEN("Adding an operation") {
+      circ.add_op<unsigned>(OpType::X, {2});
+      REQUIRE(circ.get_dag_version() > version);
+      REQUIRE(circ.get_slices().size() == 4);
+      std::vector<Command> coms = circ.get_commands();
+      REQUIRE(coms.size() == 4);
+      REQUIRE(coms.back().get_op_ptr()->get_type() == OpType::X);
+    }
+    WHEN("Removing an operation") {
+      circ.remove_vertex(
+          cx, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::Yes);
+      REQUIRE(circ.get_slices().size() == 2);
+      REQUIRE(circ.get_commands().size() == 2);
+    }
+    WHEN("Replacing an operation in place") {
+      circ.dag[cx].op = get_op_ptr(OpType::CZ);
+      std::vector<Command> coms = circ.get_commands();
+      REQUIRE(coms.back().get_op_ptr()->get_type() == OpType::CZ);
+      REQUIRE(coms.back().get_vertex() == cx);
+    }
+    WHEN("Renaming a unit") {
+      std::map<Qubit, Qubit> qm = {{Qubit(2), Qubit("a", 0)}};
+      circ.rename_units(qm);
+      std::vector<Command> coms = circ.get_commands();
+      unit_vector_t args = {Qubit(1), Qubit("a", 0)};
+      REQUIRE(coms.back().get_args() == args);
+    }
+    WHEN("Copying the circuit") {
+      Circuit copy = circ;
+      copy.add_op<unsigned>(OpType::Z, {0});
+      REQUIRE(copy.get_commands().size() == 4);
+      REQUIRE(circ.get_commands().size() == 3);
+    }
+  }
+}
+
+SCENARIO("Test cached depth metrics") {
+  GIVEN("A circuit whose depth has been measured") {
+    Circuit circ(3, 1);
+    circ.add_op<unsigned>(OpType::H, {0});
+    Vertex cx = circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::CX, {1, 2});
+    REQUIRE(circ.depth() == 3);
+    REQUIRE(circ.depth_by_type(OpType::CX) == 2);
+    WHEN("Appending operations") {
+      circ.add_op<unsigned>(OpType::X, {2});
+      REQUIRE(circ.depth() == 4);
+      circ.add_op<unsigned>(OpType::Z, {0});
+      REQUIRE(circ.depth() == 4);
+      circ.add_barrier({0, 1, 2});
+      REQUIRE(circ.depth() == 4);
+      circ.add_op<unsigned>(OpType::CX, {0, 2});
+      REQUIRE(circ.depth() == 5);
+      REQUIRE(circ.depth_by_type(OpType::CX) == 3);
+    }
+    WHEN("Appending a classical write after a read") {
+      circ.add_conditional_gate<unsigned>(OpType::X, {}, {2}, {0}, 1);
+      circ.add_op<unsigned>(OpType::Measure, {0, 0});
+      REQUIRE(circ.depth() == circ.get_slices().size());
+    }
+    WHEN("Removing an operation") {
+      circ.add_op<unsigned>(OpType::X, {1});
+      REQUIRE(circ.depth() == 4);
+      circ.remove_vertex(
+          cx, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::Yes);
+      REQUIRE(circ.depth() == 2);
+    }
+    WHEN("Replacing an operation in place") {
+      circ.set_vertex_Op_ptr(cx, get_op_ptr(OpType::CZ));
+      REQUIRE(circ.depth() == 3);
+      REQUIRE(circ.depth_by_type(OpType::CX) == 1);
+      REQUIRE(circ.depth_by_type(OpType::CZ) == 1);
+    }
+  }
+}
+
+SCENARIO("Test pooled DAG storage") {
+  GIVEN("A block released to the pool") {
+    DAGAllocator<EdgeProperties> alloc;
+    EdgeProperties* p = alloc.allocate(1);
+    alloc.deallocate(p, 1);
+    THEN("It is reused by the next allocation of the same size") {
+      DAGAllocator<std::pair<port_t, port_t>> other;
+      std::pair<port_t, port_t>* q = other.allocate(1);
+      REQUIRE(static_cast<void*>(q) == static_cast<void*>(p));
+      other.deallocate(q, 1);
+    }
+  }
+  GIVEN("Circuits copied and destroyed repeatedly") {
+    Circuit circ(4);
+    for (unsigned i = 0; i < 100; ++i) {
+      circ.add_op<unsigned>(OpType::CX, {i % 4, (i + 1) % 4});
+      circ.add_op<unsigned>(OpType::Rz, 0.1 * i, {i % 4});
+    }
+    for (unsigned i = 0; i < 10; ++i) {
+      Circuit copy = circ;
+      copy.add_op<unsigned>(OpType::H, {0});
+      REQUIRE(copy.n_gates() == circ.n_gates() + 1);
+      copy.assert_valid();
+    }
+    circ.assert_valid();
+  }
+}
+
 SCENARIO("Test extracting slice segments") {
   GIVEN("A simple circuit") {
     Circuit circ(3);
@@ -1349,6 +1687,46 @@ SCENARIO("Test circuit.dagger() method") {
   }
 }
 
+SCENARIO("Daggering and transposing a circuit in place") {
+  Circuit circ(3);
+  circ.add_op<unsigned>(OpType::CnRy, 0.2, {0, 1});
+  Eigen::Matrix4cd mat;
+  mat << 1, 0, 0, 0, 0, i_, 0, 0, 0, 0, 0, -i_, 0, 0, i_, 0;
+  circ.add_box(Unitary2qBox(mat), {1, 2});
+  circ.add_op<unsigned>(OpType::tk1, {0.3, 0.7, 0.8}, {1});
+  circ.add_op<unsigned>(OpType::SWAP, {0, 2});
+  circ.replace_SWAPs();
+  circ.add_op<unsigned>(OpType::CZ, {2, 1});
+  circ.add_phase(0.25);
+  const Eigen::MatrixXcd u = tket_sim::get_unitary(circ);
+  GIVEN("The dagger") {
+    Circuit daggered = circ;
+    daggered.dagger_in_place();
+    daggered.assert_valid();
+    REQUIRE(test_equiv_val(daggered.get_phase(), -0.25));
+    const Eigen::MatrixXcd udag = tket_sim::get_unitary(daggered);
+    REQUIRE(u.adjoint().isApprox(udag, ERR_EPS));
+    REQUIRE(udag.isApprox(tket_sim::get_unitary(circ.dagger()), ERR_EPS));
+    daggered.dagger_in_place();
+    REQUIRE(u.isApprox(tket_sim::get_unitary(daggered), ERR_EPS));
+  }
+  GIVEN("The transpose") {
+    Circuit transposed = circ;
+    transposed.transpose_in_place();
+    transposed.assert_valid();
+    const Eigen::MatrixXcd ut = tket_sim::get_unitary(transposed);
+    REQUIRE(u.transpose().isApprox(ut, ERR_EPS));
+  }
+  GIVEN("An operation without a dagger") {
+    Circuit c(1, 1);
+    c.add_op<unsigned>(OpType::H, {0});
+    c.add_op<unsigned>(OpType::Measure, {0, 0});
+    const Circuit copy = c;
+    REQUIRE_THROWS_AS(c.dagger_in_place(), CircuitInvalidity);
+    REQUIRE(c == copy);
+  }
+}
+
 SCENARIO("Test conditional_circuit method") {
   GIVEN("A circuit with wireswaps") {
     Circuit circ(2);
@@ -1546,6 +1924,77 @@ SCENARIO("Test substitute_all") {
   }
 }
 
+SCENARIO("Substituting disjoint subcircuits at once") {
+  Circuit circ(2, 1);
+  Vertex cx = circ.add_op<unsigned>(OpType::CX, {0, 1});
+  Vertex cz = circ.add_op<unsigned>(OpType::CZ, {0, 1});
+  Vertex m = circ.add_measure(1, 0);
+  circ.add_conditional_gate<unsigned>(OpType::X, {}, {0}, {0}, 1);
+  auto vertex_sub = [&circ](const Vertex &v) {
+    return Subcircuit(
+        circ.get_in_edges_of_type(v, EdgeType::Quantum),
+        circ.get_out_edges_of_type(v, EdgeType::Quantum),
+        circ.get_in_edges_of_type(v, EdgeType::Classical),
+        circ.get_out_edges_of_type(v, EdgeType::Classical),
+        circ.get_out_edges_of_type(v, EdgeType::Boolean), {v});
+  };
+  Circuit cx_rep(2);
+  cx_rep.add_op<unsigned>(OpType::H, {1});
+  cx_rep.add_op<unsigned>(OpType::CZ, {0, 1});
+  cx_rep.add_op<unsigned>(OpType::H, {1});
+  Circuit cz_rep(2);
+  cz_rep.add_op<unsigned>(OpType::H, {1});
+  cz_rep.add_op<unsigned>(OpType::CX, {0, 1});
+  cz_rep.add_op<unsigned>(OpType::H, {1});
+  cz_rep.add_phase(0.5);
+  Circuit m_rep(1, 1);
+  m_rep.add_op<unsigned>(OpType::X, {0});
+  m_rep.add_measure(0, 0);
+  m_rep.add_op<unsigned>(OpType::X, {0});
+  GIVEN("Adjacent vertices, one writing a bit read later") {
+    circ.substitute_disjoint(
+        {{vertex_sub(cx), &cx_rep},
+         {vertex_sub(cz), &cz_rep},
+         {vertex_sub(m), &m_rep}});
+    Circuit correct(2, 1);
+    correct.add_op<unsigned>(OpType::H, {1});
+    correct.add_op<unsigned>(OpType::CZ, {0, 1});
+    correct.add_op<unsigned>(OpType::H, {1});
+    correct.add_op<unsigned>(OpType::H, {1});
+    correct.add_op<unsigned>(OpType::CX, {0, 1});
+    correct.add_op<unsigned>(OpType::H, {1});
+    correct.add_op<unsigned>(OpType::X, {1});
+    correct.add_measure(1, 0);
+    correct.add_op<unsigned>(OpType::X, {1});
+    correct.add_conditional_gate<unsigned>(OpType::X, {}, {0}, {0}, 1);
+    correct.add_phase(0.5);
+    REQUIRE(circ == correct);
+    REQUIRE(circ.n_vertices() == correct.n_vertices());
+  }
+  GIVEN("An empty replacement between two others") {
+    Circuit empty(2);
+    circ.substitute_disjoint(
+        {{vertex_sub(cx), &cx_rep},
+         {vertex_sub(cz), &empty},
+         {vertex_sub(m), &m_rep}});
+    Circuit correct(2, 1);
+    correct.add_op<unsigned>(OpType::H, {1});
+    correct.add_op<unsigned>(OpType::CZ, {0, 1});
+    correct.add_op<unsigned>(OpType::H, {1});
+    correct.add_op<unsigned>(OpType::X, {1});
+    correct.add_measure(1, 0);
+    correct.add_op<unsigned>(OpType::X, {1});
+    correct.add_conditional_gate<unsigned>(OpType::X, {}, {0}, {0}, 1);
+    REQUIRE(circ == correct);
+  }
+  GIVEN("Overlapping subcircuits") {
+    REQUIRE_THROWS_AS(
+        circ.substitute_disjoint(
+            {{vertex_sub(cx), &cx_rep}, {vertex_sub(cx), &cx_rep}}),
+        CircuitInvalidity);
+  }
+}
+
 SCENARIO("Decomposing a multi-qubit operation into CXs") {
   const double sq = 1 / std::sqrt(2.);
   GIVEN("A CZ gate") {
@@ -2422,6 +2871,49 @@ SCENARIO("Confirm that LaTeX output compiles", "[latex]") {
   remove("circ.tex");
 }
 
+SCENARIO("Drawing circuits in LaTeX with options") {
+  auto count = [](const std::string &text, const std::string &pattern) {
+    unsigned n = 0;
+    for (std::size_t pos = text.find(pattern); pos != std::string::npos;
+         pos = text.find(pattern, pos + 1)) {
+      n++;
+    }
+    return n;
+  };
+  Circuit inner(2);
+  inner.add_op<unsigned>(OpType::CZ, {0, 1});
+  Circuit c(3, 1);
+  c.add_op<unsigned>(OpType::H, {0});
+  for (unsigned i = 0; i < 3; i++) c.add_op<unsigned>(OpType::CX, {0, 1});
+  c.add_box(CircBox(inner), std::vector<unsigned>{1, 2});
+  c.add_op<unsigned>(OpType::Measure, {2, 0});
+  GIVEN("Default options") {
+    std::stringstream out;
+    c.to_latex(out);
+    std::string latex = c.to_latex_str();
+    REQUIRE(out.str() == latex);
+    REQUIRE(count(latex, "\\targ{}") == 3);
+    REQUIRE(count(latex, "CircBox") == 1);
+    REQUIRE(count(latex, "\\slice") == 0);
+  }
+  GIVEN("Repeated layers collapsed") {
+    LatexOptions options;
+    options.collapse_repeated_layers = true;
+    std::string latex = c.to_latex_str(options);
+    REQUIRE(count(latex, "\\targ{}") == 1);
+    REQUIRE(count(latex, "\\slice{$\\times 3$}") == 1);
+    REQUIRE(count(latex, "\\meter{}") == 1);
+  }
+  GIVEN("Boxes expanded") {
+    LatexOptions options;
+    options.expand_boxes = true;
+    std::string latex = c.to_latex_str(options);
+    REQUIRE(count(latex, "CircBox") == 0);
+    REQUIRE(count(latex, "\\control{}") == 1);
+    REQUIRE(count(latex, "\\targ{}") == 3);
+  }
+}
+
 SCENARIO("Vertex info maps") {
   GIVEN("A mixed circuit with wire swaps") {
     Circuit c;
@@ -2463,6 +2955,29 @@ SCENARIO("Vertex info maps") {
       REQUIRE(dmap.at(c.get_in(qbs[0])) == 0);
       REQUIRE(dmap.at(c.get_out(bs[0])) == 4);
     }
+    THEN("The dense arrays agree with the maps") {
+      std::map<Vertex, unit_set_t> vmap = c.vertex_unit_map();
+      std::map<Vertex, unsigned> dmap = c.vertex_depth_map();
+      std::map<Vertex, unsigned> rmap = c.vertex_rev_depth_map();
+      VertexArray<unit_set_t> varr = c.vertex_unit_array();
+      VertexArray<unsigned> darr = c.vertex_depth_array();
+      VertexArray<unsigned> rarr = c.vertex_rev_depth_array();
+      REQUIRE(varr.size() == vmap.size());
+      REQUIRE(darr.size() == dmap.size());
+      REQUIRE(rarr.size() == rmap.size());
+      for (const auto &[v, units] : vmap) REQUIRE(varr.at(v) == units);
+      for (const auto &[v, d] : dmap) REQUIRE(darr.at(v) == d);
+      for (const auto &[v, d] : rmap) REQUIRE(rarr.at(v) == d);
+      AND_WHEN("A vertex is added after indexing") {
+        Vertex h = c.add_op<unsigned>(OpType::H, {3});
+        REQUIRE(darr.count(h) == 0);
+        REQUIRE_THROWS_AS(darr.at(h), std::out_of_range);
+        REQUIRE(darr.insert(h, 5));
+        REQUIRE(!darr.insert(h, 6));
+        REQUIRE(darr.at(h) == 5);
+        REQUIRE(darr.at(z) == 0);
+      }
+    }
   }
   GIVEN("A mixed circuit with no classical control") {
     Circuit c;
@@ -2523,6 +3038,60 @@ SCENARIO("Trying to add a Measure gate with no classical output") {
       circ.add_op<unsigned>(OpType::Measure, {0}), CircuitInvalidity);
 }
 
+SCENARIO("Appending by moving and adding ops in batches") {
+  GIVEN("A circuit moved onto the end of another") {
+    Circuit circ(2, 1);
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    Circuit c2(3, 1);
+    Vertex cx = c2.add_op<unsigned>(OpType::CX, {1, 2});
+    c2.add_measure(2, 0);
+    c2.add_phase(0.5);
+    Circuit expected = circ;
+    expected.append(c2);
+    circ.append(std::move(c2));
+    REQUIRE(circ == expected);
+    circ.assert_valid();
+    REQUIRE(c2.n_vertices() == 0);
+    // The vertices of c2 were moved rather than copied
+    REQUIRE(circ.get_OpType_from_Vertex(cx) == OpType::CX);
+    REQUIRE(circ.get_commands().size() == 4);
+  }
+  GIVEN("Circuits with clashing register types") {
+    Circuit circ(1);
+    Circuit c2;
+    c2.add_bit(Bit(q_default_reg(), 0));
+    REQUIRE_THROWS_AS(circ.append(std::move(c2)), Unsupported);
+    // Nothing was moved
+    REQUIRE(circ.n_vertices() == 2);
+    REQUIRE(c2.n_bits() == 1);
+  }
+  GIVEN("A batch of ops") {
+    Circuit circ(3, 1);
+    unit_vector_t units = {Qubit(0), Qubit(1), Qubit(2), Bit(0)};
+    std::vector<Vertex> vs = circ.add_ops(
+        {{get_op_ptr(OpType::H), {0}},
+         {get_op_ptr(OpType::CX), {0, 2}},
+         {get_op_ptr(OpType::Measure), {2, 3}},
+         {get_op_ptr(OpType::Rz, 0.25), {1}}},
+        units);
+    Circuit expected(3, 1);
+    expected.add_op<unsigned>(OpType::H, {0});
+    expected.add_op<unsigned>(OpType::CX, {0, 2});
+    expected.add_measure(2, 0);
+    expected.add_op<unsigned>(OpType::Rz, 0.25, {1});
+    REQUIRE(circ == expected);
+    REQUIRE(vs.size() == 4);
+    REQUIRE(circ.get_OpType_from_Vertex(vs[1]) == OpType::CX);
+    REQUIRE_THROWS_AS(
+        circ.add_ops({{get_op_ptr(OpType::CX), {1, 1}}}, units),
+        CircuitInvalidity);
+    REQUIRE_THROWS_AS(
+        circ.add_ops({{get_op_ptr(OpType::X), {4}}}, units), CircuitInvalidity);
+    REQUIRE(circ == expected);
+  }
+}
+
 SCENARIO("Testing add_op with Barrier type and add_barrier") {
   // TKET-377
   GIVEN("An attempt to add a Barrier with Qubit arguments") {
@@ -2704,5 +3273,281 @@ SCENARIO("Vertices in order") {
   }
 }
 
+SCENARIO("Recording changes to a circuit") {
+  Circuit circ(3);
+  Vertex h = circ.add_op<unsigned>(OpType::H, {0});
+  Vertex cx = circ.add_op<unsigned>(OpType::CX, {0, 1});
+  Vertex x = circ.add_op<unsigned>(OpType::X, {2});
+  GIVEN("No recording") {
+    REQUIRE(!circ.is_recording_changes());
+    REQUIRE_THROWS_AS(circ.get_changes_since(0), CircuitInvalidity);
+  }
+  GIVEN("Vertices added, removed and replaced") {
+    circ.record_changes(true);
+    std::size_t checkpoint = circ.get_change_checkpoint();
+    circ.remove_vertex(
+        h, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::Yes);
+    circ.set_vertex_Op_ptr(x, get_op_ptr(OpType::Y));
+    Vertex z = circ.add_op<unsigned>(OpType::Z, {1});
+    Circuit::ChangeLog log = circ.get_changes_since(checkpoint);
+    REQUIRE(log.added == VertexSet{z});
+    REQUIRE(log.removed.size() == 1);
+    CHECK(log.removed[0]->get_type() == OpType::H);
+    REQUIRE(log.replaced.size() == 1);
+    CHECK(log.replaced.at(x)->get_type() == OpType::X);
+    CHECK(log.rewired.count(cx) == 1);
+    CHECK(!log.rebuilt);
+    WHEN("A later checkpoint is taken") {
+      std::size_t later = circ.get_change_checkpoint();
+      CHECK(circ.get_changes_since(later).empty());
+    }
+    WHEN("A replaced vertex is then removed") {
+      circ.remove_vertex(
+          x, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::Yes);
+      log = circ.get_changes_since(checkpoint);
+      CHECK(log.replaced.empty());
+      REQUIRE(log.removed.size() == 2);
+      // The operation at the checkpoint is reported
+      CHECK(log.removed[1]->get_type() == OpType::X);
+    }
+    WHEN("An added vertex is then removed") {
+      circ.remove_vertex(
+          z, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::Yes);
+      log = circ.get_changes_since(checkpoint);
+      CHECK(log.added.empty());
+      CHECK(log.removed.size() == 1);
+    }
+  }
+  GIVEN("The circuit assigned to") {
+    circ.record_changes(true);
+    circ = Circuit(3);
+    CHECK(circ.get_changes_since(0).rebuilt);
+    CHECK(circ.is_valid_since(0));
+  }
+  GIVEN("Validating the changes since a checkpoint") {
+    // Without recording, the whole circuit is checked
+    CHECK(circ.is_valid_since(0));
+    circ.record_changes(true);
+    std::size_t checkpoint = circ.get_change_checkpoint();
+    circ.remove_vertex(
+        h, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::Yes);
+    circ.add_op<unsigned>(OpType::CZ, {1, 2});
+    CHECK(circ.is_valid_since(checkpoint));
+    WHEN("An edge is removed, unbalancing a vertex") {
+      circ.remove_edge(circ.get_nth_out_edge(cx, 0));
+      CHECK(!circ.is_valid_since(checkpoint));
+    }
+  }
+  GIVEN("A copy of a recording circuit") {
+    circ.record_changes(true);
+    Circuit copy = circ;
+    CHECK(!copy.is_recording_changes());
+  }
+}
+
+SCENARIO("Structural hashing") {
+  GIVEN("The same circuit built in different orders") {
+    Circuit c1(3);
+    c1.add_op<unsigned>(OpType::H, {0});
+    c1.add_op<unsigned>(OpType::Rz, 0.3, {2});
+    c1.add_op<unsigned>(OpType::CX, {0, 1});
+    Circuit c2(3);
+    c2.add_op<unsigned>(OpType::Rz, 0.3, {2});
+    c2.add_op<unsigned>(OpType::H, {0});
+    c2.add_op<unsigned>(OpType::CX, {0, 1});
+    REQUIRE(c1 == c2);
+    REQUIRE(c1.structural_hash() == c2.structural_hash());
+    Circuit c3 = c1;
+    REQUIRE(c3.structural_hash() == c1.structural_hash());
+    REQUIRE(hash_value(c3) == c1.structural_hash());
+  }
+  GIVEN("Circuits that differ") {
+    Circuit c(2);
+    c.add_op<unsigned>(OpType::Rz, 0.5, {0});
+    c.add_op<unsigned>(OpType::CX, {0, 1});
+    const std::size_t h = c.structural_hash();
+    Circuit param(2);
+    param.add_op<unsigned>(OpType::Rz, 0.25, {0});
+    param.add_op<unsigned>(OpType::CX, {0, 1});
+    CHECK(param.structural_hash() != h);
+    Circuit wiring(2);
+    wiring.add_op<unsigned>(OpType::Rz, 0.5, {0});
+    wiring.add_op<unsigned>(OpType::CX, {1, 0});
+    CHECK(wiring.structural_hash() != h);
+    Circuit order(2);
+    order.add_op<unsigned>(OpType::CX, {0, 1});
+    order.add_op<unsigned>(OpType::Rz, 0.5, {0});
+    CHECK(order.structural_hash() != h);
+    Circuit units;
+    register_t reg = units.add_q_register("r", 2);
+    units.add_op<UnitID>(OpType::Rz, 0.5, {reg[0]});
+    units.add_op<UnitID>(OpType::CX, {reg[0], reg[1]});
+    CHECK(units.structural_hash() != h);
+    Circuit named = c;
+    named.set_name("named");
+    CHECK(named.structural_hash() != h);
+  }
+  GIVEN("Parameters and phases equal modulo their period") {
+    Circuit c1(1);
+    c1.add_op<unsigned>(OpType::Rz, 0., {0});
+    Circuit c2(1);
+    c2.add_op<unsigned>(OpType::Rz, 4., {0});
+    c2.add_phase(2.);
+    REQUIRE(c1 == c2);
+    REQUIRE(c1.structural_hash() == c2.structural_hash());
+  }
+  GIVEN("Conditional operations") {
+    Circuit c1(1, 1);
+    c1.add_conditional_gate<unsigned>(OpType::X, {}, {0}, {0}, 1);
+    Circuit c2(1, 1);
+    c2.add_conditional_gate<unsigned>(OpType::X, {}, {0}, {0}, 0);
+    CHECK(c1.structural_hash() != c2.structural_hash());
+  }
+}
+
+SCENARIO("Substituting replacement templates") {
+  GIVEN("A circuit with many SWAPs") {
+    Circuit circ(4);
+    std::vector<Vertex> swaps;
+    for (unsigned i = 0; i < 12; ++i) {
+      circ.add_op<unsigned>(OpType::Rx, 0.1 * i, {i % 4});
+      swaps.push_back(
+          circ.add_op<unsigned>(OpType::SWAP, {i % 4, (i + 1 + i / 4) % 4}));
+    }
+    Circuit expected = circ;
+    const Eigen::MatrixXcd u = tket_sim::get_unitary(circ);
+    const ReplacementTemplate& tmpl = CircPool::SWAP_using_CX_0_template();
+    REQUIRE(tmpl.n_qubits() == 2);
+    REQUIRE(tmpl.n_gates() == 3);
+    for (const Vertex& v : swaps) tmpl.substitute(circ, v);
+    REQUIRE(expected.substitute_all(
+        CircPool::SWAP_using_CX_0(), get_op_ptr(OpType::SWAP)));
+    REQUIRE_NOTHROW(circ.assert_valid());
+    CHECK(circ.count_gates(OpType::CX) == 36);
+    CHECK(circ.n_vertices() == expected.n_vertices());
+    CHECK(tket_sim::get_unitary(circ).isApprox(u));
+    CHECK(tket_sim::get_unitary(expected).isApprox(u));
+  }
+  GIVEN("A replacement with an implicit permutation and a phase") {
+    Circuit repl(3);
+    repl.add_op<unsigned>(OpType::H, {0});
+    repl.add_op<unsigned>(OpType::SWAP, {0, 2});
+    repl.add_op<unsigned>(OpType::CX, {2, 1});
+    repl.replace_SWAPs();
+    repl.add_phase(0.25);
+    const ReplacementTemplate tmpl(repl);
+    Circuit circ(4);
+    circ.add_op<unsigned>(OpType::Ry, 0.3, {1});
+    circ.add_op<unsigned>(OpType::Rz, 0.7, {3});
+    Vertex v = circ.add_op<unsigned>(OpType::CCX, {3, 0, 1});
+    circ.add_op<unsigned>(OpType::CX, {1, 2});
+    Circuit expected = circ;
+    tmpl.substitute(circ, v);
+    expected.substitute(repl, v);
+    REQUIRE_NOTHROW(circ.assert_valid());
+    CHECK(circ.count_gates(OpType::CCX) == 0);
+    CHECK(circ.get_phase() == expected.get_phase());
+    CHECK(tket_sim::get_unitary(circ).isApprox(
+        tket_sim::get_unitary(expected)));
+  }
+  GIVEN("Invalid replacements") {
+    Circuit with_bits(2, 1);
+    with_bits.add_op<unsigned>(OpType::Measure, {0, 0});
+    REQUIRE_THROWS_AS(ReplacementTemplate(with_bits), CircuitInvalidity);
+    const ReplacementTemplate& tmpl = CircPool::BRIDGE_using_CX_0_template();
+    Circuit circ(2);
+    Vertex v = circ.add_op<unsigned>(OpType::CX, {0, 1});
+    REQUIRE_THROWS_AS(tmpl.substitute(circ, v), CircuitInvalidity);
+  }
+}
+
+SCENARIO("Counting operation types") {
+  Circuit circ(3, 1);
+  circ.add_op<unsigned>(OpType::H, {0});
+  Vertex cx = circ.add_op<unsigned>(OpType::CX, {0, 1});
+  circ.add_conditional_gate<unsigned>(OpType::Rz, {0.5}, {2}, {0}, 1);
+  Circuit::OpTypeCounts counts = circ.optype_counts();
+  CHECK(counts.counts[static_cast<std::size_t>(OpType::Input)] == 3);
+  CHECK(counts.counts[static_cast<std::size_t>(OpType::ClOutput)] == 1);
+  CHECK(counts.counts[static_cast<std::size_t>(OpType::Conditional)] == 1);
+  CHECK(counts.conditioned[static_cast<std::size_t>(OpType::Rz)] == 1);
+  CHECK(counts.conditioned_types().count() == 1);
+  CHECK(circ.count_gates(OpType::CX) == 1);
+  // The counts are kept up to date as the circuit changes.
+  circ.add_op<unsigned>(OpType::CX, {1, 2});
+  circ.set_vertex_Op_ptr(cx, get_op_ptr(OpType::CZ));
+  Vertex t = circ.add_op<unsigned>(OpType::T, {0});
+  circ.remove_vertex(
+      t, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::Yes);
+  circ.add_measure(2, 0);
+  counts = circ.optype_counts();
+  const Circuit copy = circ;
+  CHECK(counts.counts == copy.optype_counts().counts);
+  CHECK(counts.conditioned == copy.optype_counts().conditioned);
+  CHECK(circ.count_gates(OpType::CX) == 1);
+  CHECK(circ.count_gates(OpType::CZ) == 1);
+  CHECK(circ.count_gates(OpType::T) == 0);
+  std::map<OpType, unsigned> op_counts = circ.op_counts();
+  CHECK(op_counts.at(OpType::Measure) == 1);
+  CHECK(op_counts.count(OpType::T) == 0);
+  // Changes outside single vertices are counted afresh.
+  circ.remove_blank_wires();
+  circ.append(copy);
+  CHECK(circ.count_gates(OpType::CZ) == 2);
+  CHECK(circ.count_gates(OpType::Input) == 3);
+}
+
+SCENARIO("Estimating the memory used by a circuit") {
+  Circuit circ(3, 1);
+  circ.add_op<unsigned>(OpType::H, {0});
+  circ.add_op<unsigned>(OpType::CX, {0, 1});
+  const Circuit::MemoryUsage before = circ.memory_usage();
+  CHECK(before.vertices > 0);
+  CHECK(before.edges > 0);
+  CHECK(before.units > 0);
+  CHECK(before.expressions > 0);
+  CHECK(before.boxes == 0);
+  CHECK(before.opgroups == 0);
+  CHECK(before.total() > before.vertices + before.edges);
+
+  GIVEN("More gates, symbolic parameters and op groups") {
+    Sym a = SymEngine::symbol("alpha");
+    circ.add_op<unsigned>(OpType::Rz, Expr(a) + 1, {2}, "group");
+    circ.add_op<unsigned>(OpType::CX, {1, 2});
+    const Circuit::MemoryUsage after = circ.memory_usage();
+    CHECK(after.vertices > before.vertices);
+    CHECK(after.edges > before.edges);
+    CHECK(after.expressions > before.expressions);
+    CHECK(after.opgroups > 0);
+    CHECK(after.units == before.units);
+  }
+  GIVEN("A box used twice") {
+    Circuit inner(2);
+    inner.add_op<unsigned>(OpType::CZ, {0, 1});
+    CircBox box(inner);
+    circ.add_box(box, std::vector<unsigned>{1, 2});
+    const Circuit::MemoryUsage once = circ.memory_usage();
+    CHECK(once.boxes > 0);
+    circ.add_box(box, std::vector<unsigned>{0, 1});
+    const Circuit::MemoryUsage twice = circ.memory_usage();
+    // The copies of the box share its circuit, which is counted once.
+    CHECK(twice.boxes == once.boxes);
+    CHECK(twice.unique_ops + twice.shared_ops > once.unique_ops);
+  }
+  GIVEN("Cached traversals") {
+    circ.get_commands();
+    CHECK(circ.memory_usage().caches > before.caches);
+  }
+  GIVEN("A compilation unit") {
+    CompilationUnit cu(circ, {std::make_shared<GateSetPredicate>(
+                                 OpTypeSet{OpType::H, OpType::CX})});
+    const CompilationUnit::MemoryUsage usage = cu.memory_usage();
+    CHECK(usage.circuit.vertices == before.vertices);
+    CHECK(usage.unit_maps > 0);
+    CHECK(usage.predicates > 0);
+    CHECK(usage.total() > usage.circuit.total());
+  }
+}
+
 }  // namespace test_Circ
 }  // namespace tket
@@ -0,0 +1,149 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <sstream>
+
+#include "../testutil.hpp"
+#include "Circuit/Boxes.hpp"
+#include "Circuit/CircuitBinary.hpp"
+#include "Transformations/Transform.hpp"
+#include "Utils/Json.hpp"
+
+namespace tket {
+namespace test_CircuitBinary {
+
+static Circuit round_trip(const Circuit &circ) {
+  std::stringstream ss;
+  write_circuit_binary(ss, circ);
+  std::string data = ss.str();
+  return read_circuit_binary(data.data(), data.size());
+}
+
+SCENARIO("Binary circuit round trips") {
+  GIVEN("Gates, registers, a barrier and a phase") {
+    Circuit c(2, 2, "test_circ_1");
+    c.add_op<unsigned>(OpType::Rz, 0.2, {0});
+    c.add_op<unsigned>(OpType::H, {0});
+    c.add_op<unsigned>(OpType::Measure, {0, 1});
+    const qubit_vector_t q = c.all_qubits();
+    const Qubit a = Qubit("a", 1, 2);
+    c.add_qubit(a);
+    c.add_op<UnitID>(OpType::CnRy, 0.1, {q[0], a, q[1]});
+    c.add_barrier({q[0], a});
+    c.add_phase(0.3);
+    Circuit new_c = round_trip(c);
+    REQUIRE(new_c == c);
+    REQUIRE(new_c.get_name() == c.get_name());
+  }
+  GIVEN("Symbolic parameters and opgroups") {
+    Sym s = SymEngine::symbol("s");
+    Circuit c(2);
+    c.add_op<unsigned>(OpType::Rx, Expr(s) / 2, {0});
+    c.add_op<unsigned>(OpType::CX, {0, 1}, "g1");
+    c.add_op<unsigned>(OpType::Rx, Expr(s) / 2, {1});
+    c.add_op<unsigned>(OpType::tk1, {0.5, Expr(s), 1.25}, {1}, "g2");
+    c.add_op<unsigned>(OpType::CX, {1, 0}, "g1");
+    c.add_phase(Expr(s));
+    REQUIRE(round_trip(c) == c);
+  }
+  GIVEN("An implicit permutation") {
+    Circuit c(3);
+    add_2qb_gates(c, OpType::CX, {{0, 1}, {1, 0}, {1, 2}, {2, 1}});
+    Transform::clifford_simp().apply(c);
+    Circuit new_c = round_trip(c);
+    REQUIRE(new_c == c);
+    REQUIRE(
+        new_c.implicit_qubit_permutation() == c.implicit_qubit_permutation());
+  }
+  GIVEN("Conditionals and boxes") {
+    Circuit c(3, 3);
+    c.add_conditional_gate<unsigned>(OpType::Ry, {-0.75}, {0}, {0, 1}, 1);
+    c.add_conditional_gate<unsigned>(OpType::CX, {}, {0, 1}, {0, 1}, 1);
+    Circuit inner(2, "inner");
+    inner.add_op<unsigned>(OpType::Ry, 0.75, {0});
+    inner.add_op<unsigned>(OpType::CX, {0, 1});
+    CircBox box(inner);
+    c.add_box(box, {1, 2});
+    c.add_box(box, {0, 1});
+    REQUIRE(round_trip(c) == c);
+  }
+}
+
+SCENARIO("Binary circuit encoding") {
+  GIVEN("A large circuit") {
+    Circuit c(20);
+    for (unsigned layer = 0; layer < 200; ++layer) {
+      for (unsigned q = 0; q < 20; ++q) {
+        c.add_op<unsigned>(OpType::Rz, 0.25 * (q % 4), {q});
+      }
+      for (unsigned q = layer % 2; q + 1 < 20; q += 2) {
+        c.add_op<unsigned>(OpType::CX, {q, q + 1});
+      }
+    }
+    std::stringstream ss;
+    write_circuit_binary(ss, c);
+    nlohmann::json j = c;
+    // One byte per operation index and per argument
+    REQUIRE(ss.str().size() < 3 * c.n_gates());
+    REQUIRE(ss.str().size() * 10 < j.dump().size());
+    REQUIRE(read_circuit_binary(ss) == c);
+  }
+  GIVEN("A circuit written command by command") {
+    Circuit c(2, 1);
+    c.add_op<unsigned>(OpType::H, {0});
+    c.add_op<unsigned>(OpType::CX, {0, 1});
+    c.add_measure(1, 0);
+    std::stringstream ss;
+    CircuitBinaryWriter writer(ss, c.all_qubits(), c.all_bits());
+    for (const Command &com : c) {
+      writer.write_command(com.get_op_ptr(), com.get_args());
+    }
+    REQUIRE_THROWS_AS(
+        writer.write_command(get_op_ptr(OpType::X), {Qubit(5)}),
+        CircuitBinaryError);
+    writer.finish();
+    REQUIRE_THROWS_AS(
+        writer.write_command(get_op_ptr(OpType::X), {Qubit(0)}),
+        CircuitBinaryError);
+    REQUIRE(read_circuit_binary(ss) == c);
+  }
+  GIVEN("A file") {
+    Circuit c(3);
+    c.add_op<unsigned>(OpType::CCX, {0, 1, 2});
+    c.add_op<unsigned>(OpType::Ry, 0.5, {2});
+    std::string filename = "circuit_binary_test.tkcb";
+    write_circuit_binary_file(filename, c);
+    Circuit new_c = read_circuit_binary_file(filename);
+    std::remove(filename.c_str());
+    REQUIRE(new_c == c);
+  }
+  GIVEN("Invalid data") {
+    Circuit c(2);
+    c.add_op<unsigned>(OpType::CZ, {0, 1});
+    std::stringstream ss;
+    write_circuit_binary(ss, c);
+    std::string data = ss.str();
+    REQUIRE_THROWS_AS(
+        read_circuit_binary(data.data(), data.size() - 1),
+        CircuitBinaryError);
+    data[0] = 'X';
+    REQUIRE_THROWS_AS(
+        read_circuit_binary(data.data(), data.size()), CircuitBinaryError);
+  }
+}
+
+}  // namespace test_CircuitBinary
+}  // namespace tket
@@ -0,0 +1,114 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <catch2/catch.hpp>
+
+#include "Circuit/Boxes.hpp"
+#include "Circuit/Circuit.hpp"
+#include "Circuit/HierarchicalMetrics.hpp"
+#include "Predicates/Predicates.hpp"
+
+namespace tket {
+namespace test_HierarchicalMetrics {
+
+// Compare the metrics of a circuit with those of its decomposition
+static void check_against_decomposition(const Circuit &circ) {
+  HierarchicalMetrics metrics;
+  Circuit flat = circ;
+  flat.decompose_boxes_recursively();
+  std::map<OpType, unsigned long long> counts = metrics.gate_counts(circ);
+  unsigned long long total = 0;
+  for (const std::pair<const OpType, unsigned long long> &tc : counts) {
+    CHECK(flat.count_gates(tc.first) == tc.second);
+    total += tc.second;
+  }
+  CHECK(total == boost::num_vertices(flat.dag));
+  CHECK(metrics.depth(circ) == flat.depth());
+  OpTypeSet types = metrics.gate_types(circ);
+  GateSetPredicate exact(types);
+  CHECK(exact.verify(flat));
+  CHECK(exact.verify_expanded(circ, metrics));
+  for (OpType type : types) {
+    OpTypeSet fewer = types;
+    fewer.erase(type);
+    GateSetPredicate pred(fewer);
+    CHECK(!pred.verify(flat));
+    CHECK(!pred.verify_expanded(circ, metrics));
+  }
+}
+
+SCENARIO("Metrics of circuits with boxes") {
+  GIVEN("A circuit without boxes") {
+    Circuit c(3, 1);
+    c.add_op<unsigned>(OpType::H, {0});
+    c.add_op<unsigned>(OpType::CX, {0, 1});
+    c.add_barrier({0, 1, 2});
+    c.add_measure(1, 0);
+    c.add_conditional_gate<unsigned>(OpType::X, {}, {2}, {0}, 1);
+    check_against_decomposition(c);
+  }
+  GIVEN("Nested boxes") {
+    Circuit inner(2);
+    inner.add_op<unsigned>(OpType::Rz, 0.5, {1});
+    inner.add_op<unsigned>(OpType::CZ, {0, 1});
+    inner.add_op<unsigned>(OpType::Rx, 0.5, {1});
+    CircBox inner_box(inner);
+    Circuit middle(3);
+    middle.add_box(inner_box, {0, 1});
+    middle.add_op<unsigned>(OpType::H, {2});
+    middle.add_box(inner_box, {2, 1});
+    middle.add_box(inner_box, {1, 0});
+    CircBox middle_box(middle);
+    Circuit c(4);
+    c.add_op<unsigned>(OpType::X, {3});
+    c.add_box(middle_box, {0, 1, 2});
+    c.add_box(middle_box, {3, 2, 1});
+    c.add_box(inner_box, {0, 3});
+    check_against_decomposition(c);
+    HierarchicalMetrics metrics;
+    CHECK(metrics.count_gates(c, OpType::CZ) == 7);
+    CHECK(metrics.count_gates(c, OpType::CircBox) == 0);
+  }
+  GIVEN("Boxes with bits and conditions") {
+    Circuit inner(2, 1);
+    inner.add_op<unsigned>(OpType::H, {0});
+    inner.add_measure(0, 0);
+    inner.add_conditional_gate<unsigned>(OpType::Z, {}, {1}, {0}, 1);
+    inner.add_op<unsigned>(OpType::Y, {0});
+    CircBox inner_box(inner);
+    Circuit c(3, 2);
+    c.add_box(inner_box, {0, 1, 0});
+    c.add_op<unsigned>(OpType::CX, {1, 2});
+    Op_ptr cond = std::make_shared<Conditional>(
+        std::make_shared<CircBox>(inner_box), 1, 1);
+    c.add_op<UnitID>(cond, {Bit(0), Qubit(2), Qubit(0), Bit(1)});
+    c.add_conditional_gate<unsigned>(OpType::X, {}, {1}, {1}, 0);
+    c.add_box(inner_box, {2, 1, 1});
+    check_against_decomposition(c);
+  }
+  GIVEN("Generated boxes") {
+    Circuit c(3);
+    c.add_box(PauliExpBox({Pauli::X, Pauli::Z}, 0.3), {0, 2});
+    Circuit u(1);
+    u.add_op<unsigned>(OpType::Ry, 0.25, {0});
+    Op_ptr ubox = std::make_shared<CircBox>(u);
+    c.add_box(QControlBox(ubox, 2), {1, 2, 0});
+    c.add_barrier({0, 1});
+    c.add_box(PauliExpBox({Pauli::Y}, 0.7), {1});
+    check_against_decomposition(c);
+  }
+}
+
+}  // namespace test_HierarchicalMetrics
+}  // namespace tket
@@ -0,0 +1,102 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <catch2/catch.hpp>
+
+#include "Circuit/Circuit.hpp"
+#include "Circuit/Scheduling.hpp"
+
+namespace tket {
+namespace test_Scheduling {
+
+SCENARIO("Scheduling circuits with gate durations") {
+  GateDurations durations(1.);
+  durations.set_duration(OpType::CX, 5.);
+  GIVEN("A small circuit") {
+    Circuit circ(3);
+    Vertex h = circ.add_op<unsigned>(OpType::H, {0});
+    Vertex cx = circ.add_op<unsigned>(OpType::CX, {0, 1});
+    Vertex x = circ.add_op<unsigned>(OpType::X, {1});
+    Vertex z = circ.add_op<unsigned>(OpType::Z, {2});
+    REQUIRE(total_duration(circ, durations) == 7.);
+    WHEN("Scheduling as soon as possible") {
+      Schedule s = schedule_circuit(circ, durations);
+      CHECK(s.total_duration == 7.);
+      CHECK(s.start_times.size() == 4);
+      CHECK(s.start_times.at(h) == 0.);
+      CHECK(s.start_times.at(cx) == 1.);
+      CHECK(s.start_times.at(x) == 6.);
+      CHECK(s.start_times.at(z) == 0.);
+      CHECK(s.durations.at(cx) == 5.);
+    }
+    WHEN("Scheduling as late as possible") {
+      Schedule s = schedule_circuit(circ, durations, ScheduleMode::ALAP);
+      CHECK(s.total_duration == 7.);
+      CHECK(s.start_times.at(h) == 0.);
+      CHECK(s.start_times.at(cx) == 1.);
+      CHECK(s.start_times.at(x) == 6.);
+      CHECK(s.start_times.at(z) == 6.);
+    }
+    WHEN("The CX is faster in one direction") {
+      durations.set_duration(OpType::CX, {Qubit(0), Qubit(1)}, 2.);
+      CHECK(total_duration(circ, durations) == 4.);
+      durations.set_duration(OpType::CX, {Qubit(1), Qubit(0)}, 1.);
+      CHECK(total_duration(circ, durations) == 4.);
+    }
+    WHEN("Using the duration as a metric") {
+      CHECK(duration_metric(durations)(circ) == 7);
+      CHECK(duration_metric(durations, 2.)(circ) == 4);
+      CHECK_THROWS_AS(duration_metric(durations, 0.), std::invalid_argument);
+    }
+  }
+  GIVEN("Classical wires and conditions") {
+    Circuit circ(2, 1);
+    circ.add_op<unsigned>(OpType::Measure, {0, 0});
+    circ.add_conditional_gate<unsigned>(OpType::X, {}, {1}, {0}, 1);
+    circ.add_barrier(std::vector<unsigned>{0, 1});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    durations.set_duration(OpType::Measure, 10.);
+    // The conditional X waits for the bit, and the barrier takes no time.
+    CHECK(total_duration(circ, durations) == 16.);
+  }
+  GIVEN("Unit durations") {
+    GateDurations unit(1.);
+    const unsigned n = 600;
+    Circuit circ(n);
+    for (unsigned r = 0; r < 6; r++) {
+      for (unsigned i = 0; i < n; i++) {
+        if ((i * 7 + r) % 3 == 0) circ.add_op<unsigned>(OpType::H, {i});
+      }
+      for (unsigned i = r % 2; i + 1 < n; i += 2) {
+        if ((i + r) % 5 != 0) circ.add_op<unsigned>(OpType::CX, {i, i + 1});
+      }
+    }
+    // The total duration is then the depth.
+    CHECK(total_duration(circ, unit) == double(circ.depth()));
+    Schedule asap = schedule_circuit(circ, unit);
+    Schedule alap = schedule_circuit(circ, unit, ScheduleMode::ALAP);
+    CHECK(asap.total_duration == alap.total_duration);
+    for (const auto& [v, t] : asap.start_times) {
+      CHECK(t <= alap.start_times.at(v));
+      for (const Vertex& pred : circ.get_predecessors(v)) {
+        if (circ.detect_boundary_Op(pred)) continue;
+        CHECK(asap.start_times.at(pred) + 1. <= t);
+        CHECK(alap.start_times.at(pred) + 1. <= alap.start_times.at(v));
+      }
+    }
+  }
+}
+
+}  // namespace test_Scheduling
+}  // namespace tket
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <Circuit/Circuit.hpp>
+#include <Circuit/ParameterSweep.hpp>
 #include <Transformations/Transform.hpp>
 #include <catch2/catch.hpp>
 #include <vector>
@@ -133,5 +134,53 @@ SCENARIO("Symbolic squashing, correctness") {
   }
 }
 
+SCENARIO("Sweeping symbol values") {
+  Sym a = SymEngine::symbol("a");
+  Sym b = SymEngine::symbol("b");
+  Circuit circ(2, 1, "sweep");
+  circ.add_op<unsigned>(OpType::Rz, 2 * Expr(a) + 0.5, {0});
+  circ.add_op<unsigned>(OpType::H, {1});
+  // Sites along qubit 0 are in command order
+  circ.add_op<unsigned>(
+      OpType::tk1, {Expr(b), 0.25, SymEngine::sin(Expr(a) * Expr(b))}, {0});
+  circ.add_op<unsigned>(OpType::CX, {0, 1});
+  circ.add_op<unsigned>(
+      OpType::Ry, SymEngine::atan2(Expr(a), Expr(b)) / SymEngine::pi, {0});
+  circ.add_op<unsigned>(OpType::Rx, SymEngine::gamma(Expr(a)), {0});
+  circ.add_conditional_gate<unsigned>(OpType::Rz, {Expr(b)}, {0}, {0}, 1);
+  circ.add_phase(Expr(a) * Expr(b));
+  ParameterSweep sweep(circ, {a, b});
+  // Rz, two tk1 parameters, Ry, Rx and the phase
+  REQUIRE(sweep.n_sites() == 6);
+  REQUIRE(sweep.site_position(2)->second == 2);
+  REQUIRE(!sweep.site_position(5));
+  Eigen::MatrixXd bindings(3, 2);
+  bindings << 0.1, 0.7, -1.3, 2.5, 0.4, 0.4;
+  Eigen::MatrixXd values = sweep.parameter_values(bindings);
+  REQUIRE(values.rows() == 3);
+  REQUIRE(values.cols() == 6);
+  std::vector<Circuit> circs = sweep.circuits(bindings);
+  REQUIRE(circs.size() == 3);
+  for (unsigned row = 0; row < 3; ++row) {
+    const double va = bindings(row, 0), vb = bindings(row, 1);
+    CHECK(values(row, 0) == Approx(2 * va + 0.5));
+    CHECK(values(row, 1) == Approx(vb));
+    CHECK(values(row, 2) == Approx(std::sin(va * vb)));
+    CHECK(values(row, 3) == Approx(std::atan2(va, vb) / PI));
+    CHECK(values(row, 4) == Approx(std::tgamma(va)));
+    CHECK(values(row, 5) == Approx(va * vb));
+    Circuit expected = circ;
+    expected.symbol_substitution(
+        std::map<Sym, double, SymEngine::RCPBasicKeyLess>{{a, va}, {b, vb}});
+    CHECK(!circs[row].is_symbolic());
+    CHECK(circs[row] == expected);
+    CHECK(circs[row].get_name() == circ.get_name());
+    CHECK(sweep.circuit({va, vb}) == expected);
+  }
+  GIVEN("A symbol that is not swept") {
+    REQUIRE_THROWS_AS(ParameterSweep(circ, {a}), CircuitInvalidity);
+  }
+}
+
 }  // namespace test_Symbolic
 }  // namespace tket
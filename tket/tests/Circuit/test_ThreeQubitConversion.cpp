@@ -17,6 +17,7 @@
 #include <cmath>
 
 #include "../Simulation/ComparisonFunctions.hpp"
+#include "../testutil.hpp"
 #include "Circuit/Boxes.hpp"
 #include "Circuit/Circuit.hpp"
 #include "Circuit/Command.hpp"
@@ -129,6 +130,19 @@ SCENARIO("Three-qubit circuits") {
     auto u = tket_sim::get_unitary(c);
     check_three_qubit_synthesis(u);
   }
+  GIVEN("Many unitaries synthesised together") {
+    std::vector<Matrix8cd> Us;
+    for (unsigned i = 0; i < 20; i++) {
+      Us.push_back(random_unitary(8, 200 + i));
+    }
+    std::vector<Circuit> circs = three_qubit_synthesis(Us);
+    REQUIRE(circs.size() == Us.size());
+    for (unsigned i = 0; i < Us.size(); i++) {
+      CHECK(circs[i] == three_qubit_synthesis(Us[i]));
+      CHECK(tket_sim::compare_statevectors_or_unitaries(
+          Us[i], tket_sim::get_unitary(circs[i])));
+    }
+  }
   GIVEN("Round trip from a larger circuit") {
     Circuit c(3);
     c.add_op<unsigned>(OpType::T, {0});
@@ -241,6 +255,10 @@ static bool check_3q_squash(const Circuit &c) {
   } else {
     CHECK(c == c1);
   }
+  // Synthesising the candidate subcircuits in parallel gives the same result
+  Circuit c2 = c;
+  CHECK(Transform::three_qubit_squash(true).apply(c2) == success);
+  CHECK(c1 == c2);
   return success;
 }
 
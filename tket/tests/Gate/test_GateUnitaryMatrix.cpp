@@ -302,6 +302,64 @@ SCENARIO("Test 1 qubit gates against tk1 angles") {
   }
 }
 
+SCENARIO("Fixed size unitary matrices") {
+  const auto& gates_data = internal::GatesData::get();
+  std::vector<double> current_values;
+  std::vector<Expr> current_values_expr;
+
+  for (const auto& outer_entry : gates_data.input_data) {
+    const auto& number_of_qubits = outer_entry.first;
+    for (const auto& inner_entry : outer_entry.second) {
+      const auto& number_of_parameters = inner_entry.first;
+      current_values.resize(number_of_parameters);
+      current_values_expr.resize(number_of_parameters);
+      for (unsigned nn = 0; nn < number_of_parameters; ++nn) {
+        const double value = -0.987654321 + nn * 0.4444411111;
+        current_values[nn] = value;
+        current_values_expr[nn] = Expr(value);
+      }
+      for (OpType op_type : inner_entry.second) {
+        INFO("for op " << OpDesc(op_type).name());
+        const Gate gate(op_type, current_values_expr, number_of_qubits);
+        const auto unitary = GateUnitaryMatrix::get_unitary(gate);
+        const Eigen::MatrixXcd* fixed =
+            GateUnitaryMatrix::get_fixed_unitary(op_type);
+        if (number_of_parameters == 0 &&
+            gates_data.min_number_of_qubits_for_variable_qubit_type.count(
+                op_type) == 0) {
+          REQUIRE(fixed);
+          CHECK(matrices_are_equal(*fixed, unitary));
+        } else {
+          CHECK(!fixed);
+        }
+        // The same implementations are used, so we demand exact matches
+        switch (number_of_qubits) {
+          case 1:
+            CHECK(matrices_are_equal(
+                GateUnitaryMatrix::get_unitary_1q(gate), unitary));
+            REQUIRE_THROWS_AS(
+                GateUnitaryMatrix::get_unitary_2q(gate),
+                GateUnitaryMatrixError);
+            break;
+          case 2:
+            CHECK(matrices_are_equal(
+                GateUnitaryMatrix::get_unitary_2q(gate), unitary));
+            REQUIRE_THROWS_AS(
+                GateUnitaryMatrix::get_unitary_1q(gate),
+                GateUnitaryMatrixError);
+            break;
+          default:
+            break;
+        }
+      }
+    }
+  }
+  const Gate symbolic_gate(OpType::Rz, {Expr(SymEngine::symbol("a"))}, 1);
+  REQUIRE_THROWS_AS(
+      GateUnitaryMatrix::get_unitary_1q(symbolic_gate),
+      GateUnitaryMatrixError);
+}
+
 SCENARIO("Invalid numbers of arguments cause exceptions") {
   const unsigned max_number_of_qubits = 5;
   const unsigned max_number_of_parameters = 5;
@@ -166,6 +166,54 @@ SCENARIO("Test APs in Architecture", "[architectures],[routing]") {
   REQUIRE(ap.find(Node(0)) == ap.end());
 }
 
+SCENARIO("Track APs while removing vertices") {
+  // a square 0-1-2-3, a triangle 3-4-5 hanging off it and a path 5-6-7
+  Architecture arc(
+      {{0, 1}, {1, 2}, {2, 3}, {3, 0}, {3, 4}, {4, 5}, {5, 3}, {5, 6}, {6, 7}});
+  ArticulationPointTracker<Node> tracker(arc.get_undirected_connectivity());
+  auto check = [&]() {
+    REQUIRE(tracker.get_aps() == arc.get_articulation_points());
+  };
+  check();
+  REQUIRE(tracker.get_aps() == node_set_t{Node(3), Node(5), Node(6)});
+
+  GIVEN("Removing a vertex in a single block") {
+    for (unsigned n : {1, 4, 7, 0}) {
+      arc.remove_node(Node(n));
+      tracker.remove_vertex(Node(n));
+      check();
+    }
+  }
+  GIVEN("Removing an AP") {
+    for (unsigned n : {3, 6, 1}) {
+      arc.remove_node(Node(n));
+      tracker.remove_vertex(Node(n));
+      check();
+    }
+  }
+  GIVEN("Removing a vertex that is not there") {
+    REQUIRE_THROWS_AS(tracker.remove_vertex(Node(8)), NodeDoesNotExistError);
+  }
+}
+
+SCENARIO("Remove worst nodes incrementally", "[architectures]") {
+  // a hexagon with a bridge 1-6-7-2 across it and a tail 4-8-9
+  Architecture arc(
+      {{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}, {5, 0}, {1, 6}, {6, 7}, {7, 2},
+       {4, 8}, {8, 9}});
+  node_set_t removed = arc.remove_worst_nodes(4);
+  REQUIRE(removed.size() == 4);
+  REQUIRE(arc.n_nodes() == 6);
+  // what remains is still connected
+  std::vector<Node> nodes = arc.get_all_nodes_vec();
+  for (const Node &node : nodes) {
+    REQUIRE_NOTHROW(arc.get_distance(nodes[0], node));
+  }
+  // the tail goes first
+  REQUIRE(removed.count(Node(9)) == 1);
+  REQUIRE(removed.count(Node(8)) == 1);
+}
+
 }  // namespace test_ArticulationPoints
 }  // namespace tests
 }  // namespace graphs
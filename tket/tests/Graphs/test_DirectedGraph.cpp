@@ -109,6 +109,116 @@ SCENARIO("Disconnected graphs") {
   }
 }
 
+SCENARIO("Precomputed all-pairs distances") {
+  GIVEN("a ring with a chord") {
+    using Conn = DirectedGraph<Node>::Connection;
+    std::vector<Conn> edges;
+    for (unsigned i = 0; i < 20; i++) {
+      edges.push_back({Node(i), Node((i + 1) % 20)});
+    }
+    edges.push_back({Node(10), Node(0)});
+    DirectedGraph<Node> lazy(edges);
+    DirectedGraph<Node> dense(edges);
+    dense.precompute_distances();
+    std::shared_ptr<const DistanceMatrix<Node>> matrix =
+        dense.get_distance_matrix();
+    REQUIRE(matrix->n_nodes() == 20);
+    for (unsigned i = 0; i < 20; i++) {
+      for (unsigned j = 0; j < 20; j++) {
+        CHECK(
+            dense.get_distance(Node(i), Node(j)) ==
+            lazy.get_distance(Node(i), Node(j)));
+        CHECK(
+            (*matrix)(matrix->index(Node(i)), matrix->index(Node(j))) ==
+            lazy.get_distance(Node(i), Node(j)));
+      }
+    }
+    CHECK(dense.get_diameter() == lazy.get_diameter());
+    WHEN("the graph is copied") {
+      DirectedGraph<Node> copy(dense);
+      THEN("the matrix is shared") {
+        CHECK(copy.get_distance_matrix() == matrix);
+      }
+    }
+    WHEN("the graph is modified") {
+      dense.add_node(Node(20));
+      THEN("the matrix is recomputed") {
+        CHECK(dense.get_distance_matrix() != matrix);
+        CHECK(dense.get_distance_matrix()->n_nodes() == 21);
+        CHECK_THROWS_AS(
+            dense.get_distance(Node(0), Node(20)), NodesNotConnected<Node>);
+        CHECK_THROWS_AS(dense.get_diameter(), NodesNotConnected<Node>);
+      }
+    }
+    WHEN("a node is added with its connections") {
+      const std::vector<Conn> new_edges{
+          {Node(5), Node(20)}, {Node(20), Node(15)}};
+      dense.add_node_with_connections(Node(20), new_edges);
+      edges.insert(edges.end(), new_edges.begin(), new_edges.end());
+      DirectedGraph<Node> rebuilt(edges);
+      THEN("the matrix is extended to the new node") {
+        std::shared_ptr<const DistanceMatrix<Node>> extended =
+            dense.get_distance_matrix();
+        CHECK(extended != matrix);
+        REQUIRE(extended->n_nodes() == 21);
+        CHECK(dense.get_distance(Node(5), Node(15)) == 2);
+        for (unsigned i = 0; i < 21; i++) {
+          for (unsigned j = 0; j < 21; j++) {
+            const unsigned ei = extended->index(Node(i));
+            const unsigned ej = extended->index(Node(j));
+            CHECK(
+                (*extended)(ei, ej) == rebuilt.get_distance(Node(i), Node(j)));
+          }
+        }
+        CHECK(dense.get_diameter() == rebuilt.get_diameter());
+      }
+    }
+  }
+}
+
+SCENARIO("Compiled connectivity view") {
+  GIVEN("a directed graph with an edge in both directions") {
+    using Conn = DirectedGraph<Node>::Connection;
+    std::vector<Conn> edges = {
+        {Node(0), Node(1)}, {Node(1), Node(0)}, {Node(1), Node(2)},
+        {Node(3), Node(1)}, {Node(70), Node(2)}};
+    DirectedGraph<Node> plain(edges);
+    DirectedGraph<Node> compiled(edges);
+    compiled.compile_connectivity();
+    std::shared_ptr<const ConnectivityView<Node>> view =
+        compiled.get_connectivity_view();
+    REQUIRE(view->n_nodes() == 5);
+    for (const Node& n1 : plain.get_all_nodes_vec()) {
+      const unsigned i = view->index(n1);
+      CHECK(view->node(i) == n1);
+      for (const Node& n2 : plain.get_all_nodes_vec()) {
+        const unsigned j = view->index(n2);
+        CHECK(compiled.edge_exists(n1, n2) == plain.edge_exists(n1, n2));
+        CHECK(view->edge_exists(i, j) == plain.edge_exists(n1, n2));
+        CHECK(
+            view->connected(i, j) ==
+            (plain.edge_exists(n1, n2) || plain.edge_exists(n2, n1)));
+      }
+      std::vector<Node> neighbours;
+      for (unsigned j : view->neighbours(i)) {
+        neighbours.push_back(view->node(j));
+      }
+      const std::set<Node> expected = plain.get_neighbour_nodes(n1);
+      CHECK(neighbours == std::vector<Node>(expected.begin(), expected.end()));
+    }
+    CHECK_THROWS_AS(
+        compiled.edge_exists(Node(0), Node(5)), NodeDoesNotExistError);
+    WHEN("the graph is modified") {
+      compiled.add_connection(Node(2), Node(3));
+      THEN("the view is rebuilt") {
+        CHECK(compiled.get_connectivity_view() != view);
+        CHECK(compiled.edge_exists(Node(2), Node(3)));
+        CHECK_FALSE(view->edge_exists(Node(2), Node(3)));
+      }
+    }
+  }
+}
+
 }  // namespace test_DirectedGraph
 }  // namespace tests
 }  // namespace graphs
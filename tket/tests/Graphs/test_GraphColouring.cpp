@@ -22,6 +22,7 @@
 #include "RNG.hpp"
 #include "RandomGraphGeneration.hpp"
 #include "RandomPlanarGraphs.hpp"
+#include "Utils/Parallel.hpp"
 
 using std::map;
 using std::size_t;
@@ -363,6 +364,56 @@ SCENARIO("Test Mycielski graphs") {
   test_Mycielski_graph_sequence(graph, 2, 9);
 }
 
+SCENARIO("Components are coloured the same with any number of threads") {
+  // Several disjoint copies of Mycielski graphs of different sizes.
+  AdjacencyData component(2);
+  component.add_edge(0, 1);
+  vector<AdjacencyData> components;
+  for (int ii = 0; ii < 6; ++ii) {
+    components.push_back(component);
+    component = get_Mycielski_graph(component);
+  }
+  size_t total_vertices = 0;
+  for (const auto& comp : components) {
+    total_vertices += comp.get_number_of_vertices();
+  }
+  AdjacencyData graph(total_vertices);
+  size_t offset = 0;
+  for (const auto& comp : components) {
+    for (size_t ii = 0; ii < comp.get_number_of_vertices(); ++ii) {
+      for (size_t jj : comp.get_neighbours(ii)) {
+        graph.add_edge(offset + ii, offset + jj);
+      }
+    }
+    offset += comp.get_number_of_vertices();
+  }
+  const auto colouring = GraphColouringRoutines::get_colouring(graph);
+  GraphTestingRoutines::require_valid_suboptimal_colouring(colouring, graph);
+  CHECK(colouring.is_exact);
+  CHECK(colouring.number_of_colours == 7);
+
+  const unsigned max_threads = get_max_threads();
+  set_max_threads(1);
+  const auto sequential_colouring =
+      GraphColouringRoutines::get_colouring(graph);
+  set_max_threads(max_threads);
+  CHECK(sequential_colouring.colours == colouring.colours);
+}
+
+SCENARIO("Colouring with a time limit is still valid") {
+  RNG rng;
+  AdjacencyData graph(60);
+  for (size_t ii = 0; ii < 60; ++ii) {
+    for (size_t jj = ii + 1; jj < 60; ++jj) {
+      if (rng.check_percentage(50)) {
+        graph.add_edge(ii, jj);
+      }
+    }
+  }
+  const auto colouring = GraphColouringRoutines::get_colouring(graph, 1);
+  GraphTestingRoutines::require_valid_suboptimal_colouring(colouring, graph);
+}
+
 }  // namespace test_GraphColouring
 }  // namespace tests
 }  // namespace graphs
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <catch2/catch.hpp>
 #include <set>
 
@@ -256,6 +257,137 @@ SCENARIO("Correctly calculates max cliques") {
   CHECK(cliques_seen == 160);
 }
 
+SCENARIO("Dense graphs use bits, with the same max cliques") {
+  RNG rng;
+  const size_t number_of_vertices = 12;
+  for (size_t percentage = 10; percentage <= 90; percentage += 20) {
+    AdjacencyData graph(number_of_vertices);
+    for (size_t ii = 0; ii < number_of_vertices; ++ii) {
+      for (size_t jj = ii + 1; jj < number_of_vertices; ++jj) {
+        if (rng.check_percentage(percentage)) {
+          graph.add_edge(ii, jj);
+        }
+      }
+    }
+    CHECK(
+        graph.is_dense() == (16 * graph.get_number_of_edges() >=
+                             number_of_vertices * number_of_vertices));
+    if (graph.is_dense()) {
+      for (size_t ii = 0; ii < number_of_vertices; ++ii) {
+        const auto* row = graph.get_neighbour_bits(ii);
+        for (size_t jj = 0; jj < number_of_vertices; ++jj) {
+          CHECK(((row[0] >> jj) & 1) == graph.get_neighbours(ii).count(jj));
+        }
+      }
+    }
+    // Find all the max cliques by brute force, over all vertex subsets.
+    vector<set<size_t>> max_cliques;
+    size_t max_size = 0;
+    for (size_t subset = 1; subset < (1u << number_of_vertices); ++subset) {
+      set<size_t> vertices;
+      bool is_clique = true;
+      for (size_t ii = 0; ii < number_of_vertices && is_clique; ++ii) {
+        if (((subset >> ii) & 1) == 0) continue;
+        for (size_t jj : vertices) {
+          if (!graph.edge_exists(ii, jj)) {
+            is_clique = false;
+            break;
+          }
+        }
+        vertices.insert(ii);
+      }
+      if (!is_clique || vertices.size() < max_size) continue;
+      if (vertices.size() > max_size) {
+        max_size = vertices.size();
+        max_cliques.clear();
+      }
+      max_cliques.push_back(vertices);
+    }
+    const auto components = GraphRoutines::get_connected_components(graph);
+    for (const auto& component : components) {
+      const LargeCliquesResult result(graph, component, 1000);
+      CHECK(result.cliques_are_definitely_max_size);
+      REQUIRE(!result.cliques.empty());
+      if (result.cliques[0].size() != max_size) continue;
+      for (const auto& clique : result.cliques) {
+        CHECK(
+            std::find(max_cliques.cbegin(), max_cliques.cend(), clique) !=
+            max_cliques.cend());
+      }
+    }
+  }
+}
+
+static bool is_clique(const AdjacencyData& graph, const set<size_t>& vertices) {
+  for (size_t ii : vertices) {
+    for (size_t jj : vertices) {
+      if (ii != jj && !graph.edge_exists(ii, jj)) return false;
+    }
+  }
+  return true;
+}
+
+SCENARIO("Branch and bound finds the same max clique size") {
+  RNG rng;
+  MaxCliqueParameters parameters;
+  for (parameters.number_of_vertices = 10; parameters.number_of_vertices < 80;
+       parameters.number_of_vertices += 30) {
+    for (parameters.max_clique_size = 2; parameters.max_clique_size <= 6;
+         parameters.max_clique_size += 2) {
+      parameters.approx_number_of_extra_edges =
+          parameters.number_of_vertices * 2;
+      for (int counter = 0; counter < 5; ++counter) {
+        const auto test_data = parameters.get_test_data(rng);
+        const AdjacencyData graph(test_data.raw_adjacency_data);
+        for (const auto& component :
+             GraphRoutines::get_connected_components(graph)) {
+          const LargeCliquesResult large(graph, component, 100000);
+          REQUIRE(large.cliques_are_definitely_max_size);
+          const MaxCliqueResult max(graph, component);
+          CHECK(max.clique_is_definitely_max_size);
+          CHECK(max.clique.size() == large.cliques[0].size());
+          CHECK(is_clique(graph, max.clique));
+          for (size_t v : max.clique) CHECK(component.count(v) == 1);
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Branch and bound on a large dense graph") {
+  RNG rng;
+  const size_t number_of_vertices = 300;
+  AdjacencyData graph(number_of_vertices);
+  for (size_t ii = 0; ii < number_of_vertices; ++ii) {
+    for (size_t jj = ii + 1; jj < number_of_vertices; ++jj) {
+      if (rng.check_percentage(30)) graph.add_edge(ii, jj);
+    }
+  }
+  // Plant a clique much larger than any likely by chance.
+  set<size_t> planted;
+  while (planted.size() < 25) {
+    planted.insert(rng.get_size_t(number_of_vertices - 1));
+  }
+  for (size_t ii : planted) {
+    for (size_t jj : planted) {
+      if (ii < jj) graph.add_edge(ii, jj);
+    }
+  }
+  const auto components = GraphRoutines::get_connected_components(graph);
+  REQUIRE(components.size() == 1);
+  GIVEN("No budget") {
+    const MaxCliqueResult result(graph, components[0]);
+    CHECK(result.clique_is_definitely_max_size);
+    CHECK(result.clique == planted);
+  }
+  GIVEN("A small node budget") {
+    const MaxCliqueResult result(graph, components[0], 10);
+    CHECK(!result.clique_is_definitely_max_size);
+    CHECK(!result.clique.empty());
+    CHECK(is_clique(graph, result.clique));
+  }
+}
+
 }  // namespace test_GraphFindMaxClique
 }  // namespace tests
 }  // namespace graphs
@@ -17,6 +17,7 @@
 #include <boost/range/iterator_range_core.hpp>
 #include <catch2/catch.hpp>
 #include <map>
+#include <set>
 #include <vector>
 
 #include "Graphs/TreeSearch.hpp"
@@ -292,6 +293,60 @@ SCENARIO("longest simplest path") {
   CHECK(res[0] == 0);
 }
 
+SCENARIO("longest simple path on a large graph") {
+  // A grid with some edges missing, large enough to be split between threads
+  using Graph = boost::adjacency_list<
+      boost::vecS, boost::vecS, boost::undirectedS, boost::no_property>;
+  const unsigned side = 30;
+  Graph g(side * side);
+  for (unsigned r = 0; r < side; ++r) {
+    for (unsigned c = 0; c < side; ++c) {
+      const unsigned v = r * side + c;
+      if (c + 1 < side && (r * 7 + c) % 5 != 0) boost::add_edge(v, v + 1, g);
+      if (r + 1 < side && (r + c * 3) % 4 != 0) {
+        boost::add_edge(v, v + side, g);
+      }
+    }
+  }
+  // One search after another, as longest_simple_path used to do
+  auto sequential = [&g](std::size_t cutoff) {
+    std::vector<unsigned long> longest;
+    auto dfs = run_dfs(boost::vertex(0, g), g);
+    for (unsigned v = 0; v < side * side; ++v) {
+      dfs.change_root(v);
+      if (dfs.max_depth() + 1 > longest.size()) {
+        longest = dfs.longest_path();
+        if (cutoff > 0 && longest.size() >= cutoff) break;
+      }
+    }
+    return longest;
+  };
+  auto is_path = [&g](const std::vector<unsigned long>& path) {
+    std::set<unsigned long> seen(path.begin(), path.end());
+    if (seen.size() != path.size()) return false;
+    for (unsigned i = 0; i + 1 < path.size(); ++i) {
+      if (!boost::edge(path[i], path[i + 1], g).second) return false;
+    }
+    return true;
+  };
+  GIVEN("No cutoff") {
+    auto res = longest_simple_path(g);
+    CHECK(res == sequential(0));
+    CHECK(is_path(res));
+  }
+  GIVEN("A cutoff") {
+    auto res = longest_simple_path(g, 50);
+    CHECK(res == sequential(50));
+    CHECK(res.size() >= 50);
+  }
+  GIVEN("A time budget") {
+    auto res = longest_simple_path(g, 0, 1);
+    CHECK(res.size() > 1);
+    CHECK(res.size() <= longest_simple_path(g).size());
+    CHECK(is_path(res));
+  }
+}
+
 }  // namespace test_TreeSearch
 }  // namespace tests
 }  // namespace graphs
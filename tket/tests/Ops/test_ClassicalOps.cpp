@@ -495,5 +495,110 @@ SCENARIO("Pure classical operations") {
   }
 }
 
+SCENARIO("Classical evaluation on packed assignments") {
+  // Inputs for the k-th assignment are the bits of k, in 64 * 2 assignments
+  auto lane_bits = [](unsigned n, unsigned word) {
+    std::vector<std::uint64_t> x(n, 0);
+    for (unsigned lane = 0; lane < 64; lane++) {
+      unsigned k = 64 * word + lane;
+      for (unsigned i = 0; i < n; i++) {
+        x[i] |= std::uint64_t((k >> i) & 1) << lane;
+      }
+    }
+    return x;
+  };
+  auto check_op = [&](const ClassicalOp &op) {
+    unsigned n_in = op.get_n_i() + op.get_n_io();
+    for (unsigned word = 0; word < 2; word++) {
+      std::vector<std::uint64_t> y = op.eval_packed(lane_bits(n_in, word));
+      REQUIRE(y.size() == op.get_n_io() + op.get_n_o());
+      for (unsigned lane = 0; lane < 64; lane++) {
+        unsigned k = 64 * word + lane;
+        std::vector<bool> x(n_in);
+        for (unsigned i = 0; i < n_in; i++) x[i] = (k >> i) & 1;
+        std::vector<bool> y_lane = op.eval(x);
+        for (unsigned j = 0; j < y.size(); j++) {
+          CHECK(bool((y[j] >> lane) & 1) == y_lane[j]);
+        }
+      }
+    }
+  };
+  GIVEN("Operations with small truth tables") {
+    check_op(*ClassicalX());
+    check_op(*ClassicalCX());
+    check_op(*AndOp());
+    check_op(*XorWithOp());
+    check_op(ClassicalTransformOp(3, {0, 1, 2, 7, 0, 1, 2, 7}));
+    check_op(RangePredicateOp(4, 3, 11));
+    check_op(SetBitsOp({true, false, true}));
+    check_op(CopyBitsOp(2));
+    check_op(MultiBitOp(OrOp(), 3));
+  }
+  GIVEN("Operations with large truth tables") {
+    std::vector<bool> parity(1u << 7);
+    std::vector<std::uint32_t> rotate(1u << 7);
+    for (unsigned k = 0; k < parity.size(); k++) {
+      parity[k] = k > 0 && parity[k >> 1] != bool(k & 1);
+      rotate[k] = ((k << 1) | (k >> 6)) & 0x7f;
+    }
+    check_op(ExplicitPredicateOp(7, parity));
+    check_op(ExplicitModifierOp(6, parity));
+    check_op(ClassicalTransformOp(7, rotate));
+  }
+  GIVEN("Range predicates with bounds at and beyond the encodable range") {
+    check_op(RangePredicateOp(7));
+    check_op(RangePredicateOp(7, 0, 0));
+    check_op(RangePredicateOp(7, 127, 127));
+    check_op(RangePredicateOp(7, 64, 1000));
+    check_op(RangePredicateOp(7, 128, 1000));
+    check_op(RangePredicateOp(7, 100, 20));
+    check_op(RangePredicateOp(3, 2, 5));
+  }
+  GIVEN("A classical circuit") {
+    Circuit circ(0, 4);
+    circ.add_op<unsigned>(ClassicalCX(), {0, 1});
+    circ.add_op<unsigned>(
+        std::make_shared<SetBitsOp>(std::vector<bool>{true}), {2});
+    circ.add_op<unsigned>(AndWithOp(), {1, 2});
+    circ.add_op<unsigned>(std::make_shared<MultiBitOp>(XorOp(), 1), {0, 2, 3});
+    circ.add_op<unsigned>(ClassicalX(), {0});
+    std::map<Bit, std::vector<std::uint64_t>> values;
+    const unsigned n_words = 3;
+    for (unsigned b = 0; b < 2; b++) {
+      for (unsigned word = 0; word < n_words; word++) {
+        values[Bit(b)].push_back(lane_bits(2, word)[b]);
+      }
+    }
+    std::map<Bit, std::vector<std::uint64_t>> packed =
+        circ.classical_eval_packed(values);
+    REQUIRE(packed.size() == 4);
+    for (unsigned word = 0; word < n_words; word++) {
+      for (unsigned lane = 0; lane < 64; lane++) {
+        unsigned k = 64 * word + lane;
+        bool b0 = k & 1, b1 = (k >> 1) & 1;
+        bool c1 = b0 != b1;
+        bool c3 = b0 != c1;
+        CHECK(bool((packed[Bit(0)][word] >> lane) & 1) == !b0);
+        CHECK(bool((packed[Bit(1)][word] >> lane) & 1) == c1);
+        CHECK(bool((packed[Bit(2)][word] >> lane) & 1) == c1);
+        CHECK(bool((packed[Bit(3)][word] >> lane) & 1) == c3);
+      }
+    }
+  }
+  GIVEN("Inputs of different lengths") {
+    Circuit circ(0, 2);
+    circ.add_op<unsigned>(ClassicalCX(), {0, 1});
+    std::map<Bit, std::vector<std::uint64_t>> values = {
+        {Bit(0), {1, 2}}, {Bit(1), {3}}};
+    REQUIRE_THROWS_AS(
+        circ.classical_eval_packed(values), std::invalid_argument);
+  }
+  GIVEN("A circuit with a quantum operation") {
+    Circuit circ(1, 1);
+    circ.add_op<unsigned>(OpType::H, {0});
+    REQUIRE_THROWS_AS(circ.classical_eval_packed({}), CircuitInvalidity);
+  }
+}
+
 }  // namespace test_ClassicalOps
 }  // namespace tket
@@ -97,5 +97,39 @@ SCENARIO("Expression uniqueness", "[ops]") {
   }
 }
 
+SCENARIO("Compact parameters", "[ops]") {
+  GIVEN("A floating-point number") {
+    Param p(Expr(0.75));
+    REQUIRE(p.is_double());
+    REQUIRE(p.eval() == 0.75);
+    REQUIRE(p.to_expr() == Expr(0.75));
+    REQUIRE(p.free_symbols().empty());
+    REQUIRE(equiv_val(p, 2.75));
+    REQUIRE(equiv_expr(p, Param(4.75), 4));
+    REQUIRE(!equiv_expr(p, Param(2.75), 4));
+    REQUIRE(*eval_expr_mod(Param(-0.25 + 1e-12)) == 1.75);
+  }
+  GIVEN("An exact number") {
+    Expr third = Expr(1) / 3;
+    Param p(third);
+    REQUIRE(!p.is_double());
+    REQUIRE(p.to_expr() == third);
+    REQUIRE(test_equiv_val(third, 1. / 3));
+    REQUIRE(equiv_expr(p, Param(1. / 3)));
+  }
+  GIVEN("A symbolic expression") {
+    Sym s = SymEngine::symbol("a");
+    Expr e = Expr(s) + 0.5;
+    Param p(e);
+    REQUIRE(!p.is_double());
+    REQUIRE(!p.eval());
+    REQUIRE(p.to_expr() == e);
+    REQUIRE(p.free_symbols() == SymSet{s});
+    REQUIRE(equiv_expr(p, Param(e)));
+    REQUIRE(!equiv_expr(p, Param(0.5)));
+    REQUIRE(!equiv_0(p));
+  }
+}
+
 }  // namespace test_Expression
 }  // namespace tket
@@ -16,15 +16,21 @@
 
 #include <catch2/catch.hpp>
 #include <optional>
+#include <set>
+#include <string>
+#include <thread>
 #include <unsupported/Eigen/MatrixFunctions>
 
 #include "../testutil.hpp"
 #include "Circuit/Boxes.hpp"
 #include "Circuit/CircUtils.hpp"
 #include "Circuit/Circuit.hpp"
+#include "Gate/Commutation.hpp"
 #include "Gate/GatePtr.hpp"
 #include "Gate/SymTable.hpp"
 #include "OpType/OpType.hpp"
+#include "OpType/OpTypeFunctions.hpp"
+#include "OpType/OpTypeInfo.hpp"
 #include "Ops/OpPtr.hpp"
 #include "Predicates/CompilerPass.hpp"
 #include "Predicates/PassLibrary.hpp"
@@ -34,7 +40,7 @@
 namespace tket {
 namespace test_Ops {
 
-void clear_symbol_table() { SymTable::get_registered_symbols().clear(); }
+void clear_symbol_table() { SymTable::clear(); }
 
 SCENARIO("Check op retrieval overloads are working correctly.", "[ops]") {
   GIVEN("Transposes retrieval at the Op level") {
@@ -290,6 +296,35 @@ SCENARIO("Check op retrieval overloads are working correctly.", "[ops]") {
   }
 }
 
+SCENARIO("Check sharing of common operations", "[ops]") {
+  GIVEN("Parameterless gates") {
+    REQUIRE(get_op_ptr(OpType::CX) == get_op_ptr(OpType::CX));
+    REQUIRE(get_op_ptr(OpType::H) != get_op_ptr(OpType::X));
+    REQUIRE(get_op_ptr(OpType::CnX, {}, 3) == get_op_ptr(OpType::CnX, {}, 3));
+    REQUIRE(get_op_ptr(OpType::CnX, {}, 3) != get_op_ptr(OpType::CnX, {}, 4));
+    REQUIRE(get_op_ptr(OpType::CnX, {}, 4)->n_qubits() == 4);
+  }
+  GIVEN("Gates with Clifford angles") {
+    Op_ptr rz = get_op_ptr(OpType::Rz, 0.5);
+    REQUIRE(rz == get_op_ptr(OpType::Rz, 0.5));
+    REQUIRE(rz != get_op_ptr(OpType::Rx, 0.5));
+    REQUIRE(rz != get_op_ptr(OpType::Rz, -0.5));
+    // Structurally different parameters are not identified
+    Op_ptr rz_int = get_op_ptr(OpType::Rz, Expr(1));
+    Op_ptr rz_double = get_op_ptr(OpType::Rz, Expr(1.));
+    REQUIRE(rz_int != rz_double);
+    REQUIRE(rz_int->get_params()[0] == Expr(1));
+  }
+  GIVEN("Gates with other parameters") {
+    Sym a = SymEngine::symbol("alpha");
+    Op_ptr rz_sym = get_op_ptr(OpType::Rz, Expr(a));
+    REQUIRE(rz_sym != get_op_ptr(OpType::Rz, Expr(a)));
+    REQUIRE(*rz_sym == *get_op_ptr(OpType::Rz, Expr(a)));
+    Op_ptr rz_num = get_op_ptr(OpType::Rz, 0.123);
+    REQUIRE(rz_num != get_op_ptr(OpType::Rz, 0.123));
+  }
+}
+
 SCENARIO("Examples for is_singleq_unitary") {
   GIVEN("Some true positives") {
     REQUIRE((get_op_ptr(OpType::Z))->get_desc().is_singleq_unitary());
@@ -334,6 +369,51 @@ SCENARIO("Check exceptions in basic Op methods", "[ops]") {
   }
 }
 
+SCENARIO("Commuting bases from the commutation table", "[ops]") {
+  GIVEN("Gates of fixed and variable arity") {
+    const Op_ptr cnx = get_op_ptr(OpType::CnX, std::vector<Expr>{}, 4);
+    REQUIRE(op_commuting_basis(*cnx, 0) == Pauli::Z);
+    REQUIRE(op_commuting_basis(*cnx, 2) == Pauli::Z);
+    REQUIRE(op_commuting_basis(*cnx, 3) == Pauli::X);
+    const Op_ptr bridge = get_op_ptr(OpType::BRIDGE);
+    REQUIRE(op_commuting_basis(*bridge, 0) == Pauli::Z);
+    REQUIRE(op_commuting_basis(*bridge, 1) == Pauli::I);
+    REQUIRE(op_commuting_basis(*bridge, 2) == Pauli::X);
+    const Op_ptr ecr = get_op_ptr(OpType::ECR);
+    REQUIRE(!op_commuting_basis(*ecr, 0));
+    REQUIRE(op_commuting_basis(*ecr, 1) == Pauli::X);
+    const Op_ptr ry = get_op_ptr(OpType::Ry, 0.3);
+    REQUIRE(op_commuting_basis(*ry, 0) == Pauli::Y);
+    REQUIRE(!op_commuting_basis(*get_op_ptr(OpType::SWAP), 1));
+    REQUIRE(op_commutes_with_basis(*cnx, Pauli::Z, 1));
+    REQUIRE(!op_commutes_with_basis(*cnx, Pauli::Z, 3));
+    REQUIRE(op_commutes_with_basis(*bridge, Pauli::Y, 1));
+    REQUIRE(!op_commutes_with_basis(*ecr, std::nullopt, 0));
+  }
+  GIVEN("Agreement with the operations") {
+    for (OpType optype : {OpType::CX, OpType::CH, OpType::CSWAP, OpType::Z,
+                          OpType::H, OpType::XXPhase3, OpType::noop}) {
+      const Op_ptr op = get_op_ptr(
+          optype, std::vector<Expr>(optypeinfo(optype).n_params(), 0.5));
+      for (port_t port = 0; port < op->n_qubits(); ++port) {
+        REQUIRE(op_commuting_basis(*op, port) == op->commuting_basis(port));
+        for (Pauli p : {Pauli::I, Pauli::X, Pauli::Y, Pauli::Z}) {
+          REQUIRE(
+              op_commutes_with_basis(*op, p, port) ==
+              op->commutes_with_basis(p, port));
+        }
+      }
+    }
+  }
+  GIVEN("Invalid queries") {
+    REQUIRE_THROWS_AS(
+        op_commuting_basis(*get_op_ptr(OpType::Z), 1), NotValid);
+    REQUIRE_THROWS_AS(
+        op_commuting_basis(*get_op_ptr(OpType::Barrier), 0), NotValid);
+    REQUIRE(op_commutes_with_basis(*get_op_ptr(OpType::Z), Pauli::I, 1));
+  }
+}
+
 SCENARIO("Check some daggers work correctly", "[ops]") {
   WHEN("Check U2 gets daggered correctly") {
     Expr e(0.33);
@@ -493,6 +573,27 @@ SCENARIO("Check that fresh_symbol actually gives a unique symbol") {
     Sym x1 = SymTable::fresh_symbol("x");
     REQUIRE(x1->get_name() == "x_1");
   }
+  GIVEN("Fresh symbols requested from several threads at once") {
+    const unsigned n_threads = 4;
+    const unsigned n_symbols = 200;
+    std::vector<std::vector<std::string>> names(n_threads);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < n_threads; ++t) {
+      threads.emplace_back([&names, t]() {
+        for (unsigned i = 0; i < n_symbols; ++i) {
+          names[t].push_back(SymTable::fresh_symbol("s")->get_name());
+          // Registering existing symbols meanwhile is harmless
+          get_op_ptr(OpType::Rz, Expr("s"));
+        }
+      });
+    }
+    for (std::thread& thread : threads) thread.join();
+    std::set<std::string> all;
+    for (const std::vector<std::string>& ns : names) {
+      all.insert(ns.begin(), ns.end());
+    }
+    REQUIRE(all.size() == n_threads * n_symbols);
+  }
 }
 
 SCENARIO("Custom Gates") {
@@ -613,5 +714,42 @@ SCENARIO("Two-qubit entangling gates") {
   }
 }
 
+SCENARIO("Operation type properties", "[ops]") {
+  GIVEN("Properties known at compile time") {
+    static_assert(is_clifford_type(OpType::CX));
+    static_assert(!is_clifford_type(OpType::T));
+    static_assert(optype_flags_v<OpType::Rz> & OpTypeFlag::Rotation);
+    static_assert(has_optype_flags<OpTypeFlag::Gate | OpTypeFlag::MultiQubit>(
+        OpType::CCX));
+    static_assert(!has_optype_flags<OpTypeFlag::Gate>(OpType::CircBox));
+  }
+  GIVEN("Every operation type with information") {
+    for (const std::pair<const OpType, OpTypeInfo> &entry : optypeinfo()) {
+      const OpType type = entry.first;
+      REQUIRE(static_cast<std::size_t>(type) < n_optypes);
+      REQUIRE(&optypeinfo(type) == &entry.second);
+      const OpDesc desc(type);
+      CHECK(desc.name() == entry.second.name);
+      CHECK(desc.is_gate() == find_in_set(type, all_gate_types()));
+      CHECK(desc.is_clifford_gate() == is_clifford_type(type));
+      CHECK(
+          is_single_qubit_type(type) ==
+          find_in_set(type, all_single_qubit_types()));
+      CHECK(
+          is_multi_qubit_type(type) ==
+          find_in_set(type, all_multi_qubit_types()));
+      CHECK(
+          is_projective_type(type) ==
+          find_in_set(type, all_projective_types()));
+    }
+  }
+  GIVEN("Sets of operation types") {
+    CHECK(all_projective_types().size() == 3);
+    for (OpType type : all_gate_types()) {
+      CHECK(is_single_qubit_type(type) != is_multi_qubit_type(type));
+    }
+  }
+}
+
 }  // namespace test_Ops
 }  // namespace tket
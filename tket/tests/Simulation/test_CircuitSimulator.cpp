@@ -16,15 +16,21 @@
 // (which, of course, are used in other tests for correctness).
 #include <array>
 #include <catch2/catch.hpp>
+#include <numeric>
 
 #include "../Gate/GatesData.hpp"
 #include "../testutil.hpp"
+#include "Circuit/Boxes.hpp"
 #include "Circuit/CircPool.hpp"
 #include "Circuit/CircUtils.hpp"
 #include "ComparisonFunctions.hpp"
 #include "Gate/GateUnitaryMatrix.hpp"
 #include "Gate/GateUnitaryMatrixUtils.hpp"
+#include "Gate/SymTable.hpp"
+#include "Simulation/AdjointGradient.hpp"
 #include "Simulation/CircuitSimulator.hpp"
+#include "Simulation/MPSSimulator.hpp"
+#include "Simulation/StabiliserSimulator.hpp"
 #include "Transformations/Transform.hpp"
 #include "Utils/MatrixAnalysis.hpp"
 
@@ -141,6 +147,453 @@ SCENARIO("Simple circuits produce the correct statevectors") {
   }
 }
 
+SCENARIO("Statevectors of larger circuits") {
+  GIVEN("A 20-qubit GHZ circuit") {
+    const unsigned n = 20;
+    Circuit circ(n);
+    circ.add_op<unsigned>(OpType::H, {0});
+    for (unsigned i = 0; i + 1 < n; ++i) {
+      circ.add_op<unsigned>(OpType::CX, {i, i + 1});
+    }
+    const StateVector sv = tket_sim::get_statevector(circ, EPS, n);
+    CHECK(std::abs(sv(0) - 1. / std::sqrt(2.)) < 1e-10);
+    CHECK(std::abs(sv(sv.size() - 1) - 1. / std::sqrt(2.)) < 1e-10);
+    CHECK(std::abs(sv.norm() - 1.) < 1e-10);
+  }
+  GIVEN("Gates on widely separated qubits") {
+    const unsigned n = 16;
+    Circuit circ(n);
+    circ.add_op<unsigned>(OpType::X, {n - 1});
+    circ.add_op<unsigned>(OpType::CX, {n - 1, 0});
+    circ.add_op<unsigned>(OpType::SWAP, {0, 7});
+    const StateVector sv = tket_sim::get_statevector(circ, EPS, n);
+    // ILO-BE: qubit 0 is the most significant bit
+    const unsigned expected = (1u << (n - 1 - 7)) | 1u;
+    CHECK(std::abs(sv(expected) - 1.) < 1e-10);
+    CHECK(std::abs(sv.norm() - 1.) < 1e-10);
+  }
+  GIVEN("Gates with ten controls") {
+    const unsigned n = 12;
+    Circuit circ(n);
+    for (unsigned q = 0; q < n; ++q) {
+      circ.add_op<unsigned>(OpType::Ry, 0.3 + 0.1 * q, {q});
+    }
+    const StateVector initial = tket_sim::get_statevector(circ, EPS, n);
+    // The controls are not in order, and the target is not the last qubit
+    const std::vector<unsigned> qubits{11, 0, 9, 2, 3, 4, 5, 6, 7, 1, 8};
+    const unsigned target = qubits.back();
+    // ILO-BE: qubit 0 is the most significant bit
+    unsigned control_mask = 0;
+    for (unsigned i = 0; i + 1 < qubits.size(); ++i) {
+      control_mask |= 1u << (n - 1 - qubits[i]);
+    }
+    const unsigned target_bit = 1u << (n - 1 - target);
+    const Eigen::Matrix2cd ry = GateUnitaryMatrix::get_unitary(
+        OpType::Ry, 1, std::vector<double>{0.7});
+
+    circ.add_op<unsigned>(OpType::CnX, qubits);
+    circ.add_op<unsigned>(OpType::CnRy, 0.7, qubits);
+    const StateVector sv = tket_sim::get_statevector(circ, EPS, n);
+    StateVector expected = initial;
+    for (unsigned x = 0; x < initial.size(); ++x) {
+      if ((x & control_mask) != control_mask || (x & target_bit) != 0) {
+        continue;
+      }
+      const unsigned y = x | target_bit;
+      // X then Ry on the amplitudes of |...0...> and |...1...>
+      const Complex a0 = initial(y);
+      const Complex a1 = initial(x);
+      expected(x) = ry(0, 0) * a0 + ry(0, 1) * a1;
+      expected(y) = ry(1, 0) * a0 + ry(1, 1) * a1;
+    }
+    CHECK(sv.isApprox(expected));
+  }
+  GIVEN("A circuit followed by its inverse, wide enough for a device") {
+    // With TKET_SIM_CUDA this runs on the device, with the wide controlled
+    // gate applied on the host in between
+    const unsigned n = 18;
+    Circuit circ(n);
+    for (unsigned q = 0; q < n; ++q) {
+      circ.add_op<unsigned>(OpType::H, {q});
+      circ.add_op<unsigned>(OpType::Rx, 0.1 * q, {q});
+    }
+    for (unsigned q = 0; q + 2 < n; ++q) {
+      circ.add_op<unsigned>(OpType::CX, {q, q + 1});
+      circ.add_op<unsigned>(OpType::ZZPhase, 0.3, {q + 2, q});
+      circ.add_op<unsigned>(OpType::CCX, {q + 2, q, q + 1});
+    }
+    circ.add_op<unsigned>(OpType::CnRy, 0.7, {0, 4, 8, 12, 16, 17});
+    circ.append(circ.dagger());
+    const StateVector sv = tket_sim::get_statevector(circ, EPS, n);
+    CHECK(std::abs(sv(0) - 1.) < 1e-8);
+    CHECK(std::abs(sv.norm() - 1.) < 1e-8);
+  }
+}
+
+SCENARIO("Fused gates give the same unitary") {
+  GIVEN("A circuit followed by its inverse") {
+    Circuit circ(6);
+    for (unsigned i = 0; i < 6; ++i) {
+      circ.add_op<unsigned>(OpType::Rx, 0.1 * (i + 1), {i});
+      circ.add_op<unsigned>(OpType::CX, {i, (i + 1) % 6});
+      circ.add_op<unsigned>(OpType::Rz, 0.3 * (i + 1), {(i + 3) % 6});
+      circ.add_op<unsigned>(OpType::CCX, {i, (i + 2) % 6, (i + 4) % 6});
+      circ.add_op<unsigned>(OpType::tk1, {0.2, 0.4, 0.7}, {(i + 1) % 6});
+    }
+    const Eigen::MatrixXcd u = tket_sim::get_unitary(circ);
+    // The product of the unitaries of the gates, each simulated on its own
+    Eigen::MatrixXcd unfused = Eigen::MatrixXcd::Identity(64, 64);
+    for (const Command& com : circ) {
+      Circuit single(6);
+      single.add_op<UnitID>(com.get_op_ptr(), com.get_args());
+      unfused = tket_sim::get_unitary(single) * unfused;
+    }
+    CHECK(u.isApprox(unfused));
+    Circuit inv = circ.dagger();
+    circ.append(inv);
+    const Eigen::MatrixXcd id = tket_sim::get_unitary(circ);
+    CHECK(id.isApprox(Eigen::MatrixXcd::Identity(64, 64)));
+  }
+}
+
+SCENARIO("Pauli gadgets give the same unitary as their decomposition") {
+  GIVEN("Many gadgets, some sharing their X and Y qubits") {
+    const unsigned n = 7;
+    // Runs of strings with X or Y on the same qubits.
+    const std::vector<std::vector<Pauli>> strings{
+        {X, Y, Z, I, X, Z, Y}, {X, Y, Z, Z, X, I, Y}, {Y, X, I, Z, Y, Z, X},
+        {Z, Z, I, Z, Z, Z, I}, {I, Z, Z, Z, Z, Z, Z}, {I, I, I, I, I, I, I},
+        {Y, Y, Y, Y, Y, Y, Y}, {X, I, I, Z, I, I, I}, {Z, X, Y, Y, X, Z, Z},
+        {Z, X, Y, X, Y, I, Z}};
+    Circuit circ(n);
+    for (unsigned i = 0; i < n; ++i) {
+      circ.add_op<unsigned>(OpType::H, {i});
+    }
+    std::vector<unsigned> qubits(n);
+    std::iota(qubits.begin(), qubits.end(), 0);
+    for (unsigned i = 0; i < strings.size(); ++i) {
+      circ.add_box(PauliExpBox(strings[i], 0.1 + 0.37 * i), qubits);
+      if (i % 3 == 2) {
+        // A gadget on a few of the qubits.
+        const std::vector<unsigned> pair{i % (n - 1), n - 1};
+        circ.add_box(PauliExpBox({Y, X}, 0.3 * i), pair);
+      }
+    }
+    Circuit decomposed = circ;
+    Transform::decomp_boxes().apply(decomposed);
+    const Eigen::MatrixXcd u = tket_sim::get_unitary(circ);
+    const Eigen::MatrixXcd u_decomposed = tket_sim::get_unitary(decomposed);
+    CHECK(u.isApprox(u_decomposed));
+    const StateVector sv = tket_sim::get_statevector(circ);
+    CHECK(sv.isApprox(u_decomposed.col(0)));
+  }
+}
+
+SCENARIO("Statevectors for a sweep of symbol values") {
+  GIVEN("A symbolic circuit and several bindings") {
+    Sym a = SymEngine::symbol("a");
+    Sym b = SymEngine::symbol("b");
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::Rx, Expr(a), {0});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::Rz, Expr(b), {1});
+    std::vector<symbol_map_t> bindings;
+    for (unsigned i = 0; i < 8; ++i) {
+      bindings.push_back({{a, Expr(0.25 * i)}, {b, Expr(0.5)}});
+    }
+    const std::vector<StateVector> svs =
+        tket_sim::get_statevectors(circ, bindings);
+    REQUIRE(svs.size() == bindings.size());
+    for (unsigned i = 0; i < bindings.size(); ++i) {
+      Circuit bound = circ;
+      bound.symbol_substitution(bindings[i]);
+      CHECK(svs[i].isApprox(tket_sim::get_statevector(bound)));
+    }
+  }
+}
+
+SCENARIO("Stabiliser simulation of Clifford circuits") {
+  const tket_sim::MatrixEquivalence up_to_phase =
+      tket_sim::MatrixEquivalence::EQUAL_UP_TO_GLOBAL_PHASE;
+  GIVEN("A single-qubit state with a Y stabiliser") {
+    Circuit circ(1);
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::S, {0});
+    const std::vector<QubitPauliTensor> stabs =
+        tket_sim::get_stabilisers(circ);
+    REQUIRE(stabs.size() == 1);
+    CHECK(stabs[0] == QubitPauliTensor(Qubit(0), Pauli::Y));
+  }
+  GIVEN("A random-looking Clifford circuit with a wireswap") {
+    Circuit circ(4);
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::S, {1});
+    circ.add_op<unsigned>(OpType::V, {2});
+    circ.add_op<unsigned>(OpType::CZ, {2, 3});
+    circ.add_op<unsigned>(OpType::CY, {3, 0});
+    circ.add_op<unsigned>(OpType::Sdg, {0});
+    circ.add_op<unsigned>(OpType::Y, {2});
+    circ.add_op<unsigned>(OpType::SWAP, {1, 3});
+    circ.add_op<unsigned>(OpType::Vdg, {3});
+    circ.add_op<unsigned>(OpType::BRIDGE, {0, 1, 2});
+    circ.add_op<unsigned>(OpType::H, {1});
+    circ.replace_SWAPs();
+    REQUIRE(circ.has_implicit_wireswaps());
+    REQUIRE(tket_sim::is_stabiliser_circuit(circ));
+    const StateVector sv = tket_sim::get_statevector_up_to_phase(circ);
+    CHECK(tket_sim::compare_statevectors_or_unitaries(
+        sv, tket_sim::get_statevector(circ), up_to_phase));
+  }
+  GIVEN("A non-Clifford circuit") {
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::T, {0});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    REQUIRE(!tket_sim::is_stabiliser_circuit(circ));
+    REQUIRE_THROWS_AS(tket_sim::get_stabilisers(circ), NotValid);
+    CHECK(tket_sim::get_statevector_up_to_phase(circ).isApprox(
+        tket_sim::get_statevector(circ)));
+  }
+  GIVEN("A GHZ state on too many qubits for dense simulation") {
+    const unsigned n = 100;
+    Circuit circ(n);
+    circ.add_op<unsigned>(OpType::H, {0});
+    for (unsigned i = 1; i < n; ++i) {
+      circ.add_op<unsigned>(OpType::CX, {i - 1, i});
+    }
+    const std::vector<QubitPauliTensor> stabs =
+        tket_sim::get_stabilisers(circ);
+    REQUIRE(stabs.size() == n);
+    // The GHZ stabiliser group is generated by X...X and the Z_{i-1} Z_i, and
+    // is maximal, so anything commuting with all of these is in it up to sign.
+    QubitPauliTensor all_x;
+    for (unsigned i = 0; i < n; ++i) {
+      all_x = all_x * QubitPauliTensor(Qubit(i), Pauli::X);
+    }
+    for (const QubitPauliTensor& s : stabs) {
+      CHECK(std::abs(s.coeff) == Approx(1.));
+      bool commutes = s.commutes_with(all_x);
+      for (unsigned i = 1; i < n; ++i) {
+        commutes &= s.commutes_with(
+            QubitPauliTensor(Qubit(i - 1), Pauli::Z) *
+            QubitPauliTensor(Qubit(i), Pauli::Z));
+      }
+      CHECK(commutes);
+    }
+  }
+}
+
+SCENARIO("Matrix product state simulation") {
+  GIVEN("A circuit with long-range, multi-qubit and controlled gates") {
+    Circuit circ(6);
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::Rx, 0.3, {3});
+    circ.add_op<unsigned>(OpType::CX, {0, 5});
+    circ.add_op<unsigned>(OpType::CRz, 0.7, {5, 2});
+    circ.add_op<unsigned>(OpType::CCX, {3, 0, 4});
+    circ.add_op<unsigned>(OpType::ZZPhase, 0.2, {4, 1});
+    circ.add_op<unsigned>(OpType::CnRy, 0.4, {1, 2, 3, 5});
+    circ.add_box(
+        PauliExpBox({Pauli::X, Pauli::Y, Pauli::Z}, 0.6), {2, 5, 0});
+    circ.add_op<unsigned>(OpType::SWAP, {1, 4});
+    circ.add_op<unsigned>(OpType::tk1, {0.1, 0.2, 0.3}, {5});
+    circ.add_phase(0.25);
+    circ.replace_SWAPs();
+    REQUIRE(circ.has_implicit_wireswaps());
+    const StateVector sv = tket_sim::get_statevector(circ);
+    const tket_sim::MPSState mps = tket_sim::get_mps(circ);
+    CHECK(mps.get_truncation_fidelity() == Approx(1.));
+    CHECK(mps.get_statevector().isApprox(sv));
+    std::vector<bool> bits{true, false, true, true, false, true};
+    CHECK(std::abs(mps.get_amplitude(bits) - sv(0b101101)) < 1e-10);
+    const std::vector<Pauli> paulis{Pauli::Z, Pauli::X, Pauli::I,
+                                    Pauli::Y, Pauli::Z, Pauli::X};
+    QubitPauliMap qpm;
+    for (unsigned i = 0; i < 6; ++i) qpm[Qubit(i)] = paulis[i];
+    const CmplxSpMat op = QubitPauliString(qpm).to_sparse_matrix(6);
+    const double expected = (sv.adjoint() * op * sv)(0, 0).real();
+    CHECK(mps.get_expectation(paulis) == Approx(expected).margin(1e-10));
+  }
+  GIVEN("A GHZ state on too many qubits for dense simulation") {
+    const unsigned n = 80;
+    Circuit circ(n);
+    circ.add_op<unsigned>(OpType::H, {0});
+    for (unsigned i = 1; i < n; ++i) {
+      circ.add_op<unsigned>(OpType::CX, {i - 1, i});
+    }
+    circ.add_op<unsigned>(OpType::CZ, {0, n - 1});
+    circ.add_op<unsigned>(OpType::CZ, {n - 1, 0});
+    const tket_sim::MPSState mps = tket_sim::get_mps(circ);
+    CHECK(mps.get_bond_dimension() == 2);
+    CHECK(std::abs(mps.get_amplitude(std::vector<bool>(n, false))) ==
+          Approx(std::sqrt(0.5)));
+    CHECK(std::abs(mps.get_amplitude(std::vector<bool>(n, true))) ==
+          Approx(std::sqrt(0.5)));
+    std::vector<bool> bits(n, false);
+    bits[n / 2] = true;
+    CHECK(std::abs(mps.get_amplitude(bits)) < 1e-10);
+    std::vector<Pauli> paulis(n, Pauli::X);
+    CHECK(mps.get_expectation(paulis) == Approx(1.));
+    paulis.assign(n, Pauli::I);
+    paulis[3] = Pauli::Z;
+    paulis[70] = Pauli::Z;
+    CHECK(mps.get_expectation(paulis) == Approx(1.));
+    REQUIRE_THROWS_AS(mps.get_statevector(), NotValid);
+  }
+  GIVEN("A bond dimension too small for the state") {
+    Circuit circ(6);
+    for (unsigned i = 0; i < 6; ++i) {
+      circ.add_op<unsigned>(OpType::Ry, 0.1 * (i + 1), {i});
+    }
+    for (unsigned layer = 0; layer < 4; ++layer) {
+      for (unsigned i = layer % 2; i + 1 < 6; i += 2) {
+        circ.add_op<unsigned>(OpType::CRx, 0.3 + 0.1 * i, {i, i + 1});
+        circ.add_op<unsigned>(OpType::Ry, 0.2 * layer, {i + 1});
+      }
+    }
+    const tket_sim::MPSState exact = tket_sim::get_mps(circ);
+    const tket_sim::MPSState truncated = tket_sim::get_mps(circ, 2);
+    CHECK(exact.get_truncation_fidelity() == Approx(1.));
+    CHECK(exact.get_statevector().isApprox(tket_sim::get_statevector(circ)));
+    CHECK(truncated.get_bond_dimension() <= 2);
+    CHECK(truncated.get_truncation_fidelity() < 1.);
+    CHECK(truncated.get_statevector().norm() == Approx(1.));
+  }
+}
+
+SCENARIO("Sampling shots from statevectors") {
+  GIVEN("A GHZ state") {
+    Circuit circ(3);
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::CX, {1, 2});
+    const StateVector sv = tket_sim::get_statevector(circ);
+    const std::vector<std::uint64_t> shots =
+        tket_sim::sample_shots(sv, 10000, 1);
+    REQUIRE(shots.size() == 10000);
+    unsigned n_ones = 0;
+    for (std::uint64_t shot : shots) {
+      REQUIRE((shot == 0 || shot == 7));
+      if (shot == 7) ++n_ones;
+    }
+    CHECK(n_ones > 4700);
+    CHECK(n_ones < 5300);
+    CHECK(tket_sim::sample_shots(sv, 10000, 1) == shots);
+    const std::vector<std::uint64_t> marginal =
+        tket_sim::sample_shots(sv, {2, 0}, 100, 2);
+    for (std::uint64_t shot : marginal) {
+      CHECK((shot == 0 || shot == 3));
+    }
+  }
+  GIVEN("A product state sampled on some qubits") {
+    Circuit circ(4);
+    circ.add_op<unsigned>(OpType::X, {1});
+    circ.add_op<unsigned>(OpType::Ry, 2. / 3., {3});
+    const StateVector sv = tket_sim::get_statevector(circ);
+    const std::vector<std::uint64_t> shots =
+        tket_sim::sample_shots(sv, {3, 1}, 20000, 3);
+    // Qubit 3 reads 1 with probability 3/4, and qubit 1 always reads 1.
+    unsigned n_ones = 0;
+    for (std::uint64_t shot : shots) {
+      REQUIRE((shot == 1 || shot == 3));
+      if (shot == 3) ++n_ones;
+    }
+    CHECK(n_ones > 14700);
+    CHECK(n_ones < 15300);
+  }
+  GIVEN("A circuit with final measurements") {
+    Circuit circ(3, 3);
+    circ.add_op<unsigned>(OpType::X, {0});
+    circ.add_op<unsigned>(OpType::H, {2});
+    circ.add_op<unsigned>(OpType::Measure, {0, 2});
+    circ.add_op<unsigned>(OpType::Measure, {2, 1});
+    const StateVector sv = tket_sim::get_statevector(circ);
+    const std::vector<std::uint64_t> readouts =
+        tket_sim::sample_readouts(circ, sv, 1000);
+    bool seen[2] = {false, false};
+    for (std::uint64_t readout : readouts) {
+      // Bit 2 is always 1, bit 1 is random and bit 0 is unmeasured.
+      REQUIRE((readout == 1 || readout == 3));
+      seen[readout >> 1] = true;
+    }
+    CHECK(seen[0]);
+    CHECK(seen[1]);
+  }
+  GIVEN("Invalid input") {
+    StateVector sv = StateVector::Zero(4);
+    REQUIRE_THROWS_AS(tket_sim::sample_shots(sv, 1), NotValid);
+    sv(1) = 1.;
+    const std::vector<unsigned> out_of_range{2};
+    REQUIRE_THROWS_AS(tket_sim::sample_shots(sv, out_of_range, 1), NotValid);
+    REQUIRE_THROWS_AS(tket_sim::sample_shots(sv, {0, 0}, 1), NotValid);
+    REQUIRE_THROWS_AS(
+        tket_sim::sample_shots(StateVector::Ones(3), 1), NotValid);
+    REQUIRE(tket_sim::sample_shots(sv, 0).empty());
+  }
+}
+
+SCENARIO("Gradients of expectation values by the adjoint method") {
+  const Sym a = SymTable::fresh_symbol("a");
+  const Sym b = SymTable::fresh_symbol("b");
+  const Expr ea(a), eb(b);
+  Circuit circ(3);
+  circ.add_op<unsigned>(OpType::H, {0});
+  circ.add_op<unsigned>(OpType::Rx, ea, {1});
+  circ.add_op<unsigned>(OpType::CRz, 2 * eb + 0.1, {0, 2});
+  circ.add_op<unsigned>(OpType::ZZPhase, ea * eb, {1, 2});
+  circ.add_box(PauliExpBox({Pauli::X, Pauli::Y}, ea), {2, 0});
+  circ.add_op<unsigned>(OpType::U3, {ea, eb, 0.3}, {1});
+  circ.add_op<unsigned>(OpType::SWAP, {0, 1});
+  circ.add_op<unsigned>(OpType::Ry, SymEngine::sin(ea), {0});
+  circ.replace_SWAPs();
+  REQUIRE(circ.has_implicit_wireswaps());
+  const qubit_vector_t qubits = circ.all_qubits();
+  const OperatorSum op{
+      {QubitPauliString({qubits[0], qubits[1]}, {Pauli::Z, Pauli::Z}), 0.5},
+      {QubitPauliString(qubits[2], Pauli::X), -1.2},
+      {QubitPauliString(
+           {qubits[0], qubits[1], qubits[2]}, {Pauli::Y, Pauli::X, Pauli::Z}),
+       0.3}};
+  auto bound_state = [&](double va, double vb) {
+    Circuit bound = circ;
+    bound.symbol_substitution(symbol_map_t{{a, va}, {b, vb}});
+    return tket_sim::get_statevector(bound);
+  };
+  auto expectation = [&](double va, double vb) {
+    const StateVector sv = bound_state(va, vb);
+    double e = 0.;
+    for (const std::pair<QubitPauliString, Complex>& term : op) {
+      e += (term.second * term.first.state_expectation(sv, qubits)).real();
+    }
+    return e;
+  };
+  const double va = 0.37, vb = -1.21, h = 1e-5;
+  const tket_sim::ExpectationGradient result =
+      tket_sim::get_expectation_gradient(circ, {{a, va}, {b, vb}}, op);
+  CHECK(result.expectation == Approx(expectation(va, vb)).margin(1e-10));
+  const double da = (expectation(va + h, vb) - expectation(va - h, vb)) / 2 / h;
+  const double db = (expectation(va, vb + h) - expectation(va, vb - h)) / 2 / h;
+  CHECK(result.gradient.at(a) == Approx(da).margin(1e-6));
+  CHECK(result.gradient.at(b) == Approx(db).margin(1e-6));
+  GIVEN("A single Pauli string and an unused symbol") {
+    const Sym c = SymTable::fresh_symbol("c");
+    const QubitPauliString zz({qubits[0], qubits[2]}, {Pauli::Z, Pauli::Z});
+    const tket_sim::ExpectationGradient single =
+        tket_sim::get_expectation_gradient(
+            circ, {{a, va}, {b, vb}, {c, 2.}}, zz);
+    CHECK(single.gradient.at(c) == 0.);
+    const StateVector sv = bound_state(va, vb);
+    CHECK(
+        single.expectation ==
+        Approx(zz.state_expectation(sv, qubits).real()).margin(1e-10));
+  }
+  GIVEN("A missing symbol") {
+    REQUIRE_THROWS_AS(
+        tket_sim::get_expectation_gradient(circ, {{a, va}}, op), NotValid);
+  }
+}
+
 SCENARIO("Ignored op types don't affect get unitary") {
   Circuit circ1(3);
   // circ2 will add the same ops as circ1, but with extra ops
@@ -492,6 +945,100 @@ SCENARIO("Handling internal qubit permutations") {
   }
 }
 
+SCENARIO("Comparing circuits on random states") {
+  GIVEN("Random states") {
+    const Eigen::MatrixXcd states = tket_sim::random_states(3, 4, 5);
+    REQUIRE(states.rows() == 8);
+    REQUIRE(states.cols() == 4);
+    for (unsigned col = 0; col < 4; ++col) {
+      REQUIRE(std::abs(states.col(col).norm() - 1) < ERR_EPS);
+    }
+    REQUIRE(states == tket_sim::random_states(3, 4, 5));
+    REQUIRE(states != tket_sim::random_states(3, 4, 6));
+  }
+  GIVEN("Equivalent circuits on more qubits than get_unitary allows") {
+    const unsigned n_qubits = 14;
+    Circuit circ1(n_qubits);
+    Circuit circ2(n_qubits);
+    for (unsigned q = 0; q < n_qubits; ++q) {
+      circ1.add_op<unsigned>(OpType::Ry, 0.1 * (q + 1), {q});
+      circ2.add_op<unsigned>(OpType::Ry, 0.1 * (q + 1), {q});
+    }
+    for (unsigned q = 0; q + 1 < n_qubits; ++q) {
+      circ1.add_op<unsigned>(OpType::CX, {q, q + 1});
+      circ2.add_op<unsigned>(OpType::H, {q + 1});
+      circ2.add_op<unsigned>(OpType::CZ, {q, q + 1});
+      circ2.add_op<unsigned>(OpType::H, {q + 1});
+    }
+    REQUIRE(tket_sim::compare_circuits_by_probing(circ1, circ2));
+    WHEN("One circuit has a global phase") {
+      circ2.add_phase(0.25);
+      REQUIRE_FALSE(tket_sim::compare_circuits_by_probing(circ1, circ2));
+      REQUIRE(tket_sim::compare_circuits_by_probing(circ1, circ2, true));
+    }
+    WHEN("One circuit has an extra gate") {
+      circ2.add_op<unsigned>(OpType::T, {n_qubits / 2});
+      REQUIRE_FALSE(tket_sim::compare_circuits_by_probing(circ1, circ2));
+      REQUIRE_FALSE(
+          tket_sim::compare_circuits_by_probing(circ1, circ2, true));
+    }
+    WHEN("The circuits have different numbers of qubits") {
+      circ2.add_qubit(Qubit(n_qubits));
+      REQUIRE_THROWS_AS(
+          tket_sim::compare_circuits_by_probing(circ1, circ2), NotValid);
+    }
+  }
+  GIVEN("Circuits agreeing with get_unitary") {
+    Circuit circ1(2);
+    circ1.add_op<unsigned>(OpType::SWAP, {0, 1});
+    Circuit circ2(2);
+    circ2.add_op<unsigned>(OpType::CX, {0, 1});
+    circ2.add_op<unsigned>(OpType::CX, {1, 0});
+    circ2.add_op<unsigned>(OpType::CX, {0, 1});
+    REQUIRE(tket_sim::get_unitary(circ1).isApprox(
+        tket_sim::get_unitary(circ2), ERR_EPS));
+    REQUIRE(tket_sim::compare_circuits_by_probing(circ1, circ2));
+  }
+}
+
+SCENARIO("Simulating into a buffer owned by the caller") {
+  Circuit circ(3);
+  circ.add_op<unsigned>(OpType::H, {0});
+  circ.add_op<unsigned>(OpType::CX, {0, 1});
+  circ.add_op<unsigned>(OpType::Ry, 0.3, {2});
+  circ.add_op<unsigned>(OpType::CX, {1, 0});
+  circ.add_op<unsigned>(OpType::SWAP, {1, 2});
+  circ.replace_SWAPs();
+  REQUIRE(circ.implicit_qubit_permutation().at(Qubit(1)) == Qubit(2));
+  const Eigen::MatrixXcd u = tket_sim::get_unitary(circ);
+  const Eigen::VectorXcd sv = tket_sim::get_statevector(circ);
+  GIVEN("A raw buffer for the unitary") {
+    std::vector<std::complex<double>> buffer(64, 7.0);
+    Eigen::Map<Eigen::MatrixXcd> out(buffer.data(), 8, 8);
+    tket_sim::write_unitary(circ, out);
+    REQUIRE(out.isApprox(u, ERR_EPS));
+    REQUIRE(buffer[9] == out(1, 1));
+  }
+  GIVEN("A raw buffer for the statevector") {
+    std::vector<std::complex<double>> buffer(8, 7.0);
+    Eigen::Map<Eigen::VectorXcd> out(buffer.data(), 8);
+    tket_sim::write_statevector(circ, out);
+    REQUIRE(out.isApprox(sv, ERR_EPS));
+    REQUIRE(out.isApprox(u.col(0), ERR_EPS));
+  }
+  GIVEN("A block of a larger matrix") {
+    Eigen::MatrixXcd big = Eigen::MatrixXcd::Random(10, 6);
+    const Eigen::MatrixXcd original = big;
+    tket_sim::apply_unitary(circ, big.block(1, 2, 8, 3));
+    REQUIRE(big.block(1, 2, 8, 3).isApprox(
+        u * original.block(1, 2, 8, 3), ERR_EPS));
+    REQUIRE(big.row(0) == original.row(0));
+    REQUIRE(big.row(9) == original.row(9));
+    REQUIRE(big.leftCols(2) == original.leftCols(2));
+    REQUIRE(big.rightCols(1) == original.rightCols(1));
+  }
+}
+
 SCENARIO("compare_statevectors_or_unitaries gives expected errors") {
   const std::array<tket_sim::MatrixEquivalence, 2> equivalences{
       tket_sim::MatrixEquivalence::EQUAL,
@@ -251,6 +251,22 @@ SCENARIO("CosSinDecomposition") {
       }
     }
   }
+  GIVEN("Fixed-size 8x8 unitaries") {
+    for (unsigned i = 0; i < 10; i++) {
+      Eigen::MatrixXcd U = random_unitary(8, 1000 + i);
+      auto [l0, l1, r0, r1, c, s] = CS_decomp(U);
+      auto [l0_8, l1_8, r0_8, r1_8, c_8, s_8] = CS_decomp(Matrix8cd(U));
+      CHECK(l0.isApprox(l0_8));
+      CHECK(l1.isApprox(l1_8));
+      CHECK(r0.isApprox(r0_8));
+      CHECK(r1.isApprox(r1_8));
+      CHECK(c.isApprox(c_8));
+      CHECK(s.isApprox(s_8));
+    }
+    REQUIRE_THROWS_AS(
+        CS_decomp(Matrix8cd(2 * Matrix8cd::Identity())),
+        std::invalid_argument);
+  }
 }
 
 }  // namespace test_CosSinDecomposition
@@ -14,8 +14,10 @@
 
 #include <algorithm>
 #include <catch2/catch.hpp>
+#include <random>
 #include <vector>
 
+#include "Utils/BinaryMatrix.hpp"
 #include "Utils/MatrixAnalysis.hpp"
 
 // Element[n] = 2^n
@@ -83,5 +85,56 @@ SCENARIO("Powers of two") {
   }
 }
 
+SCENARIO("Packed binary matrices") {
+  std::mt19937 rng(17);
+  std::bernoulli_distribution coin;
+  GIVEN("A matrix wider than a word") {
+    MatrixXb m(5, 130);
+    for (unsigned r = 0; r < 5; ++r) {
+      for (unsigned c = 0; c < 130; ++c) m(r, c) = coin(rng);
+    }
+    BinaryMatrix packed(m);
+    REQUIRE(packed.to_MatrixXb() == m);
+    packed.add_row(1, 3);
+    m.row(3) = m.row(3).array() != m.row(1).array();
+    REQUIRE(packed.to_MatrixXb() == m);
+    THEN("Segments across word boundaries are read correctly") {
+      std::vector<std::uint64_t> words;
+      packed.get_segment(3, 60, 129, words);
+      REQUIRE(words.size() == 2);
+      for (unsigned c = 60; c < 129; ++c) {
+        unsigned i = c - 60;
+        REQUIRE(((words[i / 64] >> (i % 64)) & 1) == m(3, c));
+      }
+      REQUIRE((words[1] >> 5) == 0);
+      bool old = packed.get(2, 70);
+      packed.set(2, 70, true);
+      REQUIRE_FALSE(packed.is_zero(2, 66, 71));
+      packed.set(2, 70, old);
+      bool zero = true;
+      for (unsigned c = 66; c < 71; ++c) zero &= !m(2, c);
+      REQUIRE(packed.is_zero(2, 66, 71) == zero);
+    }
+  }
+  GIVEN("An invertible matrix over more than two words") {
+    const unsigned n = 150;
+    MatrixXb m = MatrixXb::Identity(n, n);
+    std::uniform_int_distribution<unsigned> row(0, n - 1);
+    for (unsigned i = 0; i < 2000; ++i) {
+      unsigned r0 = row(rng);
+      unsigned r1 = row(rng);
+      if (r0 != r1) m.row(r1) = m.row(r1).array() != m.row(r0).array();
+    }
+    THEN("Gaussian elimination reduces it to the identity") {
+      BinaryMatrix reduced(m);
+      for (const std::pair<unsigned, unsigned> &op :
+           gaussian_elimination_row_ops(m)) {
+        reduced.add_row(op.first, op.second);
+      }
+      REQUIRE(reduced.to_MatrixXb() == MatrixXb::Identity(n, n));
+    }
+  }
+}
+
 }  // namespace test_MatrixAnalysis
 }  // namespace tket
@@ -0,0 +1,101 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <catch2/catch.hpp>
+#include <set>
+#include <thread>
+
+#include "Utils/Json.hpp"
+#include "Utils/Trace.hpp"
+
+namespace tket {
+namespace test_Trace {
+
+// Events of the exported trace with the given name
+static std::vector<nlohmann::json> events_named(const std::string& name) {
+  const nlohmann::json j = nlohmann::json::parse(trace::chrome_json());
+  std::vector<nlohmann::json> events;
+  for (const nlohmann::json& event : j.at("traceEvents")) {
+    if (event.at("name") == name) events.push_back(event);
+  }
+  return events;
+}
+
+SCENARIO("Recording trace spans") {
+  trace::clear();
+  GIVEN("Recording disabled") {
+    trace::set_enabled(false);
+    {
+      trace::Span span("test_Trace::disabled");
+      REQUIRE_FALSE(span.active());
+      trace::count("calls");
+    }
+    REQUIRE(events_named("test_Trace::disabled").empty());
+  }
+  GIVEN("Nested spans with counters") {
+    trace::set_enabled(true);
+    {
+      trace::Span outer("test_Trace::outer");
+      REQUIRE(outer.active());
+      trace::count("calls", 2);
+      {
+        trace::Span inner("test_Trace::inner");
+        for (unsigned i = 0; i < 5; ++i) trace::count("calls");
+        trace::arg("detail", "inner span");
+      }
+      trace::count("calls");
+    }
+    trace::set_enabled(false);
+    const std::vector<nlohmann::json> outer = events_named("test_Trace::outer");
+    const std::vector<nlohmann::json> inner = events_named("test_Trace::inner");
+    REQUIRE(outer.size() == 1);
+    REQUIRE(inner.size() == 1);
+    REQUIRE(outer[0].at("ph") == "X");
+    REQUIRE(outer[0].at("args").at("calls") == 3);
+    REQUIRE(inner[0].at("args").at("calls") == 5);
+    REQUIRE(inner[0].at("args").at("detail") == "inner span");
+    // The inner span lies within the outer one
+    const double outer_ts = outer[0].at("ts");
+    const double inner_ts = inner[0].at("ts");
+    REQUIRE(outer_ts <= inner_ts);
+    REQUIRE(
+        inner_ts + double(inner[0].at("dur")) <=
+        outer_ts + double(outer[0].at("dur")));
+  }
+  GIVEN("Spans on several threads") {
+    trace::set_enabled(true);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < 4; ++t) {
+      threads.emplace_back([] {
+        trace::Span span("test_Trace::thread");
+        trace::count("calls");
+      });
+    }
+    for (std::thread& thread : threads) thread.join();
+    trace::set_enabled(false);
+    const std::vector<nlohmann::json> events =
+        events_named("test_Trace::thread");
+    REQUIRE(events.size() == 4);
+    std::set<unsigned> tids;
+    for (const nlohmann::json& event : events) {
+      tids.insert(event.at("tid").get<unsigned>());
+    }
+    REQUIRE(tids.size() == 4);
+    trace::clear();
+    REQUIRE(trace::n_recorded() == 0);
+  }
+}
+
+}  // namespace test_Trace
+}  // namespace tket
@@ -316,6 +316,22 @@ SCENARIO("Check rewrite combinators act the same as individual rewrites") {
     CHECK(loop.apply(copy));        // Should iterate until completion
     CHECK_FALSE(loop.apply(copy));  // Check for completion
   }
+  GIVEN("Worklist rewrites on a diagram") {
+    ZXDiagram copy = diag;
+    Rewrite loop = Rewrite::worklist(
+        {&Rewrite::self_loop_removal_at, &Rewrite::spider_fusion_at,
+         &Rewrite::parallel_h_removal_at});
+    CHECK(loop.apply(copy));        // Should iterate until completion
+    CHECK_FALSE(loop.apply(copy));  // Check for completion
+    // Same fixed point as the full sweeps
+    Rewrite sweeps = Rewrite::repeat(Rewrite::sequence(
+        {Rewrite::self_loop_removal(), Rewrite::spider_fusion(),
+         Rewrite::parallel_h_removal()}));
+    CHECK_FALSE(sweeps.apply(copy));
+    CHECK(copy.n_vertices() == 3);
+    CHECK(copy.count_wires(ZXWireType::Basic) == 1);
+    CHECK(copy.count_wires(ZXWireType::H) == 1);
+  }
 }
 
 }  // namespace test_ZXAxioms
@@ -14,7 +14,9 @@
 
 #include <catch2/catch.hpp>
 #include <fstream>
+#include <sstream>
 
+#include "ZX/Rewrite.hpp"
 #include "ZX/ZXDiagram.hpp"
 #include "ZX/ZXGenerator.hpp"
 
@@ -63,6 +65,53 @@ SCENARIO("Testing generator creation") {
   CHECK_FALSE(tri.valid_edge(1, QuantumType::Quantum));
 }
 
+SCENARIO("Exact and symbolic phases of generators") {
+  GIVEN("Phases given as exact fractions") {
+    CHECK(ZXPhase(Expr(0.25)).is_exact());
+    CHECK(ZXPhase(Expr(-3)).is_exact());
+    CHECK(ZXPhase(Expr(SymEngine::div(
+                      SymEngine::integer(7), SymEngine::integer(2))))
+              .is_exact());
+    CHECK_FALSE(ZXPhase(Expr(0.3)).is_exact());
+    CHECK_FALSE(ZXPhase(Expr("a")).is_exact());
+  }
+  GIVEN("Clifford checks") {
+    CHECK(ZXPhase(Expr(1.)).is_pauli());
+    CHECK(ZXPhase(Expr(-2)).is_zero());
+    CHECK(ZXPhase(3, 2).is_proper_clifford());
+    CHECK(ZXPhase(Expr(-0.5)).clifford_multiple() == 3u);
+    CHECK_FALSE(ZXPhase(Expr(0.25)).clifford_multiple());
+    // Symbolic phases agree with equiv_Clifford
+    CHECK(ZXPhase(Expr(0.5 + 1e-12)).is_proper_clifford());
+    CHECK_FALSE(ZXPhase(Expr("a")).clifford_multiple());
+  }
+  GIVEN("Arithmetic") {
+    ZXPhase sum = ZXPhase(Expr(0.25)) + ZXPhase(Expr(1.5));
+    CHECK(sum.is_exact());
+    CHECK(sum.to_expr() == Expr(1.75));
+    ZXPhase third = ZXPhase(1, 3) + ZXPhase(1, 6) - ZXPhase(0, 1);
+    CHECK(third == ZXPhase(1, 2));
+    CHECK(third.to_expr() == Expr("1/2"));
+    ZXPhase mixed = ZXPhase(Expr(0.25)) + ZXPhase(Expr("a"));
+    CHECK_FALSE(mixed.is_exact());
+    CHECK(mixed.to_expr() == Expr(0.25) + Expr("a"));
+    CHECK(-ZXPhase(Expr(0.25)) == ZXPhase(Expr(-0.25)));
+    // Fine phases fall back to a symbolic value rather than overflowing
+    ZXPhase fine(1, std::int64_t{1} << 40);
+    CHECK_FALSE(fine.is_exact());
+    CHECK((fine + fine).to_expr() == Expr("1/549755813888"));
+  }
+  GIVEN("Generators keep the parameter as given") {
+    BasicGen z(ZXType::ZSpider, Expr(-0.75));
+    CHECK(z.get_phase().is_exact());
+    CHECK(z.get_param() == Expr(-0.75));
+    CHECK(z.get_name() == "Q-Z(-0.75)");
+    BasicGen fused(ZXType::ZSpider, z.get_phase() + ZXPhase(Expr(0.25)));
+    CHECK(fused.get_phase().is_proper_clifford());
+    CHECK(fused == BasicGen(ZXType::ZSpider, Expr(-0.5)));
+  }
+}
+
 SCENARIO("Testing diagram creation & vertex/edge additions") {
   ZXDiagram diag(1, 1, 0, 0);
   CHECK(diag.get_scalar() == Expr(1.));
@@ -161,8 +210,11 @@ SCENARIO("Testing diagram creation & vertex/edge additions") {
 
   THEN("Print diagram to file") {
     std::ofstream dot_file("zxdiag.dot");
-    dot_file << diag.to_graphviz_str();
+    diag.to_graphviz(dot_file);
     dot_file.close();
+    std::stringstream dot_stream;
+    diag.to_graphviz(dot_stream);
+    REQUIRE(dot_stream.str() == diag.to_graphviz_str());
     remove("zxdiag.dot");
   }
 }
@@ -245,6 +297,74 @@ SCENARIO("Check that diagram conversions achieve the correct form") {
   }
 }
 
+SCENARIO("Rolling back changes to a diagram") {
+  ZXDiagram diag(1, 1, 0, 0);
+  ZXVertVec ins = diag.get_boundary(ZXType::Input);
+  ZXVertVec outs = diag.get_boundary(ZXType::Output);
+  ZXVert z = diag.add_vertex(ZXType::ZSpider, 0.3);
+  ZXVert x = diag.add_vertex(ZXType::XSpider);
+  diag.add_wire(ins[0], z);
+  diag.add_wire(z, x, ZXWireType::H);
+  Wire basic = diag.add_wire(z, x);
+  diag.add_wire(x, outs[0]);
+  const std::string before = diag.to_graphviz_str();
+  CHECK_FALSE(diag.is_journaling());
+
+  GIVEN("Changes through the diagram's methods") {
+    std::size_t mark = diag.checkpoint();
+    REQUIRE(diag.is_journaling());
+    diag.set_wire_type(basic, ZXWireType::H);
+    diag.set_vertex_ZXGen_ptr(
+        x, ZXGen::create_gen(ZXType::ZSpider, 0.5, QuantumType::Quantum));
+    diag.multiply_scalar(2.);
+    ZXVert y = diag.add_vertex(ZXType::Hbox);
+    diag.add_wire(y, z);
+    diag.remove_vertex(x);
+    diag.remove_vertex(ins[0]);
+    CHECK(diag.get_boundary().size() == 1);
+    diag.rollback(mark);
+    REQUIRE_NOTHROW(diag.check_validity());
+    CHECK(diag.n_vertices() == 4);
+    CHECK(diag.n_wires() == 4);
+    CHECK(diag.count_vertices(ZXType::XSpider) == 1);
+    CHECK(diag.count_vertices(ZXType::Hbox) == 0);
+    CHECK(diag.count_wires(ZXWireType::H) == 1);
+    CHECK(diag.get_scalar() == Expr(1.));
+    // Restored vertices have new descriptors, but keep their place in the
+    // boundary
+    ZXVertVec restored_ins = diag.get_boundary(ZXType::Input);
+    REQUIRE(restored_ins.size() == 1);
+    CHECK(diag.get_boundary().front() == restored_ins[0]);
+    CHECK(diag.neighbours(restored_ins[0]) == ZXVertVec{z});
+    diag.release();
+    CHECK_FALSE(diag.is_journaling());
+  }
+  GIVEN("Nested checkpoints") {
+    std::size_t outer = diag.checkpoint();
+    diag.remove_wire(basic);
+    std::size_t inner = diag.checkpoint();
+    ZXVert y = diag.add_vertex(ZXType::ZSpider);
+    diag.add_wire(y, z, ZXWireType::H);
+    diag.rollback(inner);
+    CHECK(diag.n_vertices() == 4);
+    CHECK(diag.n_wires() == 3);
+    diag.rollback(outer);
+    CHECK(diag.n_wires() == 4);
+    CHECK(diag.to_graphviz_str() == before);
+    REQUIRE_THROWS_AS(diag.rollback(outer + 1), ZXError);
+  }
+  GIVEN("A speculative rewrite which does not improve the metric") {
+    Rewrite grow = Rewrite::io_extension();
+    diag.set_wire_type(diag.adj_wires(ins[0]).at(0), ZXWireType::H);
+    // I/O extension adds a vertex, so its application is undone
+    Rewrite loop = Rewrite::repeat_with_metric(grow, &ZXDiagram::n_vertices);
+    CHECK_FALSE(loop.apply(diag));
+    CHECK(diag.n_vertices() == 4);
+    CHECK(diag.count_wires(ZXWireType::H) == 2);
+    CHECK_FALSE(diag.is_journaling());
+  }
+}
+
 }  // namespace test_ZXDiagram
 }  // namespace zx
 }  // namespace tket
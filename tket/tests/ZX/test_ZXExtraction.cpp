@@ -0,0 +1,119 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <catch2/catch.hpp>
+
+#include "../testutil.hpp"
+#include "Converters/Converters.hpp"
+#include "Predicates/CompilerPass.hpp"
+#include "Predicates/PassLibrary.hpp"
+#include "ZX/Rewrite.hpp"
+
+namespace tket {
+namespace zx {
+namespace test_ZXExtraction {
+
+static Circuit clifford_t_circuit() {
+  Circuit circ(3);
+  circ.add_op<unsigned>(OpType::H, {0});
+  circ.add_op<unsigned>(OpType::CX, {0, 1});
+  circ.add_op<unsigned>(OpType::T, {1});
+  circ.add_op<unsigned>(OpType::CX, {1, 2});
+  circ.add_op<unsigned>(OpType::S, {2});
+  circ.add_op<unsigned>(OpType::H, {2});
+  circ.add_op<unsigned>(OpType::CZ, {0, 2});
+  circ.add_op<unsigned>(OpType::Rx, 0.3, {0});
+  circ.add_op<unsigned>(OpType::CX, {2, 0});
+  circ.add_op<unsigned>(OpType::Tdg, {0});
+  circ.add_op<unsigned>(OpType::SWAP, {1, 2});
+  circ.add_op<unsigned>(OpType::V, {1});
+  circ.add_op<unsigned>(OpType::CX, {1, 0});
+  circ.add_op<unsigned>(OpType::tk1, {0.2, 0.7, 1.1}, {2});
+  circ.add_op<unsigned>(OpType::Ry, 0.4, {1});
+  circ.add_op<unsigned>(OpType::Y, {2});
+  circ.add_phase(0.15);
+  return circ;
+}
+
+SCENARIO("Converting circuits to ZX diagrams and back") {
+  GIVEN("A Clifford+T circuit") {
+    Circuit circ = clifford_t_circuit();
+    ZXDiagram diag = circuit_to_zx(circ);
+    REQUIRE_NOTHROW(diag.check_validity());
+    CHECK(diag.get_boundary(ZXType::Input).size() == 3);
+    CHECK(diag.get_boundary(ZXType::Output).size() == 3);
+    Circuit extracted = zx_to_circuit(diag);
+    CHECK(test_unitary_comparison(circ, extracted));
+  }
+  GIVEN("A circuit with an implicit permutation") {
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::SWAP, {0, 1});
+    circ.add_op<unsigned>(OpType::T, {0});
+    circ.replace_SWAPs();
+    REQUIRE(circ.has_implicit_wireswaps());
+    Circuit extracted = zx_to_circuit(circuit_to_zx(circ));
+    CHECK(test_unitary_comparison(circ, extracted));
+  }
+  GIVEN("A simplified diagram") {
+    Circuit circ = clifford_t_circuit();
+    ZXDiagram diag = circuit_to_zx(circ);
+    Rewrite::to_graphlike_form().apply(diag);
+    Rewrite::reduce_graphlike_form().apply(diag);
+    Circuit extracted = zx_to_circuit(diag);
+    CHECK(test_unitary_comparison(circ, extracted));
+  }
+  GIVEN("Unsupported circuits") {
+    Circuit circ(3);
+    circ.add_op<unsigned>(OpType::CCX, {0, 1, 2});
+    REQUIRE_THROWS_AS(circuit_to_zx(circ), Unsupported);
+    Circuit measured(1, 1);
+    measured.add_measure(0, 0);
+    REQUIRE_THROWS_AS(circuit_to_zx(measured), Unsupported);
+  }
+  GIVEN("A diagram with more inputs than outputs") {
+    ZXDiagram diag(2, 1, 0, 0);
+    ZXVertVec ins = diag.get_boundary(ZXType::Input);
+    ZXVertVec outs = diag.get_boundary(ZXType::Output);
+    ZXVert z = diag.add_vertex(ZXType::ZSpider);
+    diag.add_wire(ins[0], z);
+    diag.add_wire(ins[1], z);
+    diag.add_wire(z, outs[0]);
+    REQUIRE_THROWS_AS(zx_to_circuit(diag), ZXError);
+  }
+}
+
+SCENARIO("Optimising circuits through the ZX-calculus") {
+  Circuit circ = clifford_t_circuit();
+  CompilationUnit cu(circ);
+  REQUIRE(ZXGraphlikeOptimisation()->apply(cu));
+  const Circuit& result = cu.get_circ_ref();
+  CHECK(result.all_qubits() == circ.all_qubits());
+  CHECK(test_unitary_comparison(circ, result));
+  OpTypeSet out_gates = {
+      OpType::Rz, OpType::H, OpType::CX, OpType::CZ, OpType::SWAP};
+  CHECK(GateSetPredicate(out_gates).verify(result));
+
+  GIVEN("A serialised pass") {
+    nlohmann::json j = ZXGraphlikeOptimisation();
+    PassPtr loaded = j.get<PassPtr>();
+    CompilationUnit cu2(circ);
+    REQUIRE(loaded->apply(cu2));
+    CHECK(cu2.get_circ_ref() == result);
+  }
+}
+
+}  // namespace test_ZXExtraction
+}  // namespace zx
+}  // namespace tket
@@ -14,6 +14,8 @@
 
 #include <catch2/catch.hpp>
 
+#include "Utils/Parallel.hpp"
+#include "ZX/CompactZXGraph.hpp"
 #include "ZX/Rewrite.hpp"
 
 namespace tket {
@@ -111,6 +113,115 @@ SCENARIO("Testing graph state simplification") {
   CHECK_FALSE(Rewrite::parallel_h_removal().apply(diag1));
 }
 
+SCENARIO("Graph-like simplification on the compact representation") {
+  ZXDiagram diag(2, 2, 0, 0);
+  ZXVertVec ins = diag.get_boundary(ZXType::Input);
+  ZXVertVec outs = diag.get_boundary(ZXType::Output);
+  ZXVert s1 = diag.add_vertex(ZXType::ZSpider);
+  ZXVert s2 = diag.add_vertex(ZXType::ZSpider);
+  ZXVert s3 = diag.add_vertex(ZXType::ZSpider, 0.5);
+  diag.add_wire(ins[0], s1);
+  diag.add_wire(ins[1], s2);
+  diag.add_wire(s1, outs[0]);
+  diag.add_wire(s2, outs[1]);
+  diag.add_wire(s1, s3, ZXWireType::H);
+  diag.add_wire(s2, s3, ZXWireType::H);
+  REQUIRE(CompactZXGraph::is_graph_like(diag));
+
+  GIVEN("The neighbour ranges") {
+    WireVec range_wires;
+    for (const Wire& w : diag.adj_wires_range(s1)) range_wires.push_back(w);
+    CHECK(range_wires == diag.adj_wires(s1));
+    ZXVertVec range_verts;
+    for (const ZXVert& v : diag.neighbours_range(s3)) range_verts.push_back(v);
+    CHECK(range_verts == diag.neighbours(s3));
+  }
+  GIVEN("Removing an interior proper Clifford") {
+    CHECK(Rewrite::remove_interior_cliffords().apply(diag));
+    REQUIRE_NOTHROW(diag.check_validity());
+    CHECK(diag.n_vertices() == 6);
+    std::optional<Wire> w = diag.wire_between(s1, s2);
+    REQUIRE(w);
+    CHECK(diag.get_wire_type(*w) == ZXWireType::H);
+    CHECK(diag.is_proper_clifford_spider(s1));
+    CHECK(diag.is_proper_clifford_spider(s2));
+    CHECK(CompactZXGraph::is_graph_like(diag));
+  }
+  GIVEN("A diagram which is not graph-like") {
+    diag.add_wire(s1, s2, ZXWireType::Basic);
+    CHECK_FALSE(CompactZXGraph::is_graph_like(diag));
+    REQUIRE_THROWS_AS(CompactZXGraph(diag), ZXError);
+  }
+}
+
+SCENARIO("Complementing neighbourhoods of a compact graph") {
+  ZXDiagram diag(0, 0, 0, 0);
+  ZXVert a = diag.add_vertex(ZXType::ZSpider);
+  ZXVert b = diag.add_vertex(ZXType::ZSpider);
+  ZXVert c = diag.add_vertex(ZXType::ZSpider, QuantumType::Classical);
+  ZXVert d = diag.add_vertex(ZXType::ZSpider, QuantumType::Classical);
+  diag.add_wire(a, b, ZXWireType::H);
+  CompactZXGraph g(diag);
+  std::vector<unsigned> all = {0, 1, 2, 3};
+  g.complement(all, QuantumType::Quantum);
+  CHECK_FALSE(g.edge_exists(0, 1));
+  CHECK(g.edge_exists(0, 2));
+  CHECK(g.edge_exists(1, 3));
+  // Classical pairs are left alone under a Quantum complementation
+  CHECK_FALSE(g.edge_exists(2, 3));
+  g.complement_bipartite({0, 1}, {2, 3}, QuantumType::Quantum);
+  CHECK(g.neighbours(2).empty());
+  CHECK(g.neighbours(0).empty());
+  g.apply_to(diag);
+  REQUIRE_NOTHROW(diag.check_validity());
+  CHECK(diag.n_wires() == 0);
+  CHECK(diag.neighbours(c).empty());
+  CHECK(diag.neighbours(d).empty());
+}
+
+// A wire through a chain of `n` interior spiders with alternating phases
+static ZXDiagram clifford_chain(unsigned n) {
+  ZXDiagram diag(1, 1, 0, 0);
+  ZXVert in = diag.get_boundary(ZXType::Input).at(0);
+  ZXVert out = diag.get_boundary(ZXType::Output).at(0);
+  ZXVert first = diag.add_vertex(ZXType::ZSpider);
+  ZXVert last = diag.add_vertex(ZXType::ZSpider);
+  diag.add_wire(in, first);
+  diag.add_wire(last, out);
+  ZXVert prev = first;
+  for (unsigned i = 0; i < n; ++i) {
+    ZXVert v = diag.add_vertex(ZXType::ZSpider, (i % 2) ? 0.5 : 1.5);
+    diag.add_wire(prev, v, ZXWireType::H);
+    prev = v;
+  }
+  diag.add_wire(prev, last, ZXWireType::H);
+  return diag;
+}
+
+SCENARIO("Graph-like simplification in parallel rounds") {
+  GIVEN("A long chain of interior proper Cliffords") {
+    ZXDiagram diag = clifford_chain(1000);
+    REQUIRE(CompactZXGraph::is_graph_like(diag));
+    CHECK(Rewrite::remove_interior_cliffords().apply(diag));
+    REQUIRE_NOTHROW(diag.check_validity());
+    CHECK(CompactZXGraph::is_graph_like(diag));
+    CHECK(diag.n_vertices() == 4);
+    CHECK_FALSE(Rewrite::remove_interior_cliffords().apply(diag));
+  }
+  GIVEN("The same simplification on one thread") {
+    ZXDiagram parallel = clifford_chain(1000);
+    ZXDiagram serial = clifford_chain(1000);
+    Rewrite::reduce_graphlike_form().apply(parallel);
+    unsigned max_threads = get_max_threads();
+    set_max_threads(1);
+    Rewrite::reduce_graphlike_form().apply(serial);
+    set_max_threads(max_threads);
+    CHECK(parallel.n_vertices() == serial.n_vertices());
+    CHECK(parallel.n_wires() == serial.n_wires());
+    CHECK(parallel.to_graphviz_str() == serial.to_graphviz_str());
+  }
+}
+
 }  // namespace test_ZXSimp
 }  // namespace zx
 }  // namespace tket
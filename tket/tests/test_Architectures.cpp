@@ -102,6 +102,86 @@ SCENARIO("Testing SquareGrid") {
   }
 }
 
+static void check_lines(
+    const Architecture &arch, const std::vector<node_vector_t> &lines,
+    const std::vector<unsigned> &lengths) {
+  REQUIRE(lines.size() == lengths.size());
+  node_set_t used;
+  for (unsigned i = 0; i < lines.size(); i++) {
+    CHECK(lines[i].size() == lengths[i]);
+    for (unsigned j = 0; j < lines[i].size(); j++) {
+      CHECK(used.insert(lines[i][j]).second);
+      if (j > 0) {
+        CHECK(
+            (arch.edge_exists(lines[i][j - 1], lines[i][j]) ||
+             arch.edge_exists(lines[i][j], lines[i][j - 1])));
+      }
+    }
+  }
+}
+
+SCENARIO("Testing lattice architectures") {
+  GIVEN("A heavy-hex lattice") {
+    HeavyHexLattice arch(7, 15);
+    // Bridges at columns 0, 4, 8, 12 below even rows and 2, 6, 10, 14 below
+    // odd rows
+    CHECK(arch.n_nodes() == 7 * 15 + 6 * 4);
+    CHECK(arch.n_connections() == 7 * 14 + 6 * 4 * 2);
+    for (const Node &n : arch.nodes()) {
+      unsigned degree = arch.get_degree(n);
+      CHECK(degree >= 1);
+      CHECK(degree <= 3);
+    }
+    CHECK(
+        arch.get_distance(
+            Node("heavyHexNode", 0, 0), Node("heavyHexNode", 2, 0)) == 2);
+    CHECK(
+        arch.get_distance(
+            Node("heavyHexNode", 0, 1), Node("heavyHexNode", 2, 3)) == 6);
+  }
+  GIVEN("A heavy-square lattice") {
+    HeavySquareLattice arch(3, 4);
+    CHECK(arch.n_nodes() == 3 * 4 + 3 * 3 + 2 * 4);
+    CHECK(arch.get_degree(Node("heavySquareNode", 2, 2)) == 4);
+    CHECK(arch.get_degree(Node("heavySquareNode", 2, 3)) == 2);
+    CHECK(
+        arch.get_distance(
+            Node("heavySquareNode", 0, 0), Node("heavySquareNode", 4, 6)) ==
+        10);
+  }
+  GIVEN("A Sycamore-style lattice") {
+    SycamoreLattice arch(6, 5);
+    CHECK(arch.n_nodes() == 30);
+    CHECK(arch.get_degree(Node("sycamoreNode", 2, 2)) == 4);
+    CHECK(arch.edge_exists(
+        Node("sycamoreNode", 0, 1), Node("sycamoreNode", 1, 0)));
+    CHECK(arch.edge_exists(
+        Node("sycamoreNode", 1, 1), Node("sycamoreNode", 2, 2)));
+    CHECK_FALSE(arch.edge_exists(
+        Node("sycamoreNode", 0, 1), Node("sycamoreNode", 1, 2)));
+  }
+  GIVEN("Precomputed routing data") {
+    HeavyHexLattice arch(3, 9);
+    // The stored data agrees with an architecture built from the same edges
+    Architecture plain(arch.get_all_edges_vec());
+    CHECK(arch.get_articulation_points() == plain.get_articulation_points());
+    CHECK(arch.get_diameter() == plain.get_diameter());
+    std::vector<unsigned> lengths = {10, 6, 3, 1};
+    check_lines(arch, arch.get_lines(lengths), lengths);
+    WHEN("The architecture is modified") {
+      Node bridge("heavyHexNode", 1, 4);
+      arch.remove_node(bridge);
+      THEN("The data is recomputed") {
+        CHECK(arch.get_articulation_points().count(bridge) == 0);
+        plain.remove_node(bridge);
+        CHECK(
+            arch.get_articulation_points() == plain.get_articulation_points());
+        check_lines(arch, arch.get_lines({4, 2}), {4, 2});
+      }
+    }
+  }
+}
+
 SCENARIO("Diameters") {
   GIVEN("an empty architecture") {
     Architecture arc;
@@ -156,6 +236,46 @@ SCENARIO("connectivity") {
   }
 }
 
+SCENARIO("Sub-architectures") {
+  SquareGrid grid(3, 3);
+  std::vector<Node> nodes = grid.get_all_nodes_vec();
+  // Drop the centre, so that paths through it go round the edge, and a
+  // corner, so that its neighbours are further apart
+  const Node centre(nodes[4]);
+  const Node corner(nodes[0]);
+  std::vector<Node> sub_nodes;
+  for (const Node& node : nodes) {
+    if (node != centre && node != corner) sub_nodes.push_back(node);
+  }
+  // Repeated nodes are ignored and unknown ones added without edges
+  sub_nodes.push_back(sub_nodes.front());
+  sub_nodes.push_back(Node("extra", 0));
+
+  Architecture fresh = grid.create_subarch(sub_nodes);
+  grid.precompute_distances();
+  Architecture derived = grid.create_subarch(sub_nodes);
+  REQUIRE(fresh.n_nodes() == 8);
+  REQUIRE(fresh == derived);
+  REQUIRE(derived.get_all_edges_vec() == fresh.get_all_edges_vec());
+  REQUIRE(derived.n_connections() == 6);
+  std::vector<Node> all = derived.get_all_nodes_vec();
+  for (const Node& u : all) {
+    for (const Node& v : all) {
+      if (u == v) {
+        CHECK(derived.get_distance(u, v) == 0);
+      } else if (u == Node("extra", 0) || v == Node("extra", 0)) {
+        CHECK_THROWS_AS(
+            derived.get_distance(u, v), graphs::NodesNotConnected<Node>);
+      } else {
+        CHECK(derived.get_distance(u, v) == fresh.get_distance(u, v));
+      }
+    }
+  }
+  // Nodes next to the centre were two apart, and are now four apart
+  CHECK(grid.get_distance(nodes[1], nodes[7]) == 2);
+  CHECK(derived.get_distance(nodes[1], nodes[7]) == 4);
+}
+
 }  // namespace test_Architectures
 }  // namespace graphs
 }  // namespace tket
@@ -196,6 +196,33 @@ SCENARIO("Testing stabiliser based assertion") {
     CompilationUnit cu(circ);
     REQUIRE(DecomposeBoxes()->apply(cu));
   }
+  GIVEN("Stabilisers of a large GHZ state, sharing an ancilla") {
+    unsigned n = 40;
+    Circuit circ(n);
+    circ.add_op<unsigned>(OpType::H, {0});
+    for (unsigned i = 0; i + 1 < n; i++) {
+      circ.add_op<unsigned>(OpType::CX, {i, i + 1});
+    }
+    PauliStabiliserList stabilisers = {
+        {std::vector<Pauli>(n, Pauli::X), true}};
+    for (unsigned i = 0; i + 1 < n; i++) {
+      std::vector<Pauli> string(n, Pauli::I);
+      string[i] = string[i + 1] = Pauli::Z;
+      stabilisers.push_back({string, true});
+    }
+    StabiliserAssertionBox box(stabilisers);
+    qubit_vector_t qubits = circ.all_qubits();
+    circ.add_assertion(box, qubits);
+    circ.add_op<unsigned>(OpType::Z, {0});
+    circ.add_assertion(box, qubits, std::nullopt, "after Z");
+    // Both assertions use the same ancilla.
+    REQUIRE(circ.n_qubits() == n + 1);
+    REQUIRE(circ.contains_unit(Qubit(q_debug_ancilla_reg(), 0)));
+    REQUIRE(circ.n_bits() == 2 * n);
+    CompilationUnit cu(circ);
+    REQUIRE(DecomposeBoxes()->apply(cu));
+    REQUIRE(cu.get_circ_ref().count_gates(OpType::Reset) == 2 * n);
+  }
 
   GIVEN("Invalid input") {
     WHEN("Empty input") {
@@ -15,6 +15,7 @@
 #include <catch2/catch.hpp>
 
 #include "Clifford/CliffTableau.hpp"
+#include "Clifford/PackedCliffTableau.hpp"
 #include "Converters/Converters.hpp"
 
 namespace tket {
@@ -189,6 +190,58 @@ SCENARIO("Correct creation of Tableaus") {
   }
 }
 
+SCENARIO("Packed tableaus agree with unpacked ones") {
+  // Enough qubits to span more than one word per row
+  const unsigned n = 70;
+  CliffTableau tab(n);
+  PackedCliffTableau packed(n);
+  const std::vector<OpType> types = {OpType::H,  OpType::S,  OpType::Vdg,
+                                     OpType::Y,  OpType::CX, OpType::CZ,
+                                     OpType::CY, OpType::SWAP};
+  for (unsigned i = 0; i < 200; i++) {
+    const OpType type = types[i % types.size()];
+    const unsigned a = (7 * i) % n;
+    const unsigned b = (a + 1 + (13 * i) % (n - 1)) % n;
+    std::vector<unsigned> qbs = {a};
+    if (i % types.size() >= 4) qbs.push_back(b);
+    if (i % 3 == 0) {
+      tab.apply_gate_at_front(type, qbs);
+      packed.apply_gate_at_front(type, qbs);
+    } else {
+      tab.apply_gate_at_end(type, qbs);
+      packed.apply_gate_at_end(type, qbs);
+    }
+  }
+  REQUIRE(packed.to_tableau() == tab);
+
+  QubitPauliTensor pauli =
+      QubitPauliTensor(Qubit(q_default_reg(), 3), Pauli::X) *
+      QubitPauliTensor(Qubit(q_default_reg(), 40), Pauli::Y) *
+      QubitPauliTensor(Qubit(q_default_reg(), 66), Pauli::Z);
+  GIVEN("A PI/2 rotation at end") {
+    tab.apply_pauli_at_end(pauli, 1);
+    packed.apply_pauli_at_end(pauli, 1);
+    REQUIRE(packed.to_tableau() == tab);
+  }
+  GIVEN("A -PI/2 rotation at front") {
+    tab.apply_pauli_at_front(pauli, 3);
+    packed.apply_pauli_at_front(pauli, 3);
+    REQUIRE(packed.to_tableau() == tab);
+  }
+  GIVEN("A PI rotation at front with a negative coefficient") {
+    pauli.coeff = -1.;
+    tab.apply_pauli_at_front(pauli, 2);
+    packed.apply_pauli_at_front(pauli, 2);
+    REQUIRE(packed.to_tableau() == tab);
+  }
+  GIVEN("A round trip") {
+    REQUIRE(PackedCliffTableau(tab) == packed);
+    const Qubit q(q_default_reg(), 40);
+    REQUIRE(packed.get_zpauli(q) == tab.get_zpauli(q));
+    REQUIRE(packed.get_xpauli(q) == tab.get_xpauli(q));
+  }
+}
+
 SCENARIO("Error handling in Tableau generation") {
   GIVEN("Add a non-clifford gate at end") {
     CliffTableau tab(2);
@@ -217,6 +270,28 @@ SCENARIO("Synthesis of circuits from Tableaus") {
     CliffTableau res_tab = circuit_to_tableau(res);
     REQUIRE(res_tab == tab);
   }
+  GIVEN("A large random Clifford circuit") {
+    // Enough qubits to use the packed synthesis
+    const unsigned n = 100;
+    Circuit circ(n);
+    const std::vector<OpType> types = {OpType::H,  OpType::S, OpType::Vdg,
+                                       OpType::CX, OpType::Y, OpType::CZ};
+    for (unsigned i = 0; i < 2000; i++) {
+      const OpType type = types[i % types.size()];
+      const unsigned a = (7 * i) % n;
+      const unsigned b = (a + 1 + (13 * i) % (n - 1)) % n;
+      if (type == OpType::CX || type == OpType::CZ) {
+        circ.add_op<unsigned>(type, {a, b});
+      } else {
+        circ.add_op<unsigned>(type, {a});
+      }
+    }
+    CliffTableau tab = circuit_to_tableau(circ);
+    Circuit res = tableau_to_circuit(tab);
+    REQUIRE(circuit_to_tableau(res) == tab);
+    Circuit packed_res = tableau_to_circuit(PackedCliffTableau(tab));
+    REQUIRE(circuit_to_tableau(packed_res) == tab);
+  }
 }
 
 }  // namespace test_CliffTableau
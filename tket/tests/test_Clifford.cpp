@@ -372,6 +372,24 @@ SCENARIO("Test multiq clifford replacements") {
     REQUIRE(circ.count_gates(OpType::CX) == comp.count_gates(OpType::CX));
     REQUIRE(circ.count_gates(OpType::X) == comp.count_gates(OpType::X));
   }
+  GIVEN("Replacements on overlapping pairs of qubits") {
+    Circuit circ(4);
+    for (unsigned i = 0; i < 3; ++i) {
+      circ.add_op<unsigned>(OpType::CX, {i, i + 1});
+      circ.add_op<unsigned>(OpType::S, {i + 1});
+      circ.add_op<unsigned>(OpType::CX, {i, i + 1});
+    }
+    for (unsigned i = 3; i > 0; --i) {
+      circ.add_op<unsigned>(OpType::CX, {i - 1, i});
+      circ.add_op<unsigned>(OpType::S, {i});
+      circ.add_op<unsigned>(OpType::CX, {i - 1, i});
+    }
+    Circuit copy(circ);
+    REQUIRE(Transform::clifford_reduction().apply(circ));
+    REQUIRE(
+        circ.count_gates(OpType::CX) + circ.count_gates(OpType::ZZMax) < 12);
+    REQUIRE(test_unitary_comparison(circ, copy));
+  }
   GIVEN("Test that replacements will not break causal ordering") {
     Circuit circ(4);
     circ.add_op<unsigned>(OpType::CX, {0, 1});
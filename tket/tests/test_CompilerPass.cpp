@@ -14,18 +14,30 @@
 
 #include <algorithm>
 #include <catch2/catch.hpp>
+#include <filesystem>
+#include <sstream>
 
 #include "Circuit/Circuit.hpp"
+#include "Circuit/CircuitBinary.hpp"
+#include "CircuitsForTesting.hpp"
 #include "OpType/OpType.hpp"
 #include "OpType/OpTypeFunctions.hpp"
+#include "Predicates/CompilationCache.hpp"
 #include "Predicates/CompilationUnit.hpp"
+#include "Predicates/CompileServer.hpp"
+#include "Predicates/CompiledTemplate.hpp"
 #include "Predicates/CompilerPass.hpp"
+#include "Predicates/CostPrediction.hpp"
+#include "Predicates/PassCompiler.hpp"
 #include "Predicates/PassGenerators.hpp"
 #include "Predicates/PassLibrary.hpp"
+#include "Predicates/PassProfiler.hpp"
 #include "Routing/Placement.hpp"
 #include "Simulation/CircuitSimulator.hpp"
 #include "Simulation/ComparisonFunctions.hpp"
 #include "Transformations/ContextualReduction.hpp"
+#include "Utils/Cancellation.hpp"
+#include "Utils/Parallel.hpp"
 #include "testutil.hpp"
 namespace tket {
 namespace test_CompilerPass {
@@ -50,6 +62,18 @@ SCENARIO("Run some basic Compiler Passes") {
     PassPtr compass = std::make_shared<StandardPass>(
         ppm, Transform::id, pc, nlohmann::json{});
     WHEN("Run a basic pass") { REQUIRE(!compass->apply(cu)); }
+    WHEN("Run a failing pass in audit mode") {
+      Transform failing([](Circuit &c) -> bool {
+        c.add_op<unsigned>(OpType::CX, {0, 1});
+        throw std::runtime_error("Transformation failed");
+      });
+      PassPtr failing_pass = std::make_shared<StandardPass>(
+          ppm, failing, pc, nlohmann::json{});
+      REQUIRE_THROWS_AS(
+          failing_pass->apply(cu, SafetyMode::Audit), std::runtime_error);
+      // Recording stops however the pass exits
+      REQUIRE(!cu.get_circ_ref().is_recording_changes());
+    }
     // switch safety mode on
     PassPtr compass2 = std::make_shared<StandardPass>(
         ppm, Transform::id, pc, nlohmann::json{});
@@ -224,6 +248,8 @@ SCENARIO("Test making (mostly routing) passes using PassGenerators") {
     WHEN("Ran in safe mode") {
       REQUIRE(all_passes->apply(cu, SafetyMode::Audit));
       REQUIRE(cu.check_all_predicates());
+      // Changes are recorded only while auditing each pass
+      REQUIRE(!cu.get_circ_ref().is_recording_changes());
     }
     WHEN("Make incorrect sequence") {
       PassPtr bad_pass = cp_route >> SynthesiseTket();
@@ -680,6 +706,42 @@ SCENARIO("PeepholeOptimise2Q and FullPeepholeOptimise") {
     REQUIRE(FullPeepholeOptimise()->apply(cu));
     REQUIRE(test_unitary_comparison(circ, cu.get_circ_ref()));
   }
+  GIVEN("Circuits on which some stages are skipped") {
+    // The stages skipped would leave the circuit unchanged, so the result
+    // is that of the full sequence
+    Transform fixed =
+        Transform::synthesise_tket() >> Transform::two_qubit_squash() >>
+        Transform::clifford_simp() >> Transform::synthesise_tket() >>
+        Transform::three_qubit_squash() >> Transform::clifford_simp() >>
+        Transform::synthesise_tket();
+    std::vector<Circuit> circs;
+    Circuit disjoint(4);
+    disjoint.add_op<unsigned>(OpType::Rx, 0.3, {0});
+    disjoint.add_op<unsigned>(OpType::CX, {0, 1});
+    disjoint.add_op<unsigned>(OpType::CX, {2, 3});
+    disjoint.add_op<unsigned>(OpType::Ry, 0.7, {3});
+    circs.push_back(disjoint);
+    Circuit one_qubit(2);
+    one_qubit.add_op<unsigned>(OpType::H, {0});
+    one_qubit.add_op<unsigned>(OpType::Rz, 0.25, {0});
+    one_qubit.add_op<unsigned>(OpType::T, {1});
+    circs.push_back(one_qubit);
+    Circuit chain(3);
+    chain.add_op<unsigned>(OpType::CX, {0, 1});
+    chain.add_op<unsigned>(OpType::Rz, 0.1, {1});
+    chain.add_op<unsigned>(OpType::CX, {1, 2});
+    chain.add_op<unsigned>(OpType::Rx, 0.2, {2});
+    chain.add_op<unsigned>(OpType::CX, {0, 1});
+    circs.push_back(chain);
+    circs.push_back(CircuitsForTesting::get().uccsd);
+    for (const Circuit& c : circs) {
+      Circuit expected = c;
+      fixed.apply(expected);
+      CompilationUnit cu(c);
+      FullPeepholeOptimise()->apply(cu);
+      CHECK(cu.get_circ_ref() == expected);
+    }
+  }
 }
 
 SCENARIO("rebase and decompose PhasePolyBox test") {
@@ -819,6 +881,34 @@ SCENARIO("Test Pauli Graph Synthesis Pass") {
   REQUIRE(test_unitary_comparison(circ, cu.get_circ_ref()));
 }
 
+SCENARIO("Pauli Graph Synthesis does not depend on the number of threads") {
+  PassPtr graph_synth =
+      gen_synthesise_pauli_graph(PauliSynthStrat::Sets, CXConfigType::Tree);
+  const std::vector<std::pair<std::vector<Pauli>, double>> gadgets{
+      {{Pauli::Z, Pauli::Z, Pauli::Z, Pauli::Z}, 0.1},
+      {{Pauli::X, Pauli::X, Pauli::I, Pauli::I}, 0.2},
+      {{Pauli::Y, Pauli::Y, Pauli::Z, Pauli::Z}, 0.3},
+      {{Pauli::X, Pauli::Z, Pauli::X, Pauli::I}, 0.4},
+      {{Pauli::I, Pauli::Y, Pauli::X, Pauli::Z}, 0.5},
+      {{Pauli::Z, Pauli::I, Pauli::Y, Pauli::X}, 0.6},
+      {{Pauli::Y, Pauli::Z, Pauli::I, Pauli::Y}, 0.7}};
+  Circuit circ(4);
+  for (const auto &gadget : gadgets) {
+    circ.add_box(PauliExpBox(gadget.first, gadget.second), {0, 1, 2, 3});
+  }
+
+  CompilationUnit cu(circ);
+  graph_synth->apply(cu);
+  REQUIRE(test_unitary_comparison(circ, cu.get_circ_ref()));
+
+  const unsigned max_threads = get_max_threads();
+  set_max_threads(1);
+  CompilationUnit cu_sequential(circ);
+  graph_synth->apply(cu_sequential);
+  set_max_threads(max_threads);
+  REQUIRE(cu_sequential.get_circ_ref() == cu.get_circ_ref());
+}
+
 SCENARIO("Compose Pauli Graph synthesis Passes") {
   RingArch arc(10);
   PassPtr dir_pass = gen_directed_cx_routing_pass(arc);
@@ -871,6 +961,34 @@ SCENARIO("Commute measurements to the end of a circuit") {
     expected.add_op<unsigned>(OpType::Measure, {1, 1});
     REQUIRE(cu.get_circ_ref() == expected);
   }
+  GIVEN("Repeated measurements of a qubit") {
+    Circuit c(2, 3);
+    c.add_op<unsigned>(OpType::Measure, {0, 0});
+    c.add_op<unsigned>(OpType::CX, {0, 1});
+    c.add_op<unsigned>(OpType::Measure, {0, 1});
+    c.add_op<unsigned>(OpType::Rz, 0.3, {0});
+    c.add_op<unsigned>(OpType::Measure, {0, 2});
+    c.add_op<unsigned>(OpType::H, {1});
+    CompilationUnit cu(c);
+    REQUIRE(delay_pass->apply(cu));
+    REQUIRE(mid_meas_pred->verify(cu.get_circ_ref()));
+    Circuit expected(2, 3);
+    expected.add_op<unsigned>(OpType::CX, {0, 1});
+    expected.add_op<unsigned>(OpType::Rz, 0.3, {0});
+    expected.add_op<unsigned>(OpType::Measure, {0, 0});
+    expected.add_op<unsigned>(OpType::Measure, {0, 1});
+    expected.add_op<unsigned>(OpType::Measure, {0, 2});
+    expected.add_op<unsigned>(OpType::H, {1});
+    REQUIRE(cu.get_circ_ref() == expected);
+    REQUIRE_FALSE(delay_pass->apply(cu));
+  }
+  GIVEN("Measure blocked by a barrier") {
+    Circuit c(1, 1);
+    c.add_op<unsigned>(OpType::Measure, {0, 0});
+    c.add_barrier({0});
+    CompilationUnit cu(c);
+    REQUIRE_THROWS_AS(delay_pass->apply(cu), CircuitInvalidity);
+  }
   GIVEN("Measure blocked by quantum gate") {
     Circuit c(1, 1);
     c.add_op<unsigned>(OpType::Measure, {0, 0});
@@ -1045,5 +1163,559 @@ SCENARIO("ThreeQubitSquah") {
   }
 }
 
+SCENARIO("Profiling nested passes") {
+  Circuit c(2);
+  c.add_op<unsigned>(OpType::H, {0});
+  c.add_op<unsigned>(OpType::H, {0});
+  c.add_op<unsigned>(OpType::CX, {0, 1});
+  c.add_op<unsigned>(OpType::CX, {0, 1});
+  c.add_op<unsigned>(OpType::Rz, 0.3, {1});
+  CompilationUnit cu(c);
+  PassPtr repeat = std::make_shared<RepeatPass>(RemoveRedundancies());
+  PassPtr seq = std::make_shared<SequencePass>(
+      std::vector<PassPtr>{repeat, RemoveRedundancies()});
+  unsigned n_counter_calls = 0;
+  PassProfiler profiler(true, [&]() {
+    ++n_counter_calls;
+    return std::make_pair(std::uint64_t{n_counter_calls}, std::uint64_t{0});
+  });
+  REQUIRE(seq->apply(
+      cu, SafetyMode::Default, profiler.before_apply_callback(),
+      profiler.after_apply_callback()));
+
+  nlohmann::json profile = profiler.get_profile();
+  REQUIRE(profile.size() == 1);
+  const nlohmann::json& top = profile[0];
+  CHECK(top["pass_class"] == "SequencePass");
+  CHECK(top["gate_count_before"] == 5);
+  CHECK(top["gate_count_delta"] == -4);
+  CHECK(top["depth_delta"] == -4);
+  CHECK(top["wall_time_ms"].get<double>() >= 0.);
+  REQUIRE(top["children"].size() == 2);
+  const nlohmann::json& rep = top["children"][0];
+  CHECK(rep["pass_class"] == "RepeatPass");
+  // The first iteration removes everything, the second finds nothing
+  CHECK(rep["iterations"] == 2);
+  REQUIRE(rep["children"].size() == 2);
+  CHECK(rep["children"][0]["name"] == "RemoveRedundancies");
+  CHECK(rep["children"][0]["gate_count_delta"] == -4);
+  CHECK(rep["children"][1]["gate_count_delta"] == 0);
+  CHECK_FALSE(rep["children"][0].contains("children"));
+  CHECK(top["children"][1]["gate_count_delta"] == 0);
+  // Two counter calls per pass, including the 4 nested inside `top`
+  CHECK(top["allocations"] == 9);
+  CHECK(n_counter_calls == 10);
+
+  profiler.clear();
+  CHECK(profiler.get_profile().empty());
+}
+
+SCENARIO("Caching the results of passes") {
+  Circuit c(2);
+  c.add_op<unsigned>(OpType::H, {0});
+  c.add_op<unsigned>(OpType::CZ, {0, 1});
+  c.add_op<unsigned>(OpType::Rz, 0.3, {1});
+  CompilationCache cache(2);
+  CompilationUnit cu0(c);
+  REQUIRE(cache.apply(*SynthesiseTket(), cu0));
+  CHECK(cache.n_misses() == 1);
+  CHECK(cache.n_hits() == 0);
+  REQUIRE(cache.size() == 1);
+
+  CompilationUnit cu1(c);
+  REQUIRE(cache.apply(*SynthesiseTket(), cu1));
+  CHECK(cache.n_hits() == 1);
+  CHECK(cu1.get_circ_ref() == cu0.get_circ_ref());
+  // The postconditions of the pass are recorded as on a real application
+  PredicateCache::const_iterator found =
+      cu1.get_cache_ref().find(typeid(GateSetPredicate));
+  REQUIRE(found != cu1.get_cache_ref().end());
+  CHECK(found->second.second);
+
+  // A different pass on the same circuit is a different entry
+  CompilationUnit cu2(c);
+  cache.apply(*DecomposeBoxes(), cu2);
+  CompilationUnit cu3(c);
+  cache.apply(*RemoveRedundancies(), cu3);
+  CHECK(cache.n_misses() == 3);
+  // The least recently used entry has been evicted
+  CHECK(cache.size() == 2);
+  CompilationUnit cu4(c);
+  cache.apply(*SynthesiseTket(), cu4);
+  CHECK(cache.n_misses() == 4);
+
+  const std::string filename =
+      (std::filesystem::temp_directory_path() / "tket_compilation_cache.json")
+          .string();
+  cache.save(filename);
+  CompilationCache loaded(2);
+  loaded.load(filename);
+  std::filesystem::remove(filename);
+  REQUIRE(loaded.size() == 2);
+  CompilationUnit cu5(c);
+  REQUIRE(loaded.apply(*SynthesiseTket(), cu5));
+  CHECK(loaded.n_hits() == 1);
+  CHECK(cu5.get_circ_ref() == cu0.get_circ_ref());
+  REQUIRE_THROWS_AS(loaded.load(filename), std::runtime_error);
+
+  // Passes with unserializable parameters cannot be cached
+  PassPtr squash = gen_squash_pass(
+      {OpType::Rz, OpType::Rx},
+      [](const Expr&, const Expr&, const Expr&) { return Circuit(1); });
+  CompilationUnit cu6(c);
+  REQUIRE_THROWS_AS(cache.apply(*squash, cu6), std::logic_error);
+}
+
+SCENARIO("Compiling a stream of requests on a compile server") {
+  Circuit c(2);
+  c.add_op<unsigned>(OpType::H, {0});
+  c.add_op<unsigned>(OpType::CZ, {0, 1});
+  c.add_op<unsigned>(OpType::Rz, 0.3, {1});
+  CompilationUnit expected(c);
+  SynthesiseTket()->apply(expected);
+  const nlohmann::json pass_json = SynthesiseTket()->get_config();
+  CompileServer server(2);
+  REQUIRE(server.n_workers() == 2);
+
+  GIVEN("A circuit serialized as JSON") {
+    CompileRequest request{nlohmann::json(c).dump(), CircuitFormat::JSON,
+                           pass_json.dump()};
+    CompileResponse response = server.submit(request).get();
+    REQUIRE(response.error.empty());
+    CHECK(response.changed);
+    CHECK(
+        nlohmann::json::parse(response.circuit).get<Circuit>() ==
+        expected.get_circ_ref());
+    THEN("A repeated request reuses the pass and the result") {
+      request.pass = pass_json.dump(2);
+      CompileResponse again = server.compile(request);
+      CHECK(again.circuit == response.circuit);
+      CHECK(server.n_passes() == 1);
+      CHECK(server.get_cache().n_hits() == 1);
+    }
+  }
+  GIVEN("Circuits serialized in binary") {
+    std::ostringstream out;
+    write_circuit_binary(out, c);
+    std::vector<CompileRequest> requests(
+        5, {out.str(), CircuitFormat::Binary, pass_json.dump()});
+    std::vector<CompileResponse> responses = server.compile_all(requests);
+    REQUIRE(responses.size() == 5);
+    for (const CompileResponse& response : responses) {
+      REQUIRE(response.error.empty());
+      const std::string& data = response.circuit;
+      CHECK(
+          read_circuit_binary(data.data(), data.size()) ==
+          expected.get_circ_ref());
+    }
+    CHECK(server.get_cache().size() == 1);
+    CHECK(server.n_passes() == 1);
+  }
+  GIVEN("Invalid requests") {
+    CompileResponse bad_pass =
+        server.compile({nlohmann::json(c).dump(), CircuitFormat::JSON, "{}"});
+    CHECK_FALSE(bad_pass.error.empty());
+    CHECK(bad_pass.circuit.empty());
+    CompileResponse bad_circuit =
+        server
+            .submit({"not a circuit", CircuitFormat::Binary, pass_json.dump()})
+            .get();
+    CHECK_FALSE(bad_circuit.error.empty());
+  }
+}
+
+SCENARIO("Compiling a symbolic circuit once and binding it later") {
+  Sym a = SymEngine::symbol("alpha");
+  Sym b = SymEngine::symbol("beta");
+  Circuit circ(2);
+  circ.add_op<unsigned>(OpType::Rz, Expr(a), {0});
+  circ.add_op<unsigned>(OpType::CX, {0, 1});
+  circ.add_op<unsigned>(OpType::Rx, 2 * Expr(b) + 0.5, {1});
+  circ.add_op<unsigned>(OpType::CX, {0, 1});
+  CompiledTemplate tmpl(SynthesiseTket(), circ);
+  const Circuit& compiled = tmpl.get_compilation_unit().get_circ_ref();
+  CHECK(compiled.is_symbolic());
+  CHECK(tmpl.get_symbols().size() == 2);
+  REQUIRE(!tmpl.get_parameters().empty());
+  CHECK(tmpl.is_affine());
+
+  GIVEN("Values for all the symbols") {
+    symbol_map_t values{{a, 0.3}, {b, 0.7}};
+    Circuit bound = tmpl.bind(values);
+    CHECK(!bound.is_symbolic());
+    Circuit expected = circ;
+    expected.symbol_substitution(values);
+    REQUIRE(test_unitary_comparison(bound, expected));
+  }
+  GIVEN("Values making some rotations trivial") {
+    symbol_map_t values{{a, 0.}, {b, -0.25}};
+    Circuit bound = tmpl.bind(values);
+    CHECK(bound.n_gates() < compiled.n_gates());
+    Circuit expected = circ;
+    expected.symbol_substitution(values);
+    REQUIRE(test_unitary_comparison(bound, expected));
+  }
+  GIVEN("A missing value") {
+    REQUIRE_THROWS_AS(tmpl.bind({{a, 0.3}}), std::invalid_argument);
+  }
+  GIVEN("A non-affine parameter") {
+    Circuit c(1);
+    c.add_op<unsigned>(OpType::Rz, Expr(a) * Expr(a), {0});
+    CompiledTemplate sq(RemoveRedundancies(), c);
+    REQUIRE(sq.get_parameters().size() == 1);
+    CHECK(!sq.get_parameters()[0].affine);
+    CHECK(!sq.is_affine());
+  }
+}
+
+SCENARIO("Applying a pass to many compilation units in parallel") {
+  std::vector<Circuit> circs;
+  for (unsigned i = 0; i < 12; i++) {
+    Circuit circ(6);
+    for (unsigned j = 0; j < 4 + i; j++) {
+      circ.add_op<unsigned>(OpType::H, {j % 6});
+      circ.add_op<unsigned>(OpType::CX, {j % 6, (j * 5 + i + 1) % 6});
+      circ.add_op<unsigned>(OpType::Rz, 0.1 * j, {(j + i) % 6});
+    }
+    circs.push_back(circ);
+  }
+  GIVEN("An optimisation pass") {
+    std::vector<CompilationUnit> units(circs.begin(), circs.end());
+    std::vector<bool> changed = FullPeepholeOptimise()->apply_all(units);
+    REQUIRE(changed.size() == circs.size());
+    for (unsigned i = 0; i < circs.size(); i++) {
+      // The results are the same as when compiling the units one by one
+      CompilationUnit cu(circs[i]);
+      CHECK(FullPeepholeOptimise()->apply(cu) == changed[i]);
+      CHECK(cu.get_circ_ref() == units[i].get_circ_ref());
+    }
+  }
+  GIVEN("A routing pass sharing an architecture") {
+    SquareGrid grid(2, 3);
+    PassPtr pass = gen_default_mapping_pass(grid);
+    PredicatePtr routed = std::make_shared<ConnectivityPredicate>(grid);
+    std::vector<CompilationUnit> units;
+    for (const Circuit& circ : circs) {
+      units.emplace_back(circ, std::vector<PredicatePtr>{routed});
+    }
+    pass->apply_all(units);
+    for (const CompilationUnit& cu : units) {
+      CHECK(cu.check_all_predicates());
+    }
+  }
+}
+
+SCENARIO("Cancelling a compilation") {
+  Circuit circ(3);
+  circ.add_op<unsigned>(OpType::CX, {0, 1});
+  circ.add_op<unsigned>(OpType::H, {2});
+  circ.add_op<unsigned>(OpType::CX, {0, 1});
+  circ.add_op<unsigned>(OpType::CX, {1, 2});
+  GIVEN("A cancelled token") {
+    CancellationToken token;
+    token.cancel();
+    CancellationScope scope(token);
+    CompilationUnit cu(circ);
+    REQUIRE_THROWS_AS(
+        FullPeepholeOptimise()->apply(cu), CompilationCancelled);
+    CHECK(cu.get_circ_ref() == circ);
+  }
+  GIVEN("A deadline which has passed") {
+    CancellationScope scope(
+        CancellationToken::with_timeout(std::chrono::milliseconds(0)));
+    CompilationUnit cu(circ);
+    REQUIRE_THROWS_AS(
+        gen_default_mapping_pass(SquareGrid(2, 2))->apply(cu),
+        CompilationCancelled);
+    CHECK(cu.get_circ_ref() == circ);
+  }
+  GIVEN("A pass cancelled part of the way through") {
+    CancellationToken token;
+    CancellationScope scope(token);
+    // Each step half-rewrites the circuit, then cancels
+    Transform step([&](Circuit& c) {
+      c.add_op<unsigned>(OpType::X, {0});
+      token.cancel();
+      return true;
+    });
+    PassPtr cancelling = std::make_shared<StandardPass>(
+        PredicatePtrMap{}, Transform::repeat(step),
+        PostConditions{{}, {}, Guarantee::Preserve}, nlohmann::json{});
+    CompilationUnit cu(circ);
+    REQUIRE_THROWS_AS(
+        (RemoveRedundancies() >> cancelling)->apply(cu),
+        CompilationCancelled);
+    // The completed pass is kept and the cancelled one undone
+    Circuit expected(3);
+    expected.add_op<unsigned>(OpType::H, {2});
+    expected.add_op<unsigned>(OpType::CX, {1, 2});
+    CHECK(cu.get_circ_ref() == expected);
+  }
+  GIVEN("No token") {
+    CompilationUnit cu(circ);
+    CHECK(FullPeepholeOptimise()->apply(cu));
+  }
+}
+
+SCENARIO("Compiling independent regions in parallel") {
+  GIVEN("Blocks acting on disjoint qubits") {
+    Circuit circ(6);
+    for (unsigned i = 0; i < 3; i++) {
+      unsigned a = 2 * i, b = 2 * i + 1;
+      circ.add_op<unsigned>(OpType::H, {a});
+      circ.add_op<unsigned>(OpType::CX, {a, b});
+      circ.add_op<unsigned>(OpType::Rz, 0.3 * (i + 1), {b});
+      circ.add_op<unsigned>(OpType::CX, {b, a});
+      circ.add_op<unsigned>(OpType::CX, {a, b});
+      circ.add_op<unsigned>(OpType::Ry, 0.2, {a});
+    }
+    CompilationUnit cu(circ);
+    REQUIRE(gen_parallel_regions_pass(FullPeepholeOptimise())->apply(cu));
+    const Circuit& result = cu.get_circ_ref();
+    REQUIRE(test_unitary_comparison(circ, result));
+    // No gate acts across two blocks
+    for (const Command& com : result) {
+      qubit_vector_t qbs = com.get_qubits();
+      if (qbs.size() == 2) {
+        CHECK(qbs[0].index()[0] / 2 == qbs[1].index()[0] / 2);
+      }
+    }
+  }
+  GIVEN("Gates separated by a barrier") {
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::H, {1});
+    circ.add_barrier(std::vector<unsigned>{0, 1});
+    circ.add_op<unsigned>(OpType::H, {1});
+    CompilationUnit cu(circ);
+    REQUIRE(gen_parallel_regions_pass(RemoveRedundancies())->apply(cu));
+    // Only the gates on the same side of the barrier cancel
+    Circuit expected(2);
+    expected.add_op<unsigned>(OpType::H, {1});
+    expected.add_barrier(std::vector<unsigned>{0, 1});
+    expected.add_op<unsigned>(OpType::H, {1});
+    CHECK(cu.get_circ_ref() == expected);
+  }
+  GIVEN("Measurements and classical control") {
+    Circuit circ(3, 2);
+    circ.add_op<unsigned>(OpType::X, {0});
+    circ.add_op<unsigned>(OpType::X, {0});
+    circ.add_measure(0, 0);
+    circ.add_conditional_gate<unsigned>(OpType::Z, {}, {1}, {0}, 1);
+    circ.add_op<unsigned>(OpType::H, {2});
+    circ.add_op<unsigned>(OpType::H, {2});
+    circ.add_measure(2, 1);
+    CompilationUnit cu(circ);
+    REQUIRE(gen_parallel_regions_pass(RemoveRedundancies())->apply(cu));
+    const Circuit& result = cu.get_circ_ref();
+    CHECK(result.n_gates() == 3);
+    CHECK(result.count_gates(OpType::Conditional) == 1);
+    CHECK(result.count_gates(OpType::Measure) == 2);
+  }
+  GIVEN("Nothing to do") {
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::H, {1});
+    CompilationUnit cu(circ);
+    REQUIRE(!gen_parallel_regions_pass(RemoveRedundancies())->apply(cu));
+    CHECK(cu.get_circ_ref() == circ);
+  }
+  GIVEN("A pass renaming the qubits") {
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    CompilationUnit cu(circ);
+    PassPtr pp = gen_parallel_regions_pass(
+        gen_rename_qubits_pass({{Qubit(0), Qubit("a", 0)}}));
+    REQUIRE_THROWS_AS(pp->apply(cu), std::logic_error);
+  }
+}
+
+SCENARIO("Inspecting the changes made by passes in callbacks") {
+  Circuit circ(2);
+  circ.add_op<unsigned>(OpType::H, {0});
+  circ.add_op<unsigned>(OpType::H, {0});
+  circ.add_op<unsigned>(OpType::CX, {0, 1});
+  circ.add_op<unsigned>(OpType::Rz, 0.5, {1});
+  CompilationUnit cu(circ);
+  std::vector<std::pair<std::string, Circuit::ChangeLog>> logs;
+  PassCallback after_apply = [&](const CompilationUnit& c_unit,
+                                 const nlohmann::json& j) {
+    std::optional<Circuit::ChangeLog> changes = c_unit.get_changes();
+    REQUIRE(changes);
+    logs.push_back({j.at("pass_class").get<std::string>(), *changes});
+  };
+  PassPtr seq = std::make_shared<SequencePass>(
+      std::vector<PassPtr>{RemoveRedundancies(), RemoveRedundancies()});
+  GIVEN("No recording") { CHECK(!cu.get_changes()); }
+  GIVEN("Recording") {
+    cu.record_changes(true);
+    REQUIRE(seq->apply(cu, SafetyMode::Default, trivial_callback, after_apply));
+    REQUIRE(logs.size() == 3);
+    // The first pass removes the Hadamards
+    CHECK(logs[0].second.removed.size() == 2);
+    // The second finds nothing to do
+    CHECK(logs[1].second.empty());
+    // The sequence sees all its children's changes
+    CHECK(logs[2].first == "SequencePass");
+    CHECK(logs[2].second.removed.size() == 2);
+  }
+}
+
+SCENARIO("Sharing the circuit between copies of a compilation unit") {
+  Circuit circ(2);
+  circ.add_op<unsigned>(OpType::H, {0});
+  circ.add_op<unsigned>(OpType::H, {0});
+  circ.add_op<unsigned>(OpType::CX, {0, 1});
+  CompilationUnit cu(circ);
+  GIVEN("A copy that is not modified") {
+    CompilationUnit copy = cu;
+    CHECK(&copy.get_circ_ref() == &cu.get_circ_ref());
+    CompilationUnit assigned(Circuit(1));
+    assigned = cu;
+    CHECK(&assigned.get_circ_ref() == &cu.get_circ_ref());
+  }
+  GIVEN("A copy that is modified") {
+    CompilationUnit copy = cu;
+    REQUIRE(RemoveRedundancies()->apply(copy));
+    CHECK(&copy.get_circ_ref() != &cu.get_circ_ref());
+    CHECK(copy.get_circ_ref().n_gates() == 1);
+    CHECK(cu.get_circ_ref() == circ);
+    // The unit modified is the one copied
+    REQUIRE(RemoveRedundancies()->apply(cu));
+    CHECK(cu.get_circ_ref() == copy.get_circ_ref());
+  }
+  GIVEN("A unit recording its changes") {
+    cu.record_changes(true);
+    CompilationUnit copy = cu;
+    CHECK(&copy.get_circ_ref() != &cu.get_circ_ref());
+    CHECK(!copy.get_changes());
+    REQUIRE(RemoveRedundancies()->apply(cu));
+    CHECK(cu.get_changes()->removed.size() == 2);
+  }
+}
+
+SCENARIO("Compiling pass pipelines") {
+  Circuit circ(3);
+  circ.add_op<unsigned>(OpType::H, {0});
+  circ.add_op<unsigned>(OpType::CZ, {0, 1});
+  circ.add_op<unsigned>(OpType::Rz, 0.3, {1});
+  circ.add_op<unsigned>(OpType::Rz, -0.3, {1});
+  circ.add_op<unsigned>(OpType::CX, {1, 2});
+  circ.add_op<unsigned>(OpType::X, {2});
+  auto same_result = [&circ](const PassPtr& lhs, const PassPtr& rhs) {
+    CompilationUnit lhs_cu(circ);
+    CompilationUnit rhs_cu(circ);
+    lhs->apply(lhs_cu);
+    rhs->apply(rhs_cu);
+    return lhs_cu.get_circ_ref() == rhs_cu.get_circ_ref();
+  };
+  GIVEN("Repeated idempotent passes and a rebase onto a guaranteed set") {
+    PassPtr pipeline = (SynthesiseTket() >> RebaseTket()) >>
+                       (RemoveRedundancies() >> RemoveRedundancies());
+    PassPtr compiled = compile_pass(pipeline);
+    std::shared_ptr<SequencePass> seq =
+        std::dynamic_pointer_cast<SequencePass>(compiled);
+    REQUIRE(seq);
+    std::vector<PassPtr> expected{SynthesiseTket(), RemoveRedundancies()};
+    REQUIRE(seq->get_sequence() == expected);
+    REQUIRE(same_result(pipeline, compiled));
+  }
+  GIVEN("A pass run after repeating it") {
+    PassPtr commute = CommuteThroughMultis();
+    PassPtr pipeline = std::make_shared<RepeatPass>(
+                           std::make_shared<RepeatPass>(commute)) >>
+                       commute;
+    PassPtr compiled = compile_pass(pipeline);
+    std::shared_ptr<RepeatPass> repeat =
+        std::dynamic_pointer_cast<RepeatPass>(compiled);
+    REQUIRE(repeat);
+    REQUIRE(repeat->get_pass() == commute);
+    REQUIRE(same_result(pipeline, compiled));
+  }
+  GIVEN("A pipeline with no redundant stage") {
+    PassPtr pipeline =
+        DecomposeBoxes() >> RebaseTket() >> SquashTK1() >> SquashTK1();
+    REQUIRE(compile_pass(pipeline) == pipeline);
+    // The rebase is kept, as the circuit may not be in its gate set yet
+    PassPtr rebase = DecomposeBoxes() >> RebaseTket();
+    REQUIRE(compile_pass(rebase) == rebase);
+  }
+}
+
+SCENARIO("Estimating the cost of compiling circuits") {
+  GIVEN("A circuit with multi-qubit gates") {
+    Circuit circ(3, 1);
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::CZ, {1, 2});
+    circ.add_op<unsigned>(OpType::SWAP, {0, 1});
+    circ.add_op<unsigned>(OpType::ZZPhase, 0.3, {0, 2});
+    circ.add_op<unsigned>(OpType::Measure, {0, 0});
+    CircuitCostEstimate estimate = estimate_circuit_cost(circ);
+    CHECK(estimate.n_qubits == 3);
+    CHECK(estimate.n_gates == 5);
+    CHECK(estimate.n_cx == 7);
+    CHECK(estimate.n_interactions == 3);
+    CHECK(estimate.fits);
+    CHECK(estimate.n_swaps == 0);
+    WHEN("The architecture has too few nodes") {
+      Architecture arc({{0, 1}});
+      CHECK_FALSE(estimate_circuit_cost(circ, arc).fits);
+    }
+    WHEN("The architecture is a ring") {
+      RingArch arc(3);
+      estimate = estimate_circuit_cost(circ, arc);
+      CHECK(estimate.fits);
+      CHECK(estimate.n_swaps == 0);
+      CHECK(estimate.n_cx_routed() == 7);
+    }
+  }
+  GIVEN("A circuit already placed on a line") {
+    Architecture arc({{0, 1}, {1, 2}, {2, 3}});
+    Circuit circ;
+    for (unsigned i = 0; i < 4; i++) circ.add_qubit(Node(i));
+    circ.add_op<UnitID>(OpType::CX, {Node(0), Node(3)});
+    circ.add_op<UnitID>(OpType::CX, {Node(1), Node(2)});
+    CircuitCostEstimate estimate = estimate_circuit_cost(circ, arc);
+    CHECK(estimate.fits);
+    CHECK(estimate.n_swaps == 2);
+    CHECK(estimate.n_cx_routed() == 8);
+    WHEN("The architecture is not connected") {
+      Architecture split({{0, 1}, {2, 3}});
+      CHECK_FALSE(estimate_circuit_cost(circ, split).fits);
+    }
+  }
+  GIVEN("Profiles of passes") {
+    Circuit c(2);
+    c.add_op<unsigned>(OpType::H, {0});
+    c.add_op<unsigned>(OpType::H, {0});
+    c.add_op<unsigned>(OpType::CX, {0, 1});
+    CompilationUnit cu(c);
+    PassPtr repeat = std::make_shared<RepeatPass>(RemoveRedundancies());
+    PassPtr seq = std::make_shared<SequencePass>(
+        std::vector<PassPtr>{repeat, RemoveRedundancies()});
+    PassProfiler profiler;
+    REQUIRE(seq->apply(
+        cu, SafetyMode::Default, profiler.before_apply_callback(),
+        profiler.after_apply_callback()));
+    CompileTimeModel model;
+    model.add_profile(profiler.get_profile());
+    // The sequence, the repeat, two iterations of its body and the last pass
+    CHECK(model.n_records() == 5);
+    std::optional<double> ms = model.estimate_ms("RemoveRedundancies", 100);
+    REQUIRE(ms);
+    CHECK(*ms >= 0.);
+    CHECK_FALSE(model.estimate_ms("SynthesiseTket", 100));
+    std::vector<std::pair<std::string, double>> estimates =
+        model.estimate_ms(*seq, 100);
+    REQUIRE(estimates.size() == 2);
+    CHECK(estimates[0].first == "RemoveRedundancies");
+    CHECK(estimates[1].first == "RemoveRedundancies");
+    CHECK(model.estimate_ms(*SynthesiseTket(), 100).empty());
+    model.clear();
+    CHECK(model.n_records() == 0);
+  }
+}
+
 }  // namespace test_CompilerPass
 }  // namespace tket
@@ -266,6 +266,46 @@ SCENARIO("Create and Discard operations") {
     c.qubit_discard(Qubit(0));
     REQUIRE(!Transform::simplify_measured().apply(c));
   }
+  GIVEN("A long chain of classical maps before discarded measures") {
+    // Each CX only becomes removable once every later gate has been moved
+    // through the measures.
+    unsigned n = 6, depth = 50;
+    Circuit c(n, n);
+    for (unsigned q = 0; q < n; q++) {
+      c.add_op<unsigned>(OpType::H, {q});
+    }
+    for (unsigned d = 0; d < depth; d++) {
+      unsigned q = d % (n - 1);
+      c.add_op<unsigned>(OpType::CX, {q, q + 1});
+      c.add_op<unsigned>(OpType::X, {q});
+    }
+    for (unsigned q = 0; q < n; q++) {
+      c.add_op<unsigned>(OpType::Measure, {q, q});
+    }
+    c.qubit_discard_all();
+    REQUIRE(Transform::simplify_measured().apply(c));
+    REQUIRE(c.count_gates(OpType::H) == n);
+    REQUIRE(c.count_gates(OpType::CX) == 0);
+    REQUIRE(c.count_gates(OpType::X) == 0);
+    REQUIRE(c.count_gates(OpType::Measure) == n);
+  }
+  GIVEN("A long chain of gates on known basis states") {
+    unsigned n = 4, depth = 100;
+    Circuit c(n);
+    c.qubit_create_all();
+    for (unsigned d = 0; d < depth; d++) {
+      unsigned q = d % n;
+      c.add_op<unsigned>(OpType::X, {q});
+      c.add_op<unsigned>(OpType::CX, {q, (q + 1) % n});
+      c.add_op<unsigned>(OpType::CCX, {q, (q + 1) % n, (q + 2) % n});
+    }
+    c.add_op<unsigned>(OpType::H, {0});
+    c.add_op<unsigned>(OpType::CX, {0, 1});
+    REQUIRE(Transform::simplify_initial().apply(c));
+    REQUIRE(c.count_gates(OpType::CCX) == 0);
+    REQUIRE(c.count_gates(OpType::H) == 1);
+    REQUIRE(c.count_gates(OpType::CX) == 1);
+  }
   GIVEN("A circuit with a measurement on a known basis state") {
     Circuit c(2, 1);
     c.qubit_create(Qubit(0));
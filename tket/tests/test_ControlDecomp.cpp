@@ -15,6 +15,7 @@
 #include <catch2/catch.hpp>
 #include <numeric>
 
+#include "Circuit/Boxes.hpp"
 #include "Circuit/CircPool.hpp"
 #include "Simulation/CircuitSimulator.hpp"
 #include "Simulation/ComparisonFunctions.hpp"
@@ -385,5 +386,76 @@ SCENARIO("Test a CnX is decomposed correctly when bootstrapped") {
   }
 }
 
+SCENARIO("Test a CnX is decomposed correctly using ancillae") {
+  GIVEN("CnX unitaries for 3 to 5 controls") {
+    for (unsigned n = 3; n < 6; ++n) {
+      // controls 0..n-1, target n, ancillae n+1..2n-2, qubit 0 most
+      // significant
+      const unsigned n_qbs = 2 * n - 1;
+      const unsigned size = 1u << n_qbs;
+      const unsigned controls = ((1u << n) - 1) << (n_qbs - n);
+      const unsigned target = 1u << (n_qbs - n - 1);
+      const unsigned ancillae = target - 1;
+      Eigen::MatrixXcd correct = Eigen::MatrixXcd::Zero(size, size);
+      for (unsigned i = 0; i < size; ++i) {
+        unsigned j = (i & controls) == controls ? i ^ target : i;
+        correct(j, i) = 1;
+      }
+      Circuit dirty = Transform::cnx_dirty_ancilla_decomp(n);
+      REQUIRE(dirty.count_gates(OpType::CCX) == 4 * (n - 2));
+      REQUIRE(tket_sim::get_unitary(dirty).isApprox(correct, ERR_EPS));
+      Circuit clean = Transform::cnx_clean_ancilla_decomp(n);
+      REQUIRE(clean.count_gates(OpType::CCX) == 2 * n - 3);
+      const Eigen::MatrixXcd u = tket_sim::get_unitary(clean);
+      for (unsigned i = 0; i < size; ++i) {
+        if ((i & ancillae) != 0) continue;
+        CHECK(u.col(i).isApprox(correct.col(i), ERR_EPS));
+      }
+    }
+  }
+  GIVEN("A circuit with idle qubits") {
+    for (unsigned n_idle = 0; n_idle < 4; ++n_idle) {
+      Circuit circ(5 + n_idle);
+      circ.add_op<unsigned>(OpType::H, {0});
+      for (unsigned i = 0; i < n_idle; ++i) {
+        circ.add_op<unsigned>(OpType::Ry, 0.3, {5 + i});
+      }
+      circ.add_op<unsigned>(OpType::CnX, {0, 1, 2, 3, 4});
+      for (unsigned i = 0; i < n_idle; ++i) {
+        circ.add_op<unsigned>(OpType::CX, {4, 5 + i});
+      }
+      const Eigen::MatrixXcd u = tket_sim::get_unitary(circ);
+      REQUIRE(Transform::decomp_CnX_with_ancillas().apply(circ));
+      REQUIRE(circ.count_gates(OpType::CnX) == 0);
+      Transform::decomp_CCX().apply(circ);
+      REQUIRE(tket_sim::get_unitary(circ).isApprox(u, ERR_EPS));
+    }
+  }
+  GIVEN("A circuit with created qubits") {
+    Circuit circ(9);
+    circ.add_op<unsigned>(OpType::CnX, {0, 1, 2, 3, 4, 5});
+    for (unsigned i = 6; i < 9; ++i) circ.qubit_create(Qubit(i));
+    REQUIRE(Transform::decomp_CnX_with_ancillas().apply(circ));
+    // a log-depth tree
+    REQUIRE(circ.count_gates(OpType::CCX) == 7);
+    REQUIRE(circ.depth() == 5);
+  }
+  GIVEN("A QControlBox") {
+    QControlBox qcbox(get_op_ptr(OpType::Rx, 0.4), 5);
+    Circuit circ(9);
+    circ.add_box(qcbox, {0, 1, 2, 3, 4, 5});
+    circ.add_op<unsigned>(OpType::CX, {5, 6});
+    Circuit expected = circ;
+    expected.decompose_boxes();
+    const Eigen::MatrixXcd u = tket_sim::get_unitary(expected);
+    REQUIRE(Transform::decomp_arbitrary_controlled_gates(true).apply(circ));
+    for (OpType type : {OpType::QControlBox, OpType::CnX, OpType::CnRy,
+                        OpType::CCX}) {
+      REQUIRE(circ.count_gates(type) == 0);
+    }
+    REQUIRE(tket_sim::get_unitary(circ).isApprox(u, ERR_EPS));
+  }
+}
+
 }  // namespace test_ControlDecomp
 }  // namespace tket
@@ -15,6 +15,7 @@
 #include <catch2/catch.hpp>
 
 #include "Characterisation/DeviceCharacterisation.hpp"
+#include "Characterisation/ErrorTables.hpp"
 #include "OpType/OpDesc.hpp"
 
 namespace tket {
@@ -53,6 +54,77 @@ SCENARIO("Does Device correctly hold and return error information") {
     double cx_info = cx_info_ge;
     REQUIRE(cx_info == 0.2);
   }
+  GIVEN("Errors varying across the device") {
+    Node n0{0}, n1{1}, n2{2};
+    op_node_errors_t ne{
+        {n0, {{OpType::X, 0.1}}}, {n1, {{OpType::X, 0.3}}}, {n2, {}}};
+    op_link_errors_t le{
+        {{n0, n1}, {{OpType::CX, 0.2}}}, {{n1, n2}, {{OpType::CX, 0.4}}}};
+    DeviceCharacterisation characterisation(ne, le);
+    // n2 has no X error given, so counts as 0.
+    REQUIRE(
+        characterisation.get_average_error(OpType::X, 1) ==
+        Approx(0.4 / 3));
+    REQUIRE(characterisation.get_average_error(OpType::CX, 2) == Approx(0.3));
+    REQUIRE(characterisation.get_average_error(OpType::CZ, 2) == 0.);
+    REQUIRE(
+        DeviceCharacterisation().get_average_error(OpType::X, 1) == 0.);
+  }
+}
+
+SCENARIO("Compiling errors into tables") {
+  Node n0{0}, n1{1}, n2{2}, n3{3};
+  op_node_errors_t ne{
+      {n0, {{OpType::X, 0.1}, {OpType::H, 0.05}}},
+      {n1, {{OpType::X, 0.2}}},
+      {n2, {}}};
+  op_link_errors_t le{
+      {{n0, n1}, {{OpType::CX, 0.02}}},
+      {{n1, n0}, {{OpType::CX, 0.03}, {OpType::CZ, 0.01}}},
+      {{n2, n3}, {{OpType::CZ, 0.04}}}};
+  avg_readout_errors_t re{{n0, 0.1}, {n1, 0.2}, {n2, 0.3}};
+  DeviceCharacterisation dc(ne, le, re);
+  DeviceErrorTables tables(dc);
+  GIVEN("Lookups by index") {
+    REQUIRE(tables.n_nodes() == 4);
+    REQUIRE(tables.n_links() == 3);
+    REQUIRE(tables.node_index(Node(7)) == DeviceErrorTables::none);
+    for (unsigned i = 0; i < tables.n_nodes(); i++) {
+      const Node& n = tables.node(i);
+      REQUIRE(tables.node_index(n) == i);
+      CHECK(tables.node_error(i) == dc.get_error(n));
+      CHECK(tables.readout_error(i) == dc.get_readout_error(n));
+      for (OpType op : {OpType::X, OpType::H, OpType::Y, OpType::CZ}) {
+        CHECK(tables.node_error(i, op) == dc.get_error(n, op));
+      }
+    }
+    for (unsigned l = 0; l < tables.n_links(); l++) {
+      const auto& [i0, i1] = tables.link(l);
+      REQUIRE(tables.link_index(i0, i1) == l);
+      Architecture::Connection link{tables.node(i0), tables.node(i1)};
+      CHECK(tables.link_error(l) == dc.get_error(link));
+      for (OpType op : {OpType::CX, OpType::CZ, OpType::X}) {
+        CHECK(tables.link_error(l, op) == dc.get_error(link, op));
+      }
+    }
+    REQUIRE(
+        tables.link_index(tables.node_index(n1), tables.node_index(n2)) ==
+        DeviceErrorTables::none);
+  }
+  GIVEN("A circuit on the nodes") {
+    Circuit circ;
+    for (const Node& n : {n0, n1, n2, n3}) circ.add_qubit(n);
+    circ.add_bit(Bit(0));
+    circ.add_op<UnitID>(OpType::X, {n0});
+    circ.add_op<UnitID>(OpType::H, {n1});
+    circ.add_op<UnitID>(OpType::CX, {n1, n0});
+    circ.add_op<UnitID>(OpType::CZ, {n2, n3});
+    circ.add_op<UnitID>(OpType::CZ, {n1, n2});
+    circ.add_barrier({n0, n1});
+    circ.add_op<UnitID>(OpType::Measure, {n2, Bit(0)});
+    const double expected = 0.9 * 1. * 0.97 * 0.96 * 1. * 0.7;
+    REQUIRE(tables.estimate_fidelity(circ) == Approx(expected));
+  }
 }
 
 }  // namespace test_DeviceCharacterisation
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <catch2/catch.hpp>
+#include <set>
 
 #include "Characterisation/FrameRandomisation.hpp"
 #include "Transformations/Transform.hpp"
@@ -99,6 +100,42 @@ SCENARIO(
     std::vector<Cycle> cycles = fr_tester.get_cycles(circ);
     REQUIRE(cycles.size() == 50);
   }
+  GIVEN("A wide circuit with interleaved non-cycle gates.") {
+    const unsigned n = 12;
+    Circuit circ(n);
+    unsigned n_cycle_gates = 0;
+    for (unsigned layer = 0; layer < 20; layer++) {
+      for (unsigned q = layer % 2; q + 1 < n; q += 2) {
+        circ.add_op<unsigned>(OpType::CX, {q, q + 1});
+        n_cycle_gates++;
+      }
+      for (unsigned q = 0; q < n; q++) {
+        if ((q + layer) % 3 == 0) {
+          circ.add_op<unsigned>(OpType::T, {q});
+        } else {
+          circ.add_op<unsigned>(OpType::H, {q});
+          n_cycle_gates++;
+        }
+      }
+    }
+    std::vector<Cycle> cycles = fr_tester.get_cycles(circ);
+    // Every cycle gate is in exactly one cycle
+    unsigned n_coms = 0;
+    for (const Cycle& cycle : cycles) {
+      REQUIRE(cycle.size() <= n);
+      for (const CycleCom& com : cycle.coms_) {
+        if (com.type == OpType::Input) continue;
+        n_coms++;
+        for (unsigned index : com.indices) REQUIRE(index < cycle.size());
+      }
+    }
+    REQUIRE(n_coms == n_cycle_gates);
+    PauliFrameRandomisation pfr;
+    for (const Circuit& sample :
+         pfr.sample_randomisation_circuits(circ, 3, 1)) {
+      REQUIRE(test_unitary_comparison(circ, sample, true));
+    }
+  }
 }
 
 SCENARIO("Test that get_out_frame returns the expected result.") {
@@ -357,5 +394,93 @@ SCENARIO(
   }
 }
 
+SCENARIO("Test sampling frames from a FrameRandomisation template.") {
+  GIVEN("A two-qubit circuit with PauliFrameRandomisation.") {
+    PauliFrameRandomisation pfr;
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::T, {1});
+    circ.add_op<unsigned>(OpType::CX, {1, 0});
+    std::shared_ptr<const FrameRandomisation::FrameTemplate> frame_template =
+        pfr.make_template(circ);
+    REQUIRE(frame_template->cycles.size() == 2);
+    const std::vector<FrameRandomisation::FrameSample> samples =
+        pfr.sample_frames(*frame_template, 40, 7);
+    REQUIRE(samples.size() == 40);
+    // Samples are reproducible from the seed
+    const std::vector<FrameRandomisation::FrameSample> again =
+        pfr.sample_frames(*frame_template, 40, 7);
+    const std::vector<Circuit> circuits =
+        pfr.materialise(*frame_template, samples);
+    REQUIRE(circuits.size() == 40);
+    for (unsigned i = 0; i < samples.size(); i++) {
+      CHECK(samples[i].frame_ops == again[i].frame_ops);
+      REQUIRE(samples[i].frame_ops.size() == 8);
+      // Materialising does not modify the template
+      CHECK(frame_template->circuit.count_gates(OpType::noop) == 8);
+      CHECK(circuits[i].n_gates() == frame_template->circuit.n_gates());
+      CHECK(test_unitary_comparison(circ, circuits[i], true));
+    }
+  }
+  GIVEN("A circuit with Rz gates and UniversalFrameRandomisation.") {
+    UniversalFrameRandomisation ufr;
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::Rz, 0.2, {0});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::Rz, 0.3, {1});
+    std::shared_ptr<const FrameRandomisation::FrameTemplate> frame_template =
+        ufr.make_template(circ);
+    const std::vector<FrameRandomisation::FrameSample> samples =
+        ufr.sample_frames(*frame_template, 20, 3);
+    bool daggered = false;
+    for (const FrameRandomisation::FrameSample& sample : samples) {
+      daggered |= !sample.to_dagger.empty();
+      Circuit sampled = ufr.materialise(*frame_template, sample);
+      CHECK(test_unitary_comparison(circ, sampled, true));
+    }
+    CHECK(daggered);
+  }
+}
+
+SCENARIO("Test that seeded sampling is reproducible.") {
+  GIVEN("PauliFrameRandomisation of a three-qubit circuit.") {
+    PauliFrameRandomisation pfr;
+    Circuit circ(3);
+    add_2qb_gates(circ, OpType::CX, {{0, 1}, {1, 2}});
+    circ.add_op<unsigned>(OpType::T, {1});
+    add_2qb_gates(circ, OpType::CX, {{2, 0}});
+    const std::vector<Circuit> first =
+        pfr.sample_randomisation_circuits(circ, 50, 11);
+    const std::vector<Circuit> second =
+        pfr.sample_randomisation_circuits(circ, 50, 11);
+    REQUIRE(first.size() == 50);
+    REQUIRE(second.size() == 50);
+    std::set<std::vector<OpType>> distinct;
+    for (unsigned i = 0; i < first.size(); i++) {
+      CHECK(first[i] == second[i]);
+      CHECK(test_unitary_comparison(circ, first[i], true));
+      std::vector<OpType> types;
+      for (const Command& com : first[i]) {
+        types.push_back(com.get_op_ptr()->get_type());
+      }
+      distinct.insert(types);
+    }
+    CHECK(distinct.size() > 1);
+  }
+  GIVEN("PowerCycle of a two-qubit circuit.") {
+    PowerCycle pc;
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    const std::vector<Circuit> first = pc.sample_cycles(circ, 3, 20, 5);
+    const std::vector<Circuit> second = pc.sample_cycles(circ, 3, 20, 5);
+    REQUIRE(first.size() == 20);
+    for (unsigned i = 0; i < first.size(); i++) {
+      CHECK(first[i] == second[i]);
+    }
+  }
+}
+
 }  // namespace test_FrameRandomisation
 }  // namespace tket
@@ -98,5 +98,108 @@ SCENARIO("Some QubitOperators") {
   }
 }
 
+SCENARIO("Incremental measurement reduction") {
+  QubitPauliString zzzz({Pauli::Z, Pauli::Z, Pauli::Z, Pauli::Z});
+  QubitPauliString xxyy({Pauli::X, Pauli::X, Pauli::Y, Pauli::Y});
+  std::list<QubitPauliString> first{
+      QubitPauliString(Qubit(0), Pauli::Z),
+      QubitPauliString(Qubit(1), Pauli::Z), xxyy};
+  std::list<QubitPauliString> second{
+      QubitPauliString(Qubit(2), Pauli::Z),
+      QubitPauliString(Qubit(3), Pauli::Z), zzzz};
+  GIVEN("Commuting sets") {
+    IncrementalMeasurementReduction imr(PauliPartitionStrat::CommutingSets);
+    imr.add_terms(first);
+    MeasurementSetup ms0 = imr.get_setup();
+    REQUIRE(ms0.get_circs().size() == 2);
+    REQUIRE(ms0.verify());
+    WHEN("Terms are added to one group") {
+      imr.add_terms(second);
+      REQUIRE(imr.n_terms() == 6);
+      MeasurementSetup ms1 = imr.get_setup();
+      REQUIRE(ms1.get_result_map().size() == 6);
+      REQUIRE(ms1.verify());
+      // Same groups as partitioning all the terms at once
+      std::list<QubitPauliString> all = first;
+      all.insert(all.end(), second.begin(), second.end());
+      REQUIRE(
+          ms1.get_circs().size() ==
+          measurement_reduction(all, PauliPartitionStrat::CommutingSets)
+              .get_circs()
+              .size());
+      // The group that gained no terms keeps its circuit
+      REQUIRE(ms1.get_circs()[1] == ms0.get_circs()[1]);
+    }
+    WHEN("Terms are added twice") {
+      imr.add_terms(first);
+      REQUIRE(imr.n_terms() == 3);
+      REQUIRE(imr.get_setup().get_result_map().size() == 3);
+    }
+  }
+  GIVEN("Nonconflicting sets") {
+    IncrementalMeasurementReduction imr(
+        PauliPartitionStrat::NonConflictingSets);
+    imr.add_terms(first);
+    imr.add_terms(second);
+    MeasurementSetup ms = imr.get_setup();
+    REQUIRE(ms.get_circs().size() == 2);
+    for (const Circuit& circ : ms.get_circs()) {
+      REQUIRE(circ.count_gates(OpType::CX) == 0);
+    }
+    REQUIRE(ms.verify());
+  }
+}
+
+SCENARIO("Memoised mutual diagonalisation") {
+  GIVEN("The same commuting set on two sets of qubits") {
+    // Order-preserving relabelling from qubits 0, 1, 2 to 3, 5, 8
+    std::vector<unsigned> relabel{3, 5, 8};
+    std::list<std::pair<QubitPauliTensor, Expr>> gadgets0, gadgets1;
+    std::vector<std::list<Pauli>> strings{
+        {Pauli::X, Pauli::X, Pauli::Y},
+        {Pauli::Y, Pauli::Y, Pauli::Y},
+        {Pauli::Z, Pauli::Z, Pauli::I}};
+    for (const std::list<Pauli>& string : strings) {
+      QubitPauliMap map0, map1;
+      unsigned q = 0;
+      for (Pauli p : string) {
+        map0.insert({Qubit(q), p});
+        map1.insert({Qubit(relabel[q]), p});
+        ++q;
+      }
+      gadgets0.push_back({QubitPauliTensor(map0), 0.5});
+      gadgets1.push_back({QubitPauliTensor(map1, -1.), 0.5});
+    }
+    std::set<Qubit> qubits0{Qubit(0), Qubit(1), Qubit(2)};
+    std::set<Qubit> qubits1{Qubit(3), Qubit(5), Qubit(8)};
+    const std::list<std::pair<QubitPauliTensor, Expr>> original0 = gadgets0;
+    clear_mutual_diagonalise_cache();
+    std::list<std::pair<QubitPauliTensor, Expr>> uncached1 = gadgets1;
+    Circuit expected1 =
+        mutual_diagonalise(uncached1, qubits1, CXConfigType::Snake);
+    clear_mutual_diagonalise_cache();
+    Circuit circ0 = mutual_diagonalise(gadgets0, qubits0, CXConfigType::Snake);
+    REQUIRE(mutual_diagonalise_cache_size() == 1);
+    Circuit circ1 = mutual_diagonalise(gadgets1, qubits1, CXConfigType::Snake);
+    THEN("The second set reuses the first diagonalisation") {
+      REQUIRE(mutual_diagonalise_cache_size() == 1);
+      REQUIRE(circ1 == expected1);
+      REQUIRE(gadgets1 == uncached1);
+      REQUIRE(circ0.count_gates(OpType::CX) == circ1.count_gates(OpType::CX));
+      for (const std::pair<QubitPauliTensor, Expr>& gadget : gadgets1) {
+        for (const std::pair<const Qubit, Pauli>& qp :
+             gadget.first.string.map) {
+          REQUIRE((qp.second == Pauli::I || qp.second == Pauli::Z));
+        }
+      }
+    }
+    WHEN("The CX configuration differs") {
+      std::list<std::pair<QubitPauliTensor, Expr>> gadgets = original0;
+      mutual_diagonalise(gadgets, qubits0, CXConfigType::Tree);
+      REQUIRE(mutual_diagonalise_cache_size() == 2);
+    }
+  }
+}
+
 }  // namespace test_MeasurementReduction
 }  // namespace tket
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <catch2/catch.hpp>
+#include <random>
 
 #include "MeasurementSetup/MeasurementSetup.hpp"
 #include "testutil.hpp"
@@ -389,5 +390,107 @@ SCENARIO("verify_measurement_setup") {
   }
 }
 
+SCENARIO("expectation_values") {
+  Qubit q0(q_default_reg(), 0);
+  Qubit q1(q_default_reg(), 1);
+  QubitPauliString zi({{q0, Pauli::Z}});
+  QubitPauliString iz({{q1, Pauli::Z}});
+  QubitPauliString zz({{q0, Pauli::Z}, {q1, Pauli::Z}});
+  GIVEN("Shots of a single circuit") {
+    MeasurementSetup ms;
+    ms.add_measurement_circuit(Circuit(2, 2));
+    ms.add_result_for_term(QubitPauliString(), {0, {}, false});
+    ms.add_result_for_term(zi, {0, {0}, false});
+    ms.add_result_for_term(iz, {0, {1}, true});
+    ms.add_result_for_term(zz, {0, {0, 1}, false});
+    MeasurementSetup::packed_shots_t shots(4, 1);
+    shots << 0b00, 0b01, 0b01, 0b11;
+    MeasurementSetup::expectation_map_t values =
+        ms.expectation_values({shots});
+    REQUIRE(values.size() == 4);
+    REQUIRE(values.at(QubitPauliString()) == Approx(1.));
+    REQUIRE(values.at(zi) == Approx(-0.5));
+    REQUIRE(values.at(iz) == Approx(-0.5));
+    REQUIRE(values.at(zz) == Approx(0.));
+  }
+  GIVEN("A term measured by two circuits") {
+    MeasurementSetup ms;
+    ms.add_measurement_circuit(Circuit(2, 2));
+    ms.add_measurement_circuit(Circuit(2, 2));
+    ms.add_result_for_term(zi, {0, {0}, false});
+    ms.add_result_for_term(zi, {1, {1}, false});
+    MeasurementSetup::packed_shots_t shots0(2, 1);
+    shots0 << 0b0, 0b0;
+    MeasurementSetup::packed_shots_t shots1(1, 1);
+    shots1 << 0b10;
+    // Shots are pooled between the circuits
+    REQUIRE(
+        ms.expectation_values({shots0, shots1}).at(zi) == Approx(1. / 3.));
+  }
+  GIVEN("Bits beyond the first word") {
+    MeasurementSetup ms;
+    ms.add_measurement_circuit(Circuit(2, 100));
+    ms.add_result_for_term(zz, {0, {3, 70}, false});
+    MeasurementSetup::packed_shots_t shots(2, 2);
+    shots << (1 << 3), 0, (1 << 3), (1 << 6);
+    REQUIRE(ms.expectation_values({shots}).at(zz) == Approx(0.));
+    WHEN("A bit is outside the shots") {
+      ms.add_result_for_term(zi, {0, {128}, false});
+      REQUIRE_THROWS_AS(
+          ms.expectation_values({shots}), std::invalid_argument);
+    }
+  }
+  GIVEN("Shots for the wrong number of circuits") {
+    MeasurementSetup ms;
+    ms.add_measurement_circuit(Circuit(2, 2));
+    REQUIRE_THROWS_AS(ms.expectation_values({}), std::invalid_argument);
+  }
+  GIVEN("Many random shots") {
+    MeasurementSetup ms;
+    const unsigned n_circs = 3;
+    const unsigned n_bits = 80;
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<std::uint64_t> word;
+    std::uniform_int_distribution<unsigned> bit(0, n_bits - 1);
+    std::vector<MeasurementSetup::packed_shots_t> shots;
+    for (unsigned c = 0; c < n_circs; ++c) {
+      ms.add_measurement_circuit(Circuit(n_bits, n_bits));
+      MeasurementSetup::packed_shots_t table(10000 + c, 2);
+      for (Eigen::Index r = 0; r < table.rows(); ++r) {
+        table(r, 0) = word(gen);
+        table(r, 1) = word(gen) & 0xffff;
+      }
+      shots.push_back(table);
+    }
+    std::vector<QubitPauliString> terms;
+    for (unsigned t = 0; t < 50; ++t) {
+      QubitPauliString term({{Qubit(t), Pauli::X}});
+      terms.push_back(term);
+      for (unsigned c = t % 2; c < n_circs; c += 2) {
+        std::vector<unsigned> bits{bit(gen), bit(gen), bit(gen)};
+        ms.add_result_for_term(term, {c, bits, t % 3 == 0});
+      }
+    }
+    MeasurementSetup::expectation_map_t values = ms.expectation_values(shots);
+    for (const QubitPauliString &term : terms) {
+      double total = 0.;
+      unsigned n_shots = 0;
+      for (const MeasurementSetup::MeasurementBitMap &mbm :
+           ms.get_result_map().at(term)) {
+        const MeasurementSetup::packed_shots_t &table = shots[mbm.circ_index];
+        for (Eigen::Index r = 0; r < table.rows(); ++r) {
+          bool parity = mbm.invert;
+          for (unsigned b : mbm.bits) {
+            parity ^= (table(r, b / 64) >> (b % 64)) & 1;
+          }
+          total += parity ? -1. : 1.;
+          ++n_shots;
+        }
+      }
+      REQUIRE(values.at(term) == Approx(total / n_shots));
+    }
+  }
+}
+
 }  // namespace test_MeasurementSetup
 }  // namespace tket
@@ -15,6 +15,7 @@
 #include <catch2/catch.hpp>
 
 #include "Diagonalisation/PauliPartition.hpp"
+#include "Utils/Parallel.hpp"
 #include "testutil.hpp"
 
 namespace tket {
@@ -96,5 +97,89 @@ SCENARIO("Small sets of Gadgets are partitioned correctly") {
   }
 }
 
+SCENARIO("Larger sets of strings are partitioned consistently") {
+  std::list<QubitPauliString> tensors;
+  for (unsigned k = 0; k < 300; k++) {
+    QubitPauliMap map;
+    for (unsigned q = 0; q < 70; q++) {
+      unsigned p = (k * (q + 1) + q * q + k / 7) % 11;
+      if (p < 3) map.insert({Qubit(q), Pauli(p + 1)});
+    }
+    tensors.push_back(QubitPauliString(map));
+  }
+  for (PauliPartitionStrat strat :
+       {PauliPartitionStrat::NonConflictingSets,
+        PauliPartitionStrat::CommutingSets}) {
+    for (GraphColourMethod method :
+         {GraphColourMethod::LargestFirst, GraphColourMethod::Lazy}) {
+      std::list<std::list<QubitPauliString>> terms =
+          term_sequence(tensors, strat, method);
+      unsigned total_terms = 0;
+      for (const std::list<QubitPauliString>& term : terms) {
+        total_terms += term.size();
+        for (const QubitPauliString& a : term) {
+          for (const QubitPauliString& b : term) {
+            if (strat == PauliPartitionStrat::CommutingSets) {
+              REQUIRE(a.commutes_with(b));
+            } else {
+              REQUIRE(a.conflicting_qubits(b).empty());
+            }
+          }
+        }
+      }
+      REQUIRE(total_terms == tensors.size());
+
+      // The graph is the same however many threads build it.
+      set_max_threads(1);
+      REQUIRE(term_sequence(tensors, strat, method) == terms);
+      set_max_threads(0);
+    }
+  }
+}
+
+SCENARIO("Streaming partitioner") {
+  GIVEN("Strings over a growing set of qubits") {
+    std::list<QubitPauliString> tensors;
+    for (unsigned k = 0; k < 200; k++) {
+      QubitPauliMap map;
+      for (unsigned q = 0; q < 10 + k / 2; q++) {
+        unsigned p = (k * (q + 1) + q * q + k / 7) % 13;
+        if (p < 3) map.insert({Qubit(q), Pauli(p + 1)});
+      }
+      tensors.push_back(QubitPauliString(map));
+    }
+    for (PauliPartitionStrat strat :
+         {PauliPartitionStrat::NonConflictingSets,
+          PauliPartitionStrat::CommutingSets}) {
+      StreamingPauliPartitioner partitioner(strat);
+      for (const QubitPauliString& qps : tensors) {
+        unsigned g = partitioner.add(qps);
+        REQUIRE(g < partitioner.n_groups());
+      }
+      // Same first-fit assignment as the lazy method
+      REQUIRE(
+          partitioner.get_groups() ==
+          term_sequence(tensors, strat, GraphColourMethod::Lazy));
+    }
+  }
+  GIVEN("A product that commutes with the group but not its members") {
+    // XX and ZZ commute; YY commutes with both, XY with neither.
+    StreamingPauliPartitioner partitioner(PauliPartitionStrat::CommutingSets);
+    QubitPauliString xx({Qubit(0), Qubit(1)}, {Pauli::X, Pauli::X});
+    QubitPauliString zz({Qubit(0), Qubit(1)}, {Pauli::Z, Pauli::Z});
+    QubitPauliString yy({Qubit(0), Qubit(1)}, {Pauli::Y, Pauli::Y});
+    QubitPauliString xy({Qubit(0), Qubit(1)}, {Pauli::X, Pauli::Y});
+    REQUIRE(partitioner.add(xx) == 0);
+    REQUIRE(partitioner.add(zz) == 0);
+    REQUIRE(partitioner.add(yy) == 0);
+    REQUIRE(partitioner.add(xy) == 1);
+  }
+  GIVEN("An unknown strategy") {
+    REQUIRE_THROWS_AS(
+        StreamingPauliPartitioner(PauliPartitionStrat(7)),
+        UnknownPauliPartitionStrat);
+  }
+}
+
 }  // namespace test_Partition
 }  // namespace tket
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <catch2/catch.hpp>
+#include <set>
 
 #include "ArchAwareSynth/Path.hpp"
 
@@ -994,4 +995,55 @@ SCENARIO("Check iteration order construciton") {
     REQUIRE(edgelist.size() == 6);
   }
 }
+
+SCENARIO("Are Hamiltonian paths and path handlers shared between calls?") {
+  auto is_hampath = [](const Architecture &arc,
+                       const std::vector<Node> &path) {
+    if (path.size() != arc.n_nodes()) return false;
+    if (std::set<Node>(path.begin(), path.end()).size() != path.size()) {
+      return false;
+    }
+    for (unsigned i = 1; i < path.size(); ++i) {
+      if (!arc.edge_exists(path[i - 1], path[i]) &&
+          !arc.edge_exists(path[i], path[i - 1])) {
+        return false;
+      }
+    }
+    return true;
+  };
+  GIVEN("A grid") {
+    const SquareGrid grid(6, 7);
+    const std::vector<Node> path = aas::find_hampath_multistart(grid);
+    CHECK(is_hampath(grid, path));
+    const std::vector<Node> first = aas::find_hampath(grid);
+    CHECK(is_hampath(grid, first));
+    CHECK(aas::find_hampath(grid) == first);
+  }
+  GIVEN("A tree with three leaves") {
+    const Architecture tree({{0, 1}, {1, 2}, {1, 3}});
+    CHECK(aas::find_hampath_multistart(tree).empty());
+    CHECK(aas::find_hampath(tree).empty());
+    CHECK(aas::find_hampath(tree).empty());
+  }
+  GIVEN("A ring") {
+    const Architecture ring({{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 0}});
+    const std::vector<Node> path = aas::find_hampath_multistart(ring);
+    CHECK(is_hampath(ring, path));
+    CHECK(path.front() == Node(0));
+  }
+  GIVEN("The same connectivity twice") {
+    MatrixXb connectivity(3, 3);
+    connectivity << 0, 1, 0,  // 0
+        1, 0, 1,              // 1
+        0, 1, 0;              // 2
+    const aas::PathHandler first(connectivity);
+    const aas::PathHandler second(connectivity);
+    CHECK(first.get_distance_matrix() == second.get_distance_matrix());
+    CHECK(first.get_path_matrix() == second.get_path_matrix());
+    connectivity(0, 1) = 0;
+    const aas::PathHandler directed(connectivity);
+    CHECK(directed.get_distance_matrix()(1, 0) == 1);
+    CHECK(directed.get_distance_matrix()(0, 1) > 2);
+  }
+}
 }  // namespace tket
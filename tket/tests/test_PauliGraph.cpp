@@ -107,6 +107,19 @@ SCENARIO("Correct creation of PauliGraphs") {
     PauliGraph pg = circuit_to_pauli_graph(circ);
     REQUIRE(pg.n_vertices() == 3);
   }
+  GIVEN("Gadgets merging past gadgets on other qubits") {
+    Circuit circ(3);
+    circ.add_op<unsigned>(OpType::Rz, 0.3, {0});
+    circ.add_op<unsigned>(OpType::Rx, 0.6, {1});
+    circ.add_op<unsigned>(OpType::XXPhase, 0.7, {1, 2});
+    circ.add_op<unsigned>(OpType::Rz, 0.1, {0});
+    circ.add_op<unsigned>(OpType::Ry, 0.4, {2});
+    PauliGraph pg = circuit_to_pauli_graph(circ);
+    REQUIRE(pg.n_vertices() == 4);
+    circ.add_op<unsigned>(OpType::Rz, 0.1, {0});
+    PauliGraph pg2 = circuit_to_pauli_graph(circ);
+    REQUIRE(pg2.n_vertices() == 3);
+  }
   GIVEN("A circuit with Cliffords and non-Cliffords") {
     Circuit circ(2);
     circ.add_op<unsigned>(OpType::Rz, 0.3, {0});
@@ -776,6 +789,71 @@ SCENARIO("Conjugating Cliffords through Pauli tensors") {
       }
     }
   }
+  GIVEN("A 2qb XY pauli tensor") {
+    QubitPauliTensor qpt({Pauli::X, Pauli::Y});
+    Qubit qb0(0), qb1(1);
+    WHEN("Commuting a CZ through qb0-qb1") {
+      conjugate_PauliTensor(qpt, OpType::CZ, qb0, qb1);
+      THEN("XY becomes -YX") {
+        REQUIRE(qpt.string.map.at(qb0) == Pauli::Y);
+        REQUIRE(qpt.string.map.at(qb1) == Pauli::X);
+        REQUIRE(abs(qpt.coeff + 1.) < EPS);
+      }
+    }
+    WHEN("Commuting a SWAP through qb0-qb1") {
+      conjugate_PauliTensor(qpt, OpType::SWAP, qb0, qb1);
+      THEN("XY becomes YX") {
+        REQUIRE(qpt.string.map.at(qb0) == Pauli::Y);
+        REQUIRE(qpt.string.map.at(qb1) == Pauli::X);
+        REQUIRE(abs(qpt.coeff - 1.) < EPS);
+      }
+    }
+    WHEN("Commuting an unsupported gate") {
+      REQUIRE_THROWS_AS(
+          conjugate_PauliTensor(qpt, OpType::CY, qb0, qb1), NotImplemented);
+    }
+  }
+  GIVEN("Packed strings, more than fit in a word") {
+    const unsigned n_qubits = 4, n_strings = 100;
+    PackedPauliStrings packed(n_qubits, n_strings);
+    std::vector<QubitPauliTensor> tensors(n_strings);
+    for (unsigned s = 0; s < n_strings; ++s) {
+      for (unsigned q = 0; q < n_qubits; ++q) {
+        const Pauli p = Pauli((7 * s + 3 * q + s / 5) % 4);
+        packed.set(s, q, p);
+        tensors[s].string.map[Qubit(q)] = p;
+      }
+      if (s % 3 == 0) {
+        packed.set_negated(s, true);
+        tensors[s].coeff = -1.;
+      }
+    }
+    const std::vector<OpType> single{OpType::H, OpType::S, OpType::Sdg,
+                                     OpType::V, OpType::Vdg, OpType::X,
+                                     OpType::Y, OpType::Z};
+    const std::vector<OpType> pair{OpType::CX, OpType::CZ, OpType::SWAP};
+    for (unsigned i = 0; i < 60; ++i) {
+      const unsigned q0 = (5 * i) % n_qubits;
+      const unsigned q1 = (q0 + 1 + i % 3) % n_qubits;
+      const OpType op1 = single[i % single.size()];
+      const bool reverse = (i / single.size()) % 2;
+      packed.conjugate(op1, q0, reverse);
+      const OpType op2 = pair[i % pair.size()];
+      packed.conjugate(op2, q0, q1);
+      for (QubitPauliTensor& qpt : tensors) {
+        conjugate_PauliTensor(qpt, op1, Qubit(q0), reverse);
+        conjugate_PauliTensor(qpt, op2, Qubit(q0), Qubit(q1));
+      }
+    }
+    THEN("They match conjugating each string in turn") {
+      for (unsigned s = 0; s < n_strings; ++s) {
+        CHECK(packed.is_negated(s) == (tensors[s].coeff.real() < 0));
+        for (unsigned q = 0; q < n_qubits; ++q) {
+          CHECK(packed.get(s, q) == tensors[s].string.map.at(Qubit(q)));
+        }
+      }
+    }
+  }
 }
 
 SCENARIO("Test greedy diagonalisation explicitly") {
@@ -1006,5 +1084,103 @@ SCENARIO("Error handling with implicit permutations") {
   REQUIRE_THROWS_AS(circuit_to_pauli_graph(circ), NotImplemented);
 }
 
+SCENARIO("Streaming synthesis of a PauliGraph") {
+  const std::vector<Pauli> paulis{Pauli::I, Pauli::X, Pauli::Y, Pauli::Z};
+  Circuit circ(4);
+  for (unsigned i = 0; i < 300; ++i) {
+    // Runs through the non-identity strings in a scrambled order
+    const unsigned code = (i * 37) % 255 + 1;
+    std::vector<Pauli> string;
+    for (unsigned q = 0; q < 4; ++q) {
+      string.push_back(paulis[(code >> (2 * q)) % 4]);
+    }
+    circ.add_box(PauliExpBox(string, 0.01 * (i + 1)), {0, 1, 2, 3});
+    if (i % 7 == 0) circ.add_op<unsigned>(OpType::CX, {i % 4, (i + 1) % 4});
+  }
+  for (bool pairwise : {false, true}) {
+    PauliGraph pg = circuit_to_pauli_graph(circ);
+    const Circuit expected =
+        pairwise ? pauli_graph_to_circuit_pairwise(pg)
+                 : pauli_graph_to_circuit_individually(pg);
+    Circuit streamed(4);
+    unsigned n_pieces = 0;
+    pauli_graph_to_circuit_streaming(
+        pg,
+        [&](const Circuit &piece) {
+          streamed.append(piece);
+          n_pieces++;
+        },
+        pairwise);
+    REQUIRE(n_pieces > 2);
+    REQUIRE(pg.n_vertices() == 0);
+    REQUIRE(
+        streamed.count_gates(OpType::CX) == expected.count_gates(OpType::CX));
+    REQUIRE(test_unitary_comparison(streamed, expected));
+    REQUIRE(test_unitary_comparison(streamed, circ));
+  }
+}
+
+SCENARIO("Trotterised circuits from Pauli operators") {
+  GIVEN("Mutually commuting terms") {
+    // The product formula is exact for commuting terms
+    const std::map<QubitPauliString, Expr> terms{
+        {QubitPauliString({Pauli::Z, Pauli::Z, Pauli::I}), 0.3},
+        {QubitPauliString({Pauli::I, Pauli::Z, Pauli::Z}), 0.4},
+        {QubitPauliString({Pauli::X, Pauli::X, Pauli::X}), 0.5},
+        {QubitPauliString(), 0.6}};
+    Circuit expected(3);
+    expected.add_box(
+        PauliExpBox({Pauli::Z, Pauli::Z, Pauli::I}, 0.3), {0, 1, 2});
+    expected.add_box(
+        PauliExpBox({Pauli::I, Pauli::Z, Pauli::Z}, 0.4), {0, 1, 2});
+    expected.add_box(
+        PauliExpBox({Pauli::X, Pauli::X, Pauli::X}, 0.5), {0, 1, 2});
+    expected.add_phase(-0.3);
+    for (unsigned order : {1, 2, 4}) {
+      for (unsigned n_steps : {1, 3}) {
+        const Circuit circ = trotter_circuit(terms, order, n_steps);
+        REQUIRE(circ.n_qubits() == 3);
+        REQUIRE(test_unitary_comparison(circ, expected));
+      }
+    }
+  }
+  GIVEN("Non-commuting terms") {
+    std::map<QubitPauliString, Expr> terms{
+        {QubitPauliString({Pauli::X, Pauli::I}), 0.3},
+        {QubitPauliString({Pauli::Z, Pauli::Z}), 0.4},
+        {QubitPauliString({Pauli::I, Pauli::Y}), 0.2}};
+    std::map<QubitPauliString, Expr> negated;
+    for (const auto &[string, angle] : terms) negated.insert({string, -angle});
+    WHEN("Using a symmetric formula") {
+      // Steps of even order are symmetric, so U(t)U(-t) = I
+      for (unsigned order : {2, 4}) {
+        Circuit circ = trotter_circuit(terms, order, 2);
+        circ.append(trotter_circuit(negated, order, 2));
+        REQUIRE(test_unitary_comparison(circ, Circuit(2)));
+      }
+    }
+    WHEN("Increasing the number of steps") {
+      // Both formulae converge to the same unitary
+      auto distance = [&](unsigned n_steps) {
+        const Eigen::MatrixXcd u1 =
+            tket_sim::get_unitary(trotter_circuit(terms, 1, n_steps));
+        const Eigen::MatrixXcd u2 =
+            tket_sim::get_unitary(trotter_circuit(terms, 2, n_steps));
+        return (u1 - u2).norm();
+      };
+      const double coarse = distance(1);
+      const double fine = distance(20);
+      REQUIRE(fine < coarse / 10);
+    }
+  }
+  GIVEN("Invalid parameters") {
+    const std::map<QubitPauliString, Expr> terms{
+        {QubitPauliString({Pauli::Z, Pauli::Z}), 0.3}};
+    REQUIRE_THROWS_AS(trotter_circuit(terms, 3), NotValid);
+    REQUIRE_THROWS_AS(trotter_circuit(terms, 0), NotValid);
+    REQUIRE_THROWS_AS(trotter_circuit(terms, 1, 0), NotValid);
+  }
+}
+
 }  // namespace test_PauliGraph
 }  // namespace tket
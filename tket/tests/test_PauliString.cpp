@@ -18,6 +18,7 @@
 #include "CircuitsForTesting.hpp"
 #include "Converters/PauliGadget.hpp"
 #include "PauliGraph/ConjugatePauliFunctions.hpp"
+#include "Utils/DensePauliString.hpp"
 #include "Utils/PauliStrings.hpp"
 #include "testutil.hpp"
 
@@ -271,6 +272,90 @@ SCENARIO("Test matrix product utilities") {
     const QubitPauliString op({{Qubit(0), Pauli::X}, {Qubit(1), Pauli::Y}});
     REQUIRE_THROWS(op.to_sparse_matrix({Qubit(0), Qubit(2)}));
   }
+  GIVEN("A random state and operator") {
+    const unsigned n = 5;
+    Eigen::VectorXcd state = Eigen::VectorXcd::Random(1 << n);
+    state.normalize();
+    OperatorSum op;
+    for (unsigned t = 0; t < 20; ++t) {
+      QubitPauliMap map;
+      for (unsigned q = 0; q < n; ++q) {
+        map.insert({Qubit(q), Pauli((t * (q + 3) + q) % 4)});
+      }
+      op.push_back({QubitPauliString(map), Complex(0.1 * t, -0.2)});
+    }
+    qubit_vector_t qubits{Qubit(3), Qubit(0), Qubit(4), Qubit(1), Qubit(2)};
+    THEN("Direct evaluation agrees with the sparse matrices") {
+      for (const std::pair<QubitPauliString, Complex> &term : op) {
+        const CmplxSpMat mat = term.first.to_sparse_matrix(qubits);
+        REQUIRE(term.first.dot_state(state, qubits).isApprox(mat * state));
+        Complex expected = state.dot(mat * state);
+        REQUIRE(
+            std::abs(term.first.state_expectation(state, qubits) - expected) <
+            EPS);
+      }
+      Complex expected = state.dot(operator_tensor(op, n) * state);
+      REQUIRE(std::abs(operator_expectation(op, state) - expected) < EPS);
+      expected = state.dot(operator_tensor(op, qubits) * state);
+      REQUIRE(
+          std::abs(operator_expectation(op, state, qubits) - expected) < EPS);
+    }
+    THEN("A statevector of the wrong size is rejected") {
+      REQUIRE_THROWS(op[1].first.state_expectation(state, {Qubit(0)}));
+    }
+  }
+}
+
+SCENARIO("Dense Pauli strings agree with QubitPauliString") {
+  // Strings over more than one word of qubits
+  std::list<QubitPauliString> strings;
+  for (unsigned k = 0; k < 6; k++) {
+    QubitPauliMap map;
+    for (unsigned q = 0; q < 80; q++) {
+      unsigned p = (q * (2 * k + 1) + k) % 5;
+      if (p < 4) map.insert({Qubit("q", q), Pauli(p)});
+    }
+    strings.push_back(QubitPauliString(map));
+  }
+  strings.push_back(QubitPauliString(Qubit("r", 0), Pauli::Y));
+  strings.push_back(QubitPauliString(
+      {Qubit("q", 1), Qubit("q", 70), Qubit("r", 0)},
+      {Pauli::Z, Pauli::X, Pauli::X}));
+  qubit_vector_t qubits;
+  std::vector<DensePauliString> packed = pack_pauli_strings(strings, qubits);
+  REQUIRE(qubits.size() == 81);
+  REQUIRE(packed.size() == strings.size());
+
+  auto to_qubits = [&](const std::vector<unsigned> &indices) {
+    std::set<Qubit> qbs;
+    for (unsigned i : indices) qbs.insert(qubits[i]);
+    return qbs;
+  };
+  unsigned i = 0;
+  for (const QubitPauliString &a : strings) {
+    REQUIRE(packed[i].to_qubit_pauli_string(qubits) == a);
+    unsigned j = 0;
+    for (const QubitPauliString &b : strings) {
+      const DensePauliString &da = packed[i];
+      const DensePauliString &db = packed[j];
+      REQUIRE(da.commutes_with(db) == a.commutes_with(b));
+      REQUIRE(to_qubits(da.common_qubits(db)) == a.common_qubits(b));
+      REQUIRE(to_qubits(da.own_qubits(db)) == a.own_qubits(b));
+      REQUIRE(to_qubits(da.conflicting_qubits(db)) == a.conflicting_qubits(b));
+      REQUIRE((da == db) == (a == b));
+      ++j;
+    }
+    ++i;
+  }
+  GIVEN("Strings over different numbers of qubits") {
+    REQUIRE_THROWS_AS(
+        packed[0].commutes_with(DensePauliString(3)), std::invalid_argument);
+  }
+  GIVEN("A qubit missing from the index") {
+    std::map<Qubit, unsigned> index = {{Qubit("q", 0), 0}};
+    REQUIRE_THROWS_AS(
+        DensePauliString(strings.front(), index), std::out_of_range);
+  }
 }
 
 }  // namespace test_PauliString
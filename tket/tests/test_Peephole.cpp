@@ -0,0 +1,136 @@
+// Copyright 2019-2021 Cambridge Quantum Computing
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <catch2/catch.hpp>
+
+#include "CircuitsForTesting.hpp"
+#include "Gate/GatePtr.hpp"
+#include "Transformations/Peephole.hpp"
+#include "Transformations/Transform.hpp"
+#include "testutil.hpp"
+
+namespace tket {
+namespace test_Peephole {
+
+SCENARIO("Peephole rules are indexed by root type") {
+  GIVEN("A rule replacing T gates by Rz gates") {
+    unsigned n_calls = 0;
+    PeepholeRule t_to_rz{
+        "TToRz",
+        {OpType::T},
+        [&n_calls](PeepholeRewriter &rw, const Vertex &v) {
+          ++n_calls;
+          rw.replace_op(v, get_op_ptr(OpType::Rz, 0.25));
+          return true;
+        }};
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::T, {0});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::H, {1});
+    circ.add_op<unsigned>(OpType::T, {1});
+    PeepholeEngine engine({t_to_rz});
+    REQUIRE(engine.apply(circ));
+    // Only the two T vertices are offered to the rule
+    REQUIRE(n_calls == 2);
+    REQUIRE(circ.count_gates(OpType::T) == 0);
+    REQUIRE(circ.count_gates(OpType::Rz) == 2);
+    n_calls = 0;
+    REQUIRE_FALSE(engine.apply(circ));
+    REQUIRE(n_calls == 0);
+  }
+  GIVEN("A rule for any root after one for a given root") {
+    std::vector<std::string> tried;
+    PeepholeRule h_rule{
+        "H", {OpType::H}, [&tried](PeepholeRewriter &, const Vertex &) {
+          tried.push_back("H");
+          return false;
+        }};
+    PeepholeRule any_rule{
+        "Any", {}, [&tried](PeepholeRewriter &, const Vertex &) {
+          tried.push_back("Any");
+          return false;
+        }};
+    Circuit circ(1);
+    circ.add_op<unsigned>(OpType::H, {0});
+    PeepholeEngine engine({h_rule, any_rule});
+    REQUIRE_FALSE(engine.apply(circ));
+    // Rules are tried in the order they were added
+    REQUIRE(tried == std::vector<std::string>{"H", "Any"});
+  }
+}
+
+SCENARIO("Peephole Clifford rules") {
+  GIVEN("A Z gate either side of a CX control") {
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::Z, {0});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::Z, {0});
+    Circuit original = circ;
+    REQUIRE_FALSE(Transform::remove_redundancies().apply(circ));
+    REQUIRE(Transform::clifford_peephole().apply(circ));
+    REQUIRE(circ.n_gates() == 1);
+    REQUIRE(circ.count_gates(OpType::CX) == 1);
+    REQUIRE(test_unitary_comparison(original, circ));
+  }
+  GIVEN("An X gate either side of a CX target") {
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::X, {1});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::X, {1});
+    Circuit original = circ;
+    REQUIRE(Transform::clifford_peephole().apply(circ));
+    REQUIRE(circ.n_gates() == 2);
+    REQUIRE(circ.count_gates(OpType::X) == 0);
+    REQUIRE(test_unitary_comparison(original, circ));
+  }
+  GIVEN("A Z gate on a CX target") {
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::Z, {1});
+    Circuit original = circ;
+    REQUIRE_FALSE(Transform::clifford_peephole().apply(circ));
+    REQUIRE(circ == original);
+  }
+}
+
+SCENARIO("Peephole redundancy rules") {
+  GIVEN("A UCCSD example") {
+    const Circuit &original = CircuitsForTesting::get().uccsd;
+    Circuit circ = original;
+    PeepholeEngine engine(PeepholeRules::redundancy_rules());
+    engine.apply(circ);
+    REQUIRE(test_unitary_comparison(original, circ));
+    // A single application reaches a fixed point
+    Circuit again = circ;
+    REQUIRE_FALSE(Transform::remove_redundancies().apply(again));
+    REQUIRE(again == circ);
+  }
+  GIVEN("Rotations cancelling before a measurement") {
+    Circuit circ(2, 2);
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::Rx, 0.5, {1});
+    circ.add_op<unsigned>(OpType::Rx, 1.5, {1});
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::CZ, {0, 1});
+    circ.add_measure(0, 0);
+    circ.add_measure(1, 1);
+    REQUIRE(Transform::remove_redundancies().apply(circ));
+    REQUIRE(circ.n_gates() == 2);
+    REQUIRE(circ.count_gates(OpType::Measure) == 2);
+  }
+}
+
+}  // namespace test_Peephole
+}  // namespace tket
@@ -21,6 +21,7 @@
 #include "Simulation/ComparisonFunctions.hpp"
 #include "Transformations/Transform.hpp"
 #include "Utils/EigenConfig.hpp"
+#include "Utils/Parallel.hpp"
 #include "testutil.hpp"
 
 namespace tket {
@@ -273,6 +274,25 @@ SCENARIO("Identifying and synthesising Pauli gadgets") {
     const auto s1 = tket_sim::get_statevector(circ);
     REQUIRE(tket_sim::compare_statevectors_or_unitaries(s0, s1));
   }
+  GIVEN("More gadgets than are synthesised in one block") {
+    Circuit circ(6);
+    for (unsigned i = 0; i < 300; ++i) {
+      circ.add_op<unsigned>(OpType::CX, {i % 6, (i + 1 + (i / 6) % 5) % 6});
+      circ.add_op<unsigned>(i % 2 ? OpType::S : OpType::V, {(i + 3) % 6});
+      circ.add_op<unsigned>(
+          i % 3 ? OpType::Rz : OpType::Rx, 0.01 * (i + 1), {(i * 5) % 6});
+    }
+    const auto s0 = tket_sim::get_statevector(circ);
+    Circuit sequential = circ;
+    const unsigned max_threads = get_max_threads();
+    set_max_threads(1);
+    Transform::pairwise_pauli_gadgets().apply(sequential);
+    set_max_threads(max_threads);
+    Transform::pairwise_pauli_gadgets().apply(circ);
+    REQUIRE(circ == sequential);
+    const auto s1 = tket_sim::get_statevector(circ);
+    REQUIRE(tket_sim::compare_statevectors_or_unitaries(s0, s1));
+  }
 }
 
 SCENARIO("Decompose phase gadgets") {
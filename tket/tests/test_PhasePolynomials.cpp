@@ -22,6 +22,7 @@
 #include "Transformations/Transform.hpp"
 #include "Utils/HelperFunctions.hpp"
 #include "Utils/MatrixAnalysis.hpp"
+#include "Utils/Parallel.hpp"
 #include "testutil.hpp"
 
 namespace tket {
@@ -69,6 +70,37 @@ SCENARIO("Test basic phase polynomial creation") {
     }
     REQUIRE(basis_map == correct_basis_map);
   }
+  GIVEN("Parities spanning more than one word of qubits") {
+    unsigned n = 70;
+    Circuit circ(n);
+    circ.add_op<unsigned>(OpType::Rz, 0.1, {0});
+    for (unsigned i : {63, 64, 69}) {
+      circ.add_op<unsigned>(OpType::CX, {i, 0});
+      circ.add_op<unsigned>(OpType::Rz, 0.1, {0});
+    }
+    circ.add_op<unsigned>(OpType::CX, {69, 0});
+    circ.add_op<unsigned>(OpType::Rz, 0.2, {0});
+    PhasePolyBox ppbox(circ);
+    const PhasePolynomial& phasepoly = ppbox.get_phase_polynomial();
+    REQUIRE(phasepoly.size() == 4);
+    std::vector<bool> merged(n, false);
+    merged[0] = merged[63] = merged[64] = true;
+    REQUIRE(test_equiv_val(phasepoly.at(merged), 0.3));
+    merged[69] = true;
+    REQUIRE(test_equiv_val(phasepoly.at(merged), 0.1));
+    MatrixXb correct_basis_map = MatrixXb::Identity(n, n);
+    correct_basis_map(0, 63) = correct_basis_map(0, 64) = 1;
+    REQUIRE(ppbox.get_linear_transformation() == correct_basis_map);
+
+    // Synthesising and converting back gives the same box
+    PhasePolyBox resynth(*ppbox.to_circuit());
+    REQUIRE(resynth.get_phase_polynomial().size() == 4);
+    for (const phase_term_t& term : phasepoly) {
+      REQUIRE(test_equiv_expr(
+          resynth.get_phase_polynomial().at(term.first), term.second));
+    }
+    REQUIRE(resynth.get_linear_transformation() == correct_basis_map);
+  }
 }
 
 SCENARIO("Test diagonal Phase Polynomial circuit generation") {
@@ -713,6 +745,33 @@ SCENARIO("Test conversion of circuit to circuit with phase poly boxes") {
     REQUIRE(test_statevector_comparison(circ, result));
   }
 }
+SCENARIO("Decomposing many phase polynomial boxes") {
+  GIVEN("Layers of CX+Rz regions separated by Hadamards") {
+    Circuit circ(4);
+    for (unsigned layer = 0; layer < 12; ++layer) {
+      for (unsigned i = 0; i < 3; ++i) {
+        circ.add_op<unsigned>(OpType::CX, {i, i + 1});
+        circ.add_op<unsigned>(OpType::Rz, 0.1 * (layer + i + 1), {i + 1});
+        circ.add_op<unsigned>(OpType::CX, {i, i + 1});
+      }
+      for (unsigned i = 0; i < 4; ++i) circ.add_op<unsigned>(OpType::H, {i});
+    }
+    Circuit original = circ;
+    Circuit serial = circ;
+    REQUIRE(Transform::compose_phase_poly_boxes().apply(circ));
+    REQUIRE(circ.count_gates(OpType::PhasePolyBox) > 1);
+    REQUIRE(circ.decompose_boxes());
+    REQUIRE(circ.count_gates(OpType::PhasePolyBox) == 0);
+    REQUIRE(test_statevector_comparison(circ, original));
+    // The boxes are synthesised in parallel, with the same result
+    set_max_threads(1);
+    Transform::compose_phase_poly_boxes().apply(serial);
+    REQUIRE(serial.decompose_boxes());
+    set_max_threads(0);
+    REQUIRE(serial == circ);
+  }
+}
+
 SCENARIO("Phase polynomial synthesis without architecture") {
   GIVEN("single SWAP circuit") {
     Circuit circ(2);
@@ -13,9 +13,13 @@
 // limitations under the License.
 
 #include <catch2/catch.hpp>
+#include <filesystem>
+#include <memory>
+#include <optional>
 #include <random>
 
 #include "Routing/Placement.hpp"
+#include "Utils/Parallel.hpp"
 #include "testutil.hpp"
 
 namespace tket {
@@ -166,6 +170,38 @@ SCENARIO("Small monomorphisms. place_qubit") {
   }
 }
 
+SCENARIO("Does a parallel monomorphism search find the same matches?") {
+  SquareGrid arc(3, 3);
+  Circuit circ(4);
+  qubit_vector_t qbs = circ.all_qubits();
+  QubitGraph qg(qbs);
+  for (unsigned i = 0; i < 3; i++) {
+    qg.add_connection(qbs[i], qbs[i + 1], i + 1);
+  }
+  GIVEN("No limit on the number of matches") {
+    set_max_threads(1);
+    const std::vector<qubit_bimap_t> serial =
+        monomorphism_edge_break(arc, qg, 100000, 60000);
+    set_max_threads(4);
+    const std::vector<qubit_bimap_t> parallel =
+        monomorphism_edge_break(arc, qg, 100000, 60000);
+    set_max_threads(0);
+    REQUIRE(serial.size() > 1);
+    CHECK(serial == parallel);
+  }
+  GIVEN("A limit on the number of matches") {
+    set_max_threads(2);
+    const std::vector<qubit_bimap_t> two =
+        monomorphism_edge_break(arc, qg, 10, 60000);
+    set_max_threads(4);
+    const std::vector<qubit_bimap_t> four =
+        monomorphism_edge_break(arc, qg, 10, 60000);
+    set_max_threads(0);
+    CHECK(two.size() == 10);
+    CHECK(two == four);
+  }
+}
+
 // Monomorpher
 SCENARIO("Check Monomorpher satisfies correct placement conditions") {
   GIVEN("A simple architecture.") {
@@ -448,6 +484,76 @@ SCENARIO("Check Monomorpher satisfies correct placement conditions") {
   }
 }
 
+SCENARIO("Does batched map scoring agree with map_cost?") {
+  SquareGrid arc(4, 4);
+  avg_node_errors_t node_errors;
+  avg_readout_errors_t readout_errors;
+  avg_link_errors_t link_errors;
+  unsigned i = 0;
+  for (const Node& node : arc.get_all_nodes_vec()) {
+    node_errors[node] = 0.001 * (i % 5);
+    readout_errors[node] = 0.01 * (i % 3);
+    ++i;
+  }
+  for (const auto& [n1, n2] : arc.get_all_edges_vec()) {
+    link_errors[{n1, n2}] = 0.01 * (i % 7);
+    link_errors[{n2, n1}] = 0.02 * (i % 4);
+    ++i;
+  }
+  Circuit test_circ(6);
+  add_2qb_gates(
+      test_circ, OpType::CX, {{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}, {1, 4}});
+  Monomorpher morph(
+      test_circ, arc, {node_errors, link_errors, readout_errors}, {4, 6});
+  QubitGraph q_graph =
+      monomorph_interaction_graph(test_circ, arc.n_connections(), 4);
+  const std::vector<qubit_bimap_t> maps =
+      monomorphism_edge_break(arc, q_graph, 1000, 60000);
+  REQUIRE(maps.size() > 256);
+  GIVEN("All the maps") {
+    for (unsigned n_threads : {1u, 4u}) {
+      set_max_threads(n_threads);
+      const std::vector<double> costs = morph.map_costs(maps);
+      REQUIRE(costs.size() == maps.size());
+      for (unsigned k = 0; k < maps.size(); ++k) {
+        CHECK(costs[k] == Approx(morph.map_cost(maps[k])));
+      }
+    }
+    set_max_threads(0);
+  }
+  GIVEN("A stop condition") {
+    const std::vector<double> costs =
+        morph.map_costs(maps, []() { return true; });
+    CHECK(costs.size() == 256);
+  }
+}
+
+SCENARIO("Does an anytime Monomorpher keep to its budget?") {
+  std::vector<Connection> edges = {
+      {Node(1), Node(2)}, {Node(0), Node(1)}, {Node(2), Node(3)}};
+  Architecture arc(edges);
+  Circuit test_circ(4);
+  add_2qb_gates(test_circ, OpType::CX, {{0, 1}, {1, 3}, {3, 0}, {2, 1}});
+  GIVEN("A generous budget") {
+    Monomorpher morph(test_circ, arc, {}, {4, 5});
+    const std::vector<MapCost> anytime = morph.place_anytime(1, 60000);
+    const std::vector<MapCost> full = morph.place(1);
+    REQUIRE(anytime.size() == 1);
+    REQUIRE(full.size() == 1);
+    CHECK(anytime[0].cost == full[0].cost);
+  }
+  GIVEN("A tight budget") {
+    Monomorpher morph(test_circ, arc, {}, {4, 5});
+    const std::vector<MapCost> anytime = morph.place_anytime(2, 100);
+    REQUIRE(!anytime.empty());
+    CHECK(anytime.size() <= 2);
+  }
+  GIVEN("No maps requested") {
+    Monomorpher morph(test_circ, arc, {}, {4, 5});
+    REQUIRE_THROWS_AS(morph.place_anytime(0, 1000), PlacementError);
+  }
+}
+
 SCENARIO(
     "Does 'noise aware placement' deal with an undirected architecture "
     "(i.e. a coupling list with {0,1} and {1,0})?") {
@@ -498,6 +604,44 @@ SCENARIO(
   }
 }
 
+SCENARIO("Building a QubitGraph from interactions") {
+  GIVEN("A builder over four qubits") {
+    qubit_vector_t qbs = {Qubit(0), Qubit(1), Qubit(2), Qubit(3)};
+    QubitGraphBuilder builder(qbs);
+    REQUIRE(builder.index(Qubit(2)) == 2);
+    REQUIRE_THROWS_AS(builder.index(Qubit(4)), QubitGraphInvalidity);
+    REQUIRE(builder.add_connection(2, 0, 3));
+    REQUIRE(builder.add_connection(0, 2, 1));
+    REQUIRE_FALSE(builder.add_connection(2, 0, 5));
+    REQUIRE(builder.add_connection(1, 2, 2));
+    REQUIRE(builder.connected(0, 2));
+    REQUIRE_FALSE(builder.connected(0, 1));
+    REQUIRE(builder.get_weight(2, 0) == 3);
+    REQUIRE(builder.get_degree(2) == 3);
+    REQUIRE(builder.n_connections() == 3);
+    QubitGraph q_graph = builder.build();
+    // Unconnected qubits are left out
+    REQUIRE(q_graph.n_nodes() == 3);
+    REQUIRE(q_graph.get_connection_weight(Qubit(2), Qubit(0)) == 3);
+    REQUIRE(q_graph.get_connection_weight(Qubit(0), Qubit(2)) == 1);
+    REQUIRE(q_graph.get_connection_weight(Qubit(1), Qubit(2)) == 2);
+  }
+  GIVEN("A circuit") {
+    Circuit circ(4);
+    add_2qb_gates(circ, OpType::CX, {{0, 1}, {2, 3}, {1, 0}, {1, 2}, {3, 0}});
+    QubitGraph q_graph = monomorph_interaction_graph(circ, 10, 5);
+    // Weighted by the slice in which each pair first interacts
+    REQUIRE(q_graph.get_connection_weight(Qubit(0), Qubit(1)) == 1);
+    REQUIRE(q_graph.get_connection_weight(Qubit(1), Qubit(0)) == 0);
+    REQUIRE(q_graph.get_connection_weight(Qubit(2), Qubit(3)) == 1);
+    REQUIRE(q_graph.get_connection_weight(Qubit(1), Qubit(2)) == 3);
+    REQUIRE(q_graph.get_connection_weight(Qubit(3), Qubit(0)) == 3);
+    REQUIRE(q_graph.n_connections() == 4);
+    // The edge budget is checked once per slice
+    REQUIRE(monomorph_interaction_graph(circ, 1, 5).n_connections() == 2);
+  }
+}
+
 // Tests for new placement method wrappers
 
 SCENARIO(
@@ -610,6 +754,47 @@ SCENARIO(
       REQUIRE(test_m.at(all_qs[pair.first]) == Node(pair.second));
     }
   }
+  GIVEN("Circuits of the same structure placed with a cache") {
+    auto cache = std::make_shared<PlacementCache>();
+    test_p.set_cache(cache);
+    std::vector<Circuit> circs;
+    for (double angle : {0.1, 0.7}) {
+      Circuit test_circ(6);
+      add_2qb_gates(
+          test_circ, OpType::CX,
+          {{0, 1}, {2, 1}, {3, 1}, {2, 5}, {3, 4}, {0, 5}});
+      test_circ.add_op<unsigned>(OpType::Rz, angle, {2});
+      circs.push_back(test_circ);
+    }
+    const qubit_mapping_t first = test_p.get_placement_map(circs[0]);
+    REQUIRE(cache->size() == 1);
+    const qubit_mapping_t second = test_p.get_placement_map(circs[1]);
+    CHECK(cache->size() == 1);
+    CHECK(first == second);
+
+    Circuit other(6);
+    add_2qb_gates(other, OpType::CX, {{0, 1}, {1, 2}, {2, 3}});
+    test_p.get_placement_map(other);
+    CHECK(cache->size() == 2);
+
+    const std::string filename =
+        (std::filesystem::temp_directory_path() / "tket_placement_cache.json")
+            .string();
+    cache->save(filename);
+    PlacementCache loaded;
+    loaded.load(filename);
+    std::filesystem::remove(filename);
+    REQUIRE(loaded.size() == 2);
+    QubitGraph q_graph =
+        monomorph_interaction_graph(circs[0], test_arc.n_connections(), 5);
+    std::optional<qubit_mapping_t> hit = loaded.find(
+        PlacementCache::fingerprint(q_graph, test_arc, test_p.get_config()));
+    REQUIRE(hit);
+    for (const auto& [qb, node] : *hit) {
+      CHECK(first.at(qb) == node);
+    }
+    REQUIRE_THROWS_AS(loaded.load(filename), PlacementError);
+  }
 }
 
 SCENARIO(
@@ -674,5 +859,61 @@ SCENARIO(
   }
 }
 
+SCENARIO("Can placement maps be refined by annealing?") {
+  Architecture line({{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}});
+  Circuit circ(6);
+  for (unsigned r = 0; r < 3; r++) {
+    for (unsigned i = 0; i < 5; i++) {
+      circ.add_op<unsigned>(OpType::CX, {i, i + 1});
+    }
+  }
+  qubit_mapping_t identity;
+  qubit_mapping_t scrambled;
+  for (unsigned i = 0; i < 6; i++) {
+    identity.insert({Qubit(i), Node(i)});
+    scrambled.insert({Qubit(i), Node((5 * i + 1) % 6)});
+  }
+  PlacementRefinementConfig config;
+  config.budget = 600000;
+  config.max_steps = 20000;
+  config.n_chains = 4;
+  // Every interacting pair is adjacent under the identity, so it is optimal
+  const double best = placement_interaction_cost(circ, line, identity, 20);
+  REQUIRE(best > 0.);
+  GIVEN("A poor starting map") {
+    const double start = placement_interaction_cost(circ, line, scrambled, 20);
+    REQUIRE(start > best);
+    const qubit_mapping_t refined =
+        refine_placement(circ, line, {scrambled}, config);
+    CHECK(placement_interaction_cost(circ, line, refined, 20) == best);
+    REQUIRE(refined.size() == 6);
+    node_set_t used;
+    for (const auto& [qb, node] : refined) used.insert(node);
+    CHECK(used.size() == 6);
+    THEN("The result does not depend on the number of threads") {
+      set_max_threads(1);
+      CHECK(refine_placement(circ, line, {scrambled}, config) == refined);
+      set_max_threads(0);
+    }
+  }
+  GIVEN("Starting maps including an optimal one") {
+    const qubit_mapping_t refined =
+        refine_placement(circ, line, {scrambled, identity}, config);
+    CHECK(placement_interaction_cost(circ, line, refined, 20) == best);
+  }
+  GIVEN("A starting map leaving interacting qubits unplaced") {
+    qubit_mapping_t partial = scrambled;
+    partial.erase(Qubit(2));
+    partial.erase(Qubit(3));
+    const qubit_mapping_t refined =
+        refine_placement(circ, line, {partial}, config);
+    REQUIRE(refined.size() == 6);
+    CHECK(placement_interaction_cost(circ, line, refined, 20) == best);
+  }
+  GIVEN("No starting maps") {
+    REQUIRE_THROWS_AS(refine_placement(circ, line, {}, config), PlacementError);
+  }
+}
+
 }  // namespace test_Placement
 }  // namespace tket
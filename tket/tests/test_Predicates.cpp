@@ -15,7 +15,9 @@
 #include <catch2/catch.hpp>
 
 #include "Predicates/CompilationUnit.hpp"
+#include "Predicates/PassLibrary.hpp"
 #include "Predicates/Predicates.hpp"
+#include "Utils/Parallel.hpp"
 #include "testutil.hpp"
 
 namespace tket {
@@ -40,6 +42,29 @@ SCENARIO("Test out basic Predicate useage") {
     PredicatePtr gsp3 = std::make_shared<GateSetPredicate>(ots3);
     REQUIRE(!gsp2->implies(*gsp3));
   }
+  GIVEN("GateSetPredicate on a changing circuit") {
+    PredicatePtr gsp = std::make_shared<GateSetPredicate>(
+        OpTypeSet{OpType::CX, OpType::Measure});
+    PredicatePtr with_x = std::make_shared<GateSetPredicate>(
+        OpTypeSet{OpType::CX, OpType::Measure, OpType::X});
+    Circuit circ(2, 1);
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_barrier(uvec{0, 1});
+    circ.add_measure(0, 0);
+    REQUIRE(gsp->verify(circ));
+    // Conditional operations count as the operation they condition
+    Vertex x = circ.add_conditional_gate<unsigned>(OpType::X, {}, {1}, {0}, 1);
+    REQUIRE(!gsp->verify(circ));
+    REQUIRE(with_x->verify(circ));
+    circ.remove_vertex(
+        x, Circuit::GraphRewiring::Yes, Circuit::VertexDeletion::Yes);
+    REQUIRE(gsp->verify(circ));
+    Vertex h = circ.add_op<unsigned>(OpType::H, {1});
+    REQUIRE(!gsp->verify(circ));
+    circ.set_vertex_Op_ptr(h, get_op_ptr(OpType::X));
+    REQUIRE(!gsp->verify(circ));
+    REQUIRE(with_x->verify(circ));
+  }
   GIVEN("NoClassicalControlPredicate") {
     PredicatePtr pp = std::make_shared<NoClassicalControlPredicate>();
     Circuit circ(1, 1);
@@ -235,6 +260,44 @@ SCENARIO("Test routing-related predicates' meet and implication") {
   }
 }
 
+SCENARIO("Routing-related predicates on large circuits") {
+  std::vector<std::pair<unsigned, unsigned>> edges;
+  for (unsigned i = 0; i + 1 < 20; ++i) edges.push_back({i, i + 1});
+  Architecture line(edges);
+  PredicatePtr connected = std::make_shared<ConnectivityPredicate>(line);
+  PredicatePtr directed = std::make_shared<DirectednessPredicate>(line);
+  Circuit circ(20, 1);
+  for (unsigned i = 0; i < 2000; ++i) {
+    const unsigned q = (7 * i) % 19;
+    circ.add_op<unsigned>(OpType::CX, {q, q + 1});
+    circ.add_op<unsigned>(OpType::Rz, 0.1, {q});
+  }
+  circ.add_conditional_gate<unsigned>(OpType::CX, {}, {3, 4}, {0}, 1);
+  reassign_boundary(circ);
+  for (unsigned n_threads : {1u, 4u}) {
+    set_max_threads(n_threads);
+    GIVEN("A circuit of CXs along the edges") {
+      CHECK(connected->verify(circ));
+      CHECK(directed->verify(circ));
+    }
+    GIVEN("A conditional CX against its edge") {
+      circ.add_conditional_gate<unsigned>(OpType::CX, {}, {5, 4}, {0}, 1);
+      CHECK(connected->verify(circ));
+      CHECK_FALSE(directed->verify(circ));
+    }
+    GIVEN("A CX between nodes that are not adjacent") {
+      circ.add_op<unsigned>(OpType::CX, {2, 4});
+      CHECK_FALSE(connected->verify(circ));
+      CHECK_FALSE(directed->verify(circ));
+    }
+    GIVEN("A qubit that is not a node") {
+      circ.add_qubit(Qubit("extra", 0));
+      CHECK_FALSE(connected->verify(circ));
+    }
+  }
+  set_max_threads(0);
+}
+
 SCENARIO("Test basic functionality of CompilationUnit") {
   GIVEN("A satisfied/unsatisfied predicate in a CompilationUnit") {
     OpTypeSet ots = {OpType::CX};
@@ -383,5 +446,111 @@ SCENARIO("Verifying whether or not circuits have mid-circuit measurements") {
   }
 }
 
+// Counts how many times it is evaluated
+class CountingPredicate : public Predicate {
+ public:
+  explicit CountingPredicate(unsigned& count) : count_(count) {}
+  bool verify(const Circuit& circ) const override {
+    ++count_;
+    return circ.n_gates() < 3;
+  }
+  bool implies(const Predicate&) const override { return false; }
+  PredicatePtr meet(const Predicate&) const override { return nullptr; }
+  std::string to_string() const override { return "CountingPredicate"; }
+
+ private:
+  unsigned& count_;
+};
+
+SCENARIO("Predicate results are reused until the circuit changes") {
+  Circuit c(2);
+  c.add_op<unsigned>(OpType::H, {0});
+  c.add_op<unsigned>(OpType::H, {0});
+  c.add_op<unsigned>(OpType::X, {1});
+  GIVEN("A circuit version") {
+    Circuit::Version version = c.get_version();
+    REQUIRE(c.has_version(version));
+    std::map<Qubit, Qubit> qmap = {{Qubit(0), Qubit(1)}, {Qubit(1), Qubit(0)}};
+    c.rename_units(qmap);
+    REQUIRE_FALSE(c.has_version(version));
+  }
+  GIVEN("Repeated evaluations of a predicate") {
+    unsigned count = 0;
+    PredicatePtr pred = std::make_shared<CountingPredicate>(count);
+    CompilationUnit cu(c);
+    REQUIRE_FALSE(cu.calc_predicate(pred));
+    REQUIRE_FALSE(cu.calc_predicate(pred));
+    REQUIRE(count == 1);
+    // Evaluating by reference is never memoised
+    REQUIRE_FALSE(cu.calc_predicate(*pred));
+    REQUIRE(count == 2);
+    REQUIRE(RemoveRedundancies()->apply(cu));
+    REQUIRE(cu.calc_predicate(pred));
+    REQUIRE(count == 3);
+    REQUIRE_FALSE(RemoveRedundancies()->apply(cu));
+    REQUIRE(cu.calc_predicate(pred));
+    REQUIRE(count == 3);
+  }
+}
+
+SCENARIO("Implications between predicates of different classes") {
+  GIVEN("Predicates implied by a gate set") {
+    GateSetPredicate gates({OpType::CX, OpType::H, OpType::Measure});
+    REQUIRE(predicate_implies(gates, MaxTwoQubitGatesPredicate()));
+    REQUIRE(predicate_implies(gates, GlobalPhasedXPredicate()));
+    GateSetPredicate more({OpType::CX, OpType::H, OpType::Measure, OpType::Rz});
+    REQUIRE(predicate_implies(gates, more));
+    REQUIRE_FALSE(predicate_implies(gates, NoClassicalControlPredicate()));
+    GateSetPredicate wide({OpType::CX, OpType::CCX});
+    REQUIRE_FALSE(predicate_implies(wide, MaxTwoQubitGatesPredicate()));
+    GateSetPredicate boxes({OpType::CX, OpType::CircBox});
+    REQUIRE_FALSE(predicate_implies(boxes, MaxTwoQubitGatesPredicate()));
+    GateSetPredicate global({OpType::NPhasedX});
+    REQUIRE_FALSE(predicate_implies(global, GlobalPhasedXPredicate()));
+  }
+  GIVEN("Predicates implied by having no bits") {
+    NoClassicalBitsPredicate no_bits;
+    REQUIRE(predicate_implies(no_bits, NoClassicalControlPredicate()));
+    REQUIRE(predicate_implies(no_bits, NoFastFeedforwardPredicate()));
+    REQUIRE(predicate_implies(no_bits, NoMidMeasurePredicate()));
+    REQUIRE_FALSE(predicate_implies(no_bits, MaxTwoQubitGatesPredicate()));
+  }
+  GIVEN("Connectivity implied by directedness") {
+    Architecture arc({{0, 1}, {1, 2}});
+    Architecture reversed({{1, 0}, {2, 1}});
+    Architecture smaller({{0, 1}});
+    DirectednessPredicate directed(arc);
+    REQUIRE(predicate_implies(directed, ConnectivityPredicate(arc)));
+    REQUIRE(predicate_implies(directed, ConnectivityPredicate(reversed)));
+    REQUIRE_FALSE(predicate_implies(directed, ConnectivityPredicate(smaller)));
+  }
+  GIVEN("A precondition implied by the guarantee of an earlier pass") {
+    PredicatePtr gates =
+        std::make_shared<GateSetPredicate>(OpTypeSet{OpType::CX, OpType::H});
+    PredicatePtr max2 = std::make_shared<MaxTwoQubitGatesPredicate>();
+    // A pass breaking its own guarantee shows that the precondition of the
+    // next is taken from the cache rather than the circuit
+    PassPtr guarantee = std::make_shared<StandardPass>(
+        PredicatePtrMap{},
+        Transform([](Circuit& circ) {
+          circ.add_op<unsigned>(OpType::CCX, {0, 1, 2});
+          return true;
+        }),
+        PostConditions{
+            {CompilationUnit::make_type_pair(gates)}, {}, Guarantee::Preserve},
+        nlohmann::json{});
+    PassPtr require = std::make_shared<StandardPass>(
+        PredicatePtrMap{CompilationUnit::make_type_pair(max2)}, Transform::id,
+        PostConditions{{}, {}, Guarantee::Preserve}, nlohmann::json{});
+    Circuit circ(3);
+    circ.add_op<unsigned>(OpType::H, {0});
+    CompilationUnit cu(circ);
+    REQUIRE(guarantee->apply(cu));
+    REQUIRE_NOTHROW(require->apply(cu));
+    CompilationUnit unguaranteed(cu.get_circ_ref());
+    REQUIRE_THROWS_AS(require->apply(unguaranteed), UnsatisfiedPredicate);
+  }
+}
+
 }  // namespace test_Predicates
 }  // namespace tket
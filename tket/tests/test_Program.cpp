@@ -12,8 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <catch2/catch.hpp>
+#include <span>
 
+#include "Predicates/PassGenerators.hpp"
+#include "Predicates/PassLibrary.hpp"
+#include "Predicates/ProgramCompilation.hpp"
+#include "Program/CompiledProgram.hpp"
 #include "Program/Program.hpp"
 #include "testutil.hpp"
 
@@ -302,6 +308,15 @@ static void test_command_types_sequence(
     ++cit;
   }
   CHECK(cit == p.end());
+  // The compiled view generates the same commands
+  CompiledProgram compiled(p);
+  const std::vector<Command>& commands = compiled.get_commands();
+  REQUIRE(commands.size() == expected_types.size());
+  cit = p.begin();
+  for (const Command& com : commands) {
+    CHECK(com.to_str() == cit->to_str());
+    ++cit;
+  }
 }
 
 SCENARIO("Command iteration") {
@@ -434,5 +449,103 @@ SCENARIO("Command iteration") {
   }
 }
 
+SCENARIO("Compiled program queries") {
+  GIVEN("A while loop") {
+    Program p(2, 2);
+    p.add_op(OpType::X, uvec{0});
+    p.add_op(OpType::Measure, uvec{0, 0});
+    Program whilebody(2, 2);
+    whilebody.add_op(OpType::H, uvec{0});
+    whilebody.add_op(OpType::Measure, uvec{0, 0});
+    p.append_while(Bit(0), whilebody);
+    CompiledProgram compiled(p);
+    unsigned n = 0;
+    for (Program::BlockIterator it = p.block_begin(); it != p.block_end();
+         ++it) {
+      REQUIRE(compiled.get_vertex(n) == *it);
+      REQUIRE(compiled.get_condition(n) == p.get_condition(*it));
+      REQUIRE(compiled.get_successors(n).size() == p.n_out_edges(*it));
+      for (unsigned s : compiled.get_successors(n)) {
+        if (s == compiled.exit_block()) continue;
+        std::span<const unsigned> preds = compiled.get_predecessors(s);
+        REQUIRE(std::find(preds.begin(), preds.end(), n) != preds.end());
+      }
+      std::span<const Command> block_commands =
+          compiled.get_block_commands(n);
+      REQUIRE(block_commands.size() == p.get_circuit_ref(*it).n_gates());
+      ++n;
+    }
+    REQUIRE(compiled.n_blocks() == n);
+    THEN("Branch successors agree") {
+      for (unsigned b = 0; b < n; ++b) {
+        FGVert target = p.get_branch_successor(compiled.get_vertex(b));
+        unsigned succ = compiled.get_branch_successor(b);
+        if (succ == compiled.exit_block()) {
+          REQUIRE(p.get_successors(target).empty());
+        } else {
+          REQUIRE(compiled.get_vertex(succ) == target);
+        }
+        if (compiled.get_condition(b)) {
+          REQUIRE(
+              compiled.get_vertex(compiled.get_branch_successor(b, true)) ==
+              p.get_branch_successor(compiled.get_vertex(b), true));
+        } else {
+          REQUIRE_THROWS_AS(
+              compiled.get_branch_successor(b, true), ProgramError);
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Compiling the blocks of a program") {
+  Program p(3, 2);
+  p.add_op(OpType::H, uvec{0});
+  p.add_op(OpType::H, uvec{0});
+  p.add_op(OpType::CX, uvec{0, 1});
+  p.add_op(OpType::Measure, uvec{0, 0});
+  Program whilebody(3, 2);
+  whilebody.add_op(OpType::X, uvec{2});
+  whilebody.add_op(OpType::X, uvec{2});
+  whilebody.add_op(OpType::CX, uvec{1, 2});
+  whilebody.add_op(OpType::Measure, uvec{1, 0});
+  p.append_while(Bit(0), whilebody);
+  GIVEN("A pass that keeps the labelling") {
+    REQUIRE(compile_program(p, RemoveRedundancies()));
+    for (Program::BlockIterator it = p.block_begin(); it != p.block_end();
+         ++it) {
+      const Circuit& circ = it.get_circuit_ref();
+      REQUIRE(circ.count_gates(OpType::H) == 0);
+      REQUIRE(circ.count_gates(OpType::X) == 0);
+    }
+    REQUIRE(p.check_valid());
+    REQUIRE_FALSE(compile_program(p, RemoveRedundancies()));
+  }
+  GIVEN("A pass that relabels qubits") {
+    std::map<Qubit, Qubit> qm{{Qubit(0), Qubit("a", 0)}};
+    REQUIRE_THROWS_AS(
+        compile_program(p, gen_rename_qubits_pass(qm)), ProgramError);
+    // The program is unchanged
+    REQUIRE(p.all_qubits().front() == Qubit(0));
+    REQUIRE(
+        p.get_circuit_ref(*p.block_begin()).count_gates(OpType::H) == 2);
+  }
+  GIVEN("A placement shared by all blocks") {
+    Architecture arc({{Node(0), Node(1)}, {Node(1), Node(2)}});
+    GraphPlacement placement(arc);
+    REQUIRE(place_program(p, placement));
+    std::set<Qubit> nodes;
+    for (const Qubit& qb : p.all_qubits()) nodes.insert(qb);
+    for (Program::BlockIterator it = p.block_begin(); it != p.block_end();
+         ++it) {
+      for (const Qubit& qb : it.get_circuit_ref().all_qubits()) {
+        REQUIRE(nodes.count(qb) == 1);
+      }
+    }
+    REQUIRE(nodes.size() == 3);
+    REQUIRE(p.check_valid());
+  }
+}
+
 }  // namespace test_Program
 }  // namespace tket
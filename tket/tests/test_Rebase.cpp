@@ -306,6 +306,107 @@ SCENARIO("Building rebases with rebase_factory") {
     correct.add_phase(0.625);
     REQUIRE(circ == correct);
   }
+  GIVEN("A circuit repeating the same gates") {
+    Circuit circ(3);
+    for (unsigned i = 0; i < 20; ++i) {
+      circ.add_op<unsigned>(OpType::H, {i % 3});
+      circ.add_op<unsigned>(OpType::CZ, {i % 3, (i + 1) % 3});
+      circ.add_op<unsigned>(OpType::Rz, 0.3, {(i + 2) % 3});
+      circ.add_op<unsigned>(OpType::CRz, 0.3, {(i + 1) % 3, i % 3});
+    }
+    const auto s0 = tket_sim::get_statevector(circ);
+    Circuit hqs = circ;
+    REQUIRE(Transform::rebase_tket().apply(circ));
+    REQUIRE(circ.count_gates(OpType::CX) == 60);
+    REQUIRE(circ.count_gates(OpType::tk1) + circ.count_gates(OpType::CX) ==
+            circ.n_gates());
+    const auto s1 = tket_sim::get_statevector(circ);
+    REQUIRE(tket_sim::compare_statevectors_or_unitaries(s0, s1));
+    REQUIRE(Transform::rebase_HQS().apply(hqs));
+    REQUIRE(hqs.count_gates(OpType::ZZMax) == 60);
+    const auto s2 = tket_sim::get_statevector(hqs);
+    REQUIRE(tket_sim::compare_statevectors_or_unitaries(s0, s2));
+  }
+  GIVEN("A gate in an opgroup") {
+    Circuit circ(1);
+    circ.add_op<unsigned>(OpType::H, {0}, "g");
+    circ.add_op<unsigned>(OpType::H, {0});
+    REQUIRE(Transform::rebase_tket().apply(circ));
+    Circuit correct(1);
+    correct.add_op<unsigned>(OpType::tk1, {0.5, 0.5, 0.5}, {0});
+    correct.add_op<unsigned>(OpType::tk1, {0.5, 0.5, 0.5}, {0});
+    correct.add_phase(1.);
+    REQUIRE(circ == correct);
+  }
+}
+
+SCENARIO("Rebasing with a choice of replacements") {
+  Node n0{0}, n1{1};
+  op_node_errors_t ne;
+  for (const Node& n : {n0, n1}) {
+    ne[n] = {{OpType::Rz, 0.001}, {OpType::Rx, 0.1}, {OpType::PhasedX, 0.01}};
+  }
+  op_link_errors_t le{{{n0, n1}, {{OpType::CX, 0.02}, {OpType::CZ, 0.05}}}};
+  DeviceCharacterisation characterisation(ne, le);
+  auto cost = Transform::rebase_error_cost(characterisation);
+  Circuit cx_direct(2);
+  cx_direct.add_op<unsigned>(OpType::CX, {0, 1});
+  Circuit cx_via_cz(2);
+  cx_via_cz.add_op<unsigned>(OpType::H, {1});
+  cx_via_cz.add_op<unsigned>(OpType::CZ, {0, 1});
+  cx_via_cz.add_op<unsigned>(OpType::H, {1});
+  GIVEN("A cost model favouring PhasedX") {
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::CY, {0, 1});
+    circ.add_op<unsigned>(OpType::Ry, 0.3, {1});
+    circ.add_op<unsigned>(OpType::H, {0});
+    const auto u0 = tket_sim::get_unitary(circ);
+    Transform t = Transform::rebase_factory(
+        {OpType::CX, OpType::CZ}, {cx_via_cz, cx_direct},
+        {OpType::Rz, OpType::Rx, OpType::PhasedX, OpType::H},
+        {Transform::tk1_to_rzrx, Transform::tk1_to_PhasedXRz}, cost);
+    REQUIRE(t.apply(circ));
+    REQUIRE(circ.count_gates(OpType::Rx) == 0);
+    REQUIRE(circ.count_gates(OpType::PhasedX) > 0);
+    REQUIRE(circ.count_gates(OpType::CZ) == 0);
+    REQUIRE(circ.count_gates(OpType::CX) == 1);
+    const auto u1 = tket_sim::get_unitary(circ);
+    REQUIRE(tket_sim::compare_statevectors_or_unitaries(u0, u1));
+  }
+  GIVEN("Equal costs") {
+    auto no_cost = [](const Circuit&) { return 0.; };
+    auto three_gates = [](const Expr& a, const Expr& b, const Expr& c) {
+      Circuit replacement(1);
+      replacement.add_op<unsigned>(OpType::Rz, c, {0});
+      replacement.add_op<unsigned>(OpType::Rx, b, {0});
+      replacement.add_op<unsigned>(OpType::Rz, a, {0});
+      return replacement;
+    };
+    auto one_gate = [](const Expr& a, const Expr& b, const Expr& c) {
+      Circuit replacement(1);
+      replacement.add_op<unsigned>(OpType::tk1, {a, b, c}, {0});
+      return replacement;
+    };
+    Circuit circ(1);
+    circ.add_op<unsigned>(OpType::Ry, 0.3, {0});
+    const auto u0 = tket_sim::get_unitary(circ);
+    Transform t = Transform::rebase_factory(
+        {OpType::CX}, {cx_direct}, {OpType::Rz, OpType::Rx, OpType::tk1},
+        {three_gates, one_gate}, no_cost);
+    REQUIRE(t.apply(circ));
+    // The tie is broken by gate count.
+    REQUIRE(circ.n_gates() == 1);
+    REQUIRE(circ.count_gates(OpType::tk1) == 1);
+    const auto u1 = tket_sim::get_unitary(circ);
+    REQUIRE(tket_sim::compare_statevectors_or_unitaries(u0, u1));
+  }
+  GIVEN("No candidates") {
+    REQUIRE_THROWS_AS(
+        Transform::rebase_factory(
+            {OpType::CX}, {}, {OpType::tk1}, {Transform::tk1_to_tk1}, cost),
+        std::invalid_argument);
+  }
 }
 
 SCENARIO("Decompose all boxes") {
@@ -13,10 +13,12 @@
 // limitations under the License.
 
 #include <catch2/catch.hpp>
+#include <limits>
 #include <numeric>
 #include <optional>
 
 #include "Characterisation/DeviceCharacterisation.hpp"
+#include "Circuit/Boxes.hpp"
 #include "Circuit/Circuit.hpp"
 #include "OpType/OpType.hpp"
 #include "Predicates/CompilerPass.hpp"
@@ -28,6 +30,7 @@
 #include "Simulation/ComparisonFunctions.hpp"
 #include "Transformations/Transform.hpp"
 #include "Utils/HelperFunctions.hpp"
+#include "Utils/Parallel.hpp"
 #include "testutil.hpp"
 
 namespace tket {
@@ -108,12 +111,14 @@ qubit_bimap_t RoutingTester::set_default_initial_map(
     node++;
   }
   router->init_map = qmap;
-  router->qmap = qmap;
+  router->qmap.assign(qmap);
+  router->interaction_current_ = false;
   return qmap;
 }
 
 void RoutingTester::initialise_slicefrontier() {
   router->slice_frontier_.init();
+  router->interaction_current_ = false;
 }
 
 void RoutingTester::add_distributed_cx(
@@ -132,8 +137,19 @@ void RoutingTester::advance_frontier() { router->advance_frontier(); }
 void RoutingTester::set_interaction() {
   router->interaction =
       router->generate_interaction_frontier(router->slice_frontier_);
+  router->interaction_current_ = false;
+}
+void RoutingTester::set_qmap(qubit_bimap_t _qmap) {
+  router->qmap.assign(_qmap);
+  router->interaction_current_ = false;
+}
+void RoutingTester::add_swap(const Swap &nodes) { router->add_swap(nodes); }
+bool RoutingTester::interaction_matches_frontier() {
+  const Interactions inter =
+      router->generate_interaction_frontier(router->slice_frontier_);
+  return router->interaction == inter &&
+         router->dist_vector == router->generate_distance_vector(inter);
 }
-void RoutingTester::set_qmap(qubit_bimap_t _qmap) { router->qmap = _qmap; }
 void RoutingTester::set_config(const RoutingConfig &_config) {
   router->config_ = _config;
 }
@@ -232,6 +248,35 @@ SCENARIO(
     reassign_boundary(circ);
     REQUIRE(respects_connectivity_constraints(circ, arc, false));
   }
+  GIVEN("Nested boxes placed several times") {
+    Circuit inner(2);
+    inner.add_op<unsigned>(OpType::CX, {0, 1});
+    const CircBox inner_box(inner);
+    Circuit outer(2);
+    outer.add_op<unsigned>(OpType::H, {0});
+    outer.add_box(inner_box, {1, 0});
+    const CircBox outer_box(outer);
+    Circuit circ(3);
+    circ.add_box(inner_box, {1, 0});
+    circ.add_box(outer_box, {0, 1});
+    circ.add_box(outer_box, {2, 1});
+    WHEN("Every placement is on connected nodes") {
+      reassign_boundary(circ);
+      REQUIRE(respects_connectivity_constraints(circ, arc, false));
+      REQUIRE(respects_connectivity_constraints(circ, arc, true));
+    }
+    WHEN("One placement reverses a directed edge") {
+      circ.add_box(outer_box, {1, 0});
+      reassign_boundary(circ);
+      REQUIRE(respects_connectivity_constraints(circ, arc, false));
+      REQUIRE_FALSE(respects_connectivity_constraints(circ, arc, true));
+    }
+    WHEN("One placement is on unconnected nodes") {
+      circ.add_box(outer_box, {0, 2});
+      reassign_boundary(circ);
+      REQUIRE_FALSE(respects_connectivity_constraints(circ, arc, false));
+    }
+  }
 }
 
 SCENARIO("Test decompose_SWAP_to_CX pass", "[routing]") {
@@ -482,6 +527,119 @@ SCENARIO("Test redirect_CX_gates pass", "[routing]") {
     Transform::decompose_CX_directed(grid).apply(circ);
     REQUIRE(respects_connectivity_constraints(circ, grid, true));
   }
+  GIVEN("Many CX gates in both directions") {
+    Architecture line({{0, 1}, {1, 2}, {2, 3}, {3, 4}});
+    Circuit circ(5);
+    unsigned n_reversed = 0;
+    for (unsigned i = 0; i < 200; ++i) {
+      const unsigned q = i % 4;
+      if (i % 3 == 0) {
+        add_2qb_gates(circ, OpType::CX, {{q + 1, q}});
+        n_reversed++;
+      } else {
+        add_2qb_gates(circ, OpType::CX, {{q, q + 1}});
+      }
+    }
+    reassign_boundary(circ);
+    std::optional<Circuit> first;
+    for (unsigned n_threads : {1u, 4u}) {
+      set_max_threads(n_threads);
+      Circuit redirected = circ;
+      REQUIRE(Transform::decompose_CX_directed(line).apply(redirected));
+      CHECK(respects_connectivity_constraints(redirected, line, true));
+      CHECK(redirected.count_gates(OpType::CX) == 200);
+      CHECK(redirected.count_gates(OpType::H) == 4 * n_reversed);
+      if (first) {
+        CHECK(redirected == *first);
+      } else {
+        first = redirected;
+      }
+    }
+    set_max_threads(0);
+  }
+}
+
+SCENARIO("Does routing for directed CXs respect edge directions?") {
+  Architecture arc(
+      {{0, 1}, {2, 1}, {2, 3}, {4, 3}, {4, 5}, {0, 5}, {1, 4}, {3, 0}});
+  Circuit circ(6);
+  for (unsigned i = 0; i < 30; ++i) {
+    circ.add_op<unsigned>(OpType::CX, {(i * 5) % 6, (i * 5 + 2 + i % 3) % 6});
+  }
+  GIVEN("A routing configuration for directed CXs") {
+    RoutingConfig config;
+    config.directed_cx = true;
+    nlohmann::json j = config;
+    CHECK(j.at("directed_cx").get<bool>());
+    CHECK(j.get<RoutingConfig>() == config);
+    for (RoutingEngine engine :
+         {RoutingEngine::CowtanEtAl, RoutingEngine::Sabre}) {
+      config.engine = engine;
+      Circuit placed = circ;
+      LinePlacement(arc).place(placed);
+      Routing router(placed, arc);
+      Circuit routed = router.solve(config).first;
+      CHECK(respects_connectivity_constraints(routed, arc, false, true));
+    }
+  }
+  GIVEN("The directed CX routing pass") {
+    PassPtr pass =
+        gen_placement_pass(std::make_shared<LinePlacement>(arc)) >>
+        gen_directed_cx_routing_pass(arc);
+    CompilationUnit cu(circ);
+    pass->apply(cu);
+    CHECK(respects_connectivity_constraints(cu.get_circ_ref(), arc, true));
+  }
+}
+
+SCENARIO("Does noise-aware routing avoid noisy links?") {
+  // A ring, where the path 0-5-4-3 is much noisier than 0-1-2-3
+  Architecture ring({{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}, {5, 0}});
+  const std::set<std::pair<unsigned, unsigned>> good = {
+      {0, 1}, {1, 2}, {2, 3}};
+  avg_link_errors_t link_errors;
+  for (const std::pair<Node, Node> &link : ring.get_all_edges_vec()) {
+    const std::pair<unsigned, unsigned> ends = {
+        link.first.index()[0], link.second.index()[0]};
+    link_errors[link] = good.count(ends) ? 0.001 : 0.1;
+  }
+  Circuit circ(6);
+  add_2qb_gates(circ, OpType::CX, {{0, 3}, {0, 3}});
+  qubit_mapping_t map;
+  for (unsigned i = 0; i < 6; ++i) map.insert({Qubit(i), Node(i)});
+  Placement::place_with_map(circ, map);
+  GIVEN("The distances weighted by the link errors") {
+    RoutingContext context(ring, link_errors);
+    std::shared_ptr<const graphs::DistanceMatrix<Node>> weighted =
+        context.get_error_weighted_distance_matrix();
+    REQUIRE(weighted);
+    CHECK(weighted->get_distance(Node(0), Node(1)) == 1);
+    CHECK(weighted->get_distance(Node(0), Node(3)) == 3);
+    CHECK(weighted->get_distance(Node(0), Node(5)) > 1);
+    CHECK_FALSE(RoutingContext(ring).get_error_weighted_distance_matrix());
+  }
+  GIVEN("A routing configuration with link errors") {
+    RoutingConfig config;
+    config.link_errors = link_errors;
+    nlohmann::json j = config;
+    CHECK(j.get<RoutingConfig>() == config);
+    for (RoutingEngine engine :
+         {RoutingEngine::CowtanEtAl, RoutingEngine::Sabre}) {
+      config.engine = engine;
+      config.sabre_refinement_passes = 0;
+      Routing router(circ, ring);
+      const Circuit routed = router.solve(config).first;
+      CHECK(respects_connectivity_constraints(routed, ring, false, true));
+      for (const Command &com : routed) {
+        const unit_vector_t args = com.get_args();
+        if (args.size() != 2) continue;
+        std::pair<unsigned, unsigned> ends = {
+            Node(args[0]).index()[0], Node(args[1]).index()[0]};
+        if (ends.first > ends.second) std::swap(ends.first, ends.second);
+        CHECK(good.count(ends));
+      }
+    }
+  }
 }
 
 SCENARIO("Test RoutingFrontiers and interaction vectors", "[routing]") {
@@ -1306,6 +1464,59 @@ SCENARIO(
   }
 }
 
+SCENARIO(
+    "Does the heuristic pick the same swaps for many candidates in parallel?",
+    "[routing]") {
+  Circuit test_circuit(2);
+  SquareGrid test_architecture(20, 20);
+  node_vector_t square_nodes = test_architecture.get_all_nodes_vec();
+  Routing test_router(test_circuit, test_architecture);
+  RoutingTester routing_tester(&test_router);
+  const unsigned n = square_nodes.size();
+  Interactions test_interaction;
+  // Pair up nodes 3k and 3k + 1, leaving every third node idle.
+  for (unsigned i = 0; i < n; ++i) {
+    unsigned partner = (i % 3 == 2) ? i : (i % 3 == 0 ? i + 1 : i - 1);
+    if (partner >= n) partner = i;
+    test_interaction.insert({square_nodes[i], square_nodes[partner]});
+  }
+  const graphs::dist_vec base_dists =
+      routing_tester.generate_distance_vector(test_interaction);
+  std::vector<Swap> candidates;
+  for (auto [n1, n2] : test_architecture.get_all_edges_vec()) {
+    candidates.push_back({n1, n2});
+  }
+  REQUIRE(candidates.size() > 256);
+
+  // Reference: score each candidate from a full copy of the distance vector.
+  std::vector<Swap> remaining = candidates;
+  const Swap first = remaining.back();
+  remaining.pop_back();
+  graphs::dist_vec best = routing_tester.update_distance_vector(
+      first, base_dists, test_interaction);
+  std::vector<Swap> expected = {first};
+  for (const Swap &swap : remaining) {
+    const graphs::dist_vec dists = routing_tester.update_distance_vector(
+        swap, base_dists, test_interaction);
+    const int comp = tri_lexicographical_comparison(dists, best);
+    if (comp == -1) {
+      expected.push_back(swap);
+    } else if (comp == 1) {
+      expected = {swap};
+      best = dists;
+    }
+  }
+
+  for (unsigned n_threads : {1u, 4u}) {
+    set_max_threads(n_threads);
+    std::vector<Swap> trial = candidates;
+    CHECK(
+        routing_tester.cowtan_et_al_heuristic(
+            trial, base_dists, test_interaction) == expected);
+  }
+  set_max_threads(0);
+}
+
 // Routing::update_qmap
 SCENARIO("Does update qmap correctly update mapping from swap?", "[routing]") {
   // Creating RoutingTester object
@@ -1325,6 +1536,47 @@ SCENARIO("Does update qmap correctly update mapping from swap?", "[routing]") {
   REQUIRE(test_map.right.at(ring_nodes[1]) == qb0);
 }
 
+SCENARIO("Does QubitNodeMap track qubits and nodes in both directions?") {
+  const qubit_vector_t qbs = {Qubit(0), Qubit(1), Qubit(2)};
+  const node_vector_t nodes = {Node(0), Node(1), Node(2), Node(3)};
+  QubitNodeMap map(qbs, nodes);
+  CHECK(map.empty());
+  CHECK(map.insert(qbs[0], nodes[1]));
+  CHECK(map.insert(qbs[1], nodes[2]));
+  // As for a bimap, placed qubits and occupied nodes are left alone
+  CHECK_FALSE(map.insert(qbs[0], nodes[3]));
+  CHECK_FALSE(map.insert(qbs[2], nodes[2]));
+  CHECK(map.size() == 2);
+  CHECK(map.node_of(qbs[0]) == nodes[1]);
+  CHECK(map.qubit_on(nodes[2]) == qbs[1]);
+  CHECK(map.find_node(qbs[2]) == nullptr);
+  CHECK_FALSE(map.node_active(nodes[0]));
+  REQUIRE_THROWS_AS(map.qubit_on(nodes[0]), std::out_of_range);
+  GIVEN("Swaps of occupied and empty nodes") {
+    map.swap_nodes(nodes[1], nodes[2]);
+    CHECK(map.node_of(qbs[0]) == nodes[2]);
+    CHECK(map.node_of(qbs[1]) == nodes[1]);
+    map.swap_nodes(nodes[2], nodes[3]);
+    CHECK(map.node_of(qbs[0]) == nodes[3]);
+    CHECK_FALSE(map.node_active(nodes[2]));
+    const qubit_bimap_t bimap = map.to_bimap();
+    CHECK(bimap.size() == 2);
+    CHECK(bimap.left.at(qbs[0]) == nodes[3]);
+    CHECK(bimap.left.at(qbs[1]) == nodes[1]);
+  }
+  GIVEN("A bimap with qubits and nodes not given on construction") {
+    qubit_bimap_t bimap;
+    bimap.insert({Qubit("a", 0), Node(7)});
+    bimap.insert({qbs[2], nodes[0]});
+    map.assign(bimap);
+    CHECK(map.size() == 2);
+    CHECK(map.node_of(Qubit("a", 0)) == Node(7));
+    CHECK(map.qubit_on(nodes[0]) == qbs[2]);
+    CHECK_FALSE(map.node_active(nodes[1]));
+    CHECK(map.placed().front().first == Qubit("a", 0));
+  }
+}
+
 // Routing::solve_furthest interior functions
 SCENARIO(
     "Do solve_furthest interior methods find and swap along the expected "
@@ -1685,6 +1937,35 @@ SCENARIO(
     REQUIRE(tket_sim::compare_statevectors_or_unitaries(sv0, sv1));
     REQUIRE(post_aggregate > pre_aggregate);
   }
+  GIVEN("A run of gates carried along a long chain of SWAPs.") {
+    Architecture line({{0, 1}, {1, 2}, {2, 3}, {3, 4}});
+    op_node_errors_t line_errors;
+    for (unsigned n = 0; n < 5; ++n) {
+      line_errors[Node(n)] =
+          op_errors_t({{OpType::H, 0.1 * (5 - n)}, {OpType::X, 0.1}});
+    }
+    Circuit circ(5);
+    circ.add_op<unsigned>(OpType::X, {0});
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::H, {0});
+    add_2qb_gates(circ, OpType::SWAP, {{0, 1}, {1, 2}, {2, 3}, {3, 4}});
+    reassign_boundary(circ, line.get_all_nodes_vec());
+    Circuit before = circ;
+    Transform::decompose_SWAP_to_CX().apply(before);
+    const auto sv0 = tket_sim::get_statevector(before);
+
+    REQUIRE(Transform::commute_SQ_gates_through_SWAPS(line_errors).apply(circ));
+    // Both H gates go to the best node; the X gains nothing by moving
+    const qubit_vector_t qbs = circ.all_qubits();
+    require_arguments_for_specified_commands(
+        circ, {{OpType::H, qbs.at(4)}, {OpType::X, qbs.at(0)}});
+    Circuit after = circ;
+    Transform::decompose_SWAP_to_CX().apply(after);
+    REQUIRE(tket_sim::compare_statevectors_or_unitaries(
+        sv0, tket_sim::get_statevector(after)));
+    REQUIRE_FALSE(
+        Transform::commute_SQ_gates_through_SWAPS(line_errors).apply(circ));
+  }
 }
 SCENARIO("Test barrier is ignored by routing") {
   GIVEN("Circuit with 1qb barrier") {
@@ -1872,6 +2153,389 @@ SCENARIO(
   }
 }
 
+SCENARIO("Are interactions maintained incrementally through routing?") {
+  GIVEN("Many CX gates on a grid, routed by swapping along shortest paths") {
+    SquareGrid arc(3, 4);
+    Circuit circ(12);
+    for (unsigned i = 0; i < 60; ++i) {
+      const unsigned q0 = (7 * i + 3) % 12;
+      const unsigned q1 = (q0 + 1 + (5 * i) % 11) % 12;
+      circ.add_op<unsigned>(OpType::CX, {q0, q1});
+    }
+    Routing router(circ, arc);
+    RoutingTester test_router(&router);
+    test_router.set_default_initial_map(arc.get_all_nodes_vec());
+    test_router.initialise_slicefrontier();
+    test_router.advance_frontier();
+    REQUIRE(test_router.interaction_matches_frontier());
+    unsigned n_steps = 0;
+    while (!router.get_slicefrontier().slice->empty() && n_steps < 1000) {
+      // Swap one step along a path between the first distant pair.
+      const Interactions inter =
+          test_router.get_interaction(router.get_slicefrontier());
+      for (auto [n1, n2] : inter) {
+        if (arc.get_distance(n1, n2) > 1) {
+          const std::vector<Node> path = arc.get_path(n1, n2);
+          test_router.add_swap({path[0], path[1]});
+          break;
+        }
+      }
+      CHECK(test_router.interaction_matches_frontier());
+      test_router.advance_frontier();
+      CHECK(test_router.interaction_matches_frontier());
+      ++n_steps;
+    }
+    REQUIRE(router.get_slicefrontier().slice->empty());
+  }
+}
+
+SCENARIO("Does portfolio routing keep the cheapest result?") {
+  GIVEN("Two configurations and two placements on a grid") {
+    SquareGrid arc(3, 3);
+    Circuit circ(9);
+    for (unsigned i = 0; i < 40; ++i) {
+      const unsigned q0 = (5 * i + 1) % 9;
+      const unsigned q1 = (q0 + 1 + (4 * i) % 8) % 9;
+      circ.add_op<unsigned>(OpType::CX, {q0, q1});
+    }
+    const std::vector<RoutingConfig> configs = {
+        RoutingConfig(), RoutingConfig(1, 0, 0, 0)};
+    const std::vector<PlacementPtr> placements = {
+        std::make_shared<LinePlacement>(arc),
+        std::make_shared<GraphPlacement>(arc)};
+    unsigned best_cost = std::numeric_limits<unsigned>::max();
+    for (const RoutingConfig &config : configs) {
+      for (const PlacementPtr &placement : placements) {
+        Circuit placed = circ;
+        placement->place(placed);
+        Routing router(placed, arc);
+        router.solve(config);
+        const Routing::Stats stats = router.get_stats();
+        best_cost = std::min(best_cost, stats.swap_count + stats.bridge_count);
+      }
+    }
+    std::optional<PortfolioRoutingResult> first;
+    for (unsigned n_threads : {1u, 4u}) {
+      set_max_threads(n_threads);
+      const PortfolioRoutingResult result =
+          portfolio_route(circ, arc, configs, placements);
+      CHECK(result.stats.swap_count + result.stats.bridge_count == best_cost);
+      CHECK(respects_connectivity_constraints(result.circ, arc, false, true));
+      if (first) {
+        CHECK(result.config_index == first->config_index);
+        CHECK(result.placement_index == first->placement_index);
+        CHECK(result.circ == first->circ);
+      } else {
+        first = result;
+      }
+    }
+    set_max_threads(0);
+  }
+  GIVEN("No configurations") {
+    SquareGrid arc(2, 2);
+    Circuit circ(4);
+    REQUIRE_THROWS_AS(portfolio_route(circ, arc, {}), std::invalid_argument);
+  }
+}
+
+SCENARIO("Can a circuit be routed one window at a time?") {
+  GIVEN("A CX circuit on a grid") {
+    SquareGrid arc(3, 3);
+    Circuit circ(9);
+    for (unsigned i = 0; i < 40; ++i) {
+      const unsigned q0 = (5 * i + 1) % 9;
+      const unsigned q1 = (q0 + 1 + (4 * i) % 8) % 9;
+      circ.add_op<unsigned>(OpType::H, {q0});
+      circ.add_op<unsigned>(OpType::CX, {q0, q1});
+    }
+    const unsigned window_slices = 5;
+    std::vector<Circuit> windows;
+    const qubit_mapping_t final_map = route_in_windows(
+        circ, arc, window_slices,
+        [&windows](const Circuit &c) { windows.push_back(c); });
+    REQUIRE(windows.size() > 1);
+    unsigned n_cx = 0;
+    unsigned n_h = 0;
+    Circuit joined = windows.front();
+    for (unsigned i = 0; i < windows.size(); ++i) {
+      const Circuit &c = windows[i];
+      CHECK(respects_connectivity_constraints(c, arc, false, true));
+      n_cx += c.count_gates(OpType::CX) + 2 * c.count_gates(OpType::BRIDGE);
+      n_h += c.count_gates(OpType::H);
+      if (i > 0) joined.append(c);
+    }
+    CHECK(n_h == 40);
+    CHECK(n_cx == 40);
+    CHECK(joined.count_gates(OpType::H) == 40);
+    REQUIRE(final_map.size() == 9);
+    node_set_t used;
+    for (const std::pair<const Qubit, Qubit> &qn : final_map) {
+      CHECK(arc.node_exists(Node(qn.second)));
+      used.insert(Node(qn.second));
+    }
+    CHECK(used.size() == 9);
+  }
+  GIVEN("A window of no slices") {
+    SquareGrid arc(2, 2);
+    Circuit circ(4);
+    REQUIRE_THROWS_AS(
+        route_in_windows(circ, arc, 0, [](const Circuit &) {}),
+        std::invalid_argument);
+  }
+}
+
+SCENARIO("Can a window of an edited routed circuit be rerouted?") {
+  GIVEN("A gate between distant nodes added to a routed circuit") {
+    Architecture line({{0, 1}, {1, 2}, {2, 3}});
+    Circuit edited(4);
+    add_2qb_gates(
+        edited, OpType::CX, {{0, 1}, {2, 3}, {0, 3}, {0, 1}, {2, 3}});
+    edited.add_op<unsigned>(OpType::H, {3});
+    qubit_mapping_t map;
+    for (unsigned i = 0; i < 4; ++i) map.insert({Qubit(i), Node(i)});
+    Placement::place_with_map(edited, map);
+    const Circuit rerouted = reroute_slices(edited, line, 1, 1);
+    CHECK(respects_connectivity_constraints(rerouted, line, false, true));
+    CHECK(
+        rerouted.count_gates(OpType::CX) +
+            rerouted.count_gates(OpType::BRIDGE) ==
+        5);
+    CHECK(rerouted.count_gates(OpType::SWAP) % 2 == 0);
+    const std::vector<Command> before = edited.get_commands();
+    const std::vector<Command> after = rerouted.get_commands();
+    REQUIRE(after.size() > before.size());
+    for (unsigned i = 0; i < 2; ++i) CHECK(after[i] == before[i]);
+    for (unsigned i = 1; i <= 3; ++i) {
+      CHECK(after[after.size() - i] == before[before.size() - i]);
+    }
+    CHECK(tket_sim::compare_statevectors_or_unitaries(
+        tket_sim::get_unitary(edited), tket_sim::get_unitary(rerouted)));
+  }
+  GIVEN("Windows of a circuit routed with SWAPs") {
+    SquareGrid arc(3, 3);
+    Circuit circ(9);
+    for (unsigned i = 0; i < 30; ++i) {
+      const unsigned q0 = (4 * i + 2) % 9;
+      const unsigned q1 = (q0 + 1 + (5 * i) % 8) % 9;
+      circ.add_op<unsigned>(OpType::CX, {q0, q1});
+    }
+    Routing router(circ, arc);
+    const Circuit routed = router.solve().first;
+    REQUIRE(routed.has_implicit_wireswaps());
+    for (unsigned first : {0u, 3u, 6u}) {
+      const Circuit rerouted = reroute_slices(routed, arc, first, 4);
+      CHECK(rerouted.get_commands() == routed.get_commands());
+      CHECK(
+          rerouted.implicit_qubit_permutation() ==
+          routed.implicit_qubit_permutation());
+      CHECK(tket_sim::compare_statevectors_or_unitaries(
+          tket_sim::get_statevector(routed),
+          tket_sim::get_statevector(rerouted)));
+    }
+    REQUIRE_THROWS_AS(
+        reroute_slices(routed, arc, 0, 0), std::invalid_argument);
+  }
+}
+
+SCENARIO("Can many circuits be routed with one RoutingContext?") {
+  SquareGrid arc(3, 4);
+  const RoutingContextPtr context = std::make_shared<const RoutingContext>(arc);
+  GIVEN("Nodes at distance 2") {
+    const node_vector_t nodes = arc.get_all_nodes_vec();
+    for (const Node &n0 : nodes) {
+      for (const Node &n1 : nodes) {
+        const std::optional<Node> centre = context->central_node(n0, n1);
+        if (arc.get_distance(n0, n1) == 2) {
+          REQUIRE(centre);
+          CHECK(*centre == arc.get_path(n0, n1)[1]);
+        } else {
+          CHECK_FALSE(centre);
+        }
+      }
+    }
+    REQUIRE_THROWS_AS(
+        context->central_node(Node(0), nodes[0]), NodeDoesNotExistError);
+  }
+  GIVEN("Circuits routed concurrently") {
+    std::vector<Circuit> circs;
+    for (unsigned c = 0; c < 16; ++c) {
+      Circuit circ(12);
+      for (unsigned i = 0; i < 20; ++i) {
+        const unsigned q0 = (7 * i + c) % 12;
+        const unsigned q1 = (q0 + 1 + (5 * i + 3 * c) % 11) % 12;
+        circ.add_op<unsigned>(OpType::CX, {q0, q1});
+      }
+      circs.push_back(circ);
+    }
+    std::vector<Circuit> routed(circs.size());
+    set_max_threads(4);
+    parallel_for(0, circs.size(), 1, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t c = begin; c < end; ++c) {
+        Routing router(circs[c], context);
+        routed[c] = router.solve().first;
+      }
+    });
+    set_max_threads(0);
+    THEN("The results are those of routing with the architecture") {
+      for (unsigned c = 0; c < circs.size(); ++c) {
+        Routing router(circs[c], arc);
+        CHECK(routed[c] == router.solve().first);
+        CHECK(respects_connectivity_constraints(routed[c], arc, false, true));
+      }
+    }
+  }
+}
+
+SCENARIO("Can circuits be routed with the SABRE engine?") {
+  RoutingConfig config;
+  config.engine = RoutingEngine::Sabre;
+  GIVEN("A CX circuit on a grid") {
+    SquareGrid arc(3, 3);
+    Circuit circ(9);
+    for (unsigned i = 0; i < 40; ++i) {
+      const unsigned q0 = (5 * i + 1) % 9;
+      const unsigned q1 = (q0 + 1 + (4 * i) % 8) % 9;
+      circ.add_op<unsigned>(OpType::CX, {q0, q1});
+    }
+    for (unsigned passes : {0u, 1u, 3u}) {
+      config.sabre_refinement_passes = passes;
+      Routing router(circ, arc);
+      const Circuit routed = router.solve(config).first;
+      CHECK(respects_connectivity_constraints(routed, arc, false, true));
+      CHECK(routed.count_gates(OpType::CX) == 40);
+      CHECK(routed.count_gates(OpType::BRIDGE) == 0);
+      CHECK(
+          routed.count_gates(OpType::SWAP) == router.get_stats().swap_count);
+    }
+  }
+  GIVEN("A placed circuit needing no SWAPs") {
+    Architecture line({{0, 1}, {1, 2}, {2, 3}});
+    Circuit circ(4);
+    add_2qb_gates(circ, OpType::CX, {{0, 1}, {1, 2}, {2, 3}, {1, 2}});
+    LinePlacement lp(line);
+    lp.place(circ);
+    config.sabre_refinement_passes = 0;
+    Routing router(circ, line);
+    CHECK_FALSE(router.solve(config).second);
+  }
+  GIVEN("A circuit whose gates span a line") {
+    Architecture line({{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}});
+    Circuit circ(6);
+    add_2qb_gates(circ, OpType::CZ, {{0, 5}, {1, 4}, {2, 3}, {0, 5}});
+    qubit_mapping_t map;
+    for (unsigned i = 0; i < 6; ++i) map.insert({Qubit(i), Node(i)});
+    Placement::place_with_map(circ, map);
+    WHEN("The initial mapping is kept") {
+      config.sabre_refinement_passes = 0;
+      Routing router(circ, line);
+      const Circuit routed = router.solve(config).first;
+      CHECK(respects_connectivity_constraints(routed, line, false, true));
+      THEN("The furthest pair still meets") {
+        CHECK(router.get_stats().swap_count >= 4);
+      }
+    }
+    WHEN("The initial mapping is refined") {
+      config.sabre_refinement_passes = 2;
+      Routing router(circ, line);
+      const Circuit routed = router.solve(config).first;
+      CHECK(respects_connectivity_constraints(routed, line, false, true));
+      THEN("Fewer SWAPs are needed") {
+        Routing unrefined(circ, line);
+        RoutingConfig plain = config;
+        plain.sabre_refinement_passes = 0;
+        unrefined.solve(plain);
+        CHECK(
+            router.get_stats().swap_count <=
+            unrefined.get_stats().swap_count);
+      }
+    }
+  }
+  GIVEN("Windowed routing") {
+    SquareGrid arc(2, 3);
+    Circuit circ(6);
+    for (unsigned i = 0; i < 20; ++i) {
+      circ.add_op<unsigned>(OpType::CX, {i % 6, (i * 5 + 3) % 6});
+    }
+    unsigned n_cx = 0;
+    route_in_windows(
+        circ, arc, 3,
+        [&](const Circuit &c) {
+          CHECK(respects_connectivity_constraints(c, arc, false, true));
+          n_cx += c.count_gates(OpType::CX);
+        },
+        config);
+    CHECK(n_cx == 20);
+  }
+}
+
+SCENARIO("Can routing move commuting gates into the front layer?") {
+  RoutingConfig config;
+  config.commute_front_layer = true;
+  Architecture line({{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}});
+  qubit_mapping_t map;
+  for (unsigned i = 0; i < 6; ++i) map.insert({Qubit(i), Node(i)});
+  GIVEN("A gate on adjacent nodes behind a blocked gate") {
+    Circuit circ(3);
+    add_2qb_gates(circ, OpType::CZ, {{0, 2}, {0, 1}});
+    Placement::place_with_map(circ, map);
+    Routing router(circ, line);
+    Circuit routed = router.solve(config).first;
+    CHECK(respects_connectivity_constraints(routed, line, false, true));
+    THEN("It runs before any SWAP") {
+      const std::vector<Command> coms = routed.get_commands();
+      REQUIRE(coms.size() == 2 + router.get_stats().swap_count);
+      CHECK(coms[0].get_op_ptr()->get_type() == OpType::CZ);
+      CHECK(coms[0].get_args() == unit_vector_t{Node(0), Node(1)});
+    }
+    routed.replace_SWAPs();
+    CHECK(test_unitary_comparison(circ, routed));
+  }
+  GIVEN("A gate behind one it does not commute with") {
+    Circuit circ(3);
+    circ.add_op<unsigned>(OpType::CZ, {0, 2});
+    circ.add_op<unsigned>(OpType::CX, {1, 0});
+    Placement::place_with_map(circ, map);
+    Routing router(circ, line);
+    Circuit routed = router.solve(config).first;
+    CHECK(respects_connectivity_constraints(routed, line, false, true));
+    routed.replace_SWAPs();
+    CHECK(test_unitary_comparison(circ, routed));
+  }
+  GIVEN("A QAOA circuit") {
+    Circuit circ(6);
+    const std::vector<std::pair<unsigned, unsigned>> edges = {
+        {0, 3}, {1, 4}, {2, 5}, {0, 1}, {3, 4}, {1, 2}, {4, 5}, {0, 5}};
+    for (unsigned q = 0; q < 6; ++q) circ.add_op<unsigned>(OpType::H, {q});
+    for (unsigned layer = 0; layer < 2; ++layer) {
+      for (const auto& [q0, q1] : edges) {
+        circ.add_op<unsigned>(OpType::ZZPhase, 0.1 * (layer + 1), {q0, q1});
+      }
+      for (unsigned q = 0; q < 6; ++q) {
+        circ.add_op<unsigned>(OpType::Rx, 0.3 * (layer + 1), {q});
+      }
+    }
+    Placement::place_with_map(circ, map);
+    for (RoutingEngine engine :
+         {RoutingEngine::CowtanEtAl, RoutingEngine::Sabre}) {
+      config.engine = engine;
+      config.sabre_refinement_passes = 0;
+      Routing router(circ, line);
+      Circuit routed = router.solve(config).first;
+      CHECK(respects_connectivity_constraints(routed, line, false, true));
+      CHECK(routed.count_gates(OpType::ZZPhase) == 2 * edges.size());
+      CHECK(
+          routed.count_gates(OpType::SWAP) == router.get_stats().swap_count);
+      routed.replace_SWAPs();
+      CHECK(test_unitary_comparison(circ, routed));
+    }
+  }
+  GIVEN("A configuration serialised with the option") {
+    nlohmann::json j = config;
+    CHECK(j.at("commute_front_layer").get<bool>());
+    CHECK(j.get<RoutingConfig>() == config);
+  }
+}
+
 SCENARIO(
     "Do Placement and Routing work if the given graph perfectly solves the "
     "problem?") {
@@ -2704,5 +3368,42 @@ SCENARIO("Does add_distributed_cx account for incorrect BRIDGE nodes?") {
   }
 }
 
+SCENARIO("Routing records the time spent in each phase") {
+  Architecture arc({{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}});
+  Circuit circ(6);
+  for (unsigned i = 0; i < 6; ++i) {
+    circ.add_op<unsigned>(OpType::CX, {i, (i + 3) % 6});
+  }
+  for (RoutingEngine engine :
+       {RoutingEngine::CowtanEtAl, RoutingEngine::Sabre}) {
+    RoutingConfig config;
+    config.engine = engine;
+    std::vector<Routing::Stats> runs;
+    PassPtr pass =
+        gen_placement_pass(std::make_shared<LinePlacement>(arc)) >>
+        gen_routing_pass(arc, config, [&runs](const Routing::Stats &stats) {
+          runs.push_back(stats);
+        });
+    CompilationUnit cu(circ);
+    REQUIRE(pass->apply(cu));
+    REQUIRE(runs.size() == 1);
+    const Routing::Stats &stats = runs.front();
+    CHECK(stats.swap_count + stats.bridge_count > 0);
+    CHECK(stats.advance_frontier_time.count() > 0);
+    CHECK(stats.swap_generation_time.count() > 0);
+    CHECK(stats.swap_scoring_time.count() > 0);
+    CHECK(stats.solve_furthest_time.count() >= 0);
+    if (engine == RoutingEngine::CowtanEtAl) {
+      // Every SWAP chosen by lookahead is first checked for a BRIDGE.
+      CHECK(
+          (stats.n_try_all_swaps == 0) ==
+          (stats.distributed_cx_time.count() == 0));
+    } else {
+      // SABRE adds no BRIDGEs.
+      CHECK(stats.distributed_cx_time.count() == 0);
+    }
+  }
+}
+
 }  // namespace test_Routing
 }  // namespace tket
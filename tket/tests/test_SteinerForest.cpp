@@ -15,6 +15,7 @@
 #include <catch2/catch.hpp>
 
 #include "ArchAwareSynth/SteinerForest.hpp"
+#include "Utils/Parallel.hpp"
 #include "testutil.hpp"
 namespace tket {
 SCENARIO("Synthesise a CNOT-only steiner Forest") {
@@ -337,6 +338,37 @@ SCENARIO("Build a steiner Forest") {
     aas::CostedOperations expectedResult = std::pair(2, oplist2);
     REQUIRE(cosop == expectedResult);
   }
+  GIVEN("best_operations_lookahead with and without threads") {
+    const Architecture archi(
+        {{Node(0), Node(1)},
+         {Node(1), Node(2)},
+         {Node(2), Node(3)},
+         {Node(3), Node(4)},
+         {Node(4), Node(5)},
+         {Node(1), Node(4)}});
+    Circuit circ(6);
+    for (unsigned q = 0; q != 5; ++q) {
+      circ.add_op<unsigned>(OpType::CX, {q, q + 1});
+      circ.add_op<unsigned>(OpType::Rz, 0.1 * (q + 1), {q + 1});
+    }
+    circ.add_op<unsigned>(OpType::CX, {5, 0});
+    circ.add_op<unsigned>(OpType::Rz, 0.7, {0});
+    PhasePolyBox ppbox(circ);
+    aas::PathHandler pathhand(archi);
+    aas::PathHandler acyclic = pathhand.construct_acyclic_handler();
+    aas::SteinerForest sf(acyclic, ppbox);
+    REQUIRE(sf.tree_count > 1);
+    unsigned n_gates = sf.synth_circuit.n_gates();
+    aas::CostedOperations parallel =
+        aas::best_operations_lookahead(acyclic, sf, 3);
+    set_max_threads(1);
+    aas::CostedOperations serial =
+        aas::best_operations_lookahead(acyclic, sf, 3);
+    set_max_threads(0);
+    REQUIRE(parallel == serial);
+    // the search leaves the forest unchanged
+    REQUIRE(sf.synth_circuit.n_gates() == n_gates);
+  }
   GIVEN("operations_available_at_index") {
     const Architecture archi(
         {{Node(0), Node(1)}, {Node(1), Node(2)}, {Node(2), Node(3)}});
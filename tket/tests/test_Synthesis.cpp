@@ -146,6 +146,53 @@ SCENARIO("Check commutation through multiqubit ops") {
       }
     }
   }
+
+  GIVEN("Singles commuting through several gates") {
+    Circuit circ(3);
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::CX, {0, 2});
+    circ.add_op<unsigned>(OpType::Z, {0});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::Rz, 0.3, {0});
+    circ.add_op<unsigned>(OpType::X, {0});
+    circ.add_op<unsigned>(OpType::CZ, {0, 2});
+    circ.add_op<unsigned>(OpType::Z, {0});
+    Circuit copy = circ;
+    REQUIRE(Transform::commute_through_multis().apply(circ));
+    THEN("Each lands before the earliest gate it reaches") {
+      Circuit correct(3);
+      correct.add_op<unsigned>(OpType::Z, {0});
+      correct.add_op<unsigned>(OpType::Rz, 0.3, {0});
+      correct.add_op<unsigned>(OpType::CX, {0, 1});
+      correct.add_op<unsigned>(OpType::CX, {0, 2});
+      correct.add_op<unsigned>(OpType::CX, {0, 1});
+      correct.add_op<unsigned>(OpType::X, {0});
+      correct.add_op<unsigned>(OpType::Z, {0});
+      correct.add_op<unsigned>(OpType::CZ, {0, 2});
+      REQUIRE(circ == correct);
+      REQUIRE(test_unitary_comparison(circ, copy));
+      REQUIRE_FALSE(Transform::commute_through_multis().apply(circ));
+    }
+  }
+
+  GIVEN("Gates which cancel once commuted") {
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::Z, {0});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::Z, {0});
+    circ.add_op<unsigned>(OpType::H, {1});
+    Transform seq =
+        Transform::commute_through_multis() >> Transform::remove_redundancies();
+    THEN("The sequence only revisits the changed region") {
+      REQUIRE(seq.apply_in_region);
+      Circuit copy = circ;
+      REQUIRE(Transform::repeat(seq).apply(circ));
+      REQUIRE(circ.n_gates() == 1);
+      REQUIRE(test_unitary_comparison(circ, copy));
+      REQUIRE(!Transform::repeat(seq).apply(circ));
+    }
+  }
 }
 
 SCENARIO(
@@ -286,6 +333,52 @@ SCENARIO(
   }
 }
 
+SCENARIO("Synthesising in a single worklist sweep") {
+  GIVEN("A circuit where commutation enables cancellation and squashing") {
+    Circuit circ(2);
+    circ.add_op<unsigned>(OpType::H, {0});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::Rz, 0.3, {0});
+    circ.add_op<unsigned>(OpType::CX, {0, 1});
+    circ.add_op<unsigned>(OpType::H, {0});
+    const StateVector s0 = tket_sim::get_statevector(circ);
+    Circuit synth = circ;
+    Transform::synthesise_tket().apply(synth);
+    REQUIRE(Transform::synthesise_tket_fused().apply(circ));
+    REQUIRE(circ.count_gates(OpType::CX) == 0);
+    REQUIRE(circ.count_gates(OpType::tk1) == 1);
+    REQUIRE(circ.n_gates() == synth.n_gates());
+    const StateVector s1 = tket_sim::get_statevector(circ);
+    REQUIRE(tket_sim::compare_statevectors_or_unitaries(s0, s1));
+    circ.assert_valid();
+    THEN("A second application makes no change") {
+      REQUIRE_FALSE(Transform::synthesise_tket_fused().apply(circ));
+    }
+  }
+  GIVEN("A UCCSD example") {
+    Circuit circ = CircuitsForTesting::get().uccsd;
+    const StateVector s0 = tket_sim::get_statevector(circ);
+    Circuit synth = circ;
+    Transform::synthesise_tket().apply(synth);
+    Transform::synthesise_tket_fused().apply(circ);
+    BGL_FORALL_VERTICES(v, circ.dag, DAG) {
+      OpType optype = circ.get_OpType_from_Vertex(v);
+      REQUIRE(
+          (circ.detect_boundary_Op(v) || optype == OpType::tk1 ||
+           optype == OpType::CX));
+    }
+    REQUIRE(circ.count_gates(OpType::CX) == synth.count_gates(OpType::CX));
+    REQUIRE(circ.n_gates() <= synth.n_gates());
+    const StateVector s1 = tket_sim::get_statevector(circ);
+    REQUIRE(tket_sim::compare_statevectors_or_unitaries(s0, s1));
+  }
+  GIVEN("A chain that is already a lone TK1 gate") {
+    Circuit circ(1);
+    circ.add_op<unsigned>(OpType::tk1, {0.1, 0.2, 0.3}, {0});
+    REQUIRE_FALSE(Transform::squash_1qb_chains_to_tk1().apply(circ));
+  }
+}
+
 SCENARIO(
     "Check that annihilation function works on a basic circuit",
     "[transform][annihilation][optimise]") {
@@ -709,6 +802,54 @@ SCENARIO("Testing general 1qb squash") {
                   .apply(circ);
     REQUIRE_FALSE(success);
   }
+  GIVEN("Numeric and symbolic rotations") {
+    Sym a = SymEngine::symbol("alpha");
+    Sym b = SymEngine::symbol("beta");
+    std::vector<std::pair<double, double>> values = {
+        {0.142, 0.528}, {0.5, 1.}, {1., -0.5}, {0.25, 0.75}, {2., 0.3}};
+    for (const std::pair<double, double> &v : values) {
+      Rotation numeric(OpType::Rz, v.first);
+      numeric.apply(Rotation(OpType::Rx, v.second));
+      numeric.apply(Rotation(OpType::Rz, 0.5));
+      numeric.apply(Rotation(OpType::Ry, v.first));
+      REQUIRE(numeric.is_numeric());
+      Rotation symbolic(OpType::Rz, Expr(a));
+      symbolic.apply(Rotation(OpType::Rx, Expr(b)));
+      symbolic.apply(Rotation(OpType::Rz, 0.5));
+      symbolic.apply(Rotation(OpType::Ry, Expr(a)));
+      REQUIRE_FALSE(symbolic.is_numeric());
+      symbol_map_t symbol_map = {{a, v.first}, {b, v.second}};
+      Circuit c0(1), c1(1);
+      auto [p1, q, p2] = numeric.to_pqp(OpType::Rz, OpType::Rx);
+      c0.add_op<unsigned>(OpType::Rz, p1, {0});
+      c0.add_op<unsigned>(OpType::Rx, q, {0});
+      c0.add_op<unsigned>(OpType::Rz, p2, {0});
+      auto [s1, t, s2] = symbolic.to_pqp(OpType::Rz, OpType::Rx);
+      c1.add_op<unsigned>(OpType::Rz, s1, {0});
+      c1.add_op<unsigned>(OpType::Rx, t, {0});
+      c1.add_op<unsigned>(OpType::Rz, s2, {0});
+      c1.symbol_substitution(symbol_map);
+      REQUIRE(test_unitary_comparison(c0, c1));
+    }
+  }
+  GIVEN("Composing numeric with symbolic rotations") {
+    Sym a = SymEngine::symbol("alpha");
+    Rotation r(OpType::Rx, 0.3);
+    r.apply(Rotation(OpType::Rz, 0.7));
+    r.apply(Rotation(OpType::Ry, Expr(a)));
+    REQUIRE_FALSE(r.is_numeric());
+    auto [p1, q, p2] = r.to_pqp(OpType::Rz, OpType::Rx);
+    Circuit c0(1), c1(1);
+    c0.add_op<unsigned>(OpType::Rx, 0.3, {0});
+    c0.add_op<unsigned>(OpType::Rz, 0.7, {0});
+    c0.add_op<unsigned>(OpType::Ry, 0.2, {0});
+    c1.add_op<unsigned>(OpType::Rz, p1, {0});
+    c1.add_op<unsigned>(OpType::Rx, q, {0});
+    c1.add_op<unsigned>(OpType::Rz, p2, {0});
+    symbol_map_t symbol_map = {{a, 0.2}};
+    c1.symbol_substitution(symbol_map);
+    REQUIRE(test_unitary_comparison(c0, c1));
+  }
 }
 
 SCENARIO("Squishing a circuit into U3 and CNOTs") {
@@ -67,6 +67,22 @@ SCENARIO("Testing two-qubit canonical forms") {
     REQUIRE(same);
   }
 
+  GIVEN("Decomposing many kronecker products of random unitaries") {
+    for (unsigned i = 0; i < 20; i++) {
+      Eigen::Matrix2cd testA = random_unitary(2, 2 * i);
+      Eigen::Matrix2cd testB = random_unitary(2, 2 * i + 1);
+      Eigen::Matrix4cd U = Eigen::kroneckerProduct(testA, testB);
+      auto [resA, resB] = kronecker_decomposition(U);
+      Eigen::Matrix4cd V = Eigen::kroneckerProduct(resA, resB);
+      CHECK(is_unitary(resA));
+      CHECK(is_unitary(resB));
+      // Equal up to a global phase
+      Complex phase = (U.adjoint() * V).trace() / 4.;
+      CHECK(std::abs(std::abs(phase) - 1) < ERR_EPS);
+      CHECK(V.isApprox(phase * U));
+    }
+  }
+
   GIVEN("Identifying tk1 parameters from a matrix (0)") {
     Eigen::Matrix2cd test = get_matrix_from_tk1_angles({0, 2.061, 3.103, 0});
     std::vector<double> res = tk1_angles_from_unitary(test);
@@ -482,6 +498,42 @@ SCENARIO("Testing two qubit decomposition with fidelity tradeoff") {
   }
 }
 
+SCENARIO("Memoised two-qubit decompositions") {
+  Circuit circ(2);
+  circ.add_op<unsigned>(OpType::CX, {0, 1});
+  circ.add_op<unsigned>(OpType::Rz, 0.3, {1});
+  circ.add_op<unsigned>(OpType::CX, {0, 1});
+  circ.add_op<unsigned>(OpType::Rx, 0.7, {0});
+  circ.add_op<unsigned>(OpType::CX, {1, 0});
+  circ.add_op<unsigned>(OpType::CX, {0, 1});
+  Eigen::Matrix4cd U = get_matrix_from_2qb_circ(circ);
+  clear_two_qubit_canonical_cache();
+  GIVEN("The same unitary twice") {
+    Circuit c0 = two_qubit_canonical(U);
+    REQUIRE(two_qubit_canonical_cache_size() == 1);
+    Circuit c1 = two_qubit_canonical(U);
+    REQUIRE(two_qubit_canonical_cache_size() == 1);
+    REQUIRE(c0 == c1);
+    REQUIRE(get_matrix_from_2qb_circ(c1).isApprox(U));
+  }
+  GIVEN("A different CX fidelity") {
+    two_qubit_canonical(U);
+    two_qubit_canonical(U, 0.9);
+    REQUIRE(two_qubit_canonical_cache_size() == 2);
+  }
+  GIVEN("Repeated layers") {
+    Circuit layers(2);
+    for (unsigned i = 0; i < 10; ++i) {
+      layers.append(circ);
+      layers.add_barrier({0, 1});
+    }
+    Circuit copy = layers;
+    REQUIRE(Transform::two_qubit_squash().apply(layers));
+    REQUIRE(two_qubit_canonical_cache_size() == 1);
+    REQUIRE(test_unitary_comparison(layers, copy));
+  }
+}
+
 SCENARIO("KAK Decomposition around symbolic gates") {
   GIVEN("Inefficient two-qubit circuit with symbolic gates") {
     Circuit circ(4);
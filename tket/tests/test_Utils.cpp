@@ -15,6 +15,8 @@
 #include <catch2/catch.hpp>
 
 #include "Utils/HelperFunctions.hpp"
+#include "Utils/Parallel.hpp"
+#include "Utils/UnitID.hpp"
 
 namespace tket {
 namespace test_Utils {
@@ -42,5 +44,69 @@ SCENARIO("Test GrayCode generation") {
   }
 }
 
+SCENARIO("Test interned UnitIDs") {
+  GIVEN("Units constructed separately with the same name and index") {
+    Qubit a("q", 3);
+    Qubit b(3);
+    Node n("q", 3);
+    REQUIRE(a == b);
+    REQUIRE(a == n);
+    REQUIRE(hash_value(a) == hash_value(b));
+    REQUIRE(!(a < b));
+    REQUIRE(!(b < a));
+  }
+  GIVEN("Units differing in name or index") {
+    Qubit a("a", {1, 2});
+    Qubit b("a", {1, 3});
+    Qubit c("b", 0);
+    REQUIRE(a != b);
+    REQUIRE(a < b);
+    REQUIRE(b < c);
+    REQUIRE(a.reg_name() == "a");
+    REQUIRE(a.index() == std::vector<unsigned>{1, 2});
+    REQUIRE(a.repr() == "a[1, 2]");
+  }
+  GIVEN("A qubit and a bit with the same name and index") {
+    Qubit q("x", 0);
+    Bit c("x", 0);
+    REQUIRE(UnitID(q) == UnitID(c));
+    REQUIRE(q.type() == UnitType::Qubit);
+    REQUIRE(c.type() == UnitType::Bit);
+  }
+}
+
+SCENARIO("Test parallel_for") {
+  GIVEN("A range split between threads") {
+    std::vector<unsigned> counts(1000, 0);
+    parallel_for(0, counts.size(), 10, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i) ++counts[i];
+    });
+    for (unsigned c : counts) REQUIRE(c == 1);
+  }
+  GIVEN("An empty range") {
+    bool called = false;
+    parallel_for(5, 5, 1, [&](std::size_t, std::size_t) { called = true; });
+    REQUIRE(!called);
+  }
+  GIVEN("A body that throws") {
+    REQUIRE_THROWS_AS(
+        parallel_for(
+            0, 100, 1,
+            [](std::size_t begin, std::size_t) {
+              if (begin == 0) throw std::out_of_range("test");
+            }),
+        std::out_of_range);
+  }
+  GIVEN("A limit on the number of threads") {
+    unsigned old_max = get_max_threads();
+    set_max_threads(1);
+    REQUIRE(get_max_threads() == 1);
+    unsigned n_calls = 0;
+    parallel_for(0, 100, 1, [&](std::size_t, std::size_t) { ++n_calls; });
+    REQUIRE(n_calls == 1);
+    set_max_threads(old_max);
+  }
+}
+
 }  // namespace test_Utils
 }  // namespace tket
@@ -15,16 +15,19 @@
 #include <boost/range/join.hpp>
 #include <catch2/catch.hpp>
 #include <iostream>
+#include <sstream>
 
 #include "Architecture/Architecture.hpp"
 #include "Circuit/CircPool.hpp"
 #include "Circuit/CircUtils.hpp"
 #include "Circuit/Circuit.hpp"
+#include "Circuit/CircuitJsonStream.hpp"
 #include "Circuit/Command.hpp"
 #include "CircuitsForTesting.hpp"
 #include "Converters/PhasePoly.hpp"
 #include "Gate/SymTable.hpp"
 #include "OpType/OpType.hpp"
+#include "OpType/OpTypeInfo.hpp"
 #include "Ops/OpPtr.hpp"
 #include "Predicates/PassGenerators.hpp"
 #include "Predicates/PassLibrary.hpp"
@@ -343,6 +346,83 @@ SCENARIO("Test Circuit serialization") {
     REQUIRE(check_circuit(circ1));
     REQUIRE(!(circ == circ1));
   }
+  GIVEN("Enough commands to be decoded in parallel") {
+    Circuit circ(4, 2);
+    Sym a = SymTable::fresh_symbol("a");
+    Expr ea(a);
+    for (unsigned i = 0; i < 1000; i++) {
+      const unsigned q = i % 4;
+      circ.add_op<unsigned>(OpType::Rz, 0.01 * i, {q}, "g");
+      circ.add_op<unsigned>(OpType::CX, {q, (q + 1) % 4});
+      circ.add_op<unsigned>(OpType::Ry, ea, {(q + 2) % 4});
+      circ.add_conditional_gate<unsigned>(OpType::X, {}, {q}, {0, 1}, 2);
+    }
+    circ.add_op<unsigned>(OpType::Measure, {0, 0});
+    REQUIRE(check_circuit(circ));
+    nlohmann::json j = circ;
+    REQUIRE(j.get<Circuit>().get_commands() == circ.get_commands());
+  }
+  GIVEN("Every OpType name") {
+    for (const auto& info : optypeinfo()) {
+      nlohmann::json j = info.first;
+      CHECK(j.get<OpType>() == info.first);
+    }
+    nlohmann::json j = "NotAnOpType";
+    REQUIRE_THROWS_AS(j.get<OpType>(), JsonError);
+  }
+}
+
+SCENARIO("Test streaming Circuit serialization") {
+  auto check_streams = [](const Circuit& c) {
+    nlohmann::json j = c;
+    std::stringstream out;
+    write_circuit_json(out, c);
+    CHECK(out.str() == j.dump());
+    std::stringstream in(j.dump());
+    Circuit new_c = read_circuit_json(in);
+    CHECK(new_c.circuit_equality(c));
+    CHECK(new_c.get_name() == c.get_name());
+    CHECK(
+        new_c.implicit_qubit_permutation() == c.implicit_qubit_permutation());
+  };
+  GIVEN("Registers, opgroups and unused units") {
+    Circuit c(3, 2, "stream");
+    const Qubit a("a", 1, 2);
+    c.add_qubit(a);
+    c.add_bit(Bit("unused", 0));
+    c.add_op<unsigned>(OpType::Rz, 0.2, {0}, "g");
+    c.add_op<UnitID>(OpType::CX, {Qubit(0), a});
+    c.add_conditional_gate<unsigned>(OpType::Ry, {-0.75}, {1}, {0, 1}, 1);
+    c.add_op<unsigned>(OpType::Measure, {0, 1});
+    c.add_barrier({Qubit(1), Qubit(2)});
+    c.add_phase(0.3);
+    check_streams(c);
+  }
+  GIVEN("An implicit permutation") {
+    Circuit c(3);
+    add_2qb_gates(c, OpType::CX, {{0, 1}, {1, 0}, {1, 2}, {2, 1}});
+    Transform::clifford_simp().apply(c);
+    check_streams(c);
+  }
+  GIVEN("An empty circuit") { check_streams(Circuit()); }
+  GIVEN("Fields in another order") {
+    std::stringstream in(
+        R"({"qubits":[["q",[0]],["q",[1]]],"phase":"0.5","bits":[],)"
+        R"("implicit_permutation":[],"commands":[)"
+        R"({"args":[["q",[0]],["q",[1]]],"op":{"type":"CX"}}]})");
+    Circuit c(2);
+    c.add_op<unsigned>(OpType::CX, {0, 1});
+    c.add_phase(0.5);
+    REQUIRE(read_circuit_json(in) == c);
+  }
+  GIVEN("Invalid JSON") {
+    std::stringstream not_object("[]");
+    REQUIRE_THROWS_AS(read_circuit_json(not_object), JsonError);
+    std::stringstream bad_commands(R"({"commands":{}})");
+    REQUIRE_THROWS_AS(read_circuit_json(bad_commands), JsonError);
+    std::stringstream truncated(R"({"commands":[)");
+    REQUIRE_THROWS_AS(read_circuit_json(truncated), JsonError);
+  }
 }
 
 SCENARIO("Test config serializations") {
@@ -354,6 +434,30 @@ SCENARIO("Test config serializations") {
     nlohmann::json j_loaded = loaded;
     REQUIRE(j_config == j_loaded);
   }
+  GIVEN("RoutingConfig for the SABRE engine") {
+    RoutingConfig orig;
+    orig.engine = RoutingEngine::Sabre;
+    orig.sabre_extended_set_size = 12;
+    orig.sabre_extended_set_weight = 0.75;
+    orig.sabre_decay_delta = 0.01;
+    orig.sabre_decay_reset = 3;
+    orig.sabre_refinement_passes = 2;
+    nlohmann::json j_config = orig;
+    CHECK(j_config.at("engine") == "Sabre");
+    RoutingConfig loaded = j_config.get<RoutingConfig>();
+    REQUIRE(orig == loaded);
+    REQUIRE_FALSE(loaded == RoutingConfig());
+  }
+  GIVEN("RoutingConfig serialised without an engine") {
+    nlohmann::json j_config = {
+        {"depth_limit", 20},
+        {"distrib_limit", 6},
+        {"interactions_limit", 3},
+        {"distrib_exponent", 2.5}};
+    RoutingConfig loaded = j_config.get<RoutingConfig>();
+    REQUIRE(loaded == RoutingConfig(20, 6, 3, 2.5));
+    CHECK(loaded.engine == RoutingEngine::CowtanEtAl);
+  }
   GIVEN("PlacementConfig") {
     PlacementConfig orig(5, 20, 100000, 10, 1);
     nlohmann::json j_config = orig;
@@ -760,6 +864,19 @@ SCENARIO("Test compiler pass combinator serializations") {
     nlohmann::json j_loaded_comb = loaded_comb;
     REQUIRE(j_comb == j_loaded_comb);
   }
+  GIVEN("A pass applied to independent regions") {
+    Circuit circ = CircuitsForTesting::get().uccsd;
+    CompilationUnit cu{circ};
+    CompilationUnit copy = cu;
+    PassPtr pp = gen_parallel_regions_pass(FullPeepholeOptimise());
+    nlohmann::json j_pp = pp;
+    PassPtr loaded = j_pp.get<PassPtr>();
+    pp->apply(cu);
+    loaded->apply(copy);
+    REQUIRE(cu.get_circ_ref() == copy.get_circ_ref());
+    nlohmann::json j_loaded = loaded;
+    REQUIRE(j_pp == j_loaded);
+  }
 }
 
 SCENARIO("Test QubitPauliString serialization") {
@@ -25,6 +25,7 @@ set(TEST_SOURCES
     ${TKET_TESTS_DIR}/CircuitsForTesting.cpp
     ${TKET_TESTS_DIR}/Utils/test_MatrixAnalysis.cpp
     ${TKET_TESTS_DIR}/Utils/test_CosSinDecomposition.cpp
+    ${TKET_TESTS_DIR}/Utils/test_Trace.cpp
     ${TKET_TESTS_DIR}/Graphs/EdgeSequence.cpp
     ${TKET_TESTS_DIR}/Graphs/EdgeSequenceColouringParameters.cpp
     ${TKET_TESTS_DIR}/Graphs/GraphTestingRoutines.cpp
@@ -51,6 +52,9 @@ set(TEST_SOURCES
     ${TKET_TESTS_DIR}/test_Utils.cpp
     ${TKET_TESTS_DIR}/Circuit/test_Boxes.cpp
     ${TKET_TESTS_DIR}/Circuit/test_Circ.cpp
+    ${TKET_TESTS_DIR}/Circuit/test_CircuitBinary.cpp
+    ${TKET_TESTS_DIR}/Circuit/test_HierarchicalMetrics.cpp
+    ${TKET_TESTS_DIR}/Circuit/test_Scheduling.cpp
     ${TKET_TESTS_DIR}/Circuit/test_Symbolic.cpp
     ${TKET_TESTS_DIR}/Circuit/test_ThreeQubitConversion.cpp
     ${TKET_TESTS_DIR}/test_Program.cpp
@@ -68,6 +72,7 @@ set(TEST_SOURCES
     ${TKET_TESTS_DIR}/test_PhaseGadget.cpp
     ${TKET_TESTS_DIR}/test_Rebase.cpp
     ${TKET_TESTS_DIR}/test_Synthesis.cpp
+    ${TKET_TESTS_DIR}/test_Peephole.cpp
     ${TKET_TESTS_DIR}/test_TwoQubitCanonical.cpp
     ${TKET_TESTS_DIR}/test_ControlDecomp.cpp
     ${TKET_TESTS_DIR}/test_Combinators.cpp
@@ -83,4 +88,5 @@ set(TEST_SOURCES
     ${TKET_TESTS_DIR}/ZX/test_ZXDiagram.cpp
     ${TKET_TESTS_DIR}/ZX/test_ZXAxioms.cpp
     ${TKET_TESTS_DIR}/ZX/test_ZXSimp.cpp
+    ${TKET_TESTS_DIR}/ZX/test_ZXExtraction.cpp
 )